@@ -33,6 +33,7 @@ import java.util.List;
 import java.util.Observable;
 import java.util.Observer;
 import java.util.Set;
+import java.util.concurrent.atomic.AtomicBoolean;
 
 import org.dronin.androidgcs.drawer.NavDrawerActivityConfiguration;
 import org.dronin.androidgcs.drawer.NavDrawerAdapter;
@@ -363,13 +364,20 @@ public abstract class ObjectManagerActivity extends Activity {
 	final Handler uavobjHandler = new Handler();
 	private class ActivityUpdatedObserver implements Observer  {
 		UAVObject obj;
+		//! Set while a post is waiting, so a burst of updates draws once
+		private final AtomicBoolean pending = new AtomicBoolean(false);
+		private final Runnable notifyUpdated = new Runnable() {
+			@Override
+			public void run() {
+				pending.set(false);
+				objectUpdated(obj);
+			}
+		};
 		ActivityUpdatedObserver(UAVObject obj) { this.obj = obj; };
 		@Override
 		public void update(Observable observable, Object data) {
-			uavobjHandler.post(new Runnable() {
-				@Override
-				public void run() { objectUpdated(obj); }
-			});
+			if (pending.compareAndSet(false, true))
+				uavobjHandler.post(notifyUpdated);
 		}
 	};
 
@@ -30,6 +30,7 @@ import java.util.List;
 import java.util.Observable;
 import java.util.Observer;
 import java.util.Set;
+import java.util.concurrent.atomic.AtomicBoolean;
 
 import org.dronin.androidgcs.ObjectManagerActivity;
 import org.dronin.uavtalk.UAVObject;
@@ -184,27 +185,33 @@ public abstract class ObjectManagerFragment extends Fragment {
 		UAVObject obj;
 		public int my_count;
 		
+		//! Set while a post is waiting, so a burst of updates draws once
+		private final AtomicBoolean pending = new AtomicBoolean(false);
+		private final Runnable notifyUpdated = new Runnable() {
+			@Override
+			public void run() {
+				pending.set(false);
+				if (disableUpdates) {
+					Log.w(getDebugTag(), "Got an update for " + obj.getName() + " after it should have been disabled");
+					return;
+				}
+				// These assertions catch bugs in our lifecycle process
+				if (objMngr == null) {
+					if (DEBUG) Log.d(getDebugTag(), "Null object manager update for " + obj.getName() + " observer: " + my_count);
+				}
+
+				// Send the notifications
+				objectUpdated(obj);
+				if (resumed)
+					objectUpdatedUI(obj);
+			}
+		};
+
 		ObjectyUpdatedObserver(UAVObject obj) { this.obj = obj; my_count = observer_count; observer_count++; };
 		@Override
 		public void update(Observable observable, Object data) {
-			uavobjHandler.post(new Runnable() {
-				@Override
-				public void run() {
-					if (disableUpdates) {
-						Log.w(getDebugTag(), "Got an update for " + obj.getName() + " after it should have been disabled");
-						return;
-					}
-					// These assertions catch bugs in our lifecycle process
-					if (objMngr == null) {
-						if (DEBUG) Log.d(getDebugTag(), "Null object manager update for " + obj.getName() + " observer: " + my_count);
-					}
-					
-					// Send the notifications
-					objectUpdated(obj);
-					if (resumed)
-						objectUpdatedUI(obj);
-				}
-			});
+			if (pending.compareAndSet(false, true))
+				uavobjHandler.post(notifyUpdated);
 		}
 	};
 	
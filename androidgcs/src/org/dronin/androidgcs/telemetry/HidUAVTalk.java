@@ -666,6 +666,25 @@ public class HidUAVTalk extends TelemetryTask {
 			return -1;
 		}
 
+		//! Blocks until data is available, then takes what fits in dst
+		@Override
+		public int read(byte[] dst, int offset, int len) {
+			if (len == 0)
+				return 0;
+
+			try {
+				return data.getBlocking(dst, offset, len);
+			} catch (InterruptedException e) {
+				if (!shutdown) {
+					Log.e(TAG, "Timed out");
+					if (DEBUG) e.printStackTrace();
+					disconnect();
+					telemService.connectionBroken();
+				}
+			}
+			return -1;
+		}
+
 		public void write(byte[] b) {
 			data.put(b);
 		}
@@ -732,5 +751,20 @@ public class HidUAVTalk extends TelemetryTask {
 				return val;
 			}
 		}
+
+		//! Blocks until data is available, then takes up to len bytes
+		public int getBlocking(byte[] dst, int offset, int len) throws InterruptedException {
+			synchronized(buf) {
+				while (size <= 0) {
+					buf.wait();
+				}
+				int n = Math.min(size, len);
+				buf.position(0);
+				buf.get(dst, offset, n);
+				buf.compact();
+				size -= n;
+				return n;
+			}
+		}
 	}
 }
@@ -149,6 +149,8 @@ public class UAVTalk {
 	// Variables used by the receive state machine
 	ByteBuffer rxTmpBuffer /* 4 */;
 	ByteBuffer rxBuffer;
+	//! What was last read from the stream, reused for every read
+	final byte[] rxChunk = new byte[MAX_PACKET_LENGTH];
 	int rxType;
 	long rxObjId;
 	long rxInstId;
@@ -221,19 +223,20 @@ public class UAVTalk {
 	 * @throws IOException
 	 */
 	public boolean processInputStream() throws IOException {
-		int val;
+		int len;
 
-		//inStream.wait();
-		val = inStream.read();
+		// Take whatever is waiting rather than a byte at a time
+		len = inStream.read(rxChunk);
 
-		if (VERBOSE) Log.v(TAG, "Read: " + val);
+		if (VERBOSE) Log.v(TAG, "Read: " + len);
 
-		if (val == -1) {
+		if (len == -1) {
 			return false;
 		}
 
-		 processInputByte(val);
-		 return true;
+		for (int i = 0; i < len; i++)
+			processInputByte(rxChunk[i] & 0xff);
+		return true;
 	}
 
 
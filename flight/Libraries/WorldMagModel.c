@@ -62,7 +62,7 @@ static WMMtype_MagneticModel    MagneticModel;
 static float                    decimal_date;
 
 /**************************************************************************************
-*   Example use - very simple - only two exposed functions
+*   Example use - very simple
 *
 *	WMM_Initialize(); // Set default values and constants
 *
@@ -70,6 +70,10 @@ static float                    decimal_date;
 *	e.g. Iceland in may of 2012 = WMM_GetMagVector(65.0, -20.0, 0.0, 5, 5, 2012, B);
 *	Alt is above the WGS-84 Ellipsoid
 *	B is the NED (XYZ) magnetic vector in nTesla
+*
+*	WMM_GetMagVectorCached() takes the same arguments and interpolates a
+*	cached tile instead; cheap enough to call in flight.  It returns 1
+*	without touching B while a new tile is filled.
 **************************************************************************************/
 
 int WMM_Initialize()
@@ -163,6 +167,88 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
     return returned;
 }
 
+/*
+ * The field barely curves over a degree, so the corners of a one degree tile
+ * interpolate to within a few parts in 1e4 of the full model, far below what
+ * a magnetometer resolves.  A tile is
+ * filled one corner per call, so moving into a new one never costs more
+ * than a single evaluation of the model.
+ */
+#define WMM_TILE_DEG 1.0f
+#define WMM_TILE_ALT 500.0f    // m either side of the tile before it is refilled
+
+static struct {
+	bool valid;
+	uint8_t filled;
+
+	int16_t lat_idx, lon_idx;
+	float alt;
+	uint16_t month, day, year;
+
+	float B[2][2][3];
+} tile;
+
+int WMM_GetMagVectorCached(float Lat, float Lon, float AltEllipsoid, uint16_t Month, uint16_t Day, uint16_t Year, float B[3])
+{
+	// return '0' if B was updated
+	// return '1' while the tile around the point is still being filled
+	// return < 0 if error
+
+	if (Lat <  -90) return -1;
+	if (Lat >   90) return -2;
+
+	if (Lon < -180) return -3;
+	if (Lon >  180) return -4;
+
+	// Keep the top corners on the globe
+	int16_t lat_idx = floorf(fminf(Lat, 90 - WMM_TILE_DEG) / WMM_TILE_DEG);
+	int16_t lon_idx = floorf(Lon / WMM_TILE_DEG);
+
+	// A new tile starts over, keeping nothing from the old one
+	if (tile.lat_idx != lat_idx || tile.lon_idx != lon_idx ||
+			fabsf(AltEllipsoid - tile.alt) > WMM_TILE_ALT ||
+			tile.month != Month || tile.day != Day || tile.year != Year) {
+		tile.valid = false;
+		tile.filled = 0;
+		tile.lat_idx = lat_idx;
+		tile.lon_idx = lon_idx;
+		tile.alt = AltEllipsoid;
+		tile.month = Month;
+		tile.day = Day;
+		tile.year = Year;
+	}
+
+	if (!tile.valid) {
+		uint8_t i = tile.filled >> 1, j = tile.filled & 1;
+		float corner_lon = (lon_idx + j) * WMM_TILE_DEG;
+
+		// The east edge of the last tile is the antimeridian
+		if (corner_lon > 180)
+			corner_lon -= 360;
+
+		int returned = WMM_GetMagVector((lat_idx + i) * WMM_TILE_DEG, corner_lon,
+				tile.alt, Month, Day, Year, tile.B[i][j]);
+		if (returned < 0)
+			return returned;
+
+		tile.valid = ++tile.filled == 4;
+
+		return 1;
+	}
+
+	float u = Lat / WMM_TILE_DEG - lat_idx;
+	float v = Lon / WMM_TILE_DEG - lon_idx;
+
+	for (int k = 0; k < 3; k++) {
+		float south = tile.B[0][0][k] + v * (tile.B[0][1][k] - tile.B[0][0][k]);
+		float north = tile.B[1][0][k] + v * (tile.B[1][1][k] - tile.B[1][0][k]);
+
+		B[k] = south + u * (north - south);
+	}
+
+	return 0;
+}
+
 int WMM_Geomag(WMMtype_CoordSpherical * CoordSpherical, WMMtype_CoordGeodetic * CoordGeodetic, WMMtype_GeoMagneticElements * GeoMagneticElements)
    /*
       The main subroutine that calls a sequence of WMM sub-functions to calculate the magnetic field elements for a single point.
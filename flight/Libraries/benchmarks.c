@@ -0,0 +1,190 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       benchmarks.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Micro-benchmark kernels for the flight libraries
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "openpilot.h"
+#include "benchmarks.h"
+#include "circqueue.h"
+#include "coordinate_conversions.h"
+#include "misc_math.h"
+#include "pid.h"
+#include "pios_crc.h"
+
+// Private constants
+#define CIRCQUEUE_ELEM_SIZE 16
+#define CIRCQUEUE_NUM_ELEM 8
+#define CRC_PACKET_LEN 64
+
+// Private variables
+
+/* Inputs are kept out of reach of the optimiser so each call does the
+ * full work, and results go to the sink so none is thrown away. */
+static float q_a[4] = { 0.9238795f, 0.0f, 0.3826834f, 0.0f };
+static float q_b[4] = { 0.7071068f, 0.7071068f, 0.0f, 0.0f };
+static float vec[3] = { 1.0f, -2.0f, 0.5f };
+static float curve[5] = { 0.0f, 0.3f, 0.5f, 0.8f, 1.0f };
+static float input = 0.37f;
+static volatile float sink;
+
+static struct pid pid;
+static circ_queue_t queue;
+static uint8_t packet[CRC_PACKET_LEN];
+
+// Private functions
+
+static void bench_quat_mult(uint32_t iterations)
+{
+	float out[4];
+	float acc = 0;
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		quat_mult(q_a, q_b, out);
+		acc += out[0];
+	}
+
+	sink = acc;
+}
+
+static void bench_rot_mult(uint32_t iterations)
+{
+	float R[3][3];
+	float out[3];
+	float acc = 0;
+
+	Quaternion2R(q_a, R);
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		rot_mult(R, vec, out, false);
+		acc += out[0];
+	}
+
+	sink = acc;
+}
+
+static void bench_quaternion2r(uint32_t iterations)
+{
+	float R[3][3];
+	float acc = 0;
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		Quaternion2R(q_a, R);
+		acc += R[0][0];
+	}
+
+	sink = acc;
+}
+
+static void bench_pid_apply(uint32_t iterations)
+{
+	float acc = 0;
+
+	pid_zero(&pid);
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		acc += pid_apply(&pid, input, 0.0005f);
+	}
+
+	sink = acc;
+}
+
+static void bench_linear_interpolate(uint32_t iterations)
+{
+	float acc = 0;
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		acc += linear_interpolate(input, curve, NELEMENTS(curve), 0.0f, 1.0f);
+	}
+
+	sink = acc;
+}
+
+static void bench_expom(uint32_t iterations)
+{
+	float acc = 0;
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		acc += expoM(input, 40, 2.0f);
+	}
+
+	sink = acc;
+}
+
+static void bench_circqueue(uint32_t iterations)
+{
+	uint32_t elem[CIRCQUEUE_ELEM_SIZE / sizeof(uint32_t)] = { 1, 2, 3, 4 };
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		circ_queue_write_data(queue, elem, 1);
+		circ_queue_read_data(queue, elem, 1);
+	}
+
+	sink = elem[0];
+}
+
+static void bench_crc(uint32_t iterations)
+{
+	uint8_t acc = 0;
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		acc += PIOS_CRC_updateCRC(0, packet, sizeof(packet));
+	}
+
+	sink = acc;
+}
+
+const struct benchmark benchmark_kernels[BENCHMARK_NUM_KERNELS] = {
+	[BENCHMARK_QUAT_MULT]          = { "quat_mult", bench_quat_mult },
+	[BENCHMARK_ROT_MULT]           = { "rot_mult", bench_rot_mult },
+	[BENCHMARK_QUATERNION2R]       = { "Quaternion2R", bench_quaternion2r },
+	[BENCHMARK_PID_APPLY]          = { "pid_apply", bench_pid_apply },
+	[BENCHMARK_LINEAR_INTERPOLATE] = { "linear_interpolate", bench_linear_interpolate },
+	[BENCHMARK_EXPOM]              = { "expoM", bench_expom },
+	[BENCHMARK_CIRCQUEUE]          = { "circqueue", bench_circqueue },
+	[BENCHMARK_CRC]                = { "crc", bench_crc },
+};
+
+/**
+ * Set up what the kernels work on
+ * \return 0 on success, -1 if out of memory
+ */
+int32_t benchmarks_initialize(void)
+{
+	queue = circ_queue_new(CIRCQUEUE_ELEM_SIZE, CIRCQUEUE_NUM_ELEM);
+	if (queue == NULL)
+		return -1;
+
+	/* The derivative filter is shared with the stabilization, so it is
+	 * left as that set it; what it is set to makes no odds to the time. */
+	pid_configure(&pid, 0.003f, 0.006f, 0.00003f, 0.3f);
+
+	for (int i = 0; i < CRC_PACKET_LEN; i++)
+		packet[i] = i * 7;
+
+	return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
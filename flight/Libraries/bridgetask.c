@@ -0,0 +1,159 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       bridgetask.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      One task shared by the serial telemetry bridges
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "openpilot.h"
+#include "bridgetask.h"
+#include "misc_math.h"
+#include "pios_semaphore.h"
+#include "pios_thread.h"
+
+// Private constants
+#if defined(PIOS_BRIDGE_STACK_SIZE)
+#define STACK_SIZE_BYTES PIOS_BRIDGE_STACK_SIZE
+#else
+#define STACK_SIZE_BYTES 768
+#endif
+#define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
+
+// Private types
+struct bridge {
+	struct bridge *next;
+	bridgetask_run_t run;
+	void *ctx;
+	uintptr_t com;
+	uint16_t period_ms;
+	uint32_t next_run;
+};
+
+// Private variables
+static struct bridge * volatile bridges;
+static struct pios_semaphore *rx_notify;
+static struct pios_thread *bridge_task;
+
+// Private functions
+static void bridgeTask(void *parameters);
+
+/**
+ * Add a bridge to the shared task, starting the task with the first one.
+ * Called from module start functions, one at a time.
+ * \param[in] com port to run the bridge on data from, or 0 for none
+ * \param[in] period_ms how often to run it regardless, or 0 for never
+ * \param[in] run the bridge's step
+ * \param[in] ctx handed to run
+ * \return 0 on success, -1 on failure
+ */
+int32_t BridgeTaskAdd(uintptr_t com, uint16_t period_ms,
+		bridgetask_run_t run, void *ctx)
+{
+	if (!run || (!com && !period_ms))
+		return -1;
+
+	if (!rx_notify) {
+		rx_notify = PIOS_Semaphore_Create();
+		if (!rx_notify)
+			return -1;
+	}
+
+	struct bridge *b = PIOS_malloc_no_dma(sizeof(*b));
+	if (!b)
+		return -1;
+
+	b->run = run;
+	b->ctx = ctx;
+	b->com = com;
+	b->period_ms = period_ms;
+	b->next_run = PIOS_Thread_Systime() + period_ms;
+
+	if (com)
+		PIOS_COM_SetRxNotify(com, rx_notify);
+
+	// The task only ever walks the list, so the bridge is complete
+	// before it becomes visible.
+	b->next = bridges;
+	bridges = b;
+
+	if (!bridge_task) {
+		bridge_task = PIOS_Thread_Create(bridgeTask, "bridges",
+				STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+		if (!bridge_task)
+			return -1;
+		TaskMonitorAdd(TASKINFO_RUNNING_BRIDGES, bridge_task);
+	}
+
+	return 0;
+}
+
+/**
+ * Run every bridge that has data waiting or whose period is up, then wait
+ * for data on any port or the next period, whichever comes first.
+ */
+static void bridgeTask(void *parameters)
+{
+	(void) parameters;
+
+	while (1) {
+		uint32_t wait = PIOS_SEMAPHORE_TIMEOUT_MAX;
+
+		for (struct bridge *b = bridges; b; b = b->next) {
+			if (!b->run)
+				continue;
+
+			bool due = false;
+			uint32_t now = PIOS_Thread_Systime();
+
+			if (b->com && PIOS_COM_GetNumReceiveBytesPending(b->com))
+				due = true;
+
+			if (b->period_ms && (int32_t)(now - b->next_run) >= 0) {
+				due = true;
+				b->next_run += b->period_ms;
+
+				// Fell behind by more than a period; don't
+				// try to catch up
+				if ((int32_t)(now - b->next_run) >= 0)
+					b->next_run = now + b->period_ms;
+			}
+
+			if (due && !b->run(b->ctx)) {
+				if (b->com)
+					PIOS_COM_SetRxNotify(b->com, NULL);
+				b->run = NULL;
+				continue;
+			}
+
+			if (b->period_ms) {
+				int32_t left = b->next_run - PIOS_Thread_Systime();
+				wait = MIN(wait, (uint32_t)MAX(left, 0));
+			}
+		}
+
+		PIOS_Semaphore_Take(rx_notify, wait);
+	}
+}
+
+/**
+ * @}
+ * @}
+ */
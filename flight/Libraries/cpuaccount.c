@@ -0,0 +1,221 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       cpuaccount.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Charges CPU cycles to callbacks, interrupts and tasks
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "openpilot.h"
+#include "cpuaccount.h"
+
+#if defined(CPUPROFILE_DIAGNOSTICS)
+
+#include "cpuprofile.h"
+
+// Private constants
+#define CALLBACK_SLOTS 24
+#define HOT_ENTRIES CPUPROFILE_HOTLOAD_NUMELEM
+
+DONT_BUILD_IF(HOT_ENTRIES != CPUPROFILE_HOTKIND_NUMELEM, CPUProfileHotKind);
+DONT_BUILD_IF(HOT_ENTRIES != CPUPROFILE_HOTID_NUMELEM, CPUProfileHotId);
+
+// Private types
+
+//! Cycles charged to one callback since the last publish
+struct callback_slot {
+	const void *cb;
+	uint32_t cycles;
+};
+
+// Private variables
+
+/* Callbacks are found by their address; once the table is full, the
+ * rest only count in the total. */
+static struct callback_slot callbacks[CALLBACK_SLOTS];
+static uint32_t callback_cycles_total;		// only ever goes up
+static uint32_t callback_cycles_unslotted;
+
+static uint32_t last_publish;
+
+// Private functions
+
+//! Cycles charged to interrupts and callbacks so far
+static inline uint32_t nested_cycles(void)
+{
+	return PIOS_IRQ_Profile_Total() + callback_cycles_total;
+}
+
+/**
+ * Put an entry in the sorted hot list, if it is busy enough
+ */
+static void hot_add(CPUProfileData *data, uint8_t kind, uint32_t id, float load)
+{
+	if (load <= data->HotLoad[HOT_ENTRIES - 1])
+		return;
+
+	int i = HOT_ENTRIES - 1;
+
+	for (; i > 0 && data->HotLoad[i - 1] < load; i--) {
+		data->HotKind[i] = data->HotKind[i - 1];
+		data->HotId[i] = data->HotId[i - 1];
+		data->HotLoad[i] = data->HotLoad[i - 1];
+	}
+
+	data->HotKind[i] = kind;
+	data->HotId[i] = id;
+	data->HotLoad[i] = load;
+}
+
+/**
+ * Initialise the accounting and its object
+ * \return 0 on success, -1 if the object could not be created
+ */
+int32_t cpuaccount_initialize(void)
+{
+	if (CPUProfileInitialize() == -1)
+		return -1;
+
+	last_publish = PIOS_DELAY_GetRaw();
+
+	return 0;
+}
+
+/**
+ * Mark a callback starting
+ * \param[out] mark where to keep its start
+ */
+void cpuaccount_begin(struct cpuaccount_mark *mark)
+{
+	PIOS_Thread_Scheduler_Suspend();
+
+	mark->nested = nested_cycles();
+	mark->start = PIOS_DELAY_GetRaw();
+
+	PIOS_Thread_Scheduler_Resume();
+}
+
+/**
+ * Charge a callback the cycles since cpuaccount_begin(), less those of the
+ * interrupts and callbacks that ran in the meantime
+ * \param[in] cb the callback
+ * \param[in] mark as filled in by cpuaccount_begin()
+ */
+void cpuaccount_callback(const void *cb, const struct cpuaccount_mark *mark)
+{
+	PIOS_Thread_Scheduler_Suspend();
+
+	uint32_t self = PIOS_DELAY_GetRaw() - mark->start -
+		(nested_cycles() - mark->nested);
+
+	callback_cycles_total += self;
+
+	uint32_t slot = ((uintptr_t) cb >> 1) % CALLBACK_SLOTS;
+
+	for (int i = 0; i < CALLBACK_SLOTS; i++) {
+		struct callback_slot *s = &callbacks[slot];
+
+		if (s->cb == NULL)
+			s->cb = cb;
+
+		if (s->cb == cb) {
+			s->cycles += self;
+			self = 0;
+			break;
+		}
+
+		slot = (slot + 1) % CALLBACK_SLOTS;
+	}
+
+	callback_cycles_unslotted += self;
+
+	PIOS_Thread_Scheduler_Resume();
+}
+
+/**
+ * Publish the busiest tasks, callbacks and interrupts since the last call,
+ * and start again.  Called from the task monitor update.
+ * \param[in] task_runtime each task's runtime over the period
+ * \param[in] num_tasks how many there are
+ * \param[in] task_period the period, in the same units
+ */
+void cpuaccount_publish(const uint32_t *task_runtime, uint16_t num_tasks,
+		uint32_t task_period)
+{
+	uint32_t now = PIOS_DELAY_GetRaw();
+	float cycles = (now - last_publish) ? : 1;
+
+	last_publish = now;
+
+	CPUProfileData data;
+	memset(&data, 0, sizeof(data));
+
+	for (int i = 0; i < num_tasks; i++) {
+		hot_add(&data, CPUPROFILE_HOTKIND_TASK, i,
+				100.0f * task_runtime[i] / (task_period ? : 1));
+	}
+
+	PIOS_Thread_Scheduler_Suspend();
+	uint32_t total = callback_cycles_unslotted;
+	callback_cycles_unslotted = 0;
+	PIOS_Thread_Scheduler_Resume();
+
+	for (int i = 0; i < CALLBACK_SLOTS; i++) {
+		PIOS_Thread_Scheduler_Suspend();
+
+		const void *cb = callbacks[i].cb;
+		uint32_t cb_cycles = callbacks[i].cycles;
+		callbacks[i].cycles = 0;
+
+		PIOS_Thread_Scheduler_Resume();
+
+		total += cb_cycles;
+
+		if (cb != NULL)
+			hot_add(&data, CPUPROFILE_HOTKIND_CALLBACK,
+					(uintptr_t) cb, 100.0f * cb_cycles / cycles);
+	}
+
+	data.CallbackLoad = 100.0f * total / cycles;
+
+	total = 0;
+
+	for (int i = 0; i < PIOS_IRQ_PROFILE_VECTORS; i++) {
+		uint32_t irq_cycles = PIOS_IRQ_Profile_Take(i);
+
+		if (irq_cycles == 0)
+			continue;
+
+		total += irq_cycles;
+		hot_add(&data, CPUPROFILE_HOTKIND_INTERRUPT, i,
+				100.0f * irq_cycles / cycles);
+	}
+
+	data.InterruptLoad = 100.0f * total / cycles;
+
+	CPUProfileSet(&data);
+}
+
+#endif /* CPUPROFILE_DIAGNOSTICS */
+
+/**
+ * @}
+ * @}
+ */
@@ -568,6 +568,114 @@ bool frsky_encode_airspeed(struct frsky_settings *frsky, uint32_t *value, bool t
 	return true;
 }
 
+/*
+ * Values that keep the same value are sent less often, down to
+ * 1 << FRSKY_MAX_BACKOFF of their period, so the polls go to the values
+ * that are changing.  They are still sent at least every
+ * FRSKY_BACKOFF_LIMIT_MS, or the receiver takes the sensor as lost.
+ */
+#define FRSKY_MAX_BACKOFF          2
+#define FRSKY_BACKOFF_LIMIT_MS     2000
+
+/**
+ * Reset the scheduling state of a value table
+ * @param[out] state scheduling state, one per item
+ * @param[in] count number of items
+ */
+void frsky_init_items(struct frsky_value_state *state, uint8_t count)
+{
+	uint32_t now = PIOS_DELAY_GetuS();
+
+	for (uint8_t i = 0; i < count; i++) {
+		state[i].last_triggered = now;
+		state[i].last_value = 0;
+		state[i].backoff = 0;
+		state[i].present = false;
+	}
+}
+
+/**
+ * Test which items of a value table are available.  The answer only
+ * changes with the settings and the GPS status, so it is kept rather than
+ * asked of every item on every poll.
+ * @param[in] frsky settings the values are encoded with
+ * @param[in] items value table
+ * @param[in,out] state scheduling state, one per item
+ * @param[in] count number of items
+ */
+void frsky_update_presence(struct frsky_settings *frsky, const struct frsky_value_item *items,
+		struct frsky_value_state *state, uint8_t count)
+{
+	for (uint8_t i = 0; i < count; i++)
+		state[i].present = items[i].encode_value(frsky, 0, true, items[i].fn_arg);
+}
+
+/**
+ * Find the available item that is most overdue
+ * @param[in] items value table
+ * @param[in] state scheduling state, one per item
+ * @param[in] count number of items
+ * @returns index of the item, or -1 when none is available
+ */
+int32_t frsky_schedule_next(const struct frsky_value_item *items,
+		const struct frsky_value_state *state, uint8_t count)
+{
+	int32_t max_exp_time = INT32_MIN;
+	int32_t most_exp_item = -1;
+
+	for (uint8_t i = 0; i < count; i++) {
+		if (!state[i].present)
+			continue;
+
+		uint32_t period_ms = items[i].period_ms << state[i].backoff;
+		uint32_t limit_ms = MAX(items[i].period_ms, FRSKY_BACKOFF_LIMIT_MS);
+		if (period_ms > limit_ms)
+			period_ms = limit_ms;
+
+		int32_t exp_time = PIOS_DELAY_GetuSSince(state[i].last_triggered) -
+				(period_ms * 1000);
+		if (exp_time > max_exp_time) {
+			max_exp_time = exp_time;
+			most_exp_item = i;
+		}
+	}
+
+	return most_exp_item;
+}
+
+/**
+ * Encode an item of a value table, and note when it was sent and whether
+ * it changed
+ * @param[in] frsky settings the values are encoded with
+ * @param[in] items value table
+ * @param[in,out] state scheduling state, one per item
+ * @param[in] count number of items
+ * @param[in] item index of the item, as from frsky_schedule_next()
+ * @param[out] value encoded value
+ * @returns true when the value was encoded
+ */
+bool frsky_encode_item(struct frsky_settings *frsky, const struct frsky_value_item *items,
+		struct frsky_value_state *state, uint8_t count, int32_t item, uint32_t *value)
+{
+	if ((item < 0) || (item >= count))
+		return false;
+
+	state[item].last_triggered = PIOS_DELAY_GetuS();
+
+	if (!items[item].encode_value(frsky, value, false, items[item].fn_arg))
+		return false;
+
+	if (*value == state[item].last_value) {
+		if (state[item].backoff < FRSKY_MAX_BACKOFF)
+			state[item].backoff++;
+	} else {
+		state[item].backoff = 0;
+		state[item].last_value = *value;
+	}
+
+	return true;
+}
+
 /**
  * Performs byte stuffing and checksum calculation
  * @param[out] obuff buffer where byte stuffed data will came in
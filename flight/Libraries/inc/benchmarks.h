@@ -0,0 +1,63 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       benchmarks.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Micro-benchmark kernels for the flight libraries
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <stdint.h>
+
+/*
+ * The same kernels are timed by the host build in flight/tests/benchmarks
+ * and by the Benchmark module on target.  Their inputs are fixed, so
+ * figures from different commits can be compared; change what a kernel
+ * does and the figures before it no longer compare.
+ */
+enum benchmark_kernel {
+	BENCHMARK_QUAT_MULT,
+	BENCHMARK_ROT_MULT,
+	BENCHMARK_QUATERNION2R,
+	BENCHMARK_PID_APPLY,
+	BENCHMARK_LINEAR_INTERPOLATE,
+	BENCHMARK_EXPOM,
+	BENCHMARK_CIRCQUEUE,		// one 16 byte element in and out
+	BENCHMARK_CRC,			// CRC8 of a 64 byte packet
+	BENCHMARK_NUM_KERNELS
+};
+
+//! A kernel, run a number of times in a row
+struct benchmark {
+	const char *name;
+	void (*run)(uint32_t iterations);
+};
+
+extern const struct benchmark benchmark_kernels[BENCHMARK_NUM_KERNELS];
+
+int32_t benchmarks_initialize(void);
+
+#endif /* BENCHMARKS_H */
+
+/**
+ * @}
+ * @}
+ */
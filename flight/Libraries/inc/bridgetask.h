@@ -0,0 +1,52 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       bridgetask.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      One task shared by the serial telemetry bridges
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef BRIDGETASK_H
+#define BRIDGETASK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * The bridges are state machines fed from their port, or run at a fixed
+ * period, and are rarely enabled together.  Rather than a task and a stack
+ * each, they are run one after the other from a single task, which is only
+ * created once a bridge is added.
+ *
+ * A bridge is run when data has come in on its port, and when its period
+ * has elapsed.  It must not block for long, since the other bridges wait
+ * meanwhile, and must read what is waiting on its port without blocking.
+ * It returns false to be dropped for good.
+ */
+typedef bool (*bridgetask_run_t)(void *ctx);
+
+int32_t BridgeTaskAdd(uintptr_t com, uint16_t period_ms,
+		bridgetask_run_t run, void *ctx);
+
+#endif /* BRIDGETASK_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,71 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       cpuaccount.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Charges CPU cycles to callbacks, interrupts and tasks
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef CPUACCOUNT_H
+#define CPUACCOUNT_H
+
+#include <stdint.h>
+
+/*
+ * Interrupt handlers are charged their cycles by PIOS_IRQ_Prologue() and
+ * PIOS_IRQ_Epilogue(), less those of the handlers that preempted them.
+ * UAVO callbacks are charged the cycles between cpuaccount_begin() and
+ * cpuaccount_callback(), less those of interrupts and of other callbacks
+ * run in the meantime; a higher priority task preempting one is still
+ * counted against it.  Tasks come from the RTOS runtime stats.  Each
+ * taskmonitor update publishes the busiest of all of them in CPUProfile.
+ *
+ * Only built with CPUPROFILE_DIAGNOSTICS, which needs DIAG_TASKS;
+ * otherwise this compiles to nothing.
+ */
+
+//! Where a span of code started, on the stack of the code it measures
+struct cpuaccount_mark {
+	uint32_t start;
+	uint32_t nested;	// cycles charged to interrupts and callbacks then
+};
+
+#if defined(CPUPROFILE_DIAGNOSTICS)
+
+int32_t cpuaccount_initialize(void);
+void cpuaccount_begin(struct cpuaccount_mark *mark);
+void cpuaccount_callback(const void *cb, const struct cpuaccount_mark *mark);
+void cpuaccount_publish(const uint32_t *task_runtime, uint16_t num_tasks,
+		uint32_t task_period);
+
+#else
+
+static inline int32_t cpuaccount_initialize(void) { return 0; }
+static inline void cpuaccount_begin(struct cpuaccount_mark *mark) { (void) mark; }
+static inline void cpuaccount_callback(const void *cb,
+		const struct cpuaccount_mark *mark) { (void) cb; (void) mark; }
+
+#endif /* CPUPROFILE_DIAGNOSTICS */
+
+#endif /* CPUACCOUNT_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -85,6 +85,16 @@ struct frsky_value_item {
 	uint32_t fn_arg;
 };
 
+/**
+ * Scheduling state of one item of a frsky_value_item table
+ */
+struct frsky_value_state {
+	uint32_t last_triggered;
+	uint32_t last_value;
+	uint8_t backoff;
+	bool present;
+};
+
 bool frsky_encode_gps_course(struct frsky_settings *frsky, uint32_t *value, bool test_presence_only, uint32_t arg);
 bool frsky_encode_altitude(struct frsky_settings *frsky, uint32_t *value, bool test_presence_only, uint32_t arg);
 bool frsky_encode_vario(struct frsky_settings *frsky, uint32_t *value, bool test_presence_only, uint32_t arg);
@@ -100,6 +110,13 @@ bool frsky_encode_gps_speed(struct frsky_settings *frsky, uint32_t *value, bool
 bool frsky_encode_gps_time(struct frsky_settings *frsky, uint32_t *value, bool test_presence_only, uint32_t arg);
 bool frsky_encode_rpm(struct frsky_settings *frsky, uint32_t *value, bool test_presence_only, uint32_t arg);
 bool frsky_encode_airspeed(struct frsky_settings *frsky, uint32_t *value, bool test_presence_only, uint32_t arg);
+void frsky_init_items(struct frsky_value_state *state, uint8_t count);
+void frsky_update_presence(struct frsky_settings *frsky, const struct frsky_value_item *items,
+		struct frsky_value_state *state, uint8_t count);
+int32_t frsky_schedule_next(const struct frsky_value_item *items,
+		const struct frsky_value_state *state, uint8_t count);
+bool frsky_encode_item(struct frsky_settings *frsky, const struct frsky_value_item *items,
+		struct frsky_value_state *state, uint8_t count, int32_t item, uint32_t *value);
 uint8_t frsky_insert_byte(uint8_t *obuff, uint16_t *chk, uint8_t byte);
 int32_t frsky_send_frame(uintptr_t com, enum frsky_value_id id, uint32_t value,
 		bool send_prelude);
@@ -0,0 +1,70 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       looptrace.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Tracepoints timing the control path, published in LoopTiming
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef LOOPTRACE_H
+#define LOOPTRACE_H
+
+#include <stdint.h>
+
+/*
+ * Each stage of the control path marks when it starts on a gyro sample and
+ * when it hands its result on.  The time between is counted as the stage's
+ * cycles; it includes interrupts and any higher priority task that ran in
+ * the meantime.  The gyro sample each stage works on is handed down with
+ * its result, so the actuator stage knows how old the sample behind the
+ * outputs it drives is.
+ *
+ * Only built with LOOPTIMING_DIAGNOSTICS; otherwise the tracepoints
+ * compile to nothing.
+ */
+enum looptrace_stage {
+	LOOPTRACE_SENSORS,		// a gyro sample has arrived
+	LOOPTRACE_ATTITUDE,		// from the sensors
+	LOOPTRACE_STABILIZATION,	// from the sensors
+	LOOPTRACE_ACTUATOR,		// from stabilization, ends on output
+	LOOPTRACE_NUM_STAGES
+};
+
+#if defined(LOOPTIMING_DIAGNOSTICS)
+
+int32_t looptrace_initialize(void);
+void looptrace_begin(enum looptrace_stage stage);
+void looptrace_end(enum looptrace_stage stage);
+void looptrace_publish(void);
+
+#else
+
+static inline int32_t looptrace_initialize(void) { return 0; }
+static inline void looptrace_begin(enum looptrace_stage stage) { (void) stage; }
+static inline void looptrace_end(enum looptrace_stage stage) { (void) stage; }
+static inline void looptrace_publish(void) { }
+
+#endif /* LOOPTIMING_DIAGNOSTICS */
+
+#endif /* LOOPTRACE_H */
+
+/**
+ * @}
+ * @}
+ */
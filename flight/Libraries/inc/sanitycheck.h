@@ -28,7 +28,24 @@
 
 #include "systemalarms.h"
 
+/**
+ * What the configuration checks read, so that an update to one object
+ * re-runs only the checks that depend on it
+ */
+enum config_check_dep {
+	CONFIG_DEP_SYSTEMSETTINGS = 0,
+	CONFIG_DEP_MANUALCONTROLSETTINGS,
+	CONFIG_DEP_STABILIZATIONSETTINGS,
+	CONFIG_DEP_STATEESTIMATION,
+	CONFIG_DEP_FLIGHTSTATUS,
+	CONFIG_DEP_NUM,
+};
+
+#define CONFIG_DEP_MASK(dep) (1 << (dep))
+#define CONFIG_DEP_ALL ((1 << CONFIG_DEP_NUM) - 1)
+
 extern int32_t configuration_check();
+extern int32_t configuration_check_changed(uint32_t changed);
 void set_config_error(SystemAlarmsConfigErrorOptions error_code);
 
 #endif /* SANITYCHECK_H */
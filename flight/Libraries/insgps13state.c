@@ -28,6 +28,7 @@
 
 #include "insgps.h"
 #include "physical_constants.h"
+#include "pios_heap.h"
 #include <math.h>
 #include <stdint.h>
 
@@ -57,11 +58,12 @@ static void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV]);
 static void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX]);
 
 // Private variables
-static float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];	// linearized system matrices
-static float Be[3];	                    // local magnetic unit vector in NED frame
-static float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
-static float Q[NUMW], R[NUMV];   // input noise and measurement noise variances
-static float K[NUMX][NUMV];	     // feedback gain matrix
+// Every step works through these, so they go in fast RAM
+PIOS_FAST_DATA static float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];	// linearized system matrices
+PIOS_FAST_DATA static float Be[3];	                    // local magnetic unit vector in NED frame
+PIOS_FAST_DATA static float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
+PIOS_FAST_DATA static float Q[NUMW], R[NUMV];   // input noise and measurement noise variances
+PIOS_FAST_DATA static float K[NUMX][NUMV];	     // feedback gain matrix
 
 //  *************  Exposed Functions ****************
 //  *************************************************
@@ -322,6 +324,23 @@ void INSCovariancePrediction(float dT)
 	CovariancePrediction(F, G, Q, dT, P);
 }
 
+/**
+ * Advance the covariance once over several state predictions.  The process
+ * noise goes in as T^2*Q per prediction, so it is divided by the number of
+ * steps to add the same amount as predicting each step on its own would.
+ * @param[in] dT the time spanned by all of the steps
+ * @param[in] steps how many state predictions were made
+ */
+void INSCovariancePredictionSteps(float dT, uint8_t steps)
+{
+	float Qsteps[NUMW];
+
+	for (int i = 0; i < NUMW; i++)
+		Qsteps[i] = Q[i] / steps;
+
+	CovariancePrediction(F, G, Qsteps, dT, P);
+}
+
 void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[3],
 		   float BaroAlt, uint16_t SensorsUsed)
 {
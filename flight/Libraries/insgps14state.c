@@ -31,6 +31,7 @@
 
 #include "insgps.h"
 #include "physical_constants.h"
+#include "pios_heap.h"
 #include <math.h>
 #include <stdint.h>
 
@@ -60,12 +61,12 @@ void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV]);
 void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX]);
 
 // Private variables
-float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];	// linearized system matrices
+// Every step works through these, so they go in fast RAM
+PIOS_FAST_DATA float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];	// linearized system matrices
 													// global to init to zero and maintain zero elements
-float Be[3];			// local magnetic unit vector in NED frame
-float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
-float Q[NUMW], R[NUMV];		// input noise and measurement noise variances
-float K[NUMX][NUMV];		// feedback gain matrix
+PIOS_FAST_DATA float Be[3];			// local magnetic unit vector in NED frame
+PIOS_FAST_DATA float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
+PIOS_FAST_DATA float Q[NUMW], R[NUMV];		// input noise and measurement noise variances
 
 //  *************  Exposed Functions ****************
 //  *************************************************
@@ -89,10 +90,8 @@ void INSGPSInit()		//pretty much just a place holder for now
 		for (int j = 0; j < NUMW; j++)
 			G[i][j] = 0.0f;
 			
-		for (int j = 0; j < NUMV; j++) {
+		for (int j = 0; j < NUMV; j++)
 			H[j][i] = 0.0f;
-			K[i][j] = 0.0f;
-		}
 			
 		X[i] = 0.0f;
 	}
@@ -125,6 +124,10 @@ void INSGPSInit()		//pretty much just a place holder for now
 	R[5] = 0.004f;		// High freq GPS vertical velocity noise variance (m/s)^2
 	R[6] = R[7] = R[8] = 0.005f;	// magnetometer unit vector noise variance
 	R[9] = .05f;		// High freq altimeter noise variance (m^2)
+
+	// Only the magnetometer rows of H depend on the state, so the rest
+	// are set up once here
+	LinearizeH(X, Be, H);
 }
 
 //! Set the current flight state
@@ -351,6 +354,23 @@ void INSCovariancePrediction(float dT)
 	CovariancePrediction(F, G, Q, dT, P);
 }
 
+/**
+ * Advance the covariance once over several state predictions.  The process
+ * noise goes in as T^2*Q per prediction, so it is divided by the number of
+ * steps to add the same amount as predicting each step on its own would.
+ * @param[in] dT the time spanned by all of the steps
+ * @param[in] steps how many state predictions were made
+ */
+void INSCovariancePredictionSteps(float dT, uint8_t steps)
+{
+	float Qsteps[NUMW];
+
+	for (int i = 0; i < NUMW; i++)
+		Qsteps[i] = Q[i] / steps;
+
+	CovariancePrediction(F, G, Qsteps, dT, P);
+}
+
 void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[3],
 		   float BaroAlt, uint16_t SensorsUsed)
 {
@@ -396,7 +416,8 @@ void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[
 	Z[9] = BaroAlt;
 
 	// EKF correction step
-	LinearizeH(X, Be, H);
+	if (SensorsUsed & MAG_SENSORS)
+		LinearizeH(X, Be, H);
 	MeasurementEq(X, Be, Y);
 	SerialUpdate(H, R, Z, Y, P, X, SensorsUsed);
 	qmag = sqrtf(X[6] * X[6] + X[7] * X[7] + X[8] * X[8] + X[9] * X[9]);
@@ -416,7 +437,8 @@ void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[
 //  Q is vector of the diagonal for a square matrix with
 //    dimensions equal to the number of disturbance noise variables
 //  The General Method is very inefficient,not taking advantage of the sparse F and G
-//  The first Method is very specific to this implementation
+//  The Expanded Method is very specific to this implementation
+//  The Factored Method, the default, walks only the nonzero blocks of F and G
 //  ************************************************
 
 #ifdef COVARIANCE_PREDICTION_GENERAL
@@ -448,7 +470,7 @@ void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 		}
 }
 
-#else
+#elif defined(COVARIANCE_PREDICTION_EXPANDED)
 
 void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 			  float Q[NUMW], float dT, float P[NUMX][NUMX])
@@ -573,6 +595,110 @@ void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 	P[13][13] = Q[9]*Tsq + D[13][13];
 
 }
+
+#else
+
+// Blocks of the state; F is only nonzero for
+//   position  <- velocity (identity)
+//   velocity  <- quaternion, accel bias
+//   quaternion <- quaternion, gyro bias
+// and the biases are random walks.
+#define POS 0
+#define VEL 3
+#define QUAT 6
+#define GBIAS 10
+#define ABIAS 13
+
+// (I+F*T)*P; kept off the stack.  The bias rows are the same as in P, so
+// they are left out.
+PIOS_FAST_DATA static float PhiP[GBIAS][NUMX];
+
+void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
+			  float Q[NUMW], float dT, float P[NUMX][NUMX])
+{
+	float T, Tsq;
+	uint8_t i, j, k;
+
+	//  Pnew = (I+F*T)*P*(I+F*T)' + T^2*G*Q*G', one factor at a time
+
+	T = dT;
+	Tsq = dT * dT;
+
+	// Calculate PhiP = (I+F*T)*P a row at a time, adding T*F[i][k] times
+	// row k of P for each nonzero entry of F
+	for (i = 0; i < GBIAS; i++)
+		for (j = 0; j < NUMX; j++)
+			PhiP[i][j] = P[i][j];
+
+	for (i = POS; i < VEL; i++)
+		for (j = 0; j < NUMX; j++)
+			PhiP[i][j] += T * P[i + VEL][j];
+
+	for (i = VEL; i < QUAT; i++) {
+		float f = T * F[i][ABIAS];
+		for (j = 0; j < NUMX; j++)
+			PhiP[i][j] += f * P[ABIAS][j];
+
+		for (k = QUAT; k < GBIAS; k++) {
+			f = T * F[i][k];
+			for (j = 0; j < NUMX; j++)
+				PhiP[i][j] += f * P[k][j];
+		}
+	}
+
+	for (i = QUAT; i < GBIAS; i++)
+		for (k = QUAT; k < ABIAS; k++) {
+			float f = T * F[i][k];
+			for (j = 0; j < NUMX; j++)
+				PhiP[i][j] += f * P[k][j];
+		}
+
+	// Calculate Pnew = PhiP*(I+F*T)', only the upper triangular as it is
+	// symmetric, so column j of the product takes row j of F
+	for (j = POS; j < VEL; j++)
+		for (i = 0; i <= j; i++)
+			P[i][j] = PhiP[i][j] + T * PhiP[i][j + VEL];
+
+	for (j = VEL; j < QUAT; j++)
+		for (i = 0; i <= j; i++) {
+			float s = F[j][ABIAS] * PhiP[i][ABIAS];
+			for (k = QUAT; k < GBIAS; k++)
+				s += F[j][k] * PhiP[i][k];
+			P[i][j] = PhiP[i][j] + T * s;
+		}
+
+	for (j = QUAT; j < GBIAS; j++)
+		for (i = 0; i <= j; i++) {
+			float s = 0;
+			for (k = QUAT; k < ABIAS; k++)
+				s += F[j][k] * PhiP[i][k];
+			P[i][j] = PhiP[i][j] + T * s;
+		}
+
+	for (j = GBIAS; j < NUMX; j++)
+		for (i = 0; i < GBIAS; i++)
+			P[i][j] = PhiP[i][j];
+
+	// Add T^2*G*Q*G'; accel noise drives the velocity and gyro noise the
+	// quaternion, and the bias walks go straight onto the diagonal
+	for (i = VEL; i < QUAT; i++)
+		for (j = i; j < QUAT; j++)
+			P[i][j] += (Q[3] * G[i][3] * G[j][3] + Q[4] * G[i][4] * G[j][4] +
+					Q[5] * G[i][5] * G[j][5]) * Tsq;
+
+	for (i = QUAT; i < GBIAS; i++)
+		for (j = i; j < GBIAS; j++)
+			P[i][j] += (Q[0] * G[i][0] * G[j][0] + Q[1] * G[i][1] * G[j][1] +
+					Q[2] * G[i][2] * G[j][2]) * Tsq;
+
+	for (i = GBIAS; i < NUMX; i++)
+		P[i][i] += Q[i - 4] * Tsq;
+
+	for (i = 0; i < NUMX; i++)	// Fill in the lower triangular
+		for (j = i + 1; j < NUMX; j++)
+			P[j][i] = P[i][j];
+}
+
 #endif
 
 //  *************  SerialUpdate *******************
@@ -589,13 +715,18 @@ void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 //            - or see Simon, "Optimal State Estimation," 1st Ed, p.150
 //  The SensorsUsed variable is a bitwise mask indicating which sensors
 //     should be used in the update.
+//  Each row of H is only nonzero over the columns in H_first..H_last, so
+//     a measurement costs in proportion to the states it sees.
 //  ************************************************
 
+static const uint8_t H_first[NUMV] = {0, 1, 2, 3, 4, 5, 6, 6, 6, 2};
+static const uint8_t H_last[NUMV]  = {1, 2, 3, 4, 5, 6, 10, 10, 10, 3};
+
 void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
 		  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
 		  uint16_t SensorsUsed)
 {
-	float HP[NUMX], HPHR, Error;
+	float HP[NUMX], K[NUMX], HPHR, Error;
 	uint8_t i, j, k, m;
 
 	// Iterate through all the possible measurements and apply the
@@ -606,25 +737,25 @@ void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
 
 			for (j = 0; j < NUMX; j++) {	// Find Hp = H*P
 				HP[j] = 0.0f;
-				for (k = 0; k < NUMX; k++)
+				for (k = H_first[m]; k < H_last[m]; k++)
 					HP[j] += H[m][k] * P[k][j];
 			}
 			HPHR = R[m];	// Find  HPHR = H*P*H' + R
-			for (k = 0; k < NUMX; k++)
+			for (k = H_first[m]; k < H_last[m]; k++)
 				HPHR += HP[k] * H[m][k];
 
 			for (k = 0; k < NUMX; k++)
-				K[k][m] = HP[k] / HPHR;	// find K = HP/HPHR
+				K[k] = HP[k] / HPHR;	// find K = HP/HPHR; only this column is kept
 
 			for (i = 0; i < NUMX; i++) {	// Find P(m)= P(m-1) + K*HP
 				for (j = i; j < NUMX; j++)
 					P[i][j] = P[j][i] =
-					    P[i][j] - K[i][m] * HP[j];
+					    P[i][j] - K[i] * HP[j];
 			}
 
 			Error = Z[m] - Y[m];
 			for (i = 0; i < NUMX; i++)	// Find X(m)= X(m-1) + K*Error
-				X[i] = X[i] + K[i][m] * Error;
+				X[i] = X[i] + K[i] * Error;
 
 		}
 	}
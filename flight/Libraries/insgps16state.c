@@ -336,6 +336,23 @@ void INSCovariancePrediction(float dT)
 	CovariancePrediction(F, G, Q, dT, P);
 }
 
+/**
+ * Advance the covariance once over several state predictions.  The process
+ * noise goes in as T^2*Q per prediction, so it is divided by the number of
+ * steps to add the same amount as predicting each step on its own would.
+ * @param[in] dT the time spanned by all of the steps
+ * @param[in] steps how many state predictions were made
+ */
+void INSCovariancePredictionSteps(float dT, uint8_t steps)
+{
+	float Qsteps[NUMW];
+
+	for (int i = 0; i < NUMW; i++)
+		Qsteps[i] = Q[i] / steps;
+
+	CovariancePrediction(F, G, Qsteps, dT, P);
+}
+
 void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[3],
 		   float BaroAlt, uint16_t SensorsUsed)
 {
@@ -0,0 +1,278 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       looptrace.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Tracepoints timing the control path, published in LoopTiming
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "openpilot.h"
+#include "looptrace.h"
+
+#if defined(LOOPTIMING_DIAGNOSTICS)
+
+#include "looptiming.h"
+
+// Private constants
+#define HIST_BUCKETS 8
+#define LATENCY_HIST_SHIFT 6	// first bucket under 64 us
+#define JITTER_HIST_SHIFT 1	// first bucket under 2 us
+
+DONT_BUILD_IF(HIST_BUCKETS != LOOPTIMING_LATENCYHISTOGRAM_NUMELEM, LoopTimingLatencyBuckets);
+DONT_BUILD_IF(HIST_BUCKETS != LOOPTIMING_JITTERHISTOGRAM_NUMELEM, LoopTimingJitterBuckets);
+DONT_BUILD_IF(LOOPTRACE_NUM_STAGES != LOOPTIMING_STAGECYCLESAVG_NUMELEM, LoopTimingStages);
+
+// Private types
+
+//! Min, max and sum of a series, in raw delay ticks
+struct series {
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+	uint32_t count;
+};
+
+//! What is gathered over one update period
+struct window {
+	struct series stage[LOOPTRACE_NUM_STAGES];
+	struct series period;
+	struct series latency;
+	uint16_t jitter_hist[HIST_BUCKETS];
+	uint16_t latency_hist[HIST_BUCKETS];
+};
+
+//! Where each stage is with its current sample
+struct stage_state {
+	uint32_t begin;		// when the stage started on it
+	uint32_t sample;	// when the sample it works on arrived
+	uint32_t handed_on;	// the sample of the last result it handed on
+	bool running;
+};
+
+// Private variables
+
+static const enum looptrace_stage upstream[LOOPTRACE_NUM_STAGES] = {
+	[LOOPTRACE_SENSORS] = LOOPTRACE_SENSORS,
+	[LOOPTRACE_ATTITUDE] = LOOPTRACE_SENSORS,
+	[LOOPTRACE_STABILIZATION] = LOOPTRACE_SENSORS,
+	[LOOPTRACE_ACTUATOR] = LOOPTRACE_STABILIZATION,
+};
+
+/* The tracepoints write to windows[active] and looptrace_publish() reads
+ * the other.  Every stage runs at a higher priority than the system task
+ * that publishes, so a stage is never left halfway through an update when
+ * the windows swap. */
+static struct window windows[2];
+static volatile uint8_t active;
+
+static struct stage_state stages[LOOPTRACE_NUM_STAGES];
+static uint32_t last_sample;
+static bool have_sample;
+static uint32_t ref_period;	// mean period of the last window
+
+// Private functions
+
+static void series_reset(struct series *s)
+{
+	s->min = UINT32_MAX;
+	s->max = 0;
+	s->sum = 0;
+	s->count = 0;
+}
+
+static void window_reset(struct window *w)
+{
+	memset(w, 0, sizeof(*w));
+
+	for (int i = 0; i < LOOPTRACE_NUM_STAGES; i++) {
+		series_reset(&w->stage[i]);
+	}
+
+	series_reset(&w->period);
+	series_reset(&w->latency);
+}
+
+static inline void series_add(struct series *s, uint32_t ticks)
+{
+	if (ticks < s->min)
+		s->min = ticks;
+	if (ticks > s->max)
+		s->max = ticks;
+
+	s->sum += ticks;
+	s->count++;
+}
+
+//! Mean of a series, in raw ticks, or 0 when it is empty
+static uint32_t series_avg(const struct series *s)
+{
+	return s->count ? s->sum / s->count : 0;
+}
+
+/**
+ * Count a time in a histogram whose buckets double in width
+ * \param[in] us the time
+ * \param[in] shift log2 of the upper bound of the first bucket
+ */
+static inline void hist_add(uint16_t *hist, uint32_t us, uint8_t shift)
+{
+	uint32_t v = us >> shift;
+	uint8_t bucket = v ? 32 - __builtin_clz(v) : 0;
+
+	bucket = MIN(bucket, HIST_BUCKETS - 1);
+
+	if (hist[bucket] < UINT16_MAX)
+		hist[bucket]++;
+}
+
+static inline uint16_t ticks_to_us(uint32_t ticks)
+{
+	return MIN(PIOS_DELAY_DiffuS2(0, ticks), UINT16_MAX);
+}
+
+/**
+ * Initialise the tracepoints and their object
+ * \return 0 on success, -1 if the object could not be created
+ */
+int32_t looptrace_initialize(void)
+{
+	if (LoopTimingInitialize() == -1)
+		return -1;
+
+	window_reset(&windows[0]);
+	window_reset(&windows[1]);
+
+	return 0;
+}
+
+/**
+ * Mark a stage starting on a sample; for the sensors, that one has arrived
+ * \param[in] stage the stage
+ */
+void looptrace_begin(enum looptrace_stage stage)
+{
+	uint32_t now = PIOS_DELAY_GetRaw();
+	struct stage_state *st = &stages[stage];
+
+	st->begin = now;
+	st->running = true;
+
+	if (stage != LOOPTRACE_SENSORS) {
+		st->sample = stages[upstream[stage]].handed_on;
+		return;
+	}
+
+	st->sample = now;
+
+	if (have_sample) {
+		struct window *w = &windows[active];
+		uint32_t period = now - last_sample;
+
+		series_add(&w->period, period);
+
+		if (ref_period) {
+			uint32_t dev = (period > ref_period) ?
+				period - ref_period : ref_period - period;
+			hist_add(w->jitter_hist, PIOS_DELAY_DiffuS2(0, dev),
+					JITTER_HIST_SHIFT);
+		}
+	}
+
+	last_sample = now;
+	have_sample = true;
+}
+
+/**
+ * Mark a stage handing its result on; for the actuator, the outputs have
+ * been driven.  Call it before the object that wakes the next stage is set.
+ * \param[in] stage the stage
+ */
+void looptrace_end(enum looptrace_stage stage)
+{
+	uint32_t now = PIOS_DELAY_GetRaw();
+	struct stage_state *st = &stages[stage];
+
+	// A stage that gave up on its sample has nothing to count
+	if (!st->running)
+		return;
+
+	struct window *w = &windows[active];
+
+	st->running = false;
+	st->handed_on = st->sample;
+
+	series_add(&w->stage[stage], now - st->begin);
+
+	if (stage == LOOPTRACE_ACTUATOR && st->sample) {
+		uint32_t latency = now - st->sample;
+
+		series_add(&w->latency, latency);
+		hist_add(w->latency_hist, PIOS_DELAY_DiffuS2(0, latency),
+				LATENCY_HIST_SHIFT);
+	}
+}
+
+/**
+ * Publish what was gathered since the last call and start again.  Called
+ * about once a second from the system task.
+ */
+void looptrace_publish(void)
+{
+	struct window *w = &windows[active];
+
+	active = !active;
+
+	LoopTimingData timing;
+
+	timing.Samples = MIN(w->period.count, UINT16_MAX);
+	timing.PeriodMin = w->period.count ? ticks_to_us(w->period.min) : 0;
+	timing.PeriodAvg = ticks_to_us(series_avg(&w->period));
+	timing.PeriodMax = ticks_to_us(w->period.max);
+
+	timing.LatencyMin = w->latency.count ? ticks_to_us(w->latency.min) : 0;
+	timing.LatencyAvg = ticks_to_us(series_avg(&w->latency));
+	timing.LatencyMax = ticks_to_us(w->latency.max);
+
+	memcpy(timing.JitterHistogram, w->jitter_hist, sizeof(timing.JitterHistogram));
+	memcpy(timing.LatencyHistogram, w->latency_hist, sizeof(timing.LatencyHistogram));
+
+	for (int i = 0; i < LOOPTRACE_NUM_STAGES; i++) {
+		const struct series *s = &w->stage[i];
+
+		timing.StageCyclesMin[i] = s->count ? s->min : 0;
+		timing.StageCyclesAvg[i] = series_avg(s);
+		timing.StageCyclesMax[i] = s->max;
+	}
+
+	// Jitter in the next window is against this one's mean
+	if (w->period.count)
+		ref_period = series_avg(&w->period);
+
+	window_reset(w);
+
+	LoopTimingSet(&timing);
+}
+
+#endif /* LOOPTIMING_DIAGNOSTICS */
+
+/**
+ * @}
+ * @}
+ */
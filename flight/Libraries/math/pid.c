@@ -39,6 +39,31 @@ static float deriv_tau = 7.9577e-3f;
 //! Store the setpoint weight to apply for the derivative term
 static float deriv_gamma = 1.0;
 
+/**
+ * The derivative is low pass filtered with a time constant of deriv_tau
+ * (7.9577e-3 means 20 Hz).  For a time step of dT that is
+ *
+ *   D[n] = D[n-1] + dT / (dT + tau) * (Kd * diff / dT - D[n-1])
+ *        = tau * c * D[n-1] + c * Kd * diff,  with c = 1 / (dT + tau)
+ *
+ * which needs one division, done once for all the axes of a step.
+ * @param[in] dT  The time step, nonzero
+ * @returns c above
+ */
+static inline float deriv_coeff(float dT)
+{
+	return 1.0f / (dT + deriv_tau);
+}
+
+//! Run the derivative filter, with the coefficient from deriv_coeff()
+static inline float deriv_filter(struct pid *pid, float diff, float c)
+{
+	float dterm = (deriv_tau * pid->lastDer + pid->d * diff) * c;
+	pid->lastDer = dterm;
+
+	return dterm;
+}
+
 /**
  * Update the PID computation
  * @param[in] pid The PID struture which stores temporary information
@@ -62,9 +87,8 @@ float pid_apply(struct pid *pid, const float err, float dT)
 	pid->lastErr = err;
 	if(pid->d && dT)
 	{
-		dterm = pid->lastDer +  dT / ( dT + deriv_tau) * ((diff * pid->d / dT) - pid->lastDer);
-		pid->lastDer = dterm;            //   ^ set constant to 1/(2*pi*f_cutoff)
-	}	                                 //   7.9577e-3  means 20 Hz f_cutoff
+		dterm = deriv_filter(pid, diff, deriv_coeff(dT));
+	}
  
 	return ((err * pid->p) + pid->iAccumulator + dterm);
 }
@@ -97,9 +121,8 @@ float pid_apply_antiwindup(struct pid *pid, const float err,
 	pid->lastErr = err;
 	if(pid->d && dT)
 	{
-		dterm = pid->lastDer +  dT / ( dT + deriv_tau) * ((diff * pid->d / dT) - pid->lastDer);
-		pid->lastDer = dterm;            //   ^ set constant to 1/(2*pi*f_cutoff)
-	}	                                 //   7.9577e-3  means 20 Hz f_cutoff
+		dterm = deriv_filter(pid, diff, deriv_coeff(dT));
+	}
  
  	// Compute how much (if at all) the output is saturating
 	float ideal_output = ((err * pid->p) + pid->iAccumulator + dterm);
@@ -119,18 +142,11 @@ float pid_apply_antiwindup(struct pid *pid, const float err,
 }
 
 /**
- * Update the PID computation with setpoint weighting on the derivative
- * @param[in] pid The PID struture which stores temporary information
- * @param[in] setpoint The setpoint to use
- * @param[in] measured The measured value of output
- * @param[in] dT  The time step
- * @returns Output the computed controller value
- *
- * This version of apply uses setpoint weighting for the derivative component so the gain
- * on the gyro derivative can be different than the gain on the setpoint derivative
+ * The body of pid_apply_setpoint(), with the derivative filter coefficient
+ * worked out by the caller
  */
-float pid_apply_setpoint(struct pid *pid, struct pid_deadband *deadband, const float setpoint,
-	const float measured, float dT)
+__attribute__((always_inline)) static inline float pid_step_setpoint(struct pid *pid, struct pid_deadband *deadband,
+	const float setpoint, const float measured, float dT, float c)
 {
 	float err = setpoint - measured;
 	float err_d = (deriv_gamma * setpoint - measured);
@@ -157,13 +173,53 @@ float pid_apply_setpoint(struct pid *pid, struct pid_deadband *deadband, const f
 	pid->lastErr = err_d;
 	if(pid->d && dT)
 	{
-		dterm = pid->lastDer +  dT / ( dT + deriv_tau) * ((diff * pid->d / dT) - pid->lastDer);
-		pid->lastDer = dterm;            //   ^ set constant to 1/(2*pi*f_cutoff)
-	}	                                 //   7.9577e-3  means 20 Hz f_cutoff
+		dterm = deriv_filter(pid, diff, c);
+	}
  
 	return ((err * pid->p) + pid->iAccumulator + dterm);
 }
 
+/**
+ * Update the PID computation with setpoint weighting on the derivative
+ * @param[in] pid The PID struture which stores temporary information
+ * @param[in] setpoint The setpoint to use
+ * @param[in] measured The measured value of output
+ * @param[in] dT  The time step
+ * @returns Output the computed controller value
+ *
+ * This version of apply uses setpoint weighting for the derivative component so the gain
+ * on the gyro derivative can be different than the gain on the setpoint derivative
+ */
+float pid_apply_setpoint(struct pid *pid, struct pid_deadband *deadband, const float setpoint,
+	const float measured, float dT)
+{
+	return pid_step_setpoint(pid, deadband, setpoint, measured, dT,
+			dT ? deriv_coeff(dT) : 0);
+}
+
+/**
+ * Update the PIDs of several axes on the same time step, as
+ * pid_apply_setpoint() does for each.  The derivative filter coefficient is
+ * worked out once for all of them.
+ * @param[in] pids The PIDs, one for each axis
+ * @param[in] deadbands The deadband of each axis, or NULL for none
+ * @param[in] setpoints The setpoint of each axis
+ * @param[in] measured The measured value of each axis
+ * @param[out] out The computed controller value of each axis
+ * @param[in] n   The number of axes
+ * @param[in] dT  The time step
+ */
+void pid_apply_setpoint_axes(struct pid *pids, struct pid_deadband *deadbands,
+	const float *setpoints, const float *measured, float *out, int n, float dT)
+{
+	float c = dT ? deriv_coeff(dT) : 0;
+
+	for (int i = 0; i < n; i++) {
+		out[i] = pid_step_setpoint(&pids[i], deadbands ? &deadbands[i] : NULL,
+				setpoints[i], measured[i], dT, c);
+	}
+}
+
 /**
  * Reset a bit
  * @param[in] pid The pid to reset
@@ -53,6 +53,7 @@ struct pid {
 float pid_apply(struct pid *pid, const float err, float dT);
 float pid_apply_antiwindup(struct pid *pid, const float err, float min_bound, float max_bound, float dT);
 float pid_apply_setpoint(struct pid *pid, struct pid_deadband *deadband, const float setpoint, const float measured, float dT);
+void pid_apply_setpoint_axes(struct pid *pids, struct pid_deadband *deadbands, const float *setpoints, const float *measured, float *out, int n, float dT);
 void pid_zero(struct pid *pid);
 void pid_configure(struct pid *pid, float p, float i, float d, float iLim);
 void pid_configure_derivative(float cutoff, float gamma);
@@ -28,6 +28,7 @@
  */
 
 #include "msp.h"
+#include "misc_math.h"
 
 #define MSP_OVERHEAD_BYTES (2 /* preamble */ \
                           + 1 /* direction */ \
@@ -188,6 +189,49 @@ static void process_byte(struct msp_parser *p, uint8_t b)
 	}
 }
 
+/**
+ * Parse a run of received bytes.  The payload of a message, and one that
+ * is being discarded, is taken as a whole span at a time rather than a
+ * byte per state transition.
+ */
+static void process_span(struct msp_parser *p, const uint8_t *buf, uint16_t len)
+{
+	uint16_t i = 0;
+
+	while (i < len) {
+		uint16_t n;
+
+		switch (p->state) {
+		case MSP_STATE_DATA:
+			n = MIN(len - i, p->data_len - p->data_rcvd);
+
+			memcpy(&p->data_buf[p->data_rcvd], &buf[i], n);
+			for (uint16_t j = 0; j < n; j++)
+				p->checksum ^= buf[i + j];
+
+			p->data_rcvd += n;
+			i += n;
+
+			if (p->data_rcvd == p->data_len)
+				p->state = MSP_STATE_CHECKSUM;
+			break;
+		case MSP_STATE_DISCARD:
+			/* the payload and then the checksum byte */
+			n = MIN(len - i, p->data_len + 1 - p->data_rcvd);
+
+			p->data_rcvd += n;
+			i += n;
+
+			if (p->data_rcvd > p->data_len)
+				p->state = MSP_STATE_IDLE;
+			break;
+		default:
+			process_byte(p, buf[i++]);
+			break;
+		}
+	}
+}
+
 /* public */
 
 struct msp_parser *msp_parser_init(enum msp_parser_type type)
@@ -210,8 +254,7 @@ int32_t msp_process_buffer(struct msp_parser *parser, void *buf, uint8_t len)
 	if (!parser_validate(parser))
 		return -1;
 
-	for (unsigned i = 0; i < len; i++)
-		process_byte(parser, ((uint8_t *)buf)[i]);
+	process_span(parser, buf, len);
 
 	return len;
 }
@@ -222,11 +265,15 @@ int32_t msp_process_com(struct msp_parser *parser, struct pios_com_dev *com)
 		return -1;
 
 	int32_t len = 0;
-	uint8_t b;
+	const uint8_t *span;
+	uint16_t span_len;
+
+	/* Parsed where it sits in the port buffer, a contiguous span at a time */
 	/* TODO: fix PIOS_COM to take a pointer */
-	while (PIOS_COM_ReceiveBuffer((uintptr_t)com, &b, 1, 0)) {
-		process_byte(parser, b);
-		len++;
+	while ((span = PIOS_COM_PeekReceiveBuffer((uintptr_t)com, &span_len, 0)) != NULL) {
+		process_span(parser, span, span_len);
+		PIOS_COM_ConsumeReceiveBuffer((uintptr_t)com, span_len);
+		len += span_len;
 	}
 
 	return len;
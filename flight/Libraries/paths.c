@@ -53,6 +53,12 @@ static void path_curve(const float * start_point, const float * end_point,
 
 /**
  * @brief Compute progress along path and deviation from it
+ *
+ * The segment geometry is worked out afresh on each call.  That costs at
+ * most a few square roots, which the FPU does in a handful of cycles, so it
+ * isn't worth keeping per-segment state that callers would have to
+ * invalidate when PathDesired changes.
+ *
  * @param[in] start_point Starting point
  * @param[in] end_point Ending point
  * @param[in] cur_point Current location
@@ -272,9 +278,12 @@ static void path_curve(const float * start_point,
                        struct path_status *status,
                        bool clockwise)
 {
+	float path_north = end_point[0] - start_point[0];
+	float path_east = end_point[1] - start_point[1];
+	float dist_path = sqrtf(path_north * path_north + path_east * path_east);
+
 	// OK for up to 10km
-	float min_radius = sqrtf(powf(start_point[0] - end_point[0], 2) +
-		powf(start_point[1] - end_point[1], 2)) / 2.0f + 0.01f;
+	float min_radius = dist_path / 2.0f + 0.01f;
 
 	if (fabsf(radius) < min_radius) {
 		// This was possibly floating point confusion.
@@ -295,7 +304,6 @@ static void path_curve(const float * start_point,
 	}
 
 	float diff_north, diff_east;
-	float path_north, path_east;
 	float cradius;
 	float normal[2];
 
@@ -371,11 +379,8 @@ static void path_curve(const float * start_point,
 	status->path_direction[0] = normal[0];
 	status->path_direction[1] = normal[1];
 
-	path_north = end_point[0] - start_point[0];
-	path_east = end_point[1] - start_point[1];
 	diff_north = cur_point[0] - start_point[0];
 	diff_east = cur_point[1] - start_point[1];
-	float dist_path = sqrtf( path_north * path_north + path_east * path_east );
 	float dot = path_north * diff_north + path_east * diff_east;
 
 	status->fractional_progress = dot / (dist_path * dist_path);
@@ -38,6 +38,9 @@ int synBytes[MAXDEG];
 /* generator polynomial */
 int genPoly[MAXDEG*2];
 
+/* logs of the generator polynomial coefficients, -1 for zero ones */
+static int genLog[RS_ECC_NPARITY];
+
 int DEBUG = FALSE;
 
 static void
@@ -52,6 +55,12 @@ initialize_ecc ()
 
     /* Compute the encoder generator polynomial */
     compute_genpoly(RS_ECC_NPARITY, genPoly);
+
+    /* The encoder multiplies every byte by each coefficient; keep their
+     * logs so that only the byte's log needs looking up */
+    int i;
+    for (i = 0; i < RS_ECC_NPARITY; i++)
+      genLog[i] = genPoly[i] ? glog[genPoly[i]] : -1;
 }
 
 void
@@ -111,13 +120,22 @@ void
 decode_data(unsigned char data[], int nbytes)
 {
   int i, j, sum;
-  for (j = 0; j < RS_ECC_NPARITY;  j++) {
-    sum	= 0;
-    for (i = 0; i < nbytes; i++) {
-      sum = data[i] ^ gmult(gexp[j+1], sum);
+  int syn[RS_ECC_NPARITY];
+
+  for (j = 0; j < RS_ECC_NPARITY; j++) syn[j] = 0;
+
+  /* All the syndromes in one pass over the data.  Syndrome j is evaluated
+   * at alpha^(j+1), so multiplying by it is adding j+1 to the log. */
+  for (i = 0; i < nbytes; i++) {
+    for (j = 0; j < RS_ECC_NPARITY; j++) {
+      sum = syn[j];
+      if (sum)
+        sum = gexp[glog[sum] + j + 1];
+      syn[j] = data[i] ^ sum;
     }
-    synBytes[j]  = sum;
   }
+
+  for (j = 0; j < RS_ECC_NPARITY; j++) synBytes[j] = syn[j];
 }
 
 
@@ -193,10 +211,20 @@ encode_data (unsigned char msg[], int nbytes, unsigned char dst[])
 
   for (i = 0; i < nbytes; i++) {
     dbyte = msg[i] ^ LFSR[RS_ECC_NPARITY-1];
+    if (dbyte == 0) {
+      /* Nothing to feed back, just shift */
+      for (j = RS_ECC_NPARITY-1; j > 0; j--) LFSR[j] = LFSR[j-1];
+      LFSR[0] = 0;
+      continue;
+    }
+
+    int dlog = glog[dbyte];
     for (j = RS_ECC_NPARITY-1; j > 0; j--) {
-      LFSR[j] = LFSR[j-1] ^ gmult(genPoly[j], dbyte);
+      LFSR[j] = LFSR[j-1];
+      if (genLog[j] >= 0)
+        LFSR[j] ^= gexp[genLog[j] + dlog];
     }
-    LFSR[0] = gmult(genPoly[0], dbyte);
+    LFSR[0] = genLog[0] >= 0 ? gexp[genLog[0] + dlog] : 0;
   }
 
   for (i = 0; i < RS_ECC_NPARITY; i++) 
@@ -61,11 +61,49 @@ static int32_t check_stabilization_rates();
 //! Check the system is safe for autonomous flight
 static int32_t check_safe_autonomous();
 
+//! Check each flight mode switch position is usable on this airframe
+static int32_t check_flight_modes();
+
+/* The checks, in the order their errors take precedence, with the
+ * objects each reads and the result of its last run */
+static struct config_check {
+	uint32_t deps;
+	int32_t (*check)();
+	int32_t result;
+} config_checks[] = {
+	{
+		.deps = CONFIG_DEP_MASK(CONFIG_DEP_SYSTEMSETTINGS) |
+			CONFIG_DEP_MASK(CONFIG_DEP_MANUALCONTROLSETTINGS) |
+			CONFIG_DEP_MASK(CONFIG_DEP_STATEESTIMATION),
+		.check = check_flight_modes,
+	},
+	{
+		.deps = CONFIG_DEP_MASK(CONFIG_DEP_STABILIZATIONSETTINGS),
+		.check = check_stabilization_rates,
+	},
+	{
+		// Only counts if no other errors exist
+		.deps = CONFIG_DEP_MASK(CONFIG_DEP_FLIGHTSTATUS),
+		.check = check_safe_to_arm,
+	},
+};
+
 /**
  * Run a preflight check over the hardware configuration
  * and currently active modules
  */
 int32_t configuration_check()
+{
+	return configuration_check_changed(CONFIG_DEP_ALL);
+}
+
+/**
+ * Re-run the checks that read any of the changed objects, and set the
+ * alarm from their results and the kept results of the others.
+ * @param[in] changed mask of the enum config_check_dep objects updated
+ * since the last call; the first call should be CONFIG_DEP_ALL
+ */
+int32_t configuration_check_changed(uint32_t changed)
 {
 	SystemAlarmsConfigErrorOptions error_code = SYSTEMALARMS_CONFIGERROR_NONE;
 	
@@ -77,6 +115,30 @@ int32_t configuration_check()
 		return 0;
 	}
 
+	for (uint32_t i = 0; i < NELEMENTS(config_checks); i++) {
+		struct config_check *c = &config_checks[i];
+
+		if (c->deps & changed)
+			c->result = c->check();
+
+		if (error_code == SYSTEMALARMS_CONFIGERROR_NONE)
+			error_code = c->result;
+	}
+
+	set_config_error(error_code);
+
+	return 0;
+}
+
+/**
+ * For each available flight mode position sanity check the available
+ * modes
+ * @returns SYSTEMALARMS_CONFIGERROR_NONE or the error of the first bad one
+ */
+static int32_t check_flight_modes()
+{
+	SystemAlarmsConfigErrorOptions error_code = SYSTEMALARMS_CONFIGERROR_NONE;
+
 	// Classify airframe type
 	bool multirotor = true;
 	uint8_t airframe_type;
@@ -97,8 +159,6 @@ int32_t configuration_check()
 			multirotor = false;
 	}
 
-	// For each available flight mode position sanity check the available
-	// modes
 	uint8_t num_modes;
 	uint8_t modes[MANUALCONTROLSETTINGS_FLIGHTMODEPOSITION_NUMELEM];
 	ManualControlSettingsFlightModeNumberGet(&num_modes);
@@ -161,15 +221,7 @@ int32_t configuration_check()
 		}
 	}
 
-	// Check the stabilization rates are within what the sensors can track
-	error_code = (error_code == SYSTEMALARMS_CONFIGERROR_NONE) ? check_stabilization_rates() : error_code;
-
-	// Only check safe to arm if no other errors exist
-	error_code = (error_code == SYSTEMALARMS_CONFIGERROR_NONE) ? check_safe_to_arm() : error_code;
-
-	set_config_error(error_code);
-
-	return 0;
+	return error_code;
 }
 
 
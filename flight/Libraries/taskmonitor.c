@@ -27,6 +27,7 @@
 #include "openpilot.h"
 //#include "taskmonitor.h"
 #include "pios_mutex.h"
+#include "cpuaccount.h"
 
 // Private constants
 
@@ -36,6 +37,10 @@
 static struct pios_mutex *lock;
 static struct pios_thread *handles[TASKINFO_RUNNING_NUMELEM];
 static uint32_t lastMonitorTime;
+#if defined(DIAG_TASKS)
+static TaskInfoData published;		// as last set
+static uint8_t nextStackCheck;
+#endif
 
 // Private functions
 
@@ -68,6 +73,9 @@ int32_t TaskMonitorAdd(TaskInfoRunningElem task, struct pios_thread *threadp)
 	{
 		PIOS_Mutex_Lock(lock, PIOS_MUTEX_TIMEOUT_MAX);
 		handles[task_idx] = threadp;
+#if defined(DIAG_TASKS)
+		published.StackRemaining[task_idx] = 0;
+#endif
 		PIOS_Mutex_Unlock(lock);
 		return 0;
 	}
@@ -108,7 +116,9 @@ bool TaskMonitorQueryRunning(TaskInfoRunningElem task)
 }
 
 /**
- * Update the status of all tasks
+ * Update the status of all tasks.  The run times of all of them are
+ * updated, but only one task's stack is checked per call, in turn, and
+ * TaskInfo is only set for the fields that changed.
  */
 void TaskMonitorUpdateAll(void)
 {
@@ -121,6 +131,7 @@ void TaskMonitorUpdateAll(void)
 
 	uint32_t currentTime;
 	uint32_t deltaTime;
+	uint32_t runtime[TASKINFO_RUNNING_NUMELEM];
 	
 	/*
 	 * Calculate the amount of elapsed run time between the last time we
@@ -132,29 +143,58 @@ void TaskMonitorUpdateAll(void)
 #elif defined(PIOS_INCLUDE_CHIBIOS)
 	currentTime = hal_lld_get_counter_value();
 #endif /* defined(PIOS_INCLUDE_CHIBIOS) */
-	deltaTime = ((currentTime - lastMonitorTime) / 100) ? : 1; /* avoid divide-by-zero if the interval is too small */
+	uint32_t period = currentTime - lastMonitorTime;
+	deltaTime = (period / 100) ? : 1; /* avoid divide-by-zero if the interval is too small */
 	lastMonitorTime = currentTime;
 	
+	// Only the next running task's stack is checked, the rest stand
+	memcpy(data.StackRemaining, published.StackRemaining, sizeof(data.StackRemaining));
+
+	for (n = 0; n < TASKINFO_RUNNING_NUMELEM; ++n)
+	{
+		uint8_t task = nextStackCheck;
+
+		nextStackCheck = (nextStackCheck + 1) % TASKINFO_RUNNING_NUMELEM;
+
+		if (handles[task] != 0) {
+			data.StackRemaining[task] = PIOS_Thread_Get_Stack_Usage_Since(
+					handles[task], published.StackRemaining[task]);
+			break;
+		}
+	}
+
 	// Update all task information
 	for (n = 0; n < TASKINFO_RUNNING_NUMELEM; ++n)
 	{
 		if (handles[n] != 0)
 		{
 			data.Running[n] = TASKINFO_RUNNING_TRUE;
-			data.StackRemaining[n] = PIOS_Thread_Get_Stack_Usage(handles[n]);
 			/* Generate run time stats */
-			data.RunningTime[n] = PIOS_Thread_Get_Runtime(handles[n]) / deltaTime;
+			runtime[n] = PIOS_Thread_Get_Runtime(handles[n]);
+			data.RunningTime[n] = runtime[n] / deltaTime;
 		}
 		else
 		{
 			data.Running[n] = TASKINFO_RUNNING_FALSE;
 			data.StackRemaining[n] = 0;
 			data.RunningTime[n] = 0;
+			runtime[n] = 0;
 		}
 	}
 
-	// Update object
-	TaskInfoSet(&data);
+#if defined(CPUPROFILE_DIAGNOSTICS)
+	cpuaccount_publish(runtime, TASKINFO_RUNNING_NUMELEM, period);
+#endif
+
+	// Update the fields that changed
+	if (memcmp(data.StackRemaining, published.StackRemaining, sizeof(data.StackRemaining)))
+		TaskInfoStackRemainingSet(data.StackRemaining);
+	if (memcmp(data.Running, published.Running, sizeof(data.Running)))
+		TaskInfoRunningSet(data.Running);
+	if (memcmp(data.RunningTime, published.RunningTime, sizeof(data.RunningTime)))
+		TaskInfoRunningTimeSet(data.RunningTime);
+
+	published = data;
 
 	// Done
 	PIOS_Mutex_Unlock(lock);
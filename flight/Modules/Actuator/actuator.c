@@ -53,7 +53,10 @@
 #include "manualcontrolcommand.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
+#include "pios_mutex.h"
 #include "misc_math.h"
+#include "looptrace.h"
+#include "actuator.h"
 
 // Private constants
 #define MAX_QUEUE_SIZE 2
@@ -75,8 +78,9 @@
 static struct pios_queue *queue;
 static struct pios_thread *taskHandle;
 
-static bool flightStatusUpdated = true;
-static bool manualControlCommandUpdated = true;
+// Read plainly every loop, refreshed by whoever changes them
+static struct uavo_snapshot flight_status_snap;
+static struct uavo_snapshot manual_control_snap;
 
 // used to inform the actuator thread that actuator / mixer settings are updated
 // set true to ensure they're fetched on first run
@@ -89,18 +93,36 @@ static MixerSettingsData mixerSettings;
 // Ditto, for the actuator settings.
 static ActuatorSettingsData actuatorSettings;
 
+static SystemSettingsAirframeTypeOptions airframe_type;
+
+// The mixer settings compiled for the loop: the type of each channel, and
+// a matrix taking the mixer inputs to the servo and motor channels
+PIOS_FAST_DATA static MixerSettingsMixer1TypeOptions mixer_types[MAX_MIX_ACTUATORS];
+PIOS_FAST_DATA static float mixer_matrix[MAX_MIX_ACTUATORS][MIXERSETTINGS_MIXER1VECTOR_NUMELEM];
+static uint8_t num_mixers;
+
+// Kept here rather than on the stack of whichever task does the mixing
+static ActuatorCommandData command;
+static MixerStatusData mixerStatus;
+static uint32_t last_systime;
+
+// If the stabilization task mixes and drives the outputs itself
+static volatile bool direct_output;
+
+// Held while mixing, so the failsafe can't interleave with a direct update
+static struct pios_mutex *output_lock;
+
 // Private functions
 static void actuator_task(void* parameters);
+static void actuator_process(ActuatorDesiredData *desired);
 static float scale_channel(float value, int idx);
 static void set_failsafe();
 static float throt_curve(const float input, const float* curve, uint8_t num_points);
 static float collective_curve(const float input, const float* curve, uint8_t num_points);
 static bool set_channel(uint8_t mixer_channel, float value);
 static void actuator_set_servo_mode(void);
-float process_mixer(const int index, const float curve1, const float curve2,
-		ActuatorDesiredData *desired);
-static float mix_channel(int ct, ActuatorDesiredData *desired,
-		float curve1, float curve2);
+static void compile_mixer(void);
+static float unmixed_channel(int ct);
 
 static MixerSettingsMixer1TypeOptions get_mixer_type(int idx);
 static typeof(mixerSettings.Mixer1Vector) *get_mixer_vec(int idx);
@@ -147,6 +169,11 @@ int32_t ActuatorInitialize()
 	queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
 	ActuatorDesiredConnectQueue(queue);
 
+	output_lock = PIOS_Mutex_Create();
+	if (output_lock == NULL) {
+		return -1;
+	}
+
 	// Primary output of this module
 	if (ActuatorCommandInitialize() == -1) {
 		return -1;
@@ -163,16 +190,16 @@ int32_t ActuatorInitialize()
 }
 MODULE_HIPRI_INITCALL(ActuatorInitialize, ActuatorStart);
 
-static float get_curve2_source(ActuatorDesiredData *desired, SystemSettingsAirframeTypeOptions airframe_type, MixerSettingsCurve2SourceOptions source)
+static float get_curve2_source(ActuatorDesiredData *desired,
+		const ManualControlCommandData *manual_control_command,
+		SystemSettingsAirframeTypeOptions airframe_type,
+		MixerSettingsCurve2SourceOptions source)
 {
-	float tmp;
-
 	switch (source) {
 	case MIXERSETTINGS_CURVE2SOURCE_THROTTLE:
 		if(airframe_type == SYSTEMSETTINGS_AIRFRAMETYPE_HELICP)
 		{
-			ManualControlCommandThrottleGet(&tmp);
-			return tmp;
+			return manual_control_command->Throttle;
 		}
 		return desired->Thrust;
 		break;
@@ -190,8 +217,7 @@ static float get_curve2_source(ActuatorDesiredData *desired, SystemSettingsAirfr
 		{
 			return desired->Thrust;
 		}
-		ManualControlCommandCollectiveGet(&tmp);
-		return tmp;
+		return manual_control_command->Collective;
 		break;
 	case MIXERSETTINGS_CURVE2SOURCE_ACCESSORY0:
 	case MIXERSETTINGS_CURVE2SOURCE_ACCESSORY1:
@@ -227,35 +253,36 @@ static float get_curve2_source(ActuatorDesiredData *desired, SystemSettingsAirfr
  */
 static void actuator_task(void* parameters)
 {
-	float dT = 0.0f;
-
-	ActuatorCommandData command;
-	ActuatorDesiredData desired;
-	MixerStatusData mixerStatus;
-	FlightStatusData flightStatus;
-	ManualControlCommandData manual_control_command;
-
-	SystemSettingsAirframeTypeOptions airframe_type;
-
-	// Connect update callbacks
-	FlightStatusConnectCallbackCtx(UAVObjCbSetFlag, &flightStatusUpdated);
-	ManualControlCommandConnectCallbackCtx(UAVObjCbSetFlag, &manualControlCommandUpdated);
+	// Connect snapshots of what the loop reads
+	int32_t snap_ret = FlightStatusConnectSnapshot(&flight_status_snap);
+	PIOS_Assert(snap_ret == 0);
+	snap_ret = ManualControlCommandConnectSnapshot(&manual_control_snap);
+	PIOS_Assert(snap_ret == 0);
 
 	// Main task loop
-	uint32_t last_systime = PIOS_Thread_Systime();
+	last_systime = PIOS_Thread_Systime();
 
 	bool rc = false;
 
 	while (1) {
+		PIOS_Mutex_Lock(output_lock, PIOS_MUTEX_TIMEOUT_MAX);
+
 		if (actuator_settings_updated) {
 			actuator_settings_updated = false;
 			ActuatorSettingsGet(&actuatorSettings);
 			actuator_set_servo_mode();
+
+#if !defined(SMALLF1)
+			// The small stabilization stack has no room for the mixer
+			direct_output = actuatorSettings.DirectOutput ==
+				ACTUATORSETTINGS_DIRECTOUTPUT_TRUE;
+#endif
 		}
 		if (mixer_settings_updated) {
 			mixer_settings_updated = false;
 			MixerSettingsGet(&mixerSettings);
 			SystemSettingsAirframeTypeGet(&airframe_type);
+			compile_mixer();
 		}
 
 		if (rc != true) {
@@ -264,6 +291,8 @@ static void actuator_task(void* parameters)
 			set_failsafe();
 		}
 
+		PIOS_Mutex_Unlock(output_lock);
+
 		PIOS_WDG_UpdateFlag(PIOS_WDG_ACTUATOR);
 
 		UAVObjEvent ev;
@@ -272,228 +301,303 @@ static void actuator_task(void* parameters)
 		rc = PIOS_Queue_Receive(queue, &ev, FAILSAFE_TIMEOUT_MS);
 
 		/* If we timed out, go to top of loop, which sets failsafe
-		 * and waits again. */
-		if (rc != true) {
+		 * and waits again.  When the stabilization task drives the
+		 * outputs this update is already mixed, and only shows that
+		 * task is still running. */
+		if (rc != true || direct_output) {
 			continue;
 		}
 
-		// Check how long since last update
-		uint32_t this_systime = PIOS_Thread_Systime();
-		if (this_systime > last_systime) // reuse dt in case of wraparound
-			dT = (this_systime - last_systime) / 1000.0f;
-		last_systime = this_systime;
-
+		ActuatorDesiredData desired;
 		ActuatorDesiredGet(&desired);
-		ActuatorCommandGet(&command);
 
-		if (flightStatusUpdated) {
-			FlightStatusGet(&flightStatus);
-			flightStatusUpdated = false;
-		}
+		PIOS_Mutex_Lock(output_lock, PIOS_MUTEX_TIMEOUT_MAX);
+		actuator_process(&desired);
+		PIOS_Mutex_Unlock(output_lock);
+	}
+}
 
-		if (manualControlCommandUpdated) {
-			ManualControlCommandGet(&manual_control_command);
-			manualControlCommandUpdated = false;
-		}
+/**
+ * @brief Mix one update of ActuatorDesired and drive the outputs with it
+ *
+ * Called with output_lock held, from the actuator task or from the
+ * stabilization task through ActuatorDirectUpdate().
+ * @param[in] desired the command to mix
+ */
+static void actuator_process(ActuatorDesiredData *desired)
+{
+	static float dT = 0.0f;
 
-		int nMixers = 0;
+	looptrace_begin(LOOPTRACE_ACTUATOR);
 
-		for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
-			if (get_mixer_type(ct) != MIXERSETTINGS_MIXER1TYPE_DISABLED) {
-				nMixers++;
-			}
-		}
-		if ((nMixers < 2) && !ActuatorCommandReadOnly()) { //Nothing can fly with less than two mixers.
-			set_failsafe(); // So that channels like PWM buzzer keep working
-			continue;
+	// Check how long since last update
+	uint32_t this_systime = PIOS_Thread_Systime();
+	if (this_systime > last_systime) // reuse dt in case of wraparound
+		dT = (this_systime - last_systime) / 1000.0f;
+	last_systime = this_systime;
+
+	ActuatorCommandGet(&command);
+
+	const FlightStatusData *flightStatus =
+		FlightStatusSnapshotRead(&flight_status_snap);
+	const ManualControlCommandData *manual_control_command =
+		ManualControlCommandSnapshotRead(&manual_control_snap);
+
+	if ((num_mixers < 2) && !ActuatorCommandReadOnly()) { //Nothing can fly with less than two mixers.
+		set_failsafe(); // So that channels like PWM buzzer keep working
+		looptrace_end(LOOPTRACE_ACTUATOR);
+		return;
+	}
+
+	bool armed = flightStatus->Armed == FLIGHTSTATUS_ARMED_ARMED;
+	bool spin_while_armed = actuatorSettings.MotorsSpinWhileArmed == ACTUATORSETTINGS_MOTORSSPINWHILEARMED_TRUE;
+
+	float throttle_source = -1;
+	// as long as we're not a heli in failsafe mode, we should set throttle from the manual throttle value
+	// if we're not a heli, set it from the thrust value
+	if (airframe_type == SYSTEMSETTINGS_AIRFRAMETYPE_HELICP) {
+		if (flightStatus->FlightMode != FLIGHTSTATUS_FLIGHTMODE_FAILSAFE) {
+			throttle_source = manual_control_command->Throttle;
 		}
+	} else {
+		throttle_source = desired->Thrust;
+	}
 
-		bool armed = flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED;
-		bool spin_while_armed = actuatorSettings.MotorsSpinWhileArmed == ACTUATORSETTINGS_MOTORSSPINWHILEARMED_TRUE;
+	bool stabilize_now = armed && (throttle_source > 0.0f);
 
-		float throttle_source = -1;
-		// as long as we're not a heli in failsafe mode, we should set throttle from the manual throttle value
-		// if we're not a heli, set it from the thrust value
-		if (airframe_type == SYSTEMSETTINGS_AIRFRAMETYPE_HELICP) {
-			if (flightStatus.FlightMode != FLIGHTSTATUS_FLIGHTMODE_FAILSAFE) {
-				throttle_source = manual_control_command.Throttle;
-			}
+	static uint32_t last_pos_throttle_time = 0;
+
+	if (stabilize_now) {
+		if (actuatorSettings.LowPowerStabilizationMaxTime) {
+			last_pos_throttle_time = this_systime;
+		}
+
+		// Could consider stabilizing on a positive arming edge,
+		// but this seems problematic.
+	} else if (last_pos_throttle_time) {
+		if ((this_systime - last_pos_throttle_time) <
+				1000.0f * actuatorSettings.LowPowerStabilizationMaxTime) {
+			stabilize_now = true;
+			throttle_source = 0.0f;
 		} else {
-			throttle_source = desired.Thrust;
+			last_pos_throttle_time = 0;
 		}
+	}
 
-		bool stabilize_now = armed && (throttle_source > 0.0f);
+	float curve1 = throt_curve(throttle_source, mixerSettings.ThrottleCurve1, MIXERSETTINGS_THROTTLECURVE1_NUMELEM);
 
-		static uint32_t last_pos_throttle_time = 0;
+	//The source for the secondary curve is selectable
+	float curve2 = collective_curve(
+			get_curve2_source(desired, manual_control_command,
+				airframe_type, mixerSettings.Curve2Source),
+			mixerSettings.ThrottleCurve2,
+			MIXERSETTINGS_THROTTLECURVE2_NUMELEM);
 
-		if (stabilize_now) {
-			if (actuatorSettings.LowPowerStabilizationMaxTime) {
-				last_pos_throttle_time = this_systime;
-			}
+	float * status = (float *)&mixerStatus; //access status objects as an array of floats
 
-			// Could consider stabilizing on a positive arming edge,
-			// but this seems problematic.
-		} else if (last_pos_throttle_time) {
-			if ((this_systime - last_pos_throttle_time) <
-					1000.0f * actuatorSettings.LowPowerStabilizationMaxTime) {
-				stabilize_now = true;
-				throttle_source = 0.0f;
-			} else {
-				last_pos_throttle_time = 0;
-			}
+	const float inputs[MIXERSETTINGS_MIXER1VECTOR_NUMELEM] = {
+		[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE1] = curve1,
+		[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE2] = curve2,
+		[MIXERSETTINGS_MIXER1VECTOR_ROLL] = desired->Roll,
+		[MIXERSETTINGS_MIXER1VECTOR_PITCH] = desired->Pitch,
+		[MIXERSETTINGS_MIXER1VECTOR_YAW] = desired->Yaw,
+	};
+
+	// Rows of channels that aren't mixed are zero
+	for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
+		float sum = 0;
+
+		for (int i = 0; i < MIXERSETTINGS_MIXER1VECTOR_NUMELEM; i++) {
+			sum += mixer_matrix[ct][i] * inputs[i];
 		}
 
-		float curve1 = throt_curve(throttle_source, mixerSettings.ThrottleCurve1, MIXERSETTINGS_THROTTLECURVE1_NUMELEM);
+		status[ct] = sum;
+	}
 
-		//The source for the secondary curve is selectable
-		float curve2 = collective_curve(
-				get_curve2_source(&desired, airframe_type, mixerSettings.Curve2Source),
-				mixerSettings.ThrottleCurve2,
-				MIXERSETTINGS_THROTTLECURVE2_NUMELEM);
+	float min_chan = INFINITY;
+	float max_chan = -INFINITY;
+	float neg_clip = 0;
+	int num_motors = 0;
 
-		float * status = (float *)&mixerStatus; //access status objects as an array of floats
+	for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
+		switch (mixer_types[ct]) {
+		case MIXERSETTINGS_MIXER1TYPE_SERVO:
+			continue;
+		case MIXERSETTINGS_MIXER1TYPE_MOTOR:
+			break;
+		default:
+			status[ct] = unmixed_channel(ct);
+			continue;
+		}
 
-		float min_chan = INFINITY;
-		float max_chan = -INFINITY;
-		float neg_clip = 0;
-		int num_motors = 0;
+		min_chan = fminf(min_chan, status[ct]);
+		max_chan = fmaxf(max_chan, status[ct]);
 
-		for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
-			status[ct] = mix_channel(ct, &desired, curve1, curve2);
+		if (status[ct] < 0.0f) {
+			neg_clip += status[ct];
+		}
 
-			if (get_mixer_type(ct) == MIXERSETTINGS_MIXER1TYPE_MOTOR) {
-				min_chan = fminf(min_chan, status[ct]);
-				max_chan = fmaxf(max_chan, status[ct]);
+		num_motors++;
+	}
 
-				if (status[ct] < 0.0f) {
-					neg_clip += status[ct];
-				}
+	float gain = 1.0f;
+	float offset = 0.0f;
 
-				num_motors++;
-			}
-		}
+	/* This is a little dubious.  Scale down command ranges to
+	 * fit.  It may cause some cross-axis coupling, though
+	 * generally less than if we were to actually let it clip.
+	 */
+	if ((max_chan - min_chan) > 1.0f) {
+		gain = 1.0f / (max_chan - min_chan);
 
-		float gain = 1.0f;
-		float offset = 0.0f;
+		max_chan *= gain;
+		min_chan *= gain;
+	}
 
-		/* This is a little dubious.  Scale down command ranges to
-		 * fit.  It may cause some cross-axis coupling, though
-		 * generally less than if we were to actually let it clip.
+	/* Sacrifice throttle because of clipping */
+	if (max_chan > 1.0f) {
+		offset = 1.0f - max_chan;
+	} else if (min_chan < 0.0f) {
+		/* Low-side clip management-- how much power are we
+		 * willing to add??? */
+
+		neg_clip /= num_motors;
+
+		/* neg_clip is now the amount of throttle "already added." by
+		 * clipping...
+		 *
+		 * Find the "highest possible value" of offset.
+		 * if neg_clip is -15%, and maxpoweradd is 10%, we need to add
+		 * -5% to all motors.
+		 * if neg_clip is 5%, and maxpoweradd is 10%, we can add up to
+		 * 5% to all motors to further fix clipping.
 		 */
-		if ((max_chan - min_chan) > 1.0f) {
-			gain = 1.0f / (max_chan - min_chan);
+		offset = neg_clip + actuatorSettings.LowPowerStabilizationMaxPowerAdd;
 
-			max_chan *= gain;
-			min_chan *= gain;
-		}
+		/* Add the lesser of--
+		 * A) the amount the lowest channel is out of range.
+		 * B) the above calculated offset.
+		 */
+		offset = MIN(-min_chan, offset);
+	}
 
-		/* Sacrifice throttle because of clipping */
-		if (max_chan > 1.0f) {
-			offset = 1.0f - max_chan;
-		} else if (min_chan < 0.0f) {
-			/* Low-side clip management-- how much power are we
-			 * willing to add??? */
-
-			neg_clip /= num_motors;
-
-			/* neg_clip is now the amount of throttle "already added." by
-			 * clipping...
-			 *
-			 * Find the "highest possible value" of offset.
-			 * if neg_clip is -15%, and maxpoweradd is 10%, we need to add
-			 * -5% to all motors.
-			 * if neg_clip is 5%, and maxpoweradd is 10%, we can add up to
-			 * 5% to all motors to further fix clipping.
-			 */
-			offset = neg_clip + actuatorSettings.LowPowerStabilizationMaxPowerAdd;
-
-			/* Add the lesser of--
-			 * A) the amount the lowest channel is out of range.
-			 * B) the above calculated offset.
-			 */
-			offset = MIN(-min_chan, offset);
-		}
+	for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
+		// Motors have additional protection for when to be on
+		if (mixer_types[ct] == MIXERSETTINGS_MIXER1TYPE_MOTOR) {
+			if (!armed) {
+				status[ct] = -1;  //force min throttle
+			} else if (!stabilize_now) {
+				if (!spin_while_armed) {
+					status[ct] = -1;
+				} else {
+					status[ct] = 0;
+				}
+			} else {
+				status[ct] = status[ct] * gain + offset;
 
-		for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
-			// Motors have additional protection for when to be on
-			if (get_mixer_type(ct) == MIXERSETTINGS_MIXER1TYPE_MOTOR) {
-				if (!armed) {
-					status[ct] = -1;  //force min throttle
-				} else if (!stabilize_now) {
-					if (!spin_while_armed) {
-						status[ct] = -1;
-					} else {
-						status[ct] = 0;
-					}
+				if (status[ct] > 0) {
+					// Apply curve fitting, mapping the input to the propeller output.
+					status[ct] = powapprox(status[ct], actuatorSettings.MotorInputOutputCurveFit);
 				} else {
-					status[ct] = status[ct] * gain + offset;
-
-					if (status[ct] > 0) {
-						// Apply curve fitting, mapping the input to the propeller output.
-						status[ct] = powapprox(status[ct], actuatorSettings.MotorInputOutputCurveFit);
-					} else {
-						status[ct] = 0;
-					}
+					status[ct] = 0;
 				}
 			}
-
-			command.Channel[ct] = scale_channel(status[ct], ct);
 		}
 
-		// Store update time
-		command.UpdateTime = 1000.0f*dT;
-		if (1000.0f*dT > command.MaxUpdateTime)
-			command.MaxUpdateTime = 1000.0f*dT;
+		command.Channel[ct] = scale_channel(status[ct], ct);
+	}
 
-		// Update output object
-		if (!ActuatorCommandReadOnly()) {
-			ActuatorCommandSet(&command);
-		} else {
-			// it's read only during servo configuration--
-			// so GCS takes precedence.
-			ActuatorCommandGet(&command);
-		}
+	// Store update time
+	command.UpdateTime = 1000.0f*dT;
+	if (1000.0f*dT > command.MaxUpdateTime)
+		command.MaxUpdateTime = 1000.0f*dT;
+
+	if (ActuatorCommandReadOnly()) {
+		// it's read only during servo configuration--
+		// so GCS takes precedence.
+		ActuatorCommandGet(&command);
+	}
+
+	// Update servo outputs
+	bool success = true;
+
+	for (int n = 0; n < ACTUATORCOMMAND_CHANNEL_NUMELEM; ++n) {
+		success &= set_channel(n, command.Channel[n]);
+	}
+
+	PIOS_Servo_Update();
+	looptrace_end(LOOPTRACE_ACTUATOR);
+
+	// Publish what was output only now, so it adds nothing to the delay
+	if (!ActuatorCommandReadOnly()) {
+		ActuatorCommandSet(&command);
+	}
 
 #if defined(MIXERSTATUS_DIAGNOSTICS)
-		MixerStatusSet(&mixerStatus);
+	MixerStatusSet(&mixerStatus);
 #endif
 
-		// Update servo outputs
-		bool success = true;
+	if (!success) {
+		command.NumFailedUpdates++;
+		ActuatorCommandSet(&command);
+		AlarmsSet(SYSTEMALARMS_ALARM_ACTUATOR, SYSTEMALARMS_ALARM_CRITICAL);
+	} else {
+		AlarmsClear(SYSTEMALARMS_ALARM_ACTUATOR);
+	}
+}
 
-		for (int n = 0; n < ACTUATORCOMMAND_CHANNEL_NUMELEM; ++n) {
-			success &= set_channel(n, command.Channel[n]);
-		}
+/**
+ * @brief Mix and drive the outputs from the calling task, if enabled
+ *
+ * With ActuatorSettings.DirectOutput the stabilization task calls this as
+ * soon as its control loop is done, rather than waking the actuator task
+ * through ActuatorDesired.
+ * @param[in] desired the command to mix
+ * @return true if the outputs were updated, false if the actuator task
+ * does it as usual
+ */
+bool ActuatorDirectUpdate(ActuatorDesiredData *desired)
+{
+	if (!direct_output) {
+		return false;
+	}
 
-		PIOS_Servo_Update();
+	PIOS_Mutex_Lock(output_lock, PIOS_MUTEX_TIMEOUT_MAX);
+	actuator_process(desired);
+	PIOS_Mutex_Unlock(output_lock);
 
-		if (!success) {
-			command.NumFailedUpdates++;
-			ActuatorCommandSet(&command);
-			AlarmsSet(SYSTEMALARMS_ALARM_ACTUATOR, SYSTEMALARMS_ALARM_CRITICAL);
-		} else {
-			AlarmsClear(SYSTEMALARMS_ALARM_ACTUATOR);
-		}
-	}
+	return true;
 }
 
 /**
- *Process mixing for one actuator
+ * Compile the mixer settings into the types and matrix used each loop, so
+ * mixing doesn't have to go through the settings channel by channel
  */
-float process_mixer(const int index, const float curve1, const float curve2,
-		ActuatorDesiredData *desired)
+static void compile_mixer(void)
 {
-	// Taking the pointer to the array preserves type information so smart compilers
-	// can detect accesses past the end.
-	typeof(mixerSettings.Mixer1Vector) *vector = get_mixer_vec(index);
+	num_mixers = 0;
 
-	float result = (((*vector)[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE1] * curve1) +
-			((*vector)[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE2] * curve2) +
-			((*vector)[MIXERSETTINGS_MIXER1VECTOR_ROLL] * desired->Roll) +
-			((*vector)[MIXERSETTINGS_MIXER1VECTOR_PITCH] * desired->Pitch) +
-			((*vector)[MIXERSETTINGS_MIXER1VECTOR_YAW] * desired->Yaw)) * (1.0f / MULTIROTOR_MIXER_UPPER_BOUND);
+	for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
+		MixerSettingsMixer1TypeOptions type = get_mixer_type(ct);
 
-	return (result);
+		// Taking the pointer to the array preserves type information so smart compilers
+		// can detect accesses past the end.
+		typeof(mixerSettings.Mixer1Vector) *vector = get_mixer_vec(ct);
+
+		bool mixed = (type == MIXERSETTINGS_MIXER1TYPE_SERVO) ||
+			(type == MIXERSETTINGS_MIXER1TYPE_MOTOR);
+
+		for (int i = 0; i < MIXERSETTINGS_MIXER1VECTOR_NUMELEM; i++) {
+			mixer_matrix[ct][i] = mixed ?
+				(*vector)[i] * (1.0f / MULTIROTOR_MIXER_UPPER_BOUND) : 0;
+		}
+
+		mixer_types[ct] = type;
+
+		if (type != MIXERSETTINGS_MIXER1TYPE_DISABLED) {
+			num_mixers++;
+		}
+	}
 }
 
 /**
@@ -558,7 +662,7 @@ static float scale_channel(float value, int idx)
 
 static float channel_failsafe_value(int idx)
 {
-	switch (get_mixer_type(idx)) {
+	switch (mixer_types[idx]) {
 	case MIXERSETTINGS_MIXER1TYPE_MOTOR:
 		return actuatorSettings.ChannelMin[idx];
 	case MIXERSETTINGS_MIXER1TYPE_SERVO:
@@ -723,10 +827,13 @@ static void actuator_set_servo_mode(void)
 			actuatorSettings.ChannelMin);
 }
 
-static float mix_channel(int ct, ActuatorDesiredData *desired,
-		float curve1, float curve2)
+/**
+ * Value of a channel that isn't mixed from the desired attitude, which
+ * the mixer matrix leaves at zero
+ */
+static float unmixed_channel(int ct)
 {
-	MixerSettingsMixer1TypeOptions type = get_mixer_type(ct);
+	MixerSettingsMixer1TypeOptions type = mixer_types[ct];
 
 	switch (type) {
 	case MIXERSETTINGS_MIXER1TYPE_DISABLED:
@@ -735,14 +842,9 @@ static float mix_channel(int ct, ActuatorDesiredData *desired,
 		break;
 
 	case MIXERSETTINGS_MIXER1TYPE_SERVO:
-		return process_mixer(ct, curve1, curve2, desired);
-		break;
-
 	case MIXERSETTINGS_MIXER1TYPE_MOTOR:
-		(void) 0;               // nil statement
-		float val = process_mixer(ct, curve1, curve2, desired);
-
-		return val;
+		// Mixed by the matrix
+		return 0;
 		break;
 	// If an accessory channel is selected for direct bypass mode
 	// In this configuration the accessory channel is scaled and
@@ -66,10 +66,20 @@
 #define STACK_SIZE_BYTES 648
 #define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
 
+#define UPDATE_PERIOD_MS 20		// run no faster than the estimator, or this
+#define ESTIMATOR_TIMEOUT_MS 100	// engaged with no estimate for this long is an error
+#define STATE_DECIMATION 5		// set AltitudeHoldState every this many runs
+
 // Private variables
 static struct pios_thread *altitudeHoldTaskHandle;
 static struct pios_queue *queue;
 static bool module_enabled;
+static volatile bool settings_updated;
+
+static struct uavo_snapshot position_snap;
+static struct uavo_snapshot velocity_snap;
+static struct uavo_snapshot desired_snap;
+static struct uavo_snapshot attitude_snap;
 
 // Private functions
 static void altitudeHoldTask(void *parameters);
@@ -141,12 +151,18 @@ MODULE_INITCALL(AltitudeHoldInitialize, AltitudeHoldStart);
 
 /**
  * Module thread, should not return.
+ *
+ * While engaged the loop runs on the estimator's updates of VelocityActual,
+ * which follow those of PositionActual, so it uses each new estimate once
+ * and the control locks to the estimator.  The connection is throttled to
+ * the loop period, and dropped while disengaged.
  */
 static void altitudeHoldTask(void *parameters)
 {
 	bool engaged = false;
+	bool estimator_ok = true;
+	uint32_t iteration = 0;
 
-	AltitudeHoldDesiredData altitudeHoldDesired;
 	StabilizationDesiredData stabilizationDesired;
 	AltitudeHoldSettingsData altitudeHoldSettings;
 
@@ -154,8 +170,18 @@ static void altitudeHoldTask(void *parameters)
 	struct pid velocity_pid;
 
 	// Listen for object updates.
-	AltitudeHoldSettingsConnectQueue(queue);
 	FlightStatusConnectQueue(queue);
+	AltitudeHoldSettingsConnectCallbackCtx(UAVObjCbSetFlag, &settings_updated);
+
+	// Connect snapshots of what the loop reads
+	int32_t snap_ret = PositionActualConnectSnapshot(&position_snap);
+	PIOS_Assert(snap_ret == 0);
+	snap_ret = VelocityActualConnectSnapshot(&velocity_snap);
+	PIOS_Assert(snap_ret == 0);
+	snap_ret = AltitudeHoldDesiredConnectSnapshot(&desired_snap);
+	PIOS_Assert(snap_ret == 0);
+	snap_ret = AttitudeActualConnectSnapshot(&attitude_snap);
+	PIOS_Assert(snap_ret == 0);
 
 	AltitudeHoldSettingsGet(&altitudeHoldSettings);
 	pid_configure(&velocity_pid, altitudeHoldSettings.VelocityKp,
@@ -164,12 +190,27 @@ static void altitudeHoldTask(void *parameters)
 	AlarmsSet(SYSTEMALARMS_ALARM_ALTITUDEHOLD, SYSTEMALARMS_ALARM_OK);
 
 	// Main task loop
-	const uint32_t dt_ms = 20;
-	uint32_t timeout = dt_ms;
 	uint32_t timeval = PIOS_DELAY_GetRaw();
 
 	while (1) {
-		if (PIOS_Queue_Receive(queue, &ev, timeout) != true) {
+		bool received = PIOS_Queue_Receive(queue, &ev,
+				engaged ? ESTIMATOR_TIMEOUT_MS : PIOS_QUEUE_TIMEOUT_MAX);
+
+		if (settings_updated) {
+			settings_updated = false;
+			AltitudeHoldSettingsGet(&altitudeHoldSettings);
+
+			pid_configure(&velocity_pid, altitudeHoldSettings.VelocityKp,
+				          altitudeHoldSettings.VelocityKi, 0.0f, 1.0f);
+		}
+
+		if (!received) {
+			// Engaged, but the estimator stopped updating
+			if (estimator_ok) {
+				AlarmsSet(SYSTEMALARMS_ALARM_ALTITUDEHOLD, SYSTEMALARMS_ALARM_ERROR);
+				estimator_ok = false;
+			}
+			continue;
 
 		} else if (ev.obj == FlightStatusHandle()) {
 
@@ -180,106 +221,117 @@ static void altitudeHoldTask(void *parameters)
 				// Copy the current throttle as a starting point for integral
 				StabilizationDesiredThrustGet(&velocity_pid.iAccumulator);
 				engaged = true;
+				iteration = 0;
 				timeval = PIOS_DELAY_GetRaw();
 
-			} else if (flight_mode != FLIGHTSTATUS_FLIGHTMODE_ALTITUDEHOLD)
+				UAVObjConnectQueueThrottled(VelocityActualHandle(), queue,
+						EV_MASK_ALL_UPDATES, UPDATE_PERIOD_MS);
+
+			} else if (flight_mode != FLIGHTSTATUS_FLIGHTMODE_ALTITUDEHOLD && engaged) {
 				engaged = false;
 
-			// Run loop at 20 Hz when engaged otherwise just slowly wait for it to be engaged
-			timeout = engaged ? dt_ms : 100;
+				UAVObjDisconnectQueue(VelocityActualHandle(), queue);
 
-			continue;
+				if (!estimator_ok) {
+					AlarmsSet(SYSTEMALARMS_ALARM_ALTITUDEHOLD, SYSTEMALARMS_ALARM_OK);
+					estimator_ok = true;
+				}
+			}
 
-		} else if (ev.obj == AltitudeHoldSettingsHandle()) {
-			AltitudeHoldSettingsGet(&altitudeHoldSettings);
+			continue;
 
-			pid_configure(&velocity_pid, altitudeHoldSettings.VelocityKp,
-				          altitudeHoldSettings.VelocityKi, 0.0f, 1.0f);
+		} else if (ev.obj != VelocityActualHandle() || !engaged) {
+			// Queued before disengaging
 			continue;
 		}
 
-		bool landing = altitudeHoldDesired.Land == ALTITUDEHOLDDESIRED_LAND_TRUE;
+		if (!estimator_ok) {
+			AlarmsSet(SYSTEMALARMS_ALARM_ALTITUDEHOLD, SYSTEMALARMS_ALARM_OK);
+			estimator_ok = true;
+		}
+
+		// One estimate, and the set point and attitude as they were for it
+		const PositionActualData *positionActual = PositionActualSnapshotRead(&position_snap);
+		const VelocityActualData *velocityActual = VelocityActualSnapshotRead(&velocity_snap);
+		const AltitudeHoldDesiredData *altitudeHoldDesired = AltitudeHoldDesiredSnapshotRead(&desired_snap);
+
+		bool landing = altitudeHoldDesired->Land == ALTITUDEHOLDDESIRED_LAND_TRUE;
 
 		// For landing mode allow throttle to go negative to allow the integrals
 		// to stop winding up
 		const float min_throttle = landing ? -0.1f : 0.0f;
 
-		// When engaged compute altitude controller output
-		if (engaged) {
-			float position_z, velocity_z, altitude_error;
-
-			PositionActualDownGet(&position_z);
-			VelocityActualDownGet(&velocity_z);
-			position_z = -position_z; // Use positive up convention
-			velocity_z = -velocity_z; // Use positive up convention
-
-			// Compute the altitude error
-			AltitudeHoldDesiredGet(&altitudeHoldDesired);
-			altitude_error = altitudeHoldDesired.Altitude - position_z;
-
-			// Velocity desired is from the outer controller plus the set point
-			float dT = PIOS_DELAY_DiffuS(timeval) * 1.0e-6f;
-			timeval = PIOS_DELAY_GetRaw();
-			float velocity_desired = altitude_error * altitudeHoldSettings.PositionKp + altitudeHoldDesired.ClimbRate;
-			float throttle_desired = pid_apply_antiwindup(&velocity_pid, 
-			                    velocity_desired - velocity_z,
-			                    min_throttle, 1.0f, // positive limits since this is throttle
-			                    dT);
-
-			AltitudeHoldStateData altitudeHoldState;
-			altitudeHoldState.VelocityDesired = velocity_desired;
-			altitudeHoldState.Integral = velocity_pid.iAccumulator;
-			altitudeHoldState.AngleGain = 1.0f;
-
-			if (altitudeHoldSettings.AttitudeComp > 0) {
-				// Thrust desired is at this point the mount desired in the up direction, we can
-				// account for the attitude if desired
-				AttitudeActualData attitudeActual;
-				AttitudeActualGet(&attitudeActual);
-
-				// Project a unit vector pointing up into the body frame and
-				// get the z component
-				float fraction = attitudeActual.q1 * attitudeActual.q1 -
-				                 attitudeActual.q2 * attitudeActual.q2 -
-				                 attitudeActual.q3 * attitudeActual.q3 +
-				                 attitudeActual.q4 * attitudeActual.q4;
-
-				// Add ability to scale up the amount of compensation to achieve
-				// level forward flight
-				fraction = powf(fraction, (float) altitudeHoldSettings.AttitudeComp / 100.0f);
-
-				// Dividing by the fraction remaining in the vertical projection will
-				// attempt to compensate for tilt. This acts like the thrust is linear
-				// with the output which isn't really true. If the fraction is starting
-				// to go negative we are inverted and should shut off throttle
-				throttle_desired = (fraction > 0.1f) ? (throttle_desired / fraction) : 0.0f;
-
-				altitudeHoldState.AngleGain = 1.0f / fraction;
-			}
+		// Compute altitude controller output
+		float position_z = -positionActual->Down; // Use positive up convention
+		float velocity_z = -velocityActual->Down; // Use positive up convention
+
+		// Compute the altitude error
+		float altitude_error = altitudeHoldDesired->Altitude - position_z;
+
+		// Velocity desired is from the outer controller plus the set point
+		float dT = PIOS_DELAY_DiffuS(timeval) * 1.0e-6f;
+		timeval = PIOS_DELAY_GetRaw();
+		float velocity_desired = altitude_error * altitudeHoldSettings.PositionKp + altitudeHoldDesired->ClimbRate;
+		float throttle_desired = pid_apply_antiwindup(&velocity_pid, 
+		                    velocity_desired - velocity_z,
+		                    min_throttle, 1.0f, // positive limits since this is throttle
+		                    dT);
+
+		AltitudeHoldStateData altitudeHoldState;
+		altitudeHoldState.VelocityDesired = velocity_desired;
+		altitudeHoldState.Integral = velocity_pid.iAccumulator;
+		altitudeHoldState.AngleGain = 1.0f;
+
+		if (altitudeHoldSettings.AttitudeComp > 0) {
+			// Thrust desired is at this point the mount desired in the up direction, we can
+			// account for the attitude if desired
+			const AttitudeActualData *attitudeActual = AttitudeActualSnapshotRead(&attitude_snap);
+
+			// Project a unit vector pointing up into the body frame and
+			// get the z component
+			float fraction = attitudeActual->q1 * attitudeActual->q1 -
+			                 attitudeActual->q2 * attitudeActual->q2 -
+			                 attitudeActual->q3 * attitudeActual->q3 +
+			                 attitudeActual->q4 * attitudeActual->q4;
+
+			// Add ability to scale up the amount of compensation to achieve
+			// level forward flight
+			fraction = powf(fraction, (float) altitudeHoldSettings.AttitudeComp / 100.0f);
+
+			// Dividing by the fraction remaining in the vertical projection will
+			// attempt to compensate for tilt. This acts like the thrust is linear
+			// with the output which isn't really true. If the fraction is starting
+			// to go negative we are inverted and should shut off throttle
+			throttle_desired = (fraction > 0.1f) ? (throttle_desired / fraction) : 0.0f;
+
+			altitudeHoldState.AngleGain = 1.0f / fraction;
+		}
 
-			altitudeHoldState.Thrust = throttle_desired;
+		altitudeHoldState.Thrust = throttle_desired;
+
+		// The state is only for watching the loop, so it needn't go out
+		// every time the loop runs
+		if (iteration++ % STATE_DECIMATION == 0)
 			AltitudeHoldStateSet(&altitudeHoldState);
 
-			stabilizationDesired.Thrust = bound_min_max(throttle_desired, min_throttle, 1.0f);
-
-			if (landing) {
-				stabilizationDesired.StabilizationMode[STABILIZATIONDESIRED_STABILIZATIONMODE_ROLL] = STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE;
-				stabilizationDesired.StabilizationMode[STABILIZATIONDESIRED_STABILIZATIONMODE_PITCH] = STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE;
-				stabilizationDesired.StabilizationMode[STABILIZATIONDESIRED_STABILIZATIONMODE_YAW] = STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK;
-				stabilizationDesired.Roll = 0;
-				stabilizationDesired.Pitch = 0;
-				stabilizationDesired.Yaw = 0;
-			} else {
-				stabilizationDesired.StabilizationMode[STABILIZATIONDESIRED_STABILIZATIONMODE_ROLL] = STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE;
-				stabilizationDesired.StabilizationMode[STABILIZATIONDESIRED_STABILIZATIONMODE_PITCH] = STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE;
-				stabilizationDesired.StabilizationMode[STABILIZATIONDESIRED_STABILIZATIONMODE_YAW] = STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK;
-				stabilizationDesired.Roll = altitudeHoldDesired.Roll;
-				stabilizationDesired.Pitch = altitudeHoldDesired.Pitch;
-				stabilizationDesired.Yaw = altitudeHoldDesired.Yaw;
-			}
-			StabilizationDesiredSet(&stabilizationDesired);
+		stabilizationDesired.Thrust = bound_min_max(throttle_desired, min_throttle, 1.0f);
+
+		if (landing) {
+			stabilizationDesired.StabilizationMode[STABILIZATIONDESIRED_STABILIZATIONMODE_ROLL] = STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE;
+			stabilizationDesired.StabilizationMode[STABILIZATIONDESIRED_STABILIZATIONMODE_PITCH] = STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE;
+			stabilizationDesired.StabilizationMode[STABILIZATIONDESIRED_STABILIZATIONMODE_YAW] = STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK;
+			stabilizationDesired.Roll = 0;
+			stabilizationDesired.Pitch = 0;
+			stabilizationDesired.Yaw = 0;
+		} else {
+			stabilizationDesired.StabilizationMode[STABILIZATIONDESIRED_STABILIZATIONMODE_ROLL] = STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE;
+			stabilizationDesired.StabilizationMode[STABILIZATIONDESIRED_STABILIZATIONMODE_PITCH] = STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE;
+			stabilizationDesired.StabilizationMode[STABILIZATIONDESIRED_STABILIZATIONMODE_YAW] = STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK;
+			stabilizationDesired.Roll = altitudeHoldDesired->Roll;
+			stabilizationDesired.Pitch = altitudeHoldDesired->Pitch;
+			stabilizationDesired.Yaw = altitudeHoldDesired->Yaw;
 		}
-
+		StabilizationDesiredSet(&stabilizationDesired);
 	}
 }
 
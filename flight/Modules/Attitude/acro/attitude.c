@@ -48,7 +48,6 @@
 #include "misc_math.h"
 #include "coordinate_conversions.h"
 #include <pios_board_info.h>
-#include "pios_queue.h"
  
 // Private constants
 #define STACK_SIZE_BYTES 616
@@ -284,16 +283,13 @@ static int32_t updateSensorsDigital(AccelsData * accelsData, GyrosData * gyrosDa
 {
 	struct pios_sensor_gyro_data gyros;
 	struct pios_sensor_accel_data accels;
-	struct pios_queue *queue;
 
-	queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_GYRO);
-	if (queue == NULL || PIOS_Queue_Receive(queue, (void *)&gyros, SENSOR_PERIOD) == false)
+	if (!PIOS_SENSORS_GetData(PIOS_SENSOR_GYRO, &gyros, SENSOR_PERIOD))
 		return -1;
 
 	// As it says below, because the rest of the code expects the accel to be ready when
 	// the gyro is we must block here too
-	queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_ACCEL);
-	if (queue == NULL || PIOS_Queue_Receive(queue, (void *)&accels, 1) == false)
+	if (!PIOS_SENSORS_GetData(PIOS_SENSOR_ACCEL, &accels, 1))
 		return -1;
 	
 	update_accels(&accels, accelsData);
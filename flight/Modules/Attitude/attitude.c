@@ -51,6 +51,7 @@
 #include "pios_thread.h"
 #include "pios_queue.h"
 #include "misc_math.h"
+#include "looptrace.h"
 #include "physical_constants.h"
 #include "coordinate_conversions.h"
 #include "WorldMagModel.h"
@@ -169,7 +170,7 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 //! Set the @ref AttitudeActual to the complementary filter estimate
 static int32_t setAttitudeComplementary();
 
-static float calc_ned_accel(float *q, float *accels);
+static float calc_ned_accel(float Rbe[3][3], float *accels);
 static void cfvert_reset(struct cfvert *cf, float baro, float time_constant);
 static void cfvert_predict_pos(struct cfvert *cf, float z_accel, float dt);
 static void cfvert_update_baro(struct cfvert *cf, float baro, float dt);
@@ -277,8 +278,8 @@ int32_t AttitudeStart(void)
 	gyrosBias.z = 0;
 	GyrosBiasSet(&gyrosBias);
 
-	GyrosConnectQueue(gyroQueue);
-	AccelsConnectQueue(accelQueue);
+	GyrosConnectQueueCoalesced(gyroQueue);
+	AccelsConnectQueueCoalesced(accelQueue);
 	if (MagnetometerHandle())
 		MagnetometerConnectQueue(magQueue);
 	if (BaroAltitudeHandle())
@@ -404,6 +405,8 @@ static void AttitudeTask(void *parameters)
 
 		updateNedAccel();
 
+		looptrace_end(LOOPTRACE_ATTITUDE);
+
 		if(ret_val == 0)
 			first_run = false;
 
@@ -413,6 +416,12 @@ static void AttitudeTask(void *parameters)
 
 //! The complementary filter attitude estimate
 static float cf_q[4];
+//! The rotation of cf_q, kept in step with it so each step converts once
+static float cf_Rbe[3][3];
+//! Direction of the earth field the magnetometer is held to
+static float cf_be[3] = {1.0f, 0.0f, 0.0f};
+//! If cf_be is usable; false when the home field is null
+static bool cf_be_valid = true;
 
 /**
  * Update the complementary filter estimate of attitude
@@ -428,8 +437,8 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 	// If this is the primary estimation filter, wait until the accel and
 	// gyro objects are updated. If it timeouts then go to failsafe.
 	if (!secondary) {
-		bool gyroTimeout  = PIOS_Queue_Receive(gyroQueue, &ev, FAILSAFE_TIMEOUT_MS) != true;
-		bool accelTimeout = PIOS_Queue_Receive(accelQueue, &ev, 1) != true;
+		bool gyroTimeout  = UAVObjQueueReceive(gyroQueue, &ev, FAILSAFE_TIMEOUT_MS) != true;
+		bool accelTimeout = UAVObjQueueReceive(accelQueue, &ev, 1) != true;
 
 		// When one of these is updated so should the other.
 		if (gyroTimeout || accelTimeout) {
@@ -445,6 +454,8 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 				return -1;
 			}
 		}
+
+		looptrace_begin(LOOPTRACE_ATTITUDE);
 	}
 
 	AccelsGet(&accelsData);
@@ -496,6 +507,7 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 
 		// Convert Euler angles into quaternion
 		RPY2Quaternion(RPY_D, cf_q);
+		Quaternion2R(cf_q, cf_Rbe);
 
 		complementary_filter_state.initialization = CF_POWERON;
 		complementary_filter_state.reset_timeval = PIOS_DELAY_GetRaw();
@@ -509,8 +521,8 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 		return 0;
 	}
 
-	FlightStatusData flightStatus;
-	FlightStatusGet(&flightStatus);
+	uint8_t armed;
+	FlightStatusArmedGet(&armed);
 
 	float accKp = attitudeSettings.AccKp;
 	float accKi = attitudeSettings.AccKi;
@@ -534,7 +546,7 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 		mgKp = 1;
 
 	} else if ((attitudeSettings.ZeroDuringArming == ATTITUDESETTINGS_ZERODURINGARMING_TRUE) && 
-	           (flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMING)) {
+	           (armed == FLIGHTSTATUS_ARMED_ARMING)) {
 		// Use a rapidly decrease accelKp to force the attitude to snap back
 		// to level and then converge more smoothly
 		if (complementary_filter_state.arming_count < 20) {
@@ -600,9 +612,9 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 	apply_accel_filter(&accelsData.x,accels_filtered);
 
 	// Rotate gravity to body frame and cross with accels
-	grot[0] = -(2 * (cf_q[1] * cf_q[3] - cf_q[0] * cf_q[2]));
-	grot[1] = -(2 * (cf_q[2] * cf_q[3] + cf_q[0] * cf_q[1]));
-	grot[2] = -(cf_q[0]*cf_q[0] - cf_q[1]*cf_q[1] - cf_q[2]*cf_q[2] + cf_q[3]*cf_q[3]);
+	grot[0] = -cf_Rbe[0][2];
+	grot[1] = -cf_Rbe[1][2];
+	grot[2] = -cf_Rbe[2][2];
 
 	// Apply same filtering to the rotated attitude to match delays
 	apply_accel_filter(grot,grot_filtered);
@@ -610,20 +622,19 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 	// Compute the error between the predicted direction of gravity and smoothed acceleration
 	CrossProduct((const float *) accels_filtered, (const float *) grot_filtered, accel_err);
 
-	float grot_mag;
+	// Account for the accel and filtered gravity magnitudes, under a single root
+	float grot_mag2;
 	if (complementary_filter_state.accel_filter_enabled)
-		grot_mag = sqrtf(grot_filtered[0]*grot_filtered[0] + grot_filtered[1]*grot_filtered[1] + grot_filtered[2]*grot_filtered[2]);
+		grot_mag2 = grot_filtered[0]*grot_filtered[0] + grot_filtered[1]*grot_filtered[1] + grot_filtered[2]*grot_filtered[2];
 	else
-		grot_mag = 1.0f;
-
-	// Account for accel magnitude
-	float accel_mag;
-	accel_mag = accels_filtered[0]*accels_filtered[0] + accels_filtered[1]*accels_filtered[1] + accels_filtered[2]*accels_filtered[2];
-	accel_mag = sqrtf(accel_mag);
-	if (grot_mag > 1.0e-3f && accel_mag > 1.0e-3f) {
-		accel_err[0] /= (accel_mag * grot_mag);
-		accel_err[1] /= (accel_mag * grot_mag);
-		accel_err[2] /= (accel_mag * grot_mag);
+		grot_mag2 = 1.0f;
+
+	float accel_mag2 = accels_filtered[0]*accels_filtered[0] + accels_filtered[1]*accels_filtered[1] + accels_filtered[2]*accels_filtered[2];
+	if (grot_mag2 > 1.0e-6f && accel_mag2 > 1.0e-6f) {
+		float scale = 1.0f / sqrtf(accel_mag2 * grot_mag2);
+		accel_err[0] *= scale;
+		accel_err[1] *= scale;
+		accel_err[2] *= scale;
 	} else {
 		accel_err[0] = 0;
 		accel_err[1] = 0;
@@ -639,34 +650,23 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 		// Only use the magnetometer data if it is good, i.e. not NAN. A NAN would
 		// normally only arise due to a bad magnetometer calibration.
 		if  (!(IS_NOT_FINITE(mag.x) || IS_NOT_FINITE(mag.y) || IS_NOT_FINITE(mag.z))) {
-			float bmag = 1.0f;
-			float brot[3];
-			float Rbe[3][3];
+			float mag_len2 = mag.x * mag.x + mag.y * mag.y + mag.z * mag.z;
 
-			// Get rotation to bring earth magnetic field into body frame		
-			Quaternion2R(cf_q, Rbe);
-
-			if (homeLocation.Set == HOMELOCATION_SET_TRUE) {
-				rot_mult(Rbe, homeLocation.Be, brot, false);
-				bmag = sqrtf(brot[0] * brot[0] + brot[1] * brot[1] + brot[2] * brot[2]);
-				brot[0] /= bmag;
-				brot[1] /= bmag;
-				brot[2] /= bmag;
+			// Only compute if neither vector is null
+			if (!cf_be_valid || mag_len2 < 1) {
+				mag_err[0] = mag_err[1] = mag_err[2] = 0;
 			} else {
-				const float Be[3] = {1.0f, 0.0f, 0.0f};
-				rot_mult(Rbe, Be, brot, false);
-			}
+				// Bring the (unit) earth magnetic field into body frame
+				float brot[3];
+				rot_mult(cf_Rbe, cf_be, brot, false);
 
-			float mag_len = sqrtf(mag.x * mag.x + mag.y * mag.y + mag.z * mag.z);
-			mag.x /= mag_len;
-			mag.y /= mag_len;
-			mag.z /= mag_len;
+				float scale = 1.0f / sqrtf(mag_len2);
+				mag.x *= scale;
+				mag.y *= scale;
+				mag.z *= scale;
 
-			// Only compute if neither vector is null
-			if (bmag < 1 || mag_len < 1)
-				mag_err[0] = mag_err[1] = mag_err[2] = 0;
-			else
 				CrossProduct((const float *) &mag.x, (const float *) brot, mag_err);
+			}
 
 			if (mag_err[2] != mag_err[2])
 				mag_err[2] = 0;
@@ -713,10 +713,11 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 	// Renomalize
 	float qmag;
 	qmag = sqrtf(cf_q[0]*cf_q[0] + cf_q[1]*cf_q[1] + cf_q[2]*cf_q[2] + cf_q[3]*cf_q[3]);
-	cf_q[0] = cf_q[0] / qmag;
-	cf_q[1] = cf_q[1] / qmag;
-	cf_q[2] = cf_q[2] / qmag;
-	cf_q[3] = cf_q[3] / qmag;
+	float qscale = 1.0f / qmag;
+	cf_q[0] *= qscale;
+	cf_q[1] *= qscale;
+	cf_q[2] *= qscale;
+	cf_q[3] *= qscale;
 
 	// If quaternion has become inappropriately short or has become Nan reinit.
 	// THIS SHOULD NEVER ACTUALLY HAPPEN
@@ -727,10 +728,13 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
 		cf_q[3] = 0;
 	}
 
+	// Used by the rest of this step and the start of the next
+	Quaternion2R(cf_q, cf_Rbe);
+
 	if (!secondary) {
 
 		// Calculate the NED acceleration and get the z-component
-		float z_accel = calc_ned_accel(cf_q, &accelsData.x);
+		float z_accel = calc_ned_accel(cf_Rbe, &accelsData.x);
 
 		// When this is the only filter compute th vertical state from baro data
 		// Reset the filter for barometric data
@@ -756,14 +760,12 @@ static int32_t updateAttitudeComplementary(float dT, bool first_run, bool second
  * by the altitude controller. Returns the down component for
  * convenience.
  */
-static float calc_ned_accel(float *q, float *accels)
+static float calc_ned_accel(float Rbe[3][3], float *accels)
 {
 	float accel_ned[3];
-	float Rbe[3][3];
 
 	// rotate the accels into the NED frame and remove
 	// the influence of gravity
-	Quaternion2R(q, Rbe);
 	rot_mult(Rbe, accels, accel_ned, true);
 	accel_ned[2] += GRAVITY;
 
@@ -995,6 +997,10 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	static uint32_t ins_last_time = 0;
 	static uint32_t ins_init_time = 0;
 
+	// Time and samples since the covariance was last advanced
+	static float cov_dT;
+	static uint8_t cov_steps;
+
 	static enum {INS_INIT, INS_WARMUP, INS_RUNNING} ins_state;
 
 	float NED[3] = {0.0f, 0.0f, 0.0f};
@@ -1019,6 +1025,9 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 
 		ins_last_time = PIOS_DELAY_GetRaw();
 
+		cov_dT = 0;
+		cov_steps = 0;
+
 		return 0;
 	}
 
@@ -1028,12 +1037,14 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	gps_vel_updated = gps_vel_updated || (PIOS_Queue_Receive(gpsVelQueue, &ev, 0) && outdoor_mode);
 
 	// Wait until the gyro and accel object is updated, if a timeout then go to failsafe
-	if (PIOS_Queue_Receive(gyroQueue, &ev, FAILSAFE_TIMEOUT_MS) != true ||
-		PIOS_Queue_Receive(accelQueue, &ev, 1) != true)
+	if (UAVObjQueueReceive(gyroQueue, &ev, FAILSAFE_TIMEOUT_MS) != true ||
+		UAVObjQueueReceive(accelQueue, &ev, 1) != true)
 	{
 		return -1;
 	}
 
+	looptrace_begin(LOOPTRACE_ATTITUDE);
+
 	// Get most recent data
 	GyrosGet(&gyrosData);
 	AccelsGet(&accelsData);
@@ -1207,8 +1218,20 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	// Advance the state estimate
 	INSStatePrediction(gyros, &accelsData.x, dT);
 
+	// The attitude is published from every prediction, but the covariance
+	// and corrections only every CorrectionDivider of them.  Sensor
+	// updates stay flagged until then.
+	cov_dT += dT;
+	cov_steps++;
+
+	if (cov_steps < insSettings.CorrectionDivider)
+		return 0;
+
 	// Advance the covariance estimate
-	INSCovariancePrediction(dT);
+	INSCovariancePredictionSteps(cov_dT, cov_steps);
+
+	cov_dT = 0;
+	cov_steps = 0;
 
 	if(mag_updated) {
 		sensors |= MAG_SENSORS;
@@ -1234,6 +1257,17 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		nedPos.Down = NED[2];
 		NEDPositionSet(&nedPos);
 
+		// Follow the field away from home on long flights
+		if (insSettings.MagModelUpdate == INSSETTINGS_MAGMODELUPDATE_TRUE) {
+			GPSTimeData gpsTime;
+			GPSTimeGet(&gpsTime);
+
+			float Be[3];
+			if (WMM_GetMagVectorCached(gpsData.Latitude / 10e6f, gpsData.Longitude / 10e6f,
+					gpsData.Altitude, gpsTime.Month, gpsTime.Day, gpsTime.Year, Be) == 0)
+				INSSetMagNorth(Be);
+		}
+
 		gps_updated = false;
 	}
 
@@ -1302,7 +1336,9 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		INSSetGyroBias(zeros);
 
 	float accel_bias_corrected[3] = {accelsData.x - state.State[13], accelsData.y - state.State[14], accelsData.z - state.State[15]};
-	calc_ned_accel(&state.State[6], accel_bias_corrected);
+	float Rbe[3][3];
+	Quaternion2R(&state.State[6], Rbe);
+	calc_ned_accel(Rbe, accel_bias_corrected);
 
 	return 0;
 }
@@ -1515,6 +1551,25 @@ static void settingsUpdatedCb(UAVObjEvent * ev, void *ctx, void *obj, int len)
 			T[1] = cosf(lat)*(alt+6.378137E6f);
 			T[2] = -1.0f;
 
+			// The complementary filter only needs the direction
+			if (homeLocation.Set == HOMELOCATION_SET_TRUE) {
+				float bmag = sqrtf(homeLocation.Be[0] * homeLocation.Be[0] +
+						homeLocation.Be[1] * homeLocation.Be[1] +
+						homeLocation.Be[2] * homeLocation.Be[2]);
+
+				cf_be_valid = bmag >= 1;
+				if (cf_be_valid) {
+					cf_be[0] = homeLocation.Be[0] / bmag;
+					cf_be[1] = homeLocation.Be[1] / bmag;
+					cf_be[2] = homeLocation.Be[2] / bmag;
+				}
+			} else {
+				cf_be[0] = 1.0f;
+				cf_be[1] = 0.0f;
+				cf_be[2] = 0.0f;
+				cf_be_valid = true;
+			}
+
 			home_location_updated = true;
 		}
 	}
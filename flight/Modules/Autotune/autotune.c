@@ -46,6 +46,8 @@
 #include "stabilizationdesired.h"
 #include "stabilizationsettings.h"
 #include "systemident.h"
+#include "systemidentconvergence.h"
+#include "stabilization.h"
 #include <pios_board_info.h>
 #include "pios_thread.h"
 #include "systemsettings.h"
@@ -60,6 +62,10 @@
 #define AF_NUMX 13
 #define AF_NUMP 43
 
+/* Points are taken off the queue and run through the filter in blocks of
+ * up to this many, in place */
+#define AT_BLOCK_LEN 16
+
 // Private types
 enum AUTOTUNE_STATE { AT_INIT, AT_START, AT_WAITFIRSTPOINT, AT_RUN,
 	AT_WAITING };
@@ -151,6 +157,13 @@ int32_t AutotuneInitialize(void)
 			return -1;
 		}
 
+#ifndef SMALLF1
+		if (SystemIdentConvergenceInitialize() == -1) {
+			module_enabled = false;
+			return -1;
+		}
+#endif
+
 		at_queue = circ_queue_new(sizeof(struct at_queued_data),
 				AT_QUEUE_NUMELEM);
 
@@ -179,9 +192,7 @@ int32_t AutotuneStart(void)
 
 MODULE_INITCALL(AutotuneInitialize, AutotuneStart)
 
-static void at_new_actuators(UAVObjEvent * ev, void *ctx, void *obj, int len) {
-	(void) ev; (void) ctx;
-
+static void at_new_sample(const GyrosData *g, const ActuatorDesiredData *actuators) {
 	static bool last_sample_unpushed = false;
 
 	static bool running = false;
@@ -195,16 +206,10 @@ static void at_new_actuators(UAVObjEvent * ev, void *ctx, void *obj, int len) {
 		}
 	}
 
-	ActuatorDesiredData actuators;
-	ActuatorDesiredGet(&actuators);
-
-	GyrosData g;
-	GyrosGet(&g);
-
 	struct at_queued_data *q_item = circ_queue_write_pos(at_queue,
 			NULL, NULL);
 
-	if (actuators.SystemIdentCycle == 0xffff) {
+	if (actuators->SystemIdentCycle == 0xffff) {
 		if (running) {
 			// Signify end of actuation stream.
 			q_item->throttle = THROTTLE_EOF;
@@ -222,39 +227,39 @@ static void at_new_actuators(UAVObjEvent * ev, void *ctx, void *obj, int len) {
 	 * !running !first_cycle -> running first_cycle -> running !first_cycle
 	 */
 	if (!running || first_cycle) {
-		if (actuators.SystemIdentCycle == 0x0000) {
+		if (actuators->SystemIdentCycle == 0x0000) {
 			running = true;
 			first_cycle = ! first_cycle;
 		}
 	}
 
 #ifdef AUTOTUNE_AVERAGING_MODE
-	struct at_measurement *avg_point = &at_averages[actuators.SystemIdentCycle];
+	struct at_measurement *avg_point = &at_averages[actuators->SystemIdentCycle];
 
 	if (first_cycle) {
 		*avg_point = (struct at_measurement) { { 0 } };
 	}
 
-	avg_point->y[0] += g.x;
-	avg_point->y[1] += g.y;
-	avg_point->y[2] += g.z;
+	avg_point->y[0] += g->x;
+	avg_point->y[1] += g->y;
+	avg_point->y[2] += g->z;
 
-	avg_point->u[0] += actuators.Roll;
-	avg_point->u[1] += actuators.Pitch;
-	avg_point->u[2] += actuators.Yaw;
+	avg_point->u[0] += actuators->Roll;
+	avg_point->u[1] += actuators->Pitch;
+	avg_point->u[2] += actuators->Yaw;
 #endif
 
-	q_item->sample_num = actuators.SystemIdentCycle;
+	q_item->sample_num = actuators->SystemIdentCycle;
 
-	q_item->meas.y[0] = g.x;
-	q_item->meas.y[1] = g.y;
-	q_item->meas.y[2] = g.z;
+	q_item->meas.y[0] = g->x;
+	q_item->meas.y[1] = g->y;
+	q_item->meas.y[2] = g->z;
 
-	q_item->meas.u[0] = actuators.Roll;
-	q_item->meas.u[1] = actuators.Pitch;
-	q_item->meas.u[2] = actuators.Yaw;
+	q_item->meas.u[0] = actuators->Roll;
+	q_item->meas.u[1] = actuators->Pitch;
+	q_item->meas.u[2] = actuators->Yaw;
 
-	q_item->throttle = actuators.Thrust;
+	q_item->throttle = actuators->Thrust;
 
 	if (circ_queue_advance_write(at_queue) != 0) {
 		last_sample_unpushed = true;
@@ -290,6 +295,38 @@ static void UpdateSystemIdent(const float *X, const float *noise,
 	SystemIdentSet(&system_ident);
 }
 
+#ifndef SMALLF1
+/**
+ * Publish how far the estimates of Beta and Tau have settled
+ * @param[in] X the current state estimate
+ * @param[in] P the current covariance matrix
+ * @param last Beta and Tau at the last update, updated in place
+ * @param[in] elapsed_s flight time the filter has covered since then
+ */
+static void UpdateConvergence(const float X[AF_NUMX], const float P[AF_NUMP],
+		float last[4], float elapsed_s)
+{
+	SystemIdentConvergenceData convergence;
+
+	// The diagonal of P for X[6] to X[9], see af_init()
+	convergence.BetaStdDev[SYSTEMIDENTCONVERGENCE_BETASTDDEV_ROLL]  = sqrtf(P[11]);
+	convergence.BetaStdDev[SYSTEMIDENTCONVERGENCE_BETASTDDEV_PITCH] = sqrtf(P[14]);
+	convergence.BetaStdDev[SYSTEMIDENTCONVERGENCE_BETASTDDEV_YAW]   = sqrtf(P[17]);
+	convergence.TauStdDev = sqrtf(P[27]);
+
+	float rate = (elapsed_s > 0) ? 1.0f / elapsed_s : 0;
+
+	convergence.BetaDrift[SYSTEMIDENTCONVERGENCE_BETADRIFT_ROLL]  = (X[6] - last[0]) * rate;
+	convergence.BetaDrift[SYSTEMIDENTCONVERGENCE_BETADRIFT_PITCH] = (X[7] - last[1]) * rate;
+	convergence.BetaDrift[SYSTEMIDENTCONVERGENCE_BETADRIFT_YAW]   = (X[8] - last[2]) * rate;
+	convergence.TauDrift = (X[9] - last[3]) * rate;
+
+	memcpy(last, &X[6], 4 * sizeof(float));
+
+	SystemIdentConvergenceSet(&convergence);
+}
+#endif /* SMALLF1 */
+
 #ifdef AUTOTUNE_AVERAGING_MODE
 static int autotune_save_averaging() {
 	uintptr_t part_id;
@@ -349,6 +386,10 @@ static void AutotuneTask(void *parameters)
 	float P[AF_NUMP] = {0};
 	float noise[3] = {0};
 
+	// Beta and Tau at the last convergence update, and the time since
+	float converge_last[4] = {0};
+	float converge_s = 0;
+
 	uint16_t last_samp = 0;
 
 	const uint32_t YIELD_MS = 2;
@@ -378,7 +419,7 @@ static void AutotuneTask(void *parameters)
 		dT_expected = 1.0f / sample_rate;
 	}
 
-	ActuatorDesiredConnectCallback(at_new_actuators);
+	StabilizationConnectIdent(at_new_sample);
 
 	bool save_needed = false;
 
@@ -452,6 +493,9 @@ static void AutotuneTask(void *parameters)
 
 				throttle_accumulator = 0;
 
+				memcpy(converge_last, &X[6], sizeof(converge_last));
+				converge_s = 0;
+
 				state = AT_WAITFIRSTPOINT;
 
 				break;
@@ -478,65 +522,99 @@ static void AutotuneTask(void *parameters)
 
 			case AT_RUN:
 				while (true) {
-					struct at_queued_data *pt;
+					uint16_t block_len;
+					struct at_queued_data *pts;
 
-					/* Grab an autotune point */
-					pt = circ_queue_read_pos(at_queue, NULL, NULL);
+					/* Grab the autotune points that are in
+					 * a row in the queue, and work on them
+					 * in place */
+					pts = circ_queue_read_pos(at_queue, &block_len, NULL);
 
-					if (!pt) {
+					if (!pts) {
 						/* We've drained the buffer
 						 * fully.  Yay! */
 						break;
 					}
 
-					if (pt->throttle == THROTTLE_EOF) {
-						// End of actuation, clean up
-						float hover_throttle = ((float)(throttle_accumulator/update_counter))/10000.0f;
-						UpdateSystemIdent(X, noise, update_counter, at_points_spilled, hover_throttle, true);
+					if (block_len > AT_BLOCK_LEN) {
+						block_len = AT_BLOCK_LEN;
+					}
 
-						save_needed = true;
-						state = AT_WAITING;
+					uint16_t n;
+					bool eof = false;
 
-						break;
-					}
+					for (n = 0; n < block_len; n++) {
+						const struct at_queued_data *pt = &pts[n];
 
-					/* calculate time between successive
-					 * points */
+						if (pt->throttle == THROTTLE_EOF) {
+							eof = true;
+							break;
+						}
 
-					uint16_t samp_interval = pt->sample_num - last_samp;
+						/* calculate time between
+						 * successive points */
 
-					if (samp_interval > ident_wiggle_points) {
-						/* Handle wrap case. */
-						samp_interval += ident_wiggle_points;
-					}
+						uint16_t samp_interval = pt->sample_num - last_samp;
 
-					if ((samp_interval == 0) ||
-							(samp_interval > 10)) {
-						samp_interval = 10;
-					}
+						if (samp_interval > ident_wiggle_points) {
+							/* Handle wrap case. */
+							samp_interval += ident_wiggle_points;
+						}
+
+						if ((samp_interval == 0) ||
+								(samp_interval > 10)) {
+							samp_interval = 10;
+						}
 
-					float dT_s = samp_interval * dT_expected;
+						float dT_s = samp_interval * dT_expected;
 
-					last_samp = pt->sample_num;
+						last_samp = pt->sample_num;
 
-					af_predict(X, P, &pt->meas, dT_s, pt->throttle);
+						af_predict(X, P, &pt->meas, dT_s, pt->throttle);
 
-					for (uint32_t i = 0; i < 3; i++) {
-						const float NOISE_ALPHA = 0.9997f;  // 10 second time constant at 300 Hz
-						noise[i] = NOISE_ALPHA * noise[i] + (1-NOISE_ALPHA) * (pt->meas.y[i] - X[i]) * (pt->meas.y[i] - X[i]);
+						for (uint32_t i = 0; i < 3; i++) {
+							const float NOISE_ALPHA = 0.9997f;  // 10 second time constant at 300 Hz
+							noise[i] = NOISE_ALPHA * noise[i] + (1-NOISE_ALPHA) * (pt->meas.y[i] - X[i]) * (pt->meas.y[i] - X[i]);
+						}
+
+						//This will work up to 8kHz with an 89% throttle position before overflow
+						throttle_accumulator += 10000 * pt->throttle;
+
+						converge_s += dT_s;
 					}
 
-					//This will work up to 8kHz with an 89% throttle position before overflow
-					throttle_accumulator += 10000 * pt->throttle;
+					/* Free the buffers containing the AT
+					 * points used */
+					circ_queue_read_completed_multi(at_queue, n);
+
+					uint32_t last_counter = update_counter;
+					update_counter += n;
 
-					/* Free the buffer containing an AT point */
-					circ_queue_read_completed(at_queue);
+					if (eof) {
+						// End of actuation, clean up
+						circ_queue_read_completed(at_queue);
+
+						float hover_throttle = ((float)(throttle_accumulator/update_counter))/10000.0f;
+						UpdateSystemIdent(X, noise, update_counter, at_points_spilled, hover_throttle, true);
+#ifndef SMALLF1
+						UpdateConvergence(X, P, converge_last, converge_s);
+#endif
+
+						save_needed = true;
+						state = AT_WAITING;
+
+						break;
+					}
 
 					// Update uavo every 256 cycles to avoid
 					// telemetry spam
-					if (!((++update_counter) & 0xff)) {
+					if ((update_counter >> 8) != (last_counter >> 8)) {
 						float hover_throttle = ((float)(throttle_accumulator/update_counter))/10000.0f;
 						UpdateSystemIdent(X, noise, update_counter, at_points_spilled, hover_throttle, false);
+#ifndef SMALLF1
+						UpdateConvergence(X, P, converge_last, converge_s);
+						converge_s = 0;
+#endif
 					}
 				}
 
@@ -0,0 +1,192 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup Benchmark Benchmark Module
+ * @{
+ *
+ * @file       benchmark.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Times the benchmark kernels on target, for BenchmarkResults
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * Not for flight firmware: while it runs it takes every cycle the flight
+ * tasks leave over.  It is only built in, never started from ModuleSettings;
+ * uncomment it in a target's MODULES to have it.
+ */
+
+#include "openpilot.h"
+#include "pios_thread.h"
+
+#include "benchmarks.h"
+#include "uavtalk.h"
+
+#include "benchmarkresults.h"
+
+// Private constants
+#define STACK_SIZE_BYTES 600
+#define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
+
+#define ITERATIONS 1000
+#define REPEATS 5		// the best is kept, the others had interrupts
+#define RUN_PERIOD_MS 10000
+
+//! The kernels that need the object manager, after the library's
+enum {
+	KERNEL_UAVOBJ_GETSET = BENCHMARK_NUM_KERNELS,
+	KERNEL_UAVTALK_PACK,
+	NUM_KERNELS
+};
+
+DONT_BUILD_IF(NUM_KERNELS != BENCHMARKRESULTS_CYCLES_NUMELEM, BenchmarkResultsKernels);
+DONT_BUILD_IF(KERNEL_UAVOBJ_GETSET != BENCHMARKRESULTS_CYCLES_UAVOBJGETSET, BenchmarkResultsOrder);
+
+// Private variables
+static bool module_enabled;
+static struct pios_thread *benchmarkTaskHandle;
+static UAVTalkConnection uavtalk;
+static BenchmarkResultsData scratch;
+
+// Private functions
+static void benchmarkTask(void *parameters);
+static void bench_uavobj_getset(uint32_t iterations);
+static void bench_uavtalk_pack(uint32_t iterations);
+static int32_t discard_output(uint8_t *data, int32_t length);
+
+static const struct benchmark kernels[NUM_KERNELS - BENCHMARK_NUM_KERNELS] = {
+	{ "UAVObjGetSet", bench_uavobj_getset },
+	{ "UAVTalkPack", bench_uavtalk_pack },
+};
+
+/**
+ * Initialise the module
+ * \return -1 if initialisation failed
+ * \return 0 on success
+ */
+int32_t BenchmarkInitialize(void)
+{
+#ifdef MODULE_Benchmark_BUILTIN
+	module_enabled = true;
+#else
+	module_enabled = false;
+#endif
+
+	if (!module_enabled)
+		return -1;
+
+	if (BenchmarkResultsInitialize() == -1 || benchmarks_initialize() == -1) {
+		module_enabled = false;
+		return -1;
+	}
+
+	uavtalk = UAVTalkInitialize(discard_output);
+	if (uavtalk == NULL) {
+		module_enabled = false;
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Start the module
+ * \return -1 if initialisation failed
+ * \return 0 on success
+ */
+int32_t BenchmarkStart(void)
+{
+	if (!module_enabled)
+		return -1;
+
+	benchmarkTaskHandle = PIOS_Thread_Create(benchmarkTask, "Benchmark", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+
+	return 0;
+}
+
+MODULE_INITCALL(BenchmarkInitialize, BenchmarkStart);
+
+/**
+ * The best of a few runs of a kernel
+ * \return raw delay ticks per call
+ */
+static float time_kernel(const struct benchmark *b)
+{
+	uint32_t best = UINT32_MAX;
+
+	for (int i = 0; i < REPEATS; i++) {
+		uint32_t begin = PIOS_DELAY_GetRaw();
+		b->run(ITERATIONS);
+		uint32_t ticks = PIOS_DELAY_GetRaw() - begin;
+
+		if (ticks < best)
+			best = ticks;
+	}
+
+	return (float) best / ITERATIONS;
+}
+
+static void benchmarkTask(void *parameters)
+{
+	BenchmarkResultsData results = { };
+
+	while (1) {
+		for (int i = 0; i < BENCHMARK_NUM_KERNELS; i++)
+			results.Cycles[i] = time_kernel(&benchmark_kernels[i]);
+
+		for (int i = BENCHMARK_NUM_KERNELS; i < NUM_KERNELS; i++)
+			results.Cycles[i] = time_kernel(&kernels[i - BENCHMARK_NUM_KERNELS]);
+
+		results.Runs++;
+
+		BenchmarkResultsSet(&results);
+		BenchmarkResultsUpdated();
+
+		PIOS_Thread_Sleep(RUN_PERIOD_MS);
+	}
+}
+
+/* The object is sent by hand, so the sets here wake no telemetry; they
+ * still go through the lock, the copy and the event dispatch. */
+static void bench_uavobj_getset(uint32_t iterations)
+{
+	for (uint32_t i = 0; i < iterations; i++) {
+		BenchmarkResultsGet(&scratch);
+		BenchmarkResultsSet(&scratch);
+	}
+}
+
+static void bench_uavtalk_pack(uint32_t iterations)
+{
+	for (uint32_t i = 0; i < iterations; i++) {
+		UAVTalkSendObjectData(uavtalk, BenchmarkResultsHandle(), 0,
+				i, (const uint8_t *) &scratch);
+	}
+}
+
+//! Stands in for a link, so only the packing and the CRC are timed
+static int32_t discard_output(uint8_t *data, int32_t length)
+{
+	return length;
+}
+
+/**
+ * @}
+ * @}
+ */
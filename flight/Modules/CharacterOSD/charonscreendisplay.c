@@ -89,9 +89,10 @@ static void panel_draw(charosd_state_t state, uint8_t panel, uint8_t x, uint8_t
 	}
 }
 
+/* Draws into the frame buffer; PIOS_MAX7456_flush sends what changed */
 static void screen_draw(charosd_state_t state, CharOnScreenDisplaySettingsData *page)
 {
-	PIOS_MAX7456_clear (state->dev);
+	PIOS_MAX7456_begin_frame (state->dev);
 
 	for (uint8_t i = 0; i < CHARONSCREENDISPLAYSETTINGS_PANELTYPE_NUMELEM;
 		       i++) {
@@ -187,6 +188,7 @@ static void program_characters(charosd_state_t state, uint8_t font)
 	if (changed) {
 		PIOS_MAX7456_puts(state->dev, MAX7456_FMT_H_CENTER,
 				  6, loaded_txt, 0);
+		PIOS_MAX7456_flush(state->dev);
 		PIOS_Thread_Sleep(1000);
 	}
 	state->prev_font = font;
@@ -263,6 +265,7 @@ static void splash_screen(charosd_state_t state)
 	const char *boot_reason = AlarmBootReason(alarm.RebootCause);
 	PIOS_MAX7456_puts(state->dev, MAX7456_FMT_H_CENTER, 4, welcome_msg, 0);
 	PIOS_MAX7456_puts(state->dev, MAX7456_FMT_H_CENTER, 6, boot_reason, 0);
+	PIOS_MAX7456_flush(state->dev);
 
 	PIOS_Thread_Sleep(SPLASH_TIME_MS);
 }
@@ -311,10 +314,14 @@ static void CharOnScreenDisplayTask(void *parameters)
 
 		if (PIOS_MAX7456_stall_detect(state->dev)) {
 			PIOS_MAX7456_puts(state->dev, MAX7456_FMT_H_CENTER, 6, "... STALLED ...", 0);
+			PIOS_MAX7456_flush(state->dev);
 			PIOS_Thread_Sleep(10000);
 		}
 
 		PIOS_MAX7456_wait_vsync(state->dev);
+
+		// Only the characters that changed, in the blanking interval
+		PIOS_MAX7456_flush(state->dev);
 	}
 }
 
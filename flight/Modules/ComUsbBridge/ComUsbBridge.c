@@ -49,6 +49,7 @@
 
 static void com2UsbBridgeTask(void *parameters);
 static void usb2ComBridgeTask(void *parameters);
+static void bridgeSpans(uintptr_t from, uintptr_t to, volatile uint32_t *tx_errors);
 static void updateSettings();
 
 // ****************
@@ -62,8 +63,6 @@ static void updateSettings();
 
 #define TASK_PRIORITY                   PIOS_THREAD_PRIO_LOW
 
-#define BRIDGE_BUF_LEN 10
-
 // ****************
 // Private variables
 
@@ -130,18 +129,7 @@ static void com2UsbBridgeTask(void *parameters)
 	/* Handle usart -> vcp direction */
 	volatile uint32_t tx_errors = 0;
 	while (1) {
-		uint32_t rx_bytes;
-
-		uint8_t com2usb_buf[BRIDGE_BUF_LEN];
-
-		rx_bytes = PIOS_COM_ReceiveBuffer(usart_port, com2usb_buf, BRIDGE_BUF_LEN, 500);
-		if (rx_bytes > 0) {
-			/* Bytes available to transfer */
-			if (PIOS_COM_SendBuffer(vcp_port, com2usb_buf, rx_bytes) != rx_bytes) {
-				/* Error on transmit */
-				tx_errors++;
-			}
-		}
+		bridgeSpans(usart_port, vcp_port, &tx_errors);
 	}
 }
 
@@ -152,19 +140,36 @@ static void usb2ComBridgeTask(void * parameters)
 	/* Handle vcp -> usart direction */
 	volatile uint32_t tx_errors = 0;
 	while (1) {
-		uint32_t rx_bytes;
-
-		uint8_t usb2com_buf[BRIDGE_BUF_LEN];
-
-		rx_bytes = PIOS_COM_ReceiveBuffer(vcp_port, usb2com_buf, BRIDGE_BUF_LEN, 500);
-		if (rx_bytes > 0) {
-			/* Bytes available to transfer */
-			if (PIOS_COM_SendBuffer(usart_port, usb2com_buf, rx_bytes) != rx_bytes) {
-				/* Error on transmit */
-				tx_errors++;
-			}
-		}
+		bridgeSpans(vcp_port, usart_port, &tx_errors);
+	}
+}
+
+/**
+ * Moves what has arrived on one port straight from its receive buffer into
+ * the other port's transmit buffer, as big a span as there is, so fast
+ * links aren't held up by a copy through a small buffer on the stack.
+ *
+ * Sending blocks while the other side's transmit buffer is full, and only
+ * what was sent is consumed, so a slow side leaves bytes waiting in the
+ * receive buffer (and has USB hold off the host) rather than losing them.
+ */
+static void bridgeSpans(uintptr_t from, uintptr_t to, volatile uint32_t *tx_errors)
+{
+	uint16_t rx_bytes;
+
+	const uint8_t *span = PIOS_COM_PeekReceiveBuffer(from, &rx_bytes, 500);
+	if (!span) {
+		return;
 	}
+
+	int32_t sent = PIOS_COM_SendBuffer(to, span, rx_bytes);
+	if (sent <= 0) {
+		/* Error on transmit; drop the span rather than stall */
+		(*tx_errors)++;
+		sent = rx_bytes;
+	}
+
+	PIOS_COM_ConsumeReceiveBuffer(from, sent);
 }
 
 
@@ -250,6 +250,8 @@ static void resetTask(UAVObjEvent * ev, void *ctx, void *obj, int len)
 
 	if((uint32_t) (PIOS_Thread_Systime() - lastResetSysTime) > RESET_DELAY_MS) {
 		lastResetSysTime = PIOS_Thread_Systime();
+		// Settings saved just before the reboot may not be written yet
+		UAVObjFlushSaves();
 			PIOS_SYS_Reset();
 	}
 }
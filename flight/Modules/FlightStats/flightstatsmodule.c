@@ -46,7 +46,24 @@
 #define STACK_SIZE_BYTES 600
 #define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
 
+#define UPDATE_PERIOD_MS 100
+#define TICKS_PER_SECOND (1000 / UPDATE_PERIOD_MS)
+
+// A peak growing by this much is published at once, smaller changes and
+// the totals, which change all the time, at most once a period
+#define PUBLISH_PERIOD_MS 1000
+#define DISTANCE_THRESHOLD 1.0f		// m
+#define SPEED_THRESHOLD 0.1f		// m/s
+
+#define HISTOGRAM_BINS FLIGHTSTATS_GROUNDSPEEDHISTOGRAM_NUMELEM
+
 // Private types
+enum histogram {
+	HISTOGRAM_GROUNDSPEED,
+	HISTOGRAM_ALTITUDE,
+	HISTOGRAM_CURRENT,
+	HISTOGRAM_NUM
+};
 
 // Private variables
 static bool module_enabled;
@@ -56,11 +73,27 @@ static PositionActualData lastPositionActual;
 static float initial_consumed_energy;
 static float previous_consumed_energy;
 
+static FlightStatsData flightStatsData;		// as collected
+static FlightStatsData publishedStats;		// as last set
+static uint32_t last_publish_time;
+
+// Set when the inputs update, so unchanged ones aren't read again
+static volatile bool position_updated;
+static volatile bool velocity_updated;
+static volatile bool airspeed_updated;
+static volatile bool battery_updated;
+
+// Latest inputs of the histograms, and the ticks spent in each bin
+static float histogram_input[HISTOGRAM_NUM];
+static uint32_t histogram_ticks[HISTOGRAM_NUM][HISTOGRAM_BINS];
+
 // Private functions
 static void flightStatsTask(void *parameters);
 static bool isArmed();
 static void resetStats(FlightStatsData *stats);
 static void collectStats(FlightStatsData *stats);
+static void publishStats(const FlightStatsData *stats);
+static void histogramAdd(enum histogram histogram, float bin_width);
 
 // Local variables
 
@@ -123,16 +156,29 @@ MODULE_INITCALL(FlightStatsModuleInitialize, FlightStatModuleStart);
 
 static void flightStatsTask(void *parameters)
 {
-	FlightStatsData flightStatsData;
 	bool first_run = true;
 
+	// Only inputs that updated are read again, the others can't have
+	// changed the stats
+	if (PositionActualHandle())
+		PositionActualConnectCallbackCtx(UAVObjCbSetFlag, &position_updated);
+	if (VelocityActualHandle())
+		VelocityActualConnectCallbackCtx(UAVObjCbSetFlag, &velocity_updated);
+	if (AirspeedActualHandle())
+		AirspeedActualConnectCallbackCtx(UAVObjCbSetFlag, &airspeed_updated);
+	if (FlightBatteryStateHandle())
+		FlightBatteryStateConnectCallbackCtx(UAVObjCbSetFlag, &battery_updated);
+
+	// The object starts out as the stats do
 	resetStats(&flightStatsData);
 	flightStatsData.State = FLIGHTSTATS_STATE_IDLE;
+	publishedStats = flightStatsData;
+	last_publish_time = PIOS_Thread_Systime();
 
 	// Loop forever
 	while (1) {
 		// Update stats at about 10Hz
-		PIOS_Thread_Sleep(100);
+		PIOS_Thread_Sleep(UPDATE_PERIOD_MS);
 		switch (flightStatsData.State) {
 			case FLIGHTSTATS_STATE_IDLE:
 				if (isArmed()) {
@@ -154,7 +200,10 @@ static void flightStatsTask(void *parameters)
 			case FLIGHTSTATS_STATE_COLLECTING:
 				if (first_run) { // get some initial values
 					// initial position
-					PositionActualGet(&lastPositionActual);
+					if (PositionActualHandle()) {
+						position_updated = false;
+						PositionActualGet(&lastPositionActual);
+					}
 
 					// get the initial battery voltage and consumed energy
 					if (FlightBatteryStateHandle()) {
@@ -183,9 +232,10 @@ static void flightStatsTask(void *parameters)
 				if (!isArmed()) {
 					flightStatsData.State = FLIGHTSTATS_STATE_IDLE;
 				}
-				FlightStatsSet(&flightStatsData);
 				break;
 		}
+
+		publishStats(&flightStatsData);
 	}
 }
 
@@ -207,48 +257,68 @@ static void resetStats(FlightStatsData *stats)
 {
 	// reset everything
 	memset((void*)stats, 0, sizeof(FlightStatsData));
+	memset(histogram_ticks, 0, sizeof(histogram_ticks));
 }
 
 /**
- * Collect the statistics
+ * Collect the statistics, from the inputs that updated since the last call
  */
 static void collectStats(FlightStatsData *stats)
 {
 	float tmp;
-	PositionActualData positionActual;
-	PositionActualGet(&positionActual);
 
-	// Total (horizontal) distance
-	stats->DistanceTravelled  += sqrtf(powf(positionActual.North - lastPositionActual.North, 2.f) \
-									   + powf(positionActual.East - lastPositionActual.East, 2.f));
+	if (position_updated) {
+		position_updated = false;
 
-	// Max distance to home
-	tmp =  sqrtf(powf(positionActual.North, 2.f) + powf(positionActual.East, 2.f));
-	stats->MaxDistanceToHome = MAX(stats->MaxDistanceToHome, tmp);
+		PositionActualData positionActual;
+		PositionActualGet(&positionActual);
 
-	// Max altitude
-	stats->MaxAltitude = MAX(stats->MaxAltitude, -1.f * positionActual.Down);
+		// Total (horizontal) distance
+		float north = positionActual.North - lastPositionActual.North;
+		float east = positionActual.East - lastPositionActual.East;
+		stats->DistanceTravelled += sqrtf(north * north + east * east);
 
-	VelocityActualData velocityActual;
-	VelocityActualGet(&velocityActual);
+		// Max distance to home, compared squared so the root is only
+		// taken when it grows
+		tmp = positionActual.North * positionActual.North + positionActual.East * positionActual.East;
+		if (tmp > stats->MaxDistanceToHome * stats->MaxDistanceToHome)
+			stats->MaxDistanceToHome = sqrtf(tmp);
 
-	// Max groundspeed
-	tmp =  sqrtf(powf(velocityActual.North, 2.f) + powf(velocityActual.East, 2.f));
-	stats->MaxGroundSpeed = MAX(stats->MaxGroundSpeed, tmp);
+		// Max altitude
+		histogram_input[HISTOGRAM_ALTITUDE] = -positionActual.Down;
+		stats->MaxAltitude = MAX(stats->MaxAltitude, -1.f * positionActual.Down);
 
-	// Max climb rate
-	stats->MaxClimbRate = MAX(stats->MaxClimbRate, -1.f * velocityActual.Down);
+		// update things for next call
+		lastPositionActual = positionActual;
+	}
+
+	if (velocity_updated) {
+		velocity_updated = false;
+
+		VelocityActualData velocityActual;
+		VelocityActualGet(&velocityActual);
+
+		// Max groundspeed
+		tmp = sqrtf(velocityActual.North * velocityActual.North + velocityActual.East * velocityActual.East);
+		histogram_input[HISTOGRAM_GROUNDSPEED] = tmp;
+		stats->MaxGroundSpeed = MAX(stats->MaxGroundSpeed, tmp);
 
-	// Max descent rate
-	stats->MaxDescentRate = MAX(stats->MaxDescentRate, velocityActual.Down);
+		// Max climb rate
+		stats->MaxClimbRate = MAX(stats->MaxClimbRate, -1.f * velocityActual.Down);
+
+		// Max descent rate
+		stats->MaxDescentRate = MAX(stats->MaxDescentRate, velocityActual.Down);
+	}
 
 	// Max airspeed
-	if (AirspeedActualHandle()) {
+	if (airspeed_updated) {
+		airspeed_updated = false;
+
 		AirspeedActualTrueAirspeedGet(&tmp);
 		stats->MaxAirSpeed = MAX(stats->MaxAirSpeed, tmp);
 	}
 
-	// Max roll/pitch/yaw rates
+	// Max roll/pitch/yaw rates, the gyros update faster than this runs
 	GyrosData gyros;
 	GyrosGet(&gyros);
 	stats->MaxPitchRate = MAX(stats->MaxPitchRate, fabsf(gyros.y));
@@ -256,11 +326,75 @@ static void collectStats(FlightStatsData *stats)
 	stats->MaxYawRate = MAX(stats->MaxYawRate, fabsf(gyros.z));
 
 	// Consumed energy
-	if (FlightBatteryStateHandle()) {
-		FlightBatteryStateConsumedEnergyGet(&tmp);
-		stats->ConsumedEnergy = previous_consumed_energy + tmp - initial_consumed_energy;
+	if (battery_updated) {
+		battery_updated = false;
+
+		FlightBatteryStateData battery;
+		FlightBatteryStateGet(&battery);
+		histogram_input[HISTOGRAM_CURRENT] = battery.Current;
+		stats->ConsumedEnergy = previous_consumed_energy + battery.ConsumedEnergy - initial_consumed_energy;
+	}
+
+	// Time spent at each speed, altitude and current
+	histogramAdd(HISTOGRAM_GROUNDSPEED, settings.HistogramBinWidth[FLIGHTSTATSSETTINGS_HISTOGRAMBINWIDTH_GROUNDSPEED]);
+	histogramAdd(HISTOGRAM_ALTITUDE, settings.HistogramBinWidth[FLIGHTSTATSSETTINGS_HISTOGRAMBINWIDTH_ALTITUDE]);
+	histogramAdd(HISTOGRAM_CURRENT, settings.HistogramBinWidth[FLIGHTSTATSSETTINGS_HISTOGRAMBINWIDTH_CURRENT]);
+
+	for (int i = 0; i < HISTOGRAM_BINS; i++) {
+		stats->GroundSpeedHistogram[i] = MIN(histogram_ticks[HISTOGRAM_GROUNDSPEED][i] / TICKS_PER_SECOND, UINT16_MAX);
+		stats->AltitudeHistogram[i] = MIN(histogram_ticks[HISTOGRAM_ALTITUDE][i] / TICKS_PER_SECOND, UINT16_MAX);
+		stats->CurrentHistogram[i] = MIN(histogram_ticks[HISTOGRAM_CURRENT][i] / TICKS_PER_SECOND, UINT16_MAX);
+	}
+}
+
+/**
+ * Count a tick in the bin of the latest input of a histogram
+ * \param[in] histogram The histogram
+ * \param[in] bin_width The width of each bin, the last holds everything above
+ */
+static void histogramAdd(enum histogram histogram, float bin_width)
+{
+	float value = histogram_input[histogram];
+	int bin;
+
+	if (!(value > 0) || !(bin_width > 0))
+		bin = 0;
+	else if (value >= bin_width * (HISTOGRAM_BINS - 1))
+		bin = HISTOGRAM_BINS - 1;
+	else
+		bin = value / bin_width;
+
+	histogram_ticks[histogram][bin]++;
+}
+
+/**
+ * Set the stats if they changed enough to be worth it. A new peak or
+ * state goes out at once, anything else with the next periodic update.
+ */
+static void publishStats(const FlightStatsData *stats)
+{
+	const FlightStatsData *last = &publishedStats;
+
+	bool publish = stats->State != last->State ||
+		stats->InitialBatteryVoltage != last->InitialBatteryVoltage ||
+		stats->MaxAltitude != last->MaxAltitude ||
+		stats->MaxRollRate != last->MaxRollRate ||
+		stats->MaxPitchRate != last->MaxPitchRate ||
+		stats->MaxYawRate != last->MaxYawRate ||
+		stats->MaxDistanceToHome - last->MaxDistanceToHome >= DISTANCE_THRESHOLD ||
+		stats->MaxGroundSpeed - last->MaxGroundSpeed >= SPEED_THRESHOLD ||
+		stats->MaxAirSpeed - last->MaxAirSpeed >= SPEED_THRESHOLD ||
+		stats->MaxClimbRate - last->MaxClimbRate >= SPEED_THRESHOLD ||
+		stats->MaxDescentRate - last->MaxDescentRate >= SPEED_THRESHOLD;
+
+	if (!publish) {
+		if (!PIOS_Thread_Period_Elapsed(last_publish_time, PUBLISH_PERIOD_MS))
+			return;
+		if (memcmp(stats, last, sizeof(*stats)) == 0)
+			return;
 	}
 
-	// update things for next call
-	lastPositionActual = positionActual;
+	FlightStatsSet(stats);
+	publishedStats = *stats;
+	last_publish_time = PIOS_Thread_Systime();
 }
@@ -38,12 +38,22 @@
 
 static uint32_t parse_errors;
 
-static bool checksum_ubx_message(const struct UBXPacket *);
 static uint32_t parse_ubx_message(const struct UBXPacket *, GPSPositionData *);
 
-// parse incoming character stream for messages in UBX binary format
-
-int parse_ubx_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+/**
+ * Parse a span of the incoming stream for messages in UBX binary format.
+ *
+ * The payload is copied straight from the span and the checksum is summed
+ * as it goes, rather than byte by byte through the state machine and then
+ * again over the assembled message.
+ *
+ * \param[in] rx the received bytes
+ * \param[in] len how many there are
+ * \return PARSER_COMPLETE if a message was completed in the span, otherwise
+ * the state after the last byte: PARSER_ERROR if it couldn't be used,
+ * PARSER_INCOMPLETE if a message is under way
+ */
+int parse_ubx_stream (const uint8_t *rx, uint16_t len, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
 {
 	enum proto_states {
 		START,
@@ -60,77 +70,109 @@ int parse_ubx_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData,
 
 	static enum proto_states proto_state = START;
 	static uint16_t rx_count = 0;
+	static uint8_t ck_a, ck_b;
 	struct UBXPacket *ubx = (struct UBXPacket *)gps_rx_buffer;
-
-	switch (proto_state) {
-		case START: // detect protocol
-			if (c ==  UBX_SYNC1) // first UBX sync char found
-				proto_state = UBX_SY2;
-			break;
-		case UBX_SY2:
-			if (c == UBX_SYNC2) // second UBX sync char found
-				proto_state = UBX_CLASS;
-			else
-				proto_state = START; // reset state
-			break;
-		case UBX_CLASS:
-			ubx->header.class = c;
-			proto_state = UBX_ID;
-			break;
-		case UBX_ID:
-			ubx->header.id = c;
-			proto_state = UBX_LEN1;
-			break;
-		case UBX_LEN1:
-			ubx->header.len = c;
-			proto_state = UBX_LEN2;
-			break;
-		case UBX_LEN2:
-			ubx->header.len += (c << 8);
-			if (ubx->header.len > sizeof(UBXPayload)) {
-				gpsRxStats->gpsRxOverflow++;
-				proto_state = START;
-			} else {
-				rx_count = 0;
-				proto_state = UBX_PAYLOAD;
-			}
-			break;
-		case UBX_PAYLOAD:
-			if (rx_count < ubx->header.len) {
-				ubx->payload.payload[rx_count] = c;
-				if (++rx_count == ubx->header.len)
+	bool complete = false;
+	int res = PARSER_INCOMPLETE;
+
+	for (uint16_t i = 0; i < len; i++) {
+		uint8_t c = rx[i];
+
+		switch (proto_state) {
+			case START: // detect protocol
+				if (c == UBX_SYNC1) { // first UBX sync char found
+					proto_state = UBX_SY2;
+				} else {
+					// skip straight to the next candidate
+					const uint8_t *sync = memchr(&rx[i + 1], UBX_SYNC1, len - i - 1);
+					i = sync ? (sync - rx) - 1 : len - 1;
+				}
+				break;
+			case UBX_SY2:
+				if (c == UBX_SYNC2) // second UBX sync char found
+					proto_state = UBX_CLASS;
+				else
+					proto_state = START; // reset state
+				break;
+			case UBX_CLASS:
+				ubx->header.class = c;
+				ck_a = ck_b = c;
+				proto_state = UBX_ID;
+				break;
+			case UBX_ID:
+				ubx->header.id = c;
+				ck_a += c;
+				ck_b += ck_a;
+				proto_state = UBX_LEN1;
+				break;
+			case UBX_LEN1:
+				ubx->header.len = c;
+				ck_a += c;
+				ck_b += ck_a;
+				proto_state = UBX_LEN2;
+				break;
+			case UBX_LEN2:
+				ubx->header.len += (c << 8);
+				ck_a += c;
+				ck_b += ck_a;
+				if (ubx->header.len > sizeof(UBXPayload)) {
+					gpsRxStats->gpsRxOverflow++;
+					proto_state = START;
+				} else {
+					rx_count = 0;
+					proto_state = ubx->header.len ? UBX_PAYLOAD : UBX_CHK1;
+				}
+				break;
+			case UBX_PAYLOAD:
+			{
+				// as much of the payload as this span holds
+				uint16_t n = ubx->header.len - rx_count;
+				if (n > len - i)
+					n = len - i;
+
+				for (uint16_t j = 0; j < n; j++) {
+					uint8_t b = rx[i + j];
+					ubx->payload.payload[rx_count++] = b;
+					ck_a += b;
+					ck_b += ck_a;
+				}
+				i += n - 1;
+
+				if (rx_count == ubx->header.len)
 					proto_state = UBX_CHK1;
-			} else {
-				gpsRxStats->gpsRxOverflow++;
-				proto_state = START;
+				break;
 			}
-			break;
-		case UBX_CHK1:
-			ubx->header.ck_a = c;
-			proto_state = UBX_CHK2;
-			break;
-		case UBX_CHK2:
-			ubx->header.ck_b = c;
-			if (checksum_ubx_message(ubx)) { // message complete and valid
-				parse_ubx_message(ubx, GpsData);
-				proto_state = FINISHED;
-			} else {
-				gpsRxStats->gpsRxChkSumError++;
-				proto_state = START;
-			}
-			break;
-		default: break;
-	}
+			case UBX_CHK1:
+				ubx->header.ck_a = c;
+				proto_state = UBX_CHK2;
+				break;
+			case UBX_CHK2:
+				ubx->header.ck_b = c;
+				if (ubx->header.ck_a == ck_a && ubx->header.ck_b == ck_b) { // message complete and valid
+					parse_ubx_message(ubx, GpsData);
+					proto_state = FINISHED;
+				} else {
+					parse_errors++;
+					UBloxInfoParseErrorsSet(&parse_errors);
+					gpsRxStats->gpsRxChkSumError++;
+					proto_state = START;
+				}
+				break;
+			default: break;
+		}
 
-	if (proto_state == START)
-		return PARSER_ERROR;	// parser couldn't use this byte
-	else if (proto_state == FINISHED) {
-		gpsRxStats->gpsRxReceived++;
-		proto_state = START;
-		return PARSER_COMPLETE;	// message complete & processed
+		if (proto_state == START) {
+			res = PARSER_ERROR;	// parser couldn't use this byte
+		} else if (proto_state == FINISHED) {
+			gpsRxStats->gpsRxReceived++;
+			proto_state = START;
+			complete = true;	// message complete & processed
+		} else {
+			res = PARSER_INCOMPLETE; // message not (yet) complete
+		}
 	}
 
-	return PARSER_INCOMPLETE; // message not (yet) complete
+	return complete ? PARSER_COMPLETE : res;
 }
 
 
@@ -165,40 +207,6 @@ bool check_msgtracker (uint32_t tow, uint8_t msg_flag)
 	return true;
 }
 
-static bool checksum_ubx_message (const struct UBXPacket *ubx)
-{
-	int i;
-	uint8_t ck_a, ck_b;
-
-	ck_a = ubx->header.class;
-	ck_b = ck_a;
-
-	ck_a += ubx->header.id;
-	ck_b += ck_a;
-
-	ck_a += ubx->header.len & 0xff;
-	ck_b += ck_a;
-
-	ck_a += ubx->header.len >> 8;
-	ck_b += ck_a;
-
-	for (i = 0; i < ubx->header.len; i++) {
-		ck_a += ubx->payload.payload[i];
-		ck_b += ck_a;
-	}
-
-	if (ubx->header.ck_a == ck_a &&
-			ubx->header.ck_b == ck_b)
-		return true;
-	else {
-		parse_errors++;
-		UBloxInfoParseErrorsSet(&parse_errors);
-
-		return false;
-	}
-
-}
-
 static void parse_ubx_nav_posllh (const struct UBX_NAV_POSLLH *posllh, GPSPositionData *GpsPosition)
 {
 	if (check_msgtracker(posllh->iTOW, POSLLH_RECEIVED)) {
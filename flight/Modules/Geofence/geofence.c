@@ -43,17 +43,39 @@
 // Configuration
 //
 #define SAMPLE_PERIOD_MS     250
+#define MAX_VERTICES         GEOFENCESETTINGS_VERTEXNORTH_NUMELEM
 
 // Private types
 
-// Private variables
+//! An edge of the polygon, from one vertex towards the next
+struct fence_edge {
+	float north;
+	float east;
+	float d_north;
+	float d_east;
+	float inv_len2;	//!< 1 / squared length, 0 for a degenerate edge
+};
+
+//! The fence as checked, worked out from the settings when they change
+struct fence {
+	GeoFenceSettingsData settings;
+	bool polygon;
+	uint8_t num_edges;
+	float warning_radius2;
+	float error_radius2;
+	float warning_margin2;
+	float ceiling;
+	float ceiling_warning;
+	struct fence_edge edges[MAX_VERTICES];
+};
 
 // Private functions
 static void settingsUpdated(UAVObjEvent* ev, void *ctx, void *obj, int len);
 static void checkPosition(UAVObjEvent* ev, void *ctx, void *obj, int len);
+static SystemAlarmsAlarmOptions checkPolygon(float north, float east);
 
 // Private variables
-static GeoFenceSettingsData *geofenceSettings;
+static struct fence *fence;
 
 /**
  * Initialise the module, called on startup
@@ -82,8 +104,8 @@ int32_t GeofenceInitialize(void)
 
 	if (module_enabled) {
 		// allocate and initialize the static data storage only if module is enabled
-		geofenceSettings = (GeoFenceSettingsData *) PIOS_malloc(sizeof(GeoFenceSettingsData));
-		if (geofenceSettings == NULL) {
+		fence = (struct fence *) PIOS_malloc(sizeof(*fence));
+		if (fence == NULL) {
 			module_enabled = false;
 			return -1;
 		}
@@ -100,7 +122,7 @@ int32_t GeofenceInitialize(void)
 /* stub: module has no module thread */
 int32_t GeofenceStart(void)
 {
-	if (geofenceSettings == NULL) {
+	if (fence == NULL) {
 		return -1;
 	}
 
@@ -128,17 +150,78 @@ static void checkPosition(UAVObjEvent* ev, void *ctx, void *obj, int len)
 		PositionActualData positionActual;
 		PositionActualGet(&positionActual);
 
-		const float distance2 = powf(positionActual.North, 2) + powf(positionActual.East, 2);
+		SystemAlarmsAlarmOptions alarm = SYSTEMALARMS_ALARM_OK;
 
-		// ErrorRadius is squared when it is fetched, so this is correct
-		if (distance2 > geofenceSettings->ErrorRadius) {
-			AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, SYSTEMALARMS_ALARM_ERROR);
-		} else if (distance2 > geofenceSettings->WarningRadius) {
-			AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, SYSTEMALARMS_ALARM_WARNING);
+		if (fence->polygon) {
+			alarm = checkPolygon(positionActual.North, positionActual.East);
 		} else {
+			const float distance2 = powf(positionActual.North, 2) + powf(positionActual.East, 2);
+
+			if (distance2 > fence->error_radius2) {
+				alarm = SYSTEMALARMS_ALARM_ERROR;
+			} else if (distance2 > fence->warning_radius2) {
+				alarm = SYSTEMALARMS_ALARM_WARNING;
+			}
+		}
+
+		if (fence->ceiling > 0) {
+			const float altitude = -positionActual.Down;
+
+			if (altitude > fence->ceiling) {
+				alarm = SYSTEMALARMS_ALARM_ERROR;
+			} else if (altitude > fence->ceiling_warning && alarm == SYSTEMALARMS_ALARM_OK) {
+				alarm = SYSTEMALARMS_ALARM_WARNING;
+			}
+		}
+
+		if (alarm == SYSTEMALARMS_ALARM_OK) {
 			AlarmsClear(SYSTEMALARMS_ALARM_GEOFENCE);
+		} else {
+			AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, alarm);
+		}
+	}
+}
+
+/**
+ * Check a position against the polygon: an error outside it, a warning
+ * inside it but within the warning margin of an edge.
+ * \param[in] north position north of home
+ * \param[in] east position east of home
+ * \return the alarm level
+ */
+static SystemAlarmsAlarmOptions checkPolygon(float north, float east)
+{
+	bool inside = false;
+	float closest2 = INFINITY;
+
+	for (uint8_t i = 0; i < fence->num_edges; i++) {
+		const struct fence_edge *e = &fence->edges[i];
+		const float rel_north = north - e->north;
+		const float rel_east = east - e->east;
+
+		// Crossing test along a ray towards the east
+		if ((rel_north < 0) != (rel_north - e->d_north < 0)) {
+			const float cross_east = e->d_east * rel_north / e->d_north;
+			if (rel_east < cross_east)
+				inside = !inside;
 		}
+
+		// Squared distance to the nearest point of the edge
+		float t = (rel_north * e->d_north + rel_east * e->d_east) * e->inv_len2;
+		t = bound_min_max(t, 0, 1);
+
+		const float dist2 = powf(rel_north - t * e->d_north, 2) +
+			powf(rel_east - t * e->d_east, 2);
+		if (dist2 < closest2)
+			closest2 = dist2;
 	}
+
+	if (!inside)
+		return SYSTEMALARMS_ALARM_ERROR;
+	if (closest2 < fence->warning_margin2)
+		return SYSTEMALARMS_ALARM_WARNING;
+
+	return SYSTEMALARMS_ALARM_OK;
 }
 
 /**
@@ -147,11 +230,36 @@ static void checkPosition(UAVObjEvent* ev, void *ctx, void *obj, int len)
 static void settingsUpdated(UAVObjEvent* ev, void *ctx, void *obj, int len)
 {
 	(void) ev; (void) ctx; (void) obj; (void) len;
-	GeoFenceSettingsGet(geofenceSettings);
+	// Both this and checkPosition are run by the event dispatcher, so
+	// the fence can be rebuilt in place
+	GeoFenceSettingsData *settings = &fence->settings;
+	GeoFenceSettingsGet(settings);
 
 	// Cache squared distances to save computations
-	geofenceSettings->WarningRadius = powf(geofenceSettings->WarningRadius, 2);
-	geofenceSettings->ErrorRadius = powf(geofenceSettings->ErrorRadius, 2);
+	fence->warning_radius2 = powf(settings->WarningRadius, 2);
+	fence->error_radius2 = powf(settings->ErrorRadius, 2);
+	fence->warning_margin2 = powf(settings->WarningMargin, 2);
+	fence->ceiling = settings->Ceiling;
+	fence->ceiling_warning = (float) settings->Ceiling - settings->WarningMargin;
+
+	uint8_t num_vertices = MIN(settings->VertexCount, MAX_VERTICES);
+
+	// Too few vertices for a polygon; fall back to the cylinder
+	fence->polygon = settings->Shape == GEOFENCESETTINGS_SHAPE_POLYGON && num_vertices >= 3;
+	fence->num_edges = fence->polygon ? num_vertices : 0;
+
+	for (uint8_t i = 0; i < fence->num_edges; i++) {
+		uint8_t next = (i + 1) % num_vertices;
+		struct fence_edge *e = &fence->edges[i];
+
+		e->north = settings->VertexNorth[i];
+		e->east = settings->VertexEast[i];
+		e->d_north = settings->VertexNorth[next] - e->north;
+		e->d_east = settings->VertexEast[next] - e->east;
+
+		const float len2 = powf(e->d_north, 2) + powf(e->d_east, 2);
+		e->inv_len2 = len2 > 0 ? 1.0f / len2 : 0;
+	}
 }
 
 /**
@@ -0,0 +1,70 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup Logging Logging Module
+ * @{
+ *
+ * @file       logcompress.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Block compression of the log stream
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef LOGCOMPRESS_H
+#define LOGCOMPRESS_H
+
+#include <stdint.h>
+
+/*
+ * A compressed log is cut into chunks of up to LOGCOMPRESS_BLOCK_LEN bytes
+ * of the plain stream, each compressed on its own:
+ *
+ *   [LOGCOMPRESS_MARKER][plain length, u16][payload length, u16]
+ *   [payload][CRC8 of all before]
+ *
+ * A payload as long as the plain data is stored as is.  Otherwise it is a
+ * sequence of tokens; a byte c below 0x80 is followed by c + 1 literals,
+ * and a pair 1LLLLLOO OOOOOOOO copies L + 3 bytes from O + 1 bytes back.
+ * When L is 31 a byte of extra length follows.  Matches only reach back
+ * within the chunk, so each chunk decodes without the ones before it.
+ */
+#define LOGCOMPRESS_MARKER 0xC7
+#define LOGCOMPRESS_BLOCK_LEN 1024
+#define LOGCOMPRESS_HEADER_LEN 5
+#define LOGCOMPRESS_CHUNK_MAX (LOGCOMPRESS_HEADER_LEN + LOGCOMPRESS_BLOCK_LEN + 1)
+
+#define LOGCOMPRESS_HASH_BITS 8
+
+/**
+ * Working memory of the compressor
+ */
+struct logcompress_state {
+	uint16_t hash[1 << LOGCOMPRESS_HASH_BITS];
+};
+
+uint16_t logcompress_chunk(struct logcompress_state *state,
+		const uint8_t *in, uint16_t in_len, uint8_t *out);
+
+#endif /* LOGCOMPRESS_H */
+
+/**
+  * @}
+  * @}
+  */
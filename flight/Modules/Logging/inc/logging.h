@@ -0,0 +1,58 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup Logging Logging Module
+ * @{
+ *
+ * @file       logging.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      High rate samples of the control loop for the onboard log
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include "openpilot.h"
+
+/**
+ * One iteration of the rate loop.  Only floats, in this order, as they are
+ * encoded field by field.
+ */
+struct logging_blackbox_sample {
+	float gyro[3];		// deg/s, as filtered for the rate loop
+	float setpoint[3];	// deg/s, rate desired
+	float pid_p[3];		// rate loop terms, actuator units
+	float pid_i[3];
+	float pid_d[3];
+	float actuator[4];	// ActuatorDesired roll, pitch, yaw and thrust
+};
+
+int32_t LoggingInitialize(void);
+
+bool LoggingBlackboxDue(void);
+void LoggingBlackboxSample(const struct logging_blackbox_sample *sample);
+
+#endif /* LOGGING_H */
+
+/**
+  * @}
+  * @}
+  */
@@ -0,0 +1,162 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup Logging Logging Module
+ * @{
+ *
+ * @file       logcompress.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Block compression of the log stream, LZ77 with a 1k window
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "openpilot.h"
+#include "logcompress.h"
+
+#define MATCH_MIN 3
+#define MATCH_SHORT_MAX (MATCH_MIN + 30)	// longest without the extra byte
+#define MATCH_MAX (MATCH_MIN + 31 + 255)
+#define LITERALS_MAX 128
+
+DONT_BUILD_IF(LOGCOMPRESS_BLOCK_LEN > 1024, LogcompressOffsetBits);
+
+static inline uint32_t hash3(const uint8_t *p)
+{
+	uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+
+	return (v * 2654435761u) >> (32 - LOGCOMPRESS_HASH_BITS);
+}
+
+/**
+ * Append literals, in runs of up to LITERALS_MAX
+ * \return the end of the output, or NULL if it would pass limit
+ */
+static uint8_t *put_literals(uint8_t *op, const uint8_t *limit,
+		const uint8_t *lit, uint16_t len)
+{
+	while (len) {
+		uint16_t run = MIN(len, LITERALS_MAX);
+
+		if (op + 1 + run > limit) {
+			return NULL;
+		}
+
+		*op++ = run - 1;
+		memcpy(op, lit, run);
+		op += run;
+		lit += run;
+		len -= run;
+	}
+
+	return op;
+}
+
+/**
+ * Compress a block of the log into a chunk
+ * \param[in] state working memory
+ * \param[in] in plain data, at most LOGCOMPRESS_BLOCK_LEN bytes
+ * \param[in] in_len length of the plain data
+ * \param[out] out room for LOGCOMPRESS_CHUNK_MAX bytes
+ * \return length of the chunk
+ */
+uint16_t logcompress_chunk(struct logcompress_state *state,
+		const uint8_t *in, uint16_t in_len, uint8_t *out)
+{
+	PIOS_Assert(in_len <= LOGCOMPRESS_BLOCK_LEN);
+
+	uint8_t *payload = out + LOGCOMPRESS_HEADER_LEN;
+
+	// Anything as long as the plain data is worth nothing
+	const uint8_t *limit = payload + in_len;
+	uint8_t *op = payload;
+
+	// Positions are kept plus one, so 0 is an empty slot
+	memset(state->hash, 0, sizeof(state->hash));
+
+	uint16_t ip = 0;
+	uint16_t lit = 0;
+
+	while (op && ip + MATCH_MIN <= in_len) {
+		uint32_t h = hash3(in + ip);
+		uint16_t cand = state->hash[h];
+		state->hash[h] = ip + 1;
+
+		if (!cand || memcmp(in + cand - 1, in + ip, MATCH_MIN)) {
+			ip++;
+			continue;
+		}
+
+		cand--;
+		uint16_t len = MATCH_MIN;
+		uint16_t max = MIN(in_len - ip, MATCH_MAX);
+		while (len < max && in[cand + len] == in[ip + len]) {
+			len++;
+		}
+
+		op = put_literals(op, limit, in + lit, ip - lit);
+		if (!op || op + 3 > limit) {
+			op = NULL;
+			break;
+		}
+
+		uint16_t offset = ip - cand - 1;
+		uint8_t code = MIN(len, MATCH_SHORT_MAX + 1) - MATCH_MIN;
+		*op++ = 0x80 | (code << 2) | (offset >> 8);
+		*op++ = offset & 0xff;
+		if (len > MATCH_SHORT_MAX) {
+			*op++ = len - MATCH_SHORT_MAX - 1;
+		}
+
+		// What the match covers may be the start of a later one
+		uint16_t end = ip + len;
+		while (++ip < end && ip + MATCH_MIN <= in_len) {
+			state->hash[hash3(in + ip)] = ip + 1;
+		}
+		ip = lit = end;
+	}
+
+	if (op) {
+		op = put_literals(op, limit, in + lit, in_len - lit);
+	}
+
+	uint16_t payload_len;
+	if (op && op < limit) {
+		payload_len = op - payload;
+	} else {
+		memcpy(payload, in, in_len);
+		payload_len = in_len;
+	}
+
+	out[0] = LOGCOMPRESS_MARKER;
+	out[1] = in_len & 0xff;
+	out[2] = in_len >> 8;
+	out[3] = payload_len & 0xff;
+	out[4] = payload_len >> 8;
+
+	uint16_t chunk_len = LOGCOMPRESS_HEADER_LEN + payload_len;
+	out[chunk_len] = PIOS_CRC_updateCRC(0, out, chunk_len);
+
+	return chunk_len + 1;
+}
+
+/**
+  * @}
+  * @}
+  */
@@ -32,6 +32,8 @@
  */
 
 #include "openpilot.h"
+#include "logging.h"
+#include "logcompress.h"
 #include "modulesettings.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
@@ -57,6 +59,7 @@
 #include "gpssatellites.h"
 #include "gyros.h"
 #include "loggingsettings.h"
+#include "loggingsector.h"
 #include "loggingstats.h"
 #include "magnetometer.h"
 #include "manualcontrolcommand.h"
@@ -81,8 +84,80 @@ const char DIGITS[16] = "0123456789abcdef";
 
 #define LOGGING_PERIOD_MS 100
 
+// Updates wait in the ring for at most about LOGGING_DRAIN_PERIOD_MS
+#ifndef LOGGING_RING_SIZE
+#define LOGGING_RING_SIZE 4096	// bytes, a power of two
+#endif
+#define LOGGING_DRAIN_PERIOD_MS 5
+
+/*
+ * High rate samples of the rate loop go out in frames of one streamfs
+ * write each.  A frame is a UAVTalk OBJ_TS packet of BLACKBOX_OBJID, which
+ * no object has, so other readers skip it:
+ *
+ *   [10 byte header][version][records][time of the first record, us, u32]
+ *   [records][zero padding][CRC8]
+ *
+ * A record is the time since the one before in us, then the fields of
+ * struct logging_blackbox_sample scaled by blackbox_scale, each as a
+ * zigzag varint.  The first record of a frame holds the fields, the
+ * others what changed since the record before, so every frame decodes
+ * on its own.
+ */
+#define BLACKBOX_FRAME_LEN 256		// the streamfs write_size
+#define BLACKBOX_OBJID 0xB1ACB0C5
+#define BLACKBOX_VERSION 1
+#define BLACKBOX_HEADER_LEN 16
+#define BLACKBOX_FIELDS 19
+#define BLACKBOX_RECORD_MAX (5 * (BLACKBOX_FIELDS + 1))
+#define BLACKBOX_DRAIN_PERIOD_MS 2
+
+// Streamed downloads keep up to STREAM_WINDOW sectors unacknowledged
+#define STREAM_WINDOW 16
+#define STREAM_PERIOD_MS 2
+#define STREAM_RESEND_MS 100
+
+// A compressed log waits in a partial block for at most this long
+#define COMPRESS_FLUSH_MS 1000
+#define COMPRESS_PUSH_LEN 128	// bytes of a chunk queued at once when not blocking
+
 // Private types
 
+/**
+ * Update waiting in the log ring, followed by the object data.  A record
+ * with pad set only fills up the end of the ring, it is at least the
+ * first four bytes long.
+ */
+struct log_record {
+	uint16_t length;	// of the whole record, padding included
+	volatile uint8_t ready;	// set once the writer is done with it
+	uint8_t pad;
+	uint32_t timestamp;
+	UAVObjHandle obj;
+	uint16_t instId;
+};
+
+/**
+ * Frame of high rate samples, filled by the stabilization task.
+ */
+struct blackbox_frame {
+	uint8_t data[BLACKBOX_FRAME_LEN];
+	uint16_t length;	// filled so far, header included
+	uint8_t records;
+	volatile bool full;	// sealed, waiting for the logging task
+};
+
+/**
+ * Buffers of the log compression, only allocated when it is first used.
+ */
+struct compress_bufs {
+	struct logcompress_state state;
+	uint8_t block[LOGCOMPRESS_BLOCK_LEN];
+	uint8_t chunk[LOGCOMPRESS_CHUNK_MAX];
+};
+
+DONT_BUILD_IF(sizeof(struct logging_blackbox_sample) != BLACKBOX_FIELDS * sizeof(float), BlackboxSampleFields);
+
 // Private variables
 static UAVTalkConnection uavTalkCon;
 static struct pios_thread *loggingTaskHandle;
@@ -94,26 +169,124 @@ static LoggingStatsData loggingData;
 static void    loggingTask(void *parameters);
 static int32_t send_data(uint8_t *data, int32_t length);
 static int32_t send_data_nonblock(uint8_t *data, int32_t length);
+static int32_t log_write(uint8_t *data, int32_t length, bool block);
+static void compress_start(void);
+static void compress_stop(void);
+static void compress_age(void);
+static void log_snapshot(UAVObjEvent *ev, void *uavo_data, int uavo_len);
+static void drain_log_ring(bool write);
+static void blackbox_start(void);
+static void blackbox_stop(void);
+static void drain_blackbox(bool write);
 static uint16_t get_minimum_logging_period();
 static void unregister_object(UAVObjHandle obj);
 static void register_object(UAVObjHandle obj);
 static void register_default_profile();
+static void register_profile();
+static void burst_reset(void);
+static void burst_check(void);
 static void logAll(UAVObjHandle obj);
 static void logSettings(UAVObjHandle obj);
 static void writeHeader();
 static void updateSettings();
 
+/*
+ * For a while after a trigger, the objects of the profile are logged at
+ * the fastest rate the settings allow.
+ */
+static struct {
+	bool active;
+	uint16_t period;	// of the default profile while bursting, ms
+	uint32_t started;	// time of the last trigger
+	uint8_t flight_mode;
+	uint8_t alarms[SYSTEMALARMS_ALARM_NUMELEM];
+} burst;
+
 // Local variables
 static uintptr_t logging_com_id;
 static uint32_t written_bytes;
+static uint32_t stored_bytes;
 static bool destination_onboard_flash;
 
+/*
+ * With compression on, what follows the header of a log goes out as the
+ * chunks of logcompress.h.  Writes gather in the block until it is full,
+ * then its chunk trickles into the COM buffer as room frees up.  A write
+ * only fails when the block is full and the chunk before is still going
+ * out, which is when an uncompressed one would have found the COM buffer
+ * full.
+ */
+static struct {
+	struct compress_bufs *bufs;
+	bool active;
+	uint16_t block_len;
+	uint16_t chunk_len;
+	uint16_t chunk_sent;
+	uint32_t block_time;	// of the first write in the block
+} compress;
+
+/*
+ * Updates are copied in by whichever task set the object, and written out
+ * by the logging task.  Writers claim room by moving head with a compare
+ * and swap, so they never wait for each other nor for the log; the logging
+ * task alone moves tail.
+ */
+static struct {
+	uint8_t *buf;
+	volatile uint32_t head;		// free running, end of the claimed room
+	volatile uint32_t tail;		// free running, first record not written
+	volatile uint32_t dropped;
+	uint32_t peak;
+} log_ring;
+
+/*
+ * Two frames, so one fills while the other is written out.  Only the
+ * stabilization task samples; it runs above the logging task, so when
+ * the latter starts or stops sampling no sample is half done.
+ */
+static struct {
+	struct blackbox_frame *frame;
+	uint8_t filling;	// frame samples go in
+	uint8_t writing;	// next frame to write out
+	volatile bool active;
+	uint32_t period_us;
+	uint32_t due_us;	// time of the sample being taken
+	uint32_t last_us;	// time of the last record
+	int32_t last[BLACKBOX_FIELDS];
+	volatile uint32_t dropped;
+} blackbox;
+
+static const float blackbox_scale[BLACKBOX_FIELDS] = {
+	10, 10, 10,			// gyro, 0.1 deg/s
+	10, 10, 10,			// setpoint
+	10000, 10000, 10000,		// P
+	10000, 10000, 10000,		// I
+	10000, 10000, 10000,		// D
+	10000, 10000, 10000, 10000,	// actuator
+};
+
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
 static const struct streamfs_cfg streamfs_settings = {
 	.fs_magic      = 0x89abceef,
 	.arena_size    = PIOS_LOGFLASH_SECT_SIZE,
 	.write_size    = 0x00000100, /* 256 bytes */
 };
+
+/**
+ * State of a streamed download. Sector n is pushed in LoggingSector
+ * instance n % STREAM_WINDOW, and FileSectorNum is the first sector the
+ * GCS has not received, so an instance is only reused once acknowledged.
+ */
+static struct {
+	bool active;
+	bool eof;
+	uint16_t next;		// Next sector to read from the file
+	uint16_t acked;		// First sector not acknowledged
+	uint32_t acked_time;
+} stream;
+
+static int32_t stream_sectors(void);
+static int32_t open_file_range(void);
 #endif
 
 /**
@@ -180,12 +353,42 @@ int32_t LoggingInitialize(void)
 		return -1;
 	}
 
+#ifdef PIOS_INCLUDE_LOG_TO_FLASH
+	if (destination_onboard_flash) {
+		if (LoggingSectorInitialize() == -1) {
+			module_enabled = false;
+			return -1;
+		}
+
+		for (int i = 1; i < STREAM_WINDOW; i++) {
+			if (LoggingSectorCreateInstance() == 0) {
+				module_enabled = false;
+				return -1;
+			}
+		}
+	}
+#endif
+
 	// Initialise UAVTalk
 	uavTalkCon = UAVTalkInitialize(&send_data_nonblock);
 	if (uavTalkCon == 0) {
 		module_enabled = false;
 		return -1;
 	}
+
+	log_ring.buf = PIOS_malloc(LOGGING_RING_SIZE);
+	if (!log_ring.buf) {
+		module_enabled = false;
+		return -1;
+	}
+	memset(log_ring.buf, 0, LOGGING_RING_SIZE);
+
+	blackbox.frame = PIOS_malloc(2 * sizeof(*blackbox.frame));
+	if (!blackbox.frame) {
+		module_enabled = false;
+		return -1;
+	}
+	memset(blackbox.frame, 0, 2 * sizeof(*blackbox.frame));
 	
 	return 0;
 }
@@ -281,8 +484,12 @@ static void loggingTask(void *parameters)
 					PIOS_STREAMFS_Close(logging_com_id);
 					read_open = false;
 					write_open = false;
+					stream.active = false;
 				}
 
+				// What was still gathering belonged to a file now gone
+				compress.active = false;
+
 				PIOS_STREAMFS_Format(logging_com_id);
 				loggingData.MinFileId = PIOS_STREAMFS_MinFileId(logging_com_id);
 				loggingData.MaxFileId = PIOS_STREAMFS_MaxFileId(logging_com_id);
@@ -294,12 +501,18 @@ static void loggingTask(void *parameters)
 		case LOGGINGSTATS_OPERATION_INITIALIZING:
 			// Unregister all objects
 			UAVObjIterate(&unregister_object);
+
+			// Updates of an earlier log don't belong in this one
+			drain_log_ring(false);
+			drain_blackbox(false);
+			compress_stop();
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
 			if (destination_onboard_flash){
 				// Close the file if it is open for reading
 				if (read_open) {
 					PIOS_STREAMFS_Close(logging_com_id);
 					read_open = false;
+					stream.active = false;
 				}
 
 				// Open the file if it is not open for writing
@@ -321,8 +534,10 @@ static void loggingTask(void *parameters)
 			}
 #endif /* PIOS_INCLUDE_LOG_TO_FLASH */
 
-			// Write information at start of the log file
+			// Write information at start of the log file, which
+			// stays readable as text when compressing the rest
 			writeHeader();
+			compress_start();
 
 			// Log settings
 			if (settings.InitiallyLog == LOGGINGSETTINGS_INITIALLYLOG_ALLOBJECTS) {
@@ -332,15 +547,10 @@ static void loggingTask(void *parameters)
 			}
 
 			// Register objects to be logged
-			switch (settings.Profile) {
-				case LOGGINGSETTINGS_PROFILE_BASIC:
-					register_default_profile();
-					break;
-				case LOGGINGSETTINGS_PROFILE_CUSTOM:
-				case LOGGINGSETTINGS_PROFILE_FULLBORE:
-					UAVObjIterate(&register_object);
-					break;
-			}
+			burst_reset();
+			register_profile();
+
+			blackbox_start();
 
 			// Empty the queue
 			LoggingStatsBytesLoggedSet(&written_bytes);
@@ -349,20 +559,115 @@ static void loggingTask(void *parameters)
 			break;
 		case LOGGINGSTATS_OPERATION_LOGGING:
 			{
-				// Sleep between updating stats.
-				PIOS_Thread_Sleep_Until(&now, LOGGING_PERIOD_MS);
+				// Write the updates out in batches, between
+				// updating stats.
+				drain_log_ring(true);
+				drain_blackbox(true);
+				compress_age();
+
+				// A frame of samples fills in a few ms
+				if (blackbox.active) {
+					PIOS_Thread_Sleep(BLACKBOX_DRAIN_PERIOD_MS);
+				} else {
+					PIOS_Thread_Sleep(LOGGING_DRAIN_PERIOD_MS);
+				}
+
+				if (PIOS_Thread_Period_Elapsed(now, LOGGING_PERIOD_MS)) {
+					burst_check();
+
+					uint32_t dropped = log_ring.dropped;
+					uint16_t peak = log_ring.peak;
+					uint32_t samples_dropped = blackbox.dropped;
+
+					LoggingStatsBytesLoggedSet(&written_bytes);
+					LoggingStatsBytesStoredSet(&stored_bytes);
+					LoggingStatsDroppedUpdatesSet(&dropped);
+					LoggingStatsRingPeakSet(&peak);
+					LoggingStatsBlackboxDroppedSet(&samples_dropped);
+#ifdef PIOS_INCLUDE_LOG_TO_FLASH
+					if (destination_onboard_flash) {
+						uint32_t erase_stalls = PIOS_STREAMFS_EraseStalls(logging_com_id);
+						LoggingStatsEraseStallsSet(&erase_stalls);
+					}
+#endif /* PIOS_INCLUDE_LOG_TO_FLASH */
+
+					now = PIOS_Thread_Systime();
+				}
+			}
+			break;
+#ifdef PIOS_INCLUDE_LOG_TO_FLASH
+		case LOGGINGSTATS_OPERATION_STREAM:
+			if (!destination_onboard_flash) {
+				loggingData.Operation = LOGGINGSTATS_OPERATION_ERROR;
+				LoggingStatsSet(&loggingData);
+				break;
+			}
+
+			if (!stream.active) {
+				if (read_open || write_open) {
+					PIOS_STREAMFS_Close(logging_com_id);
+					read_open = false;
+					write_open = false;
+				}
+
+				if (open_file_range() != 0) {
+					loggingData.Operation = LOGGINGSTATS_OPERATION_ERROR;
+					LoggingStatsSet(&loggingData);
+					break;
+				}
+
+				read_open = true;
+				stream.active = true;
+				stream.eof = false;
+				stream.next = 0;
+				stream.acked = 0;
+				stream.acked_time = PIOS_Thread_Systime();
+			}
+
+			{
+				int32_t ret = stream_sectors();
+				if (ret == 0) {
+					PIOS_Thread_Sleep(STREAM_PERIOD_MS);
+					break;
+				}
 
-				LoggingStatsBytesLoggedSet(&written_bytes);
+				if (ret > 0) {
+					loggingData.Operation = LOGGINGSTATS_OPERATION_COMPLETE;
+				} else {
+					loggingData.Operation = LOGGINGSTATS_OPERATION_ERROR;
+					loggingData.FileSectorNum = 0xffff;
+				}
 
-				now = PIOS_Thread_Systime();
+				PIOS_STREAMFS_Close(logging_com_id);
+				stream.active = false;
+				read_open = false;
+				LoggingStatsSet(&loggingData);
 			}
 			break;
+		case LOGGINGSTATS_OPERATION_INFO:
+			// Describe a file from the index kept in the sector footers
+			if (destination_onboard_flash) {
+				struct streamfs_file_info info;
+				if (PIOS_STREAMFS_FileInfo(logging_com_id, loggingData.FileRequest, &info) == 0) {
+					loggingData.FileStartTime = info.start_time;
+					loggingData.FileDuration = info.duration;
+					loggingData.FileLength = info.length;
+					loggingData.Operation = LOGGINGSTATS_OPERATION_IDLE;
+				} else {
+					loggingData.Operation = LOGGINGSTATS_OPERATION_ERROR;
+				}
+			} else {
+				loggingData.Operation = LOGGINGSTATS_OPERATION_ERROR;
+			}
+			LoggingStatsSet(&loggingData);
+			break;
+#endif /* PIOS_INCLUDE_LOG_TO_FLASH */
 		case LOGGINGSTATS_OPERATION_DOWNLOAD:
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
 			if (destination_onboard_flash) {
 				if (!read_open) {
 					// Start reading
-					if (PIOS_STREAMFS_OpenRead(logging_com_id, loggingData.FileRequest) != 0) {
+					if (open_file_range() != 0) {
 						loggingData.Operation = LOGGINGSTATS_OPERATION_ERROR;
 					} else {
 						read_open = true;
@@ -408,10 +713,34 @@ static void loggingTask(void *parameters)
 		default:
 			//  Makes sure that we are not hogging the processor
 			PIOS_Thread_Sleep(10);
+
+			// Stop sampling, the last frame goes out with the rest
+			if (blackbox.active) {
+				blackbox_stop();
+
+				if (!destination_onboard_flash) {
+					drain_blackbox(true);
+				}
+			}
+
+			if (!destination_onboard_flash) {
+				compress_stop();
+			}
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
 			if (destination_onboard_flash) {
+				// Abandon a streamed download the GCS stopped
+				if (stream.active && loggingData.Operation != LOGGINGSTATS_OPERATION_STREAM) {
+					PIOS_STREAMFS_Close(logging_com_id);
+					stream.active = false;
+					read_open = false;
+				}
+
 				// Close the file if necessary
 				if (write_open) {
+					// With what was logged before stopping
+					drain_log_ring(true);
+					drain_blackbox(true);
+					compress_stop();
 					PIOS_STREAMFS_Close(logging_com_id);
 					loggingData.MinFileId = PIOS_STREAMFS_MinFileId(logging_com_id);
 					loggingData.MaxFileId = PIOS_STREAMFS_MaxFileId(logging_com_id);
@@ -424,6 +753,69 @@ static void loggingTask(void *parameters)
 	}
 }
 
+#ifdef PIOS_INCLUDE_LOG_TO_FLASH
+/**
+ * Open the part of the requested file the GCS asked for
+ * \return 0 on success, negative on error
+ */
+static int32_t open_file_range(void)
+{
+	uint32_t start_ms = loggingData.FileRange[LOGGINGSTATS_FILERANGE_START] * 1000;
+	uint32_t end_ms = 0xFFFFFFFF;
+
+	if (loggingData.FileRange[LOGGINGSTATS_FILERANGE_END] != 0) {
+		end_ms = loggingData.FileRange[LOGGINGSTATS_FILERANGE_END] * 1000;
+	}
+
+	return PIOS_STREAMFS_OpenReadRange(logging_com_id, loggingData.FileRequest, start_ms, end_ms);
+}
+
+/**
+ * Advance a streamed download: take the acknowledgement from the GCS,
+ * push sectors until the window is full and send the oldest sector
+ * again if the acknowledgement stalls.
+ * \return 0 while streaming, 1 once every sector is acknowledged, -1 on error
+ */
+static int32_t stream_sectors(void)
+{
+	uint32_t now = PIOS_Thread_Systime();
+
+	// Only accept acknowledgements of sectors that were sent
+	uint16_t ack = loggingData.FileSectorNum;
+	if (ack != stream.acked &&
+			(uint16_t) (ack - stream.acked) <= (uint16_t) (stream.next - stream.acked)) {
+		stream.acked = ack;
+		stream.acked_time = now;
+	}
+
+	while (!stream.eof && (uint16_t) (stream.next - stream.acked) < STREAM_WINDOW) {
+		LoggingSectorData sector;
+		int32_t bytes_read = PIOS_STREAMFS_Read(logging_com_id, sector.Data, LOGGINGSECTOR_DATA_NUMELEM);
+		if (bytes_read < 0)
+			return -1;
+
+		sector.SectorNum = stream.next;
+		sector.Length = bytes_read;
+		LoggingSectorInstSet(stream.next % STREAM_WINDOW, &sector);
+
+		stream.eof = bytes_read < LOGGINGSECTOR_DATA_NUMELEM;
+		stream.next++;
+	}
+
+	if (stream.eof && stream.acked == stream.next)
+		return 1;
+
+	if (stream.acked != stream.next && PIOS_Thread_Period_Elapsed(stream.acked_time, STREAM_RESEND_MS)) {
+		LoggingSectorData sector;
+		LoggingSectorInstGet(stream.acked % STREAM_WINDOW, &sector);
+		LoggingSectorInstSet(stream.acked % STREAM_WINDOW, &sector);
+		stream.acked_time = now;
+	}
+
+	return 0;
+}
+#endif /* PIOS_INCLUDE_LOG_TO_FLASH */
+
 /**
  * Log all objects' initial value.
  * \param[in] obj Object to log
@@ -454,38 +846,480 @@ static void logSettings(UAVObjHandle obj)
  */
 static int32_t send_data(uint8_t *data, int32_t length)
 {
-	if (PIOS_COM_SendBuffer(logging_com_id, data, length) < 0)
-		return -1;
+	return log_write(data, length, true);
+}
 
-	written_bytes += length;
+static int32_t send_data_nonblock(uint8_t *data, int32_t length)
+{
+	return log_write(data, length, false);
+}
 
-	return length;
+/**
+ * Move what is left of the pending chunk into the COM buffer
+ * \param[in] block wait for room instead of giving up when there is none
+ * \return true once all of the chunk is in
+ */
+static bool compress_push(bool block)
+{
+	while (compress.chunk_sent < compress.chunk_len) {
+		uint8_t *chunk = compress.bufs->chunk + compress.chunk_sent;
+		uint16_t len = compress.chunk_len - compress.chunk_sent;
+		int32_t rc;
+
+		if (block) {
+			rc = PIOS_COM_SendBuffer(logging_com_id, chunk, len);
+		} else {
+			rc = PIOS_COM_SendBufferNonBlocking(logging_com_id, chunk,
+					MIN(len, COMPRESS_PUSH_LEN));
+		}
+
+		if (rc <= 0) {
+			return false;
+		}
+
+		compress.chunk_sent += rc;
+		stored_bytes += rc;
+	}
+
+	return true;
 }
 
-static int32_t send_data_nonblock(uint8_t *data, int32_t length)
+/**
+ * Compress the block into the pending chunk, which must be out already
+ */
+static void compress_block(void)
+{
+	if (compress.block_len) {
+		compress.chunk_len = logcompress_chunk(&compress.bufs->state,
+				compress.bufs->block, compress.block_len,
+				compress.bufs->chunk);
+		compress.chunk_sent = 0;
+		compress.block_len = 0;
+
+		compress_push(false);
+	}
+}
+
+/**
+ * Write to the log, through the compression when it is on
+ * \param[in] block wait for room in the COM buffer
+ * \return -1 on failure, else length
+ */
+static int32_t log_write(uint8_t *data, int32_t length, bool block)
 {
-	if (PIOS_COM_SendBufferNonBlocking(logging_com_id, data, length) < 0)
+	if (!compress.active) {
+		int32_t rc;
+
+		if (block) {
+			rc = PIOS_COM_SendBuffer(logging_com_id, data, length);
+		} else {
+			rc = PIOS_COM_SendBufferNonBlocking(logging_com_id, data, length);
+		}
+
+		if (rc < 0)
+			return -1;
+
+		written_bytes += length;
+		stored_bytes += length;
+
+		return length;
+	}
+
+	if (length > LOGCOMPRESS_BLOCK_LEN) {
 		return -1;
+	}
+
+	bool pushed = compress_push(block);
 
+	if (compress.block_len + length > LOGCOMPRESS_BLOCK_LEN) {
+		if (!pushed) {
+			return -1;
+		}
+
+		compress_block();
+	}
+
+	if (!compress.block_len) {
+		compress.block_time = PIOS_Thread_Systime();
+	}
+
+	memcpy(compress.bufs->block + compress.block_len, data, length);
+	compress.block_len += length;
 	written_bytes += length;
 
 	return length;
 }
 
+/**
+ * Compress what follows in the log, if the settings ask for it
+ */
+static void compress_start(void)
+{
+	if (settings.Compression != LOGGINGSETTINGS_COMPRESSION_ON) {
+		return;
+	}
+
+	if (!compress.bufs) {
+		compress.bufs = PIOS_malloc_no_dma(sizeof(*compress.bufs));
+
+		// Without the room, the log is just left uncompressed
+		if (!compress.bufs) {
+			return;
+		}
+	}
+
+	compress.block_len = 0;
+	compress.chunk_len = 0;
+	compress.chunk_sent = 0;
+	compress.active = true;
+}
+
+/**
+ * Write out all that is gathered, and leave what follows uncompressed
+ */
+static void compress_stop(void)
+{
+	if (!compress.active) {
+		return;
+	}
+
+	compress_push(true);
+	compress_block();
+	compress_push(true);
+
+	compress.active = false;
+}
+
+/**
+ * Keep the pending chunk going out, and compress a partial block once it
+ * has waited long enough, so a slow log doesn't keep it back
+ */
+static void compress_age(void)
+{
+	if (!compress.active) {
+		return;
+	}
+
+	if (compress_push(false) && compress.block_len &&
+			PIOS_Thread_Period_Elapsed(compress.block_time, COMPRESS_FLUSH_MS)) {
+		compress_block();
+	}
+}
+
+/**
+ * Copy an update into the log ring, or count it as dropped if there is
+ * no room.  Runs in the task that set the object, so it costs a bounded
+ * copy and nothing else.
+ */
+static void log_snapshot(UAVObjEvent *ev, void *uavo_data, int uavo_len)
+{
+	uint32_t now = PIOS_Thread_Systime();
+
+	if (!uavo_data || uavo_len <= 0) {
+		uavo_data = NULL;
+		uavo_len = UAVObjGetNumBytes(ev->obj);
+	}
+
+	const uint32_t mask = LOGGING_RING_SIZE - 1;
+	uint32_t size = (sizeof(struct log_record) + uavo_len + 3) & ~3;
+	uint32_t head, pad, next;
+
+	// Claim the room, plus the end of the ring if the record doesn't fit
+	do {
+		head = log_ring.head;
+		uint32_t offset = head & mask;
+
+		pad = (offset + size > LOGGING_RING_SIZE) ? (LOGGING_RING_SIZE - offset) : 0;
+		next = head + pad + size;
+
+		if (next - log_ring.tail > LOGGING_RING_SIZE) {
+			__sync_fetch_and_add(&log_ring.dropped, 1);
+			return;
+		}
+	} while (!__sync_bool_compare_and_swap(&log_ring.head, head, next));
+
+	// Only a statistic, a lost race doesn't matter
+	if (next - log_ring.tail > log_ring.peak) {
+		log_ring.peak = next - log_ring.tail;
+	}
+
+	if (pad) {
+		struct log_record *filler = (struct log_record *) &log_ring.buf[head & mask];
+		filler->length = pad;
+		filler->pad = 1;
+		__sync_synchronize();
+		filler->ready = 1;
+	}
+
+	struct log_record *rec = (struct log_record *) &log_ring.buf[(head + pad) & mask];
+	rec->length = size;
+	rec->pad = 0;
+	rec->timestamp = now;
+	rec->obj = ev->obj;
+	rec->instId = ev->instId;
+
+	if (uavo_data) {
+		memcpy(rec + 1, uavo_data, uavo_len);
+	} else {
+		UAVObjPack(ev->obj, ev->instId, (uint8_t *) (rec + 1));
+	}
+
+	// The record must be complete before the logging task sees it
+	__sync_synchronize();
+	rec->ready = 1;
+}
+
+/**
+ * Write out the updates in the log ring, up to the first one still being
+ * copied in
+ * \param[in] write false to discard them instead
+ */
+static void drain_log_ring(bool write)
+{
+	const uint32_t mask = LOGGING_RING_SIZE - 1;
+
+	while (log_ring.tail != log_ring.head) {
+		struct log_record *rec = (struct log_record *) &log_ring.buf[log_ring.tail & mask];
+
+		if (!rec->ready) {
+			break;
+		}
+
+		__sync_synchronize();
+
+		if (write && !rec->pad) {
+			UAVTalkSendObjectData(uavTalkCon, rec->obj, rec->instId,
+					rec->timestamp, (const uint8_t *) (rec + 1));
+		}
+
+		uint16_t length = rec->length;
+
+		/* Records differ in size, so a later header can land anywhere
+		 * in this one.  Clear all of it, so no ready flag is left
+		 * behind for a record claimed but not written yet. */
+		memset(rec, 0, length);
+
+		// Writers may reuse the room once tail moves past it
+		__sync_synchronize();
+		log_ring.tail += length;
+	}
+}
+
+/**
+ * Start taking high rate samples, at the rate in the settings
+ */
+static void blackbox_start(void)
+{
+	uint32_t rate = 0;
+
+	switch (settings.BlackboxRate) {
+	case LOGGINGSETTINGS_BLACKBOXRATE_250:
+		rate = 250;
+		break;
+	case LOGGINGSETTINGS_BLACKBOXRATE_500:
+		rate = 500;
+		break;
+	case LOGGINGSETTINGS_BLACKBOXRATE_1000:
+		rate = 1000;
+		break;
+	case LOGGINGSETTINGS_BLACKBOXRATE_2000:
+		rate = 2000;
+		break;
+	}
+
+	for (int i = 0; i < 2; i++) {
+		blackbox.frame[i].length = 0;
+		blackbox.frame[i].records = 0;
+		blackbox.frame[i].full = false;
+	}
+
+	blackbox.filling = 0;
+	blackbox.writing = 0;
+	blackbox.dropped = 0;
+
+	if (rate) {
+		blackbox.period_us = 1000000 / rate;
+		blackbox.last_us = PIOS_DELAY_GetuS() - blackbox.period_us;
+		blackbox.active = true;
+	}
+}
+
+/**
+ * Fill in the count, padding and CRC of a frame, and hand it over to the
+ * logging task
+ */
+static void blackbox_seal(struct blackbox_frame *frame)
+{
+	memset(frame->data + frame->length, 0, BLACKBOX_FRAME_LEN - 1 - frame->length);
+	frame->data[11] = frame->records;
+	frame->data[BLACKBOX_FRAME_LEN - 1] = PIOS_CRC_updateCRC(0, frame->data, BLACKBOX_FRAME_LEN - 1);
+
+	__sync_synchronize();
+	frame->full = true;
+}
+
+/**
+ * Stop taking samples, sealing the frame they were going in
+ */
+static void blackbox_stop(void)
+{
+	blackbox.active = false;
+
+	struct blackbox_frame *frame = &blackbox.frame[blackbox.filling];
+	if (frame->records && !frame->full) {
+		blackbox_seal(frame);
+	}
+}
+
+/**
+ * Write out the sealed frames, oldest first
+ * \param[in] write false to discard them instead
+ */
+static void drain_blackbox(bool write)
+{
+	struct blackbox_frame *frame;
+
+	while ((frame = &blackbox.frame[blackbox.writing])->full) {
+		// When the COM buffer is full, try again on the next pass
+		if (write && send_data_nonblock(frame->data, BLACKBOX_FRAME_LEN) < 0) {
+			break;
+		}
+
+		frame->length = 0;
+		frame->records = 0;
+		__sync_synchronize();
+		frame->full = false;
+
+		blackbox.writing ^= 1;
+	}
+}
+
+static uint8_t *put_varint(uint8_t *p, uint32_t value)
+{
+	while (value >= 0x80) {
+		*p++ = (value & 0x7f) | 0x80;
+		value >>= 7;
+	}
+	*p++ = value;
+
+	return p;
+}
+
+/**
+ * Encode a record, against the one before it or against zero
+ * \return the length of the record
+ */
+static uint16_t blackbox_encode(uint8_t *rec, uint32_t dt_us, const int32_t *values,
+		const int32_t *last)
+{
+	uint8_t *p = put_varint(rec, dt_us);
+
+	for (int i = 0; i < BLACKBOX_FIELDS; i++) {
+		int32_t diff = last ? values[i] - last[i] : values[i];
+
+		p = put_varint(p, ((uint32_t) diff << 1) ^ (uint32_t) (diff >> 31));
+	}
+
+	return p - rec;
+}
+
+/**
+ * Whether to take a sample this iteration of the control loop.  Cheap, so
+ * it can be asked every time.
+ */
+bool LoggingBlackboxDue(void)
+{
+	if (!blackbox.active) {
+		return false;
+	}
+
+	uint32_t now = PIOS_DELAY_GetuS();
+
+	// A little early rather than a whole loop late
+	if (now - blackbox.last_us < blackbox.period_us - blackbox.period_us / 4) {
+		return false;
+	}
+
+	blackbox.due_us = now;
+
+	return true;
+}
+
+/**
+ * Add a sample to the frame being filled.  Only after LoggingBlackboxDue
+ * returned true, and from the stabilization task.
+ */
+void LoggingBlackboxSample(const struct logging_blackbox_sample *sample)
+{
+	const float *in = sample->gyro;
+	int32_t values[BLACKBOX_FIELDS];
+	uint8_t rec[BLACKBOX_RECORD_MAX];
+	uint16_t length = 0;
+
+	for (int i = 0; i < BLACKBOX_FIELDS; i++) {
+		values[i] = roundf(in[i] * blackbox_scale[i]);
+	}
+
+	struct blackbox_frame *frame = &blackbox.frame[blackbox.filling];
+
+	if (frame->records) {
+		length = blackbox_encode(rec, blackbox.due_us - blackbox.last_us, values, blackbox.last);
+
+		if (frame->length + length > BLACKBOX_FRAME_LEN - 1 || frame->records == 0xff) {
+			blackbox_seal(frame);
+
+			blackbox.filling ^= 1;
+			frame = &blackbox.frame[blackbox.filling];
+		}
+	}
+
+	if (frame->full) {
+		// The logging task is behind
+		blackbox.dropped++;
+		return;
+	}
+
+	if (!frame->records) {
+		uint8_t *hdr = frame->data;
+		uint32_t objId = BLACKBOX_OBJID;
+		uint16_t size = BLACKBOX_FRAME_LEN - 1;
+		uint16_t timestamp = PIOS_Thread_Systime();
+
+		hdr[0] = 0x3C;		// sync
+		hdr[1] = 0xA0;		// OBJ_TS
+		memcpy(&hdr[2], &size, sizeof(size));
+		memcpy(&hdr[4], &objId, sizeof(objId));
+		memcpy(&hdr[8], &timestamp, sizeof(timestamp));
+		hdr[10] = BLACKBOX_VERSION;
+		hdr[11] = 0;
+		memcpy(&hdr[12], &blackbox.due_us, sizeof(blackbox.due_us));
+
+		frame->length = BLACKBOX_HEADER_LEN;
+		length = blackbox_encode(rec, 0, values, NULL);
+	}
+
+	memcpy(frame->data + frame->length, rec, length);
+	frame->length += length;
+	frame->records++;
+
+	memcpy(blackbox.last, values, sizeof(values));
+	blackbox.last_us = blackbox.due_us;
+}
+
 /**
  * @brief Callback for adding an object to the logging queue
  * @param ev the event
  */
 static void obj_updated_callback(UAVObjEvent * ev, void* cb_ctx, void *uavo_data, int uavo_len)
 {
-	(void) cb_ctx; (void) uavo_data; (void) uavo_len;
+	(void) cb_ctx;
 
 	if (loggingData.Operation != LOGGINGSTATS_OPERATION_LOGGING){
 		// We are not logging, so all events are discarded
 		return;
 	}
 
-	UAVTalkSendObjectTimestamped(uavTalkCon, ev->obj, ev->instId, false, 0);
+	log_snapshot(ev, uavo_data, uavo_len);
 }
 
 
@@ -564,7 +1398,7 @@ static void register_object(UAVObjHandle obj)
 			return;
 		}
 
-		period = meta_data.loggingUpdatePeriod;
+		period = burst.active ? 1 : meta_data.loggingUpdatePeriod;
 	}
 
 	period = MAX(period, get_minimum_logging_period());
@@ -578,6 +1412,24 @@ static void register_object(UAVObjHandle obj)
 	}
 }
 
+/**
+ * Connect an object of the default profile, if the board has it
+ * \param[in] obj Object to connect
+ * \param[in] period Logging period, in ms
+ */
+static void register_throttled(UAVObjHandle obj, uint16_t period)
+{
+	if (!obj) {
+		return;
+	}
+
+	if (burst.active) {
+		period = MIN(period, burst.period);
+	}
+
+	UAVObjConnectCallbackThrottled(obj, obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, period);
+}
+
 /**
  * Register objects for the default logging profile
  */
@@ -586,60 +1438,112 @@ static void register_default_profile()
 	// For the default profile, we limit things to 100Hz (for now)
 	uint16_t min_period = MAX(get_minimum_logging_period(), 10);
 
-	// Objects for which we log all changes (use 100Hz to limit max data rate)
-	UAVObjConnectCallbackThrottled(FlightStatusHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10);
-	UAVObjConnectCallbackThrottled(SystemAlarmsHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10);
-	if (WaypointActiveHandle()) {
-		UAVObjConnectCallbackThrottled(WaypointActiveHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10);
-	}
+	burst.period = min_period;
 
-	if (SystemIdentHandle()){
-		UAVObjConnectCallbackThrottled(SystemIdentHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10);
-	}
+	// Objects for which we log all changes (use 100Hz to limit max data rate)
+	register_throttled(FlightStatusHandle(), 10);
+	register_throttled(SystemAlarmsHandle(), 10);
+	register_throttled(WaypointActiveHandle(), 10);
+	register_throttled(SystemIdentHandle(), 10);
 
 	// Log fast
-	UAVObjConnectCallbackThrottled(AccelsHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, min_period);
-	UAVObjConnectCallbackThrottled(GyrosHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, min_period);
+	register_throttled(AccelsHandle(), min_period);
+	register_throttled(GyrosHandle(), min_period);
 
 	// Log a bit slower
-	UAVObjConnectCallbackThrottled(AttitudeActualHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 5 * min_period);
+	register_throttled(AttitudeActualHandle(), 5 * min_period);
+	register_throttled(MagnetometerHandle(), 5 * min_period);
+	register_throttled(ManualControlCommandHandle(), 5 * min_period);
+	register_throttled(ActuatorDesiredHandle(), 5 * min_period);
+	register_throttled(StabilizationDesiredHandle(), 5 * min_period);
 
-	if (MagnetometerHandle()) {
-		UAVObjConnectCallbackThrottled(MagnetometerHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 5 * min_period);
-	}
+	// Log slow
+	register_throttled(FlightBatteryStateHandle(), 10 * min_period);
+	register_throttled(BaroAltitudeHandle(), 10 * min_period);
+	register_throttled(AirspeedActualHandle(), 10 * min_period);
+	register_throttled(GPSPositionHandle(), 10 * min_period);
+	register_throttled(PositionActualHandle(), 10 * min_period);
+	register_throttled(VelocityActualHandle(), 10 * min_period);
 
-	UAVObjConnectCallbackThrottled(ManualControlCommandHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 5 * min_period);
-	UAVObjConnectCallbackThrottled(ActuatorDesiredHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 5 * min_period);
-	UAVObjConnectCallbackThrottled(StabilizationDesiredHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 5 * min_period);
+	// Log very slow
+	register_throttled(GPSTimeHandle(), 50 * min_period);
 
-	// Log slow
-	if (FlightBatteryStateHandle()) {
-		UAVObjConnectCallbackThrottled(FlightBatteryStateHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10 * min_period);
-	}
-	if (BaroAltitudeHandle()) {
-		UAVObjConnectCallbackThrottled(BaroAltitudeHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10 * min_period);
-	}
-	if (AirspeedActualHandle()) {
-		UAVObjConnectCallbackThrottled(AirspeedActualHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10 * min_period);
+	// Log very very slow
+	register_throttled(GPSSatellitesHandle(), 500 * min_period);
+}
+
+/**
+ * Register the objects of the profile in the settings.  Connecting an
+ * object again only changes its period, so this also moves in and out
+ * of a burst.
+ */
+static void register_profile()
+{
+	switch (settings.Profile) {
+		case LOGGINGSETTINGS_PROFILE_BASIC:
+			register_default_profile();
+			break;
+		case LOGGINGSETTINGS_PROFILE_CUSTOM:
+		case LOGGINGSETTINGS_PROFILE_FULLBORE:
+			UAVObjIterate(&register_object);
+			break;
 	}
-	if (GPSPositionHandle()) {
-		UAVObjConnectCallbackThrottled(GPSPositionHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10 * min_period);
+}
+
+/**
+ * Remember the state bursts are triggered by, so only a change of it
+ * from now on is one
+ */
+static void burst_reset(void)
+{
+	FlightStatusFlightModeGet(&burst.flight_mode);
+	SystemAlarmsAlarmGet(burst.alarms);
+
+	burst.active = false;
+}
+
+/**
+ * Start a burst on a change of flight mode or an alarm getting worse, and
+ * end it BurstDuration after the last trigger
+ */
+static void burst_check(void)
+{
+	if (!settings.BurstDuration) {
+		return;
 	}
-	if (PositionActualHandle()) {
-		UAVObjConnectCallbackThrottled(PositionActualHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10 * min_period);
+
+	bool triggered = false;
+
+	uint8_t flight_mode;
+	FlightStatusFlightModeGet(&flight_mode);
+	if (flight_mode != burst.flight_mode &&
+			settings.BurstTrigger[LOGGINGSETTINGS_BURSTTRIGGER_FLIGHTMODE] == LOGGINGSETTINGS_BURSTTRIGGER_TRUE) {
+		triggered = true;
 	}
-	if (VelocityActualHandle()) {
-		UAVObjConnectCallbackThrottled(VelocityActualHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 10 * min_period);
+	burst.flight_mode = flight_mode;
+
+	uint8_t alarms[SYSTEMALARMS_ALARM_NUMELEM];
+	SystemAlarmsAlarmGet(alarms);
+	for (int i = 0; i < SYSTEMALARMS_ALARM_NUMELEM; i++) {
+		if (alarms[i] > burst.alarms[i] && alarms[i] >= SYSTEMALARMS_ALARM_WARNING &&
+				settings.BurstTrigger[LOGGINGSETTINGS_BURSTTRIGGER_ALARM] == LOGGINGSETTINGS_BURSTTRIGGER_TRUE) {
+			triggered = true;
+		}
+		burst.alarms[i] = alarms[i];
 	}
 
-	// Log very slow
-	if (GPSTimeHandle()) {
-		UAVObjConnectCallbackThrottled(GPSTimeHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 50 * min_period);
-	}
+	uint32_t now = PIOS_Thread_Systime();
 
-	// Log very very slow
-	if (GPSSatellitesHandle()) {
-		UAVObjConnectCallbackThrottled(GPSSatellitesHandle(), obj_updated_callback, NULL, EV_UPDATED | EV_UNPACKED, 500 * min_period);
+	if (triggered) {
+		burst.started = now;
+
+		if (!burst.active) {
+			burst.active = true;
+			register_profile();
+		}
+	} else if (burst.active && now - burst.started >= settings.BurstDuration * 1000) {
+		burst.active = false;
+		register_profile();
 	}
 }
 
@@ -131,8 +131,8 @@ DONT_BUILD_IF(
 //! Initialize the transmitter control mode
 int32_t transmitter_control_initialize();
 
-//! Process inputs and arming
-int32_t transmitter_control_update();
+//! Process inputs, and arming too when full_update is set
+int32_t transmitter_control_update(bool full_update);
 
 //! Select and use transmitter control
 int32_t transmitter_control_select(bool reset_controller);
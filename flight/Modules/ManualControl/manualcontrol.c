@@ -123,17 +123,45 @@ static void manualControlTask(void *parameters)
 	// Select failsafe before run
 	failsafe_control_select(true);
 
+	// Initialize to invalid value to ensure first update sets FlightStatus
+	FlightStatusControlSourceOptions last_control_selection = -1;
+	uint32_t last_full_update = 0;
+
 	while (1) {
+		uint32_t now = PIOS_Thread_Systime();
+
+		// Receivers wake us on every frame.  While the transmitter is in
+		// control a frame only needs to reach the stabilization desired
+		// values; selecting the controller, the failsafe and arming checks
+		// and the other controllers are run at the update period.
+		bool full_update = last_control_selection != FLIGHTSTATUS_CONTROLSOURCE_TRANSMITTER ||
+			now - last_full_update >= UPDATE_PERIOD_MS;
+
+		// Read all available inputs
+		transmitter_control_update(full_update);
+
+		if (!full_update) {
+			uint8_t connected;
+			ManualControlCommandConnectedGet(&connected);
+
+			if (connected == MANUALCONTROLCOMMAND_CONNECTED_TRUE) {
+				transmitter_control_select(false);
+
+				PIOS_RCVR_WaitActivity(UPDATE_PERIOD_MS);
+				PIOS_WDG_UpdateFlag(PIOS_WDG_MANUAL);
+				continue;
+			}
+
+			// Lost the receiver, so fall back right away
+		}
+
+		last_full_update = now;
 
-		// Process periodic data for each of the controllers, including reading
-		// all available inputs
+		// Process periodic data for the other controllers
 		failsafe_control_update();
-		transmitter_control_update();
 		tablet_control_update();
 		geofence_control_update();
 
-		// Initialize to invalid value to ensure first update sets FlightStatus
-		static FlightStatusControlSourceOptions last_control_selection = -1;
 		enum control_events control_events = CONTROL_EVENTS_NONE;
 
 		// Control logic to select the valid controller
@@ -202,8 +202,16 @@ static float get_thrust_source(ManualControlCommandData *manual_control_command,
   * is always in charge.  When a transmitter is not detected control will
   * fall back to the failsafe module.  If the flight mode is in tablet
   * control position then control will be ceeded to that module.
+  *
+  * The channels are read and ManualControlCommand updated on every call,
+  * so a new receiver frame reaches the controller without delay.  What
+  * only needs the slower update rate -- the activity monitor, RSSI, the
+  * accessories and the arming state machine -- is skipped unless
+  * full_update is set.
+  *
+  * \param[in] full_update true to do the slow rate processing as well
   */
-int32_t transmitter_control_update()
+int32_t transmitter_control_update(bool full_update)
 {
 	lastSysTime = PIOS_Thread_Systime();
 
@@ -219,14 +227,14 @@ int32_t transmitter_control_update()
 	uint8_t arm_status;
 	FlightStatusArmedGet(&arm_status);
 
-	if (arm_status == FLIGHTSTATUS_ARMED_DISARMED) {
+	if (full_update && arm_status == FLIGHTSTATUS_ARMED_DISARMED) {
 		if (updateRcvrActivity(&activity_fsm)) {
 			/* Reset the aging timer because activity was detected */
 			lastActivityTime = lastSysTime;
 		}
 	}
 
-	if (timeDifferenceMs(lastActivityTime, lastSysTime) > 5000) {
+	if (full_update && timeDifferenceMs(lastActivityTime, lastSysTime) > 5000) {
 		resetRcvrActivity(&activity_fsm);
 		lastActivityTime = lastSysTime;
 	}
@@ -246,7 +254,7 @@ int32_t transmitter_control_update()
 		return 0;
 	}
 
-	if (settings.RssiType != MANUALCONTROLSETTINGS_RSSITYPE_NONE) {
+	if (full_update && settings.RssiType != MANUALCONTROLSETTINGS_RSSITYPE_NONE) {
 		int32_t value = 0;
 
 		switch (settings.RssiType) {
@@ -431,35 +439,38 @@ int32_t transmitter_control_update()
 			cmd.Collective = scaledChannel[MANUALCONTROLSETTINGS_CHANNELGROUPS_COLLECTIVE];
 		}
 
-		AccessoryDesiredData accessory;
-		// Set Accessory 0
-		if (settings.ChannelGroups[MANUALCONTROLSETTINGS_CHANNELGROUPS_ACCESSORY0] !=
-			MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE) {
-			accessory.AccessoryVal = scaledChannel[MANUALCONTROLSETTINGS_CHANNELGROUPS_ACCESSORY0];
-			if(AccessoryDesiredInstSet(0, &accessory) != 0) //These are allocated later and that allocation might fail
-				set_manual_control_error(SYSTEMALARMS_MANUALCONTROL_ACCESSORY);
-		}
-		// Set Accessory 1
-		if (settings.ChannelGroups[MANUALCONTROLSETTINGS_CHANNELGROUPS_ACCESSORY1] !=
-			MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE) {
-			accessory.AccessoryVal = scaledChannel[MANUALCONTROLSETTINGS_CHANNELGROUPS_ACCESSORY1];
-			if(AccessoryDesiredInstSet(1, &accessory) != 0) //These are allocated later and that allocation might fail
-				set_manual_control_error(SYSTEMALARMS_MANUALCONTROL_ACCESSORY);
-		}
-		// Set Accessory 2
-		if (settings.ChannelGroups[MANUALCONTROLSETTINGS_CHANNELGROUPS_ACCESSORY2] !=
-			MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE) {
-			accessory.AccessoryVal = scaledChannel[MANUALCONTROLSETTINGS_CHANNELGROUPS_ACCESSORY2];
-			if(AccessoryDesiredInstSet(2, &accessory) != 0) //These are allocated later and that allocation might fail
-				set_manual_control_error(SYSTEMALARMS_MANUALCONTROL_ACCESSORY);
+		// Accessories only need the slow rate
+		if (full_update) {
+			AccessoryDesiredData accessory;
+			// Set Accessory 0
+			if (settings.ChannelGroups[MANUALCONTROLSETTINGS_CHANNELGROUPS_ACCESSORY0] !=
+				MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE) {
+				accessory.AccessoryVal = scaledChannel[MANUALCONTROLSETTINGS_CHANNELGROUPS_ACCESSORY0];
+				if(AccessoryDesiredInstSet(0, &accessory) != 0) //These are allocated later and that allocation might fail
+					set_manual_control_error(SYSTEMALARMS_MANUALCONTROL_ACCESSORY);
+			}
+			// Set Accessory 1
+			if (settings.ChannelGroups[MANUALCONTROLSETTINGS_CHANNELGROUPS_ACCESSORY1] !=
+				MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE) {
+				accessory.AccessoryVal = scaledChannel[MANUALCONTROLSETTINGS_CHANNELGROUPS_ACCESSORY1];
+				if(AccessoryDesiredInstSet(1, &accessory) != 0) //These are allocated later and that allocation might fail
+					set_manual_control_error(SYSTEMALARMS_MANUALCONTROL_ACCESSORY);
+			}
+			// Set Accessory 2
+			if (settings.ChannelGroups[MANUALCONTROLSETTINGS_CHANNELGROUPS_ACCESSORY2] !=
+				MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE) {
+				accessory.AccessoryVal = scaledChannel[MANUALCONTROLSETTINGS_CHANNELGROUPS_ACCESSORY2];
+				if(AccessoryDesiredInstSet(2, &accessory) != 0) //These are allocated later and that allocation might fail
+					set_manual_control_error(SYSTEMALARMS_MANUALCONTROL_ACCESSORY);
+			}
 		}
-
 	}
 
 	// Process arming outside conditional so system will disarm when disconnected.  Notice this
 	// is processed in the _update method instead of _select method so the state system is always
 	// evalulated, even if not detected.
-	process_transmitter_events(&cmd, &settings, valid_input_detected);
+	if (full_update)
+		process_transmitter_events(&cmd, &settings, valid_input_detected);
 
 	// Update cmd object
 	ManualControlCommandSet(&cmd);
@@ -56,21 +56,79 @@ extern uint8_t *draw_buffer;
 extern uint8_t *disp_buffer;
 #endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
 
+/* Most pages only draw in a few bands of the screen, so rather than wiping
+ * the whole draw buffer every frame, keep track of the rows that have been
+ * drawn on since each buffer was last cleared and only clear those.
+ *
+ * The buffers are swapped from the vsync interrupt, which may happen while a
+ * frame is still being drawn, so a write can't be reliably pinned to one
+ * buffer.  Every write widens the pending rows of both buffers instead; each
+ * buffer's rows are reset once it has been cleared. */
+struct dirty_rows {
+	uint8_t *buf;
+	int16_t top;
+	int16_t bottom;
+};
+
+static struct dirty_rows dirty[2] = {
+	{ .buf = NULL, .top = 0, .bottom = INT16_MAX },
+	{ .buf = NULL, .top = 0, .bottom = INT16_MAX },
+};
+
+static inline void mark_rows(int top, int bottom)
+{
+	for (int i = 0; i < 2; i++) {
+		if (top < dirty[i].top)
+			dirty[i].top = top;
+		if (bottom > dirty[i].bottom)
+			dirty[i].bottom = bottom;
+	}
+}
 
 void clearGraphics()
 {
 #if defined(PIOS_VIDEO_SPLITBUFFER)
-	memset((uint8_t *)draw_buffer_mask, 0, BUFFER_HEIGHT * BUFFER_WIDTH);
-	memset((uint8_t *)draw_buffer_level, 0, BUFFER_HEIGHT * BUFFER_WIDTH);
+	uint8_t *mask = draw_buffer_mask;
+	uint8_t *level = draw_buffer_level;
 #else
-	memset((uint8_t *)draw_buffer, 0, BUFFER_HEIGHT * BUFFER_WIDTH);
+	uint8_t *mask = draw_buffer;
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+	struct dirty_rows *d = NULL;
+
+	// Buffers are told apart by their mask (or only) pointer, which is
+	// swapped along with the level one.
+	for (int i = 0; i < 2 && !d; i++) {
+		if (dirty[i].buf == mask || !dirty[i].buf) {
+			dirty[i].buf = mask;
+			d = &dirty[i];
+		}
+	}
+
+	int top = 0, bottom = BUFFER_HEIGHT - 1;
+	if (d) {
+		top = MAX(d->top, 0);
+		bottom = MIN(d->bottom, BUFFER_HEIGHT - 1);
+		d->top = INT16_MAX;
+		d->bottom = -1;
+	}
+
+	if (top > bottom)
+		return;
+
+	size_t offset = top * BUFFER_WIDTH;
+	size_t len = (bottom - top + 1) * BUFFER_WIDTH;
+
+	memset(mask + offset, 0, len);
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+	memset(level + offset, 0, len);
 #endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
 }
 
 void draw_image(uint16_t x, uint16_t y, const struct Image * image)
 {
-#if defined(PIOS_VIDEO_SPLITBUFFER)
 	CHECK_COORDS(x + image->width, y + image->height);
+	mark_rows(y, y + image->height - 1);
+#if defined(PIOS_VIDEO_SPLITBUFFER)
 	uint8_t byte_width = image->width / 8;
 	uint8_t pixel_offset = x % 8;
 	uint8_t mask1 = 0xFF;
@@ -96,7 +154,6 @@ void draw_image(uint16_t x, uint16_t y, const struct Image * image)
 		}
 	}
 #else
-	CHECK_COORDS(x + image->width, y + image->height);
 	uint8_t byte_width = image->width / 4;
 	uint8_t pixel_offset = 2 * (x % 4);
 	uint8_t mask1 = 0xFF;
@@ -231,6 +288,7 @@ void drawBox(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
 void write_pixel(uint8_t *buff, int x, int y, int mode)
 {
 	CHECK_COORDS(x, y);
+	mark_rows(y, y);
 	// Determine the bit in the word to be set and the word
 	// index to set it in.
 	int wordnum = CALC_BUFF_ADDR(x, y);
@@ -241,6 +299,7 @@ void write_pixel(uint8_t *buff, int x, int y, int mode)
 void write_pixel(int x, int y, uint8_t value)
 {
 	CHECK_COORDS(x, y);
+	mark_rows(y, y);
 	// Determine the bit in the word to be set and the word
 	// index to set it in.
 	int wordnum = CALC_BUFF_ADDR(x, y);
@@ -261,6 +320,7 @@ void write_pixel(int x, int y, uint8_t value)
 void write_pixel_lm(int x, int y, int mmode, int lmode)
 {
 	CHECK_COORDS(x, y);
+	mark_rows(y, y);
 	// Determine the bit in the word to be set and the word
 	// index to set it in.
 	int addr   = CALC_BUFF_ADDR(x, y);
@@ -274,6 +334,46 @@ void write_pixel_lm(int x, int y, int mmode, int lmode)
 #endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
 }
 
+/**
+ * write_span: fill the whole bytes addr0 to addr1 of a row.
+ *
+ * Setting and clearing go through memset, which stores a word at a time;
+ * only toggling needs a read-modify-write of each byte.
+ *
+ * @param       buff    pointer to buffer to write in
+ * @param       addr0   first byte
+ * @param       addr1   last byte
+ * @param       mode    0 = clear, 1 = set, 2 = toggle
+ */
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+static inline void write_span(uint8_t *buff, int addr0, int addr1, int mode)
+{
+	if (addr1 < addr0)
+		return;
+
+	switch (mode) {
+	case 0:
+		memset(&buff[addr0], 0x00, addr1 - addr0 + 1);
+		break;
+	case 1:
+		memset(&buff[addr0], 0xff, addr1 - addr0 + 1);
+		break;
+	case 2:
+		for (int i = addr0; i <= addr1; i++)
+			buff[i] ^= 0xff;
+		break;
+	}
+}
+#else
+static inline void write_span(int addr0, int addr1, uint8_t value)
+{
+	if (addr1 < addr0)
+		return;
+
+	memset(&draw_buffer[addr0], value, addr1 - addr0 + 1);
+}
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+
 /**
  * write_hline: optimised horizontal line writing algorithm
  *
@@ -295,13 +395,14 @@ void write_hline(uint8_t *buff, int x0, int x1, int y, int mode)
 	if (x0 == x1) {
 		return;
 	}
+	mark_rows(y, y);
 	/* This is an optimised algorithm for writing horizontal lines.
 	 * We begin by finding the addresses of the x0 and x1 points. */
 	int addr0     = CALC_BUFF_ADDR(x0, y);
 	int addr1     = CALC_BUFF_ADDR(x1, y);
 	int addr0_bit = CALC_BIT_IN_WORD(x0);
 	int addr1_bit = CALC_BIT_IN_WORD(x1);
-	int mask, mask_l, mask_r, i;
+	int mask, mask_l, mask_r;
 	/* If the addresses are equal, we only need to write one word
 	 * which is an island. */
 	if (addr0 == addr1) {
@@ -313,11 +414,8 @@ void write_hline(uint8_t *buff, int x0, int x1, int y, int mode)
 		mask_r = COMPUTE_HLINE_EDGE_R_MASK(addr1_bit);
 		WRITE_WORD_MODE(buff, addr0, mask_l, mode);
 		WRITE_WORD_MODE(buff, addr1, mask_r, mode);
-		// Now write 0xffff words from start+1 to end-1.
-		for (i = addr0 + 1; i <= addr1 - 1; i++) {
-			uint8_t m = 0xff;
-			WRITE_WORD_MODE(buff, i, m, mode);
-		}
+		// Now fill the words from start+1 to end-1.
+		write_span(buff, addr0 + 1, addr1 - 1, mode);
 	}
 }
 #else
@@ -332,13 +430,14 @@ void write_hline(int x0, int x1, int y, uint8_t value)
 	if (x0 == x1) {
 		return;
 	}
+	mark_rows(y, y);
 	/* This is an optimised algorithm for writing horizontal lines.
 	 * We begin by finding the addresses of the x0 and x1 points. */
 	int addr0     = CALC_BUFF_ADDR(x0, y);
 	int addr1     = CALC_BUFF_ADDR(x1, y);
 	int addr0_bit = CALC_BIT1_IN_WORD(x0);
 	int addr1_bit = CALC_BIT0_IN_WORD(x1);
-	int mask, mask_l, mask_r, i;
+	int mask, mask_l, mask_r;
 	/* If the addresses are equal, we only need to write one word
 	 * which is an island. */
 	if (addr0 == addr1) {
@@ -350,11 +449,8 @@ void write_hline(int x0, int x1, int y, uint8_t value)
 		mask_r = COMPUTE_HLINE_EDGE_R_MASK(addr1_bit);
 		WRITE_WORD(draw_buffer, addr0, mask_l, value);
 		WRITE_WORD(draw_buffer, addr1, mask_r, value);
-		// Now write 0xffff words from start+1 to end-1.
-		for (i = addr0 + 1; i <= addr1 - 1; i++) {
-			uint8_t m = 0xff;
-			WRITE_WORD(draw_buffer, i, m, value);
-		}
+		// Now fill the words from start+1 to end-1.
+		write_span(addr0 + 1, addr1 - 1, value);
 	}
 }
 #endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
@@ -432,6 +528,7 @@ void write_vline(uint8_t *buff, int x, int y0, int y1, int mode)
 	if (y0 == y1) {
 		return;
 	}
+	mark_rows(y0, y1);
 	/* This is an optimised algorithm for writing vertical lines.
 	 * We begin by finding the addresses of the x,y0 and x,y1 points. */
 	int addr0  = CALC_BUFF_ADDR(x, y0);
@@ -456,6 +553,7 @@ void write_vline(int x, int y0, int y1, uint8_t value)
 	if (y0 == y1) {
 		return;
 	}
+	mark_rows(y0, y1);
 	/* This is an optimised algorithm for writing vertical lines.
 	 * We begin by finding the addresses of the x,y0 and x,y1 points. */
 	int addr0  = CALC_BUFF_ADDR(x, y0);
@@ -546,13 +644,14 @@ void write_filled_rectangle(uint8_t *buff, int x, int y, int width, int height,
 	if (width <= 0 || height <= 0) {
 		return;
 	}
+	mark_rows(y, y + height - 1);
 	// Calculate as if the rectangle was only a horizontal line. We then
 	// step these addresses through each row until we iterate `height` times.
 	int addr0     = CALC_BUFF_ADDR(x, y);
 	int addr1     = CALC_BUFF_ADDR(x + width, y);
 	int addr0_bit = CALC_BIT_IN_WORD(x);
 	int addr1_bit = CALC_BIT_IN_WORD(x + width);
-	int mask, mask_l, mask_r, i;
+	int mask, mask_l, mask_r;
 	// If the addresses are equal, we need to write one word vertically.
 	if (addr0 == addr1) {
 		mask = COMPUTE_HLINE_ISLAND_MASK(addr0_bit, addr1_bit);
@@ -575,15 +674,12 @@ void write_filled_rectangle(uint8_t *buff, int x, int y, int width, int height,
 			addr1 += BUFFER_WIDTH;
 			yy++;
 		}
-		// Now write 0xffff words from start+1 to end-1 for each row.
+		// Now fill the words from start+1 to end-1 for each row.
 		yy    = 0;
 		addr0 = addr0_old;
 		addr1 = addr1_old;
 		while (yy < height) {
-			for (i = addr0 + 1; i <= addr1 - 1; i++) {
-				uint8_t m = 0xff;
-				WRITE_WORD_MODE(buff, i, m, mode);
-			}
+			write_span(buff, addr0 + 1, addr1 - 1, mode);
 			addr0 += BUFFER_WIDTH;
 			addr1 += BUFFER_WIDTH;
 			yy++;
@@ -600,13 +696,14 @@ void write_filled_rectangle(int x, int y, int width, int height, uint8_t value)
 	if (width <= 0 || height <= 0) {
 		return;
 	}
+	mark_rows(y, y + height - 1);
 	// Calculate as if the rectangle was only a horizontal line. We then
 	// step these addresses through each row until we iterate `height` times.
 	int addr0     = CALC_BUFF_ADDR(x, y);
 	int addr1     = CALC_BUFF_ADDR(x + width, y);
 	int addr0_bit = CALC_BIT_IN_WORD(x);
 	int addr1_bit = CALC_BIT_IN_WORD(x + width);
-	int mask, mask_l, mask_r, i;
+	int mask, mask_l, mask_r;
 	// If the addresses are equal, we need to write one word vertically.
 	if (addr0 == addr1) {
 		mask = COMPUTE_HLINE_ISLAND_MASK(addr0_bit, addr1_bit);
@@ -629,15 +726,12 @@ void write_filled_rectangle(int x, int y, int width, int height, uint8_t value)
 			addr1 += BUFFER_WIDTH;
 			yy++;
 		}
-		// Now write 0xffff words from start+1 to end-1 for each row.
+		// Now fill the words from start+1 to end-1 for each row.
 		yy    = 0;
 		addr0 = addr0_old;
 		addr1 = addr1_old;
 		while (yy < height) {
-			for (i = addr0 + 1; i <= addr1 - 1; i++) {
-				uint8_t m = 0xff;
-				WRITE_WORD(draw_buffer, i, m, value);
-			}
+			write_span(addr0 + 1, addr1 - 1, value);
 			addr0 += BUFFER_WIDTH;
 			addr1 += BUFFER_WIDTH;
 			yy++;
@@ -1224,6 +1318,8 @@ void write_char(uint8_t ch, int x, int y, const struct FontEntry *font_info)
 		return;
 	}
 
+	mark_rows(MAX(y, GRAPHICS_TOP), MIN(y + font_info->height - 1, GRAPHICS_BOTTOM));
+
 	// Compute starting address of character
 	int addr = CALC_BUFF_ADDR(x, y);
 	int wbit = CALC_BIT_IN_WORD(x);
@@ -527,6 +527,12 @@ static int32_t UAVTalkSendHandler(uint8_t * buf, int32_t length)
 /**
  * Transmit data buffer to the com port.
  *
+ * There is no need to gather frames into radio packets here: the radio
+ * sends one packet per time slot, filled with as much of what is queued on
+ * the port as fits, so the frames relayed between two slots already share
+ * a packet and its error correcting code.  Holding frames back for longer
+ * would only leave slots empty.
+ *
  * @param[in] buf Data buffer to send
  * @param[in] length Length of buffer
  * @return -1 on failure
@@ -33,8 +33,8 @@
 #include "pios.h"
 #include "physical_constants.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
 #include "misc_math.h"
+#include "looptrace.h"
 
 #if defined(PIOS_INCLUDE_PX4FLOW)
 #include "pios_px4flow_priv.h"
@@ -92,7 +92,9 @@ static void update_rangefinder(struct pios_sensor_rangefinder_data *rangefinder)
 static void mag_calibration_prelemari(MagnetometerData *mag);
 static void mag_calibration_fix_length(MagnetometerData *mag);
 
-static void updateTemperatureComp(float temperature, float *temp_bias);
+static bool updateTemperatureComp(float temperature, float *temp_bias);
+static void updateGyroFused(void);
+static void gyrosBiasUpdatedCb(UAVObjEvent * objEv, void *ctx, void *obj, int len);
 
 // Private variables
 static struct pios_thread *sensorsTaskHandle;
@@ -118,6 +120,10 @@ static float gyro_temp_bias[3] = {0,0,0};
 static float z_accel_offset = 0;
 static float Rsb[3][3] = {{0}}; //! Rotation matrix that transforms from the body frame to the sensor board frame
 static int8_t rotate = 0;
+static float gyro_fused[3][3] = {{0}}; //! Gyro scale and board rotation, applied as one matrix
+static float gyro_temp_offset[3] = {0,0,0}; //! Temperature bias in the body frame
+static float gyro_bias[3] = {0,0,0}; //! Copy of GyrosBias, refreshed when the state estimator sets it
+static volatile bool gyro_bias_updated = true;
 
 //! Select the algorithm to try and null out the magnetometer bias error
 static enum mag_calibration_algo mag_calibration_algo = MAG_CALIBRATION_PRELEMARI;
@@ -191,6 +197,7 @@ int32_t SensorsInitialize(void)
 	AttitudeSettingsConnectCallback(&settingsUpdatedCb);
 	SensorSettingsConnectCallback(&settingsUpdatedCb);
 	INSSettingsConnectCallback(&settingsUpdatedCb);
+	GyrosBiasConnectCallback(&gyrosBiasUpdatedCb);
 
 	return 0;
 }
@@ -227,6 +234,7 @@ static void SensorsTask(void *parameters)
 
 	UAVObjEvent ev;
 	settingsUpdatedCb(&ev, NULL, NULL, 0);
+	gyrosBiasUpdatedCb(&ev, NULL, NULL, 0);
 
 	// Main task loop
 	lastSysTime = PIOS_Thread_Systime();
@@ -241,23 +249,23 @@ static void SensorsTask(void *parameters)
 			PIOS_Thread_Sleep_Until(&lastSysTime, SENSOR_PERIOD);
 		}
 
-		struct pios_sensor_gyro_data gyros;
+		struct pios_sensor_gyro_data *gyros;
 		struct pios_sensor_accel_data accels;
 		struct pios_sensor_mag_data mags;
 		struct pios_sensor_baro_data baro;
 
 		uint32_t timeval = PIOS_DELAY_GetRaw();
 
-		//Block on gyro data but nothing else
-		struct pios_queue *queue;
-		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_GYRO);
-		if (queue == NULL || PIOS_Queue_Receive(queue, &gyros, SENSOR_PERIOD) == false) {
+		//Block on gyro data but nothing else; it is used in place
+		gyros = PIOS_SENSORS_PeekData(PIOS_SENSOR_GYRO, NULL, SENSOR_PERIOD);
+		if (gyros == NULL) {
 			good_runs = 0;
 			continue;
 		}
 
-		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_ACCEL);
-		if (queue == NULL || PIOS_Queue_Receive(queue, &accels, 0) == false) {
+		looptrace_begin(LOOPTRACE_SENSORS);
+
+		if (!PIOS_SENSORS_GetData(PIOS_SENSOR_ACCEL, &accels, 0)) {
 			//If no new accels data is ready, reuse the latest sample
 			AccelsSet(&accelsData);
 		}
@@ -266,12 +274,12 @@ static void SensorsTask(void *parameters)
 
 		// Update gyros after the accels since the rest of the code expects
 		// the accels to be available first
-		update_gyros(&gyros);
+		update_gyros(gyros);
+		PIOS_SENSORS_ReleaseData(PIOS_SENSOR_GYRO, 1);
 
 		bool test_good_run = good_runs > REQUIRED_GOOD_CYCLES;
 
-		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_MAG);
-		if (queue != NULL && PIOS_Queue_Receive(queue, &mags, 0) != false) {
+		if (PIOS_SENSORS_GetData(PIOS_SENSOR_MAG, &mags, 0)) {
 			update_mags(&mags);
 #ifdef PIOS_TOLERATE_MISSING_SENSORS
 		} else if (test_good_run) {
@@ -285,9 +293,8 @@ static void SensorsTask(void *parameters)
 #endif
 		}
 
-		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_BARO);
-		if (queue != NULL) {
-			if (PIOS_Queue_Receive(queue, &baro, 0) != false) {
+		if (PIOS_SENSORS_IsRegistered(PIOS_SENSOR_BARO)) {
+			if (PIOS_SENSORS_GetData(PIOS_SENSOR_BARO, &baro, 0)) {
 				// we can use the timeval because it contains the current time stamp (PIOS_DELAY_GetRaw())
 				last_baro_update_time = timeval;
 				update_baro(&baro);
@@ -315,16 +322,14 @@ static void SensorsTask(void *parameters)
 
 #if defined(PIOS_INCLUDE_OPTICALFLOW)
 		struct pios_sensor_optical_flow_data optical_flow;
-		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_OPTICAL_FLOW);
-		if (queue != NULL && PIOS_Queue_Receive(queue, &optical_flow, 0) != false) {
+		if (PIOS_SENSORS_GetData(PIOS_SENSOR_OPTICAL_FLOW, &optical_flow, 0)) {
 			update_optical_flow(&optical_flow);
 		}
 #endif /* PIOS_INCLUDE_OPTICALFLOW */
 
 #if defined(PIOS_INCLUDE_RANGEFINDER)
 		struct pios_sensor_rangefinder_data rangefinder;
-		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_RANGEFINDER);
-		if (queue != NULL && PIOS_Queue_Receive(queue, &rangefinder, 0) != false) {
+		if (PIOS_SENSORS_GetData(PIOS_SENSOR_RANGEFINDER, &rangefinder, 0)) {
 			update_rangefinder(&rangefinder);
 		}
 #endif /* PIOS_INCLUDE_RANGEFINDER */
@@ -381,56 +386,48 @@ static void update_accels(struct pios_sensor_accel_data *accels)
  */
 static void update_gyros(struct pios_sensor_gyro_data *gyros)
 {
-	// Scale the gyros
-	float gyros_out[3] = {
-	    gyros->x * gyro_scale[0],
-	    gyros->y * gyro_scale[1],
-	    gyros->z * gyro_scale[2]
-	};
+	const float gyros_raw[3] = {gyros->x, gyros->y, gyros->z};
+	float gyros_out[3];
+
+	// Scale and rotate in one go
+	rot_mult(gyro_fused, gyros_raw, gyros_out, false);
 
 	GyrosData gyrosData;
 	gyrosData.temperature = gyros->temperature;
 
 	// Update the bias due to the temperature
-	updateTemperatureComp(gyrosData.temperature, gyro_temp_bias);
+	if (updateTemperatureComp(gyrosData.temperature, gyro_temp_bias))
+		updateGyroFused();
 
-	// Apply temperature bias correction before the rotation
-	if (bias_correct_gyro) {
-		gyros_out[0] -= gyro_temp_bias[0];
-		gyros_out[1] -= gyro_temp_bias[1];
-		gyros_out[2] -= gyro_temp_bias[2];
-	}
-
-	if (rotate) {
-		float gyros[3];
-		rot_mult(Rsb, gyros_out, gyros, true);
-		gyrosData.x = gyros[0];
-		gyrosData.y = gyros[1];
-		gyrosData.z = gyros[2];
-	} else {
-		gyrosData.x = gyros_out[0];
-		gyrosData.y = gyros_out[1];
-		gyrosData.z = gyros_out[2];
-	}
+	gyrosData.x = gyros_out[0];
+	gyrosData.y = gyros_out[1];
+	gyrosData.z = gyros_out[2];
 
 	if (bias_correct_gyro) {
-		// Apply bias correction to the gyros from the state estimator
-		GyrosBiasData gyrosBias;
-		GyrosBiasGet(&gyrosBias);
-		gyrosData.x -= gyrosBias.x;
-		gyrosData.y -= gyrosBias.y;
-		gyrosData.z -= gyrosBias.z;
-
-		const float GYRO_BIAS_WARN = 10.0f;
-		if (fabsf(gyrosBias.x) > GYRO_BIAS_WARN ||
-			fabsf(gyrosBias.y) > GYRO_BIAS_WARN ||
-			fabsf(gyrosBias.z) > GYRO_BIAS_WARN) {
-			AlarmsSet(SYSTEMALARMS_ALARM_GYROBIAS, SYSTEMALARMS_ALARM_WARNING);
-		} else {
-			AlarmsClear(SYSTEMALARMS_ALARM_GYROBIAS);
+		// Apply the temperature bias correction, and the bias
+		// correction from the state estimator
+		gyrosData.x -= gyro_temp_offset[0] + gyro_bias[0];
+		gyrosData.y -= gyro_temp_offset[1] + gyro_bias[1];
+		gyrosData.z -= gyro_temp_offset[2] + gyro_bias[2];
+
+		// The alarm only changes with the bias
+		if (gyro_bias_updated) {
+			gyro_bias_updated = false;
+
+			const float GYRO_BIAS_WARN = 10.0f;
+			if (fabsf(gyro_bias[0]) > GYRO_BIAS_WARN ||
+				fabsf(gyro_bias[1]) > GYRO_BIAS_WARN ||
+				fabsf(gyro_bias[2]) > GYRO_BIAS_WARN) {
+				AlarmsSet(SYSTEMALARMS_ALARM_GYROBIAS, SYSTEMALARMS_ALARM_WARNING);
+			} else {
+				AlarmsClear(SYSTEMALARMS_ALARM_GYROBIAS);
+			}
 		}
 	}
 
+	// Before the set, which wakes stabilization
+	looptrace_end(LOOPTRACE_SENSORS);
+
 	GyrosSet(&gyrosData);
 }
 
@@ -544,8 +541,9 @@ static void update_rangefinder(struct pios_sensor_rangefinder_data *rangefinder)
 /**
  * Compute the bias expected from temperature variation for each gyro
  * channel
+ * \return true when temp_bias was recomputed
  */
-static void updateTemperatureComp(float temperature, float *temp_bias)
+static bool updateTemperatureComp(float temperature, float *temp_bias)
 {
 	static int temp_counter = -1;
 	static float temp_accum = 0;
@@ -572,9 +570,54 @@ static void updateTemperatureComp(float temperature, float *temp_bias)
 		               gyro_coeff_y[2] * powf(t,2) + gyro_coeff_y[3] * powf(t,3);
 		temp_bias[2] = gyro_coeff_z[0] + gyro_coeff_z[1] * t + 
 		               gyro_coeff_z[2] * powf(t,2) + gyro_coeff_z[3] * powf(t,3);
+
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * Fold the gyro scale into the board rotation, and rotate the temperature
+ * bias along, so a sample only takes one matrix multiply
+ */
+static void updateGyroFused(void)
+{
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			if (rotate)
+				gyro_fused[i][j] = Rsb[j][i] * gyro_scale[j];
+			else
+				gyro_fused[i][j] = (i == j) ? gyro_scale[j] : 0;
+		}
+	}
+
+	if (rotate) {
+		rot_mult(Rsb, gyro_temp_bias, gyro_temp_offset, true);
+	} else {
+		gyro_temp_offset[0] = gyro_temp_bias[0];
+		gyro_temp_offset[1] = gyro_temp_bias[1];
+		gyro_temp_offset[2] = gyro_temp_bias[2];
 	}
 }
 
+/**
+ * Keep a copy of the gyro bias, rather than getting it on every sample
+ */
+static void gyrosBiasUpdatedCb(UAVObjEvent * objEv, void *ctx, void *obj, int len)
+{
+	(void) objEv; (void) ctx; (void) obj; (void) len;
+
+	GyrosBiasData gyrosBias;
+	GyrosBiasGet(&gyrosBias);
+
+	gyro_bias[0] = gyrosBias.x;
+	gyro_bias[1] = gyrosBias.y;
+	gyro_bias[2] = gyrosBias.z;
+
+	gyro_bias_updated = true;
+}
+
 /**
  * Perform an update of the @ref MagBias based on
  * Magnetometer Offset Cancellation: Theory and Implementation, 
@@ -758,6 +801,7 @@ static void settingsUpdatedCb(UAVObjEvent * objEv, void *ctx, void *obj, int len
 		rotate = 1;
 	}
 
+	updateGyroFused();
 }
 /**
   * @}
@@ -110,10 +110,10 @@ static int32_t SimSensorsInitialize(void)
 	// Register fake address.  Later if we really fake entire sensors then
 	// it will make sense to have real queues registered.  For now if these
 	// queues are used a crash is appropriate.
-	PIOS_SENSORS_Register(PIOS_SENSOR_ACCEL, (struct pios_queue*)1);
-	PIOS_SENSORS_Register(PIOS_SENSOR_GYRO, (struct pios_queue*)1);
-	PIOS_SENSORS_Register(PIOS_SENSOR_MAG, (struct pios_queue*)1);
-	PIOS_SENSORS_Register(PIOS_SENSOR_BARO, (struct pios_queue*)1);
+	PIOS_SENSORS_Register(PIOS_SENSOR_ACCEL, (struct pios_sensors_queue*)1);
+	PIOS_SENSORS_Register(PIOS_SENSOR_GYRO, (struct pios_sensors_queue*)1);
+	PIOS_SENSORS_Register(PIOS_SENSOR_MAG, (struct pios_sensors_queue*)1);
+	PIOS_SENSORS_Register(PIOS_SENSOR_BARO, (struct pios_sensors_queue*)1);
 
 	PIOS_SENSORS_SetSampleRate(PIOS_SENSOR_ACCEL, 500);
 	PIOS_SENSORS_SetSampleRate(PIOS_SENSOR_GYRO, 500);
@@ -0,0 +1,335 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup StabilizationModule Stabilization Module
+ * @{
+ *
+ * @file       dynamicnotch.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Notch filters on the gyro that follow the strongest vibration
+ *
+ * The spectrum of the roll and pitch gyros is estimated with a bank of
+ * Goertzel filters spread over the configured range, each fed every sample
+ * so the cost is the same every loop.  At the end of every block the
+ * strongest peaks decide where the notches sit.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "openpilot.h"
+#include "physical_constants.h"
+#include "misc_math.h"
+#include "stabilization.h"
+#include "dynamicnotch.h"
+
+//! Private constants
+#define BINS 24
+#define TRACKED_AXES 2			// roll and pitch; yaw sees the same motors
+#define BLOCK_MIN 32
+#define BLOCK_MAX 512
+#define PEAK_RATIO 10.0f			// times the median power to count as a peak
+#define CENTER_SMOOTH 0.5f		// weight of a new peak against the old center
+
+struct notch_state {
+	float x1, x2;
+	float y1, y2;
+};
+
+struct dynamic_notch {
+	float dT;
+	float q;
+	uint8_t count;
+	bool primed;
+
+	uint16_t block_len;
+	uint16_t block_pos;
+
+	float bin_spacing;
+	float bin_hz[BINS];
+	float bin_coeff[BINS];
+	float bin_weight[BINS];
+
+	float s1[TRACKED_AXES][BINS];
+	float s2[TRACKED_AXES][BINS];
+	float last[TRACKED_AXES];
+
+	// Kept here rather than on the small stabilization stack
+	float power[BINS];
+	float sorted[BINS];
+
+	bool tracking[DYNAMIC_NOTCH_MAX];
+	float center[DYNAMIC_NOTCH_MAX];
+	float b0[DYNAMIC_NOTCH_MAX];
+	float a1[DYNAMIC_NOTCH_MAX];
+	float a2[DYNAMIC_NOTCH_MAX];
+	struct notch_state state[DYNAMIC_NOTCH_MAX][MAX_AXES];
+};
+
+//! Private variables
+static struct dynamic_notch *dn;
+
+//! Private methods
+static void set_center(uint8_t n, float hz);
+static void track_peaks(void);
+
+/**
+ * Set up the notches, or turn them off with a count of zero.  Only called
+ * from the stabilization task, which is also the one filtering.
+ * \param[in] dT the gyro sample period
+ * \param[in] count how many peaks to follow, up to DYNAMIC_NOTCH_MAX
+ * \param[in] min_hz lowest frequency searched
+ * \param[in] max_hz highest frequency searched, at most 0.45 of the rate
+ * \param[in] q quality of each notch; higher is narrower
+ */
+void dynamic_notch_configure(float dT, uint8_t count, float min_hz,
+		float max_hz, float q)
+{
+	count = MIN(count, DYNAMIC_NOTCH_MAX);
+	max_hz = MIN(max_hz, 0.45f / dT);
+
+	if (min_hz < 1.0f || max_hz <= min_hz || q < 0.1f) {
+		count = 0;
+	}
+
+	if (!count) {
+		if (dn) {
+			dn->count = 0;
+		}
+
+		return;
+	}
+
+	if (!dn) {
+		dn = PIOS_malloc(sizeof(*dn));
+
+		if (!dn) {
+			return;
+		}
+	}
+
+	memset(dn, 0, sizeof(*dn));
+
+	dn->dT = dT;
+	dn->q = q;
+	dn->count = count;
+
+	// A block about as long as it takes to tell neighbouring bins apart
+	dn->bin_spacing = (max_hz - min_hz) / (BINS - 1);
+	dn->block_len = bound_min_max(1.0f / (dn->bin_spacing * dT),
+			BLOCK_MIN, BLOCK_MAX);
+
+	for (int k = 0; k < BINS; k++) {
+		float hz = min_hz + k * dn->bin_spacing;
+		float w = 2.0f * (float)(M_PI) * hz * dT;
+		float diff_gain = 2.0f * sinf(w / 2);
+
+		dn->bin_hz[k] = hz;
+		dn->bin_coeff[k] = 2.0f * cosf(w);
+
+		// The input is differenced to drop the DC; undo its slope
+		dn->bin_weight[k] = 1.0f / (diff_gain * diff_gain);
+	}
+}
+
+/**
+ * Follow the vibration and notch it out of the gyro, in place
+ * \param[in,out] gyro rates of each axis
+ */
+void dynamic_notch_apply(float gyro[3])
+{
+	if (!dn || !dn->count) {
+		return;
+	}
+
+	if (dn->primed) {
+		for (int a = 0; a < TRACKED_AXES; a++) {
+			float x = gyro[a] - dn->last[a];
+			float *s1 = dn->s1[a];
+			float *s2 = dn->s2[a];
+
+			for (int k = 0; k < BINS; k++) {
+				float s0 = x + dn->bin_coeff[k] * s1[k] - s2[k];
+				s2[k] = s1[k];
+				s1[k] = s0;
+			}
+		}
+
+		if (++dn->block_pos >= dn->block_len) {
+			dn->block_pos = 0;
+			track_peaks();
+		}
+	}
+
+	for (int a = 0; a < TRACKED_AXES; a++) {
+		dn->last[a] = gyro[a];
+	}
+	dn->primed = true;
+
+	for (int n = 0; n < dn->count; n++) {
+		if (!dn->tracking[n]) {
+			continue;
+		}
+
+		for (int a = 0; a < MAX_AXES; a++) {
+			struct notch_state *st = &dn->state[n][a];
+			float x = gyro[a];
+			float y = dn->b0[n] * (x + st->x2) +
+				dn->a1[n] * (st->x1 - st->y1) -
+				dn->a2[n] * st->y2;
+
+			st->x2 = st->x1;
+			st->x1 = x;
+			st->y2 = st->y1;
+			st->y1 = y;
+
+			gyro[a] = y;
+		}
+	}
+}
+
+/**
+ * Move a notch, computing the coefficients of its biquad
+ * \param[in] n which notch
+ * \param[in] hz the new center frequency
+ */
+static void set_center(uint8_t n, float hz)
+{
+	float w = 2.0f * (float)(M_PI) * hz * dn->dT;
+	float alpha = sinf(w) / (2.0f * dn->q);
+	float a0 = 1.0f + alpha;
+
+	dn->center[n] = hz;
+	dn->b0[n] = 1.0f / a0;
+	dn->a1[n] = -2.0f * cosf(w) / a0;	// b1 is the same
+	dn->a2[n] = (1.0f - alpha) / a0;
+}
+
+/**
+ * Read out the filter bank at the end of a block and move the notches
+ * onto the strongest peaks in it
+ */
+static void track_peaks(void)
+{
+	float *power = dn->power;
+	float *sorted = dn->sorted;
+
+	for (int k = 0; k < BINS; k++) {
+		float c = dn->bin_coeff[k];
+		float p = 0;
+
+		for (int a = 0; a < TRACKED_AXES; a++) {
+			float s1 = dn->s1[a][k];
+			float s2 = dn->s2[a][k];
+
+			p += s1 * s1 + s2 * s2 - c * s1 * s2;
+
+			dn->s1[a][k] = 0;
+			dn->s2[a][k] = 0;
+		}
+
+		power[k] = p * dn->bin_weight[k];
+
+		// Insertion sort for the median; a strong peak would drag a
+		// mean up over weaker peaks beside it
+		int j = k;
+		while (j > 0 && sorted[j - 1] > power[k]) {
+			sorted[j] = sorted[j - 1];
+			j--;
+		}
+		sorted[j] = power[k];
+	}
+
+	float threshold = PEAK_RATIO * sorted[BINS / 2];
+
+	// The strongest local maxima, strongest first
+	float peak_hz[DYNAMIC_NOTCH_MAX];
+	float peak_power[DYNAMIC_NOTCH_MAX];
+	uint8_t found = 0;
+
+	for (int k = 0; k < BINS; k++) {
+		float p = power[k];
+		float left = (k > 0) ? power[k - 1] : 0;
+		float right = (k < BINS - 1) ? power[k + 1] : 0;
+
+		if (p <= threshold || p < left || p <= right) {
+			continue;
+		}
+
+		// Fit a parabola through the peak and its neighbours
+		float delta = 0;
+		float denom = left - 2 * p + right;
+
+		if (k > 0 && k < BINS - 1 && denom < 0) {
+			delta = bound_sym(0.5f * (left - right) / denom, 0.5f);
+		}
+
+		int slot = found;
+		while (slot > 0 && peak_power[slot - 1] < p) {
+			if (slot < dn->count) {
+				peak_hz[slot] = peak_hz[slot - 1];
+				peak_power[slot] = peak_power[slot - 1];
+			}
+			slot--;
+		}
+
+		if (slot < dn->count) {
+			peak_hz[slot] = dn->bin_hz[k] + delta * dn->bin_spacing;
+			peak_power[slot] = p;
+			found = MIN(found + 1, dn->count);
+		}
+	}
+
+	// Each peak moves the closest notch already following one, so two
+	// notches don't swap places when the peaks trade strength
+	bool taken[DYNAMIC_NOTCH_MAX] = { false };
+
+	for (int i = 0; i < found; i++) {
+		int best = -1;
+		float best_dist = 0;
+
+		for (int n = 0; n < dn->count; n++) {
+			if (taken[n]) {
+				continue;
+			}
+
+			float dist = dn->tracking[n] ?
+				fabsf(dn->center[n] - peak_hz[i]) : INFINITY;
+
+			if (best < 0 || dist < best_dist) {
+				best = n;
+				best_dist = dist;
+			}
+		}
+
+		taken[best] = true;
+
+		if (dn->tracking[best]) {
+			set_center(best, dn->center[best] +
+					CENTER_SMOOTH * (peak_hz[i] - dn->center[best]));
+		} else {
+			set_center(best, peak_hz[i]);
+			dn->tracking[best] = true;
+		}
+	}
+}
+
+/**
+ * @}
+ * @}
+ */
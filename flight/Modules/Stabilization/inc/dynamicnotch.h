@@ -0,0 +1,47 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup StabilizationModule Stabilization Module
+ * @{
+ *
+ * @file       dynamicnotch.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Notch filters on the gyro that follow the strongest vibration
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef DYNAMICNOTCH_H
+#define DYNAMICNOTCH_H
+
+#include "openpilot.h"
+
+//! Most notches that can follow peaks at once
+#define DYNAMIC_NOTCH_MAX 2
+
+void dynamic_notch_configure(float dT, uint8_t count, float min_hz,
+		float max_hz, float q);
+void dynamic_notch_apply(float gyro[3]);
+
+#endif /* DYNAMICNOTCH_H */
+
+/**
+ * @}
+ * @}
+ */
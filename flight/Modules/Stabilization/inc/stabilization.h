@@ -32,9 +32,17 @@
 #ifndef STABILIZATION_H
 #define STABILIZATION_H
 
+#include "gyros.h"
+#include "actuatordesired.h"
+
 enum {ROLL,PITCH,YAW,MAX_AXES};
 
+//! Takes the gyro sample and command of each loop, in the stabilization task
+typedef void (*stabilization_ident_sink_t)(const GyrosData *gyros,
+		const ActuatorDesiredData *desired);
+
 int32_t StabilizationInitialize();
+void StabilizationConnectIdent(stabilization_ident_sink_t sink);
 
 #endif /* STABILIZATION_H */
 
@@ -68,6 +68,13 @@
 
 // Includes for various stabilization algorithms
 #include "virtualflybar.h"
+#include "dynamicnotch.h"
+#include "actuator.h"
+#include "looptrace.h"
+
+#if defined(PIOS_INCLUDE_LOG_TO_FLASH)
+#include "logging.h"
+#endif
 
 // Private constants
 #define MAX_QUEUE_SIZE 1
@@ -75,7 +82,7 @@
 #if defined(PIOS_STABILIZATION_STACK_SIZE)
 #define STACK_SIZE_BYTES PIOS_STABILIZATION_STACK_SIZE
 #else
-#define STACK_SIZE_BYTES 860
+#define STACK_SIZE_BYTES 1000	// room to run the mixer, see ActuatorDirectUpdate()
 #endif
 
 #define TASK_PRIORITY PIOS_THREAD_PRIO_HIGHEST
@@ -114,6 +121,7 @@ static SubTrimData subTrim;
 static struct pios_queue *queue;
 
 uint16_t ident_wiggle_points;
+static volatile stabilization_ident_sink_t ident_sink;
 
 float axis_lock_accum[3] = {0,0,0};
 uint8_t max_axis_lock = 0;
@@ -125,7 +133,7 @@ float vbar_decay = 0.991f;
 float gyro_alpha = 0.6f;
 static float max_rate_alpha = 0.8f;
 
-struct pid pids[PID_MAX];
+PIOS_FAST_DATA struct pid pids[PID_MAX];
 
 #ifndef NO_CONTROL_DEADBANDS
 struct pid_deadband *deadbands = NULL;
@@ -134,9 +142,10 @@ struct pid_deadband *deadbands = NULL;
 volatile bool gyro_filter_updated = true; 
 
 static bool actuatorDesiredUpdated = true;
-static bool flightStatusUpdated = true;
 static bool systemSettingsUpdated = true;
 
+static struct uavo_snapshot flight_status_snap;
+
 // Private functions
 static void stabilizationTask(void* parameters);
 static void zero_pids(void);
@@ -171,7 +180,7 @@ int32_t StabilizationStart()
 
 	// Listen for updates.
 	//	AttitudeActualConnectQueue(queue);
-	GyrosConnectQueue(queue);
+	GyrosConnectQueueCoalesced(queue);
 
 	// Connect settings callback
 	StabilizationSettingsConnectCallback(SettingsUpdatedCb);
@@ -212,6 +221,19 @@ int32_t StabilizationInitialize()
 	return 0;
 }
 
+/**
+ * @brief Have each loop's gyro sample and command passed to a function
+ *
+ * It is called from the stabilization task right after the outputs are
+ * driven, so it must be quick and must not block; system identification
+ * uses it to queue its samples without the UAVO callback and locks.
+ * @param[in] sink the function, or NULL to stop
+ */
+void StabilizationConnectIdent(stabilization_ident_sink_t sink)
+{
+	ident_sink = sink;
+}
+
 
 MODULE_HIPRI_INITCALL(StabilizationInitialize, StabilizationStart);
 
@@ -229,7 +251,6 @@ static void stabilizationTask(void* parameters)
 	RateDesiredData rateDesired;
 	AttitudeActualData attitudeActual;
 	GyrosData gyrosData;
-	FlightStatusData flightStatus;
 	SystemSettingsAirframeTypeOptions airframe_type;
 
 	float *stabDesiredAxis = &stabDesired.Roll;
@@ -239,7 +260,8 @@ static void stabilizationTask(void* parameters)
 
 	// Connect callbacks
 	ActuatorDesiredConnectCallbackCtx(UAVObjCbSetFlag, &actuatorDesiredUpdated);
-	FlightStatusConnectCallbackCtx(UAVObjCbSetFlag, &flightStatusUpdated);
+	int32_t snap_ret = FlightStatusConnectSnapshot(&flight_status_snap);
+	PIOS_Assert(snap_ret == 0);
 	SystemSettingsConnectCallbackCtx(UAVObjCbSetFlag, &systemSettingsUpdated);
 
 	// Force refresh of all settings immediately before entering main task loop
@@ -289,12 +311,14 @@ static void stabilizationTask(void* parameters)
 		PIOS_WDG_UpdateFlag(PIOS_WDG_STABILIZATION);
 
 		// Wait until the AttitudeRaw object is updated, if a timeout then go to failsafe
-		if (PIOS_Queue_Receive(queue, &ev, FAILSAFE_TIMEOUT_MS) != true)
+		if (UAVObjQueueReceive(queue, &ev, FAILSAFE_TIMEOUT_MS) != true)
 		{
 			AlarmsSet(SYSTEMALARMS_ALARM_STABILIZATION,SYSTEMALARMS_ALARM_WARNING);
 			continue;
 		}
 
+		looptrace_begin(LOOPTRACE_STABILIZATION);
+
 		static bool frequency_wrong = false;
 
 		float dT = PIOS_DELAY_DiffuS(timeval) * 1.0e-6f;
@@ -340,6 +364,12 @@ static void stabilizationTask(void* parameters)
 				vbar_decay = expf(-dT_expected / vbar_settings.VbarTau);
 			}
 
+			dynamic_notch_configure(dT_expected,
+					settings.DynamicNotchCount,
+					settings.DynamicNotchRange[STABILIZATIONSETTINGS_DYNAMICNOTCHRANGE_MIN],
+					settings.DynamicNotchRange[STABILIZATIONSETTINGS_DYNAMICNOTCHRANGE_MAX],
+					settings.DynamicNotchQ);
+
 			gyro_filter_updated = false;
 		}
 
@@ -348,16 +378,14 @@ static void stabilizationTask(void* parameters)
 			actuatorDesiredUpdated = false;
 		}
 
-		if (flightStatusUpdated) {
-			FlightStatusGet(&flightStatus);
-			flightStatusUpdated = false;
-		}
-
 		if (systemSettingsUpdated) {
 			SystemSettingsAirframeTypeGet(&airframe_type);
 			systemSettingsUpdated = false;
 		}
 
+		const FlightStatusData *flightStatus =
+			FlightStatusSnapshotRead(&flight_status_snap);
+
 		StabilizationDesiredGet(&stabDesired);
 		AttitudeActualGet(&attitudeActual);
 		GyrosGet(&gyrosData);
@@ -471,9 +499,12 @@ static void stabilizationTask(void* parameters)
 
 		static float gyro_filtered[3];
 
-		gyro_filtered[0] = gyro_filtered[0] * gyro_alpha + gyrosData.x * (1 - gyro_alpha);
-		gyro_filtered[1] = gyro_filtered[1] * gyro_alpha + gyrosData.y * (1 - gyro_alpha);
-		gyro_filtered[2] = gyro_filtered[2] * gyro_alpha + gyrosData.z * (1 - gyro_alpha);
+		float gyro_notched[3] = { gyrosData.x, gyrosData.y, gyrosData.z };
+		dynamic_notch_apply(gyro_notched);
+
+		gyro_filtered[0] = gyro_filtered[0] * gyro_alpha + gyro_notched[0] * (1 - gyro_alpha);
+		gyro_filtered[1] = gyro_filtered[1] * gyro_alpha + gyro_notched[1] * (1 - gyro_alpha);
+		gyro_filtered[2] = gyro_filtered[2] * gyro_alpha + gyro_notched[2] * (1 - gyro_alpha);
 
 		/* Maintain a second-order, lower cutof freq variant for
 		 * dynamic flight modes.
@@ -974,6 +1005,18 @@ static void stabilizationTask(void* parameters)
 		if (vbar_settings.VbarPiroComp == VBARSETTINGS_VBARPIROCOMP_TRUE)
 			stabilization_virtual_flybar_pirocomp(gyro_filtered[2], dT_expected);
 
+		looptrace_end(LOOPTRACE_STABILIZATION);
+
+		// Drive the outputs before anything else, if allowed to; the
+		// objects after are then only for telemetry and the failsafe
+		ActuatorDirectUpdate(&actuatorDesired);
+
+		// Then hand the loop straight to system identification
+		stabilization_ident_sink_t sink = ident_sink;
+		if (sink) {
+			sink(&gyrosData, &actuatorDesired);
+		}
+
 #if defined(RATEDESIRED_DIAGNOSTICS)
 		RateDesiredSet(&rateDesired);
 #endif
@@ -981,11 +1024,32 @@ static void stabilizationTask(void* parameters)
 		// Save dT
 		actuatorDesired.UpdateTime = dT * 1000;
 
+#if defined(PIOS_INCLUDE_LOG_TO_FLASH)
+		if (LoggingBlackboxDue()) {
+			static struct logging_blackbox_sample sample;
+
+			for (uint8_t i = 0; i < 3; i++) {
+				struct pid *pid = &pids[PID_GROUP_RATE + i];
+
+				sample.gyro[i] = gyro_filtered[i];
+				sample.setpoint[i] = rateDesiredAxis[i];
+				sample.pid_p[i] = pid->p * pid->lastErr;
+				sample.pid_i[i] = pid->iAccumulator;
+				sample.pid_d[i] = pid->lastDer;
+			}
+
+			for (uint8_t i = 0; i < 4; i++)
+				sample.actuator[i] = actuatorDesiredAxis[i];
+
+			LoggingBlackboxSample(&sample);
+		}
+#endif
+
 		ActuatorDesiredSet(&actuatorDesired);
 		// So we only fetch it above if it is modified by another module (wacky)
 		actuatorDesiredUpdated = false;
 
-		if(flightStatus.Armed != FLIGHTSTATUS_ARMED_ARMED ||
+		if(flightStatus->Armed != FLIGHTSTATUS_ARMED_ARMED ||
 		   (lowThrottleZeroIntegral && get_throttle(&stabDesired, &airframe_type) < 0))
 		{
 			// Force all axes to reinitialize when engaged
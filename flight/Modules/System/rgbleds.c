@@ -411,6 +411,7 @@ void systemmod_process_rgb_leds(bool led_override, bool led_override_active,
 					rgbSettings.RangeBaseColor[2],
 					rgbSettings.RangeEndColor[2],
 					fraction);
+			break;
 		case RGBLEDSETTINGS_RANGECOLORBLENDTYPE_LINEARINHSV:
 			interp_in_hsv(false, rgbSettings.RangeBaseColor,
 					rgbSettings.RangeEndColor,
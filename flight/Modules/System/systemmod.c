@@ -37,6 +37,8 @@
 #include "sanitycheck.h"
 #include "taskinfo.h"
 #include "taskmonitor.h"
+#include "looptrace.h"
+#include "cpuaccount.h"
 #include "pios_thread.h"
 #include "pios_mutex.h"
 #include "pios_queue.h"
@@ -53,6 +55,13 @@
 #include "systemsettings.h"
 #include "systemstats.h"
 #include "watchdogstatus.h"
+#if defined(PIOS_INCLUDE_HEAP_POOLS)
+#include "heappools.h"
+#endif
+#if defined(PIOS_INCLUDE_SPI) && !defined(SMALLF1)
+#define SPI_BUS_STATS
+#include "spibusstats.h"
+#endif
 
 #ifdef SYSTEMMOD_RGBLED_SUPPORT
 #include "rgbledsettings.h"
@@ -102,6 +111,17 @@ extern annuncdac_dev_t pios_dac_annunciator_id;
 
 #endif
 
+/* A burst of settings writes, like the GCS uploading a configuration, is
+ * checked once it has settled for this long, but no later than the max
+ * after the first write.  Flight status changes are checked at once. */
+#define CONFIG_CHECK_SETTLE_MS 250
+#define CONFIG_CHECK_MAX_DELAY_MS 1000
+
+/* Saves asked for by the GCS are written once they stop coming for this
+ * long, and never while armed.  Programming the internal flash stalls the
+ * CPU, and a whole configuration comes as a burst of saves. */
+#define SETTINGS_FLUSH_DELAY_MS 500
+
 // Private types
 
 /**
@@ -119,15 +139,31 @@ typedef struct {
 struct PeriodicObjectListStruct {
 	EventCallbackInfo evInfo; /** Event callback information */
 	uint16_t updatePeriodMs; /** Update period in ms or 0 if no periodic updates are needed */
-	int32_t timeToNextUpdateMs; /** Time delay to the next update */
+	uint8_t wheelSlot; /** Slot of the timer wheel the entry waits in, or WHEEL_NONE */
+	bool rephased; /** Backdated to randomize the phase, so not late */
+	uint32_t nextUpdateMs; /** System time of the next update */
+	struct PeriodicObjectListStruct* wheelNext; /** Next entry in the same wheel slot */
 	struct PeriodicObjectListStruct* next; /** Needed by linked list library (utlist.h) */
 };
 typedef struct PeriodicObjectListStruct PeriodicObjectList;
 
+/* The entries with a period wait on a hashed timer wheel, in the slot of
+ * the millisecond they are due, and each slot is kept sorted by deadline.
+ * Entries due a revolution or more ahead share slots with the nearer ones
+ * and stay behind them until their turn comes. */
+#define WHEEL_SLOTS 64	// power of two, at most 255
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_NONE 0xFF
+
+// Dispatches later than this count in the SystemStats late statistics
+#define LATE_DISPATCH_MS 5
+
 // Private types
 
 // Private variables
 static PeriodicObjectList* objList;
+static PeriodicObjectList* wheel[WHEEL_SLOTS];
+static uint32_t wheelTime;	// everything due before this was dispatched
 static struct pios_recursive_mutex *mutex;
 static EventStats stats;
 
@@ -135,18 +171,28 @@ static uint32_t idleCounter;
 static uint32_t idleCounterClear;
 static struct pios_thread *systemTaskHandle;
 static struct pios_queue *objectPersistenceQueue;
+static uint32_t lastSaveTime;
 
-static volatile bool config_check_needed;
+#ifndef NO_SENSORS
+static volatile bool config_changed[CONFIG_DEP_NUM];
+static volatile uint32_t config_first_change_ms;
+static volatile uint32_t config_last_change_ms;
+#endif
 
 // Private functions
 static void systemPeriodicCb(UAVObjEvent *ev, void *ctx, void *obj_data, int len);
 static void objectUpdatedCb(UAVObjEvent * ev, void *ctx, void *obj, int len);
+static void flushSettingsSaves();
 static uint32_t processPeriodicUpdates();
+static void wheelInsert(PeriodicObjectList *entry);
+static void wheelRemove(PeriodicObjectList *entry);
+static void dispatchPeriodic(PeriodicObjectList *entry, uint32_t now);
 static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, uint16_t periodMs);
 static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, uint16_t periodMs);
 
 #ifndef NO_SENSORS
 static void configurationUpdatedCb(UAVObjEvent * ev, void *ctx, void *obj, int len);
+static void configurationCheckPending();
 #endif
 
 static void systemTask(void *parameters);
@@ -156,6 +202,12 @@ static inline void updateRfm22bStats();
 #if defined(WDG_STATS_DIAGNOSTICS)
 static inline void updateWDGstats();
 #endif
+#if defined(PIOS_INCLUDE_HEAP_POOLS)
+static void updateHeapPools();
+#endif
+#if defined(SPI_BUS_STATS)
+static void updateSpiBusStats();
+#endif
 
 /**
  * Create the module task.
@@ -208,6 +260,18 @@ int32_t SystemModInitialize(void)
 	if (WatchdogStatusInitialize() == -1)
 		return -1;
 #endif
+	if (looptrace_initialize() == -1)
+		return -1;
+	if (cpuaccount_initialize() == -1)
+		return -1;
+#if defined(PIOS_INCLUDE_HEAP_POOLS)
+	if (HeapPoolsInitialize() == -1)
+		return -1;
+#endif
+#if defined(SPI_BUS_STATS)
+	if (SPIBusStatsInitialize() == -1)
+		return -1;
+#endif
 
 	objectPersistenceQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
 	if (objectPersistenceQueue == NULL)
@@ -237,6 +301,10 @@ static void systemTask(void *parameters)
 	PIOS_IAP_WriteBootCount(0);
 #endif
 
+	/* The flight modules loaded the settings they use as they started,
+	 * and are running at higher priority.  Load everything else now. */
+	UAVObjLoadDeferredSettings();
+
 	// Initialize vars
 	idleCounter = 0;
 	idleCounterClear = 0;
@@ -250,19 +318,27 @@ static void systemTask(void *parameters)
 
 	// Whenever the configuration changes, make sure it is safe to fly
 	if (StabilizationSettingsHandle())
-		StabilizationSettingsConnectCallback(configurationUpdatedCb);
+		StabilizationSettingsConnectCallbackCtx(configurationUpdatedCb,
+				&config_changed[CONFIG_DEP_STABILIZATIONSETTINGS]);
 	if (SystemSettingsHandle())
-		SystemSettingsConnectCallback(configurationUpdatedCb);
+		SystemSettingsConnectCallbackCtx(configurationUpdatedCb,
+				&config_changed[CONFIG_DEP_SYSTEMSETTINGS]);
 	if (ManualControlSettingsHandle())
-		ManualControlSettingsConnectCallback(configurationUpdatedCb);
+		ManualControlSettingsConnectCallbackCtx(configurationUpdatedCb,
+				&config_changed[CONFIG_DEP_MANUALCONTROLSETTINGS]);
 	if (FlightStatusHandle())
-		FlightStatusConnectCallback(configurationUpdatedCb);
+		FlightStatusConnectCallbackCtx(configurationUpdatedCb,
+				&config_changed[CONFIG_DEP_FLIGHTSTATUS]);
 #ifndef SMALLF1
 	if (StateEstimationHandle())
-		StateEstimationConnectCallback(configurationUpdatedCb);
+		StateEstimationConnectCallbackCtx(configurationUpdatedCb,
+				&config_changed[CONFIG_DEP_STATEESTIMATION]);
 #endif
 #endif
 
+	/* Boot is done, what is allocated from here on can be freed */
+	PIOS_heap_enable_pools();
+
 	// Main system loop
 	while (1) {
 		int32_t delayTime = processPeriodicUpdates();
@@ -273,6 +349,8 @@ static void systemTask(void *parameters)
 			// If object persistence is updated call the callback
 			objectUpdatedCb(&ev, NULL, NULL, 0);
 		}
+
+		flushSettingsSaves();
 	}
 }
 
@@ -413,10 +491,7 @@ static void systemPeriodicCb(UAVObjEvent *ev, void *ctx, void *obj_data, int len
 	counter++;
 
 #ifndef NO_SENSORS
-	if (config_check_needed) {
-		configuration_check();
-		config_check_needed = false;
-	}
+	configurationCheckPending();
 #endif
 
 #ifdef SYSTEM_RAPID_UPDATES
@@ -445,6 +520,16 @@ static void systemPeriodicCb(UAVObjEvent *ev, void *ctx, void *obj_data, int len
 		TaskMonitorUpdateAll();
 #endif
 
+#if defined(LOOPTIMING_DIAGNOSTICS)
+		// Update the loop timing about once a second
+		static uint32_t last_loop_timing;
+		uint32_t now = PIOS_Thread_Systime();
+		if (now - last_loop_timing >= 1000) {
+			last_loop_timing = now;
+			looptrace_publish();
+		}
+#endif
+
 #endif /* PIPXTREME */
 	}
 
@@ -611,8 +696,9 @@ static void objectUpdatedCb(UAVObjEvent * ev, void *ctx, void *obj_data, int len
 				return;
 			}
 
-			// Save selected instance
-			retval = UAVObjSave(obj, objper.InstanceID);
+			// Save selected instance, written by flushSettingsSaves()
+			retval = UAVObjSaveDeferred(obj, objper.InstanceID);
+			lastSaveTime = PIOS_Thread_Systime();
 		} else if (objper.Operation == OBJECTPERSISTENCE_OPERATION_DELETE) {
 			// Delete selected instance
 			retval = UAVObjDeleteById(objper.ObjectID, objper.InstanceID);
@@ -620,6 +706,8 @@ static void objectUpdatedCb(UAVObjEvent * ev, void *ctx, void *obj_data, int len
 			retval = -1;
 #if defined(PIOS_INCLUDE_LOGFS_SETTINGS)
 			extern uintptr_t pios_uavo_settings_fs_id;
+			// So saves still pending are erased too
+			UAVObjFlushSaves();
 			retval = PIOS_FLASHFS_Format(pios_uavo_settings_fs_id);
 #endif
 		}
@@ -644,15 +732,85 @@ static void objectUpdatedCb(UAVObjEvent * ev, void *ctx, void *obj_data, int len
 #endif
 }
 
+/**
+ * Write the saves left pending by the object persistence requests, once
+ * they have settled and the vehicle is disarmed
+ */
+static void flushSettingsSaves()
+{
+#ifndef PIPXTREME
+	if (!UAVObjSavesPending())
+		return;
+
+	if (!PIOS_Thread_Period_Elapsed(lastSaveTime, SETTINGS_FLUSH_DELAY_MS))
+		return;
+
+	uint8_t armed;
+	FlightStatusArmedGet(&armed);
+
+	if (armed != FLIGHTSTATUS_ARMED_DISARMED)
+		return;
+
+	// On failure, try again after another delay
+	if (UAVObjFlushSaves() != 0)
+		lastSaveTime = PIOS_Thread_Systime();
+#endif
+}
+
 #ifndef NO_SENSORS
 /**
  * Called whenever a critical configuration component changes
+ * @param[in] ctx the changed flag of the object
  */
 
 static void configurationUpdatedCb(UAVObjEvent * ev, void *ctx, void *obj, int len)
 {
-	(void) ev; (void) ctx; (void) obj; (void) len;
-	config_check_needed = true;
+	(void) ev; (void) obj; (void) len;
+
+	volatile bool *changed = ctx;
+
+	if (changed != &config_changed[CONFIG_DEP_FLIGHTSTATUS]) {
+		uint32_t now = PIOS_Thread_Systime();
+
+		if (!config_changed[CONFIG_DEP_SYSTEMSETTINGS] &&
+				!config_changed[CONFIG_DEP_MANUALCONTROLSETTINGS] &&
+				!config_changed[CONFIG_DEP_STABILIZATIONSETTINGS] &&
+				!config_changed[CONFIG_DEP_STATEESTIMATION])
+			config_first_change_ms = now;
+
+		config_last_change_ms = now;
+	}
+
+	*changed = true;
+}
+
+/**
+ * Re-run the configuration checks that read the objects changed since
+ * the last run, once a burst of settings changes has settled
+ */
+static void configurationCheckPending()
+{
+	uint32_t now = PIOS_Thread_Systime();
+
+	bool settled = (now - config_last_change_ms >= CONFIG_CHECK_SETTLE_MS) ||
+		(now - config_first_change_ms >= CONFIG_CHECK_MAX_DELAY_MS);
+
+	uint32_t changed = 0;
+
+	for (int i = 0; i < CONFIG_DEP_NUM; i++) {
+		if (!config_changed[i])
+			continue;
+
+		if (i != CONFIG_DEP_FLIGHTSTATUS && !settled)
+			continue;
+
+		// Cleared first, so a change during the check is seen next time
+		config_changed[i] = false;
+		changed |= CONFIG_DEP_MASK(i);
+	}
+
+	if (changed)
+		configuration_check_changed(changed);
 }
 #endif
 
@@ -796,8 +954,99 @@ static void updateStats()
 	const float STM32_TEMP_AVG_SLOPE = 4.3f; /* mV/C */
 	stats.CPUTemp = (temp_voltage-STM32_TEMP_V25) * 1000 / STM32_TEMP_AVG_SLOPE + 25;
 #endif
+	// Late periodic events, since boot
+	EventStats evStats;
+	EventGetStats(&evStats);
+	stats.EventLateDispatches += evStats.lateDispatches;
+	if (evStats.maxLateMs > stats.EventMaxLateness) {
+		stats.EventMaxLateness = MIN(evStats.maxLateMs, UINT16_MAX);
+		stats.EventLateID = evStats.lateID;
+	}
+
 	SystemStatsSet(&stats);
+
+#if defined(PIOS_INCLUDE_HEAP_POOLS)
+	updateHeapPools();
+#endif
+#if defined(SPI_BUS_STATS)
+	updateSpiBusStats();
+#endif
+}
+
+#if defined(PIOS_INCLUDE_HEAP_POOLS)
+DONT_BUILD_IF(PIOS_HEAP_NUM_POOLS != HEAPPOOLS_INUSE_NUMELEM, HeapPoolsNumElem);
+
+/**
+ * Publish how the heap block pools are used
+ */
+static void updateHeapPools()
+{
+	HeapPoolsData pools = { };
+	struct pios_heap_pool_stats stats[PIOS_HEAP_NUM_POOLS];
+
+	if (PIOS_heap_get_pool_stats(false, stats) == 0) {
+		for (int i = 0; i < PIOS_HEAP_NUM_POOLS; i++) {
+			pools.InUse[i] = stats[i].in_use;
+			pools.Peak[i] = stats[i].peak;
+			pools.Carved[i] = stats[i].carved;
+		}
+	}
+
+	if (PIOS_heap_get_pool_stats(true, stats) == 0) {
+		for (int i = 0; i < PIOS_HEAP_NUM_POOLS; i++) {
+			pools.FastInUse[i] = stats[i].in_use;
+			pools.FastPeak[i] = stats[i].peak;
+			pools.FastCarved[i] = stats[i].carved;
+		}
+	}
+
+	HeapPoolsSet(&pools);
 }
+#endif /* PIOS_INCLUDE_HEAP_POOLS */
+
+#if defined(SPI_BUS_STATS)
+DONT_BUILD_IF(PIOS_SPI_MAX_BUSES != SPIBUSSTATS_UTILIZATION_NUMELEM, SPIBusStatsNumElem);
+
+/**
+ * Publish how busy the SPI buses were since the last call
+ */
+static void updateSpiBusStats()
+{
+	static struct pios_spi_stats last[PIOS_SPI_MAX_BUSES];
+	static uint32_t last_time;
+
+	uint32_t now = PIOS_Thread_Systime();
+	uint32_t dt_ms = now - last_time;
+
+	if (dt_ms == 0)
+		return;
+
+	last_time = now;
+
+	SPIBusStatsData bus_stats = { };
+
+	for (int i = 0; i < PIOS_SPI_MAX_BUSES; i++) {
+		struct pios_spi_stats stats;
+
+		if (PIOS_SPI_GetStats(i, &stats) != 0)
+			break;
+
+		uint32_t transactions = stats.transactions - last[i].transactions;
+		uint32_t busy_us = stats.busy_us - last[i].busy_us;
+		uint32_t wait_us = stats.wait_us - last[i].wait_us;
+
+		bus_stats.Utilization[i] = MIN(busy_us / (dt_ms * 10), 100);
+		bus_stats.TransactionRate[i] = MIN(transactions * 1000 / dt_ms, UINT16_MAX);
+		bus_stats.WaitAvg[i] = transactions ?
+			MIN(wait_us / transactions, UINT16_MAX) : 0;
+		bus_stats.WaitMax[i] = stats.max_wait_us;
+
+		last[i] = stats;
+	}
+
+	SPIBusStatsSet(&bus_stats);
+}
+#endif /* SPI_BUS_STATS */
 
 /**
  * Update system alarms
@@ -979,14 +1228,23 @@ static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, stru
 	}
 	// Create handle
 	objEntry = (PeriodicObjectList*)PIOS_malloc_no_dma(sizeof(PeriodicObjectList));
-	if (objEntry == NULL) return -1;
+	if (objEntry == NULL) {
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		return -1;
+	}
 	objEntry->evInfo.ev.obj = ev->obj;
 	objEntry->evInfo.ev.instId = ev->instId;
 	objEntry->evInfo.ev.event = ev->event;
 	objEntry->evInfo.cb = cb;
 	objEntry->evInfo.queue = queue;
 	objEntry->updatePeriodMs = periodMs;
-	objEntry->timeToNextUpdateMs = randomize_int(periodMs); // avoid bunching of updates
+	objEntry->wheelSlot = WHEEL_NONE;
+	if (periodMs > 0) {
+		// Due right away, at a random phase to avoid bunching of updates
+		objEntry->nextUpdateMs = PIOS_Thread_Systime() - randomize_int(periodMs);
+		objEntry->rephased = true;
+		wheelInsert(objEntry);
+	}
 	// Add to list
 	LL_APPEND(objList, objEntry);
 	// Release lock
@@ -1017,8 +1275,14 @@ static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, stru
 				objEntry->evInfo.ev.event == ev->event)
 		{
 			// Object found, update period
+			wheelRemove(objEntry);
 			objEntry->updatePeriodMs = periodMs;
-			objEntry->timeToNextUpdateMs = randomize_int(periodMs); // avoid bunching of updates
+			if (periodMs > 0) {
+				// Due right away, at a random phase to avoid bunching of updates
+				objEntry->nextUpdateMs = PIOS_Thread_Systime() - randomize_int(periodMs);
+				objEntry->rephased = true;
+				wheelInsert(objEntry);
+			}
 			// Release lock
 			PIOS_Recursive_Mutex_Unlock(mutex);
 			return 0;
@@ -1035,61 +1299,134 @@ static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, stru
 #define MAX_UPDATE_PERIOD_MS 350
 
 /**
- * Handle periodic updates for all objects.
- * \return The system time until the next update (in ms) or -1 if failed
+ * Put an entry with a period on the wheel, behind the entries of its slot
+ * that are due no later
  */
-static uint32_t processPeriodicUpdates()
+static void wheelInsert(PeriodicObjectList *entry)
 {
-	PeriodicObjectList* objEntry;
-	int32_t timeNow;
-	int32_t offset;
+	// Overdue entries go where the next pass starts
+	uint32_t due = entry->nextUpdateMs;
+	if ((int32_t)(due - wheelTime) < 0)
+		due = wheelTime;
+
+	entry->wheelSlot = due & WHEEL_MASK;
+
+	PeriodicObjectList **pos = &wheel[entry->wheelSlot];
+	while (*pos && (int32_t)((*pos)->nextUpdateMs - entry->nextUpdateMs) <= 0)
+		pos = &(*pos)->wheelNext;
 
+	entry->wheelNext = *pos;
+	*pos = entry;
+}
+
+/**
+ * Take an entry off the wheel, if it is on it
+ */
+static void wheelRemove(PeriodicObjectList *entry)
+{
+	if (entry->wheelSlot == WHEEL_NONE)
+		return;
+
+	PeriodicObjectList **pos = &wheel[entry->wheelSlot];
+	while (*pos && *pos != entry)
+		pos = &(*pos)->wheelNext;
+
+	if (*pos)
+		*pos = entry->wheelNext;
+
+	entry->wheelSlot = WHEEL_NONE;
+}
+
+/**
+ * Dispatch the event of an entry that is due, and put it back on the wheel
+ * for its next period
+ */
+static void dispatchPeriodic(PeriodicObjectList *entry, uint32_t now)
+{
+	uint32_t late = now - entry->nextUpdateMs;
+
+	if (entry->rephased) {
+		entry->rephased = false;
+	} else if (late > LATE_DISPATCH_MS) {
+		++stats.lateDispatches;
+		if (late > stats.maxLateMs) {
+			stats.maxLateMs = late;
+			stats.lateID = entry->evInfo.ev.obj ? UAVObjGetID(entry->evInfo.ev.obj) : 0;
+		}
+	}
+
+	// Reset timer, before the callback as it may change the period
+	uint32_t offset = late % entry->updatePeriodMs;
+	entry->nextUpdateMs = now + entry->updatePeriodMs - offset;
+	wheelInsert(entry);
+
+	// Invoke callback, if one
+	if ( entry->evInfo.cb != 0)
+	{
+		entry->evInfo.cb(&entry->evInfo.ev, NULL, NULL, 0); // the function is expected to copy the event information
+	}
+	// Push event to queue, if one
+	if ( entry->evInfo.queue != 0)
+	{
+		if (PIOS_Queue_Send(entry->evInfo.queue, &entry->evInfo.ev, 0) != true ) // do not block if queue is full
+		{
+			if (entry->evInfo.ev.obj != NULL)
+				stats.lastErrorID = UAVObjGetID(entry->evInfo.ev.obj);
+			++stats.eventErrors;
+		}
+	}
+}
+
+/**
+ * Handle periodic updates for all objects.  Only the wheel slots of the
+ * milliseconds since the last pass are visited, and only their due entries.
+ * \return The time until the next update (in ms)
+ */
+static uint32_t processPeriodicUpdates()
+{
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
-	// Iterate through each object and update its timer, if zero then transmit object.
-	// Also calculate smallest delay to next update.
 	uint32_t now = PIOS_Thread_Systime();
-	uint32_t timeToNextUpdate = PIOS_Thread_Systime() + MAX_UPDATE_PERIOD_MS;
-	LL_FOREACH(objList, objEntry)
-	{
-		// If object is configured for periodic updates
-		if (objEntry->updatePeriodMs > 0)
-		{
-			// Check if time for the next update
-			timeNow = PIOS_Thread_Systime();
-			if (objEntry->timeToNextUpdateMs <= timeNow)
-			{
-				// Reset timer
-				offset = ( timeNow - objEntry->timeToNextUpdateMs ) % objEntry->updatePeriodMs;
-				objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - offset;
-				// Invoke callback, if one
-				if ( objEntry->evInfo.cb != 0)
-				{
-					objEntry->evInfo.cb(&objEntry->evInfo.ev, NULL, NULL, 0); // the function is expected to copy the event information
-				}
-				// Push event to queue, if one
-				if ( objEntry->evInfo.queue != 0)
-				{
-					if (PIOS_Queue_Send(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != true ) // do not block if queue is full
-					{
-						if (objEntry->evInfo.ev.obj != NULL)
-							stats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
-						++stats.eventErrors;
-					}
-				}
-			}
-			// Update minimum delay
-			if (objEntry->timeToNextUpdateMs < timeToNextUpdate)
-			{
-				timeToNextUpdate = objEntry->timeToNextUpdateMs;
-			}
+
+	// A revolution visits every slot already
+	uint32_t ticks = now - wheelTime + 1;
+	if ((int32_t)(now - wheelTime) < 0)
+		ticks = 0;
+	if (ticks > WHEEL_SLOTS)
+		ticks = WHEEL_SLOTS;
+
+	for (uint32_t i = 0; i < ticks; i++) {
+		PeriodicObjectList **slot = &wheel[(wheelTime + i) & WHEEL_MASK];
+
+		// Sorted by deadline, so the due entries come first
+		while (*slot && (int32_t)((*slot)->nextUpdateMs - now) <= 0) {
+			PeriodicObjectList *entry = *slot;
+
+			*slot = entry->wheelNext;
+			entry->wheelSlot = WHEEL_NONE;
+
+			dispatchPeriodic(entry, now);
+		}
+	}
+
+	wheelTime = now + 1;
+
+	// The next update is the first slot ahead whose head is due in this
+	// revolution
+	uint32_t timeToNextUpdate = MIN(MAX_UPDATE_PERIOD_MS, WHEEL_SLOTS);
+	for (uint32_t i = 0; i < timeToNextUpdate; i++) {
+		PeriodicObjectList *head = wheel[(wheelTime + i) & WHEEL_MASK];
+
+		if (head && (int32_t)(head->nextUpdateMs - (wheelTime + i)) <= 0) {
+			timeToNextUpdate = i + 1;
+			break;
 		}
 	}
 
 	// Done
 	PIOS_Recursive_Mutex_Unlock(mutex);
-	return timeToNextUpdate - now;
+	return timeToNextUpdate;
 }
 
 /**
@@ -34,6 +34,7 @@
 
 #include "openpilot.h"
 #include <eventdispatcher.h>
+#include "flightstatus.h"
 #include "flighttelemetrystats.h"
 #include "gcstelemetrystats.h"
 #include "modulesettings.h"
@@ -42,6 +43,7 @@
 #include "pios_queue.h"
 
 #include "pios_hal.h"
+#include "misc_math.h"
 
 #include <uavtalk.h>
 
@@ -56,15 +58,65 @@
 #define CONNECTION_TIMEOUT_MS 8000
 #define USB_ACTIVITY_TIMEOUT_MS 6000
 
+/* Events waiting to be sent, by class, and the bytes each class may send
+ * per scheduling round.  A class that is full drops its oldest event. */
+#ifndef TELEM_CONTROL_QUEUE_LEN
+#define TELEM_CONTROL_QUEUE_LEN 4
+#endif
+#ifndef TELEM_STATE_QUEUE_LEN
+#define TELEM_STATE_QUEUE_LEN   (MAX_QUEUE_SIZE / 2)
+#endif
+#ifndef TELEM_BULK_QUEUE_LEN
+#define TELEM_BULK_QUEUE_LEN    MAX_QUEUE_SIZE
+#endif
+#define TELEM_CONTROL_QUANTUM   256
+#define TELEM_STATE_QUANTUM     128
+#define TELEM_BULK_QUANTUM      64
+
+/* Periodic updates slow down by RateScale while the link can't keep up:
+ * the tx fifo fills, the GCS receives less than we send or events get
+ * dropped.  Objects are never sent faster than their metadata asks, nor
+ * slowed beyond TELEM_RATE_MAX_PERIOD_MS unless it asks so. */
+#define TELEM_RATE_SCALE_MAX      8.0f
+#define TELEM_RATE_SCALE_UP       1.5f
+#define TELEM_RATE_SCALE_DOWN     1.2f
+#define TELEM_RATE_MAX_PERIOD_MS  5000
+#define TELEM_RATE_FIFO_HIGH      75	// percent
+#define TELEM_RATE_FIFO_LOW       25	// percent
+#define TELEM_RATE_MIN_TX_RATE    100	// bytes/s, GCS rx feedback below is noise
+
 // Private types
 
+//! Traffic classes, in the order they are served
+enum telem_class {
+	TELEM_CLASS_CONTROL,	// link statistics and metadata
+	TELEM_CLASS_STATE,	// alarms, flight status and on change updates
+	TELEM_CLASS_BULK,	// periodic and throttled streams
+	TELEM_CLASS_NUM
+};
+
+//! Ring of the events of one class, served by deficit round robin
+struct telem_class_queue {
+	UAVObjEvent *events;
+	uint16_t size;
+	uint16_t head;
+	uint16_t count;
+	uint16_t quantum;
+	int32_t deficit;
+};
+
 // Private variables
 static struct pios_queue *queue;
+static struct telem_class_queue classQueues[TELEM_CLASS_NUM];
+static uint8_t currentClass;
+static bool currentClassFresh = true;
 
 static uint32_t txErrors;
 static uint32_t txRetries;
 static uint32_t timeOfLastObjectUpdate;
 static UAVTalkConnection uavTalkCon;
+static float rateScale = 1.0f;
+static uint8_t txFifoPeak;		// percent, since the last stats update
 
 #if defined(PIOS_INCLUDE_USB)
 static volatile uint32_t usb_timeout_time;
@@ -74,10 +126,20 @@ static volatile uint32_t usb_timeout_time;
 static void telemetryTxTask(void *parameters);
 static void telemetryRxTask(void *parameters);
 static int32_t transmitData(uint8_t * data, int32_t length);
+static uint8_t *reserveData(int32_t length);
+static int32_t commitData(int32_t length);
 static void registerObject(UAVObjHandle obj);
 static void updateObject(UAVObjHandle obj, int32_t eventType);
 static int32_t setUpdatePeriod(UAVObjHandle obj, int32_t updatePeriodMs);
+static void rescaleObject(UAVObjHandle obj);
+static void updateRateScale(const FlightTelemetryStatsData * flightStats,
+		const GCSTelemetryStatsData * gcsStats, uint32_t errors);
+static void sampleTxFifo();
 static void processObjEvent(UAVObjEvent * ev);
+static int32_t createClassQueue(enum telem_class cls, uint16_t size, uint16_t quantum);
+static enum telem_class classifyEvent(const UAVObjEvent * ev);
+static void enqueueEvent(const UAVObjEvent * ev);
+static bool dequeueEvent(UAVObjEvent * ev);
 static void updateTelemetryStats();
 static void gcsTelemetryStatsUpdated();
 static void updateSettings();
@@ -132,8 +194,17 @@ int32_t TelemetryInitialize(void)
 	// Create object queues
 	queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
 
+	if (createClassQueue(TELEM_CLASS_CONTROL, TELEM_CONTROL_QUEUE_LEN, TELEM_CONTROL_QUANTUM) ||
+			createClassQueue(TELEM_CLASS_STATE, TELEM_STATE_QUEUE_LEN, TELEM_STATE_QUANTUM) ||
+			createClassQueue(TELEM_CLASS_BULK, TELEM_BULK_QUEUE_LEN, TELEM_BULK_QUANTUM)) {
+		return -1;
+	}
+
 	// Initialise UAVTalk
 	uavTalkCon = UAVTalkInitialize(&transmitData);
+	UAVTalkSetReserveStream(uavTalkCon, &reserveData, &commitData);
+	UAVTalkAllowBundles(uavTalkCon);
+	UAVTalkAllowDeltas(uavTalkCon);
 
 	if (SessionManagingInitialize() == -1) {
 		return -1;
@@ -260,6 +331,13 @@ static void processObjEvent(UAVObjEvent * ev)
 		// Get object metadata
 		UAVObjGetMetadata(ev->obj, &metadata);
 
+		// A set that changed nothing has nothing to send on change
+		if (ev->event == EV_UPDATED && ev->dirty == 0 &&
+				!UAVObjIsMetaobject(ev->obj) &&
+				UAVObjGetTelemetryUpdateMode(&metadata) == UPDATEMODE_ONCHANGE) {
+			return;
+		}
+
 		// Act on event
 		retries = 0;
 		success = -1;
@@ -285,6 +363,137 @@ static void processObjEvent(UAVObjEvent * ev)
 	}
 }
 
+/**
+ * Allocate the ring of one traffic class
+ * \return -1 if the allocation failed
+ * \return 0 on success
+ */
+static int32_t createClassQueue(enum telem_class cls, uint16_t size, uint16_t quantum)
+{
+	struct telem_class_queue *q = &classQueues[cls];
+
+	if (size < 1) {
+		size = 1;
+	}
+
+	q->events = PIOS_malloc(size * sizeof(UAVObjEvent));
+	if (!q->events) {
+		return -1;
+	}
+
+	q->size = size;
+	q->head = 0;
+	q->count = 0;
+	q->quantum = quantum;
+	q->deficit = 0;
+
+	return 0;
+}
+
+/**
+ * Tell which traffic class an event is sent in
+ */
+static enum telem_class classifyEvent(const UAVObjEvent * ev)
+{
+	if (ev->obj == 0 || ev->obj == GCSTelemetryStatsHandle() ||
+			UAVObjIsMetaobject(ev->obj)) {
+		return TELEM_CLASS_CONTROL;
+	}
+
+	// Both stream periodically, but matter right away
+	if (ev->obj == SystemAlarmsHandle() || ev->obj == FlightStatusHandle()) {
+		return TELEM_CLASS_STATE;
+	}
+
+	UAVObjMetadata metadata;
+	UAVObjGetMetadata(ev->obj, &metadata);
+
+	if (UAVObjGetTelemetryAcked(&metadata)) {
+		return TELEM_CLASS_STATE;
+	}
+
+	switch (UAVObjGetTelemetryUpdateMode(&metadata)) {
+	case UPDATEMODE_PERIODIC:
+	case UPDATEMODE_THROTTLED:
+		return TELEM_CLASS_BULK;
+	default:
+		return TELEM_CLASS_STATE;
+	}
+}
+
+/**
+ * Put an event in the ring of its class, making room by dropping the
+ * oldest one when the link can't keep up with the class.
+ */
+static void enqueueEvent(const UAVObjEvent * ev)
+{
+	struct telem_class_queue *q = &classQueues[classifyEvent(ev)];
+
+	if (q->count == q->size) {
+		q->head = (q->head + 1) % q->size;
+		q->count--;
+		++txErrors;
+	}
+
+	q->events[(q->head + q->count) % q->size] = *ev;
+	q->count++;
+}
+
+/**
+ * Pick the next event to send, deficit round robin over the classes.  Each
+ * visit grants a class its quantum of bytes, and it sends while its head
+ * event fits in what it has been granted so far.
+ * \return false if there is nothing to send
+ */
+static bool dequeueEvent(UAVObjEvent * ev)
+{
+	bool pending = false;
+
+	for (int i = 0; i < TELEM_CLASS_NUM; i++) {
+		pending |= (classQueues[i].count > 0);
+	}
+
+	if (!pending) {
+		return false;
+	}
+
+	while (1) {
+		struct telem_class_queue *q = &classQueues[currentClass];
+
+		if (q->count > 0) {
+			if (currentClassFresh) {
+				q->deficit += q->quantum;
+				currentClassFresh = false;
+			}
+
+			const UAVObjEvent *head = &q->events[q->head];
+			int32_t cost = head->obj ? UAVObjGetNumBytes(head->obj) : 1;
+
+			if (cost <= q->deficit) {
+				*ev = *head;
+				q->head = (q->head + 1) % q->size;
+				q->count--;
+				q->deficit -= cost;
+
+				// Keep serving this class until it runs out
+				if (q->count == 0) {
+					q->deficit = 0;
+					currentClass = (currentClass + 1) % TELEM_CLASS_NUM;
+					currentClassFresh = true;
+				}
+
+				return true;
+			}
+		} else {
+			// Idle classes don't save up
+			q->deficit = 0;
+		}
+
+		currentClass = (currentClass + 1) % TELEM_CLASS_NUM;
+		currentClassFresh = true;
+	}
+}
+
 /**
  * Telemetry transmit task, regular priority
  */
@@ -299,8 +508,27 @@ static void telemetryTxTask(void *parameters)
 	while (1) {
 		// Wait for queue message
 		if (PIOS_Queue_Receive(queue, &ev, PIOS_QUEUE_TIMEOUT_MAX) == true) {
-			// Process event
-			processObjEvent(&ev);
+			enqueueEvent(&ev);
+
+			// Process events, as long as there are some
+			while (1) {
+				// Sort what came in since the last send into
+				// the classes, then send the one that is due
+				while (PIOS_Queue_Receive(queue, &ev, 0) == true) {
+					enqueueEvent(&ev);
+				}
+
+				if (!dequeueEvent(&ev)) {
+					break;
+				}
+
+				processObjEvent(&ev);
+				sampleTxFifo();
+			}
+
+			// Nothing else to send for now, don't hold back the
+			// updates bundled so far
+			UAVTalkFlush(uavTalkCon);
 		}
 	}
 }
@@ -361,16 +589,18 @@ static void telemetryRxTask(void *parameters)
 		uintptr_t inputPort = getComPort();
 
 		if (inputPort) {
-			// Block until data are available
-			uint8_t serial_data[16];
+			// Block until data are available, then parse them in place
+			const uint8_t *serial_data;
 			uint16_t bytes_to_process;
 
-			bytes_to_process = PIOS_COM_ReceiveBuffer(inputPort, serial_data, sizeof(serial_data), 500);
+			serial_data = PIOS_COM_PeekReceiveBuffer(inputPort, &bytes_to_process, 500);
 			if (bytes_to_process > 0) {
-				for (uint8_t i = 0; i < bytes_to_process; i++) {
+				for (uint16_t i = 0; i < bytes_to_process; i++) {
 					UAVTalkProcessInputStream(uavTalkCon,serial_data[i]);
 				}
 
+				PIOS_COM_ConsumeReceiveBuffer(inputPort, bytes_to_process);
+
 #if defined(PIOS_INCLUDE_USB)
 				if (inputPort == PIOS_COM_TELEM_USB) {
 					processUsbActivity(true);
@@ -400,6 +630,39 @@ static int32_t transmitData(uint8_t * data, int32_t length)
 	return -1;
 }
 
+//! Port a packet is being built for, between reserveData and commitData
+static uintptr_t reservedPort;
+
+/**
+ * Get room in the COM port transmit buffer to build a packet into
+ * \param[in] length Length of the packet
+ * \return NULL if there is no room, transmitData is used then
+ */
+static uint8_t *reserveData(int32_t length)
+{
+	uintptr_t outputPort = getComPort();
+
+	if (!outputPort)
+		return NULL;
+
+	uint8_t *buf = PIOS_COM_ReserveBuffer(outputPort, length);
+
+	if (buf)
+		reservedPort = outputPort;
+
+	return buf;
+}
+
+/**
+ * Transmit the packet built by reserveData
+ * \param[in] length Length of the packet, 0 to drop it
+ * \return number of bytes transmitted
+ */
+static int32_t commitData(int32_t length)
+{
+	return PIOS_COM_CommitBuffer(reservedPort, length);
+}
+
 /**
  * Set update period of object (it must be already setup for periodic updates)
  * \param[in] obj The object to update
@@ -415,9 +678,77 @@ static int32_t setUpdatePeriod(UAVObjHandle obj, int32_t updatePeriodMs)
 	ev.obj = obj;
 	ev.instId = UAVOBJ_ALL_INSTANCES;
 	ev.event = EV_UPDATED_PERIODIC;
+
+	// Slower while the link is congested
+	if (updatePeriodMs > 0 && rateScale > 1.0f) {
+		int32_t scaledMs = (int32_t)(updatePeriodMs * rateScale);
+		updatePeriodMs = MAX(updatePeriodMs, MIN(scaledMs, TELEM_RATE_MAX_PERIOD_MS));
+	}
+
 	return EventPeriodicQueueUpdate(&ev, queue, updatePeriodMs);
 }
 
+/**
+ * Apply the current rate scale to an object, if it is sent periodically
+ * \param[in] obj Object to update
+ */
+static void rescaleObject(UAVObjHandle obj)
+{
+	if (UAVObjIsMetaobject(obj)) {
+		return;
+	}
+
+	UAVObjMetadata metadata;
+	UAVObjGetMetadata(obj, &metadata);
+
+	if (UAVObjGetTelemetryUpdateMode(&metadata) == UPDATEMODE_PERIODIC) {
+		setUpdatePeriod(obj, metadata.telemetryUpdatePeriod);
+	}
+}
+
+/**
+ * Keep track of how full the tx fifo of the telemetry port gets
+ */
+static void sampleTxFifo()
+{
+	uint16_t pending, room;
+
+	if (PIOS_COM_GetTxBufferState(getComPort(), &pending, &room) == 0 &&
+			pending + room > 0) {
+		uint8_t fill = (uint8_t)((100 * (uint32_t)pending) / (pending + room));
+		txFifoPeak = MAX(txFifoPeak, fill);
+	}
+}
+
+/**
+ * Back the periodic updates off while the link is congested, and speed
+ * them up again slowly once it has spare capacity.
+ * \param[in] flightStats Our stats for the last period
+ * \param[in] gcsStats The latest stats from the GCS
+ * \param[in] errors Events that failed or were dropped in the last period
+ */
+static void updateRateScale(const FlightTelemetryStatsData * flightStats,
+		const GCSTelemetryStatsData * gcsStats, uint32_t errors)
+{
+	float scale = rateScale;
+	bool feedback = flightStats->TxDataRate > TELEM_RATE_MIN_TX_RATE;
+
+	if (txFifoPeak >= TELEM_RATE_FIFO_HIGH || errors > 0 ||
+			(feedback && gcsStats->RxDataRate < 0.7f * flightStats->TxDataRate)) {
+		scale = MIN(scale * TELEM_RATE_SCALE_UP, TELEM_RATE_SCALE_MAX);
+	} else if (txFifoPeak < TELEM_RATE_FIFO_LOW &&
+			(!feedback || gcsStats->RxDataRate >= 0.9f * flightStats->TxDataRate)) {
+		scale = MAX(scale / TELEM_RATE_SCALE_DOWN, 1.0f);
+	}
+
+	txFifoPeak = 0;
+
+	if (scale != rateScale) {
+		rateScale = scale;
+		UAVObjIterate(&rescaleObject);
+	}
+}
+
 /**
  * Called each time the GCS telemetry stats object is updated.
  * Trigger a flight telemetry stats update if a connection is not
@@ -461,6 +792,7 @@ static void updateTelemetryStats()
 		flightStats.RxFailures += utalkStats.rxErrors;
 		flightStats.TxFailures += txErrors;
 		flightStats.TxRetries += txRetries;
+		updateRateScale(&flightStats, &gcsStats, txErrors);
 		txErrors = 0;
 		txRetries = 0;
 	} else {
@@ -471,7 +803,15 @@ static void updateTelemetryStats()
 		flightStats.TxRetries = 0;
 		txErrors = 0;
 		txRetries = 0;
+
+		// Start new connections at the full rates
+		txFifoPeak = 0;
+		if (rateScale != 1.0f) {
+			rateScale = 1.0f;
+			UAVObjIterate(&rescaleObject);
+		}
 	}
+	flightStats.RateScale = rateScale;
 
 	// Check for connection timeout
 	timeNow = PIOS_Thread_Systime();
@@ -513,6 +853,9 @@ static void updateTelemetryStats()
 		AlarmsClear(SYSTEMALARMS_ALARM_TELEMETRY);
 	} else {
 		AlarmsSet(SYSTEMALARMS_ALARM_TELEMETRY, SYSTEMALARMS_ALARM_ERROR);
+
+		// A new session has to ask for bundles again
+		UAVTalkStopBundles(uavTalkCon);
 	}
 
 	// Update object
@@ -576,6 +919,7 @@ static void session_managing_updated(UAVObjEvent * ev, void *ctx, void *obj, int
 		SessionManagingGet(&sessionManaging);
 
 		if (sessionManaging.SessionID == 0) {
+			UAVTalkStopBundles(uavTalkCon);
 			sessionManaging.ObjectID = 0;
 			sessionManaging.ObjectInstances = 0;
 			sessionManaging.NumberOfObjects = UAVObjCount();
@@ -35,6 +35,7 @@
 #include "frsky_packing.h"
 #include "pios_thread.h"
 #include "pios_modules.h"
+#include "bridgetask.h"
 
 #include "baroaltitude.h"
 #include "flightbatterysettings.h"
@@ -46,6 +47,7 @@
 
 #define FRSKY_POLL_REQUEST                 0x7e
 #define FRSKY_MINIMUM_POLL_INTERVAL        10000
+#define FRSKY_PRESENCE_INTERVAL            1000000
 
 enum frsky_state {
 	FRSKY_STATE_WAIT_POLL_REQUEST,
@@ -85,27 +87,47 @@ struct frsky_sport_telemetry {
 	enum frsky_state state;
 	int32_t scheduled_item;
 	uint32_t last_poll_time;
+	uint32_t last_presence_time;
 	uint8_t ignore_rx_chars;
 	uintptr_t com;
+	volatile bool gps_position_updated;
 	struct frsky_settings frsky_settings;
-	uint32_t item_last_triggered[NELEMENTS(frsky_value_items)];
+	struct frsky_value_state item_state[NELEMENTS(frsky_value_items)];
 };
 
 static const uint8_t frsky_sensor_ids[] = {0x1b};
 
 #define FRSKY_SPORT_BAUDRATE                    57600
 
-#if defined(PIOS_FRSKY_SPORT_TELEMETRY_STACK_SIZE)
-#define STACK_SIZE_BYTES PIOS_FRSKY_SPORT_TELEMETRY_STACK_SIZE
-#else
-#define STACK_SIZE_BYTES 672
-#endif
-#define TASK_PRIORITY               PIOS_THREAD_PRIO_LOW
-
 static bool module_enabled = false;
 static struct frsky_sport_telemetry *frsky;
 static int32_t uavoFrSKYSPortBridgeInitialize(void);
-static void uavoFrSKYSPortBridgeTask(void *parameters);
+static bool uavoFrSKYSPortBridgeRun(void *ctx);
+static void gps_position_updated_cb(UAVObjEvent *ev, void *ctx, void *obj, int len);
+
+/**
+ * Refresh the GPS position when it has changed, and which values are
+ * available with it
+ */
+static void frsky_refresh_values(void)
+{
+	bool presence_changed = false;
+
+	// GPS position data are very often used by encode() handlers, so they
+	// are kept here rather than fetched by each
+	if (frsky->gps_position_updated) {
+		frsky->gps_position_updated = false;
+		GPSPositionGet(&frsky->frsky_settings.gps_position);
+		presence_changed = true;
+	}
+
+	if (presence_changed ||
+			PIOS_DELAY_GetuSSince(frsky->last_presence_time) > FRSKY_PRESENCE_INTERVAL) {
+		frsky->last_presence_time = PIOS_DELAY_GetuS();
+		frsky_update_presence(&frsky->frsky_settings, frsky_value_items,
+				frsky->item_state, NELEMENTS(frsky_value_items));
+	}
+}
 
 /**
  * Scan for value item with the longest expired time and schedule it to send in next poll turn
@@ -113,20 +135,8 @@ static void uavoFrSKYSPortBridgeTask(void *parameters);
  */
 static void frsky_schedule_next_item(void)
 {
-	uint32_t i = 0;
-	int32_t max_exp_time = INT32_MIN;
-	int32_t most_exp_item = -1;
-	for (i = 0; i < NELEMENTS(frsky_value_items); i++) {
-		if (frsky_value_items[i].encode_value(&frsky->frsky_settings, 0, true, frsky_value_items[i].fn_arg)) {
-			int32_t exp_time = PIOS_DELAY_GetuSSince(frsky->item_last_triggered[i]) -
-					(frsky_value_items[i].period_ms * 1000);
-			if (exp_time > max_exp_time) {
-				max_exp_time = exp_time;
-				most_exp_item = i;
-			}
-		}
-	}
-	frsky->scheduled_item = most_exp_item;
+	frsky->scheduled_item = frsky_schedule_next(frsky_value_items,
+			frsky->item_state, NELEMENTS(frsky_value_items));
 }
 /**
  * Send value item previously scheduled by frsky_schedule_next_itme()
@@ -135,19 +145,27 @@ static void frsky_schedule_next_item(void)
 static bool frsky_send_scheduled_item(void)
 {
 	int32_t item = frsky->scheduled_item;
-	if ((item >= 0) && (item < NELEMENTS(frsky_value_items))) {
-		frsky->item_last_triggered[item] = PIOS_DELAY_GetuS();
-		uint32_t value = 0;
-		if (frsky_value_items[item].encode_value(&frsky->frsky_settings, &value, false,
-				frsky_value_items[item].fn_arg)) {
-			frsky->ignore_rx_chars += frsky_send_frame(frsky->com, (uint16_t)(frsky_value_items[item].id), value, false);
-			return true;
-		}
+	uint32_t value = 0;
+
+	if (frsky_encode_item(&frsky->frsky_settings, frsky_value_items, frsky->item_state,
+			NELEMENTS(frsky_value_items), item, &value)) {
+		frsky->ignore_rx_chars += frsky_send_frame(frsky->com, (uint16_t)(frsky_value_items[item].id), value, false);
+		return true;
 	}
 
 	return false;
 }
 
+/**
+ * Note that the GPS position changed, to be fetched on the next poll
+ */
+static void gps_position_updated_cb(UAVObjEvent *ev, void *ctx, void *obj, int len)
+{
+	(void) ev; (void) ctx; (void) obj; (void) len;
+
+	frsky->gps_position_updated = true;
+}
+
 /**
  * Process incoming bytes from FrSky S.PORT bus
  * @param[in] b received byte
@@ -177,10 +195,7 @@ static void frsky_receive_byte(uint8_t b)
 		frsky->state = FRSKY_STATE_WAIT_POLL_REQUEST;
 		for (i = 0; i < sizeof(frsky_sensor_ids); i++) {
 			if (frsky_sensor_ids[i] == b) {
-				// get GPSPositionData once here to be more efficient, since
-				// GPS position data are very often used by encode() handlers
-				if (GPSPositionHandle() != NULL)
-					GPSPositionGet(&frsky->frsky_settings.gps_position);
+				frsky_refresh_values();
 				// send item previously scheduled
 				if (frsky_send_scheduled_item() && frsky->ignore_rx_chars)
 					frsky->state = FRSKY_STATE_WAIT_TX_DONE;
@@ -215,14 +230,15 @@ static int32_t uavoFrSKYSPortBridgeStart(void)
 			&& PIOS_SENSORS_GetQueue(PIOS_SENSOR_BARO) != NULL)
 		frsky->frsky_settings.use_baro_sensor = true;
 
-	struct pios_thread *task;
-	task = PIOS_Thread_Create(
-			uavoFrSKYSPortBridgeTask, "uavoFrSKYSPortBridge",
-			STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-	TaskMonitorAdd(TASKINFO_RUNNING_UAVOFRSKYSPORTBRIDGE,
-			task);
+	if (GPSPositionHandle() != NULL) {
+		frsky->gps_position_updated = true;
+		GPSPositionConnectCallback(gps_position_updated_cb);
+	}
+
+	frsky_update_presence(&frsky->frsky_settings, frsky_value_items,
+			frsky->item_state, NELEMENTS(frsky_value_items));
 
-	return 0;
+	return BridgeTaskAdd(frsky->com, 0, uavoFrSKYSPortBridgeRun, NULL);
 }
 
 /**
@@ -246,10 +262,9 @@ static int32_t uavoFrSKYSPortBridgeInitialize(void)
 			frsky->ignore_rx_chars = 0;
 			frsky->scheduled_item = -1;
 			frsky->com = sport_com;
+			frsky->last_presence_time = PIOS_DELAY_GetuS();
 
-			uint8_t i;
-			for (i = 0; i < NELEMENTS(frsky_value_items); i++)
-				frsky->item_last_triggered[i] = PIOS_DELAY_GetuS();
+			frsky_init_items(frsky->item_state, NELEMENTS(frsky_value_items));
 			PIOS_COM_ChangeBaud(frsky->com, FRSKY_SPORT_BAUDRATE);
 			module_enabled = true;
 			return 0;
@@ -261,17 +276,19 @@ static int32_t uavoFrSKYSPortBridgeInitialize(void)
 MODULE_INITCALL(uavoFrSKYSPortBridgeInitialize, uavoFrSKYSPortBridgeStart)
 
 /**
- * Main task routine
- * @param[in] parameters parameter given by PIOS_Thread_Create()
+ * Bridge step, run from the shared bridge task when data comes in
+ * @param[in] ctx unused
+ * @return true, to keep running
  */
-static void uavoFrSKYSPortBridgeTask(void *parameters)
+static bool uavoFrSKYSPortBridgeRun(void *ctx)
 {
-	while (1) {
-		uint8_t b = 0;
-		uint16_t count = PIOS_COM_ReceiveBuffer(frsky->com, &b, 1, PIOS_QUEUE_TIMEOUT_MAX);
-		if (count)
-			frsky_receive_byte(b);
-	}
+	(void) ctx;
+	uint8_t b;
+
+	while (PIOS_COM_ReceiveBuffer(frsky->com, &b, 1, 0))
+		frsky_receive_byte(b);
+
+	return true;
 }
 
 #endif //PIOS_INCLUDE_FRSKY_SPORT_TELEMETRY
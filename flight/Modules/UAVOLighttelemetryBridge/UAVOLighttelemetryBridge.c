@@ -65,16 +65,13 @@
 #include "manualcontrolcommand.h"
 #include "positionactual.h"
 
-#include "pios_thread.h"
 #include "pios_modules.h"
+#include "bridgetask.h"
 
 #include <pios_hal.h>
 
 #if defined(PIOS_INCLUDE_LIGHTTELEMETRY)
 // Private constants
-#define STACK_SIZE_BYTES 600
-#define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
-
 #define CHUNK_TIME 30		/* 30ms. 3.6 bytes @ 1200, 14.4 bytes at 4800 */
 /* The expected behavior at 1200 bps becomes then, prepare+send frame, delay 30ms,
  * then prepare 1-3 frames at 30ms intervals that go unsent because of buffer.
@@ -89,13 +86,12 @@
 
 // Private variables
 static bool module_enabled = false;
-static struct pios_thread *taskHandle;
 static uint32_t lighttelemetryPort;
 static uint8_t ltm_scheduler;
 static uint8_t ltm_slowrate;
 
 // Private functions
-static void uavoLighttelemetryBridgeTask(void *parameters);
+static bool uavoLighttelemetryBridgeRun(void *ctx);
 static void updateSettings();
 
 static int send_LTM_Packet(uint8_t *LTPacket, uint8_t LTPacket_size);
@@ -129,9 +125,9 @@ int32_t uavoLighttelemetryBridgeStart()
 {
 	if ( module_enabled )
 	{
-		taskHandle = PIOS_Thread_Create(uavoLighttelemetryBridgeTask, "uavoLighttelemetryBridge", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-		TaskMonitorAdd(TASKINFO_RUNNING_UAVOLIGHTTELEMETRYBRIDGE, taskHandle);
-		return 0;
+		updateSettings();
+
+		return BridgeTaskAdd(0, CHUNK_TIME, uavoLighttelemetryBridgeRun, NULL);
 	}
 	
 	return -1;
@@ -140,67 +136,61 @@ int32_t uavoLighttelemetryBridgeStart()
 MODULE_INITCALL(uavoLighttelemetryBridgeInitialize, uavoLighttelemetryBridgeStart);
 
 
-/*#######################################################################
- * Module thread, should not return.
- *#######################################################################
-*/
-
-static void uavoLighttelemetryBridgeTask(void *parameters)
+/**
+ * Bridge step, run from the shared bridge task every CHUNK_TIME
+ * @param[in] ctx unused
+ * @return true, the bridge is never dropped
+ */
+static bool uavoLighttelemetryBridgeRun(void *ctx)
 {
-	updateSettings();
-	
-	// Main task loop
-	while (1)
-	{
-		int ret = 0;
-
-		if (!ret) {
-			switch (ltm_scheduler) {
-				case 0:
-				case 6:
-					ret = send_LTM_Sframe();
-					break;
-
-				case 3:
-				case 9:
-					ret = send_LTM_Gframe();
-					break;
-
-				case 1:
-				case 4:
-				case 7:
-				case 10:
-					if (ltm_slowrate) {
-						break;
-					}
-
-				case 2:
-				case 5:
-				case 8:
-				case 11:
-					ret = send_LTM_Aframe();
-					break;
-
-				default:
-					break;
+	(void) ctx;
+
+	int ret = 0;
+
+	switch (ltm_scheduler) {
+		case 0:
+		case 6:
+			ret = send_LTM_Sframe();
+			break;
+
+		case 3:
+		case 9:
+			ret = send_LTM_Gframe();
+			break;
+
+		case 1:
+		case 4:
+		case 7:
+		case 10:
+			if (ltm_slowrate) {
+				break;
 			}
-		}
 
-		PIOS_Thread_Sleep(CHUNK_TIME);
+		case 2:
+		case 5:
+		case 8:
+		case 11:
+			ret = send_LTM_Aframe();
+			break;
 
-		if (ret) {
-			/* If we couldn't tx, go around and try the same thing
-			 * again.
-			 */
-			continue;
-		}
+		default:
+			break;
+	}
 
-		ltm_scheduler++;
+	if (ret) {
+		/* If we couldn't tx, try the same thing again next time
+		 * around.
+		 */
+		return true;
+	}
+
+	ltm_scheduler++;
 
-		if (ltm_scheduler > 11) {
-			ltm_scheduler = 0;
-		}
+	if (ltm_scheduler > 11) {
+		ltm_scheduler = 0;
 	}
+
+	return true;
 }
 
 /*#######################################################################
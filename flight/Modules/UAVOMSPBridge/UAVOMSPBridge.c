@@ -52,6 +52,7 @@
 #include "pios_thread.h"
 #include "pios_sensors.h"
 #include "pios_modules.h"
+#include "bridgetask.h"
 
 #ifndef SMALLF1
 #include "positionactual.h"
@@ -143,9 +144,37 @@ typedef enum {
 	MSP_MAYBE_UAVTALK_SLOW6
 } msp_state;
 
+#define MAX_ALARM_LEN 30
+
+//! Preamble, direction, size, command and checksum
+#define MSP_FRAME_OVERHEAD 6
+
+/* Replies that only change when one of a few objects does: they are
+ * kept once built and sent again as they are until one of those objects
+ * is updated, as OSDs ask for them far more often than that. */
+enum msp_cached_reply {
+	MSP_CACHE_STATUS,
+	MSP_CACHE_RAW_GPS,
+	MSP_CACHE_COMP_GPS,
+	MSP_CACHE_BOXIDS,
+	MSP_CACHE_ALARMS,
+	MSP_CACHE_NUM,
+};
+
+#define MSP_CACHE_FRAME_LEN (MSP_FRAME_OVERHEAD + 1 + MAX_ALARM_LEN)
+
+struct msp_reply_cache {
+	volatile bool valid;
+	uint8_t len;		// of the frame, 0 if nothing was sent
+	uint8_t frame[MSP_CACHE_FRAME_LEN];
+};
+
 struct msp_bridge {
 	uintptr_t com;
 
+	struct msp_reply_cache *cache;
+	struct msp_reply_cache *filling;
+
 	msp_state state;
 	uint8_t cmd_size;
 	uint8_t cmd_id;
@@ -157,28 +186,40 @@ struct msp_bridge {
 	} cmd_data;
 };
 
-#if defined(PIOS_MSP_STACK_SIZE)
-#define STACK_SIZE_BYTES PIOS_MSP_STACK_SIZE
-#else
-#define STACK_SIZE_BYTES 768
-#endif
-#define TASK_PRIORITY               PIOS_THREAD_PRIO_LOW
-
-#define MAX_ALARM_LEN 30
-
 #define BOOT_DISPLAY_TIME_MS (10*1000)
 
 static bool module_enabled = false;
 extern uintptr_t pios_com_msp_id;
 static struct msp_bridge *msp;
 static int32_t uavoMSPBridgeInitialize(void);
-static void uavoMSPBridgeTask(void *parameters);
+static bool uavoMSPBridgeRun(void *ctx);
 
 static void msp_send(struct msp_bridge *m, uint8_t cmd, const uint8_t *data, size_t len)
 {
 	uint8_t buf[5];
 	uint8_t cs = (uint8_t)(len) ^ cmd;
 
+	struct msp_reply_cache *c = m->filling;
+
+	/* A reply being cached is built there and sent in one go */
+	if (c && len + MSP_FRAME_OVERHEAD <= sizeof(c->frame)) {
+		c->frame[0] = '$';
+		c->frame[1] = 'M';
+		c->frame[2] = '>';
+		c->frame[3] = (uint8_t)(len);
+		c->frame[4] = cmd;
+		memcpy(&c->frame[5], data, len);
+
+		for (int i = 0; i < len; i++) {
+			cs ^= data[i];
+		}
+		c->frame[5 + len] = cs;
+
+		c->len = len + MSP_FRAME_OVERHEAD;
+		PIOS_COM_SendBuffer(m->com, c->frame, c->len);
+		return;
+	}
+
 	buf[0] = '$';
 	buf[1] = 'M';
 	buf[2] = '>';
@@ -570,12 +611,73 @@ static void msp_send_alarms(struct msp_bridge *m) {
 	msp_send(m, MSP_ALARMS, data.buf, len+1);
 }
 
+static const uint8_t msp_cached_ids[MSP_CACHE_NUM] = {
+	[MSP_CACHE_STATUS] = MSP_STATUS,
+	[MSP_CACHE_RAW_GPS] = MSP_RAW_GPS,
+	[MSP_CACHE_COMP_GPS] = MSP_COMP_GPS,
+	[MSP_CACHE_BOXIDS] = MSP_BOXIDS,
+	[MSP_CACHE_ALARMS] = MSP_ALARMS,
+};
+
+/**
+ * Find where the reply to a request is cached
+ * @param[in] cmd the request
+ * @return the cache entry, or NULL if the reply is built every time
+ */
+static struct msp_reply_cache *msp_cache_lookup(struct msp_bridge *m, uint8_t cmd)
+{
+	if (!m->cache)
+		return NULL;
+
+	// The boot reason shown at first goes away with time, not an update
+	if (cmd == MSP_ALARMS && PIOS_Thread_Systime() < BOOT_DISPLAY_TIME_MS)
+		return NULL;
+
+	for (int i = 0; i < MSP_CACHE_NUM; i++) {
+		if (msp_cached_ids[i] == cmd)
+			return &m->cache[i];
+	}
+
+	return NULL;
+}
+
+/**
+ * Drop the cached replies built from an object, when it is updated
+ * @param[in] ctx mask of the enum msp_cached_reply entries to drop
+ */
+static void msp_cache_invalidate_cb(UAVObjEvent *ev, void *ctx, void *obj, int len)
+{
+	(void) ev; (void) obj; (void) len;
+
+	uint32_t mask = (uintptr_t) ctx;
+
+	for (int i = 0; i < MSP_CACHE_NUM; i++) {
+		if (mask & (1 << i))
+			msp->cache[i].valid = false;
+	}
+}
+
 static msp_state msp_state_checksum(struct msp_bridge *m, uint8_t b)
 {
 	if ((m->checksum ^ b) != 0) {
 		return MSP_IDLE;
 	}
 
+	struct msp_reply_cache *c = msp_cache_lookup(m, m->cmd_id);
+
+	if (c) {
+		if (c->valid) {
+			PIOS_COM_SendBuffer(m->com, c->frame, c->len);
+			return MSP_IDLE;
+		}
+
+		/* Marked valid before the objects are read, so an update
+		 * that comes in while the reply is built drops it again */
+		c->len = 0;
+		c->valid = true;
+		m->filling = c;
+	}
+
 	// Respond to interesting things.
 	switch (m->cmd_id) {
 	case MSP_IDENT:
@@ -609,6 +711,14 @@ static msp_state msp_state_checksum(struct msp_bridge *m, uint8_t b)
 		msp_send_alarms(m);
 		break;
 	}
+
+	if (c) {
+		m->filling = NULL;
+
+		if (c->len == 0)
+			c->valid = false;
+	}
+
 	return MSP_IDLE;
 }
 
@@ -719,13 +829,9 @@ static int32_t uavoMSPBridgeStart(void)
 		return -1;
 	}
 
-	struct pios_thread *task = PIOS_Thread_Create(
-		uavoMSPBridgeTask, "uavoMSPBridge",
-		STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-	TaskMonitorAdd(TASKINFO_RUNNING_UAVOMSPBRIDGE,
-			task);
+	setMSPSpeed(msp);
 
-	return 0;
+	return BridgeTaskAdd(msp->com, 0, uavoMSPBridgeRun, msp);
 }
 
 static void setMSPSpeed(struct msp_bridge *m)
@@ -751,6 +857,27 @@ static int32_t uavoMSPBridgeInitialize(void)
 
 			msp->com = pios_com_msp_id;
 
+#ifndef SMALLF1
+			msp->cache = PIOS_malloc_no_dma(MSP_CACHE_NUM * sizeof(*msp->cache));
+			if (msp->cache) {
+				memset(msp->cache, 0, MSP_CACHE_NUM * sizeof(*msp->cache));
+
+				if (GPSPositionHandle() != NULL)
+					GPSPositionConnectCallbackCtx(msp_cache_invalidate_cb,
+							(void *)(uintptr_t)((1 << MSP_CACHE_STATUS) |
+								(1 << MSP_CACHE_RAW_GPS) |
+								(1 << MSP_CACHE_COMP_GPS)));
+				if (HomeLocationHandle() != NULL)
+					HomeLocationConnectCallbackCtx(msp_cache_invalidate_cb,
+							(void *)(uintptr_t)(1 << MSP_CACHE_COMP_GPS));
+				if (FlightStatusHandle() != NULL)
+					FlightStatusConnectCallbackCtx(msp_cache_invalidate_cb,
+							(void *)(uintptr_t)(1 << MSP_CACHE_STATUS));
+				SystemAlarmsConnectCallbackCtx(msp_cache_invalidate_cb,
+						(void *)(uintptr_t)(1 << MSP_CACHE_ALARMS));
+			}
+#endif
+
 			module_enabled = true;
 			return 0;
 		}
@@ -761,26 +888,30 @@ static int32_t uavoMSPBridgeInitialize(void)
 MODULE_INITCALL(uavoMSPBridgeInitialize, uavoMSPBridgeStart)
 
 /**
- * Main task routine
- * @param[in] parameters parameter given by PIOS_Thread_Create()
+ * Bridge step, run from the shared bridge task when data comes in
+ * @param[in] ctx the bridge
+ * @return false once the port has been handed over to telemetry
  */
-static void uavoMSPBridgeTask(void *parameters)
+static bool uavoMSPBridgeRun(void *ctx)
 {
-	setMSPSpeed(msp);
-
-	while (1) {
-		uint8_t b = 0;
-		uint16_t count = PIOS_COM_ReceiveBuffer(msp->com, &b, 1, PIOS_QUEUE_TIMEOUT_MAX);
-		if (count) {
-			if (!msp_receive_byte(msp, b)) {
-				// Returning is considered risky here as
-				// that's unusual and this is an edge case.
-				while (1) {
-					PIOS_Thread_Sleep(60*1000);
-				}
+	struct msp_bridge *m = ctx;
+	const uint8_t *span;
+	uint16_t len;
+
+	/* Parsed where it sits in the port buffer; what follows a hand-over
+	 * is left there for telemetry */
+	while ((span = PIOS_COM_PeekReceiveBuffer(m->com, &len, 0)) != NULL) {
+		for (uint16_t i = 0; i < len; i++) {
+			if (!msp_receive_byte(m, span[i])) {
+				PIOS_COM_ConsumeReceiveBuffer(m->com, i + 1);
+				return false;
 			}
 		}
+
+		PIOS_COM_ConsumeReceiveBuffer(m->com, len);
 	}
+
+	return true;
 }
 
 #endif //PIOS_INCLUDE_MSP_BRIDGE
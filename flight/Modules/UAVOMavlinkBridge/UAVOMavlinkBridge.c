@@ -50,6 +50,7 @@
 #include "mavlink.h"
 #include "pios_thread.h"
 #include "pios_modules.h"
+#include "bridgetask.h"
 
 #include <pios_hal.h>
 
@@ -58,21 +59,21 @@
 // ****************
 // Private functions
 
-static void uavoMavlinkBridgeTask(void *parameters);
+static bool uavoMavlinkBridgeRun(void *ctx);
 static bool stream_trigger(enum MAV_DATA_STREAM stream_num);
+static void stream_updated_cb(UAVObjEvent *ev, void *ctx, void *obj, int len);
+static void receive_requests();
+static void send_heartbeat();
 
 // ****************
 // Private constants
 
-#if defined(PIOS_MAVLINK_STACK_SIZE)
-#define STACK_SIZE_BYTES PIOS_MAVLINK_STACK_SIZE
-#else
-#define STACK_SIZE_BYTES 696
-#endif
-
-#define TASK_PRIORITY               PIOS_THREAD_PRIO_LOW
 #define TASK_RATE_HZ				10
 
+//! Heartbeats go out at least this often, whatever streams are on
+#define HEARTBEAT_RATE_HZ			1
+
+//! Default rate of each stream, until the other end asks for another
 static const uint8_t mav_rates[] =
 	 { [MAV_DATA_STREAM_RAW_SENSORS]=0x02, //2Hz
 	   [MAV_DATA_STREAM_EXTENDED_STATUS]=0x02, //2Hz
@@ -83,19 +84,49 @@ static const uint8_t mav_rates[] =
 
 #define MAXSTREAMS sizeof(mav_rates)
 
+/* Streams that only go out once one of their objects has been updated
+ * since they last did, so a GPS that isn't there costs nothing.  The
+ * rest are sent at their rate regardless. */
+static const bool mav_on_change[MAXSTREAMS] =
+	 { [MAV_DATA_STREAM_RC_CHANNELS]=true,
+	   [MAV_DATA_STREAM_POSITION]=true };
+
+//! Seed of the request's checksum, from MAVLINK_MESSAGE_CRCS
+#define REQUEST_DATA_STREAM_CRC_EXTRA	148
+
+//! The part of a frame kept while receiving, up to the largest we handle
+#define RX_FRAME_LEN	(MAVLINK_NUM_HEADER_BYTES - 1 + \
+			 MAVLINK_MSG_ID_REQUEST_DATA_STREAM_LEN)
+
+struct mav_stream {
+	uint8_t rate;
+	uint8_t ticks;
+	volatile bool updated;
+};
+
+struct mav_rx_state {
+	uint16_t pos;		// bytes of the frame received, 0 while hunting
+	uint16_t crc;
+	uint8_t frame[RX_FRAME_LEN];
+};
+
 // ****************
 // Private variables
 
-static struct pios_thread *uavoMavlinkBridgeTaskHandle;
-
 static uint32_t mavlink_port;
 
 static bool module_enabled = false;
 
-static uint8_t * stream_ticks;
+static struct mav_stream *streams;
+
+static uint8_t heartbeat_ticks;
+
+static struct mav_rx_state *rx_state;
 
 static mavlink_message_t *mav_msg;
 
+static FlightBatterySettingsData batSettings;
+
 static void updateSettings();
 
 /**
@@ -105,12 +136,11 @@ static void updateSettings();
  */
 static int32_t uavoMavlinkBridgeStart(void) {
 	if (module_enabled) {
-		// Start tasks
-		uavoMavlinkBridgeTaskHandle = PIOS_Thread_Create(
-				uavoMavlinkBridgeTask, "uavoMavlinkBridge", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-		TaskMonitorAdd(TASKINFO_RUNNING_UAVOMAVLINKBRIDGE,
-				uavoMavlinkBridgeTaskHandle);
-		return 0;
+		if (FlightBatterySettingsHandle() != NULL )
+			FlightBatterySettingsGet(&batSettings);
+
+		return BridgeTaskAdd(0, 1000 / TASK_RATE_HZ,
+				uavoMavlinkBridgeRun, NULL);
 	}
 	return -1;
 }
@@ -126,13 +156,31 @@ static int32_t uavoMavlinkBridgeInitialize(void) {
 		updateSettings();
 
 		mav_msg = PIOS_malloc(sizeof(*mav_msg));
-		stream_ticks = PIOS_malloc_no_dma(MAXSTREAMS);
+		streams = PIOS_malloc_no_dma(MAXSTREAMS * sizeof(*streams));
+
+		/* The receive side of a port shared with the GPS is the GPS's */
+		if (PIOS_COM_HasRx(mavlink_port) && mavlink_port != PIOS_COM_GPS) {
+			rx_state = PIOS_malloc_no_dma(sizeof(*rx_state));
+			if (rx_state)
+				rx_state->pos = 0;
+		}
 
-		if (mav_msg && stream_ticks) {
+		if (mav_msg && streams) {
 			for (int x = 0; x < MAXSTREAMS; ++x) {
-				stream_ticks[x] = (TASK_RATE_HZ / mav_rates[x]);
+				streams[x].rate = mav_rates[x];
+				streams[x].ticks = 0;
+				streams[x].updated = false;
 			}
 
+			if (GPSPositionHandle() != NULL)
+				GPSPositionConnectCallbackCtx(stream_updated_cb,
+						&streams[MAV_DATA_STREAM_POSITION].updated);
+			if (HomeLocationHandle() != NULL)
+				HomeLocationConnectCallbackCtx(stream_updated_cb,
+						&streams[MAV_DATA_STREAM_POSITION].updated);
+			ManualControlCommandConnectCallbackCtx(stream_updated_cb,
+					&streams[MAV_DATA_STREAM_RC_CHANNELS].updated);
+
 			module_enabled = true;
 		}else {
 			module_enabled = false;
@@ -152,342 +200,472 @@ static void send_message() {
 }
 
 /**
- * Main task. It does not return.
+ * Marks the stream whose updated flag is ctx as having new data
  */
+static void stream_updated_cb(UAVObjEvent *ev, void *ctx, void *obj, int len)
+{
+	(void) ev; (void) obj; (void) len;
 
-static void uavoMavlinkBridgeTask(void *parameters) {
-	uint32_t lastSysTime;
-	// Main task loop
-	lastSysTime = PIOS_Thread_Systime();
+	*(volatile bool *) ctx = true;
+}
 
-	FlightBatterySettingsData batSettings = {};
+/**
+ * Applies a REQUEST_DATA_STREAM: sets the rate of one stream or of all
+ * of them, or stops them.
+ */
+static void handle_request_data_stream(const mavlink_request_data_stream_t *req)
+{
+	uint16_t rate = req->start_stop ? req->req_message_rate : 0;
 
-	if (FlightBatterySettingsHandle() != NULL )
-		FlightBatterySettingsGet(&batSettings);
+	if (rate > TASK_RATE_HZ)
+		rate = TASK_RATE_HZ;
 
-	SystemStatsData systemStats;
+	for (int x = 0; x < MAXSTREAMS; ++x) {
+		if (req->req_stream_id != MAV_DATA_STREAM_ALL &&
+				req->req_stream_id != x)
+			continue;
 
-	while (1) {
-		PIOS_Thread_Sleep_Until(&lastSysTime, 1000 / TASK_RATE_HZ);
+		/* Slots the defaults leave empty aren't streams we have */
+		if (mav_rates[x] == 0)
+			continue;
 
-		if (stream_trigger(MAV_DATA_STREAM_EXTENDED_STATUS)) {
-			FlightBatteryStateData batState = {};
+		streams[x].rate = rate;
+		streams[x].ticks = 0;
+	}
+}
 
-			if (FlightBatteryStateHandle() != NULL )
-				FlightBatteryStateGet(&batState);
+/**
+ * Takes one received byte.  Only whole frames of the messages we handle
+ * are kept and checked; the others are skipped by their length.
+ */
+static void receive_byte(uint8_t c)
+{
+	struct mav_rx_state *rx = rx_state;
 
-			SystemStatsGet(&systemStats);
+	if (rx->pos == 0) {
+		if (c == MAVLINK_STX) {
+			crc_init(&rx->crc);
+			rx->pos = 1;
+		}
+		return;
+	}
 
-			int8_t battery_remaining = 0;
-			if (batSettings.Capacity != 0) {
-				if (batState.ConsumedEnergy < batSettings.Capacity) {
-					battery_remaining = 100 - lroundf(batState.ConsumedEnergy / batSettings.Capacity * 100);
-				}
-			}
+	/* frame[0] is the payload length, frame[4] the message id */
+	uint16_t idx = rx->pos - 1;
 
-			uint16_t voltage = 0;
-			if (batSettings.VoltagePin != FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE)
-				voltage = lroundf(batState.Voltage * 1000);
-
-			uint16_t current = 0;
-			if (batSettings.CurrentPin != FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE)
-				current = lroundf(batState.Current * 100);
-
-			mavlink_msg_sys_status_pack(0, 200, mav_msg,
-					// onboard_control_sensors_present Bitmask showing which onboard controllers and sensors are present. Value of 0: not present. Value of 1: present. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
-					0,
-					// onboard_control_sensors_enabled Bitmask showing which onboard controllers and sensors are enabled:  Value of 0: not enabled. Value of 1: enabled. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
-					0,
-					// onboard_control_sensors_health Bitmask showing which onboard controllers and sensors are operational or have an error:  Value of 0: not enabled. Value of 1: enabled. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
-					0,
-					// load Maximum usage in percent of the mainloop time, (0%: 0, 100%: 1000) should be always below 1000
-					(uint16_t)systemStats.CPULoad * 10,
-					// voltage_battery Battery voltage, in millivolts (1 = 1 millivolt)
-					voltage,
-					// current_battery Battery current, in 10*milliamperes (1 = 10 milliampere), -1: autopilot does not measure the current
-					current,
-					// battery_remaining Remaining battery energy: (0%: 0, 100%: 100), -1: autopilot estimate the remaining battery
-					battery_remaining,
-					// drop_rate_comm Communication drops in percent, (0%: 0, 100%: 10'000), (UART, I2C, SPI, CAN), dropped packets on all links (packets that were corrupted on reception on the MAV)
-					0,
-					// errors_comm Communication errors (UART, I2C, SPI, CAN), dropped packets on all links (packets that were corrupted on reception on the MAV)
-					0,
-					// errors_count1 Autopilot-specific errors
-					0,
-					// errors_count2 Autopilot-specific errors
-					0,
-					// errors_count3 Autopilot-specific errors
-					0,
-					// errors_count4 Autopilot-specific errors
-					0);
-
-			send_message();
-		}
+	if (idx < RX_FRAME_LEN)
+		rx->frame[idx] = c;
 
-		if (stream_trigger(MAV_DATA_STREAM_RC_CHANNELS)) {
-			ManualControlCommandData manualState;
-			FlightStatusData flightStatus;
-
-			ManualControlCommandGet(&manualState);
-			FlightStatusGet(&flightStatus);
-			SystemStatsGet(&systemStats);
-
-			//TODO connect with RSSI object and pass in last argument
-			mavlink_msg_rc_channels_raw_pack(0, 200, mav_msg,
-					// time_boot_ms Timestamp (milliseconds since system boot)
-					systemStats.FlightTime,
-					// port Servo output port (set of 8 outputs = 1 port). Most MAVs will just use one, but this allows to encode more than 8 servos.
-					0,
-					// chan1_raw RC channel 1 value, in microseconds
-					manualState.Channel[0],
-					// chan2_raw RC channel 2 value, in microseconds
-					manualState.Channel[1],
-					// chan3_raw RC channel 3 value, in microseconds
-					manualState.Channel[2],
-					// chan4_raw RC channel 4 value, in microseconds
-					manualState.Channel[3],
-					// chan5_raw RC channel 5 value, in microseconds
-					manualState.Channel[4],
-					// chan6_raw RC channel 6 value, in microseconds
-					manualState.Channel[5],
-					// chan7_raw RC channel 7 value, in microseconds
-					manualState.Channel[6],
-					// chan8_raw RC channel 8 value, in microseconds
-					manualState.Channel[7],
-					// rssi Receive signal strength indicator, 0: 0%, 255: 100%
-					manualState.Rssi);
-
-			send_message();
-		}
+	rx->pos++;
 
-		if (stream_trigger(MAV_DATA_STREAM_POSITION)) {
-			GPSPositionData gpsPosData = {};
-			HomeLocationData homeLocation = {};
-			SystemStatsGet(&systemStats);
-
-			if (GPSPositionHandle() != NULL )
-				GPSPositionGet(&gpsPosData);
-			if (HomeLocationHandle() != NULL )
-				HomeLocationGet(&homeLocation);
-			SystemStatsGet(&systemStats);
-
-			uint8_t gps_fix_type;
-			switch (gpsPosData.Status)
-			{
-			case GPSPOSITION_STATUS_NOGPS:
-				gps_fix_type = 0;
-				break;
-			case GPSPOSITION_STATUS_NOFIX:
-				gps_fix_type = 1;
-				break;
-			case GPSPOSITION_STATUS_FIX2D:
-				gps_fix_type = 2;
-				break;
-			case GPSPOSITION_STATUS_FIX3D:
-			case GPSPOSITION_STATUS_DIFF3D:
-				gps_fix_type = 3;
-				break;
-			default:
-				gps_fix_type = 0;
-				break;
-			}
+	uint16_t crc_idx = MAVLINK_NUM_HEADER_BYTES - 1 + rx->frame[0];
 
-			mavlink_msg_gps_raw_int_pack(0, 200, mav_msg,
-					// time_usec Timestamp (microseconds since UNIX epoch or microseconds since system boot)
-					(uint64_t)systemStats.FlightTime * 1000,
-					// fix_type 0-1: no fix, 2: 2D fix, 3: 3D fix. Some applications will not use the value of this field unless it is at least two, so always correctly fill in the fix.
-					gps_fix_type,
-					// lat Latitude in 1E7 degrees
-					gpsPosData.Latitude,
-					// lon Longitude in 1E7 degrees
-					gpsPosData.Longitude,
-					// alt Altitude in 1E3 meters (millimeters) above MSL
-					gpsPosData.Altitude * 1000,
-					// eph GPS HDOP horizontal dilution of position in cm (m*100). If unknown, set to: 65535
-					gpsPosData.HDOP * 100,
-					// epv GPS VDOP horizontal dilution of position in cm (m*100). If unknown, set to: 65535
-					gpsPosData.VDOP * 100,
-					// vel GPS ground speed (m/s * 100). If unknown, set to: 65535
-					gpsPosData.Groundspeed * 100,
-					// cog Course over ground (NOT heading, but direction of movement) in degrees * 100, 0.0..359.99 degrees. If unknown, set to: 65535
-					gpsPosData.Heading * 100,
-					// satellites_visible Number of satellites visible. If unknown, set to 255
-					gpsPosData.Satellites);
-
-			send_message();
-
-			mavlink_msg_gps_global_origin_pack(0, 200, mav_msg,
-					// latitude Latitude (WGS84), expressed as * 1E7
-					homeLocation.Latitude,
-					// longitude Longitude (WGS84), expressed as * 1E7
-					homeLocation.Longitude,
-					// altitude Altitude(WGS84), expressed as * 1000
-					homeLocation.Altitude * 1000);
-
-			send_message();
-
-			//TODO add waypoint nav stuff
-			//wp_target_bearing
-			//wp_dist = mavlink_msg_nav_controller_output_get_wp_dist(&msg);
-			//alt_error = mavlink_msg_nav_controller_output_get_alt_error(&msg);
-			//aspd_error = mavlink_msg_nav_controller_output_get_aspd_error(&msg);
-			//xtrack_error = mavlink_msg_nav_controller_output_get_xtrack_error(&msg);
-			//mavlink_msg_nav_controller_output_pack
-			//wp_number
-			//mavlink_msg_mission_current_pack
-		}
+	if (idx < crc_idx) {
+		crc_accumulate(c, &rx->crc);
+		return;
+	}
+
+	bool wanted = rx->frame[4] == MAVLINK_MSG_ID_REQUEST_DATA_STREAM &&
+		rx->frame[0] == MAVLINK_MSG_ID_REQUEST_DATA_STREAM_LEN;
 
-		if (stream_trigger(MAV_DATA_STREAM_EXTRA1)) {
-			AttitudeActualData attActual;
-			SystemStatsData systemStats;
-
-			AttitudeActualGet(&attActual);
-			SystemStatsGet(&systemStats);
-
-			mavlink_msg_attitude_pack(0, 200, mav_msg,
-					// time_boot_ms Timestamp (milliseconds since system boot)
-					systemStats.FlightTime,
-					// roll Roll angle (rad)
-					attActual.Roll * DEG2RAD,
-					// pitch Pitch angle (rad)
-					attActual.Pitch * DEG2RAD,
-					// yaw Yaw angle (rad)
-					attActual.Yaw * DEG2RAD,
-					// rollspeed Roll angular speed (rad/s)
-					0,
-					// pitchspeed Pitch angular speed (rad/s)
-					0,
-					// yawspeed Yaw angular speed (rad/s)
-					0);
-
-			send_message();
+	if (idx == crc_idx) {
+		if (wanted) {
+			crc_accumulate(REQUEST_DATA_STREAM_CRC_EXTRA, &rx->crc);
+
+			if (c != (rx->crc & 0xff))
+				rx->pos = 0;
 		}
 
-		if (stream_trigger(MAV_DATA_STREAM_EXTRA2)) {
-			ActuatorDesiredData actDesired;
-			AttitudeActualData attActual;
-			AirspeedActualData airspeedActual = {};
-			GPSPositionData gpsPosData = {};
-			BaroAltitudeData baroAltitude = {};
-			FlightStatusData flightStatus;
-
-			if (AirspeedActualHandle() != NULL )
-				AirspeedActualGet(&airspeedActual);
-			if (GPSPositionHandle() != NULL )
-				GPSPositionGet(&gpsPosData);
-			if (BaroAltitudeHandle() != NULL )
-				BaroAltitudeGet(&baroAltitude);
-			ActuatorDesiredGet(&actDesired);
-			AttitudeActualGet(&attActual);
-			FlightStatusGet(&flightStatus);
-
-			float altitude = 0;
-			if (BaroAltitudeHandle() != NULL)
-				altitude = baroAltitude.Altitude;
-			else if (GPSPositionHandle() != NULL)
-				altitude = gpsPosData.Altitude;
-
-			// round attActual.Yaw to nearest int and transfer from (-180 ... 180) to (0 ... 360)
-			int16_t heading = lroundf(attActual.Yaw);
-			if (heading < 0)
-				heading += 360;
-
-			mavlink_msg_vfr_hud_pack(0, 200, mav_msg,
-					// airspeed Current airspeed in m/s
-					airspeedActual.TrueAirspeed,
-					// groundspeed Current ground speed in m/s
-					gpsPosData.Groundspeed,
-					// heading Current heading in degrees, in compass units (0..360, 0=north)
-					heading,
-					// throttle Current throttle setting in integer percent, 0 to 100
-					actDesired.Thrust * 100,
-					// alt Current altitude (MSL), in meters
-					altitude,
-					// climb Current climb rate in meters/second
-					0);
-
-			send_message();
-
-			uint8_t armed_mode = 0;
-			if (flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED)
-				armed_mode |= MAV_MODE_FLAG_SAFETY_ARMED;
-
-			uint8_t custom_mode = CUSTOM_MODE_STAB;
-
-			switch (flightStatus.FlightMode) {
-				case FLIGHTSTATUS_FLIGHTMODE_MANUAL:
-				case FLIGHTSTATUS_FLIGHTMODE_VIRTUALBAR:
-				case FLIGHTSTATUS_FLIGHTMODE_HORIZON:
-					/* Kinda a catch all */
-					custom_mode = CUSTOM_MODE_SPORT;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_ACRO:
-				case FLIGHTSTATUS_FLIGHTMODE_AXISLOCK:
-					custom_mode = CUSTOM_MODE_ACRO;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_STABILIZED1:
-				case FLIGHTSTATUS_FLIGHTMODE_STABILIZED2:
-				case FLIGHTSTATUS_FLIGHTMODE_STABILIZED3:
-					/* May want these three to try and
-					 * infer based on roll axis */
-				case FLIGHTSTATUS_FLIGHTMODE_LEVELING:
-					custom_mode = CUSTOM_MODE_STAB;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_AUTOTUNE:
-					custom_mode = CUSTOM_MODE_DRIFT;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_ALTITUDEHOLD:
-					custom_mode = CUSTOM_MODE_ALTH;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_RETURNTOHOME:
-					custom_mode = CUSTOM_MODE_RTL;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_TABLETCONTROL:
-				case FLIGHTSTATUS_FLIGHTMODE_POSITIONHOLD:
-					custom_mode = CUSTOM_MODE_POSH;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_FAILSAFE:
-					/* (make it clear we're in charge) */
-				case FLIGHTSTATUS_FLIGHTMODE_PATHPLANNER:
-					custom_mode = CUSTOM_MODE_AUTO;
-					break;
+		return;
+	}
+
+	rx->pos = 0;
+
+	if (!wanted || c != (rx->crc >> 8))
+		return;
+
+	mavlink_request_data_stream_t req;
+	memcpy(&req, &rx->frame[MAVLINK_NUM_HEADER_BYTES - 1], sizeof(req));
+
+	handle_request_data_stream(&req);
+}
+
+/**
+ * Handles whatever the other end has sent since the last step
+ */
+static void receive_requests()
+{
+	uint8_t buf[16];
+	uint16_t len;
+
+	while ((len = PIOS_COM_ReceiveBuffer(mavlink_port, buf, sizeof(buf), 0)) > 0) {
+		for (uint16_t i = 0; i < len; i++)
+			receive_byte(buf[i]);
+	}
+}
+
+/**
+ * Bridge step, run from the shared bridge task at TASK_RATE_HZ
+ * @param[in] ctx unused
+ * @return true, to keep running
+ */
+static bool uavoMavlinkBridgeRun(void *ctx) {
+	(void) ctx;
+
+	SystemStatsData systemStats;
+
+	if (rx_state)
+		receive_requests();
+
+	if (stream_trigger(MAV_DATA_STREAM_EXTENDED_STATUS)) {
+		FlightBatteryStateData batState = {};
+
+		if (FlightBatteryStateHandle() != NULL )
+			FlightBatteryStateGet(&batState);
+
+		SystemStatsGet(&systemStats);
+
+		int8_t battery_remaining = 0;
+		if (batSettings.Capacity != 0) {
+			if (batState.ConsumedEnergy < batSettings.Capacity) {
+				battery_remaining = 100 - lroundf(batState.ConsumedEnergy / batSettings.Capacity * 100);
 			}
+		}
+
+		uint16_t voltage = 0;
+		if (batSettings.VoltagePin != FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE)
+			voltage = lroundf(batState.Voltage * 1000);
+
+		uint16_t current = 0;
+		if (batSettings.CurrentPin != FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE)
+			current = lroundf(batState.Current * 100);
+
+		mavlink_msg_sys_status_pack(0, 200, mav_msg,
+				// onboard_control_sensors_present Bitmask showing which onboard controllers and sensors are present. Value of 0: not present. Value of 1: present. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
+				0,
+				// onboard_control_sensors_enabled Bitmask showing which onboard controllers and sensors are enabled:  Value of 0: not enabled. Value of 1: enabled. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
+				0,
+				// onboard_control_sensors_health Bitmask showing which onboard controllers and sensors are operational or have an error:  Value of 0: not enabled. Value of 1: enabled. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
+				0,
+				// load Maximum usage in percent of the mainloop time, (0%: 0, 100%: 1000) should be always below 1000
+				(uint16_t)systemStats.CPULoad * 10,
+				// voltage_battery Battery voltage, in millivolts (1 = 1 millivolt)
+				voltage,
+				// current_battery Battery current, in 10*milliamperes (1 = 10 milliampere), -1: autopilot does not measure the current
+				current,
+				// battery_remaining Remaining battery energy: (0%: 0, 100%: 100), -1: autopilot estimate the remaining battery
+				battery_remaining,
+				// drop_rate_comm Communication drops in percent, (0%: 0, 100%: 10'000), (UART, I2C, SPI, CAN), dropped packets on all links (packets that were corrupted on reception on the MAV)
+				0,
+				// errors_comm Communication errors (UART, I2C, SPI, CAN), dropped packets on all links (packets that were corrupted on reception on the MAV)
+				0,
+				// errors_count1 Autopilot-specific errors
+				0,
+				// errors_count2 Autopilot-specific errors
+				0,
+				// errors_count3 Autopilot-specific errors
+				0,
+				// errors_count4 Autopilot-specific errors
+				0);
+
+		send_message();
+	}
+
+	if (stream_trigger(MAV_DATA_STREAM_RC_CHANNELS)) {
+		ManualControlCommandData manualState;
+		FlightStatusData flightStatus;
+
+		ManualControlCommandGet(&manualState);
+		FlightStatusGet(&flightStatus);
+		SystemStatsGet(&systemStats);
+
+		//TODO connect with RSSI object and pass in last argument
+		mavlink_msg_rc_channels_raw_pack(0, 200, mav_msg,
+				// time_boot_ms Timestamp (milliseconds since system boot)
+				systemStats.FlightTime,
+				// port Servo output port (set of 8 outputs = 1 port). Most MAVs will just use one, but this allows to encode more than 8 servos.
+				0,
+				// chan1_raw RC channel 1 value, in microseconds
+				manualState.Channel[0],
+				// chan2_raw RC channel 2 value, in microseconds
+				manualState.Channel[1],
+				// chan3_raw RC channel 3 value, in microseconds
+				manualState.Channel[2],
+				// chan4_raw RC channel 4 value, in microseconds
+				manualState.Channel[3],
+				// chan5_raw RC channel 5 value, in microseconds
+				manualState.Channel[4],
+				// chan6_raw RC channel 6 value, in microseconds
+				manualState.Channel[5],
+				// chan7_raw RC channel 7 value, in microseconds
+				manualState.Channel[6],
+				// chan8_raw RC channel 8 value, in microseconds
+				manualState.Channel[7],
+				// rssi Receive signal strength indicator, 0: 0%, 255: 100%
+				manualState.Rssi);
+
+		send_message();
+	}
 
-			mavlink_msg_heartbeat_pack(0, 200, mav_msg,
-					// type Type of the MAV (quadrotor, helicopter, etc., up to 15 types, defined in MAV_TYPE ENUM)
-					MAV_TYPE_GENERIC,
-					// autopilot Autopilot type / class. defined in MAV_AUTOPILOT ENUM
-					MAV_AUTOPILOT_GENERIC,
-					// base_mode System mode bitfield, see MAV_MODE_FLAGS ENUM in mavlink/include/mavlink_types.h
-					armed_mode,
-					// custom_mode A bitfield for use for autopilot-specific flags.
-					custom_mode,
-					// system_status System status flag, see MAV_STATE ENUM
-					0);
-
-			send_message();
+	if (stream_trigger(MAV_DATA_STREAM_POSITION)) {
+		GPSPositionData gpsPosData = {};
+		HomeLocationData homeLocation = {};
+		SystemStatsGet(&systemStats);
+
+		if (GPSPositionHandle() != NULL )
+			GPSPositionGet(&gpsPosData);
+		if (HomeLocationHandle() != NULL )
+			HomeLocationGet(&homeLocation);
+		SystemStatsGet(&systemStats);
+
+		uint8_t gps_fix_type;
+		switch (gpsPosData.Status)
+		{
+		case GPSPOSITION_STATUS_NOGPS:
+			gps_fix_type = 0;
+			break;
+		case GPSPOSITION_STATUS_NOFIX:
+			gps_fix_type = 1;
+			break;
+		case GPSPOSITION_STATUS_FIX2D:
+			gps_fix_type = 2;
+			break;
+		case GPSPOSITION_STATUS_FIX3D:
+		case GPSPOSITION_STATUS_DIFF3D:
+			gps_fix_type = 3;
+			break;
+		default:
+			gps_fix_type = 0;
+			break;
 		}
+
+		mavlink_msg_gps_raw_int_pack(0, 200, mav_msg,
+				// time_usec Timestamp (microseconds since UNIX epoch or microseconds since system boot)
+				(uint64_t)systemStats.FlightTime * 1000,
+				// fix_type 0-1: no fix, 2: 2D fix, 3: 3D fix. Some applications will not use the value of this field unless it is at least two, so always correctly fill in the fix.
+				gps_fix_type,
+				// lat Latitude in 1E7 degrees
+				gpsPosData.Latitude,
+				// lon Longitude in 1E7 degrees
+				gpsPosData.Longitude,
+				// alt Altitude in 1E3 meters (millimeters) above MSL
+				gpsPosData.Altitude * 1000,
+				// eph GPS HDOP horizontal dilution of position in cm (m*100). If unknown, set to: 65535
+				gpsPosData.HDOP * 100,
+				// epv GPS VDOP horizontal dilution of position in cm (m*100). If unknown, set to: 65535
+				gpsPosData.VDOP * 100,
+				// vel GPS ground speed (m/s * 100). If unknown, set to: 65535
+				gpsPosData.Groundspeed * 100,
+				// cog Course over ground (NOT heading, but direction of movement) in degrees * 100, 0.0..359.99 degrees. If unknown, set to: 65535
+				gpsPosData.Heading * 100,
+				// satellites_visible Number of satellites visible. If unknown, set to 255
+				gpsPosData.Satellites);
+
+		send_message();
+
+		mavlink_msg_gps_global_origin_pack(0, 200, mav_msg,
+				// latitude Latitude (WGS84), expressed as * 1E7
+				homeLocation.Latitude,
+				// longitude Longitude (WGS84), expressed as * 1E7
+				homeLocation.Longitude,
+				// altitude Altitude(WGS84), expressed as * 1000
+				homeLocation.Altitude * 1000);
+
+		send_message();
+
+		//TODO add waypoint nav stuff
+		//wp_target_bearing
+		//wp_dist = mavlink_msg_nav_controller_output_get_wp_dist(&msg);
+		//alt_error = mavlink_msg_nav_controller_output_get_alt_error(&msg);
+		//aspd_error = mavlink_msg_nav_controller_output_get_aspd_error(&msg);
+		//xtrack_error = mavlink_msg_nav_controller_output_get_xtrack_error(&msg);
+		//mavlink_msg_nav_controller_output_pack
+		//wp_number
+		//mavlink_msg_mission_current_pack
+	}
+
+	if (stream_trigger(MAV_DATA_STREAM_EXTRA1)) {
+		AttitudeActualData attActual;
+		SystemStatsData systemStats;
+
+		AttitudeActualGet(&attActual);
+		SystemStatsGet(&systemStats);
+
+		mavlink_msg_attitude_pack(0, 200, mav_msg,
+				// time_boot_ms Timestamp (milliseconds since system boot)
+				systemStats.FlightTime,
+				// roll Roll angle (rad)
+				attActual.Roll * DEG2RAD,
+				// pitch Pitch angle (rad)
+				attActual.Pitch * DEG2RAD,
+				// yaw Yaw angle (rad)
+				attActual.Yaw * DEG2RAD,
+				// rollspeed Roll angular speed (rad/s)
+				0,
+				// pitchspeed Pitch angular speed (rad/s)
+				0,
+				// yawspeed Yaw angular speed (rad/s)
+				0);
+
+		send_message();
+	}
+
+	bool extra2 = stream_trigger(MAV_DATA_STREAM_EXTRA2);
+
+	if (extra2) {
+		ActuatorDesiredData actDesired;
+		AttitudeActualData attActual;
+		AirspeedActualData airspeedActual = {};
+		GPSPositionData gpsPosData = {};
+		BaroAltitudeData baroAltitude = {};
+
+		if (AirspeedActualHandle() != NULL )
+			AirspeedActualGet(&airspeedActual);
+		if (GPSPositionHandle() != NULL )
+			GPSPositionGet(&gpsPosData);
+		if (BaroAltitudeHandle() != NULL )
+			BaroAltitudeGet(&baroAltitude);
+		ActuatorDesiredGet(&actDesired);
+		AttitudeActualGet(&attActual);
+
+		float altitude = 0;
+		if (BaroAltitudeHandle() != NULL)
+			altitude = baroAltitude.Altitude;
+		else if (GPSPositionHandle() != NULL)
+			altitude = gpsPosData.Altitude;
+
+		// round attActual.Yaw to nearest int and transfer from (-180 ... 180) to (0 ... 360)
+		int16_t heading = lroundf(attActual.Yaw);
+		if (heading < 0)
+			heading += 360;
+
+		mavlink_msg_vfr_hud_pack(0, 200, mav_msg,
+				// airspeed Current airspeed in m/s
+				airspeedActual.TrueAirspeed,
+				// groundspeed Current ground speed in m/s
+				gpsPosData.Groundspeed,
+				// heading Current heading in degrees, in compass units (0..360, 0=north)
+				heading,
+				// throttle Current throttle setting in integer percent, 0 to 100
+				actDesired.Thrust * 100,
+				// alt Current altitude (MSL), in meters
+				altitude,
+				// climb Current climb rate in meters/second
+				0);
+
+		send_message();
 	}
+
+	/* Heartbeats go with EXTRA2, and on their own when it's off */
+	if (extra2 || heartbeat_ticks == 0) {
+		send_heartbeat();
+		heartbeat_ticks = TASK_RATE_HZ / HEARTBEAT_RATE_HZ;
+	}
+
+	heartbeat_ticks--;
+
+	return true;
 }
 
+/**
+ * Sends a heartbeat, with the arming state and flight mode
+ */
+static void send_heartbeat()
+{
+	FlightStatusData flightStatus;
+
+	FlightStatusGet(&flightStatus);
+
+	uint8_t armed_mode = 0;
+	if (flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED)
+		armed_mode |= MAV_MODE_FLAG_SAFETY_ARMED;
+
+	uint8_t custom_mode = CUSTOM_MODE_STAB;
+
+	switch (flightStatus.FlightMode) {
+		case FLIGHTSTATUS_FLIGHTMODE_MANUAL:
+		case FLIGHTSTATUS_FLIGHTMODE_VIRTUALBAR:
+		case FLIGHTSTATUS_FLIGHTMODE_HORIZON:
+			/* Kinda a catch all */
+			custom_mode = CUSTOM_MODE_SPORT;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_ACRO:
+		case FLIGHTSTATUS_FLIGHTMODE_AXISLOCK:
+			custom_mode = CUSTOM_MODE_ACRO;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_STABILIZED1:
+		case FLIGHTSTATUS_FLIGHTMODE_STABILIZED2:
+		case FLIGHTSTATUS_FLIGHTMODE_STABILIZED3:
+			/* May want these three to try and
+			 * infer based on roll axis */
+		case FLIGHTSTATUS_FLIGHTMODE_LEVELING:
+			custom_mode = CUSTOM_MODE_STAB;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_AUTOTUNE:
+			custom_mode = CUSTOM_MODE_DRIFT;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_ALTITUDEHOLD:
+			custom_mode = CUSTOM_MODE_ALTH;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_RETURNTOHOME:
+			custom_mode = CUSTOM_MODE_RTL;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_TABLETCONTROL:
+		case FLIGHTSTATUS_FLIGHTMODE_POSITIONHOLD:
+			custom_mode = CUSTOM_MODE_POSH;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_FAILSAFE:
+			/* (make it clear we're in charge) */
+		case FLIGHTSTATUS_FLIGHTMODE_PATHPLANNER:
+			custom_mode = CUSTOM_MODE_AUTO;
+			break;
+	}
+
+	mavlink_msg_heartbeat_pack(0, 200, mav_msg,
+			// type Type of the MAV (quadrotor, helicopter, etc., up to 15 types, defined in MAV_TYPE ENUM)
+			MAV_TYPE_GENERIC,
+			// autopilot Autopilot type / class. defined in MAV_AUTOPILOT ENUM
+			MAV_AUTOPILOT_GENERIC,
+			// base_mode System mode bitfield, see MAV_MODE_FLAGS ENUM in mavlink/include/mavlink_types.h
+			armed_mode,
+			// custom_mode A bitfield for use for autopilot-specific flags.
+			custom_mode,
+			// system_status System status flag, see MAV_STATE ENUM
+			0);
+
+	send_message();
+}
+
+/**
+ * Whether a stream is due to be sent this step
+ * @param[in] stream_num the stream
+ * @return true if it should be sent now
+ */
 static bool stream_trigger(enum MAV_DATA_STREAM stream_num) {
-	uint8_t rate = (uint8_t) mav_rates[stream_num];
+	struct mav_stream *stream = &streams[stream_num];
+	uint8_t rate = stream->rate;
 
 	if (rate == 0) {
 		return false;
 	}
 
-	if (stream_ticks[stream_num] == 0) {
+	if (stream->ticks == 0) {
+		/* Nothing new: stay due, to go as soon as something is */
+		if (mav_on_change[stream_num] && !stream->updated) {
+			return false;
+		}
+
 		// we're triggering now, setup the next trigger point
 		if (rate > TASK_RATE_HZ) {
 			rate = TASK_RATE_HZ;
 		}
-		stream_ticks[stream_num] = (TASK_RATE_HZ / rate);
+		stream->ticks = (TASK_RATE_HZ / rate) - 1;
+		stream->updated = false;
 		return true;
 	}
 
-	// count down at 50Hz
-	stream_ticks[stream_num]--;
+	// count down at TASK_RATE_HZ
+	stream->ticks--;
 	return false;
 }
 
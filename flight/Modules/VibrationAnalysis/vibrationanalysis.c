@@ -34,10 +34,16 @@
  * This module executes on a timer trigger. When the module is
  * triggered it will update the data of VibrationAnalysiOutput,
  * with the accumulated accelerometer samples. 
+ *
+ * With OutputMode set to Spectrum the samples are kept on board instead:
+ * each window is Hann windowed and transformed, Welch averaged with the
+ * half-overlapping windows around it, and only @ref VibrationAnalysisSpectrum
+ * (the RMS acceleration in 16 bands and the peak of each axis) is sent.
  */
 
 #include "openpilot.h"
 #include "physical_constants.h"
+#include "misc_math.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
 
@@ -45,13 +51,15 @@
 #include "modulesettings.h"
 #include "vibrationanalysisoutput.h"
 #include "vibrationanalysissettings.h"
+#include "vibrationanalysisspectrum.h"
 
 
 // Private constants
 
 #define MAX_QUEUE_SIZE 2
 
-#define STACK_SIZE_BYTES (200 + 448 + 16 + (2*3*window_size)*0) // The memory requirement grows linearly 
+// 256 of it is for the spectrum being published
+#define STACK_SIZE_BYTES (200 + 448 + 16 + 256 + (2*3*window_size)*0) // The memory requirement grows linearly 
 																				  // with window size. The constant is multiplied
 																				  // by 0 in order to reflect the fact that the
 																				  // malloc'ed memory is not taken from the module 
@@ -64,6 +72,7 @@
 #define MAX_ACCEL_RANGE 16                          // Maximum accelerometer resolution in [g]
 #define FLOAT_TO_FIXED (32768/(MAX_ACCEL_RANGE*2)-1) // This is the scaling constant that scales input floats
 #define VIBRATION_ELEMENTS_COUNT 16  // Number of elements per object Instance
+#define SPECTRUM_BANDS_COUNT 16      // Bands in VibrationAnalysisSpectrum
 
 #define MAX_WINDOW_SIZE 1024
 
@@ -78,6 +87,7 @@ static struct pios_thread *taskHandle;
 static TaskInfoRunningElem task;
 static struct pios_queue *queue;
 static bool module_enabled = false;
+static uint8_t output_mode = VIBRATIONANALYSISSETTINGS_OUTPUTMODE_SAMPLES;
 
 static struct VibrationAnalysis_data {
 	uint16_t accels_sum_count;
@@ -98,9 +108,25 @@ static struct VibrationAnalysis_data {
 	int16_t *accel_buffer_z;
 } *vtd;
 
+/* Spectrum mode state, which outlives vtd being cleared on settings
+ * changes so the buffers can be reused. The buffers take 16 bytes for
+ * each sample of the largest window used so far: 16kB for 1024. */
+static struct VibrationAnalysis_spectrum {
+	uint16_t capacity;      // window the buffers were allocated for
+	uint16_t fill;          // samples of the current window collected
+	uint16_t segments;      // windows added into power
+	uint16_t averages;      // windows in each published spectrum
+
+	int16_t *samples;       // 3 x capacity, fixed point as the output
+	float *work;            // capacity
+	float *power;           // 3 x capacity / 2, mean square per bin
+} *vsd;
+
 
 // Private functions
 static void VibrationAnalysisTask(void *parameters);
+static int32_t VibrationAnalysisSpectrumStart(uint16_t window_size, bool reset);
+static bool VibrationAnalysisSpectrumAdd(float x, float y, float z, uint16_t sampleRate_ms);
 
 /*
 *   Releases any memory dinamically allocated
@@ -193,6 +219,22 @@ static int32_t VibrationAnalysisStart(void)
             break;
     }
 
+    uint8_t new_output_mode;
+    VibrationAnalysisSettingsOutputModeGet(&new_output_mode);
+
+    if (new_output_mode == VIBRATIONANALYSISSETTINGS_OUTPUTMODE_SPECTRUM) {
+        bool reset = output_mode != new_output_mode || window_size != vtd->window_size;
+
+        if (VibrationAnalysisSpectrumStart(window_size, reset) != 0) {
+            VibrationAnalysisCleanup();
+
+            module_enabled = false;
+            return -1;
+        }
+    }
+
+    output_mode = new_output_mode;
+
     // Is the new window size different?
     // Will happen upon initialization and when the window size changes
     if (window_size != vtd->window_size) {
@@ -294,6 +336,256 @@ static int32_t VibrationAnalysisStart(void)
 }
 
 
+/**
+ * In-place radix-2 FFT of complex values stored re, im, re, im...
+ * @param[in,out] d the values
+ * @param[in] n how many, a power of two
+ */
+static void fft_complex(float *d, uint16_t n)
+{
+	for (uint16_t i = 1, j = 0; i < n; i++) {
+		uint16_t bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+
+		if (i < j) {
+			float t = d[2 * i];
+			d[2 * i] = d[2 * j];
+			d[2 * j] = t;
+			t = d[2 * i + 1];
+			d[2 * i + 1] = d[2 * j + 1];
+			d[2 * j + 1] = t;
+		}
+	}
+
+	for (uint16_t len = 2; len <= n; len <<= 1) {
+		// Twiddles by rotation, which for 512 steps stays well inside float precision
+		float step_re = cosf(-2 * PI / len);
+		float step_im = sinf(-2 * PI / len);
+
+		for (uint16_t i = 0; i < n; i += len) {
+			float w_re = 1, w_im = 0;
+
+			for (uint16_t k = 0; k < len / 2; k++) {
+				float *a = &d[2 * (i + k)];
+				float *b = &d[2 * (i + k + len / 2)];
+
+				float t_re = b[0] * w_re - b[1] * w_im;
+				float t_im = b[0] * w_im + b[1] * w_re;
+
+				b[0] = a[0] - t_re;
+				b[1] = a[1] - t_im;
+				a[0] += t_re;
+				a[1] += t_im;
+
+				float t = w_re * step_re - w_im * step_im;
+				w_im = w_re * step_im + w_im * step_re;
+				w_re = t;
+			}
+		}
+	}
+}
+
+/**
+ * Power of each frequency below Nyquist of a real signal, from a complex
+ * FFT of half its length over the even and odd samples
+ * @param[in,out] d the n samples, overwritten
+ * @param[in] n how many, a power of two
+ * @param[in,out] power n/2 sums that scale * |X[k]|^2 is added to
+ * @param[in] scale to multiply the power by
+ */
+static void fft_real_power_add(float *d, uint16_t n, float *power, float scale)
+{
+	uint16_t half = n / 2;
+
+	fft_complex(d, half);
+
+	power[0] += (d[0] + d[1]) * (d[0] + d[1]) * scale;
+
+	float step_re = cosf(2 * PI / n);
+	float step_im = sinf(2 * PI / n);
+	float c = step_re, s = step_im;
+
+	for (uint16_t k = 1; k < half; k++) {
+		const float *a = &d[2 * k];
+		const float *b = &d[2 * (half - k)];
+
+		// Spectra of the even and odd samples
+		float e_re = (a[0] + b[0]) / 2;
+		float e_im = (a[1] - b[1]) / 2;
+		float o_re = (a[1] + b[1]) / 2;
+		float o_im = (b[0] - a[0]) / 2;
+
+		float x_re = e_re + c * o_re + s * o_im;
+		float x_im = e_im + c * o_im - s * o_re;
+
+		power[k] += (x_re * x_re + x_im * x_im) * scale;
+
+		float t = c * step_re - s * step_im;
+		s = c * step_im + s * step_re;
+		c = t;
+	}
+}
+
+/**
+ * Set up spectrum mode for a window size, allocating the buffers if
+ * the ones there are too small
+ * @param[in] window_size samples per FFT
+ * @param[in] reset start again rather than carry on with the window
+ * @return 0 on success, -1 if it won't fit in memory
+ */
+static int32_t VibrationAnalysisSpectrumStart(uint16_t window_size, bool reset)
+{
+	if (vsd == NULL) {
+		vsd = PIOS_malloc(sizeof(*vsd));
+		if (vsd == NULL)
+			return -1;
+
+		memset(vsd, 0, sizeof(*vsd));
+	}
+
+	if (vsd->capacity < window_size) {
+#ifdef PIOS_FREE_IMPLEMENTED
+		PIOS_free(vsd->samples);
+		PIOS_free(vsd->work);
+		PIOS_free(vsd->power);
+#endif
+		vsd->capacity = 0;
+
+		vsd->samples = PIOS_malloc(3 * window_size * sizeof(*vsd->samples));
+		vsd->work = PIOS_malloc(window_size * sizeof(*vsd->work));
+		vsd->power = PIOS_malloc(3 * window_size / 2 * sizeof(*vsd->power));
+
+		if (vsd->samples == NULL || vsd->work == NULL || vsd->power == NULL)
+			return -1;
+
+		vsd->capacity = window_size;
+		reset = true;
+	}
+
+	uint8_t averages;
+	VibrationAnalysisSettingsWelchAveragesGet(&averages);
+	vsd->averages = averages > 0 ? averages : 1;
+
+	if (reset) {
+		vsd->fill = 0;
+		vsd->segments = 0;
+		memset(vsd->power, 0, 3 * window_size / 2 * sizeof(*vsd->power));
+	}
+
+	return 0;
+}
+
+/**
+ * Work out and publish the spectrum from the averaged power
+ * @param[in] sampleRate_ms sample period
+ */
+static void VibrationAnalysisSpectrumPublish(uint16_t sampleRate_ms)
+{
+	uint16_t n = vtd->window_size;
+	uint16_t half = n / 2;
+	uint16_t bands = MIN(SPECTRUM_BANDS_COUNT, half);
+	uint16_t bins_per_band = half / bands;
+	float bin_hz = 1000.0f / sampleRate_ms / n;
+
+	VibrationAnalysisSpectrumData spectrum;
+	memset(&spectrum, 0, sizeof(spectrum));
+
+	float *bands_out[3] = { spectrum.x, spectrum.y, spectrum.z };
+
+	for (int axis = 0; axis < 3; axis++) {
+		float *power = &vsd->power[axis * half];
+		uint16_t peak = 1;
+
+		for (uint16_t k = 1; k < half; k++) {
+			power[k] /= vsd->segments;
+
+			if (power[k] > power[peak])
+				peak = k;
+
+			// The DC bin is left out, it is mostly what the bias missed
+			bands_out[axis][k / bins_per_band] += power[k];
+		}
+
+		for (uint16_t b = 0; b < bands; b++)
+			bands_out[axis][b] = sqrtf(bands_out[axis][b]);
+
+		// Parabola through the peak and its neighbours
+		float delta = 0;
+		if (peak > 1 && peak < half - 1) {
+			float denom = power[peak - 1] - 2 * power[peak] + power[peak + 1];
+			if (denom < 0)
+				delta = 0.5f * (power[peak - 1] - power[peak + 1]) / denom;
+		}
+
+		// A sine's power is spread over about three bins by the window
+		float peak_ms = power[peak];
+		if (peak > 1)
+			peak_ms += power[peak - 1];
+		if (peak < half - 1)
+			peak_ms += power[peak + 1];
+
+		spectrum.PeakFrequency[axis] = (peak + delta) * bin_hz;
+		spectrum.PeakAmplitude[axis] = sqrtf(2 * peak_ms);
+	}
+
+	spectrum.BandWidth = bins_per_band * bin_hz;
+	spectrum.Averages = vsd->segments;
+
+	VibrationAnalysisSpectrumSet(&spectrum);
+}
+
+/**
+ * Add a sample to the window, and transform it when it is full
+ * @param[in] x, y, z the averaged sample, less the bias
+ * @param[in] sampleRate_ms sample period, for the frequencies
+ * @return true when a spectrum has been published
+ */
+static bool VibrationAnalysisSpectrumAdd(float x, float y, float z, uint16_t sampleRate_ms)
+{
+	uint16_t n = vtd->window_size;
+	uint16_t half = n / 2;
+
+	vsd->samples[vsd->fill] = x * FLOAT_TO_FIXED;
+	vsd->samples[n + vsd->fill] = y * FLOAT_TO_FIXED;
+	vsd->samples[2 * n + vsd->fill] = z * FLOAT_TO_FIXED;
+
+	if (++vsd->fill < n)
+		return false;
+
+	/* Hann window, scaled so each bin comes out as the mean square of
+	 * the signal in it: sum(w^2) is 3n/8 and the one-sided power is
+	 * doubled.  The samples go back from fixed point as well. */
+	float scale = 16.0f / (3.0f * n * n) / (FLOAT_TO_FIXED * FLOAT_TO_FIXED);
+
+	for (int axis = 0; axis < 3; axis++) {
+		const int16_t *samples = &vsd->samples[axis * n];
+		float *power = &vsd->power[axis * half];
+
+		for (uint16_t i = 0; i < n; i++)
+			vsd->work[i] = samples[i] * (0.5f - 0.5f * cosf(2 * PI * i / n));
+
+		fft_real_power_add(vsd->work, n, power, scale);
+	}
+
+	// Windows overlap by half
+	for (int axis = 0; axis < 3; axis++)
+		memmove(&vsd->samples[axis * n], &vsd->samples[axis * n + half],
+				half * sizeof(*vsd->samples));
+	vsd->fill = half;
+
+	if (++vsd->segments < vsd->averages)
+		return false;
+
+	VibrationAnalysisSpectrumPublish(sampleRate_ms);
+
+	vsd->segments = 0;
+	memset(vsd->power, 0, 3 * half * sizeof(*vsd->power));
+
+	return true;
+}
+
 /**
  * Initialise the module, called on startup
  */
@@ -320,7 +612,8 @@ static int32_t VibrationAnalysisInitialize(void)
 		return -1;
 
 	// Initialize UAVOs
-	if (VibrationAnalysisSettingsInitialize() == -1 || VibrationAnalysisOutputInitialize() == -1) {
+	if (VibrationAnalysisSettingsInitialize() == -1 || VibrationAnalysisOutputInitialize() == -1 ||
+			VibrationAnalysisSpectrumInitialize() == -1) {
         module_enabled = false;
         return -1;
     }
@@ -429,10 +722,10 @@ static void VibrationAnalysisTask(void *parameters)
         vtd->accels_static_bias_y = alpha*accels_avg_y + (1-alpha)*vtd->accels_static_bias_y;
         vtd->accels_static_bias_z = alpha*accels_avg_z + (1-alpha)*vtd->accels_static_bias_z;
         
-        // Add averaged values to the buffer, and remove DC bias.
-        vtd->accel_buffer_x[sample_count] = (accels_avg_x - vtd->accels_static_bias_x)*FLOAT_TO_FIXED;
-        vtd->accel_buffer_y[sample_count] = (accels_avg_y - vtd->accels_static_bias_y)*FLOAT_TO_FIXED;
-        vtd->accel_buffer_z[sample_count] = (accels_avg_z - vtd->accels_static_bias_z)*FLOAT_TO_FIXED;
+        // Remove DC bias.
+        float accels_x = accels_avg_x - vtd->accels_static_bias_x;
+        float accels_y = accels_avg_y - vtd->accels_static_bias_y;
+        float accels_z = accels_avg_z - vtd->accels_static_bias_z;
         
         //Reset the accumulators
         vtd->accels_data_sum_x = 0;
@@ -440,6 +733,19 @@ static void VibrationAnalysisTask(void *parameters)
         vtd->accels_data_sum_z = 0;
         vtd->accels_sum_count = 0;
 
+        // In spectrum mode the samples stay on board, and settings are
+        // looked at again between spectra
+        if (output_mode == VIBRATIONANALYSISSETTINGS_OUTPUTMODE_SPECTRUM) {
+            if (VibrationAnalysisSpectrumAdd(accels_x, accels_y, accels_z, sampleRate_ms))
+                runningAcquisition = 0;
+            continue;
+        }
+
+        // Add averaged values to the buffer
+        vtd->accel_buffer_x[sample_count] = accels_x*FLOAT_TO_FIXED;
+        vtd->accel_buffer_y[sample_count] = accels_y*FLOAT_TO_FIXED;
+        vtd->accel_buffer_z[sample_count] = accels_z*FLOAT_TO_FIXED;
+
         // Advance sample and reset when at buffer end
         sample_count++;
 
@@ -39,6 +39,7 @@
 #include "ucontext/winucontext.c"
 #else
 #include <ucontext.h>
+#include <sys/time.h>
 #endif
 
 #include <unistd.h>
@@ -77,6 +78,30 @@ void port_tick_signal_handler(int signo, siginfo_t *info, void *context) {
 void port_init(void) {
 }
 
+/**
+ * @brief   Set once the system tick is driven by the idle thread rather
+ *          than by the interval timer.
+ */
+bool_t port_virtual_time = FALSE;
+
+/**
+ * @brief   Runs the system on virtual time.
+ * @details The interval timer is stopped and the system tick is advanced by
+ *          the idle thread instead, as soon as every other thread is blocked.
+ *          Time then goes as fast as the threads keep up with it, and a
+ *          thread that never blocks stops the clock.
+ */
+void port_virtual_time_enable(void) {
+#if !(defined(_WIN32) || defined(WIN32) || defined(__MINGW32__))
+  struct itimerval itimer = { { 0, 0 }, { 0, 0 } };
+
+  if (setitimer(PORT_TIMER_TYPE, &itimer, NULL) < 0)
+    port_halt();
+
+  port_virtual_time = TRUE;
+#endif
+}
+
 /**
  * @brief   Kernel-lock action.
  * @details Usually this function just disables interrupts but may perform more
@@ -163,6 +188,15 @@ void port_enable(void) {
  *          modes.
  */
 void port_wait_for_interrupt(void) {
+  if (port_virtual_time) {
+    /* Nothing else can run until time passes, so move on to the next tick. */
+    chSysLock();
+    chSysTimerHandlerI();
+    chSchRescheduleS();
+    chSysUnlock();
+    return;
+  }
+
 	select(0, NULL, NULL, NULL, NULL);
 }
 
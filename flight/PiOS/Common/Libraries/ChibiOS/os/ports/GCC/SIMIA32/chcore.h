@@ -250,6 +250,8 @@ struct context {
 #ifdef __cplusplus
 extern "C" {
 #endif
+  extern bool_t port_virtual_time;
+
   void port_init(void);
   void port_lock(void);
   void port_unlock(void);
@@ -259,6 +261,7 @@ extern "C" {
   void port_suspend(void);
   void port_enable(void);
   void port_wait_for_interrupt(void);
+  void port_virtual_time_enable(void);
   void port_halt(void);
   void port_switch(Thread *ntp, Thread *otp);
 
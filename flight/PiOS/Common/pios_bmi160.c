@@ -39,7 +39,6 @@
 #include "pios_bmi160.h"
 #include "pios_semaphore.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
 
 /* Private constants */
 #define PIOS_BMI160_TASK_PRIORITY    PIOS_THREAD_PRIO_HIGHEST
@@ -85,8 +84,8 @@ struct bmi160_dev {
 	uint32_t spi_id;
 	uint32_t slave_num;
 	const struct pios_bmi160_cfg *cfg;
-	struct pios_queue *gyro_queue;
-	struct pios_queue *accel_queue;
+	struct pios_sensors_queue *gyro_queue;
+	struct pios_sensors_queue *accel_queue;
 	struct pios_thread *TaskHandle;
 	struct pios_semaphore *data_ready_sema;
 	float accel_scale;
@@ -368,23 +367,23 @@ static struct bmi160_dev *PIOS_BMI160_alloc(const struct pios_bmi160_cfg *cfg)
 
 	bmi160_dev->magic = PIOS_BMI160_DEV_MAGIC;
 
-	bmi160_dev->accel_queue = PIOS_Queue_Create(PIOS_BMI160_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_accel_data));
+	bmi160_dev->accel_queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_accel_data), PIOS_BMI160_MAX_DOWNSAMPLE);
 	if (bmi160_dev->accel_queue == NULL) {
 		PIOS_free(bmi160_dev);
 		return NULL;
 	}
 
-	bmi160_dev->gyro_queue = PIOS_Queue_Create(PIOS_BMI160_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_gyro_data));
+	bmi160_dev->gyro_queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_gyro_data), PIOS_BMI160_MAX_DOWNSAMPLE);
 	if (bmi160_dev->gyro_queue == NULL) {
-		PIOS_Queue_Delete(dev->accel_queue);
+		PIOS_SENSORS_DeleteQueue(dev->accel_queue);
 		PIOS_free(bmi160_dev);
 		return NULL;
 	}
 
 	bmi160_dev->data_ready_sema = PIOS_Semaphore_Create();
 	if (bmi160_dev->data_ready_sema == NULL) {
-		PIOS_Queue_Delete(dev->accel_queue);
-		PIOS_Queue_Delete(dev->gyro_queue);
+		PIOS_SENSORS_DeleteQueue(dev->accel_queue);
+		PIOS_SENSORS_DeleteQueue(dev->gyro_queue);
 		PIOS_free(bmi160_dev);
 		return NULL;
 	}
@@ -645,8 +644,8 @@ static void PIOS_BMI160_Task(void *parameters)
 		gyro_data.temperature = temperature;
 
 
-		PIOS_Queue_Send(dev->accel_queue, &accel_data, 0);
-		PIOS_Queue_Send(dev->gyro_queue, &gyro_data, 0);
+		PIOS_SENSORS_Push(dev->accel_queue, &accel_data);
+		PIOS_SENSORS_Push(dev->gyro_queue, &gyro_data);
 
 		temp_interleave_cnt += 1;
 	}
@@ -35,7 +35,6 @@
 #include "pios_bmp085_priv.h"
 #include "pios_semaphore.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
 
 /* Private constants */
 #define BMP085_TASK_PRIORITY	PIOS_THREAD_PRIO_HIGHEST
@@ -77,7 +76,7 @@ struct bmp085_dev {
 	const struct pios_bmp085_cfg *cfg;
 	uint32_t i2c_id;
 	struct pios_thread *task;
-	struct pios_queue *queue;
+	struct pios_sensors_queue *queue;
 
 	int64_t pressure_unscaled;
 	int64_t temperature_unscaled;
@@ -114,7 +113,7 @@ static struct bmp085_dev *PIOS_BMP085_alloc(void)
 	bmp085_dev = (struct bmp085_dev *)PIOS_malloc(sizeof(*bmp085_dev));
 	if (!bmp085_dev) return (NULL);
 
-	bmp085_dev->queue = PIOS_Queue_Create(1, sizeof(struct pios_sensor_baro_data));
+	bmp085_dev->queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_baro_data), 1);
 	if (bmp085_dev->queue == NULL) {
 		PIOS_free(bmp085_dev);
 		return NULL;
@@ -454,7 +453,7 @@ static void PIOS_BMP085_Task(void *parameters)
 		data.altitude = 44330.0f * (1.0f - powf(data.pressure / BMP085_P0, (1.0f / 5.255f)));
 
 		if (read_adc_result == 0) {
-			PIOS_Queue_Send(dev->queue, (void*)&data, 0);
+			PIOS_SENSORS_Push(dev->queue, &data);
 		}
 	}
 }
@@ -36,7 +36,6 @@
 #include "pios_bmp280_priv.h"
 #include "pios_semaphore.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
 
 /* Private constants */
 #define BMP280_TASK_PRIORITY	PIOS_THREAD_PRIO_HIGHEST
@@ -88,7 +87,7 @@ struct bmp280_dev {
 #endif
 
 	struct pios_thread *task;
-	struct pios_queue *queue;
+	struct pios_sensors_queue *queue;
 
 	uint32_t compensatedPressure;
 	int32_t  compensatedTemperature;
@@ -131,7 +130,7 @@ static struct bmp280_dev *PIOS_BMP280_alloc(void)
 		.magic = PIOS_BMP280_DEV_MAGIC
 	};
 
-	bmp280_dev->queue = PIOS_Queue_Create(1, sizeof(struct pios_sensor_baro_data));
+	bmp280_dev->queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_baro_data), 1);
 	if (bmp280_dev->queue == NULL) {
 		PIOS_free(bmp280_dev);
 		return NULL;
@@ -555,7 +554,7 @@ static void PIOS_BMP280_Task(void *parameters)
 
 		data.altitude = calc_alt;
 
-		PIOS_Queue_Send(dev->queue, (void*)&data, 0);
+		PIOS_SENSORS_Push(dev->queue, &data);
 	}
 }
 
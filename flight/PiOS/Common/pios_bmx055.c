@@ -41,7 +41,6 @@
 
 #include "pios_semaphore.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
 #include "physical_constants.h"
 #include "taskmonitor.h"
 
@@ -73,8 +72,8 @@ struct pios_bmx055_dev {
 	uint32_t spi_slave_gyro;                    /**< The slave number (SPI) */
 	uint32_t spi_slave_accel;
 
-	struct pios_queue *gyro_queue;
-	struct pios_queue *accel_queue;
+	struct pios_sensors_queue *gyro_queue;
+	struct pios_sensors_queue *accel_queue;
 
 	struct pios_thread *task_handle;
 	struct pios_semaphore *data_ready_sema;
@@ -123,23 +122,23 @@ static struct pios_bmx055_dev *PIOS_BMX_Alloc(const struct pios_bmx055_cfg *cfg)
 
 	dev->magic = PIOS_BMX_DEV_MAGIC;
 
-	dev->accel_queue = PIOS_Queue_Create(PIOS_BMX_QUEUE_LEN, sizeof(struct pios_sensor_accel_data));
+	dev->accel_queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_accel_data), PIOS_BMX_QUEUE_LEN);
 	if (dev->accel_queue == NULL) {
 		PIOS_free(dev);
 		return NULL;
 	}
 
-	dev->gyro_queue = PIOS_Queue_Create(PIOS_BMX_QUEUE_LEN, sizeof(struct pios_sensor_gyro_data));
+	dev->gyro_queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_gyro_data), PIOS_BMX_QUEUE_LEN);
 	if (dev->gyro_queue == NULL) {
-		PIOS_Queue_Delete(dev->accel_queue);
+		PIOS_SENSORS_DeleteQueue(dev->accel_queue);
 		PIOS_free(dev);
 		return NULL;
 	}
 
 	dev->data_ready_sema = PIOS_Semaphore_Create();
 	if (dev->data_ready_sema == NULL) {
-		PIOS_Queue_Delete(dev->accel_queue);
-		PIOS_Queue_Delete(dev->gyro_queue);
+		PIOS_SENSORS_DeleteQueue(dev->accel_queue);
+		PIOS_SENSORS_DeleteQueue(dev->gyro_queue);
 		PIOS_free(dev);
 		return NULL;
 	}
@@ -510,8 +509,8 @@ static void PIOS_BMX_Task(void *parameters)
 		gyro_data.z *= gyro_scale;
 		gyro_data.temperature = accel_temp;
 
-		PIOS_Queue_Send(bmx_dev->accel_queue, &accel_data, 0);
-		PIOS_Queue_Send(bmx_dev->gyro_queue, &gyro_data, 0);
+		PIOS_SENSORS_Push(bmx_dev->accel_queue, &accel_data);
+		PIOS_SENSORS_Push(bmx_dev->gyro_queue, &gyro_data);
 	}
 }
 
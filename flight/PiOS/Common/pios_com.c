@@ -59,6 +59,7 @@ struct pios_com_dev {
 
 	struct pios_semaphore *tx_sem;
 	struct pios_semaphore *rx_sem;
+	struct pios_semaphore *rx_notify;	// also given on receive, may be shared
 #if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
 	struct pios_mutex *sendbuffer_mtx;
 #endif
@@ -152,10 +153,17 @@ out_fail:
 static void PIOS_COM_UnblockRx(struct pios_com_dev *com_dev, bool * need_yield)
 {
 #if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
-	if (PIOS_IRQ_InISR() == true)
+	struct pios_semaphore *notify = com_dev->rx_notify;
+
+	if (PIOS_IRQ_InISR() == true) {
 		PIOS_Semaphore_Give_FromISR(com_dev->rx_sem, need_yield);
-	else
+		if (notify)
+			PIOS_Semaphore_Give_FromISR(notify, need_yield);
+	} else {
 		PIOS_Semaphore_Give(com_dev->rx_sem);
+		if (notify)
+			PIOS_Semaphore_Give(notify);
+	}
 #endif
 }
 
@@ -381,6 +389,83 @@ int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t le
 	return sent;
 }
 
+/**
+* Reserves contiguous room in the transmit buffer, for the caller to build
+* a package in place instead of copying it in.  The port stays locked for
+* other senders until PIOS_COM_CommitBuffer is called.
+* (non-blocking function)
+* \param[in] port COM port
+* \param[in] len package length
+* \return pointer to fill len bytes into
+* \return NULL if the port is not available, busy, down or there is not
+*         enough contiguous room: the caller should use PIOS_COM_SendBuffer
+*/
+uint8_t *PIOS_COM_ReserveBuffer(uintptr_t com_id, uint16_t len)
+{
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev) || !com_dev->tx) {
+		return NULL;
+	}
+
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	if (PIOS_Mutex_Lock(com_dev->sendbuffer_mtx, 0) != true) {
+		return NULL;
+	}
+#endif /* defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS) */
+
+	/* A down device is handled by the regular send path */
+	if (!com_dev->driver->available || com_dev->driver->available(com_dev->lower_id)) {
+		uint16_t contig;
+		uint8_t *buf = circ_queue_write_pos(com_dev->tx, &contig, NULL);
+
+		if (len <= contig) {
+			return buf;
+		}
+	}
+
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	PIOS_Mutex_Unlock(com_dev->sendbuffer_mtx);
+#endif /* PIOS_INCLUDE_FREERTOS */
+
+	return NULL;
+}
+
+/**
+* Sends a package built with PIOS_COM_ReserveBuffer and unlocks the port
+* \param[in] port COM port
+* \param[in] len length of the package, at most the length reserved.
+*            0 sends nothing.
+* \return -1 if port not available
+* \return number of bytes transmitted on success
+*/
+int32_t PIOS_COM_CommitBuffer(uintptr_t com_id, uint16_t len)
+{
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		return -1;
+	}
+
+	if (len > 0) {
+		circ_queue_advance_write_multi(com_dev->tx, len);
+
+		if (com_dev->driver->tx_start) {
+			uint16_t tx_avail;
+
+			circ_queue_read_pos(com_dev->tx, NULL, &tx_avail);
+			com_dev->driver->tx_start(com_dev->lower_id,
+						  tx_avail);
+		}
+	}
+
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	PIOS_Mutex_Unlock(com_dev->sendbuffer_mtx);
+#endif /* PIOS_INCLUDE_FREERTOS */
+
+	return len;
+}
+
 /**
 * Sends a single character over given port
 * \param[in] port COM port
@@ -515,6 +600,28 @@ uint16_t PIOS_COM_GetNumReceiveBytesPending(uintptr_t com_id) {
 	return rx_pending;
 }
 
+/**
+* Get how full the transmit buffer is, to tell whether the link keeps up
+* \param[in] port COM port
+* \param[out] pending bytes waiting to be sent
+* \param[out] room bytes that still fit in
+* \return 0 on success
+* \return -1 if the port has no transmit buffer
+*/
+int32_t PIOS_COM_GetTxBufferState(uintptr_t com_id, uint16_t *pending, uint16_t *room)
+{
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev) || !com_dev->tx) {
+		return -1;
+	}
+
+	circ_queue_read_pos(com_dev->tx, NULL, pending);
+	circ_queue_write_pos(com_dev->tx, NULL, room);
+
+	return 0;
+}
+
 /**
 * Transfer bytes from port buffers into another buffer
 * \param[in] port COM port
@@ -571,6 +678,82 @@ check_again:
 	return (bytes_from_fifo);
 }
 
+/**
+* Get the received bytes that sit contiguously in the port buffer, for the
+* caller to parse in place instead of copying them out.  They stay in the
+* buffer until PIOS_COM_ConsumeReceiveBuffer is called.
+* \param[in] port COM port
+* \param[out] len number of bytes there, 0 if none came within the timeout
+* \param[in] timeout_ms how long to wait for the first byte
+* \returns pointer to the first byte, NULL if there are none
+*/
+const uint8_t *PIOS_COM_PeekReceiveBuffer(uintptr_t com_id, uint16_t *len, uint32_t timeout_ms)
+{
+	PIOS_Assert(len);
+
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		/* Undefined COM port for this board (see pios_board.c) */
+		PIOS_Assert(0);
+	}
+	PIOS_Assert(com_dev->rx);
+
+	/* Clear any pending RX wakeup */
+	PIOS_Semaphore_Take(com_dev->rx_sem, 0);
+
+	const uint8_t *buf;
+
+check_again:
+	buf = circ_queue_read_pos(com_dev->rx, len, NULL);
+
+	if (*len == 0) {
+		/* Make sure the receiver is running while we wait */
+		if (com_dev->driver->rx_start) {
+			uint16_t rx_space_avail;
+
+			circ_queue_write_pos(com_dev->rx, NULL,
+					&rx_space_avail);
+			(com_dev->driver->rx_start)(com_dev->lower_id,
+						    rx_space_avail);
+		}
+		if (timeout_ms > 0) {
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+			if (PIOS_Semaphore_Take(com_dev->rx_sem, timeout_ms) == true) {
+				timeout_ms = 0;
+				goto check_again;
+			}
+#else
+			PIOS_DELAY_WaitmS(1);
+			timeout_ms--;
+			goto check_again;
+#endif
+		}
+
+		return NULL;
+	}
+
+	return buf;
+}
+
+/**
+* Drop bytes got with PIOS_COM_PeekReceiveBuffer from the port buffer
+* \param[in] port COM port
+* \param[in] len how many, at most what the peek returned
+*/
+void PIOS_COM_ConsumeReceiveBuffer(uintptr_t com_id, uint16_t len)
+{
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		/* Undefined COM port for this board (see pios_board.c) */
+		PIOS_Assert(0);
+	}
+	PIOS_Assert(com_dev->rx);
+
+	circ_queue_read_completed_multi(com_dev->rx, len);
+}
+
 /**
  * Query if a com port is available for use.  That can be
  * used to check a link is established even if the device
@@ -592,6 +775,41 @@ bool PIOS_COM_Available(uintptr_t com_id)
 	return (com_dev->driver->available)(com_dev->lower_id);
 }
 
+/**
+ * Query if a com port was set up with a receive buffer, for modules
+ * that can make use of received data but do not need it.
+ */
+bool PIOS_COM_HasRx(uintptr_t com_id)
+{
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		return false;
+	}
+
+	return com_dev->rx != NULL;
+}
+
+/**
+ * Have a second semaphore given whenever data arrives on a port, so that
+ * one task can wait on several ports at once.
+ * \param[in] com_id COM port
+ * \param[in] sem the semaphore, or NULL to stop
+ * \return 0 on success, -1 if the port is not valid
+ */
+int32_t PIOS_COM_SetRxNotify(uintptr_t com_id, struct pios_semaphore *sem)
+{
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		return -1;
+	}
+
+	com_dev->rx_notify = sem;
+
+	return 0;
+}
+
 uintptr_t PIOS_COM_GetDriverCtx(uintptr_t com_id) {
 	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
 
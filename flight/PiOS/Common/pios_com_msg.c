@@ -170,6 +170,9 @@ uint16_t PIOS_COM_MSG_Receive(uintptr_t com_id, uint8_t * msg, uint16_t msg_len)
 		memcpy(msg, com_dev->rx_msg_buffer, msg_len);
 		com_dev->rx_msg_full = false;
 
+		/* Take the next message while the caller handles this one */
+		(com_dev->driver->rx_start)(com_dev->lower_id, sizeof(com_dev->rx_msg_buffer));
+
 		return msg_len;
 	}
 
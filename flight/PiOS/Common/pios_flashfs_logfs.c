@@ -30,14 +30,61 @@
 #include "pios_flashfs_logfs_priv.h" /* Internal API */
 
 #include <stdbool.h>
+#include <string.h>		/* memset */
 #include <stddef.h>		/* NULL */
 
+#if !defined(PIOS_FLASHFS_LOGFS_NO_GC_TASK)
+#include "pios_thread.h"
+#endif
+
 #define MIN(x,y) ((x) < (y) ? (x) : (y))
 
+/*
+ * Most entries in the RAM index of the active slots, a power of two.  Less
+ * are allocated when the arena has fewer slots; 0 leaves lookups to scan
+ * the arena as before.
+ */
+#ifndef PIOS_FLASHFS_LOGFS_INDEX_SIZE
+#define PIOS_FLASHFS_LOGFS_INDEX_SIZE 256
+#endif
+
+/*
+ * Garbage collection starts in the background once no more than 1/DIV of
+ * the slots are free, and moves up to SLOTS_PER_STEP active slots to the
+ * next arena at a time.  Saves only collect in the foreground when the log
+ * fills up before the background is done.
+ */
+#ifndef PIOS_FLASHFS_LOGFS_GC_FREE_DIV
+#define PIOS_FLASHFS_LOGFS_GC_FREE_DIV 4
+#endif
+
+#ifndef PIOS_FLASHFS_LOGFS_GC_SLOTS_PER_STEP
+#define PIOS_FLASHFS_LOGFS_GC_SLOTS_PER_STEP 2
+#endif
+
+#if !defined(PIOS_FLASHFS_LOGFS_NO_GC_TASK)
+#define PIOS_FLASHFS_LOGFS_GC_TASK_PRIORITY    PIOS_THREAD_PRIO_LOW
+#define PIOS_FLASHFS_LOGFS_GC_TASK_STACK_BYTES 600
+#define PIOS_FLASHFS_LOGFS_GC_IDLE_MS          100
+#endif
+
 /*
  * Filesystem state data tracked in RAM
  */
 
+/* Slot 0 holds the arena header, so it marks an unused entry */
+struct logfs_index_entry {
+	uint32_t obj_id;
+	uint16_t obj_inst_id;
+	uint16_t slot_id;
+};
+
+enum logfs_gc_state {
+	LOGFS_GC_IDLE,
+	LOGFS_GC_ERASE,            /* next step erases the destination */
+	LOGFS_GC_COPY,             /* moving slots, then switching arenas */
+};
+
 enum pios_flashfs_logfs_dev_magic {
 	PIOS_FLASHFS_LOGFS_DEV_MAGIC = 0x94938201,
 };
@@ -55,6 +102,20 @@ struct logfs_state {
 	uint16_t num_free_slots;   /* slots in free state */
 	uint16_t num_active_slots; /* slots in active state */
 
+	/* Open addressed hash of the active slots by object and instance */
+	struct logfs_index_entry *index;
+	uint16_t index_size;       /* entries, a power of two or 0 */
+	bool index_complete;       /* every active slot is in the index */
+
+	/* Garbage collection of the active arena into the next one */
+	enum logfs_gc_state gc_state;
+	uint8_t gc_dst_arena_id;
+	uint16_t gc_src_slot_id;   /* next active arena slot to move */
+	uint16_t gc_dst_slot_id;   /* next free destination slot */
+#if !defined(PIOS_FLASHFS_LOGFS_NO_GC_TASK)
+	struct pios_thread *gc_task;
+#endif
+
 	/* Underlying flash partition handle */
 	uintptr_t partition_id;
 	uint32_t partition_size;
@@ -377,6 +438,109 @@ static int32_t logfs_raw_copy_bytes (const struct logfs_state *logfs, uintptr_t
 	return 0;
 }
 
+/****************************************
+ * RAM index of the active slots
+ ****************************************/
+
+static uint16_t logfs_index_hash(const struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	uint32_t key = (obj_id ^ ((uint32_t) obj_inst_id << 16)) * 0x9E3779B1;
+
+	return (key >> 16) & (logfs->index_size - 1);
+}
+
+static void logfs_index_clear(struct logfs_state *logfs)
+{
+	if (logfs->index_size) {
+		memset(logfs->index, 0, logfs->index_size * sizeof(*logfs->index));
+	}
+
+	logfs->index_complete = (logfs->index_size != 0);
+}
+
+/**
+ * @brief Look up the slot of an object
+ * @return the slot, or 0 if it isn't in the index
+ */
+static uint16_t logfs_index_find(const struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	if (!logfs->index_size)
+		return 0;
+
+	uint16_t mask = logfs->index_size - 1;
+	for (uint16_t i = logfs_index_hash(logfs, obj_id, obj_inst_id); ; i = (i + 1) & mask) {
+		const struct logfs_index_entry *entry = &logfs->index[i];
+
+		if (entry->slot_id == 0)
+			return 0;
+
+		if (entry->obj_id == obj_id && entry->obj_inst_id == obj_inst_id)
+			return entry->slot_id;
+	}
+}
+
+/**
+ * @brief Record the slot of an object.  When the index is full it stops
+ * being complete, and lookups it misses scan the arena.
+ */
+static void logfs_index_set(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint16_t slot_id)
+{
+	if (!logfs->index_size)
+		return;
+
+	uint16_t mask = logfs->index_size - 1;
+	uint16_t i = logfs_index_hash(logfs, obj_id, obj_inst_id);
+
+	/* Keep an entry free, so that searches always end */
+	for (uint16_t probes = 0; probes < mask; probes++, i = (i + 1) & mask) {
+		struct logfs_index_entry *entry = &logfs->index[i];
+
+		if (entry->slot_id == 0 ||
+			(entry->obj_id == obj_id && entry->obj_inst_id == obj_inst_id)) {
+			entry->obj_id      = obj_id;
+			entry->obj_inst_id = obj_inst_id;
+			entry->slot_id     = slot_id;
+			return;
+		}
+	}
+
+	logfs->index_complete = false;
+}
+
+/**
+ * @brief Forget the slot of an object, moving back the entries after it
+ * that would no longer be found past the hole
+ */
+static void logfs_index_remove(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	if (!logfs->index_size)
+		return;
+
+	uint16_t mask = logfs->index_size - 1;
+	uint16_t hole = logfs_index_hash(logfs, obj_id, obj_inst_id);
+
+	while (logfs->index[hole].obj_id != obj_id || logfs->index[hole].obj_inst_id != obj_inst_id) {
+		if (logfs->index[hole].slot_id == 0)
+			return;
+		hole = (hole + 1) & mask;
+	}
+
+	if (logfs->index[hole].slot_id == 0)
+		return;
+
+	for (uint16_t i = (hole + 1) & mask; logfs->index[i].slot_id != 0; i = (i + 1) & mask) {
+		uint16_t home = logfs_index_hash(logfs, logfs->index[i].obj_id, logfs->index[i].obj_inst_id);
+
+		/* Entry i can fill the hole if its home isn't in (hole, i] */
+		if (((i - home) & mask) >= ((i - hole) & mask)) {
+			logfs->index[hole] = logfs->index[i];
+			hole = i;
+		}
+	}
+
+	logfs->index[hole].slot_id = 0;
+}
+
 /*
  * Is the entire filesystem full?
  * true = all slots in the arena are in the ACTIVE state (ie. garbage collection won't free anything)
@@ -405,6 +569,8 @@ static int32_t logfs_unmount_log(struct logfs_state *logfs)
 	logfs->num_free_slots   = 0;
 	logfs->mounted          = false;
 
+	logfs_index_clear(logfs);
+
 	return 0;
 }
 
@@ -416,7 +582,9 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 	logfs->num_free_slots   = 0;
 	logfs->active_arena_id  = arena_id;
 
-	/* Scan the log to find out how full it is */
+	logfs_index_clear(logfs);
+
+	/* Scan the log to find out how full it is, and index what is in it */
 	for (uint16_t slot_id = 1;
 	     slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
 	     slot_id++) {
@@ -442,6 +610,13 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 			break;
 		case SLOT_STATE_ACTIVE:
 			logfs->num_active_slots++;
+
+			/* Only one version should be active, leave it to scans if not */
+			if (logfs_index_find(logfs, slot_hdr.obj_id, slot_hdr.obj_inst_id) != 0) {
+				logfs->index_complete = false;
+			} else {
+				logfs_index_set(logfs, slot_hdr.obj_id, slot_hdr.obj_inst_id, slot_id);
+			}
 			break;
 		case SLOT_STATE_RESERVED:
 		case SLOT_STATE_OBSOLETE:
@@ -475,9 +650,28 @@ static void PIOS_FLASHFS_Logfs_free(struct logfs_state *logfs)
 {
 	/* Invalidate the magic */
 	logfs->magic = ~PIOS_FLASHFS_LOGFS_DEV_MAGIC;
+	if (logfs->index) {
+		PIOS_free(logfs->index);
+	}
 	PIOS_free(logfs);
 }
 
+#if !defined(PIOS_FLASHFS_LOGFS_NO_GC_TASK)
+static void PIOS_FLASHFS_Logfs_Task(void *parameters)
+{
+	uintptr_t fs_id = (uintptr_t)parameters;
+
+	while (1) {
+		if (PIOS_FLASHFS_Logfs_GarbageCollectStep(fs_id) > 0) {
+			/* Let saves in between the steps */
+			PIOS_Thread_Sleep(1);
+		} else {
+			PIOS_Thread_Sleep(PIOS_FLASHFS_LOGFS_GC_IDLE_MS);
+		}
+	}
+}
+#endif
+
 /**
  * @brief Initialize the flash object setting FS
  * @return 0 if success, -1 if failure
@@ -519,6 +713,24 @@ int32_t PIOS_FLASHFS_Logfs_Init(uintptr_t *fs_id, const struct flashfs_logfs_cfg
 	logfs->partition_id   = partition_id; /* underlying partition */
 	logfs->partition_size = partition_size; /* size of underlying partition */
 	logfs->mounted        = false;
+	logfs->gc_state       = LOGFS_GC_IDLE;
+
+	/* Size the index for the slots of an arena, kept at most 80% full */
+	uint16_t num_slots = cfg->arena_size / cfg->slot_size - 1;
+	uint16_t index_size = 1;
+	while (index_size < PIOS_FLASHFS_LOGFS_INDEX_SIZE && index_size < num_slots + num_slots / 4 + 1) {
+		index_size <<= 1;
+	}
+
+	logfs->index = NULL;
+	logfs->index_size = 0;
+	if (PIOS_FLASHFS_LOGFS_INDEX_SIZE > 1) {
+		logfs->index = (struct logfs_index_entry *)PIOS_malloc_no_dma(index_size * sizeof(*logfs->index));
+		if (logfs->index) {
+			logfs->index_size = index_size;
+		}
+	}
+	logfs_index_clear(logfs);
 
 	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
 		rc = -1;
@@ -561,6 +773,12 @@ int32_t PIOS_FLASHFS_Logfs_Init(uintptr_t *fs_id, const struct flashfs_logfs_cfg
 
 	*fs_id = (uintptr_t) logfs;
 
+#if !defined(PIOS_FLASHFS_LOGFS_NO_GC_TASK)
+	logfs->gc_task = PIOS_Thread_Create(PIOS_FLASHFS_Logfs_Task,
+			"pios_logfs", PIOS_FLASHFS_LOGFS_GC_TASK_STACK_BYTES,
+			logfs, PIOS_FLASHFS_LOGFS_GC_TASK_PRIORITY);
+#endif
+
 out_end_trans:
 	PIOS_FLASH_end_transaction(logfs->partition_id);
 
@@ -579,6 +797,15 @@ int32_t PIOS_FLASHFS_Logfs_Destroy(uintptr_t fs_id)
 		goto out_exit;
 	}
 
+#if !defined(PIOS_FLASHFS_LOGFS_NO_GC_TASK)
+	/* Holding the transaction, the task can't be in the middle of a step */
+	if (logfs->gc_task) {
+		PIOS_FLASH_start_transaction(logfs->partition_id);
+		PIOS_Thread_Delete(logfs->gc_task);
+		PIOS_FLASH_end_transaction(logfs->partition_id);
+	}
+#endif
+
 	PIOS_FLASHFS_Logfs_free(logfs);
 	rc = 0;
 
@@ -586,34 +813,71 @@ out_exit:
 	return rc;
 }
 
-/* NOTE: Must be called while holding the flash transaction lock */
-static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
+/**
+ * @brief Start moving the active slots to the next arena in the background
+ * when the log is filling up, if it holds obsolete slots to reclaim
+ */
+static void logfs_gc_schedule(struct logfs_state *logfs)
+{
+	uint16_t num_slots = (logfs->cfg->arena_size / logfs->cfg->slot_size) - 1;
+
+	if (logfs->gc_state != LOGFS_GC_IDLE)
+		return;
+
+	if (logfs->num_free_slots > num_slots / PIOS_FLASHFS_LOGFS_GC_FREE_DIV)
+		return;
+
+	if (logfs->num_active_slots + logfs->num_free_slots >= num_slots)
+		return;
+
+	logfs->gc_state = LOGFS_GC_ERASE;
+}
+
+/**
+ * @brief Do the next bounded piece of the garbage collection: erase the
+ * destination arena, or move a few active slots to it.  Once the end of the
+ * log is reached, the destination becomes the active arena.
+ * @return 1 if there is more to do, 0 when done, < 0 on failure
+ * @note Saves and deletes may run in between steps.  New slots are written
+ *       after the ones already moved, and deletes obsolete the moved copies.
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_gc_step (struct logfs_state *logfs) {
 	PIOS_Assert (logfs->mounted);
 
-	/* Source arena is the active arena */
-	uint8_t src_arena_id = logfs->active_arena_id;
+	uint16_t arena_slots = logfs->cfg->arena_size / logfs->cfg->slot_size;
 
-	/* Compute destination arena */
-	uint8_t dst_arena_id = (logfs->active_arena_id + 1) % (logfs->partition_size / logfs->cfg->arena_size);
+	switch (logfs->gc_state) {
+	case LOGFS_GC_IDLE:
+		return 0;
+	case LOGFS_GC_ERASE:
+		/* Compute destination arena */
+		logfs->gc_dst_arena_id = (logfs->active_arena_id + 1) % (logfs->partition_size / logfs->cfg->arena_size);
 
-	/* Erase destination arena */
-	if (logfs_erase_arena (logfs, dst_arena_id) != 0) {
-		return -1;
-	}
+		/* Erase destination arena */
+		if (logfs_erase_arena (logfs, logfs->gc_dst_arena_id) != 0) {
+			return -1;
+		}
 
-	/* Reserve the destination arena so we can start filling it */
-	if (logfs_reserve_arena (logfs, dst_arena_id) != 0) {
-		/* Unable to reserve the arena */
-		return -2;
+		/* Reserve the destination arena so we can start filling it */
+		if (logfs_reserve_arena (logfs, logfs->gc_dst_arena_id) != 0) {
+			/* Unable to reserve the arena */
+			return -2;
+		}
+
+		logfs->gc_src_slot_id = 1;
+		logfs->gc_dst_slot_id = 1;
+		logfs->gc_state = LOGFS_GC_COPY;
+		return 1;
+	case LOGFS_GC_COPY:
+		break;
 	}
 
-	/* Copy active slots from active arena to destination arena */
-	uint16_t dst_slot_id = 1;
-	for (uint16_t src_slot_id = 1;
-	     src_slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
-	     src_slot_id++) {
+	/* Copy the next active slots from active arena to destination arena */
+	uint16_t moved = 0;
+	for (; logfs->gc_src_slot_id < arena_slots; logfs->gc_src_slot_id++) {
 		struct slot_header slot_hdr;
-		uintptr_t src_addr = logfs_get_addr (logfs, src_arena_id, src_slot_id);
+		uintptr_t src_addr = logfs_get_addr (logfs, logfs->active_arena_id, logfs->gc_src_slot_id);
 		if (PIOS_FLASH_read_data(logfs->partition_id,
 						src_addr,
 						(uint8_t *)&slot_hdr,
@@ -621,19 +885,42 @@ static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
 			return -3;
 		}
 
-		if (slot_hdr.state == SLOT_STATE_ACTIVE) {
-			uintptr_t dst_addr = logfs_get_addr (logfs, dst_arena_id, dst_slot_id);
-			if (logfs_raw_copy_bytes(logfs,
-							src_addr,
-							sizeof(slot_hdr) + slot_hdr.obj_size,
-							dst_addr) != 0) {
-				/* Failed to copy all bytes */
-				return -4;
-			}
-			dst_slot_id++;
+		if (slot_hdr.state == SLOT_STATE_EMPTY) {
+			/* We hit the end of the log */
+			break;
 		}
+
+		if (slot_hdr.state != SLOT_STATE_ACTIVE)
+			continue;
+
+		if (moved == PIOS_FLASHFS_LOGFS_GC_SLOTS_PER_STEP) {
+			/* Leave this one for the next step */
+			return 1;
+		}
+
+		if (logfs->gc_dst_slot_id >= arena_slots) {
+			/* Filled up with copies obsoleted since, start over */
+			logfs->gc_state = LOGFS_GC_ERASE;
+			return 1;
+		}
+
+		uintptr_t dst_addr = logfs_get_addr (logfs, logfs->gc_dst_arena_id, logfs->gc_dst_slot_id);
+		if (logfs_raw_copy_bytes(logfs,
+						src_addr,
+						sizeof(slot_hdr) + slot_hdr.obj_size,
+						dst_addr) != 0) {
+			/* Failed to copy all bytes */
+			return -4;
+		}
+		logfs->gc_dst_slot_id++;
+		moved++;
 	}
 
+	/* Everything has been moved, switch over to the destination arena */
+	uint8_t src_arena_id = logfs->active_arena_id;
+	uint8_t dst_arena_id = logfs->gc_dst_arena_id;
+	logfs->gc_state = LOGFS_GC_IDLE;
+
 	/* Activate the destination arena */
 	if (logfs_activate_arena (logfs, dst_arena_id) != 0) {
 		return -5;
@@ -657,8 +944,33 @@ static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
 	return 0;
 }
 
+/**
+ * @brief Run the garbage collection to the end, starting it unless the
+ * background already did
+ * @return 0 if success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
+	int32_t rc;
+
+	if (logfs->gc_state == LOGFS_GC_IDLE) {
+		logfs->gc_state = LOGFS_GC_ERASE;
+	}
+
+	do {
+		rc = logfs_gc_step(logfs);
+	} while (rc > 0);
+
+	if (rc < 0) {
+		/* Start over from the erase next time */
+		logfs->gc_state = LOGFS_GC_IDLE;
+	}
+
+	return rc;
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
-static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct slot_header *slot_hdr, uint16_t *curr_slot, uint32_t obj_id, uint16_t obj_inst_id)
+static int16_t logfs_object_find_next (const struct logfs_state *logfs, uint8_t arena_id, struct slot_header *slot_hdr, uint16_t *curr_slot, uint32_t obj_id, uint16_t obj_inst_id)
 {
 	PIOS_Assert(slot_hdr);
 	PIOS_Assert(curr_slot);
@@ -669,7 +981,7 @@ static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct s
 	for (uint16_t slot_id = *curr_slot;
 	     slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
 	     slot_id++) {
-		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
+		uintptr_t slot_addr = logfs_get_addr (logfs, arena_id, slot_id);
 
 		if (PIOS_FLASH_read_data(logfs->partition_id,
 						slot_addr,
@@ -694,17 +1006,92 @@ static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct s
 	return -1;
 }
 
+/**
+ * Find the active slot of an object, from the index when it has it
+ * @return 0 if found, -1 if not found, -2 on a read error
+ */
+/* NOTE: Must be called while holding the flash transaction lock */
+static int16_t logfs_object_find (const struct logfs_state *logfs, struct slot_header *slot_hdr, uint16_t *slot_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	uint16_t indexed_slot_id = logfs_index_find(logfs, obj_id, obj_inst_id);
+
+	if (indexed_slot_id != 0) {
+		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, indexed_slot_id);
+
+		if (PIOS_FLASH_read_data(logfs->partition_id,
+						slot_addr,
+						(uint8_t *)slot_hdr,
+						sizeof (*slot_hdr)) != 0) {
+			return -2;
+		}
+
+		if (slot_hdr->state == SLOT_STATE_ACTIVE &&
+			slot_hdr->obj_id      == obj_id &&
+			slot_hdr->obj_inst_id == obj_inst_id) {
+			*slot_id = indexed_slot_id;
+			return 0;
+		}
+
+		/* Stale entry, should never happen.  Scan instead. */
+		PIOS_DEBUG_Assert(0);
+	} else if (logfs->index_complete) {
+		return -1;
+	}
+
+	*slot_id = 0;
+	return logfs_object_find_next (logfs, logfs->active_arena_id, slot_hdr, slot_id, obj_id, obj_inst_id);
+}
+
+/**
+ * Obsolete the copy of an object the garbage collection already moved
+ * @return 0 if success, < 0 on failure
+ */
+/* NOTE: Must be called while holding the flash transaction lock */
+static int8_t logfs_gc_forget (struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	struct slot_header slot_hdr;
+	uint16_t slot_id = 0;
+
+	switch (logfs_object_find_next (logfs, logfs->gc_dst_arena_id, &slot_hdr, &slot_id, obj_id, obj_inst_id)) {
+	case 0:
+		break;
+	case -1:
+		/* Should have been there, but then nothing to do */
+		return 0;
+	default:
+		return -1;
+	}
+
+	slot_hdr.state = SLOT_STATE_OBSOLETE;
+	if (PIOS_FLASH_write_data(logfs->partition_id,
+					logfs_get_addr (logfs, logfs->gc_dst_arena_id, slot_id),
+					(uint8_t *)&slot_hdr,
+					sizeof(slot_hdr)) != 0) {
+		return -2;
+	}
+
+	return 0;
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
-/* OPTIMIZE: could trust that there is at most one active version of every object and terminate the search when we find one */
 static int8_t logfs_delete_object (struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
 {
 	int8_t rc;
 
+	/* With a complete index there is at most one active version to find */
 	bool more = true;
 	uint16_t curr_slot_id = 0;
 	do {
 		struct slot_header slot_hdr;
-		switch (logfs_object_find_next (logfs, &slot_hdr, &curr_slot_id, obj_id, obj_inst_id)) {
+		int16_t found;
+
+		if (logfs->index_complete) {
+			found = logfs_object_find (logfs, &slot_hdr, &curr_slot_id, obj_id, obj_inst_id);
+		} else {
+			found = logfs_object_find_next (logfs, logfs->active_arena_id, &slot_hdr, &curr_slot_id, obj_id, obj_inst_id);
+		}
+
+		switch (found) {
 		case 0:
 			/* Found a matching slot.  Obsolete it. */
 			slot_hdr.state = SLOT_STATE_OBSOLETE;
@@ -719,6 +1106,20 @@ static int8_t logfs_delete_object (struct logfs_state *logfs, uint32_t obj_id, u
 			}
 			/* Object has been successfully obsoleted and is no longer active */
 			logfs->num_active_slots--;
+			logfs_index_remove(logfs, obj_id, obj_inst_id);
+
+			/* Don't let the garbage collection bring back a copy */
+			if (logfs->gc_state == LOGFS_GC_COPY &&
+				curr_slot_id < logfs->gc_src_slot_id &&
+				logfs_gc_forget(logfs, obj_id, obj_inst_id) != 0) {
+				rc = -2;
+				goto out_exit;
+			}
+
+			if (logfs->index_complete) {
+				more = false;
+				rc = 0;
+			}
 			break;
 		case -1:
 			/* Search completed, object not found */
@@ -831,6 +1232,102 @@ static int8_t logfs_append_to_log (struct logfs_state *logfs, uint32_t obj_id, u
 
 	/* Object has been successfully written to the slot */
 	logfs->num_active_slots++;
+	logfs_index_set(logfs, obj_id, obj_inst_id, free_slot_id);
+	return 0;
+}
+
+/**
+ * Check whether the active version of an object already holds this data
+ * @return true if it does, false if it differs, is missing or can't be read
+ */
+/* NOTE: Must be called while holding the flash transaction lock */
+static bool logfs_object_is_stored (struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, const uint8_t *obj_data, uint16_t obj_size)
+{
+	uint16_t slot_id;
+	struct slot_header slot_hdr;
+	if (logfs_object_find (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
+		return false;
+	}
+
+	if (slot_hdr.obj_size != obj_size) {
+		return false;
+	}
+
+	uintptr_t data_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id) + sizeof(slot_hdr);
+	uint8_t data_block[RAW_COPY_BLOCK_SIZE];
+
+	for (uint16_t offset = 0; offset < obj_size; offset += RAW_COPY_BLOCK_SIZE) {
+		uint16_t blk_size = MIN(obj_size - offset, RAW_COPY_BLOCK_SIZE);
+
+		if (PIOS_FLASH_read_data(logfs->partition_id,
+						data_addr + offset,
+						data_block,
+						blk_size) != 0) {
+			return false;
+		}
+
+		if (memcmp(data_block, obj_data + offset, blk_size) != 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Write a new version of an object, unless it is already stored
+ * @return 0 if success or the error code of PIOS_FLASHFS_ObjSave
+ */
+/* NOTE: Must be called while holding the flash transaction lock */
+static int8_t logfs_save_object (struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
+{
+	/* Saving what is there already would only wear the flash */
+	if (logfs_object_is_stored(logfs, obj_id, obj_inst_id, obj_data, obj_size)) {
+		return 0;
+	}
+
+	if (logfs_delete_object (logfs, obj_id, obj_inst_id) != 0) {
+		return -3;
+	}
+
+	/*
+	 * All old versions of this object + instance have been invalidated.
+	 * Write the new object.
+	 */
+
+	/* Check if the arena is entirely full. */
+	if (logfs_fs_is_full(logfs)) {
+		/* Note: Filesystem Full means we're full of *active* records so gc won't help at all. */
+		return -4;
+	}
+
+	/* Is garbage collection required? */
+	if (logfs_log_is_full(logfs)) {
+		/* Note: Log Full means the log is full but may contain obsolete slots so gc may free some space */
+		if (logfs_garbage_collect(logfs) != 0) {
+			return -5;
+		}
+		/* Check one more time just to be sure we actually free'd some space */
+		if (logfs_log_is_full(logfs)) {
+			/*
+			 * Log is still full even after gc!
+			 * NOTE: This should not happen since the filesystem wasn't full
+			 *       when we checked above so gc should have helped.
+			 */
+			PIOS_DEBUG_Assert(0);
+			return -6;
+		}
+	}
+
+	/* We have room for our new object.  Append it to the log. */
+	if (logfs_append_to_log(logfs, obj_id, obj_inst_id, obj_data, obj_size) != 0) {
+		/* Error during append */
+		return -7;
+	}
+
+	/* Make room for the next saves before they need it */
+	logfs_gc_schedule(logfs);
+
 	return 0;
 }
 
@@ -857,6 +1354,7 @@ static int8_t logfs_append_to_log (struct logfs_state *logfs, uint32_t obj_id, u
  * @retval -5 if garbage collection failed
  * @retval -6 if filesystem is full even after garbage collection should have freed space
  * @retval -7 if writing the new object to the filesystem failed
+ * @note Nothing is written if the object is stored with the same contents
  */
 int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
 {
@@ -876,54 +1374,52 @@ int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 		goto out_exit;
 	}
 
-	if (logfs_delete_object (logfs, obj_id, obj_inst_id) != 0) {
-		rc = -3;
-		goto out_end_trans;
-	}
+	rc = logfs_save_object(logfs, obj_id, obj_inst_id, obj_data, obj_size);
 
-	/*
-	 * All old versions of this object + instance have been invalidated.
-	 * Write the new object.
-	 */
+	PIOS_FLASH_end_transaction(logfs->partition_id);
 
-	/* Check if the arena is entirely full. */
-	if (logfs_fs_is_full(logfs)) {
-		/* Note: Filesystem Full means we're full of *active* records so gc won't help at all. */
-		rc = -4;
-		goto out_end_trans;
-	}
+out_exit:
+	return rc;
+}
 
-	/* Is garbage collection required? */
-	if (logfs_log_is_full(logfs)) {
-		/* Note: Log Full means the log is full but may contain obsolete slots so gc may free some space */
-		if (logfs_garbage_collect(logfs) != 0) {
-			rc = -5;
-			goto out_end_trans;
-		}
-		/* Check one more time just to be sure we actually free'd some space */
-		if (logfs_log_is_full(logfs)) {
-			/*
-			 * Log is still full even after gc!
-			 * NOTE: This should not happen since the filesystem wasn't full
-			 *       when we checked above so gc should have helped.
-			 */
-			PIOS_DEBUG_Assert(0);
-			rc = -6;
-			goto out_end_trans;
-		}
+/**
+ * @brief Saves many objects to the filesystem in one flash transaction
+ * @param[in] fs_id The filesystem to use for this action
+ * @param[in] next Called for each object to save, until it returns false
+ * @param[in] ctx Passed to next
+ * @return 0 if success or error code
+ * @retval -1 to -7 as for PIOS_FLASHFS_ObjSave, the objects before the
+ *         failed one are saved
+ * @note Objects that are stored already are not written again
+ */
+int32_t PIOS_FLASHFS_ObjSaveBatch(uintptr_t fs_id, pios_flashfs_batch_next_t next, void *ctx)
+{
+	int8_t rc;
+
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		rc = -1;
+		goto out_exit;
 	}
 
-	/* We have room for our new object.  Append it to the log. */
-	if (logfs_append_to_log(logfs, obj_id, obj_inst_id, obj_data, obj_size) != 0) {
-		/* Error during append */
-		rc = -7;
-		goto out_end_trans;
+	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
+		rc = -2;
+		goto out_exit;
 	}
 
-	/* Object successfully written to the log */
 	rc = 0;
 
-out_end_trans:
+	uint32_t obj_id;
+	uint16_t obj_inst_id;
+	uint8_t *obj_data;
+	uint16_t obj_size;
+	while (rc == 0 && next(ctx, &obj_id, &obj_inst_id, &obj_data, &obj_size)) {
+		PIOS_Assert(obj_size <= (logfs->cfg->slot_size - sizeof(struct slot_header)));
+
+		rc = logfs_save_object(logfs, obj_id, obj_inst_id, obj_data, obj_size);
+	}
+
 	PIOS_FLASH_end_transaction(logfs->partition_id);
 
 out_exit:
@@ -965,7 +1461,7 @@ int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 	/* Find the object in the log */
 	uint16_t slot_id = 0;
 	struct slot_header slot_hdr;
-	if (logfs_object_find_next (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
+	if (logfs_object_find (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
 		/* Object does not exist in fs */
 		rc = -3;
 		goto out_end_trans;
@@ -1063,15 +1559,18 @@ int32_t PIOS_FLASHFS_Format(uintptr_t fs_id)
 		goto out_exit;
 	}
 
-	if (logfs->mounted) {
-		logfs_unmount_log(logfs);
-	}
-
 	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
 		rc = -2;
 		goto out_exit;
 	}
 
+	/* Under the transaction, so no garbage collection step is running */
+	logfs->gc_state = LOGFS_GC_IDLE;
+
+	if (logfs->mounted) {
+		logfs_unmount_log(logfs);
+	}
+
 	if (logfs_erase_all_arenas(logfs) != 0) {
 		rc = -3;
 		goto out_end_trans;
@@ -1099,6 +1598,48 @@ out_exit:
 	return rc;
 }
 
+/**
+ * @brief Do the next step of a garbage collection started in the background
+ * @param[in] fs_id The filesystem to use for this action
+ * @return 1 if there is more to do, 0 if there is nothing to do, or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if the garbage collection failed, it starts over next time
+ */
+int32_t PIOS_FLASHFS_Logfs_GarbageCollectStep(uintptr_t fs_id)
+{
+	int32_t rc;
+
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		rc = -1;
+		goto out_exit;
+	}
+
+	/* Saves start it, check before taking the flash */
+	if (logfs->gc_state == LOGFS_GC_IDLE) {
+		rc = 0;
+		goto out_exit;
+	}
+
+	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
+		rc = -2;
+		goto out_exit;
+	}
+
+	rc = logfs_gc_step(logfs);
+	if (rc < 0) {
+		logfs->gc_state = LOGFS_GC_IDLE;
+		rc = -3;
+	}
+
+	PIOS_FLASH_end_transaction(logfs->partition_id);
+
+out_exit:
+	return rc;
+}
+
 /**
  * @}
  * @}
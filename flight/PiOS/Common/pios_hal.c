@@ -150,18 +150,33 @@ uintptr_t pios_com_debug_id;
 #define PIOS_COM_TELEM_USB_TX_BUF_LEN 65
 #endif
 
+/* Bulk endpoints move many packets per frame, as long as the buffer keeps them fed */
+#ifndef PIOS_COM_TELEM_VCP_RX_BUF_LEN
+#define PIOS_COM_TELEM_VCP_RX_BUF_LEN 129
+#endif
+
+#ifndef PIOS_COM_TELEM_VCP_TX_BUF_LEN
+#define PIOS_COM_TELEM_VCP_TX_BUF_LEN 512
+#endif
+
+/* A few ms of 921600 baud each way, for the bridge task's latency */
 #ifndef PIOS_COM_BRIDGE_RX_BUF_LEN
-#define PIOS_COM_BRIDGE_RX_BUF_LEN 65
+#define PIOS_COM_BRIDGE_RX_BUF_LEN 513
 #endif
 
 #ifndef PIOS_COM_BRIDGE_TX_BUF_LEN
-#define PIOS_COM_BRIDGE_TX_BUF_LEN 12
+#define PIOS_COM_BRIDGE_TX_BUF_LEN 513
 #endif
 
 #ifndef PIOS_COM_MAVLINK_TX_BUF_LEN
 #define PIOS_COM_MAVLINK_TX_BUF_LEN 128
 #endif
 
+/* Only for stream requests, which are a few short packets */
+#ifndef PIOS_COM_MAVLINK_RX_BUF_LEN
+#define PIOS_COM_MAVLINK_RX_BUF_LEN 32
+#endif
+
 #ifndef PIOS_COM_MSP_TX_BUF_LEN
 #define PIOS_COM_MSP_TX_BUF_LEN 128
 #endif
@@ -731,7 +746,7 @@ void PIOS_HAL_ConfigurePort(HwSharedPortTypesOptions port_type,
 
 	case HWSHARED_PORTTYPES_MAVLINKTX:
 #if defined(PIOS_INCLUDE_MAVLINK)
-		PIOS_HAL_ConfigureCom(usart_port_cfg, &usart_port_params, 0, PIOS_COM_MAVLINK_TX_BUF_LEN, com_driver, &port_driver_id);
+		PIOS_HAL_ConfigureCom(usart_port_cfg, &usart_port_params, PIOS_COM_MAVLINK_RX_BUF_LEN, PIOS_COM_MAVLINK_TX_BUF_LEN, com_driver, &port_driver_id);
 		target = &pios_com_mavlink_id;
 		PIOS_Modules_Enable(PIOS_MODULE_UAVOMAVLINKBRIDGE);
 #endif          /* PIOS_INCLUDE_MAVLINK */
@@ -916,8 +931,8 @@ void PIOS_HAL_ConfigureCDC(HwSharedUSB_VCPPortOptions port_type,
 	case HWSHARED_USB_VCPPORT_USBTELEMETRY:
 	{
 		if (PIOS_COM_Init(&pios_com_telem_usb_id, &pios_usb_cdc_com_driver, pios_usb_cdc_id,
-						PIOS_COM_TELEM_USB_RX_BUF_LEN,
-						PIOS_COM_TELEM_USB_TX_BUF_LEN)) {
+						PIOS_COM_TELEM_VCP_RX_BUF_LEN,
+						PIOS_COM_TELEM_VCP_TX_BUF_LEN)) {
 			PIOS_Assert(0);
 		}
 	}
@@ -950,6 +965,9 @@ void PIOS_HAL_ConfigureCDC(HwSharedUSB_VCPPortOptions port_type,
 
 #if defined(PIOS_INCLUDE_USB_HID)
 /** @brief Configure USB HID.
+ *
+ * When USB telemetry was already bound to the VCP, it stays there and the
+ * HID reports carry no telemetry.
  *
  * @param[in] port_type The service provided over USB HID communications
  * @param[in] usb_id ID of the USB device
@@ -968,6 +986,9 @@ void PIOS_HAL_ConfigureHID(HwSharedUSB_HIDPortOptions port_type,
 		break;
 	case HWSHARED_USB_HIDPORT_USBTELEMETRY:
 	{
+		if (pios_com_telem_usb_id)
+			break;
+
 		if (PIOS_COM_Init(&pios_com_telem_usb_id,
 				&pios_usb_hid_com_driver, pios_usb_hid_id,
 				PIOS_COM_TELEM_USB_RX_BUF_LEN,
@@ -1235,6 +1256,14 @@ void PIOS_HAL_ConfigureSerialSpeed(uintptr_t com_id,
 		case HWSHARED_SPEEDBPS_230400:
 			PIOS_COM_ChangeBaud(com_id, 230400);
 			break;
+
+		case HWSHARED_SPEEDBPS_460800:
+			PIOS_COM_ChangeBaud(com_id, 460800);
+			break;
+
+		case HWSHARED_SPEEDBPS_921600:
+			PIOS_COM_ChangeBaud(com_id, 921600);
+			break;
 	}
 }
 
@@ -55,10 +55,42 @@ bool PIOS_heap_malloc_failed_p(void)
 
 #endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
 
+#if defined(PIOS_INCLUDE_HEAP_POOLS)
+
+/*
+ * Blocks up to the biggest pool size come from pools of fixed size blocks,
+ * carved from the heap as they are first needed and kept on a free list
+ * once freed, so what is freed can be allocated again.  Every block has a
+ * tag word in front of it saying which pool it is from; bigger blocks are
+ * tagged too, but are never given back.
+ *
+ * The pools are only used once PIOS_heap_enable_pools() is called at the
+ * end of boot.  What is allocated before then is kept for good, so it is
+ * taken off the heap as it was without pools, untagged and unrounded.
+ */
+#define POOL_MIN_SHIFT	4	/* the smallest blocks are 16 bytes */
+#define POOL_TAG	0xB10C0000
+#define POOL_TAG_MASK	0xFFFF0000
+#define POOL_TAG_FREE	0x00008000	/* set while on the free list */
+#define POOL_NONE	0xFF		/* too big for a pool */
+
+struct heap_pool {
+	void *free_list;
+	uint16_t in_use;
+	uint16_t peak;
+	uint16_t carved;
+};
+
+#endif	/* PIOS_INCLUDE_HEAP_POOLS */
+
 struct pios_heap {
 	const uintptr_t start_addr;
 	uintptr_t end_addr;
 	uintptr_t free_addr;
+#if defined(PIOS_INCLUDE_HEAP_POOLS)
+	uintptr_t pool_addr;	/* blocks below are from boot, 0 while booting */
+	struct heap_pool pools[PIOS_HEAP_NUM_POOLS];
+#endif	/* PIOS_INCLUDE_HEAP_POOLS */
 };
 
 static bool is_ptr_in_heap_p(const struct pios_heap *heap, void *buf)
@@ -68,26 +100,44 @@ static bool is_ptr_in_heap_p(const struct pios_heap *heap, void *buf)
 	return ((buf_addr >= heap->start_addr) && (buf_addr <= heap->end_addr));
 }
 
-static void * simple_malloc(struct pios_heap *heap, size_t size)
+static inline void heap_lock(void)
 {
-	if (heap == NULL)
-		return NULL;
-
-	void * buf = NULL;
-	uint32_t align_pad = (sizeof(uintptr_t) - (size & (sizeof(uintptr_t) - 1))) % sizeof(uintptr_t);
-
 #if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
 	PIOS_Thread_Scheduler_Suspend();
 #endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
+}
+
+static inline void heap_unlock(void)
+{
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	PIOS_Thread_Scheduler_Resume();
+#endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
+}
+
+//! Take bytes off the end of the heap; called with the heap locked
+static void * bump_malloc(struct pios_heap *heap, size_t size)
+{
+	void * buf = NULL;
+	uint32_t align_pad = (sizeof(uintptr_t) - (size & (sizeof(uintptr_t) - 1))) % sizeof(uintptr_t);
 
 	if (heap->free_addr + size <= heap->end_addr) {
 		buf = (void *)heap->free_addr;
 		heap->free_addr += size + align_pad;
 	}
 
-#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
-	PIOS_Thread_Scheduler_Resume();
-#endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
+	return buf;
+}
+
+#if !defined(PIOS_INCLUDE_HEAP_POOLS)
+
+static void * simple_malloc(struct pios_heap *heap, size_t size)
+{
+	if (heap == NULL)
+		return NULL;
+
+	heap_lock();
+	void * buf = bump_malloc(heap, size);
+	heap_unlock();
 
 	return buf;
 }
@@ -97,6 +147,114 @@ static void simple_free(struct pios_heap *heap, void *buf)
 	/* This allocator doesn't support free */
 }
 
+#else	/* PIOS_INCLUDE_HEAP_POOLS */
+
+//! The pool for a size, or POOL_NONE
+static uint8_t pool_index(size_t size)
+{
+	for (uint8_t i = 0; i < PIOS_HEAP_NUM_POOLS; i++) {
+		if (size <= (1 << (POOL_MIN_SHIFT + i)))
+			return i;
+	}
+
+	return POOL_NONE;
+}
+
+static void * simple_malloc(struct pios_heap *heap, size_t size)
+{
+	if (heap == NULL)
+		return NULL;
+
+	uint8_t idx = pool_index(size);
+	uint32_t *tag = NULL;
+
+	heap_lock();
+
+	if (!heap->pool_addr) {
+		void *buf = bump_malloc(heap, size);
+		heap_unlock();
+
+		return buf;
+	}
+
+	if (idx == POOL_NONE) {
+		tag = bump_malloc(heap, sizeof(*tag) + size);
+	} else {
+		struct heap_pool *pool = &heap->pools[idx];
+
+		if (pool->free_list) {
+			tag = pool->free_list;
+			pool->free_list = *(void **)(tag + 1);
+		} else {
+			tag = bump_malloc(heap, sizeof(*tag) + (1 << (POOL_MIN_SHIFT + idx)));
+			if (tag)
+				pool->carved++;
+		}
+
+		if (tag) {
+			pool->in_use++;
+			if (pool->in_use > pool->peak)
+				pool->peak = pool->in_use;
+		}
+	}
+
+	heap_unlock();
+
+	if (tag == NULL)
+		return NULL;
+
+	*tag = POOL_TAG | idx;
+
+	return tag + 1;
+}
+
+static void simple_free(struct pios_heap *heap, void *buf)
+{
+	/* Allocated at boot, has no tag */
+	if (!heap->pool_addr || (uintptr_t)buf < heap->pool_addr)
+		return;
+
+	uint32_t *tag = (uint32_t *)buf - 1;
+
+	/* Not one of ours, or freed already */
+	if ((*tag & POOL_TAG_MASK) != POOL_TAG || (*tag & POOL_TAG_FREE))
+		return;
+
+	uint8_t idx = *tag & 0xFF;
+
+	/* Big blocks are left where they are */
+	if (idx >= PIOS_HEAP_NUM_POOLS)
+		return;
+
+	struct heap_pool *pool = &heap->pools[idx];
+
+	heap_lock();
+
+	*tag |= POOL_TAG_FREE;
+	*(void **)(tag + 1) = pool->free_list;
+	pool->free_list = tag;
+	pool->in_use--;
+
+	heap_unlock();
+}
+
+static void simple_get_pool_stats(struct pios_heap *heap,
+		struct pios_heap_pool_stats stats[PIOS_HEAP_NUM_POOLS])
+{
+	heap_lock();
+
+	for (int i = 0; i < PIOS_HEAP_NUM_POOLS; i++) {
+		stats[i].block_size = 1 << (POOL_MIN_SHIFT + i);
+		stats[i].in_use = heap->pools[i].in_use;
+		stats[i].peak = heap->pools[i].peak;
+		stats[i].carved = heap->pools[i].carved;
+	}
+
+	heap_unlock();
+}
+
+#endif	/* PIOS_INCLUDE_HEAP_POOLS */
+
 static size_t simple_get_free_bytes(struct pios_heap *heap)
 {
 	if (heap->free_addr > heap->end_addr)
@@ -185,6 +343,29 @@ void PIOS_free(void * buf)
 		return simple_free(&pios_standard_heap, buf);
 }
 
+/**
+ * Get how the block pools of a heap are used
+ * \param[in] fast the fast heap rather than the standard one
+ * \param[out] stats one entry for each pool, smallest blocks first
+ * \return 0 on success, -1 if there are no pools or no such heap
+ */
+int32_t PIOS_heap_get_pool_stats(bool fast, struct pios_heap_pool_stats stats[PIOS_HEAP_NUM_POOLS])
+{
+#if defined(PIOS_INCLUDE_HEAP_POOLS)
+	if (!fast) {
+		simple_get_pool_stats(&pios_standard_heap, stats);
+		return 0;
+	}
+
+#if defined(PIOS_INCLUDE_FASTHEAP)
+	simple_get_pool_stats(&pios_nodma_heap, stats);
+	return 0;
+#endif	/* PIOS_INCLUDE_FASTHEAP */
+#endif	/* PIOS_INCLUDE_HEAP_POOLS */
+
+	return -1;
+}
+
 size_t xPortGetFreeHeapSize(void) __attribute__((alias ("PIOS_heap_get_free_size")));
 size_t PIOS_heap_get_free_size(void)
 {
@@ -234,18 +415,30 @@ void PIOS_heap_initialize_blocks(void)
 	/* NOP for the simple allocator */
 }
 
+/**
+ * Allocate from the block pools from now on
+ *
+ * Called once boot is done; what was allocated until then stays where it
+ * is and is ignored by PIOS_free().
+ */
+void PIOS_heap_enable_pools(void)
+{
+#if defined(PIOS_INCLUDE_HEAP_POOLS)
+	heap_lock();
+	pios_standard_heap.pool_addr = pios_standard_heap.free_addr;
+#if defined(PIOS_INCLUDE_FASTHEAP)
+	pios_nodma_heap.pool_addr = pios_nodma_heap.free_addr;
+#endif	/* PIOS_INCLUDE_FASTHEAP */
+	heap_unlock();
+#endif	/* PIOS_INCLUDE_HEAP_POOLS */
+}
+
 void xPortIncreaseHeapSize(size_t bytes) __attribute__((alias ("PIOS_heap_increase_size")));
 void PIOS_heap_increase_size(size_t bytes)
 {
-#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
-	PIOS_Thread_Scheduler_Suspend();
-#endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
-
+	heap_lock();
 	simple_extend_heap(&pios_standard_heap, bytes);
-
-#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
-	PIOS_Thread_Scheduler_Resume();
-#endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
+	heap_unlock();
 }
 
 
@@ -201,14 +201,9 @@ static int PIOS_HSUM_UnrollChannels(struct pios_hsum_dev *hsum_dev)
 		/* check crc before processing */
 		if (hsum_dev->proto == PIOS_HSUM_PROTO_SUMD) {
 			/* SUMD has 16 bit CCITT CRC */
-			uint16_t crc = 0;
 			uint8_t *s = &(state->received_data[0]);
 			int len = state->byte_count - 2;
-			for (int n = 0; n < len; n++) {
-				crc ^= (uint16_t)s[n] << 8;
-				for (int i = 0; i < 8; i++)
-					crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
-			}
+			uint16_t crc = PIOS_CRC16_CCITT_updateCRC(0, s, len);
 			if (crc ^ (((uint16_t)s[len] << 8) | s[len + 1]))
 				/* wrong crc checksum found */
 				goto stream_error;
@@ -34,7 +34,6 @@
 
 #include "pios_semaphore.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
 #include "physical_constants.h"
 #include "taskmonitor.h"
 
@@ -67,7 +66,7 @@ struct lis3mdl_dev {
 	uint32_t spi_id;                        /**< Handle to the communication driver */
 	uint32_t spi_slave_mag;                 /**< The slave number (SPI) */
 
-	struct pios_queue *mag_queue;
+	struct pios_sensors_queue *mag_queue;
 
 	struct pios_thread *task_handle;
 };
@@ -113,7 +112,7 @@ static struct lis3mdl_dev *PIOS_LIS_Alloc(const struct pios_lis3mdl_cfg *cfg)
 
 	dev->magic = PIOS_LIS_DEV_MAGIC;
 
-	dev->mag_queue = PIOS_Queue_Create(PIOS_LIS_QUEUE_LEN, sizeof(struct pios_sensor_mag_data));
+	dev->mag_queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_mag_data), PIOS_LIS_QUEUE_LEN);
 	if (dev->mag_queue == NULL) {
 		PIOS_free(dev);
 		return NULL;
@@ -400,7 +399,7 @@ static void PIOS_LIS_Task(void *parameters)
 		mag_data.y *= mag_scale;
 		mag_data.z *= mag_scale;
 
-		PIOS_Queue_Send(lis_dev->mag_queue, &mag_data, 0);
+		PIOS_SENSORS_Push(lis_dev->mag_queue, &mag_data);
 
 		PIOS_Thread_Sleep(9);
 	}
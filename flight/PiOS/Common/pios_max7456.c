@@ -69,6 +69,15 @@
 #define SYNC_INTERVAL_NTSC 33366
 #define SYNC_INTERVAL_PAL  40000
 
+#define SCREEN_CELLS (MAX7456_COLUMNS * MAX7456_PAL_ROWS)
+
+/* Bytes gathered before a flush hands them to the SPI layer */
+#define BURST_LEN 128
+
+/* Unchanged cells between two changes that are cheaper to rewrite than
+ * to start a new run for: a run costs its address, mode and stop bytes */
+#define RUN_MERGE_GAP 6
+
 ///////////////////////////////////////////////////////////////////////////////
 
 struct max7456_dev_s {
@@ -80,12 +89,21 @@ struct max7456_dev_s {
 	uint8_t mode, right, bottom, hcenter, vcenter;
 
 	uint8_t mask;
-	bool opened;
 
 	bool force_mode;
 	uint8_t det_mode_fallback;
 
 	uint32_t next_sync_expected;
+
+	/* What the panels drew this frame, and what the chip shows.  Only
+	 * the cells that differ are sent by PIOS_MAX7456_flush. */
+	uint8_t frame_chr[SCREEN_CELLS];
+	uint8_t frame_attr[SCREEN_CELLS];
+	uint8_t shown_chr[SCREEN_CELLS];
+	uint8_t shown_attr[SCREEN_CELLS];
+
+	uint8_t burst[BURST_LEN];
+	uint16_t burst_len;
 };
 
 static bool poll_vsync_spi (max7456_dev_t dev);
@@ -317,7 +335,6 @@ void PIOS_MAX7456_set_mode(max7456_dev_t dev, bool force, uint8_t fallback)
 void PIOS_MAX7456_clear(max7456_dev_t dev)
 {
 	PIOS_Assert(dev->magic == MAX7456_MAGIC);
-	PIOS_Assert(!dev->opened);
 
 	uint8_t dmm;
 	dmm = read_register_sel(dev, MAX7456_REG_DMM);
@@ -330,6 +347,19 @@ void PIOS_MAX7456_clear(max7456_dev_t dev)
 	while (MAX7456_DMM_CLR_R(dmm) != MAX7456_DMM_CLR_READY) {
 		dmm = read_register_sel(dev, MAX7456_REG_DMM);
 	}
+
+	memset(dev->frame_chr, 0, sizeof(dev->frame_chr));
+	memset(dev->frame_attr, 0, sizeof(dev->frame_attr));
+	memset(dev->shown_chr, 0, sizeof(dev->shown_chr));
+	memset(dev->shown_attr, 0, sizeof(dev->shown_attr));
+}
+
+void PIOS_MAX7456_begin_frame(max7456_dev_t dev)
+{
+	PIOS_Assert(dev->magic == MAX7456_MAGIC);
+
+	memset(dev->frame_chr, 0, sizeof(dev->frame_chr));
+	memset(dev->frame_attr, 0, sizeof(dev->frame_attr));
 }
 
 void PIOS_MAX7456_upload_char (max7456_dev_t dev, uint8_t char_index,
@@ -407,26 +437,28 @@ void PIOS_MAX7456_download_char (max7456_dev_t dev, uint8_t char_index,
 	enable_osd(dev);
 }
 
-/* Assumes you have already selected */
-static inline void set_offset (max7456_dev_t dev, uint8_t col, uint8_t row)
+static bool poll_vsync_spi (max7456_dev_t dev)
 {
-	PIOS_Assert(dev->magic == MAX7456_MAGIC);
-
-	if (col > 29) {
-		// Still will wrap to next line...
-		col = 29;
-	}
+	uint8_t status = read_register_sel(dev, MAX7456_REG_STAT);
 
-	uint16_t offset = (row * 30 + col) & 0x1ff;
-	write_register(dev, MAX7456_REG_DMAH, offset >> 8);
-	write_register(dev, MAX7456_REG_DMAL,(uint8_t) offset);
+	return MAX7456_STAT_VSYNC_R(status) == MAX7456_STAT_VSYNC_TRUE;
 }
 
-static bool poll_vsync_spi (max7456_dev_t dev)
+#define valid_char(c) (c == MAX7456_DMDI_AUTOINCREMENT_STOP ? 0x00 : c)
+
+/* The frame buffer is laid out like display memory, so a string runs on
+ * into the next line just as it would with autoincrement */
+static inline uint16_t frame_offset(max7456_dev_t dev, uint8_t col, uint8_t row)
 {
-	uint8_t status = read_register_sel(dev, MAX7456_REG_STAT);
+	if (col > dev->right) {
+		col = 0;
+	}
 
-	return MAX7456_STAT_VSYNC_R(status) == MAX7456_STAT_VSYNC_TRUE;
+	if (row > dev->bottom) {
+		row = 0;
+	}
+
+	return row * MAX7456_COLUMNS + col;
 }
 
 void PIOS_MAX7456_put (max7456_dev_t dev, 
@@ -434,59 +466,138 @@ void PIOS_MAX7456_put (max7456_dev_t dev,
 {
 	PIOS_Assert(dev->magic == MAX7456_MAGIC);
 
-	PIOS_Assert(!dev->opened);
+	uint16_t offset = frame_offset(dev, col, row);
 
-	chip_select(dev);
-	set_offset(dev, col, row);
-	write_register(dev, MAX7456_REG_DMM,(attr & 0x07) << 3);
-	write_register(dev, MAX7456_REG_DMDI, chr);
-	chip_unselect(dev);
+	dev->frame_chr[offset] = chr;
+	dev->frame_attr[offset] = attr & 0x07;
 }
 
-static void PIOS_MAX7456_open (max7456_dev_t dev, uint8_t col, uint8_t row,
-		uint8_t attr)
+void PIOS_MAX7456_puts(max7456_dev_t dev, uint8_t col, uint8_t row, const char *s, uint8_t attr)
 {
 	PIOS_Assert(dev->magic == MAX7456_MAGIC);
 
-	PIOS_Assert(!dev->opened);
+	if (col == MAX7456_FMT_H_CENTER) {
+		col = ((MAX7456_COLUMNS - strlen(s)) / 2);
+	}
 
-	dev->opened = true;
+	uint16_t offset = frame_offset(dev, col, row);
 
-	chip_select(dev);
-	set_offset(dev, col > dev->right ? 0 : col, row > dev->bottom ? 0 : row);
+	while (*s && offset < SCREEN_CELLS)
+	{
+		dev->frame_chr[offset] = valid_char(*s);
+		dev->frame_attr[offset] = attr & 0x07;
+		offset++;
+		s++;
+	}
+}
 
-	// 16 bits operating mode, char attributes, autoincrement
-	write_register(dev, MAX7456_REG_DMM, ((attr & 0x07) << 3) | 0x01);
+static void burst_add(max7456_dev_t dev, uint8_t val)
+{
+	if (dev->burst_len >= BURST_LEN) {
+		PIOS_SPI_TransferBlock(dev->spi_id, dev->burst, NULL,
+				dev->burst_len);
+		dev->burst_len = 0;
+	}
+
+	dev->burst[dev->burst_len++] = val;
 }
 
-static void PIOS_MAX7456_close (max7456_dev_t dev)
+static void burst_seek(max7456_dev_t dev, uint16_t offset, uint8_t attr,
+		bool autoincrement)
 {
-	PIOS_Assert(dev->magic == MAX7456_MAGIC);
+	burst_add(dev, MAX7456_REG_DMAH);
+	burst_add(dev, (offset >> 8) & 0x01);
+	burst_add(dev, MAX7456_REG_DMAL);
+	burst_add(dev, (uint8_t) offset);
+
+	// 16 bits operating mode, char attributes, maybe autoincrement
+	burst_add(dev, MAX7456_REG_DMM);
+	burst_add(dev, (attr << 3) | (autoincrement ? 0x01 : 0x00));
+}
 
-	PIOS_Assert(dev->opened);
+/* Writes cells [start, end) in one autoincrement run */
+static void burst_run(max7456_dev_t dev, uint16_t start, uint16_t end)
+{
+	uint8_t attr = dev->frame_attr[start];
 
-	// terminate autoincrement mode
-	write_register(dev, MAX7456_REG_DMDI, MAX7456_DMDI_AUTOINCREMENT_STOP);
+	burst_seek(dev, start, attr, true);
 
-	chip_unselect(dev);
-	dev->opened = false;
+	for (uint16_t i = start; i < end; i++) {
+		uint8_t chr = dev->frame_chr[i];
+
+		if (chr == MAX7456_DMDI_AUTOINCREMENT_STOP) {
+			/* This one would end the run; write it on its own */
+			burst_add(dev, MAX7456_DMDI_AUTOINCREMENT_STOP);
+			burst_seek(dev, i, attr, false);
+			burst_add(dev, MAX7456_REG_DMDI);
+			burst_add(dev, chr);
+			burst_seek(dev, i + 1, attr, true);
+		} else {
+			burst_add(dev, chr);
+		}
+
+		dev->shown_chr[i] = chr;
+		dev->shown_attr[i] = attr;
+	}
+
+	// terminate autoincrement mode
+	burst_add(dev, MAX7456_DMDI_AUTOINCREMENT_STOP);
 }
 
-#define valid_char(c) (c == MAX7456_DMDI_AUTOINCREMENT_STOP ? 0x00 : c)
-void PIOS_MAX7456_puts(max7456_dev_t dev, uint8_t col, uint8_t row, const char *s, uint8_t attr)
+void PIOS_MAX7456_flush(max7456_dev_t dev)
 {
 	PIOS_Assert(dev->magic == MAX7456_MAGIC);
 
-	if (col == MAX7456_FMT_H_CENTER) {
-		col = ((MAX7456_COLUMNS - strlen(s)) / 2);
+	uint16_t cells = (dev->bottom + 1) * MAX7456_COLUMNS;
+	if (cells > SCREEN_CELLS) {
+		cells = SCREEN_CELLS;
 	}
-	PIOS_MAX7456_open(dev, col, row, attr);
-	while (*s)
-	{
-		write_register(dev, MAX7456_REG_DMDI, valid_char(*s));
-		s++;
+
+	bool selected = false;
+	uint16_t i = 0;
+
+	while (i < cells) {
+		if (dev->frame_chr[i] == dev->shown_chr[i] &&
+				dev->frame_attr[i] == dev->shown_attr[i]) {
+			i++;
+			continue;
+		}
+
+		/* A run takes one attribute, and goes on over short gaps of
+		 * unchanged cells */
+		uint8_t attr = dev->frame_attr[i];
+		uint16_t start = i;
+		uint16_t end = i + 1;
+
+		for (uint16_t j = end; j < cells && j - end <= RUN_MERGE_GAP; j++) {
+			if (dev->frame_attr[j] != attr) {
+				break;
+			}
+
+			if (dev->frame_chr[j] != dev->shown_chr[j] ||
+					dev->shown_attr[j] != attr) {
+				end = j + 1;
+			}
+		}
+
+		if (!selected) {
+			chip_select(dev);
+			dev->burst_len = 0;
+			selected = true;
+		}
+
+		burst_run(dev, start, end);
+		i = end;
+	}
+
+	if (selected) {
+		if (dev->burst_len) {
+			PIOS_SPI_TransferBlock(dev->spi_id, dev->burst, NULL,
+					dev->burst_len);
+		}
+
+		chip_unselect(dev);
 	}
-	PIOS_MAX7456_close(dev);
 }
 
 void PIOS_MAX7456_get_extents(max7456_dev_t dev, 
@@ -35,7 +35,6 @@
 
 #include "pios_semaphore.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
 #include "physical_constants.h"
 #include "taskmonitor.h"
 
@@ -50,6 +49,10 @@
 
 #define PIOS_MPU_QUEUE_LEN       2
 
+// Accel, temperature and gyro, in the order of the data registers
+#define PIOS_MPU_FIFO_SAMPLE_LEN 14
+#define PIOS_MPU_FIFO_BATCH_MAX  8
+
 #ifndef PIOS_MPU_SPI_HIGH_SPEED
 #define PIOS_MPU_SPI_HIGH_SPEED              20000000	// should result in 10.5MHz clock on F4 targets like Sparky2
 #endif // PIOS_MPU_SPI_HIGH_SPEED
@@ -100,16 +103,17 @@ struct pios_mpu_dev {
 	enum pios_mpu_com_driver com_driver_type;   /**< Communication driver type */
 	uint32_t com_driver_id;                     /**< Handle to the communication driver */
 	uint32_t com_slave_addr;                    /**< The slave address (I2C) or number (SPI) */
-	struct pios_queue *gyro_queue;
-	struct pios_queue *accel_queue;
+	struct pios_sensors_queue *gyro_queue;
+	struct pios_sensors_queue *accel_queue;
 	struct pios_thread *task_handle;
 	struct pios_semaphore *data_ready_sema;
 	enum pios_mpu_gyro_range gyro_range;
 	enum pios_mpu_accel_range accel_range;
+	uint8_t fifo_batch;                         /**< Samples per read, 1 without the FIFO */
 	enum pios_mpu_dev_magic magic;              /**< Magic bytes to validate the struct contents */
 #ifdef PIOS_INCLUDE_MPU_MAG
 	bool use_mag;
-	struct pios_queue *mag_queue;
+	struct pios_sensors_queue *mag_queue;
 #endif // PIOS_INCLUDE_MPU_MAG
 	volatile uint32_t interrupt_count;
 };
@@ -141,6 +145,9 @@ static int32_t PIOS_MPU_Validate(struct pios_mpu_dev *dev);
  * @return 0 if successful
  */
 static int32_t PIOS_MPU_Config(struct pios_mpu_cfg const *cfg);
+static uint8_t PIOS_MPU_UserCtrl(void);
+static int32_t PIOS_MPU_FIFO_Start(uint8_t batch);
+static int32_t PIOS_MPU_FIFO_Read(uint8_t *sample);
 static void PIOS_MPU_Task(void *parameters);
 static int32_t PIOS_MPU_ReadReg(uint8_t reg);
 static int32_t PIOS_MPU_WriteReg(uint8_t reg, uint8_t data);
@@ -185,24 +192,25 @@ static struct pios_mpu_dev *PIOS_MPU_Alloc(const struct pios_mpu_cfg *cfg)
 		return NULL;
 
 	dev->magic = PIOS_MPU_DEV_MAGIC;
+	dev->fifo_batch = 1;
 
-	dev->accel_queue = PIOS_Queue_Create(PIOS_MPU_QUEUE_LEN, sizeof(struct pios_sensor_accel_data));
+	dev->accel_queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_accel_data), PIOS_MPU_QUEUE_LEN);
 	if (dev->accel_queue == NULL) {
 		PIOS_free(dev);
 		return NULL;
 	}
 
-	dev->gyro_queue = PIOS_Queue_Create(PIOS_MPU_QUEUE_LEN, sizeof(struct pios_sensor_gyro_data));
+	dev->gyro_queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_gyro_data), PIOS_MPU_QUEUE_LEN);
 	if (dev->gyro_queue == NULL) {
-		PIOS_Queue_Delete(dev->accel_queue);
+		PIOS_SENSORS_DeleteQueue(dev->accel_queue);
 		PIOS_free(dev);
 		return NULL;
 	}
 
 	dev->data_ready_sema = PIOS_Semaphore_Create();
 	if (dev->data_ready_sema == NULL) {
-		PIOS_Queue_Delete(dev->accel_queue);
-		PIOS_Queue_Delete(dev->gyro_queue);
+		PIOS_SENSORS_DeleteQueue(dev->accel_queue);
+		PIOS_SENSORS_DeleteQueue(dev->gyro_queue);
 		PIOS_free(dev);
 		return NULL;
 	}
@@ -253,13 +261,8 @@ static int32_t PIOS_MPU_Config(struct pios_mpu_cfg const *cfg)
 		return -PIOS_MPU_ERROR_WRITEFAILED;
 
 	// user control
-	if (mpu_dev->com_driver_type == PIOS_MPU_COM_SPI) {
-		if (PIOS_MPU_WriteReg(PIOS_MPU_USER_CTRL_REG, PIOS_MPU_USERCTL_DIS_I2C | PIOS_MPU_USERCTL_I2C_MST_EN) != 0)
-			return -PIOS_MPU_ERROR_WRITEFAILED;
-	} else {
-		if (PIOS_MPU_WriteReg(PIOS_MPU_USER_CTRL_REG, PIOS_MPU_USERCTL_I2C_MST_EN) != 0)
-			return -PIOS_MPU_ERROR_WRITEFAILED;
-	}
+	if (PIOS_MPU_WriteReg(PIOS_MPU_USER_CTRL_REG, PIOS_MPU_UserCtrl()) != 0)
+		return -PIOS_MPU_ERROR_WRITEFAILED;
 
 	// Digital low-pass filter and scale
 	// set this before sample rate else sample rate calculation will fail
@@ -285,6 +288,39 @@ static int32_t PIOS_MPU_Config(struct pios_mpu_cfg const *cfg)
 	return 0;
 }
 
+/**
+ * @brief User control bits for the bus the chip is on, without the FIFO
+ */
+static uint8_t PIOS_MPU_UserCtrl(void)
+{
+	if (mpu_dev->com_driver_type == PIOS_MPU_COM_SPI)
+		return PIOS_MPU_USERCTL_DIS_I2C | PIOS_MPU_USERCTL_I2C_MST_EN;
+	else
+		return PIOS_MPU_USERCTL_I2C_MST_EN;
+}
+
+/**
+ * @brief Have the samples go through the FIFO, so that the task wakes up
+ * and reads the bus once every batch samples instead of every sample
+ * @param[in] batch samples per read, up to PIOS_MPU_FIFO_BATCH_MAX
+ * @returns 0 when success
+ */
+static int32_t PIOS_MPU_FIFO_Start(uint8_t batch)
+{
+	if (PIOS_MPU_WriteReg(PIOS_MPU_FIFO_EN_REG, PIOS_MPU_FIFO_TEMP_OUT |
+			PIOS_MPU_FIFO_GYRO_X_OUT | PIOS_MPU_FIFO_GYRO_Y_OUT |
+			PIOS_MPU_FIFO_GYRO_Z_OUT | PIOS_MPU_ACCEL_OUT) != 0)
+		return -PIOS_MPU_ERROR_WRITEFAILED;
+
+	if (PIOS_MPU_WriteReg(PIOS_MPU_USER_CTRL_REG, PIOS_MPU_UserCtrl() |
+			PIOS_MPU_USERCTL_FIFO_EN | PIOS_MPU_USERCTL_FIFO_RST) != 0)
+		return -PIOS_MPU_ERROR_WRITEFAILED;
+
+	mpu_dev->fifo_batch = batch;
+
+	return 0;
+}
+
 #ifdef PIOS_INCLUDE_MPU_MAG
 /**
  * @brief Writes one byte to the AK8xxx register using MPU I2C master
@@ -379,7 +415,7 @@ static int32_t PIOS_MPU_Mag_Config(void)
 
 static bool PIOS_MPU_Mag_Alloc(struct pios_mpu_dev *dev)
 {
-	dev->mag_queue = PIOS_Queue_Create(PIOS_MPU_QUEUE_LEN, sizeof(struct pios_sensor_mag_data));
+	dev->mag_queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_mag_data), PIOS_MPU_QUEUE_LEN);
 	if (dev->mag_queue == NULL) {
 		dev->use_mag = false;
 		return false;
@@ -420,6 +456,21 @@ static int32_t PIOS_MPU_Common_Init(void)
 	}
 #endif // PIOS_INCLUDE_MPU_MAG
 
+	/* The mag comes with the data registers, so the FIFO is only used without it */
+	uint8_t batch = MIN(mpu_dev->cfg->fifo_batch, PIOS_MPU_FIFO_BATCH_MAX);
+#ifdef PIOS_INCLUDE_MPU_MAG
+	if (mpu_dev->use_mag)
+		batch = 1;
+#endif // PIOS_INCLUDE_MPU_MAG
+	if (batch > 1) {
+		if (PIOS_MPU_FIFO_Start(batch) != 0)
+			return -PIOS_MPU_ERROR_NOCONFIG;
+
+		// The sensors see the rate of the batches
+		if (PIOS_MPU_SetSampleRate(mpu_dev->cfg->default_samplerate) != 0)
+			return -PIOS_MPU_ERROR_SAMPLERATE;
+	}
+
 	/* Set up EXTI line */
 	PIOS_EXTI_Init(mpu_dev->cfg->exti_cfg);
 
@@ -654,6 +705,9 @@ int32_t PIOS_MPU_SetSampleRate(uint16_t samplerate_hz)
 
 	int32_t retval = PIOS_MPU_WriteReg(PIOS_MPU_SMPLRT_DIV_REG, (uint8_t)divisor);
 
+	// A batch of samples goes out as one
+	samplerate_hz /= mpu_dev->fifo_batch;
+
 	if (retval == 0) {
 		PIOS_SENSORS_SetSampleRate(PIOS_SENSOR_ACCEL, samplerate_hz);
 		PIOS_SENSORS_SetSampleRate(PIOS_SENSOR_GYRO, samplerate_hz);
@@ -876,6 +930,79 @@ static int32_t PIOS_MPU_ReadReg(uint8_t reg)
 		return data;
 }
 
+/**
+ * @brief Read a batch of samples from the FIFO, and average them
+ * @param[out] sample the mean, laid out as the data registers
+ * @returns 0 when success
+ */
+static int32_t PIOS_MPU_FIFO_Read(uint8_t *sample)
+{
+	static uint8_t fifo_buf[PIOS_MPU_FIFO_BATCH_MAX * PIOS_MPU_FIFO_SAMPLE_LEN];
+	uint8_t count_buf[2];
+
+#if defined(PIOS_INCLUDE_SPI)
+	if (mpu_dev->com_driver_type == PIOS_MPU_COM_SPI) {
+		if (PIOS_MPU_ClaimBus(false) != 0)
+			return -1;
+		PIOS_SPI_TransferByte(mpu_dev->com_driver_id, 0x80 | PIOS_MPU_FIFO_CNT_MSB);
+		PIOS_SPI_TransferBlock(mpu_dev->com_driver_id, NULL, count_buf, sizeof(count_buf));
+		PIOS_MPU_ReleaseBus(false);
+	}
+#endif // defined(PIOS_INCLUDE_SPI)
+#if defined(PIOS_INCLUDE_I2C)
+	if (mpu_dev->com_driver_type == PIOS_MPU_COM_I2C) {
+		if (PIOS_MPU_I2C_Read(PIOS_MPU_FIFO_CNT_MSB, count_buf, sizeof(count_buf)) < 0)
+			return -1;
+	}
+#endif // defined(PIOS_INCLUDE_I2C)
+
+	uint16_t count = count_buf[0] << 8 | count_buf[1];
+
+	// Out of step with the samples, or so far behind it overflowed
+	if (count % PIOS_MPU_FIFO_SAMPLE_LEN ||
+			count > 2 * mpu_dev->fifo_batch * PIOS_MPU_FIFO_SAMPLE_LEN) {
+		PIOS_MPU_WriteReg(PIOS_MPU_USER_CTRL_REG, PIOS_MPU_UserCtrl() |
+				PIOS_MPU_USERCTL_FIFO_EN | PIOS_MPU_USERCTL_FIFO_RST);
+		return -2;
+	}
+
+	int32_t samples = MIN(count / PIOS_MPU_FIFO_SAMPLE_LEN, mpu_dev->fifo_batch);
+	if (samples == 0)
+		return -3;
+
+	uint16_t len = samples * PIOS_MPU_FIFO_SAMPLE_LEN;
+
+#if defined(PIOS_INCLUDE_SPI)
+	if (mpu_dev->com_driver_type == PIOS_MPU_COM_SPI) {
+		if (PIOS_MPU_ClaimBus(false) != 0)
+			return -1;
+		PIOS_SPI_TransferByte(mpu_dev->com_driver_id, 0x80 | PIOS_MPU_FIFO_REG);
+		PIOS_SPI_TransferBlock(mpu_dev->com_driver_id, NULL, fifo_buf, len);
+		PIOS_MPU_ReleaseBus(false);
+	}
+#endif // defined(PIOS_INCLUDE_SPI)
+#if defined(PIOS_INCLUDE_I2C)
+	if (mpu_dev->com_driver_type == PIOS_MPU_COM_I2C) {
+		if (PIOS_MPU_I2C_Read(PIOS_MPU_FIFO_REG, fifo_buf, len) < 0)
+			return -1;
+	}
+#endif // defined(PIOS_INCLUDE_I2C)
+
+	for (int i = 0; i < PIOS_MPU_FIFO_SAMPLE_LEN; i += 2) {
+		int32_t sum = 0;
+		for (int j = 0; j < samples; j++) {
+			const uint8_t *p = &fifo_buf[j * PIOS_MPU_FIFO_SAMPLE_LEN + i];
+			sum += (int16_t)(p[0] << 8 | p[1]);
+		}
+
+		int16_t mean = (sum + (sum >= 0 ? samples / 2 : -samples / 2)) / samples;
+		sample[i] = mean >> 8;
+		sample[i + 1] = mean & 0xff;
+	}
+
+	return 0;
+}
+
 bool PIOS_MPU_IRQHandler(void)
 {
 	if (PIOS_MPU_Validate(mpu_dev) != 0)
@@ -885,6 +1012,10 @@ bool PIOS_MPU_IRQHandler(void)
 
 	mpu_dev->interrupt_count++;
 
+	// Let the FIFO fill up with a batch
+	if (mpu_dev->interrupt_count % mpu_dev->fifo_batch)
+		return false;
+
 	PIOS_Semaphore_Give_FromISR(mpu_dev->data_ready_sema, &woken);
 
 	return woken;
@@ -946,9 +1077,13 @@ static void PIOS_MPU_Task(void *parameters)
 		//Wait for data ready interrupt
 		if (PIOS_Semaphore_Take(mpu_dev->data_ready_sema, PIOS_SEMAPHORE_TIMEOUT_MAX) != true)
 			continue;
-		
+
+		if (mpu_dev->fifo_batch > 1) {
+			if (PIOS_MPU_FIFO_Read(&mpu_rec_buf[IDX_ACCEL_XOUT_H]) != 0)
+				continue;
+		}
 #if defined(PIOS_INCLUDE_SPI)
-		if (mpu_dev->com_driver_type == PIOS_MPU_COM_SPI) {
+		else if (mpu_dev->com_driver_type == PIOS_MPU_COM_SPI) {
 			// claim bus in high speed mode
 			if (PIOS_MPU_ClaimBus(false) != 0)
 				continue;
@@ -963,7 +1098,7 @@ static void PIOS_MPU_Task(void *parameters)
 #endif // defined(PIOS_INCLUDE_SPI)
 
 #if defined(PIOS_INCLUDE_I2C)
-		if (mpu_dev->com_driver_type == PIOS_MPU_COM_I2C) {
+		else if (mpu_dev->com_driver_type == PIOS_MPU_COM_I2C) {
 			// we skip the SPI dummy byte at the beginning of the buffer here
 			if (PIOS_MPU_I2C_Read(PIOS_MPU_ACCEL_X_OUT_MSB, &mpu_rec_buf[IDX_ACCEL_XOUT_H], transfer_size) < 0)
 				continue;
@@ -1121,8 +1256,8 @@ static void PIOS_MPU_Task(void *parameters)
 		gyro_data.z *= gyro_scale;
 		gyro_data.temperature = temperature;
 
-		PIOS_Queue_Send(mpu_dev->accel_queue, &accel_data, 0);
-		PIOS_Queue_Send(mpu_dev->gyro_queue, &gyro_data, 0);
+		PIOS_SENSORS_Push(mpu_dev->accel_queue, &accel_data);
+		PIOS_SENSORS_Push(mpu_dev->gyro_queue, &gyro_data);
 
 #ifdef PIOS_INCLUDE_MPU_MAG
 		if (mpu_dev->use_mag) {
@@ -1143,7 +1278,7 @@ static void PIOS_MPU_Task(void *parameters)
 				mag_data.x *= mag_scale;
 				mag_data.y *= mag_scale;
 				mag_data.z *= mag_scale;
-				PIOS_Queue_Send(mpu_dev->mag_queue, &mag_data, 0);
+				PIOS_SENSORS_Push(mpu_dev->mag_queue, &mag_data);
 
 				// trigger another sample
 				if (mpu_dev->mpu_type == PIOS_MPU9150)
@@ -37,7 +37,6 @@
 
 #include "pios_semaphore.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
 
 /* Private constants */
 #define MPU6050_TASK_PRIORITY		PIOS_THREAD_PRIO_HIGHEST
@@ -55,10 +54,10 @@ struct mpu6050_dev {
 	uint32_t i2c_id;
 	uint8_t i2c_addr;
 	enum pios_mpu60x0_range gyro_range;
-	struct pios_queue *gyro_queue;
+	struct pios_sensors_queue *gyro_queue;
 #if defined(PIOS_MPU6050_ACCEL)
 	enum pios_mpu60x0_accel_range accel_range;
-	struct pios_queue *accel_queue;
+	struct pios_sensors_queue *accel_queue;
 #endif /* PIOS_MPU6050_ACCEL */
 	struct pios_thread *TaskHandle;
 	struct pios_semaphore *data_ready_sema;
@@ -93,7 +92,7 @@ static struct mpu6050_dev *PIOS_MPU6050_alloc(void)
 	mpu6050_dev->magic = PIOS_MPU6050_DEV_MAGIC;
 
 #if defined(PIOS_MPU6050_ACCEL)
-	mpu6050_dev->accel_queue = PIOS_Queue_Create(PIOS_MPU6050_MAX_QUEUESIZE, sizeof(struct pios_sensor_accel_data));
+	mpu6050_dev->accel_queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_accel_data), PIOS_MPU6050_MAX_QUEUESIZE);
 
 	if (mpu6050_dev->accel_queue == NULL) {
 		PIOS_free(mpu6050_dev);
@@ -101,7 +100,7 @@ static struct mpu6050_dev *PIOS_MPU6050_alloc(void)
 	}
 #endif /* PIOS_MPU6050_ACCEL */
 
-	mpu6050_dev->gyro_queue = PIOS_Queue_Create(PIOS_MPU6050_MAX_QUEUESIZE, sizeof(struct pios_sensor_gyro_data));
+	mpu6050_dev->gyro_queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_gyro_data), PIOS_MPU6050_MAX_QUEUESIZE);
 
 	if (mpu6050_dev->gyro_queue == NULL) {
 		PIOS_free(mpu6050_dev);
@@ -717,9 +716,9 @@ static void PIOS_MPU6050_Task(void *parameters)
 		gyro_data.z *= gyro_scale;
 		gyro_data.temperature = temperature;
 
-		PIOS_Queue_Send(pios_mpu6050_dev->accel_queue, &accel_data, 0);
+		PIOS_SENSORS_Push(pios_mpu6050_dev->accel_queue, &accel_data);
 
-		PIOS_Queue_Send(pios_mpu6050_dev->gyro_queue, &gyro_data, 0);
+		PIOS_SENSORS_Push(pios_mpu6050_dev->gyro_queue, &gyro_data);
 
 #else
 
@@ -778,7 +777,7 @@ static void PIOS_MPU6050_Task(void *parameters)
 		gyro_data.z *= gyro_scale;
 		gyro_data.temperature = temperature;
 
-		PIOS_Queue_Send(pios_mpu6050_dev->gyro_queue, &gyro_data, 0);
+		PIOS_SENSORS_Push(pios_mpu6050_dev->gyro_queue, &gyro_data);
 
 #endif /* PIOS_MPU6050_ACCEL */
 	}
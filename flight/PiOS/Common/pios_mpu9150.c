@@ -37,7 +37,6 @@
 #include "pios_mpu60x0.h"
 #include "pios_semaphore.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
 
 /* Private constants */
 #define MPU9150_TASK_PRIORITY		PIOS_THREAD_PRIO_HIGHEST
@@ -70,9 +69,9 @@ struct mpu9150_dev {
 	uint8_t i2c_addr;
 	enum pios_mpu60x0_accel_range accel_range;
 	enum pios_mpu60x0_range gyro_range;
-	struct pios_queue *gyro_queue;
-	struct pios_queue *accel_queue;
-	struct pios_queue *mag_queue;
+	struct pios_sensors_queue *gyro_queue;
+	struct pios_sensors_queue *accel_queue;
+	struct pios_sensors_queue *mag_queue;
 	struct pios_thread *TaskHandle;
 	struct pios_semaphore *data_ready_sema;
 	const struct pios_mpu60x0_cfg * cfg;
@@ -106,19 +105,19 @@ static struct mpu9150_dev * PIOS_MPU9150_alloc(void)
 	
 	mpu9150_dev->magic = PIOS_MPU9150_DEV_MAGIC;
 	
-	mpu9150_dev->accel_queue = PIOS_Queue_Create(PIOS_MPU9150_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_gyro_data));
+	mpu9150_dev->accel_queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_gyro_data), PIOS_MPU9150_MAX_DOWNSAMPLE);
 	if (mpu9150_dev->accel_queue == NULL) {
 		PIOS_free(mpu9150_dev);
 		return NULL;
 	}
 
-	mpu9150_dev->gyro_queue = PIOS_Queue_Create(PIOS_MPU9150_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_gyro_data));
+	mpu9150_dev->gyro_queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_gyro_data), PIOS_MPU9150_MAX_DOWNSAMPLE);
 	if (mpu9150_dev->gyro_queue == NULL) {
 		PIOS_free(mpu9150_dev);
 		return NULL;
 	}
 
-	mpu9150_dev->mag_queue = PIOS_Queue_Create(PIOS_MPU9150_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_mag_data));
+	mpu9150_dev->mag_queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_mag_data), PIOS_MPU9150_MAX_DOWNSAMPLE);
 	if (mpu9150_dev->mag_queue == NULL) {
 		PIOS_free(mpu9150_dev);
 		return NULL;
@@ -765,8 +764,8 @@ static void PIOS_MPU9150_Task(void *parameters)
 		gyro_data.z *= gyro_scale;
 		gyro_data.temperature = temperature;
 
-		PIOS_Queue_Send(dev->accel_queue, &accel_data, 0);
-		PIOS_Queue_Send(dev->gyro_queue, &gyro_data, 0);
+		PIOS_SENSORS_Push(dev->accel_queue, &accel_data);
+		PIOS_SENSORS_Push(dev->gyro_queue, &gyro_data);
 
 		// Check for mag data ready.  Reading it clears this flag.
 		if ((use_mpu_mag) && (PIOS_MPU9150_Mag_GetReg(MPU9150_MAG_STATUS) > 0)) {
@@ -824,7 +823,7 @@ static void PIOS_MPU9150_Task(void *parameters)
 				// Trigger another measurement
 				PIOS_MPU9150_Mag_SetReg(MPU9150_MAG_CNTR, 0x01);
 
-				PIOS_Queue_Send(dev->mag_queue, &mag_data, 0);
+				PIOS_SENSORS_Push(dev->mag_queue, &mag_data);
 			}
 		}
 
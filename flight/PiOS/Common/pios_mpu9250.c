@@ -37,7 +37,6 @@
 #include "pios_mpu60x0.h"
 #include "pios_semaphore.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
 
 /* Private constants */
 #define MPU9250_TASK_PRIORITY	PIOS_THREAD_PRIO_HIGHEST
@@ -70,9 +69,9 @@ struct mpu9250_dev {
 	bool use_mag;
 	enum pios_mpu60x0_accel_range accel_range;
 	enum pios_mpu60x0_range gyro_range;
-	struct pios_queue *gyro_queue;
-	struct pios_queue *accel_queue;
-	struct pios_queue *mag_queue;
+	struct pios_sensors_queue *gyro_queue;
+	struct pios_sensors_queue *accel_queue;
+	struct pios_sensors_queue *mag_queue;
 	struct pios_thread *TaskHandle;
 	struct pios_semaphore *data_ready_sema;
 	const struct pios_mpu9250_cfg * cfg;
@@ -109,13 +108,13 @@ static struct mpu9250_dev * PIOS_MPU9250_alloc(bool use_mag)
 	
 	mpu9250_dev->magic = PIOS_MPU9250_DEV_MAGIC;
 	
-	mpu9250_dev->accel_queue = PIOS_Queue_Create(PIOS_MPU9250_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_gyro_data));
+	mpu9250_dev->accel_queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_gyro_data), PIOS_MPU9250_MAX_DOWNSAMPLE);
 	if (mpu9250_dev->accel_queue == NULL) {
 		PIOS_free(mpu9250_dev);
 		return NULL;
 	}
 
-	mpu9250_dev->gyro_queue = PIOS_Queue_Create(PIOS_MPU9250_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_gyro_data));
+	mpu9250_dev->gyro_queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_gyro_data), PIOS_MPU9250_MAX_DOWNSAMPLE);
 	if (mpu9250_dev->gyro_queue == NULL) {
 		PIOS_free(mpu9250_dev);
 		return NULL;
@@ -123,7 +122,7 @@ static struct mpu9250_dev * PIOS_MPU9250_alloc(bool use_mag)
 
 	mpu9250_dev->use_mag = use_mag;
 	if (use_mag) {
-		mpu9250_dev->mag_queue = PIOS_Queue_Create(PIOS_MPU9250_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_mag_data));
+		mpu9250_dev->mag_queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_mag_data), PIOS_MPU9250_MAX_DOWNSAMPLE);
 		if (mpu9250_dev->mag_queue == NULL) {
 			PIOS_free(mpu9250_dev);
 			return NULL;
@@ -789,8 +788,8 @@ static void PIOS_MPU9250_Task(void *parameters)
 		gyro_data.z *= gyro_scale;
 		gyro_data.temperature = temperature;
 
-		PIOS_Queue_Send(dev->accel_queue, &accel_data, 0);
-		PIOS_Queue_Send(dev->gyro_queue, &gyro_data, 0);
+		PIOS_SENSORS_Push(dev->accel_queue, &accel_data);
+		PIOS_SENSORS_Push(dev->gyro_queue, &gyro_data);
 
 		// Check for mag data ready.  Reading it clears this flag.
 		if (dev->use_mag && PIOS_MPU9250_Mag_GetReg(MPU9250_MAG_STATUS) > 0) {
@@ -845,7 +844,7 @@ static void PIOS_MPU9250_Task(void *parameters)
 				// Trigger another measurement
 				PIOS_MPU9250_Mag_SetReg(MPU9250_MAG_CNTR, 0x01);
 
-				PIOS_Queue_Send(dev->mag_queue, &mag_data, 0);
+				PIOS_SENSORS_Push(dev->mag_queue, &mag_data);
 			}
 		}
 	}
@@ -36,7 +36,6 @@
 #include "pios_ms5611_priv.h"
 #include "pios_semaphore.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
 
 /* Private constants */
 #define PIOS_MS5611_OVERSAMPLING oversampling
@@ -76,7 +75,7 @@ struct ms5611_dev {
 	uint32_t spi_id;
 	uint32_t slave_num;
 	struct pios_thread *task;
-	struct pios_queue *queue;
+	struct pios_sensors_queue *queue;
 
 	int64_t pressure_unscaled;
 	int64_t temperature_unscaled;
@@ -102,7 +101,7 @@ static struct ms5611_dev * PIOS_MS5611_alloc(void)
 
 	memset(ms5611_dev, 0, sizeof(*ms5611_dev));
 
-	ms5611_dev->queue = PIOS_Queue_Create(1, sizeof(struct pios_sensor_baro_data));
+	ms5611_dev->queue = PIOS_SENSORS_CreateQueue(sizeof(struct pios_sensor_baro_data), 1);
 	if (ms5611_dev->queue == NULL) {
 		PIOS_free(ms5611_dev);
 		return NULL;
@@ -478,7 +477,7 @@ static void PIOS_MS5611_Task(void *parameters)
 
 
 		if (read_adc_result == 0) {
-			PIOS_Queue_Send(dev->queue, &data, 0);
+			PIOS_SENSORS_Push(dev->queue, &data);
 		}
 	}
 }
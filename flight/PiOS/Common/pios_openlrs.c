@@ -466,6 +466,66 @@ static void rx_reset(struct pios_openlrs_dev *openlrs_dev)
 	rfm22_releaseBus(openlrs_dev);
 }
 
+/*
+ * The wake-up timer of the RFM22 counts 4 / 32768 s steps (exponent 0)
+ * and raises nIRQ when it expires, which times the hops much finer than
+ * the scheduler tick.  It runs from the internal RC oscillator, so it is
+ * armed a little short and the rest of the wait is timed again.
+ */
+#define WAKEUP_STEPS_PER_S       8192
+#define WAKEUP_MAX_US            500000
+
+static void wakeup_arm(struct pios_openlrs_dev *openlrs_dev, uint32_t time_us)
+{
+	if (time_us > WAKEUP_MAX_US) {
+		time_us = WAKEUP_MAX_US;
+	}
+
+	time_us -= time_us >> 4;
+
+	uint32_t steps = time_us * WAKEUP_STEPS_PER_S / 1000000;
+	if (steps < 1) {
+		steps = 1;
+	}
+
+	openlrs_dev->wakeup_armed = true;
+
+	rfm22_claimBus(openlrs_dev);
+	rfm22_write(openlrs_dev, RFM22_wakeup_timer_period1, 0x00);
+	rfm22_write(openlrs_dev, RFM22_wakeup_timer_period2, steps >> 8);
+	rfm22_write(openlrs_dev, RFM22_wakeup_timer_period3, steps & 0xff);
+	rfm22_write(openlrs_dev, RFM22_interrupt_enable2, RFM22_ie2_enwut);
+
+	// The timer starts counting when it is enabled
+	uint8_t opfc1 = rfm22_read(openlrs_dev, RFM22_op_and_func_ctrl1) & ~RFM22_opfc1_enwt;
+	rfm22_write(openlrs_dev, RFM22_op_and_func_ctrl1, opfc1);
+	rfm22_write(openlrs_dev, RFM22_op_and_func_ctrl1, opfc1 | RFM22_opfc1_enwt);
+	rfm22_releaseBus(openlrs_dev);
+}
+
+/**
+ * Stop the wake-up timer and find out why nIRQ fired
+ * \return true if a packet was received
+ */
+static bool wakeup_disarm(struct pios_openlrs_dev *openlrs_dev)
+{
+	rfm22_claimBus(openlrs_dev);
+	rfm22_write(openlrs_dev, RFM22_interrupt_enable2, 0x00);
+	uint8_t opfc1 = rfm22_read(openlrs_dev, RFM22_op_and_func_ctrl1);
+	rfm22_write(openlrs_dev, RFM22_op_and_func_ctrl1, opfc1 & ~RFM22_opfc1_enwt);
+	openlrs_dev->it_status1 = rfm22_read(openlrs_dev, RFM22_interrupt_status1);
+	openlrs_dev->it_status2 = rfm22_read(openlrs_dev, RFM22_interrupt_status2);
+	rfm22_releaseBus(openlrs_dev);
+
+	openlrs_dev->wakeup_armed = false;
+
+	if ((openlrs_dev->it_status1 & RFM22_is1_ipkvalid) && (openlrs_dev->rf_mode == Receive)) {
+		openlrs_dev->rf_mode = Received;
+	}
+
+	return openlrs_dev->rf_mode == Received;
+}
+
 // TODO: move into dev structure
 uint32_t tx_start = 0;
 
@@ -1243,30 +1303,51 @@ static void pios_openlrs_task(void *parameters)
 		 *  1. the ISR was triggered (packet was received)
 		 *  2. a little before the expected packet (to sample the RSSI while receiving packet)
 		 *  3. a little after expected packet (to channel hop when a packet was missing)
+		 *
+		 * The waits for 2. and 3. are timed by the wake-up timer of the radio, which
+		 * raises the same interrupt as a packet does, rather than by the scheduler tick.
+		 * The semaphore timeout only backs it up.
 		 */
 
+		const uint32_t interval_us = getInterval(&openlrs_dev->bind_data);
 
-		uint32_t delay_ms = 0;
-
-		uint32_t time_since_packet_us = PIOS_DELAY_GetuSSince(openlrs_dev->lastPacketTimeUs);
-
+		uint32_t target_us;
 		if (!rssi_sampled) {
 			// If we had not sampled RSSI yet, schedule a bit early to try and catch while "packet is in the air"
-			uint32_t time_till_measure_rssi_us  = (getInterval(&openlrs_dev->bind_data) - packet_advance_time_us) - time_since_packet_us;
-			delay_ms = (time_till_measure_rssi_us + 999) / 1000;
-			DEBUG_PRINTF(3, "T1: %d\r\n", delay_ms);
+			target_us = interval_us - packet_advance_time_us;
 		} else {
 			// If we have sampled RSSI we want to schedule to hop when a packet has been missed
-			uint32_t time_till_timeout_us  = (getInterval(&openlrs_dev->bind_data) + packet_timeout_us) - time_since_packet_us;
-			delay_ms = (time_till_timeout_us + 999) / 1000;
-			DEBUG_PRINTF(3, "T2: %d %d\r\n", time_till_timeout_us,delay_ms, time_since_packet_us);
+			target_us = interval_us + packet_timeout_us;
+		}
+
+		uint32_t time_since_packet_us = PIOS_DELAY_GetuSSince(openlrs_dev->lastPacketTimeUs);
+
+		uint32_t delay_us = 0;
+		if (time_since_packet_us < target_us) {
+			delay_us = target_us - time_since_packet_us;
 		}
 
 		// Maximum delay based on packet time
-		const uint32_t max_delay = (getInterval(&openlrs_dev->bind_data) + packet_timeout_us) / 1000;
-		if (delay_ms > max_delay) delay_ms = max_delay;
+		const uint32_t max_delay_us = interval_us + packet_timeout_us;
+		if (delay_us > max_delay_us) delay_us = max_delay_us;
+
+		DEBUG_PRINTF(3, "T%d: %d\r\n", rssi_sampled ? 2 : 1, delay_us);
+
+		bool packet = false;
+		if (delay_us > 0) {
+			wakeup_arm(openlrs_dev, delay_us);
+			PIOS_Semaphore_Take(openlrs_dev->sema_isr, (delay_us + 999) / 1000);
+			packet = wakeup_disarm(openlrs_dev);
+		} else {
+			packet = openlrs_dev->rf_mode == Received;
+		}
+
+		if (!packet) {
+			// The wake-up timer runs a little short, so wait out the rest
+			if (PIOS_DELAY_GetuSSince(openlrs_dev->lastPacketTimeUs) < target_us) {
+				continue;
+			}
 
-		if (PIOS_Semaphore_Take(openlrs_dev->sema_isr, delay_ms) == false) {
 			if (!rssi_sampled) {
 				// We timed out to sample RSSI
 				if (openlrs_dev->numberOfLostPackets < 2) {
@@ -1274,17 +1355,17 @@ static void pios_openlrs_task(void *parameters)
 					openlrs_dev->lastRSSITimeUs = openlrs_dev->lastPacketTimeUs;
 					openlrs_status.LastRSSI = rfmGetRSSI(openlrs_dev); // Read the RSSI value
 
-					DEBUG_PRINTF(3, "Sampled RSSI: %d %d\r\n", openlrs_status.LastRSSI, delay);
+					DEBUG_PRINTF(3, "Sampled RSSI: %d %d\r\n", openlrs_status.LastRSSI, delay_us);
 				}
 			} else {
 				// We timed out because packet was missed
-				DEBUG_PRINTF(3, "ISR Timeout. Missed packet: %d %d %d\r\n", delay, getInterval(&openlrs_dev->bind_data), time_since_packet_us);
+				DEBUG_PRINTF(3, "ISR Timeout. Missed packet: %d %d %d\r\n", delay_us, interval_us, time_since_packet_us);
 				pios_openlrs_rx_loop(openlrs_dev);
 			}
 
 			rssi_sampled = true;
 		} else {
-			DEBUG_PRINTF(3, "ISR %d %d %d\r\n", delay, getInterval(&openlrs_dev->bind_data), time_since_packet_us);
+			DEBUG_PRINTF(3, "ISR %d %d %d\r\n", delay_us, interval_us, time_since_packet_us);
 
 			// Process incoming data
 			pios_openlrs_rx_loop(openlrs_dev);
@@ -1304,6 +1385,14 @@ bool PIOS_OpenLRS_EXT_Int(void)
 	if (!pios_openlrs_validate(openlrs_dev))
 		return false;
 
+	// While the wake-up timer is armed the task reads the status to tell
+	// a packet from the timer, as the bus can't be claimed here
+	if (openlrs_dev->wakeup_armed) {
+		bool woken = false;
+		PIOS_Semaphore_Give_FromISR(openlrs_dev->sema_isr, &woken);
+		return woken;
+	}
+
 	if (openlrs_dev->rf_mode == Transmit) {
 		openlrs_dev->rf_mode = Transmitted;
 	}
@@ -1332,6 +1421,7 @@ static struct pios_openlrs_dev *pios_openlrs_alloc(void)
 	}
 
 	openlrs_dev->spi_id = 0;
+	openlrs_dev->wakeup_armed = false;
 
 	// Create the ISR signal
 	openlrs_dev->sema_isr = PIOS_Semaphore_Create();
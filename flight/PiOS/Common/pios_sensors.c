@@ -28,10 +28,23 @@
  */
 
 #include "pios_sensors.h"
+#include "pios_semaphore.h"
+#include "pios_thread.h"
 #include <stddef.h>
 
+//! A ring of samples, and what wakes its reader
+struct pios_sensors_queue {
+	circ_queue_t ring;
+
+	/* Set up the first time the reader waits, and only given while the
+	 * reader is blocked on it, so samples nobody waits for, or that come
+	 * in while the reader is busy, cost no kernel call. */
+	struct pios_semaphore *ready;
+	volatile bool waiting;
+};
+
 //! The list of queue handles
-static struct pios_queue *queues[PIOS_SENSOR_LAST];
+static struct pios_sensors_queue *queues[PIOS_SENSOR_LAST];
 static uint32_t sample_rates[PIOS_SENSOR_LAST];
 static int32_t max_gyro_rate;
 
@@ -49,7 +62,86 @@ int32_t PIOS_SENSORS_Init()
 	return 0;
 }
 
-int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, struct pios_queue *queue)
+/**
+ * Create a queue for a driver to hand its samples over in
+ * @param[in] elem_size size of each sample
+ * @param[in] num_elem most samples that can wait to be read
+ * @return the queue, or NULL if out of memory
+ */
+struct pios_sensors_queue *PIOS_SENSORS_CreateQueue(uint16_t elem_size, uint16_t num_elem)
+{
+	struct pios_sensors_queue *queue = PIOS_malloc(sizeof(*queue));
+
+	if (queue == NULL)
+		return NULL;
+
+	// A circ_queue holds one less than its size
+	queue->ring = circ_queue_new(elem_size, num_elem + 1);
+	if (queue->ring == NULL) {
+		PIOS_free(queue);
+		return NULL;
+	}
+
+	queue->ready = NULL;
+	queue->waiting = false;
+
+	return queue;
+}
+
+/**
+ * Free a queue no one has read from, when a driver fails to come up
+ * @param[in] queue the queue
+ */
+void PIOS_SENSORS_DeleteQueue(struct pios_sensors_queue *queue)
+{
+	// Nothing can free the semaphore, and nothing waited to need one
+	PIOS_Assert(queue->ready == NULL);
+
+	PIOS_free(queue->ring);
+	PIOS_free(queue);
+}
+
+/**
+ * Hand a sample over to the task reading the sensor.  Only one task may
+ * push to a queue.
+ * @param[in] queue the queue
+ * @param[in] sample the sample, of the size the queue was created with
+ * @return true on success, false if the queue is full and the sample
+ * was dropped
+ */
+bool PIOS_SENSORS_Push(struct pios_sensors_queue *queue, const void *sample)
+{
+	if (circ_queue_write_data(queue->ring, sample, 1) != 1)
+		return false;
+
+	if (queue->waiting)
+		PIOS_Semaphore_Give(queue->ready);
+
+	return true;
+}
+
+#if !defined(SIM_POSIX)
+/**
+ * Hand a sample over to the task reading the sensor, from an interrupt
+ * @param[in] queue the queue
+ * @param[in] sample the sample, of the size the queue was created with
+ * @param[out] woken set true if a context switch is needed
+ * @return true on success, false if the queue is full and the sample
+ * was dropped
+ */
+bool PIOS_SENSORS_Push_FromISR(struct pios_sensors_queue *queue, const void *sample, bool *woken)
+{
+	if (circ_queue_write_data(queue->ring, sample, 1) != 1)
+		return false;
+
+	if (queue->waiting)
+		PIOS_Semaphore_Give_FromISR(queue->ready, woken);
+
+	return true;
+}
+#endif /* !defined(SIM_POSIX) */
+
+int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, struct pios_sensors_queue *queue)
 {
 	if(queues[type] != NULL)
 		return -1;
@@ -70,7 +162,7 @@ bool PIOS_SENSORS_IsRegistered(enum pios_sensor_type type)
 	return false;
 }
 
-struct pios_queue *PIOS_SENSORS_GetQueue(enum pios_sensor_type type)
+struct pios_sensors_queue *PIOS_SENSORS_GetQueue(enum pios_sensor_type type)
 {
 	if (type >= PIOS_SENSOR_LAST)
 		return NULL;
@@ -78,6 +170,111 @@ struct pios_queue *PIOS_SENSORS_GetQueue(enum pios_sensor_type type)
 	return queues[type];
 }
 
+/**
+ * Wait for the reader's next samples
+ * @param[in] queue the queue
+ * @param[out] num the number of samples found in a row
+ * @param[in] ms_to_wait how long to wait if there are none
+ * @return the first sample, or NULL on timeout
+ */
+static void *wait_for_data(struct pios_sensors_queue *queue, uint16_t *num,
+		uint32_t ms_to_wait)
+{
+	void *data = circ_queue_read_pos(queue->ring, num, NULL);
+
+	if (data != NULL || ms_to_wait == 0)
+		return data;
+
+	if (queue->ready == NULL) {
+		queue->ready = PIOS_Semaphore_Create();
+
+		if (queue->ready == NULL)
+			return NULL;
+	}
+
+	uint32_t start = PIOS_Thread_Systime();
+
+	while (true) {
+		/* Say we're waiting before looking again, so a sample
+		 * pushed after the look is sure to give the semaphore */
+		queue->waiting = true;
+
+		data = circ_queue_read_pos(queue->ring, num, NULL);
+		if (data != NULL)
+			break;
+
+		uint32_t remaining = ms_to_wait;
+
+		if (ms_to_wait != PIOS_SEMAPHORE_TIMEOUT_MAX) {
+			uint32_t waited = PIOS_Thread_Systime() - start;
+
+			if (waited >= ms_to_wait)
+				break;
+
+			remaining = ms_to_wait - waited;
+		}
+
+		// It may be left given from before; then this just goes round
+		if (!PIOS_Semaphore_Take(queue->ready, remaining))
+			break;
+	}
+
+	queue->waiting = false;
+
+	return data;
+}
+
+/**
+ * Copy out the oldest sample of a sensor
+ * @param[in] type the sensor
+ * @param[out] sample where to put it
+ * @param[in] ms_to_wait how long to wait for one if there are none
+ * @return true if a sample was read, false on timeout or if there is no
+ * such sensor
+ */
+bool PIOS_SENSORS_GetData(enum pios_sensor_type type, void *sample, uint32_t ms_to_wait)
+{
+	struct pios_sensors_queue *queue = PIOS_SENSORS_GetQueue(type);
+
+	if (queue == NULL || wait_for_data(queue, NULL, ms_to_wait) == NULL)
+		return false;
+
+	return circ_queue_read_data(queue->ring, sample, 1) == 1;
+}
+
+/**
+ * Get the waiting samples of a sensor without copying them.  They stay
+ * in the queue until released with PIOS_SENSORS_ReleaseData().
+ * @param[in] type the sensor
+ * @param[out] num the number of samples in a row at the pointer
+ * @param[in] ms_to_wait how long to wait for one if there are none
+ * @return the oldest sample, or NULL on timeout or if there is no such
+ * sensor
+ */
+void *PIOS_SENSORS_PeekData(enum pios_sensor_type type, uint16_t *num, uint32_t ms_to_wait)
+{
+	struct pios_sensors_queue *queue = PIOS_SENSORS_GetQueue(type);
+
+	if (queue == NULL)
+		return NULL;
+
+	return wait_for_data(queue, num, ms_to_wait);
+}
+
+/**
+ * Release samples got with PIOS_SENSORS_PeekData()
+ * @param[in] type the sensor
+ * @param[in] num how many, at most the number it returned
+ */
+void PIOS_SENSORS_ReleaseData(enum pios_sensor_type type, uint16_t num)
+{
+	struct pios_sensors_queue *queue = PIOS_SENSORS_GetQueue(type);
+
+	PIOS_Assert(queue != NULL);
+
+	circ_queue_read_completed_multi(queue->ring, num);
+}
+
 void PIOS_SENSORS_SetMaxGyro(int32_t rate)
 {
 	max_gyro_rate = rate;
@@ -78,7 +78,6 @@ struct pios_srxl_dev {
 	uint32_t rx_timer;
 	uint32_t failsafe_timer;
 	uint8_t frame_length;
-	uint16_t crc;
 };
 
 /* Private Functions */
@@ -93,12 +92,6 @@ static struct pios_srxl_dev *PIOS_SRXL_AllocDev(void);
  * @return true if device is valid, false otherwise
  */
 static bool PIOS_SRXL_ValidateDev(struct pios_srxl_dev *dev);
-/**
- * @brief Update the CRC of the current frame with a new byte
- * @param[in] dev Pointer to device structure
- * @param[in] value New byte to be added to CRC
- */
-static void PIOS_SRXL_UpdateCRC(struct pios_srxl_dev *dev, uint8_t value);
 /**
  * @brief Serial receive callback
  * @param[in] context Pointer to device structure
@@ -180,22 +173,6 @@ static bool PIOS_SRXL_ValidateDev(struct pios_srxl_dev *dev)
 	return false;
 }
 
-static void PIOS_SRXL_UpdateCRC(struct pios_srxl_dev *dev, uint8_t value)
-{
-	if (!PIOS_SRXL_ValidateDev(dev))
-		return;
-
-	uint8_t i;
-	dev->crc = dev->crc ^ (int16_t)value << 8;
-	for(i = 0; i < 8; i++)
-	{
-		if(dev->crc & 0x8000)
-			dev->crc = dev->crc << 1^0x1021;
-		else
-			dev->crc = dev->crc << 1;
-		}
-}
-
 static uint16_t PIOS_SRXL_RxCallback(uintptr_t context, uint8_t *buf,
 	uint16_t buf_len, uint16_t *headroom, bool *task_woken)
 {
@@ -206,9 +183,8 @@ static uint16_t PIOS_SRXL_RxCallback(uintptr_t context, uint8_t *buf,
 	dev->rx_timer = 0;
 	uint16_t consumed = 0;
 
-	for (int i = 0; i < buf_len; i++) {
+	for (int i = 0; i < buf_len; ) {
 		if (dev->rx_buffer_pos == 0) {
-			dev->crc = 0;
 			if (buf[i] == PIOS_SRXL_SYNC_MULTIPLEX12) {
 				dev->frame_length = sizeof(struct pios_srxl_frame_multiplex12);
 			} else if (buf[i] == PIOS_SRXL_SYNC_MULTIPLEX16) {
@@ -216,14 +192,20 @@ static uint16_t PIOS_SRXL_RxCallback(uintptr_t context, uint8_t *buf,
 			} else if (buf[i] == PIOS_SRXL_SYNC_WEATRONIC16) {
 				dev->frame_length = sizeof(struct pios_srxl_frame_weatronic16);
 			} else {
+				i++;
 				continue;
 			}
 		}
-		dev->rx_buffer[dev->rx_buffer_pos++] = buf[i];
-		PIOS_SRXL_UpdateCRC(dev, buf[i]);
+
+		/* take as much of the frame as this buffer holds in one go */
+		uint16_t n = MIN(dev->frame_length - dev->rx_buffer_pos, buf_len - i);
+		memcpy(&dev->rx_buffer[dev->rx_buffer_pos], &buf[i], n);
+		dev->rx_buffer_pos += n;
+		consumed += n;
+		i += n;
+
 		if (dev->rx_buffer_pos == dev->frame_length)
-				PIOS_SRXL_ParseFrame(dev);
-		consumed++;
+			PIOS_SRXL_ParseFrame(dev);
 	}
 
 	if (headroom)
@@ -238,7 +220,8 @@ static void PIOS_SRXL_ParseFrame(struct pios_srxl_dev *dev)
 	if (!PIOS_SRXL_ValidateDev(dev))
 		return;
 
-	if (dev->crc == 0) {
+	/* the CRC over the whole frame, its own CRC included, is 0 */
+	if (PIOS_CRC16_CCITT_updateCRC(0, dev->rx_buffer, dev->frame_length) == 0) {
 		bool failsafe = false; // only used by variants with failsafe flag
 
 		switch (dev->rx_buffer[0]) {
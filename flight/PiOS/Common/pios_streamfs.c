@@ -28,6 +28,7 @@
 #include "pios.h"
 
 #include "pios_flash.h"		     /* PIOS_FLASH_* */
+#include "pios_streamfs.h"      /* Public API */
 #include "pios_streamfs_priv.h" /* Internal API */
 #include "pios_mutex.h"
 #include "pios_semaphore.h"
@@ -49,6 +50,11 @@
  * Files are written into continuous sectors of the flash chip. Each
  * sector has a footer to indicate the file id and the sector id.
  *
+ * The footers also hold the time span each sector covers, and together
+ * serve as the index of the file system: the size and duration of a
+ * file, and the sector to start reading a time range from, are found
+ * from them without reading any of the file contents.
+ *
  * Arenas map onto sectors. 
  */
 
@@ -89,6 +95,10 @@ struct streamfs_state {
 	uintptr_t tx_out_context;
 	uint8_t *com_buffer;
 
+	/* Writes are combined here, so whole pages are programmed at once */
+	uint8_t *write_buffer;
+	uint16_t write_fill;
+
 	/* Information for current file handle */
 	bool file_open_writing;
 	bool file_open_reading;
@@ -96,6 +106,13 @@ struct streamfs_state {
 	int32_t active_file_segment;
 	int32_t active_file_arena;
 	int32_t active_file_arena_offset;
+	uint32_t active_arena_start_time;
+	int32_t read_last_segment;
+
+	/* Arenas after the active one known to be erased, 0 or 1 */
+	uint32_t erased_ahead;
+	/* Times writing had to wait for an erase */
+	uint32_t erase_stalls;
 
 	/* Information about file system contents */
 	int32_t min_file_id;
@@ -128,6 +145,8 @@ struct streamfs_footer {
 	uint32_t written_bytes;
 	uint32_t file_id;
 	uint16_t file_segment;
+	uint32_t start_time;	/* ms when the first byte of the arena was written */
+	uint32_t end_time;	/* ms when the arena was closed */
 } __attribute__((packed));
 
 
@@ -170,6 +189,63 @@ static int32_t streamfs_erase_all_arenas(const struct streamfs_state *streamfs)
 	return 0;
 }
 
+/**
+ * @brief Checks whether an arena is erased, from its footer
+ * @return 1 if erased, 0 if not, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t streamfs_arena_erased(const struct streamfs_state *streamfs, uint32_t arena_id)
+{
+	struct streamfs_footer footer;
+
+	uint32_t start_address = streamfs_get_addr(streamfs, arena_id,
+			                          streamfs->cfg->arena_size - sizeof(footer));
+	if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
+		return -1;
+	}
+
+	for (int i=0; i < sizeof(footer); i++) {
+		if (((uint8_t*)&footer)[i] != 0xFF) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * @brief Finds the oldest file again, after an erase may have removed it
+ * @return 0 on success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t streamfs_refresh_min_file_id(struct streamfs_state *streamfs)
+{
+	bool found_file = false;
+
+	streamfs->min_file_id = -1;
+
+	for (uint16_t arena = 0; arena < streamfs->partition_arenas; arena++) {
+		struct streamfs_footer footer;
+		uint32_t start_address = streamfs_get_addr(streamfs, arena,
+				                                   streamfs->cfg->arena_size - sizeof(footer));
+		if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
+			return -1;
+		}
+
+		if (footer.magic == streamfs->cfg->fs_magic) {
+			found_file = true;
+			if (footer.file_id < streamfs->min_file_id)
+				streamfs->min_file_id = footer.file_id;
+		}
+	}
+
+	if (!found_file) {
+		streamfs->min_file_id = -1;
+	}
+
+	return 0;
+}
+
 static bool streamfs_validate(const struct streamfs_state *streamfs)
 {
 	return (streamfs && (streamfs->magic == PIOS_FLASHFS_STREAMFS_DEV_MAGIC));
@@ -198,6 +274,8 @@ static int32_t streamfs_new_sector(struct streamfs_state *streamfs)
 	footer.written_bytes = streamfs->active_file_arena_offset;
 	footer.file_id = streamfs->active_file_id;
 	footer.file_segment = streamfs->active_file_segment;
+	footer.start_time = streamfs->active_arena_start_time;
+	footer.end_time = PIOS_Thread_Systime();
 
 	uint32_t start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
 			                                   streamfs->cfg->arena_size - sizeof(footer));
@@ -210,26 +288,85 @@ static int32_t streamfs_new_sector(struct streamfs_state *streamfs)
 	streamfs->active_file_arena = (streamfs->active_file_arena + 1) % streamfs->partition_arenas;
 	streamfs->active_file_arena_offset = 0;
 	streamfs->active_file_segment++;
+	streamfs->active_arena_start_time = footer.end_time;
+
+	// Erased in the background already
+	if (streamfs->erased_ahead > 0) {
+		streamfs->erased_ahead--;
+		return 0;
+	}
 
 	// Test whether the sector has already been erased by checking the footer
-	start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
-			                          streamfs->cfg->arena_size - sizeof(footer));
-	if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
+	int32_t erased = streamfs_arena_erased(streamfs, streamfs->active_file_arena);
+	if (erased < 0) {
 		return -2;
 	}
 
-	for (int i=0; i < sizeof(footer); i++) {
-		if (((uint8_t*)&footer)[i] != 0xFF) {
-			if (streamfs_erase_arena(streamfs, streamfs->active_file_arena) != 0) {
-				return -3;
-			}
-			break;
+	if (!erased) {
+		streamfs->erase_stalls++;
+
+		if (streamfs_erase_arena(streamfs, streamfs->active_file_arena) != 0) {
+			return -3;
+		}
+
+		if (streamfs_refresh_min_file_id(streamfs) != 0) {
+			return -4;
 		}
 	}
 
 	return 0;
 }
 
+/**
+ * Erase the arena the file being written will move on to, once half of
+ * the active one is written.  Erasing sooner, or further ahead, would
+ * throw away the oldest logs before they have to go.  Takes the flash
+ * transaction lock.
+ * @return 1 if it went on to an arena, 0 if there is nothing to do, < 0 on failure
+ */
+static int32_t streamfs_erase_ahead(struct streamfs_state *streamfs)
+{
+	if (!streamfs->file_open_writing ||
+			streamfs->erased_ahead > 0 ||
+			streamfs->partition_arenas < 2 ||
+			streamfs->active_file_arena_offset < streamfs->cfg->arena_size / 2) {
+		return 0;
+	}
+
+	if (PIOS_FLASH_start_transaction(streamfs->partition_id) != 0) {
+		return -1;
+	}
+
+	int32_t rc;
+	uint32_t arena = (streamfs->active_file_arena + 1 + streamfs->erased_ahead) % streamfs->partition_arenas;
+
+	int32_t erased = streamfs_arena_erased(streamfs, arena);
+	if (erased < 0) {
+		rc = -2;
+		goto out_end_trans;
+	}
+
+	if (!erased) {
+		if (streamfs_erase_arena(streamfs, arena) != 0) {
+			rc = -3;
+			goto out_end_trans;
+		}
+
+		if (streamfs_refresh_min_file_id(streamfs) != 0) {
+			rc = -4;
+			goto out_end_trans;
+		}
+	}
+
+	streamfs->erased_ahead++;
+	rc = 1;
+
+out_end_trans:
+	PIOS_FLASH_end_transaction(streamfs->partition_id);
+
+	return rc;
+}
+
 /**
  * Close this sector by writing footer. Does not prepare next sector.
  */
@@ -241,6 +378,8 @@ static int32_t streamfs_close_sector(struct streamfs_state *streamfs)
 	footer.written_bytes = streamfs->active_file_arena_offset;
 	footer.file_id = streamfs->active_file_id;
 	footer.file_segment = streamfs->active_file_segment;
+	footer.start_time = streamfs->active_arena_start_time;
+	footer.end_time = PIOS_Thread_Systime();
 
 	uint32_t start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
 			                                   streamfs->cfg->arena_size - sizeof(footer));
@@ -254,20 +393,20 @@ static int32_t streamfs_close_sector(struct streamfs_state *streamfs)
 
 
 /**
- * Find the first arena for a file
+ * Find the last arena for a file
  * @param[in] streamfs the file system handle
  * @param[in] file_id the file to find
  * @return the sector number if found, or negative if there was an error
  *
  * @NOTE: Must be called while holding the flash transaction lock
  */
-static int32_t streamfs_find_first_arena(struct streamfs_state *streamfs, int32_t file_id)
+static int32_t streamfs_find_last_arena(struct streamfs_state *streamfs, int32_t file_id)
 {
 	uint16_t num_arenas = streamfs->partition_size / streamfs->cfg->arena_size;
 
 	bool found_file = false;
-	uint32_t min_segment = 0xFFFFFFFF;
-	uint32_t sector = 0xFFFFFFFF;
+	int32_t max_segment = -1;
+	uint32_t sector = 0;
 
 	for (uint16_t arena = 0; arena < num_arenas; arena++) {
 		// Read footer for each arena
@@ -275,13 +414,13 @@ static int32_t streamfs_find_first_arena(struct streamfs_state *streamfs, int32_
 		uint32_t start_address = streamfs_get_addr(streamfs, arena,
 				                                   streamfs->cfg->arena_size - sizeof(footer));
 		if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
-			return -1;
+			return -3;
 		}
 
 		if (footer.magic == streamfs->cfg->fs_magic && footer.file_id == file_id) {
 			found_file = true;
-			if (footer.file_segment < min_segment) {
-				min_segment = footer.file_segment;
+			if (footer.file_segment > max_segment) {
+				max_segment = footer.file_segment;
 				sector = arena;
 			}
 		}
@@ -291,24 +430,30 @@ static int32_t streamfs_find_first_arena(struct streamfs_state *streamfs, int32_
 		return sector;
 	}
 
-	return -2;
+	return -4;
 }
 
 /**
- * Find the last arena for a file
+ * Summarize a file from the footers of its arenas
  * @param[in] streamfs the file system handle
- * @param[in] file_id the file to find
- * @return the sector number if found, or negative if there was an error
+ * @param[in] file_id the file to summarize
+ * @param[out] info the file start time, duration and length
+ * @return 0 if found, or negative if there was an error
  *
  * @NOTE: Must be called while holding the flash transaction lock
  */
-static int32_t streamfs_find_last_arena(struct streamfs_state *streamfs, int32_t file_id)
+static int32_t streamfs_get_file_info(struct streamfs_state *streamfs, int32_t file_id,
+		struct streamfs_file_info *info)
 {
 	uint16_t num_arenas = streamfs->partition_size / streamfs->cfg->arena_size;
 
 	bool found_file = false;
+	uint32_t min_segment = 0xFFFFFFFF;
 	int32_t max_segment = -1;
-	uint32_t sector = 0;
+	uint32_t end_time = 0;
+
+	info->start_time = 0;
+	info->length = 0;
 
 	for (uint16_t arena = 0; arena < num_arenas; arena++) {
 		// Read footer for each arena
@@ -316,23 +461,89 @@ static int32_t streamfs_find_last_arena(struct streamfs_state *streamfs, int32_t
 		uint32_t start_address = streamfs_get_addr(streamfs, arena,
 				                                   streamfs->cfg->arena_size - sizeof(footer));
 		if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
-			return -3;
+			return -1;
 		}
 
 		if (footer.magic == streamfs->cfg->fs_magic && footer.file_id == file_id) {
 			found_file = true;
+			info->length += footer.written_bytes;
+			if (footer.file_segment < min_segment) {
+				min_segment = footer.file_segment;
+				info->start_time = footer.start_time;
+			}
 			if (footer.file_segment > max_segment) {
 				max_segment = footer.file_segment;
-				sector = arena;
+				end_time = footer.end_time;
 			}
 		}
 	}
 
-	if (found_file) {
-		return sector;
+	if (!found_file) {
+		return -2;
 	}
 
-	return -4;
+	info->duration = end_time - info->start_time;
+
+	return 0;
+}
+
+/**
+ * Find the arena of a file holding the data written at a given time
+ * @param[in] streamfs the file system handle
+ * @param[in] file_id the file to search
+ * @param[in] time the time to find, in ms since boot
+ * @param[out] segment the segment of the file in that arena
+ * @return the arena, the first one of the file if the time is before
+ * its start, or negative if there was an error
+ *
+ * @NOTE: Must be called while holding the flash transaction lock
+ */
+static int32_t streamfs_find_arena_at(struct streamfs_state *streamfs, int32_t file_id,
+		uint32_t time, int32_t *segment)
+{
+	uint16_t num_arenas = streamfs->partition_size / streamfs->cfg->arena_size;
+
+	int32_t first_segment = -1;
+	int32_t first_arena = -1;
+	int32_t found_segment = -1;
+	int32_t found_arena = -1;
+
+	for (uint16_t arena = 0; arena < num_arenas; arena++) {
+		// Read footer for each arena
+		struct streamfs_footer footer;
+		uint32_t start_address = streamfs_get_addr(streamfs, arena,
+				                                   streamfs->cfg->arena_size - sizeof(footer));
+		if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
+			return -1;
+		}
+
+		if (footer.magic != streamfs->cfg->fs_magic || footer.file_id != file_id) {
+			continue;
+		}
+
+		if (first_arena < 0 || footer.file_segment < first_segment) {
+			first_segment = footer.file_segment;
+			first_arena = arena;
+		}
+
+		// The latest arena started by then holds that time
+		if (footer.start_time <= time && footer.file_segment > found_segment) {
+			found_segment = footer.file_segment;
+			found_arena = arena;
+		}
+	}
+
+	if (first_arena < 0) {
+		return -2;
+	}
+
+	if (found_arena < 0) {
+		*segment = first_segment;
+		return first_arena;
+	}
+
+	*segment = found_segment;
+	return found_arena;
 }
 
 /**
@@ -356,6 +567,41 @@ static int32_t streamfs_find_new_sector(struct streamfs_state *streamfs)
 	return (last_sector + 1) % num_arenas;
 }
 
+/**
+ * Program the combined writes into flash, moving on to the next sector
+ * once the data space of this one is full
+ */
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t streamfs_flush_page(struct streamfs_state *streamfs)
+{
+	if (streamfs->write_fill == 0)
+		return 0;
+
+	uint32_t start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
+			                                   streamfs->active_file_arena_offset);
+
+	if (PIOS_FLASH_write_data(streamfs->partition_id, start_address, streamfs->write_buffer, streamfs->write_fill) != 0) {
+		streamfs->write_fill = 0;
+		return -1;
+	}
+
+	streamfs->active_file_arena_offset += streamfs->write_fill;
+	streamfs->write_fill = 0;
+
+	if (streamfs->active_file_arena_offset >= (streamfs->cfg->arena_size - sizeof(struct streamfs_footer))) {
+		if (streamfs_new_sector(streamfs) != 0) {
+			return -2;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Append to the open file.  The data is gathered into the write buffer
+ * and only programmed once it makes up a page (write_size) or reaches
+ * the footer; the last page is programmed by close.
+ */
 /* NOTE: Must be called while holding the flash transaction lock */
 static int32_t streamfs_append_to_file(struct streamfs_state *streamfs, uint8_t *data, uint32_t len)
 {
@@ -366,31 +612,29 @@ static int32_t streamfs_append_to_file(struct streamfs_state *streamfs, uint8_t
 		return -2;
 
 	uint32_t total_written = 0;
+	uint32_t data_end = streamfs->cfg->arena_size - sizeof(struct streamfs_footer);
 
 	while (len > 0) {
-		uint32_t start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
-			                                                 streamfs->active_file_arena_offset);
+		uint32_t pos = streamfs->active_file_arena_offset + streamfs->write_fill;
 
-		// Make sure not to write into the space for the footer
-		uint32_t bytes_to_write = len;
-		if ((streamfs->active_file_arena_offset + bytes_to_write) > (streamfs->cfg->arena_size - sizeof(struct streamfs_footer))) {
-			bytes_to_write = streamfs->cfg->arena_size - sizeof(struct streamfs_footer) - streamfs->active_file_arena_offset;
+		// Room to the end of the page, not writing into the space for the footer
+		uint32_t room = streamfs->cfg->write_size - (pos % streamfs->cfg->write_size);
+		if (pos + room > data_end) {
+			room = data_end - pos;
 		}
 
-		if (PIOS_FLASH_write_data(streamfs->partition_id, start_address, data, bytes_to_write) != 0) {
-			return -3;
-		}
+		uint32_t bytes_to_write = MIN(len, room);
+		memcpy(&streamfs->write_buffer[streamfs->write_fill], data, bytes_to_write);
 
 		// Increment pointers
-		streamfs->active_file_arena_offset += bytes_to_write;
+		streamfs->write_fill += bytes_to_write;
 		len -= bytes_to_write;
 		total_written += bytes_to_write;
 		data = &data[bytes_to_write];
 
-
-		if (streamfs->active_file_arena_offset >= (streamfs->cfg->arena_size - sizeof(struct streamfs_footer))) {
-			if (streamfs_new_sector(streamfs) != 0) {
-				return -4;
+		if (bytes_to_write == room) {
+			if (streamfs_flush_page(streamfs) != 0) {
+				return -3;
 			}
 		}
 	}
@@ -429,6 +673,11 @@ static int32_t streamfs_read_from_file(struct streamfs_state *streamfs, uint8_t
 			return total_read_len;
 		}
 
+		// End of the requested range
+		if (footer.file_segment > streamfs->read_last_segment) {
+			return total_read_len;
+		}
+
 		// End of file
 		if (streamfs->active_file_arena_offset == footer.written_bytes) {
 			return total_read_len;
@@ -529,6 +778,11 @@ static void PIOS_STREAMFS_Task(void *parameters)
 		}
 
 		if (bytes_to_write <= 0) {
+			// Spend the idle time erasing what the file moves on to
+			if (streamfs_erase_ahead(streamfs) > 0) {
+				continue;
+			}
+
 			// Block here until woken.
 			PIOS_Mutex_Unlock(streamfs->mutex);
 			PIOS_Semaphore_Take(streamfs->sem, PIOS_SEMAPHORE_TIMEOUT_MAX);
@@ -553,7 +807,7 @@ static void PIOS_STREAMFS_Task(void *parameters)
 		// Flush available data from PIOS_COM interface to
 		// file system
 		while (bytes_to_write > 0) {
-			if (streamfs_append_to_file(streamfs, streamfs->com_buffer, bytes_to_write) != 0) {
+			if (streamfs_append_to_file(streamfs, streamfs->com_buffer, bytes_to_write) < 0) {
 				break;
 			}
 
@@ -616,6 +870,14 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 		return -1;
 	}
 
+	streamfs->write_buffer = (uint8_t *)PIOS_malloc(cfg->write_size);
+	if (!streamfs->write_buffer) {
+		PIOS_free(streamfs->com_buffer);
+		PIOS_free(streamfs);
+		return -1;
+	}
+	streamfs->write_fill = 0;
+
 	/* Bind configuration parameters to this filesystem instance */
 	streamfs->cfg            = cfg;	/* filesystem configuration */
 	streamfs->partition_id   = partition_id; /* underlying partition */
@@ -627,6 +889,10 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 	streamfs->active_file_id           = 0;
 	streamfs->active_file_arena        = 0;
 	streamfs->active_file_arena_offset = 0;
+	streamfs->active_arena_start_time  = 0;
+	streamfs->read_last_segment        = INT32_MAX;
+	streamfs->erased_ahead             = 0;
+	streamfs->erase_stalls             = 0;
 
 	streamfs->mutex = PIOS_Mutex_Create();
 
@@ -700,6 +966,8 @@ int32_t PIOS_STREAMFS_Format(uintptr_t fs_id)
 		goto out_end_trans;
 	}
 
+	streamfs->erased_ahead = 0;
+
 	/* Chip erased and log remounted successfully */
 	rc = 0;
 
@@ -762,6 +1030,9 @@ int32_t PIOS_STREAMFS_OpenWrite(uintptr_t fs_id)
 	streamfs->active_file_segment = 0;
 	streamfs->active_file_arena = streamfs_find_new_sector(streamfs);
 	streamfs->active_file_arena_offset = 0;
+	streamfs->active_arena_start_time = PIOS_Thread_Systime();
+	streamfs->write_fill = 0;
+	streamfs->erased_ahead = 0;
 	streamfs->file_open_writing = true;
 
 	// Erase this sector to prepare for streaming
@@ -783,7 +1054,30 @@ out_exit:
 	return rc;
 }
 
+/**
+ * Open a file for reading from its start
+ *
+ * @param[in] fs_id the streaming device handle
+ * @param[in] file_id the file to read
+ * @returns 0 if successful, <0 if not
+ */
 int32_t PIOS_STREAMFS_OpenRead(uintptr_t fs_id, uint32_t file_id)
+{
+	return PIOS_STREAMFS_OpenReadRange(fs_id, file_id, 0, 0xFFFFFFFF);
+}
+
+/**
+ * Open part of a file for reading. Reading starts at the beginning of
+ * the sector holding start_ms and ends with the sector holding end_ms,
+ * so it may begin and end in the middle of a record.
+ *
+ * @param[in] fs_id the streaming device handle
+ * @param[in] file_id the file to read
+ * @param[in] start_ms time from the start of the file to read from
+ * @param[in] end_ms time from the start of the file to read until
+ * @returns 0 if successful, <0 if not
+ */
+int32_t PIOS_STREAMFS_OpenReadRange(uintptr_t fs_id, uint32_t file_id, uint32_t start_ms, uint32_t end_ms)
 {
 	int32_t rc;
 
@@ -818,19 +1112,100 @@ int32_t PIOS_STREAMFS_OpenRead(uintptr_t fs_id, uint32_t file_id)
 		goto out_exit;
 	}
 
-	// Find start of file
-	streamfs->active_file_arena = streamfs_find_first_arena(streamfs, file_id);
-	if (streamfs->active_file_arena >= 0) {
-		streamfs->active_file_id = file_id;
-		streamfs->active_file_segment = 0;
-		streamfs->active_file_arena_offset = 0;
-		streamfs->file_open_reading = true;
+	struct streamfs_file_info info;
+	if (streamfs_get_file_info(streamfs, file_id, &info) != 0) {
+		rc = -5;
+		goto out_end_trans;
+	}
+
+	// Find the sectors holding the start and the end of the range
+	int32_t segment = 0;
+	if (start_ms < info.duration) {
+		streamfs->active_file_arena = streamfs_find_arena_at(streamfs, file_id,
+				info.start_time + start_ms, &segment);
 	} else {
+		streamfs->active_file_arena = streamfs_find_last_arena(streamfs, file_id);
+	}
+	if (streamfs->active_file_arena < 0) {
 		streamfs->active_file_arena = 0;
 		rc = -5;
 		goto out_end_trans;
 	}
 
+	streamfs->read_last_segment = INT32_MAX;
+	if (end_ms < info.duration) {
+		uint32_t active_arena = streamfs->active_file_arena;
+		if (streamfs_find_arena_at(streamfs, file_id, info.start_time + end_ms,
+				&streamfs->read_last_segment) < 0) {
+			streamfs->active_file_arena = 0;
+			rc = -5;
+			goto out_end_trans;
+		}
+		streamfs->active_file_arena = active_arena;
+	}
+
+	streamfs->active_file_id = file_id;
+	streamfs->active_file_segment = segment;
+	streamfs->active_file_arena_offset = 0;
+	streamfs->file_open_reading = true;
+
+	rc = 0;
+
+out_end_trans:
+	PIOS_FLASH_end_transaction(streamfs->partition_id);
+
+out_exit:
+	if (locked) {
+		PIOS_Mutex_Unlock(streamfs->mutex);
+	}
+
+	return rc;
+}
+
+/**
+ * Get the start time, duration and length of a file
+ *
+ * @param[in] fs_id the streaming device handle
+ * @param[in] file_id the file to summarize
+ * @param[out] info the file summary
+ * @returns 0 if successful, <0 if not
+ */
+int32_t PIOS_STREAMFS_FileInfo(uintptr_t fs_id, uint32_t file_id, struct streamfs_file_info *info)
+{
+	int32_t rc;
+
+	struct streamfs_state *streamfs = (struct streamfs_state *)
+		PIOS_COM_GetDriverCtx(fs_id);
+	bool locked = false;
+
+	if (!streamfs_validate(streamfs)) {
+		rc = -1;
+		goto out_exit;
+	}
+
+	locked = PIOS_Mutex_Lock(streamfs->mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	if (!locked) {
+		rc = -6;
+		goto out_exit;
+	}
+
+	// The footer of the arena being written isn't there yet
+	if (streamfs->file_open_writing) {
+		rc = -2;
+		goto out_exit;
+	}
+
+	if (PIOS_FLASH_start_transaction(streamfs->partition_id) != 0) {
+		rc = -4;
+		goto out_exit;
+	}
+
+	if (streamfs_get_file_info(streamfs, file_id, info) != 0) {
+		rc = -5;
+		goto out_end_trans;
+	}
+
 	rc = 0;
 
 out_end_trans:
@@ -856,6 +1231,22 @@ int32_t PIOS_STREAMFS_MinFileId(uintptr_t fs_id)
 	return streamfs->min_file_id;
 }
 
+/**
+ * Number of times writing had to wait for an arena to be erased, because
+ * the background erase had not kept up
+ */
+int32_t PIOS_STREAMFS_EraseStalls(uintptr_t fs_id)
+{
+	struct streamfs_state *streamfs = (struct streamfs_state *)
+		PIOS_COM_GetDriverCtx(fs_id);
+
+	if (!streamfs_validate(streamfs)) {
+		return -1;
+	}
+
+	return streamfs->erase_stalls;
+}
+
 int32_t PIOS_STREAMFS_MaxFileId(uintptr_t fs_id)
 {
 	struct streamfs_state *streamfs = (struct streamfs_state *)
@@ -905,6 +1296,12 @@ int32_t PIOS_STREAMFS_Close(uintptr_t fs_id)
 		goto out_exit;
 	}
 
+	// Program what is left of the last page
+	if (streamfs_flush_page(streamfs) != 0) {
+		rc = -3;
+		goto out_end_trans;
+	}
+
 	if (streamfs->active_file_arena_offset != 0) {
 		// Close segment when something has been written. This avoids creating
 		// null files with an open/close operation
@@ -170,6 +170,26 @@ uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp)
 #endif /* (INCLUDE_uxTaskGetStackHighWaterMark == 1) */
 }
 
+/**
+ *
+ * @brief   Returns stack usage of a thread, given what it was last time.
+ *
+ * @param[in] threadp      pointer to instance of @p struct pios_thread
+ * @param[in] previous     the last result for this thread, or 0 for none
+ *
+ * @return stack usage in bytes
+ *
+ * FreeRTOS only scans the whole stack, so this is the same as
+ * PIOS_Thread_Get_Stack_Usage().
+ *
+ */
+uint32_t PIOS_Thread_Get_Stack_Usage_Since(struct pios_thread *threadp, uint32_t previous)
+{
+	(void) previous;
+
+	return PIOS_Thread_Get_Stack_Usage(threadp);
+}
+
 /**
  *
  * @brief   Returns runtime of a thread.
@@ -402,18 +422,51 @@ bool PIOS_Thread_Period_Elapsed(const uint32_t prev_systime, const uint32_t incr
  * @return stack usage in bytes
  */
 uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp)
+{
+	return PIOS_Thread_Get_Stack_Usage_Since(threadp, 0);
+}
+
+/**
+ *
+ * @brief   Returns stack usage of a thread, given what it was last time.
+ *
+ * @param[in] threadp      pointer to instance of @p struct pios_thread
+ * @param[in] previous     the last result for this thread, or 0 for none
+ *
+ * @return stack usage in bytes
+ *
+ * The stack only ever fills further, so the fill word just under the last
+ * mark is a canary: while it is intact the mark stands and nothing is
+ * scanned.  Otherwise only the words under the old mark are.  This can
+ * miss a deeper use that skipped the canary, until the canary goes too.
+ *
+ */
+uint32_t PIOS_Thread_Get_Stack_Usage_Since(struct pios_thread *threadp, uint32_t previous)
 {
 #if CH_DBG_FILL_THREADS
-	uint32_t *stack = (uint32_t*)((size_t)threadp->threadp + sizeof(*threadp->threadp));
-	uint32_t *stklimit = stack;
-	while (*stack ==
+	const uint32_t fill =
 			((CH_STACK_FILL_VALUE << 24) |
 			(CH_STACK_FILL_VALUE << 16) |
 			(CH_STACK_FILL_VALUE << 8) |
-			(CH_STACK_FILL_VALUE << 0)))
+			(CH_STACK_FILL_VALUE << 0));
+	uint32_t *stack = (uint32_t*)((size_t)threadp->threadp + sizeof(*threadp->threadp));
+	uint32_t *stklimit = stack;
+	uint32_t *end = NULL;
+	uint32_t words = previous / 4;
+
+	if (words > 0) {
+		if (stklimit[words - 1] == fill)
+			return previous;
+
+		end = stklimit + words - 1;
+	}
+
+	while ((end == NULL || stack < end) && *stack == fill)
 		++stack;
 	return (stack - stklimit) * 4;
 #else
+	(void) previous;
+
 	return 0;
 #endif /* CH_DBG_FILL_THREADS */
 }
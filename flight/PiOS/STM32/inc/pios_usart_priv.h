@@ -36,12 +36,25 @@
 
 extern const struct pios_com_driver pios_usart_com_driver;
 
+/*
+ * Streams to receive into a ring and send in blocks, instead of taking an
+ * interrupt for every byte.  Only the STM32F4xx driver uses them.  The
+ * stream interrupt must have the same priority as the USART's.
+ */
+struct pios_usart_dma_cfg {
+	struct stm32_irq irq;		/* of the rx stream; flags are all its flags */
+	struct stm32_dma_chan rx;
+	struct stm32_dma_chan tx;
+	uint32_t tx_flags;		/* all the flags of the tx stream */
+};
+
 struct pios_usart_cfg {
 	USART_TypeDef *regs;
 	uint32_t remap;		/* GPIO_Remap_* */
 	struct stm32_gpio rx;
 	struct stm32_gpio tx;
 	struct stm32_irq irq;
+	const struct pios_usart_dma_cfg *dma;	/* optional */
 };
 
 struct pios_usart_params {
@@ -54,6 +67,7 @@ struct pios_usart_params {
 
 extern int32_t PIOS_USART_Init(uintptr_t * usart_id, const struct pios_usart_cfg * cfg, struct pios_usart_params * params);
 extern const struct pios_usart_cfg * PIOS_USART_GetConfig(uintptr_t usart_id);
+extern void PIOS_USART_DMA_irq_handler(USART_TypeDef *regs);
 
 #endif /* PIOS_USART_PRIV_H */
 
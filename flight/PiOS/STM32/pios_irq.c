@@ -93,6 +93,81 @@ bool PIOS_IRQ_InISR(void)
 	return (__get_IPSR() & 0xff) != 0;
 }
 
+#if defined(CPUPROFILE_DIAGNOSTICS)
+/* Cycles charged to the handlers that use PIOS_IRQ_Prologue(), in all and
+ * by exception number.  Only touched with interrupts masked, as handlers
+ * nest. */
+static volatile uint32_t irq_cycles_total;
+static uint32_t irq_cycles[PIOS_IRQ_PROFILE_VECTORS];
+
+/**
+ * Mark a handler starting
+ * \param[out] prof where to keep its start, on the handler's stack
+ */
+void PIOS_IRQ_Profile_Enter(struct pios_irq_profile *prof)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	prof->nested = irq_cycles_total;
+	prof->start = PIOS_DELAY_GetRaw();
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * Mark a handler ending, and charge it its cycles less those of the
+ * handlers that preempted it
+ * \param[in] prof as filled in by PIOS_IRQ_Profile_Enter()
+ */
+void PIOS_IRQ_Profile_Exit(const struct pios_irq_profile *prof)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t self = PIOS_DELAY_GetRaw() - prof->start -
+		(irq_cycles_total - prof->nested);
+	uint32_t vector = __get_IPSR() & 0x1ff;
+
+	irq_cycles_total += self;
+	if (vector < PIOS_IRQ_PROFILE_VECTORS)
+		irq_cycles[vector] += self;
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * Get the cycles charged to all handlers.  It only ever goes up, so the
+ * time handlers took out of a span of code is the difference across it.
+ */
+uint32_t PIOS_IRQ_Profile_Total(void)
+{
+	return irq_cycles_total;
+}
+
+/**
+ * Take the cycles charged to the handler of one exception since the
+ * last call
+ * \param[in] vector the exception number
+ * \return the cycles
+ */
+uint32_t PIOS_IRQ_Profile_Take(uint16_t vector)
+{
+	if (vector >= PIOS_IRQ_PROFILE_VECTORS)
+		return 0;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t cycles = irq_cycles[vector];
+	irq_cycles[vector] = 0;
+
+	__set_PRIMASK(primask);
+
+	return cycles;
+}
+#endif /* CPUPROFILE_DIAGNOSTICS */
+
 /**
   * @}
   * @}
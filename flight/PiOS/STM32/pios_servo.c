@@ -62,6 +62,7 @@ enum channel_mode {
 	REGULAR_PWM,
 	REGULAR_INVERTED_PWM,
 	SYNC_PWM,
+	SYNC_DSHOT_150,
 	SYNC_DSHOT_300,
 	SYNC_DSHOT_600,
 	SYNC_DSHOT_1200
@@ -90,9 +91,24 @@ static bool resetting;
 
 static bool dshot_in_use;
 
+#ifdef PIOS_SERVO_DSHOT_DMA
+//! Per bit, words for BSRR: all pins high, the zeroes low, then all low
+#define DSHOT_DMA_WORDS (16 * 3)
+
+static uint32_t (*dshot_dma_buf)[DSHOT_DMA_WORDS];
+
+//! Which port of ours each DMA port of the config drives, or -1
+static int8_t dshot_dma_gpio[DS_GPIO_NUMVALS];
+
+static bool dshot_dma_ready;
+#endif
+
 /* Private function prototypes */
 static uint32_t timer_apb_clock(TIM_TypeDef *timer);
 static uint32_t max_timer_clock(TIM_TypeDef *timer);
+#ifdef PIOS_SERVO_DSHOT_DMA
+static bool DSHOT_DMA_Setup(void);
+#endif
 
 /**
 * Initialise Servos
@@ -157,6 +173,9 @@ struct timer_bank {
 static void ChannelSetup_DShot(int j, uint16_t rate)
 {
 	switch (rate) {
+		case SHOT_DSHOT150:
+			output_channels[j].mode = SYNC_DSHOT_150;
+			break;
 		case SHOT_DSHOT300:
 			output_channels[j].mode = SYNC_DSHOT_300;
 			break;
@@ -372,6 +391,7 @@ int PIOS_Servo_SetMode(const uint16_t *out_rate, const int banks, const uint16_t
 			TIM_TimeBaseInit(timer_banks[i].timer, &TIM_TimeBaseStructure);
 			break;
 
+		case SHOT_DSHOT150:
 		case SHOT_DSHOT300:
 		case SHOT_DSHOT600:
 		case SHOT_DSHOT1200:
@@ -388,6 +408,7 @@ int PIOS_Servo_SetMode(const uint16_t *out_rate, const int banks, const uint16_t
 			if (timer_banks[i].timer == chan->timer) {
 				/* save the frequency for these channels */
 				switch (rate) {
+				case SHOT_DSHOT150:
 				case SHOT_DSHOT300:
 				case SHOT_DSHOT600:
 				case SHOT_DSHOT1200:
@@ -410,6 +431,10 @@ int PIOS_Servo_SetMode(const uint16_t *out_rate, const int banks, const uint16_t
 		}
 	}
 
+#ifdef PIOS_SERVO_DSHOT_DMA
+	dshot_dma_ready = dshot_in_use && DSHOT_DMA_Setup();
+#endif
+
 	return 0;
 }
 
@@ -452,6 +477,7 @@ void PIOS_Servo_SetFraction(uint8_t servo, uint16_t fraction,
 	}
 
 	switch (output_channels[servo].mode) {
+		case SYNC_DSHOT_150:
 		case SYNC_DSHOT_300:
 		case SYNC_DSHOT_600:
 		case SYNC_DSHOT_1200:
@@ -508,6 +534,7 @@ void PIOS_Servo_Set(uint8_t servo, float position)
 	}
 
 	switch (output_channels[servo].mode) {
+		case SYNC_DSHOT_150:
 		case SYNC_DSHOT_300:
 		case SYNC_DSHOT_600:
 		case SYNC_DSHOT_1200:
@@ -547,6 +574,211 @@ static int DSHOT_Update()
 	return -1;
 }
 #else
+/**
+ * Build the 16 bit DShot packet for a value
+ * \param[in] value 0 to disarm, 1-47 for commands, 48-2047 for throttle
+ * \param[in] telem ask the ESC to send telemetry back
+ * \return the packet, CRC included
+ */
+static uint16_t DSHOT_Packet(uint16_t value, bool telem)
+{
+	uint16_t message = (value << 1) | (telem ? 1 : 0);
+
+	uint16_t crc = message ^ (message >> 4) ^ (message >> 8);
+
+	// A bidirectional ESC will want this inverted, when we get there
+	return (message << 4) | (crc & 0xf);
+}
+
+#ifdef PIOS_SERVO_DSHOT_DMA
+/**
+ * Get the DMA ready to send frames, if the board has it and every DShot pin
+ * is on a port it covers.  Otherwise frames are bitbanged.
+ * \return true if frames go out by DMA
+ */
+static bool DSHOT_DMA_Setup(void)
+{
+	const struct pios_servo_dshot_dma_cfg *dma = servo_cfg->dshot_dma;
+
+	if (!dma) {
+		return false;
+	}
+
+	PIOS_Assert(dma->num_ports <= DS_GPIO_NUMVALS);
+
+	for (int k = 0; k < DS_GPIO_NUMVALS; k++) {
+		dshot_dma_gpio[k] = -1;
+	}
+
+	enum channel_mode dshot_mode = UNCONFIGURED;
+
+	for (int j = 0; j < servo_cfg->num_channels; j++) {
+		const struct pios_tim_channel *chan = &servo_cfg->channels[j];
+
+		if (chan->timer == dma->timer) {
+			/* The pacing timer is driving outputs */
+			return false;
+		}
+
+		switch (output_channels[j].mode) {
+			case SYNC_DSHOT_150:
+			case SYNC_DSHOT_300:
+			case SYNC_DSHOT_600:
+			case SYNC_DSHOT_1200:
+				break;
+			default:
+				continue;
+		}
+
+		if (dshot_mode == UNCONFIGURED) {
+			dshot_mode = output_channels[j].mode;
+		} else if (dshot_mode != output_channels[j].mode) {
+			return false;
+		}
+
+		int k;
+		for (k = 0; k < dma->num_ports; k++) {
+			if (dma->ports[k].gpio == chan->pin.gpio) {
+				break;
+			}
+		}
+
+		if (k == dma->num_ports) {
+			return false;
+		}
+
+		dshot_dma_gpio[k] = output_channels[j].i.dshot.gpio;
+	}
+
+	/* Each bit is three slots: the zeroes fall after the first, the
+	 * ones after the second.  Close to the Betaflight timings below.
+	 */
+	uint32_t slot_ns;
+
+	switch (dshot_mode) {
+		case SYNC_DSHOT_150:
+			slot_ns = 2222;
+			break;
+		case SYNC_DSHOT_300:
+			slot_ns = 1111;
+			break;
+		case SYNC_DSHOT_600:
+			slot_ns = 556;
+			break;
+		case SYNC_DSHOT_1200:
+			slot_ns = 278;
+			break;
+		default:
+			return false;
+	}
+
+	if (!dshot_dma_buf) {
+		dshot_dma_buf = PIOS_malloc(dma->num_ports *
+				sizeof(*dshot_dma_buf));
+
+		if (!dshot_dma_buf) {
+			return false;
+		}
+	}
+
+	TIM_DeInit(dma->timer);
+	TIM_Cmd(dma->timer, DISABLE);
+
+	TIM_TimeBaseInitTypeDef tim_init = {
+		.TIM_Prescaler = 0,
+		.TIM_CounterMode = TIM_CounterMode_Up,
+		.TIM_Period = max_timer_clock(dma->timer) / 1000 * slot_ns /
+			1000000 - 1,
+		.TIM_ClockDivision = TIM_CKD_DIV1,
+	};
+
+	TIM_TimeBaseInit(dma->timer, &tim_init);
+
+	/* All requests come on the same tick of each slot */
+	TIM_SetCompare1(dma->timer, 1);
+	TIM_SetCompare2(dma->timer, 1);
+	TIM_SetCompare3(dma->timer, 1);
+	TIM_SetCompare4(dma->timer, 1);
+
+	TIM_ITConfig(dma->timer, TIM_IT_Update | TIM_IT_CC1 | TIM_IT_CC2 |
+			TIM_IT_CC3 | TIM_IT_CC4 | TIM_IT_COM | TIM_IT_Trigger |
+			TIM_IT_Break, DISABLE);
+
+	return true;
+}
+
+/**
+ * Send a frame by DMA.  Returns straight away; the timer paces the DMA
+ * through all the bits.
+ * \param[in] bits the DShot pins of each port
+ * \param[in] zeroes the pins of each port sending a zero, for each bit
+ */
+static void DSHOT_DMA_Send(const uint16_t *bits,
+		uint16_t zeroes[16][DS_GPIO_NUMVALS])
+{
+	const struct pios_servo_dshot_dma_cfg *dma = servo_cfg->dshot_dma;
+
+	for (int k = 0; k < dma->num_ports; k++) {
+		if (dma->ports[k].stream->CR & DMA_SxCR_EN) {
+			/* Last frame still going out; skip this one */
+			return;
+		}
+	}
+
+	TIM_Cmd(dma->timer, DISABLE);
+	TIM_SetCounter(dma->timer, 0);
+
+	uint16_t requests = 0;
+
+	for (int k = 0; k < dma->num_ports; k++) {
+		int8_t gpio = dshot_dma_gpio[k];
+
+		TIM_DMACmd(dma->timer, dma->ports[k].request, DISABLE);
+
+		if (gpio < 0) {
+			continue;
+		}
+
+		uint32_t *buf = dshot_dma_buf[k];
+
+		for (int i = 0; i < 16; i++) {
+			buf[3 * i] = bits[gpio];
+			buf[3 * i + 1] = ((uint32_t) zeroes[i][gpio]) << 16;
+			buf[3 * i + 2] = ((uint32_t) bits[gpio]) << 16;
+		}
+
+		DMA_Cmd(dma->ports[k].stream, DISABLE);
+		DMA_DeInit(dma->ports[k].stream);
+
+		DMA_InitTypeDef dma_init;
+
+		DMA_StructInit(&dma_init);
+
+		dma_init.DMA_Channel = dma->ports[k].channel;
+		dma_init.DMA_PeripheralBaseAddr =
+			(uintptr_t) &dma->ports[k].gpio->BSRRL;
+		dma_init.DMA_Memory0BaseAddr = (uintptr_t) buf;
+		dma_init.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+		dma_init.DMA_BufferSize = DSHOT_DMA_WORDS;
+		dma_init.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+		dma_init.DMA_MemoryInc = DMA_MemoryInc_Enable;
+		dma_init.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word;
+		dma_init.DMA_MemoryDataSize = DMA_MemoryDataSize_Word;
+		dma_init.DMA_Mode = DMA_Mode_Normal;
+		dma_init.DMA_Priority = DMA_Priority_VeryHigh;
+		dma_init.DMA_FIFOMode = DMA_FIFOMode_Disable;
+
+		DMA_Init(dma->ports[k].stream, &dma_init);
+		DMA_Cmd(dma->ports[k].stream, ENABLE);
+
+		requests |= dma->ports[k].request;
+	}
+
+	TIM_DMACmd(dma->timer, requests, ENABLE);
+	TIM_Cmd(dma->timer, ENABLE);
+}
+#endif /* PIOS_SERVO_DSHOT_DMA */
+
 static int DSHOT_Update()
 {
 	uint16_t dshot_bits[DS_GPIO_NUMVALS] = { 0 };
@@ -558,6 +790,7 @@ static int DSHOT_Update()
 		struct output_channel *chan = &output_channels[i];
 
 		switch (chan->mode) {
+			case SYNC_DSHOT_150:
 			case SYNC_DSHOT_300:
 			case SYNC_DSHOT_600:
 			case SYNC_DSHOT_1200:
@@ -582,13 +815,8 @@ static int DSHOT_Update()
 
 		PIOS_Assert(info->value < 2048);
 
-		uint16_t message = info->value << 5;
 		/* Don't set telem req bit for now */
-
-		message |= 
-			((message >> 4 ) & 0xf) ^
-			((message >> 8 ) & 0xf) ^
-			((message >> 12) & 0xf);
+		uint16_t message = DSHOT_Packet(info->value, false);
 
 		for (int j = 0; j < 16; j++) {
 			if (! (message & 0x8000)) {
@@ -601,6 +829,18 @@ static int DSHOT_Update()
 		info->value = 0;	/* turn off motor if not updated */
 	}
 
+	if (dshot_mode == UNCONFIGURED) {
+		return -1;
+	}
+
+#ifdef PIOS_SERVO_DSHOT_DMA
+	if (dshot_dma_ready) {
+		DSHOT_DMA_Send(dshot_bits, dshot_msg_zeroes);
+
+		return 0;
+	}
+#endif
+
 	uint16_t time_0, time_1, time_tot;
 
 	/* As specified by original document:
@@ -610,14 +850,18 @@ static int DSHOT_Update()
 	 *
 	 * Below timings are as used by Betaflight, which blheli_s seems to
 	 * demand.  Meh.
+	 * DShot 150 - 2000ns 0, 4333ns 1, 6667ns total
 	 * DShot 300 - 1000ns 0, 2166ns 1, 3333ns total
 	 * DShot 600 -  500ns 0, 1083ns 1, 1667ns total
 	 * DShot 1200-  250ns 0,  541ns 1,  833ns total
 	 */
 
 	switch (dshot_mode) {
-		case UNCONFIGURED:
-			return -1;
+		case SYNC_DSHOT_150:
+			time_0   = PIOS_INLINEDELAY_NsToCycles(2000);
+			time_1   = PIOS_INLINEDELAY_NsToCycles(4333);
+			time_tot = PIOS_INLINEDELAY_NsToCycles(6667);
+			break;
 		case SYNC_DSHOT_300:
 			time_0   = PIOS_INLINEDELAY_NsToCycles(1000);
 			time_1   = PIOS_INLINEDELAY_NsToCycles(2166);
@@ -638,10 +882,6 @@ static int DSHOT_Update()
 			break;
 	}
 
-	if (dshot_mode == UNCONFIGURED) {
-		return -1;
-	}
-
 	PIOS_IRQ_Disable();	// Necessary for critical timing below
 
 	register uint16_t a = dshot_bits[DS_GPIOA];
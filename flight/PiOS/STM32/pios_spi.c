@@ -55,6 +55,21 @@ typedef enum {
 	PIOS_SPI_PRESCALER_256 = 7
 } SPIPrescalerTypeDef;
 
+#if defined(STM32F4XX)
+/* Shorter blocks are over before the streams could be set up */
+#define SPI_DMA_MIN_LEN 32
+#define SPI_DMA_TIMEOUT_MS 50
+
+/* The streams cannot reach the CCM */
+#define SPI_DMA_CAN_REACH(p) (((uintptr_t)(p) & 0xFFFF0000) != 0x10000000)
+
+/* What the streams send and receive in place of a missing buffer */
+static uint8_t spi_dma_dummy_tx = 0xff;
+static uint8_t spi_dma_dummy_rx;
+#endif
+
+static struct pios_spi_dev *spi_buses[PIOS_SPI_MAX_BUSES];
+static uint8_t spi_num_buses;
 
 static bool PIOS_SPI_validate(struct pios_spi_dev *com_dev)
 {
@@ -64,7 +79,30 @@ static bool PIOS_SPI_validate(struct pios_spi_dev *com_dev)
 
 static struct pios_spi_dev *PIOS_SPI_alloc(void)
 {
-	return (PIOS_malloc(sizeof(struct pios_spi_dev)));
+	struct pios_spi_dev *spi_dev = PIOS_malloc(sizeof(struct pios_spi_dev));
+
+	if (spi_dev)
+		memset(spi_dev, 0, sizeof(*spi_dev));
+
+	return spi_dev;
+}
+
+static bool PIOS_SPI_LockBus(struct pios_spi_dev *spi_dev)
+{
+#if defined(PIOS_SPI_BUS_MUTEX)
+	return PIOS_Mutex_Lock(spi_dev->busy, PIOS_MUTEX_TIMEOUT_MAX);
+#else
+	return PIOS_Semaphore_Take(spi_dev->busy, PIOS_SEMAPHORE_TIMEOUT_MAX);
+#endif
+}
+
+static void PIOS_SPI_UnlockBus(struct pios_spi_dev *spi_dev)
+{
+#if defined(PIOS_SPI_BUS_MUTEX)
+	PIOS_Mutex_Unlock(spi_dev->busy);
+#else
+	PIOS_Semaphore_Give(spi_dev->busy);
+#endif
 }
 
 /**
@@ -88,7 +126,25 @@ int32_t PIOS_SPI_Init(uint32_t *spi_id, const struct pios_spi_cfg *cfg)
 	/* Bind the configuration to the device instance */
 	spi_dev->cfg = cfg;
 
+	/* A mutex rather than a semaphore: a task waiting for the bus lends
+	 * its priority to the holder, and waiters are served highest priority
+	 * first, so a gyro read waits for one transaction at most. */
+#if defined(PIOS_SPI_BUS_MUTEX)
+	spi_dev->busy = PIOS_Mutex_Create();
+#else
 	spi_dev->busy = PIOS_Semaphore_Create();
+#endif
+	if (!spi_dev->busy) goto out_fail;
+
+#if defined(STM32F4XX)
+	if (cfg->block_dma) {
+		spi_dev->dma_done = PIOS_Semaphore_Create();
+		if (!spi_dev->dma_done) goto out_fail;
+
+		/* Created given; it is given again by each completed block */
+		PIOS_Semaphore_Take(spi_dev->dma_done, 0);
+	}
+#endif
 
 	switch (spi_dev->cfg->init.SPI_NSS) {
 	case SPI_NSS_Soft:
@@ -160,6 +216,14 @@ int32_t PIOS_SPI_Init(uint32_t *spi_id, const struct pios_spi_cfg *cfg)
 	/* Must store this before enabling interrupt */
 	*spi_id = (uint32_t)spi_dev;
 
+#if defined(STM32F4XX)
+	if (cfg->block_dma)
+		NVIC_Init((NVIC_InitTypeDef *)&cfg->block_dma->irq.init);
+#endif
+
+	if (spi_num_buses < PIOS_SPI_MAX_BUSES)
+		spi_buses[spi_num_buses++] = spi_dev;
+
 	return (0);
 
 out_fail:
@@ -235,9 +299,21 @@ int32_t PIOS_SPI_ClaimBus(uint32_t spi_id)
 	bool valid = PIOS_SPI_validate(spi_dev);
 	PIOS_Assert(valid)
 
-	if (PIOS_Semaphore_Take(spi_dev->busy, PIOS_SEMAPHORE_TIMEOUT_MAX) != true)
+	uint32_t asked_at = PIOS_DELAY_GetRaw();
+
+	if (PIOS_SPI_LockBus(spi_dev) != true)
 		return -1;
 
+	/* The statistics are only written with the bus held */
+	spi_dev->claimed_at = PIOS_DELAY_GetRaw();
+
+	uint32_t wait_us = PIOS_DELAY_DiffuS2(asked_at, spi_dev->claimed_at);
+
+	spi_dev->stats.transactions++;
+	spi_dev->stats.wait_us += wait_us;
+	if (wait_us > spi_dev->stats.max_wait_us)
+		spi_dev->stats.max_wait_us = MIN(wait_us, UINT16_MAX);
+
 	return 0;
 }
 
@@ -248,7 +324,20 @@ int32_t PIOS_SPI_ReleaseBus(uint32_t spi_id)
 	bool valid = PIOS_SPI_validate(spi_dev);
 	PIOS_Assert(valid)
 
-	PIOS_Semaphore_Give(spi_dev->busy);
+	spi_dev->stats.busy_us += PIOS_DELAY_DiffuS2(spi_dev->claimed_at,
+			PIOS_DELAY_GetRaw());
+
+	PIOS_SPI_UnlockBus(spi_dev);
+
+	return 0;
+}
+
+int32_t PIOS_SPI_GetStats(uint8_t bus, struct pios_spi_stats *stats)
+{
+	if (bus >= spi_num_buses)
+		return -1;
+
+	*stats = spi_buses[bus]->stats;
 
 	return 0;
 }
@@ -355,29 +444,123 @@ static int32_t SPI_PIO_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer
 	return 0;
 }
 
+#if defined(STM32F4XX)
+static void SPI_DMA_SetupStream(const struct stm32_dma_chan *chan, SPI_TypeDef *regs,
+		uint32_t dir, uint8_t *buf, uint8_t *dummy, uint16_t len)
+{
+	DMA_InitTypeDef DMAInit = chan->init;
+
+	DMAInit.DMA_PeripheralBaseAddr	= (uint32_t)&regs->DR;
+	DMAInit.DMA_Memory0BaseAddr	= (uint32_t)(buf ? buf : dummy);
+	DMAInit.DMA_DIR			= dir;
+	DMAInit.DMA_BufferSize		= len;
+	DMAInit.DMA_PeripheralInc	= DMA_PeripheralInc_Disable;
+	DMAInit.DMA_MemoryInc		= buf ? DMA_MemoryInc_Enable : DMA_MemoryInc_Disable;
+	DMAInit.DMA_PeripheralDataSize	= DMA_PeripheralDataSize_Byte;
+	DMAInit.DMA_MemoryDataSize	= DMA_MemoryDataSize_Byte;
+	DMAInit.DMA_Mode		= DMA_Mode_Normal;
+	/* Receive first, so the data register is never overrun */
+	DMAInit.DMA_Priority		= (dir == DMA_DIR_PeripheralToMemory) ?
+						DMA_Priority_High : DMA_Priority_Medium;
+	DMAInit.DMA_FIFOMode		= DMA_FIFOMode_Disable;
+	DMAInit.DMA_FIFOThreshold	= DMA_FIFOThreshold_HalfFull;
+	DMAInit.DMA_MemoryBurst		= DMA_MemoryBurst_Single;
+	DMAInit.DMA_PeripheralBurst	= DMA_PeripheralBurst_Single;
+
+	DMA_DeInit(chan->channel);
+	DMA_Init(chan->channel, &DMAInit);
+}
+
+/**
+* Transfers a block of bytes via DMA.  The calling task sleeps until the rx
+* stream has the last byte, leaving the CPU to the others.
+*
+* \param[in] spi_dev SPI device, with streams configured
+* \param[in] send_buffer what to send, or NULL for all-one
+* \param[in] receive_buffer where to receive, or NULL to discard
+* \param[in] len number of bytes which should be transfered
+* \return >= 0 if no error during transfer
+* \return -1 if the streams did not finish in time
+*/
+static int32_t SPI_DMA_TransferBlock(struct pios_spi_dev *spi_dev, const uint8_t *send_buffer, uint8_t *receive_buffer, uint16_t len)
+{
+	const struct pios_spi_dma_cfg *dma = spi_dev->cfg->block_dma;
+	SPI_TypeDef *regs = spi_dev->cfg->regs;
+
+	SPI_DMA_SetupStream(&dma->rx, regs, DMA_DIR_PeripheralToMemory,
+			receive_buffer, &spi_dma_dummy_rx, len);
+	SPI_DMA_SetupStream(&dma->tx, regs, DMA_DIR_MemoryToPeripheral,
+			(uint8_t *)send_buffer, &spi_dma_dummy_tx, len);
+
+	/* Make sure the RXNE flag is cleared by reading the DR register */
+	SPI_ReceiveData8(regs);
+
+	DMA_ITConfig(dma->rx.channel, DMA_IT_TC, ENABLE);
+	DMA_Cmd(dma->rx.channel, ENABLE);
+	DMA_Cmd(dma->tx.channel, ENABLE);
+	SPI_I2S_DMACmd(regs, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
+
+	bool done = PIOS_Semaphore_Take(spi_dev->dma_done, SPI_DMA_TIMEOUT_MS);
+
+	SPI_I2S_DMACmd(regs, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+	DMA_ITConfig(dma->rx.channel, DMA_IT_TC, DISABLE);
+	DMA_Cmd(dma->tx.channel, DISABLE);
+	DMA_Cmd(dma->rx.channel, DISABLE);
+
+	if (!done) {
+		/* Don't let a late completion end the next block early */
+		PIOS_Semaphore_Take(spi_dev->dma_done, 0);
+		return -1;
+	}
+
+	/* Wait for SPI transfer to have fully completed */
+	while (regs->SR & SPI_I2S_FLAG_BSY);
+
+	return 0;
+}
+#endif /* STM32F4XX */
+
 int32_t PIOS_SPI_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer, uint8_t *receive_buffer, uint16_t len)
 {
+#if defined(STM32F4XX)
+	struct pios_spi_dev *spi_dev = (struct pios_spi_dev *)spi_id;
+
+	if (spi_dev->cfg->block_dma && len >= SPI_DMA_MIN_LEN &&
+			SPI_DMA_CAN_REACH(send_buffer) &&
+			SPI_DMA_CAN_REACH(receive_buffer))
+		return SPI_DMA_TransferBlock(spi_dev, send_buffer, receive_buffer, len);
+#endif
+
 	return SPI_PIO_TransferBlock(spi_id, send_buffer, receive_buffer, len);
 }
 
 void PIOS_SPI_IRQ_Handler(uint32_t spi_id)
 {
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_PROLOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Prologue();
 
 	struct pios_spi_dev *spi_dev = (struct pios_spi_dev *)spi_id;
 
 	bool valid = PIOS_SPI_validate(spi_dev);
 	PIOS_Assert(valid)
 
+#if defined(STM32F4XX)
+	/* The rx stream of a block is done */
+	const struct pios_spi_dma_cfg *dma = spi_dev->cfg->block_dma;
+
+	if (dma) {
+		DMA_ITConfig(dma->rx.channel, DMA_IT_TC, DISABLE);
+		DMA_ClearFlag(dma->rx.channel, dma->irq.flags);
+
+		bool woken = false;
+		PIOS_Semaphore_Give_FromISR(spi_dev->dma_done, &woken);
+	}
+#endif
+
 	if (spi_dev->cfg->init.SPI_Mode != SPI_Mode_Master) {
 		/* XXX handle appropriate slave callback stuff */
 	}
 
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_EPILOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Epilogue();
 }
 
 #endif
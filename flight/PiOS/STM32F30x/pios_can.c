@@ -65,9 +65,12 @@ struct pios_can_dev {
 // Local constants
 #define CAN_COM_ID      0x11
 #define MAX_SEND_LEN    8
+#define CAN_TX_MAILBOXES_EMPTY (CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2)
 
 void USB_HP_CAN1_TX_IRQHandler(void);
 
+static void PIOS_CAN_ConfigureFilters(void);
+
 static bool PIOS_CAN_validate(struct pios_can_dev *can_dev)
 {
 	return (can_dev->magic == PIOS_CAN_DEV_MAGIC);
@@ -130,21 +133,14 @@ int32_t PIOS_CAN_Init(uintptr_t *can_id, const struct pios_can_cfg *cfg)
 	*can_id = (uintptr_t)can_dev;
 
 	CAN_DeInit(can_dev->cfg->regs);
-	CAN_Init(can_dev->cfg->regs, (CAN_InitTypeDef *)&can_dev->cfg->init);
-
-	/* CAN filter init */
-	CAN_FilterInitTypeDef CAN_FilterInitStructure;
-	CAN_FilterInitStructure.CAN_FilterNumber = 0;
-	CAN_FilterInitStructure.CAN_FilterMode = CAN_FilterMode_IdMask;
-	CAN_FilterInitStructure.CAN_FilterScale = CAN_FilterScale_32bit;
-	CAN_FilterInitStructure.CAN_FilterIdHigh = 0x0000;
-	CAN_FilterInitStructure.CAN_FilterIdLow = 0x0000;
-	CAN_FilterInitStructure.CAN_FilterMaskIdHigh = 0x0000;
-	CAN_FilterInitStructure.CAN_FilterMaskIdLow = 0x0000;  
-	CAN_FilterInitStructure.CAN_FilterFIFOAssignment = 1;
-
-	CAN_FilterInitStructure.CAN_FilterActivation = ENABLE;
-	CAN_FilterInit(&CAN_FilterInitStructure);
+
+	/* All three mailboxes are filled at once, so they have to go out in
+	 * the order they were filled rather than by identifier */
+	CAN_InitTypeDef init = can_dev->cfg->init;
+	init.CAN_TXFP = ENABLE;
+	CAN_Init(can_dev->cfg->regs, &init);
+
+	PIOS_CAN_ConfigureFilters();
 
 	// Enable the receiver IRQ
  	NVIC_Init((NVIC_InitTypeDef*) &can_dev->cfg->rx_irq.init);
@@ -209,10 +205,59 @@ static void PIOS_CAN_RegisterTxCallback(uintptr_t can_id, pios_com_callback tx_o
 }
 
 //! The mapping of message types to CAN BUS StdID
-static uint32_t pios_can_message_stdid[PIOS_CAN_LAST] = {
+static const uint32_t pios_can_message_stdid[PIOS_CAN_LAST] = {
 	[PIOS_CAN_GIMBAL] = 0x130,
+	[PIOS_CAN_ACTUATOR] = 0x140,
+	[PIOS_CAN_ESC_TELEMETRY] = 0x150,
 };
 
+//! The size of the data of each message type
+static const uint8_t pios_can_message_len[PIOS_CAN_LAST] = {
+	[PIOS_CAN_GIMBAL] = sizeof(struct pios_can_gimbal_message),
+	[PIOS_CAN_ACTUATOR] = sizeof(struct pios_can_actuator_message),
+	[PIOS_CAN_ESC_TELEMETRY] = sizeof(struct pios_can_esc_telemetry_message),
+};
+
+/**
+ * Set the acceptance filters to pass only the identifiers this driver
+ * handles, so the rest of the traffic on the bus never interrupts us.
+ * Each bank holds four standard identifiers in 16 bit list mode.
+ */
+static void PIOS_CAN_ConfigureFilters(void)
+{
+	uint16_t ids[PIOS_CAN_LAST + 1];
+	uint32_t num_ids = 0;
+
+	ids[num_ids++] = CAN_COM_ID;
+	for (uint32_t i = 0; i < PIOS_CAN_LAST; i++)
+		ids[num_ids++] = pios_can_message_stdid[i];
+
+	uint8_t bank = 0;
+
+	for (uint32_t i = 0; i < num_ids; i += 4, bank++) {
+		// Identifier in the top 11 bits, data frames only; a bank that
+		// isn't filled repeats its last identifier
+		uint16_t entry[4];
+		for (uint32_t j = 0; j < 4; j++) {
+			uint32_t k = (i + j < num_ids) ? (i + j) : (num_ids - 1);
+			entry[j] = (ids[k] & 0x7FF) << 5;
+		}
+
+		CAN_FilterInitTypeDef filter = {
+			.CAN_FilterIdHigh = entry[0],
+			.CAN_FilterIdLow = entry[1],
+			.CAN_FilterMaskIdHigh = entry[2],
+			.CAN_FilterMaskIdLow = entry[3],
+			.CAN_FilterFIFOAssignment = 1,
+			.CAN_FilterNumber = bank,
+			.CAN_FilterMode = CAN_FilterMode_IdList,
+			.CAN_FilterScale = CAN_FilterScale_16bit,
+			.CAN_FilterActivation = ENABLE,
+		};
+		CAN_FilterInit(&filter);
+	}
+}
+
 //! The mapping of message types to CAN BUS StdID
 static struct pios_queue *pios_can_queues[PIOS_CAN_LAST];
 
@@ -250,14 +295,10 @@ static bool process_received_message(CanRxMsg message)
 struct pios_queue * PIOS_CAN_RegisterMessageQueue(uintptr_t id, enum pios_can_messages msg_id)
 {
 	// Fetch the size of this message type or error if unknown
-	uint32_t bytes;
-	switch(msg_id) {
-	case PIOS_CAN_GIMBAL:
-		bytes = sizeof(struct pios_can_gimbal_message);
-		break;
-	default:
+	if (msg_id >= PIOS_CAN_LAST)
 		return NULL;
-	}
+
+	uint32_t bytes = pios_can_message_len[msg_id];
 
 	// Return existing queue if created
 	if (pios_can_queues[msg_id] != NULL)
@@ -282,28 +323,20 @@ static void PIOS_CAN_TxGeneric(void);
 
 void CAN1_RX1_IRQHandler(void)
 {
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_PROLOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Prologue();
 
 	PIOS_CAN_RxGeneric();
 
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_EPILOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Epilogue();
 }
 
 void USB_HP_CAN1_TX_IRQHandler(void)
 {
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_PROLOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Prologue();
 
 	PIOS_CAN_TxGeneric();
 
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_EPILOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Epilogue();
 }
 
 /**
@@ -318,16 +351,19 @@ static void PIOS_CAN_RxGeneric(void)
 	bool valid = PIOS_CAN_validate(can_dev);
 	PIOS_Assert(valid);
 
-	CanRxMsg RxMessage;
-	CAN_Receive(CAN1, CAN_FIFO1, &RxMessage);
+	// Empty the fifo, as it holds up to three frames per interrupt
+	while (CAN_MessagePending(can_dev->cfg->regs, CAN_FIFO1) > 0) {
+		CanRxMsg RxMessage;
+		CAN_Receive(can_dev->cfg->regs, CAN_FIFO1, &RxMessage);
 
-	bool rx_need_yield = false;
-	if (RxMessage.StdId == CAN_COM_ID) {
-		if (can_dev->rx_in_cb) {
-			(void) (can_dev->rx_in_cb)(can_dev->rx_in_context, RxMessage.Data, RxMessage.DLC, NULL, &rx_need_yield);
+		bool rx_need_yield = false;
+		if (RxMessage.StdId == CAN_COM_ID) {
+			if (can_dev->rx_in_cb) {
+				(void) (can_dev->rx_in_cb)(can_dev->rx_in_context, RxMessage.Data, RxMessage.DLC, NULL, &rx_need_yield);
+			}
+		} else {
+			rx_need_yield = process_received_message(RxMessage);
 		}
-	} else {
-		rx_need_yield = process_received_message(RxMessage);
 	}
 }
 
@@ -343,24 +379,25 @@ static void PIOS_CAN_TxGeneric(void)
 
 	bool tx_need_yield = false;
 	
-	if (can_dev->tx_out_cb) {
+	// Fill every empty mailbox, and only take data from the fifo when
+	// there is a mailbox to put it in
+	while (can_dev->tx_out_cb &&
+			(can_dev->cfg->regs->TSR & CAN_TX_MAILBOXES_EMPTY)) {
 
 		// Prepare CAN message structure
 		CanTxMsg msg;
 		msg.StdId = CAN_COM_ID;
 		msg.ExtId = 0;
 		msg.IDE = CAN_ID_STD;
-		msg.RTR = CAN_RTR_DATA;			
+		msg.RTR = CAN_RTR_DATA;
 		msg.DLC = (can_dev->tx_out_cb)(can_dev->tx_out_context, msg.Data, MAX_SEND_LEN, NULL, &tx_need_yield);
 
-		// Send message and get mailbox number
-		if (msg.DLC > 0) {
-			CAN_Transmit(can_dev->cfg->regs, &msg);
-		} else {
+		if (msg.DLC == 0) {
 			CAN_ITConfig(can_dev->cfg->regs, CAN_IT_TME, DISABLE);
+			break;
 		}
 
-		// TODO: deal with failure to send and keep the message to retransmit
+		CAN_Transmit(can_dev->cfg->regs, &msg);
 	}
 }
 
@@ -375,14 +412,10 @@ static void PIOS_CAN_TxGeneric(void)
 int32_t PIOS_CAN_TxData(uintptr_t id, enum pios_can_messages msg_id, uint8_t *data)
 {
 	// Fetch the size of this message type or error if unknown
-	uint32_t bytes;
-	switch(msg_id) {
-	case PIOS_CAN_GIMBAL:
-		bytes = sizeof(struct pios_can_gimbal_message);
-		break;
-	default:
+	if (msg_id >= PIOS_CAN_LAST)
 		return -1;
-	}
+
+	uint32_t bytes = pios_can_message_len[msg_id];
 
 	// Look up the CAN BUS Standard ID for this message type
 	uint32_t std_id = pios_can_message_stdid[msg_id];
@@ -395,7 +428,9 @@ int32_t PIOS_CAN_TxData(uintptr_t id, enum pios_can_messages msg_id, uint8_t *da
 	msg.RTR = CAN_RTR_DATA;			
 	msg.DLC = (bytes > 8) ? 8 : bytes;
 	memcpy(msg.Data, data, msg.DLC);
-	CAN_Transmit(can_dev->cfg->regs, &msg);
+
+	if (CAN_Transmit(can_dev->cfg->regs, &msg) == CAN_TxStatus_NoMailBox)
+		return -1;
 
 	return msg.DLC;
 }
@@ -33,6 +33,16 @@
 #include "pios_mutex.h"
 #include <inttypes.h>
 
+/*
+ * A stream to receive reads of more than two bytes, instead of taking an
+ * interrupt for every byte.  The stream interrupt must have the same
+ * priority as the event and error interrupts.
+ */
+struct pios_i2c_dma_cfg {
+	struct stm32_irq irq;		/* flags are all the flags of the stream */
+	struct stm32_dma_chan rx;
+};
+
 struct pios_i2c_adapter_cfg {
 	I2C_TypeDef *regs;
 	uint32_t remap;
@@ -43,6 +53,7 @@ struct pios_i2c_adapter_cfg {
 	struct stm32_gpio sda;
 	struct stm32_irq event;
 	struct stm32_irq error;
+	const struct pios_i2c_dma_cfg *dma;	/* optional */
 };
 
 enum pios_i2c_adapter_magic {
@@ -65,6 +76,8 @@ enum i2c_adapter_state {
 	I2C_STATE_R_MORE_TXN_PRE_MIDDLE,
 	I2C_STATE_R_MORE_TXN_PRE_LAST,
 	I2C_STATE_R_MORE_TXN_POST_LAST,
+	I2C_STATE_R_MORE_TXN_DMA,
+	I2C_STATE_R_MORE_TXN_POST_DMA,
 
 	I2C_STATE_R_LAST_TXN_ADDR,
 	I2C_STATE_R_LAST_TXN_PRE_ONE,
@@ -72,6 +85,8 @@ enum i2c_adapter_state {
 	I2C_STATE_R_LAST_TXN_PRE_MIDDLE,
 	I2C_STATE_R_LAST_TXN_PRE_LAST,
 	I2C_STATE_R_LAST_TXN_POST_LAST,
+	I2C_STATE_R_LAST_TXN_DMA,
+	I2C_STATE_R_LAST_TXN_POST_DMA,
 
 	I2C_STATE_W_MORE_TXN_ADDR,
 	I2C_STATE_W_MORE_TXN_PRE_MIDDLE,
@@ -99,10 +114,12 @@ enum i2c_adapter_event {
 	I2C_EVENT_ADDR_SENT_LEN_EQ_1,
 	I2C_EVENT_ADDR_SENT_LEN_EQ_2,
 	I2C_EVENT_ADDR_SENT_LEN_GT_2,
+	I2C_EVENT_ADDR_SENT_DMA,
 	I2C_EVENT_TRANSFER_DONE_LEN_EQ_0,
 	I2C_EVENT_TRANSFER_DONE_LEN_EQ_1,
 	I2C_EVENT_TRANSFER_DONE_LEN_EQ_2,
 	I2C_EVENT_TRANSFER_DONE_LEN_GT_2,
+	I2C_EVENT_DMA_DONE,
 	I2C_EVENT_NACK,
 	I2C_EVENT_STOPPED,
 	I2C_EVENT_AUTO,
@@ -168,5 +185,6 @@ struct pios_i2c_adapter {
 };
 
 int32_t PIOS_I2C_Init(uint32_t * i2c_id, const struct pios_i2c_adapter_cfg * cfg);
+void PIOS_I2C_DMA_IRQ_Handler(uint32_t i2c_id);
 
 #endif /* PIOS_I2C_PRIV_H */
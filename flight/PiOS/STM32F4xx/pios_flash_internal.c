@@ -164,14 +164,26 @@ static int32_t PIOS_Flash_Internal_WriteData(uintptr_t chip_id, uint32_t chip_of
 	if (!PIOS_Flash_Internal_Validate(flash_dev))
 		return -1;
 
-	/* Write the data */
-	for (uint16_t i = 0; i < len; i++) {
+	/*
+	 * Write the data.  Sectors are erased for voltage range 3, which
+	 * programs a word in the time of a byte, so whole words are written
+	 * wherever the address is aligned.  Bytes fill in the ends.
+	 */
+	uint16_t i = 0;
+	while (i < len) {
 		FLASH_Status status;
-		/*
-		 * This is inefficient.  Should try to do word writes.
-		 * Not sure if word writes need to be aligned though.
-		 */
-		status = FLASH_ProgramByte(FLASH_BASE + chip_offset + i, data[i]);
+		uint32_t address = FLASH_BASE + chip_offset + i;
+
+		if (!(address & 3) && (len - i) >= sizeof(uint32_t)) {
+			uint32_t word;
+			memcpy(&word, &data[i], sizeof(word));
+			status = FLASH_ProgramWord(address, word);
+			i += sizeof(uint32_t);
+		} else {
+			status = FLASH_ProgramByte(address, data[i]);
+			i++;
+		}
+
 		PIOS_Assert(status == FLASH_COMPLETE);
 	}
 
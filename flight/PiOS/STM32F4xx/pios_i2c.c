@@ -35,9 +35,15 @@
 
 #include <pios_i2c_priv.h>
 
+/* The stream cannot reach the CCM */
+#define I2C_DMA_CAN_REACH(p) (((uintptr_t)(p) & 0xFFFF0000) != 0x10000000)
+
 static void i2c_adapter_inject_event(struct pios_i2c_adapter *i2c_adapter, enum i2c_adapter_event event, bool *woken);
 static void i2c_adapter_fsm_init(struct pios_i2c_adapter *i2c_adapter);
 static void i2c_adapter_reset_bus(struct pios_i2c_adapter *i2c_adapter);
+static void i2c_adapter_dma_init(struct pios_i2c_adapter *i2c_adapter);
+static void i2c_adapter_dma_start(struct pios_i2c_adapter *i2c_adapter);
+static void i2c_adapter_dma_stop(struct pios_i2c_adapter *i2c_adapter);
 #if defined(PIOS_I2C_DIAGNOSTICS)
 static void i2c_adapter_log_fault(struct pios_i2c_adapter *i2c_adapter, enum pios_i2c_error_type type);
 #endif
@@ -54,6 +60,8 @@ static void go_r_more_txn_pre_first(struct pios_i2c_adapter *i2c_adapter, bool *
 static void go_r_more_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken);
 static void go_r_more_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
 static void go_r_more_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_more_txn_dma(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_more_txn_post_dma(struct pios_i2c_adapter *i2c_adapter, bool *woken);
 
 static void go_r_last_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken);
 static void go_r_last_txn_pre_one(struct pios_i2c_adapter *i2c_adapter, bool *woken);
@@ -61,6 +69,8 @@ static void go_r_last_txn_pre_first(struct pios_i2c_adapter *i2c_adapter, bool *
 static void go_r_last_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken);
 static void go_r_last_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
 static void go_r_last_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_last_txn_dma(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_last_txn_post_dma(struct pios_i2c_adapter *i2c_adapter, bool *woken);
 
 static void go_w_more_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken);
 static void go_w_more_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken);
@@ -124,6 +134,7 @@ static const struct i2c_adapter_transition i2c_adapter_transitions[I2C_STATE_NUM
 			[I2C_EVENT_ADDR_SENT_LEN_EQ_1] = I2C_STATE_R_MORE_TXN_PRE_ONE,
 			[I2C_EVENT_ADDR_SENT_LEN_EQ_2] = I2C_STATE_R_MORE_TXN_PRE_FIRST,
 			[I2C_EVENT_ADDR_SENT_LEN_GT_2] = I2C_STATE_R_MORE_TXN_PRE_FIRST,
+			[I2C_EVENT_ADDR_SENT_DMA] = I2C_STATE_R_MORE_TXN_DMA,
 			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
 		},
 	},
@@ -168,6 +179,24 @@ static const struct i2c_adapter_transition i2c_adapter_transitions[I2C_STATE_NUM
 			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
 		},
 	},
+	[I2C_STATE_R_MORE_TXN_DMA] = {
+		.entry_fn = go_r_more_txn_dma,
+		.next_state = {
+			[I2C_EVENT_DMA_DONE] = I2C_STATE_R_MORE_TXN_POST_DMA,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_MORE_TXN_POST_DMA] = {
+		.entry_fn = go_r_more_txn_post_dma,
+		.next_state = {
+			[I2C_EVENT_R_MORE_TXN_STARTED] = I2C_STATE_R_MORE_TXN_ADDR,
+			[I2C_EVENT_W_MORE_TXN_STARTED] = I2C_STATE_W_MORE_TXN_ADDR,
+			[I2C_EVENT_R_LAST_TXN_STARTED] = I2C_STATE_R_LAST_TXN_ADDR,
+			[I2C_EVENT_W_LAST_TXN_STARTED] = I2C_STATE_W_LAST_TXN_ADDR,
+			[I2C_EVENT_NACK] = I2C_STATE_NACK,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
 
 	/*
 	 * Read with stop
@@ -178,6 +207,7 @@ static const struct i2c_adapter_transition i2c_adapter_transitions[I2C_STATE_NUM
 			[I2C_EVENT_ADDR_SENT_LEN_EQ_1] = I2C_STATE_R_LAST_TXN_PRE_ONE,
 			[I2C_EVENT_ADDR_SENT_LEN_EQ_2] = I2C_STATE_R_LAST_TXN_PRE_FIRST,
 			[I2C_EVENT_ADDR_SENT_LEN_GT_2] = I2C_STATE_R_LAST_TXN_PRE_FIRST,
+			[I2C_EVENT_ADDR_SENT_DMA] = I2C_STATE_R_LAST_TXN_DMA,
 			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
 		},
 	},
@@ -217,6 +247,19 @@ static const struct i2c_adapter_transition i2c_adapter_transitions[I2C_STATE_NUM
 			[I2C_EVENT_AUTO] = I2C_STATE_STOPPED,
 		},
 	},
+	[I2C_STATE_R_LAST_TXN_DMA] = {
+		.entry_fn = go_r_last_txn_dma,
+		.next_state = {
+			[I2C_EVENT_DMA_DONE] = I2C_STATE_R_LAST_TXN_POST_DMA,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_LAST_TXN_POST_DMA] = {
+		.entry_fn = go_r_last_txn_post_dma,
+		.next_state = {
+			[I2C_EVENT_AUTO] = I2C_STATE_STOPPED,
+		},
+	},
 
 	/*
 	 * Write with restart
@@ -404,6 +447,29 @@ static void go_r_more_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *
 	I2C_GenerateSTART(i2c_adapter->cfg->regs, ENABLE);
 }
 
+static void go_r_more_txn_dma(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	i2c_adapter_dma_start(i2c_adapter);
+}
+
+static void go_r_more_txn_post_dma(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	i2c_adapter_dma_stop(i2c_adapter);
+
+	/* Move to the next transaction */
+	i2c_adapter->active_txn++;
+
+	// set up current txn byte pointers
+	i2c_adapter->active_byte = &(i2c_adapter->active_txn->buf[0]);
+	i2c_adapter->last_byte = &(i2c_adapter->active_txn->buf[i2c_adapter->active_txn->len - 1]);
+
+	// the start needs the event interrupt back
+	I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_EVT, ENABLE);
+
+	// generate repeated START condition
+	I2C_GenerateSTART(i2c_adapter->cfg->regs, ENABLE);
+}
+
 /*
  * Read with stop
  */
@@ -466,6 +532,22 @@ static void go_r_last_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *
 	i2c_adapter->active_txn++;
 }
 
+static void go_r_last_txn_dma(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	i2c_adapter_dma_start(i2c_adapter);
+}
+
+static void go_r_last_txn_post_dma(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// the stream has the last byte, which was nacked; stop right away
+	I2C_GenerateSTOP(i2c_adapter->cfg->regs, ENABLE);
+
+	i2c_adapter_dma_stop(i2c_adapter);
+
+	/* Move to the next transaction */
+	i2c_adapter->active_txn++;
+}
+
 
 /*
  * Write with restart
@@ -601,6 +683,8 @@ static void i2c_adapter_reset_bus(struct pios_i2c_adapter *i2c_adapter)
 	uint8_t retry_count_clk = 0;
 	static const uint8_t MAX_I2C_RETRY_COUNT = 10;
 
+	i2c_adapter_dma_stop(i2c_adapter);
+
 	/* Reset the I2C block */
 	I2C_DeInit(i2c_adapter->cfg->regs);
 
@@ -690,6 +774,68 @@ static void i2c_adapter_reset_bus(struct pios_i2c_adapter *i2c_adapter)
 	}
 }
 
+static void i2c_adapter_dma_init(struct pios_i2c_adapter *i2c_adapter)
+{
+	const struct pios_i2c_dma_cfg *dma = i2c_adapter->cfg->dma;
+
+	DMA_InitTypeDef DMAInit = dma->rx.init;
+	DMAInit.DMA_PeripheralBaseAddr	= (uint32_t)&i2c_adapter->cfg->regs->DR;
+	DMAInit.DMA_Memory0BaseAddr	= 0;	/* set for each read */
+	DMAInit.DMA_BufferSize		= 1;	/* set for each read */
+	DMAInit.DMA_DIR			= DMA_DIR_PeripheralToMemory;
+	DMAInit.DMA_PeripheralInc	= DMA_PeripheralInc_Disable;
+	DMAInit.DMA_MemoryInc		= DMA_MemoryInc_Enable;
+	DMAInit.DMA_PeripheralDataSize	= DMA_PeripheralDataSize_Byte;
+	DMAInit.DMA_MemoryDataSize	= DMA_MemoryDataSize_Byte;
+	DMAInit.DMA_Mode		= DMA_Mode_Normal;
+	DMAInit.DMA_Priority		= DMA_Priority_Medium;
+	DMAInit.DMA_FIFOMode		= DMA_FIFOMode_Disable;
+	DMAInit.DMA_FIFOThreshold	= DMA_FIFOThreshold_HalfFull;
+	DMAInit.DMA_MemoryBurst		= DMA_MemoryBurst_Single;
+	DMAInit.DMA_PeripheralBurst	= DMA_PeripheralBurst_Single;
+
+	DMA_DeInit(dma->rx.channel);
+	DMA_Init(dma->rx.channel, &DMAInit);
+
+	DMA_ITConfig(dma->rx.channel, DMA_IT_TC | DMA_IT_TE, ENABLE);
+	NVIC_Init((NVIC_InitTypeDef *)&dma->irq.init);
+}
+
+/**
+ * Hand the rest of a read to the stream.  The address has been sent and
+ * there are more than two bytes to come.
+ */
+static void i2c_adapter_dma_start(struct pios_i2c_adapter *i2c_adapter)
+{
+	const struct pios_i2c_dma_cfg *dma = i2c_adapter->cfg->dma;
+	I2C_TypeDef *regs = i2c_adapter->cfg->regs;
+
+	// the stream takes the bytes, and says when it is done
+	I2C_ITConfig(regs, I2C_IT_EVT | I2C_IT_BUF, DISABLE);
+
+	DMA_MemoryTargetConfig(dma->rx.channel, (uint32_t)i2c_adapter->active_byte, DMA_Memory_0);
+	DMA_SetCurrDataCounter(dma->rx.channel, i2c_adapter->last_byte - i2c_adapter->active_byte + 1);
+	DMA_ClearFlag(dma->rx.channel, dma->irq.flags);
+	DMA_Cmd(dma->rx.channel, ENABLE);
+
+	// ack all the bytes but the last, which the peripheral nacks itself
+	I2C_AcknowledgeConfig(regs, ENABLE);
+	I2C_DMALastTransferCmd(regs, ENABLE);
+	I2C_DMACmd(regs, ENABLE);
+}
+
+static void i2c_adapter_dma_stop(struct pios_i2c_adapter *i2c_adapter)
+{
+	const struct pios_i2c_dma_cfg *dma = i2c_adapter->cfg->dma;
+
+	if (!dma)
+		return;
+
+	I2C_DMACmd(i2c_adapter->cfg->regs, DISABLE);
+	I2C_DMALastTransferCmd(i2c_adapter->cfg->regs, DISABLE);
+	DMA_Cmd(dma->rx.channel, DISABLE);
+}
+
 /**
  * Logs the last N state transitions and N IRQ events due to
  * an error condition
@@ -768,6 +914,9 @@ int32_t PIOS_I2C_Init(uint32_t *i2c_id, const struct pios_i2c_adapter_cfg *cfg)
 	i2c_adapter->sem_ready = PIOS_Semaphore_Create();
 	i2c_adapter->lock = PIOS_Mutex_Create();
 
+	if (cfg->dma)
+		i2c_adapter_dma_init(i2c_adapter);
+
 	/* Initialize the state machine */
 	i2c_adapter_fsm_init(i2c_adapter);
 
@@ -863,9 +1012,7 @@ int32_t PIOS_I2C_Transfer(uint32_t i2c_id, const struct pios_i2c_txn txn_list[],
 
 void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id)
 {
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_PROLOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Prologue();
 
 	struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
 
@@ -907,6 +1054,15 @@ void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id)
 		break;
 	case I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED:	/* EV6 */
 	case I2C_EVENT_MASTER_RECEIVER_MODE_SELECTED:	/* EV6 */
+		if (event == I2C_EVENT_MASTER_RECEIVER_MODE_SELECTED &&
+				i2c_adapter->cfg->dma &&
+				i2c_adapter->last_byte - i2c_adapter->active_byte + 1 > 2 &&
+				I2C_DMA_CAN_REACH(i2c_adapter->active_byte)) {
+			/* Long read, the stream takes it from here */
+			i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_ADDR_SENT_DMA, &woken);
+			break;
+		}
+
 		switch (i2c_adapter->last_byte - i2c_adapter->active_byte + 1) {
 		case 0:
 			i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_ADDR_SENT_LEN_EQ_0, &woken);
@@ -951,16 +1107,41 @@ void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id)
 		break;
 	}
 
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_EPILOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Epilogue();
+}
+
+/**
+ * Handle the interrupt of the receive stream: a read is done, or failed
+ * \param[in] i2c_id the adapter the stream serves
+ */
+void PIOS_I2C_DMA_IRQ_Handler(uint32_t i2c_id)
+{
+	PIOS_IRQ_Prologue();
+
+	struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
+
+	PIOS_Assert(PIOS_I2C_validate(i2c_adapter) == true)
+
+	const struct pios_i2c_dma_cfg *dma = i2c_adapter->cfg->dma;
+	bool woken = false;
+
+	DMA_ClearFlag(dma->rx.channel, dma->irq.flags);
+
+	if (DMA_GetCurrDataCounter(dma->rx.channel) == 0) {
+		i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_DMA_DONE, &woken);
+	} else {
+#if defined(PIOS_I2C_DIAGNOSTICS)
+		i2c_adapter_log_fault(i2c_adapter, PIOS_I2C_ERROR_INTERRUPT);
+#endif
+		i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_BUS_ERROR, &woken);
+	}
+
+	PIOS_IRQ_Epilogue();
 }
 
 void PIOS_I2C_ER_IRQ_Handler(uint32_t i2c_id)
 {
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_PROLOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Prologue();
 
 	struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
 
@@ -1001,9 +1182,7 @@ void PIOS_I2C_ER_IRQ_Handler(uint32_t i2c_id)
 		i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_BUS_ERROR, &woken);
 	}
 
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_EPILOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Epilogue();
 }
 
 #endif
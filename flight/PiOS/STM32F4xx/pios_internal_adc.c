@@ -32,7 +32,10 @@
  * @note This is a stripped-down ADC driver intended primarily for sampling
  * voltage and current values.  Samples are averaged over the period between
  * fetches so that relatively accurate measurements can be obtained without
- * forcing higher-level logic to poll aggressively.
+ * forcing higher-level logic to poll aggressively.  Each DMA block is summed
+ * per channel in one pass as it completes, so the interrupt does one add per
+ * sample and the reader gets the exact mean since its last fetch, which is
+ * what integrating current over that period needs.
  *
  * @todo This module needs more work to be more generally useful.  It should
  * almost certainly grow callback support so that e.g. voltage and current readings
@@ -90,10 +93,13 @@ const struct pios_adc_driver pios_internal_adc_driver = {
 struct adc_accumulator {
 	uint32_t		accumulator;
 	uint32_t		count;
+	uint16_t		last_block_mean;	// held when read faster than blocks complete
+	bool			have_data;
 };
 
 // Buffers to hold the ADC data
 static struct adc_accumulator * accumulator;
+static uint32_t * block_sum;
 static uint16_t * adc_raw_buffer_0;
 static uint16_t * adc_raw_buffer_1;
 
@@ -237,11 +243,20 @@ static struct pios_internal_adc_dev * PIOS_INTERNAL_ADC_Allocate(const struct pi
 		PIOS_free(adc_dev);
 		return NULL;
 	}
+	memset(accumulator, 0, cfg->adc_pin_count * sizeof(struct adc_accumulator));
+
+	block_sum = (uint32_t *)PIOS_malloc_no_dma(cfg->adc_pin_count * sizeof(uint32_t));
+	if (!block_sum) {
+		PIOS_free(adc_dev);
+		PIOS_free(accumulator);
+		return NULL;
+	}
 
 	adc_raw_buffer_0 = (uint16_t *)PIOS_malloc(adc_dev->max_samples * cfg->adc_pin_count * sizeof(uint16_t));
 	if (!adc_raw_buffer_0) {
 		PIOS_free(adc_dev);
 		PIOS_free(accumulator);
+		PIOS_free(block_sum);
 		return NULL;
 	}
 
@@ -249,6 +264,7 @@ static struct pios_internal_adc_dev * PIOS_INTERNAL_ADC_Allocate(const struct pi
 	if (!adc_raw_buffer_1) {
 		PIOS_free(adc_dev);
 		PIOS_free(accumulator);
+		PIOS_free(block_sum);
 		PIOS_free(adc_raw_buffer_0);
 		return NULL;
 	}
@@ -289,9 +305,11 @@ void PIOS_ADC_Config(uint32_t oversampling)
 /**
  * Returns value of an ADC Pin
  * @param[in] pin number
- * @return ADC pin value averaged over the set of samples since the last reading.
- * @return -1 if pin doesn't exist
- * @return -2 if no data acquired since last read
+ * @return ADC pin value averaged over the set of samples since the last reading,
+ * or the mean of the last block if none completed since.
+ * @return -1 if the ADC isn't initialized
+ * @return -2 if pin doesn't exist
+ * @return -3 if no data acquired yet
  * TODO we currently ignore internal_adc_id since this driver doesn't support multiple instances
  * TODO we should probably refactor this similarly to the new F3 driver
  */
@@ -309,14 +327,25 @@ static int32_t PIOS_INTERNAL_ADC_PinGet(uint32_t internal_adc_id, uint32_t pin)
 		return -2;
 	}
 
-	if (accumulator[pin].accumulator <= 0) {
+	struct adc_accumulator *acc = &accumulator[pin];
+
+	if (!acc->have_data) {
 		return -3;
 	}
 
-	/* return accumulated result and clear accumulator */
-	result = accumulator[pin].accumulator / (accumulator[pin].count ?: 1);
-	accumulator[pin].accumulator = result;
-	accumulator[pin].count = 1;
+	/* take the accumulated result and clear it, without the DMA
+	 * interrupt adding a block in between */
+	PIOS_IRQ_Disable();
+	uint32_t sum = acc->accumulator;
+	uint32_t count = acc->count;
+	acc->accumulator = 0;
+	acc->count = 0;
+	result = acc->last_block_mean;
+	PIOS_IRQ_Enable();
+
+	if (count) {
+		result = (sum + count / 2) / count;
+	}
 
 	return result;
 #endif
@@ -365,33 +394,48 @@ void PIOS_ADC_SetFIRCoefficients(float * new_filter)
 
 /**
  * @brief accumulate the data for each of the channels.
+ *
+ * The block is summed per channel first, which a block of 12 bit samples
+ * can't overflow, and folded into the accumulators once per channel.
  */
-void accumulate(uint16_t *buffer, uint32_t count)
+static void accumulate(uint16_t *buffer, uint32_t count)
 {
 #if defined(PIOS_INCLUDE_ADC)
-	uint16_t	*sp = buffer;
+	const uint16_t *sp = buffer;
 	if (!PIOS_INTERNAL_ADC_validate(pios_adc_dev)) {
 		return;
 	}
 
-	/*
-	 * Accumulate sampled values.
-	 */
-	while (count--) {
-		for (int i = 0; i < pios_adc_dev->cfg->adc_pin_count; i++) {
-			accumulator[i].accumulator += *sp++;
-			accumulator[i].count++;
-			/*
-			 * If the accumulator reaches half-full, rescale in order to
-			 * make more space.
-			 */
-			if (accumulator[i].accumulator >= (1 << 31)) {
-				accumulator[i].accumulator /= 2;
-				accumulator[i].count /= 2;
-			}
+	const uint8_t channels = pios_adc_dev->cfg->adc_pin_count;
+
+	for (int i = 0; i < channels; i++) {
+		block_sum[i] = 0;
+	}
+
+	/* samples are interleaved by channel, one scan after another */
+	for (uint32_t n = count; n; n--) {
+		for (int i = 0; i < channels; i++) {
+			block_sum[i] += *sp++;
 		}
 	}
-	
+
+	for (int i = 0; i < channels; i++) {
+		struct adc_accumulator *acc = &accumulator[i];
+
+		/*
+		 * If nobody reads the channel for long, rescale in order
+		 * to make more space.
+		 */
+		if (acc->accumulator >= (1u << 31)) {
+			acc->accumulator /= 2;
+			acc->count /= 2;
+		}
+
+		acc->accumulator += block_sum[i];
+		acc->count += count;
+		acc->last_block_mean = block_sum[i] / count;
+		acc->have_data = true;
+	}
 #endif
 }
 
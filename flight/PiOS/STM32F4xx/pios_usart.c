@@ -54,6 +54,12 @@ const struct pios_com_driver pios_usart_com_driver = {
 	.bind_rx_cb = PIOS_USART_RegisterRxCallback,
 };
 
+/* Bytes of the receive ring; the half and full transfer interrupts each
+ * hand on half of it, and the idle line interrupt what came before a gap */
+#define PIOS_USART_DMA_RX_LEN 64
+/* Most bytes sent in one transfer */
+#define PIOS_USART_DMA_TX_LEN 64
+
 enum pios_usart_dev_magic {
 	PIOS_USART_DEV_MAGIC = 0x4152834A,
 };
@@ -66,6 +72,10 @@ struct pios_usart_dev {
 	uintptr_t rx_in_context;
 	pios_com_callback tx_out_cb;
 	uintptr_t tx_out_context;
+
+	uint8_t *rx_dma_buf;
+	uint16_t rx_dma_pos;	/* the next byte of the ring to hand on */
+	uint8_t *tx_dma_buf;
 };
 
 static bool PIOS_USART_validate(struct pios_usart_dev * usart_dev)
@@ -92,95 +102,73 @@ static struct pios_usart_dev * PIOS_USART_alloc(void)
  * each physical IRQ to a specific registered device instance.
  */
 static void PIOS_USART_generic_irq_handler(uintptr_t usart_id);
+static int32_t PIOS_USART_DMA_Init(struct pios_usart_dev *usart_dev);
+static uintptr_t *PIOS_USART_id_slot(USART_TypeDef *regs);
 
 static uintptr_t PIOS_USART_1_id;
 void USART1_IRQHandler(void) __attribute__ ((alias ("PIOS_USART_1_irq_handler")));
 static void PIOS_USART_1_irq_handler (void)
 {
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_PROLOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Prologue();
 
 	PIOS_USART_generic_irq_handler (PIOS_USART_1_id);
 
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_EPILOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Epilogue();
 }
 
 static uintptr_t PIOS_USART_2_id;
 void USART2_IRQHandler(void) __attribute__ ((alias ("PIOS_USART_2_irq_handler")));
 static void PIOS_USART_2_irq_handler (void)
 {
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_PROLOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Prologue();
 
 	PIOS_USART_generic_irq_handler (PIOS_USART_2_id);
 
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_EPILOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Epilogue();
 }
 
 static uintptr_t PIOS_USART_3_id;
 void USART3_IRQHandler(void) __attribute__ ((alias ("PIOS_USART_3_irq_handler")));
 static void PIOS_USART_3_irq_handler (void)
 {
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_PROLOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Prologue();
 
 	PIOS_USART_generic_irq_handler (PIOS_USART_3_id);
 
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_EPILOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Epilogue();
 }
 
 static uintptr_t PIOS_USART_4_id;
 void USART4_IRQHandler(void) __attribute__ ((alias ("PIOS_USART_4_irq_handler")));
 static void PIOS_USART_4_irq_handler (void)
 {
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_PROLOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Prologue();
 
 	PIOS_USART_generic_irq_handler (PIOS_USART_4_id);
 
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_EPILOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Epilogue();
 }
 
 static uintptr_t PIOS_USART_5_id;
 void USART5_IRQHandler(void) __attribute__ ((alias ("PIOS_USART_5_irq_handler")));
 static void PIOS_USART_5_irq_handler (void)
 {
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_PROLOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Prologue();
 
 	PIOS_USART_generic_irq_handler (PIOS_USART_5_id);
 
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_EPILOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Epilogue();
 }
 
 static uintptr_t PIOS_USART_6_id;
 void USART6_IRQHandler(void) __attribute__ ((alias ("PIOS_USART_6_irq_handler")));
 static void PIOS_USART_6_irq_handler (void)
 {
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_PROLOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Prologue();
 
 	PIOS_USART_generic_irq_handler (PIOS_USART_6_id);
 
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_EPILOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Epilogue();
 }
 
 /**
@@ -230,29 +218,18 @@ int32_t PIOS_USART_Init(uintptr_t * usart_id, const struct pios_usart_cfg * cfg,
 	*usart_id = (uintptr_t)usart_dev;
 
 	/* Configure USART Interrupts */
-	switch ((uint32_t)usart_dev->cfg->regs) {
-	case (uint32_t)USART1:
-		PIOS_USART_1_id = (uintptr_t)usart_dev;
-		break;
-	case (uint32_t)USART2:
-		PIOS_USART_2_id = (uintptr_t)usart_dev;
-		break;
-	case (uint32_t)USART3:
-		PIOS_USART_3_id = (uintptr_t)usart_dev;
-		break;
-	case (uint32_t)UART4:
-		PIOS_USART_4_id = (uintptr_t)usart_dev;
-		break;
-	case (uint32_t)UART5:
-		PIOS_USART_5_id = (uintptr_t)usart_dev;
-		break;
-	case (uint32_t)USART6:
-		PIOS_USART_6_id = (uintptr_t)usart_dev;
-		break;
+	uintptr_t *id_slot = PIOS_USART_id_slot(usart_dev->cfg->regs);
+	if (id_slot)
+		*id_slot = (uintptr_t)usart_dev;
+
+	if (usart_dev->cfg->dma) {
+		if (PIOS_USART_DMA_Init(usart_dev))
+			goto out_fail;
+	} else {
+		USART_ITConfig(usart_dev->cfg->regs, USART_IT_RXNE, ENABLE);
+		USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE,  ENABLE);
 	}
 	NVIC_Init((NVIC_InitTypeDef *)&(usart_dev->cfg->irq.init));
-	USART_ITConfig(usart_dev->cfg->regs, USART_IT_RXNE, ENABLE);
-	USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE,  ENABLE);
 
 	// FIXME XXX Clear / reset uart here - sends NUL char else
 
@@ -271,7 +248,11 @@ static void PIOS_USART_RxStart(uintptr_t usart_id, uint16_t rx_bytes_avail)
 	
 	bool valid = PIOS_USART_validate(usart_dev);
 	PIOS_Assert(valid);
-	
+
+	/* The DMA never stops receiving */
+	if (usart_dev->cfg->dma)
+		return;
+
 	USART_ITConfig(usart_dev->cfg->regs, USART_IT_RXNE, ENABLE);
 }
 static void PIOS_USART_TxStart(uintptr_t usart_id, uint16_t tx_bytes_avail)
@@ -280,7 +261,14 @@ static void PIOS_USART_TxStart(uintptr_t usart_id, uint16_t tx_bytes_avail)
 	
 	bool valid = PIOS_USART_validate(usart_dev);
 	PIOS_Assert(valid);
-	
+
+	/* TC stays set once the last transfer is out, so when the stream is
+	 * idle this takes the interrupt that starts the next one at once */
+	if (usart_dev->cfg->dma) {
+		USART_ITConfig(usart_dev->cfg->regs, USART_IT_TC, ENABLE);
+		return;
+	}
+
 	USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE, ENABLE);
 }
 
@@ -342,12 +330,201 @@ static void PIOS_USART_RegisterTxCallback(uintptr_t usart_id, pios_com_callback
 	usart_dev->tx_out_cb = tx_out_cb;
 }
 
+static uintptr_t *PIOS_USART_id_slot(USART_TypeDef *regs)
+{
+	switch ((uint32_t)regs) {
+	case (uint32_t)USART1:
+		return &PIOS_USART_1_id;
+	case (uint32_t)USART2:
+		return &PIOS_USART_2_id;
+	case (uint32_t)USART3:
+		return &PIOS_USART_3_id;
+	case (uint32_t)UART4:
+		return &PIOS_USART_4_id;
+	case (uint32_t)UART5:
+		return &PIOS_USART_5_id;
+	case (uint32_t)USART6:
+		return &PIOS_USART_6_id;
+	}
+
+	return NULL;
+}
+
+/**
+ * Set up the streams: the receiver runs for good into a ring, the
+ * transmitter sends whatever block the COM layer hands over.  The buffers
+ * are the driver's own, as those of the COM layer may be out of reach of
+ * the DMA.
+ */
+static int32_t PIOS_USART_DMA_Init(struct pios_usart_dev *usart_dev)
+{
+	const struct pios_usart_dma_cfg *dma = usart_dev->cfg->dma;
+
+	usart_dev->rx_dma_buf = PIOS_malloc(PIOS_USART_DMA_RX_LEN);
+	usart_dev->tx_dma_buf = PIOS_malloc(PIOS_USART_DMA_TX_LEN);
+	if (!usart_dev->rx_dma_buf || !usart_dev->tx_dma_buf)
+		return -1;
+
+	DMA_InitTypeDef DMAInit = dma->rx.init;
+	DMAInit.DMA_Memory0BaseAddr	= (uint32_t)usart_dev->rx_dma_buf;
+	DMAInit.DMA_BufferSize		= PIOS_USART_DMA_RX_LEN;
+	DMAInit.DMA_DIR			= DMA_DIR_PeripheralToMemory;
+	DMAInit.DMA_PeripheralInc	= DMA_PeripheralInc_Disable;
+	DMAInit.DMA_MemoryInc		= DMA_MemoryInc_Enable;
+	DMAInit.DMA_PeripheralDataSize	= DMA_PeripheralDataSize_Byte;
+	DMAInit.DMA_MemoryDataSize	= DMA_MemoryDataSize_Byte;
+	DMAInit.DMA_Mode		= DMA_Mode_Circular;
+	DMAInit.DMA_Priority		= DMA_Priority_Medium;
+	DMAInit.DMA_FIFOMode		= DMA_FIFOMode_Disable;
+	DMAInit.DMA_FIFOThreshold	= DMA_FIFOThreshold_HalfFull;
+	DMAInit.DMA_MemoryBurst		= DMA_MemoryBurst_Single;
+	DMAInit.DMA_PeripheralBurst	= DMA_PeripheralBurst_Single;
+
+	DMA_DeInit(dma->rx.channel);
+	DMA_Init(dma->rx.channel, &DMAInit);
+
+	DMAInit = dma->tx.init;
+	DMAInit.DMA_Memory0BaseAddr	= (uint32_t)usart_dev->tx_dma_buf;
+	DMAInit.DMA_BufferSize		= 1;	/* set for each transfer */
+	DMAInit.DMA_DIR			= DMA_DIR_MemoryToPeripheral;
+	DMAInit.DMA_PeripheralInc	= DMA_PeripheralInc_Disable;
+	DMAInit.DMA_MemoryInc		= DMA_MemoryInc_Enable;
+	DMAInit.DMA_PeripheralDataSize	= DMA_PeripheralDataSize_Byte;
+	DMAInit.DMA_MemoryDataSize	= DMA_MemoryDataSize_Byte;
+	DMAInit.DMA_Mode		= DMA_Mode_Normal;
+	DMAInit.DMA_Priority		= DMA_Priority_Medium;
+	DMAInit.DMA_FIFOMode		= DMA_FIFOMode_Disable;
+	DMAInit.DMA_FIFOThreshold	= DMA_FIFOThreshold_HalfFull;
+	DMAInit.DMA_MemoryBurst		= DMA_MemoryBurst_Single;
+	DMAInit.DMA_PeripheralBurst	= DMA_PeripheralBurst_Single;
+
+	DMA_DeInit(dma->tx.channel);
+	DMA_Init(dma->tx.channel, &DMAInit);
+
+	DMA_ITConfig(dma->rx.channel, DMA_IT_HT | DMA_IT_TC, ENABLE);
+	NVIC_Init((NVIC_InitTypeDef *)&dma->irq.init);
+	DMA_Cmd(dma->rx.channel, ENABLE);
+
+	USART_DMACmd(usart_dev->cfg->regs, USART_DMAReq_Rx | USART_DMAReq_Tx, ENABLE);
+	USART_ITConfig(usart_dev->cfg->regs, USART_IT_IDLE, ENABLE);
+
+	return 0;
+}
+
+/**
+ * Hand on what the DMA has put in the ring since the last call
+ */
+static void PIOS_USART_DMA_RxDrain(struct pios_usart_dev *usart_dev, bool *need_yield)
+{
+	uint16_t head = PIOS_USART_DMA_RX_LEN -
+		DMA_GetCurrDataCounter(usart_dev->cfg->dma->rx.channel);
+	uint16_t pos = usart_dev->rx_dma_pos;
+
+	if (head == PIOS_USART_DMA_RX_LEN)
+		head = 0;
+
+	if (head == pos)
+		return;
+
+	usart_dev->rx_dma_pos = head;
+
+	if (!usart_dev->rx_in_cb)
+		return;
+
+	if (head < pos) {
+		(void) (usart_dev->rx_in_cb)(usart_dev->rx_in_context,
+				&usart_dev->rx_dma_buf[pos],
+				PIOS_USART_DMA_RX_LEN - pos, NULL, need_yield);
+		pos = 0;
+	}
+
+	if (head > pos) {
+		(void) (usart_dev->rx_in_cb)(usart_dev->rx_in_context,
+				&usart_dev->rx_dma_buf[pos],
+				head - pos, NULL, need_yield);
+	}
+}
+
+/**
+ * Start sending the next block, or stop if there is none.  Called when
+ * the last one is out, which the TC flag shows.
+ */
+static void PIOS_USART_DMA_TxNext(struct pios_usart_dev *usart_dev, bool *need_yield)
+{
+	const struct pios_usart_dma_cfg *dma = usart_dev->cfg->dma;
+	uint16_t bytes_to_send = 0;
+
+	if (usart_dev->tx_out_cb) {
+		bytes_to_send = (usart_dev->tx_out_cb)(usart_dev->tx_out_context,
+				usart_dev->tx_dma_buf, PIOS_USART_DMA_TX_LEN,
+				NULL, need_yield);
+	}
+
+	if (bytes_to_send == 0) {
+		/* Leave TC set, for PIOS_USART_TxStart() */
+		USART_ITConfig(usart_dev->cfg->regs, USART_IT_TC, DISABLE);
+		return;
+	}
+
+	DMA_ClearFlag(dma->tx.channel, dma->tx_flags);
+	DMA_SetCurrDataCounter(dma->tx.channel, bytes_to_send);
+	USART_ClearFlag(usart_dev->cfg->regs, USART_FLAG_TC);
+	DMA_Cmd(dma->tx.channel, ENABLE);
+}
+
+/**
+ * Handle the half and full transfer interrupts of a receive stream.  The
+ * board points the stream's vector here.
+ * \param[in] regs the USART the stream serves
+ */
+void PIOS_USART_DMA_irq_handler(USART_TypeDef *regs)
+{
+	PIOS_IRQ_Prologue();
+
+	uintptr_t *id_slot = PIOS_USART_id_slot(regs);
+	struct pios_usart_dev *usart_dev = (struct pios_usart_dev *)(id_slot ? *id_slot : 0);
+
+	bool valid = PIOS_USART_validate(usart_dev);
+	PIOS_Assert(valid);
+
+	DMA_ClearFlag(usart_dev->cfg->dma->rx.channel, usart_dev->cfg->dma->irq.flags);
+
+	bool rx_need_yield = false;
+	PIOS_USART_DMA_RxDrain(usart_dev, &rx_need_yield);
+
+	PIOS_IRQ_Epilogue();
+}
+
+static void PIOS_USART_DMA_generic_irq_handler(struct pios_usart_dev *usart_dev)
+{
+	USART_TypeDef *regs = usart_dev->cfg->regs;
+	uint16_t sr = regs->SR;
+
+	/* Reading DR after SR clears IDLE; the line is idle, so there is no
+	 * byte in it for the DMA to miss */
+	bool rx_need_yield = false;
+	if (sr & USART_SR_IDLE) {
+		(void) regs->DR;
+		PIOS_USART_DMA_RxDrain(usart_dev, &rx_need_yield);
+	}
+
+	bool tx_need_yield = false;
+	if ((sr & USART_SR_TC) && (regs->CR1 & USART_CR1_TCIE)) {
+		PIOS_USART_DMA_TxNext(usart_dev, &tx_need_yield);
+	}
+}
+
 static void PIOS_USART_generic_irq_handler(uintptr_t usart_id)
 {
 	struct pios_usart_dev * usart_dev = (struct pios_usart_dev *)usart_id;
 
 	bool valid = PIOS_USART_validate(usart_dev);
 	PIOS_Assert(valid);
+
+	if (usart_dev->cfg->dma) {
+		PIOS_USART_DMA_generic_irq_handler(usart_dev);
+		return;
+	}
 	
 	/* Force read of dr after sr to make sure to clear error flags */
 	volatile uint16_t sr = usart_dev->cfg->regs->SR;
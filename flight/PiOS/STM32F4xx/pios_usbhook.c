@@ -95,18 +95,14 @@ void PIOS_USBHOOK_Deactivate(void)
 
 void OTG_FS_IRQHandler(void)
 {
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_PROLOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Prologue();
 
 	if(!USBD_OTG_ISR_Handler(&pios_usb_otg_core_handle)) {
 		/* spurious interrupt, disable IRQ */
 	  
 	}
 
-#if defined(PIOS_INCLUDE_CHIBIOS)
-	CH_IRQ_EPILOGUE();
-#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+	PIOS_IRQ_Epilogue();
 }
 
 struct usb_if_entry {
@@ -225,9 +225,10 @@ void PIOS_VIDEO_DMA_Handler(void)
 {	
 	// Handle flags from DMA stream channel
 	if ((dev_cfg->mask_dma->LISR & DMA_FLAG_TCIF3) && (dev_cfg->level_dma->HISR & DMA_FLAG_TCIF4)) {
-		// Clear the DMA interrupt flags
-		dev_cfg->mask_dma->LIFCR  |= DMA_FLAG_TCIF3;
-		dev_cfg->level_dma->HIFCR |= DMA_FLAG_TCIF4;
+		// Clear the DMA interrupt flags; the clear registers are
+		// write-only, so there is nothing to read back
+		dev_cfg->mask_dma->LIFCR  = DMA_FLAG_TCIF3;
+		dev_cfg->level_dma->HIFCR = DMA_FLAG_TCIF4;
 
 		dev_cfg->mask.dma.tx.channel->CR  &= ~(uint32_t)DMA_SxCR_EN;
 		dev_cfg->level.dma.tx.channel->CR &= ~(uint32_t)DMA_SxCR_EN;
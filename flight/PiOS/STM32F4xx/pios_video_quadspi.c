@@ -107,6 +107,10 @@ static enum pios_video_system video_system_act = PIOS_VIDEO_SYSTEM_NONE;
 static enum pios_video_system video_system_tmp = PIOS_VIDEO_SYSTEM_PAL;
 static const struct pios_video_type_cfg *pios_video_type_cfg_act = &pios_video_type_cfg_pal;
 
+// Copies of the active configuration for the line interrupt
+static int16_t visible_lines;
+static uint16_t line_length;
+
 // Private functions
 static void swap_buffers();
 
@@ -145,6 +149,9 @@ bool PIOS_Vsync_ISR()
 
 	video_system_tmp = PIOS_VIDEO_SYSTEM_NTSC;
 
+	visible_lines = pios_video_type_cfg_act->graphics_hight_real;
+	line_length = pios_video_type_cfg_act->dma_buffer_length;
+
 	// Every VSYNC_REDRAW_CNT field: swap buffers and trigger redraw
 	if (++Vsync_update >= VSYNC_REDRAW_CNT) {
 		Vsync_update = 0;
@@ -165,11 +172,9 @@ bool PIOS_Vsync_ISR()
 
 bool PIOS_Hsync_ISR()
 {
-	static bool woken = false;
-
 	active_line++;
 
-	if ((active_line >= 0) && (active_line < pios_video_type_cfg_act->graphics_hight_real)) {
+	if ((active_line >= 0) && (active_line < visible_lines)) {
 		// Check if QUADSPI is busy
 		if (QUADSPI->SR & 0x20)
 			goto exit;
@@ -177,15 +182,16 @@ bool PIOS_Hsync_ISR()
 		// Disable DMA
 		dev_cfg->dma.tx.channel->CR &= ~(uint32_t)DMA_SxCR_EN;
 
-		// Clear the DMA interrupt flags
-		dev_cfg->pixel_dma->HIFCR  |= DMA_FLAG_TCIF7 | DMA_FLAG_HTIF7 | DMA_FLAG_FEIF7 | DMA_FLAG_TEIF7 | DMA_FLAG_DMEIF7;
+		// Clear the DMA interrupt flags; the clear register is
+		// write-only, so there is nothing to read back
+		dev_cfg->pixel_dma->HIFCR  = DMA_FLAG_TCIF7 | DMA_FLAG_HTIF7 | DMA_FLAG_FEIF7 | DMA_FLAG_TEIF7 | DMA_FLAG_DMEIF7;
 
 		// Load new line
 		dev_cfg->dma.tx.channel->M0AR = (uint32_t)&disp_buffer[buffer_offset];
 
 		// Set length
-		dev_cfg->dma.tx.channel->NDTR = (uint16_t)pios_video_type_cfg_act->dma_buffer_length;
-		QUADSPI->DLR = (uint32_t)pios_video_type_cfg_act->dma_buffer_length - 1;
+		dev_cfg->dma.tx.channel->NDTR = line_length;
+		QUADSPI->DLR = (uint32_t)line_length - 1;
 
 		// Enable DMA
 		dev_cfg->dma.tx.channel->CR |= (uint32_t)DMA_SxCR_EN;
@@ -194,11 +200,8 @@ bool PIOS_Hsync_ISR()
 	}
 
 exit:
-#if defined(PIOS_INCLUDE_FREERTOS)
-	/* Yield From ISR if needed */
-	portEND_SWITCHING_ISR(woken == true ? pdTRUE : pdFALSE);
-#endif
-	return woken;
+	// Nothing is woken from here, so there is never a need to yield
+	return false;
 }
 
 /**
@@ -86,9 +86,15 @@ struct ws2811_dev_s {
 	// And this gets fixed up to be a shifted right image, etc.
 	uint8_t gpio_bit;
 
+	// The four words a pair of pixel bits expands to, odd bytes included
+	uint32_t bit_pair_word[4];
+
 	bool cur_buf;
 	bool eof;
 
+	// A pixel changed since the strand was last sent
+	bool dirty;
+
 	volatile bool in_progress;
 
 	uint8_t *pixel_data_pos;
@@ -112,6 +118,7 @@ int PIOS_WS2811_init(ws2811_dev_t *dev_out, const struct pios_ws2811_cfg *cfg,
 
 	dev->magic = WS2811_MAGIC;
 	dev->cfg = cfg;
+	dev->dirty = true;
 	dev->max_leds = max_leds;
 
 	dev->pixel_data_end = (uint8_t *)(&dev->pixel_data[max_leds]);
@@ -142,6 +149,20 @@ int PIOS_WS2811_init(ws2811_dev_t *dev_out, const struct pios_ws2811_cfg *cfg,
 			(dev->gpio_bit << 24);
 	}
 
+	for (int i = 0; i < 4; i++) {
+		// Bit 1 of the index is the earlier (more significant) bit
+		dev->bit_pair_word[i] = (dev->gpio_bit << 8) |
+			(dev->gpio_bit << 24);
+
+		if (!(i & 2)) {
+			dev->bit_pair_word[i] |= dev->gpio_bit;
+		}
+
+		if (!(i & 1)) {
+			dev->bit_pair_word[i] |= dev->gpio_bit << 16;
+		}
+	}
+
 	dev->lame_dma_buf[0] = (dev->gpio_bit) |
 		(dev->gpio_bit << 8) |
 		(dev->gpio_bit << 16) |
@@ -195,8 +216,13 @@ DONT_BUILD_IF((WS2811_DMA_BUFSIZE % 16) != 0, DMABufIntegralBytes);
 
 // Updates pixel_data_ptr to where we are.  returns true if we've reached
 // the end.
-static bool fill_dma_buf(uint8_t * restrict dma_buf, uint8_t **pixel_data_ptr,
-		uint8_t *pixel_data_end, uint8_t gpio_val) {
+//
+// Each bit is two bytes: for a '0' the even byte is the gpio bit, so the
+// pin falls early; for a '1' it is zero and the odd byte, always the gpio
+// bit, clears it later.  Two bits make a word, looked up in bit_pair_word,
+// so a pixel byte is four word stores.
+static bool fill_dma_buf(uint32_t * restrict dma_buf, uint8_t **pixel_data_ptr,
+		uint8_t *pixel_data_end, const uint32_t *bit_pair_word) {
 	// Our local shadow of this, for efficient blitting.
 	uint8_t * restrict p_d_p = *pixel_data_ptr;
 
@@ -206,26 +232,16 @@ static bool fill_dma_buf(uint8_t * restrict dma_buf, uint8_t **pixel_data_ptr,
 		return true;
 	}
 
-	for (int i = 0; i < WS2811_DMA_BUFSIZE; i += 16) {
+	for (int i = 0; i < WS2811_DMA_BUFSIZE / 4; i += 4) {
 		if (p_d_p >= pixel_data_end) break;
 
 		uint8_t p = *(p_d_p++);
 
-		for (int j = 0; j < 8; j++) {
-			if (!(p & 0x80)) {
-				// It's zero-- therefore the pin has to fall
-				// early.
-				dma_buf[i + j*2] = gpio_val;
-			} else {
-				// It's one.  Therefore we let the prefilled
-				// bit in the odd position clear it; we do
-				// nothing.
-				dma_buf[i + j*2] = 0;
-			}
-
-			// We clock out most significant bit first.
-			p = p << 1;
-		}
+		// We clock out most significant bit first.
+		dma_buf[i] = bit_pair_word[p >> 6];
+		dma_buf[i + 1] = bit_pair_word[(p >> 4) & 3];
+		dma_buf[i + 2] = bit_pair_word[(p >> 2) & 3];
+		dma_buf[i + 3] = bit_pair_word[p & 3];
 	}
 	*pixel_data_ptr = p_d_p;
 
@@ -321,6 +337,13 @@ void PIOS_WS2811_trigger_update(ws2811_dev_t dev)
 		return;
 	}
 
+	// The LEDs hold their color, so only changes need sending.  A change
+	// made while a send was in progress is still pending here.
+	if (!dev->dirty) {
+		return;
+	}
+
+	dev->dirty = false;
 	dev->in_progress = true;
 
 	dev->eof = false;
@@ -330,11 +353,11 @@ void PIOS_WS2811_trigger_update(ws2811_dev_t dev)
 	// Current one to blit is the first
 	dev->cur_buf = false;
 
-	fill_dma_buf((uint8_t *) dev->dma_buf_0, &dev->pixel_data_pos,
-			dev->pixel_data_end, dev->gpio_bit);
+	fill_dma_buf(dev->dma_buf_0, &dev->pixel_data_pos,
+			dev->pixel_data_end, dev->bit_pair_word);
 
-	dev->eof = fill_dma_buf((uint8_t *) dev->dma_buf_1, &dev->pixel_data_pos,
-			dev->pixel_data_end, dev->gpio_bit);
+	dev->eof = fill_dma_buf(dev->dma_buf_1, &dev->pixel_data_pos,
+			dev->pixel_data_end, dev->bit_pair_word);
 
 	ws2811_cue_dma(dev);
 }
@@ -381,11 +404,10 @@ void PIOS_WS2811_dma_interrupt_handler(ws2811_dev_t dev)
 	// If cur_buf is true, we're currently blitting 1, so we should
 	// be updating 0.
 
-	uint8_t *buf = (uint8_t *)
-		(dev->cur_buf ? dev->dma_buf_0 : dev->dma_buf_1);
+	uint32_t *buf = dev->cur_buf ? dev->dma_buf_0 : dev->dma_buf_1;
 
 	dev->eof = fill_dma_buf(buf, &dev->pixel_data_pos,
-			dev->pixel_data_end, dev->gpio_bit);
+			dev->pixel_data_end, dev->bit_pair_word);
 }
 
 void PIOS_WS2811_set(ws2811_dev_t dev, int idx, uint8_t r, uint8_t g,
@@ -397,8 +419,12 @@ void PIOS_WS2811_set(ws2811_dev_t dev, int idx, uint8_t r, uint8_t g,
 		return;
 	}
 
-	dev->pixel_data[idx] = (struct ws2811_pixel_data_s)
-			{ .r = r, .g = g, .b = b };
+	struct ws2811_pixel_data_s *pixel = &dev->pixel_data[idx];
+
+	if (pixel->r != r || pixel->g != g || pixel->b != b) {
+		*pixel = (struct ws2811_pixel_data_s) { .r = r, .g = g, .b = b };
+		dev->dirty = true;
+	}
 }
 
 void PIOS_WS2811_set_all(ws2811_dev_t dev, uint8_t r, uint8_t g,
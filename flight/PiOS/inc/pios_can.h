@@ -35,7 +35,9 @@
 //! The set of CAN messages
 enum pios_can_messages {
 	PIOS_CAN_GIMBAL = 0,
-	PIOS_CAN_LAST = 1
+	PIOS_CAN_ACTUATOR = 1,
+	PIOS_CAN_ESC_TELEMETRY = 2,
+	PIOS_CAN_LAST = 3
 };
 
 //! Message to tell gimbal the desired setpoint and FC state
@@ -48,6 +50,20 @@ struct pios_can_gimbal_message {
 	uint8_t setpoint_yaw;
 }  __attribute__((packed));;
 
+//! Commands of the first four actuator channels, as ActuatorCommand
+struct pios_can_actuator_message {
+	uint16_t channel[4];	//!< pulse width in us
+} __attribute__((packed));
+
+//! Telemetry reported by one ESC on the bus
+struct pios_can_esc_telemetry_message {
+	uint8_t esc;		//!< index of the ESC
+	int8_t temperature;	//!< deg C
+	uint16_t rpm;		//!< electrical RPM / 10
+	uint16_t voltage;	//!< cV
+	uint16_t current;	//!< cA
+} __attribute__((packed));
+
 //! Transmit a data message with a particular message ID
 int32_t PIOS_CAN_TxData(uintptr_t id, enum pios_can_messages, uint8_t *data);
 
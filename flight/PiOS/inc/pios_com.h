@@ -38,6 +38,8 @@ struct pios_com_driver;
 /** Opaque struct for device handles */
 struct pios_com_dev;
 
+struct pios_semaphore;
+
 typedef uint16_t (*pios_com_callback)(uintptr_t context, uint8_t * buf, uint16_t buf_len, uint16_t * headroom, bool * task_woken);
 
 struct pios_com_driver {
@@ -56,13 +58,20 @@ extern int32_t PIOS_COM_SendCharNonBlocking(uintptr_t com_id, char c);
 extern int32_t PIOS_COM_SendChar(uintptr_t com_id, char c);
 extern int32_t PIOS_COM_SendBufferNonBlocking(uintptr_t com_id, const uint8_t *buffer, uint16_t len);
 extern int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t len);
+extern uint8_t *PIOS_COM_ReserveBuffer(uintptr_t com_id, uint16_t len);
+extern int32_t PIOS_COM_CommitBuffer(uintptr_t com_id, uint16_t len);
 extern int32_t PIOS_COM_SendStringNonBlocking(uintptr_t com_id, const char *str);
 extern int32_t PIOS_COM_SendString(uintptr_t com_id, const char *str);
 extern int32_t PIOS_COM_SendFormattedStringNonBlocking(uintptr_t com_id, const char *format, ...);
 extern int32_t PIOS_COM_SendFormattedString(uintptr_t com_id, const char *format, ...);
 extern uint16_t PIOS_COM_ReceiveBuffer(uintptr_t com_id, uint8_t * buf, uint16_t buf_len, uint32_t timeout_ms);
+extern const uint8_t *PIOS_COM_PeekReceiveBuffer(uintptr_t com_id, uint16_t *len, uint32_t timeout_ms);
+extern void PIOS_COM_ConsumeReceiveBuffer(uintptr_t com_id, uint16_t len);
 extern bool PIOS_COM_Available(uintptr_t com_id);
+extern bool PIOS_COM_HasRx(uintptr_t com_id);
+extern int32_t PIOS_COM_SetRxNotify(uintptr_t com_id, struct pios_semaphore *sem);
 uint16_t PIOS_COM_GetNumReceiveBytesPending(uintptr_t com_id);
+int32_t PIOS_COM_GetTxBufferState(uintptr_t com_id, uint16_t *pending, uint16_t *room);
 
 #endif /* PIOS_COM_H */
 
@@ -27,9 +27,14 @@
 #define PIOS_FLASHFS_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 int32_t PIOS_FLASHFS_Format(uintptr_t fs_id);
 int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t * obj_data, uint16_t obj_size);
+
+/* Fills in the next object of a batch, or returns false when there are no more */
+typedef bool (*pios_flashfs_batch_next_t)(void *ctx, uint32_t *obj_id, uint16_t *obj_inst_id, uint8_t **obj_data, uint16_t *obj_size);
+int32_t PIOS_FLASHFS_ObjSaveBatch(uintptr_t fs_id, pios_flashfs_batch_next_t next, void *ctx);
 int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t * obj_data, uint16_t obj_size);
 int32_t PIOS_FLASHFS_ObjDelete(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id);
 
@@ -29,6 +29,28 @@
 
 #include <stdlib.h>		/* size_t */
 #include <stdbool.h>		/* bool */
+#include <stdint.h>		/* uint16_t */
+
+/**
+ * Mark zero-initialised data that is worked on all the time.  It goes in
+ * the CCM RAM where the linker script has room for it, F4 for now, and in
+ * the plain .bss elsewhere.  Like the fast heap, it is out of the DMA's reach.
+ */
+#if defined(__ELF__)
+#define PIOS_FAST_DATA __attribute__((section(".bss.fast")))
+#else
+#define PIOS_FAST_DATA
+#endif
+
+//! Pools of 16, 32, 64, 128 and 256 byte blocks, with PIOS_INCLUDE_HEAP_POOLS
+#define PIOS_HEAP_NUM_POOLS 5
+
+struct pios_heap_pool_stats {
+	uint16_t block_size;
+	uint16_t in_use;	/* blocks allocated now */
+	uint16_t peak;		/* most blocks allocated at once */
+	uint16_t carved;	/* blocks taken from the heap, in use or free */
+};
 
 extern bool PIOS_heap_malloc_failed_p(void);
 
@@ -41,5 +63,7 @@ extern size_t PIOS_heap_get_free_size(void);
 extern size_t PIOS_fastheap_get_free_size(void);
 extern void PIOS_heap_initialize_blocks(void);
 extern void PIOS_heap_increase_size(size_t bytes);
+extern void PIOS_heap_enable_pools(void);
+extern int32_t PIOS_heap_get_pool_stats(bool fast, struct pios_heap_pool_stats stats[PIOS_HEAP_NUM_POOLS]);
 
 #endif	/* PIOS_HEAP_H */
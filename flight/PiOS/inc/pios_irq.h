@@ -38,4 +38,45 @@ extern int32_t PIOS_IRQ_Disable(void);
 extern int32_t PIOS_IRQ_Enable(void);
 extern bool PIOS_IRQ_InISR(void);
 
+#if defined(CPUPROFILE_DIAGNOSTICS)
+//! Exception numbers whose cycles are counted
+#define PIOS_IRQ_PROFILE_VECTORS 128
+
+//! When a handler started, so it can be charged its own cycles
+struct pios_irq_profile {
+	uint32_t start;
+	uint32_t nested;	// all handlers' cycles when it started
+};
+
+extern void PIOS_IRQ_Profile_Enter(struct pios_irq_profile *prof);
+extern void PIOS_IRQ_Profile_Exit(const struct pios_irq_profile *prof);
+extern uint32_t PIOS_IRQ_Profile_Total(void);
+extern uint32_t PIOS_IRQ_Profile_Take(uint16_t vector);
+
+#define PIOS_IRQ_PROFILE_ENTER() \
+	struct pios_irq_profile pios_irq_prof; \
+	PIOS_IRQ_Profile_Enter(&pios_irq_prof)
+#define PIOS_IRQ_PROFILE_EXIT() PIOS_IRQ_Profile_Exit(&pios_irq_prof)
+#else
+#define PIOS_IRQ_PROFILE_ENTER() do { } while (0)
+#define PIOS_IRQ_PROFILE_EXIT() do { } while (0)
+#endif /* CPUPROFILE_DIAGNOSTICS */
+
+/**
+ * The first and last things in an interrupt handler: they let the RTOS
+ * know about it, and charge it its cycles when profiling.  The epilogue
+ * must be reached on every way out.
+ */
+#if defined(PIOS_INCLUDE_CHIBIOS)
+#define PIOS_IRQ_Prologue() \
+	CH_IRQ_PROLOGUE(); \
+	PIOS_IRQ_PROFILE_ENTER()
+#define PIOS_IRQ_Epilogue() \
+	PIOS_IRQ_PROFILE_EXIT(); \
+	CH_IRQ_EPILOGUE()
+#else
+#define PIOS_IRQ_Prologue() PIOS_IRQ_PROFILE_ENTER()
+#define PIOS_IRQ_Epilogue() PIOS_IRQ_PROFILE_EXIT()
+#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+
 #endif /* PIOS_IRQ_H */
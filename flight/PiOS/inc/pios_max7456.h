@@ -80,6 +80,20 @@ int PIOS_MAX7456_init (max7456_dev_t *dev_out,
  */
 void PIOS_MAX7456_clear (max7456_dev_t dev);
 
+/**
+ * @brief Blank the frame buffer that put and puts draw into, to draw a
+ * new frame without touching what is on screen
+ * @param[in] dev The max7456 device handle
+ */
+void PIOS_MAX7456_begin_frame (max7456_dev_t dev);
+
+/**
+ * @brief Send the characters that differ from what is on screen, in one
+ * SPI burst
+ * @param[in] dev The max7456 device handle
+ */
+void PIOS_MAX7456_flush (max7456_dev_t dev);
+
 /**
  * @brief Upload a character to the device
  * @param[in] dev The max7456 device handle
@@ -99,7 +113,7 @@ void PIOS_MAX7456_download_char (max7456_dev_t dev,
 		uint8_t char_index, uint8_t *data);
 
 /**
- * @brief Sets a position of character memory
+ * @brief Sets a position of the frame buffer, shown at the next flush
  * @param[in] dev The max7456 device handle
  * @param[in] col The column to update
  * @param[in] row The row of the character to update
@@ -110,7 +124,7 @@ void PIOS_MAX7456_put (max7456_dev_t dev, uint8_t col, uint8_t row,
 		uint8_t chr, uint8_t attr);
 
 /**
- * @brief Sets a string into character memory
+ * @brief Sets a string into the frame buffer, shown at the next flush
  * @param[in] dev The max7456 device handle
  * @param[in] col The column to begin the update at
  * @param[in] row The row of the character to update
@@ -176,6 +176,9 @@ struct pios_openlrs_dev {
   enum RF_MODE rf_mode;
   uint32_t rf_channel;
 
+  // The radio's wake-up timer is armed, so nIRQ may not be a packet
+  volatile bool wakeup_armed;
+
   uint8_t it_status1;
   uint8_t it_status2;
 
@@ -32,7 +32,7 @@
 
 #include "pios.h"
 #include "stdint.h"
-#include "pios_queue.h"
+#include <circqueue.h>
 
 //! Pios sensor structure for generic gyro data
 struct pios_sensor_gyro_data {
@@ -91,17 +91,47 @@ enum pios_sensor_type
 	PIOS_SENSOR_LAST
 };
 
+/**
+ * Samples of one sensor, from the driver to the one task that reads them.
+ * A ring on a circ_queue, so handing a sample over takes no kernel call
+ * unless the reader is waiting for it.
+ */
+struct pios_sensors_queue;
+
 //! Initialize the PIOS_SENSORS interface
 int32_t PIOS_SENSORS_Init();
 
+//! Create a queue for a driver to hand over up to num_elem samples in
+struct pios_sensors_queue *PIOS_SENSORS_CreateQueue(uint16_t elem_size, uint16_t num_elem);
+
+//! Free a queue that was never registered, on a failed driver init
+void PIOS_SENSORS_DeleteQueue(struct pios_sensors_queue *queue);
+
+//! Hand a sample over to the reader, from a task
+bool PIOS_SENSORS_Push(struct pios_sensors_queue *queue, const void *sample);
+
+#if !defined(SIM_POSIX)
+//! Hand a sample over to the reader, from an interrupt
+bool PIOS_SENSORS_Push_FromISR(struct pios_sensors_queue *queue, const void *sample, bool *woken);
+#endif
+
 //! Register a sensor with the PIOS_SENSORS interface
-int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, struct pios_queue *queue);
+int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, struct pios_sensors_queue *queue);
 
 //! Checks if a sensor type is registered with the PIOS_SENSORS interface
 bool PIOS_SENSORS_IsRegistered(enum pios_sensor_type type);
 
 //! Get the data queue for a sensor type
-struct pios_queue *PIOS_SENSORS_GetQueue(enum pios_sensor_type type);
+struct pios_sensors_queue *PIOS_SENSORS_GetQueue(enum pios_sensor_type type);
+
+//! Copy out the oldest sample of a sensor, waiting up to ms_to_wait for one
+bool PIOS_SENSORS_GetData(enum pios_sensor_type type, void *sample, uint32_t ms_to_wait);
+
+//! Get the waiting samples of a sensor in place, waiting up to ms_to_wait for one
+void *PIOS_SENSORS_PeekData(enum pios_sensor_type type, uint16_t *num, uint32_t ms_to_wait);
+
+//! Release the first num samples got with PIOS_SENSORS_PeekData()
+void PIOS_SENSORS_ReleaseData(enum pios_sensor_type type, uint16_t num);
 
 //! Set the maximum gyro rate in deg/s
 void PIOS_SENSORS_SetMaxGyro(int32_t rate);
@@ -37,6 +37,7 @@
  */
 enum pios_servo_shot_type {
 	SHOT_ONESHOT = 0,
+	SHOT_DSHOT150 = 65531,
 	SHOT_DSHOT300 = 65532,
 	SHOT_DSHOT600 = 65533,
 	SHOT_DSHOT1200 = 65534
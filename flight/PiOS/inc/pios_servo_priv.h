@@ -34,6 +34,28 @@
 #include <pios_stm32.h>
 #include <pios_tim_priv.h>
 
+#if defined(STM32F40_41xxx) || defined(STM32F446xx)
+#define PIOS_SERVO_DSHOT_DMA
+
+/**
+ * DShot frames sent by DMA instead of by the CPU.  A timer not driving any
+ * output paces word writes into the BSRR of each port with DShot pins, one
+ * stream per port, triggered by one of the timer's DMA requests.  Only DMA2
+ * reaches the GPIO, so the timer has to be TIM1 or TIM8.
+ */
+struct pios_servo_dshot_dma_cfg {
+	TIM_TypeDef *timer;
+
+	struct {
+		GPIO_TypeDef *gpio;
+		DMA_Stream_TypeDef *stream;
+		uint32_t channel;
+		uint16_t request;	/* TIM_DMA_Update, TIM_DMA_CC1... */
+	} ports[3];
+	uint8_t num_ports;
+};
+#endif
+
 struct pios_servo_cfg {
 	TIM_TimeBaseInitTypeDef tim_base_init;
 	TIM_OCInitTypeDef tim_oc_init;
@@ -43,6 +65,11 @@ struct pios_servo_cfg {
 	uint8_t num_channels;
 
 	bool force_1MHz;
+
+#ifdef PIOS_SERVO_DSHOT_DMA
+	/* Optional; without it DShot is bitbanged */
+	const struct pios_servo_dshot_dma_cfg *dshot_dma;
+#endif
 };
 
 extern int32_t PIOS_Servo_Init(const struct pios_servo_cfg * cfg);
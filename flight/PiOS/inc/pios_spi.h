@@ -33,6 +33,16 @@ struct pios_spi_cfg;
 
 struct pios_spi_dev;
 
+//! Buses that keep statistics, in the order the board brings them up
+#define PIOS_SPI_MAX_BUSES 3
+
+struct pios_spi_stats {
+	uint32_t transactions;	/* times the bus was claimed */
+	uint32_t busy_us;	/* time it was held; wraps after 71 minutes */
+	uint32_t wait_us;	/* time spent waiting for it; wraps too */
+	uint16_t max_wait_us;	/* longest wait for it */
+};
+
 /* Public Functions */
 
 /**
@@ -96,6 +106,15 @@ int32_t PIOS_SPI_ClaimBus(uint32_t spi_id);
  */
 int32_t PIOS_SPI_ReleaseBus(uint32_t spi_id);
 
+/**
+ * Get the statistics of a bus
+ * \param[in] bus index of the bus, in the order they were initialised
+ * \param[out] stats where to put them
+ * \return 0 if no error
+ * \return -1 if there is no such bus
+ */
+int32_t PIOS_SPI_GetStats(uint8_t bus, struct pios_spi_stats *stats);
+
 void    PIOS_SPI_IRQ_Handler(uint32_t spi_id);
 
 #endif /* PIOS_SPI_H */
@@ -35,9 +35,31 @@
 #include <pios_stm32.h>
 #include "pios_semaphore.h"
 
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+#include "pios_mutex.h"
+#define PIOS_SPI_BUS_MUTEX
+#endif
+
 struct pios_spi_dev {
 	const struct pios_spi_cfg *cfg;
+#if defined(PIOS_SPI_BUS_MUTEX)
+	struct pios_mutex *busy;	/* the holder inherits the waiters' priority */
+#else
 	struct pios_semaphore *busy;
+#endif
+	struct pios_semaphore *dma_done;
+	uint32_t claimed_at;		/* raw time the holder got the bus */
+	struct pios_spi_stats stats;
+};
+
+/*
+ * Streams to move long blocks while the task doing the transfer sleeps.
+ * Only the STM32F4xx builds use them.
+ */
+struct pios_spi_dma_cfg {
+	struct stm32_irq irq;		/* of the rx stream; flags are all its flags */
+	struct stm32_dma_chan rx;
+	struct stm32_dma_chan tx;
 };
 
 struct pios_spi_cfg {
@@ -47,6 +69,7 @@ struct pios_spi_cfg {
 	struct stm32_gpio sclk;
 	struct stm32_gpio miso;
 	struct stm32_gpio mosi;
+	const struct pios_spi_dma_cfg *block_dma;	/* optional */
 	uint32_t slave_count;
 #ifdef PIOS_INCLUDE_VIDEO
 	// XXX Hack: pios_video uses pios_spi's config structure and expects the
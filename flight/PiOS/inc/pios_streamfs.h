@@ -28,13 +28,26 @@
 
 #include <stdint.h>
 
+/**
+ * Summary of a file, taken from the footers of its arenas. Times are in
+ * ms since the boot the file was written on.
+ */
+struct streamfs_file_info {
+	uint32_t start_time;
+	uint32_t duration;
+	uint32_t length;	/* bytes still present in flash */
+};
+
 /* fs_id here is actually the com driver ID, to avoid having to do too
  * much bookkeepin' */
 int32_t PIOS_STREAMFS_Format(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_OpenWrite(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_OpenRead(uintptr_t fs_id, uint32_t file_id);
+int32_t PIOS_STREAMFS_OpenReadRange(uintptr_t fs_id, uint32_t file_id, uint32_t start_ms, uint32_t end_ms);
+int32_t PIOS_STREAMFS_FileInfo(uintptr_t fs_id, uint32_t file_id, struct streamfs_file_info *info);
 int32_t PIOS_STREAMFS_MinFileId(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_MaxFileId(uintptr_t fs_id);
+int32_t PIOS_STREAMFS_EraseStalls(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_Close(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_Read(uintptr_t fs_id, uint8_t *data, uint32_t len);
 
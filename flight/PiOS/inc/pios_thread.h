@@ -90,6 +90,7 @@ uint32_t PIOS_Thread_Systime(void);
 void PIOS_Thread_Sleep(uint32_t time_ms);
 void PIOS_Thread_Sleep_Until(uint32_t *previous_ms, uint32_t increment_ms);
 uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp);
+uint32_t PIOS_Thread_Get_Stack_Usage_Since(struct pios_thread *threadp, uint32_t previous);
 uint32_t PIOS_Thread_Get_Runtime(struct pios_thread *threadp);
 void PIOS_Thread_Scheduler_Suspend(void);
 void PIOS_Thread_Scheduler_Resume(void);
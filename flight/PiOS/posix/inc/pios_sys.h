@@ -41,6 +41,8 @@ extern int32_t PIOS_SYS_SerialNumberGetBinary(uint8_t array[PIOS_SYS_SERIAL_NUM_
 extern int32_t PIOS_SYS_SerialNumberGet(char str[PIOS_SYS_SERIAL_NUM_ASCII_LEN+1]);
 
 extern void PIOS_SYS_Args(int argc, char *argv[]);
+extern void PIOS_SYS_ScanInstance(int argc, char *argv[]);
+extern int PIOS_SYS_Instance(void);
 
 #endif /* PIOS_SYS_H */
 
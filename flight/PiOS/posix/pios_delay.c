@@ -30,6 +30,7 @@
 
 /* Project Includes */
 #include "pios.h"
+#include "pios_thread.h"
 #include "time.h"
 
 #include <time.h>
@@ -124,6 +125,11 @@ int32_t PIOS_DELAY_Init(void)
 */
 int32_t PIOS_DELAY_WaituS(uint32_t uS)
 {
+	/* Less than a tick of virtual time never passes */
+	if (port_virtual_time) {
+		return 0;
+	}
+
 	struct timespec wait,rest;
 	wait.tv_sec=0;
 	wait.tv_nsec=1000*uS;
@@ -148,6 +154,12 @@ int32_t PIOS_DELAY_WaituS(uint32_t uS)
 */
 int32_t PIOS_DELAY_WaitmS(uint32_t mS)
 {
+	/* Virtual time only passes while every thread is blocked */
+	if (port_virtual_time) {
+		PIOS_Thread_Sleep(mS);
+		return 0;
+	}
+
 	struct timespec wait,rest;
 	wait.tv_sec=mS/1000;
 	wait.tv_nsec=(mS%1000)*1000000;
@@ -161,6 +173,11 @@ int32_t PIOS_DELAY_WaitmS(uint32_t mS)
 
 uint32_t PIOS_DELAY_GetRaw()
 {
+	/* On virtual time the raw clock follows the system tick */
+	if (port_virtual_time) {
+		return PIOS_Thread_Systime() * 1000;
+	}
+
 	uint32_t raw_us = get_monotonic_us_time() - base_time;
 	return raw_us;
 }
@@ -89,6 +89,16 @@ size_t PIOS_fastheap_get_free_size(void)
 	return 0;
 }
 
+void PIOS_heap_enable_pools(void)
+{
+}
+
+int32_t PIOS_heap_get_pool_stats(bool fast, struct pios_heap_pool_stats stats[PIOS_HEAP_NUM_POOLS])
+{
+	/* The ChibiOS heap frees on its own */
+	return -1;
+}
+
 /**
  * @}
  * @}
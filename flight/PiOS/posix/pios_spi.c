@@ -141,6 +141,11 @@ int32_t PIOS_SPI_ReleaseBus(uint32_t spi_id)
 	return 0;
 }
 
+int32_t PIOS_SPI_GetStats(uint8_t bus, struct pios_spi_stats *stats)
+{
+	return -1;
+}
+
 int32_t PIOS_SPI_RC_PinSet(uint32_t spi_id, uint32_t slave_id, bool pin_value)
 {
 	struct pios_spi_dev *spi_dev = (struct pios_spi_dev *)spi_id;
@@ -71,16 +71,20 @@
 
 #if defined(PIOS_INCLUDE_SYS)
 static bool debug_fpe=false;
+static int sim_instance = 0;
 
 #define MAX_SPI_BUSES 16
 int num_spi = 0;
 uintptr_t spi_devs[16];
 
 static void Usage(char *cmdName) {
-	printf( "usage: %s [-f] [-r] [-l logfile] [-s spibase] [-d drvname:bus:id]\n"
+	printf( "usage: %s [-f] [-r] [-t] [-I instance] [-l logfile] [-s spibase] [-d drvname:bus:id]\n"
 		"\n"
 		"\t-f\tEnables floating point exception trapping mode\n"
+		"\t-I inst\tRuns as instance inst of several, with telemetry on\n"
+		"\t\t\tport 9000+inst and a serial number of its own\n"
 		"\t-r\tGoes realtime-class and pins all memory (requires root)\n"
+		"\t-t\tRuns on virtual time, as fast as the tasks allow\n"
 		"\t-l log\tWrites simulation data to a log\n"
 #ifdef PIOS_INCLUDE_SERIAL
 		"\t-S drvname:serialpath\tStarts a serial driver on serialpath\n"
@@ -330,14 +334,20 @@ void PIOS_SYS_Args(int argc, char *argv[]) {
 
 	int opt;
 
-	while ((opt = getopt(argc, argv, "frl:s:d:S:")) != -1) {
+	while ((opt = getopt(argc, argv, "frtI:l:s:d:S:")) != -1) {
 		switch (opt) {
 			case 'f':
 				debug_fpe = true;
 				break;
+			case 'I':
+				/* Already taken by PIOS_SYS_ScanInstance() */
+				break;
 			case 'r':
 				go_realtime();
 				break;
+			case 't':
+				port_virtual_time_enable();
+				break;
 			case 'l':
 			{
 				uintptr_t tmp;
@@ -408,6 +418,44 @@ void PIOS_SYS_Args(int argc, char *argv[]) {
 	}
 }
 
+/**
+ * Picks the instance number (-I) out of the arguments.  The board opens
+ * its telemetry port before PIOS_SYS_Args() runs, so this is done first,
+ * from main().
+ */
+void PIOS_SYS_ScanInstance(int argc, char *argv[])
+{
+	for (int i = 1; i < argc; i++) {
+		const char *val = NULL;
+
+		if (!strcmp(argv[i], "-I") && (i + 1 < argc)) {
+			val = argv[i + 1];
+		} else if (!strncmp(argv[i], "-I", 2) && argv[i][2]) {
+			val = argv[i] + 2;
+		}
+
+		if (val) {
+			char *endptr;
+			long inst = strtol(val, &endptr, 10);
+
+			if ((inst < 0) || (inst > 255) || *endptr) {
+				printf("Instance must be 0 to 255\n");
+				exit(1);
+			}
+
+			sim_instance = inst;
+		}
+	}
+}
+
+/**
+ * \return the instance number given with -I, 0 by default
+ */
+int PIOS_SYS_Instance(void)
+{
+	return sim_instance;
+}
+
 /**
 * Initialises all system peripherals
 */
@@ -522,6 +570,11 @@ int32_t PIOS_SYS_SerialNumberGetBinary(uint8_t *array)
 		array[i] = 0xff;
 	}
 
+	/* Instances other than the first are told apart by the last byte */
+	if (sim_instance) {
+		array[PIOS_SYS_SERIAL_NUM_BINARY_LEN - 1] = sim_instance;
+	}
+
 	/* No error */
 	return 0;
 }
@@ -541,6 +594,11 @@ int32_t PIOS_SYS_SerialNumberGet(char *str)
 	}
 	str[i] = '\0';
 
+	if (sim_instance) {
+		snprintf(str + PIOS_SYS_SERIAL_NUM_ASCII_LEN - 2, 3, "%02X",
+				sim_instance);
+	}
+
 	/* No error */
 	return 0;
 }
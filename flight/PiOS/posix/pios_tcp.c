@@ -43,6 +43,9 @@
 #include <errno.h>
 #include <fcntl.h>
 
+/* How long a write waits for the peer to take data before dropping it */
+#define PIOS_TCP_TX_TIMEOUT_MS 100
+
 /* Provide a COM driver */
 static void PIOS_TCP_ChangeBaud(uintptr_t udp_id, uint32_t baud);
 static void PIOS_TCP_RegisterRxCallback(uintptr_t udp_id, pios_com_callback rx_in_cb, uintptr_t context);
@@ -101,13 +104,16 @@ static int set_nonblock(int sock) {
 
 /**
  * RxTask
+ *
+ * The simulated threads share one host thread, so the socket can't be
+ * waited on; it is read until it runs dry, and polled every tick after.
+ * Data the COM fifo has no room for is kept and offered again, so the
+ * sender is held back by TCP rather than the data being dropped.
  */
 static void PIOS_TCP_RxTask(void *tcp_dev_n)
 {
 	pios_tcp_dev *tcp_dev = (pios_tcp_dev*)tcp_dev_n;
 	
-	const int INCOMING_BUFFER_SIZE = 16;
-	char incoming_buffer[INCOMING_BUFFER_SIZE];
 	int error;
 
 	while (1) {
@@ -138,24 +144,42 @@ static void PIOS_TCP_RxTask(void *tcp_dev_n)
 		
 		fprintf(stderr, "Connection accepted\n");
 
+		uint16_t pending_pos = 0;
+		uint16_t pending_len = 0;
+
 		while (1) {
-			// Received is used to track the scoket whereas the dev variable is only updated when it can be
+			if (pending_len > 0) {
+				if (tcp_dev->rx_in_cb) {
+					bool rx_need_yield = false;
+
+					uint16_t accepted = tcp_dev->rx_in_cb(tcp_dev->rx_in_context,
+							tcp_dev->rx_buffer + pending_pos, pending_len,
+							NULL, &rx_need_yield);
+
+					pending_pos += accepted;
+					pending_len -= accepted;
+				}
+
+				if (pending_len > 0) {
+					/* The fifo is full; give the reader a tick */
+					PIOS_Thread_Sleep(1);
+					continue;
+				}
+			}
 
 			/* Polling the fd has to be executed in thread suspended mode
 			 * to get a correct errno value. */
 			PIOS_Thread_Scheduler_Suspend();
 
-			int result = read(tcp_dev->socket_connection, incoming_buffer, INCOMING_BUFFER_SIZE);
+			int result = read(tcp_dev->socket_connection, tcp_dev->rx_buffer, PIOS_TCP_RX_BUFFER_SIZE);
 			error = errno;
 
 			PIOS_Thread_Scheduler_Resume();
 			
-			if (result > 0 && tcp_dev->rx_in_cb) {
-
-				bool rx_need_yield = false;
-
-				tcp_dev->rx_in_cb(tcp_dev->rx_in_context, (uint8_t*)incoming_buffer, result, NULL, &rx_need_yield);
-
+			if (result > 0) {
+				pending_pos = 0;
+				pending_len = result;
+				continue;
 			}
 
 			if (result == 0) {
@@ -279,19 +303,38 @@ static void PIOS_TCP_TxStart(uintptr_t tcp_id, uint16_t tx_bytes_avail)
 		while (tx_bytes_avail > 0) {
 			bool tx_need_yield = false;
 			length = (tcp_dev->tx_out_cb)(tcp_dev->tx_out_context, tcp_dev->tx_buffer, PIOS_TCP_RX_BUFFER_SIZE, NULL, &tx_need_yield);
+			if (length <= 0) {
+				break;
+			}
+
 			rem = length;
+			int waited_ms = 0;
 			while (rem > 0) {
-				ssize_t len = 0;
-				if (tcp_dev->socket_connection != INVALID_SOCKET) {
-					len = write(tcp_dev->socket_connection, tcp_dev->tx_buffer, length);
+				if (tcp_dev->socket_connection == INVALID_SOCKET) {
+					break;
 				}
-				if (len <= 0) {
-					rem = 0;
-				} else {
+
+				PIOS_Thread_Scheduler_Suspend();
+
+				ssize_t len = write(tcp_dev->socket_connection,
+						tcp_dev->tx_buffer + length - rem, rem);
+				int error = errno;
+
+				PIOS_Thread_Scheduler_Resume();
+
+				if (len > 0) {
 					rem -= len;
+				} else if ((len < 0) && (error == EAGAIN || error == EINTR) &&
+						(waited_ms < PIOS_TCP_TX_TIMEOUT_MS)) {
+					/* The socket buffer is full; let the peer catch up
+					 * rather than dropping the rest of the chunk */
+					PIOS_Thread_Sleep(1);
+					waited_ms++;
+				} else {
+					break;
 				}
 			}
-			tx_bytes_avail -= length;
+			tx_bytes_avail = (length < tx_bytes_avail) ? (tx_bytes_avail - length) : 0;
 		}
 	}
 }
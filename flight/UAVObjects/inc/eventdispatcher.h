@@ -41,6 +41,9 @@
 typedef struct {
 	uint32_t lastErrorID;
 	uint32_t eventErrors;
+	uint32_t lateDispatches;	// periodic events dispatched late
+	uint32_t maxLateMs;
+	uint32_t lateID;		// object of the latest one
 } EventStats;
 
 // Public functions
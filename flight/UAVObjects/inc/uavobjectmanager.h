@@ -103,6 +103,13 @@ typedef enum {
 #define EV_MASK_ALL 0
 #define EV_MASK_ALL_UPDATES (EV_UNPACKED | EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATED_PERIODIC)
 
+/**
+ * Dirty masks carried by the events.  Bit n stands for field n of the data
+ * structure; the fields past the 15th all share the last bit.
+ */
+#define UAVOBJ_ALL_FIELDS_DIRTY 0xffff
+#define UAVOBJ_FIELD_DIRTY(n) ((uint16_t) (1 << (((n) < 15) ? (n) : 15)))
+
 /**
  * Access types
  */
@@ -117,6 +124,7 @@ typedef enum {
 typedef struct {
 	UAVObjHandle obj;
 	uint16_t instId;
+	uint16_t dirty; /** Fields changed by an EV_UPDATED, none if the set changed nothing */
 	UAVObjEventType event;
 } UAVObjEvent;
 
@@ -171,7 +179,11 @@ int32_t UAVObjSaveToFile(UAVObjHandle obj_handle, uint16_t instId, FILEINFO* fil
 UAVObjHandle UAVObjLoadFromFile(FILEINFO* file);
 #endif
 int32_t UAVObjSaveSettings();
+int32_t UAVObjSaveDeferred(UAVObjHandle obj_handle, uint16_t instId);
+int32_t UAVObjFlushSaves();
+bool UAVObjSavesPending();
 int32_t UAVObjLoadSettings();
+int32_t UAVObjLoadDeferredSettings();
 int32_t UAVObjDeleteSettings();
 int32_t UAVObjSaveMetaobjects();
 int32_t UAVObjLoadMetaobjects();
@@ -182,6 +194,8 @@ int32_t UAVObjGetData(UAVObjHandle obj_handle, void* dataOut);
 int32_t UAVObjGetDataField(UAVObjHandle obj_handle, void* dataOut, uint32_t offset, uint32_t size);
 int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn);
 int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn, uint32_t offset, uint32_t size);
+int32_t UAVObjSetDataFieldMasked(UAVObjHandle obj_handle, const void* dataIn, uint32_t offset, uint32_t size, uint16_t dirty);
+int32_t UAVObjSetInstanceDataFieldMasked(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn, uint32_t offset, uint32_t size, uint16_t dirty);
 int32_t UAVObjGetInstanceData(UAVObjHandle obj_handle, uint16_t instId, void* dataOut);
 int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, void* dataOut, uint32_t offset, uint32_t size);
 int32_t UAVObjSetMetadata(UAVObjHandle obj_handle, const UAVObjMetadata* dataIn);
@@ -203,18 +217,59 @@ int8_t UAVObjReadOnly(UAVObjHandle obj);
 int32_t UAVObjConnectQueue(UAVObjHandle obj_handle, struct pios_queue *queue, uint8_t eventMask);
 int32_t UAVObjDisconnectQueue(UAVObjHandle obj_handle, struct pios_queue *queue);
 int32_t UAVObjConnectQueueThrottled(UAVObjHandle obj_handle, struct pios_queue *queue, uint8_t eventMask, uint16_t interval);
+int32_t UAVObjConnectQueueCoalesced(UAVObjHandle obj_handle, struct pios_queue *queue, uint8_t eventMask);
+bool UAVObjQueueReceive(struct pios_queue *queue, UAVObjEvent *ev, uint32_t timeout_ms);
 int32_t UAVObjConnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb, void *cbCtx, uint8_t eventMask);
 int32_t UAVObjConnectCallbackThrottled(UAVObjHandle obj_handle, UAVObjEventCallback cb, void *cbCtx, uint8_t eventMask, uint16_t interval);
 int32_t UAVObjDisconnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb, void *cbCtx);
+int32_t UAVObjConnectCallbackDeferred(UAVObjHandle obj_handle, UAVObjEventCallback cb, void *cbCtx, uint8_t eventMask);
+int32_t UAVObjGetCallbackStats(UAVObjHandle obj_handle, UAVObjEventCallback cb, void *cbCtx, uint16_t *delivered, uint16_t *dropped);
+int32_t UAVObjGetQueueStats(UAVObjHandle obj_handle, struct pios_queue *queue, uint16_t *delivered, uint16_t *dropped);
 void UAVObjUpdated(UAVObjHandle obj);
 void UAVObjInstanceUpdated(UAVObjHandle obj_handle, uint16_t instId);
 void UAVObjIterate(void (*iterator)(UAVObjHandle obj));
 int32_t getEventMask(UAVObjHandle obj_handle, struct pios_queue *queue);
 uint8_t UAVObjCount();
 uint32_t UAVObjIDByIndex(uint8_t index);
+int32_t UAVObjGetIndex(UAVObjHandle obj_handle);
 void UAVObjCbSetFlag(UAVObjEvent *objEv, void *ctx, void *obj, int len);
 void UAVObjCbCopyData(UAVObjEvent *objEv, void *ctx, void *obj, int len);
 
+/**
+ * A copy of the first instance of an object, refreshed on every change by
+ * UAVObjConnectSnapshot, that one task at a time reads with no locking.
+ * Changes go into a spare copy which then becomes the latest, so the one
+ * being read is never written.
+ */
+struct uavo_snapshot {
+	void *buf[3];
+	volatile uint8_t latest;
+	volatile uint8_t held;		// the one the reader is on
+};
+
+int32_t UAVObjConnectSnapshot(UAVObjHandle obj_handle, struct uavo_snapshot *snap);
+
+/**
+ * Get the latest data of a snapshot.  It stays valid and unchanged until
+ * the next read of the same snapshot.
+ * \param[in] snap the snapshot
+ * \return the object data
+ */
+static inline const void *UAVObjSnapshotRead(struct uavo_snapshot *snap)
+{
+	uint8_t latest;
+
+	// If a change lands before the writer can see which copy we took,
+	// it may be writing that copy; take the new latest instead
+	do {
+		latest = snap->latest;
+		snap->held = latest;
+		__sync_synchronize();
+	} while (latest != snap->latest);
+
+	return snap->buf[latest];
+}
+
 #endif // UAVOBJECTMANAGER_H
 
 /**
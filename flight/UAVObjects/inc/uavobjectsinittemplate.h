@@ -34,6 +34,7 @@
 void UAVObjectsInitializeAll();
 
 #define UAVOBJECTS_LARGEST $(SIZECALCULATION)
+#define UAVOBJECTS_COUNT $(OBJCOUNT)
 
 #endif /* UAVOBJECTSINIT_H */
 
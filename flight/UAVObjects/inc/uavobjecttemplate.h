@@ -75,10 +75,14 @@ static inline int32_t $(NAME)InstSet(uint16_t instId, const $(NAME)Data *dataIn)
 
 static inline int32_t $(NAME)ConnectQueue(struct pios_queue *queue) { return UAVObjConnectQueue($(NAME)Handle(), queue, EV_MASK_ALL_UPDATES); }
 
+static inline int32_t $(NAME)ConnectQueueCoalesced(struct pios_queue *queue) { return UAVObjConnectQueueCoalesced($(NAME)Handle(), queue, EV_MASK_ALL_UPDATES); }
+
 static inline int32_t $(NAME)ConnectCallback(UAVObjEventCallback cb) { return UAVObjConnectCallback($(NAME)Handle(), cb, NULL, EV_MASK_ALL_UPDATES); }
 
 static inline int32_t $(NAME)ConnectCallbackCtx(UAVObjEventCallback cb, volatile void *ctx) { return UAVObjConnectCallback($(NAME)Handle(), cb, (void *)ctx, EV_MASK_ALL_UPDATES); }
 
+static inline int32_t $(NAME)ConnectCallbackDeferred(UAVObjEventCallback cb) { return UAVObjConnectCallbackDeferred($(NAME)Handle(), cb, NULL, EV_MASK_ALL_UPDATES); }
+
 static inline int32_t $(NAME)ConnectCopy(volatile $(NAME)Data *dataOut) {
 	/* Get the thing once for free first-- no changes */
 	$(NAME)Get((void *) dataOut);
@@ -86,6 +90,10 @@ static inline int32_t $(NAME)ConnectCopy(volatile $(NAME)Data *dataOut) {
 	return UAVObjConnectCallback($(NAME)Handle(), UAVObjCbCopyData, (void *)dataOut, EV_MASK_ALL_UPDATES);
 }
 
+static inline int32_t $(NAME)ConnectSnapshot(struct uavo_snapshot *snap) { return UAVObjConnectSnapshot($(NAME)Handle(), snap); }
+
+static inline const $(NAME)Data *$(NAME)SnapshotRead(struct uavo_snapshot *snap) { return (const $(NAME)Data *) UAVObjSnapshotRead(snap); }
+
 static inline uint16_t $(NAME)CreateInstance() { return UAVObjCreateInstance($(NAME)Handle(), &$(NAME)SetDefaults); }
 
 static inline void $(NAME)Updated() { UAVObjUpdated($(NAME)Handle()); }
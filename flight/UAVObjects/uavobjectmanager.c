@@ -41,6 +41,8 @@
 #include "pios_mutex.h"
 #include "pios_queue.h"
 #include "misc_math.h"
+#include "cpuaccount.h"
+#include "uavobjectsinit.h"	/* UAVOBJECTS_COUNT */
 
 extern uintptr_t pios_uavo_settings_fs_id;
 
@@ -67,6 +69,11 @@ struct ObjectEventEntry {
 	UAVObjEventCallback       cb;
 	uint8_t                   hasThrottle : 1;
 	uint8_t                   eventMask : 7;
+	uint8_t                   isDeferred : 1;
+	uint8_t                   isCoalesced : 1;
+	uint8_t                   isPending : 1;	// coalesced event not received yet
+	uint16_t                  delivered;	// events handed over, wraps
+	uint16_t                  dropped;	// events lost, wraps
 	struct ObjectEventEntry * next;
 };
 
@@ -80,11 +87,10 @@ struct ObjectEventEntryThrottled {
 /*
   MetaInstance   == [UAVOBase [UAVObjMetadata]]
   SingleInstance == [UAVOBase [UAVOData [InstanceData]]]
-  MultiInstance  == [UAVOBase [UAVOData [NumInstances [InstanceData0 [next]]]]
-                                                  ____________________/
-                                                  \-->[InstanceData1 [next]]
-                                                  _________...________/
-                                                  \-->[InstanceDataN [next]]
+  MultiInstance  == [UAVOBase [UAVOData [NumInstances [Table [InstanceData0]]]]
+                                                        |
+                              [&InstanceData0, ...] <---/
+                                               \----> [InstanceData1] ... [InstanceDataN]
  */
 
 /*
@@ -101,6 +107,8 @@ struct UAVOBase {
 		bool isMeta        : 1;
 		bool isSingle      : 1;
 		bool isSettings    : 1;
+		bool loadDeferred  : 1;	/* not read from flash yet */
+		bool savePending   : 1;	/* saved by UAVObjSaveDeferred(), not written yet */
 	} flags;
 
 } __attribute__((packed));
@@ -114,6 +122,11 @@ struct UAVOMeta {
 /* Shared data structure for all data-carrying UAVObjects (UAVOSingle and UAVOMulti) */
 struct UAVOData {
 	struct UAVOBase   base;
+	/*
+	 * Count of writes to the instance data, odd while one is in
+	 * progress.  Aligned so that it is read and written atomically.
+	 */
+	volatile uint32_t seq __attribute__((aligned(4)));
 	uint32_t          id;
 	/*
 	 * Embed the Meta object as another complete UAVO
@@ -135,28 +148,32 @@ struct UAVOSingle {
 	 */
 } __attribute__((packed));
 
-/* Part of a linked list of instances chained off of a multi instance UAVO. */
-struct UAVOMultiInst {
-	struct UAVOMultiInst * next;
-	uint8_t                instance[];
-	/* 
-	 * Additional space will be malloc'd here to hold the
-	 * the data for this instance.
-	 */
-} __attribute__((packed));
-
 /* Augmented type for Multi Instance Data UAVO */
 struct UAVOMulti {
 	struct UAVOData        uavo;
 
 	uint16_t               num_instances;
-	struct UAVOMultiInst   instance0;
+	uint16_t               table_size;
+	/*
+	 * The data of every instance, indexed by instance ID.  NULL until
+	 * a second instance is created.
+	 */
+	void                ** instances;
+
+	uint8_t                instance0[];
 	/*
 	 * Additional space will be malloc'd here to hold the
 	 * the data for instance 0.
 	 */
 } __attribute__((packed));
 
+/*
+ * First size of an instance table, it doubles from there.  The heap
+ * never frees, so the instance data is never moved: only the small
+ * pointer tables are left behind as they are outgrown.
+ */
+#define INSTANCE_TABLE_MIN_SIZE 4
+
 /** all information about a metaobject are hardcoded constants **/
 #define MetaNumBytes sizeof(UAVObjMetadata)
 
@@ -170,22 +187,80 @@ struct UAVOMulti {
 
 /** all information about instances are dependant on object type **/
 #define ObjSingleInstanceDataOffset(obj) ((void*)(&(( (struct UAVOSingle*)obj )->instance0)))
-#define InstanceDataOffset(inst) ((void*)&(( (struct UAVOMultiInst*)inst )->instance))
 #define InstanceData(instance) (void*)instance
 
+/*
+ * The instance data of data objects is read without taking the global
+ * mutex.  Writers still hold it, and keep the object's sequence count odd
+ * while they change any of its instances.  A reader copies the data
+ * between two reads of the same even count, and retries a torn copy.
+ */
+#define SEQLOCK_READ_RETRIES 4
+
+/*
+ * Number of events that may be pending in sendEvent at once, i.e. how
+ * deep a chain of callbacks updating other objects may go.
+ */
+#ifndef UAVO_PENDING_EVENTS
+#define UAVO_PENDING_EVENTS 3
+#endif
+
+/*
+ * Deferred callbacks are not run from the setter.  Their events are queued
+ * and a dedicated task runs them in batches, without holding the mutex.
+ */
+#ifndef UAVO_DEFERRED_QUEUE_LEN
+#define UAVO_DEFERRED_QUEUE_LEN 16
+#endif
+
+#ifndef UAVO_DEFERRED_TASK_STACK
+#define UAVO_DEFERRED_TASK_STACK 640
+#endif
+
+#ifndef UAVO_DEFERRED_TASK_PRIORITY
+#define UAVO_DEFERRED_TASK_PRIORITY PIOS_THREAD_PRIO_NORMAL
+#endif
+
+/* Options of connectObj */
+#define CONNECT_DEFERRED	(1 << 0)
+#define CONNECT_COALESCED	(1 << 1)
+
+struct DeferredEvent {
+	UAVObjEvent msg;
+	UAVObjEventCallback cb;
+	void *cbCtx;
+	bool hasData;
+};
+
 // Private functions
 static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
-			UAVObjEventType event, void *obj_data, int len);
+			UAVObjEventType event, uint16_t dirty,
+			void *obj_data, int len);
 static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId);
 static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId);
+static InstanceHandle peekInstance(struct UAVOData * obj, uint16_t instId);
+static void loadDeferred(struct UAVOData * obj);
+static void dataWriteBegin(UAVObjHandle obj_handle);
+static void dataWriteEnd(UAVObjHandle obj_handle);
+static bool readInstance(struct UAVOData * obj, uint16_t instId,
+			void *dataOut, uint32_t offset, uint32_t size);
+static int findIndex(uint32_t id);
+static bool saveSettingsNext(void *ctx, uint32_t *obj_id, uint16_t *obj_inst_id,
+			uint8_t **obj_data, uint16_t *obj_size);
 static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 			UAVObjEventCallback cb, void *cbCtx, uint8_t eventMask,
-			uint16_t interval);
+			uint16_t interval, uint8_t options);
+static struct ObjectEventEntry *findEvent(UAVObjHandle obj_handle,
+			struct pios_queue *queue, UAVObjEventCallback cb, void *cbCtx);
+static void deferredTask(void *parameters);
 static int32_t disconnectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 			UAVObjEventCallback cb, void *cbCtx);
 
 // Private variables
 static struct UAVOData * uavo_list;
+/* The registered objects sorted by ID, for lookups */
+static struct UAVOData * uavo_index[UAVOBJECTS_COUNT];
+static uint16_t uavo_index_len;
 static struct ObjectEventEntry * events_unused;
 static struct ObjectEventEntry * events_unused_throttled;
 static struct pios_recursive_mutex *mutex;
@@ -208,6 +283,11 @@ static new_uavo_instance_cb_t newUavObjInstanceCB;
 
 static void *cb_stack;
 
+static struct pios_queue *deferred_queue;
+static struct pios_thread *deferred_task;
+
+static volatile bool saves_pending;	// by UAVObjSaveDeferred()
+
 /**
  * Initialize the object manager
  * \return 0 Success
@@ -217,8 +297,12 @@ int32_t UAVObjInitialize()
 {
 	// Initialize variables
 	uavo_list = NULL;
+	uavo_index_len = 0;
 	events_unused = NULL;
 	events_unused_throttled = NULL;
+	deferred_queue = NULL;
+	deferred_task = NULL;
+	saves_pending = false;
 
 	// Allocate the stack used for callbacks.
 	cb_stack = PIOS_malloc_no_dma(UAVO_CB_STACK_SIZE);
@@ -295,6 +379,7 @@ static struct UAVOData * UAVObjAllocSingle(uint32_t num_bytes)
 	memset(uavo_base, 0, sizeof(*uavo_base));
 	uavo_base->flags.isSingle = true;
 	uavo_base->next_event     = NULL;
+	uavo_single->uavo.seq     = 0;
 
 	/* Clear the instance data carried in the UAVO */
 	memset(&(uavo_single->instance0), 0, num_bytes);
@@ -318,13 +403,15 @@ static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
 	memset(uavo_base, 0, sizeof(*uavo_base));
 	uavo_base->flags.isSingle = false;
 	uavo_base->next_event     = NULL;
+	uavo_multi->uavo.seq      = 0;
 
 	/* Set up the type-specific part of the UAVO */
 	uavo_multi->num_instances = 1;
+	uavo_multi->table_size    = 0;
+	uavo_multi->instances     = NULL;
 
 	/* Clear the instance data carried in the UAVO */
-	uavo_multi->instance0.next = NULL;
-	memset (&(uavo_multi->instance0.instance), 0, num_bytes);
+	memset (&(uavo_multi->instance0), 0, num_bytes);
 
 	/* Give back the generic UAVO part */
 	return (&(uavo_multi->uavo));
@@ -357,6 +444,10 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 	if (UAVObjGetByID(id))
 		goto unlock_exit;
 
+	/* Only the objects known to the generator fit in the index */
+	if (uavo_index_len >= UAVOBJECTS_COUNT)
+		goto unlock_exit;
+
 	/* Map the various flags to one of the UAVO types we understand */
 	if (isSingleInstance) {
 		uavo_data = UAVObjAllocSingle (num_bytes);
@@ -380,6 +471,13 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 	/* Add the newly created object to the global list of objects */
 	LL_APPEND(uavo_list, uavo_data);
 
+	/* And to the index, keeping it sorted */
+	int pos = findIndex(id);
+	memmove(&uavo_index[pos + 1], &uavo_index[pos],
+		(uavo_index_len - pos) * sizeof(uavo_index[0]));
+	uavo_index[pos] = uavo_data;
+	uavo_index_len++;
+
 	/* Initialize object fields and metadata to default values */
 	if (initCb)
 		initCb((UAVObjHandle) uavo_data, 0);
@@ -387,9 +485,12 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 	/* Always try to load the meta object from flash */
 	UAVObjLoad((UAVObjHandle) &(uavo_data->metaObj), 0);
 
-	/* Attempt to load settings object from flash */
+	/*
+	 * Load settings object from flash when it is first used, or when
+	 * the system loads the rest once all the modules are running
+	 */
 	if (uavo_data->base.flags.isSettings)
-		UAVObjLoad((UAVObjHandle) uavo_data, 0);
+		uavo_data->base.flags.loadDeferred = true;
 
 	// fire events for outer object and its embedded meta object
 	UAVObjInstanceUpdated((UAVObjHandle) uavo_data, 0);
@@ -412,20 +513,14 @@ UAVObjHandle UAVObjGetByID(uint32_t id)
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
-	// Look for object
-	struct UAVOData * tmp_obj;
-	LL_FOREACH(uavo_list, tmp_obj) {
-		if (tmp_obj->id == id) {
-			found_obj = &tmp_obj->base;
-			goto unlock_exit;
-		}
-		if (MetaObjectId(tmp_obj->id) == id) {
-			found_obj = &(tmp_obj->metaObj.base);
-			goto unlock_exit;
-		}
+	// Look for object, or for the object this is the metaobject of
+	int pos = findIndex(id);
+	if (pos < uavo_index_len && uavo_index[pos]->id == id) {
+		found_obj = &uavo_index[pos]->base;
+	} else if (pos > 0 && MetaObjectId(uavo_index[pos - 1]->id) == id) {
+		found_obj = &(uavo_index[pos - 1]->metaObj.base);
 	}
 
-unlock_exit:
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return found_obj;
 }
@@ -657,11 +752,13 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId,
 		len = obj->instance_size;
 	}
 
+	dataWriteBegin(obj_handle);
 	memcpy(target, dataIn, len);
+	dataWriteEnd(obj_handle);
 
 	// Fire event
 	sendEvent((struct UAVOBase*)obj_handle, instId, EV_UNPACKED,
-		target, len);
+		UAVOBJ_ALL_FIELDS_DIRTY, target, len);
 
 	rc = 0;
 
@@ -681,6 +778,14 @@ int32_t UAVObjPack(UAVObjHandle obj_handle, uint16_t instId, uint8_t * dataOut)
 {
 	PIOS_Assert(obj_handle);
 
+	if (!UAVObjIsMetaobject(obj_handle)) {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+		if (readInstance(obj, instId, dataOut, 0, obj->instance_size)) {
+			return 0;
+		}
+	}
+
 	// Lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
@@ -825,6 +930,10 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId)
 	void *target;
 	int len;
 
+	// Load what was saved last, even if it is not written yet
+	if (((struct UAVOBase *) obj_handle)->flags.savePending)
+		UAVObjFlushSaves();
+
 	if (UAVObjIsMetaobject(obj_handle)) {
 		if (instId != 0)
 			return -1;
@@ -833,7 +942,8 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId)
 		len = UAVObjGetNumBytes(obj_handle);
 	} else {
 
-		InstanceHandle instEntry = getInstance( (struct UAVOData *)obj_handle, instId);
+		// What is there is replaced anyway, don't load it first
+		InstanceHandle instEntry = peekInstance( (struct UAVOData *)obj_handle, instId);
 
 		if (instEntry == NULL)
 			return -1;
@@ -844,6 +954,10 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId)
 
 	// Load the object from the filesystem
 	int32_t rc;
+
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	dataWriteBegin(obj_handle);
+
 #if defined(PIOS_INCLUDE_FASTHEAP)
 	rc = PIOS_FLASHFS_ObjLoad(pios_uavo_settings_fs_id,
 			UAVObjGetID(obj_handle),
@@ -858,14 +972,24 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId)
 			len);
 #endif  /* PIOS_INCLUDE_FASTHEAP */
 
-	if (rc != 0)
-		return -1;
-
 #if defined(PIOS_INCLUDE_FASTHEAP)
-	memcpy(target, uavobj_load_trampoline, len);
+	if (rc == 0)
+		memcpy(target, uavobj_load_trampoline, len);
 #endif  /* PIOS_INCLUDE_FASTHEAP */
 
-	sendEvent((struct UAVOBase*)obj_handle, instId, EV_UNPACKED, target, len);
+	dataWriteEnd(obj_handle);
+
+	// Whether it was stored or not, this is what the object starts from
+	if (instId == 0)
+		((struct UAVOBase *) obj_handle)->flags.loadDeferred = false;
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
+
+	if (rc != 0)
+		return -1;
+
+	sendEvent((struct UAVOBase*)obj_handle, instId, EV_UNPACKED,
+		UAVOBJ_ALL_FIELDS_DIRTY, target, len);
 	return 0;
 }
 
@@ -877,43 +1001,193 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId)
  */
 int32_t UAVObjDeleteById(uint32_t obj_id, uint16_t inst_id)
 {
+	UAVObjHandle obj_handle = UAVObjGetByID(obj_id);
+
+	// A save still to be written would bring it back
+	if (obj_handle && inst_id == 0)
+		((struct UAVOBase *) obj_handle)->flags.savePending = false;
+
 	PIOS_FLASHFS_ObjDelete(pios_uavo_settings_fs_id, obj_id, inst_id);
 
 	return 0;
 }
 
+/**
+ * Hand the filesystem the next settings object to save.
+ * @param[in,out] ctx The list entry to continue from
+ * @return true if an object was filled in, false at the end of the list
+ */
+static bool saveSettingsNext(void *ctx, uint32_t *obj_id, uint16_t *obj_inst_id, uint8_t **obj_data, uint16_t *obj_size)
+{
+	struct UAVOData **next = (struct UAVOData **) ctx;
+
+	for (struct UAVOData *obj = *next; obj; obj = obj->next) {
+		if (!UAVObjIsSettings(&obj->base))
+			continue;
+
+		InstanceHandle instEntry = getInstance(obj, 0);
+
+		if (instEntry == NULL || InstanceData(instEntry) == NULL)
+			continue;
+
+		*next = obj->next;
+		*obj_id = UAVObjGetID(&obj->base);
+		*obj_inst_id = 0;
+		*obj_size = UAVObjGetNumBytes(&obj->base);
+
+		obj->base.flags.savePending = false;
+
+		// The previous object is saved by now, the buffer is free
+#if defined(PIOS_INCLUDE_FASTHEAP)
+		memcpy(uavobj_save_trampoline, InstanceData(instEntry), *obj_size);
+		*obj_data = uavobj_save_trampoline;
+#else /* PIOS_INCLUDE_FASTHEAP */
+		*obj_data = InstanceData(instEntry);
+#endif  /* PIOS_INCLUDE_FASTHEAP */
+
+		return true;
+	}
+
+	return false;
+}
+
 /**
  * Save all settings objects to the SD card.
+ * They are written in one flash transaction, skipping those that are
+ * stored already.
  * @return 0 if success or -1 if failure
  */
 int32_t UAVObjSaveSettings()
 {
-	struct UAVOData *obj;
-
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
-	int32_t rc = -1;
+	int32_t rc = 0;
 
-	// Save all settings objects
-	LL_FOREACH(uavo_list, obj) {
-		// Check if this is a settings object
-		if (UAVObjIsSettings(&obj->base)) {
-			// Save object
-			if (UAVObjSave(&obj->base, 0) ==
-				-1) {
-				goto unlock_exit;
-			}
-		}
+	struct UAVOData *next = uavo_list;
+	if (PIOS_FLASHFS_ObjSaveBatch(pios_uavo_settings_fs_id, saveSettingsNext, &next) != 0) {
+		rc = -1;
 	}
 
-	rc = 0;
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return rc;
+}
+
+/**
+ * Where UAVObjFlushSaves() is in the object list
+ */
+struct saveDeferredCtx {
+	struct UAVOData *next;
+	struct UAVOData *last;	// handed to the filesystem last
+};
+
+/**
+ * Hand the filesystem the next object with a save pending.
+ * @param[in,out] ctx The struct saveDeferredCtx to continue from
+ * @return true if an object was filled in, false at the end of the list
+ */
+static bool saveDeferredNext(void *ctx, uint32_t *obj_id, uint16_t *obj_inst_id, uint8_t **obj_data, uint16_t *obj_size)
+{
+	struct saveDeferredCtx *save = (struct saveDeferredCtx *) ctx;
+
+	for (struct UAVOData *obj = save->next; obj; obj = obj->next) {
+		if (!obj->base.flags.savePending)
+			continue;
+
+		InstanceHandle instEntry = getInstance(obj, 0);
+
+		if (instEntry == NULL || InstanceData(instEntry) == NULL)
+			continue;
+
+		save->next = obj->next;
+		save->last = obj;
+		*obj_id = UAVObjGetID(&obj->base);
+		*obj_inst_id = 0;
+		*obj_size = UAVObjGetNumBytes(&obj->base);
+
+		obj->base.flags.savePending = false;
+
+		// The previous object is saved by now, the buffer is free
+#if defined(PIOS_INCLUDE_FASTHEAP)
+		memcpy(uavobj_save_trampoline, InstanceData(instEntry), *obj_size);
+		*obj_data = uavobj_save_trampoline;
+#else /* PIOS_INCLUDE_FASTHEAP */
+		*obj_data = InstanceData(instEntry);
+#endif  /* PIOS_INCLUDE_FASTHEAP */
+
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * Save an object, but only mark it to be written by the next
+ * UAVObjFlushSaves().  Saving it again before then costs nothing, and
+ * what it holds when flushed is what gets written.  Metaobjects and
+ * instances other than the first are saved straight away.
+ * @param[in] obj The object handle.
+ * @param[in] instId The instance ID
+ * @return 0 if success or -1 if failure
+ */
+int32_t UAVObjSaveDeferred(UAVObjHandle obj_handle, uint16_t instId)
+{
+	PIOS_Assert(obj_handle);
+
+	if (UAVObjIsMetaobject(obj_handle) || instId != 0)
+		return UAVObjSave(obj_handle, instId);
+
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	((struct UAVOBase *) obj_handle)->flags.savePending = true;
+	saves_pending = true;
+	PIOS_Recursive_Mutex_Unlock(mutex);
+
+	return 0;
+}
+
+/**
+ * Write the saves left by UAVObjSaveDeferred(), all in one flash
+ * transaction.  Those stored as they are already are skipped.
+ * @return 0 if success or -1 if failure, when those not written yet
+ * stay pending
+ */
+int32_t UAVObjFlushSaves()
+{
+	if (!saves_pending)
+		return 0;
+
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	int32_t rc = 0;
+
+	struct saveDeferredCtx save = {
+		.next = uavo_list,
+		.last = NULL,
+	};
+
+	saves_pending = false;
+
+	if (PIOS_FLASHFS_ObjSaveBatch(pios_uavo_settings_fs_id, saveDeferredNext, &save) != 0) {
+		// The failed one, and those after it, are still to be written
+		if (save.last)
+			save.last->base.flags.savePending = true;
+
+		saves_pending = true;
+		rc = -1;
+	}
 
-unlock_exit:
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return rc;
 }
 
+/**
+ * Whether UAVObjSaveDeferred() left anything to write
+ */
+bool UAVObjSavesPending()
+{
+	return saves_pending;
+}
+
 /**
  * Load all settings objects from the SD card.
  * @return 0 if success or -1 if failure
@@ -946,6 +1220,26 @@ unlock_exit:
 	return rc;
 }
 
+/**
+ * Load the settings objects that haven't been used since boot, and so
+ * weren't loaded yet.
+ * @return 0 if success or -1 if failure
+ */
+int32_t UAVObjLoadDeferredSettings()
+{
+	struct UAVOData *obj;
+
+	// Get lock
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	LL_FOREACH(uavo_list, obj) {
+		loadDeferred(obj);
+	}
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return 0;
+}
+
 /**
  * Delete all settings objects from the SD card.
  * @return 0 if success or -1 if failure
@@ -1087,6 +1381,18 @@ int32_t UAVObjSetDataField(UAVObjHandle obj_handle, const void* dataIn, uint32_t
 	return UAVObjSetInstanceDataField(obj_handle, 0, dataIn, offset, size);
 }
 
+/**
+ * Set part of the object data, telling which fields it holds
+ * \param[in] obj The object handle
+ * \param[in] dataIn The new data of the fields
+ * \param[in] dirty The fields written, see UAVOBJ_FIELD_DIRTY()
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjSetDataFieldMasked(UAVObjHandle obj_handle, const void* dataIn, uint32_t offset, uint32_t size, uint16_t dirty)
+{
+	return UAVObjSetInstanceDataFieldMasked(obj_handle, 0, dataIn, offset, size, dirty);
+}
+
 /**
  * Get the object data
  * \param[in] obj The object handle
@@ -1133,6 +1439,22 @@ int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
  * \return 0 if success or -1 if failure
  */
 int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn, uint32_t offset, uint32_t size)
+{
+	return UAVObjSetInstanceDataFieldMasked(obj_handle, instId, dataIn,
+		offset, size, UAVOBJ_ALL_FIELDS_DIRTY);
+}
+
+/**
+ * Set part of the data of a specific object instance.  The EV_UPDATED event
+ * always fires, and carries the fields written as its dirty mask, or no
+ * fields at all if the data did not actually change.
+ * \param[in] obj The object handle
+ * \param[in] instId The object instance ID
+ * \param[in] dataIn The new data of the fields
+ * \param[in] dirty The fields written, see UAVOBJ_FIELD_DIRTY()
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjSetInstanceDataFieldMasked(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn, uint32_t offset, uint32_t size, uint16_t dirty)
 {
 	PIOS_Assert(obj_handle);
 
@@ -1186,11 +1508,17 @@ int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, con
 		goto unlock_exit;
 	}
 
-	// Set data
-	memcpy(target + offset, dataIn, size);
+	// Set data, if it changes anything
+	if (memcmp(target + offset, dataIn, size)) {
+		dataWriteBegin(obj_handle);
+		memcpy(target + offset, dataIn, size);
+		dataWriteEnd(obj_handle);
+	} else {
+		dirty = 0;
+	}
 
 	// Fire event
-	sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED,
+	sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED, dirty,
 		target, obj_len);
 	rc = 0;
 
@@ -1211,6 +1539,14 @@ int32_t UAVObjGetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
 {
 	PIOS_Assert(obj_handle);
 
+	if (!UAVObjIsMetaobject(obj_handle)) {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+		if (readInstance(obj, instId, dataOut, 0, obj->instance_size)) {
+			return 0;
+		}
+	}
+
 	// Lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
@@ -1257,6 +1593,15 @@ int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, voi
 {
 	PIOS_Assert(obj_handle);
 
+	if (!UAVObjIsMetaobject(obj_handle)) {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+		if (((size + offset) <= obj->instance_size) &&
+				readInstance(obj, instId, dataOut, offset, size)) {
+			return 0;
+		}
+	}
+
 	// Lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
@@ -1514,7 +1859,7 @@ int32_t UAVObjConnectQueueThrottled(UAVObjHandle obj_handle,
 	PIOS_Assert(queue);
 	int32_t res;
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-	res = connectObj(obj_handle, queue, NULL, NULL, eventMask, interval);
+	res = connectObj(obj_handle, queue, NULL, NULL, eventMask, interval, 0);
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return res;
 }
@@ -1524,6 +1869,57 @@ int32_t UAVObjConnectQueue(UAVObjHandle obj_handle, struct pios_queue *queue,
 	return UAVObjConnectQueueThrottled(obj_handle, queue, eventMask, 0);
 }
 
+/**
+ * Connect an event queue to the object, coalescing its events.  After an
+ * event was sent to the queue, the following ones are discarded until the
+ * consumer received it, so the queue never holds more than one event of the
+ * object and the consumer finds the latest data when it reads it.  The
+ * consumer must receive with UAVObjQueueReceive() for this to work.
+ * \param[in] obj The object handle
+ * \param[in] queue The event queue
+ * \param[in] eventMask The event mask, if EV_MASK_ALL_UPDATES then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjConnectQueueCoalesced(UAVObjHandle obj_handle,
+		struct pios_queue *queue, uint8_t eventMask)
+{
+	PIOS_Assert(obj_handle);
+	PIOS_Assert(queue);
+	int32_t res;
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	res = connectObj(obj_handle, queue, NULL, NULL, eventMask, 0, CONNECT_COALESCED);
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return res;
+}
+
+/**
+ * Receive an event from a queue connected to objects.  Required for
+ * coalesced connections, as it lets the next event of the object through,
+ * and equivalent to PIOS_Queue_Receive() for the others.
+ * \param[in] queue The event queue
+ * \param[out] ev The received event
+ * \param[in] timeout_ms Time to wait for an event
+ * \return true if an event was received
+ */
+bool UAVObjQueueReceive(struct pios_queue *queue, UAVObjEvent *ev,
+		uint32_t timeout_ms)
+{
+	PIOS_Assert(queue);
+
+	if (PIOS_Queue_Receive(queue, ev, timeout_ms) != true) {
+		return false;
+	}
+
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	struct ObjectEventEntry *event = findEvent(ev->obj, queue, NULL, NULL);
+	if (event) {
+		event->isPending = 0;
+	}
+	PIOS_Recursive_Mutex_Unlock(mutex);
+
+	return true;
+}
+
 
 /**
  * Disconnect an event queue from the object.
@@ -1577,6 +1973,77 @@ void UAVObjCbCopyData(UAVObjEvent *objEv, void *ctx, void *obj, int len) {
 	memcpy(ctx, obj, len);
 }
 
+/**
+ * Refreshes a snapshot with the passed in object.
+ * Conforms to the UAVObjConnectCallback* signature; connected by
+ * UAVObjConnectSnapshot.
+ *
+ * \param[in] ctx The snapshot.
+ * \param[in] obj The pointer to the raw object data.
+ * \param[in] len The length of data to copy.
+ */
+static void UAVObjCbSnapshot(UAVObjEvent *objEv, void *ctx, void *obj, int len) {
+	struct uavo_snapshot *snap = ctx;
+
+	if (!obj || objEv->instId != 0) {
+		return;
+	}
+
+	// Neither the latest nor the one the reader is on
+	uint8_t next = 0;
+	while (next == snap->latest || next == snap->held) {
+		next++;
+	}
+
+	memcpy(snap->buf[next], obj, len);
+
+	__sync_synchronize();
+
+	snap->latest = next;
+}
+
+/**
+ * Keep a snapshot of an object, for a task to read cheaply every loop with
+ * UAVObjSnapshotRead instead of getting the object when a flag says it
+ * changed.  Only the first instance is kept.  Callers should use the
+ * wrapper in the individual UAV objects.
+ * \param[in] obj_handle The object handle
+ * \param[out] snap The snapshot, which must live as long as the object
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjConnectSnapshot(UAVObjHandle obj_handle, struct uavo_snapshot *snap)
+{
+	PIOS_Assert(obj_handle);
+
+	uint32_t len = UAVObjGetNumBytes(obj_handle);
+	uint8_t *buf = PIOS_malloc_no_dma(3 * len);
+
+	if (!buf) {
+		return -1;
+	}
+
+	for (int i = 0; i < 3; i++) {
+		snap->buf[i] = buf + i * len;
+	}
+
+	snap->latest = 0;
+	snap->held = 0;
+
+	// Held across both so that no change is missed between them
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	int32_t res = UAVObjGetData(obj_handle, snap->buf[0]);
+
+	if (!res) {
+		res = UAVObjConnectCallback(obj_handle, UAVObjCbSnapshot, snap,
+				EV_MASK_ALL_UPDATES);
+	}
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
+
+	return res;
+}
+
 /**
  * Connect an event callback to the object, if the callback is already connected then the event mask is only updated.
  * The supplied callback will be invoked on all events matching the event mask.
@@ -1592,7 +2059,7 @@ int32_t UAVObjConnectCallbackThrottled(UAVObjHandle obj_handle, UAVObjEventCallb
 	PIOS_Assert(obj_handle);
 	int32_t res;
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-	res = connectObj(obj_handle, 0, cb, cbCtx, eventMask, interval);
+	res = connectObj(obj_handle, 0, cb, cbCtx, eventMask, interval, 0);
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return res;
 }
@@ -1603,6 +2070,30 @@ int32_t UAVObjConnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb,
 	return UAVObjConnectCallbackThrottled(obj_handle, cb, cbCtx, eventMask, 0);
 }
 
+/**
+ * Connect an event callback that is run from the UAVObject event task
+ * instead of from the context updating the object.  The update only
+ * queues the event, so its cost does not depend on the callback, and the
+ * callback may take longer and block.  It is passed the latest data of
+ * the instance, which may be newer than the update that triggered the
+ * event.  Events are dropped (and counted) when the queue is full.
+ * \param[in] obj The object handle
+ * \param[in] cb The event callback
+ * \param[in] eventMask The event mask, if EV_MASK_ALL_UPDATES then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjConnectCallbackDeferred(UAVObjHandle obj_handle, UAVObjEventCallback cb,
+			void *cbCtx, uint8_t eventMask)
+{
+	PIOS_Assert(obj_handle);
+	PIOS_Assert(cb);
+	int32_t res;
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	res = connectObj(obj_handle, 0, cb, cbCtx, eventMask, 0, CONNECT_DEFERRED);
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return res;
+}
+
 /**
  * Disconnect an event callback from the object.
  * \param[in] obj The object handle
@@ -1620,6 +2111,55 @@ int32_t UAVObjDisconnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb
 	return res;
 }
 
+/**
+ * Get the delivery counters of an event callback.  Both wrap around.
+ * \param[in] obj The object handle
+ * \param[in] cb The event callback
+ * \param[out] delivered Number of events passed to the callback (or queued for it)
+ * \param[out] dropped Number of events lost because the deferred queue was full
+ * \return 0 if success or -1 if the callback is not connected
+ */
+int32_t UAVObjGetCallbackStats(UAVObjHandle obj_handle, UAVObjEventCallback cb,
+		void *cbCtx, uint16_t *delivered, uint16_t *dropped)
+{
+	PIOS_Assert(obj_handle);
+	int32_t rc = -1;
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	struct ObjectEventEntry *event = findEvent(obj_handle, 0, cb, cbCtx);
+	if (event) {
+		*delivered = event->delivered;
+		*dropped = event->dropped;
+		rc = 0;
+	}
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return rc;
+}
+
+/**
+ * Get the delivery counters of an event queue.  Both wrap around.
+ * \param[in] obj The object handle
+ * \param[in] queue The event queue
+ * \param[out] delivered Number of events sent to the queue
+ * \param[out] dropped Number of events lost because the queue was full
+ * \return 0 if success or -1 if the queue is not connected
+ */
+int32_t UAVObjGetQueueStats(UAVObjHandle obj_handle, struct pios_queue *queue,
+		uint16_t *delivered, uint16_t *dropped)
+{
+	PIOS_Assert(obj_handle);
+	PIOS_Assert(queue);
+	int32_t rc = -1;
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	struct ObjectEventEntry *event = findEvent(obj_handle, queue, NULL, NULL);
+	if (event) {
+		*delivered = event->delivered;
+		*dropped = event->dropped;
+		rc = 0;
+	}
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return rc;
+}
+
 /**
  * Send the object's data to the GCS (triggers a EV_UPDATED_MANUAL event on this object).
  * \param[in] obj The object handle
@@ -1639,7 +2179,7 @@ void UAVObjInstanceUpdated(UAVObjHandle obj_handle, uint16_t instId)
 	PIOS_Assert(obj_handle);
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 	sendEvent((struct UAVOBase *) obj_handle, instId, EV_UPDATED_MANUAL,
-		NULL, 0);
+		UAVOBJ_ALL_FIELDS_DIRTY, NULL, 0);
 	PIOS_Recursive_Mutex_Unlock(mutex);
 }
 
@@ -1739,15 +2279,45 @@ static int32_t pumpOneEvent(UAVObjEvent msg, void *obj_data, int len) {
 			}
 
 			// Invoke callback (from event task) if a valid one is registered
-			if (event->cb) {
+			if (event->cb && event->isDeferred) {
+				// leave it to the deferred task; will not block
+				struct DeferredEvent deferred = {
+					.msg = msg,
+					.cb = event->cb,
+					.cbCtx = event->cbInfo.cbCtx,
+					.hasData = obj_data != NULL,
+				};
+
+				if (PIOS_Queue_Send(deferred_queue, &deferred, 0) != true) {
+					event->dropped++;
+					stats.lastCallbackErrorID = UAVObjGetID(msg.obj);
+					++stats.eventCallbackErrors;
+				} else {
+					event->delivered++;
+				}
+			} else if (event->cb) {
 				// invoke callback directly; callbacks must be well behaved
+				struct cpuaccount_mark mark;
+
+				event->delivered++;
+				cpuaccount_begin(&mark);
 				invokeCallback(event, &msg, obj_data, len);
+				cpuaccount_callback(event->cb, &mark);
 			} else if (event->cbInfo.queue) {
+				if (event->isPending) {
+					// the consumer has yet to see the last one
+					continue;
+				}
+
 				// Send to queue if a valid queue is registered
 				// will not block
 				if (PIOS_Queue_Send(event->cbInfo.queue, &msg, 0) != true) {
+					event->dropped++;
 					stats.lastQueueErrorID = UAVObjGetID(msg.obj);
 					++stats.eventQueueErrors;
+				} else {
+					event->delivered++;
+					event->isPending = event->isCoalesced;
 				}
 			}
 
@@ -1761,7 +2331,7 @@ static int32_t pumpOneEvent(UAVObjEvent msg, void *obj_data, int len) {
  * Send a triggered event to all event queues registered on the object.
  */
 static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
-			UAVObjEventType triggered_event,
+			UAVObjEventType triggered_event, uint16_t dirty,
 			void *obj_data, int len)
 {
 	static uint8_t num_pending = 0;
@@ -1770,7 +2340,7 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 		UAVObjEvent msg;
 		void *obj_data;
 		int len;
-	} pending_events[3];
+	} pending_events[UAVO_PENDING_EVENTS];
 
 	/* The logic to spool up callbacks here may be a little confusing.
 	 * basically, this relies on the fact that we are in a re-entrant
@@ -1794,7 +2364,7 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 	 * trigger callback B which triggers callback A.  Don't do that.
 	 */
 
-	if (num_pending >= 3) {
+	if (num_pending >= UAVO_PENDING_EVENTS) {
 		/* Unable to pump event; backlog too long */
 		stats.eventCallbackErrors++;
 		stats.lastCallbackErrorID = UAVObjGetID(obj);
@@ -1815,7 +2385,8 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 	pending_events[num_pending].msg = (UAVObjEvent) {
 		.obj    = obj,
 		.event  = triggered_event,
-		.instId = instId
+		.instId = instId,
+		.dirty  = dirty
 	};
 
 	pending_events[num_pending].obj_data = obj_data;
@@ -1846,12 +2417,46 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 	return 0;
 }
 
+/**
+ * Runs the deferred callbacks.  Whatever queued up while the previous
+ * batch ran is drained without going back to sleep.
+ */
+static void deferredTask(void *parameters)
+{
+	static uint8_t obj_data[UAVOBJECTS_LARGEST] __attribute__((aligned(4)));
+	struct DeferredEvent deferred;
+
+	while (1) {
+		if (PIOS_Queue_Receive(deferred_queue, &deferred, PIOS_QUEUE_TIMEOUT_MAX) != true) {
+			continue;
+		}
+
+		do {
+			void *data = NULL;
+			int len = 0;
+
+			if (deferred.hasData &&
+					UAVObjGetInstanceData(deferred.msg.obj, deferred.msg.instId, obj_data) == 0) {
+				data = obj_data;
+				len = UAVObjGetNumBytes(deferred.msg.obj);
+			}
+
+			struct cpuaccount_mark mark;
+
+			cpuaccount_begin(&mark);
+			deferred.cb(&deferred.msg, deferred.cbCtx, data, len);
+			cpuaccount_callback(deferred.cb, &mark);
+		} while (PIOS_Queue_Receive(deferred_queue, &deferred, 0) == true);
+	}
+}
+
 /**
  * Create a new object instance, return the instance info or NULL if failure.
  */
 static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 {
-	struct UAVOMultiInst *instEntry;
+	struct UAVOMulti *uavo_multi = (struct UAVOMulti *) obj;
+	void *instEntry;
 
 	/* Don't allow more than one instance for single instance objects */
 	if (UAVObjIsSingleInstance(&(obj->base))) {
@@ -1876,14 +2481,37 @@ static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 		}
 	}
 
+	/* Grow the instance table if it is full */
+	if (instId >= uavo_multi->table_size) {
+		uint16_t table_size = MAX(uavo_multi->table_size * 2,
+				INSTANCE_TABLE_MIN_SIZE);
+		void **table = PIOS_malloc_no_dma(table_size * sizeof(*table));
+		if (!table)
+			return NULL;
+
+		if (uavo_multi->instances) {
+			memcpy(table, uavo_multi->instances,
+				uavo_multi->num_instances * sizeof(*table));
+		} else {
+			table[0] = &(uavo_multi->instance0);
+		}
+
+		/* Lockless readers may still be using the old table, it stays valid */
+		__sync_synchronize();
+		uavo_multi->instances = table;
+		uavo_multi->table_size = table_size;
+	}
+
 	/* Create the actual instance */
-	instEntry = (struct UAVOMultiInst *) PIOS_malloc_no_dma(sizeof(struct UAVOMultiInst)+obj->instance_size);
+	instEntry = PIOS_malloc_no_dma(obj->instance_size);
 	if (!instEntry)
 		return NULL;
-	memset(InstanceDataOffset(instEntry), 0, obj->instance_size);
-	LL_APPEND(( (struct UAVOMulti*)obj )->instance0.next, instEntry);
+	memset(instEntry, 0, obj->instance_size);
+	uavo_multi->instances[instId] = instEntry;
 
-	( (struct UAVOMulti*)obj )->num_instances++;
+	/* Lockless readers must find the entry in the table once it is counted */
+	__sync_synchronize();
+	uavo_multi->num_instances++;
 
 	// Fire event
 	UAVObjInstanceUpdated((UAVObjHandle) obj, instId);
@@ -1892,13 +2520,41 @@ static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 	if (newUavObjInstanceCB) {
 		newUavObjInstanceCB(obj->id, UAVObjGetNumInstances(&obj->base));
 	}
-	return InstanceDataOffset(instEntry);
+	return instEntry;
 }
 
 /**
- * Get the instance information or NULL if the instance does not exist
+ * Get an instance, loading a settings object from flash first if that was
+ * deferred.  Not to be called on uninitialized objects.
  */
 static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId)
+{
+	if (obj->base.flags.loadDeferred)
+		loadDeferred(obj);
+
+	return peekInstance(obj, instId);
+}
+
+/**
+ * Load a settings object whose load was deferred at registration, unless
+ * another task just did
+ */
+static void loadDeferred(struct UAVOData * obj)
+{
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	// Clears the flag, even if nothing was stored
+	if (obj->base.flags.loadDeferred)
+		UAVObjLoad((UAVObjHandle) obj, 0);
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
+}
+
+/**
+ * Get an instance as it is, without loading it, or NULL if the instance
+ * does not exist
+ */
+static InstanceHandle peekInstance(struct UAVOData * obj, uint16_t instId)
 {
 	if (UAVObjIsMetaobject(&obj->base)) {
 		/* Metadata Instance */
@@ -1926,18 +2582,92 @@ static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId)
 		if (instId >= uavo_multi->num_instances)
 			return NULL;
 
-		// Look for specified instance ID
-		uint16_t instance = 0;
-		struct UAVOMultiInst *instEntry;
-		LL_FOREACH(&(uavo_multi->instance0), instEntry) {
-			if (instance++ == instId) {
-				/* Found it */
-				return &(instEntry->instance);
-			}
-		}
-		/* Instance was not found */
-		return NULL;
+		if (instId == 0)
+			return (&(uavo_multi->instance0));
+
+		/* Read the count before the table, see createInstance() */
+		__sync_synchronize();
+
+		return uavo_multi->instances[instId];
+	}
+}
+
+/**
+ * Binary search of the object index, must be called with the mutex held
+ * \return The position of the first object with an ID not below id, which
+ * is where an object with that ID is or would be inserted
+ */
+static int findIndex(uint32_t id)
+{
+	int low = 0;
+	int high = uavo_index_len;
+
+	while (low < high) {
+		int mid = (low + high) / 2;
+
+		if (uavo_index[mid]->id < id)
+			low = mid + 1;
+		else
+			high = mid;
 	}
+
+	return low;
+}
+
+/**
+ * Mark the start of a write to the instance data of an object.  Must be
+ * called with the mutex held, metaobjects are only ever read under it.
+ */
+static void dataWriteBegin(UAVObjHandle obj_handle)
+{
+	if (UAVObjIsMetaobject(obj_handle))
+		return;
+
+	((struct UAVOData *) obj_handle)->seq++;
+	__sync_synchronize();
+}
+
+/**
+ * Mark the end of a write started with dataWriteBegin()
+ */
+static void dataWriteEnd(UAVObjHandle obj_handle)
+{
+	if (UAVObjIsMetaobject(obj_handle))
+		return;
+
+	__sync_synchronize();
+	((struct UAVOData *) obj_handle)->seq++;
+}
+
+/**
+ * Copy part of an instance without taking the mutex
+ * \return true if a consistent copy was made.  If not (a write is in
+ * progress, or the instance doesn't exist) the caller must read under the
+ * mutex; spinning here could starve a preempted lower priority writer.
+ */
+static bool readInstance(struct UAVOData * obj, uint16_t instId,
+		void *dataOut, uint32_t offset, uint32_t size)
+{
+	for (int i = 0; i < SEQLOCK_READ_RETRIES; i++) {
+		uint32_t seq = obj->seq;
+		if (seq & 1)
+			return false;
+
+		__sync_synchronize();
+
+		InstanceHandle instEntry = getInstance(obj, instId);
+		if (instEntry == NULL)
+			return false;
+
+		memcpy(dataOut, InstanceData(instEntry) + offset, size);
+
+		__sync_synchronize();
+
+		if (obj->seq == seq)
+			return true;
+	}
+
+	return false;
 }
 
 /**
@@ -1947,16 +2677,35 @@ static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId)
  * \param[in] cb The event callback
  * \param[in] eventMask The event mask, if EV_MASK_ALL_UPDATES then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
  * \param[in] interval The interval at which to throttle updates; 0 is unthrottled
+ * \param[in] options CONNECT_DEFERRED and/or CONNECT_COALESCED
  * \return 0 if success or -1 if failure
  */
 static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 			UAVObjEventCallback cb, void *cbCtx, uint8_t eventMask,
-			uint16_t interval)
+			uint16_t interval, uint8_t options)
 {
+	bool deferred = (options & CONNECT_DEFERRED) != 0;
+	bool coalesced = (options & CONNECT_COALESCED) != 0;
+
 	if (queue && cb) {
 		return -1;
 	}
 
+	// The deferred task is only started once something needs it
+	if (deferred && deferred_task == NULL) {
+		deferred_queue = PIOS_Queue_Create(UAVO_DEFERRED_QUEUE_LEN,
+				sizeof(struct DeferredEvent));
+		if (deferred_queue == NULL) {
+			return -1;
+		}
+
+		deferred_task = PIOS_Thread_Create(deferredTask, "uavoevents",
+				UAVO_DEFERRED_TASK_STACK, NULL, UAVO_DEFERRED_TASK_PRIORITY);
+		if (deferred_task == NULL) {
+			return -1;
+		}
+	}
+
 	struct ObjectEventEntry *event;
 	struct ObjectEventEntryThrottled *throttled;
 	struct UAVOBase *obj;
@@ -1968,6 +2717,9 @@ static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 				((!event->cb) && event->cbInfo.queue == queue)) {
 			// Already connected, update event mask and throttling (if possible)
 			event->eventMask = eventMask;
+			event->isDeferred = deferred;
+			event->isCoalesced = coalesced;
+			event->isPending = 0;
 			if (event->hasThrottle) {
 				if (interval == 0) {
 					event->hasThrottle = 0;
@@ -2027,6 +2779,8 @@ static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 
 	event->eventMask = eventMask;
 	event->hasThrottle = 0;
+	event->isDeferred = deferred;
+	event->isCoalesced = coalesced;
 
 	if (interval) {
 		event->hasThrottle = 1;
@@ -2042,6 +2796,29 @@ static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 	return 0;
 }
 
+/**
+ * Find the entry of an event queue or callback connected to the object
+ * \param[in] obj The object handle
+ * \param[in] queue The event queue
+ * \param[in] cb The event callback
+ * \return the entry or NULL if not connected
+ */
+static struct ObjectEventEntry *findEvent(UAVObjHandle obj_handle,
+			struct pios_queue *queue, UAVObjEventCallback cb, void *cbCtx)
+{
+	struct ObjectEventEntry *event;
+	struct UAVOBase *obj = (struct UAVOBase *) obj_handle;
+
+	LL_FOREACH(obj->next_event, event) {
+		if ((event->cb == cb && event->cbInfo.cbCtx == cbCtx) ||
+				((!event->cb) && event->cbInfo.queue == queue)) {
+			return event;
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * Disconnect an event queue from the object
  * \param[in] obj The object handle
@@ -2111,19 +2888,33 @@ int32_t getEventMask(UAVObjHandle obj_handle, struct pios_queue *queue)
  */
 uint8_t UAVObjCount()
 {
-	uint8_t count = 0;
+	return uavo_index_len;
+}
+
+/**
+ * UAVObjGetIndex returns the index of an object, the reverse of UAVObjIDByIndex
+ * \return the index or -1 for metaobjects
+ */
+int32_t UAVObjGetIndex(UAVObjHandle obj_handle)
+{
+	PIOS_Assert(obj_handle);
+
+	if (UAVObjIsMetaobject(obj_handle)) {
+		return -1;
+	}
+
+	uint32_t id = ((struct UAVOData *) obj_handle)->id;
+	int32_t index = -1;
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
-	// Look for object
-	struct UAVOData * tmp_obj;
-	LL_FOREACH(uavo_list, tmp_obj) {
-		++count;
-	}
+	int pos = findIndex(id);
+	if (pos < uavo_index_len && uavo_index[pos]->id == id)
+		index = pos;
 
 	// Release lock
 	PIOS_Recursive_Mutex_Unlock(mutex);
-	return count;
+	return index;
 }
 
 /**
@@ -2132,25 +2923,17 @@ uint8_t UAVObjCount()
  */
 uint32_t UAVObjIDByIndex(uint8_t index)
 {
-	uint8_t count = 0;
+	uint32_t id = 0;
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
-	// Look for object
-	struct UAVOData * tmp_obj;
-	LL_FOREACH(uavo_list, tmp_obj) {
-		if (count == index)
-		{
-			// Release lock
-			PIOS_Recursive_Mutex_Unlock(mutex);
-			return tmp_obj->id;
-		}
-		++count;
-	}
+	// The index is in ID order, that is as good as any for enumerating
+	if (index < uavo_index_len)
+		id = uavo_index[index]->id;
 
 	// Release lock
 	PIOS_Recursive_Mutex_Unlock(mutex);
-	return 0;
+	return id;
 }
 
 /**
@@ -32,6 +32,10 @@
 
 // Public types
 typedef int32_t (*UAVTalkOutputStream)(uint8_t* data, int32_t length);
+//! Optional, lets packets be built in the output buffer: NULL if no room
+typedef uint8_t *(*UAVTalkReserveStream)(int32_t length);
+//! Sends what was built in the reserved buffer, 0 to cancel
+typedef int32_t (*UAVTalkCommitStream)(int32_t length);
 
 //! Tracking statistics for a UAVTalk connection
 typedef struct {
@@ -54,12 +58,18 @@ typedef enum {UAVTALK_STATE_ERROR = 0, UAVTALK_STATE_SYNC, UAVTALK_STATE_TYPE, U
 UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream);
 int32_t UAVTalkSetOutputStream(UAVTalkConnection connection, UAVTalkOutputStream outputStream);
 UAVTalkOutputStream UAVTalkGetOutputStream(UAVTalkConnection connection);
+int32_t UAVTalkSetReserveStream(UAVTalkConnection connectionHandle, UAVTalkReserveStream reserve, UAVTalkCommitStream commit);
 int32_t UAVTalkSendObject(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, uint8_t acked, int32_t timeoutMs);
 int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, uint8_t acked, int32_t timeoutMs);
+int32_t UAVTalkSendObjectData(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, uint32_t timestamp, const uint8_t *data);
 int32_t UAVTalkSendObjectRequest(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, int32_t timeoutMs);
 int32_t UAVTalkSendAck(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId);
 int32_t UAVTalkSendNack(UAVTalkConnection connectionHandle, uint32_t objId);
 int32_t UAVTalkSendBuf(UAVTalkConnection connectionHandle, uint8_t *buf, uint16_t len);
+int32_t UAVTalkAllowBundles(UAVTalkConnection connectionHandle);
+int32_t UAVTalkAllowDeltas(UAVTalkConnection connectionHandle);
+void UAVTalkStopBundles(UAVTalkConnection connectionHandle);
+int32_t UAVTalkFlush(UAVTalkConnection connectionHandle);
 UAVTalkRxState UAVTalkProcessInputStream(UAVTalkConnection connection, uint8_t rxbyte);
 UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connection, uint8_t rxbyte);
 UAVTalkRxState UAVTalkRelayInputStream(UAVTalkConnection connectionHandle, uint8_t rxbyte);
@@ -62,6 +62,16 @@ typedef uint8_t uavtalk_checksum;
 #define UAVTALK_MIN_PACKET_LENGTH       UAVTALK_MAX_HEADER_LENGTH + UAVTALK_CHECKSUM_LENGTH
 #define UAVTALK_MAX_PACKET_LENGTH       UAVTALK_MIN_PACKET_LENGTH + UAVTALK_MAX_PAYLOAD_LENGTH
 
+#ifndef UAVTALK_DELTA_SLOTS
+#define UAVTALK_DELTA_SLOTS       4	// objects sent as deltas
+#endif
+#ifndef UAVTALK_DELTA_MAX_LENGTH
+#define UAVTALK_DELTA_MAX_LENGTH  48	// larger objects are always sent in full
+#endif
+#ifndef UAVTALK_DELTA_KEYFRAME
+#define UAVTALK_DELTA_KEYFRAME    20	// deltas between full updates
+#endif
+
 //! State information for the UAVTalk parser
 typedef struct {
 	UAVObjHandle obj;
@@ -79,10 +89,21 @@ typedef struct {
 	uint16_t rxPacketLength;
 } UAVTalkInputProcessor;
 
+//! An update sent in full, that later ones are sent as deltas against
+typedef struct {
+	uint32_t objId;			// 0 while the slot is free
+	uint16_t instId;
+	uint8_t crc;			// of data, lets the other end check it has it
+	uint8_t deltas;			// sent since data was
+	uint8_t data[UAVTALK_DELTA_MAX_LENGTH];
+} UAVTalkDeltaRef;
+
 //! Information for the physical link
 typedef struct {
 	uint8_t canari;
 	UAVTalkOutputStream outStream;
+	UAVTalkReserveStream outReserve;
+	UAVTalkCommitStream outCommit;
 	struct pios_recursive_mutex *lock;
 	struct pios_recursive_mutex *transLock;
 	struct pios_semaphore *respSema;
@@ -93,6 +114,15 @@ typedef struct {
 	uint8_t *rxBuffer;
 	uint32_t txSize;
 	uint8_t *txBuffer;
+	uint8_t *bundleBuffer;		// NULL unless bundles are allowed
+	uint16_t bundleLength;		// payload held back in bundleBuffer
+	uint16_t bundleObjects;
+	uint16_t bundleObjectBytes;
+	bool bundling;			// the other end asked for bundles
+	uint8_t bundleObjCount;		// object count the indices refer to
+	UAVTalkDeltaRef *deltaRefs;	// NULL unless deltas are allowed
+	bool deltas;			// the other end asked for delta entries
+	bool dumpRequested;		// answered once the packet is processed
 } UAVTalkConnectionData;
 
 #define UAVTALK_CANARI         0xCA
@@ -107,9 +137,46 @@ typedef struct {
 #define UAVTALK_TYPE_OBJ_ACK   (UAVTALK_TYPE_VER | 0x02)
 #define UAVTALK_TYPE_ACK       (UAVTALK_TYPE_VER | 0x03)
 #define UAVTALK_TYPE_NACK      (UAVTALK_TYPE_VER | 0x04)
+#define UAVTALK_TYPE_BUNDLE    (UAVTALK_TYPE_VER | 0x05)
 #define UAVTALK_TYPE_OBJ_TS       (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ)
 #define UAVTALK_TYPE_OBJ_ACK_TS   (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ_ACK)
 
+/*
+ * A bundle frame has the header of a single instance object, with
+ * UAVTALK_BUNDLE_OBJID as object ID, and carries several unacked updates.
+ * Each is the object index (UAVObjIDByIndex order), the instance ID if the
+ * object is multi instance, both one byte, then the object data.  The other
+ * end asks for them with an empty bundle frame holding its count of
+ * objects, once it has learnt them through SessionManaging.  Endpoints
+ * that don't know the frame drop it as an unknown object.
+ *
+ * A second byte in the request holds UAVTALK_BUNDLE_OPT_ flags.  With
+ * UAVTALK_BUNDLE_OPT_DELTAS, an entry can instead start with
+ * UAVTALK_BUNDLE_DELTA, followed by the index and instance ID as above,
+ * the CRC of the reference update, a bitmap of the data bytes that differ
+ * from it (byte i is bit i % 8 of bitmap byte i / 8) and those bytes.  The
+ * reference is the last update of the object sent in full in a bundle;
+ * the other end drops deltas whose CRC doesn't match the one it holds.
+ */
+#define UAVTALK_BUNDLE_OBJID   0x00000000
+#define UAVTALK_BUNDLE_DELTA   0xFF	// never an object index, as UAVObjCount() <= 255
+#define UAVTALK_BUNDLE_OPT_DELTAS 0x01
+#ifndef UAVTALK_BUNDLE_LENGTH
+#define UAVTALK_BUNDLE_LENGTH  128	// payload
+#endif
+
+#if UAVTALK_BUNDLE_LENGTH > 255
+#error UAVTALK_BUNDLE_LENGTH is beyond what the GCS accepts
+#endif
+
+/*
+ * An object request for UAVTALK_DUMP_OBJID asks for every metaobject and
+ * every instance of every settings object, sent back to back as unacked
+ * updates.  An ACK for UAVTALK_DUMP_OBJID follows the last of them.
+ * Endpoints that don't know the request NACK it as an unknown object.
+ */
+#define UAVTALK_DUMP_OBJID     0x00000000
+
 //macros
 #define CHECKCONHANDLE(handle,variable,failcommand) \
 	variable = (UAVTalkConnectionData*) handle; \
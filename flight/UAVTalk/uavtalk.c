@@ -41,9 +41,16 @@
 static int32_t objectTransaction(UAVTalkConnectionData *connection, UAVObjHandle objectId, uint16_t instId, uint8_t type, int32_t timeout);
 static int32_t sendObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type);
 static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type);
+static int32_t sendObjectFrame(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type, uint32_t timestamp, const uint8_t *data);
 static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId);
+static int32_t sendBareFrame(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId);
+static int32_t bundleObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
+static int32_t flushBundle(UAVTalkConnectionData *connection);
+static int32_t deltaEncode(UAVTalkConnectionData *connection, uint32_t objId, uint16_t instId, uint8_t *entry, int32_t headLength, int32_t length);
+static void resetDeltas(UAVTalkConnectionData *connection, bool enable);
 static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, uint8_t* data, int32_t length);
 static void updateAck(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
+static void sendDump(UAVTalkConnectionData *connection);
 
 /**
  * Initialize the UAVTalk library
@@ -61,6 +68,16 @@ UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream)
 	connection->iproc.rxPacketLength = 0;
 	connection->iproc.state = UAVTALK_STATE_SYNC;
 	connection->outStream = outputStream;
+	connection->outReserve = NULL;
+	connection->outCommit = NULL;
+	connection->bundleBuffer = NULL;
+	connection->bundleLength = 0;
+	connection->bundleObjects = 0;
+	connection->bundleObjectBytes = 0;
+	connection->bundling = false;
+	connection->deltaRefs = NULL;
+	connection->deltas = false;
+	connection->dumpRequested = false;
 	connection->lock = PIOS_Recursive_Mutex_Create();
 	PIOS_Assert(connection->lock != NULL);
 	connection->transLock = PIOS_Recursive_Mutex_Create();
@@ -102,6 +119,37 @@ int32_t UAVTalkSetOutputStream(UAVTalkConnection connectionHandle, UAVTalkOutput
 
 }
 
+/**
+ * Let objects be packed straight into the output buffer, rather than copied
+ * in from txBuffer.  Both functions act on the same link as the output
+ * stream, which is still used whenever reserve gives no room.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] reserve Function pointer that is called to get room for a packet
+ * \param[in] commit Function pointer that is called to send the packet
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSetReserveStream(UAVTalkConnection connectionHandle, UAVTalkReserveStream reserve, UAVTalkCommitStream commit)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	if ((reserve == NULL) != (commit == NULL)) {
+		return -1;
+	}
+
+	// Lock
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	connection->outReserve = reserve;
+	connection->outCommit = commit;
+
+	// Release lock
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return 0;
+}
+
 /**
  * Get current output stream
  * \param[in] connection UAVTalkConnection to be used
@@ -226,6 +274,32 @@ int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjH
 	}
 }
 
+/**
+ * Send a copy of an object taken earlier, timestamped with the time it
+ * was taken.  It goes out unacked.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object the data belongs to
+ * \param[in] instId The instance ID
+ * \param[in] timestamp When the copy was taken, in ms
+ * \param[in] data UAVObjGetNumBytes() bytes of instance data
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendObjectData(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, uint32_t timestamp, const uint8_t *data)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	if (!connection->outStream) return -1;
+
+	// Lock
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	int32_t rc = sendObjectFrame(connection, obj, instId, UAVTALK_TYPE_OBJ_TS, timestamp, data);
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return rc;
+}
+
 /**
  * Execute the requested transaction on an object.
  * \param[in] connection UAVTalkConnection to be used
@@ -525,6 +599,8 @@ UAVTalkRxState UAVTalkProcessInputStream(UAVTalkConnection connectionHandle, uin
 		PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
 		receiveObject(connection, iproc->type, iproc->objId, iproc->instId, connection->rxBuffer, iproc->length);
 		PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+		sendDump(connection);
 	}
 
 	return state;
@@ -566,6 +642,8 @@ int32_t UAVTalkRelayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnecti
 	// Lock
 	PIOS_Recursive_Mutex_Lock(outConnection->lock, PIOS_MUTEX_TIMEOUT_MAX);
 
+	flushBundle(outConnection);
+
 	outConnection->txBuffer[0] = UAVTALK_SYNC_VAL;
 	// Setup type
 	outConnection->txBuffer[1] = inIproc->type;
@@ -643,7 +721,11 @@ int32_t UAVTalkReceiveObject(UAVTalkConnection connectionHandle)
 		return -1;
 	}
 
-	return receiveObject(connection, iproc->type, iproc->objId, iproc->instId, connection->rxBuffer, iproc->length);
+	int32_t ret = receiveObject(connection, iproc->type, iproc->objId, iproc->instId, connection->rxBuffer, iproc->length);
+
+	sendDump(connection);
+
+	return ret;
 }
 
 /**
@@ -801,6 +883,8 @@ int32_t UAVTalkSendBuf(UAVTalkConnection connectionHandle, uint8_t *buf, uint16_
 	// Lock
 	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
 
+	flushBundle(connection);
+
 	// Output the buffer
 	int32_t rc = (*connection->outStream)(buf, len);
 
@@ -816,6 +900,106 @@ int32_t UAVTalkSendBuf(UAVTalkConnection connectionHandle, uint8_t *buf, uint16_
 	return 0;
 }
 
+/**
+ * Let the other end ask for bundle frames on this connection.  Only for
+ * the connection telemetry negotiated the session on, as bundles use its
+ * object indices.
+ * \param[in] connection UAVTalkConnection to be used
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkAllowBundles(UAVTalkConnection connectionHandle)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection, return -1);
+
+	if (connection->bundleBuffer) {
+		return 0;
+	}
+
+	uint8_t *buf = PIOS_malloc(UAVTALK_MIN_HEADER_LENGTH +
+			UAVTALK_BUNDLE_LENGTH + UAVTALK_CHECKSUM_LENGTH);
+	if (!buf) {
+		return -1;
+	}
+
+	// Lock
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	connection->bundleBuffer = buf;
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return 0;
+}
+
+/**
+ * Let the other end ask for delta entries in the bundle frames of this
+ * connection, for the objects that change little between updates.
+ * \param[in] connection UAVTalkConnection to be used
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkAllowDeltas(UAVTalkConnection connectionHandle)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection, return -1);
+
+	if (connection->deltaRefs) {
+		return 0;
+	}
+
+	UAVTalkDeltaRef *refs = PIOS_malloc_no_dma(UAVTALK_DELTA_SLOTS * sizeof(*refs));
+	if (!refs) {
+		return -1;
+	}
+
+	memset(refs, 0, UAVTALK_DELTA_SLOTS * sizeof(*refs));
+
+	// Lock
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	connection->deltaRefs = refs;
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return 0;
+}
+
+/**
+ * Go back to sending one frame per object, until the other end asks for
+ * bundles again.  To be called when the session is lost or renegotiated.
+ * \param[in] connection UAVTalkConnection to be used
+ */
+void UAVTalkStopBundles(UAVTalkConnection connectionHandle)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection, return);
+
+	// Lock
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	flushBundle(connection);
+	connection->bundling = false;
+	resetDeltas(connection, false);
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+}
+
+/**
+ * Send the object updates held back for a bundle frame.  To be called
+ * whenever there is nothing more to send for a while.
+ * \param[in] connection UAVTalkConnection to be used
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkFlush(UAVTalkConnection connectionHandle)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection, return -1);
+
+	// Lock
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	int32_t rc = flushBundle(connection);
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return rc;
+}
+
 /**
  * Receive an object. This function process objects received through the telemetry stream.
  * \param[in] connection UAVTalkConnection to be used
@@ -870,7 +1054,9 @@ static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, ui
 		break;
 	case UAVTALK_TYPE_OBJ_REQ:
 		// Send requested object if message is of type OBJ_REQ
-		if (obj == 0)
+		if (objId == UAVTALK_DUMP_OBJID)
+			connection->dumpRequested = true;
+		else if (obj == 0)
 			sendNack(connection, objId);
 		else
 			sendObject(connection, obj, instId, UAVTALK_TYPE_OBJ);
@@ -878,6 +1064,24 @@ static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, ui
 	case UAVTALK_TYPE_NACK:
 		// Do nothing on flight side, let it time out.
 		break;
+	case UAVTALK_TYPE_BUNDLE:
+		// The other end asks for bundles, with the indices of our objects
+		// and the options it understands
+		if (connection->bundleBuffer && objId == UAVTALK_BUNDLE_OBJID &&
+				(length == 1 || length == 2) && data[0] == UAVObjCount()) {
+			// Lock
+			PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+			flushBundle(connection);
+			connection->bundling = true;
+			connection->bundleObjCount = data[0];
+			// It starts over without references
+			resetDeltas(connection, length == 2 &&
+					(data[1] & UAVTALK_BUNDLE_OPT_DELTAS));
+			PIOS_Recursive_Mutex_Unlock(connection->lock);
+		} else {
+			ret = -1;
+		}
+		break;
 	case UAVTALK_TYPE_ACK:
 		// All instances, not allowed for ACK messages
 		if (obj && (instId != UAVOBJ_ALL_INSTANCES)) {
@@ -908,6 +1112,44 @@ static void updateAck(UAVTalkConnectionData *connection, UAVObjHandle obj, uint1
 	}
 }
 
+/**
+ * Answer a dump request, if one came in: every metaobject and every settings
+ * object, then an ACK for UAVTALK_DUMP_OBJID.  The lock is only held for
+ * one object at a time, so other updates still go out meanwhile.
+ * \param[in] connection UAVTalkConnection to be used
+ */
+static void sendDump(UAVTalkConnectionData *connection)
+{
+	if (!connection->dumpRequested)
+		return;
+
+	connection->dumpRequested = false;
+
+	uint8_t count = UAVObjCount();
+
+	for (uint8_t i = 0; i < count; i++) {
+		UAVObjHandle obj = UAVObjGetByID(UAVObjIDByIndex(i));
+
+		if (!obj)
+			continue;
+
+		PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+		sendObject(connection, UAVObjGetLinkedObj(obj), 0, UAVTALK_TYPE_OBJ);
+		PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+		if (!UAVObjIsSettings(obj))
+			continue;
+
+		PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+		sendObject(connection, obj, UAVOBJ_ALL_INSTANCES, UAVTALK_TYPE_OBJ);
+		PIOS_Recursive_Mutex_Unlock(connection->lock);
+	}
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	sendBareFrame(connection, UAVTALK_TYPE_ACK, UAVTALK_DUMP_OBJID);
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+}
+
 /**
  * Send an object through the telemetry link.
  * \param[in] connection UAVTalkConnection to be used
@@ -963,41 +1205,44 @@ static int32_t sendObject(UAVTalkConnectionData *connection, UAVObjHandle obj, u
  * \return -1 Failure
  */
 static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type)
+{
+	if (!connection->outStream) return -1;
+
+	// Unacked updates may wait for company in a bundle frame
+	if (type == UAVTALK_TYPE_OBJ && bundleObject(connection, obj, instId) == 0) {
+		return 0;
+	}
+
+	return sendObjectFrame(connection, obj, instId, type, PIOS_Thread_Systime(), NULL);
+}
+
+/**
+ * Send one frame for an object
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object handle to send
+ * \param[in] instId The instance ID
+ * \param[in] type Transaction type
+ * \param[in] timestamp Time to put in timestamped frames, in ms
+ * \param[in] data Instance data to send, NULL to pack the object
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t sendObjectFrame(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type, uint32_t timestamp, const uint8_t *data)
 {
 	int32_t length;
 	int32_t dataOffset;
 	uint32_t objId;
 
-	if (!connection->outStream) return -1;
+	// Goes out in order, after what was held back
+	flushBundle(connection);
 
-	// Setup type and object id fields
-	objId = UAVObjGetID(obj);
-	connection->txBuffer[0] = UAVTALK_SYNC_VAL;  // sync byte
-	connection->txBuffer[1] = type;
-	// data length inserted here below
-	connection->txBuffer[4] = (uint8_t)(objId & 0xFF);
-	connection->txBuffer[5] = (uint8_t)((objId >> 8) & 0xFF);
-	connection->txBuffer[6] = (uint8_t)((objId >> 16) & 0xFF);
-	connection->txBuffer[7] = (uint8_t)((objId >> 24) & 0xFF);
-
-	// Setup instance ID if one is required
-	if (UAVObjIsSingleInstance(obj)) {
-		dataOffset = 8;
-	} else {
-		connection->txBuffer[8] = (uint8_t)(instId & 0xFF);
-		connection->txBuffer[9] = (uint8_t)((instId >> 8) & 0xFF);
-		dataOffset = 10;
-	}
+	// Determine header and data length
+	dataOffset = UAVObjIsSingleInstance(obj) ? 8 : 10;
 
-	// Add timestamp when the transaction type is appropriate
 	if (type & UAVTALK_TIMESTAMPED) {
-		uint32_t time = PIOS_Thread_Systime();
-		connection->txBuffer[dataOffset] = (uint8_t)(time & 0xFF);
-		connection->txBuffer[dataOffset + 1] = (uint8_t)((time >> 8) & 0xFF);
 		dataOffset += 2;
 	}
 
-	// Determine data length
 	if (type == UAVTALK_TYPE_OBJ_REQ || type == UAVTALK_TYPE_ACK) {
 		length = 0;
 	} else {
@@ -1009,22 +1254,67 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
 		return -1;
 	}
 
+	uint16_t tx_msg_len = dataOffset+length+UAVTALK_CHECKSUM_LENGTH;
+
+	// Build the packet in the output buffer if there is room, so the
+	// data is only copied once
+	uint8_t *buf = NULL;
+
+	if (connection->outReserve) {
+		buf = (*connection->outReserve)(tx_msg_len);
+	}
+
+	bool reserved = buf != NULL;
+
+	if (!reserved) {
+		buf = connection->txBuffer;
+	}
+
+	// Setup type and object id fields
+	objId = UAVObjGetID(obj);
+	buf[0] = UAVTALK_SYNC_VAL;  // sync byte
+	buf[1] = type;
+	buf[2] = (uint8_t)((dataOffset+length) & 0xFF);
+	buf[3] = (uint8_t)(((dataOffset+length) >> 8) & 0xFF);
+	buf[4] = (uint8_t)(objId & 0xFF);
+	buf[5] = (uint8_t)((objId >> 8) & 0xFF);
+	buf[6] = (uint8_t)((objId >> 16) & 0xFF);
+	buf[7] = (uint8_t)((objId >> 24) & 0xFF);
+
+	// Setup instance ID if one is required
+	if (!UAVObjIsSingleInstance(obj)) {
+		buf[8] = (uint8_t)(instId & 0xFF);
+		buf[9] = (uint8_t)((instId >> 8) & 0xFF);
+	}
+
+	// Add timestamp when the transaction type is appropriate
+	if (type & UAVTALK_TIMESTAMPED) {
+		buf[dataOffset - 2] = (uint8_t)(timestamp & 0xFF);
+		buf[dataOffset - 1] = (uint8_t)((timestamp >> 8) & 0xFF);
+	}
+
 	// Copy data (if any)
-	if (length > 0) {
-		if (UAVObjPack(obj, instId, &connection->txBuffer[dataOffset]) < 0) {
+	if (length > 0 && data) {
+		memcpy(&buf[dataOffset], data, length);
+	} else if (length > 0) {
+		if (UAVObjPack(obj, instId, &buf[dataOffset]) < 0) {
+			if (reserved) {
+				(*connection->outCommit)(0);
+			}
 			return -1;
 		}
 	}
 
-	// Store the packet length
-	connection->txBuffer[2] = (uint8_t)((dataOffset+length) & 0xFF);
-	connection->txBuffer[3] = (uint8_t)(((dataOffset+length) >> 8) & 0xFF);
-
 	// Calculate checksum
-	connection->txBuffer[dataOffset+length] = PIOS_CRC_updateCRC(0, connection->txBuffer, dataOffset+length);
+	buf[dataOffset+length] = PIOS_CRC_updateCRC(0, buf, dataOffset+length);
 
-	uint16_t tx_msg_len = dataOffset+length+UAVTALK_CHECKSUM_LENGTH;
-	int32_t rc = (*connection->outStream)(connection->txBuffer, tx_msg_len);
+	int32_t rc;
+
+	if (reserved) {
+		rc = (*connection->outCommit)(tx_msg_len);
+	} else {
+		rc = (*connection->outStream)(buf, tx_msg_len);
+	}
 
 	if (rc == tx_msg_len) {
 		// Update stats
@@ -1045,13 +1335,29 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
  * \return -1 Failure
  */
 static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId)
+{
+	return sendBareFrame(connection, UAVTALK_TYPE_NACK, objId);
+}
+
+/**
+ * Send a frame without instance ID or data, for an object ID that needn't
+ * be one of ours
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] type Frame type
+ * \param[in] objId Object ID to put in the frame
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t sendBareFrame(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId)
 {
 	int32_t dataOffset;
 
 	if (!connection->outStream) return -1;
 
+	flushBundle(connection);
+
 	connection->txBuffer[0] = UAVTALK_SYNC_VAL;  // sync byte
-	connection->txBuffer[1] = UAVTALK_TYPE_NACK;
+	connection->txBuffer[1] = type;
 	// data length inserted here below
 	connection->txBuffer[4] = (uint8_t)(objId & 0xFF);
 	connection->txBuffer[5] = (uint8_t)((objId >> 8) & 0xFF);
@@ -1079,6 +1385,210 @@ static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId)
 	return 0;
 }
 
+/**
+ * Add an object update to the bundle frame being built, sending the frame
+ * first if the update doesn't fit in anymore.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object handle to send
+ * \param[in] instId The instance ID
+ * \return 0 Success
+ * \return -1 The update can't be bundled, send it on its own
+ */
+static int32_t bundleObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId)
+{
+	if (!connection->bundling) {
+		return -1;
+	}
+
+	// Objects registered since the session was set up shift the indices
+	if (UAVObjCount() != connection->bundleObjCount) {
+		flushBundle(connection);
+		connection->bundling = false;
+		return -1;
+	}
+
+	int32_t index = UAVObjGetIndex(obj);
+	bool single = UAVObjIsSingleInstance(obj);
+
+	if (index < 0 || index >= UAVTALK_BUNDLE_DELTA || (!single && instId > 0xFF)) {
+		return -1;
+	}
+
+	int32_t length = UAVObjGetNumBytes(obj);
+	int32_t entryLength = (single ? 1 : 2) + length;
+
+	if (entryLength > UAVTALK_BUNDLE_LENGTH) {
+		return -1;
+	}
+
+	if (connection->bundleLength + entryLength > UAVTALK_BUNDLE_LENGTH) {
+		flushBundle(connection);
+	}
+
+	uint8_t *entry = &connection->bundleBuffer[UAVTALK_MIN_HEADER_LENGTH + connection->bundleLength];
+
+	entry[0] = (uint8_t) index;
+	if (!single) {
+		entry[1] = (uint8_t) instId;
+	}
+
+	if (UAVObjPack(obj, instId, &entry[entryLength - length]) < 0) {
+		return -1;
+	}
+
+	if (connection->deltas) {
+		entryLength = deltaEncode(connection, UAVObjGetID(obj), instId,
+				entry, entryLength - length, length);
+	}
+
+	connection->bundleLength += entryLength;
+	connection->bundleObjects++;
+	connection->bundleObjectBytes += length;
+
+	return 0;
+}
+
+/**
+ * Turn a full bundle entry into a delta entry against the last update of
+ * the object sent in full, when that's shorter.  Otherwise the update goes
+ * in full and becomes the reference, if the object has or gets a slot.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] objId ID of the object
+ * \param[in] instId The instance ID
+ * \param[in,out] entry The full entry, rewritten in place
+ * \param[in] headLength Length of the index and instance ID in the entry
+ * \param[in] length Length of the object data in the entry
+ * \return Length of the entry
+ */
+static int32_t deltaEncode(UAVTalkConnectionData *connection, uint32_t objId, uint16_t instId, uint8_t *entry, int32_t headLength, int32_t length)
+{
+	int32_t fullLength = headLength + length;
+	int32_t bitmapLength = (length + 7) / 8;
+
+	// The marker, CRC and bitmap alone must leave some saving
+	if (length > UAVTALK_DELTA_MAX_LENGTH || 2 + bitmapLength >= length) {
+		return fullLength;
+	}
+
+	UAVTalkDeltaRef *ref = NULL;
+	UAVTalkDeltaRef *freeSlot = NULL;
+
+	for (int i = 0; i < UAVTALK_DELTA_SLOTS; i++) {
+		UAVTalkDeltaRef *slot = &connection->deltaRefs[i];
+
+		if (slot->objId == objId && slot->instId == instId) {
+			ref = slot;
+			break;
+		} else if (slot->objId == 0 && !freeSlot) {
+			freeSlot = slot;
+		}
+	}
+
+	uint8_t *data = &entry[headLength];
+
+	if (ref && ref->deltas < UAVTALK_DELTA_KEYFRAME) {
+		// Never longer than the full entry, the loop stops before that
+		uint8_t delta[2 + UAVTALK_DELTA_MAX_LENGTH];
+		int32_t deltaLength = 1 + headLength + 1 + bitmapLength;
+
+		delta[0] = UAVTALK_BUNDLE_DELTA;
+		memcpy(&delta[1], entry, headLength);
+		delta[1 + headLength] = ref->crc;
+
+		uint8_t *bitmap = &delta[2 + headLength];
+		memset(bitmap, 0, bitmapLength);
+
+		for (int32_t i = 0; i < length && deltaLength < fullLength; i++) {
+			if (data[i] != ref->data[i]) {
+				bitmap[i / 8] |= 1 << (i % 8);
+				delta[deltaLength++] = data[i];
+			}
+		}
+
+		if (deltaLength < fullLength) {
+			memcpy(entry, delta, deltaLength);
+			ref->deltas++;
+			return deltaLength;
+		}
+	}
+
+	if (!ref) {
+		ref = freeSlot;
+	}
+
+	if (ref) {
+		ref->objId = objId;
+		ref->instId = instId;
+		ref->crc = PIOS_CRC_updateCRC(0, data, length);
+		ref->deltas = 0;
+		memcpy(ref->data, data, length);
+	}
+
+	return fullLength;
+}
+
+/**
+ * Forget the references of the delta entries
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] enable Send delta entries from now on
+ */
+static void resetDeltas(UAVTalkConnectionData *connection, bool enable)
+{
+	connection->deltas = enable && connection->deltaRefs;
+
+	if (connection->deltaRefs) {
+		memset(connection->deltaRefs, 0, UAVTALK_DELTA_SLOTS * sizeof(*connection->deltaRefs));
+	}
+}
+
+/**
+ * Send the bundle frame being built, if any
+ * \param[in] connection UAVTalkConnection to be used
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t flushBundle(UAVTalkConnectionData *connection)
+{
+	if (connection->bundleLength == 0) {
+		return 0;
+	}
+
+	uint8_t *buf = connection->bundleBuffer;
+	uint16_t size = UAVTALK_MIN_HEADER_LENGTH + connection->bundleLength;
+
+	buf[0] = UAVTALK_SYNC_VAL;  // sync byte
+	buf[1] = UAVTALK_TYPE_BUNDLE;
+	buf[2] = (uint8_t)(size & 0xFF);
+	buf[3] = (uint8_t)((size >> 8) & 0xFF);
+	buf[4] = (uint8_t)(UAVTALK_BUNDLE_OBJID & 0xFF);
+	buf[5] = (uint8_t)((UAVTALK_BUNDLE_OBJID >> 8) & 0xFF);
+	buf[6] = (uint8_t)((UAVTALK_BUNDLE_OBJID >> 16) & 0xFF);
+	buf[7] = (uint8_t)((UAVTALK_BUNDLE_OBJID >> 24) & 0xFF);
+
+	// Calculate checksum
+	buf[size] = PIOS_CRC_updateCRC(0, buf, size);
+
+	uint16_t tx_msg_len = size + UAVTALK_CHECKSUM_LENGTH;
+	int32_t rc = -1;
+
+	if (connection->outStream) {
+		rc = (*connection->outStream)(buf, tx_msg_len);
+	}
+
+	if (rc == tx_msg_len) {
+		// Update stats
+		connection->stats.txObjects += connection->bundleObjects;
+		connection->stats.txBytes += tx_msg_len;
+		connection->stats.txObjectBytes += connection->bundleObjectBytes;
+	}
+
+	connection->bundleLength = 0;
+	connection->bundleObjects = 0;
+	connection->bundleObjectBytes = 0;
+
+	return (rc == tx_msg_len) ? 0 : -1;
+}
+
 /**
  * @}
  * @}
@@ -48,6 +48,9 @@ enum bl_commands {
 	BL_MSG_STATUS_REQ,
 	BL_MSG_STATUS_REP,
 	BL_MSG_WIPE_PARTITION,
+	BL_MSG_SECTOR_CRC_REQ,
+	BL_MSG_SECTOR_CRC_REP,
+	BL_MSG_WRITE_RANGE_START,
 
 	BL_MSG_WRITE_START = 0x27,
 };
@@ -145,7 +148,7 @@ struct bl_messages {
 		} status_req;
 
 		struct msg_status_rep {
-			uint32_t unused;
+			uint32_t additional_state; /* Next packet expected while writing */
 			uint8_t current_state;
 		} status_rep;
 
@@ -153,6 +156,27 @@ struct bl_messages {
 			enum dfu_partition_label label;
 		} wipe_partition;
 
+		struct msg_sector_crc_req {
+			enum dfu_partition_label label;
+			uint32_t partition_offset;
+		} sector_crc_req;
+
+		struct msg_sector_crc_rep {
+			enum dfu_partition_label label;
+			uint32_t sector_offset;
+			uint32_t sector_size; /* 0 past the end of the partition */
+			uint32_t crc;
+		} sector_crc_rep;
+
+		/* Writes over only the sectors the range covers */
+		struct msg_xfer_range_start {
+			uint32_t packets_in_transfer;
+			enum dfu_partition_label label;
+			uint8_t words_in_last_packet;
+			uint32_t expected_crc; /* of the whole sectors written */
+			uint32_t partition_offset; /* must start a sector */
+		} xfer_range_start;
+
 		uint8_t pad[62];
 	} __attribute__((aligned(1)))v;
 } __attribute__((packed));
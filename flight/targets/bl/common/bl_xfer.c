@@ -41,6 +41,34 @@
 
 #define MIN(x,y) ((x) < (y) ? (x) : (y))
 
+/*
+ * Written packets are collected here and programmed a buffer at a time,
+ * which saves a flash transaction per packet.  The next packet is
+ * already being received while the buffer is programmed.
+ */
+#define BL_XFER_STAGING_LEN (16 * XFER_BYTES_PER_PACKET)
+
+static uint32_t staging_buf[BL_XFER_STAGING_LEN / sizeof(uint32_t)];
+
+static bool bl_xfer_flush_staging(struct xfer_state * xfer)
+{
+	if (xfer->staged_bytes == 0)
+		return true;
+
+	PIOS_FLASH_start_transaction(xfer->partition_id);
+
+	int32_t ret = PIOS_FLASH_write_data(xfer->partition_id,
+			xfer->current_partition_offset - xfer->staged_bytes,
+			(uint8_t *)staging_buf,
+			xfer->staged_bytes);
+
+	PIOS_FLASH_end_transaction(xfer->partition_id);
+
+	xfer->staged_bytes = 0;
+
+	return (ret == 0);
+}
+
 static uint32_t bl_compute_partition_crc(uintptr_t partition_id, uint32_t partition_offset, uint32_t length)
 {
 	CRC_ResetDR();
@@ -77,7 +105,7 @@ bool bl_xfer_crc_ok_p(const struct xfer_state * xfer)
 
 	uint32_t actual_crc = bl_compute_partition_crc(xfer->partition_id,
 						xfer->original_partition_offset,
-						xfer->partition_size);
+						xfer->crc_length);
 
 	return (actual_crc == xfer->crc);
 }
@@ -181,22 +209,23 @@ bool bl_xfer_send_next_read_packet(struct xfer_state * xfer)
 	return true;
 }
 
-bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *xfer_start)
+/**
+ * Look up the partition a write to label goes to
+ * \param[out] xfer partition id, size and offset are filled in
+ * \param[out] partition_needs_erase false if the partition is written without erasing
+ * \return false if label can't be written
+ */
+static bool bl_xfer_find_write_partition(struct xfer_state * xfer, enum dfu_partition_label label, bool * partition_needs_erase)
 {
-	/* Disable any previous transfer */
-	xfer->in_progress = false;
-
 	/* Recover a pointer to the bootloader board info blob */
 	const struct pios_board_info * bdinfo = &pios_board_info_blob;
 
-	/* Set up the transfer */
-	bool partition_needs_erase = true;
+	*partition_needs_erase = true;
 
 	xfer->check_crc = true;
-	xfer->crc  = BE32_TO_CPU(xfer_start->expected_crc);
 	xfer->original_partition_offset = 0;
 
-	switch (xfer_start->label) {
+	switch (label) {
 #ifdef F1_UPGRADER
 	case DFU_PARTITION_BL:
 		PIOS_FLASH_find_partition_id(FLASH_PARTITION_LABEL_BL, &xfer->partition_id);
@@ -214,7 +243,7 @@ bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *
 		PIOS_FLASH_get_partition_size(xfer->partition_id, &xfer->partition_size);
 		xfer->original_partition_offset = bdinfo->desc_base - bdinfo->fw_base;
 		xfer->check_crc        = false;
-		partition_needs_erase  = false;
+		*partition_needs_erase = false;
 		break;
 	case DFU_PARTITION_SETTINGS:
 		PIOS_FLASH_find_partition_id(FLASH_PARTITION_LABEL_SETTINGS, &xfer->partition_id);
@@ -232,6 +261,22 @@ bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *
 		return false;
 	}
 
+	return true;
+}
+
+bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *xfer_start)
+{
+	/* Disable any previous transfer */
+	xfer->in_progress = false;
+
+	/* Set up the transfer */
+	bool partition_needs_erase;
+	if (!bl_xfer_find_write_partition(xfer, xfer_start->label, &partition_needs_erase))
+		return false;
+
+	xfer->crc = BE32_TO_CPU(xfer_start->expected_crc);
+	xfer->crc_length = xfer->partition_size;
+
 	/* How many bytes is the host trying to transfer? */
 	uint32_t bytes_to_xfer = (BE32_TO_CPU(xfer_start->packets_in_transfer) - 1) * XFER_BYTES_PER_PACKET +
 		xfer_start->words_in_last_packet * sizeof(uint32_t);
@@ -252,6 +297,69 @@ bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *
 
 	xfer->current_partition_offset = xfer->original_partition_offset;
 	xfer->bytes_to_xfer = bytes_to_xfer;
+	xfer->staged_bytes = 0;
+	xfer->next_packet_number = 0;
+	xfer->in_progress = true;
+
+	return true;
+}
+
+bool bl_xfer_write_range_start(struct xfer_state * xfer, const struct msg_xfer_range_start *range_start)
+{
+	/* Disable any previous transfer */
+	xfer->in_progress = false;
+
+	/* Set up the transfer */
+	bool partition_needs_erase;
+	if (!bl_xfer_find_write_partition(xfer, range_start->label, &partition_needs_erase))
+		return false;
+
+	/* The descriptor isn't erased so it can't be written by sectors */
+	if (!partition_needs_erase)
+		return false;
+
+	if (BE32_TO_CPU(range_start->packets_in_transfer) == 0)
+		return false;
+
+	/* How many bytes is the host trying to transfer, and where? */
+	uint32_t bytes_to_xfer = (BE32_TO_CPU(range_start->packets_in_transfer) - 1) * XFER_BYTES_PER_PACKET +
+		range_start->words_in_last_packet * sizeof(uint32_t);
+	uint32_t offset = BE32_TO_CPU(range_start->partition_offset);
+
+	if ((offset >= xfer->partition_size) || (bytes_to_xfer > xfer->partition_size - offset)) {
+		return false;
+	}
+
+	/* Erase each sector the range touches, the first of which must start at offset */
+	uint32_t erase_end = offset;
+	int32_t ret = 0;
+
+	PIOS_FLASH_start_transaction(xfer->partition_id);
+	do {
+		uint32_t sector_offset;
+		uint32_t sector_size;
+		ret = PIOS_FLASH_get_sector_range(xfer->partition_id, erase_end, &sector_offset, &sector_size);
+		if (ret != 0 || sector_offset != erase_end) {
+			ret = -1;
+			break;
+		}
+
+		ret = PIOS_FLASH_erase_range(xfer->partition_id, sector_offset, sector_size);
+		erase_end = sector_offset + sector_size;
+	} while (ret == 0 && erase_end < offset + bytes_to_xfer);
+	PIOS_FLASH_end_transaction(xfer->partition_id);
+
+	if (ret != 0)
+		return false;
+
+	/* The CRC covers the erased sectors, as far as the partition can be written */
+	xfer->crc = BE32_TO_CPU(range_start->expected_crc);
+	xfer->original_partition_offset = offset;
+	xfer->crc_length = MIN(erase_end, xfer->partition_size) - offset;
+
+	xfer->current_partition_offset = offset;
+	xfer->bytes_to_xfer = bytes_to_xfer;
+	xfer->staged_bytes = 0;
 	xfer->next_packet_number = 0;
 	xfer->in_progress = true;
 
@@ -277,28 +385,66 @@ bool bl_xfer_write_cont(struct xfer_state * xfer, const struct msg_xfer_cont *xf
 		return false;
 	}
 
-	/* Fix up the endian of the data words */
-	for (uint8_t i = 0; i < bytes_this_xfer / sizeof(uint32_t); i++) {
-		uint32_t *data = &((uint32_t *)xfer_cont->data)[i];
-		*data = BE32_TO_CPU(*data);
+	/* Program what is staged if this packet doesn't fit */
+	if (xfer->staged_bytes + bytes_this_xfer > sizeof(staging_buf)) {
+		if (!bl_xfer_flush_staging(xfer))
+			return false;
 	}
 
-	/* Write the data to flash */
-	PIOS_FLASH_start_transaction(xfer->partition_id);
-
-	PIOS_FLASH_write_data(xfer->partition_id,
-			xfer->current_partition_offset,
-			xfer_cont->data,
-			bytes_this_xfer);
-
-	PIOS_FLASH_end_transaction(xfer->partition_id);
+	/* Fix up the endian of the data words as they are staged */
+	uint32_t *staged = &staging_buf[xfer->staged_bytes / sizeof(uint32_t)];
+	for (uint8_t i = 0; i < bytes_this_xfer / sizeof(uint32_t); i++) {
+		uint32_t data;
+		memcpy(&data, &xfer_cont->data[i * sizeof(uint32_t)], sizeof(data));
+		staged[i] = BE32_TO_CPU(data);
+	}
 
 	/* Update accounting for how many bytes we've received */
+	xfer->staged_bytes             += bytes_this_xfer;
 	xfer->current_partition_offset += bytes_this_xfer;
 	xfer->bytes_to_xfer            -= bytes_this_xfer;
 
 	xfer->next_packet_number++;
 
+	/* Everything must be in flash before the CRC is checked */
+	if (xfer->bytes_to_xfer == 0) {
+		return bl_xfer_flush_staging(xfer);
+	}
+
+	return true;
+}
+
+bool bl_xfer_send_sector_crc(const struct msg_sector_crc_req *sector_crc_req)
+{
+	struct bl_messages msg = {
+		.flags_command = BL_MSG_SECTOR_CRC_REP,
+		.v.sector_crc_rep = {
+			.label = sector_crc_req->label,
+		},
+	};
+
+	/* Only partitions that can be written by sectors are reported */
+	struct xfer_state target;
+	bool partition_needs_erase;
+	uint32_t offset = BE32_TO_CPU(sector_crc_req->partition_offset);
+	uint32_t sector_offset;
+	uint32_t sector_size;
+
+	if (bl_xfer_find_write_partition(&target, sector_crc_req->label, &partition_needs_erase) &&
+			partition_needs_erase &&
+			(offset < target.partition_size) &&
+			(PIOS_FLASH_get_sector_range(target.partition_id, offset, &sector_offset, &sector_size) == 0)) {
+		/* Same extent the CRC of a write over this sector covers */
+		sector_size = MIN(sector_offset + sector_size, target.partition_size) - sector_offset;
+
+		msg.v.sector_crc_rep.sector_offset = CPU_TO_BE32(sector_offset);
+		msg.v.sector_crc_rep.sector_size   = CPU_TO_BE32(sector_size);
+		msg.v.sector_crc_rep.crc           = CPU_TO_BE32(bl_compute_partition_crc(target.partition_id,
+									sector_offset, sector_size));
+	}
+
+	PIOS_COM_MSG_Send(PIOS_COM_TELEM_USB, (uint8_t *)&msg, sizeof(msg));
+
 	return true;
 }
 
@@ -44,6 +44,8 @@ struct xfer_state {
 	uint32_t crc;
 
 	uint32_t bytes_to_xfer;
+	uint32_t staged_bytes;
+	uint32_t crc_length;
 };
 
 extern bool bl_xfer_completed_p(const struct xfer_state * xfer);
@@ -51,7 +53,9 @@ extern bool bl_xfer_crc_ok_p(const struct xfer_state * xfer);
 extern bool bl_xfer_read_start(struct xfer_state * xfer, const struct msg_xfer_start *xfer_start);
 extern bool bl_xfer_send_next_read_packet(struct xfer_state * xfer);
 extern bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *xfer_start);
+extern bool bl_xfer_write_range_start(struct xfer_state * xfer, const struct msg_xfer_range_start *range_start);
 extern bool bl_xfer_write_cont(struct xfer_state * xfer, const struct msg_xfer_cont *xfer_cont);
+extern bool bl_xfer_send_sector_crc(const struct msg_sector_crc_req *sector_crc_req);
 extern bool bl_xfer_wipe_partition(const struct msg_wipe_partition *wipe_partition);
 extern bool bl_xfer_send_capabilities_self(void);
 
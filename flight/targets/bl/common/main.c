@@ -545,6 +545,11 @@ static bool bl_send_status(struct bl_fsm_context * context)
 		},
 	};
 
+	/* Lets the host resume an interrupted write where it stopped */
+	if (context->curr_state == BL_STATE_DFU_WRITE_IN_PROGRESS) {
+		msg.v.status_rep.additional_state = CPU_TO_BE32(context->xfer.next_packet_number);
+	}
+
 	PIOS_COM_MSG_Send(PIOS_COM_TELEM_USB, (uint8_t *)&msg, sizeof(msg));
 
 	return true;
@@ -622,6 +627,13 @@ static void process_packet_rx(struct bl_fsm_context * context, const struct bl_m
 			/* Failed to start the write */
 		}
 		break;
+	case BL_MSG_WRITE_RANGE_START:
+		if (bl_xfer_write_range_start(&context->xfer, &(msg->v.xfer_range_start))) {
+			bl_fsm_inject_event(context, BL_EVENT_WRITE_START);
+		} else {
+			/* Failed to start the write */
+		}
+		break;
 	case BL_MSG_WRITE_CONT:
 		if (bl_fsm_get_state(context) == BL_STATE_DFU_WRITE_IN_PROGRESS) {
 			if (!bl_xfer_write_cont(&context->xfer, &(msg->v.xfer_cont))) {
@@ -661,8 +673,13 @@ static void process_packet_rx(struct bl_fsm_context * context, const struct bl_m
 		bl_xfer_wipe_partition(&(msg->v.wipe_partition));
 		break;
 
+	case BL_MSG_SECTOR_CRC_REQ:
+		bl_xfer_send_sector_crc(&(msg->v.sector_crc_req));
+		break;
+
 	case BL_MSG_CAP_REP:
 	case BL_MSG_STATUS_REP:
+	case BL_MSG_SECTOR_CRC_REP:
 	case BL_MSG_READ_CONT:
 		/* We've received a *reply* packet when we expected a request. */
 		break;
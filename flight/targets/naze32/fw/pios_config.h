@@ -76,6 +76,8 @@
 #define PIOS_INCLUDE_MPU
 
 #define PIOS_INCLUDE_LOGFS_SETTINGS
+#define PIOS_FLASHFS_LOGFS_INDEX_SIZE 64
+#define PIOS_FLASHFS_LOGFS_NO_GC_TASK
 
 #define PIOS_INCLUDE_FLASH
 #define PIOS_INCLUDE_FLASH_SECTOR_SETTINGS
@@ -99,7 +101,6 @@
 #define PIOS_STABILIZATION_STACK_SIZE   624
 #define PIOS_TELEM_STACK_SIZE           528
 #define PIOS_EVENTDISPATCHER_STACK_SIZE 720
-#define PIOS_MAVLINK_STACK_SIZE         496
 #define PIOS_COMUSBBRIDGE_STACK_SIZE    480
 #define IDLE_COUNTS_PER_SEC_AT_NO_LOAD 1995998
 
@@ -117,6 +118,7 @@
 #define PIOS_COM_BRIDGE_TX_BUF_LEN 12
 
 #define PIOS_COM_MAVLINK_TX_BUF_LEN 32
+#define PIOS_COM_MAVLINK_RX_BUF_LEN 0
 
 #define PIOS_COM_FRSKYSENSORHUB_TX_BUF_LEN 128
 
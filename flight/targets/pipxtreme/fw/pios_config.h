@@ -64,6 +64,8 @@
 #define PIOS_INCLUDE_FLASH
 #define PIOS_INCLUDE_FLASH_INTERNAL
 #define PIOS_INCLUDE_LOGFS_SETTINGS
+#define PIOS_FLASHFS_LOGFS_INDEX_SIZE 64
+#define PIOS_FLASHFS_LOGFS_NO_GC_TASK
 
 /* Defaults for Logging */
 #define LOG_FILENAME 			"PIOS.LOG"
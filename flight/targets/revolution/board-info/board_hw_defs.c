@@ -174,7 +174,36 @@ static const struct pios_spi_cfg pios_spi_gyro_cfg = {
 /*
  * SPI3 Interface
  * Used for Flash and the RFM22B
+ *
+ * Long blocks, the flash pages, go by DMA1 stream 0 and stream 7.
  */
+void PIOS_SPI_telem_flash_irq_handler(void);
+void DMA1_Stream0_IRQHandler(void) __attribute__((alias("PIOS_SPI_telem_flash_irq_handler")));
+
+static const struct pios_spi_dma_cfg pios_spi_telem_flash_dma_cfg = {
+	.irq = {
+		.flags = (DMA_FLAG_TCIF0 | DMA_FLAG_HTIF0 | DMA_FLAG_TEIF0 | DMA_FLAG_DMEIF0 | DMA_FLAG_FEIF0),
+		.init = {
+			.NVIC_IRQChannel = DMA1_Stream0_IRQn,
+			.NVIC_IRQChannelPreemptionPriority = PIOS_IRQ_PRIO_MID,
+			.NVIC_IRQChannelSubPriority = 0,
+			.NVIC_IRQChannelCmd = ENABLE,
+		},
+	},
+	.rx = {
+		.channel = DMA1_Stream0,
+		.init = {
+			.DMA_Channel = DMA_Channel_0,
+		},
+	},
+	.tx = {
+		.channel = DMA1_Stream7,
+		.init = {
+			.DMA_Channel = DMA_Channel_0,
+		},
+	},
+};
+
 static const struct pios_spi_cfg pios_spi_telem_flash_cfg = {
 	.regs = SPI3,
 	.remap = GPIO_AF_SPI3,
@@ -219,6 +248,7 @@ static const struct pios_spi_cfg pios_spi_telem_flash_cfg = {
 			.GPIO_PuPd = GPIO_PuPd_NOPULL
 		},
 	},
+	.block_dma = &pios_spi_telem_flash_dma_cfg,
 	.slave_count = 2,
 	.ssel = { 
 		{      // RFM22b
@@ -243,6 +273,11 @@ static const struct pios_spi_cfg pios_spi_telem_flash_cfg = {
 };
 
 uint32_t pios_spi_telem_flash_id;
+void PIOS_SPI_telem_flash_irq_handler(void)
+{
+	/* Call into the generic code to handle the IRQ for this specific device */
+	PIOS_SPI_IRQ_Handler(pios_spi_telem_flash_id);
+}
 
 #if defined(PIOS_INCLUDE_RFM22B)
 #include <pios_rfm22b_priv.h>
@@ -550,7 +585,42 @@ const struct pios_flash_partition * PIOS_BOARD_HW_DEFS_GetPartitionTable (uint32
 #include <pios_usart_priv.h>
 /*
  * MAIN USART
+ *
+ * Received into a ring by DMA2 stream 5 and sent by DMA2 stream 7, so
+ * fast telemetry does not take an interrupt for every byte.
  */
+static const struct pios_usart_dma_cfg pios_usart_main_dma_cfg = {
+	.irq = {
+		.flags = (DMA_FLAG_TCIF5 | DMA_FLAG_HTIF5 | DMA_FLAG_TEIF5 | DMA_FLAG_DMEIF5 | DMA_FLAG_FEIF5),
+		.init = {
+			.NVIC_IRQChannel = DMA2_Stream5_IRQn,
+			.NVIC_IRQChannelPreemptionPriority = PIOS_IRQ_PRIO_MID,
+			.NVIC_IRQChannelSubPriority = 0,
+			.NVIC_IRQChannelCmd = ENABLE,
+		},
+	},
+	.rx = {
+		.channel = DMA2_Stream5,
+		.init = {
+			.DMA_Channel = DMA_Channel_4,
+			.DMA_PeripheralBaseAddr = (uint32_t)&USART1->DR,
+		},
+	},
+	.tx = {
+		.channel = DMA2_Stream7,
+		.init = {
+			.DMA_Channel = DMA_Channel_4,
+			.DMA_PeripheralBaseAddr = (uint32_t)&USART1->DR,
+		},
+	},
+	.tx_flags = (DMA_FLAG_TCIF7 | DMA_FLAG_HTIF7 | DMA_FLAG_TEIF7 | DMA_FLAG_DMEIF7 | DMA_FLAG_FEIF7),
+};
+
+void DMA2_Stream5_IRQHandler(void)
+{
+	PIOS_USART_DMA_irq_handler(USART1);
+}
+
 static const struct pios_usart_cfg pios_usart_main_cfg = {
 	.regs = USART1,
 	.remap = GPIO_AF_USART1,
@@ -562,6 +632,7 @@ static const struct pios_usart_cfg pios_usart_main_cfg = {
 			.NVIC_IRQChannelCmd = ENABLE,
 		},
 	},
+	.dma = &pios_usart_main_dma_cfg,
 	.rx = {
 		.gpio = GPIOA,
 		.init = {
@@ -761,6 +832,29 @@ void I2C1_EV_IRQHandler()
 void I2C1_ER_IRQHandler()
     __attribute__ ((alias("PIOS_I2C_mag_pressure_adapter_er_irq_handler")));
 
+/* The mag and baro reads are received by DMA1 stream 5 */
+void PIOS_I2C_mag_pressure_adapter_dma_irq_handler(void);
+void DMA1_Stream5_IRQHandler()
+    __attribute__ ((alias("PIOS_I2C_mag_pressure_adapter_dma_irq_handler")));
+
+static const struct pios_i2c_dma_cfg pios_i2c_mag_pressure_dma_cfg = {
+	.irq = {
+		.flags = (DMA_FLAG_TCIF5 | DMA_FLAG_HTIF5 | DMA_FLAG_TEIF5 | DMA_FLAG_DMEIF5 | DMA_FLAG_FEIF5),
+		.init = {
+			.NVIC_IRQChannel = DMA1_Stream5_IRQn,
+			.NVIC_IRQChannelPreemptionPriority = PIOS_IRQ_PRIO_HIGHEST,
+			.NVIC_IRQChannelSubPriority = 0,
+			.NVIC_IRQChannelCmd = ENABLE,
+		},
+	},
+	.rx = {
+		.channel = DMA1_Stream5,
+		.init = {
+			.DMA_Channel = DMA_Channel_1,
+		},
+	},
+};
+
 static const struct pios_i2c_adapter_cfg pios_i2c_mag_pressure_adapter_cfg = {
 	.regs = I2C1,
 	.remap = GPIO_AF_I2C1,
@@ -811,6 +905,7 @@ static const struct pios_i2c_adapter_cfg pios_i2c_mag_pressure_adapter_cfg = {
 			.NVIC_IRQChannelCmd = ENABLE,
 		},
 	},
+	.dma = &pios_i2c_mag_pressure_dma_cfg,
 };
 
 uint32_t pios_i2c_mag_pressure_adapter_id;
@@ -826,6 +921,12 @@ void PIOS_I2C_mag_pressure_adapter_er_irq_handler(void)
 	PIOS_I2C_ER_IRQ_Handler(pios_i2c_mag_pressure_adapter_id);
 }
 
+void PIOS_I2C_mag_pressure_adapter_dma_irq_handler(void)
+{
+	/* Call into the generic code to handle the IRQ for this specific device */
+	PIOS_I2C_DMA_IRQ_Handler(pios_i2c_mag_pressure_adapter_id);
+}
+
 
 void PIOS_I2C_flexiport_adapter_ev_irq_handler(void);
 void PIOS_I2C_flexiport_adapter_er_irq_handler(void);
@@ -60,6 +60,7 @@
 #define PIOS_INCLUDE_RTC
 #define PIOS_INCLUDE_WDG
 #define PIOS_INCLUDE_FASTHEAP
+#define PIOS_INCLUDE_HEAP_POOLS
 #define PIOS_INCLUDE_FRSKY_RSSI
 
 /* Variables related to the RFM22B functionality */
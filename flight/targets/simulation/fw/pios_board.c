@@ -54,9 +54,12 @@
 void Stack_Change() {
 }
 
-const struct pios_tcp_cfg pios_tcp_telem_cfg = {
+#define PIOS_TCP_TELEM_BASE_PORT 9000
+
+// The port is offset by the instance, so several can run side by side
+struct pios_tcp_cfg pios_tcp_telem_cfg = {
   .ip = "0.0.0.0",
-  .port = 9000,
+  .port = PIOS_TCP_TELEM_BASE_PORT,
 };
 
 #define PIOS_COM_TELEM_RF_RX_BUF_LEN 384
@@ -132,6 +135,8 @@ void PIOS_Board_Init(void) {
 	HwSparkyInitialize();
 	HwSimulationInitialize();
 
+	pios_tcp_telem_cfg.port = PIOS_TCP_TELEM_BASE_PORT + PIOS_SYS_Instance();
+
 	uintptr_t pios_tcp_telem_rf_id;
 	if (PIOS_TCP_Init(&pios_tcp_telem_rf_id, &pios_tcp_telem_cfg)) {
 		PIOS_Assert(0);
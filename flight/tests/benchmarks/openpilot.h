@@ -0,0 +1,4 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "pios.h"
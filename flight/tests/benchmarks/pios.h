@@ -0,0 +1,10 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Just what the benchmarked code needs, without the rest of PiOS */
+#define PIOS_malloc(size) malloc(size)
+#define PIOS_free(ptr) free(ptr)
+#define PIOS_Assert(x) if (!(x)) { while (1) ; }
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
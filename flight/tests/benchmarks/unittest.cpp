@@ -0,0 +1,156 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Times the flight library benchmark kernels on the host
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+
+#include <chrono>		/* steady_clock */
+
+extern "C" {
+
+#include "benchmarks.h"		/* the kernels */
+#include "pid.h"		/* pid_configure_derivative */
+#include "pios_crc.h"		/* PIOS_CRC_updateCRC */
+
+}
+
+#define ITERATIONS 100000
+#define REPEATS 5
+
+// Not pass/fail tests; the figures, also in the XML from ut_benchmarks_xml,
+// are to compare between commits on the same machine
+class Benchmarks : public testing::Test {
+protected:
+  static void SetUpTestCase() {
+    pid_configure_derivative(20.0f, 1.0f);
+    ASSERT_EQ(0, benchmarks_initialize());
+  }
+
+  void Time(enum benchmark_kernel kernel);
+};
+
+void Benchmarks::Time(enum benchmark_kernel kernel) {
+  const struct benchmark *b = &benchmark_kernels[kernel];
+  double best = 0;
+
+  ASSERT_TRUE(b->name != NULL);
+
+  // The fastest of a few runs, as the least disturbed by the rest of the host
+  for (int i = 0; i < REPEATS; i++) {
+    auto start = std::chrono::steady_clock::now();
+    b->run(ITERATIONS);
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+
+    if (i == 0 || ns < best) {
+      best = ns;
+    }
+  }
+
+  printf("%-20s %8.2f ns\n", b->name, best);
+
+  char figure[16];
+  snprintf(figure, sizeof(figure), "%.2f", best);
+  testing::Test::RecordProperty(b->name, figure);
+}
+
+#define BENCHMARK(kernel) \
+  TEST_F(Benchmarks, kernel) { Time(BENCHMARK_##kernel); }
+
+BENCHMARK(QUAT_MULT)
+BENCHMARK(ROT_MULT)
+BENCHMARK(QUATERNION2R)
+BENCHMARK(PID_APPLY)
+BENCHMARK(LINEAR_INTERPOLATE)
+BENCHMARK(EXPOM)
+BENCHMARK(CIRCQUEUE)
+BENCHMARK(CRC)
+
+// The buffer CRC takes several bytes per step; it must still agree with
+// the byte at a time one, for every length and alignment
+TEST(CRC, BufferMatchesBytewise) {
+  uint8_t data[64];
+
+  for (unsigned i = 0; i < sizeof(data); i++) {
+    data[i] = i * 37 + 11;
+  }
+
+  for (int offset = 0; offset < 4; offset++) {
+    for (int len = 0; len + offset <= (int) sizeof(data); len++) {
+      for (int seed = 0; seed < 256; seed += 85) {
+        uint8_t expected = seed;
+
+        for (int i = 0; i < len; i++) {
+          expected = PIOS_CRC_updateByte(expected, data[offset + i]);
+        }
+
+        EXPECT_EQ(expected, PIOS_CRC_updateCRC(seed, data + offset, len)) <<
+          "offset " << offset << " length " << len << " seed " << seed;
+      }
+    }
+  }
+}
+
+// The receivers check their frames with the CRC-16-CCITT, now table driven;
+// it must match the bit at a time definition
+TEST(CRC, CCITTMatchesBitwise) {
+  const uint8_t check[] = "123456789";
+
+  EXPECT_EQ(0x31c3, PIOS_CRC16_CCITT_updateCRC(0, check, 9));
+
+  uint8_t data[40];
+
+  for (unsigned i = 0; i < sizeof(data); i++) {
+    data[i] = i * 73 + 5;
+  }
+
+  for (unsigned len = 0; len <= sizeof(data); len++) {
+    uint16_t expected = 0x1d0f;
+
+    for (unsigned n = 0; n < len; n++) {
+      expected ^= data[n] << 8;
+      for (int i = 0; i < 8; i++) {
+        expected = (expected & 0x8000) ? (expected << 1) ^ 0x1021 : (expected << 1);
+      }
+    }
+
+    EXPECT_EQ(expected, PIOS_CRC16_CCITT_updateCRC(0x1d0f, data, len)) << "length " << len;
+  }
+}
+
+/**
+ * @}
+ * @}
+ */
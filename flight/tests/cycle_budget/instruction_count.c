@@ -0,0 +1,120 @@
+/**
+ ******************************************************************************
+ * @file       instruction_count.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Counts the instructions a function executes, by single stepping it
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "instruction_count.h"
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__))
+
+#include <signal.h>
+#include <stdio.h>
+#include <sys/ptrace.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static void nothing(void)
+{
+}
+
+/**
+ * Steps from the child's first stop to its second
+ * \return the steps, or -1 if the child did not stop again
+ */
+static int64_t steps_between_stops(void (*fn)(void))
+{
+	fflush(NULL);
+
+	pid_t pid = fork();
+	if (pid < 0)
+		return -1;
+
+	if (pid == 0) {
+		if (ptrace(PTRACE_TRACEME, 0, NULL, NULL) != 0)
+			_exit(1);
+
+		raise(SIGSTOP);
+		fn();
+		raise(SIGSTOP);
+		_exit(0);
+	}
+
+	int status;
+	int64_t steps = -1;
+
+	if (waitpid(pid, &status, 0) == pid && WIFSTOPPED(status)) {
+		int64_t n = 0;
+
+		while (ptrace(PTRACE_SINGLESTEP, pid, NULL, NULL) == 0 &&
+				waitpid(pid, &status, 0) == pid &&
+				WIFSTOPPED(status)) {
+			if (WSTOPSIG(status) == SIGSTOP) {
+				steps = n;
+				break;
+			}
+
+			n++;
+		}
+	}
+
+	kill(pid, SIGKILL);
+	waitpid(pid, &status, 0);
+
+	return steps;
+}
+
+int64_t instruction_count(void (*fn)(void))
+{
+	/* Leaving the first raise and entering the second cost the same
+	 * every time, so an empty function measures them */
+	static int64_t overhead = -1;
+
+	if (overhead < 0) {
+		overhead = steps_between_stops(nothing);
+		if (overhead < 0)
+			return -1;
+	}
+
+	int64_t steps = steps_between_stops(fn);
+	if (steps < 0)
+		return -1;
+
+	return steps - overhead;
+}
+
+#else
+
+int64_t instruction_count(void (*fn)(void))
+{
+	(void) fn;
+
+	return -1;
+}
+
+#endif
+
+/**
+ * @}
+ * @}
+ */
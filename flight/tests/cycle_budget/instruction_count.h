@@ -0,0 +1,50 @@
+/**
+ ******************************************************************************
+ * @file       instruction_count.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Counts the instructions a function executes, by single stepping it
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef INSTRUCTION_COUNT_H
+#define INSTRUCTION_COUNT_H
+
+#include <stdint.h>
+
+/*
+ * The function runs once in a child forked from the caller, so it starts
+ * from the caller's state and leaves it untouched, and the child is single
+ * stepped through it with ptrace.  The count does not depend on the load
+ * of the host or on what it runs on, only on the code the compiler made,
+ * so it is the same from run to run.
+ */
+
+/**
+ * Instructions executed by fn(), not counting the calls around it
+ * \return the count, or -1 where single stepping is not supported
+ */
+int64_t instruction_count(void (*fn)(void));
+
+#endif /* INSTRUCTION_COUNT_H */
+
+/**
+ * @}
+ * @}
+ */
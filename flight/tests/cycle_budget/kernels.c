@@ -0,0 +1,192 @@
+/**
+ ******************************************************************************
+ * @file       kernels.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Flight hot paths on fixed inputs, for their instruction budgets
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "pios.h"
+#include "kernels.h"
+#include "insgps.h"
+#include "ecc.h"
+#include "pios_flash_priv.h"
+#include "pios_flashfs_logfs_priv.h"
+
+#include <string.h>
+
+// Private constants
+#define INS_DT 0.002f			// 500 Hz, the attitude rate on F3/F4
+
+#define RS_PACKET_LEN 64		// RFM22B_MAX_PACKET_LEN
+#define RS_DATA_LEN (RS_PACKET_LEN - RS_ECC_NPARITY)
+
+#define LOGFS_NUM_OBJECTS 128
+#define LOGFS_OBJ_SIZE 76
+#define LOGFS_OBJ_ID(i) (0x12345678u + (i) * 0x01010101u)
+
+// Private variables
+extern const struct pios_flash_partition pios_flash_partition_table[];
+extern uint32_t pios_flash_partition_table_size;
+extern const struct flashfs_logfs_cfg flashfs_config_settings;
+
+/* A vehicle level and still, a little off home, with the sensors agreeing */
+static const float ins_gyro[3] = { 0.01f, -0.02f, 0.005f };
+static const float ins_accel[3] = { 0.1f, -0.05f, -9.81f };
+static const float ins_mag[3] = { 400.0f, 20.0f, 300.0f };
+static const float ins_pos[3] = { 1.5f, -2.0f, -10.0f };
+static const float ins_vel[3] = { 0.2f, 0.1f, -0.05f };
+static const float ins_baro = 10.1f;
+
+static uint8_t rs_packet[RS_PACKET_LEN];	// as sent
+static uint8_t rs_rx[RS_PACKET_LEN];		// as received
+
+static uintptr_t logfs_id;
+static uint8_t logfs_obj[LOGFS_OBJ_SIZE];
+
+// Private functions
+
+static int32_t ins_setup(void)
+{
+	const float zeros[3] = { 0, 0, 0 };
+	const float accel_var[3] = { 0.003f, 0.003f, 0.003f };
+	const float gyro_var[3] = { 1e-5f, 1e-5f, 1e-4f };
+	const float mag_var[3] = { 10, 10, 100 };
+	const float Be[3] = { 400.0f, 20.0f, 300.0f };
+	const float q[4] = { 1, 0, 0, 0 };
+
+	INSGPSInit();
+	INSSetAccelVar(accel_var);
+	INSSetGyroVar(gyro_var);
+	INSSetMagVar(mag_var);
+	INSSetBaroVar(0.01f);
+	INSSetPosVelVar(0.001f, 0.01f, 0.5f);
+	INSSetMagNorth(Be);
+	INSSetState(ins_pos, ins_vel, q, zeros, zeros);
+
+	return 0;
+}
+
+static void ins_state_prediction(void)
+{
+	INSStatePrediction(ins_gyro, ins_accel, INS_DT);
+}
+
+static void ins_covariance_prediction(void)
+{
+	INSCovariancePrediction(INS_DT);
+}
+
+static void ins_correction(void)
+{
+	INSCorrection(ins_mag, ins_pos, ins_vel, ins_baro, FULL_SENSORS);
+}
+
+static int32_t rs_setup(void)
+{
+	static bool initialized;
+
+	if (!initialized) {
+		uint8_t msg[RS_DATA_LEN];
+
+		initialize_ecc();
+
+		for (int i = 0; i < RS_DATA_LEN; i++)
+			msg[i] = i * 37 + 11;
+
+		encode_data(msg, RS_DATA_LEN, rs_packet);
+		initialized = true;
+	}
+
+	memcpy(rs_rx, rs_packet, sizeof(rs_rx));
+
+	return 0;
+}
+
+static int32_t rs_setup_errors(void)
+{
+	rs_setup();
+
+	rs_rx[5] ^= 0x5a;
+	rs_rx[40] ^= 0x81;
+
+	return 0;
+}
+
+static void rs_decode(void)
+{
+	decode_data(rs_rx, RS_PACKET_LEN);
+}
+
+/* As the radio takes a packet that fails its check */
+static void rs_correct(void)
+{
+	decode_data(rs_rx, RS_PACKET_LEN);
+	if (check_syndrome() != 0)
+		correct_errors_erasures(rs_rx, RS_PACKET_LEN, 0, NULL);
+}
+
+/* Fills the log with objects, each saved once, so the last is found at the
+ * end of a long scan */
+static int32_t logfs_setup(void)
+{
+	if (logfs_id)
+		return 0;
+
+	PIOS_FLASH_register_partition_table(pios_flash_partition_table,
+			pios_flash_partition_table_size);
+
+	if (PIOS_FLASHFS_Logfs_Init(&logfs_id, &flashfs_config_settings,
+				FLASH_PARTITION_LABEL_SETTINGS) != 0)
+		return -1;
+
+	for (int i = 0; i < LOGFS_NUM_OBJECTS; i++) {
+		memset(logfs_obj, i, sizeof(logfs_obj));
+		if (PIOS_FLASHFS_ObjSave(logfs_id, LOGFS_OBJ_ID(i), 0,
+					logfs_obj, sizeof(logfs_obj)) != 0)
+			return -1;
+	}
+
+	if (PIOS_FLASHFS_ObjLoad(logfs_id, LOGFS_OBJ_ID(LOGFS_NUM_OBJECTS - 1), 0,
+				logfs_obj, sizeof(logfs_obj)) != 0)
+		return -1;
+
+	return 0;
+}
+
+static void logfs_find(void)
+{
+	PIOS_FLASHFS_ObjLoad(logfs_id, LOGFS_OBJ_ID(LOGFS_NUM_OBJECTS - 1), 0,
+			logfs_obj, sizeof(logfs_obj));
+}
+
+const struct budget_kernel_def budget_kernels[KERNEL_NUM_KERNELS] = {
+	[KERNEL_INS_STATE_PREDICTION]      = { "INSStatePrediction", ins_setup, ins_state_prediction },
+	[KERNEL_INS_COVARIANCE_PREDICTION] = { "INSCovariancePrediction", ins_setup, ins_covariance_prediction },
+	[KERNEL_INS_CORRECTION]            = { "INSCorrection", ins_setup, ins_correction },
+	[KERNEL_RS_DECODE]                 = { "decode_data", rs_setup, rs_decode },
+	[KERNEL_RS_CORRECT]                = { "correct_errors_erasures", rs_setup_errors, rs_correct },
+	[KERNEL_LOGFS_FIND]                = { "logfs_object_find_next", logfs_setup, logfs_find },
+};
+
+/**
+ * @}
+ * @}
+ */
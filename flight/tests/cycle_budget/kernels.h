@@ -0,0 +1,58 @@
+/**
+ ******************************************************************************
+ * @file       kernels.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Flight hot paths on fixed inputs, for their instruction budgets
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <stdint.h>
+
+/*
+ * Each kernel is one call of the code it is named for.  Its setup puts the
+ * inputs back as they were, so the call does the same work every time.
+ */
+enum budget_kernel {
+	KERNEL_INS_STATE_PREDICTION,
+	KERNEL_INS_COVARIANCE_PREDICTION,
+	KERNEL_INS_CORRECTION,		// all sensors
+	KERNEL_RS_DECODE,		// syndromes of a full radio packet
+	KERNEL_RS_CORRECT,		// two bad bytes found and fixed
+	KERNEL_LOGFS_FIND,		// the last of the objects saved, by scan
+	KERNEL_NUM_KERNELS
+};
+
+struct budget_kernel_def {
+	const char *name;
+	int32_t (*setup)(void);		// 0 on success
+	void (*run)(void);
+};
+
+extern const struct budget_kernel_def budget_kernels[KERNEL_NUM_KERNELS];
+
+#endif /* KERNELS_H */
+
+/**
+ * @}
+ * @}
+ */
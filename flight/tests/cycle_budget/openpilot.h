@@ -0,0 +1,3 @@
+#include "pios.h"
+
+#define RS_ECC_NPARITY 4
@@ -0,0 +1,5 @@
+#define PIOS_INCLUDE_FLASH
+#define PIOS_FLASHFS_LOGFS_NO_GC_TASK
+
+/* Without the index every lookup scans the arena, which is the code timed */
+#define PIOS_FLASHFS_LOGFS_INDEX_SIZE 0
@@ -0,0 +1,124 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Holds flight hot paths to budgets of instructions
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* int64_t */
+
+extern "C" {
+
+#include "kernels.h"		/* the kernels */
+#include "instruction_count.h"	/* instruction_count */
+
+}
+
+// The budgets are instructions, as built here with gcc 12 for x86_64 and
+// about 10% over what that took.  A change that costs more fails; if it
+// is worth it, raise the budget in the same commit.  On other hosts the
+// compiler makes other code, so the counts are reported but not held to
+// the budgets.
+#if defined(__x86_64__)
+#define ENFORCE_BUDGETS 1
+#else
+#define ENFORCE_BUDGETS 0
+#endif
+
+// Well under budget, the budget ought to come down to keep the gain
+#define SLACK_PERCENT 70
+
+static void Check(enum budget_kernel kernel, int64_t budget) {
+  const struct budget_kernel_def *k = &budget_kernels[kernel];
+
+  ASSERT_TRUE(k->name != NULL);
+
+  // Once ahead, so the code and data it touches are in place, then from
+  // the inputs again
+  ASSERT_EQ(0, k->setup());
+  k->run();
+  ASSERT_EQ(0, k->setup());
+
+  int64_t count = instruction_count(k->run);
+
+  if (count < 0) {
+    printf("%-28s not counted, no single stepping here\n", k->name);
+    return;
+  }
+
+  printf("%-28s %8lld instructions, budget %lld\n", k->name,
+      (long long) count, (long long) budget);
+
+  char figure[24];
+  snprintf(figure, sizeof(figure), "%lld", (long long) count);
+  testing::Test::RecordProperty(k->name, figure);
+
+  if (!ENFORCE_BUDGETS) {
+    return;
+  }
+
+  EXPECT_LE(count, budget) << k->name << " is over its budget";
+
+  if (count * 100 < budget * SLACK_PERCENT) {
+    printf("%-28s is well under its budget, consider lowering it\n", k->name);
+  }
+}
+
+#define BUDGET(kernel, instructions) \
+  TEST(CycleBudget, kernel) { Check(KERNEL_##kernel, instructions); }
+
+BUDGET(INS_STATE_PREDICTION, 1500)
+BUDGET(INS_COVARIANCE_PREDICTION, 10500)
+BUDGET(INS_CORRECTION, 20700)
+BUDGET(RS_DECODE, 4350)
+BUDGET(RS_CORRECT, 47600)
+BUDGET(LOGFS_FIND, 14500)
+
+// The same instructions every time, or the budgets mean nothing
+TEST(CycleBudget, Repeatable) {
+  const struct budget_kernel_def *k = &budget_kernels[KERNEL_RS_CORRECT];
+
+  ASSERT_EQ(0, k->setup());
+  k->run();
+  ASSERT_EQ(0, k->setup());
+
+  int64_t first = instruction_count(k->run);
+  if (first < 0) {
+    return;
+  }
+
+  EXPECT_EQ(first, instruction_count(k->run));
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,112 @@
+/*
+ * These need to be defined in a .c file so that we can use
+ * designated initializer syntax which c++ doesn't support (yet).
+ *
+ * The flash is kept in RAM, so the lookups are timed without the file
+ * system of the host.
+ */
+
+#include "pios.h"
+#include "pios_flash_priv.h"
+#include "pios_flashfs_logfs_priv.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define FLASH_NUM_SECTORS 2
+
+static uint8_t flash[FLASH_NUM_SECTORS * FLASH_SECTOR_64KB];
+
+static int32_t ram_flash_start_transaction(uintptr_t chip_id)
+{
+	return 0;
+}
+
+static int32_t ram_flash_end_transaction(uintptr_t chip_id)
+{
+	return 0;
+}
+
+static int32_t ram_flash_erase_sector(uintptr_t chip_id, uint32_t chip_sector, uint32_t chip_offset)
+{
+	memset(&flash[chip_offset], 0xFF, FLASH_SECTOR_64KB);
+	return 0;
+}
+
+static int32_t ram_flash_write_data(uintptr_t chip_id, uint32_t chip_offset, const uint8_t *data, uint16_t len)
+{
+	/* Flash only clears bits */
+	for (uint16_t i = 0; i < len; i++)
+		flash[chip_offset + i] &= data[i];
+	return 0;
+}
+
+static int32_t ram_flash_read_data(uintptr_t chip_id, uint32_t chip_offset, uint8_t *data, uint16_t len)
+{
+	memcpy(data, &flash[chip_offset], len);
+	return 0;
+}
+
+static const struct pios_flash_driver ram_flash_driver = {
+	.start_transaction = ram_flash_start_transaction,
+	.end_transaction   = ram_flash_end_transaction,
+	.erase_sector      = ram_flash_erase_sector,
+	.write_data        = ram_flash_write_data,
+	.read_data         = ram_flash_read_data,
+};
+
+static const struct pios_flash_sector_range ram_flash_sectors[] = {
+	{
+		.base_sector = 0,
+		.last_sector = FLASH_NUM_SECTORS - 1,
+		.sector_size = FLASH_SECTOR_64KB,
+	},
+};
+
+static uintptr_t ram_flash_id;
+static const struct pios_flash_chip ram_flash_chip = {
+	.driver        = &ram_flash_driver,
+	.chip_id       = &ram_flash_id,
+	.page_size     = 256,
+	.sector_blocks = ram_flash_sectors,
+	.num_blocks    = NELEMENTS(ram_flash_sectors),
+};
+
+const struct pios_flash_partition pios_flash_partition_table[] = {
+	{
+		.label        = FLASH_PARTITION_LABEL_SETTINGS,
+		.chip_desc    = &ram_flash_chip,
+		.first_sector = 0,
+		.last_sector  = FLASH_NUM_SECTORS - 1,
+		.chip_offset  = 0,
+		.size         = FLASH_NUM_SECTORS * FLASH_SECTOR_64KB,
+	},
+};
+
+uint32_t pios_flash_partition_table_size = NELEMENTS(pios_flash_partition_table);
+
+const struct flashfs_logfs_cfg flashfs_config_settings = {
+	.fs_magic      = 0x89abceef,
+	.arena_size    = 0x00010000, /* 256 * slot size */
+	.slot_size     = 0x00000100, /* 256 bytes */
+};
+
+bool PIOS_heap_malloc_failed_p(void)
+{
+	return false;
+}
+
+void * PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void * PIOS_malloc_no_dma(size_t size)
+{
+	return malloc(size);
+}
+
+void PIOS_free(void * buf)
+{
+	free(buf);
+}
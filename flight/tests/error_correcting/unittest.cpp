@@ -45,6 +45,8 @@ extern "C" {
 
 #include <math.h>   /* fabs() */
 
+#include <chrono>   /* steady_clock */
+
 
 
 // To use a test fixture, derive a class from testing::Test.
@@ -103,3 +105,75 @@ TEST_F(EncodeDecode, Recover) {
     EXPECT_EQ(p[i], p2[i]);
 
 };
+
+// The codec works from logs; check it against the plain shift register
+// and syndrome sums built on gmult
+static void reference_encode(unsigned char msg[], int nbytes, unsigned char parity[])
+{
+  int lfsr[RS_ECC_NPARITY] = {};
+  extern int genPoly[];
+
+  for (int i = 0; i < nbytes; i++) {
+    int dbyte = msg[i] ^ lfsr[RS_ECC_NPARITY - 1];
+    for (int j = RS_ECC_NPARITY - 1; j > 0; j--)
+      lfsr[j] = lfsr[j - 1] ^ gmult(genPoly[j], dbyte);
+    lfsr[0] = gmult(genPoly[0], dbyte);
+  }
+
+  for (int i = 0; i < RS_ECC_NPARITY; i++)
+    parity[i] = lfsr[RS_ECC_NPARITY - 1 - i];
+}
+
+TEST_F(EncodeDecode, MatchesReference) {
+  unsigned char p[255];
+  unsigned char parity[RS_ECC_NPARITY];
+
+  srand(1);
+  for (int n = 0; n < 200; n++) {
+    int len = rand() % (sizeof(p) - RS_ECC_NPARITY);
+    for (int i = 0; i < len; i++)
+      p[i] = (n & 1) ? rand() : (rand() % 4 == 0 ? rand() : 0);
+
+    reference_encode(p, len, parity);
+    encode_data(p, len, p);
+    for (int i = 0; i < RS_ECC_NPARITY; i++)
+      EXPECT_EQ(parity[i], p[len + i]);
+
+    p[rand() % (len + RS_ECC_NPARITY)] ^= 1 + rand() % 255;
+    decode_data(p, len + RS_ECC_NPARITY);
+    for (int j = 0; j < RS_ECC_NPARITY; j++) {
+      int sum = 0;
+      for (int i = 0; i < len + RS_ECC_NPARITY; i++)
+        sum = p[i] ^ gmult(gexp[j + 1], sum);
+      EXPECT_EQ(sum, synBytes[j]);
+    }
+    EXPECT_EQ(1, check_syndrome());
+  }
+};
+
+// Not pass/fail; the time to encode and check a full-size radio packet, to
+// compare between commits on the same machine
+TEST_F(EncodeDecode, Throughput) {
+  const int iterations = 20000;
+  unsigned char p[255];
+  int len = sizeof(p) - RS_ECC_NPARITY;
+
+  for (int i = 0; i < len; i++)
+    p[i] = i * 37;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int n = 0; n < iterations; n++) {
+    encode_data(p, len, p);
+    decode_data(p, sizeof(p));
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  EXPECT_EQ(0, check_syndrome());
+
+  double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+  printf("%-20s %8.2f ns\n", "RS_PACKET", ns);
+
+  char figure[16];
+  snprintf(figure, sizeof(figure), "%.2f", ns);
+  testing::Test::RecordProperty("RS_PACKET", figure);
+};
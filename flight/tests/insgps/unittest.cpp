@@ -0,0 +1,299 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Replays a simulated flight through the INS, timing each step and
+ * checking the estimate against the truth it was made from
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <math.h>		/* sin, cos */
+
+#include <chrono>		/* steady_clock */
+#include <random>		/* mt19937 */
+
+extern "C" {
+
+#include "insgps.h"		/* API for the INS */
+
+}
+
+#define GRAVITY_MSS 9.81
+
+// Sensor rates, as a divider of the prediction rate
+#define STEP_DT   0.002		// 500 Hz, the attitude rate on F3/F4
+#define MAG_DIV   20		// 25 Hz
+#define BARO_DIV  25		// 20 Hz
+#define GPS_DIV   100		// 5 Hz
+#define INDOOR_DIV 50		// 10 Hz, as the attitude module fakes it
+
+#define FLIGHT_STEPS 30000	// 60 s
+#define SETTLE_STEPS 5000	// errors are only counted after 10 s
+
+// The vehicle: a slow circle with a bob in altitude, tumbling gently.
+// Indoors it holds its place and only tumbles.
+static void truth_motion(double t, bool indoor, double pos[3], double vel[3],
+		double acc[3], double rate[3])
+{
+	const double r = indoor ? 0 : 20, w = 0.1;
+	const double h = indoor ? 0 : 2, wh = 0.2;
+
+	pos[0] = r * cos(w * t);
+	pos[1] = r * sin(w * t);
+	pos[2] = -10 - h * sin(wh * t);
+	vel[0] = -r * w * sin(w * t);
+	vel[1] = r * w * cos(w * t);
+	vel[2] = -h * wh * cos(wh * t);
+	acc[0] = -r * w * w * cos(w * t);
+	acc[1] = -r * w * w * sin(w * t);
+	acc[2] = h * wh * wh * sin(wh * t);
+
+	rate[0] = 0.3 * sin(0.5 * t);
+	rate[1] = 0.2 * sin(0.3 * t + 1);
+	rate[2] = 0.1;
+}
+
+// Same kinematics as the INS: qdot = q * (0, w) / 2
+static void quat_integrate(double q[4], const double w[3], double dT)
+{
+	double qd[4] = {
+		(-q[1] * w[0] - q[2] * w[1] - q[3] * w[2]) / 2,
+		(q[0] * w[0] - q[3] * w[1] + q[2] * w[2]) / 2,
+		(q[3] * w[0] + q[0] * w[1] - q[1] * w[2]) / 2,
+		(-q[2] * w[0] + q[1] * w[1] + q[0] * w[2]) / 2,
+	};
+
+	double mag = 0;
+	for (int i = 0; i < 4; i++) {
+		q[i] += qd[i] * dT;
+		mag += q[i] * q[i];
+	}
+
+	mag = sqrt(mag);
+	for (int i = 0; i < 4; i++)
+		q[i] /= mag;
+}
+
+// Rotate an earth frame vector into the body frame
+static void earth_to_body(const double q[4], const double e[3], double b[3])
+{
+	const double q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+	double Reb[3][3] = {
+		{ q0*q0 + q1*q1 - q2*q2 - q3*q3, 2 * (q1*q2 - q0*q3), 2 * (q1*q3 + q0*q2) },
+		{ 2 * (q1*q2 + q0*q3), q0*q0 - q1*q1 + q2*q2 - q3*q3, 2 * (q2*q3 - q0*q1) },
+		{ 2 * (q1*q3 - q0*q2), 2 * (q2*q3 + q0*q1), q0*q0 - q1*q1 - q2*q2 + q3*q3 },
+	};
+
+	for (int i = 0; i < 3; i++)
+		b[i] = Reb[0][i] * e[0] + Reb[1][i] * e[1] + Reb[2][i] * e[2];
+}
+
+struct flight_result {
+	double step_ns_mean;
+	double step_ns_worst;
+	double att_err_rms;	// deg
+	double att_err_max;	// deg
+	double pos_err_rms;	// m
+	double vel_err_rms;	// m/s
+};
+
+static void fly(struct flight_result *res, bool indoor)
+{
+	std::mt19937 gen(42);
+	std::normal_distribution<double> noise(0, 1);
+
+	const double gyro_bias[3] = { 0.01, -0.005, 0.002 };
+	const double Be[3] = { 400, 50, 900 };
+	const float Be_f[3] = { 400, 50, 900 };
+
+	double q[4] = { 1, 0, 0, 0 };
+	double pos[3], vel[3], acc[3], rate[3];
+
+	truth_motion(0, indoor, pos, vel, acc, rate);
+
+	const float zeros[3] = { 0, 0, 0 };
+	const float accel_var[3] = { 0.003f, 0.003f, 0.003f };
+	const float gyro_var[3] = { 1e-5f, 1e-5f, 1e-4f };
+	const float mag_var[3] = { 10, 10, 100 };
+	float pos_f[3] = { (float) pos[0], (float) pos[1], (float) pos[2] };
+	float vel_f[3] = { (float) vel[0], (float) vel[1], (float) vel[2] };
+	float q_f[4] = { 1, 0, 0, 0 };
+
+	INSGPSInit();
+	INSSetAccelVar(accel_var);
+	INSSetGyroVar(gyro_var);
+	INSSetMagVar(mag_var);
+	INSSetBaroVar(0.01f);
+	INSSetPosVelVar(0.001f, 0.01f, 0.5f);
+	INSSetMagNorth(Be_f);
+	INSSetState(pos_f, vel_f, q_f, zeros, zeros);
+
+	double ns_total = 0, ns_worst = 0;
+	double att_sq = 0, att_max = 0, pos_sq = 0, vel_sq = 0;
+	int counted = 0;
+
+	for (int step = 1; step <= FLIGHT_STEPS; step++) {
+		double t = step * STEP_DT;
+
+		// Truth, then the sensors seeing it
+		truth_motion(t, indoor, pos, vel, acc, rate);
+		quat_integrate(q, rate, STEP_DT);
+
+		double f_ned[3] = { acc[0], acc[1], acc[2] - GRAVITY_MSS };
+		double f_body[3], mag_body[3];
+		earth_to_body(q, f_ned, f_body);
+		earth_to_body(q, Be, mag_body);
+
+		float gyro_f[3], accel_f[3], mag_f[3], gps_pos[3], gps_vel[3];
+		for (int i = 0; i < 3; i++) {
+			gyro_f[i] = rate[i] + gyro_bias[i] + 0.003 * noise(gen);
+			accel_f[i] = f_body[i] + 0.05 * noise(gen);
+			mag_f[i] = mag_body[i] + 3 * noise(gen);
+			gps_pos[i] = pos[i] + 0.5 * noise(gen);
+			gps_vel[i] = vel[i] + 0.1 * noise(gen);
+		}
+		float baro = -pos[2] + 0.1 * noise(gen);
+
+		uint16_t sensors = 0;
+		if (step % MAG_DIV == 0)
+			sensors |= MAG_SENSORS;
+		if (step % BARO_DIV == 0)
+			sensors |= BARO_SENSOR;
+		if (!indoor && step % GPS_DIV == 0)
+			sensors |= POS_SENSORS | HORIZ_VEL_SENSORS | VERT_VEL_SENSORS;
+
+		// Without GPS the vehicle is held weakly at the origin, with
+		// the baro for its height
+		if (indoor && step % INDOOR_DIV == 0) {
+			sensors |= HORIZ_POS_SENSORS | HORIZ_VEL_SENSORS;
+			for (int i = 0; i < 3; i++)
+				gps_vel[i] = 0;
+			gps_pos[0] = gps_pos[1] = 0;
+			gps_pos[2] = -baro;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+
+		INSStatePrediction(gyro_f, accel_f, STEP_DT);
+		INSCovariancePrediction(STEP_DT);
+		if (sensors)
+			INSCorrection(mag_f, gps_pos, gps_vel, baro, sensors);
+
+		auto end = std::chrono::steady_clock::now();
+		double ns = std::chrono::duration<double, std::nano>(end - start).count();
+
+		ns_total += ns;
+		if (ns > ns_worst)
+			ns_worst = ns;
+
+		if (step <= SETTLE_STEPS)
+			continue;
+
+		float est_pos[3], est_vel[3], est_q[4], est_gyro_bias[3], est_accel_bias[4];
+		INSGetState(est_pos, est_vel, est_q, est_gyro_bias, est_accel_bias);
+
+		double dot = fabs(q[0] * est_q[0] + q[1] * est_q[1] +
+				q[2] * est_q[2] + q[3] * est_q[3]);
+		double att_err = 2 * acos(fmin(dot, 1.0)) * 180 / M_PI;
+
+		att_sq += att_err * att_err;
+		if (att_err > att_max)
+			att_max = att_err;
+
+		for (int i = 0; i < 3; i++) {
+			pos_sq += (est_pos[i] - pos[i]) * (est_pos[i] - pos[i]);
+			vel_sq += (est_vel[i] - vel[i]) * (est_vel[i] - vel[i]);
+		}
+
+		counted++;
+	}
+
+	res->step_ns_mean = ns_total / FLIGHT_STEPS;
+	res->step_ns_worst = ns_worst;
+	res->att_err_rms = sqrt(att_sq / counted);
+	res->att_err_max = att_max;
+	res->pos_err_rms = sqrt(pos_sq / counted);
+	res->vel_err_rms = sqrt(vel_sq / counted);
+}
+
+static void report(const char *name, const struct flight_result *res)
+{
+	printf("%s, %d states: %.0f ns/step mean, %.0f ns worst; "
+			"attitude %.2f deg rms, %.2f deg max; "
+			"position %.2f m rms; velocity %.3f m/s rms\n",
+			name, ins_get_num_states(),
+			res->step_ns_mean, res->step_ns_worst,
+			res->att_err_rms, res->att_err_max,
+			res->pos_err_rms, res->vel_err_rms);
+
+	testing::Test::RecordProperty("StepNsMean", (int) res->step_ns_mean);
+	testing::Test::RecordProperty("StepNsWorst", (int) res->step_ns_worst);
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class InsReplay : public testing::Test {
+protected:
+  virtual void SetUp() {
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+// The limits leave room over what all three filters do today; the printed
+// figures are what to compare when changing a filter
+TEST_F(InsReplay, OutdoorFlight) {
+  struct flight_result res;
+
+  fly(&res, false);
+  report("outdoor", &res);
+
+  EXPECT_LT(res.att_err_rms, 4.0);
+  EXPECT_LT(res.att_err_max, 10.0);
+  EXPECT_LT(res.pos_err_rms, 1.5);
+  EXPECT_LT(res.vel_err_rms, 0.75);
+};
+
+TEST_F(InsReplay, IndoorHover) {
+  struct flight_result res;
+
+  fly(&res, true);
+  report("indoor", &res);
+
+  EXPECT_LT(res.att_err_rms, 4.0);
+  EXPECT_LT(res.att_err_max, 10.0);
+  EXPECT_LT(res.pos_err_rms, 1.5);
+};
+
+/**
+ * @}
+ * @}
+ */
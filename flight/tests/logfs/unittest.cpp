@@ -332,6 +332,152 @@ TEST_F(LogfsTestCooked, WriteManyVerify) {
   EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
 }
 
+TEST_F(LogfsTestCooked, WriteManyBackgroundGarbageCollect) {
+  bool collected = false;
+
+  /* Rewrite a few objects, stepping the garbage collection after each save */
+  for (uint32_t i = 0; i < 2000; i++) {
+    unsigned char *data = ((i / 4) % 2) ? obj1_alt : obj1;
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, i % 4, data, sizeof(obj1)));
+
+    int32_t rc = PIOS_FLASHFS_Logfs_GarbageCollectStep(fs_id);
+    EXPECT_LE(0, rc);
+    if (rc > 0)
+      collected = true;
+  }
+
+  EXPECT_TRUE(collected);
+
+  /* The last round wrote obj1_alt to every instance */
+  for (uint16_t inst = 0; inst < 4; inst++) {
+    unsigned char obj1_check[OBJ1_SIZE];
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, inst, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+  }
+}
+
+TEST_F(LogfsTestCooked, DeleteDuringBackgroundGarbageCollect) {
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+  for (uint16_t inst = 0; inst < 4; inst++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ3_ID, inst, obj3, sizeof(obj3)));
+  }
+
+  /* Rewrite obj1 until the log is full enough to collect in the background */
+  int32_t rc = 0;
+  for (uint32_t i = 0; rc == 0; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, (i % 2) ? obj1_alt : obj1, sizeof(obj1)));
+    rc = PIOS_FLASHFS_Logfs_GarbageCollectStep(fs_id);
+  }
+
+  /* The destination is erased, this step moves obj2 from the first slot and a copy of obj3 */
+  EXPECT_EQ(1, rc);
+  EXPECT_EQ(1, PIOS_FLASHFS_Logfs_GarbageCollectStep(fs_id));
+
+  /* Delete it after it was moved, and save a new version of obj1 */
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ2_ID, 0));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1_alt, sizeof(obj1_alt)));
+
+  /* Finish the collection */
+  do {
+    rc = PIOS_FLASHFS_Logfs_GarbageCollectStep(fs_id);
+    EXPECT_LE(0, rc);
+  } while (rc > 0);
+
+  /* The deleted object must not come back from its moved copy */
+  unsigned char obj2_check[OBJ2_SIZE];
+  EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+
+  /* Which also holds after remounting */
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+}
+
+TEST_F(LogfsTestCooked, WriteUnchangedMany) {
+  /* Saving the same data again shouldn't use up the log */
+  for (uint32_t i = 0; i < 1000; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ0_ID, 0, NULL, 0));
+  }
+
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_GarbageCollectStep(fs_id));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+}
+
+struct batch_obj {
+  uint32_t id;
+  uint16_t inst_id;
+  uint8_t *data;
+  uint16_t size;
+};
+
+struct batch_ctx {
+  const struct batch_obj *objs;
+  uint32_t num_objs;
+  uint32_t next;
+};
+
+static bool batch_next(void *ctx, uint32_t *obj_id, uint16_t *obj_inst_id, uint8_t **obj_data, uint16_t *obj_size)
+{
+  struct batch_ctx *batch = (struct batch_ctx *)ctx;
+
+  if (batch->next >= batch->num_objs)
+    return false;
+
+  const struct batch_obj *obj = &batch->objs[batch->next++];
+  *obj_id = obj->id;
+  *obj_inst_id = obj->inst_id;
+  *obj_data = obj->data;
+  *obj_size = obj->size;
+  return true;
+}
+
+TEST_F(LogfsTestCooked, WriteBatchVerify) {
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1_alt, sizeof(obj1_alt)));
+
+  const struct batch_obj objs[] = {
+    { OBJ1_ID, 0, obj1, sizeof(obj1) },
+    { OBJ2_ID, 0, obj2, sizeof(obj2) },
+    { OBJ3_ID, 7, obj3, sizeof(obj3) },
+    { OBJ0_ID, 0, NULL, 0 },
+  };
+  struct batch_ctx batch = { objs, sizeof(objs) / sizeof(objs[0]), 0 };
+
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSaveBatch(fs_id, batch_next, &batch));
+  EXPECT_EQ(batch.num_objs, batch.next);
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+
+  unsigned char obj2_check[OBJ2_SIZE];
+  memset(obj2_check, 0, sizeof(obj2_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+  EXPECT_EQ(0, memcmp(obj2, obj2_check, sizeof(obj2)));
+
+  unsigned char obj3_check[OBJ3_SIZE];
+  memset(obj3_check, 0, sizeof(obj3_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ3_ID, 7, obj3_check, sizeof(obj3_check)));
+  EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
+
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ0_ID, 0, NULL, 0));
+}
+
 class LogfsTestCookedMultiPart : public LogfsTestRaw {
 protected:
   virtual void SetUp() {
@@ -0,0 +1,210 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Checks the PID kernels against each other and the filter they
+ * replaced, and times them
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <math.h>		/* sin, fabs */
+
+#include <chrono>		/* steady_clock */
+
+extern "C" {
+
+#include "misc_math.h"		/* bound_sym */
+#include "pid.h"		/* API for the PIDs */
+
+}
+
+#define DT 0.0005f		// 2 kHz, the fastest rate loop
+#define CUTOFF 20.0f
+#define STEPS 20000
+#define BENCH_STEPS 1000000
+
+// The derivative filter as it was, with two divisions; kept out of line
+// like the library calls it is timed against
+static float __attribute__((noinline)) old_apply_setpoint(struct pid *pid, float setpoint,
+		float measured, float dT)
+{
+	const float tau = 1.0f / (2 * (float) M_PI * CUTOFF);
+	float err = setpoint - measured;
+
+	pid->iAccumulator += err * (pid->i * dT);
+	pid->iAccumulator = bound_sym(pid->iAccumulator, pid->iLim);
+
+	float diff = err - pid->lastErr;
+	pid->lastErr = err;
+
+	float dterm = pid->lastDer + dT / (dT + tau) *
+		((diff * pid->d / dT) - pid->lastDer);
+	pid->lastDer = dterm;
+
+	return err * pid->p + pid->iAccumulator + dterm;
+}
+
+// A gyro chasing a stick, with some noise on it
+static void axis_input(int step, int axis, float *setpoint, float *measured)
+{
+	float t = step * DT;
+
+	*setpoint = 200 * sinf(2 * t + axis);
+	*measured = *setpoint * 0.9f + 5 * sinf(300 * t * (axis + 1));
+}
+
+static void configure_axes(struct pid pids[3])
+{
+	pid_configure(&pids[0], 0.003f, 0.006f, 0.00003f, 0.3f);
+	pid_configure(&pids[1], 0.003f, 0.006f, 0.00003f, 0.3f);
+	pid_configure(&pids[2], 0.006f, 0.01f, 0.0001f, 0.3f);
+
+	for (int i = 0; i < 3; i++) {
+		pid_zero(&pids[i]);
+	}
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class PidTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    pid_configure_derivative(CUTOFF, 1.0f);
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(PidTest, MatchesOldFilter) {
+  struct pid pids[3], old[3];
+
+  configure_axes(pids);
+  configure_axes(old);
+
+  for (int step = 0; step < STEPS; step++) {
+    for (int i = 0; i < 3; i++) {
+      float setpoint, measured;
+      axis_input(step, i, &setpoint, &measured);
+
+      float out = pid_apply_setpoint(&pids[i], NULL, setpoint, measured, DT);
+      float ref = old_apply_setpoint(&old[i], setpoint, measured, DT);
+
+      ASSERT_NEAR(ref, out, 1e-5f + fabsf(ref) * 1e-4f);
+    }
+  }
+};
+
+TEST_F(PidTest, AxesMatchScalar) {
+  struct pid pids[3], axes[3];
+  struct pid_deadband deadbands[3];
+
+  configure_axes(pids);
+  configure_axes(axes);
+
+  for (int i = 0; i < 3; i++) {
+    pid_configure_deadband(&deadbands[i], 2.0f, 0.3f);
+  }
+
+  for (int step = 0; step < STEPS; step++) {
+    float setpoints[3], measured[3], out[3];
+
+    for (int i = 0; i < 3; i++) {
+      axis_input(step, i, &setpoints[i], &measured[i]);
+    }
+
+    pid_apply_setpoint_axes(axes, deadbands, setpoints, measured, out, 3, DT);
+
+    for (int i = 0; i < 3; i++) {
+      float ref = pid_apply_setpoint(&pids[i], &deadbands[i],
+          setpoints[i], measured[i], DT);
+
+      ASSERT_FLOAT_EQ(ref, out[i]);
+    }
+  }
+};
+
+// Not a pass/fail test; the figures are to compare when changing the PIDs
+TEST_F(PidTest, Timing) {
+  struct pid pids[3];
+  float setpoints[3], measured[3], out[3];
+  float sink = 0;
+
+  // Not known when compiling, as in flight
+  volatile float dT_in = DT;
+  float dT = dT_in;
+
+  for (int i = 0; i < 3; i++) {
+    axis_input(1, i, &setpoints[i], &measured[i]);
+  }
+
+  configure_axes(pids);
+  auto start = std::chrono::steady_clock::now();
+  for (int step = 0; step < BENCH_STEPS; step++) {
+    for (int i = 0; i < 3; i++) {
+      sink += old_apply_setpoint(&pids[i], setpoints[i], measured[i] + step, dT);
+    }
+  }
+  auto mid = std::chrono::steady_clock::now();
+
+  configure_axes(pids);
+  for (int step = 0; step < BENCH_STEPS; step++) {
+    for (int i = 0; i < 3; i++) {
+      sink += pid_apply_setpoint(&pids[i], NULL, setpoints[i], measured[i] + step, dT);
+    }
+  }
+  auto mid2 = std::chrono::steady_clock::now();
+
+  configure_axes(pids);
+  for (int step = 0; step < BENCH_STEPS; step++) {
+    measured[0] += 1;
+    measured[1] += 1;
+    measured[2] += 1;
+    pid_apply_setpoint_axes(pids, NULL, setpoints, measured, out, 3, dT);
+    sink += out[0] + out[1] + out[2];
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double ns_old = std::chrono::duration<double, std::nano>(mid - start).count() / BENCH_STEPS;
+  double ns_scalar = std::chrono::duration<double, std::nano>(mid2 - mid).count() / BENCH_STEPS;
+  double ns_axes = std::chrono::duration<double, std::nano>(end - mid2).count() / BENCH_STEPS;
+
+  printf("three axes: %.1f ns old filter, %.1f ns scalar, %.1f ns batched (%g)\n",
+      ns_old, ns_scalar, ns_axes, sink);
+
+  testing::Test::RecordProperty("OldNs", (int) ns_old);
+  testing::Test::RecordProperty("ScalarNs", (int) ns_scalar);
+  testing::Test::RecordProperty("AxesNs", (int) ns_axes);
+};
+
+/**
+ * @}
+ * @}
+ */
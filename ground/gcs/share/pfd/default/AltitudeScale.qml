@@ -30,7 +30,7 @@ Item {
             property int topNumber: Math.floor(altitude/5)*5 + 15
             property int bottomNumber: Math.floor(altitude/5)*5 - 15
             property real unitHeight: altitude_scale.height / 30
-            property real altitude: -PositionActual.Down
+            property real altitude: -FlightState.down
 
             SvgElementImage {
                 id: altitude_desired
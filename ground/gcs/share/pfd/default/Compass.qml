@@ -16,8 +16,8 @@ Item {
         y: Math.floor(scaledBounds.y * sceneItem.height)
         //anchors.horizontalCenter: parent.horizontalCenter
 
-        //AttitudeActual.Yaw is converted to -180..180 range
-        property real yaw : sceneItem.parent.circular_modulus_deg(AttitudeActual.Yaw)
+        //FlightState.yaw is converted to -180..180 range
+        property real yaw : sceneItem.parent.circular_modulus_deg(FlightState.yaw)
 
         //split compass band to 8 parts to ensure it doesn't exceed the max texture size
         Row {
@@ -46,7 +46,7 @@ Item {
 
             visible: HomeLocation.Set !== 0
 
-            property real bearing_D : Math.atan2(-PositionActual.East, -PositionActual.North)*180/Math.PI
+            property real bearing_D : Math.atan2(-FlightState.east, -FlightState.north)*180/Math.PI
 
             anchors.centerIn: parent
             //convert bearing-compass.yaw to -180..180 range as compass_band_composed
@@ -65,7 +65,7 @@ Item {
 
             visible:  Waypoint.Position_North !== 0 || Waypoint.Position_East !== 0 || Waypoint.Position_Down !== 0
 
-            property real bearing_D : Math.atan2(Waypoint.Position_East - PositionActual.East, Waypoint.Position_North - PositionActual.North)*180/Math.PI
+            property real bearing_D : Math.atan2(Waypoint.Position_East - FlightState.east, Waypoint.Position_North - FlightState.north)*180/Math.PI
 
             anchors.centerIn: parent
             //convert bearing-compass.yaw to -180..180 range as compass_band_composed
@@ -79,19 +79,19 @@ Item {
             elementName: "unfiltered-compass-bearing"
             sceneSize: sceneItem.sceneSize
 
-            visible: Magnetometer.x !== 0 || Magnetometer.y !==0 || Magnetometer.z !==0
+            visible: FlightState.magX !== 0 || FlightState.magY !==0 || FlightState.magZ !==0
 
             // Calculate unfiltered magnetic heading, corrected for magnetic inclination
             function calculateHeading()
             {
-                var cP=Math.cos(AttitudeActual.Yaw*Math.PI/180*0)
-                var sP=Math.sin(AttitudeActual.Yaw*Math.PI/180*0)
+                var cP=Math.cos(FlightState.yaw*Math.PI/180*0)
+                var sP=Math.sin(FlightState.yaw*Math.PI/180*0)
 
-                var cT=Math.cos(AttitudeActual.Pitch*Math.PI/180)
-                var sT=Math.sin(AttitudeActual.Pitch*Math.PI/180)
+                var cT=Math.cos(FlightState.pitch*Math.PI/180)
+                var sT=Math.sin(FlightState.pitch*Math.PI/180)
 
-                var cF=Math.cos(AttitudeActual.Roll*Math.PI/180)
-                var sF=Math.sin(AttitudeActual.Roll*Math.PI/180)
+                var cF=Math.cos(FlightState.roll*Math.PI/180)
+                var sF=Math.sin(FlightState.roll*Math.PI/180)
 
                 var Rbe00 = cT*cP
                 var Rbe01 = cT*sP
@@ -104,8 +104,8 @@ Item {
                 var Rbe22 = cT*cF
 
                 // Rotate body frame magnetometer measurment into Earth frame.
-                var mag_N = Rbe00*Magnetometer.x + Rbe10*Magnetometer.y + Rbe20*Magnetometer.z
-                var mag_E = Rbe01*Magnetometer.x + Rbe11*Magnetometer.y + Rbe21*Magnetometer.z
+                var mag_N = Rbe00*FlightState.magX + Rbe10*FlightState.magY + Rbe20*FlightState.magZ
+                var mag_E = Rbe01*FlightState.magX + Rbe11*FlightState.magY + Rbe21*FlightState.magZ
 
                 // Calculate compass heading, relative to magnetic North
                 var magnetic_heading_R = Math.atan2(-mag_E, mag_N)
@@ -4,9 +4,9 @@ Item {
     id: sceneItem
     property variant sceneSize
 
-    //AttitudeActual.Yaw is converted to -180..180 range
-    property real yaw: sceneItem.parent.circular_modulus_deg(AttitudeActual.Yaw)
-    property real pitch : (AttitudeActual.Pitch)
+    //FlightState.yaw is converted to -180..180 range
+    property real yaw: sceneItem.parent.circular_modulus_deg(FlightState.yaw)
+    property real pitch : (FlightState.pitch)
 
     // Telemetry status arrow
     SvgElementImage {
@@ -83,7 +83,7 @@ Item {
                 y: -homelocation.parent.height/2*Math.sin(homewaypoint.elevation_R)*(Math.sin(Math.PI/2)/Math.sin(parent.fovY_D*Math.PI/180/2))
             },
             Rotation {
-                angle: -AttitudeActual.Roll
+                angle: -FlightState.roll
                 origin.x : homelocation.parent.width/2
                 origin.y : homelocation.parent.height/2
             }
@@ -98,8 +98,8 @@ Item {
             // Home location is only visible if it is set and when it is in front of the viewport
             visible: (HomeLocation.Set != 0 && Math.abs(bearing_R) < Math.PI/2)
 
-            property real bearing_R : sceneItem.parent.circular_modulus_rad(Math.atan2(-PositionActual.East, -PositionActual.North) - yaw*Math.PI/180)
-            property real elevation_R : Math.atan(-PositionActual.Down / -Math.sqrt(Math.pow(PositionActual.North,2)+Math.pow(PositionActual.East,2))) - pitch*Math.PI/180
+            property real bearing_R : sceneItem.parent.circular_modulus_rad(Math.atan2(-FlightState.east, -FlightState.north) - yaw*Math.PI/180)
+            property real elevation_R : Math.atan(-FlightState.down / -Math.sqrt(Math.pow(FlightState.north,2)+Math.pow(FlightState.east,2))) - pitch*Math.PI/180
 
             // Center the home location marker in the middle of the PFD
             anchors.centerIn: parent
@@ -118,7 +118,7 @@ Item {
                 y: -waypoint.parent.height/2*Math.sin(nextwaypoint.elevation_R)*(Math.sin(Math.PI/2)/Math.sin(parent.fovY_D*Math.PI/180/2))
             },
             Rotation {
-                angle: -AttitudeActual.Roll
+                angle: -FlightState.roll
                 origin.x : waypoint.parent.width/2
                 origin.y : waypoint.parent.height/2
             }
@@ -139,8 +139,8 @@ Item {
             // Waypoint is only visible when it is in front of the viewport
             visible: (Math.abs(bearing_R) < Math.PI/2 && (Waypoint.Position_North != 0 || Waypoint.Position_East != 0 || Waypoint.Position_Down != 0))
 
-            property real bearing_R : sceneItem.parent.circular_modulus_rad(Math.atan2(Waypoint.Position_East - PositionActual.East, Waypoint.Position_North - PositionActual.North) - yaw*Math.PI/180)
-            property real elevation_R : Math.atan((Waypoint.Position_Down - PositionActual.Down) / -Math.sqrt(Math.pow(Waypoint.Position_North - PositionActual.North,2)+Math.pow(Waypoint.Position_East - PositionActual.East,2))) - pitch*Math.PI/180
+            property real bearing_R : sceneItem.parent.circular_modulus_rad(Math.atan2(Waypoint.Position_East - FlightState.east, Waypoint.Position_North - FlightState.north) - yaw*Math.PI/180)
+            property real elevation_R : Math.atan((Waypoint.Position_Down - FlightState.down) / -Math.sqrt(Math.pow(Waypoint.Position_North - FlightState.north,2)+Math.pow(Waypoint.Position_East - FlightState.east,2))) - pitch*Math.PI/180
 
             // Center the home location marker in the middle of the PFD
             anchors.centerIn: parent
@@ -10,9 +10,9 @@ Item {
         sceneFile: qmlWidget.earthFile
         fieldOfView: 90
 
-        yaw: AttitudeActual.Yaw
-        pitch: AttitudeActual.Pitch
-        roll: AttitudeActual.Roll
+        yaw: FlightState.yaw
+        pitch: FlightState.pitch
+        roll: FlightState.roll
 
         latitude: qmlWidget.actualPositionUsed ?
                       GPSPosition.Latitude/10000000.0 : qmlWidget.latitude
@@ -32,10 +32,10 @@ Item {
                 id: pitchTranslate
                 x: Math.round((world.parent.width - world.width)/2)
                 y: (world.parent.height - world.height)/2+
-                   world.parent.height/2*Math.sin(AttitudeActual.Pitch*Math.PI/180)*1.405
+                   world.parent.height/2*Math.sin(FlightState.pitch*Math.PI/180)*1.405
             },
             Rotation {
-                angle: -AttitudeActual.Roll
+                angle: -FlightState.roll
                 origin.x : world.parent.width/2
                 origin.y : world.parent.height/2
             }
@@ -3,7 +3,7 @@ import QtQuick 2.0
 Item {
     id: sceneItem
     property variant sceneSize
-    property real calibratedAirspeed : 3.6 * AirspeedActual.CalibratedAirspeed
+    property real calibratedAirspeed : 3.6 * FlightState.calibratedAirspeed
 
 
     // Create speed ticker
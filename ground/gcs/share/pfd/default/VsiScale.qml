@@ -20,9 +20,9 @@ Item {
             sceneSize: sceneItem.sceneSize
 
             //the scale in 1000 ft/min with height == 5200 ft/min
-            height: (Math.abs(VelocityActual.Down)*3.28*60/1000)*vsi_scale.unitHeight
+            height: (Math.abs(FlightState.velocityDown)*3.28*60/1000)*vsi_scale.unitHeight
 
-            anchors.verticalCenterOffset: (VelocityActual.Down*3.28*60/1000)*vsi_scale.unitHeight / 2.0
+            anchors.verticalCenterOffset: (FlightState.velocityDown*3.28*60/1000)*vsi_scale.unitHeight / 2.0
 
             anchors.verticalCenter: parent.verticalCenter
 
@@ -32,6 +32,7 @@
 #define COMMAND_LINE_NO_LOAD "no-load"
 #define COMMAND_LINE_TEST "test"
 #define COMMAND_LINE_PLUGIN_OPTION "plugin-option"
+#define COMMAND_LINE_TRACE "trace"
 
 #include "utils/xmlconfig.h"
 #include "utils/pathutils.h"
@@ -39,6 +40,7 @@
 #include <extensionsystem/pluginmanager.h>
 #include <extensionsystem/pluginspec.h>
 #include <extensionsystem/iplugin.h>
+#include <extensionsystem/tracelog.h>
 
 #include <QtCore/QDir>
 #include <QtCore/QTextStream>
@@ -270,12 +272,16 @@ int main(int argc, char **argv)
     // The options are passed to the plugin init as a QStringList i.e. >> iplugin::initialize(const QStringList &arguments, QString *errorString)
     // These options need to be set in the pluginspec file (look in the Core.pluginspec file for an example)
     parser.addOption(pluginOption);
+    QCommandLineOption traceOption(COMMAND_LINE_TRACE, QCoreApplication::translate("main", "Writes the time taken by startup and connecting to a board to a Chrome trace file, when the GCS exits."), QCoreApplication::translate("main", "trace file"), "");
+    parser.addOption(traceOption);
     parser.addPositionalArgument("config", QCoreApplication::translate("main", "Use the specified configuration file."), QCoreApplication::translate("main", "config file"));
     if (!parser.parse(QCoreApplication::arguments())) {
          displayError(parser.errorText());
          displayHelpText(parser.helpText());
         return 1;
     }
+    if (parser.isSet(traceOption))
+        ExtensionSystem::TraceLog::start(parser.value(traceOption));
     QString settingsFilename;
     QStringList positionalArguments = parser.positionalArguments();
     {
@@ -379,7 +385,10 @@ int main(int argc, char **argv)
     QObject::connect(&pluginManager,SIGNAL(hideSplash()),&splash,SLOT(hide()));
     QObject::connect(&pluginManager,SIGNAL(showSplash()),&splash,SLOT(show()));
 
-    pluginManager.loadPlugins();
+    {
+        ExtensionSystem::TraceScope trace("Load plugins", "plugins");
+        pluginManager.loadPlugins();
+    }
     {
         QStringList errors;
         foreach (ExtensionSystem::PluginSpec *p, pluginManager.plugins())
@@ -393,5 +402,7 @@ int main(int argc, char **argv)
     QObject::connect(&app, SIGNAL(instanceStarted(void)), coreplugin->plugin(), SLOT(remoteArgument()));
     QTimer::singleShot(100, &pluginManager, SLOT(startTests()));
     splash.close();
-    return app.exec();
+    int ret = app.exec();
+    ExtensionSystem::TraceLog::finish();
+    return ret;
 }
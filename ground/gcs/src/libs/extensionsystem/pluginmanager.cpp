@@ -33,6 +33,7 @@
 #include "pluginspec_p.h"
 #include "optionsparser.h"
 #include "iplugin.h"
+#include "tracelog.h"
 
 #include <QtCore/QMetaProperty>
 #include <QtCore/QDir>
@@ -547,6 +548,7 @@ void PluginManagerPrivate::loadPlugins()
     QList<PluginSpec *> queue = loadQueue();
     foreach (PluginSpec *spec, queue) {
         emit q->splashMessages(QString(QObject::tr("Loading %1 plugin")).arg(spec->name()));
+        TraceScope trace("Load " + spec->name(), "plugins");
         loadPlugin(spec, PluginSpec::Loaded);
         if(spec->name() == "Core") {
             QObject::connect(spec->plugin(),SIGNAL(splashMessages(QString)), q, SIGNAL(splashMessages(QString)));
@@ -557,12 +559,15 @@ void PluginManagerPrivate::loadPlugins()
 
     foreach (PluginSpec *spec, queue) {
         emit q->splashMessages(QString(QObject::tr("Initializing %1 plugin")).arg(spec->name()));
+        TraceScope trace("Initialize " + spec->name(), "plugins");
         loadPlugin(spec, PluginSpec::Initialized);
     }
     QListIterator<PluginSpec *> it(queue);
     it.toBack();
     while (it.hasPrevious()) {
-        loadPlugin(it.previous(), PluginSpec::Running);
+        PluginSpec *spec = it.previous();
+        TraceScope trace("Extensions initialized " + spec->name(), "plugins");
+        loadPlugin(spec, PluginSpec::Running);
     }
     emit q->pluginsChanged();
     q->m_allPluginsLoaded=true;
@@ -0,0 +1,184 @@
+/**
+ ******************************************************************************
+ * @file       tracelog.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Timing trace of startup and connection, in Chrome trace format
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "tracelog.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+
+using namespace ExtensionSystem;
+
+bool TraceLog::enabled = false;
+
+namespace {
+
+// Only touched with lock held, once enabled is set
+QMutex lock;
+QString traceFileName;
+QElapsedTimer clock;
+QStringList events;
+QHash<Qt::HANDLE, int> threadIds;
+
+QString jsonString(const QString &s)
+{
+    QString out;
+    out.reserve(s.size() + 2);
+    out += QLatin1Char('"');
+    foreach (QChar c, s) {
+        if (c == QLatin1Char('"') || c == QLatin1Char('\\'))
+            out += QLatin1Char('\\');
+        if (c.unicode() < 0x20)
+            out += QString("\\u%1").arg(c.unicode(), 4, 16, QLatin1Char('0'));
+        else
+            out += c;
+    }
+    out += QLatin1Char('"');
+    return out;
+}
+
+} // namespace
+
+/**
+ * @brief Starts recording, to be written to fileName by finish()
+ */
+void TraceLog::start(const QString &fileName)
+{
+    QMutexLocker locker(&lock);
+    traceFileName = fileName;
+    events.clear();
+    threadIds.clear();
+    clock.start();
+    enabled = true;
+}
+
+/**
+ * @brief Stops recording and writes the trace
+ * @return false if it couldn't be written
+ */
+bool TraceLog::finish()
+{
+    QMutexLocker locker(&lock);
+    if (!enabled)
+        return true;
+    enabled = false;
+
+    QFile file(traceFileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Could not write the trace to" << traceFileName;
+        return false;
+    }
+
+    file.write("{\"traceEvents\":[\n");
+    file.write(events.join(QLatin1String(",\n")).toUtf8());
+    file.write("\n]}\n");
+
+    events.clear();
+    return true;
+}
+
+/**
+ * @brief Microseconds since start()
+ */
+qint64 TraceLog::nowUs()
+{
+    return clock.nsecsElapsed() / 1000;
+}
+
+void TraceLog::complete(const QString &name, const char *category,
+                        qint64 startUs, qint64 durationUs)
+{
+    add(name, category, 'X', startUs, QString("\"dur\":%1").arg(durationUs));
+}
+
+void TraceLog::instant(const QString &name, const char *category)
+{
+    add(name, category, 'i', nowUs(), QLatin1String("\"s\":\"p\""));
+}
+
+void TraceLog::asyncBegin(const QString &name, const char *category)
+{
+    add(name, category, 'b', nowUs(), QString("\"id\":%1").arg(qHash(name)));
+}
+
+/**
+ * @brief Ends the phase asyncBegin() started with the same name
+ * @param detail shown with the end in the viewer, e.g. a count
+ */
+void TraceLog::asyncEnd(const QString &name, const char *category,
+                        const QString &detail)
+{
+    QString extra = QString("\"id\":%1").arg(qHash(name));
+    if (!detail.isEmpty())
+        extra += QString(",\"args\":{\"detail\":%1}").arg(jsonString(detail));
+    add(name, category, 'e', nowUs(), extra);
+}
+
+void TraceLog::add(const QString &name, const char *category, char phase,
+                   qint64 timeUs, const QString &extra)
+{
+    if (!enabled)
+        return;
+
+    QMutexLocker locker(&lock);
+    if (!enabled)
+        return;
+
+    // Small thread numbers read better than handles
+    Qt::HANDLE thread = QThread::currentThreadId();
+    if (!threadIds.contains(thread))
+        threadIds.insert(thread, threadIds.count());
+
+    // Built by appending, since the name could contain %1 and the like
+    QString event = QLatin1String("{\"name\":") + jsonString(name) +
+            QLatin1String(",\"cat\":\"") + QLatin1String(category) +
+            QLatin1String("\",\"ph\":\"") + QLatin1Char(phase) +
+            QLatin1String("\",\"ts\":") + QString::number(timeUs) +
+            QLatin1String(",\"pid\":") + QString::number(QCoreApplication::applicationPid()) +
+            QLatin1String(",\"tid\":") + QString::number(threadIds.value(thread));
+    if (!extra.isEmpty())
+        event += QLatin1Char(',') + extra;
+    event += QLatin1Char('}');
+
+    events.append(event);
+}
+
+TraceScope::TraceScope(const QString &name, const char *category) :
+    m_category(category),
+    m_startUs(-1)
+{
+    if (TraceLog::isEnabled()) {
+        m_name = name;
+        m_startUs = TraceLog::nowUs();
+    }
+}
+
+TraceScope::~TraceScope()
+{
+    if (m_startUs >= 0)
+        TraceLog::complete(m_name, m_category, m_startUs,
+                           TraceLog::nowUs() - m_startUs);
+}
@@ -0,0 +1,85 @@
+/**
+ ******************************************************************************
+ * @file       tracelog.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Timing trace of startup and connection, in Chrome trace format
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef EXTENSIONSYSTEM_TRACELOG_H
+#define EXTENSIONSYSTEM_TRACELOG_H
+
+#include "extensionsystem_global.h"
+
+#include <QtCore/QString>
+
+namespace ExtensionSystem {
+
+/**
+ * @brief Collects timed events while the GCS runs, and writes them out at
+ * exit as a Chrome trace (load it in chrome://tracing).
+ *
+ * Nothing is recorded unless start() was called, which main() does when
+ * given --trace, so the trace points cost a check of a flag otherwise.
+ *
+ * Phases that finish within a function are timed with a TraceScope.
+ * Phases that span the event loop, like connecting to a board, use
+ * asyncBegin() and asyncEnd() with the same name.
+ */
+class EXTENSIONSYSTEM_EXPORT TraceLog
+{
+public:
+    static void start(const QString &fileName);
+    static bool finish();
+
+    static inline bool isEnabled() { return enabled; }
+
+    static void complete(const QString &name, const char *category,
+                         qint64 startUs, qint64 durationUs);
+    static void instant(const QString &name, const char *category);
+    static void asyncBegin(const QString &name, const char *category);
+    static void asyncEnd(const QString &name, const char *category,
+                         const QString &detail = QString());
+
+    static qint64 nowUs();
+
+private:
+    static void add(const QString &name, const char *category, char phase,
+                    qint64 timeUs, const QString &extra);
+
+    static bool enabled;
+};
+
+/**
+ * @brief Records the time from its construction to the end of its scope
+ */
+class EXTENSIONSYSTEM_EXPORT TraceScope
+{
+public:
+    explicit TraceScope(const QString &name, const char *category = "gcs");
+    ~TraceScope();
+
+private:
+    Q_DISABLE_COPY(TraceScope)
+
+    QString m_name;
+    const char *m_category;
+    qint64 m_startUs;
+};
+
+} // namespace ExtensionSystem
+
+#endif // EXTENSIONSYSTEM_TRACELOG_H
@@ -44,8 +44,9 @@ namespace core {
     int KiberTileCache::MemoryCacheCapacity()
     {
         kiberCacheLock.lockForRead();
-        return _MemoryCacheCapacity;
+        int capacity=_MemoryCacheCapacity;
         kiberCacheLock.unlock();
+        return capacity;
     }
 
     void KiberTileCache::RemoveMemoryOverload()
@@ -30,7 +30,7 @@
 namespace core {
     MemoryCache::MemoryCache()
     {
-
+        setDecodedCacheCapacity(64);
     }
 
 
@@ -56,5 +56,21 @@ namespace core {
 
         kiberCacheLock.unlock();
     }
+    QImage MemoryCache::GetDecodedTileFromMemoryCache(const RawTile &tile)
+    {
+        QMutexLocker locker(&decodedTilesLock);
+        QImage *image=decodedTiles.object(tile);
+        return image ? *image : QImage();
+    }
+    void MemoryCache::AddDecodedTileToMemoryCache(const RawTile &tile, const QImage &image)
+    {
+        QMutexLocker locker(&decodedTilesLock);
+        decodedTiles.insert(tile,new QImage(image),image.byteCount());
+    }
+    void MemoryCache::setDecodedCacheCapacity(const int &megabytes)
+    {
+        QMutexLocker locker(&decodedTilesLock);
+        decodedTiles.setMaxCost(megabytes*1048576);
+    }
 
 }
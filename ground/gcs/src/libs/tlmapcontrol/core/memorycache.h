@@ -31,6 +31,8 @@
 #include <QMutex>
 #include <QReadWriteLock>
 #include <QQueue>
+#include <QCache>
+#include <QImage>
 #include "kibertilecache.h"
 #include <QDebug>
 #include "debugheader.h"
@@ -44,6 +46,15 @@ namespace core {
         QByteArray GetTileFromMemoryCache(const RawTile &tile);
         void AddTileToMemoryCache(const RawTile &tile, const QByteArray &pic);
         QReadWriteLock kiberCacheLock;
+
+        QImage GetDecodedTileFromMemoryCache(const RawTile &tile);
+        void AddDecodedTileToMemoryCache(const RawTile &tile, const QImage &image);
+        void setDecodedCacheCapacity(const int &megabytes);
+    private:
+        // Tiles decoded by the loaders, second level to TilesInMemory. The
+        // least recently used ones go once the decoded bytes exceed the capacity
+        QCache<RawTile, QImage> decodedTiles;
+        QMutex decodedTilesLock;
     };
 
 
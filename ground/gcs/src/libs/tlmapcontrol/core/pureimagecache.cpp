@@ -28,18 +28,118 @@
 #include <QDateTime>
 #include <QSettings>
 //#define DEBUG_PUREIMAGECACHE
+
+// Tiles written in one transaction before it is committed
+#define TILES_PER_TRANSACTION 64
+
 namespace core {
     qlonglong PureImageCache::ConnCounter=0;
 
-    PureImageCache::PureImageCache()
+    /**
+     * An open connection to the cache database with its prepared statements.
+     * A QSqlDatabase may only be used from the thread that opened it, each
+     * thread gets its own one.
+     */
+    class PureImageCache::Connection
+    {
+    public:
+        Connection(const QString &file, qlonglong id, int generation);
+        ~Connection();
+        void Commit();
+
+        QString name;
+        int generation;
+        QSqlDatabase cn;
+        QSqlQuery *getTile;
+        QSqlQuery *putTile;
+        QSqlQuery *putTileData;
+        int pending;            // Tiles written in the open transaction
+    };
+
+    PureImageCache::Connection::Connection(const QString &file, qlonglong id, int generation) :
+        name(QString("TileCache%1").arg(id)),
+        generation(generation),
+        getTile(0),
+        putTile(0),
+        putTileData(0),
+        pending(0)
     {
+        cn = QSqlDatabase::addDatabase("QSQLITE",name);
+        cn.setDatabaseName(file);
+        cn.setConnectOptions("QSQLITE_BUSY_TIMEOUT=2000");
+        if(!cn.open())
+        {
+#ifdef DEBUG_PUREIMAGECACHE
+            qDebug()<<"Connection: Unable to open database"<<cn.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+            return;
+        }
+        {
+            QSqlQuery query(cn);
+            // The write ahead log lets the loader threads read while tiles are written
+            query.exec("PRAGMA journal_mode=WAL");
+            query.exec("PRAGMA synchronous=NORMAL");
+            // Caches created before the index was added to CreateEmptyDB
+            query.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (X, Y, Zoom, Type)");
+        }
+        getTile=new QSqlQuery(cn);
+        getTile->prepare("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=? AND Y=? AND Zoom=? AND Type=?)");
+        putTile=new QSqlQuery(cn);
+        putTile->prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
+        putTileData=new QSqlQuery(cn);
+        putTileData->prepare("INSERT INTO TilesData(id, Tile) VALUES(?, ?)");
+    }
 
+    PureImageCache::Connection::~Connection()
+    {
+        Commit();
+        delete getTile;
+        delete putTile;
+        delete putTileData;
+        cn.close();
+        // No handle to the connection may be left when it is removed
+        cn=QSqlDatabase();
+        QSqlDatabase::removeDatabase(name);
+    }
+
+    void PureImageCache::Connection::Commit()
+    {
+        if(pending>0)
+        {
+            cn.commit();
+            pending=0;
+        }
+    }
+
+    PureImageCache::PureImageCache() :
+        generation(0)
+    {
+
+    }
+
+    /**
+     * The connection of the calling thread, opened on first use
+     */
+    PureImageCache::Connection *PureImageCache::ThreadConnection()
+    {
+        Connection *connection=connections.localData();
+        if(connection==0 || connection->generation!=generation)
+        {
+            Mcounter.lock();
+            qlonglong id=++ConnCounter;
+            Mcounter.unlock();
+            // Replacing the local data deletes the previous connection
+            connection=new Connection(gtilecache+"Data.qmdb",id,generation);
+            connections.setLocalData(connection);
+        }
+        return connection;
     }
 
     void PureImageCache::setGtileCache(const QString &value)
     {
         lock.lockForWrite();
         gtilecache=value;
+        ++generation;
         QDir d;
         if(!d.exists(gtilecache))
         {
@@ -109,6 +209,15 @@ namespace core {
             {
 #ifdef DEBUG_PUREIMAGECACHE
                 qDebug()<<"CreateEmptyDB: "<<query.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+                db.close();
+                return false;
+            }
+            query.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (X, Y, Zoom, Type)");
+            if(query.numRowsAffected()==-1)
+            {
+#ifdef DEBUG_PUREIMAGECACHE
+                qDebug()<<"CreateEmptyDB: "<<query.lastError().driverText();
 #endif //DEBUG_PUREIMAGECACHE
                 db.close();
                 return false;
@@ -179,80 +288,66 @@ namespace core {
 #ifdef DEBUG_PUREIMAGECACHE
         qDebug()<<"PutImageToCache Start:";//<<pos;
 #endif //DEBUG_PUREIMAGECACHE
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        Connection *connection=ThreadConnection();
+        if(connection->cn.isOpen())
         {
-            QSqlDatabase cn;
-            cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-            QString db=gtilecache+"Data.qmdb";
-            cn.setDatabaseName(db);
-            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-            if(cn.open())
-            {
-                {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
-                    query.addBindValue(pos.X());
-                    query.addBindValue(pos.Y());
-                    query.addBindValue(zoom);
+            // Tiles are written in batches, a transaction per tile would
+            // wait on the disk for every one of them
+            if(connection->pending==0)
+                connection->cn.transaction();
 
-                    query.addBindValue((int)type);
-                    query.addBindValue(QDateTime::currentDateTime().toString());
-                    query.exec();
-                }
-                {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
-                    query.addBindValue(tile);
-                    query.exec();
-                }
-                cn.close();
+            QSqlQuery *query=connection->putTile;
+            query->addBindValue(pos.X());
+            query->addBindValue(pos.Y());
+            query->addBindValue(zoom);
+            query->addBindValue((int)type);
+            query->addBindValue(QDateTime::currentDateTime().toString());
+            if(query->exec())
+            {
+                query=connection->putTileData;
+                query->addBindValue(connection->putTile->lastInsertId());
+                query->addBindValue(tile);
+                query->exec();
             }
+            if(++connection->pending>=TILES_PER_TRANSACTION)
+                connection->Commit();
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
         lock.unlock();
         return true;
     }
-    QByteArray PureImageCache::GetImageFromCache(MapType::Types type, Point pos, int zoom)
+    /**
+     * Commit the tiles the calling thread wrote so far
+     */
+    void PureImageCache::FlushCache()
     {
         lock.lockForRead();
+        Connection *connection=connections.localData();
+        if(connection!=0)
+            connection->Commit();
+        lock.unlock();
+    }
+    QByteArray PureImageCache::GetImageFromCache(MapType::Types type, Point pos, int zoom)
+    {
         QByteArray ar;
         if(gtilecache.isEmpty()|gtilecache.isNull())
             return ar;
-        QString dir=gtilecache;
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        lock.lockForRead();
 #ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"Cache dir="<<dir<<" Try to GET:"<<pos.X()+","+pos.Y();
+        qDebug()<<"Cache dir="<<gtilecache<<" Try to GET:"<<pos.X()+","+pos.Y();
 #endif //DEBUG_PUREIMAGECACHE
-
+        Connection *connection=ThreadConnection();
+        if(connection->cn.isOpen())
         {
-            QString db=dir+"Data.qmdb";
-            {
-                QSqlDatabase cn;
-
-                cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-
-                cn.setDatabaseName(db);
-                cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-                if(cn.open())
-                {
-                    {
-                        QSqlQuery query(cn);
-                        query.exec(QString("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=%1 AND Y=%2 AND Zoom=%3 AND Type=%4)").arg(pos.X()).arg(pos.Y()).arg(zoom).arg((int) type));
-                        query.next();
-                        if(query.isValid())
-                        {
-                            ar=query.value(0).toByteArray();
-                        }
-                    }
-                    cn.close();
-                }
-            }
+            QSqlQuery *query=connection->getTile;
+            query->addBindValue(pos.X());
+            query->addBindValue(pos.Y());
+            query->addBindValue(zoom);
+            query->addBindValue((int) type);
+            if(query->exec() && query->next())
+                ar=query->value(0).toByteArray();
+            // Release the read, or the statement keeps its snapshot of the database
+            query->finish();
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
         lock.unlock();
         return ar;
     }
@@ -320,7 +415,11 @@ namespace core {
             if(cb.open())
             {
                 QSqlQuery queryb(cb);
+                // The tiles are looked up by position for every source tile
+                queryb.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (X, Y, Zoom, Type)");
                 queryb.exec(QString("ATTACH DATABASE \"%1\" AS Source").arg(sourceFile));
+                // One transaction for the whole copy, instead of one per statement
+                cb.transaction();
                 QSqlQuery querya(ca);
                 querya.exec("SELECT id, X, Y, Zoom, Type, Date FROM Tiles");
                 while(querya.next())
@@ -339,6 +438,7 @@ namespace core {
                     queryb.exec(QString("INSERT INTO Tiles(X, Y, Zoom, Type, Date) SELECT X, Y, Zoom, Type, Date FROM Source.Tiles WHERE id=%1").arg(f));
                     queryb.exec(QString("INSERT INTO TilesData(id, Tile) Values((SELECT last_insert_rowid()), (SELECT Tile FROM Source.TilesData WHERE id=%1))").arg(f));
                 }
+                cb.commit();
                 add.clear();
                 ca.close();
                 cb.close();
@@ -42,6 +42,7 @@
 #include <QList>
 #include <QMutex>
 #include <QReadWriteLock>
+#include <QThreadStorage>
 namespace core {
     class PureImageCache
     {
@@ -55,12 +56,21 @@ namespace core {
         void setGtileCache(const QString &value);
         static bool ExportMapDataToDB(QString sourceFile, QString destFile);
         void deleteOlderTiles(int const& days);
+        void FlushCache();
     private:
+        class Connection;
+        Connection *ThreadConnection();
+
         QString gtilecache;
         QMutex Mcounter;
         QReadWriteLock lock;
         static qlonglong ConnCounter;
 
+        // Connections stay open for the life of each thread using the
+        // cache, and are reopened once the cache moves
+        QThreadStorage<Connection *> connections;
+        int generation;
+
     };
 
 }
@@ -98,6 +98,8 @@ void TileCacheQueue::run()
 
         else
         {
+            // Commit the batch of tiles written while the queue was busy
+            Cache::Instance()->ImageCache.FlushCache();
 #ifdef DEBUG_TILECACHEQUEUE
             qDebug()<<"Cache engine BEGIN WAIT";
 #endif //DEBUG_TILECACHEQUEUE
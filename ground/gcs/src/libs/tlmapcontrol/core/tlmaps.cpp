@@ -59,6 +59,24 @@ namespace core {
         TileDBcacheQueue.wait();
     }
 
+    /**
+     * @brief TLMaps::ThreadNetwork The network access manager of the calling thread.
+     * Reusing it from one tile to the next keeps the connections to the tile
+     * servers alive, instead of connecting again for every tile.
+     * @return
+     */
+    QNetworkAccessManager *TLMaps::ThreadNetwork()
+    {
+        QNetworkAccessManager *network=networks.localData();
+        if(network==0)
+        {
+            network=new QNetworkAccessManager();
+            networks.setLocalData(network);
+        }
+        network->setProxy(Proxy);
+        return network;
+    }
+
     /**
      * @brief OPMaps::GetImageFromFile
      * @param type Type of map (Google Satellite, Bing, ARCGIS...)
@@ -367,13 +385,10 @@ namespace core {
                     QEventLoop q;
                     QNetworkReply *reply;
                     QNetworkRequest qheader;
-                    QNetworkAccessManager network;
+                    QNetworkAccessManager *network=ThreadNetwork();
                     QTimer tT;
                     tT.setSingleShot(true);
-                    connect(&network, SIGNAL(finished(QNetworkReply*)),
-                            &q, SLOT(quit()));
                     connect(&tT, SIGNAL(timeout()), &q, SLOT(quit()));
-                    network.setProxy(Proxy);
     #ifdef DEBUG_GMAPS
                     qDebug()<<"Try Tile from the Internet";
     #endif //DEBUG_GMAPS
@@ -388,6 +403,10 @@ namespace core {
                     qheader.setUrl(QUrl(url));
                     qheader.setRawHeader("User-Agent",UserAgent);
                     qheader.setRawHeader("Accept","*/*");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+                    // Servers that speak HTTP/2 serve all the tiles over one connection
+                    qheader.setAttribute(QNetworkRequest::HTTP2AllowedAttribute, true);
+#endif
                     switch(type)
                     {
                     case MapType::GoogleMap:
@@ -461,11 +480,16 @@ namespace core {
 #ifdef DEBUG_GMAPS
                     qDebug() << "qheader: " << qheader.url();
 #endif //DEBUG_GMAPS
-                    reply=network.get(qheader);
+                    reply=network->get(qheader);
+                    connect(reply, SIGNAL(finished()), &q, SLOT(quit()));
                     tT.start(Timeout);
                     q.exec();
 
+                    // The network manager outlives this call, so the replies are
+                    // deleted here. There is no event loop left to run deleteLater()
                     if(!tT.isActive()){
+                        reply->abort();
+                        delete reply;
                         errorvars.lock();
                         ++diag.timeouts;
                         errorvars.unlock();
@@ -477,11 +501,11 @@ namespace core {
                         errorvars.lock();
                         ++diag.networkerrors;
                         errorvars.unlock();
-                        reply->deleteLater();
+                        delete reply;
                         return ret;
                     }
                     ret=reply->readAll();
-                    reply->deleteLater();//TODO can't this be global??
+                    delete reply;
                     if(ret.isEmpty())
                     {
     #ifdef DEBUG_GMAPS
@@ -41,6 +41,8 @@
 #include "urlfactory.h"
 #include "diagnostics.h"
 
+#include <QThreadStorage>
+
 #include "../internals/pureprojection.h"
 #include "../internals/projections/lks94projection.h"
 #include "../internals/projections/mercatorprojection.h"
@@ -93,6 +95,11 @@ namespace core {
         int quadCoordBottom;
         QImage imScaled;
         int leastCommonZoom;
+
+        // A QNetworkAccessManager only serves the thread it was created in,
+        // each loader thread keeps its own for the life of the thread
+        QNetworkAccessManager *ThreadNetwork();
+        QThreadStorage<QNetworkAccessManager *> networks;
     };
 
 }
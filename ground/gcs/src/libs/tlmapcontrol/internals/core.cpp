@@ -27,6 +27,8 @@
 */
 #include "core.h"
 
+#include <algorithm>
+
 #ifdef DEBUG_CORE
 qlonglong internals::Core::debugcounter=0;
 #endif
@@ -34,6 +36,25 @@ qlonglong internals::Core::debugcounter=0;
 using namespace projections;
 
 namespace internals {
+    /**
+     * Orders the tiles to load from the center of the view outwards
+     */
+    struct CloserToCenter
+    {
+        CloserToCenter(const Point &center) : center(center) {}
+        bool operator()(const LoadTask &lhs, const LoadTask &rhs) const
+        {
+            return Distance(lhs.Pos) < Distance(rhs.Pos);
+        }
+        qint64 Distance(const Point &p) const
+        {
+            qint64 dx = p.X() - center.X();
+            qint64 dy = p.Y() - center.Y();
+            return dx * dx + dy * dy;
+        }
+        Point center;
+    };
+
     Core::Core():started(false),MouseWheelZooming(false),currentPosition(0,0),currentPositionPixel(0,0),LastLocationInBounds(-1,-1),sizeOfMapArea(0,0)
             ,minOfTiles(0,0),maxOfTiles(0,0),zoom(0),isDragging(false),TooltipTextPadding(10,10),mapType(MapType::None),loaderLimit(5),maxzoom(21),runningThreads(0)
     {
@@ -115,6 +136,19 @@ namespace internals {
                         {
                             int retry = 0;
 
+                            // Tiles decoded before skip the download and the decoding
+                            RawTile key(tl, task.Pos, task.Zoom);
+                            QImage decoded;
+                            if(tl != MapType::UserImage)
+                                decoded = TLMaps::Instance()->GetDecodedTileFromMemoryCache(key);
+                            if(!decoded.isNull())
+                            {
+                                Moverlays.lock();
+                                t->Overlays.append(decoded);
+                                Moverlays.unlock();
+                                continue;
+                            }
+
                             do
                             {
                                 QByteArray tileImage;
@@ -139,11 +173,19 @@ namespace internals {
 #endif //DEBUG_CORE
                                 }
 
+                                // Decode here in the loader, so painting never has to. The
+                                // premultiplied format is the one drawn without conversion
                                 if(tileImage.length()!=0)
+                                    decoded = QImage::fromData(tileImage).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+                                if(!decoded.isNull())
                                 {
+                                    if(tl != MapType::UserImage)
+                                        TLMaps::Instance()->AddDecodedTileToMemoryCache(key, decoded);
+
                                     Moverlays.lock();
                                     {
-                                        t->Overlays.append(tileImage);
+                                        t->Overlays.append(decoded);
 #ifdef DEBUG_CORE
                                         qDebug()<<"Core::run append tileImage:"<<tileImage.length()<<" to tile:"<<t->GetPos().ToString()<<" now has "<<t->Overlays.count()<<" overlays"<<" ID="<<debug;
 #endif //DEBUG_CORE
@@ -663,28 +705,44 @@ namespace internals {
             emit OnTileLoadStart();
 
 
-            foreach(Point p,tileDrawingList)
+            MtileLoadQueue.lock();
             {
-                LoadTask task = LoadTask(p, Zoom());
+                // Tiles that left the view are not worth loading anymore. Their
+                // runs still come, and find nothing or another tile to load
+                QQueue<LoadTask>::iterator it = tileLoadQueue.begin();
+                while(it != tileLoadQueue.end())
                 {
-                    MtileLoadQueue.lock();
+                    if(it->Zoom != Zoom() || !tileDrawingList.contains(it->Pos))
                     {
-                        if(!tileLoadQueue.contains(task))
-                        {
-                            MtileToload.lock();
-                            ++tilesToload;
-                            MtileToload.unlock();
-                            tileLoadQueue.enqueue(task);
+                        it = tileLoadQueue.erase(it);
+                        MtileToload.lock();
+                        --tilesToload;
+                        MtileToload.unlock();
+                    }
+                    else
+                        ++it;
+                }
+
+                foreach(Point p,tileDrawingList)
+                {
+                    LoadTask task = LoadTask(p, Zoom());
+                    if(!tileLoadQueue.contains(task))
+                    {
+                        MtileToload.lock();
+                        ++tilesToload;
+                        MtileToload.unlock();
+                        tileLoadQueue.enqueue(task);
 #ifdef DEBUG_CORE
-                            qDebug()<<"Core::UpdateBounds new Task"<<task.Pos.ToString();
+                        qDebug()<<"Core::UpdateBounds new Task"<<task.Pos.ToString();
 #endif //DEBUG_CORE
-                            ProcessLoadTaskCallback.start(this);
-                        }
+                        ProcessLoadTaskCallback.start(this);
                     }
-                    MtileLoadQueue.unlock();
                 }
 
+                // The loaders take the tiles closest to the center of the view first
+                std::stable_sort(tileLoadQueue.begin(), tileLoadQueue.end(), CloserToCenter(centerTileXYLocation));
             }
+            MtileLoadQueue.unlock();
         }
         MtileDrawingList.unlock();
         UpdateGroundResolution();
@@ -96,6 +96,7 @@ namespace mapcontrol
         void paintImage(QPainter* painter);
         void ConstructLastImage(int const& zoomdiff);
         internals::PureProjection* Projection()const{return core->Projection();}
+        qreal RenderTransform()const{return MapRenderTransform;}
         double Zoom();
         double ZoomDigi();
         double ZoomTotal();
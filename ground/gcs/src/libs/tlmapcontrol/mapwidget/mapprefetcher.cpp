@@ -0,0 +1,136 @@
+/**
+******************************************************************************
+*
+* @file       mapprefetcher.cpp
+* @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+* @brief      Loads the tiles around predicted positions ahead of time
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#include "mapprefetcher.h"
+
+// Tiles loaded around each position, in each direction
+#define PREFETCH_RADIUS 1
+
+namespace mapcontrol
+{
+
+MapPrefetcher::MapPrefetcher(internals::Core * core):core(core),zoom(0),pending(false),cancel(false)
+{
+}
+
+MapPrefetcher::~MapPrefetcher()
+{
+    mutex.lock();
+    cancel=true;
+    mutex.unlock();
+    wait();
+}
+
+/**
+ * @brief MapPrefetcher::Prefetch Load the tiles around positions, replacing the
+ * positions not loaded yet
+ * @param positions Positions the view is expected to show
+ * @param zoom Zoom level of the view
+ */
+void MapPrefetcher::Prefetch(QList<internals::PointLatLng> const& positions,int const& zoom)
+{
+    QMutexLocker locker(&mutex);
+    points=positions;
+    this->zoom=zoom;
+    pending=true;
+    if(!isRunning())
+        start(QThread::LowPriority);
+}
+
+/**
+ * @brief MapPrefetcher::Superseded
+ * @return true if the loading should stop, for new positions or on deletion
+ */
+bool MapPrefetcher::Superseded()
+{
+    QMutexLocker locker(&mutex);
+    return pending || cancel;
+}
+
+void MapPrefetcher::run()
+{
+    forever
+    {
+        QList<internals::PointLatLng> positions;
+        int viewZoom;
+        {
+            QMutexLocker locker(&mutex);
+            if(!pending || cancel)
+                return;
+            positions=points;
+            viewZoom=zoom;
+            pending=false;
+        }
+
+        if(TLMaps::Instance()->GetAccessMode()==core::AccessMode::CacheOnly)
+            continue;
+
+        core::MapType::Types type=core->GetMapType();
+        if(type==core::MapType::UserImage)
+            continue;
+        QVector<core::MapType::Types> types = TLMaps::Instance()->GetAllLayersOfType(type);
+
+        // The view's zoom first, then the levels a zoom in or out goes to
+        QList<int> zooms;
+        zooms<<viewZoom;
+        if(viewZoom<core->MaxZoom())
+            zooms<<viewZoom+1;
+        if(viewZoom>0)
+            zooms<<viewZoom-1;
+
+        foreach(int z,zooms)
+        {
+            core::Size minOfTiles=core->Projection()->GetTileMatrixMinXY(z);
+            core::Size maxOfTiles=core->Projection()->GetTileMatrixMaxXY(z);
+            QList<core::Point> tiles;
+            foreach(internals::PointLatLng position,positions)
+            {
+                core::Point center=core->Projection()->FromPixelToTileXY(core->Projection()->FromLatLngToPixel(position,z));
+                for(int i=-PREFETCH_RADIUS;i<=PREFETCH_RADIUS;i++)
+                {
+                    for(int j=-PREFETCH_RADIUS;j<=PREFETCH_RADIUS;j++)
+                    {
+                        core::Point p(center.X()+i,center.Y()+j);
+                        if(p.X()>=minOfTiles.Width() && p.Y()>=minOfTiles.Height() && p.X()<=maxOfTiles.Width() && p.Y()<=maxOfTiles.Height() && !tiles.contains(p))
+                            tiles.append(p);
+                    }
+                }
+            }
+
+            // Tiles in the caches come back without touching the network
+            foreach(core::Point p,tiles)
+            {
+                if(Superseded())
+                    break;
+                foreach(core::MapType::Types layer,types)
+                    TLMaps::Instance()->GetImageFromServer(layer,p,z);
+            }
+            if(Superseded())
+                break;
+        }
+    }
+}
+
+}
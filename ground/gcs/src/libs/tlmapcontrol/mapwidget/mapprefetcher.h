@@ -0,0 +1,60 @@
+/**
+******************************************************************************
+*
+* @file       mapprefetcher.h
+* @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+* @brief      Loads the tiles around predicted positions ahead of time
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef MAPPREFETCHER_H
+#define MAPPREFETCHER_H
+
+#include <QThread>
+#include <QMutex>
+#include "../internals/core.h"
+#include "../core/corecommon.h"
+
+namespace mapcontrol
+{
+    /**
+     * Loads the tiles around a list of positions into the caches in the
+     * background, at the given zoom and the zoom levels next to it. A new
+     * list replaces the one being loaded.
+     */
+    class TLMAPWIDGET_EXPORT MapPrefetcher:public QThread
+    {
+        Q_OBJECT
+    public:
+        MapPrefetcher(internals::Core *);
+        ~MapPrefetcher();
+        void Prefetch(QList<internals::PointLatLng> const& positions,int const& zoom);
+        void run();
+    private:
+        bool Superseded();
+
+        internals::Core * core;
+        QMutex mutex;
+        QList<internals::PointLatLng> points;
+        int zoom;
+        bool pending;
+        bool cancel;
+    };
+}
+#endif // MAPPREFETCHER_H
@@ -39,7 +39,7 @@ namespace mapcontrol
 {
 
     TLMapWidget::TLMapWidget(QWidget *parent, Configuration *config) : QGraphicsView(parent),
-        configuration(config),UAV(0),GPS(0),Home(0),followmouse(true),
+        configuration(config),UAV(0),GPS(0),Home(0),prefetcher(0),followmouse(true),
         compassRose(0),windCompass(0),showuav(false),showhome(false),
         diagTimer(0),diagGraphItem(0),showDiag(false),overlayOpacity(1),
         windspeedTxt(0)
@@ -49,6 +49,7 @@ namespace mapcontrol
 
         core=new internals::Core;
         map=new MapGraphicItem(core,config);
+        prefetcher=new MapPrefetcher(core);
 
         scene()->addItem(map);
         Home=new HomeItem(map,this);
@@ -232,6 +233,8 @@ namespace mapcontrol
 
     TLMapWidget::~TLMapWidget()
     {
+        if(prefetcher)
+            delete prefetcher;
         if(UAV)
             delete UAV;
         if(Home)
@@ -642,6 +645,18 @@ namespace mapcontrol
         new MapRipper(core,map->SelectedArea());
     }
 
+    void TLMapWidget::PrefetchTiles(QList<internals::PointLatLng> const& positions)
+    {
+        QList<internals::PointLatLng> points=positions;
+        foreach(QGraphicsItem* i,map->childItems())
+        {
+            WayPointItem* w=qgraphicsitem_cast<WayPointItem*>(i);
+            if(w)
+                points.append(w->Coord());
+        }
+        prefetcher->Prefetch(points,core->Zoom());
+    }
+
     void TLMapWidget::setSelectedWP(QList<WayPointItem * >list)
     {
         this->scene()->clearSelection();
@@ -40,6 +40,7 @@
 #include "gpsitem.h"
 #include "homeitem.h"
 #include "mapripper.h"
+#include "mapprefetcher.h"
 #include "mapline.h"
 #include "mapcircle.h"
 #include "waypointcurve.h"
@@ -386,10 +387,32 @@ namespace mapcontrol
         WayPointItem *WPFind(int number);
         void setSelectedWP(QList<WayPointItem *> list);
 
+        /**
+        * @brief Loads the tiles around positions the view is expected to show,
+        * and around the waypoints, into the caches in the background
+        *
+        * @param positions the predicted positions
+        */
+        void PrefetchTiles(QList<internals::PointLatLng> const& positions);
+        /**
+        * @brief Adds the tiles of a map pack, a tile database exported by
+        * ExportMapPack, to the cache
+        *
+        * @return true if the pack was imported
+        */
+        bool ImportMapPack(QString const& file){return core::TLMaps::Instance()->ImportFromGMDB(file);}
+        /**
+        * @brief Exports the tiles of the cache to a map pack
+        *
+        * @return true if the pack was written
+        */
+        bool ExportMapPack(QString const& file){return core::TLMaps::Instance()->ExportToGMDB(file);}
+
         void setWindVelocity(double windVelocity_NED[3]);
       private:
         internals::Core *core;
         MapGraphicItem *map;
+        MapPrefetcher *prefetcher;
         GeoCoderStatusCode x;
         MapType y;
         core::AccessMode xx;
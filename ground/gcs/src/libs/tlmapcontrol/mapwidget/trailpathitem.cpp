@@ -0,0 +1,341 @@
+/**
+******************************************************************************
+*
+* @file       trailpathitem.cpp
+* @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+* @brief      A graphicsItem drawing a whole trail as one simplified path
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#include "trailpathitem.h"
+#include <QDateTime>
+#include <QGraphicsSceneHoverEvent>
+#include <QStyleOptionGraphicsItem>
+#include <QPair>
+
+// Radius of the trail dots, in screen pixels
+#define POINT_RADIUS 2
+// Distance from a dot that shows its tooltip, in screen pixels
+#define HOVER_REACH 4
+
+namespace mapcontrol
+{
+    const double TrailPathItem::TOLERANCE = 0.5;
+
+    TrailPathItem::TrailPathItem(QColor const& pointColor,QColor const& lineColor,MapGraphicItem * map):QGraphicsItem(map),m_map(map),m_pointColor(pointColor),m_lineColor(lineColor),showPoints(true),showLine(true),anchor(0),zoom(-1)
+    {
+        setFlag(QGraphicsItem::ItemUsesExtendedStyleOption,true);
+        setAcceptHoverEvents(true);
+        setAcceptedMouseButtons(Qt::NoButton);
+        connect(map,SIGNAL(childRefreshPosition()),this,SLOT(RefreshPos()));
+    }
+
+    /**
+     * @brief Adds the newest point of the trail. It is kept as it is until
+     *        TAIL_POINTS more follow, then the tail is simplified
+     */
+    void TrailPathItem::AddPoint(internals::PointLatLng const& coord,int const& altitude)
+    {
+        TrailPoint point;
+        point.coord=coord;
+        point.altitude=altitude;
+        point.time=QDateTime::currentMSecsSinceEpoch();
+        points.append(point);
+
+        if(points.count()==1 || zoom<0)
+        {
+            Reproject();
+            RefreshPos();
+            return;
+        }
+
+        core::Point p=m_map->Projection()->FromLatLngToPixel(coord,zoom);
+        pixels.append(QPointF(p.X(),p.Y())-origin);
+        kept.append(points.count()-1);
+
+        if(kept.count()-1-anchor>=TAIL_POINTS)
+        {
+            int from=anchor;
+            Simplify(from);
+            anchor=kept.count()-1;
+            RebuildChunksFrom(from);
+        }
+        else
+            RebuildChunksFrom(kept.count()-1);
+    }
+
+    void TrailPathItem::Clear()
+    {
+        prepareGeometryChange();
+        points.clear();
+        pixels.clear();
+        kept.clear();
+        chunks.clear();
+        chunkRects.clear();
+        bounds=QRectF();
+        anchor=0;
+    }
+
+    void TrailPathItem::SetShowPoints(bool const& value)
+    {
+        showPoints=value;
+        setVisible(showPoints || showLine);
+        update();
+    }
+
+    void TrailPathItem::SetShowLine(bool const& value)
+    {
+        showLine=value;
+        setVisible(showPoints || showLine);
+        update();
+    }
+
+    /**
+     * @brief Projects all the points at the map zoom and simplifies them for
+     *        it. Only needed when the zoom changes, panning keeps the pixels
+     */
+    void TrailPathItem::Reproject()
+    {
+        zoom=(int)m_map->Zoom();
+        pixels.resize(points.count());
+        kept.clear();
+        anchor=0;
+
+        if(points.isEmpty())
+        {
+            Clear();
+            return;
+        }
+
+        internals::PureProjection *projection=m_map->Projection();
+        core::Point o=projection->FromLatLngToPixel(points[0].coord,zoom);
+        origin=QPointF(o.X(),o.Y());
+        for(int i=0;i<points.count();++i)
+        {
+            core::Point p=projection->FromLatLngToPixel(points[i].coord,zoom);
+            pixels[i]=QPointF(p.X(),p.Y())-origin;
+        }
+
+        kept.append(0);
+        Simplify(0);
+        anchor=kept.count()-1;
+        RebuildChunksFrom(0);
+    }
+
+    /**
+     * @brief Douglas-Peucker, iterative, on the points from kept[from] to the
+     *        last one. Replaces the entries of kept after from with the points
+     *        the simplification leaves
+     */
+    void TrailPathItem::Simplify(int const& from)
+    {
+        int first=kept[from];
+        int last=points.count()-1;
+        kept.resize(from+1);
+        if(last<=first)
+            return;
+
+        QVector<bool> keep(last-first+1,false);
+        keep[last-first]=true;
+
+        QVector<QPair<int,int> > spans;
+        spans.append(qMakePair(first,last));
+        while(!spans.isEmpty())
+        {
+            QPair<int,int> span=spans.takeLast();
+            const QPointF a=pixels[span.first];
+            const QPointF ab=pixels[span.second]-a;
+            const qreal length2=ab.x()*ab.x()+ab.y()*ab.y();
+
+            int farthest=-1;
+            qreal distance2=TOLERANCE*TOLERANCE;
+            for(int i=span.first+1;i<span.second;++i)
+            {
+                // Distance to the segment, or to a when both ends are the same
+                QPointF ap=pixels[i]-a;
+                qreal t=length2>0 ? qBound((qreal)0,(ap.x()*ab.x()+ap.y()*ab.y())/length2,(qreal)1) : 0;
+                QPointF d=ap-ab*t;
+                qreal d2=d.x()*d.x()+d.y()*d.y();
+                if(d2>distance2)
+                {
+                    distance2=d2;
+                    farthest=i;
+                }
+            }
+
+            if(farthest>=0)
+            {
+                keep[farthest-first]=true;
+                spans.append(qMakePair(span.first,farthest));
+                spans.append(qMakePair(farthest,span.second));
+            }
+        }
+
+        for(int i=1;i<keep.count();++i)
+        {
+            if(keep[i])
+                kept.append(first+i);
+        }
+    }
+
+    /**
+     * @brief Rebuilds the chunks holding the entries of kept from the given
+     *        one on. Chunks share their end points, so the line is unbroken
+     */
+    void TrailPathItem::RebuildChunksFrom(int const& from)
+    {
+        prepareGeometryChange();
+
+        int chunk=qMax(from-1,0)/CHUNK_POINTS;
+        chunks.resize(chunk);
+        chunkRects.resize(chunk);
+
+        int start=chunk*CHUNK_POINTS;
+        do
+        {
+            int end=qMin(start+(int)CHUNK_POINTS,kept.count()-1);
+            QPainterPath path(pixels[kept[start]]);
+            for(int i=start+1;i<=end;++i)
+                path.lineTo(pixels[kept[i]]);
+            chunks.append(path);
+            chunkRects.append(path.boundingRect());
+            start+=CHUNK_POINTS;
+        }
+        while(start<kept.count()-1);
+
+        bounds=QRectF();
+        foreach(QRectF const& rect,chunkRects)
+            bounds|=rect.adjusted(-0.5,-0.5,0.5,0.5);
+        update(chunkRects.last());
+    }
+
+    void TrailPathItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+    {
+        Q_UNUSED(widget);
+
+        const qreal radius=POINT_RADIUS/scale();
+        const QRectF exposed=option->exposedRect.adjusted(-radius,-radius,radius,radius);
+
+        if(showLine)
+        {
+            QPen pen(m_lineColor);
+            pen.setCosmetic(true);
+            painter->setPen(pen);
+            painter->setBrush(Qt::NoBrush);
+            for(int c=0;c<chunks.count();++c)
+            {
+                if(chunkRects[c].adjusted(-radius,-radius,radius,radius).intersects(exposed))
+                    painter->drawPath(chunks[c]);
+            }
+        }
+
+        if(showPoints)
+        {
+            QPen pen(Qt::black);
+            pen.setCosmetic(true);
+            painter->setPen(pen);
+            painter->setBrush(m_pointColor);
+            for(int c=0;c<chunks.count();++c)
+            {
+                if(!chunkRects[c].adjusted(-radius,-radius,radius,radius).intersects(exposed))
+                    continue;
+                int end=qMin((c+1)*(int)CHUNK_POINTS,kept.count()-1);
+                for(int i=c ? c*CHUNK_POINTS+1 : 0;i<=end;++i)
+                {
+                    const QPointF &p=pixels[kept[i]];
+                    if(exposed.contains(p))
+                        painter->drawEllipse(p,radius,radius);
+                }
+            }
+        }
+    }
+
+    QRectF TrailPathItem::boundingRect()const
+    {
+        if(bounds.isNull())
+            return QRectF();
+        const qreal margin=(POINT_RADIUS+1)/scale();
+        return bounds.adjusted(-margin,-margin,margin,margin);
+    }
+
+    int TrailPathItem::type()const
+    {
+        return Type;
+    }
+
+    /**
+     * @brief Shows the position, altitude and time of the dot under the mouse
+     */
+    void TrailPathItem::hoverMoveEvent(QGraphicsSceneHoverEvent *event)
+    {
+        int nearest=-1;
+        if(showPoints)
+        {
+            const qreal reach=HOVER_REACH/scale();
+            qreal best=reach*reach;
+            for(int c=0;c<chunks.count();++c)
+            {
+                if(!chunkRects[c].adjusted(-reach,-reach,reach,reach).contains(event->pos()))
+                    continue;
+                int end=qMin((c+1)*(int)CHUNK_POINTS,kept.count()-1);
+                for(int i=c*CHUNK_POINTS;i<=end;++i)
+                {
+                    QPointF d=pixels[kept[i]]-event->pos();
+                    qreal d2=d.x()*d.x()+d.y()*d.y();
+                    if(d2<best)
+                    {
+                        best=d2;
+                        nearest=kept[i];
+                    }
+                }
+            }
+        }
+
+        if(nearest<0)
+        {
+            setToolTip(QString());
+            return;
+        }
+
+        TrailPoint const& point=points[nearest];
+        QString coord_str = " " + QString::number(point.coord.Lat(), 'f', 6) + "   " + QString::number(point.coord.Lng(), 'f', 6);
+        setToolTip(QString(tr("Position:")+"%1\n"+tr("Altitude:")+"%2\n"+tr("Time:")+"%3").arg(coord_str).arg(QString::number(point.altitude)).arg(QDateTime::fromMSecsSinceEpoch(point.time).toString()));
+    }
+
+    /**
+     * @brief Follows the map. The cached pixels are only redone when the zoom
+     *        changed, otherwise the item is just moved and scaled
+     */
+    void TrailPathItem::RefreshPos()
+    {
+        if(points.isEmpty())
+            return;
+
+        if((int)m_map->Zoom()!=zoom)
+            Reproject();
+
+        core::Point p=m_map->FromLatLngToLocal(points[0].coord);
+        setPos(p.X(),p.Y());
+        if(scale()!=m_map->RenderTransform())
+        {
+            prepareGeometryChange();
+            setScale(m_map->RenderTransform());
+        }
+    }
+}
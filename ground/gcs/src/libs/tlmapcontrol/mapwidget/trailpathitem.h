@@ -0,0 +1,99 @@
+/**
+******************************************************************************
+*
+* @file       trailpathitem.h
+* @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+* @brief      A graphicsItem drawing a whole trail as one simplified path
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef TRAILPATHITEM_H
+#define TRAILPATHITEM_H
+
+#include <QGraphicsItem>
+#include <QPainter>
+#include <QPainterPath>
+#include <QVector>
+#include "../internals/pointlatlng.h"
+#include <QObject>
+#include "mapgraphicitem.h"
+#include "../core/corecommon.h"
+
+namespace mapcontrol
+{
+    /**
+     * All the points of a trail in a single item, drawn as dots and as the
+     * line joining them. The points are projected once per zoom level and
+     * simplified with Douglas-Peucker to what that zoom can show; panning
+     * only moves the item. The simplified line is split in chunks, and only
+     * the chunks crossing the exposed area are painted.
+     */
+    class TLMAPWIDGET_EXPORT TrailPathItem:public QObject,public QGraphicsItem
+    {
+        Q_OBJECT
+        Q_INTERFACES(QGraphicsItem)
+    public:
+        enum { Type = UserType + 10 };
+        TrailPathItem(QColor const& pointColor,QColor const& lineColor,MapGraphicItem * map);
+        void AddPoint(internals::PointLatLng const& coord,int const& altitude);
+        void Clear();
+        void SetShowPoints(bool const& value);
+        void SetShowLine(bool const& value);
+        void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+                    QWidget *widget);
+        QRectF boundingRect() const;
+        int type() const;
+    protected:
+        void hoverMoveEvent(QGraphicsSceneHoverEvent *event);
+    private:
+        struct TrailPoint
+        {
+            internals::PointLatLng coord;
+            int altitude;
+            qint64 time;
+        };
+
+        void Reproject();
+        void Simplify(int const& from);
+        void RebuildChunksFrom(int const& from);
+
+        static const int TAIL_POINTS = 64;    // Points kept as they are before simplifying them
+        static const int CHUNK_POINTS = 256;  // Simplified points per painted chunk
+        static const double TOLERANCE;        // Simplification error allowed, in pixels
+
+        MapGraphicItem * m_map;
+        QColor m_pointColor;
+        QColor m_lineColor;
+        bool showPoints;
+        bool showLine;
+
+        QVector<TrailPoint> points;
+        QPointF origin;             // First point projected at zoom
+        QVector<QPointF> pixels;    // Points projected at zoom, relative to origin
+        QVector<int> kept;          // Indexes of the points left by the simplification
+        int anchor;                 // Last simplified entry of kept, the tail follows it
+        int zoom;
+        QVector<QPainterPath> chunks;
+        QVector<QRectF> chunkRects;
+        QRectF bounds;
+    public slots:
+        void RefreshPos();
+    };
+}
+#endif // TRAILPATHITEM_H
@@ -9,11 +9,11 @@ SOURCES += mapwidget/mapgraphicitem.cpp \
     mapwidget/waypointitem.cpp \
     mapwidget/uavitem.cpp \
     mapwidget/gpsitem.cpp \
-    mapwidget/trailitem.cpp \
+    mapwidget/trailpathitem.cpp \
     mapwidget/homeitem.cpp \
     mapwidget/mapripform.cpp \
     mapwidget/mapripper.cpp \
-    mapwidget/traillineitem.cpp \
+    mapwidget/mapprefetcher.cpp \
     mapwidget/mapline.cpp \
     mapwidget/mapcircle.cpp \
     mapwidget/waypointcurve.cpp \
@@ -61,11 +61,11 @@ HEADERS += mapwidget/mapgraphicitem.h \
     mapwidget/gpsitem.h \
     mapwidget/uavmapfollowtype.h \
     mapwidget/uavtrailtype.h \
-    mapwidget/trailitem.h \
+    mapwidget/trailpathitem.h \
     mapwidget/homeitem.h \
     mapwidget/mapripform.h \
     mapwidget/mapripper.h \
-    mapwidget/traillineitem.h \
+    mapwidget/mapprefetcher.h \
     mapwidget/mapline.h \
     mapwidget/mapcircle.h \
     mapwidget/waypointcurve.h \
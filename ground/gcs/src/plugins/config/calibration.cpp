@@ -68,7 +68,7 @@ enum calibrationSuccessMessages{
 #define sign(x) ((x < 0) ? -1 : 1)
 
 Calibration::Calibration() : calibrateMags(false), accelLength(GRAVITY),
-    xCurve(NULL), yCurve(NULL), zCurve(NULL)
+    accelPositionError(0), magPositionError(0), xCurve(NULL), yCurve(NULL), zCurve(NULL)
 {
 }
 
@@ -327,12 +327,14 @@ void Calibration::dataUpdated(UAVObject * obj) {
                 QString magCalibrationResults = "";
                 if (calibrateAccels == true) {
                     accelCalibrationResults = QString(tr("Accelerometer bias, in [m/s^2]: x=%1, y=%2, z=%3\n")).arg(sensorSettingsData.AccelBias[SensorSettings::ACCELBIAS_X], -9).arg(sensorSettingsData.AccelBias[SensorSettings::ACCELBIAS_Y], -9).arg(sensorSettingsData.AccelBias[SensorSettings::ACCELBIAS_Z], -9) +
-                                              QString(tr("Accelerometer scale, in [-]:    x=%1, y=%2, z=%3\n")).arg(sensorSettingsData.AccelScale[SensorSettings::ACCELSCALE_X], -9).arg(sensorSettingsData.AccelScale[SensorSettings::ACCELSCALE_Y], -9).arg(sensorSettingsData.AccelScale[SensorSettings::ACCELSCALE_Z], -9);
+                                              QString(tr("Accelerometer scale, in [-]:    x=%1, y=%2, z=%3\n")).arg(sensorSettingsData.AccelScale[SensorSettings::ACCELSCALE_X], -9).arg(sensorSettingsData.AccelScale[SensorSettings::ACCELSCALE_Y], -9).arg(sensorSettingsData.AccelScale[SensorSettings::ACCELSCALE_Z], -9) +
+                                              QString(tr("Accelerometer worst position error, in [%]: %1\n")).arg(100 * accelPositionError, 0, 'f', 3);
 
                 }
                 if (calibrateMags == true) {
                     magCalibrationResults = QString(tr("Magnetometer bias, in [mG]: x=%1, y=%2, z=%3\n")).arg(sensorSettingsData.MagBias[SensorSettings::MAGBIAS_X], -9).arg(sensorSettingsData.MagBias[SensorSettings::MAGBIAS_Y], -9).arg(sensorSettingsData.MagBias[SensorSettings::MAGBIAS_Z], -9) +
-                                            QString(tr("Magnetometer scale, in [-]: x=%4, y=%5, z=%6")).arg(sensorSettingsData.MagScale[SensorSettings::MAGSCALE_X], -9).arg(sensorSettingsData.MagScale[SensorSettings::MAGSCALE_Y], -9).arg(sensorSettingsData.MagScale[SensorSettings::MAGSCALE_Z], -9);
+                                            QString(tr("Magnetometer scale, in [-]: x=%4, y=%5, z=%6")).arg(sensorSettingsData.MagScale[SensorSettings::MAGSCALE_X], -9).arg(sensorSettingsData.MagScale[SensorSettings::MAGSCALE_Y], -9).arg(sensorSettingsData.MagScale[SensorSettings::MAGSCALE_Z], -9) +
+                                            QString(tr("\nMagnetometer worst position error, in [%]: %1")).arg(100 * magPositionError, 0, 'f', 3);
                 }
 
                 // Emit SIGNAL containing calibration success message
@@ -581,12 +583,10 @@ void Calibration::doStartSixPoint()
     sensorSettings->setData(sensorSettingsData);
 
     // Clear the accumulators
-    accel_accum_x.clear();
-    accel_accum_y.clear();
-    accel_accum_z.clear();
-    mag_accum_x.clear();
-    mag_accum_y.clear();
-    mag_accum_z.clear();
+    accelMean.clear();
+    magMean.clear();
+    accelPositionError = 0;
+    magPositionError = 0;
 
     // TODO: Document why the thread needs to wait 100ms.
     QThread::usleep(100000);
@@ -696,6 +696,7 @@ void Calibration::doStartTempCal()
     gyro_accum_y.clear();
     gyro_accum_z.clear();
     gyro_accum_temp.clear();
+    gyroTempFit.clear();
 
     // Disable gyro sensor bias correction to see raw data
     AttitudeSettings *attitudeSettings = AttitudeSettings::GetInstance(getObjectManager());
@@ -992,9 +993,7 @@ bool Calibration::storeSixPointMeasurement(UAVObject * obj, int position)
         Q_ASSERT(accels);
         Accels::DataFields accelsData = accels->getData();
 
-        accel_accum_x.append(accelsData.x);
-        accel_accum_y.append(accelsData.y);
-        accel_accum_z.append(accelsData.z);
+        accelMean.add(Eigen::Vector3d(accelsData.x, accelsData.y, accelsData.z));
     }
 
     if( calibrateMags && obj->getObjID() == Magnetometer::OBJID) {
@@ -1002,53 +1001,51 @@ bool Calibration::storeSixPointMeasurement(UAVObject * obj, int position)
         Q_ASSERT(mag);
         Magnetometer::DataFields magData = mag->getData();
 
-        mag_accum_x.append(magData.x);
-        mag_accum_y.append(magData.y);
-        mag_accum_z.append(magData.z);
+        magMean.add(Eigen::Vector3d(magData.x, magData.y, magData.z));
     }
 
     // Update progress bar
     int progress_percentage;
     if(calibrateAccels && !calibrateMags)
-        progress_percentage = (100 * accel_accum_x.size()) / NUM_SENSOR_UPDATES_SIX_POINT;
+        progress_percentage = (100 * accelMean.count()) / NUM_SENSOR_UPDATES_SIX_POINT;
     else if(!calibrateAccels && calibrateMags)
-        progress_percentage = (100 * mag_accum_x.size()) / NUM_SENSOR_UPDATES_SIX_POINT;
+        progress_percentage = (100 * magMean.count()) / NUM_SENSOR_UPDATES_SIX_POINT;
     else
-        progress_percentage = (100 * std::min(mag_accum_x.size(), accel_accum_x.size())) / NUM_SENSOR_UPDATES_SIX_POINT;
+        progress_percentage = (100 * std::min(magMean.count(), accelMean.count())) / NUM_SENSOR_UPDATES_SIX_POINT;
     emit sixPointProgressChanged(progress_percentage);
 
-    // If enough data is collected, average it for this position
-    if((!calibrateAccels || accel_accum_x.size() >= NUM_SENSOR_UPDATES_SIX_POINT) &&
-            (!calibrateMags || mag_accum_x.size() >= NUM_SENSOR_UPDATES_SIX_POINT)) {
+    // If enough data is collected, or the means have settled, store them for this position
+    if((!calibrateAccels || sixPointDone(accelMean)) &&
+            (!calibrateMags || sixPointDone(magMean))) {
 
         // Store the average accelerometer value in that position
         if (calibrateAccels) {
             // undo the board rotation that has been applied to the sensor values
-            double accel_body[3] = {listMean(accel_accum_x), listMean(accel_accum_y), listMean(accel_accum_z)};
+            Eigen::Vector3d mean = accelMean.mean();
+            double accel_body[3] = {mean(0), mean(1), mean(2)};
             double accel_sensor[3];
             rotate_vector(boardRotationMatrix, accel_body, accel_sensor, false);
 
             accel_data_x[position] = accel_sensor[0];
             accel_data_y[position] = accel_sensor[1];
             accel_data_z[position] = accel_sensor[2];
-            accel_accum_x.clear();
-            accel_accum_y.clear();
-            accel_accum_z.clear();
+            accelPositionError = std::max(accelPositionError, accelMean.relativeError());
+            accelMean.clear();
         }
 
         // Store the average magnetometer value in that position
         if (calibrateMags) {
             // undo the board rotation that has been applied to the sensor values
-            double mag_body[3] = {listMean(mag_accum_x), listMean(mag_accum_y), listMean(mag_accum_z)};
+            Eigen::Vector3d mean = magMean.mean();
+            double mag_body[3] = {mean(0), mean(1), mean(2)};
             double mag_sensor[3];
             rotate_vector(boardRotationMatrix, mag_body, mag_sensor, false);
 
             mag_data_x[position] = mag_sensor[0];
             mag_data_y[position] = mag_sensor[1];
             mag_data_z[position] = mag_sensor[2];
-            mag_accum_x.clear();
-            mag_accum_y.clear();
-            mag_accum_z.clear();
+            magPositionError = std::max(magPositionError, magMean.relativeError());
+            magMean.clear();
         }
 
         // Indicate all data collected for this position
@@ -1057,6 +1054,20 @@ bool Calibration::storeSixPointMeasurement(UAVObject * obj, int position)
     return false;
 }
 
+/**
+ * A position is done after NUM_SENSOR_UPDATES_SIX_POINT samples, or sooner
+ * once the standard error of the mean is small next to its length, as the
+ * remaining samples would barely move it.
+ */
+bool Calibration::sixPointDone(const CalibrationFit::VectorMean &mean)
+{
+    if (mean.count() >= NUM_SENSOR_UPDATES_SIX_POINT)
+        return true;
+
+    return mean.count() >= MIN_SENSOR_UPDATES_SIX_POINT &&
+            mean.relativeError() < SIX_POINT_SETTLED_ERROR;
+}
+
 /**
  * @brief Calibration::configureTempCurves
  * @param x
@@ -1089,6 +1100,8 @@ bool Calibration::storeTempCalMeasurement(UAVObject * obj)
         gyro_accum_y.append(gyros_sensor[1]);
         gyro_accum_z.append(gyros_sensor[2]);
         gyro_accum_temp.append(gyrosData.temperature);
+        gyroTempFit.add(gyrosData.temperature,
+                        Eigen::Vector3d(gyros_sensor[0], gyros_sensor[1], gyros_sensor[2]));
     }
 
     auto m = std::minmax_element(gyro_accum_temp.begin(), gyro_accum_temp.end());
@@ -1112,27 +1125,13 @@ bool Calibration::storeTempCalMeasurement(UAVObject * obj)
  */
 void Calibration::updateTempCompCalibrationDisplay()
 {
-    int n_samples = gyro_accum_temp.size();
-
-    // Construct the matrix of temperature.
-    Eigen::Matrix<double, Eigen::Dynamic, 4> X(n_samples, 4);
-
-    // And the matrix of gyro samples.
-    Eigen::Matrix<double, Eigen::Dynamic, 3> Y(n_samples, 3);
-
-    for (int i = 0; i < n_samples; ++i) {
-        X(i,0) = 1;
-        X(i,1) = gyro_accum_temp[i];
-        X(i,2) = pow(gyro_accum_temp[i],2);
-        X(i,3) = pow(gyro_accum_temp[i],3);
-        Y(i,0) = gyro_accum_x[i];
-        Y(i,1) = gyro_accum_y[i];
-        Y(i,2) = gyro_accum_z[i];
-    }
+    // Solve Y = X * B from the normal equations gathered so far
+    Eigen::Matrix<double, 4, 3> result = gyroTempFit.solve();
+    Eigen::Vector3d residual = gyroTempFit.rmsResidual(result);
 
-    // Solve Y = X * B
-    // Use the cholesky-based Penrose pseudoinverse method.
-    Eigen::Matrix<double, 4, 3> result = (X.transpose() * X).ldlt().solve(X.transpose()*Y);
+    emit showTempCalMessage(tr("Leave board flat and very still while it changes temperature\n"
+                               "Fit residual, in [deg/s]: x=%1, y=%2, z=%3")
+                            .arg(residual(0), 0, 'f', 3).arg(residual(1), 0, 'f', 3).arg(residual(2), 0, 'f', 3));
 
     QList<double> xCoeffs, yCoeffs, zCoeffs;
     xCoeffs.clear();
@@ -1178,27 +1177,10 @@ int Calibration::computeTempCal()
     attitudeSettings->setData(attitudeSettingsData);
     attitudeSettings->updated();
 
-    int n_samples = gyro_accum_temp.size();
-
-    // Construct the matrix of temperature.
-    Eigen::Matrix<double, Eigen::Dynamic, 4> X(n_samples, 4);
-
-    // And the matrix of gyro samples.
-    Eigen::Matrix<double, Eigen::Dynamic, 3> Y(n_samples, 3);
-
-    for (int i = 0; i < n_samples; ++i) {
-        X(i,0) = 1;
-        X(i,1) = gyro_accum_temp[i];
-        X(i,2) = pow(gyro_accum_temp[i],2);
-        X(i,3) = pow(gyro_accum_temp[i],3);
-        Y(i,0) = gyro_accum_x[i];
-        Y(i,1) = gyro_accum_y[i];
-        Y(i,2) = gyro_accum_z[i];
-    }
-
-    // Solve Y = X * B
-    // Use the cholesky-based Penrose pseudoinverse method.
-    Eigen::Matrix<double, 4, 3> result = (X.transpose() * X).ldlt().solve(X.transpose()*Y);
+    // Solve Y = X * B from the normal equations gathered during collection
+    Eigen::Matrix<double, 4, 3> result = gyroTempFit.solve();
+    Eigen::Vector3d residual = gyroTempFit.rmsResidual(result);
+    qDebug() << "Temperature fit RMS residual:" << residual(0) << residual(1) << residual(2);
 
     std::stringstream str;
     str << result.format(Eigen::IOFormat(4, 0, ", ", "\n", "[", "]"));
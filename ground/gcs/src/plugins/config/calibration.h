@@ -28,6 +28,7 @@
 #include <extensionsystem/pluginmanager.h>
 #include <uavobject.h>
 #include <tempcompcurve.h>
+#include "calibrationfit.h"
 
 #include <QObject>
 #include <QTimer>
@@ -193,6 +194,17 @@ private:
     QList<double> mag_accum_y;
     QList<double> mag_accum_z;
 
+    //! Running means of the current six point position
+    CalibrationFit::VectorMean accelMean;
+    CalibrationFit::VectorMean magMean;
+
+    //! Largest relative error of the means over the six positions
+    double accelPositionError;
+    double magPositionError;
+
+    //! Cubic fit of each gyro axis against temperature
+    CalibrationFit::PolyFit<3, 3> gyroTempFit;
+
     double gyro_data_x[6], gyro_data_y[6], gyro_data_z[6];
     double accel_data_x[6], accel_data_y[6], accel_data_z[6];
     double mag_data_x[6], mag_data_y[6], mag_data_z[6];
@@ -200,6 +212,10 @@ private:
     static const int NUM_SENSOR_UPDATES_LEVELING = 300;
     static const int NUM_SENSOR_UPDATES_YAW_ORIENTATION = 300;
     static const int NUM_SENSOR_UPDATES_SIX_POINT = 100;
+    //! A position can finish early, once this many samples have settled
+    static const int MIN_SENSOR_UPDATES_SIX_POINT = 25;
+    //! Relative standard error of the mean counted as settled
+    static constexpr double SIX_POINT_SETTLED_ERROR = 0.001;
     static const int SENSOR_UPDATE_PERIOD = 25;
     static const int NON_SENSOR_UPDATE_PERIOD = 0;
 
@@ -255,6 +271,9 @@ protected:
     //! Update the graphs with the temperature compensation
     void updateTempCompCalibrationDisplay();
 
+    //! Whether a six point mean has enough samples, or has settled
+    static bool sixPointDone(const CalibrationFit::VectorMean &mean);
+
 };
 
 #endif // CALIBRATION_H
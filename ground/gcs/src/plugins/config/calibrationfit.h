@@ -0,0 +1,158 @@
+/**
+ ******************************************************************************
+ * @file       calibrationfit.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ConfigPlugin Config Plugin
+ * @{
+ * @brief Running estimates that calibration folds its samples into
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef CALIBRATIONFIT_H
+#define CALIBRATIONFIT_H
+
+#include <Eigen/Core>
+#include <Eigen/Cholesky>
+
+#include <limits>
+
+namespace CalibrationFit {
+
+/**
+ * @brief Mean and spread of a three axis sensor, updated as each sample
+ * arrives (Welford's method), so no samples are kept.
+ */
+class VectorMean
+{
+public:
+    VectorMean() { clear(); }
+
+    void clear()
+    {
+        n = 0;
+        m.setZero();
+        m2.setZero();
+    }
+
+    void add(const Eigen::Vector3d &x)
+    {
+        n++;
+        Eigen::Vector3d d = x - m;
+        m += d / n;
+        m2 += d.cwiseProduct(x - m);
+    }
+
+    int count() const { return n; }
+    Eigen::Vector3d mean() const { return m; }
+
+    //! Sample standard deviation of each axis
+    Eigen::Vector3d stdDev() const
+    {
+        if (n < 2)
+            return Eigen::Vector3d::Zero();
+        return (m2 / (n - 1)).cwiseSqrt();
+    }
+
+    //! Standard error of the mean as a fraction of its length
+    double relativeError() const
+    {
+        double len = m.norm();
+        if (n < 2 || len <= 0)
+            return std::numeric_limits<double>::infinity();
+        return stdDev().norm() / sqrt(static_cast<double>(n)) / len;
+    }
+
+private:
+    int n;
+    Eigen::Vector3d m;
+    Eigen::Vector3d m2;
+};
+
+/**
+ * @brief Least squares fit of a polynomial in one variable to several
+ * outputs at once.
+ *
+ * Each sample is folded into the normal equations when it arrives, so a
+ * solve is a fixed size LDLT however many samples there are, and can be
+ * done after every sample to show how the fit is settling.
+ */
+template <int Order, int Outputs>
+class PolyFit
+{
+public:
+    typedef Eigen::Matrix<double, Order + 1, Outputs> Coefficients;
+    typedef Eigen::Matrix<double, Outputs, 1> Output;
+
+    PolyFit() { clear(); }
+
+    void clear()
+    {
+        n = 0;
+        xtx.setZero();
+        xty.setZero();
+        yty.setZero();
+    }
+
+    void add(double t, const Output &y)
+    {
+        Eigen::Matrix<double, Order + 1, 1> x;
+        x(0) = 1;
+        for (int i = 1; i <= Order; i++)
+            x(i) = x(i - 1) * t;
+
+        xtx += x * x.transpose();
+        xty += x * y.transpose();
+        yty += y.cwiseProduct(y);
+        n++;
+    }
+
+    int count() const { return n; }
+
+    //! Coefficients of each output, lowest power first
+    Coefficients solve() const { return xtx.ldlt().solve(xty); }
+
+    //! RMS of the residuals of each output with coefficients b
+    Output rmsResidual(const Coefficients &b) const
+    {
+        if (n == 0)
+            return Output::Zero();
+
+        // sum((y - x b)^2) expanded, as the samples are gone
+        Output r;
+        for (int c = 0; c < Outputs; c++)
+            r(c) = yty(c) - 2 * b.col(c).dot(xty.col(c)) +
+                    b.col(c).dot(xtx * b.col(c));
+
+        return (r.cwiseMax(0) / n).cwiseSqrt();
+    }
+
+private:
+    int n;
+    Eigen::Matrix<double, Order + 1, Order + 1> xtx;
+    Eigen::Matrix<double, Order + 1, Outputs> xty;
+    Output yty;
+};
+
+} // namespace CalibrationFit
+
+#endif // CALIBRATIONFIT_H
+
+/**
+ * @}
+ * @}
+ */
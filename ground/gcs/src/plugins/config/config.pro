@@ -16,6 +16,7 @@ OTHER_FILES += Config.pluginspec \
     Config.json
 
 HEADERS += calibration.h \
+    calibrationfit.h \
     configplugin.h \
     configgadgetconfiguration.h \
     configgadgetwidget.h \
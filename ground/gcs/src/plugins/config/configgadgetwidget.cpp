@@ -45,6 +45,8 @@
 #include "defaulthwsettingswidget.h"
 #include "uavobjectutilmanager.h"
 
+#include <extensionsystem/tracelog.h>
+
 #include <QDebug>
 #include <QStringList>
 #include <QWidget>
@@ -246,6 +248,7 @@ void ConfigGadgetWidget::onAutopilotDisconnect() {
 }
 
 void ConfigGadgetWidget::onAutopilotConnect() {
+    ExtensionSystem::TraceScope trace("Refresh config gadget", "connect");
 
     QIcon* icon;
     QWidget* qwd;
@@ -83,7 +83,7 @@ const QVector<ConfigInputWidget::ArmingMethod> ConfigInputWidget::armingMethods
 };
 
 ConfigInputWidget::ConfigInputWidget(QWidget *parent) : ConfigTaskWidget(parent),
-    wizardStep(wizardNone), transmitterType(heli), loop(NULL), skipflag(false),
+    channelsSampled(false), wizardStep(wizardNone), transmitterType(heli), loop(NULL), skipflag(false),
     cbArmingOption(Q_NULLPTR), lastArmingMethod(ARM_INVALID), armingConfigUpdating(false)
 {
     manualCommandObj = ManualControlCommand::GetInstance(getObjectManager());
@@ -348,6 +348,10 @@ ConfigInputWidget::ConfigInputWidget(QWidget *parent) : ConfigTaskWidget(parent)
     animate=new QTimer(this);
     connect(animate,SIGNAL(timeout()),this,SLOT(moveTxControls()));
 
+    calibrationRefresh = new QTimer(this);
+    calibrationRefresh->setInterval(CALIBRATION_REFRESH_MS);
+    connect(calibrationRefresh, SIGNAL(timeout()), this, SLOT(refreshCalibration()));
+
     heliChannelOrder << ManualControlSettings::CHANNELGROUPS_COLLECTIVE <<
                         ManualControlSettings::CHANNELGROUPS_THROTTLE <<
                         ManualControlSettings::CHANNELGROUPS_ROLL <<
@@ -650,8 +654,8 @@ void ConfigInputWidget::wizardSetUpStep(enum wizardSteps step)
                 manualSettingsData.ChannelMax[i] = manualSettingsData.ChannelNeutral[i] - INITIAL_OFFSET;
             }
         }
-        connect(manualCommandObj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(identifyLimits()));
-        connect(manualCommandObj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(moveSticks()));
+        setManualCommandPeriod(CALIBRATION_UPDATE_PERIOD_MS);
+        startCalibrationSampling();
         connect(accessoryDesiredObj0, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(moveSticks()));
 
         // Disable next.  When range on all channels is sufficient, enable it
@@ -783,8 +787,8 @@ void ConfigInputWidget::wizardTearDownStep(enum wizardSteps step)
         setTxMovement(nothing);
         break;
     case wizardIdentifyLimits:
-        disconnect(manualCommandObj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(identifyLimits()));
-        disconnect(manualCommandObj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(moveSticks()));
+        stopCalibrationSampling();
+        setManualCommandPeriod(WIZARD_UPDATE_PERIOD_MS);
         disconnect(accessoryDesiredObj0, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(moveSticks()));
         manualSettingsObj->setData(manualSettingsData);
         setTxMovement(nothing);
@@ -837,7 +841,7 @@ void ConfigInputWidget::fastMdata()
     originalMetaData = utilMngr->readAllNonSettingsMetadata();
 
     // Update data rates
-    quint16 fastUpdate =  150; // in [ms]
+    quint16 fastUpdate = WIZARD_UPDATE_PERIOD_MS; // in [ms]
 
     // Iterate over list of UAVObjects, configuring all dynamic data metadata objects.
     UAVObjectManager *objManager = getObjectManager();
@@ -882,6 +886,94 @@ void ConfigInputWidget::restoreMdata()
     originalMetaData.clear();
 }
 
+/**
+ * @brief ConfigInputWidget::setManualCommandPeriod Change how often the flight
+ * side sends ManualControlCommand, leaving the other objects as they are
+ * @param period Update period in ms
+ */
+void ConfigInputWidget::setManualCommandPeriod(quint16 period)
+{
+    UAVObject::Metadata mdata = manualCommandObj->getMetadata();
+    UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_THROTTLED);
+    mdata.flightTelemetryUpdatePeriod = period;
+    manualCommandObj->setMetadata(mdata);
+}
+
+/**
+ * @brief ConfigInputWidget::startCalibrationSampling Collect the channel values
+ * of every ManualControlCommand received into minSeen, maxSeen and lastSeen,
+ * and refresh the widgets from them at display rate rather than on every
+ * update. The caller sets the ranges to start from.
+ */
+void ConfigInputWidget::startCalibrationSampling()
+{
+    channelsSampled = false;
+
+    // The channel widgets follow the samples from the refresh instead
+    disconnect(manualCommandObj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(refreshWidgetsValues(UAVObject*)));
+    connect(manualCommandObj, SIGNAL(objectUnpacked(UAVObject*)), this, SLOT(sampleChannels()), Qt::UniqueConnection);
+
+    calibrationRefresh->start();
+}
+
+/**
+ * @brief ConfigInputWidget::stopCalibrationSampling Stop collecting channel
+ * values, after applying those not yet refreshed
+ */
+void ConfigInputWidget::stopCalibrationSampling()
+{
+    calibrationRefresh->stop();
+
+    disconnect(manualCommandObj, SIGNAL(objectUnpacked(UAVObject*)), this, SLOT(sampleChannels()));
+    connect(manualCommandObj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(refreshWidgetsValues(UAVObject*)), Qt::UniqueConnection);
+
+    refreshCalibration();
+}
+
+/**
+ * @brief ConfigInputWidget::sampleChannels Fold the channels of a received
+ * ManualControlCommand into the ranges seen. Values outside the sane range,
+ * such as those of a receiver in failsafe, are left out.
+ */
+void ConfigInputWidget::sampleChannels()
+{
+    ManualControlCommand::DataFields data = manualCommandObj->getData();
+
+    for (unsigned int i = 0; i < ManualControlCommand::CHANNEL_NUMELEM; i++) {
+        int channelVal = data.Channel[i];
+
+        if ((channelVal <= MIN_SANE_CHANNEL_VALUE) ||
+                (channelVal >= MAX_SANE_CHANNEL_VALUE))
+            continue;
+
+        minSeen[i] = qMin(minSeen[i], channelVal);
+        maxSeen[i] = qMax(maxSeen[i], channelVal);
+        lastSeen[i] = channelVal;
+    }
+
+    channelsSampled = true;
+}
+
+/**
+ * @brief ConfigInputWidget::refreshCalibration Apply the channel values
+ * sampled since the last refresh to the calibration under way
+ */
+void ConfigInputWidget::refreshCalibration()
+{
+    if (!channelsSampled)
+        return;
+    channelsSampled = false;
+
+    refreshWidgetsValues(manualCommandObj);
+
+    if (wizardStep == wizardIdentifyLimits) {
+        identifyLimits();
+        moveSticks();
+    } else {
+        updateCalibration();
+    }
+}
+
 /**
   * Set the display to indicate which channel the person should move
   */
@@ -1007,28 +1099,16 @@ void ConfigInputWidget::identifyControls()
     QTimer::singleShot(CHANNEL_IDENTIFICATION_WAIT_TIME_MS, this, SLOT(wzNext()));
 }
 
+/**
+ * @brief ConfigInputWidget::identifyLimits Set the channel ranges from those
+ * sampled, see sampleChannels()
+ */
 void ConfigInputWidget::identifyLimits()
 {
     bool allSane=true;
 
-    manualCommandData=manualCommandObj->getData();
-
     for(quint8 i=0;i<ManualControlSettings::CHANNELMAX_NUMELEM;++i)
     {
-        uint16_t channelVal = manualCommandData.Channel[i];
-
-        // Don't mess up the range based on failsafe, etc.
-        if ((channelVal > MIN_SANE_CHANNEL_VALUE) &&
-                (channelVal < MAX_SANE_CHANNEL_VALUE)) {
-	    if (channelVal < minSeen[i]) {
-		minSeen[i] = channelVal;
-	    }
-
-	    if (channelVal > maxSeen[i]) {
-		maxSeen[i] = channelVal;
-	    }
-        }
-
 	switch (i) {
 	    case ManualControlSettings::CHANNELNUMBER_THROTTLE:
             // Keep the throttle neutral position near the minimum value so that
@@ -1697,18 +1777,22 @@ void ConfigInputWidget::updatePositionSlider()
     }
 }
 
+/**
+ * @brief ConfigInputWidget::updateCalibration Widen the channel ranges of the
+ * simple calibration to those sampled, see sampleChannels()
+ */
 void ConfigInputWidget::updateCalibration()
 {
-    manualCommandData=manualCommandObj->getData();
     for(quint8 i=0;i<ManualControlSettings::CHANNELMAX_NUMELEM;++i)
     {
-        if((!reverse[i] && manualSettingsData.ChannelMin[i]>manualCommandData.Channel[i]) ||
-                (reverse[i] && manualSettingsData.ChannelMin[i]<manualCommandData.Channel[i]))
-            manualSettingsData.ChannelMin[i]=manualCommandData.Channel[i];
-        if((!reverse[i] && manualSettingsData.ChannelMax[i]<manualCommandData.Channel[i]) ||
-                (reverse[i] && manualSettingsData.ChannelMax[i]>manualCommandData.Channel[i]))
-            manualSettingsData.ChannelMax[i]=manualCommandData.Channel[i];
-        manualSettingsData.ChannelNeutral[i] = manualCommandData.Channel[i];
+        if (!reverse[i]) {
+            manualSettingsData.ChannelMin[i] = qMin<int>(manualSettingsData.ChannelMin[i], minSeen[i]);
+            manualSettingsData.ChannelMax[i] = qMax<int>(manualSettingsData.ChannelMax[i], maxSeen[i]);
+        } else {
+            manualSettingsData.ChannelMin[i] = qMax<int>(manualSettingsData.ChannelMin[i], maxSeen[i]);
+            manualSettingsData.ChannelMax[i] = qMin<int>(manualSettingsData.ChannelMax[i], minSeen[i]);
+        }
+        manualSettingsData.ChannelNeutral[i] = lastSeen[i];
     }
 
     manualSettingsObj->setData(manualSettingsData);
@@ -1738,14 +1822,18 @@ void ConfigInputWidget::simpleCalibration(bool enable)
             manualSettingsData.ChannelMin[i] = manualCommandData.Channel[i];
             manualSettingsData.ChannelNeutral[i] = manualCommandData.Channel[i];
             manualSettingsData.ChannelMax[i] = manualCommandData.Channel[i];
+            minSeen[i] = maxSeen[i] = lastSeen[i] = manualCommandData.Channel[i];
         }
 
         fastMdata();
+        setManualCommandPeriod(CALIBRATION_UPDATE_PERIOD_MS);
 
-        connect(manualCommandObj, SIGNAL(objectUnpacked(UAVObject*)), this, SLOT(updateCalibration()));
+        startCalibrationSampling();
     } else {
         m_config->configurationWizard->setEnabled(true);
 
+        stopCalibrationSampling();
+
         manualCommandData = manualCommandObj->getData();
         manualSettingsData = manualSettingsObj->getData();
 
@@ -1770,8 +1858,6 @@ void ConfigInputWidget::simpleCalibration(bool enable)
                   manualSettingsData.ChannelMin[ManualControlSettings::CHANNELMIN_THROTTLE]) * THROTTLE_NEUTRAL_FRACTION;
 
         manualSettingsObj->setData(manualSettingsData);
-
-        disconnect(manualCommandObj, SIGNAL(objectUnpacked(UAVObject*)), this, SLOT(updateCalibration()));
     }
 }
 
@@ -108,11 +108,22 @@ private:
         // transmitters.
         static const int CHANNEL_IDENTIFICATION_WAIT_TIME_MS = 2500;
 
+        //! Telemetry period of ManualControlCommand through the wizard
+        static const int WIZARD_UPDATE_PERIOD_MS = 150;
+        //! And while the channel ranges are calibrated, so fast stick
+        //! movements don't miss the endpoints
+        static const int CALIBRATION_UPDATE_PERIOD_MS = 20;
+        //! The calibration widgets are refreshed no faster than this
+        static const int CALIBRATION_REFRESH_MS = 33;
+
         bool growing;
         bool reverse[ManualControlSettings::CHANNELNEUTRAL_NUMELEM];
 
         int minSeen[ManualControlSettings::CHANNELNEUTRAL_NUMELEM];
         int maxSeen[ManualControlSettings::CHANNELNEUTRAL_NUMELEM];
+        int lastSeen[ManualControlSettings::CHANNELNEUTRAL_NUMELEM];
+        bool channelsSampled;   // Since the calibration was last refreshed
+        QTimer *calibrationRefresh;
 
         txMovements currentMovement;
         int movePos;
@@ -197,6 +208,10 @@ private:
 
         void fastMdata();
         void restoreMdata();
+        void setManualCommandPeriod(quint16 period);
+
+        void startCalibrationSampling();
+        void stopCalibrationSampling();
 
         void setChannel(int);
         void nextChannel();
@@ -230,6 +245,8 @@ private slots:
         void invertControls();
         void simpleCalibration(bool state);
         void updateCalibration();
+        void sampleChannels();
+        void refreshCalibration();
         void checkArmingConfig();
         void checkReprojection();
         void updateArmingConfig(UAVObject *manualControlSettings);
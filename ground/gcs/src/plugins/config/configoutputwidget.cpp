@@ -537,6 +537,7 @@ void ConfigOutputWidget::refreshWidgetRanges()
                     // only the timer period provides bounding
                     maxPulseWidth = timerPeriodUs;
                     break;
+                case RATE_DSHOT150:
                 case RATE_DSHOT300:
                 case RATE_DSHOT600:
                 case RATE_DSHOT1200:
@@ -618,6 +619,7 @@ void ConfigOutputWidget::updateObjectsFromWidgets()
 QString ConfigOutputWidget::timerFreqToString(quint32 freq) const {
     static const QMap<quint32, QString> mapping{
         {RATE_SYNCPWM, tr("SyncPWM")},
+        {RATE_DSHOT150, tr("Dshot150")},
         {RATE_DSHOT300, tr("Dshot300")},
         {RATE_DSHOT600, tr("Dshot600")},
         {RATE_DSHOT1200, tr("Dshot1200")},
@@ -628,6 +630,7 @@ QString ConfigOutputWidget::timerFreqToString(quint32 freq) const {
 quint32 ConfigOutputWidget::timerStringToFreq(QString str) const {
     static const QMap<QString, quint32> mapping{
         {tr("SyncPWM"), RATE_SYNCPWM},
+        {tr("Dshot150"), RATE_DSHOT150},
         {tr("Dshot300"), RATE_DSHOT300},
         {tr("Dshot600"), RATE_DSHOT600},
         {tr("Dshot1200"), RATE_DSHOT1200},
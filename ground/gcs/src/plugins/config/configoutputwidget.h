@@ -50,6 +50,7 @@ public:
 private:
     enum SpecialOutputRates {
         RATE_SYNCPWM = 0,
+        RATE_DSHOT150 = 65531,
         RATE_DSHOT300 = 65532,
         RATE_DSHOT600 = 65533,
         RATE_DSHOT1200 = 65534,
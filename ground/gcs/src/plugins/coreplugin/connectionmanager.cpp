@@ -32,6 +32,7 @@
 #include <coreplugin/iconnection.h>
 #include <coreplugin/idevice.h>
 #include <extensionsystem/pluginmanager.h>
+#include <extensionsystem/tracelog.h>
 #include <QtSerialPort/QSerialPort>
 #include <QtSerialPort/QSerialPortInfo>
 #include <QDebug>
@@ -39,8 +40,12 @@
 #include <QHBoxLayout>
 #include <QComboBox>
 #include <QEventLoop>
+#include <QMenu>
 #include <alarmsmonitorwidget.h>
 
+// Time a preferred link gets to bring the telemetry up when auto connected, in ms
+#define AUTOCONNECT_CHECK_PERIOD 5000
+
 namespace Core {
 
 
@@ -50,7 +55,9 @@ ConnectionManager::ConnectionManager(Internal::MainWindow *mainWindow, QTabWidge
     m_connectBtn(0),
     m_ioDev(NULL),
     polling(true),
-    m_mainWindow(mainWindow)
+    m_mainWindow(mainWindow),
+    m_autoConnected(false),
+    m_telemetryConnected(false)
 {
     QHBoxLayout *layout = new QHBoxLayout;
     layout->setSpacing(5);
@@ -70,7 +77,14 @@ ConnectionManager::ConnectionManager(Internal::MainWindow *mainWindow, QTabWidge
 
     m_connectBtn = new QPushButton(tr("Connect"));
     m_connectBtn->setEnabled(false);
+    // The device list is disabled while connected, so the button has the
+    // menu for watching more vehicles too
+    m_connectBtn->setContextMenuPolicy(Qt::CustomContextMenu);
     layout->addWidget(m_connectBtn);
+    connect(m_availableDevList, SIGNAL(customContextMenuRequested(QPoint)),
+            this, SLOT(showAdditionalDeviceMenu(QPoint)));
+    connect(m_connectBtn, SIGNAL(customContextMenuRequested(QPoint)),
+            this, SLOT(showAdditionalDeviceMenu(QPoint)));
 
     setLayout(layout);
 
@@ -83,10 +97,17 @@ ConnectionManager::ConnectionManager(Internal::MainWindow *mainWindow, QTabWidge
     reconnectCheck = new QTimer(this);
     connect(reconnect,SIGNAL(timeout()),this,SLOT(reconnectSlot()));
     connect(reconnectCheck,SIGNAL(timeout()),this,SLOT(reconnectCheckSlot()));
+
+    autoConnectCheck = new QTimer(this);
+    autoConnectCheck->setSingleShot(true);
+    autoConnectCheck->setInterval(AUTOCONNECT_CHECK_PERIOD);
+    connect(autoConnectCheck,SIGNAL(timeout()),this,SLOT(autoConnectCheckSlot()));
 }
 
 ConnectionManager::~ConnectionManager()
 {
+    foreach (QIODevice *dev, m_additionalDevices.keys())
+        disconnectAdditionalDevice(dev);
     disconnectDevice();
     suspendPolling();
     if (m_monitorWidget)
@@ -131,6 +152,8 @@ bool ConnectionManager::connectDevice(DevListItem device)
         return false;
     }
 
+    ExtensionSystem::TraceScope trace("Open device", "connect");
+
     QIODevice *io_dev = device.connection->openDevice(device.device);
     if (!io_dev) {
         return false;
@@ -152,10 +175,14 @@ bool ConnectionManager::connectDevice(DevListItem device)
     // we appear to have connected to the device OK
     // remember the connection/device details
     m_connectionDevice = device;
+    m_connectionDeviceName = device.device->getName();
     m_ioDev = io_dev;
 
     connect(m_connectionDevice.connection, SIGNAL(destroyed(QObject *)), this, SLOT(onConnectionDestroyed(QObject *)), Qt::QueuedConnection);
 
+    // ended by the telemetry manager once the objects are retrieved
+    ExtensionSystem::TraceLog::asyncBegin("Board connect", "connect");
+
     // signal interested plugins that we connected to the device
     emit deviceConnected(io_dev);
     m_connectBtn->setText("Disconnect");
@@ -190,16 +217,19 @@ bool ConnectionManager::disconnectDevice()
         reconnect->stop();
     if(reconnectCheck->isActive())
         reconnectCheck->stop();
+    autoConnectCheck->stop();
+    m_autoConnected = false;
+    m_telemetryConnected = false;
 
     // signal interested plugins that user is disconnecting his device
     emit deviceAboutToDisconnect();
 
     try {
         if (m_connectionDevice.connection) {
-            m_connectionDevice.connection->closeDevice(m_connectionDevice.getConName());
+            m_connectionDevice.connection->closeDevice(m_connectionDeviceName);
         }
     } catch (...) {	// handle exception
-        qDebug() << "Exception: m_connectionDevice.connection->closeDevice(" << m_connectionDevice.getConName() << ")";
+        qDebug() << "Exception: m_connectionDevice.connection->closeDevice(" << m_connectionDeviceName << ")";
     }
 
     m_connectionDevice.connection = NULL;
@@ -212,6 +242,121 @@ bool ConnectionManager::disconnectDevice()
     return true;
 }
 
+/**
+ * @brief Opens a device to watch another vehicle on, leaving the main
+ * connection as it is.  Only for connections that support several open
+ * devices.
+ * @return the opened device, or NULL on failure
+ */
+QIODevice *ConnectionManager::connectAdditionalDevice(DevListItem device)
+{
+    if (!device.connection || device.device.isNull() ||
+            !device.connection->supportsMultipleDevices())
+        return NULL;
+
+    // The main connection, or already being watched
+    if (device == m_connectionDevice)
+        return NULL;
+    foreach (const AdditionalDevice &watched, m_additionalDevices) {
+        if (watched.device == device)
+            return NULL;
+    }
+
+    ExtensionSystem::TraceScope trace("Open additional device", "connect");
+
+    QIODevice *io_dev = device.connection->openDevice(device.device);
+    if (!io_dev)
+        return NULL;
+
+    if (!io_dev->isOpen())
+        io_dev->open(QIODevice::ReadWrite);
+    if (!io_dev->isOpen()) {
+        device.connection->closeDevice(device.device->getName());
+        return NULL;
+    }
+
+    AdditionalDevice watched;
+    watched.device = device;
+    watched.name = device.device->getName();
+    m_additionalDevices.insert(io_dev, watched);
+
+    emit additionalDeviceConnected(io_dev, device.getConName());
+    return io_dev;
+}
+
+/**
+ * @brief Stops watching the vehicle on a device from connectAdditionalDevice()
+ */
+bool ConnectionManager::disconnectAdditionalDevice(QIODevice *dev)
+{
+    if (!m_additionalDevices.contains(dev))
+        return false;
+
+    AdditionalDevice watched = m_additionalDevices.take(dev);
+
+    emit additionalDeviceAboutToDisconnect(dev);
+
+    if (watched.device.connection)
+        watched.device.connection->closeDevice(watched.name);
+
+    return true;
+}
+
+QList<DevListItem> ConnectionManager::getAdditionalDevices()
+{
+    QList<DevListItem> devices;
+    foreach (const AdditionalDevice &watched, m_additionalDevices)
+        devices.append(watched.device);
+    return devices;
+}
+
+/**
+ * @brief Offers the devices that can be watched besides the main
+ * connection, and those being watched
+ */
+void ConnectionManager::showAdditionalDeviceMenu(const QPoint &pos)
+{
+    QWidget *widget = qobject_cast<QWidget *>(sender());
+    if (!widget)
+        return;
+
+    QMenu menu;
+    QMenu *watchMenu = menu.addMenu(tr("Watch another vehicle"));
+    QMenu *stopMenu = menu.addMenu(tr("Stop watching"));
+
+    foreach (DevListItem d, m_devList) {
+        if (!d.connection || !d.connection->supportsMultipleDevices() ||
+                d == m_connectionDevice || getAdditionalDevices().contains(d))
+            continue;
+        watchMenu->addAction(d.getConName())->setData(d.getConName());
+    }
+
+    QMap<QAction *, QIODevice *> stopActions;
+    for (QMap<QIODevice *, AdditionalDevice>::iterator i = m_additionalDevices.begin();
+         i != m_additionalDevices.end(); ++i) {
+        QString name = i->device.getConName();
+        if (name.isEmpty())
+            name = i->name;
+        stopActions.insert(stopMenu->addAction(name), i.key());
+    }
+
+    watchMenu->setEnabled(!watchMenu->isEmpty());
+    stopMenu->setEnabled(!stopMenu->isEmpty());
+
+    QAction *chosen = menu.exec(widget->mapToGlobal(pos));
+    if (!chosen)
+        return;
+
+    if (stopActions.contains(chosen)) {
+        disconnectAdditionalDevice(stopActions.value(chosen));
+        return;
+    }
+
+    DevListItem device = findDevice(chosen->data().toString());
+    if (device.connection && !connectAdditionalDevice(device))
+        connectDeviceFailed(device);
+}
+
 /**
 *   Slot called when a plugin added an object to the core pool
 */
@@ -244,6 +389,11 @@ void ConnectionManager::aboutToRemoveObject(QObject *obj)
         m_ioDev = NULL;
     }
 
+    foreach (QIODevice *dev, m_additionalDevices.keys()) {
+        if (m_additionalDevices.value(dev).device.connection == connection)
+            disconnectAdditionalDevice(dev);
+    }
+
     if (m_connectionsList.contains(connection))
         m_connectionsList.removeAt(m_connectionsList.indexOf(connection));
 }
@@ -286,6 +436,8 @@ void ConnectionManager::telemetryConnected()
 
     if(reconnectCheck->isActive())
         reconnectCheck->stop();
+    autoConnectCheck->stop();
+    m_telemetryConnected = true;
 
     //tell the monitor we're connected
     m_monitorWidget->connected();
@@ -298,6 +450,7 @@ void ConnectionManager::telemetryDisconnected()
 {
     qDebug() << "TelemetryMonitor: disconnected";
 
+    m_telemetryConnected = false;
     if (m_ioDev){
         if(m_connectionDevice.connection->reconnect())//currently used with bluetooth only
         {
@@ -338,6 +491,24 @@ void ConnectionManager::reconnectCheckSlot()
     reconnect->start(1000);
 }
 
+/**
+*   A preferred link was auto connected but no telemetry came over it,
+*   it is probably bound to something else on the board. Leave it for
+*   the next candidate.
+*/
+void ConnectionManager::autoConnectCheckSlot()
+{
+    if (!m_ioDev || !m_autoConnected || m_telemetryConnected)
+        return;
+
+    qDebug() << "No telemetry on" << m_connectionDevice.getConName() << "- skipping it for auto connection";
+    m_autoConnectSkipped.insert(m_connectionDevice.getConName());
+    disconnectDevice();
+
+    m_availableDevList->clear();
+    updateConnectionDropdown();
+}
+
 /**
 *   Find a device by its displayed (visible on screen) name
 */
@@ -487,24 +658,64 @@ void ConnectionManager::devChanged(IConnection *connection)
         m_connectBtn->setEnabled(false);
 }
 
+/**
+*   USB HID boards, and the board links their plugin marks as preferred
+*/
+bool ConnectionManager::autoConnectCandidate(DevListItem &device)
+{
+    if (device.device.isNull() || m_autoConnectSkipped.contains(device.getConName()))
+        return false;
+    return device.getConName().startsWith("USB") || device.device->getPreferred();
+}
+
 void ConnectionManager::updateConnectionDropdown()
 {
+    QSet<QString> present;
+    int candidate = -1;
+    DevListItem candidateDevice;
+
     //add all the list again to the combobox
     foreach (DevListItem d, m_devList)
     {
+        present.insert(d.getConName());
         m_availableDevList->addItem(d.getConName());
         m_availableDevList->setItemData(m_availableDevList->count()-1, d.getConName(), Qt::ToolTipRole);
-        if(!m_ioDev && d.getConName().startsWith("USB"))
+
+        // The first candidate wins, unless a later one is preferred
+        if (autoConnectCandidate(d) && (candidate < 0 || (d.device->getPreferred() && !candidateDevice.device->getPreferred())))
         {
-            if(m_mainWindow->generalSettings()->autoConnect() || m_mainWindow->generalSettings()->autoSelect())
-                m_availableDevList->setCurrentIndex(m_availableDevList->count() - 1);
+            candidate = m_availableDevList->count() - 1;
+            candidateDevice = d;
+        }
+    }
+
+    // Links that went away get another chance when they come back
+    m_autoConnectSkipped.intersect(present);
+
+    // A preferred link showing up while the automatic connection is still
+    // waiting for telemetry replaces it
+    if (m_ioDev && m_autoConnected && !m_telemetryConnected && candidate >= 0 &&
+            candidateDevice.device->getPreferred() && !(candidateDevice == m_connectionDevice))
+    {
+        qDebug() << "Switching the automatic connection to" << candidateDevice.getConName();
+        disconnectDevice();
+    }
 
-            if(m_mainWindow->generalSettings()->autoConnect() && polling)
+    if(!m_ioDev && candidate >= 0)
+    {
+        if(m_mainWindow->generalSettings()->autoConnect() || m_mainWindow->generalSettings()->autoSelect())
+            m_availableDevList->setCurrentIndex(candidate);
+
+        if(m_mainWindow->generalSettings()->autoConnect() && polling)
+        {
+            qDebug() << "Automatically opening device";
+            if (connectDevice(candidateDevice))
             {
-                qDebug() << "Automatically opening device";
-                connectDevice(d);
-                qDebug()<<"ConnectionManager::devChanged autoconnected USB device";
+                m_autoConnected = true;
+                if (candidateDevice.device->getPreferred())
+                    autoConnectCheck->start();
             }
+            qDebug()<<"ConnectionManager::devChanged autoconnected USB device";
         }
     }
     if(m_ioDev)//if a device is connected make it the one selected on the dropbox
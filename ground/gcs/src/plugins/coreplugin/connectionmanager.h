@@ -48,6 +48,7 @@
 
 #include "core_global.h"
 #include <QTimer>
+#include <QSet>
 
 QT_BEGIN_NAMESPACE
 class QTabWidget;
@@ -77,7 +78,7 @@ public:
         return connection->shortName() + ": " + device->getDisplayName();
     }
 
-    bool operator==(const DevListItem &rhs) {
+    bool operator==(const DevListItem &rhs) const {
         return connection == rhs.connection && device == rhs.device;
     }
 
@@ -106,6 +107,10 @@ public:
 
     bool connectDevice(DevListItem device);
     bool disconnectDevice();
+
+    QIODevice *connectAdditionalDevice(DevListItem device);
+    bool disconnectAdditionalDevice(QIODevice *dev);
+    QList<DevListItem> getAdditionalDevices();
     void suspendPolling();
     void resumePolling();
     TelemetryMonitorWidget * getTelemetryMonitorWidget(){return m_monitorWidget;}
@@ -114,11 +119,14 @@ protected:
     void updateConnectionList(IConnection *connection);
     void registerDevice(IConnection *conn, IDevice *device);
     void updateConnectionDropdown();
+    bool autoConnectCandidate(DevListItem &device);
 
 signals:
     void deviceConnected(QIODevice *device);
     void deviceAboutToDisconnect();
     void deviceDisconnected();
+    void additionalDeviceConnected(QIODevice *device, const QString &name);
+    void additionalDeviceAboutToDisconnect(QIODevice *device);
     void availableDevicesChanged(const QLinkedList<Core::DevListItem> devices);
 
 public slots:
@@ -137,6 +145,8 @@ private slots:
     void connectionsCallBack(); //used to call devChange after all the plugins are loaded
     void reconnectSlot();
     void reconnectCheckSlot();
+    void autoConnectCheckSlot();
+    void showAdditionalDeviceMenu(const QPoint &pos);
 
 protected:
     QComboBox *m_availableDevList;
@@ -149,6 +159,8 @@ protected:
 
     //currently connected connection plugin
     DevListItem m_connectionDevice;
+    // what to close it by; the device itself may be gone by then
+    QString m_connectionDeviceName;
 
     // Last thing the user tried to connect to manually
     DevListItem m_lastManualConnect;
@@ -167,7 +179,23 @@ private:
     QTimer *reconnect;
     QTimer *reconnectCheck;
 
+    // Automatic connections still waiting for telemetry can be traded for
+    // a preferred link, and preferred links that never bring telemetry up
+    // are skipped until they go away
+    bool m_autoConnected;
+    bool m_telemetryConnected;
+    QTimer *autoConnectCheck;
+    QSet<QString> m_autoConnectSkipped;
+
     void connectDeviceFailed(DevListItem &device);
+
+    // Devices watched as more vehicles besides the main connection, with
+    // the device name to close each by, as the device may be gone by then
+    struct AdditionalDevice {
+        DevListItem device;
+        QString name;
+    };
+    QMap<QIODevice *, AdditionalDevice> m_additionalDevices;
 };
 
 } //namespace Core
@@ -84,6 +84,13 @@ public:
      */
     virtual bool reconnect() { return false; }
 
+    /**
+     * @brief Whether several of its devices can be open at once, so that
+     * more vehicles can be watched besides the main connection.  Such a
+     * connection closes the device named by closeDevice(), by its name.
+     */
+    virtual bool supportsMultipleDevices() { return false; }
+
 signals:
     /**
     *   Available devices list has changed, signal it to connection manager (and whoever wants to know)
@@ -47,13 +47,17 @@ class CORE_EXPORT IDevice : public QObject
 {
     Q_OBJECT
 public:
-
+    IDevice() : preferred(false) { }
 
     QString getName() const { return name; }
     void setName(QString theName) { name = theName; }
     QString getDisplayName() const { return displayName; }
     void setDisplayName( QString dn ) { displayName = dn; }
 
+    /** Picked over the other links to the same board when auto connecting */
+    bool getPreferred() const { return preferred; }
+    void setPreferred(bool pref) { preferred = pref; }
+
     /*
     bool operator==(const IDevice *idv) const {
         return name == idv->getName()  && displayName == idv->getDisplayName();
@@ -67,6 +71,7 @@ public:
 private:
     QString name;
     QString displayName;
+    bool preferred;
 
 
 };
@@ -60,6 +60,7 @@
 #include "versiondialog.h"
 
 #include <extensionsystem/pluginmanager.h>
+#include <extensionsystem/tracelog.h>
 #include "dialogs/iwizard.h"
 #include <utils/hostosinfo.h>
 #include <utils/pathchooser.h>
@@ -356,9 +357,15 @@ void MainWindow::extensionsInitialized()
     qs->endGroup();
     m_uavGadgetInstanceManager = new UAVGadgetInstanceManager(this);
     connect(m_uavGadgetInstanceManager,SIGNAL(splashMessages(QString)),this,SIGNAL(splashMessages(QString)));
-    m_uavGadgetInstanceManager->readSettings(qs);
+    {
+        ExtensionSystem::TraceScope trace("Read gadget configurations", "ui");
+        m_uavGadgetInstanceManager->readSettings(qs);
+    }
 
-    readSettings(qs);
+    {
+        ExtensionSystem::TraceScope trace("Restore workspaces", "ui");
+        readSettings(qs);
+    }
     updateContext();
     emit splashMessages(tr("Preparing to open core"));
 
@@ -370,6 +377,7 @@ void MainWindow::extensionsInitialized()
         QDir::setCurrent(QDir::homePath());
     }
 
+    ExtensionSystem::TraceScope trace("Open main window", "ui");
     emit m_coreImpl->coreAboutToOpen();
     show();
     emit m_coreImpl->coreOpened();
@@ -128,7 +128,11 @@ void UAVGadgetDecorator::saveState(QSettings* qSettings)
 
 void UAVGadgetDecorator::restoreState(QSettings* qSetting)
 {
-    QString configName = qSetting->value("activeConfiguration").toString();
+    restoreConfiguration(qSetting->value("activeConfiguration").toString());
+}
+
+void UAVGadgetDecorator::restoreConfiguration(const QString &configName)
+{
     foreach (IUAVGadgetConfiguration *config, *m_configurations) {
         if (config->name() == configName) {
             m_activeConfiguration = config;
@@ -46,6 +46,7 @@ public:
     void loadConfiguration(IUAVGadgetConfiguration *config);
     void saveState(QSettings* qSettings);
     void restoreState(QSettings* qSettings);
+    void restoreConfiguration(const QString &configName);
 public slots:
     void configurationChanged(IUAVGadgetConfiguration* config);
     void configurationAdded(IUAVGadgetConfiguration* config);
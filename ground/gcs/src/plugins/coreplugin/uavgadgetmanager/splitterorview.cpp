@@ -33,6 +33,9 @@
 #include "iuavgadget.h"
 #include "minisplitter.h"
 
+#include <coreplugin/modemanager.h>
+#include <coreplugin/uavgadgetdecorator.h>
+
 #include <QtCore/QDebug>
 
 
@@ -260,6 +263,31 @@ void SplitterOrView::split(Qt::Orientation orientation, bool restoring)
     }
 }
 
+/**
+ * @brief Create the gadgets restoreState() left for when the workspace is shown
+ */
+void SplitterOrView::createPendingGadgets()
+{
+    if (m_splitter) {
+        static_cast<SplitterOrView*>(m_splitter->widget(0))->createPendingGadgets();
+        static_cast<SplitterOrView*>(m_splitter->widget(1))->createPendingGadgets();
+        return;
+    }
+
+    if (!m_view || m_pendingClassId.isEmpty())
+        return;
+
+    int index = m_view->indexOfClassId(m_pendingClassId);
+    m_view->selectionActivated(index, false);
+
+    UAVGadgetDecorator *decorator = qobject_cast<UAVGadgetDecorator*>(gadget());
+    if (decorator && !m_pendingConfiguration.isEmpty())
+        decorator->restoreConfiguration(m_pendingConfiguration);
+
+    m_pendingClassId.clear();
+    m_pendingConfiguration.clear();
+}
+
 void SplitterOrView::onSplitterMoved( int pos, int index ) {
     Q_UNUSED(pos);
     Q_UNUSED(index);
@@ -349,11 +377,22 @@ void SplitterOrView::saveState(QSettings* qSettings) const {
         qSettings->beginGroup("gadget");
         gadget()->saveState(qSettings);
         qSettings->endGroup();
+    } else if (!m_pendingClassId.isEmpty()) {
+        qSettings->setValue("type", "uavGadget");
+        qSettings->setValue("classId", m_pendingClassId);
+        if (!m_pendingConfiguration.isEmpty()) {
+            qSettings->beginGroup("gadget");
+            qSettings->setValue("activeConfiguration", m_pendingConfiguration);
+            qSettings->endGroup();
+        }
     }
 }
 
 void SplitterOrView::restoreState(QSettings* qSettings)
 {
+    m_pendingClassId.clear();
+    m_pendingConfiguration.clear();
+
     QString mode = qSettings->value("type").toString();
     if (mode == "splitter") {
         qint32 orientation = qSettings->value("splitterOrientation").toInt();
@@ -372,6 +411,16 @@ void SplitterOrView::restoreState(QSettings* qSettings)
         qSettings->endGroup();
     } else if (mode == "uavGadget") {
         QString classId = qSettings->value("classId").toString();
+
+        // Maps, models and the like are slow to create, so a workspace that
+        // isn't showing only gets its gadgets when it's first shown.  All the
+        // decorator wrapping each gadget keeps is its active configuration.
+        if (ModeManager::instance()->currentMode() != m_uavGadgetManager.data()) {
+            m_pendingClassId = classId;
+            m_pendingConfiguration = qSettings->value("gadget/activeConfiguration").toString();
+            return;
+        }
+
         int index = m_view->indexOfClassId(classId);
         m_view->selectionActivated(index, false);
         if(qSettings->childGroups().contains("gadget")) {
@@ -61,6 +61,7 @@ public:
 
     void saveState(QSettings*) const;
     void restoreState(QSettings*);
+    void createPendingGadgets();
 
     SplitterOrView *findView(Core::IUAVGadget *uavGadget);
     SplitterOrView *findView(UAVGadgetView *view);
@@ -101,6 +102,10 @@ private:
 
     // The splitter sizes. We keep our own copy of these, since after loading they can't realiably be retrieved.
     QList<int> m_sizes;
+
+    // The gadget restored into our view while its workspace was hidden, created when it's first shown.
+    QString m_pendingClassId;
+    QString m_pendingConfiguration;
 };
 
 
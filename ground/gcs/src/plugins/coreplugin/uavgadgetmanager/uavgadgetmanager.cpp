@@ -134,6 +134,8 @@ void UAVGadgetManager::modeChanged(Core::IMode *mode)
     if (mode != this)
         return;
 
+    m_splitterOrView->createPendingGadgets();
+
     if (!m_currentGadget) {
         m_splitterOrView->view()->doReplaceGadget(0);
     }
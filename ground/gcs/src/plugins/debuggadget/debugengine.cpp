@@ -27,9 +27,13 @@
 
 #include "debugengine.h"
 
-DebugEngine::DebugEngine()
+#include <QTimer>
+
+DebugEngine::DebugEngine() : total(0), flushPending(false)
 {
     qRegisterMetaType<DebugEngine::Level>("DebugEngine::Level");
+    ring.resize(CAPACITY);
+    clock.start();
 }
 
 DebugEngine *DebugEngine::getInstance()
@@ -38,6 +42,138 @@ DebugEngine *DebugEngine::getInstance()
     return &objectInstance;
 }
 
+/**
+ * @brief Stores a message, unless its category is over the rate limit.
+ * Can be called from any thread.
+ * @param category name of the logging category, or null for the default
+ */
+void DebugEngine::log(Level level, const QString &msg, const char *category,
+                      const QString &file, int line, const QString &function)
+{
+    Entry entry;
+    entry.level = level;
+    entry.time = QTime::currentTime();
+    entry.msg = msg;
+    entry.file = file;
+    entry.line = line;
+    entry.function = function;
+
+    bool schedule = false;
+    {
+        QMutexLocker locker(&lock);
+
+        // Warnings and worse are rare, and always kept
+        if (level <= INFO) {
+            QString name = QLatin1String(category ? category : "default");
+            RateLimit &limit = limits[name];
+            qint64 now = clock.elapsed();
+
+            if (now - limit.windowStart >= 1000) {
+                reportSuppressed(name, limit);
+                limit.windowStart = now;
+                limit.count = 0;
+            }
+
+            if (++limit.count > RATE_LIMIT) {
+                limit.suppressed++;
+                return;
+            }
+        }
+
+        store(entry);
+
+        if (!flushPending) {
+            flushPending = true;
+            schedule = true;
+        }
+    }
+
+    // The timer has to be started from this object's thread
+    if (schedule)
+        QMetaObject::invokeMethod(this, "scheduleFlush", Qt::QueuedConnection);
+
+    emit message(level, msg, file, line, function);
+}
+
+/**
+ * @brief The entries stored after the one numbered seq, as far as they
+ * are still in the buffer
+ * @param[out] last the number to pass next time
+ */
+QVector<DebugEngine::Entry> DebugEngine::entriesSince(quint64 seq, quint64 *last) const
+{
+    QMutexLocker locker(&lock);
+
+    quint64 first = qMax(seq, total > CAPACITY ? total - CAPACITY : 0);
+
+    QVector<Entry> entries;
+    entries.reserve(total - first);
+    for (quint64 i = first; i < total; i++)
+        entries.append(ring[i % CAPACITY]);
+
+    *last = total;
+    return entries;
+}
+
+void DebugEngine::scheduleFlush()
+{
+    QTimer::singleShot(FLUSH_INTERVAL_MS, this, SLOT(flush()));
+}
+
+void DebugEngine::flush()
+{
+    bool again = false;
+    {
+        QMutexLocker locker(&lock);
+
+        // Say how much was dropped once each window is over, which may
+        // take another flush if the messages stopped meanwhile
+        qint64 now = clock.elapsed();
+        for (QHash<QString, RateLimit>::iterator i = limits.begin(); i != limits.end(); ++i) {
+            if (!i->suppressed)
+                continue;
+            if (now - i->windowStart >= 1000)
+                reportSuppressed(i.key(), *i);
+            else
+                again = true;
+        }
+
+        flushPending = again;
+    }
+
+    if (again)
+        scheduleFlush();
+
+    emit entriesAdded();
+}
+
+/**
+ * @brief Stores a note of the messages dropped from a category, if any.
+ * Called with the lock held.
+ */
+void DebugEngine::reportSuppressed(const QString &category, RateLimit &limit)
+{
+    if (!limit.suppressed)
+        return;
+
+    Entry entry;
+    entry.level = INFO;
+    entry.time = QTime::currentTime();
+    entry.msg = QString("%1 more messages from %2 in one second were dropped")
+            .arg(limit.suppressed).arg(category);
+    entry.line = 0;
+    store(entry);
+
+    limit.suppressed = 0;
+}
+
+//! Called with the lock held
+void DebugEngine::store(const Entry &entry)
+{
+    ring[total % CAPACITY] = entry;
+    total++;
+}
+
 /**
  * @}
  * @}
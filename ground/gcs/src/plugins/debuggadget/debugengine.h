@@ -30,9 +30,23 @@
 #include <QTextBrowser>
 #include <QPointer>
 #include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QTime>
+#include <QVector>
 #include "debuggadget_global.h"
 
-
+/**
+ * @brief Keeps the most recent messages in a ring buffer, for the debug
+ * gadgets to show.
+ *
+ * Messages can come from any thread and at any rate, so they are only
+ * stored as they arrive.  The gadgets are told about new ones at most
+ * every FLUSH_INTERVAL_MS, and then fetch all of them at once with
+ * entriesSince().  Debug and info messages beyond RATE_LIMIT a second
+ * from one category are counted rather than stored.
+ */
 class DEBUGGADGET_EXPORT DebugEngine : public QObject {
     Q_OBJECT
     // Add all missing constructor etc... to have singleton
@@ -46,10 +60,51 @@ public:
         FATAL,
     };
 
+    struct Entry {
+        Level level;
+        QTime time;
+        QString msg;
+        QString file;
+        int line;
+        QString function;
+    };
+
+    static const int CAPACITY = 5000;
+    static const int FLUSH_INTERVAL_MS = 250;
+    static const int RATE_LIMIT = 200;
+
     static DebugEngine *getInstance();
 
+    void log(Level level, const QString &msg, const char *category = 0,
+             const QString &file = "", int line = 0, const QString &function = "");
+    QVector<Entry> entriesSince(quint64 seq, quint64 *last) const;
+
 signals:
+    //! Each message that is stored, as it arrives
     void message(DebugEngine::Level level, const QString &msg, const QString &file = "", const int line = 0, const QString &function = "");
+    //! There are entries after the last seen with entriesSince()
+    void entriesAdded();
+
+private slots:
+    void scheduleFlush();
+    void flush();
+
+private:
+    struct RateLimit {
+        qint64 windowStart;
+        int count;
+        int suppressed;
+    };
+
+    void store(const Entry &entry);
+    void reportSuppressed(const QString &category, RateLimit &limit);
+
+    mutable QMutex lock;
+    QVector<Entry> ring;
+    quint64 total; // Entries ever stored; the newest is ring[(total - 1) % CAPACITY]
+    bool flushPending;
+    QHash<QString, RateLimit> limits;
+    QElapsedTimer clock;
 };
 
 #endif // DEBUGENGINE_H
@@ -54,7 +54,7 @@ void customMessageHandler(QtMsgType type, const QMessageLogContext &context, con
         QTextStream(stderr) << "[FATAL] " << msg << endl;
         break;
     }
-    DebugEngine::getInstance()->message(level, msg, QString(context.file), context.line, QString(context.function));
+    DebugEngine::getInstance()->log(level, msg, context.category, QString(context.file), context.line, QString(context.function));
 }
 
 DebugGadgetFactory::DebugGadgetFactory(QObject *parent) :
@@ -64,7 +64,7 @@ DebugGadgetFactory::DebugGadgetFactory(QObject *parent) :
 {
     QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
     if (env.contains("NO_DEBUG_GADGET"))
-        DebugEngine::getInstance()->message(DebugEngine::INFO, "Debug gadget disabled by NO_DEBUG_GADGET env. var.");
+        DebugEngine::getInstance()->log(DebugEngine::INFO, "Debug gadget disabled by NO_DEBUG_GADGET env. var.");
     else
         qInstallMessageHandler(customMessageHandler);
 }
@@ -29,7 +29,8 @@
 #include <QDebug>
 #include <QStringList>
 #include <QWidget>
-#include <QTextEdit>
+#include <QPlainTextEdit>
+#include <QTextCursor>
 #include <QVBoxLayout>
 #include <QPushButton>
 #include "debugengine.h"
@@ -39,16 +40,19 @@
 #include <QScrollBar>
 #include <QTime>
 
-DebugGadgetWidget::DebugGadgetWidget(QWidget *parent) : QLabel(parent)
+DebugGadgetWidget::DebugGadgetWidget(QWidget *parent) : QLabel(parent), lastSeen(0)
 {
     m_config = new Ui_Form();
     m_config->setupUi(this);
+    // The oldest lines go as new ones come in, like the engine's buffer
+    m_config->plainTextEdit->setMaximumBlockCount(DebugEngine::CAPACITY);
     DebugEngine *de = DebugEngine::getInstance();
-    connect(de, SIGNAL(message(DebugEngine::Level, const QString &, const QString &, const int, const QString &)),
-                this, SLOT(message(DebugEngine::Level, const QString &, const QString &, const int, const QString &)),
-                Qt::QueuedConnection);
+    connect(de, SIGNAL(entriesAdded()), this, SLOT(showNewEntries()));
     connect(m_config->saveToFile, SIGNAL(clicked()), this, SLOT(saveLog()));
     connect(m_config->clearLog, SIGNAL(clicked()), this, SLOT(clearLog()));
+
+    // Along with whatever was logged before the gadget was opened
+    showNewEntries();
 }
 
 DebugGadgetWidget::~DebugGadgetWidget()
@@ -66,7 +70,7 @@ void DebugGadgetWidget::saveLog()
 
     QFile file(fileName);
     if (file.open(QIODevice::WriteOnly) &&
-        (file.write(m_config->plainTextEdit->toHtml().toLatin1()) != -1)) {
+        (file.write(m_config->plainTextEdit->document()->toHtml().toLatin1()) != -1)) {
         file.close();
     } else {
         QMessageBox::critical(0,
@@ -82,45 +86,81 @@ void DebugGadgetWidget::clearLog()
     m_config->plainTextEdit->clear();
 }
 
-void DebugGadgetWidget::message(DebugEngine::Level level, const QString &msg, const QString &file, const int line, const QString &function)
+/**
+ * @brief Appends the entries logged since the last call, all in one edit
+ */
+void DebugGadgetWidget::showNewEntries()
+{
+    QVector<DebugEngine::Entry> entries = DebugEngine::getInstance()->entriesSince(lastSeen, &lastSeen);
+    if (entries.isEmpty())
+        return;
+
+    QPlainTextEdit *log = m_config->plainTextEdit;
+    QScrollBar *sb = log->verticalScrollBar();
+    bool atBottom = sb->value() == sb->maximum();
+
+    QTextCursor cursor(log->document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.beginEditBlock();
+
+    bool firstBlock = log->document()->isEmpty();
+    foreach (const DebugEngine::Entry &entry, entries) {
+        if (!firstBlock)
+            cursor.insertBlock();
+        firstBlock = false;
+
+        QTextCharFormat format;
+        format.setForeground(levelColor(entry.level));
+        cursor.insertText(formatEntry(entry), format);
+    }
+
+    cursor.endEditBlock();
+
+    // Follow the log, unless the user has scrolled back to read it
+    if (atBottom)
+        sb->setValue(sb->maximum());
+}
+
+QColor DebugGadgetWidget::levelColor(DebugEngine::Level level)
 {
-    QColor color;
-    QString type;
     switch (level) {
     case DebugEngine::DEBUG:
-        color = Qt::blue;
+        return Qt::blue;
+    case DebugEngine::INFO:
+        return Qt::black;
+    default:
+        return Qt::red;
+    }
+}
+
+QString DebugGadgetWidget::formatEntry(const DebugEngine::Entry &entry)
+{
+    QString type;
+    switch (entry.level) {
+    case DebugEngine::DEBUG:
         type = "debug";
         break;
     case DebugEngine::INFO:
-        color = Qt::black;
         type = "info";
         break;
     case DebugEngine::WARNING:
-        color = Qt::red;
         type = "WARNING";
         break;
     case DebugEngine::CRITICAL:
-        color = Qt::red;
         type = "CRITICAL";
         break;
     case DebugEngine::FATAL:
-        color = Qt::red;
         type = "FATAL";
         break;
     }
 
     QString source;
 #ifdef QT_DEBUG // only display this extended info to devs
-    source = QString("[%0:%1 %2]").arg(file).arg(line).arg(function);
-#else
-    Q_UNUSED(file); Q_UNUSED(line); Q_UNUSED(function);
+    if (!entry.file.isEmpty())
+        source = QString("[%0:%1 %2]").arg(entry.file).arg(entry.line).arg(entry.function);
 #endif
 
-    m_config->plainTextEdit->setTextColor(color);
-    m_config->plainTextEdit->append(QString("%0[%1]%2 %3").arg(QTime::currentTime().toString()).arg(type).arg(source).arg(msg));
-
-    QScrollBar *sb = m_config->plainTextEdit->verticalScrollBar();
-    sb->setValue(sb->maximum());
+    return QString("%0[%1]%2 %3").arg(entry.time.toString()).arg(type).arg(source).arg(entry.msg);
 }
 
 /**
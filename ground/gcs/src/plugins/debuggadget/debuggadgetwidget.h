@@ -39,10 +39,14 @@ public:
     ~DebugGadgetWidget();
 private:
     Ui_Form *m_config;
+    quint64 lastSeen; // Of the engine's entries
+
+    static QColor levelColor(DebugEngine::Level level);
+    static QString formatEntry(const DebugEngine::Entry &entry);
 private slots:
     void saveLog();
     void clearLog();
-    void message(DebugEngine::Level level, const QString &msg, const QString &file, const int line, const QString &function);
+    void showNewEntries();
 };
 #endif /* DEBUGGADGETWIDGET_H_ */
 
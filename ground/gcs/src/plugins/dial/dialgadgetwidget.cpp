@@ -58,6 +58,8 @@ DialGadgetWidget::DialGadgetWidget(QWidget *parent) : QGraphicsView(parent)
     needle2Target = 0;
     needle3Target = 0;
 
+    dialError = true; // Until a dial file is loaded
+
 //	beSmooth = true;
 	beSmooth = false;
 
@@ -335,6 +337,12 @@ void DialGadgetWidget::setDialFile(QString dfn, QString bg, QString fg, QString
 
     l_scene->setSceneRect(m_background->boundingRect());
 
+    // The background and foreground only change with the dial size, so
+    // they are drawn from pixmaps rendered for the current view transform.
+    m_background->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+    if (fgenabled)
+        m_foreground->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+
     // Now Initialize the center for all transforms of the dial needles to the
     // center of the background:
     // - Move the center of the needle to the center of the background.
@@ -412,6 +420,7 @@ void DialGadgetWidget::setDialFile(QString dfn, QString bg, QString fg, QString
     if (!dialTimer.isActive())
         dialTimer.start();
     dialError = false;
+    cacheNeedles();
    }
    else
    {
@@ -453,6 +462,32 @@ void DialGadgetWidget::resizeEvent(QResizeEvent *event)
 {
     Q_UNUSED(event);
     fitInView(m_background, Qt::KeepAspectRatio );
+    cacheNeedles();
+}
+
+/**
+ * The needles are cached in their own coordinates, so that rotating or
+ * moving them redraws the pixmap rather than the SVG.  The pixmap has to
+ * be as large as the needle is shown for it to stay sharp, so this is
+ * redone whenever the view is scaled.
+ */
+void DialGadgetWidget::cacheNeedles()
+{
+    if (dialError)
+        return;
+
+    qreal ratio = devicePixelRatioF();
+    QList<QGraphicsSvgItem *> needles;
+    needles << m_needle1;
+    if (n2enabled && m_needle2 != m_needle1)
+        needles << m_needle2;
+    if (n3enabled)
+        needles << m_needle3;
+
+    foreach (QGraphicsSvgItem *needle, needles) {
+        QSizeF size = transform().mapRect(needle->boundingRect()).size() * ratio;
+        needle->setCacheMode(QGraphicsItem::ItemCoordinateCache, size.toSize());
+    }
 }
 
 void DialGadgetWidget::setDialFont(QString fontProps)
@@ -482,7 +517,9 @@ void DialGadgetWidget::setNeedle1(double value) {
     if (m_text1) {
         QString s;
         s.sprintf("%.2f",value*n1Factor);
-        m_text1->setPlainText(s);
+        // Laying the text out again costs more than moving the needle
+        if (m_text1->toPlainText() != s)
+            m_text1->setPlainText(s);
     }
 }
 
@@ -501,7 +538,8 @@ void DialGadgetWidget::setNeedle2(double value) {
     if (m_text2) {
         QString s;
         s.sprintf("%.2f",value*n2Factor);
-        m_text2->setPlainText(s);
+        if (m_text2->toPlainText() != s)
+            m_text2->setPlainText(s);
     }
 
 }
@@ -521,7 +559,8 @@ void DialGadgetWidget::setNeedle3(double value) {
     if (m_text3) {
         QString s;
         s.sprintf("%.2f",value*n3Factor);
-        m_text3->setPlainText(s);
+        if (m_text3->toPlainText() != s)
+            m_text3->setPlainText(s);
     }
 }
 
@@ -84,6 +84,8 @@ private slots:
    void rotateNeedles();
 
 private:
+   void cacheNeedles();
+
    QSvgRenderer *m_renderer;
    QGraphicsSvgItem *m_background;
    QGraphicsSvgItem *m_foreground;
@@ -56,21 +56,30 @@ GpsConstellationWidget::GpsConstellationWidget(QWidget *parent) : QGraphicsView(
     world = new QGraphicsSvgItem();
     world->setSharedRenderer(renderer);
     world->setElementId("map");
+    // The sky grid never changes, so only render the SVG again on resize
+    world->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
 
     scene = new QGraphicsScene(this);
     scene->addItem(world);
     scene->setSceneRect(world->boundingRect());
     setScene(scene);
 
+    refreshTimer = new QTimer(this);
+    refreshTimer->setSingleShot(true);
+    refreshTimer->setInterval(REFRESH_MS);
+    connect(refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+
     // Now create 'maxSatellites' satellite icons which we will move around on the map:
     for (int i = 0; i < MAX_SATELLITES; i++) {
         satellites[i][0] = 0;
         satellites[i][1] = 0;
         satellites[i][2] = 0;
         satellites[i][3] = 0;
+        changed[i] = false;
 
         satIcons[i] = new QGraphicsSvgItem(world);
         satIcons[i]->setSharedRenderer(renderer);
+        satIcons[i]->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
         satIcons[i]->setElementId("sat-notSeen");
         satIcons[i]->hide();
 
@@ -111,17 +120,49 @@ void GpsConstellationWidget::resizeEvent(QResizeEvent* event)
 
 void GpsConstellationWidget::updateSat(int index, int prn, int elevation, int azimuth, int snr)
 {
-    if (index >= MAX_SATELLITES) {
+    if (index < 0 || index >= MAX_SATELLITES) {
         // A bit of error checking never hurts.
         return;
     }
 
+    // Most satellites are the same from one update to the next
+    if (satellites[index][0] == prn && satellites[index][1] == elevation &&
+            satellites[index][2] == azimuth && satellites[index][3] == snr) {
+        return;
+    }
+
     // TODO: add range checking
     satellites[index][0] = prn;
     satellites[index][1] = elevation;
     satellites[index][2] = azimuth;
     satellites[index][3] = snr;
 
+    changed[index] = true;
+    if (!refreshTimer->isActive()) {
+        refreshTimer->start();
+    }
+}
+
+/**
+  Draws the satellites that changed since the last refresh
+  */
+void GpsConstellationWidget::refresh()
+{
+    for (int index = 0; index < MAX_SATELLITES; index++) {
+        if (changed[index]) {
+            changed[index] = false;
+            drawSat(index);
+        }
+    }
+}
+
+void GpsConstellationWidget::drawSat(int index)
+{
+    const int prn = satellites[index][0];
+    const int elevation = satellites[index][1];
+    const int azimuth = satellites[index][2];
+    const int snr = satellites[index][3];
+
     if (prn && elevation >= 0) {
         QPointF opd = polarToCoord(elevation,azimuth);
         opd += QPointF(-satIcons[index]->boundingRect().center().x(),
@@ -28,6 +28,7 @@
 #define GPSCONSTELLATIONWIDGET_H_
 
 #include <QGraphicsView>
+#include <QTimer>
 #include <QtSvg/QSvgRenderer>
 #include <QtSvg/QGraphicsSvgItem>
 
@@ -45,10 +46,15 @@ public slots:
 
 
 private slots:
+   void refresh();
 
 private:
    static const int MAX_SATELLITES = 32;
+   // Changes are drawn at most this often, about the display rate
+   static const int REFRESH_MS = 33;
    int satellites[MAX_SATELLITES][4];
+   bool changed[MAX_SATELLITES];
+   QTimer *refreshTimer;
    QGraphicsScene *scene;
    QSvgRenderer *renderer;
    QGraphicsSvgItem* world;
@@ -56,6 +62,7 @@ private:
    QGraphicsSimpleTextItem* satTexts[MAX_SATELLITES];
 
    QPointF polarToCoord(int elevation, int azimuth);
+   void drawSat(int index);
 
 protected:
     void showEvent(QShowEvent *event);
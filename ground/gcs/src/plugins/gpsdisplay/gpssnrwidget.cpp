@@ -6,12 +6,18 @@ GpsSnrWidget::GpsSnrWidget(QWidget *parent) :
     scene = new QGraphicsScene(this);
     setScene(scene);
 
+    refreshTimer = new QTimer(this);
+    refreshTimer->setSingleShot(true);
+    refreshTimer->setInterval(REFRESH_MS);
+    connect(refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+
     // Now create 'maxSatellites' satellite icons which we will move around on the map:
     for (int i = 0; i < MAX_SATELLITES; i++) {
         satellites[i][0] = 0;
         satellites[i][1] = 0;
         satellites[i][2] = 0;
         satellites[i][3] = 0;
+        changed[i] = false;
 
         boxes[i] = new QGraphicsRectItem();
         boxes[i]->setBrush(QColor("Green"));
@@ -52,18 +58,39 @@ void GpsSnrWidget::resizeEvent(QResizeEvent* event) {
 }
 
 void GpsSnrWidget::updateSat(int index, int prn, int elevation, int azimuth, int snr) {
-    if (index >= MAX_SATELLITES) {
+    if (index < 0 || index >= MAX_SATELLITES) {
         // A bit of error checking never hurts.
         return;
     }
 
+    // Most satellites are the same from one update to the next
+    if (satellites[index][0] == prn && satellites[index][1] == elevation &&
+            satellites[index][2] == azimuth && satellites[index][3] == snr) {
+        return;
+    }
+
     // TODO: add range checking
     satellites[index][0] = prn;
     satellites[index][1] = elevation;
     satellites[index][2] = azimuth;
     satellites[index][3] = snr;
 
-    drawSat(index);
+    changed[index] = true;
+    if (!refreshTimer->isActive()) {
+        refreshTimer->start();
+    }
+}
+
+/**
+  Draws the satellites that changed since the last refresh
+  */
+void GpsSnrWidget::refresh() {
+    for (int index = 0; index < MAX_SATELLITES; index++) {
+        if (changed[index]) {
+            changed[index] = false;
+            drawSat(index);
+        }
+    }
 }
 
 void GpsSnrWidget::drawSat(int index) {
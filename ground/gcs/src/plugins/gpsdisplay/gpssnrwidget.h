@@ -3,6 +3,7 @@
 
 #include <QGraphicsView>
 #include <QGraphicsRectItem>
+#include <QTimer>
 
 class GpsSnrWidget : public QGraphicsView {
     Q_OBJECT
@@ -15,9 +16,16 @@ signals:
 public slots:
     void updateSat(int index, int prn, int elevation, int azimuth, int snr);
 
+private slots:
+    void refresh();
+
 private:
     static const int MAX_SATELLITES = 32;
+    // Changes are drawn at most this often, about the display rate
+    static const int REFRESH_MS = 33;
     int satellites[MAX_SATELLITES][4];
+    bool changed[MAX_SATELLITES];
+    QTimer *refreshTimer;
     QGraphicsScene *scene;
     QGraphicsRectItem *boxes[MAX_SATELLITES];
     QGraphicsSimpleTextItem *satTexts[MAX_SATELLITES];
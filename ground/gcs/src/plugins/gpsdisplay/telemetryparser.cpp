@@ -106,9 +106,8 @@ void TelemetryParser::updateTime( UAVObject* object1) {
 /**
   Updates the satellite constellation.
 
-  Not really optimized for now, we should only send updates for the stas
-  which have changed instead of updating everything... That said, Qt is supposed
-  to be able to optimize redraws anyway.
+  Every satellite is sent; the display widgets skip those that have not
+  changed and redraw the rest at most at their refresh rate.
   */
 void TelemetryParser::updateSats( UAVObject* object1) {
     UAVObjectField* prn = object1->getField(QString("PRN"));
@@ -257,6 +257,10 @@ void FGSimulator::processUpdate(const QByteArray& inp)
     int n = fields[FG_COUNTER_RECV].toInt();
     udpCounterFGrecv = n;
 
+    // Older protocol files don't send the simulation time
+    if (fields.length() > FG_SIM_TIME)
+        setSimTime(fields[FG_SIM_TIME].toDouble());
+
     ///////
     // Output formatting
     ///////
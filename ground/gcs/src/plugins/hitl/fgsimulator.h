@@ -81,7 +81,8 @@ private:
         FG_VEL_ACT_DOWN = 21,   /*!< velocity down in feet per second   */
         FG_VEL_ACT_EAST = 22,   /*!< velocity east in feet per second   */
         FG_VEL_ACT_NORTH= 23,   /*!< velocity north in feet per second  */
-        FG_COUNTER_RECV = 24    /*!< udp packet counter                 */
+        FG_COUNTER_RECV = 24,   /*!< udp packet counter                 */
+        FG_SIM_TIME     = 25    /*!< elapsed simulation time in seconds */
     };
 };
 
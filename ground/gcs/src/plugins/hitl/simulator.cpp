@@ -58,13 +58,14 @@ Simulator::Simulator(const SimulatorSettings& params) :
         connect(this, SIGNAL(myStart()), this, SLOT(onStart()),Qt::QueuedConnection);
 	emit myStart();
 
-    QTime currentTime=QTime::currentTime();
-    gpsPosTime = currentTime;
-    groundTruthTime = currentTime;
-    gcsRcvrTime = currentTime;
-    attRawTime = currentTime;
-    baroAltTime = currentTime;
-    airspeedActualTime=currentTime;
+    simTime = 0;
+    hasSimTime = false;
+    gpsPosTime = 0;
+    groundTruthTime = 0;
+    gcsRcvrTime = 0;
+    attRawTime = 0;
+    baroAltTime = 0;
+    airspeedActualTime = 0;
 
     //Define standard atmospheric constants
     airParameters.univGasConstant =UNIVERSAL_GAS_CONSTANT;         //[J/(mol·K)]
@@ -217,6 +218,7 @@ void Simulator::receiveUpdate()
 	}
 
 	// Process data
+	bool stepped = false;
         while(inSocket->hasPendingDatagrams()) {
 		// Receive datagram
 		QByteArray datagram;
@@ -228,7 +230,15 @@ void Simulator::receiveUpdate()
 
         // Process incomming data
 		processUpdate(datagram);
+		stepped = true;
 	 }
+
+	// Answer every simulator step with the controls it produced, in
+	// lockstep with the simulator instead of on the transmit timer
+	if (stepped) {
+		txTimer->stop();
+		transmitUpdate();
+	}
 }
 
 void Simulator::setupUAVObjects()
@@ -388,6 +398,39 @@ void Simulator::onSimulatorConnectionTimeout()
 		simConnectionStatus = false;
 		emit simulatorDisconnected();
 	}
+	// Nothing to step on anymore, fall back to the timer
+	txTimer->start();
+}
+
+/**
+ * @brief Simulator::setSimTime Set the simulation clock from the last packet
+ * of the simulator. Runs then don't depend on the GCS timing, and follow
+ * the simulator when it runs faster or slower than real time.
+ * @param seconds Elapsed simulation time
+ */
+void Simulator::setSimTime(double seconds)
+{
+    simTime = (qint64) (seconds * 1000);
+    hasSimTime = true;
+}
+
+/**
+ * @brief Simulator::isDue Rate limit an output on the simulation clock
+ * @param lastTime Simulation time the output was last due, advanced when due
+ * @param period Output period, in ms
+ */
+bool Simulator::isDue(qint64 &lastTime, quint16 period)
+{
+    // The simulator was reset or restarted
+    if (simTime < lastTime)
+        lastTime = simTime;
+
+    if (simTime - lastTime < period)
+        return false;
+
+    // Keep the rate, without bursting to catch up after a pause
+    lastTime = (simTime - lastTime < 2 * period) ? lastTime + period : simTime;
+    return true;
 }
 
 
@@ -398,7 +441,8 @@ void Simulator::resetInitialHomePosition(){
 
 void Simulator::updateUAVOs(Output2Hardware out){
 
-    QTime currentTime = QTime::currentTime();
+    if (!hasSimTime)
+        simTime = time->elapsed();
 
     Noise noise;
     HitlNoiseGeneration noiseSource;
@@ -623,7 +667,7 @@ void Simulator::updateUAVOs(Output2Hardware out){
 
     /*******************************/
     if (settings.gcsReceiverEnabled) {
-        if (gcsRcvrTime.msecsTo(currentTime) >= settings.minOutputPeriod) {
+        if (isDue(gcsRcvrTime, settings.minOutputPeriod)) {
             GCSReceiver::DataFields gcsRcvrData;
             memset(&gcsRcvrData, 0, sizeof(GCSReceiver::DataFields));
 
@@ -632,17 +676,13 @@ void Simulator::updateUAVOs(Output2Hardware out){
             }
 
             gcsReceiver->setData(gcsRcvrData);
-
-            gcsRcvrTime=gcsRcvrTime.addMSecs(settings.minOutputPeriod);
-
         }
     }
 
 
     /*******************************/
     if (settings.gpsPositionEnabled) {
-        if (gpsPosTime.msecsTo(currentTime) >= settings.gpsPosRate) {
-            qDebug()<< " GPS time:" << gpsPosTime << ", currentTime: " << currentTime  << ", difference: "  << gpsPosTime.msecsTo(currentTime);
+        if (isDue(gpsPosTime, settings.gpsPosRate)) {
             // Update GPS Position objects
             GPSPosition::DataFields gpsPosData;
             memset(&gpsPosData, 0, sizeof(GPSPosition::DataFields));
@@ -667,14 +707,12 @@ void Simulator::updateUAVOs(Output2Hardware out){
             gpsVelData.Down = out.velDown + noise.gpsVelData.Down;
 
             gpsVel->setData(gpsVelData);
-
-            gpsPosTime=gpsPosTime.addMSecs(settings.gpsPosRate);
         }
     }
 
     // Update PositionActual.{North,East,Down} && VelocityActual.{North,East,Down}
     if (settings.groundTruthEnabled) {
-        if (groundTruthTime.msecsTo(currentTime) >= settings.groundTruthRate) {
+        if (isDue(groundTruthTime, settings.groundTruthRate)) {
             VelocityActual::DataFields velocityActualData;
             memset(&velocityActualData, 0, sizeof(VelocityActual::DataFields));
             velocityActualData.North = out.velNorth + noise.velocityActualData.North;
@@ -689,8 +727,6 @@ void Simulator::updateUAVOs(Output2Hardware out){
             positionActualData.East = (out.dstE-initE) + noise.positionActualData.East;
             positionActualData.Down = (out.dstD/*-initD*/) + noise.positionActualData.Down;
             posActual->setData(positionActualData);
-
-            groundTruthTime=groundTruthTime.addMSecs(settings.groundTruthRate);
         }
     }
 
@@ -719,22 +755,20 @@ void Simulator::updateUAVOs(Output2Hardware out){
     /*******************************/
     // Update BaroAltitude object
     if (settings.baroAltitudeEnabled){
-        if (baroAltTime.msecsTo(currentTime) >= settings.baroAltRate) {
+        if (isDue(baroAltTime, settings.baroAltRate)) {
         BaroAltitude::DataFields baroAltData;
         memset(&baroAltData, 0, sizeof(BaroAltitude::DataFields));
         baroAltData.Altitude = out.altitude + noise.baroAltData.Altitude;
         baroAltData.Temperature = out.temperature + noise.baroAltData.Temperature;
         baroAltData.Pressure = out.pressure + noise.baroAltData.Pressure;
         baroAlt->setData(baroAltData);
-
-        baroAltTime=baroAltTime.addMSecs(settings.baroAltRate);
         }
     }
 
     /*******************************/
     // Update AirspeedActual object
     if (settings.airspeedActualEnabled){
-        if (airspeedActualTime.msecsTo(currentTime) >= settings.airspeedActualRate) {
+        if (isDue(airspeedActualTime, settings.airspeedActualRate)) {
         AirspeedActual::DataFields airspeedActualData;
         memset(&airspeedActualData, 0, sizeof(AirspeedActual::DataFields));
         airspeedActualData.CalibratedAirspeed = out.calibratedAirspeed + noise.airspeedActual.CalibratedAirspeed;
@@ -742,15 +776,13 @@ void Simulator::updateUAVOs(Output2Hardware out){
         airspeedActualData.alpha=out.angleOfAttack;
         airspeedActualData.beta=out.angleOfSlip;
         airspeedActual->setData(airspeedActualData);
-
-        airspeedActualTime=airspeedActualTime.addMSecs(settings.airspeedActualRate);
         }
     }
 
     /*******************************/
     // Update raw attitude sensors
     if (settings.attRawEnabled) {
-        if (attRawTime.msecsTo(currentTime) >= settings.attRawRate) {
+        if (isDue(attRawTime, settings.attRawRate)) {
             //Update gyroscope sensor data
             Gyros::DataFields gyroData;
             memset(&gyroData, 0, sizeof(Gyros::DataFields));
@@ -766,8 +798,6 @@ void Simulator::updateUAVOs(Output2Hardware out){
             accelData.y = out.accY + noise.accelData.y;
             accelData.z = out.accZ + noise.accelData.z;
             accels->setData(accelData);
-
-            attRawTime=attRawTime.addMSecs(settings.attRawRate);
         }
     }
 }
@@ -250,6 +250,7 @@ public:
 
     void resetInitialHomePosition();
     void updateUAVOs(Output2Hardware out);
+    void setSimTime(double seconds);
 
     AirParameters getAirParameters();
     void setAirParameters(AirParameters airParameters);
@@ -319,12 +320,17 @@ private:
     QTimer* txTimer;
     QTimer* simTimer;
 
-    QTime attRawTime;
-    QTime gpsPosTime;
-    QTime groundTruthTime;
-    QTime baroAltTime;
-    QTime gcsRcvrTime;
-    QTime airspeedActualTime;
+    // Outputs are rate limited on the simulation clock, in ms, so they
+    // follow the simulator steps rather than the GCS timers
+    qint64 simTime;
+    bool hasSimTime;    // The simulator reports its clock, else wall time is used
+    qint64 attRawTime;
+    qint64 gpsPosTime;
+    qint64 groundTruthTime;
+    qint64 baroAltTime;
+    qint64 gcsRcvrTime;
+    qint64 airspeedActualTime;
+    bool isDue(qint64 &lastTime, quint16 period);
 
     QString name;
     QString simulatorId;
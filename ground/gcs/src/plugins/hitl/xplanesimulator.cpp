@@ -248,6 +248,10 @@ void XplaneSimulator::processUpdate(const QByteArray& dataBuf)
         {
             switch(buf[0]) // switch by id
             {
+            case XplaneSimulator::Times: // Total simulation time, in [s]
+                setSimTime(*((float*)(buf.data()+4*2)));
+                break;
+
             case XplaneSimulator::LatitudeLongitudeAltitude:
                 latitude = *((float*)(buf.data()+4*1));
                 longitude = *((float*)(buf.data()+4*2));
@@ -7,11 +7,13 @@ HEADERS += ipconnectionplugin.h \
     ipconnection_global.h \
     ipconnectionconfiguration.h \
     ipconnectionoptionspage.h \
-    ipdevice.h
+    ipdevice.h \
+    ipsocketbatcher.h
 SOURCES += ipconnectionplugin.cpp \
     ipconnectionconfiguration.cpp \
     ipconnectionoptionspage.cpp \
-    ipdevice.cpp
+    ipdevice.cpp \
+    ipsocketbatcher.cpp
 FORMS += ipconnectionoptionspage.ui
 RESOURCES += 
 DEFINES += IPconnection_LIBRARY
@@ -31,7 +31,8 @@ IPconnectionConfiguration::IPconnectionConfiguration(QString classId, QSettings*
     IUAVGadgetConfiguration(classId, parent),
     m_HostName("127.0.0.1"),
     m_Port(1000),
-    m_UseTCP(1)
+    m_UseTCP(1),
+    m_Batch(0)
 {
     Q_UNUSED(qSettings);
 
@@ -48,6 +49,7 @@ IUAVGadgetConfiguration *IPconnectionConfiguration::clone()
     m->m_Port = m_Port;
     m->m_HostName = m_HostName;
     m->m_UseTCP = m_UseTCP;
+    m->m_Batch = m_Batch;
     return m;
 }
 
@@ -59,6 +61,7 @@ void IPconnectionConfiguration::saveConfig(QSettings* qSettings) const {
    qSettings->setValue("port", m_Port);
    qSettings->setValue("hostName", m_HostName);
    qSettings->setValue("useTCP", m_UseTCP);
+   qSettings->setValue("batch", m_Batch);
 }
 
 void IPconnectionConfiguration::savesettings() const
@@ -70,6 +73,7 @@ void IPconnectionConfiguration::savesettings() const
         settings->setValue(QLatin1String("HostName"), m_HostName);
         settings->setValue(QLatin1String("Port"), m_Port);
         settings->setValue(QLatin1String("UseTCP"), m_UseTCP);
+        settings->setValue(QLatin1String("Batch"), m_Batch);
         settings->endArray();
         settings->endGroup();
 }
@@ -84,6 +88,7 @@ void IPconnectionConfiguration::restoresettings()
         m_HostName = (settings->value(QLatin1String("HostName"), tr("")).toString());
         m_Port = (settings->value(QLatin1String("Port"), tr("")).toInt());
         m_UseTCP = (settings->value(QLatin1String("UseTCP"), tr("")).toInt());
+        m_Batch = (settings->value(QLatin1String("Batch"), 0).toInt());
         settings->endArray();
         settings->endGroup();
 
@@ -39,6 +39,7 @@ Q_OBJECT
 Q_PROPERTY(QString HostName READ HostName WRITE setHostName)
 Q_PROPERTY(int Port READ Port WRITE setPort)
 Q_PROPERTY(int UseTCP READ UseTCP WRITE setUseTCP)
+Q_PROPERTY(int Batch READ Batch WRITE setBatch)
 
 public:
     explicit IPconnectionConfiguration(QString classId, QSettings* qSettings = 0, QObject *parent = 0);
@@ -54,17 +55,20 @@ public:
     QString HostName() const { return m_HostName; }
     int Port() const { return m_Port; }
     int UseTCP() const { return m_UseTCP; }
+    int Batch() const { return m_Batch; }
 
 
 public slots:
     void setHostName(QString HostName) { m_HostName = HostName; }
     void setPort(int Port) { m_Port = Port; }
     void setUseTCP(int UseTCP) { m_UseTCP = UseTCP; }
+    void setBatch(int Batch) { m_Batch = Batch; }
 
 private:
     QString m_HostName;
     int m_Port;
     int m_UseTCP;
+    int m_Batch;
     QSettings* settings;
 
 
@@ -49,6 +49,7 @@ IPConnection * connection = 0;
 IPConnection::IPConnection()
 {
     ipSocket = NULL;
+    ipBatcher = NULL;
     //create all our objects
     m_config = new IPconnectionConfiguration("IP Network Telemetry", NULL, this);
     m_config->restoresettings();
@@ -65,6 +66,7 @@ IPConnection::IPConnection()
 
 IPConnection::~IPConnection()
 {//clean up our resources...
+    delete ipBatcher;
     if (ipSocket) {
         ipSocket->close();
         delete(ipSocket);
@@ -147,11 +149,7 @@ QIODevice *IPConnection::openDevice(Core::IDevice *deviceName)
     Port = m_config->Port();
     UseTCP = m_config->UseTCP();
 
-    if (ipSocket){
-        ipSocket->close();
-        delete ipSocket;
-        ipSocket = NULL;
-    }
+    closeDevice(QString());
 
     openDevice(HostName, Port, UseTCP);
 
@@ -160,12 +158,22 @@ QIODevice *IPConnection::openDevice(Core::IDevice *deviceName)
         msgBox.setText((const QString )errorMsg);
         msgBox.exec();
     }
+    else if (m_config->Batch())
+    {
+        ipBatcher = new IPSocketBatcher(ipSocket, this);
+        return ipBatcher;
+    }
 
     return ipSocket;
 }
 
 void IPConnection::closeDevice(const QString &)
 {
+    if (ipBatcher){
+        ipBatcher->close();
+        delete ipBatcher;
+        ipBatcher = NULL;
+    }
     if (ipSocket){
         ipSocket->close();
         delete ipSocket;
@@ -37,6 +37,7 @@
 #include "ipconnectionconfiguration.h"
 #include "coreplugin/iconnection.h"
 #include "ipdevice.h"
+#include "ipsocketbatcher.h"
 #include <extensionsystem/iplugin.h>
 //#include <QtCore/QSettings>
 
@@ -77,6 +78,7 @@ protected slots:
 private:
     void openDevice(QString HostName, int Port, bool UseTCP);
     QAbstractSocket *ipSocket;
+    IPSocketBatcher *ipBatcher;
     IPconnectionConfiguration *m_config;
     IPconnectionOptionsPage *m_optionspage;
     IPDevice dev;
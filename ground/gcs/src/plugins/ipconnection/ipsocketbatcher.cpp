@@ -0,0 +1,119 @@
+/**
+ ******************************************************************************
+ *
+ * @file       ipsocketbatcher.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup IPConnPlugin IP Telemetry Plugin
+ * @{
+ * @brief Coalesces the telemetry packets written to a socket
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+#include "ipsocketbatcher.h"
+#include <QtNetwork/QAbstractSocket>
+
+// Longest a packet waits for company before it is sent, in ms
+#define FLUSH_DEADLINE 2
+
+IPSocketBatcher::IPSocketBatcher(QAbstractSocket *socket, QObject *parent) :
+    QIODevice(parent),
+    socket(socket)
+{
+    pending.reserve(MAX_DATAGRAM);
+
+    flushTimer.setSingleShot(true);
+    flushTimer.setTimerType(Qt::PreciseTimer);
+    flushTimer.setInterval(FLUSH_DEADLINE);
+    connect(&flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+
+    connect(socket, SIGNAL(readyRead()), this, SIGNAL(readyRead()));
+}
+
+IPSocketBatcher::~IPSocketBatcher()
+{
+}
+
+bool IPSocketBatcher::open(OpenMode mode)
+{
+    // The socket does the buffering already
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void IPSocketBatcher::close()
+{
+    flush();
+    QIODevice::close();
+}
+
+bool IPSocketBatcher::isSequential() const
+{
+    return true;
+}
+
+qint64 IPSocketBatcher::bytesAvailable() const
+{
+    return socket->bytesAvailable() + QIODevice::bytesAvailable();
+}
+
+qint64 IPSocketBatcher::bytesToWrite() const
+{
+    return pending.size() + socket->bytesToWrite();
+}
+
+qint64 IPSocketBatcher::readData(char *data, qint64 maxSize)
+{
+    return socket->read(data, maxSize);
+}
+
+/**
+ * @brief IPSocketBatcher::writeData Queue a write, sending what was queued
+ * before when it wouldn't fit in the same datagram
+ */
+qint64 IPSocketBatcher::writeData(const char *data, qint64 maxSize)
+{
+    if (pending.size() + maxSize > MAX_DATAGRAM)
+        flush();
+
+    pending.append(data, maxSize);
+
+    if (pending.size() >= MAX_DATAGRAM)
+        flush();
+    else if (!flushTimer.isActive())
+        flushTimer.start();
+
+    return maxSize;
+}
+
+void IPSocketBatcher::flush()
+{
+    flushTimer.stop();
+
+    int sent = 0;
+    while (sent < pending.size()) {
+        qint64 len = socket->write(pending.constData() + sent, qMin(pending.size() - sent, MAX_DATAGRAM));
+        if (len <= 0)
+            break;
+        sent += len;
+    }
+
+    pending.clear();
+}
+
+/**
+ * @}
+ * @}
+ */
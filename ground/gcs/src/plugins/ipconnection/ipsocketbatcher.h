@@ -0,0 +1,76 @@
+/**
+ ******************************************************************************
+ *
+ * @file       ipsocketbatcher.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup IPConnPlugin IP Telemetry Plugin
+ * @{
+ * @brief Coalesces the telemetry packets written to a socket
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef IPSOCKETBATCHER_H
+#define IPSOCKETBATCHER_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QTimer>
+
+class QAbstractSocket;
+
+/**
+ * @brief The IPSocketBatcher class Stands in for a connected socket and
+ * holds the writes back for a couple of ms, so the packets sent in a burst
+ * share datagrams (or segments) of up to MAX_DATAGRAM bytes. A packet is
+ * never split unless it is bigger than that on its own. Reads go straight
+ * through.
+ */
+class IPSocketBatcher : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    static const int MAX_DATAGRAM = 1200;
+
+    IPSocketBatcher(QAbstractSocket *socket, QObject *parent = 0);
+    virtual ~IPSocketBatcher();
+
+    virtual bool open(OpenMode mode);
+    virtual void close();
+    virtual bool isSequential() const;
+    virtual qint64 bytesAvailable() const;
+    virtual qint64 bytesToWrite() const;
+
+protected:
+    virtual qint64 readData(char *data, qint64 maxSize);
+    virtual qint64 writeData(const char *data, qint64 maxSize);
+
+private slots:
+    void flush();
+
+private:
+    QAbstractSocket *socket;
+    QByteArray pending;
+    QTimer flushTimer;
+};
+
+#endif // IPSOCKETBATCHER_H
+
+/**
+ * @}
+ * @}
+ */
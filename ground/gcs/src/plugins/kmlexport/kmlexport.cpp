@@ -27,6 +27,7 @@
 #include <QMessageBox>
 #include <QTextStream>
 #include <QtGlobal>
+#include <string.h>
 
 #include <coreplugin/coreconstants.h>
 #include "utils/coordinateconversions.h"
@@ -41,10 +42,21 @@ const double ColorMap_Jet[256][3] = COLORMAP_JET;
 #define maxVelocity 20 // Vehicle velocity which corresponds to maximum color in color map. This shouldn't be hardcoded
 #define numberOfWallAxes 5 // Number of wall axes to plot. This shouldn't be hardcoded
 #define wallAxesSeparation 20 // Wall axes separation height in [m]. This shouldn't be hardcoded
+#define minPointDistance 1 // Track points closer than this to the last one, in [m], are dropped...
+#define minPointInterval 200 // ...as are the ones less than this after it, in [ms]...
+#define maxPointInterval 5000 // ...unless it was this long ago, in [ms]
 
 
 KmlExport::KmlExport(QString inputLogFileName, QString outputKmlFileName) :
-    outputFileName(outputKmlFileName)
+    outputFileName(outputKmlFileName),
+    output(NULL),
+    kmz(NULL),
+    kmzEntry(NULL),
+    writeFailed(false),
+    firstPoint(false),
+    oldPointTime(0),
+    timeStamp(0),
+    lastPlacemarkTime(0)
 {
     logFile.setFileName(inputLogFileName);
 
@@ -75,26 +87,6 @@ KmlExport::KmlExport(QString inputLogFileName, QString outputKmlFileName) :
     // Get the factory singleton to create KML elements.
     factory = KmlFactory::GetFactory();
 
-    // Create <Document>
-    document = factory->CreateDocument();
-
-    // Create folders
-    timestampFolder = factory->CreateFolder();
-    timestampFolder->set_name("Arrows");
-
-    trackFolder = factory->CreateFolder();
-    trackFolder->set_name("Track");
-
-    // Create custom styles. Add as document's first elements
-    StyleMapPtr styleCBS = createCustomBalloonStyle();
-    document->add_styleselector(styleCBS);
-
-    StylePtr styleGT = createGroundTrackStyle();
-    document->add_styleselector(styleGT);
-
-    StyleMapPtr wallAxesStyle = createWallAxesStyle();
-    document->add_styleselector(wallAxesStyle);
-
     // Create an array of lines which will make the wall axes.
     for (int i=0; i<numberOfWallAxes; i++){
         CoordinatesPtr coordinates = factory->CreateCoordinates();
@@ -104,7 +96,9 @@ KmlExport::KmlExport(QString inputLogFileName, QString outputKmlFileName) :
 
 
 /**
- * @brief KmlExport::exportToKML Triggers logfile export to KML.
+ * @brief KmlExport::exportToKML Triggers logfile export to KML. The track
+ * placemarks are written as the log is parsed, the arrows are held in a
+ * temporary file until the track folder is closed.
  */
 bool KmlExport::exportToKML()
 {
@@ -114,21 +108,41 @@ bool KmlExport::exportToKML()
         return false;
     }
 
-    // Parses logfile and generates KML document
+    // Ensures the logfile has something to export
     ret = preparseLogFile();
     if (!ret) {
         qDebug () << "Logfile preparsing failed";
         return false;
     }
 
-    // Call parser.
-    parseLogFile();
+    if (!openOutput()) {
+        closeOutput();
+        stopExport();
+        qDebug() << "Write failed. Could not create:" << outputFileName;
+        QMessageBox::critical(new QWidget(),"Write failed", "Failed to write file. Invalid filename");
+        return false;
+    }
+
+    // Open <kml> and <Document>
+    writeOutput(output, "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+                "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n<Document>\n");
 
-    // Add track to <Document>
-    document->add_feature(trackFolder);
+    // Create custom styles. Add as document's first elements
+    writeElement(output, createCustomBalloonStyle());
+    writeElement(output, createGroundTrackStyle());
+    writeElement(output, createWallAxesStyle());
+
+    // Call parser. The track is written as it goes.
+    writeOutput(output, "<Folder>\n<name>Track</name>\n");
+    parseLogFile();
+    writeOutput(output, "</Folder>\n");
 
     // Add timespans to <Document>
-    document->add_feature(timestampFolder);
+    writeOutput(output, "<Folder>\n<name>Arrows</name>\n");
+    arrowsFile.seek(0);
+    while (!arrowsFile.atEnd())
+        writeOutput(output, arrowsFile.read(64 * 1024));
+    writeOutput(output, "</Folder>\n");
 
     // Add ground track to <Document>
     {
@@ -145,7 +159,7 @@ bool KmlExport::exportToKML()
         placemark->set_styleurl("#ts_2_tb");
         placemark->set_name("Ground track");
 
-        document->add_feature(placemark);
+        writeElement(output, placemark);
     }
 
     // Add wall axes to <Document>
@@ -166,39 +180,109 @@ bool KmlExport::exportToKML()
         folder->add_feature(placemark);
         folder->set_name("Wall axes");
     }
-    document->add_feature(folder);
+    writeElement(output, folder);
 
-    // Create <kml> and give it <Document>.
-    KmlPtr kml = factory->CreateKml();
-    kml->set_feature(document);  // kml takes ownership.
+    writeOutput(output, "</Document>\n</kml>\n");
 
-    // Serialize to XML
-    std::string kml_data = kmldom::SerializePretty(kml);
+    if (!closeOutput()) {
+        qDebug() << "Write failed: " << outputFileName;
+        QMessageBox::critical(new QWidget(),"Write failed", "Failed to write file.");
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief KmlExport::openOutput Creates the output file. A KMZ is written
+ * through a single compressed doc.kml entry, in the same pass.
+ * @return returns true if the output and temporary files could be created
+ */
+bool KmlExport::openOutput()
+{
+    writeFailed = false;
+
+    if (!arrowsFile.open())
+        return false;
 
-    // Save to file
-    if (QFileInfo(outputFileName).suffix().toLower() == "kmz") {
-        if (!kmlengine::KmzFile::WriteKmz(outputFileName.toStdString().c_str(), kml_data)) {
-            qDebug() << "KMZ write failed: " << outputFileName;
-            QMessageBox::critical(new QWidget(),"KMZ write failed", "Failed to write KMZ file.");
+    QString suffix = QFileInfo(outputFileName).suffix().toLower();
+    if (suffix == "kmz") {
+        kmz = new QuaZip(outputFileName);
+        if (!kmz->open(QuaZip::mdCreate))
             return false;
-        }
-    } else if (QFileInfo(outputFileName).suffix().toLower() == "kml") {
-        if (!kmlbase::File::WriteStringToFile(kml_data, outputFileName.toStdString())) {
-            qDebug() << "KML write failed: " << outputFileName;
-            QMessageBox::critical(new QWidget(),"KML write failed", "Failed to write KML file.");
+
+        kmzEntry = new QuaZipFile(kmz);
+        if (!kmzEntry->open(QIODevice::WriteOnly, QuaZipNewInfo("doc.kml")))
             return false;
-        }
+
+        output = kmzEntry;
+    } else if (suffix == "kml") {
+        kmlFile.setFileName(outputFileName);
+        if (!kmlFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            return false;
+
+        output = &kmlFile;
     } else {
-        qDebug() << "Write failed. Invalid file name:" << outputFileName;
-        QMessageBox::critical(new QWidget(),"Write failed", "Failed to write file. Invalid filename");
         return false;
     }
 
-
     return true;
 }
 
 
+/**
+ * @brief KmlExport::closeOutput Finishes the output file
+ * @return returns true if everything was written
+ */
+bool KmlExport::closeOutput()
+{
+    bool success = (output != NULL) && !writeFailed;
+
+    if (kmzEntry) {
+        kmzEntry->close();
+        success = success && (kmzEntry->getZipError() == UNZ_OK);
+        delete kmzEntry;
+        kmzEntry = NULL;
+    }
+
+    if (kmz) {
+        kmz->close();
+        success = success && (kmz->getZipError() == UNZ_OK);
+        delete kmz;
+        kmz = NULL;
+    }
+
+    if (kmlFile.isOpen()) {
+        kmlFile.close();
+        success = success && (kmlFile.error() == QFile::NoError);
+    }
+
+    arrowsFile.close();
+    output = NULL;
+
+    return success;
+}
+
+
+void KmlExport::writeOutput(QIODevice *device, const QByteArray &data)
+{
+    if (device->write(data) != data.size())
+        writeFailed = true;
+}
+
+
+/**
+ * @brief KmlExport::writeElement Serializes one element of the document
+ * on its own, so it can be freed once written
+ */
+void KmlExport::writeElement(QIODevice *device, const ElementPtr &element)
+{
+    std::string xml = kmldom::SerializePretty(element);
+    writeOutput(device, QByteArray(xml.data(), xml.size()));
+}
+
+
 /**
  * @brief KmlExport::open Opens the logfile and ensures it's sane
  * @return returns true if the logfile is successfully opened, returns false otherwise.
@@ -263,17 +347,17 @@ bool KmlExport::open()
  */
 bool KmlExport::preparseLogFile()
 {
-    //Read all log timestamps into array
-    timestampBuffer.clear(); //Save beginning of log for later use
-    timestampPos.clear();
-    quint64 logFileStartIdx = logFile.pos();
+    //Walk the log timestamps, without keeping them
+    quint64 logFileStartIdx = logFile.pos(); //Save beginning of log for later use
     quint32 lastTimeStamp = 0;
+    quint32 previousTimeStamp = 0;
+    quint32 numRecords = 0;
 
     while (!logFile.atEnd()){
         qint64 dataSize;
 
         //Get time stamp position
-        timestampPos.append(logFile.pos());
+        qint64 recordPos = logFile.pos();
 
         //Read timestamp and logfile packet size
         logFile.read((char *) &lastTimeStamp, sizeof(lastTimeStamp));
@@ -283,28 +367,28 @@ bool KmlExport::preparseLogFile()
         //TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN THE STRING OF SIX 0x00
         if ((dataSize & 0xFFFFFFFFFFFF0000)!=0){
             qDebug() << "Wrong sync byte. At file location 0x"  << QString("%1").arg(logFile.pos(),0,16) << "Got 0x" << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000,0,16) << ", but expected 0x""00"".";
-            logFile.seek(timestampPos.last()+1);
-            timestampPos.pop_back();
+            logFile.seek(recordPos+1);
             continue;
         }
 
         //Check if timestamps are sequential.
-        if (!timestampBuffer.isEmpty() && lastTimeStamp < timestampBuffer.last()){
+        if (numRecords > 0 && lastTimeStamp < previousTimeStamp){
             QMessageBox msgBox;
             msgBox.setText("Corrupted file.");
             msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected behavior"); //<--TODO: add hyperlink to webpage with better description.
             msgBox.exec();
 
-            qDebug() << "Timestamp: " << timestampBuffer.last() << " " << lastTimeStamp;
+            qDebug() << "Timestamp: " << previousTimeStamp << " " << lastTimeStamp;
         }
 
-        timestampBuffer.append(lastTimeStamp);
+        previousTimeStamp = lastTimeStamp;
+        numRecords++;
 
-        logFile.seek(timestampPos.last()+sizeof(lastTimeStamp)+sizeof(dataSize)+dataSize);
+        logFile.seek(recordPos+sizeof(lastTimeStamp)+sizeof(dataSize)+dataSize);
     }
 
     //Check if any timestamps were successfully read
-    if (timestampBuffer.size() == 0){
+    if (numRecords == 0){
         QMessageBox msgBox;
         msgBox.setText("Empty logfile.");
         msgBox.setInformativeText("No log data can be found.");
@@ -369,9 +453,7 @@ void KmlExport::parseLogFile()
 
         // Parse the packet. This operation passes the data to the kmlTalk object, which internally parses the data
         // and then emits objectUpdated(UAVObject *) signals. These signals are connected to in the KmlExport constructor.
-        for (int i=0; i < dataBuffer.size(); i++) {
-            kmlTalk->processInputByte(dataBuffer[i]);
-        }
+        kmlTalk->processInputBuffer((const quint8 *)dataBuffer.constData(), dataBuffer.size());
 
         timeStampIdx++;
     }
@@ -789,10 +871,20 @@ void KmlExport::positionActualUpdated(UAVObject *obj)
     VelocityActual::DataFields velocityActualData = velocityActual->getData();
 
     LLAVCoordinates newPoint;
+    double NED[3]={positionActualData.North, positionActualData.East, positionActualData.Down};
+
+    // Decimate. Points that barely moved only add placemarks.
+    if (firstPoint) {
+        quint32 elapsed = timeStamp - oldPointTime;
+        double distance = sqrt((NED[0]-oldNED[0])*(NED[0]-oldNED[0]) + (NED[1]-oldNED[1])*(NED[1]-oldNED[1]) + (NED[2]-oldNED[2])*(NED[2]-oldNED[2]));
+        if (elapsed < maxPointInterval && (elapsed < minPointInterval || distance < minPointDistance))
+            return;
+    }
+    memcpy(oldNED, NED, sizeof(oldNED));
+    oldPointTime = timeStamp;
 
     // Convert NED data to LLA data
     double homeLLA[3]={homeLocationData.Latitude/1e7, homeLocationData.Longitude/1e7, homeLocationData.Altitude};
-    double NED[3]={positionActualData.North, positionActualData.East, positionActualData.Down};
     double LLA[3];
     Utils::CoordinateConversions().NED2LLA_HomeLLA(homeLLA, NED, LLA);
 
@@ -808,8 +900,6 @@ void KmlExport::positionActualUpdated(UAVObject *obj)
                              .arg(newPoint.longitude).arg(newPoint.altitude).arg(airspeedActualData.CalibratedAirspeed).arg(newPoint.groundspeed));
 
     // In case this is the first time through, copy data and exit
-    static bool firstPoint;
-
     if (firstPoint == false) {
         oldPoint.latitude = newPoint.latitude;
         oldPoint.longitude = newPoint.longitude;
@@ -825,15 +915,15 @@ void KmlExport::positionActualUpdated(UAVObject *obj)
         wallAxes[i]->add_latlngalt(newPoint.latitude, newPoint.longitude, i*wallAxesSeparation + homeLocationData.Altitude);
     }
 
-    // Create colored tracks and add to the KML document
+    // Create colored tracks and write them to the KML document
     PlacemarkPtr newPlacemark = CreateLineStringPlacemark(oldPoint, newPoint, timeStamp);
-    trackFolder->add_feature(newPlacemark);
+    writeElement(output, newPlacemark);
 
     // Every 2 seconds generate a time stamp
     if (timeStamp - lastPlacemarkTime > 2000) {
 
         PlacemarkPtr newPlacemarkTimestamp = createTimespanPlacemark(newPoint, lastPlacemarkTime, timeStamp);
-        timestampFolder->add_feature(newPlacemarkTimestamp);
+        writeElement(&arrowsFile, newPlacemarkTimestamp);
         lastPlacemarkTime = timeStamp;
     }
 
@@ -32,6 +32,7 @@
 #include <QTimer>
 #include <QDebug>
 #include <QBuffer>
+#include <QTemporaryFile>
 #include <math.h>
 
 #include "kml/base/file.h"
@@ -39,6 +40,8 @@
 #include "kml/engine.h"
 
 #include "./uavtalk/uavtalk.h"
+#include "quazip.h"
+#include "quazipfile.h"
 
 #include "airspeedactual.h"
 #include "attitudeactual.h"
@@ -61,7 +64,9 @@ struct LLAVCoordinates
 
 /**
  * @class KmlExport generates a KML file showing the flight path from a UAVTalk
- * log path that is viewable in Google Earth.
+ * log path that is viewable in Google Earth. The document is written out as
+ * the log is parsed, directly into the archive for KMZ, so memory use doesn't
+ * grow with the length of the log.
  */
 class KmlExport : public QObject
 {
@@ -91,9 +96,6 @@ protected:
     QFile logFile;
 
 private:
-    QList<quint32> timestampBuffer;
-    QList<quint32> timestampPos;
-
     UAVTalk *kmlTalk;
 
     AirspeedActual *airspeedActual;
@@ -106,13 +108,20 @@ private:
     GPSPosition::DataFields gpsPositionData;
     HomeLocation::DataFields homeLocationData;
 
-    DocumentPtr document;
-    FolderPtr trackFolder;
-    FolderPtr timestampFolder;
     KmlFactory *factory;
 
     QString outputFileName;
+    QIODevice *output;
+    QFile kmlFile;
+    QuaZip *kmz;
+    QuaZipFile *kmzEntry;
+    QTemporaryFile arrowsFile; // The arrows folder, until the track is written
+    bool writeFailed;
+
+    bool firstPoint;
     LLAVCoordinates oldPoint;
+    double oldNED[3];
+    quint32 oldPointTime;
     quint32 timeStamp;
     quint32 lastPlacemarkTime;
     QString informationString;
@@ -120,6 +129,10 @@ private:
     static QString dateTimeFormat;
 
     void parseLogFile();
+    bool openOutput();
+    bool closeOutput();
+    void writeOutput(QIODevice *device, const QByteArray &data);
+    void writeElement(QIODevice *device, const ElementPtr &element);
     StylePtr createGroundTrackStyle();
     StyleMapPtr createWallAxesStyle();
     StyleMapPtr createCustomBalloonStyle();
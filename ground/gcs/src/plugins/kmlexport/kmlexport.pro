@@ -3,6 +3,7 @@ TARGET = KMLExport
 QT += svg
 include(../../gcsplugin.pri)
 include(kmlexport_dependencies.pri)
+include(../../libs/quazip/quazip.pri)
 HEADERS += kmlexportplugin.h \
     kmlexport.h
 
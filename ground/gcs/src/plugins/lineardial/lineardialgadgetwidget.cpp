@@ -126,15 +126,15 @@ void LineardialGadgetWidget::updateIndex(UAVObject *object1) {
             if (fieldSymbol) {
                 // If we defined a symbol, we will look for a matching
                 // SVG element to display:
-                if (m_renderer->elementExists("symbol-" + s)) {
-                    fieldSymbol->setElementId("symbol-" + s);
-                } else {
-                    fieldSymbol->setElementId("symbol");
-                }
+                QString symbol = m_renderer->elementExists("symbol-" + s) ?
+                            "symbol-" + s : QString("symbol");
+                // Changing the element throws away its cached pixmap
+                if (fieldSymbol->elementId() != symbol)
+                    fieldSymbol->setElementId(symbol);
             }
         }
 
-        if (fieldValue)
+        if (fieldValue && fieldValue->toPlainText() != s)
             fieldValue->setPlainText(s);
 
         if (index && !dialTimer.isActive())
@@ -330,6 +330,18 @@ void LineardialGadgetWidget::setDialFile(QString dfn)
 
          l_scene->setSceneRect(background->boundingRect());
 
+         // Only the index and the text change with the value, so the SVG
+         // layers are drawn from pixmaps rendered for the current view
+         // transform.  The index only ever moves, which reuses its pixmap.
+         QList<QGraphicsItem *> layers;
+         layers << background << red << yellow << green << index << fieldSymbol;
+         if (fgenabled)
+             layers << foreground;
+         foreach (QGraphicsItem *item, layers) {
+             if (item)
+                 item->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+         }
+
          // Reset the current index value:
          indexValue = 0;
          if (!dialTimer.isActive() && index)
@@ -428,6 +440,4 @@ void LineardialGadgetWidget::moveIndex()
         matrix.translate(trans+startX,startY);
     }
     index->setTransform(matrix,false);
-    
-    update();
 }
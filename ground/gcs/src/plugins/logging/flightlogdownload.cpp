@@ -36,13 +36,30 @@
 #include "loggingstats.h"
 
 #include <QDateTime>
+#include <QTime>
 #include <QFile>
 #include <QFileDialog>
 #include <QDebug>
 
+// Sectors received before an acknowledgement goes out, below the window
+// the flight side keeps in flight
+static const quint32 ACK_SECTORS = 4;
+static const int ACK_PERIOD_MS = 20;
+// Acknowledge again when nothing arrives, in case it was lost
+static const int ACK_REPEAT_MS = 200;
+// Sectors this far past the next one needed are stale repeats
+static const quint16 MAX_SECTORS_AHEAD = 1024;
+// Item data role holding the duration of a file, in ms
+static const int DURATION_ROLE = Qt::UserRole + 1;
+
 FlightLogDownload::FlightLogDownload(QWidget *parent) :
     QDialog(parent),
-    ui(new Ui::FlightLogDownload)
+    ui(new Ui::FlightLogDownload),
+    nextSector(0),
+    lastSector(-1),
+    ackedSector(0),
+    indexFile(-1),
+    maxIndexFile(-1)
 {
     ui->setupUi(this);
 
@@ -53,8 +70,17 @@ FlightLogDownload::FlightLogDownload(QWidget *parent) :
     loggingStats = LoggingStats::GetInstance(uavoManager);
     Q_ASSERT(loggingStats);
 
+    // Instances of the sectors are created as they are first received
+    foreach (UAVObject *obj, uavoManager->getObjectInstancesVector(LoggingSector::OBJID))
+        newInstance(obj);
+    connect(uavoManager, SIGNAL(newInstance(UAVObject*)), this, SLOT(newInstance(UAVObject*)));
+
+    ackTimer.setInterval(ACK_PERIOD_MS);
+    connect(&ackTimer, SIGNAL(timeout()), this, SLOT(sendAck()));
+
     connect(ui->fileNameButton, SIGNAL(clicked()), this, SLOT(getFilename()));
     connect(ui->saveButton, SIGNAL(clicked()), this, SLOT(startDownload()));
+    connect(ui->cbFileId, SIGNAL(currentIndexChanged(int)), this, SLOT(fileSelected(int)));
 
     // Create default file name
 	QString fileName = tr("dRonin-%0.drlog").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss"));
@@ -80,10 +106,38 @@ void FlightLogDownload::getFilename()
         ui->fileName->setText(fileName);
 }
 
+/**
+ * @brief FlightLogDownload::requestInfo ask the flight side for the
+ * start, duration and length of the file being indexed
+ */
+void FlightLogDownload::requestInfo()
+{
+    LoggingStats::DataFields logging = loggingStats->getData();
+    logging.Operation = LoggingStats::OPERATION_INFO;
+    logging.FileRequest = indexFile;
+    loggingStats->setData(logging);
+    loggingStats->updated();
+}
+
+//! Limit the range to the duration of the selected file, once known
+void FlightLogDownload::fileSelected(int index)
+{
+    bool ok;
+    quint32 duration = ui->cbFileId->itemData(index, DURATION_ROLE).toUInt(&ok);
+    int maximum = ok ? qMin(duration / 1000 + 1, 65535u) : 65535;
+    ui->rangeStart->setMaximum(maximum);
+    ui->rangeEnd->setMaximum(maximum);
+}
+
+void FlightLogDownload::newInstance(UAVObject *obj)
+{
+    if (obj->getObjID() == LoggingSector::OBJID)
+        connect(obj, SIGNAL(objectUnpacked(UAVObject*)), this, SLOT(sectorReceived(UAVObject*)), Qt::UniqueConnection);
+}
+
 /**
  * @brief FlightLogDownload::updateReceived respond to updates
- * from the LoggingStats object and store the data during a
- * download
+ * from the LoggingStats object, which end a download
  */
 void FlightLogDownload::updateReceived()
 {
@@ -91,10 +145,50 @@ void FlightLogDownload::updateReceived()
 
     switch(dl_state) {
     case DL_IDLE:
-        // Update the file selector
+        // Update the file selector when the files changed, then ask
+        // for a description of each
+        if (ui->cbFileId->count() == logging.MaxFileId - logging.MinFileId + 1 &&
+                ui->cbFileId->itemData(0).toInt() == logging.MinFileId)
+            return;
         ui->cbFileId->clear();
         for (int i = logging.MinFileId; i <= logging.MaxFileId; i++)
             ui->cbFileId->addItem(QString::number(i), QVariant(i));
+        if (logging.MaxFileId >= logging.MinFileId && logging.Operation != LoggingStats::OPERATION_LOGGING) {
+            UAVObject::Metadata mdata = loggingStats->getMetadata();
+            UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_ONCHANGE);
+            loggingStats->setMetadata(mdata);
+
+            dl_state = DL_INDEXING;
+            indexFile = logging.MinFileId;
+            maxIndexFile = logging.MaxFileId;
+            requestInfo();
+        }
+        return;
+    case DL_INDEXING:
+        if (logging.FileRequest != indexFile)
+            return;
+        if (logging.Operation == LoggingStats::OPERATION_IDLE) {
+            int index = ui->cbFileId->findData(QVariant(indexFile));
+            if (index >= 0) {
+                QString duration = QTime(0, 0).addMSecs(logging.FileDuration).toString("hh:mm:ss");
+                ui->cbFileId->setItemText(index, tr("%0: %1, %2 kB").arg(indexFile).arg(duration)
+                                          .arg(logging.FileLength / 1024));
+                ui->cbFileId->setItemData(index, QVariant(logging.FileDuration), DURATION_ROLE);
+                if (index == ui->cbFileId->currentIndex())
+                    fileSelected(index);
+            }
+        } else if (logging.Operation != LoggingStats::OPERATION_ERROR) {
+            return;
+        }
+
+        if (++indexFile <= maxIndexFile) {
+            requestInfo();
+        } else {
+            UAVObject::Metadata mdata = loggingStats->getMetadata();
+            UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_MANUAL);
+            loggingStats->setMetadata(mdata);
+            dl_state = DL_IDLE;
+        }
         return;
     case DL_COMPLETE:
         return;
@@ -102,48 +196,99 @@ void FlightLogDownload::updateReceived()
         break;
     }
 
-    UAVObject::Metadata mdata;
-
     switch (logging.Operation) {
-    case LoggingStats::OPERATION_IDLE:
-        log.append((char *) logging.FileSector, LoggingStats::FILESECTOR_NUMELEM);
-        logging.Operation = LoggingStats::OPERATION_DOWNLOAD;
-        logging.FileSectorNum++;
-        loggingStats->setData(logging);
-        loggingStats->updated();
-        ui->sectorLabel->setText(QString::number(logging.FileSectorNum));
-        qDebug() << "Requesting sector num: " << logging.FileSectorNum;
-
-        ui->lb_operationStatus->setText("Downloading...");
+    case LoggingStats::OPERATION_STREAM:
         break;
     case LoggingStats::OPERATION_COMPLETE:
-    {
-        log.append((char *) logging.FileSector, LoggingStats::FILESECTOR_NUMELEM);
+        finishDownload(lastSector >= 0 && nextSector > lastSector);
+        break;
+    case LoggingStats::OPERATION_ERROR:
+        finishDownload(false);
+        break;
+    default:
+        qDebug() << "Unhandled";
+    }
+}
 
-        dl_state = DL_IDLE;
+/**
+ * @brief FlightLogDownload::sectorReceived store a streamed sector,
+ * appending every sector that is now in order to the log
+ */
+void FlightLogDownload::sectorReceived(UAVObject *obj)
+{
+    if (dl_state != DL_DOWNLOADING)
+        return;
 
-        mdata = loggingStats->getMetadata();
-        UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_MANUAL);
-        loggingStats->setMetadata(mdata);
+    LoggingSector *sectorObj = qobject_cast<LoggingSector *>(obj);
+    if (sectorObj == NULL)
+        return;
+    LoggingSector::DataFields sector = sectorObj->getData();
 
-        logFile->write(log);
-        logFile->close();
+    // Sector numbers wrap at 16 bits, place them after the next one needed
+    quint16 ahead = sector.SectorNum - (quint16) nextSector;
+    if (ahead >= MAX_SECTORS_AHEAD || sector.Length > LoggingSector::DATA_NUMELEM)
+        return;
+    quint32 sectorNum = nextSector + ahead;
 
-        ui->lb_operationStatus->setText("Download complete.");
-        break;
-    }
-    case LoggingStats::OPERATION_ERROR:
-        dl_state = DL_IDLE;
+    if (!sectors.contains(sectorNum))
+        sectors.insert(sectorNum, QByteArray((const char *) sector.Data, sector.Length));
+    if (sector.Length < LoggingSector::DATA_NUMELEM)
+        lastSector = sectorNum;
+
+    while (sectors.contains(nextSector))
+        log.append(sectors.take(nextSector++));
 
-        mdata = loggingStats->getMetadata();
-        UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_MANUAL);
-        loggingStats->setMetadata(mdata);
+    ui->sectorLabel->setText(QString::number(nextSector));
+
+    if (nextSector - ackedSector >= ACK_SECTORS || (lastSector >= 0 && nextSector > lastSector))
+        sendAck();
+}
+
+/**
+ * @brief FlightLogDownload::sendAck tell the flight side which sector
+ * is needed next, when it changed or has not been said for a while
+ */
+void FlightLogDownload::sendAck()
+{
+    if (dl_state != DL_DOWNLOADING)
+        return;
+    if (nextSector == ackedSector && !sinceAck.hasExpired(ACK_REPEAT_MS))
+        return;
+
+    LoggingStats::DataFields logging = loggingStats->getData();
+    logging.Operation = LoggingStats::OPERATION_STREAM;
+    logging.FileSectorNum = nextSector;
+    loggingStats->setData(logging);
+    loggingStats->updated();
+
+    ackedSector = nextSector;
+    sinceAck.restart();
+}
 
+/**
+ * @brief FlightLogDownload::finishDownload write the file out once the
+ * flight side ended the download
+ */
+void FlightLogDownload::finishDownload(bool success)
+{
+    dl_state = DL_IDLE;
+    ackTimer.stop();
+
+    UAVObject::Metadata mdata = loggingStats->getMetadata();
+    UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_MANUAL);
+    loggingStats->setMetadata(mdata);
+
+    if (success) {
+        logFile->write(log);
+        logFile->close();
+        ui->lb_operationStatus->setText("Download complete.");
+    } else {
+        logFile->close();
         ui->lb_operationStatus->setText("Download error.");
-        break;
-    default:
-        qDebug() << "Unhandled";
     }
+
+    log.clear();
+    sectors.clear();
 }
 
 /**
@@ -155,7 +300,7 @@ void FlightLogDownload::startDownload()
 {
     bool ok;
     qint32 file_id = ui->cbFileId->currentData().toInt(&ok);
-    if (!ok)
+    if (!ok || dl_state == DL_DOWNLOADING)
         return;
 
     logFile = new QFile(ui->fileName->text(), this);
@@ -163,6 +308,10 @@ void FlightLogDownload::startDownload()
         return;
 
     log.clear();
+    sectors.clear();
+    nextSector = 0;
+    lastSector = -1;
+    ackedSector = 0;
 
     LoggingStats::DataFields logging = loggingStats->getData();
 
@@ -178,11 +327,17 @@ void FlightLogDownload::startDownload()
 
     qDebug() << "Download file id: " << file_id;
     dl_state = DL_DOWNLOADING;
-    logging.Operation = LoggingStats::OPERATION_DOWNLOAD;
+    logging.Operation = LoggingStats::OPERATION_STREAM;
     logging.FileRequest = file_id;
+    logging.FileRange[LoggingStats::FILERANGE_START] = ui->rangeStart->value();
+    logging.FileRange[LoggingStats::FILERANGE_END] = ui->rangeEnd->value();
     logging.FileSectorNum = 0;
     loggingStats->setData(logging);
     loggingStats->updated();
+
+    sinceAck.start();
+    ackTimer.start();
+    ui->lb_operationStatus->setText("Downloading...");
 }
 
 /**
@@ -31,7 +31,11 @@
 #include <QDialog>
 #include <QByteArray>
 #include <QFile>
+#include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
 #include "loggingstats.h"
+#include "loggingsector.h"
 
 namespace Ui {
 class FlightLogDownload;
@@ -47,15 +51,34 @@ public:
 
 private slots:
     void updateReceived();
+    void sectorReceived(UAVObject *obj);
+    void newInstance(UAVObject *obj);
+    void sendAck();
     void startDownload();
     void getFilename();
+    void fileSelected(int index);
 
 private:
     LoggingStats *loggingStats;
     QByteArray log;
     QFile *logFile;
 
-    enum LOG_DL_STATE {DL_IDLE, DL_DOWNLOADING, DL_COMPLETE} dl_state;
+    //! Sectors received ahead of the next one needed
+    QHash<quint32, QByteArray> sectors;
+    quint32 nextSector;
+    qint64 lastSector;          // The short sector ending the file, or -1
+    quint32 ackedSector;        // Last acknowledgement sent
+    QTimer ackTimer;
+    QElapsedTimer sinceAck;
+
+    //! File described by the flight side next, while indexing
+    qint32 indexFile;
+    qint32 maxIndexFile;
+
+    void requestInfo();
+    void finishDownload(bool success);
+
+    enum LOG_DL_STATE {DL_IDLE, DL_INDEXING, DL_DOWNLOADING, DL_COMPLETE} dl_state;
 
     Ui::FlightLogDownload *ui;
 };
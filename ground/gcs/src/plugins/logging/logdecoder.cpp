@@ -0,0 +1,777 @@
+/**
+ ******************************************************************************
+ * @file       logdecoder.cpp
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup LoggingPlugin Logging Plugin
+ * @{
+ * @brief Decodes a whole log into per-object time series
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "logdecoder.h"
+#include "logfile.h"
+#include <uavtalk/uavtalk.h>
+#include <extensionsystem/pluginmanager.h>
+#include <QtEndian>
+#include <QtConcurrentRun>
+#include <QFuture>
+#include <QDebug>
+
+// Log records: timestamp(4), packet size(8), UAVTalk packet
+static const int RECORD_HEADER_LENGTH = sizeof(quint32) + sizeof(qint64);
+
+// UAVTalk framing
+static const quint8 UAVTALK_SYNC = 0x3C;
+static const quint8 UAVTALK_TYPE_OBJ = 0x20;
+static const quint8 UAVTALK_TYPE_OBJ_ACK = 0x22;
+static const quint8 UAVTALK_TIMESTAMPED = 0x80;
+static const int UAVTALK_MIN_HEADER = 8;
+static const int UAVTALK_TIMESTAMP_LENGTH = 2;
+static const int UAVTALK_CHECKSUM_LENGTH = 1;
+
+// Onboard logs are a text header then timestamped UAVTalk packets
+static const char FLIGHT_LOG_HEADER[] = "dRonin git hash:\n";
+static const int FLIGHT_LOG_HEADER_LINES = 3;
+
+// What follows the header may be compressed, see logcompress.h
+static const quint8 FLIGHT_CHUNK_MARKER = 0xC7;
+static const int FLIGHT_CHUNK_HEADER_LENGTH = 5;
+
+// High rate samples of the rate loop, see the flight logging module
+static const quint32 BLACKBOX_OBJID = 0xB1ACB0C5;
+static const quint8 BLACKBOX_VERSION = 1;
+static const int BLACKBOX_FIELDS = 19;
+static const double BLACKBOX_SCALE[BLACKBOX_FIELDS] = {
+    10, 10, 10,
+    10, 10, 10,
+    10000, 10000, 10000,
+    10000, 10000, 10000,
+    10000, 10000, 10000,
+    10000, 10000, 10000, 10000
+};
+
+// Amount of log decoded by one task
+static const qint64 DECODE_CHUNK_LENGTH = 4 * 1024 * 1024;
+
+static inline quint64 seriesKey(quint32 objId, quint16 instId)
+{
+    return ((quint64) objId << 16) | instId;
+}
+
+/**
+ * Read the record header at pos
+ * @returns false if it doesn't describe a record that fits in the log
+ */
+static inline bool readRecordHeader(const uchar *log, qint64 size, qint64 pos,
+                                    quint32 &timeStamp, qint64 &dataSize)
+{
+    if (pos + RECORD_HEADER_LENGTH > size)
+        return false;
+
+    memcpy(&timeStamp, log + pos, sizeof(timeStamp));
+    memcpy(&dataSize, log + pos + sizeof(timeStamp), sizeof(dataSize));
+
+    return (dataSize & 0xFFFFFFFFFFFF0000) == 0 && dataSize >= 1 &&
+            pos + RECORD_HEADER_LENGTH + dataSize <= size;
+}
+
+/**
+ * Read a varint of a blackbox record
+ * @returns false if it runs past end
+ */
+static inline bool readVarint(const uchar *&pos, const uchar *end, quint32 &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35 && pos < end; shift += 7) {
+        uchar byte = *pos++;
+        value |= (quint32) (byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+LogDecoder::LogDecoder(QObject *parent) :
+    QThread(parent),
+    numPackets(0),
+    numErrors(0)
+{
+}
+
+LogDecoder::~LogDecoder()
+{
+    wait();
+}
+
+/**
+ * Start decoding a log in the background. Must be called from the thread
+ * owning the objects, as their layouts are copied here.
+ * @param exportDirName If set, every field is also written to a column
+ * file under this directory once decoded
+ * @returns false if a decode is still running or the file can't be opened
+ */
+bool LogDecoder::decodeFile(const QString &fileName, const QString &exportDirName)
+{
+    if (isRunning())
+        return false;
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objMngr = pm->getObject<UAVObjectManager>();
+    Q_ASSERT(objMngr);
+    if (objMngr == NULL)
+        return false;
+
+    layouts.clear();
+    foreach (const QVector<UAVDataObject*> &instances, objMngr->getDataObjectsVector()) {
+        if (instances.isEmpty())
+            continue;
+        UAVDataObject *obj = instances.first();
+
+        ObjectLayout layout;
+        layout.objId = obj->getObjID();
+        layout.name = obj->getName();
+        layout.isSingleInstance = obj->isSingleInstance();
+        layout.numBytes = obj->getNumBytes();
+        foreach (UAVObjectField *field, obj->getFields()) {
+            FieldLayout fieldLayout;
+            fieldLayout.name = field->getName();
+            fieldLayout.type = field->getType();
+            fieldLayout.offset = field->getDataOffset();
+            fieldLayout.numElements = field->getNumElements();
+            fieldLayout.elementNames = field->getElementNames();
+            layout.fields.append(fieldLayout);
+        }
+        layout.columns = layoutColumns(layout);
+        layouts.insert(layout.objId, layout);
+    }
+
+    if (file.isOpen())
+        file.close();
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Unable to open" << fileName << "for decoding";
+        return false;
+    }
+
+    exportDir = exportDirName;
+    series.clear();
+    numPackets = 0;
+    numErrors = 0;
+    start();
+    return true;
+}
+
+void LogDecoder::run()
+{
+    qint64 size = file.size();
+    QByteArray contents;
+    const uchar *log = file.map(0, size);
+    if (log == NULL) {
+        contents = file.readAll();
+        log = (const uchar *) contents.constData();
+        size = contents.size();
+    }
+
+    // Onboard logs have no records to split on, and their timestamps
+    // only make sense in order, so they are decoded in one go
+    qint64 flightStart = findFlightLogStart(log, size);
+    if (flightStart >= 0) {
+        QByteArray image;
+        if (flightStart < size && log[flightStart] == FLIGHT_CHUNK_MARKER) {
+            expandFlightLog(log, size, flightStart, image);
+            log = (const uchar *) image.constData();
+            size = image.size();
+            flightStart = 0;
+        }
+
+        QHash<quint64, int> seriesIndex;
+        decodeFlightLog(log, size, flightStart, series, seriesIndex, numPackets, numErrors);
+        emit progress(100);
+
+        file.close();
+
+        bool success = exportDir.isEmpty() || exportColumns();
+        emit decodeFinished(success);
+        return;
+    }
+
+    // Compact logs are decoded from their expansion to plain records
+    qint64 start = findLogStart(log, size);
+    QByteArray image;
+    if (LogFile::isCompactLog(log, start)) {
+        LogFile::expandLog(log, size, start, image);
+        log = (const uchar *) image.constData();
+        size = image.size();
+    }
+
+    // Walking the record headers is cheap next to decoding, and gives
+    // chunk boundaries the decode of each chunk will land on exactly
+    QVector<qint64> bounds = splitRecords(log, size, start, DECODE_CHUNK_LENGTH);
+
+    QList<QFuture<DecodedChunk> > chunks;
+    for (int i = 0; i < bounds.size() - 1; i++)
+        chunks << QtConcurrent::run(this, &LogDecoder::decodeChunk, log, size, bounds[i], bounds[i + 1]);
+
+    QHash<quint64, int> seriesIndex;
+    for (int i = 0; i < chunks.size(); i++) {
+        mergeChunk(chunks[i].result(), seriesIndex);
+        chunks[i] = QFuture<DecodedChunk>();
+        emit progress(100 * (i + 1) / chunks.size());
+    }
+
+    file.close();
+
+    bool success = exportDir.isEmpty() || exportColumns();
+    emit decodeFinished(success);
+}
+
+/**
+ * Column names of an object, one per element of its numeric fields
+ */
+QStringList LogDecoder::layoutColumns(const ObjectLayout &layout)
+{
+    QStringList columns;
+    foreach (const FieldLayout &field, layout.fields) {
+        if (field.type == UAVObjectField::STRING)
+            continue;
+        if (field.numElements == 1) {
+            columns << field.name;
+            continue;
+        }
+        for (quint32 i = 0; i < field.numElements; i++) {
+            QString element = (i < (quint32) field.elementNames.size()) ? field.elementNames[i] : QString::number(i);
+            columns << field.name + "." + element;
+        }
+    }
+    return columns;
+}
+
+/**
+ * Skip the text header of a log
+ * @returns The offset of the first record
+ */
+qint64 LogDecoder::findLogStart(const uchar *log, qint64 size)
+{
+    QByteArray header = QByteArray::fromRawData((const char *) log, qMin(size, (qint64) 4096));
+    if (header.startsWith("##\n"))
+        return 3;
+    int separator = header.indexOf("\n##\n");
+    return (separator < 0) ? 0 : separator + 4;
+}
+
+/**
+ * Skip the text header of a log written onboard, which unlike the GCS
+ * ones has no separator
+ * @returns The offset of the first packet, or -1 if it is no onboard log
+ */
+qint64 LogDecoder::findFlightLogStart(const uchar *log, qint64 size)
+{
+    QByteArray header = QByteArray::fromRawData((const char *) log, qMin(size, (qint64) 4096));
+    if (!header.startsWith(FLIGHT_LOG_HEADER) || header.contains("\n##\n"))
+        return -1;
+
+    int pos = 0;
+    for (int i = 0; i < FLIGHT_LOG_HEADER_LINES; i++) {
+        pos = header.indexOf('\n', pos);
+        if (pos < 0)
+            return -1;
+        pos++;
+    }
+    return pos;
+}
+
+/**
+ * Append the plain data of a chunk of a compressed onboard log
+ * @param chunk From the marker to the CRC
+ * @returns false if the chunk is corrupted, out is left as it was then
+ */
+bool LogDecoder::expandFlightChunk(const uchar *chunk, qint64 length, QByteArray &out)
+{
+    int plainLength = qFromLittleEndian<quint16>(&chunk[1]);
+    int payloadLength = length - FLIGHT_CHUNK_HEADER_LENGTH - 1;
+    const uchar *in = chunk + FLIGHT_CHUNK_HEADER_LENGTH;
+    const uchar *end = in + payloadLength;
+
+    if (payloadLength == plainLength) {
+        out.append((const char *) in, plainLength);
+        return true;
+    }
+
+    int start = out.size();
+    out.reserve(start + plainLength);
+
+    while (in < end) {
+        uchar token = *in++;
+
+        // A run of literals
+        if (token < 0x80) {
+            int run = token + 1;
+            if (end - in < run)
+                break;
+            out.append((const char *) in, run);
+            in += run;
+            continue;
+        }
+
+        // A copy of what came before in the chunk
+        if (in == end)
+            break;
+        int offset = (((token & 0x03) << 8) | *in++) + 1;
+        int count = ((token >> 2) & 0x1f) + 3;
+        if (count == 34) {
+            if (in == end)
+                break;
+            count += *in++;
+        }
+        if (offset > out.size() - start)
+            break;
+
+        // Byte by byte, as the copy may overlap what it writes
+        for (int i = 0; i < count; i++)
+            out.append(out.at(out.size() - offset));
+    }
+
+    if (in != end || out.size() - start != plainLength) {
+        out.truncate(start);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Expand a compressed onboard log to the packets it holds. What isn't a
+ * good chunk is copied as is, the packet decode skips over it after.
+ */
+void LogDecoder::expandFlightLog(const uchar *log, qint64 size, qint64 begin, QByteArray &out)
+{
+    qint64 pos = begin;
+    while (pos < size) {
+        if (log[pos] == FLIGHT_CHUNK_MARKER && pos + FLIGHT_CHUNK_HEADER_LENGTH < size) {
+            qint64 length = FLIGHT_CHUNK_HEADER_LENGTH + qFromLittleEndian<quint16>(&log[pos + 3]) + 1;
+            if (pos + length <= size &&
+                    UAVTalk::updateCRC(0, log + pos, length - 1) == log[pos + length - 1] &&
+                    expandFlightChunk(log + pos, length, out)) {
+                pos += length;
+                continue;
+            }
+        }
+
+        out.append((char) log[pos]);
+        pos++;
+    }
+}
+
+/**
+ * Find chunk boundaries of roughly chunkLength that fall on records
+ * @returns The start of every chunk, followed by the end of the log
+ */
+QVector<qint64> LogDecoder::splitRecords(const uchar *log, qint64 size, qint64 begin, qint64 chunkLength)
+{
+    QVector<qint64> bounds;
+    bounds << begin;
+
+    qint64 pos = begin;
+    qint64 nextBound = begin + chunkLength;
+    while (pos + RECORD_HEADER_LENGTH <= size) {
+        if (pos >= nextBound) {
+            bounds << pos;
+            nextBound = pos + chunkLength;
+        }
+
+        quint32 timeStamp;
+        qint64 dataSize;
+        if (!readRecordHeader(log, size, pos, timeStamp, dataSize)) {
+            pos++;
+            continue;
+        }
+        pos += RECORD_HEADER_LENGTH + dataSize;
+    }
+
+    bounds << size;
+    return bounds;
+}
+
+/**
+ * Decode one chunk into series of its own, run on the thread pool
+ */
+LogDecoder::DecodedChunk LogDecoder::decodeChunk(const uchar *log, qint64 size, qint64 begin, qint64 end) const
+{
+    DecodedChunk chunk;
+    chunk.numPackets = 0;
+    chunk.numErrors = 0;
+
+    QHash<quint64, int> chunkIndex;
+    decodeRecords(log, size, begin, end, chunk.series, chunkIndex, chunk.numPackets, chunk.numErrors);
+    return chunk;
+}
+
+/**
+ * Append the series of a chunk to the ones decoded so far
+ */
+void LogDecoder::mergeChunk(const DecodedChunk &chunk, QHash<quint64, int> &seriesIndex)
+{
+    foreach (const LogSeries &part, chunk.series) {
+        quint64 key = seriesKey(part.objId, part.instId);
+        int seriesPos = seriesIndex.value(key, -1);
+        if (seriesPos < 0) {
+            seriesIndex.insert(key, series.size());
+            series.append(part);
+            continue;
+        }
+
+        LogSeries &entry = series[seriesPos];
+        entry.timestamps += part.timestamps;
+        for (int i = 0; i < entry.values.size(); i++)
+            entry.values[i] += part.values[i];
+    }
+
+    numPackets += chunk.numPackets;
+    numErrors += chunk.numErrors;
+}
+
+/**
+ * Decode the records starting in [begin, end), resynchronising over
+ * corrupted record headers the same way replay does
+ * @returns The offset just past the last record decoded
+ */
+qint64 LogDecoder::decodeRecords(const uchar *log, qint64 size, qint64 begin, qint64 end,
+                                 QVector<LogSeries> &out, QHash<quint64, int> &outIndex,
+                                 quint32 &packets, quint32 &errors) const
+{
+    qint64 pos = begin;
+    while (pos < end && pos + RECORD_HEADER_LENGTH <= size) {
+        quint32 timeStamp;
+        qint64 dataSize;
+        if (!readRecordHeader(log, size, pos, timeStamp, dataSize)) {
+            pos++;
+            continue;
+        }
+
+        if (decodePacket(log + pos + RECORD_HEADER_LENGTH, dataSize, timeStamp, out, outIndex))
+            packets++;
+        else
+            errors++;
+
+        pos += RECORD_HEADER_LENGTH + dataSize;
+    }
+    return pos;
+}
+
+/**
+ * Decode the packets of an onboard log, skipping over what doesn't look
+ * like one. The 16 bit timestamps of the packets are unwrapped on the way.
+ */
+void LogDecoder::decodeFlightLog(const uchar *log, qint64 size, qint64 begin,
+                                 QVector<LogSeries> &out, QHash<quint64, int> &outIndex,
+                                 quint32 &packets, quint32 &errors) const
+{
+    quint32 timeBase = 0;
+    quint16 lastTime = 0;
+
+    qint64 pos = begin;
+    while (pos + UAVTALK_MIN_HEADER + UAVTALK_CHECKSUM_LENGTH <= size) {
+        const uchar *packet = log + pos;
+        quint16 packetSize = qFromLittleEndian<quint16>(&packet[2]);
+        if (packet[0] != UAVTALK_SYNC || packetSize < UAVTALK_MIN_HEADER ||
+                pos + packetSize + UAVTALK_CHECKSUM_LENGTH > size ||
+                UAVTalk::updateCRC(0, packet, packetSize) != packet[packetSize]) {
+            pos++;
+            continue;
+        }
+
+        // Where the timestamp is depends on the object having instances
+        quint32 objId = qFromLittleEndian<quint32>(&packet[4]);
+        int timeOffset = -1;
+        if (packet[1] & UAVTALK_TIMESTAMPED) {
+            if (objId == BLACKBOX_OBJID) {
+                timeOffset = UAVTALK_MIN_HEADER;
+            } else {
+                QHash<quint32, ObjectLayout>::const_iterator layoutItr = layouts.constFind(objId);
+                if (layoutItr != layouts.constEnd())
+                    timeOffset = UAVTALK_MIN_HEADER + (layoutItr.value().isSingleInstance ? 0 : 2);
+            }
+        }
+
+        if (timeOffset >= 0 && timeOffset + UAVTALK_TIMESTAMP_LENGTH <= packetSize) {
+            quint16 time = qFromLittleEndian<quint16>(&packet[timeOffset]);
+            if (time < lastTime)
+                timeBase += 0x10000;
+            lastTime = time;
+        }
+
+        bool decoded;
+        if (objId == BLACKBOX_OBJID)
+            decoded = decodeBlackbox(packet, packetSize + UAVTALK_CHECKSUM_LENGTH, timeBase + lastTime, out, outIndex);
+        else
+            decoded = decodePacket(packet, packetSize + UAVTALK_CHECKSUM_LENGTH, timeBase + lastTime, out, outIndex);
+
+        if (decoded)
+            packets++;
+        else
+            errors++;
+
+        pos += packetSize + UAVTALK_CHECKSUM_LENGTH;
+    }
+}
+
+/**
+ * Append the records of a frame of high rate samples to their series. All
+ * but the first record of a frame hold the change since the one before.
+ * @returns false if the frame is corrupted or of an unknown version
+ */
+bool LogDecoder::decodeBlackbox(const uchar *packet, qint64 length, quint32 timeStamp,
+                                QVector<LogSeries> &out, QHash<quint64, int> &outIndex) const
+{
+    // Version, number of records and time of the first one in us
+    const int payloadOffset = UAVTALK_MIN_HEADER + UAVTALK_TIMESTAMP_LENGTH;
+    const int recordsOffset = payloadOffset + 6;
+    if (length < recordsOffset + UAVTALK_CHECKSUM_LENGTH || packet[1] != (UAVTALK_TYPE_OBJ | UAVTALK_TIMESTAMPED) ||
+            packet[payloadOffset] != BLACKBOX_VERSION)
+        return false;
+
+    int numRecords = packet[payloadOffset + 1];
+    quint32 time = qFromLittleEndian<quint32>(&packet[payloadOffset + 2]);
+    quint32 startTime = time;
+
+    quint64 key = seriesKey(BLACKBOX_OBJID, 0);
+    int seriesPos = outIndex.value(key, -1);
+    if (seriesPos < 0) {
+        LogSeries entry;
+        entry.objId = BLACKBOX_OBJID;
+        entry.instId = 0;
+        entry.name = "Blackbox";
+        entry.columns << "Time";
+        foreach (const QString &term, QStringList() << "Gyros" << "RateDesired" << "P" << "I" << "D")
+            entry.columns << term + ".Roll" << term + ".Pitch" << term + ".Yaw";
+        entry.columns << "ActuatorDesired.Roll" << "ActuatorDesired.Pitch"
+                      << "ActuatorDesired.Yaw" << "ActuatorDesired.Thrust";
+        entry.values.resize(entry.columns.size());
+        seriesPos = out.size();
+        out.append(entry);
+        outIndex.insert(key, seriesPos);
+    }
+    LogSeries &entry = out[seriesPos];
+
+    const uchar *pos = packet + recordsOffset;
+    const uchar *end = packet + length - UAVTALK_CHECKSUM_LENGTH;
+    qint32 fields[BLACKBOX_FIELDS] = { 0 };
+    for (int i = 0; i < numRecords; i++) {
+        quint32 dt;
+        if (!readVarint(pos, end, dt))
+            return false;
+        time += dt;
+
+        for (int j = 0; j < BLACKBOX_FIELDS; j++) {
+            quint32 zigzag;
+            if (!readVarint(pos, end, zigzag))
+                return false;
+            fields[j] += (qint32) ((zigzag >> 1) ^ -(qint32) (zigzag & 1));
+        }
+
+        entry.timestamps.append(timeStamp + (time - startTime) / 1000);
+        entry.values[0].append(time);
+        for (int j = 0; j < BLACKBOX_FIELDS; j++)
+            entry.values[j + 1].append(fields[j] / BLACKBOX_SCALE[j]);
+    }
+
+    return true;
+}
+
+/**
+ * Check one UAVTalk packet and append its values if it is an object update
+ * @returns false if the packet is corrupted or of an unknown object
+ */
+bool LogDecoder::decodePacket(const uchar *packet, qint64 length, quint32 timeStamp,
+                              QVector<LogSeries> &out, QHash<quint64, int> &outIndex) const
+{
+    if (length < UAVTALK_MIN_HEADER + UAVTALK_CHECKSUM_LENGTH || packet[0] != UAVTALK_SYNC)
+        return false;
+
+    quint16 packetSize = qFromLittleEndian<quint16>(&packet[2]);
+    quint32 objId = qFromLittleEndian<quint32>(&packet[4]);
+    if (packetSize + UAVTALK_CHECKSUM_LENGTH > length)
+        return false;
+    if (UAVTalk::updateCRC(0, packet, packetSize) != packet[packetSize])
+        return false;
+
+    // Requests, acks and nacks carry no data
+    quint8 type = packet[1] & ~UAVTALK_TIMESTAMPED;
+    if (type != UAVTALK_TYPE_OBJ && type != UAVTALK_TYPE_OBJ_ACK)
+        return true;
+
+    QHash<quint32, ObjectLayout>::const_iterator layoutItr = layouts.constFind(objId);
+    if (layoutItr == layouts.constEnd())
+        return false;
+    const ObjectLayout &layout = layoutItr.value();
+
+    int headerLength = UAVTALK_MIN_HEADER + (layout.isSingleInstance ? 0 : 2) +
+            ((packet[1] & UAVTALK_TIMESTAMPED) ? UAVTALK_TIMESTAMP_LENGTH : 0);
+    if (packetSize != headerLength + (qint64) layout.numBytes)
+        return false;
+    quint16 instId = layout.isSingleInstance ? 0 : qFromLittleEndian<quint16>(&packet[UAVTALK_MIN_HEADER]);
+
+    quint64 key = seriesKey(objId, instId);
+    int seriesPos = outIndex.value(key, -1);
+    if (seriesPos < 0) {
+        LogSeries entry;
+        entry.objId = objId;
+        entry.instId = instId;
+        entry.name = layout.name;
+        entry.columns = layout.columns;
+        entry.values.resize(layout.columns.size());
+        seriesPos = out.size();
+        out.append(entry);
+        outIndex.insert(key, seriesPos);
+    }
+
+    LogSeries &entry = out[seriesPos];
+    entry.timestamps.append(timeStamp);
+
+    const uchar *data = packet + headerLength;
+    int column = 0;
+    foreach (const FieldLayout &field, layout.fields) {
+        // Strings are not sampled
+        if (field.type == UAVObjectField::STRING)
+            continue;
+
+        const uchar *fieldData = data + field.offset;
+        for (quint32 i = 0; i < field.numElements; i++) {
+            double value;
+            switch (field.type) {
+            case UAVObjectField::INT8:
+                value = (qint8) fieldData[i];
+                break;
+            case UAVObjectField::INT16:
+                value = qFromLittleEndian<qint16>(fieldData + 2 * i);
+                break;
+            case UAVObjectField::INT32:
+                value = qFromLittleEndian<qint32>(fieldData + 4 * i);
+                break;
+            case UAVObjectField::UINT8:
+            case UAVObjectField::ENUM:
+                value = fieldData[i];
+                break;
+            case UAVObjectField::UINT16:
+                value = qFromLittleEndian<quint16>(fieldData + 2 * i);
+                break;
+            case UAVObjectField::UINT32:
+                value = qFromLittleEndian<quint32>(fieldData + 4 * i);
+                break;
+            case UAVObjectField::FLOAT32:
+            {
+                quint32 raw = qFromLittleEndian<quint32>(fieldData + 4 * i);
+                float f;
+                memcpy(&f, &raw, sizeof(f));
+                value = f;
+                break;
+            }
+            case UAVObjectField::BITFIELD:
+                value = (fieldData[i / 8] >> (i % 8)) & 1;
+                break;
+            default:
+                value = 0;
+                break;
+            }
+            entry.values[column++].append(value);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Write every series under the export directory, one task per series
+ */
+bool LogDecoder::exportColumns() const
+{
+    QDir dir(exportDir);
+    QList<QFuture<bool> > writes;
+    for (int i = 0; i < series.size(); i++)
+        writes << QtConcurrent::run(&LogDecoder::exportSeries, &series.at(i), dir);
+
+    bool success = true;
+    foreach (QFuture<bool> write, writes)
+        success = write.result() && success;
+    return success;
+}
+
+/**
+ * Write one CSV file per field of a series, as <Object>/<Field>.csv, with
+ * the timestamp and one column per element. Instances other than the
+ * first go to <Object>_<instance>/.
+ */
+bool LogDecoder::exportSeries(const LogSeries *entry, const QDir &dir)
+{
+    QString objectDirName = entry->name;
+    if (entry->instId != 0)
+        objectDirName += QString("_%1").arg(entry->instId);
+    if (!dir.mkpath(objectDirName)) {
+        qDebug() << "Unable to create" << dir.filePath(objectDirName);
+        return false;
+    }
+    QDir objectDir(dir.filePath(objectDirName));
+
+    const QStringList &columns = entry->columns;
+    int first = 0;
+    while (first < columns.size()) {
+        // Columns of one field are consecutive and share its name
+        QString field = columns[first].section('.', 0, 0);
+        int last = first;
+        while (last + 1 < columns.size() && columns[last + 1].section('.', 0, 0) == field)
+            last++;
+
+        QFile out(objectDir.filePath(field + ".csv"));
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qDebug() << "Unable to open" << out.fileName() << "for export";
+            return false;
+        }
+
+        QByteArray text("timestamp");
+        for (int column = first; column <= last; column++)
+            text += ',' + columns[column].toUtf8();
+        text += '\n';
+
+        for (int sample = 0; sample < entry->timestamps.size(); sample++) {
+            text += QByteArray::number(entry->timestamps[sample]);
+            for (int column = first; column <= last; column++) {
+                text += ',';
+                text += QByteArray::number(entry->values[column][sample], 'g', 10);
+            }
+            text += '\n';
+
+            if (text.size() >= 65536) {
+                if (out.write(text) != text.size())
+                    return false;
+                text.clear();
+            }
+        }
+        if (out.write(text) != text.size())
+            return false;
+
+        first = last + 1;
+    }
+
+    return true;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,141 @@
+/**
+ ******************************************************************************
+ * @file       logdecoder.h
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup LoggingPlugin Logging Plugin
+ * @{
+ * @brief Decodes a whole log into per-object time series
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef LOGDECODER_H
+#define LOGDECODER_H
+
+#include <QThread>
+#include <QFile>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+#include <QDir>
+#include "uavobjectmanager.h"
+#include "uavobjectfield.h"
+
+/**
+ * Every column of one object instance over the whole log. Each element
+ * of each numeric field is a column; enums hold their raw value and
+ * bitfields one bit per column. String fields are left out.
+ */
+typedef struct {
+    quint32 objId;
+    quint16 instId;
+    QString name;
+    QStringList columns;
+    QVector<quint32> timestamps;        // ms, one per sample
+    QVector<QVector<double> > values;   // One array per column
+} LogSeries;
+
+/**
+ * Decodes a log as fast as it can be read, with no replay pacing and
+ * without touching the live objects. Logs downloaded from the onboard
+ * flash are read too, with their high rate samples as a Blackbox series. The object layouts are copied from
+ * the object manager up front, the decoding itself runs on the thread.
+ * The log is cut into chunks at record boundaries, which are decoded in
+ * parallel on the global thread pool and merged back in order.
+ */
+class LogDecoder : public QThread
+{
+    Q_OBJECT
+
+public:
+    LogDecoder(QObject *parent = 0);
+    ~LogDecoder();
+
+    bool decodeFile(const QString &fileName, const QString &exportDirName = QString());
+    const QVector<LogSeries> &getSeries() const { return series; }
+    quint32 getNumPackets() const { return numPackets; }
+    quint32 getNumErrors() const { return numErrors; }
+
+signals:
+    void progress(int percent);
+    void decodeFinished(bool success);
+
+protected:
+    void run();
+
+    typedef struct {
+        QString name;
+        UAVObjectField::FieldType type;
+        quint32 offset;
+        quint32 numElements;
+        QStringList elementNames;
+    } FieldLayout;
+
+    typedef struct {
+        quint32 objId;
+        QString name;
+        bool isSingleInstance;
+        quint32 numBytes;
+        QVector<FieldLayout> fields;
+        QStringList columns;
+    } ObjectLayout;
+
+    typedef struct {
+        QVector<LogSeries> series;
+        quint32 numPackets;
+        quint32 numErrors;
+    } DecodedChunk;
+
+    static QStringList layoutColumns(const ObjectLayout &layout);
+    static qint64 findLogStart(const uchar *log, qint64 size);
+    static qint64 findFlightLogStart(const uchar *log, qint64 size);
+    static bool expandFlightChunk(const uchar *chunk, qint64 length, QByteArray &out);
+    static void expandFlightLog(const uchar *log, qint64 size, qint64 begin, QByteArray &out);
+    static QVector<qint64> splitRecords(const uchar *log, qint64 size, qint64 begin, qint64 chunkLength);
+    static bool exportSeries(const LogSeries *entry, const QDir &dir);
+
+    DecodedChunk decodeChunk(const uchar *log, qint64 size, qint64 begin, qint64 end) const;
+    void mergeChunk(const DecodedChunk &chunk, QHash<quint64, int> &seriesIndex);
+    bool exportColumns() const;
+
+    qint64 decodeRecords(const uchar *log, qint64 size, qint64 begin, qint64 end,
+                         QVector<LogSeries> &out, QHash<quint64, int> &outIndex,
+                         quint32 &packets, quint32 &errors) const;
+    bool decodePacket(const uchar *packet, qint64 length, quint32 timeStamp,
+                      QVector<LogSeries> &out, QHash<quint64, int> &outIndex) const;
+    void decodeFlightLog(const uchar *log, qint64 size, qint64 begin,
+                         QVector<LogSeries> &out, QHash<quint64, int> &outIndex,
+                         quint32 &packets, quint32 &errors) const;
+    bool decodeBlackbox(const uchar *packet, qint64 length, quint32 timeStamp,
+                        QVector<LogSeries> &out, QHash<quint64, int> &outIndex) const;
+
+    QHash<quint32, ObjectLayout> layouts;
+    QFile file;
+    QString exportDir;
+    QVector<LogSeries> series;
+    quint32 numPackets;
+    quint32 numErrors;
+};
+
+#endif // LOGDECODER_H
+
+/**
+ * @}
+ * @}
+ */
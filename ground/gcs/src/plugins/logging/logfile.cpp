@@ -29,12 +29,237 @@
 #include <QtGlobal>
 #include <QTextStream>
 #include <QMessageBox>
+#include <QDataStream>
+#include <QtEndian>
+#include <QElapsedTimer>
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 #include <coreplugin/coreconstants.h>
+#include <extensionsystem/pluginmanager.h>
+
+static const char INDEX_MAGIC[] = "DRLOGIDX";
+static const char INDEX_END_MAGIC[] = "DRLOGEND";
+static const int MAGIC_LENGTH = 8;
+static const int INDEX_TRAILER_LENGTH = sizeof(qint64) + MAGIC_LENGTH;
+
+// UAVTalk framing needed to tell which object a record updates
+static const quint8 UAVTALK_SYNC = 0x3C;
+static const quint8 UAVTALK_TYPE_OBJ = 0x20;
+static const quint8 UAVTALK_TYPE_OBJ_ACK = 0x22;
+static const int UAVTALK_MIN_HEADER = 8;
+static const int UAVTALK_MAX_HEADER = 10;
+
+// Compact format
+static const char FORMAT_V2_LINE[] = "format: 2";
+static const char BLOCK_MAGIC[] = "DRB2";
+static const int BLOCK_MAGIC_LENGTH = 4;
+static const int BLOCK_HEADER_LENGTH = BLOCK_MAGIC_LENGTH + 1 + 3 * sizeof(quint32);
+static const quint8 BLOCK_ZLIB = 0x01;
+static const int BLOCK_ZLIB_LEVEL = 6;
+
+static inline void appendVarint(QByteArray &out, quint64 value)
+{
+    while (value >= 0x80) {
+        out.append((char) (value | 0x80));
+        value >>= 7;
+    }
+    out.append((char) value);
+}
+
+static inline bool readVarint(const uchar *&pos, const uchar *end, quint64 &value)
+{
+    value = 0;
+    for (int shift = 0; pos < end && shift < 64; shift += 7) {
+        uchar byte = *pos++;
+        value |= (quint64) (byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+LogWriter::LogWriter(QFile *file, quint32 syncInterval, bool compact, bool compress) :
+    file(file),
+    syncInterval(syncInterval),
+    compact(compact),
+    compress(compress),
+    pendingBase(0),
+    writingBase(0),
+    lastTimeStamp(0),
+    stopping(false),
+    droppedBytes(0),
+    lateBytes(0)
+{
+    // Reserved capacity survives resize(0), so neither buffer reallocates
+    pending.reserve(2 * CHUNK_LENGTH);
+    writing.reserve(2 * CHUNK_LENGTH);
+}
+
+LogWriter::~LogWriter()
+{
+    stop();
+}
+
+/**
+ * Queue one record for writing
+ * @returns false if it was dropped, the writer being too far behind
+ */
+bool LogWriter::writeRecord(quint32 timeStamp, const char *data, qint64 dataSize)
+{
+    QMutexLocker locker(&mutex);
+
+    qint64 length = sizeof(timeStamp) + sizeof(dataSize) + dataSize;
+    if (pending.size() + length > MAX_PENDING_LENGTH) {
+        droppedBytes += length;
+        return false;
+    }
+
+    if (compact) {
+        if (pending.isEmpty())
+            pendingBase = lastTimeStamp = timeStamp;
+        appendVarint(pending, (quint32) (timeStamp - lastTimeStamp));
+        appendVarint(pending, dataSize);
+        lastTimeStamp = timeStamp;
+    } else {
+        pending.append((const char *) &timeStamp, sizeof(timeStamp));
+        pending.append((const char *) &dataSize, sizeof(dataSize));
+    }
+    pending.append(data, dataSize);
+
+    if (pending.size() >= CHUNK_LENGTH)
+        chunkReady.wakeOne();
+    return true;
+}
+
+/**
+ * Write out everything queued and wait for the thread to end
+ */
+void LogWriter::stop()
+{
+    mutex.lock();
+    stopping = true;
+    chunkReady.wakeOne();
+    mutex.unlock();
+
+    wait();
+}
+
+void LogWriter::run()
+{
+    QElapsedTimer sinceSync;
+    sinceSync.start();
+
+    QMutexLocker locker(&mutex);
+    forever {
+        if (!stopping && pending.size() < CHUNK_LENGTH)
+            chunkReady.wait(&mutex, FLUSH_INTERVAL_MS);
+
+        bool finish = stopping;
+        writing.swap(pending);
+        writingBase = pendingBase;
+        locker.unlock();
+
+        if (!writing.isEmpty()) {
+            QElapsedTimer writeTime;
+            writeTime.start();
+
+            QByteArray block;
+            if (compact)
+                block = encodeBlock(writing, writingBase);
+            const QByteArray &out = compact ? block : writing;
+
+            qint64 written = file->write(out);
+            file->flush();
+            if (written != out.size()) {
+                qWarning() << "Unable to write to" << file->fileName() << file->errorString();
+                droppedBytes += writing.size();
+            }
+            if (writeTime.elapsed() > (qint64) FLUSH_INTERVAL_MS)
+                lateBytes += writing.size();
+
+            writing.resize(0);
+        }
+
+        if (finish || (syncInterval > 0 && sinceSync.elapsed() >= syncInterval)) {
+            syncFile();
+            sinceSync.restart();
+        }
+
+        locker.relock();
+        if (finish && pending.isEmpty())
+            break;
+    }
+}
+
+/**
+ * Frame the records of one chunk as a compact block, compressed if
+ * asked to and if that makes it smaller
+ */
+QByteArray LogWriter::encodeBlock(const QByteArray &records, quint32 baseTimeStamp) const
+{
+    QByteArray stored;
+    quint8 flags = 0;
+    if (compress) {
+        stored = qCompress(records, BLOCK_ZLIB_LEVEL);
+        if (stored.size() < records.size())
+            flags |= BLOCK_ZLIB;
+    }
+    const QByteArray &data = (flags & BLOCK_ZLIB) ? stored : records;
+
+    uchar header[BLOCK_HEADER_LENGTH];
+    memcpy(header, BLOCK_MAGIC, BLOCK_MAGIC_LENGTH);
+    header[BLOCK_MAGIC_LENGTH] = flags;
+    qToLittleEndian<quint32>(baseTimeStamp, header + BLOCK_MAGIC_LENGTH + 1);
+    qToLittleEndian<quint32>(records.size(), header + BLOCK_MAGIC_LENGTH + 5);
+    qToLittleEndian<quint32>(data.size(), header + BLOCK_MAGIC_LENGTH + 9);
+
+    QByteArray block;
+    block.reserve(BLOCK_HEADER_LENGTH + data.size());
+    block.append((const char *) header, BLOCK_HEADER_LENGTH);
+    block.append(data);
+    return block;
+}
+
+void LogWriter::syncFile()
+{
+#ifdef Q_OS_WIN
+    _commit(file->handle());
+#else
+    fsync(file->handle());
+#endif
+}
 
 LogFile::LogFile(QObject *parent) :
     QIODevice(parent),
-    timestampBufferIdx(0)
+    lastKeyframeTime(0),
+    replayStateKnown(false),
+    replayEntry(0),
+    lastCheckpointTime(0),
+    ringHead(0),
+    ringCount(0),
+    ringQueued(0),
+    ringTaken(0),
+    lastReadStamp(0),
+    replayClockBase(0),
+    mappedLog(NULL),
+    mappedSize(0),
+    expanded(false),
+    dataStart(0),
+    dataEnd(0),
+    nextRecordPos(0),
+    firstTimestamp(0),
+    objMngr(NULL),
+    writer(NULL),
+    writePos(0),
+    syncInterval(DEFAULT_SYNC_INTERVAL_MS),
+    writeFormat(FORMAT_V1),
+    readCompact(false)
 {
     connect(&timer, SIGNAL(timeout()), this, SLOT(timerFired()));
 }
@@ -56,6 +281,8 @@ bool LogFile::open(OpenMode mode) {
         return true;
     }
 
+    clearIndex();
+
     //Open file as either WriteOnly, or ReadOnly, depending on `mode` parameter
     if(file.open(mode) == false)
     {
@@ -79,7 +306,16 @@ bool LogFile::open(OpenMode mode) {
         QString uavoHash = QString::fromLatin1(Core::Constants::UAVOSHA1_STR).replace("\"{ ", "").replace(" }\"", "").replace(",", "").replace("0x", "");
         QTextStream out(&file);
 
-        out << "dRonin git hash:\n" <<  gitHash << "\n" << uavoHash << "\n##\n";
+        out << "dRonin git hash:\n" <<  gitHash << "\n" << uavoHash << "\n";
+        if (writeFormat != FORMAT_V1)
+            out << FORMAT_V2_LINE << "\n";
+        out << "##\n";
+        out.flush();
+
+        // From here on the file is only written by the writer thread
+        writePos = file.pos();
+        writer = new LogWriter(&file, syncInterval, writeFormat != FORMAT_V1, writeFormat == FORMAT_V2_ZLIB);
+        writer->start();
     }
     else if(mode == QIODevice::ReadOnly)
     {
@@ -102,9 +338,12 @@ bool LogFile::open(OpenMode mode) {
             msgBox.exec();
         }
 
-        QString tmpLine=file.readLine(); //Look for the header/body separation string.
+        QString tmpLine=file.readLine().trimmed(); //Look for the header/body separation string.
         int cnt=0;
-        while (tmpLine!="##\n" && cnt < 10 && !file.atEnd()){
+        readCompact = false;
+        while (tmpLine!="##" && cnt < 10 && !file.atEnd()){
+            if (tmpLine == FORMAT_V2_LINE)
+                readCompact = true;
             tmpLine=file.readLine().trimmed();
             cnt++;
         }
@@ -140,7 +379,25 @@ void LogFile::close()
 
     if (timer.isActive())
         timer.stop();
+    if (file.isOpen() && file.isWritable() && !index.isEmpty())
+        writeIndex();
+    if (writer != NULL) {
+        writer->stop();
+        if (writer->getDroppedBytes() > 0 || writer->getLateBytes() > 0)
+            qWarning() << "Log" << file.fileName() << "dropped" << writer->getDroppedBytes()
+                       << "bytes, wrote" << writer->getLateBytes() << "bytes late";
+        delete writer;
+        writer = NULL;
+    }
+    if (mappedLog != NULL) {
+        if (!expanded)
+            file.unmap(mappedLog);
+        mappedLog = NULL;
+    }
+    expandedLog.clear();
+    expanded = false;
     file.close();
+    clearIndex();
     QIODevice::close();
 }
 
@@ -149,137 +406,203 @@ qint64 LogFile::writeData(const char * data, qint64 dataSize) {
         return dataSize;
 
     quint32 timeStamp = myTime.elapsed();
+    qint64 pos = writePos;
 
-    file.write((char *) &timeStamp,sizeof(timeStamp));
-    file.write((char *) &dataSize, sizeof(dataSize));
+    // A dropped record must leave no trace in the index
+    if (!writeRecord(timeStamp, data, dataSize))
+        return dataSize;
+
+    // Index before this record updates the object state, so that a
+    // keyframe describes the log up to its entry
+    if (index.isEmpty() || timeStamp - index.last().timestamp >= INDEX_INTERVAL_MS)
+        addIndexEntry(timeStamp, pos);
 
-    qint64 written = file.write(data, dataSize);
-    if(written != -1)
-        emit bytesWritten(written);
+    quint64 key;
+    if (packetKey(data, dataSize, key))
+        latestRecord.insert(key, pos);
 
     return dataSize;
 }
 
+/**
+ * Hand a record to the writer thread
+ * @returns false if the writer dropped it
+ */
+bool LogFile::writeRecord(quint32 timeStamp, const char *data, qint64 dataSize)
+{
+    if (writer == NULL || !writer->writeRecord(timeStamp, data, dataSize))
+        return false;
+
+    writePos += RECORD_HEADER_LENGTH + dataSize;
+    emit bytesWritten(dataSize);
+    return true;
+}
+
 qint64 LogFile::readData(char * data, qint64 maxSize) {
     QMutexLocker locker(&mutex);
-    qint64 toRead = qMin(maxSize,(qint64)dataBuffer.size());
-    memcpy(data,dataBuffer.data(),toRead);
-    dataBuffer.remove(0,toRead);
+    qint64 toRead = qMin(maxSize, ringCount);
+
+    // Never past the end of the record at the head, so that what was
+    // read has a single time
+    if (!ringStamps.isEmpty()) {
+        toRead = qMin(toRead, ringStamps.head().end - ringTaken);
+        lastReadStamp = ringStamps.head().timestamp;
+    }
+
+    // At most two pieces, before and after the wrap
+    qint64 first = qMin(toRead, (qint64) ringBuffer.size() - ringHead);
+    memcpy(data, ringBuffer.constData() + ringHead, first);
+    memcpy(data + first, ringBuffer.constData(), toRead - first);
+
+    ringHead = (ringHead + toRead) % qMax(ringBuffer.size(), 1);
+    ringCount -= toRead;
+    ringTaken += toRead;
+    while (!ringStamps.isEmpty() && ringStamps.head().end <= ringTaken)
+        ringStamps.dequeue();
     return toRead;
 }
 
 qint64 LogFile::bytesAvailable() const
 {
-    return dataBuffer.size();
+    return ringCount;
 }
 
-void LogFile::timerFired()
+/**
+ * Queue replayed data for readData(), growing the ring when it is full
+ * @param[in] timestamp the time the objects in it are stamped with
+ */
+void LogFile::appendReplayData(const char *data, qint64 length, qint64 timestamp)
 {
-    qint64 dataSize;
+    QMutexLocker locker(&mutex);
 
-    if(file.bytesAvailable() > 4)
-    {
+    if (ringCount + length > ringBuffer.size()) {
+        qint64 size = qMax((qint64) RING_BUFFER_INITIAL_SIZE, (qint64) ringBuffer.size());
+        while (size < ringCount + length)
+            size *= 2;
 
-        int time;
-        time = myTime.elapsed();
+        // Unwrap the pending data into the new storage
+        QByteArray grown(size, 0);
+        qint64 first = qMin(ringCount, (qint64) ringBuffer.size() - ringHead);
+        memcpy(grown.data(), ringBuffer.constData() + ringHead, first);
+        memcpy(grown.data() + first, ringBuffer.constData(), ringCount - first);
+        ringBuffer = grown;
+        ringHead = 0;
+    }
 
-        //Read packets
-        while ((lastPlayTime + ((time - lastPlayTimeOffset)* playbackSpeed) > (lastTimeStamp-firstTimestamp)))
-        {
-            lastPlayTime += ((time - lastPlayTimeOffset)* playbackSpeed);
-            if(file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
+    qint64 tail = (ringHead + ringCount) % ringBuffer.size();
+    qint64 first = qMin(length, (qint64) ringBuffer.size() - tail);
+    memcpy(ringBuffer.data() + tail, data, first);
+    memcpy(ringBuffer.data(), data + first, length - first);
+    ringCount += length;
 
-            file.seek(lastTimeStampPos+sizeof(lastTimeStamp));
+    ringQueued += length;
+    RecordStamp stamp = { ringQueued, timestamp };
+    ringStamps.enqueue(stamp);
+}
 
-            file.read((char *) &dataSize, sizeof(dataSize));
+void LogFile::timerFired()
+{
+    qint64 dataSize;
+    int time;
+    time = myTime.elapsed();
 
-            if (dataSize<1 || dataSize>(1024*1024)) {
-                qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
-                stopReplay();
-                return;
-            }
-            if(file.bytesAvailable() < dataSize) {
-                stopReplay();
-                return;
-            }
+    //Read packets
+    while ((lastPlayTime + ((time - lastPlayTimeOffset)* playbackSpeed) > (lastTimeStamp-firstTimestamp)))
+    {
+        lastPlayTime += ((time - lastPlayTimeOffset)* playbackSpeed);
 
-            mutex.lock();
-            dataBuffer.append(file.read(dataSize));
-            mutex.unlock();
-            emit readyRead();
+        quint32 timeStamp;
+        if (!readRecordHeader(nextRecordPos, timeStamp, dataSize)) {
+            stopReplay();
+            return;
+        }
 
-            if(file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
+        if (dataSize<1 || dataSize>(1024*1024)) {
+            qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
+            stopReplay();
+            return;
+        }
+        if(nextRecordPos + RECORD_HEADER_LENGTH + dataSize > dataEnd) {
+            stopReplay();
+            return;
+        }
 
-            lastTimeStampPos = timestampPos[timestampBufferIdx];
-            lastTimeStamp = timestampBuffer[timestampBufferIdx];
-            timestampBufferIdx++;
+        QByteArray scratch;
+        const char *packet = logData(nextRecordPos + RECORD_HEADER_LENGTH, dataSize, scratch);
+        if (packet == NULL) {
+            stopReplay();
+            return;
+        }
+
+        addCheckpoints(nextRecordPos);
+        quint64 key;
+        if (packetKey(packet, dataSize, key))
+            replayLatest.insert(key, nextRecordPos);
 
-            lastPlayTimeOffset = time;
-            time = myTime.elapsed();
+        appendReplayData(packet, dataSize, replayStamp(timeStamp));
+        emit readyRead();
 
+        // Move on to the next valid record
+        nextRecordPos = findRecord(nextRecordPos + RECORD_HEADER_LENGTH + dataSize);
+        if (nextRecordPos < 0 || !readRecordHeader(nextRecordPos, lastTimeStamp, dataSize)) {
+            stopReplay();
+            return;
         }
-    } else {
-        stopReplay();
-    }
 
+        lastPlayTimeOffset = time;
+        time = myTime.elapsed();
+    }
 }
 
 bool LogFile::startReplay() {
-    dataBuffer.clear();
+    {
+        QMutexLocker locker(&mutex);
+        ringHead = 0;
+        ringCount = 0;
+        ringStamps.clear();
+        ringQueued = 0;
+        ringTaken = 0;
+    }
     myTime.restart();
     lastPlayTimeOffset = 0;
     lastPlayTime = 0;
     playbackSpeed = 1;
 
-    //Read all log timestamps into array
-    timestampBuffer.clear(); //Save beginning of log for later use
-    timestampPos.clear();
-    quint64 logFileStartIdx = file.pos();
-    timestampBufferIdx = 0;
-    lastTimeStamp = 0;
+    // Use the index the log was written with, old logs have to be scanned
+    dataStart = file.pos();
+    clearIndex();
 
-    while (!file.atEnd()){
-        qint64 dataSize;
-
-        //Get time stamp position
-        timestampPos.append(file.pos());
-
-        //Read timestamp and logfile packet size
-        file.read((char *) &lastTimeStamp, sizeof(lastTimeStamp));
-        file.read((char *) &dataSize, sizeof(dataSize));
-
-        //Check if dataSize sync bytes are correct.
-        //TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN THE STRING OF SIX 0x00
-        if ((dataSize & 0xFFFFFFFFFFFF0000)!=0){
-            qDebug() << "Wrong sync byte. At file location 0x"  << QString("%1").arg(file.pos(),0,16) << "Got 0x" << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000,0,16) << ", but expected 0x""00"".";
-            file.seek(timestampPos.last()+1);
-            timestampPos.pop_back();
-            continue;
-        }
-
-        //Check if timestamps are sequential.
-        if (!timestampBuffer.isEmpty() && lastTimeStamp < timestampBuffer.last()){
-            QMessageBox msgBox;
-            msgBox.setText("Corrupted file.");
-            msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected behavior"); //<--TODO: add hyperlink to webpage with better description.
-            msgBox.exec();
+    // Read the log straight from memory when it can be mapped
+    if (mappedLog == NULL) {
+        mappedSize = file.size();
+        mappedLog = file.map(0, mappedSize);
+    }
 
-            qDebug() << "Timestamp: " << timestampBuffer.last() << " " << lastTimeStamp;
+    // Everything below works on plain records, expand compact logs first
+    if (readCompact && !expanded) {
+        QByteArray contents;
+        const uchar *log = mappedLog;
+        qint64 size = mappedSize;
+        if (log == NULL && file.seek(0)) {
+            contents = file.readAll();
+            log = (const uchar *) contents.constData();
+            size = contents.size();
         }
+        if (log == NULL || !expandLog(log, size, dataStart, expandedLog))
+            qDebug() << "No valid blocks in compact log" << file.fileName();
 
-        timestampBuffer.append(lastTimeStamp);
-
-        file.seek(timestampPos.last()+sizeof(lastTimeStamp)+sizeof(dataSize)+dataSize);
+        if (mappedLog != NULL)
+            file.unmap(mappedLog);
+        mappedLog = (uchar *) expandedLog.data();
+        mappedSize = expandedLog.size();
+        expanded = true;
     }
 
+    if (!readIndex())
+        scanLog();
+
     //Check if any timestamps were successfully read
-    if (timestampBuffer.size() == 0){
+    if (index.isEmpty()){
         QMessageBox msgBox;
         msgBox.setText("Empty logfile.");
         msgBox.setInformativeText("No log data can be found.");
@@ -290,11 +613,15 @@ bool LogFile::startReplay() {
     }
 
     //Reset to log beginning.
-    file.seek(logFileStartIdx+sizeof(lastTimeStamp));
-    lastTimeStampPos = timestampPos[0];
-    lastTimeStamp = timestampBuffer[0];
-    firstTimestamp = timestampBuffer[0];
-    timestampBufferIdx = 1;
+    nextRecordPos = index[0].offset;
+    lastTimeStamp = index[0].timestamp;
+    firstTimestamp = index[0].timestamp;
+    replayClockBase = UAVObject::currentTimestamp();
+
+    replayLatest.clear();
+    replayStateKnown = true;
+    replayEntry = 0;
+    lastCheckpointTime = index[0].timestamp;
 
     timer.setInterval(10);
     timer.start();
@@ -320,22 +647,515 @@ void LogFile::resumeReplay()
 }
 
 /**
- * @brief LogFile::setReplayTime, sets the playback time
- * @param val, the time in
+ * @brief LogFile::setReplayTime, sets the playback time. The object state
+ * at that time is restored from the nearest keyframe before playback
+ * resumes, if the log has them.
+ * @param val, the time in seconds
  */
 void LogFile::setReplayTime(double val)
 {
-    quint32 tmpIdx=0;
-    while(timestampBuffer[tmpIdx++] <= val*1000 && tmpIdx <= timestampBufferIdx){
+    if (index.isEmpty())
+        return;
+
+    quint32 target = val*1000;
+
+    // Last index entry at or before the target
+    QVector<IndexEntry>::const_iterator entry = std::upper_bound(index.constBegin(), index.constEnd(), target,
+            [](quint32 time, const IndexEntry &e) { return time < e.timestamp; });
+    if (entry != index.constBegin())
+        --entry;
+
+    qint64 pos = entry->offset;
+    QHash<quint64, qint64> latest;
+    bool restoreState = false;
+    quint32 keyframeTime = entry->timestamp;
+
+    for (QVector<IndexEntry>::const_iterator kf = entry; ; --kf) {
+        if (kf->keyframe >= 0) {
+            pos = kf->offset;
+            keyframeTime = kf->timestamp;
+            restoreState = true;
+            foreach (qint64 offset, keyframes[kf->keyframe]) {
+                quint64 key;
+                if (recordKey(offset, key))
+                    latest.insert(key, offset);
+            }
+            break;
+        }
+        if (kf == index.constBegin())
+            break;
+    }
+
+    // Walk up to the first record at or after the target
+    quint32 timeStamp = entry->timestamp;
+    qint64 dataSize;
+    while (pos >= 0 && readRecordHeader(pos, timeStamp, dataSize) && timeStamp < target) {
+        quint64 key;
+        if (restoreState && recordKey(pos, key))
+            latest.insert(key, pos);
+        pos = findRecord(pos + RECORD_HEADER_LENGTH + dataSize);
+    }
+
+    // Stamps carry on from the last ones read whichever way we jumped,
+    // the scopes need them to keep increasing
+    qint64 resumeStamp = qMax(UAVObject::currentTimestamp(), lastReadStamp);
+    replayClockBase = resumeStamp - (qint64) (timeStamp - firstTimestamp);
+
+    // Replay the latest value of every object, in log order
+    QVector<qint64> offsets = latest.values().toVector();
+    std::sort(offsets.begin(), offsets.end());
+    bool restored = false;
+    foreach (qint64 offset, offsets) {
+        quint32 recordTime;
+        QByteArray scratch;
+        const char *packet;
+        if (readRecordHeader(offset, recordTime, dataSize) &&
+                (packet = logData(offset + RECORD_HEADER_LENGTH, dataSize, scratch)) != NULL) {
+            appendReplayData(packet, dataSize, resumeStamp);
+            restored = true;
+        }
     }
+    if (restored)
+        emit readyRead();
 
-    lastTimeStampPos=timestampPos[tmpIdx];
-    lastTimeStamp=timestampBuffer[tmpIdx];
-    timestampBufferIdx=tmpIdx;
+    nextRecordPos = (pos < 0) ? dataEnd : pos;
+    lastTimeStamp = timeStamp;
+
+    // Carry on adding keyframes from the restored state
+    replayLatest = latest;
+    replayStateKnown = restoreState;
+    replayEntry = (int) (std::lower_bound(index.constBegin(), index.constEnd(), nextRecordPos,
+            [](const IndexEntry &e, qint64 offset) { return e.offset < offset; }) - index.constBegin());
+    lastCheckpointTime = keyframeTime;
 
     lastPlayTimeOffset = myTime.elapsed();
-    lastPlayTime=lastTimeStamp;
+    lastPlayTime = lastTimeStamp - firstTimestamp;
 
     qDebug() << "Replaying at: " << lastTimeStamp << ", but requestion at" << val*1000;
 }
 
+/**
+ * Check the header of a log for the compact format line
+ */
+bool LogFile::isCompactLog(const uchar *log, qint64 headerLength)
+{
+    QByteArray header = QByteArray::fromRawData((const char *) log, headerLength);
+    return header.contains(QByteArray("\n") + FORMAT_V2_LINE + "\n");
+}
+
+/**
+ * Expand the blocks of a compact log to plain records, keeping the header
+ * so that offsets match the ones the log was indexed with. Corrupted
+ * blocks are skipped up to the next block magic.
+ * @param start The end of the header
+ * @returns false if no block could be read
+ */
+bool LogFile::expandLog(const uchar *log, qint64 size, qint64 start, QByteArray &image)
+{
+    image = QByteArray((const char *) log, start);
+    bool found = false;
+
+    qint64 pos = start;
+    while (pos + BLOCK_HEADER_LENGTH <= size) {
+        if (memcmp(log + pos, BLOCK_MAGIC, BLOCK_MAGIC_LENGTH)) {
+            pos++;
+            continue;
+        }
+
+        quint8 flags = log[pos + BLOCK_MAGIC_LENGTH];
+        quint32 timeStamp = qFromLittleEndian<quint32>(log + pos + BLOCK_MAGIC_LENGTH + 1);
+        quint32 recordsLength = qFromLittleEndian<quint32>(log + pos + BLOCK_MAGIC_LENGTH + 5);
+        quint32 storedLength = qFromLittleEndian<quint32>(log + pos + BLOCK_MAGIC_LENGTH + 9);
+        if (pos + BLOCK_HEADER_LENGTH + storedLength > size) {
+            pos++;
+            continue;
+        }
+
+        const uchar *records = log + pos + BLOCK_HEADER_LENGTH;
+        QByteArray uncompressed;
+        if (flags & BLOCK_ZLIB) {
+            uncompressed = qUncompress(records, storedLength);
+            records = (const uchar *) uncompressed.constData();
+        }
+        if ((flags & BLOCK_ZLIB) ? (quint32) uncompressed.size() != recordsLength : storedLength != recordsLength) {
+            pos++;
+            continue;
+        }
+
+        const uchar *record = records;
+        const uchar *end = records + recordsLength;
+        while (record < end) {
+            quint64 delta;
+            quint64 length;
+            if (!readVarint(record, end, delta) || !readVarint(record, end, length) ||
+                    length > (quint64) (end - record))
+                break;
+
+            timeStamp += delta;
+            qint64 dataSize = length;
+            image.append((const char *) &timeStamp, sizeof(timeStamp));
+            image.append((const char *) &dataSize, sizeof(dataSize));
+            image.append((const char *) record, dataSize);
+            record += dataSize;
+        }
+
+        found = true;
+        pos += BLOCK_HEADER_LENGTH + storedLength;
+    }
+
+    return found;
+}
+
+qint64 LogFile::logSize()
+{
+    return (mappedLog != NULL) ? mappedSize : file.size();
+}
+
+/**
+ * Copy part of the log being replayed, from the mapping when there is one
+ */
+bool LogFile::readLog(qint64 pos, char *dest, qint64 length)
+{
+    if (mappedLog != NULL) {
+        if (pos < 0 || pos + length > mappedSize)
+            return false;
+        memcpy(dest, mappedLog + pos, length);
+        return true;
+    }
+
+    return file.seek(pos) && file.read(dest, length) == length;
+}
+
+/**
+ * Get part of the log being replayed without copying it when the log is
+ * mapped, otherwise read it into scratch
+ * @returns The data, or NULL if it is past the end of the file
+ */
+const char *LogFile::logData(qint64 pos, qint64 length, QByteArray &scratch)
+{
+    if (mappedLog != NULL) {
+        if (pos < 0 || pos + length > mappedSize)
+            return NULL;
+        return (const char *) mappedLog + pos;
+    }
+
+    if (!file.seek(pos))
+        return NULL;
+    scratch = file.read(length);
+    return (scratch.size() == length) ? scratch.constData() : NULL;
+}
+
+/**
+ * Read the header of the record at pos
+ * @returns false at the end of the data or if the size is not plausible
+ */
+bool LogFile::readRecordHeader(qint64 pos, quint32 &timeStamp, qint64 &dataSize)
+{
+    if (pos + RECORD_HEADER_LENGTH > dataEnd)
+        return false;
+    if (!readLog(pos, (char *) &timeStamp, sizeof(timeStamp)) ||
+            !readLog(pos + sizeof(timeStamp), (char *) &dataSize, sizeof(dataSize)))
+        return false;
+
+    //Check if dataSize sync bytes are correct.
+    //TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN THE STRING OF SIX 0x00
+    return (dataSize & 0xFFFFFFFFFFFF0000) == 0;
+}
+
+/**
+ * Find the first record at or after pos with a plausible header
+ * @returns The record offset, or -1 at the end of the data
+ */
+qint64 LogFile::findRecord(qint64 pos)
+{
+    quint32 timeStamp;
+    qint64 dataSize;
+    while (pos + RECORD_HEADER_LENGTH <= dataEnd) {
+        if (readRecordHeader(pos, timeStamp, dataSize))
+            return pos;
+        qDebug() << "Wrong sync byte. At file location 0x"  << QString("%1").arg(pos,0,16) << "Got 0x" << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000,0,16) << ", but expected 0x""00"".";
+        pos++;
+    }
+    return -1;
+}
+
+/**
+ * Identify the object instance a UAVTalk packet updates
+ * @returns false if the packet is not an object update
+ */
+bool LogFile::packetKey(const char *data, qint64 dataSize, quint64 &key)
+{
+    if (dataSize < UAVTALK_MIN_HEADER || (quint8) data[0] != UAVTALK_SYNC)
+        return false;
+    if ((quint8) data[1] != UAVTALK_TYPE_OBJ && (quint8) data[1] != UAVTALK_TYPE_OBJ_ACK)
+        return false;
+
+    if (objMngr == NULL)
+        objMngr = ExtensionSystem::PluginManager::instance()->getObject<UAVObjectManager>();
+
+    quint32 objId = qFromLittleEndian<quint32>((const uchar *) &data[4]);
+    quint16 instId = 0;
+    UAVObject *obj = objMngr ? objMngr->getObject(objId) : NULL;
+    if (obj != NULL && !obj->isSingleInstance() && dataSize >= UAVTALK_MAX_HEADER)
+        instId = qFromLittleEndian<quint16>((const uchar *) &data[8]);
+
+    key = ((quint64) objId << 16) | instId;
+    return true;
+}
+
+/**
+ * Identify the object instance the record at pos updates
+ */
+bool LogFile::recordKey(qint64 pos, quint64 &key)
+{
+    quint32 timeStamp;
+    qint64 dataSize;
+    if (!readRecordHeader(pos, timeStamp, dataSize))
+        return false;
+
+    char header[UAVTALK_MAX_HEADER];
+    qint64 length = qMin(dataSize, (qint64) UAVTALK_MAX_HEADER);
+    if (!readLog(pos + RECORD_HEADER_LENGTH, header, length))
+        return false;
+    return packetKey(header, length, key);
+}
+
+/**
+ * Add an index entry, with a keyframe every KEYFRAME_INTERVAL_MS
+ */
+void LogFile::addIndexEntry(quint32 timeStamp, qint64 offset)
+{
+    IndexEntry entry;
+    entry.timestamp = timeStamp;
+    entry.offset = offset;
+    entry.keyframe = -1;
+
+    if (keyframes.isEmpty() || timeStamp - lastKeyframeTime >= KEYFRAME_INTERVAL_MS) {
+        QVector<qint64> keyframe = latestRecord.values().toVector();
+        std::sort(keyframe.begin(), keyframe.end());
+        entry.keyframe = keyframes.size();
+        keyframes.append(keyframe);
+        lastKeyframeTime = timeStamp;
+    }
+
+    index.append(entry);
+}
+
+/**
+ * Give the index entries playback reaches at pos a keyframe of the
+ * state played so far, at most every CHECKPOINT_INTERVAL_MS. Afterwards
+ * seeking near them restores the state without walking far.
+ */
+void LogFile::addCheckpoints(qint64 pos)
+{
+    while (replayEntry < index.size() && index[replayEntry].offset <= pos) {
+        IndexEntry &entry = index[replayEntry++];
+        if (entry.keyframe >= 0) {
+            lastCheckpointTime = entry.timestamp;
+            continue;
+        }
+        if (!replayStateKnown || entry.timestamp - lastCheckpointTime < CHECKPOINT_INTERVAL_MS)
+            continue;
+
+        QVector<qint64> keyframe = replayLatest.values().toVector();
+        std::sort(keyframe.begin(), keyframe.end());
+        entry.keyframe = keyframes.size();
+        keyframes.append(keyframe);
+        lastCheckpointTime = entry.timestamp;
+    }
+}
+
+/**
+ * Append the index to a log being written
+ */
+void LogFile::writeIndex()
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+
+    out.writeRawData(INDEX_MAGIC, MAGIC_LENGTH);
+    out << INDEX_VERSION << (quint32) index.size() << (quint32) keyframes.size();
+    foreach (const IndexEntry &entry, index)
+        out << entry.timestamp << entry.offset << entry.keyframe;
+    foreach (const QVector<qint64> &keyframe, keyframes) {
+        out << (quint32) keyframe.size();
+        foreach (qint64 offset, keyframe)
+            out << offset;
+    }
+
+    quint32 timeStamp = myTime.elapsed();
+    foreach (const QByteArray &record, indexRecords(payload, writePos))
+        writeRecord(timeStamp, record.constData(), record.size());
+}
+
+/**
+ * Split an index payload into the records it is written as
+ * @param[in] payload the index, from "DRLOGIDX" to the last keyframe
+ * @param[in] indexPos offset the first of the records will be written at
+ * @returns the chunks of the payload, then the trailer in a record of its own
+ *
+ * The trailer never shares a record with the payload, so whatever the
+ * payload length it is always the last INDEX_TRAILER_LENGTH bytes of the
+ * log and is not split by a record header.
+ */
+QVector<QByteArray> LogFile::indexRecords(const QByteArray &payload, qint64 indexPos)
+{
+    QVector<QByteArray> records;
+    for (int pos = 0; pos < payload.size(); pos += INDEX_CHUNK_LENGTH)
+        records.append(payload.mid(pos, INDEX_CHUNK_LENGTH));
+
+    QByteArray trailer;
+    QDataStream out(&trailer, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << indexPos;
+    out.writeRawData(INDEX_END_MAGIC, MAGIC_LENGTH);
+    records.append(trailer);
+
+    return records;
+}
+
+/**
+ * Parse the trailer ending a log with an index
+ * @param[in] trailer the last INDEX_TRAILER_LENGTH bytes of the log
+ * @param[out] indexPos offset of the first index record
+ * @returns false if the bytes are not a trailer
+ */
+bool LogFile::parseIndexTrailer(const QByteArray &trailer, qint64 &indexPos)
+{
+    if (trailer.size() != INDEX_TRAILER_LENGTH ||
+            memcmp(trailer.constData() + sizeof(qint64), INDEX_END_MAGIC, MAGIC_LENGTH))
+        return false;
+
+    QDataStream in(trailer);
+    in.setByteOrder(QDataStream::LittleEndian);
+    in >> indexPos;
+    return in.status() == QDataStream::Ok;
+}
+
+/**
+ * Load the index from the end of the log
+ * @returns false if the log has no usable index
+ */
+bool LogFile::readIndex()
+{
+    dataEnd = logSize();
+    if (dataEnd < dataStart + RECORD_HEADER_LENGTH + INDEX_TRAILER_LENGTH)
+        return false;
+
+    // The trailer is the whole of the last record
+    qint64 trailerPos = dataEnd - INDEX_TRAILER_LENGTH - RECORD_HEADER_LENGTH;
+    quint32 trailerStamp;
+    qint64 trailerSize;
+    if (!readRecordHeader(trailerPos, trailerStamp, trailerSize) || trailerSize != INDEX_TRAILER_LENGTH)
+        return false;
+
+    QByteArray trailer(INDEX_TRAILER_LENGTH, 0);
+    qint64 indexPos;
+    if (!readLog(dataEnd - INDEX_TRAILER_LENGTH, trailer.data(), INDEX_TRAILER_LENGTH) ||
+            !parseIndexTrailer(trailer, indexPos) || indexPos < dataStart || indexPos >= trailerPos)
+        return false;
+
+    // Gather the payload back from the records before the trailer
+    QByteArray payload;
+    for (qint64 pos = indexPos; pos < trailerPos; ) {
+        quint32 timeStamp;
+        qint64 dataSize;
+        if (!readRecordHeader(pos, timeStamp, dataSize) || pos + RECORD_HEADER_LENGTH + dataSize > trailerPos)
+            return false;
+        QByteArray scratch;
+        const char *chunk = logData(pos + RECORD_HEADER_LENGTH, dataSize, scratch);
+        if (chunk == NULL)
+            return false;
+        payload.append(chunk, dataSize);
+        pos += RECORD_HEADER_LENGTH + dataSize;
+    }
+
+    QDataStream in(payload);
+    in.setByteOrder(QDataStream::LittleEndian);
+    char magic[MAGIC_LENGTH];
+    quint32 version, numEntries, numKeyframes;
+    if (in.readRawData(magic, MAGIC_LENGTH) != MAGIC_LENGTH || memcmp(magic, INDEX_MAGIC, MAGIC_LENGTH))
+        return false;
+    in >> version >> numEntries >> numKeyframes;
+    if (in.status() != QDataStream::Ok || version != INDEX_VERSION)
+        return false;
+
+    QVector<IndexEntry> entries;
+    for (quint32 i = 0; i < numEntries && in.status() == QDataStream::Ok; i++) {
+        IndexEntry entry;
+        in >> entry.timestamp >> entry.offset >> entry.keyframe;
+        if (entry.offset < dataStart || entry.offset >= indexPos || entry.keyframe >= (qint32) numKeyframes)
+            return false;
+        entries.append(entry);
+    }
+
+    QVector<QVector<qint64> > frames;
+    for (quint32 i = 0; i < numKeyframes && in.status() == QDataStream::Ok; i++) {
+        quint32 count;
+        in >> count;
+        QVector<qint64> keyframe;
+        for (quint32 j = 0; j < count && in.status() == QDataStream::Ok; j++) {
+            qint64 offset;
+            in >> offset;
+            keyframe.append(offset);
+        }
+        frames.append(keyframe);
+    }
+
+    if (in.status() != QDataStream::Ok || entries.isEmpty())
+        return false;
+
+    index = entries;
+    keyframes = frames;
+    dataEnd = indexPos;
+    return true;
+}
+
+/**
+ * Build the index of a log written without one by reading every record
+ */
+void LogFile::scanLog()
+{
+    dataEnd = logSize();
+
+    quint32 timeStamp = 0;
+    quint32 previousTimeStamp = 0;
+    qint64 dataSize;
+    bool warned = false;
+
+    for (qint64 pos = findRecord(dataStart); pos >= 0; pos = findRecord(pos + RECORD_HEADER_LENGTH + dataSize)) {
+        readRecordHeader(pos, timeStamp, dataSize);
+
+        //Check if timestamps are sequential.
+        if (!index.isEmpty() && timeStamp < previousTimeStamp && !warned){
+            QMessageBox msgBox;
+            msgBox.setText("Corrupted file.");
+            msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected behavior"); //<--TODO: add hyperlink to webpage with better description.
+            msgBox.exec();
+            warned = true;
+
+            qDebug() << "Timestamp: " << previousTimeStamp << " " << timeStamp;
+        }
+        previousTimeStamp = timeStamp;
+
+        // Same index and keyframes as the log would have been written with
+        if (index.isEmpty() || timeStamp - index.last().timestamp >= INDEX_INTERVAL_MS)
+            addIndexEntry(timeStamp, pos);
+
+        quint64 key;
+        if (recordKey(pos, key))
+            latestRecord.insert(key, pos);
+    }
+
+    latestRecord.clear();
+}
+
+void LogFile::clearIndex()
+{
+    index.clear();
+    keyframes.clear();
+    latestRecord.clear();
+    lastKeyframeTime = 0;
+    replayLatest.clear();
+}
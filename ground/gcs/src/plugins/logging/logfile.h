@@ -33,25 +33,120 @@
 #include <QMutexLocker>
 #include <QDebug>
 #include <QBuffer>
+#include <QHash>
+#include <QVector>
+#include <QThread>
+#include <QWaitCondition>
+#include <QQueue>
 #include "uavobjectmanager.h"
+#include <uavtalk/uavtalk.h>
 #include <math.h>
 
-class LogFile : public QIODevice
+/**
+ * Writes log records to the file from its own thread, so that recording
+ * never waits on the disk. Records are appended whole to a pending
+ * buffer, which the thread swaps out and writes in large chunks, syncing
+ * the file to disk every syncInterval ms (never if 0). Records that
+ * would grow the pending buffer past MAX_PENDING_LENGTH are dropped.
+ * In the compact format every chunk is written as one block.
+ */
+class LogWriter : public QThread
+{
+public:
+    LogWriter(QFile *file, quint32 syncInterval, bool compact, bool compress);
+    ~LogWriter();
+
+    bool writeRecord(quint32 timeStamp, const char *data, qint64 dataSize);
+    void stop();
+
+    //! Bytes dropped because the disk fell behind or failed
+    quint64 getDroppedBytes() const { return droppedBytes; }
+    //! Bytes written by chunks that took longer than FLUSH_INTERVAL_MS
+    quint64 getLateBytes() const { return lateBytes; }
+
+protected:
+    void run();
+
+private:
+    static const int CHUNK_LENGTH = 256 * 1024;
+    static const int MAX_PENDING_LENGTH = 32 * 1024 * 1024;
+    static const unsigned long FLUSH_INTERVAL_MS = 250;
+
+    QFile *file;
+    quint32 syncInterval;
+    bool compact;
+    bool compress;
+    QMutex mutex;
+    QWaitCondition chunkReady;
+    QByteArray pending;
+    QByteArray writing;
+    quint32 pendingBase;        // Timestamp the pending block starts at
+    quint32 writingBase;
+    quint32 lastTimeStamp;
+    bool stopping;
+    quint64 droppedBytes;
+    quint64 lateBytes;
+
+    QByteArray encodeBlock(const QByteArray &records, quint32 baseTimeStamp) const;
+    void syncFile();
+};
+
+/**
+ * Logs are a text header followed by records of a timestamp (32 bit,
+ * ms), the packet size (64 bit) and one UAVTalk packet.
+ *
+ * Logs written by this version end with an index, stored as ordinary
+ * records so that older versions still replay them (UAVTalk discards the
+ * index bytes as noise). The index payload is "DRLOGIDX", the version,
+ * the entry and keyframe counts, the entries (timestamp, record offset,
+ * keyframe or -1) and the keyframes (record count, record offsets). It
+ * is split over records of at most INDEX_CHUNK_LENGTH bytes, followed
+ * by a record of just the offset of the first index record and
+ * "DRLOGEND". Logs without it are scanned when replay starts.
+ */
+/**
+ * Logs written in the compact format (FORMAT_V2) add "format: 2" to the
+ * header and store the records in blocks: "DRB2", flags (1 if zlib
+ * compressed), the timestamp of the first record, the length of the
+ * records and the length stored (32 bit each). Each record in a block
+ * is the time since the previous one and the packet size as varints,
+ * then the packet. When replayed or decoded these logs are expanded in
+ * memory to the records above, which all offsets in the index refer to.
+ */
+class LogFile : public QIODevice, public UAVTalkTimeSource
 {
     Q_OBJECT
 public:
+    //! Layouts a log can be recorded with
+    enum RecordFormat {
+        FORMAT_V1,          // Readable by every version
+        FORMAT_V2,          // Compact
+        FORMAT_V2_ZLIB      // Compact, with the blocks compressed
+    };
+
     explicit LogFile(QObject *parent = 0);
     qint64 bytesAvailable() const;
-    qint64 bytesToWrite() const { return file.bytesToWrite(); }
+    // Never throttle the sender, the writer keeps its own backlog
+    qint64 bytesToWrite() const { return 0; }
     bool open(OpenMode mode);
     void setFileName(QString name) { file.setFileName(name); }
     void close();
     qint64 writeData(const char * data, qint64 dataSize);
     qint64 readData(char * data, qint64 maxlen);
+    qint64 readTimestamp() const { return lastReadStamp; }
 
     bool startReplay();
     bool stopReplay();
 
+    //! Interval between syncs of a recording to disk, 0 to never sync
+    void setSyncInterval(quint32 interval) { syncInterval = interval; }
+    void setRecordFormat(RecordFormat format) { writeFormat = format; }
+
+    static bool isCompactLog(const uchar *log, qint64 headerLength);
+    static bool expandLog(const uchar *log, qint64 size, qint64 start, QByteArray &image);
+    static QVector<QByteArray> indexRecords(const QByteArray &payload, qint64 indexPos);
+    static bool parseIndexTrailer(const QByteArray &trailer, qint64 &indexPos);
+
 public slots:
     void setReplaySpeed(double val) { playbackSpeed = val; qDebug() << "New playback speed: " << playbackSpeed; }
     void setReplayTime(double val);
@@ -67,7 +162,6 @@ signals:
     void replayFinished();
 
 protected:
-    QByteArray dataBuffer;
     QTimer timer;
     QTime myTime;
     QFile file;
@@ -80,11 +174,91 @@ protected:
     double playbackSpeed;
 
 private:
-    QList<quint32> timestampBuffer;
-    QList<quint32> timestampPos;
-    quint32 timestampBufferIdx;
-    quint32 lastTimeStampPos;
+    static const int RECORD_HEADER_LENGTH = sizeof(quint32) + sizeof(qint64);
+    static const quint32 INDEX_INTERVAL_MS = 1000;
+    static const quint32 KEYFRAME_INTERVAL_MS = 30000;
+    static const int INDEX_CHUNK_LENGTH = 60000;    // Below what old versions take as a bad size
+    static const quint32 INDEX_VERSION = 1;
+
+    //! Sparse index of the log, one entry per INDEX_INTERVAL_MS
+    typedef struct {
+        quint32 timestamp;
+        qint64 offset;          // First record at or after timestamp
+        qint32 keyframe;        // Entry in keyframes, or -1
+    } IndexEntry;
+
+    QVector<IndexEntry> index;
+    //! Latest record of every object instance when the entry started
+    QVector<QVector<qint64> > keyframes;
+    //! While writing or scanning, the latest record of every object instance
+    QHash<quint64, qint64> latestRecord;
+    quint32 lastKeyframeTime;
+
+    //! While replaying, the latest record of every object instance played,
+    //! used to add keyframes to the index the first time through the log
+    QHash<quint64, qint64> replayLatest;
+    bool replayStateKnown;
+    int replayEntry;            // First index entry not reached yet
+    quint32 lastCheckpointTime;
+    static const quint32 CHECKPOINT_INTERVAL_MS = 5000;
+
+    //! Replayed data waiting to be read, as a ring buffer
+    QByteArray ringBuffer;
+    qint64 ringHead;
+    qint64 ringCount;
+    static const int RING_BUFFER_INITIAL_SIZE = 64 * 1024;
+
+    //! Where each record queued in the ring ends, and the time it is
+    //! stamped with. Reads stop at record ends so every read has one time.
+    typedef struct {
+        qint64 end;             // In bytes ever queued
+        qint64 timestamp;       // On the UAVObject clock
+    } RecordStamp;
+
+    QQueue<RecordStamp> ringStamps;
+    qint64 ringQueued;          // Bytes ever queued
+    qint64 ringTaken;           // Bytes ever read
+    qint64 lastReadStamp;
+    //! The UAVObject time the first record of the log is stamped with
+    qint64 replayClockBase;
+
+    //! The log mapped in memory while replaying, if the platform allows
+    uchar *mappedLog;
+    qint64 mappedSize;
+    //! A compact log expanded for replay, mappedLog then points to it
+    QByteArray expandedLog;
+    bool expanded;
+
+    qint64 dataStart;
+    qint64 dataEnd;             // Start of the index, or end of file
+    qint64 nextRecordPos;       // Record to play next
     quint32 firstTimestamp;
+    UAVObjectManager *objMngr;
+
+    //! While writing, the records handed to the file writer
+    LogWriter *writer;
+    qint64 writePos;
+    quint32 syncInterval;
+    static const quint32 DEFAULT_SYNC_INTERVAL_MS = 1000;
+    RecordFormat writeFormat;
+    bool readCompact;           // The log being replayed is compact
+
+    bool writeRecord(quint32 timeStamp, const char *data, qint64 dataSize);
+    qint64 logSize();
+    bool readLog(qint64 pos, char *dest, qint64 length);
+    const char *logData(qint64 pos, qint64 length, QByteArray &scratch);
+    void appendReplayData(const char *data, qint64 length, qint64 timestamp);
+    qint64 replayStamp(quint32 timeStamp) const { return replayClockBase + (qint64) (timeStamp - firstTimestamp); }
+    bool readRecordHeader(qint64 pos, quint32 &timeStamp, qint64 &dataSize);
+    qint64 findRecord(qint64 pos);
+    bool packetKey(const char *data, qint64 dataSize, quint64 &key);
+    bool recordKey(qint64 pos, quint64 &key);
+    void addIndexEntry(quint32 timeStamp, qint64 offset);
+    void addCheckpoints(qint64 pos);
+    void writeIndex();
+    bool readIndex();
+    void scanLog();
+    void clearIndex();
 };
 
 #endif // LOGFILE_H
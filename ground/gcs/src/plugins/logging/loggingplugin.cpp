@@ -31,6 +31,8 @@
 #include "loggingdevice.h"
 #include "logginggadgetfactory.h"
 #include "flightlogdownload.h"
+#include "logdecoder.h"
+#include "logsessionmanager.h"
 
 #include <QDebug>
 #include <QtPlugin>
@@ -40,6 +42,9 @@
 #include <QFileDialog>
 #include <QList>
 #include <QErrorMessage>
+#include <QMessageBox>
+#include <QSettings>
+#include <QFileInfo>
 #include <QWriteLocker>
 
 #include <extensionsystem/pluginmanager.h>
@@ -137,6 +142,7 @@ LoggingThread::~LoggingThread()
 bool LoggingThread::openFile(QString file, LoggingPlugin * parent)
 {
     logFile.setFileName(file);
+    logFile.setRecordFormat(parent->getCompactLogs() ? LogFile::FORMAT_V2_ZLIB : LogFile::FORMAT_V1);
     if (!logFile.open(QIODevice::WriteOnly)) {
         return false;
     }
@@ -310,7 +316,7 @@ void LoggingThread::transactionCompleted(UAVObject* obj, bool success)
  ********************************/
 
 
-LoggingPlugin::LoggingPlugin() : state(IDLE)
+LoggingPlugin::LoggingPlugin() : state(IDLE), logExporter(NULL), sessionManager(NULL)
 {
     logConnection = new LoggingConnection();
 }
@@ -363,6 +369,47 @@ bool LoggingPlugin::initialize(const QStringList& args, QString *errMsg)
     ac->addAction(cmdDownload, "Logging");
     connect(cmdDownload->action(), SIGNAL(triggered(bool)), this, SLOT(downloadLog()));
 
+    // Command to export a log to column files
+    cmdExport = am->registerAction(new QAction(this),
+                                            "LoggingPlugin.Export",
+                                            QList<int>() <<
+                                            Core::Constants::C_GLOBAL_ID);
+    cmdExport->action()->setText("Export log...");
+    ac->addAction(cmdExport, "Logging");
+    connect(cmdExport->action(), SIGNAL(triggered(bool)), this, SLOT(exportLog()));
+
+    // Compact logs are smaller, but only readable by this and later versions
+    cmdCompact = am->registerAction(new QAction(this),
+                                            "LoggingPlugin.Compact",
+                                            QList<int>() <<
+                                            Core::Constants::C_GLOBAL_ID);
+    cmdCompact->action()->setText("Compact logs");
+    cmdCompact->action()->setCheckable(true);
+    cmdCompact->action()->setChecked(Core::ICore::instance()->settings()->value("LoggingPlugin/CompactLogs", false).toBool());
+    ac->addAction(cmdCompact, "Logging");
+    connect(cmdCompact->action(), SIGNAL(toggled(bool)), this, SLOT(setCompactLogs(bool)));
+
+    // Logs opened for comparison are offered as overlays by the scopes
+    cmdCompare = am->registerAction(new QAction(this),
+                                            "LoggingPlugin.Compare",
+                                            QList<int>() <<
+                                            Core::Constants::C_GLOBAL_ID);
+    cmdCompare->action()->setText("Open log for comparison...");
+    ac->addAction(cmdCompare, "Logging");
+    connect(cmdCompare->action(), SIGNAL(triggered(bool)), this, SLOT(openComparisonLog()));
+
+    cmdCloseCompare = am->registerAction(new QAction(this),
+                                            "LoggingPlugin.CloseCompare",
+                                            QList<int>() <<
+                                            Core::Constants::C_GLOBAL_ID);
+    cmdCloseCompare->action()->setText("Close comparison logs");
+    cmdCloseCompare->action()->setEnabled(false);
+    ac->addAction(cmdCloseCompare, "Logging");
+    connect(cmdCloseCompare->action(), SIGNAL(triggered(bool)), this, SLOT(closeComparisonLogs()));
+
+    sessionManager = new LogSessionManager(this);
+    addAutoReleasedObject(sessionManager);
+
 
     mf = new LoggingGadgetFactory(this);
     addAutoReleasedObject(mf);
@@ -380,6 +427,96 @@ void LoggingPlugin::downloadLog()
     download.exec();
 }
 
+bool LoggingPlugin::getCompactLogs() const
+{
+    return cmdCompact->action()->isChecked();
+}
+
+void LoggingPlugin::setCompactLogs(bool compact)
+{
+    Core::ICore::instance()->settings()->setValue("LoggingPlugin/CompactLogs", compact);
+}
+
+/**
+  * Decode a log in the background and write each of its fields
+  * to a column file
+  */
+void LoggingPlugin::exportLog()
+{
+    if (logExporter)
+        return;
+
+    QString fileName = QFileDialog::getOpenFileName(NULL, tr("Export log"), QDir::homePath(),
+                                                    tr("dRonin Log (*.drlog)"));
+    if (fileName.isEmpty())
+        return;
+
+    QString dirName = QFileDialog::getExistingDirectory(NULL, tr("Export to directory"),
+                                                        QFileInfo(fileName).absolutePath());
+    if (dirName.isEmpty())
+        return;
+
+    logExporter = new LogDecoder(this);
+    connect(logExporter, SIGNAL(decodeFinished(bool)), this, SLOT(exportFinished(bool)));
+    if (!logExporter->decodeFile(fileName, dirName)) {
+        delete logExporter;
+        logExporter = NULL;
+
+        QErrorMessage err;
+        err.showMessage("Unable to open file for export");
+        err.exec();
+        return;
+    }
+
+    cmdExport->action()->setEnabled(false);
+}
+
+/**
+  * Received the end of an export from the LogDecoder
+  */
+void LoggingPlugin::exportFinished(bool success)
+{
+    if (success) {
+        QMessageBox::information(NULL, tr("Export log"),
+                                 tr("Exported %0 packets, %1 corrupted packets skipped.")
+                                 .arg(logExporter->getNumPackets()).arg(logExporter->getNumErrors()));
+    } else {
+        QErrorMessage err;
+        err.showMessage("Unable to write the exported log");
+        err.exec();
+    }
+
+    // The decoded series are only needed for the export
+    logExporter->deleteLater();
+    logExporter = NULL;
+    cmdExport->action()->setEnabled(true);
+}
+
+/**
+  * Decode one or more logs in the background so the scopes can
+  * overlay them
+  */
+void LoggingPlugin::openComparisonLog()
+{
+    QStringList fileNames = QFileDialog::getOpenFileNames(NULL, tr("Open log for comparison"), QDir::homePath(),
+                                                          tr("dRonin Log (*.drlog)"));
+    foreach (const QString &fileName, fileNames) {
+        if (!sessionManager->openSession(fileName)) {
+            QErrorMessage err;
+            err.showMessage("Unable to open file for comparison");
+            err.exec();
+        }
+    }
+
+    cmdCloseCompare->action()->setEnabled(sessionManager->numSessions() > 0);
+}
+
+void LoggingPlugin::closeComparisonLogs()
+{
+    sessionManager->closeSessions();
+    cmdCloseCompare->action()->setEnabled(false);
+}
+
 /**
   * The action that is triggered by the menu item which opens the
   * file and begins logging if successful
@@ -493,6 +630,14 @@ void LoggingPlugin::shutdown()
         delete loggingThread;
         loggingThread = NULL;
     }
+
+    if (logExporter != NULL) {
+        delete logExporter;
+        logExporter = NULL;
+    }
+
+    if (sessionManager != NULL)
+        sessionManager->closeSessions();
 }
 
 /**
@@ -43,6 +43,8 @@
 
 class LoggingPlugin;
 class LoggingGadgetFactory;
+class LogDecoder;
+class LogSessionManager;
 
 /**
 *   Define a connection via the IConnection interface
@@ -125,6 +127,7 @@ public:
 
     LoggingConnection* getLogConnection() { return logConnection; }
     LogFile* getLogfile() { return logConnection->getLogfile();}
+    bool getCompactLogs() const;
     void setLogMenuTitle(QString str);
 
 
@@ -143,7 +146,12 @@ protected:
 
 private slots:
     void downloadLog();
+    void exportLog();
+    void exportFinished(bool success);
+    void openComparisonLog();
+    void closeComparisonLogs();
     void toggleLogging();
+    void setCompactLogs(bool compact);
     void startLogging(QString file);
     void stopLogging();
     void loggingStopped();
@@ -154,6 +162,12 @@ private:
     LoggingGadgetFactory *mf;
     Core::Command* cmdLogging;
     Core::Command* cmdDownload;
+    Core::Command* cmdExport;
+    Core::Command* cmdCompact;
+    Core::Command* cmdCompare;
+    Core::Command* cmdCloseCompare;
+    LogDecoder *logExporter;
+    LogSessionManager *sessionManager;
 
 };
 #endif /* LoggingPLUGIN_H_ */
@@ -0,0 +1,181 @@
+/**
+ ******************************************************************************
+ * @file       logsessionmanager.cpp
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup LoggingPlugin Logging Plugin
+ * @{
+ * @brief Keeps logs opened for comparison and offers them to the scopes
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "logsessionmanager.h"
+#include "logdecoder.h"
+#include <QFileInfo>
+#include <QRegExp>
+#include <QDebug>
+
+LogSessionManager::LogSessionManager(QObject *parent) : ScopeOverlaySource(parent)
+{
+}
+
+LogSessionManager::~LogSessionManager()
+{
+    closeSessions();
+}
+
+/**
+ * Start decoding a log for comparison. The overlay becomes available
+ * once the decoding has finished.
+ * @returns false if the log couldn't be opened
+ */
+bool LogSessionManager::openSession(const QString &fileName)
+{
+    Session session;
+    session.name = QFileInfo(fileName).completeBaseName();
+    session.ready = false;
+    session.start = 0;
+
+    // Keep the names apart when logs of the same name are compared
+    int copies = 1;
+    QStringList names;
+    foreach (const Session &other, sessions)
+        names << other.name;
+    while (names.contains(session.name))
+        session.name = QString("%0 (%1)").arg(QFileInfo(fileName).completeBaseName()).arg(++copies);
+
+    session.decoder = new LogDecoder(this);
+    connect(session.decoder, SIGNAL(decodeFinished(bool)), this, SLOT(decodeFinished(bool)));
+    if (!session.decoder->decodeFile(fileName)) {
+        delete session.decoder;
+        return false;
+    }
+
+    sessions.append(session);
+    return true;
+}
+
+/**
+ * Drop every comparison log, waiting for those still being decoded
+ */
+void LogSessionManager::closeSessions()
+{
+    foreach (const Session &session, sessions)
+        delete session.decoder;
+    sessions.clear();
+
+    emit overlaysChanged();
+}
+
+QStringList LogSessionManager::getOverlayNames() const
+{
+    QStringList names;
+    foreach (const Session &session, sessions) {
+        if (session.ready)
+            names << session.name;
+    }
+    return names;
+}
+
+bool LogSessionManager::getOverlaySamples(const QString &overlay, const QString &objName,
+                                          const QString &fieldName, const QString &elementName,
+                                          QVector<double> &times, QVector<double> &values) const
+{
+    foreach (const Session &session, sessions) {
+        if (!session.ready || session.name != overlay)
+            continue;
+
+        int series = session.index.value(objName, -1);
+        if (series < 0)
+            return false;
+        const LogSeries &entry = session.decoder->getSeries().at(series);
+
+        // Single element fields have a column named after the field
+        int column;
+        if (elementName.isEmpty()) {
+            column = entry.columns.indexOf(fieldName);
+            if (column < 0)
+                column = entry.columns.indexOf(QRegExp(QRegExp::escape(fieldName + ".") + ".*"));
+        } else {
+            column = entry.columns.indexOf(fieldName + "." + elementName);
+        }
+        if (column < 0)
+            return false;
+
+        // Every object counts from the start of the log, so curves of
+        // different objects line up
+        times.resize(entry.timestamps.size());
+        for (int i = 0; i < entry.timestamps.size(); i++)
+            times[i] = (entry.timestamps[i] - session.start) / 1000.0;
+        values = entry.values[column];
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Index the series of a decoded log by object, and find where it starts
+ */
+void LogSessionManager::indexSession(Session &session)
+{
+    const QVector<LogSeries> &series = session.decoder->getSeries();
+
+    bool first = true;
+    for (int i = 0; i < series.size(); i++) {
+        const LogSeries &entry = series.at(i);
+        if (entry.timestamps.isEmpty())
+            continue;
+
+        if (first || entry.timestamps.first() < session.start)
+            session.start = entry.timestamps.first();
+        first = false;
+
+        if (entry.instId == 0 && !session.index.contains(entry.name))
+            session.index.insert(entry.name, i);
+    }
+}
+
+/**
+ * Received the end of a decode, the log can now be overlaid
+ */
+void LogSessionManager::decodeFinished(bool success)
+{
+    LogDecoder *decoder = qobject_cast<LogDecoder *>(sender());
+    for (int i = 0; i < sessions.size(); i++) {
+        if (sessions[i].decoder != decoder)
+            continue;
+
+        if (success) {
+            indexSession(sessions[i]);
+            sessions[i].ready = true;
+        } else {
+            qDebug() << "Unable to decode comparison log" << sessions[i].name;
+            decoder->deleteLater();
+            sessions.removeAt(i);
+        }
+        break;
+    }
+
+    emit overlaysChanged();
+}
+
+/**
+ * @}
+ * @}
+ */
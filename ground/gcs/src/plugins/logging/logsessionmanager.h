@@ -0,0 +1,85 @@
+/**
+ ******************************************************************************
+ * @file       logsessionmanager.h
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup LoggingPlugin Logging Plugin
+ * @{
+ * @brief Keeps logs opened for comparison and offers them to the scopes
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef LOGSESSIONMANAGER_H
+#define LOGSESSIONMANAGER_H
+
+#include "scope/scopeoverlaysource.h"
+#include <QHash>
+#include <QList>
+
+class LogDecoder;
+
+/**
+ * Every log opened for comparison is decoded by its own LogDecoder, so
+ * several logs load at once while sharing the global thread pool. Once
+ * decoded a log is only kept as its series, indexed by object name, and
+ * can be overlaid or viewed by any number of scopes.
+ */
+class LogSessionManager : public ScopeOverlaySource
+{
+    Q_OBJECT
+
+public:
+    LogSessionManager(QObject *parent = 0);
+    ~LogSessionManager();
+
+    bool openSession(const QString &fileName);
+    void closeSessions();
+    int numSessions() const { return sessions.size(); }
+
+    QStringList getOverlayNames() const;
+    bool getOverlaySamples(const QString &overlay, const QString &objName,
+                           const QString &fieldName, const QString &elementName,
+                           QVector<double> &times, QVector<double> &values) const;
+
+private slots:
+    void decodeFinished(bool success);
+
+private:
+    typedef struct {
+        QString name;
+        LogDecoder *decoder;
+        bool ready;
+
+        //! Series of the first instance of each object, by object name
+        QHash<QString, int> index;
+        //! Earliest timestamp of the log, in ms, all times count from it
+        quint32 start;
+    } Session;
+
+    void indexSession(Session &session);
+
+    QList<Session> sessions;
+};
+
+#endif // LOGSESSIONMANAGER_H
+
+/**
+ * @}
+ * @}
+ */
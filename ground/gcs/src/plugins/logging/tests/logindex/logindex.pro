@@ -0,0 +1,20 @@
+QT += testlib network widgets qml
+TEMPLATE = app
+TARGET = tst_logindex
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../../../../../gcs.pri)
+include(../../logging_dependencies.pri)
+
+INCLUDEPATH *= $$GCS_SOURCE_TREE/src/plugins \
+    $$GCS_SOURCE_TREE/src/plugins/logging
+
+# The plugins are ordinary libraries, only kept in the plugin directory
+LIBS += -L$$GCS_PLUGIN_PATH/dRonin
+unix:!macx:QMAKE_RPATHDIR += $$GCS_PLUGIN_PATH/dRonin $$GCS_LIBRARY_PATH
+
+# LogFile is not exported by the plugin, so build it in
+HEADERS += ../../logfile.h
+SOURCES += ../../logfile.cpp \
+    tst_logindex.cpp
@@ -0,0 +1,127 @@
+/**
+ ******************************************************************************
+ * @file       tst_logindex.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup LoggingPlugin Logging Plugin
+ * @{
+ * @brief Tests of the framing of the index at the end of logs
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "logfile.h"
+
+#include <QtCore/QObject>
+#include <QtTest/QtTest>
+#include <QtEndian>
+
+namespace {
+
+// As in LogFile
+const int RECORD_HEADER_LENGTH = 12;
+const int INDEX_CHUNK_LENGTH = 60000;
+const int INDEX_TRAILER_LENGTH = 16;
+
+//! Append a record as LogFile writes it
+void appendRecord(QByteArray &log, quint32 timeStamp, const QByteArray &data)
+{
+    uchar header[RECORD_HEADER_LENGTH];
+    qToLittleEndian<quint32>(timeStamp, header);
+    qToLittleEndian<qint64>(data.size(), header + sizeof(quint32));
+    log.append((const char *) header, RECORD_HEADER_LENGTH);
+    log.append(data);
+}
+
+} // namespace
+
+class tst_LogIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void trailerIsLastRecord_data();
+    void trailerIsLastRecord();
+};
+
+void tst_LogIndex::trailerIsLastRecord_data()
+{
+    QTest::addColumn<int>("payloadLength");
+
+    QTest::newRow("short") << 100;
+    QTest::newRow("one chunk") << INDEX_CHUNK_LENGTH;
+    // Ends inside what would be the trailer if it shared the last chunk
+    QTest::newRow("chunk + 1") << INDEX_CHUNK_LENGTH + 1;
+    QTest::newRow("chunk + 8") << INDEX_CHUNK_LENGTH + 8;
+    QTest::newRow("chunk + 15") << INDEX_CHUNK_LENGTH + 15;
+    QTest::newRow("chunk - 15") << INDEX_CHUNK_LENGTH - 15;
+    QTest::newRow("two chunks + 1") << 2 * INDEX_CHUNK_LENGTH + 1;
+}
+
+void tst_LogIndex::trailerIsLastRecord()
+{
+    QFETCH(int, payloadLength);
+
+    // Some telemetry ahead of the index
+    QByteArray log;
+    appendRecord(log, 0, QByteArray(40, 0x3C));
+    appendRecord(log, 10, QByteArray(1000, 0x20));
+
+    QByteArray payload(payloadLength, 0);
+    for (int i = 0; i < payloadLength; i++)
+        payload[i] = (char) (i * 7);
+
+    qint64 indexPos = log.size();
+    QVector<QByteArray> records = LogFile::indexRecords(payload, indexPos);
+    QVERIFY(records.size() >= 2);
+    foreach (const QByteArray &record, records) {
+        QVERIFY(record.size() <= INDEX_CHUNK_LENGTH);
+        appendRecord(log, 20, record);
+    }
+
+    // The trailer is the last bytes of the log, in a record of its own
+    QCOMPARE(records.last().size(), INDEX_TRAILER_LENGTH);
+    qint64 trailerSize = qFromLittleEndian<qint64>((const uchar *) log.constData() +
+            log.size() - INDEX_TRAILER_LENGTH - sizeof(qint64));
+    QCOMPARE(trailerSize, (qint64) INDEX_TRAILER_LENGTH);
+
+    qint64 parsedPos;
+    QVERIFY(LogFile::parseIndexTrailer(log.right(INDEX_TRAILER_LENGTH), parsedPos));
+    QCOMPARE(parsedPos, indexPos);
+
+    // Walking the records from there gives the payload back whole
+    qint64 trailerPos = log.size() - INDEX_TRAILER_LENGTH - RECORD_HEADER_LENGTH;
+    QByteArray gathered;
+    for (qint64 pos = parsedPos; pos < trailerPos; ) {
+        qint64 dataSize = qFromLittleEndian<qint64>((const uchar *) log.constData() + pos + sizeof(quint32));
+        QVERIFY(pos + RECORD_HEADER_LENGTH + dataSize <= trailerPos);
+        gathered.append(log.constData() + pos + RECORD_HEADER_LENGTH, dataSize);
+        pos += RECORD_HEADER_LENGTH + dataSize;
+    }
+    QCOMPARE(gathered, payload);
+
+    // Anything else at the end of a log is not a trailer
+    QVERIFY(!LogFile::parseIndexTrailer(payload.right(INDEX_TRAILER_LENGTH), parsedPos));
+}
+
+QTEST_MAIN(tst_LogIndex)
+
+#include "tst_logindex.moc"
+
+/**
+ * @}
+ * @}
+ */
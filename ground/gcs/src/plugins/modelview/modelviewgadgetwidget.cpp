@@ -40,9 +40,21 @@
 const QString ModelViewGadgetWidget::fallbackAcFilename = QString(":/modelview/models/warning_sign.obj");
 const QString ModelViewGadgetWidget::fallbackBgFilename = QString(":/modelview/models/black.jpg");
 
+// Display frame, the swap is synced to the vertical refresh, in ms
+#define REFRESH_PERIOD 16
+// Longest an attitude change is spread over, in ms
+#define MAX_SAMPLE_SPACING 250
+
+static QGLFormat vsyncFormat()
+{
+    QGLFormat format(QGL::SampleBuffers);
+    format.setSwapInterval(1);
+    return format;
+}
+
 
 ModelViewGadgetWidget::ModelViewGadgetWidget(QWidget *parent)
-    : QGLWidget(new GLC_Context(QGLFormat(QGL::SampleBuffers)), parent)
+    : QGLWidget(new GLC_Context(vsyncFormat()), parent)
     , m_Light()
     , m_World()
     , m_GlView()
@@ -52,6 +64,9 @@ ModelViewGadgetWidget::ModelViewGadgetWidget(QWidget *parent)
     , acFilename(fallbackAcFilename)
     , bgFilename(fallbackBgFilename)
     , vboEnable(false)
+    , lastArrival(0)
+    , sampleSpacing(0)
+    , lastTimestamp(0)
 {
     connect(&m_GlView, SIGNAL(updateOpenGL()), this, SLOT(updateGL()));
     setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::MinimumExpanding);
@@ -72,7 +87,11 @@ ModelViewGadgetWidget::ModelViewGadgetWidget(QWidget *parent)
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
     attState = AttitudeActual::GetInstance(objManager);
+    connect(attState, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(attitudeUpdated(UAVObject*)));
+    attitudeUpdated(attState);
+    prevAttitude = lastAttitude;
 
+    m_MotionTimer.setInterval(REFRESH_PERIOD);
     connect(&m_MotionTimer, SIGNAL(timeout()), this, SLOT(updateAttitude()));
 }
 
@@ -130,7 +149,7 @@ void ModelViewGadgetWidget::initializeGL()
     // Enable antialiasing
     glEnable(GL_MULTISAMPLE);
 
-    m_MotionTimer.start(100);
+    m_MotionTimer.start();
     setFocusPolicy(Qt::StrongFocus); // keyboard capture for camera switching
 }
 
@@ -321,17 +340,62 @@ void ModelViewGadgetWidget::keyPressEvent(QKeyEvent *e) // switch between camera
     }
 }
 
+void ModelViewGadgetWidget::showEvent(QShowEvent *e)
+{
+    QGLWidget::showEvent(e);
+    if (!m_MoverController.hasActiveMover())
+        m_MotionTimer.start();
+}
+
+void ModelViewGadgetWidget::hideEvent(QHideEvent *e)
+{
+    m_MotionTimer.stop();
+    QGLWidget::hideEvent(e);
+}
+
 //////////////////////////////////////////////////////////////////////
 // Private slots Functions
 //////////////////////////////////////////////////////////////////////
+
+/**
+ * Keep the new sample, and how far apart it was taken from the previous
+ * one. The drawn attitude starts from wherever it got to.
+ */
+void ModelViewGadgetWidget::attitudeUpdated(UAVObject *obj)
+{
+    Q_UNUSED(obj);
+
+    AttitudeActual::DataFields data = attState->getData();
+    qint64 timestamp = attState->getTimestamp();
+
+    sampleSpacing = qBound((qint64) 0, timestamp - lastTimestamp, (qint64) MAX_SAMPLE_SPACING);
+    lastTimestamp = timestamp;
+    lastArrival = UAVObject::currentTimestamp();
+
+    prevAttitude = drawnAttitude;
+    lastAttitude = QQuaternion(data.q1, data.q3, data.q2, data.q4);
+}
+
+/**
+ * Called once per display frame while shown. Draws the model slerped
+ * between the two latest samples, and only when that moved it.
+ */
 void ModelViewGadgetWidget::updateAttitude()
 {
-    AttitudeActual::DataFields data  = attState->getData(); // get attitude data
+    QQuaternion attitude = lastAttitude;
+    qint64 elapsed = UAVObject::currentTimestamp() - lastArrival;
+    if (sampleSpacing > 0 && elapsed < sampleSpacing)
+        attitude = QQuaternion::slerp(prevAttitude, lastAttitude, (qreal) elapsed / sampleSpacing);
+
+    if (attitude == drawnAttitude)
+        return;
+    drawnAttitude = attitude;
+
     GLC_StructOccurence *rootObject = m_World.rootOccurence(); // get the full 3D model
-    double x = data.q3;
-    double y = data.q2;
-    double z = data.q4;
-    double w = data.q1;
+    double x = attitude.x();
+    double y = attitude.y();
+    double z = attitude.z();
+    double w = attitude.scalar();
 
     if (w == 0.0) {
         w = 1.0;
@@ -29,6 +29,7 @@
 
 #include <QGLWidget>
 #include <QTimer>
+#include <QQuaternion>
 
 #include "glc_factory.h"
 #include "viewport/glc_viewport.h"
@@ -68,11 +69,16 @@ private:
     void wheelEvent(QWheelEvent *e);
     void keyPressEvent(QKeyEvent *e);
 
+    // Only render while shown
+    void showEvent(QShowEvent *e);
+    void hideEvent(QHideEvent *e);
+
 //////////////////////////////////////////////////////////////////////
 // Private slots Functions
 //////////////////////////////////////////////////////////////////////
 private slots:
     void updateAttitude();
+    void attitudeUpdated(UAVObject *obj);
 
 private:
     GLC_Factory *m_pFactory;
@@ -92,6 +98,15 @@ private:
     static const QString fallbackBgFilename;
 
     AttitudeActual *attState;
+
+    // The two latest attitude samples, the model is drawn moving from the
+    // first to the second over the time that separated them on the board
+    QQuaternion prevAttitude;
+    QQuaternion lastAttitude;
+    QQuaternion drawnAttitude;
+    qint64 lastArrival;
+    qint64 sampleSpacing;
+    qint64 lastTimestamp;
 };
 
 #endif /* MODELVIEWGADGETWIDGET_H_ */
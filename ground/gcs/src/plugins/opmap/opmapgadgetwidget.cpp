@@ -43,6 +43,8 @@
 #include <QDir>
 #include <QFile>
 #include <QDateTime>
+#include <QFileDialog>
+#include <QMessageBox>
 
 #include <math.h>
 
@@ -83,6 +85,10 @@ const int uav_trail_distance_list[] = {1, 2, 5, 10, 20, 50, 100, 200, 500};
 
 const int max_update_rate_list[] = {100, 200, 500, 1000, 2000, 5000};                   // milliseconds
 
+const int prefetch_lookahead_list[] = {15, 30, 60};                                      // seconds
+
+#define prefetch_interval   5000    // milliseconds between prefetches of the tiles ahead
+
 // *************************************************************************************
 
 
@@ -387,6 +393,8 @@ void OPMapGadgetWidget::contextMenuEvent(QContextMenuEvent *event)
     contextMenu.addAction(reloadAct);
     contextMenu.addSeparator();
     contextMenu.addAction(ripAct);
+    contextMenu.addAction(importMapPackAct);
+    contextMenu.addAction(exportMapPackAct);
     contextMenu.addSeparator();
 
     QMenu maxUpdateRateSubMenu(tr("&Max Update Rate ") + "(" + QString::number(m_maxUpdateRate) + " ms)", this);
@@ -654,6 +662,31 @@ void OPMapGadgetWidget::updatePosition()
     }
     m_map->UAV->updateTextOverlay();
     m_map->UAV->update();
+
+	// *************
+	// load the tiles where the UAV is heading in the background, so they are
+	// there before the map shows them. The waypoints are added by the map.
+
+    if (!m_prefetchTimer.isValid() || m_prefetchTimer.elapsed() >= prefetch_interval)
+    {
+        m_prefetchTimer.start();
+
+        QList<internals::PointLatLng> positions;
+        positions << uav_pos;
+
+        double homeLLA[3] = {uav_pos.Lat(), uav_pos.Lng(), uav_altitude};
+        int lookahead_count = sizeof(prefetch_lookahead_list) / sizeof(prefetch_lookahead_list[0]);
+        for (int i = 0; i < lookahead_count; i++)
+        {
+            double t = prefetch_lookahead_list[i];
+            double aheadNED[3] = {vNED[0] * t, vNED[1] * t, 0};
+            double aheadLLA[3];
+            Utils::CoordinateConversions().NED2LLA_HomeLLA(homeLLA, aheadNED, aheadLLA);
+            positions << internals::PointLatLng(aheadLLA[0], aheadLLA[1]);
+        }
+
+        m_map->PrefetchTiles(positions);
+    }
 	// *************
 }
 
@@ -1254,6 +1287,14 @@ void OPMapGadgetWidget::createActions()
     ripAct->setStatusTip(tr("Rip the map tiles"));
     connect(ripAct, SIGNAL(triggered()), this, SLOT(onRipAct_triggered()));
 
+    importMapPackAct = new QAction(tr("&Import map pack..."), this);
+    importMapPackAct->setStatusTip(tr("Add the tiles of a map pack to the cache, for use without a connection"));
+    connect(importMapPackAct, SIGNAL(triggered()), this, SLOT(onImportMapPackAct_triggered()));
+
+    exportMapPackAct = new QAction(tr("&Export map pack..."), this);
+    exportMapPackAct->setStatusTip(tr("Save the tiles of the cache to a map pack, ripped areas included"));
+    connect(exportMapPackAct, SIGNAL(triggered()), this, SLOT(onExportMapPackAct_triggered()));
+
     copyMouseLatLonToClipAct = new QAction(tr("Mouse latitude and longitude"), this);
     copyMouseLatLonToClipAct->setStatusTip(tr("Copy the mouse latitude and longitude to the clipboard"));
     connect(copyMouseLatLonToClipAct, SIGNAL(triggered()), this, SLOT(onCopyMouseLatLonToClipAct_triggered()));
@@ -1546,6 +1587,34 @@ void OPMapGadgetWidget::onRipAct_triggered()
     m_map->RipMap();
 }
 
+void OPMapGadgetWidget::onImportMapPackAct_triggered()
+{
+	if (!m_widget || !m_map)
+		return;
+
+    QString file = QFileDialog::getOpenFileName(this, tr("Import map pack"), QString(), tr("Map packs (*.qmdb)"));
+    if (file.isEmpty())
+        return;
+
+    if (!m_map->ImportMapPack(file))
+        QMessageBox::warning(this, tr("Import map pack"), tr("Could not import the map pack %1").arg(file));
+    else
+        m_map->ReloadMap();
+}
+
+void OPMapGadgetWidget::onExportMapPackAct_triggered()
+{
+	if (!m_widget || !m_map)
+		return;
+
+    QString file = QFileDialog::getSaveFileName(this, tr("Export map pack"), QString(), tr("Map packs (*.qmdb)"));
+    if (file.isEmpty())
+        return;
+
+    if (!m_map->ExportMapPack(file))
+        QMessageBox::warning(this, tr("Export map pack"), tr("Could not export the map cache to %1").arg(file));
+}
+
 void OPMapGadgetWidget::onCopyMouseLatLonToClipAct_triggered()
 {
     QClipboard *clipboard = QApplication::clipboard();
@@ -45,6 +45,7 @@
 #include <QStandardItemModel>
 #include <QList>
 #include <QPointF>
+#include <QElapsedTimer>
 
 #include "tlmapcontrol/tlmapcontrol.h"
 
@@ -178,6 +179,8 @@ private slots:
     */
     void onReloadAct_triggered();
     void onRipAct_triggered();
+    void onImportMapPackAct_triggered();
+    void onExportMapPackAct_triggered();
     void onCopyMouseLatLonToClipAct_triggered();
     void onCopyMouseLatToClipAct_triggered();
     void onCopyMouseLonToClipAct_triggered();
@@ -239,6 +242,7 @@ private:
     QCompleter *findPlaceCompleter;
     QTimer *m_updateTimer;
     QTimer *m_statusUpdateTimer;
+    QElapsedTimer m_prefetchTimer;
     Ui::OPMap_Widget *m_widget;
     mapcontrol::TLMapWidget *m_map;
 	ExtensionSystem::PluginManager *pm;
@@ -252,6 +256,8 @@ private:
     QAction *closeAct2;
     QAction *reloadAct;
     QAction *ripAct;
+    QAction *importMapPackAct;
+    QAction *exportMapPackAct;
 	QAction *copyMouseLatLonToClipAct;
     QAction *copyMouseLatToClipAct;
     QAction *copyMouseLonToClipAct;
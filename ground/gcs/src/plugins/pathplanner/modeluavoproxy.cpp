@@ -99,7 +99,8 @@ bool ModelUavoProxy::modelToObjects()
         }
 
         Q_ASSERT(wp);
-        Waypoint::DataFields waypoint = wp->getData();
+        const Waypoint::DataFields current = wp->getData();
+        Waypoint::DataFields waypoint = current;
 
         // Convert from LLA to NED for sending to the model
         LLA[0] = myModel->data(myModel->index(x,FlightDataModel::LATPOSITION)).toDouble();
@@ -115,6 +116,12 @@ bool ModelUavoProxy::modelToObjects()
         waypoint.Mode = myModel->data(myModel->index(x,FlightDataModel::MODE), Qt::UserRole).toInt();
         waypoint.ModeParameters = myModel->data(myModel->index(x,FlightDataModel::MODE_PARAMS)).toFloat();
 
+        // Editing a plan usually moves a point or two; only send those
+        if (!newInstance && sameWaypoint(current, waypoint)) {
+            emit sendPathPlanToUavProgress(100 * (x + 1) / progressMax);
+            continue;
+        }
+
         if (robustUpdate(waypoint, x)) {
             qDebug() << "Successfully updated";
             emit sendPathPlanToUavProgress(100 * (x + 1) / progressMax);
@@ -123,12 +130,6 @@ bool ModelUavoProxy::modelToObjects()
             emit sendPathPlanToUavProgress(100 * (x + 1) / progressMax);
             return false;
         }
-        if(newInstance)
-        {
-            QEventLoop m_eventloop;
-            QTimer::singleShot(800, &m_eventloop, SLOT(quit()));
-            m_eventloop.exec();
-        }
     }
 
     /* Continue iterating over any instance indices that aren't needed to
@@ -139,6 +140,11 @@ bool ModelUavoProxy::modelToObjects()
         
         Waypoint::DataFields waypoint = wp->getData();
 
+        if (waypoint.Mode == Waypoint::MODE_INVALID) {
+            emit sendPathPlanToUavProgress(100 * (x + 1) / progressMax);
+            continue;
+        }
+
         waypoint.Mode = Waypoint::MODE_INVALID;
         if (robustUpdate(waypoint, x)) {
             qDebug() << "Successfully updated";
@@ -154,6 +160,22 @@ bool ModelUavoProxy::modelToObjects()
     return true;
 }
 
+/**
+ * @brief sameWaypoint Compare a waypoint as we have it with what we would send.
+ * The positions come back through LLA and so are only compared to a millimetre.
+ * @return True if there is no need to send it again
+ */
+bool ModelUavoProxy::sameWaypoint(const Waypoint::DataFields &a, const Waypoint::DataFields &b)
+{
+    for (int i = 0; i < Waypoint::POSITION_NUMELEM; i++) {
+        if (fabs(a.Position[i] - b.Position[i]) > 1e-3)
+            return false;
+    }
+
+    return a.Velocity == b.Velocity && a.Mode == b.Mode &&
+            a.ModeParameters == b.ModeParameters;
+}
+
 /**
  * @brief robustUpdate Upload a waypoint and check for an ACK or retry.
  * @param data The data to set
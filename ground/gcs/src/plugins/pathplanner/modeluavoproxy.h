@@ -41,6 +41,9 @@ private:
     //! Robustly upload a waypoint (like smart save)
     bool robustUpdate(Waypoint::DataFields data, int instance);
 
+    //! Whether a waypoint would be unchanged by uploading it again
+    static bool sameWaypoint(const Waypoint::DataFields &a, const Waypoint::DataFields &b);
+
     //! Fetch the home LLA position
     bool getHomeLocation(double *homeLLA);
 
@@ -0,0 +1,117 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pfdqmlflightstate.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup PfdQmlPlugin QML PFD Plugin
+ * @{
+ * @brief The fast changing flight state, handed to the PFD once per frame
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "pfdqmlflightstate.h"
+#include "uavobjectmanager.h"
+#include "attitudeactual.h"
+#include "positionactual.h"
+#include "velocityactual.h"
+#include "airspeedactual.h"
+#include "magnetometer.h"
+#include <string.h>
+
+// Display frame the updates are coalesced over, in ms
+#define REFRESH_PERIOD 16
+
+PfdQmlFlightState::PfdQmlFlightState(UAVObjectManager *objManager, QObject *parent) :
+    QObject(parent),
+    m_objManager(objManager)
+{
+    memset(&state, 0, sizeof(state));
+
+    refreshTimer.setSingleShot(true);
+    refreshTimer.setInterval(REFRESH_PERIOD);
+    connect(&refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+
+    watch(AttitudeActual::GetInstance(m_objManager));
+    watch(PositionActual::GetInstance(m_objManager));
+    watch(VelocityActual::GetInstance(m_objManager));
+    watch(AirspeedActual::GetInstance(m_objManager));
+    watch(Magnetometer::GetInstance(m_objManager));
+
+    refresh();
+}
+
+void PfdQmlFlightState::watch(UAVObject *obj)
+{
+    Q_ASSERT(obj);
+    if (obj)
+        connect(obj, SIGNAL(objectUpdatedCoalesced(UAVObject*, quint64)), this, SLOT(scheduleRefresh()));
+}
+
+/**
+ * @brief PfdQmlFlightState::scheduleRefresh Called at most once a frame for
+ * each watched object that changed, only the first one starts the timer
+ */
+void PfdQmlFlightState::scheduleRefresh()
+{
+    if (!refreshTimer.isActive())
+        refreshTimer.start();
+}
+
+/**
+ * @brief PfdQmlFlightState::refresh Read all the watched objects at once and
+ * notify the bindings, if anything they show changed
+ */
+void PfdQmlFlightState::refresh()
+{
+    FlightState latest;
+
+    AttitudeActual::DataFields attitude = AttitudeActual::GetInstance(m_objManager)->getData();
+    latest.roll = attitude.Roll;
+    latest.pitch = attitude.Pitch;
+    latest.yaw = attitude.Yaw;
+
+    PositionActual::DataFields position = PositionActual::GetInstance(m_objManager)->getData();
+    latest.north = position.North;
+    latest.east = position.East;
+    latest.down = position.Down;
+
+    VelocityActual::DataFields velocity = VelocityActual::GetInstance(m_objManager)->getData();
+    latest.velocityNorth = velocity.North;
+    latest.velocityEast = velocity.East;
+    latest.velocityDown = velocity.Down;
+
+    AirspeedActual::DataFields airspeed = AirspeedActual::GetInstance(m_objManager)->getData();
+    latest.calibratedAirspeed = airspeed.CalibratedAirspeed;
+    latest.trueAirspeed = airspeed.TrueAirspeed;
+
+    Magnetometer::DataFields mag = Magnetometer::GetInstance(m_objManager)->getData();
+    latest.magX = mag.x;
+    latest.magY = mag.y;
+    latest.magZ = mag.z;
+
+    if (memcmp(&latest, &state, sizeof(state)) == 0)
+        return;
+
+    state = latest;
+    emit changed();
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,117 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pfdqmlflightstate.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup PfdQmlPlugin QML PFD Plugin
+ * @{
+ * @brief The fast changing flight state, handed to the PFD once per frame
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PFDQMLFLIGHTSTATE_H_
+#define PFDQMLFLIGHTSTATE_H_
+
+#include <QObject>
+#include <QTimer>
+
+class UAVObject;
+class UAVObjectManager;
+
+/**
+ * @brief The PfdQmlFlightState class Gathers the objects that update at
+ * telemetry rate (attitude, position, velocity, airspeed and magnetometer)
+ * into one set of typed properties. Their updates are coalesced and the
+ * properties refreshed at most once per display frame, with a single
+ * notification, however many packets came in meanwhile.
+ */
+class PfdQmlFlightState : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(qreal roll READ roll NOTIFY changed)
+    Q_PROPERTY(qreal pitch READ pitch NOTIFY changed)
+    Q_PROPERTY(qreal yaw READ yaw NOTIFY changed)
+    Q_PROPERTY(qreal north READ north NOTIFY changed)
+    Q_PROPERTY(qreal east READ east NOTIFY changed)
+    Q_PROPERTY(qreal down READ down NOTIFY changed)
+    Q_PROPERTY(qreal velocityNorth READ velocityNorth NOTIFY changed)
+    Q_PROPERTY(qreal velocityEast READ velocityEast NOTIFY changed)
+    Q_PROPERTY(qreal velocityDown READ velocityDown NOTIFY changed)
+    Q_PROPERTY(qreal calibratedAirspeed READ calibratedAirspeed NOTIFY changed)
+    Q_PROPERTY(qreal trueAirspeed READ trueAirspeed NOTIFY changed)
+    Q_PROPERTY(qreal magX READ magX NOTIFY changed)
+    Q_PROPERTY(qreal magY READ magY NOTIFY changed)
+    Q_PROPERTY(qreal magZ READ magZ NOTIFY changed)
+
+public:
+    PfdQmlFlightState(UAVObjectManager *objManager, QObject *parent = 0);
+
+    qreal roll() const { return state.roll; }
+    qreal pitch() const { return state.pitch; }
+    qreal yaw() const { return state.yaw; }
+    qreal north() const { return state.north; }
+    qreal east() const { return state.east; }
+    qreal down() const { return state.down; }
+    qreal velocityNorth() const { return state.velocityNorth; }
+    qreal velocityEast() const { return state.velocityEast; }
+    qreal velocityDown() const { return state.velocityDown; }
+    qreal calibratedAirspeed() const { return state.calibratedAirspeed; }
+    qreal trueAirspeed() const { return state.trueAirspeed; }
+    qreal magX() const { return state.magX; }
+    qreal magY() const { return state.magY; }
+    qreal magZ() const { return state.magZ; }
+
+signals:
+    void changed();
+
+private slots:
+    void scheduleRefresh();
+    void refresh();
+
+private:
+    struct FlightState {
+        float roll;
+        float pitch;
+        float yaw;
+        float north;
+        float east;
+        float down;
+        float velocityNorth;
+        float velocityEast;
+        float velocityDown;
+        float calibratedAirspeed;
+        float trueAirspeed;
+        float magX;
+        float magY;
+        float magZ;
+    };
+
+    void watch(UAVObject *obj);
+
+    UAVObjectManager *m_objManager;
+    FlightState state;
+    QTimer refreshTimer;
+};
+
+#endif /* PFDQMLFLIGHTSTATE_H_ */
+
+/**
+ * @}
+ * @}
+ */
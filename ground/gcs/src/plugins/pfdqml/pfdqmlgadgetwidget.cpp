@@ -27,6 +27,7 @@
 #include <QQmlEngine>
 #include <QQmlContext>
 #include "stabilizationdesired.h"
+#include "pfdqmlflightstate.h"
 
 PfdQmlGadgetWidget::PfdQmlGadgetWidget(QWindow *parent) :
     QQuickView(parent)
@@ -57,6 +58,9 @@ PfdQmlGadgetWidget::PfdQmlGadgetWidget(QWindow *parent) :
         exportUAVOInstance(objectName, 0);
     }
 
+    // The objects updating at telemetry rate, refreshed once per frame
+    engine()->rootContext()->setContextProperty("FlightState", new PfdQmlFlightState(m_objManager, this));
+
     //to expose settings values
     engine()->rootContext()->setContextProperty("qmlWidget", this);
 }
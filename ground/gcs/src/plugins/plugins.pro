@@ -154,6 +154,7 @@ plugin_telemetryscheduler.subdir = telemetryscheduler
 plugin_telemetryscheduler.depends = plugin_coreplugin
 plugin_telemetryscheduler.depends += plugin_uavobjects
 plugin_telemetryscheduler.depends += plugin_uavobjectutil
+plugin_telemetryscheduler.depends += plugin_uavtalk
 SUBDIRS += plugin_telemetryscheduler
 
 # Primary Flight Display (PFD) gadget, QML version
@@ -237,6 +238,7 @@ plugin_uavsettingsimportexport.subdir = uavsettingsimportexport
 plugin_uavsettingsimportexport.depends = plugin_coreplugin
 plugin_uavsettingsimportexport.depends += plugin_uavobjects
 plugin_uavsettingsimportexport.depends += plugin_uavobjectutil
+plugin_uavsettingsimportexport.depends += plugin_uavtalk
 SUBDIRS += plugin_uavsettingsimportexport
 
 # UAV Object Widget Utility plugin
@@ -34,6 +34,7 @@
 #include <QtGlobal>
 #include <QList>
 #include <QMutexLocker>
+#include <QElapsedTimer>
 
 class IConnection;
 
@@ -41,13 +42,19 @@ class IConnection;
 static const int READ_TIMEOUT = 200;
 static const int READ_SIZE = 64;
 
+// Reports gathered into one batch before it is handed on
+static const int READ_BATCH_REPORTS = 16;
+// Time a batch is held open for more reports, in ms
+static const int READ_BATCH_WINDOW = 1;
+
 static const int WRITE_SIZE = 64;
 
 static const int WRITE_RETRIES = 10;
 
 RawHIDReadThread::RawHIDReadThread(hid_device *handle)
     : m_handle(handle),
-      m_running(true)
+      m_running(true),
+      m_directFeed(0)
 {
 }
 
@@ -63,41 +70,75 @@ RawHIDReadThread::~RawHIDReadThread()
 
 void RawHIDReadThread::run()
 {
+    //here we gather the reports in a local batch so we don't need to lock
+    //the mutex while we are reading from the device
+    QByteArray batch;
+    batch.reserve(READ_BATCH_REPORTS * READ_SIZE);
+    int reports = 0;
+    QElapsedTimer window;
+
     while(m_running)
     {
-        //here we use a temporary buffer so we don't need to lock
-        //the mutex while we are reading from the device
-
         // Want to read in regular chunks that match the packet size the device
         // is using.  In this case it is 64 bytes (the interrupt packet limit)
         // although it would be nice if the device had a different report to
         // configure this
         unsigned char buffer[READ_SIZE] = {0};
 
-        int ret = hid_read_timeout(m_handle, buffer, READ_SIZE, READ_TIMEOUT);
+        // Block for the first report of a batch, then only take what
+        // arrives within the batch window
+        int timeout = READ_TIMEOUT;
+        if (reports > 0)
+            timeout = qMax(READ_BATCH_WINDOW - (int) window.elapsed(), 0);
+
+        int ret = hid_read_timeout(m_handle, buffer, READ_SIZE, timeout);
 
         if(ret > 0) //read some data
         {
-            QMutexLocker lock(&m_readBufMtx);
-
-            bool needSignal = m_readBuffer.size() == 0;
+            if (reports++ == 0)
+                window.start();
 
             // Note: Preprocess the USB packets in this OS independent code
             // First byte is report ID, second byte is the number of valid bytes
-            m_readBuffer.append((char *) &buffer[2], buffer[1]);
+            batch.append((char *) &buffer[2], qMin((int) buffer[1], READ_SIZE - 2));
 
-            if (needSignal) {
-                emit readyToRead();
-            }
-        }
-        else if(ret == 0) //nothing read
-        {
+            if (reports < READ_BATCH_REPORTS && window.elapsed() < READ_BATCH_WINDOW)
+                continue;
         }
-        else // < 0 => error
+        else if(ret < 0) // < 0 => error
         {
             // This thread exiting on error is OK/sane.
             m_running=false;
         }
+
+        // Batch full, window over, or nothing more came in
+        if (reports > 0) {
+            if (batch.size() > 0)
+                deliver(batch);
+            batch.clear();
+            reports = 0;
+        }
+    }
+}
+
+/**
+ * Hand a batch of reports on, with a single lock and at most one signal
+ */
+void RawHIDReadThread::deliver(const QByteArray &batch)
+{
+    if (m_directFeed.loadAcquire()) {
+        emit dataRead(batch);
+        return;
+    }
+
+    QMutexLocker lock(&m_readBufMtx);
+
+    bool needSignal = m_readBuffer.size() == 0;
+
+    m_readBuffer.append(batch);
+
+    if (needSignal) {
+        emit readyToRead();
     }
 }
 
@@ -238,7 +279,8 @@ RawHID::RawHID(USBDevice *deviceStructure)
     :QIODevice(),
     m_deviceInfo(deviceStructure),
     m_readThread(NULL),
-    m_writeThread(NULL)
+    m_writeThread(NULL),
+    m_directFeed(false)
 {
 }
 
@@ -266,6 +308,9 @@ bool RawHID::open(OpenMode mode)
 
         // Plumb through read thread's ready read signal to our clients
         connect(m_readThread, SIGNAL(readyToRead()), this, SLOT(sendReadyRead()));
+        // The batches for a direct consumer stay on the read thread
+        connect(m_readThread, SIGNAL(dataRead(QByteArray)), this, SIGNAL(dataReceived(QByteArray)), Qt::DirectConnection);
+        m_readThread->setDirectFeed(m_directFeed);
 
         m_readThread->start();
         m_writeThread->start();
@@ -282,6 +327,25 @@ void RawHID::sendReadyRead()
     emit readyRead();
 }
 
+void RawHID::connectNotify(const QMetaMethod &signal)
+{
+    if (signal == QMetaMethod::fromSignal(&RawHID::dataReceived)) {
+        m_directFeed = true;
+        if (m_readThread)
+            m_readThread->setDirectFeed(true);
+    }
+}
+
+void RawHID::disconnectNotify(const QMetaMethod &signal)
+{
+    if (signal == QMetaMethod::fromSignal(&RawHID::dataReceived) &&
+            !isSignalConnected(signal)) {
+        m_directFeed = false;
+        if (m_readThread)
+            m_readThread->setDirectFeed(false);
+    }
+}
+
 void RawHID::close()
 {
     if (!isOpen())
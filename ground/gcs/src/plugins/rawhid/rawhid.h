@@ -30,8 +30,10 @@
 
 #include "rawhid_global.h"
 
+#include <QAtomicInt>
 #include <QByteArray>
 #include <QIODevice>
+#include <QMetaMethod>
 #include <QMutex>
 #include <QThread>
 #include <QWaitCondition>
@@ -68,11 +70,18 @@ public:
 
     void stop() { m_running = false; }
 
+    /** Hand batches straight to dataRead() instead of buffering them */
+    void setDirectFeed(bool direct) { m_directFeed.storeRelease(direct); }
+
 signals:
     void readyToRead();
 
+    /** Emitted from this thread, only in direct feed mode */
+    void dataRead(const QByteArray &data);
+
 protected:
     void run();
+    void deliver(const QByteArray &batch);
 
     /** QByteArray might not be the most efficient way to implement
     a circular buffer but it's good enough and very simple */
@@ -84,6 +93,8 @@ protected:
     hid_device *m_handle;
 
     bool m_running;
+
+    QAtomicInt m_directFeed;
 };
 
 
@@ -145,10 +156,21 @@ public:
     virtual void close();
     virtual bool isSequential() const;
 
+signals:
+    /**
+     * Emitted from the read thread with every batch of reports, for a
+     * consumer that parses off the GUI thread.  While anything is connected
+     * the data skip the read buffer and readyRead() is not emitted.  The
+     * connection must be a direct one.
+     */
+    void dataReceived(const QByteArray &data);
+
 private slots:
     void sendReadyRead();
 
 protected:
+    virtual void connectNotify(const QMetaMethod &signal);
+    virtual void disconnectNotify(const QMetaMethod &signal);
     virtual qint64 readData(char *data, qint64 maxSize);
     virtual qint64 writeData(const char *data, qint64 maxSize);
     virtual qint64 bytesAvailable() const;
@@ -159,6 +181,8 @@ protected:
 
     RawHIDReadThread *m_readThread;
     RawHIDWriteThread *m_writeThread;
+
+    bool m_directFeed;
 };
 
 #endif // RAWHID_H
@@ -8,7 +8,7 @@
  * @{
  * @addtogroup RawHIDPlugin Raw HID Plugin
  * @{
- * @brief Implements the USB monitor on Mac using XXXXX
+ * @brief Keeps the table of USB HID devices, refreshed on hotplug events
  *****************************************************************************/
 /*
  * This program is free software; you can redistribute it and/or modify
@@ -35,6 +35,20 @@
 
 #include "rawhid.h"
 
+#ifdef Q_OS_LINUX
+#include <QSocketNotifier>
+#include <libudev.h>
+#endif
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <dbt.h>
+#endif
+#ifdef Q_OS_MAC
+#include <CoreFoundation/CoreFoundation.h>
+#include <IOKit/IOKitLib.h>
+#include <IOKit/hid/IOHIDKeys.h>
+#endif
+
 
 //#define USB_MON_DEBUG
 #ifdef USB_MON_DEBUG
@@ -45,6 +59,11 @@
 
 #define printf USB_MON_QXTLOG_DEBUG
 
+// Polling period when the OS gives no hotplug notifications, in ms
+#define POLL_PERIOD 150
+// Time for the HID node to show up after the USB device did, in ms
+#define HOTPLUG_SETTLE 50
+
 USBMonitor *USBMonitor::m_instance = 0;
 
 /**
@@ -57,19 +76,203 @@ USBMonitor::USBMonitor(QObject *parent) : QObject(parent) {
 
     hid_init();
 
-    connect(&periodicTimer, SIGNAL(timeout()), this, SLOT(periodic()));
-    periodicTimer.setSingleShot(true);
-    periodicTimer.start(150);
-
     enumerating = false;
+    cacheValid = false;
     prevDevList = NULL;
+
+    notifications = setUpNotifications();
+    if (!notifications)
+        qDebug() << "usbmonitor: no hotplug notifications, polling";
+
+    connect(&periodicTimer, SIGNAL(timeout()), this, SLOT(periodic()));
+    periodicTimer.setSingleShot(true);
+    periodicTimer.start(POLL_PERIOD);
 }
 
 USBMonitor::~USBMonitor()
 {
+    tearDownNotifications();
     hid_free_enumeration(prevDevList);
 }
 
+void USBMonitor::hotplugEvent()
+{
+    cacheValid = false;
+    if (!periodicTimer.isActive())
+        periodicTimer.start(HOTPLUG_SETTLE);
+}
+
+#ifdef Q_OS_LINUX
+
+bool USBMonitor::setUpNotifications()
+{
+    udevNotifier = NULL;
+    udevMonitor = NULL;
+    udevContext = udev_new();
+    if (!udevContext)
+        return false;
+
+    udevMonitor = udev_monitor_new_from_netlink(udevContext, "udev");
+    if (!udevMonitor ||
+            udev_monitor_filter_add_match_subsystem_devtype(udevMonitor, "hidraw", NULL) < 0 ||
+            udev_monitor_enable_receiving(udevMonitor) < 0) {
+        tearDownNotifications();
+        return false;
+    }
+
+    udevNotifier = new QSocketNotifier(udev_monitor_get_fd(udevMonitor), QSocketNotifier::Read, this);
+    connect(udevNotifier, SIGNAL(activated(int)), this, SLOT(udevEvent()));
+
+    return true;
+}
+
+void USBMonitor::tearDownNotifications()
+{
+    delete udevNotifier;
+    udevNotifier = NULL;
+    if (udevMonitor)
+        udev_monitor_unref(udevMonitor);
+    udevMonitor = NULL;
+    if (udevContext)
+        udev_unref(udevContext);
+    udevContext = NULL;
+}
+
+void USBMonitor::udevEvent()
+{
+    struct udev_device *dev;
+
+    while ((dev = udev_monitor_receive_device(udevMonitor)) != NULL)
+        udev_device_unref(dev);
+
+    hotplugEvent();
+}
+
+#elif defined(Q_OS_WIN)
+
+static LRESULT CALLBACK notifyWindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+    if (msg == WM_DEVICECHANGE &&
+            (wParam == DBT_DEVICEARRIVAL || wParam == DBT_DEVICEREMOVECOMPLETE) &&
+            USBMonitor::instance())
+        USBMonitor::instance()->hotplugEvent();
+
+    return DefWindowProc(hwnd, msg, wParam, lParam);
+}
+
+/**
+  A message only window receives the device notifications, Qt's event
+  loop dispatches them to it
+  */
+bool USBMonitor::setUpNotifications()
+{
+    notifyHandle = NULL;
+
+    WNDCLASSEX wc;
+    memset(&wc, 0, sizeof(wc));
+    wc.cbSize = sizeof(wc);
+    wc.lpfnWndProc = notifyWindowProc;
+    wc.hInstance = GetModuleHandle(NULL);
+    wc.lpszClassName = TEXT("dRoninUSBMonitor");
+    RegisterClassEx(&wc);
+
+    HWND hwnd = CreateWindowEx(0, wc.lpszClassName, NULL, 0, 0, 0, 0, 0, HWND_MESSAGE, NULL, wc.hInstance, NULL);
+    notifyWindow = hwnd;
+    if (!hwnd)
+        return false;
+
+    DEV_BROADCAST_DEVICEINTERFACE filter;
+    memset(&filter, 0, sizeof(filter));
+    filter.dbcc_size = sizeof(filter);
+    filter.dbcc_devicetype = DBT_DEVTYP_DEVICEINTERFACE;
+
+    notifyHandle = RegisterDeviceNotification(hwnd, &filter,
+            DEVICE_NOTIFY_WINDOW_HANDLE | DEVICE_NOTIFY_ALL_INTERFACE_CLASSES);
+    if (!notifyHandle) {
+        tearDownNotifications();
+        return false;
+    }
+
+    return true;
+}
+
+void USBMonitor::tearDownNotifications()
+{
+    if (notifyHandle)
+        UnregisterDeviceNotification((HDEVNOTIFY) notifyHandle);
+    notifyHandle = NULL;
+    if (notifyWindow)
+        DestroyWindow((HWND) notifyWindow);
+    notifyWindow = NULL;
+}
+
+#elif defined(Q_OS_MAC)
+
+/**
+  The iterators must be drained for the notifications to be armed again
+  */
+static void ioServiceCallback(void *refcon, io_iterator_t iterator)
+{
+    io_object_t service;
+
+    while ((service = IOIteratorNext(iterator)) != 0)
+        IOObjectRelease(service);
+
+    static_cast<USBMonitor *>(refcon)->hotplugEvent();
+}
+
+bool USBMonitor::setUpNotifications()
+{
+    addedIter = 0;
+    removedIter = 0;
+    notifyPort = IONotificationPortCreate(kIOMasterPortDefault);
+    if (!notifyPort)
+        return false;
+
+    CFRunLoopAddSource(CFRunLoopGetMain(), IONotificationPortGetRunLoopSource(notifyPort), kCFRunLoopDefaultMode);
+
+    // Each call consumes a reference to the matching dictionary
+    if (IOServiceAddMatchingNotification(notifyPort, kIOFirstMatchNotification,
+                IOServiceMatching(kIOHIDDeviceKey), ioServiceCallback, this, &addedIter) != KERN_SUCCESS ||
+            IOServiceAddMatchingNotification(notifyPort, kIOTerminatedNotification,
+                IOServiceMatching(kIOHIDDeviceKey), ioServiceCallback, this, &removedIter) != KERN_SUCCESS) {
+        tearDownNotifications();
+        return false;
+    }
+
+    // Arm them, the devices present now are enumerated anyway
+    ioServiceCallback(this, addedIter);
+    ioServiceCallback(this, removedIter);
+
+    return true;
+}
+
+void USBMonitor::tearDownNotifications()
+{
+    if (addedIter)
+        IOObjectRelease(addedIter);
+    addedIter = 0;
+    if (removedIter)
+        IOObjectRelease(removedIter);
+    removedIter = 0;
+    if (notifyPort)
+        IONotificationPortDestroy(notifyPort);
+    notifyPort = NULL;
+}
+
+#else
+
+bool USBMonitor::setUpNotifications()
+{
+    return false;
+}
+
+void USBMonitor::tearDownNotifications()
+{
+}
+
+#endif
+
 void USBMonitor::periodic() {
     // This is here to catch recursion, from the process_pending_events in
     // hidapi on OS X.
@@ -78,6 +281,7 @@ void USBMonitor::periodic() {
     }
 
     enumerating = true;
+    cacheValid = notifications;
 
     struct hid_device_info *hidDevList = hid_enumerate(0, 0, prevDevList);
 
@@ -135,12 +339,14 @@ void USBMonitor::periodic() {
     }
 
     /* Ensure our signals are spaced out.  Also limit our CPU consumption */
-    periodicTimer.start(150);
+    if (!notifications)
+        periodicTimer.start(POLL_PERIOD);
 }
 
 QList<USBPortInfo> USBMonitor::availableDevices()
 {
-    periodic();
+    if (!cacheValid)
+        periodic();
     return knowndevices;
 }
 
@@ -157,7 +363,8 @@ QList<USBPortInfo> USBMonitor::availableDevices()
   */
 QList<USBPortInfo> USBMonitor::availableDevices(int vid, int pid, int bcdDeviceMSB, int bcdDeviceLSB)
 {
-    periodic();
+    if (!cacheValid)
+        periodic();
 
     QList<USBPortInfo> thePortsWeWant;
 
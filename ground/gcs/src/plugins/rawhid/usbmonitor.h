@@ -39,6 +39,15 @@
 
 #include <QTimer>
 
+#ifdef Q_OS_LINUX
+class QSocketNotifier;
+struct udev;
+struct udev_monitor;
+#endif
+#ifdef Q_OS_MAC
+struct IONotificationPort;
+#endif
+
 struct USBPortInfo {
     QString serialNumber; // As a string as it can be anything, really...
     QString manufacturer;
@@ -102,24 +111,34 @@ signals:
     /*!
       A new device has been connected to the system.
 
-      setUpNotifications() must be called first to enable event-driven device notifications.
-      Currently only implemented on Windows and OS X.
+      Event driven where the OS offers hotplug notifications (udev, device
+      notifications on Windows, IOKit on OS X), polled otherwise.
       \param info The device that has been discovered.
     */
     void deviceDiscovered( const USBPortInfo &info );
     /*!
       A device has been disconnected from the system.
 
-      setUpNotifications() must be called first to enable event-driven device notifications.
-      Currently only implemented on Windows and OS X.
+      Event driven where the OS offers hotplug notifications, polled
+      otherwise.
       \param info The device that was disconnected.
     */
     void deviceRemoved( const USBPortInfo &info );
 
+public slots:
+    //! Something changed on the bus, enumerate again once it settles
+    void hotplugEvent();
+
 private slots:
     void periodic();
+#ifdef Q_OS_LINUX
+    void udevEvent();
+#endif
 
 private:
+    bool setUpNotifications();
+    void tearDownNotifications();
+
     //! List of known devices maintained by callbacks
     QList<USBPortInfo> knowndevices;
 
@@ -131,5 +150,25 @@ private:
     struct hid_device_info *prevDevList;
 
     bool enumerating;
+
+    //! The OS tells us about hotplug, so there's no need to poll
+    bool notifications;
+    //! knowndevices is current, nothing was plugged since the last cycle
+    bool cacheValid;
+
+#ifdef Q_OS_LINUX
+    struct udev *udevContext;
+    struct udev_monitor *udevMonitor;
+    QSocketNotifier *udevNotifier;
+#endif
+#ifdef Q_OS_WIN
+    void *notifyWindow;
+    void *notifyHandle;
+#endif
+#ifdef Q_OS_MAC
+    struct IONotificationPort *notifyPort;
+    unsigned int addedIter;
+    unsigned int removedIter;
+#endif
 };
 #endif // USBMONITOR_H
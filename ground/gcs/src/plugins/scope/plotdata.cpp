@@ -71,6 +71,10 @@ Plot2dData::Plot2dData(QString p_uavObject, QString p_uavFieldName):
     yMaximum = 120;
 
     m_xWindowSize = 0;
+
+    boundObject = NULL;
+    boundField = NULL;
+    boundElement = 0;
 }
 
 
@@ -100,8 +104,6 @@ Plot3dData::Plot3dData(QString p_uavObject, QString p_uavFieldName):
     xData = new QVector<double>();
     yData = new QVector<double>();
     zData = new QVector<double>();
-    zDataHistory = new QVector<double>();
-    timeDataHistory = new QVector<double>();
 
     scalePower = 0;
     meanSamples = 1;
@@ -114,6 +116,10 @@ Plot3dData::Plot3dData(QString p_uavObject, QString p_uavFieldName):
     yMaximum = 60;
     zMinimum = 0;
     zMaximum = 100;
+
+    boundObject = NULL;
+    boundField = NULL;
+    boundElement = 0;
 }
 
 
@@ -136,31 +142,23 @@ Plot3dData::~Plot3dData()
         delete yData;
     if (zData != NULL)
         delete zData;
-    if (zDataHistory != NULL)
-        delete zDataHistory;
-    if (timeDataHistory != NULL)
-        delete timeDataHistory;
 }
 
 
 /**
- * @brief valueAsDouble Fetch the value from the UAVO and return it as a double
- * @param obj UAVO
- * @param field UAVO field
- * @param haveSubField TRUE if UAVO has subfield. FALSE if not.
- * @param uavSubFieldName UAVO subfield, if it exists
- * @return
+ * @brief PlotData::bindTo Resolve the plotted field and element of the
+ * UAVO once, so that updates don't need to look them up by name
+ * @param obj UAVO whose updates are routed to this plot data
  */
-double PlotData::valueAsDouble(UAVObject* obj, UAVObjectField* field, bool haveSubField, QString uavSubFieldName)
+void PlotData::bindTo(UAVObject *obj)
 {
-    Q_UNUSED(obj);
-    QVariant value;
-
-    if(haveSubField){
-        int indexOfSubField = field->getElementNames().indexOf(QRegExp(uavSubFieldName, Qt::CaseSensitive, QRegExp::FixedString));
-        value = field->getValue(indexOfSubField);
-    }else
-        value = field->getValue();
-
-    return value.toDouble();
+    boundObject = obj;
+    boundField = obj ? obj->getField(uavFieldName) : NULL;
+    boundElement = 0;
+
+    if (boundField && haveSubField) {
+        boundElement = boundField->getElementNames().indexOf(uavSubFieldName);
+        if (boundElement < 0)
+            boundField = NULL;
+    }
 }
@@ -45,7 +45,13 @@ class PlotData : public QObject
 {
     Q_OBJECT
 public:
-    double valueAsDouble(UAVObject* obj, UAVObjectField* field, bool haveSubField, QString uavSubFieldName);
+    void bindTo(UAVObject *obj);
+
+    //! Time of the object's data, in s, as the time axes show it
+    static double sampleTime(UAVObject *obj) {
+        qint64 timestamp = obj->getTimestamp();
+        return (timestamp ? timestamp : UAVObject::currentTimestamp()) / 1000.0;
+    }
 
     //Setter functions
     void setXMinimum(double val){xMinimum=val;}
@@ -64,6 +70,7 @@ public:
     double getYMaximum(){return yMaximum;}
     double getXWindowSize(){return m_xWindowSize;}
 
+    UAVObject *getBoundObject(){return boundObject;}
     QString getUavoName(){return uavObjectName;}
     QString getUavoFieldName(){return uavFieldName;}
     QString getUavoSubFieldName(){return uavSubFieldName;}
@@ -101,6 +108,11 @@ protected:
     QString uavSubFieldName;
     bool haveSubField;
 
+    //! The plotted object, field and element, resolved once by bindTo()
+    UAVObject *boundObject;
+    UAVObjectField *boundField;
+    int boundElement;
+
     int scalePower; //This is the power to which each value must be raised
     unsigned int meanSamples;
     QString mathFunction;
@@ -1,5 +1,5 @@
 TEMPLATE = lib
-QT+=widgets
+QT+=widgets opengl
 TARGET = ScopeGadget
 DEFINES += SCOPE_LIBRARY
 DEFINES += QWT_DLL
@@ -8,10 +8,14 @@ include(../../gcsplugin.pri)
 include (scope_dependencies.pri)
 HEADERS += scopeplugin.h \
     scopes2d/histogramplotdata.h \
+    scopes2d/histogrambins.h \
     scopes2d/histogramscopeconfig.h \
     scopes2d/scatterplotdata.h \
+    scopes2d/ringseries.h \
     scopes2d/scatterplotscopeconfig.h \
     scopes3d/spectrogramplotdata.h \
+    scopes3d/spectrogramrasterdata.h \
+    scopes3d/stftengine.h \
     scopes3d/spectrogramscopeconfig.h \
     scopes2d/plotdata2d.h \
     scopes2d/scopes2dconfig.h \
@@ -19,7 +23,9 @@ HEADERS += scopeplugin.h \
     scopes3d/scopes3dconfig.h \
     scopesconfig.h \
     plotdata.h \
-    scope_global.h
+    scope_global.h \
+    scopeoverlaysource.h \
+    scoperenderscheduler.h
 HEADERS += scopegadgetoptionspage.h
 HEADERS += scopegadgetconfiguration.h
 HEADERS += scopegadget.h
@@ -27,10 +33,14 @@ HEADERS += scopegadgetwidget.h
 HEADERS += scopegadgetfactory.h
 SOURCES += scopeplugin.cpp \
     scopes2d/histogramplotdata.cpp \
+    scopes2d/histogrambins.cpp \
     scopes2d/histogramscopeconfig.cpp \
     scopes2d/scatterplotdata.cpp \
+    scopes2d/ringseries.cpp \
     scopes2d/scatterplotscopeconfig.cpp \
     scopes3d/spectrogramplotdata.cpp \
+    scopes3d/spectrogramrasterdata.cpp \
+    scopes3d/stftengine.cpp \
     scopes3d/spectrogramscopeconfig.cpp \
     plotdata.cpp
 SOURCES += scopegadgetoptionspage.cpp
@@ -38,6 +48,7 @@ SOURCES += scopegadgetconfiguration.cpp
 SOURCES += scopegadget.cpp
 SOURCES += scopegadgetfactory.cpp
 SOURCES += scopegadgetwidget.cpp
+SOURCES += scoperenderscheduler.cpp
 OTHER_FILES += ScopeGadget.pluginspec \
     ScopeGadget.json
 FORMS += scopegadgetoptionspage.ui
@@ -53,8 +53,12 @@ void ScopeGadget::loadConfiguration(IUAVGadgetConfiguration* config)
 
     scopeGadgetWidget->clearPlotWidget();
     scopeGadgetWidget->setScopeName(config->name());
+    scopeGadgetWidget->setOpenGLCanvas(sgConfig->getOpenGLCanvas());
 
     sgConfig->getScope()->loadConfiguration(scopeGadgetWidget);
+
+    // Once the curves exist
+    scopeGadgetWidget->setAntialiasing(sgConfig->getAntialiasing());
 }
 
 
@@ -38,7 +38,9 @@
  */
 ScopeGadgetConfiguration::ScopeGadgetConfiguration(QString classId, QSettings* qSettings, QObject *parent) :
         IUAVGadgetConfiguration(classId, parent),
-        m_scope(0)
+        m_scope(0),
+        m_openGLCanvas(false),
+        m_antialiasing(false)
 {
     //Default for scopes
     int refreshInterval = 50;
@@ -46,6 +48,8 @@ ScopeGadgetConfiguration::ScopeGadgetConfiguration(QString classId, QSettings* q
     //if a saved configuration exists load it
     if(qSettings != 0)
     {
+        m_openGLCanvas = qSettings->value("openGLCanvas", false).toBool();
+        m_antialiasing = qSettings->value("antialiasing", false).toBool();
 
         PlotDimensions plotDimensions =  (PlotDimensions) qSettings->value("plotDimensions").toInt();
 
@@ -112,6 +116,9 @@ void ScopeGadgetConfiguration::applyGuiConfiguration(Ui::ScopeGadgetOptionsPage
     //Default for scopes
     int refreshInterval = 50;
 
+    m_openGLCanvas = options_page->chkOpenGLCanvas->isChecked();
+    m_antialiasing = options_page->chkAntialiasing->isChecked();
+
     if(options_page->tabWidget2d3d->currentWidget() == options_page->tabPlot2d)
     {   //--- 2D ---//
         Scopes2dConfig::Plot2dType plot2dType = (Scopes2dConfig::Plot2dType) options_page->cmb2dPlotType->itemData(options_page->cmb2dPlotType->currentIndex()).toUInt(); //This is safe because the item data is defined from the enum.
@@ -160,6 +167,8 @@ IUAVGadgetConfiguration *ScopeGadgetConfiguration::clone()
 {
     ScopeGadgetConfiguration *m = new ScopeGadgetConfiguration(this->classId());
     m->m_scope=this->getScope()->cloneScope(m_scope);
+    m->m_openGLCanvas = m_openGLCanvas;
+    m->m_antialiasing = m_antialiasing;
 
     return m;
 }
@@ -172,6 +181,8 @@ IUAVGadgetConfiguration *ScopeGadgetConfiguration::clone()
 void ScopeGadgetConfiguration::saveConfig(QSettings* qSettings) const {
     qSettings->setValue("plotDimensions", m_scope->getScopeDimensions());
     qSettings->setValue("refreshInterval", m_scope->getRefreshInterval());
+    qSettings->setValue("openGLCanvas", m_openGLCanvas);
+    qSettings->setValue("antialiasing", m_antialiasing);
 
     m_scope->saveConfiguration(qSettings);
 }
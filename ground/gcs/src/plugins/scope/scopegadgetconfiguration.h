@@ -48,6 +48,8 @@ public:
 
     //configurations getter functions
     ScopeConfig* getScope(){return m_scope;}
+    bool getOpenGLCanvas(){return m_openGLCanvas;}
+    bool getAntialiasing(){return m_antialiasing;}
 
     void saveConfig(QSettings* settings) const; //THIS SEEMS TO BE UNUSED
     IUAVGadgetConfiguration* clone();
@@ -56,6 +58,8 @@ public:
 
 private:
     ScopeConfig *m_scope;
+    bool m_openGLCanvas;
+    bool m_antialiasing;
 
 };
 
@@ -175,8 +175,11 @@ QWidget* ScopeGadgetOptionsPage::createPage(QWidget *parent)
     connect(options_page->lst2dCurves, SIGNAL(itemClicked(QListWidgetItem *)), this, SLOT(on_lst2dItem_clicked(QListWidgetItem *)));
 
     // Configuration the GUI elements to reflect the scope settings
-    if(m_config)
+    if(m_config) {
         m_config->getScope()->setGuiConfiguration(options_page);
+        options_page->chkOpenGLCanvas->setChecked(m_config->getOpenGLCanvas());
+        options_page->chkAntialiasing->setChecked(m_config->getAntialiasing());
+    }
 
     // Cascading update on the UI elements
     emit on_cmb2dPlotType_currentIndexChanged(options_page->cmb2dPlotType->currentText());
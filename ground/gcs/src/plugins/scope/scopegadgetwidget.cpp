@@ -37,6 +37,9 @@
 
 #include "scopegadgetwidget.h"
 #include "scopegadgetconfiguration.h"
+#include "scopeoverlaysource.h"
+#include "scoperenderscheduler.h"
+#include "scopes2d/scatterplotdata.h"
 
 #include "utils/stylehelper.h"
 #include "uavtalk/telemetrymanager.h"
@@ -49,6 +52,9 @@
 #include "qwt/src/qwt_legend.h"
 #include "qwt/src/qwt_legend_label.h"
 #include "qwt/src/qwt_scale_widget.h"
+#include "qwt/src/qwt_plot_curve.h"
+#include "qwt/src/qwt_plot_canvas.h"
+#include "qwt/src/qwt_plot_glcanvas.h"
 
 #include <iostream>
 #include <math.h>
@@ -64,22 +70,22 @@
 #include <QClipboard>
 #include <QApplication>
 
-QTimer *ScopeGadgetWidget::replotTimer=0;
-
 ScopeGadgetWidget::ScopeGadgetWidget(QWidget *parent) : QwtPlot(parent),
     m_refreshInterval(50), // Arbitrary 50ms refresh timer
     m_scope(0),
-    m_xWindowSize(60) // This is an arbitrary 1 minute window
+    m_xWindowSize(60), // This is an arbitrary 1 minute window
+    m_sampleTimestamp(0),
+    m_sampleReceived(0),
+    m_dataChanged(false),
+    m_logSpan(0)
 {
     m_grid = new QwtPlotGrid;
 
     setMouseTracking(true);
 //	canvas()->setMouseTracking(true);
 
-    //Set up the timer that replots data. Only set up one timer for entire class.
-    if (replotTimer == NULL)
-        replotTimer = new QTimer();
-    connect(replotTimer, SIGNAL(timeout()), this, SLOT(replotNewData()));
+    // All scopes are replotted from one frame timer
+    ScopeRenderScheduler::instance()->addScope(this);
 
     // Listen to telemetry connection/disconnection events, no point in
     // running the scopes if we are not connected and not replaying logs.
@@ -97,6 +103,8 @@ ScopeGadgetWidget::ScopeGadgetWidget(QWidget *parent) : QwtPlot(parent),
  */
 ScopeGadgetWidget::~ScopeGadgetWidget()
 {
+    ScopeRenderScheduler::instance()->removeScope(this);
+
     // Get the object to de-monitor
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
@@ -125,6 +133,46 @@ void ScopeGadgetWidget::popUpMenu(const QPoint &mousePosition)
 
     // Add copy to clipboard item to menu
     connect(action, SIGNAL(triggered(bool)), this, SLOT(copyToClipboardAsImage()));
+
+    // Add the overlays other plugins offer, such as logs opened for comparison
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    QStringList overlays;
+    foreach (ScopeOverlaySource *source, pm->getObjects<ScopeOverlaySource>())
+        overlays << source->getOverlayNames();
+    if (!overlays.isEmpty() || !m_overlayCurves.isEmpty()) {
+        QMenu *overlayMenu = menu.addMenu(tr("Overlay"));
+        foreach (const QString &overlay, overlays) {
+            action = overlayMenu->addAction(overlay);
+            action->setCheckable(true);
+            action->setChecked(m_overlayCurves.contains(overlay));
+            action->setData(overlay);
+            connect(action, SIGNAL(toggled(bool)), this, SLOT(toggleOverlay(bool)));
+        }
+        overlayMenu->addSeparator();
+        action = overlayMenu->addAction(tr("Clear overlays"));
+        connect(action, SIGNAL(triggered(bool)), this, SLOT(clearOverlays()));
+    }
+
+    // The same logs can be shown whole instead of the live data, by scopes
+    // plotting against time
+    bool timeSeries = false;
+    foreach (PlotData *plotData, m_dataSources.values())
+        timeSeries |= dynamic_cast<TimeSeriesPlotData *>(plotData) != NULL;
+    if (timeSeries && (!overlays.isEmpty() || isViewingLog())) {
+        QMenu *viewMenu = menu.addMenu(tr("View log"));
+        foreach (const QString &overlay, overlays) {
+            action = viewMenu->addAction(overlay);
+            action->setCheckable(true);
+            action->setChecked(m_logView == overlay);
+            action->setData(overlay);
+            connect(action, SIGNAL(toggled(bool)), this, SLOT(viewLog(bool)));
+        }
+        viewMenu->addSeparator();
+        action = viewMenu->addAction(tr("Live data"));
+        action->setCheckable(true);
+        action->setChecked(!isViewingLog());
+        connect(action, SIGNAL(triggered(bool)), this, SLOT(viewLiveData()));
+    }
     menu.addSeparator();
 
     // Add options dialog to clipboard
@@ -150,6 +198,225 @@ void ScopeGadgetWidget::clearPlot()
 }
 
 
+/**
+ * @brief ScopeGadgetWidget::toggleOverlay Draw or remove the overlay of the menu entry
+ */
+void ScopeGadgetWidget::toggleOverlay(bool on)
+{
+    QAction *action = qobject_cast<QAction *>(sender());
+    if (action == NULL)
+        return;
+    QString overlay = action->data().toString();
+
+    if (on) {
+        addOverlay(overlay);
+        return;
+    }
+
+    foreach (QwtPlotCurve *curve, m_overlayCurves.values(overlay)) {
+        curve->detach();
+        delete curve;
+    }
+    m_overlayCurves.remove(overlay);
+    replot();
+}
+
+
+/**
+ * @brief ScopeGadgetWidget::getOverlaySamples Get the samples an overlay has
+ * for the field element a plot shows, from whichever source offers it
+ * @return false if no source has that element
+ */
+bool ScopeGadgetWidget::getOverlaySamples(const QString &overlay, PlotData *plotData,
+                                          QVector<double> &times, QVector<double> &values) const
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+
+    QString element = plotData->getHaveSubFieldFlag() ? plotData->getUavoSubFieldName() : QString();
+    foreach (ScopeOverlaySource *source, pm->getObjects<ScopeOverlaySource>()) {
+        if (source->getOverlaySamples(overlay, plotData->getUavoName(), plotData->getUavoFieldName(),
+                                      element, times, values))
+            return true;
+    }
+    return false;
+}
+
+
+/**
+ * @brief ScopeGadgetWidget::addOverlay Draw an overlay next to every time series
+ * curve it has data for, starting with the oldest data shown
+ */
+void ScopeGadgetWidget::addOverlay(const QString &overlay)
+{
+    // A log being viewed starts at zero, so the overlay starts with it
+    double start = isViewingLog() ? 0 : getPlotTime();
+    foreach (PlotData *plotData, m_dataSources.values()) {
+        TimeSeriesPlotData *timeSeries = dynamic_cast<TimeSeriesPlotData *>(plotData);
+        if (timeSeries && !timeSeries->getSamples()->isEmpty())
+            start = qMin(start, timeSeries->getSamples()->first().x());
+    }
+
+    foreach (PlotData *plotData, m_dataSources.values()) {
+        TimeSeriesPlotData *timeSeries = dynamic_cast<TimeSeriesPlotData *>(plotData);
+        if (timeSeries == NULL || timeSeries->getCurve() == NULL)
+            continue;
+
+        QVector<double> times;
+        QVector<double> values;
+        if (!getOverlaySamples(overlay, plotData, times, values))
+            continue;
+
+        double scale = pow(10, plotData->getScalePower());
+        for (int i = 0; i < times.size(); i++) {
+            times[i] += start;
+            values[i] *= scale;
+        }
+
+        QwtPlotCurve *curve = new QwtPlotCurve(timeSeries->getCurve()->title().text() + " (" + overlay + ")");
+        QPen pen = timeSeries->getCurve()->pen();
+        pen.setStyle(Qt::DashLine);
+        curve->setPen(pen);
+        curve->setSamples(times, values);
+        curve->attach(this);
+        m_overlayCurves.insert(overlay, curve);
+    }
+
+    replot();
+}
+
+
+/**
+ * @brief ScopeGadgetWidget::clearOverlays Remove every overlay curve
+ */
+void ScopeGadgetWidget::clearOverlays()
+{
+    foreach (QwtPlotCurve *curve, m_overlayCurves.values()) {
+        curve->detach();
+        delete curve;
+    }
+    m_overlayCurves.clear();
+    replot();
+}
+
+
+/**
+ * @brief ScopeGadgetWidget::viewLog Show the whole log of the menu entry in
+ * place of the live data. The time series are loaded with the decoded
+ * samples at once, rather than replaying the log through the objects, and
+ * the curves then zoom and scroll over it without decoding again.
+ */
+void ScopeGadgetWidget::viewLog(bool on)
+{
+    QAction *action = qobject_cast<QAction *>(sender());
+    if (action == NULL)
+        return;
+    QString overlay = action->data().toString();
+
+    if (!on) {
+        if (overlay == m_logView)
+            viewLiveData();
+        return;
+    }
+
+    // Overlays drawn against the live data no longer line up
+    clearOverlays();
+
+    m_logView = overlay;
+    m_logSpan = 0;
+    foreach (PlotData *plotData, m_dataSources.values()) {
+        TimeSeriesPlotData *timeSeries = dynamic_cast<TimeSeriesPlotData *>(plotData);
+        if (timeSeries == NULL || timeSeries->getCurve() == NULL)
+            continue;
+
+        QVector<double> times;
+        QVector<double> values;
+        if (!getOverlaySamples(overlay, plotData, times, values)) {
+            timeSeries->clearPlots();
+            timeSeries->setUpdatedFlagToTrue();
+            continue;
+        }
+
+        timeSeries->loadSamples(times, values);
+        if (!times.isEmpty())
+            m_logSpan = qMax(m_logSpan, times.last());
+    }
+
+    // Show the whole flight, counted from the start of the log
+    setAxisScaleDraw(QwtPlot::xBottom, new TimeScaleDraw(true));
+    setAxisScale(QwtPlot::xBottom, 0, qMax(m_logSpan, 1.0));
+    setAxisAutoScale(QwtPlot::yLeft, true);
+
+    replotNewData();
+}
+
+
+/**
+ * @brief ScopeGadgetWidget::viewLiveData Go back from viewing a log to
+ * plotting the live data, from an empty plot
+ */
+void ScopeGadgetWidget::viewLiveData()
+{
+    if (!isViewingLog())
+        return;
+
+    m_logView.clear();
+    clearOverlays();
+    clearPlot();
+
+    setAxisScaleDraw(QwtPlot::xBottom, new TimeScaleDraw());
+    setAxisAutoScale(QwtPlot::yLeft, true);
+
+    // Puts the time axis back on the live clock
+    replotNewData();
+}
+
+
+/**
+ * @brief ScopeGadgetWidget::zoomTime Zoom the time axis of a log being viewed,
+ * no further out than the whole log
+ * @param center Time that stays where it is, in s
+ * @param factor More than one zooms out
+ */
+void ScopeGadgetWidget::zoomTime(double center, double factor)
+{
+    QwtInterval xInterval = axisInterval(QwtPlot::xBottom);
+    double from = (xInterval.minValue() - center) * factor + center;
+    double to = (xInterval.maxValue() - center) * factor + center;
+
+    double span = qMax(m_logSpan, 1.0);
+    if (to - from >= span) {
+        from = 0;
+        to = span;
+    } else if (from < 0) {
+        to -= from;
+        from = 0;
+    } else if (to > span) {
+        from -= to - span;
+        to = span;
+    }
+
+    setAxisScale(QwtPlot::xBottom, from, to);
+    replot();
+}
+
+
+/**
+ * @brief ScopeGadgetWidget::scrollTime Scroll the time axis of a log being
+ * viewed, staying within the log
+ * @param fraction Of the time shown, positive scrolls later
+ */
+void ScopeGadgetWidget::scrollTime(double fraction)
+{
+    QwtInterval xInterval = axisInterval(QwtPlot::xBottom);
+    double width = xInterval.maxValue() - xInterval.minValue();
+    double span = qMax(m_logSpan, 1.0);
+
+    double from = qBound(0.0, xInterval.minValue() + fraction * width, qMax(span - width, 0.0));
+    setAxisScale(QwtPlot::xBottom, from, from + width);
+    replot();
+}
+
+
 /**
  * @brief ScopeGadgetWidget::copyToClipboardAsImage Copies the selected scope to the clipboard
  */
@@ -209,6 +476,10 @@ void ScopeGadgetWidget::mouseDoubleClickEvent(QMouseEvent *e)
 
     //On double-click, reset plot zoom
     setAxisAutoScale(QwtPlot::yLeft, true);
+    if (isViewingLog()) {
+        setAxisScale(QwtPlot::xBottom, 0, qMax(m_logSpan, 1.0));
+        replot();
+    }
 
     update();
 
@@ -227,11 +498,21 @@ void ScopeGadgetWidget::mouseMoveEvent(QMouseEvent *e)
 
 
 /**
- * @brief ScopeGadgetWidget::wheelEvent Zoom in or out, then pass mouse wheel event to QwtPlot
+ * @brief ScopeGadgetWidget::wheelEvent Zoom in or out, then pass mouse wheel event to QwtPlot.
+ * While a log is viewed, Ctrl zooms the time axis and Shift scrolls through the log.
  * @param e
  */
 void ScopeGadgetWidget::wheelEvent(QWheelEvent *e)
 {
+    if (isViewingLog() && (e->modifiers() & (Qt::ControlModifier | Qt::ShiftModifier))) {
+        if (e->modifiers() & Qt::ControlModifier)
+            zoomTime(invTransform(QwtPlot::xBottom, e->pos().x()), e->delta() < 0 ? 1.25 : 0.8);
+        else
+            scrollTime(e->delta() < 0 ? 0.1 : -0.1);
+        e->accept();
+        return;
+    }
+
     //Change zoom on scroll wheel event
     QwtInterval yInterval=axisInterval(QwtPlot::yLeft);
     if (yInterval.minValue() != yInterval.maxValue()) //Make sure that the two values are never the same. Sometimes axisInterval returns (0,0)
@@ -266,11 +547,7 @@ void ScopeGadgetWidget::wheelEvent(QWheelEvent *e)
  */
 void ScopeGadgetWidget::startPlotting()
 {
-    if (!replotTimer)
-        return;
-
-    if (!replotTimer->isActive())
-        replotTimer->start(m_refreshInterval);
+    ScopeRenderScheduler::instance()->start(m_refreshInterval);
 }
 
 
@@ -279,10 +556,7 @@ void ScopeGadgetWidget::startPlotting()
  */
 void ScopeGadgetWidget::stopPlotting()
 {
-    if (!replotTimer)
-        return;
-
-    replotTimer->stop();
+    ScopeRenderScheduler::instance()->stop();
 }
 
 
@@ -360,15 +634,87 @@ void ScopeGadgetWidget::showCurve(const QVariant & itemInfo, bool on, int index)
  */
 void ScopeGadgetWidget::uavObjectReceived(UAVObject* obj)
 {
-    foreach(PlotData* plotdData, m_dataSources.values()) {
+    if (obj->getTimestamp()) {
+        m_sampleTimestamp = obj->getTimestamp();
+        m_sampleReceived = UAVObject::currentTimestamp();
+    }
+
+    // The log being viewed stays as it is
+    if (isViewingLog())
+        return;
+
+    foreach(PlotData* plotdData, m_subscribers.value(obj)) {
         bool ret = plotdData->append(obj);
-        if (ret)
+        if (ret) {
             plotdData->setUpdatedFlagToTrue();
+            m_dataChanged = true;
+        }
     }
 }
 
 
 
+/**
+ * @brief ScopeGadgetWidget::setOpenGLCanvas Paint the plot canvas through
+ * OpenGL or the raster engine. Set before the axes and curves are
+ * configured, the canvas background is a property of the canvas.
+ */
+void ScopeGadgetWidget::setOpenGLCanvas(bool openGL)
+{
+    bool isOpenGL = qobject_cast<QwtPlotGLCanvas *>(canvas()) != NULL;
+    if (openGL == isOpenGL)
+        return;
+
+    // The plot deletes the canvas it replaces
+    if (openGL)
+        setCanvas(new QwtPlotGLCanvas());
+    else
+        setCanvas(new QwtPlotCanvas());
+}
+
+
+/**
+ * @brief ScopeGadgetWidget::setAntialiasing Antialias the curves and
+ * histograms of the plot, set once they are created
+ */
+void ScopeGadgetWidget::setAntialiasing(bool antialiased)
+{
+    foreach (QwtPlotItem *item, itemList()) {
+        if (item->rtti() == QwtPlotItem::Rtti_PlotCurve || item->rtti() == QwtPlotItem::Rtti_PlotHistogram)
+            item->setRenderHint(QwtPlotItem::RenderAntialiased, antialiased);
+    }
+}
+
+
+/**
+ * @brief ScopeGadgetWidget::getPlotTime Time the time axes end at, in s. This
+ * is the time of the latest data moved on by the time since it arrived, so
+ * the axes keep scrolling smoothly between updates and follow replays.
+ */
+double ScopeGadgetWidget::getPlotTime() const
+{
+    qint64 now = UAVObject::currentTimestamp();
+    if (m_sampleReceived == 0)
+        return now / 1000.0;
+    return (m_sampleTimestamp + (now - m_sampleReceived)) / 1000.0;
+}
+
+
+/**
+ * @brief ScopeGadgetWidget::renderFrame Replot if any data came in since the
+ * last replot
+ * @return true if it replotted
+ */
+bool ScopeGadgetWidget::renderFrame()
+{
+    if (!m_dataChanged || m_scope == NULL)
+        return false;
+
+    replotNewData();
+    return true;
+}
+
+
 /**
  * @brief ScopeGadgetWidget::replotNewData
  */
@@ -378,6 +724,8 @@ void ScopeGadgetWidget::replotNewData()
     if (!isVisible() || m_scope == NULL)
         return;
 
+    m_dataChanged = false;
+
     // Update the data in the scopes
     foreach(PlotData* plotData, m_dataSources.values())
     {
@@ -394,6 +742,11 @@ void ScopeGadgetWidget::replotNewData()
  */
 void ScopeGadgetWidget::clearPlotWidget()
 {
+    clearOverlays();
+
+    // The plots are set up again, with the axes for live data
+    m_logView.clear();
+
     if(m_grid){
         m_grid->detach();
     }
@@ -405,6 +758,7 @@ void ScopeGadgetWidget::clearPlotWidget()
 
         // Clear the data
         m_dataSources.clear();
+        m_subscribers.clear();
     }
 }
 
@@ -452,10 +806,15 @@ void ScopeGadgetWidget::showEvent(QShowEvent *event)
 
 
 /**
- * @brief ScopeGadgetWidget::connectUAVO Connects UAVO update signal, but only if it hasn't yet been connected
+ * @brief ScopeGadgetWidget::connectUAVO Routes the UAVO updates to the plot data. The
+ * update signal is only connected if it hasn't yet been connected
  * @param obj
+ * @param plotData Plot data drawn from the UAVO, bound to it here
  */
-void ScopeGadgetWidget::connectUAVO(UAVDataObject* obj){
+void ScopeGadgetWidget::connectUAVO(UAVDataObject* obj, PlotData *plotData){
+    plotData->bindTo(obj);
+    m_subscribers[obj].append(plotData);
+
     //Link to the new signal data only if this UAVObject has not been connected yet
     if (!m_connectedUAVObjects.contains(obj->getName())) {
         m_connectedUAVObjects.append(obj->getName());
@@ -474,12 +833,6 @@ void ScopeGadgetWidget::startTimer(int refreshInterval){
 
     // Only start the timer if we are already connected
     Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
-    if (cm->getCurrentConnection() && replotTimer)
-    {
-        if (!replotTimer->isActive())
-            replotTimer->start(refreshInterval);
-        else
-            replotTimer->setInterval(refreshInterval);
-
-    }
+    if (cm->getCurrentConnection())
+        ScopeRenderScheduler::instance()->start(refreshInterval);
 }
@@ -55,18 +55,26 @@ class UAVDataObject;
 #include <QTimer>
 #include <QTime>
 #include <QVector>
+#include <QMultiMap>
+#include <QHash>
+
+class QwtPlotCurve;
 
 /*!
   \brief This class is used to render the time values on the horizontal axis for the
-  ChronoPlot.
+  ChronoPlot. Elapsed times, such as those of a log being viewed, are shown from zero
+  instead of as the time of day.
   */
 class TimeScaleDraw : public QwtScaleDraw
 {
 public:
-    TimeScaleDraw() {
+    TimeScaleDraw(bool elapsed = false) : elapsed(elapsed) {
         //baseTime = QDateTime::currentDateTime().toTime_t();
     }
     virtual QwtText label(double v) const {
+        if (elapsed)
+            return QTime(0, 0).addMSecs(qRound64(qMax(v, 0.0) * 1000)).toString("hh:mm:ss");
+
         uint seconds = (uint)(v);
         QDateTime upTime = QDateTime::fromTime_t(seconds);
         QTime timePart = upTime.time().addMSecs((v - seconds )* 1000);
@@ -75,6 +83,7 @@ public:
     }
 private:
 //    double baseTime;
+    bool elapsed;
 };
 
 class ScopeGadgetWidget : public QwtPlot
@@ -86,7 +95,7 @@ public:
     ~ScopeGadgetWidget();
 
     QString getUavObjectFieldUnits(QString uavObjectName, QString uavObjectFieldName);
-    void connectUAVO(UAVDataObject* obj);
+    void connectUAVO(UAVDataObject* obj, PlotData *plotData);
 
     void setScope(ScopeConfig *val){m_scope = val;}
     QMap<QString, PlotData*> getDataSources(){return m_dataSources;}
@@ -99,6 +108,11 @@ public:
     QwtPlotGrid *m_grid;
     QwtLegend *m_legend;
     void setScopeName(QString val) {scopeName = val;}
+    double getPlotTime() const;
+    bool renderFrame();
+    bool isViewingLog() const {return !m_logView.isEmpty();}
+    void setOpenGLCanvas(bool openGL);
+    void setAntialiasing(bool antialiased);
 
 protected:
     void mousePressEvent(QMouseEvent *e);
@@ -118,15 +132,38 @@ private slots:
     void clearPlot();
     void copyToClipboardAsImage();
     void showOptionDialog();
+    void toggleOverlay(bool on);
+    void clearOverlays();
+    void viewLog(bool on);
+    void viewLiveData();
 
 private:
     int m_refreshInterval;
     ScopeConfig *m_scope;
     QMap<QString, PlotData*> m_dataSources;
     double m_xWindowSize;
-    static QTimer *replotTimer;
     QList<QString> m_connectedUAVObjects;
+
+    //! Plot data fed by each connected UAVO, so updates skip the others
+    QHash<UAVObject *, QList<PlotData *> > m_subscribers;
     QString scopeName;
+
+    //! Latest object time received, and when on the object clock
+    qint64 m_sampleTimestamp;
+    qint64 m_sampleReceived;
+    bool m_dataChanged;         // Since the last replot
+
+    //! Curves drawn from overlay sources, by overlay name
+    QMultiMap<QString, QwtPlotCurve *> m_overlayCurves;
+    void addOverlay(const QString &overlay);
+    bool getOverlaySamples(const QString &overlay, PlotData *plotData,
+                           QVector<double> &times, QVector<double> &values) const;
+
+    //! Overlay shown in place of the live data, and the time it spans in s
+    QString m_logView;
+    double m_logSpan;
+    void zoomTime(double center, double factor);
+    void scrollTime(double fraction);
 };
 
 
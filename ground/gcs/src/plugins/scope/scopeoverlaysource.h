@@ -0,0 +1,70 @@
+/**
+ ******************************************************************************
+ *
+ * @file       scopeoverlaysource.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Interface for data the scopes can overlay on their curves
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef SCOPEOVERLAYSOURCE_H
+#define SCOPEOVERLAYSOURCE_H
+
+#include "scope_global.h"
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * Plugins providing recorded series, such as decoded logs, add an
+ * implementation to the object pool. Time series scopes then offer to
+ * draw them next to their live curves, or to show one in place of the
+ * live data.
+ */
+class SCOPE_EXPORT ScopeOverlaySource : public QObject
+{
+    Q_OBJECT
+
+public:
+    ScopeOverlaySource(QObject *parent = 0) : QObject(parent) {}
+    virtual ~ScopeOverlaySource() {}
+
+    //! Names of the overlays ready to be drawn
+    virtual QStringList getOverlayNames() const = 0;
+
+    /**
+     * Get the samples of one field element of the first instance of an
+     * object, with times in seconds from the start of the overlay
+     * @returns false if the overlay doesn't have that element
+     */
+    virtual bool getOverlaySamples(const QString &overlay, const QString &objName,
+                                   const QString &fieldName, const QString &elementName,
+                                   QVector<double> &times, QVector<double> &values) const = 0;
+
+signals:
+    void overlaysChanged();
+};
+
+#endif // SCOPEOVERLAYSOURCE_H
+
+/**
+ * @}
+ * @}
+ */
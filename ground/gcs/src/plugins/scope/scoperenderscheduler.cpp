@@ -0,0 +1,129 @@
+/**
+ ******************************************************************************
+ *
+ * @file       scoperenderscheduler.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Paces the replots of all the scope gadgets
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "scoperenderscheduler.h"
+#include "scopegadgetwidget.h"
+
+#include <QElapsedTimer>
+
+ScopeRenderScheduler::ScopeRenderScheduler() :
+    baseInterval(50),
+    renderCost(0)
+{
+    connect(&timer, SIGNAL(timeout()), this, SLOT(renderFrame()));
+}
+
+
+/**
+ * @brief ScopeRenderScheduler::instance The scheduler all scopes share
+ */
+ScopeRenderScheduler *ScopeRenderScheduler::instance()
+{
+    static ScopeRenderScheduler *scheduler = new ScopeRenderScheduler();
+    return scheduler;
+}
+
+
+void ScopeRenderScheduler::addScope(ScopeGadgetWidget *scope)
+{
+    if (!scopes.contains(scope))
+        scopes.append(scope);
+}
+
+
+void ScopeRenderScheduler::removeScope(ScopeGadgetWidget *scope)
+{
+    scopes.removeAll(scope);
+}
+
+
+/**
+ * @brief ScopeRenderScheduler::start Start rendering frames, or change the
+ * interval asked for if already running
+ * @param interval The refresh interval, in ms
+ */
+void ScopeRenderScheduler::start(int interval)
+{
+    baseInterval = interval;
+
+    if (!timer.isActive())
+        timer.start(frameInterval());
+    else
+        timer.setInterval(frameInterval());
+}
+
+
+void ScopeRenderScheduler::stop()
+{
+    timer.stop();
+}
+
+
+/**
+ * @brief ScopeRenderScheduler::renderFrame Replot the scopes that need it
+ * and pace the next frame on what that cost
+ */
+void ScopeRenderScheduler::renderFrame()
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    bool rendered = false;
+    foreach (ScopeGadgetWidget *scope, scopes) {
+        // Hidden, minimized or covered scopes are caught up when shown
+        if (!scope->isVisible() || scope->window()->isMinimized() || scope->visibleRegion().isEmpty())
+            continue;
+        if (scope->renderFrame())
+            rendered = true;
+    }
+
+    if (!rendered)
+        return;
+
+    double cost = elapsed.nsecsElapsed() / 1000000.0;
+    renderCost += (cost - renderCost) / (1 << COST_FILTER_SHIFT);
+
+    // Only change the timer when the interval moved noticeably
+    int interval = frameInterval();
+    if (qAbs(interval - timer.interval()) > timer.interval() / 8)
+        timer.setInterval(interval);
+}
+
+
+/**
+ * @brief ScopeRenderScheduler::frameInterval The interval that keeps the
+ * rendering within its budget, never below the one asked for
+ */
+int ScopeRenderScheduler::frameInterval() const
+{
+    int budgeted = renderCost * 100 / RENDER_BUDGET_PERCENT;
+    return qBound(baseInterval, budgeted, qMax(baseInterval, (int) MAX_INTERVAL_MS));
+}
+
+/**
+ * @}
+ * @}
+ */
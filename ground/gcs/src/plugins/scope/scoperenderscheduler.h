@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ *
+ * @file       scoperenderscheduler.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Paces the replots of all the scope gadgets
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef SCOPERENDERSCHEDULER_H
+#define SCOPERENDERSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QList>
+
+class ScopeGadgetWidget;
+
+/**
+ * @brief The ScopeRenderScheduler class One frame timer for every scope.
+ * Each frame only the scopes that can be seen and got new data since the
+ * last one are replotted. The frame interval starts at the refresh
+ * interval asked for and is stretched when rendering the frames takes
+ * more than RENDER_BUDGET_PERCENT of it, up to MAX_INTERVAL_MS.
+ */
+class ScopeRenderScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ScopeRenderScheduler *instance();
+
+    void addScope(ScopeGadgetWidget *scope);
+    void removeScope(ScopeGadgetWidget *scope);
+
+    void start(int interval);
+    void stop();
+
+    //! Interval between frames now, in ms
+    int getFrameInterval() const { return timer.interval(); }
+
+private slots:
+    void renderFrame();
+
+private:
+    ScopeRenderScheduler();
+    int frameInterval() const;
+
+    static const int MAX_INTERVAL_MS = 500;
+    static const int RENDER_BUDGET_PERCENT = 30;
+    static const int COST_FILTER_SHIFT = 3;     // Average the cost over ~8 frames
+
+    QTimer timer;
+    QList<ScopeGadgetWidget *> scopes;
+    int baseInterval;
+    double renderCost;          // ms per frame rendered
+};
+
+#endif // SCOPERENDERSCHEDULER_H
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,222 @@
+/**
+ ******************************************************************************
+ *
+ * @file       histogrambins.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Incremental bin counts for the histogram scope
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <math.h>
+#include <string.h>
+#include <qnumeric.h>
+
+#include "scopes2d/histogrambins.h"
+
+/**
+ * @brief HistogramBins::HistogramBins
+ * @param binWidth Width of each bin
+ * @param maxNumberOfBins Most bins the range may span
+ * @param window Seconds of values counted, 0 to count all of them
+ */
+HistogramBins::HistogramBins(double binWidth, unsigned int maxNumberOfBins, double window) :
+    firstBin(0),
+    numBins(0),
+    currentSlice(0),
+    sliceHead(0),
+    dirty(true)
+{
+    step = binWidth;
+    if (step < 1e-6) //Don't allow step size to be 0.
+        step = 1e-6;
+
+    this->maxNumberOfBins = qMax(1u, maxNumberOfBins);
+    sliceLength = window > 0 ? window / NUM_SLICES : 0;
+
+    totals.resize(this->maxNumberOfBins);
+    if (sliceLength > 0)
+        slices.resize(this->maxNumberOfBins * NUM_SLICES);
+}
+
+
+/**
+ * @brief HistogramBins::add Count a value
+ * @param value The value
+ * @param time Time of the value, in s
+ * @return false if the value is too far from the others to fit in the bins
+ */
+bool HistogramBins::add(double value, double time)
+{
+    if (!qIsFinite(value))
+        return false;
+
+    if (sliceLength > 0)
+        advanceTo(time);
+
+    qint64 bin = (qint64) floor(value / step);
+
+    if (numBins == 0) {
+        firstBin = bin;
+        numBins = 1;
+        clearSlot(slotOf(bin));
+    } else if (bin < firstBin) {
+        // This is a graceful way not to lock up the GCS if the bin width
+        // is inappropriate, or if there is an extremely distant outlier.
+        if (firstBin + numBins - bin > maxNumberOfBins)
+            return false;
+
+        for (qint64 i = bin; i < firstBin; i++)
+            clearSlot(slotOf(i));
+        numBins += firstBin - bin;
+        firstBin = bin;
+    } else if (bin >= firstBin + numBins) {
+        if (bin - firstBin + 1 > maxNumberOfBins)
+            return false;
+
+        for (qint64 i = firstBin + numBins; i <= bin; i++)
+            clearSlot(slotOf(i));
+        numBins = bin - firstBin + 1;
+    }
+
+    int slot = slotOf(bin);
+    totals[slot]++;
+    if (sliceLength > 0)
+        slices[slot * NUM_SLICES + sliceHead]++;
+
+    dirty = true;
+    return true;
+}
+
+
+/**
+ * @brief HistogramBins::clear Drop all counts
+ */
+void HistogramBins::clear()
+{
+    numBins = 0;
+    currentSlice = 0;
+    sliceHead = 0;
+    dirty = true;
+}
+
+
+/**
+ * @brief HistogramBins::advanceTo Move the window so its newest slice holds
+ * a time, taking the slices that fall out of it off the totals
+ */
+void HistogramBins::advanceTo(double time)
+{
+    qint64 slice = (qint64) floor(time / sliceLength);
+
+    if (numBins == 0 || slice < currentSlice) {
+        // First value, or the time went back, like after seeking in a log
+        if (numBins > 0)
+            clear();
+        currentSlice = slice;
+        return;
+    }
+
+    qint64 steps = qMin(slice - currentSlice, (qint64) NUM_SLICES);
+    for (qint64 i = 0; i < steps; i++) {
+        // The oldest slice is the one after the newest one
+        sliceHead = (sliceHead + 1) % NUM_SLICES;
+        for (int j = 0; j < numBins; j++) {
+            int slot = slotOf(firstBin + j);
+            quint32 &count = slices[slot * NUM_SLICES + sliceHead];
+            totals[slot] -= count;
+            count = 0;
+        }
+        dirty = true;
+    }
+    currentSlice = slice;
+
+    // Bins emptied at the ends of the range make room for new ones
+    while (numBins > 0 && totals[slotOf(firstBin)] == 0) {
+        firstBin++;
+        numBins--;
+    }
+    while (numBins > 0 && totals[slotOf(firstBin + numBins - 1)] == 0)
+        numBins--;
+}
+
+
+/**
+ * @brief HistogramBins::clearSlot Zero a slot before a bin takes it, it may
+ * still hold the counts of a bin dropped by clear()
+ */
+void HistogramBins::clearSlot(int slot)
+{
+    totals[slot] = 0;
+    if (sliceLength > 0)
+        memset(slices.data() + slot * NUM_SLICES, 0, NUM_SLICES * sizeof(quint32));
+}
+
+
+/**
+ * @brief HistogramBins::slotOf Storage slot of a bin in the range
+ */
+int HistogramBins::slotOf(qint64 bin) const
+{
+    int slot = bin % maxNumberOfBins;
+    return slot < 0 ? slot + maxNumberOfBins : slot;
+}
+
+
+size_t HistogramBins::size() const
+{
+    return numBins;
+}
+
+
+QwtIntervalSample HistogramBins::sample(size_t i) const
+{
+    qint64 bin = firstBin + i;
+    return QwtIntervalSample(totals[slotOf(bin)], bin * step, (bin + 1) * step);
+}
+
+
+QRectF HistogramBins::boundingRect() const
+{
+    if (!dirty)
+        return d_boundingRect;
+
+    if (numBins == 0) {
+        d_boundingRect = QRectF(0.0, 0.0, -1.0, -1.0);
+    } else {
+        quint32 minCount = totals[slotOf(firstBin)];
+        quint32 maxCount = minCount;
+        for (int i = 1; i < numBins; i++) {
+            quint32 count = totals[slotOf(firstBin + i)];
+            minCount = qMin(minCount, count);
+            maxCount = qMax(maxCount, count);
+        }
+
+        d_boundingRect = QRectF(firstBin * step, minCount,
+                                numBins * step, maxCount - minCount);
+    }
+
+    dirty = false;
+    return d_boundingRect;
+}
+
+/**
+ * @}
+ * @}
+ */
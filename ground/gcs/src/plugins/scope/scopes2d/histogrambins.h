@@ -0,0 +1,87 @@
+/**
+ ******************************************************************************
+ *
+ * @file       histogrambins.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Incremental bin counts for the histogram scope
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HISTOGRAMBINS_H
+#define HISTOGRAMBINS_H
+
+#include "qwt/src/qwt_series_data.h"
+
+#include <QVector>
+
+/**
+ * @brief The HistogramBins class Counts of a histogram with fixed width bins,
+ * handed to the QwtPlotHistogram as its data. A value finds its bin by
+ * division, and the range only grows at the end the value falls past. Bins
+ * are stored by their index modulo the maximum number of bins, so growing
+ * the range never moves the counts. The interval samples are built from the
+ * counts when Qwt asks for them, and the bounding rectangle is only computed
+ * again after the counts changed.
+ *
+ * With a window set, counts are also kept per time slice, and a slice is
+ * taken back out of the totals once it is older than the window.
+ */
+class HistogramBins : public QwtSeriesData<QwtIntervalSample>
+{
+public:
+    HistogramBins(double binWidth, unsigned int maxNumberOfBins, double window);
+
+    bool add(double value, double time);
+    void clear();
+
+    virtual size_t size() const;
+    virtual QwtIntervalSample sample(size_t i) const;
+    virtual QRectF boundingRect() const;
+
+private:
+    // Slices the window is divided into, the window moves by one at a time
+    static const int NUM_SLICES = 16;
+
+    void advanceTo(double time);
+    void clearSlot(int slot);
+    int slotOf(qint64 bin) const;
+
+    double step;
+    int maxNumberOfBins;
+    double sliceLength;         // 0 when all values are kept
+
+    qint64 firstBin;            // Index of the lowest bin, as value / step
+    int numBins;
+
+    qint64 currentSlice;        // Index of the newest slice, as time / sliceLength
+    int sliceHead;              // Storage slice of the newest slice
+
+    QVector<quint32> totals;
+    QVector<quint32> slices;    // NUM_SLICES counts per bin slot
+
+    mutable bool dirty;
+};
+
+#endif // HISTOGRAMBINS_H
+
+/**
+ * @}
+ * @}
+ */
@@ -21,7 +21,7 @@
  * for more details.
  *
  * You should have received a copy of the GNU General Public License along
- * with this program; if not, see <http://www.gnu.org/licenses/>
+ * with this program; if not, see <http://www.gnu.org/licenses/>
  */
 
 #include <QDebug>
@@ -46,24 +46,21 @@
  * @param uavField
  * @param binWidth
  * @param numberOfBins
+ * @param window Seconds of data counted, 0 to count all of it
  */
-HistogramData::HistogramData(QString uavObject, QString uavField, double binWidth, uint numberOfBins) :
+HistogramData::HistogramData(QString uavObject, QString uavField, double binWidth, uint numberOfBins, double window) :
     Plot2dData(uavObject, uavField),
     histogram(0),
     histogramBins(0),
-    histogramInterval(0),
-    intervalSeriesData(0)
+    binsChanged(false)
 {
-    this->binWidth = binWidth;
-    this->numberOfBins = numberOfBins;
     scalePower = 1;
 
-    //Create histogram data set
-    histogramBins = new QVector<QwtIntervalSample>();
-    histogramInterval = new QVector<QwtInterval>();
+    if (numberOfBins > MAX_NUMBER_OF_INTERVALS)
+        numberOfBins = MAX_NUMBER_OF_INTERVALS;
 
-    // Generate the interval series
-    intervalSeriesData = new QwtIntervalSeriesData(*histogramBins);
+    //Create histogram data set
+    histogramBins = new HistogramBins(binWidth, numberOfBins, window);
 }
 
 
@@ -77,9 +74,12 @@ void HistogramData::plotNewData(PlotData* plot2dData, ScopeConfig *scopeConfig,
     Q_UNUSED(scopeGadgetWidget);
     Q_UNUSED(scopeConfig);
 
-    //Plot new data
-    histogram->setData(intervalSeriesData);
-    intervalSeriesData->setSamples(*histogramBins);
+    //Plot new data. The samples are read from the bins on the next replot,
+    //so only tell the histogram they changed.
+    if (binsChanged) {
+        binsChanged = false;
+        histogram->dataChanged();
+    }
 }
 
 
@@ -95,78 +95,16 @@ bool HistogramData::append(UAVObject* obj)
     xData->clear();
     yData->clear();
 
-    if (uavObjectName == obj->getName()) {
-
-        //Get the field of interest
-        UAVObjectField* field =  obj->getField(uavFieldName);
-
-        //Bad place to do this
-        double step = binWidth;
-        if (step < 1e-6) //Don't allow step size to be 0.
-            step =1e-6;
-
-        if (numberOfBins > MAX_NUMBER_OF_INTERVALS)
-            numberOfBins = MAX_NUMBER_OF_INTERVALS;
-
-        if (field) {
-            double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-            // Extend interval, if necessary
-            if(!histogramInterval->empty()){
-                while (currentValue < histogramInterval->front().minValue()
-                       && histogramInterval->size() <= (int) numberOfBins){
-                    histogramInterval->prepend(QwtInterval(histogramInterval->front().minValue() - step, histogramInterval->front().minValue()));
-                    histogramBins->prepend(QwtIntervalSample(0,histogramInterval->front()));
-                }
-
-                while (currentValue > histogramInterval->back().maxValue()
-                       && histogramInterval->size() <= (int) numberOfBins){
-                    histogramInterval->append(QwtInterval(histogramInterval->back().maxValue(), histogramInterval->back().maxValue() + step));
-                    histogramBins->append(QwtIntervalSample(0,histogramInterval->back()));
-                }
-
-                // If the histogram reaches its max size, pop one off the end and return
-                // This is a graceful way not to lock up the GCS if the bin width
-                // is inappropriate, or if there is an extremely distant outlier.
-                if (histogramInterval->size() > (int) numberOfBins )
-                {
-                    histogramBins->pop_back();
-                    histogramInterval->pop_back();
-                    return false;
-                }
-
-                // Test all intervals. This isn't particularly effecient, especially if we have just
-                // extended the interval and thus know for sure that the point lies on the extremity.
-                // On top of that, some kind of search by bisection would be better.
-                for (int i=0; i < histogramInterval->size(); i++ ){
-                    if(histogramInterval->at(i).contains(currentValue)){
-                        histogramBins->replace(i, QwtIntervalSample(histogramBins->at(i).value + 1, histogramInterval->at(i)));
-                        break;
-                    }
-
-                }
-            }
-            else{
-                // Create first interval
-                double tmp=0;
-                if (tmp < currentValue){
-                    while (tmp < currentValue){
-                        tmp+=step;
-                    }
-                    histogramInterval->append(QwtInterval(tmp-step, tmp));
-                }
-                else{
-                    while (tmp > step){
-                        tmp-=step;
-                    }
-                    histogramInterval->append(QwtInterval(tmp, tmp+step));
-                }
-
-                histogramBins->append(QwtIntervalSample(0,histogramInterval->front()));
-            }
-
-
-            return true;
+    if (obj == boundObject) {
+
+        //The field of interest was resolved by bindTo()
+        if (boundField) {
+            double currentValue = boundField->getDouble(boundElement) * pow(10, scalePower);
+
+            // Even a value that doesn't fit may have moved the window
+            bool added = histogramBins->add(currentValue, sampleTime(obj));
+            binsChanged = true;
+            return added;
         }
     }
 
@@ -180,14 +118,10 @@ void HistogramData::deletePlots(PlotData *histogramData)
 {
     histogram->detach();
 
-    // Delete data bins
-    delete histogramInterval;
-    delete histogramBins;
-
-    // Don't delete intervalSeriesData, this is done by the histogram's destructor
-    /* delete intervalSeriesData; */
+    // Don't delete histogramBins, this is done by the histogram's destructor
+    /* delete histogramBins; */
 
-    // Delete histogram (also deletes intervalSeriesData)
+    // Delete histogram (also deletes histogramBins)
     delete histogram;
 
     delete histogramData;
@@ -200,5 +134,5 @@ void HistogramData::deletePlots(PlotData *histogramData)
 void HistogramData::clearPlots()
 {
     histogramBins->clear();
-    histogramInterval->clear();
+    binsChanged = true;
 }
@@ -28,6 +28,7 @@
 #define HISTOGRAMDATA_H
 
 #include "scopes2d/plotdata2d.h"
+#include "scopes2d/histogrambins.h"
 #include "uavobject.h"
 
 #include "qwt/src/qwt_plot_histogram.h"
@@ -46,7 +47,7 @@ class HistogramData : public Plot2dData
 {
     Q_OBJECT
 public:
-    HistogramData(QString uavObject, QString uavField, double binWidth, uint numberOfBins);
+    HistogramData(QString uavObject, QString uavField, double binWidth, uint numberOfBins, double window);
     ~HistogramData() {}
 
     bool append(UAVObject* obj);
@@ -56,17 +57,13 @@ public:
     virtual void deletePlots(PlotData *);
     void clearPlots();
 
-    QwtIntervalSeriesData *getIntervalSeriesData(){return intervalSeriesData;}
+    HistogramBins *getIntervalSeriesData(){return histogramBins;}
     void setHistogram(QwtPlotHistogram *val){histogram = val;}
 
 private:
     QwtPlotHistogram *histogram;
-    QVector<QwtIntervalSample> *histogramBins; //Used for histograms
-    QVector<QwtInterval> *histogramInterval;
-    QwtIntervalSeriesData *intervalSeriesData;
-
-    double binWidth;
-    uint numberOfBins;
+    HistogramBins *histogramBins; //Owned by the histogram once attached
+    bool binsChanged;
 
 private slots:
 
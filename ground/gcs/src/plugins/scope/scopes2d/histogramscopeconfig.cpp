@@ -46,6 +46,7 @@ HistogramScopeConfig::HistogramScopeConfig()
 {
     binWidth = 1;
     maxNumberOfBins = 1000;
+    window = 0;
     m_refreshInterval = 50;
 }
 
@@ -61,6 +62,7 @@ HistogramScopeConfig::HistogramScopeConfig(QSettings *qSettings)
         binWidth = 1e-3;
 
     maxNumberOfBins = qSettings->value("maxNumberOfBins").toInt();
+    window = qSettings->value("window", 0).toDouble();
     this->m_refreshInterval = m_refreshInterval;
     this->m_plotDimensions = m_plotDimensions;
 
@@ -99,6 +101,7 @@ HistogramScopeConfig::HistogramScopeConfig(Ui::ScopeGadgetOptionsPage *options_p
 
     binWidth = options_page->spnBinWidth->value();
     maxNumberOfBins = options_page->spnMaxNumBins->value();
+    window = options_page->spnHistogramWindow->value();
 
     //For each y-data source in the list
     for(int iIndex = 0; iIndex < options_page->lst2dCurves->count();iIndex++) {
@@ -149,6 +152,7 @@ ScopeConfig* HistogramScopeConfig::cloneScope(ScopeConfig *originalScope)
 
     cloneObj->binWidth = originalHistogramScopeConfig->binWidth;
     cloneObj->maxNumberOfBins = originalHistogramScopeConfig->maxNumberOfBins;
+    cloneObj->window = originalHistogramScopeConfig->window;
     cloneObj->m_refreshInterval = originalHistogramScopeConfig->m_refreshInterval;
 
     int histogramSourceCount = originalHistogramScopeConfig->m_HistogramSourceConfigs.size();
@@ -184,6 +188,7 @@ void HistogramScopeConfig::saveConfiguration(QSettings* qSettings)
     qSettings->setValue("plot2dType", HISTOGRAM);
     qSettings->setValue("binWidth", binWidth);
     qSettings->setValue("maxNumberOfBins", maxNumberOfBins);
+    qSettings->setValue("window", window);
 
     int dataSourceCount = m_HistogramSourceConfigs.size();
     qSettings->setValue("dataSourceCount", dataSourceCount);
@@ -241,7 +246,7 @@ void HistogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWidge
         units = getUavObjectFieldUnits(histogramDataSourceConfig->uavObjectName, histogramDataSourceConfig->uavFieldName);
 
         HistogramData* histogramData;
-        histogramData = new HistogramData(histogramDataSourceConfig->uavObjectName, histogramDataSourceConfig->uavFieldName, binWidth, maxNumberOfBins);
+        histogramData = new HistogramData(histogramDataSourceConfig->uavObjectName, histogramDataSourceConfig->uavFieldName, binWidth, maxNumberOfBins, window);
 
         histogramData->setScalePower(histogramDataSourceConfig->yScalePower);
         histogramData->setMeanSamples(histogramDataSourceConfig->yMeanSamples);
@@ -287,7 +292,7 @@ void HistogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWidge
         scopeGadgetWidget->insertDataSources(histogramNameScaled, histogramData);
 
         // Connect the UAVO
-        scopeGadgetWidget->connectUAVO(obj);
+        scopeGadgetWidget->connectUAVO(obj, histogramData);
     }
     scopeGadgetWidget->replot();
 }
@@ -311,6 +316,7 @@ void HistogramScopeConfig::setGuiConfiguration(Ui::ScopeGadgetOptionsPage *optio
     foreach (Plot2dCurveConfiguration* dataSource,  m_HistogramSourceConfigs) {
         options_page->spnMaxNumBins->setValue(maxNumberOfBins);
         options_page->spnBinWidth->setValue(binWidth);
+        options_page->spnHistogramWindow->setValue(window);
 
         QString uavObjectName = dataSource->uavObjectName;
         QString uavFieldName = dataSource->uavFieldName;
@@ -53,11 +53,13 @@ public:
     virtual int getScopeType(){return (int) HISTOGRAM;}
     double getBinWidth(){return binWidth;}
     unsigned int getMaxNumberOfBins(){return maxNumberOfBins;}
+    double getWindow(){return window;}
     virtual QList<Plot2dCurveConfiguration*> getDataSourceConfigs(){return m_HistogramSourceConfigs;}
 
     //Setter functions
     void setBinWidth(double val){binWidth = val;}
     void setMaxNumberOfBins(unsigned int val){maxNumberOfBins = val;}
+    void setWindow(double val){window = val;}
 
     virtual ScopeConfig* cloneScope(ScopeConfig *histogramSourceConfigs);
 
@@ -70,6 +72,7 @@ public:
 private:
     double binWidth;
     unsigned int maxNumberOfBins;
+    double window; // Seconds of data counted, 0 for all of it
     QString units;
 
     QList<Plot2dCurveConfiguration*> m_HistogramSourceConfigs;
@@ -0,0 +1,462 @@
+/**
+ ******************************************************************************
+ *
+ * @file       ringseries.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Circular sample storage for the scatterplot curves
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "scopes2d/ringseries.h"
+
+#include <math.h>
+
+
+// Each level of the envelope pyramid merges this many blocks below it
+static const int LEVEL_SHIFT = 2;
+
+
+RingSeries::RingSeries(int capacity) :
+    mask(0),
+    head(0),
+    count(0),
+    appended(0),
+    levelsFrom(0),
+    changes(0)
+{
+    reserve(capacity);
+}
+
+
+/**
+ * @brief RingSeries::reserve Grow the buffer to hold at least capacity samples
+ */
+void RingSeries::reserve(int capacity)
+{
+    if (capacity <= samples.size())
+        return;
+
+    int newSize = 1;
+    while (newSize < capacity)
+        newSize <<= 1;
+
+    // Every sample stays at its index modulo the size
+    QVector<QPointF> grown(newSize);
+    int newMask = newSize - 1;
+    quint64 firstIndex = appended - count;
+    for (int i = 0; i < count; i++)
+        grown[(firstIndex + i) & newMask] = at(i);
+
+    samples.swap(grown);
+    mask = newMask;
+    head = firstIndex & mask;
+
+    rebuildLevels();
+}
+
+
+void RingSeries::append(const QPointF &sample)
+{
+    if (count == samples.size())
+        reserve(count * 2);
+
+    samples[appended & mask] = sample;
+    addToLevels(appended, sample.y());
+
+    appended++;
+    count++;
+    changes++;
+}
+
+
+void RingSeries::popFront()
+{
+    if (count == 0)
+        return;
+
+    head = (head + 1) & mask;
+    count--;
+    changes++;
+}
+
+
+void RingSeries::clear()
+{
+    count = 0;
+    head = appended & mask;
+    levelsFrom = appended;
+    changes++;
+}
+
+
+/**
+ * @brief RingSeries::lowerBound Find the first sample at or after x,
+ * the samples being in increasing x
+ */
+int RingSeries::lowerBound(double x) const
+{
+    int low = 0;
+    int high = count;
+
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (at(middle).x() < x)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+
+/**
+ * @brief RingSeries::envelope Get the samples from first to last, reduced
+ * to the minimum and maximum of each block when there are more of them
+ * than maxPoints
+ * @param sequential Use the position in the range as x
+ */
+void RingSeries::envelope(int first, int last, int maxPoints, bool sequential, QVector<QPointF> &out) const
+{
+    out.clear();
+    if (first > last)
+        return;
+
+    // Use the finest level that has at most maxPoints blocks in the range
+    int length = last - first + 1;
+    int level = -1;
+    while (level + 1 < levels.size() && (length >> ((level + 1) * LEVEL_SHIFT)) > maxPoints)
+        level++;
+
+    quint64 base = appended - count + first;
+    emitRange(base, base + length, level, sequential, out);
+
+    // Number sequential samples from the oldest one held
+    if (sequential) {
+        for (int i = 0; i < out.size(); i++)
+            out[i].rx() -= appended - count;
+    }
+}
+
+
+void RingSeries::addToLevels(quint64 index, double y)
+{
+    for (int l = 0; l < levels.size(); l++) {
+        int shift = (l + 1) * LEVEL_SHIFT;
+        QVector<Envelope> &level = levels[l];
+        Envelope &envelope = level[(index >> shift) & (level.size() - 1)];
+
+        // Start the block over on its first sample
+        if ((index & ((Q_UINT64_C(1) << shift) - 1)) == 0 || index == levelsFrom) {
+            envelope.minIndex = envelope.maxIndex = index;
+            envelope.minY = envelope.maxY = y;
+        } else if (y < envelope.minY) {
+            envelope.minIndex = index;
+            envelope.minY = y;
+        } else if (y > envelope.maxY) {
+            envelope.maxIndex = index;
+            envelope.maxY = y;
+        }
+    }
+}
+
+
+/**
+ * @brief RingSeries::rebuildLevels Size the pyramid for the capacity and
+ * fill it from the samples held
+ */
+void RingSeries::rebuildLevels()
+{
+    levels.clear();
+    for (int shift = LEVEL_SHIFT; (samples.size() >> shift) >= 4; shift += LEVEL_SHIFT) {
+        // Enough blocks for a full buffer starting part way into one
+        int blocks = 1;
+        while (blocks < (samples.size() >> shift) + 2)
+            blocks <<= 1;
+        levels.append(QVector<Envelope>(blocks));
+    }
+
+    levelsFrom = appended - count;
+    for (int i = 0; i < count; i++)
+        addToLevels(levelsFrom + i, at(i).y());
+}
+
+
+/**
+ * @brief RingSeries::emitRange Output the samples from begin to end,
+ * using the blocks of a level wherever they fit whole and the levels
+ * below for the partial blocks at either end
+ */
+void RingSeries::emitRange(quint64 begin, quint64 end, int level, bool sequential, QVector<QPointF> &out) const
+{
+    if (level < 0) {
+        for (quint64 i = begin; i < end; i++)
+            emitSample(i, samples.at(i & mask).y(), sequential, out);
+        return;
+    }
+
+    int shift = (level + 1) * LEVEL_SHIFT;
+    quint64 blockSize = Q_UINT64_C(1) << shift;
+    quint64 blockBegin = (begin + blockSize - 1) & ~(blockSize - 1);
+    quint64 blockEnd = end & ~(blockSize - 1);
+
+    if (blockBegin >= blockEnd) {
+        emitRange(begin, end, level - 1, sequential, out);
+        return;
+    }
+
+    emitRange(begin, blockBegin, level - 1, sequential, out);
+
+    const QVector<Envelope> &blocks = levels.at(level);
+    for (quint64 block = blockBegin >> shift; block < (blockEnd >> shift); block++) {
+        const Envelope &envelope = blocks.at(block & (blocks.size() - 1));
+
+        // Keep the extremes in the order they happened
+        if (envelope.minIndex < envelope.maxIndex) {
+            emitSample(envelope.minIndex, envelope.minY, sequential, out);
+            emitSample(envelope.maxIndex, envelope.maxY, sequential, out);
+        } else if (envelope.minIndex > envelope.maxIndex) {
+            emitSample(envelope.maxIndex, envelope.maxY, sequential, out);
+            emitSample(envelope.minIndex, envelope.minY, sequential, out);
+        } else {
+            emitSample(envelope.minIndex, envelope.minY, sequential, out);
+        }
+    }
+
+    emitRange(blockEnd, end, level - 1, sequential, out);
+}
+
+
+void RingSeries::emitSample(quint64 index, double y, bool sequential, QVector<QPointF> &out) const
+{
+    if (sequential)
+        out.append(QPointF(index, y));
+    else
+        out.append(QPointF(samples.at(index & mask).x(), y));
+}
+
+
+RingSeriesData::RingSeriesData(const RingSeries *series, bool sequential) :
+    series(series),
+    sequential(sequential),
+    resolution(0),
+    boundsRevision(series->revision() - 1),
+    decimated(false),
+    pointsValid(false),
+    pointsRevision(0)
+{
+}
+
+
+/**
+ * @brief RingSeriesData::setResolution Set the pixels across the plot,
+ * past which the samples shown are reduced to their envelope
+ */
+void RingSeriesData::setResolution(int pixels)
+{
+    if (pixels == resolution)
+        return;
+
+    resolution = pixels;
+    pointsValid = false;
+    boundsRevision = series->revision() - 1;
+}
+
+
+void RingSeriesData::setRectOfInterest(const QRectF &rect)
+{
+    interest = rect;
+    pointsValid = false;
+    boundsRevision = series->revision() - 1;
+}
+
+
+size_t RingSeriesData::size() const
+{
+    updatePoints();
+
+    return decimated ? points.size() : series->size();
+}
+
+
+QPointF RingSeriesData::sample(size_t i) const
+{
+    updatePoints();
+
+    if (decimated)
+        return points.at(i);
+    if (sequential)
+        return QPointF(i, series->at(i).y());
+
+    return series->at(i);
+}
+
+
+/**
+ * @brief RingSeriesData::boundingRect Bounds of the samples, only
+ * recalculated after the series changed
+ */
+QRectF RingSeriesData::boundingRect() const
+{
+    if (boundsRevision != series->revision()) {
+        d_boundingRect = qwtBoundingRect(*this);
+        boundsRevision = series->revision();
+    }
+
+    return d_boundingRect;
+}
+
+
+/**
+ * @brief RingSeriesData::updatePoints Reduce the visible samples to their
+ * envelope when they outnumber the pixels, once per change
+ */
+void RingSeriesData::updatePoints() const
+{
+    if (pointsValid && pointsRevision == series->revision())
+        return;
+
+    pointsValid = true;
+    pointsRevision = series->revision();
+
+    // Keep a sample past each edge so the curve runs off the plot
+    int first = 0;
+    int last = series->size() - 1;
+    if (interest.width() > 0 && !series->isEmpty()) {
+        if (sequential) {
+            first = qBound(0, (int) floor(interest.left()), last);
+            last = qBound(first, (int) ceil(interest.right()) + 1, last);
+        } else {
+            first = qMax(0, series->lowerBound(interest.left()) - 1);
+            last = qMax(first, qMin(last, series->lowerBound(interest.right())));
+        }
+    }
+
+    decimated = resolution > 0 && last - first + 1 > 2 * resolution;
+    if (decimated) {
+        series->envelope(first, last, resolution, sequential, points);
+    } else {
+        points.clear();
+    }
+}
+
+
+WindowStats::WindowStats() :
+    head(0),
+    count(0),
+    avg(0),
+    m2(0),
+    sinceRecompute(0)
+{
+    history.resize(1);
+}
+
+
+/**
+ * @brief WindowStats::setWindow Set the number of samples averaged,
+ * starting over when it changes
+ */
+void WindowStats::setWindow(int samples)
+{
+    if (samples < 1)
+        samples = 1;
+    if (samples == history.size())
+        return;
+
+    history.resize(samples);
+    clear();
+}
+
+
+void WindowStats::append(double value)
+{
+    int window = history.size();
+
+    if (count == window) {
+        // Take the oldest sample out of the window
+        double oldest = history[head];
+        double delta = oldest - avg;
+        if (count > 1) {
+            avg -= delta / (count - 1);
+            m2 -= delta * (oldest - avg);
+        } else {
+            avg = 0;
+            m2 = 0;
+        }
+        count--;
+        head = (head + 1) % window;
+    }
+
+    history[(head + count) % window] = value;
+    count++;
+
+    double delta = value - avg;
+    avg += delta / count;
+    m2 += delta * (value - avg);
+
+    if (++sinceRecompute >= window)
+        recompute();
+}
+
+
+void WindowStats::clear()
+{
+    head = 0;
+    count = 0;
+    avg = 0;
+    m2 = 0;
+    sinceRecompute = 0;
+}
+
+
+/**
+ * @brief WindowStats::stdDev Sample standard deviation, with Bessel's correction
+ */
+double WindowStats::stdDev() const
+{
+    if (count < 2 || m2 <= 0)
+        return 0;
+
+    return sqrt(m2 / (count - 1));
+}
+
+
+void WindowStats::recompute()
+{
+    int window = history.size();
+
+    double sum = 0;
+    for (int i = 0; i < count; i++)
+        sum += history[(head + i) % window];
+    avg = sum / count;
+
+    m2 = 0;
+    for (int i = 0; i < count; i++) {
+        double delta = history[(head + i) % window] - avg;
+        m2 += delta * delta;
+    }
+
+    sinceRecompute = 0;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,161 @@
+/**
+ ******************************************************************************
+ *
+ * @file       ringseries.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Circular sample storage for the scatterplot curves
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef RINGSERIES_H
+#define RINGSERIES_H
+
+#include "qwt/src/qwt_series_data.h"
+
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+
+
+/**
+ * @brief The RingSeries class Samples of a curve in a circular buffer, so
+ * dropping the oldest sample is O(1). The capacity is a power of two and
+ * only grows, so once a time window is filled nothing is allocated.
+ *
+ * A pyramid of min/max envelopes is kept up to date as samples arrive.
+ * Each level merges four blocks of the one below, so a range of any
+ * length can be drawn with a number of points set by the pixels
+ * available, without losing the peaks.
+ */
+class RingSeries
+{
+public:
+    RingSeries(int capacity = 1024);
+
+    void append(const QPointF &sample);
+    void popFront();
+    void clear();
+    void reserve(int capacity);
+
+    int size() const {return count;}
+    bool isEmpty() const {return count == 0;}
+    const QPointF &at(int i) const {return samples.at((head + i) & mask);}
+    const QPointF &first() const {return at(0);}
+    const QPointF &last() const {return at(count - 1);}
+
+    int lowerBound(double x) const;
+    void envelope(int first, int last, int maxPoints, bool sequential, QVector<QPointF> &out) const;
+
+    //! Increments on every change, to tell when cached bounds are stale
+    quint32 revision() const {return changes;}
+
+private:
+    typedef struct {
+        quint64 minIndex;
+        double minY;
+        quint64 maxIndex;
+        double maxY;
+    } Envelope;
+
+    void addToLevels(quint64 index, double y);
+    void rebuildLevels();
+    void emitRange(quint64 begin, quint64 end, int level, bool sequential, QVector<QPointF> &out) const;
+    void emitSample(quint64 index, double y, bool sequential, QVector<QPointF> &out) const;
+
+    QVector<QPointF> samples;
+    int mask;
+    int head;
+    int count;
+    quint64 appended;       // Samples ever appended, the index of the next one
+    quint64 levelsFrom;     // First sample the envelopes know about
+    QVector<QVector<Envelope> > levels;
+    quint32 changes;
+};
+
+
+/**
+ * @brief The RingSeriesData class Hands a RingSeries to a curve without
+ * copying it. The curve owns this view, the series stays with the plot
+ * data, which must outlive the curve.
+ */
+class RingSeriesData : public QwtSeriesData<QPointF>
+{
+public:
+    RingSeriesData(const RingSeries *series, bool sequential = false);
+
+    void setResolution(int pixels);
+
+    virtual size_t size() const;
+    virtual QPointF sample(size_t i) const;
+    virtual QRectF boundingRect() const;
+    virtual void setRectOfInterest(const QRectF &rect);
+
+private:
+    void updatePoints() const;
+
+    const RingSeries *series;
+    bool sequential;    // Plot against the sample index instead of x
+    int resolution;     // Pixels across the plot, or 0 to draw every sample
+    QRectF interest;
+    mutable quint32 boundsRevision;
+
+    //! The envelope drawn while the visible samples outnumber the pixels
+    mutable QVector<QPointF> points;
+    mutable bool decimated;
+    mutable bool pointsValid;
+    mutable quint32 pointsRevision;
+};
+
+
+/**
+ * @brief The WindowStats class Mean and standard deviation over the last
+ * samples, in O(1) per sample using Welford's method. The state is
+ * rebuilt from the window every window length, so rounding errors can't
+ * accumulate.
+ */
+class WindowStats
+{
+public:
+    WindowStats();
+
+    void setWindow(int samples);
+    void append(double value);
+    void clear();
+
+    double mean() const {return avg;}
+    double stdDev() const;
+
+private:
+    void recompute();
+
+    QVector<double> history;
+    int head;
+    int count;
+    double avg;
+    double m2;          // Sum of squared differences from the mean
+    int sinceRecompute;
+};
+
+#endif // RINGSERIES_H
+
+/**
+ * @}
+ * @}
+ */
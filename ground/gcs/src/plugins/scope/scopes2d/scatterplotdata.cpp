@@ -48,14 +48,18 @@ void TimeSeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeCon
     Q_UNUSED(scopeConfig);
     Q_UNUSED(scopeGadgetWidget);
 
-    //Plot new data
+    // Plot new data, the curve draws straight from the samples. Draw no
+    // more than a min/max pair per pixel
+    seriesData->setResolution(scopeGadgetWidget->canvas()->width());
     if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+        curve->itemChanged();
 
-    QDateTime NOW = QDateTime::currentDateTime();
-    double toTime = NOW.toTime_t();
-    toTime += NOW.time().msec() / 1000.0;
+    // A log being viewed stays where it was zoomed to
+    if (scopeGadgetWidget->isViewingLog())
+        return;
 
+    // Follow the data rather than the wall clock, replays run faster
+    double toTime = scopeGadgetWidget->getPlotTime();
     scopeGadgetWidget->setAxisScale(QwtPlot::xBottom, toTime - m_xWindowSize, toTime);
 }
 
@@ -70,9 +74,11 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
     Q_UNUSED(scopeConfig);
     Q_UNUSED(scopeGadgetWidget);
 
-    //Plot new data
+    // Plot new data, the curve draws straight from the samples. Draw no
+    // more than a min/max pair per pixel
+    seriesData->setResolution(scopeGadgetWidget->canvas()->width());
     if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+        curve->itemChanged();
 }
 
 
@@ -83,58 +89,18 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
  */
 bool SeriesPlotData::append(UAVObject* obj)
 {
-    if (uavObjectName == obj->getName()) {
-
-        //Get the field of interest
-        UAVObjectField* field =  obj->getField(uavFieldName);
-
-        if (field) {
-
-            double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-            //Perform scope math, if necessary
-            if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
-                //Put the new value at the front
-                yDataHistory->append( currentValue );
-
-                // calculate average value
-                meanSum += currentValue;
-                if(yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum+=currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg=meanSum/yDataHistory->size();
-
-                if ( mathFunction  == "Standard deviation" ){
-                    //Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum=0;
-                    for (int i=0; i < yDataHistory->size(); i++){
-                        stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
-                    }
-                    yData->append(sqrt(stdSum));
-                }
-                else  {
-                    yData->append(boxcarAvg);
-                }
-            }
-            else{
-                yData->append( currentValue );
-            }
-
-            if (yData->size() > getXWindowSize()) { //If new data overflows the window, remove old data...
-                yData->pop_front();
-            } else //...otherwise, add a new y point at position xData
-                xData->insert(xData->size(), xData->size());
+    if (obj == boundObject) {
+
+        //The field of interest was resolved by bindTo()
+        if (boundField) {
+
+            double currentValue = boundField->getDouble(boundElement) * pow(10, scalePower);
+
+            // If new data overflows the window, remove old data. The curve
+            // plots against the sample index, so the x values don't matter
+            samples.append(QPointF(0, applyMath(currentValue)));
+            if (samples.size() > getXWindowSize())
+                samples.popFront();
 
             return true;
         }
@@ -151,54 +117,12 @@ bool SeriesPlotData::append(UAVObject* obj)
  */
 bool TimeSeriesPlotData::append(UAVObject* obj)
 {
-    if (uavObjectName == obj->getName()) {
-        //Get the field of interest
-        UAVObjectField* field =  obj->getField(uavFieldName);
-
-        if (field) {
-            QDateTime NOW = QDateTime::currentDateTime(); //THINK ABOUT REIMPLEMENTING THIS TO SHOW UAVO TIME, NOT SYSTEM TIME
-            double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-            //Perform scope math, if necessary
-            if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
-                //Put the new value at the back
-                yDataHistory->append( currentValue );
-
-                // calculate average value
-                meanSum += currentValue;
-                if(yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum+=currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg=meanSum/yDataHistory->size();
-
-                if ( mathFunction  == "Standard deviation" ){
-                    //Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum=0;
-                    for (int i=0; i < yDataHistory->size(); i++){
-                        stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
-                    }
-                    yData->append(sqrt(stdSum));
-                }
-                else  {
-                    yData->append(boxcarAvg);
-                }
-            }
-            else{
-                yData->append( currentValue );
-            }
-
-            double valueX = NOW.toTime_t() + NOW.time().msec() / 1000.0;
-            xData->append(valueX);
+    if (obj == boundObject) {
+        //The field of interest was resolved by bindTo()
+        if (boundField) {
+            double currentValue = boundField->getDouble(boundElement) * pow(10, scalePower);
+
+            samples.append(QPointF(sampleTime(obj), applyMath(currentValue)));
 
             //Remove stale data
             removeStaleData();
@@ -212,26 +136,32 @@ bool TimeSeriesPlotData::append(UAVObject* obj)
 
 
 /**
- * @brief TimeSeriesPlotData::removeStaleData Removes stale data from time series plot
+ * @brief TimeSeriesPlotData::loadSamples Replace the samples with a whole
+ * recording at once, such as a decoded log. Nothing is dropped for being
+ * outside the time window, the envelopes keep drawing it cheap.
+ * @param times Sample times, in s and increasing
+ * @param values Unscaled values, one for each time
  */
-void TimeSeriesPlotData::removeStaleData()
+void TimeSeriesPlotData::loadSamples(const QVector<double> &times, const QVector<double> &values)
 {
-    double newestValue;
-    double oldestValue;
+    clearPlots();
+    samples.reserve(times.size());
 
-    while (1) {
-        if (xData->size() == 0)
-            break;
+    double scale = pow(10, scalePower);
+    for (int i = 0; i < times.size(); i++)
+        samples.append(QPointF(times[i], applyMath(values[i] * scale)));
 
-        newestValue = xData->last();
-        oldestValue = xData->first();
+    setUpdatedFlagToTrue();
+}
 
-        if (newestValue - oldestValue > getXWindowSize()) {
-            yData->pop_front();
-            xData->pop_front();
-        } else
-            break;
-    }
+
+/**
+ * @brief TimeSeriesPlotData::removeStaleData Removes stale data from time series plot
+ */
+void TimeSeriesPlotData::removeStaleData()
+{
+    while (!samples.isEmpty() && samples.last().x() - samples.first().x() > getXWindowSize())
+        samples.popFront();
 }
 
 
@@ -244,6 +174,37 @@ void TimeSeriesPlotData::removeStaleDataTimeout()
 }
 
 
+/**
+ * @brief ScatterplotData::setCurve Set the curve drawing the samples
+ */
+void ScatterplotData::setCurve(QwtPlotCurve *val)
+{
+    curve = val;
+    seriesData = new RingSeriesData(&samples, sequential);
+    curve->setData(seriesData);
+}
+
+
+/**
+ * @brief ScatterplotData::applyMath Apply the scope math function to a new value
+ * @param currentValue The scaled value
+ * @return The value to plot
+ */
+double ScatterplotData::applyMath(double currentValue)
+{
+    if (mathFunction == "Boxcar average" || mathFunction == "Standard deviation") {
+        stats.setWindow(meanSamples);
+        stats.append(currentValue);
+
+        if (mathFunction == "Standard deviation")
+            return stats.stdDev();
+        return stats.mean();
+    }
+
+    return currentValue;
+}
+
+
 /**
  * @brief ScatterplotData::deletePlots Delete all plot data
  */
@@ -261,6 +222,6 @@ void ScatterplotData::deletePlots(PlotData *scatterplotData)
  */
 void ScatterplotData::clearPlots()
 {
-    yData->clear();
-    xData->clear();
+    samples.clear();
+    stats.clear();
 }
@@ -28,6 +28,7 @@
 #define SCATTERPLOTDATA_H
 
 #include "scopes2d/plotdata2d.h"
+#include "scopes2d/ringseries.h"
 #include "uavobject.h"
 #include "qwt/src/qwt_plot_curve.h"
 
@@ -44,16 +45,24 @@ class ScatterplotData : public Plot2dData
     Q_OBJECT
 public:
     ScatterplotData(QString uavObject, QString uavField):
-        Plot2dData(uavObject, uavField){curve = 0;}
+        Plot2dData(uavObject, uavField){curve = 0; seriesData = 0; sequential = false;}
     ~ScatterplotData(){}
 
     virtual void deletePlots(PlotData *);
     void clearPlots();
 
-    void setCurve(QwtPlotCurve *val){curve = val;}
+    void setCurve(QwtPlotCurve *val);
+    QwtPlotCurve *getCurve(){return curve;}
+    const RingSeries *getSamples(){return &samples;}
 
 protected:
+    double applyMath(double currentValue);
+
     QwtPlotCurve* curve;
+    RingSeries samples;     // Drawn by the curve in place
+    RingSeriesData *seriesData; // Owned by the curve
+    WindowStats stats;      // For the boxcar average and standard deviation
+    bool sequential;        // Samples are plotted against their index
 };
 
 
@@ -67,7 +76,7 @@ class SeriesPlotData : public ScatterplotData
     Q_OBJECT
 public:
     SeriesPlotData(QString uavObject, QString uavField)
-            : ScatterplotData(uavObject, uavField) {}
+            : ScatterplotData(uavObject, uavField) {sequential = true;}
     ~SeriesPlotData() {}
 
     /*!
@@ -100,6 +109,7 @@ public:
     }
 
     bool append(UAVObject* obj);
+    void loadSamples(const QVector<double> &times, const QVector<double> &values);
 
     virtual void removeStaleData();
     virtual void plotNewData(PlotData *, ScopeConfig *, ScopeGadgetWidget *);
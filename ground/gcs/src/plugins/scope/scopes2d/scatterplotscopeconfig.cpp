@@ -298,15 +298,14 @@ void Scatterplot2dScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetW
         //Create the curve plot
         QwtPlotCurve* plotCurve = new QwtPlotCurve(curveNameScaledMath);
         plotCurve->setPen(QPen(QBrush(QColor(color), Qt::SolidPattern), (qreal)1, Qt::SolidLine, Qt::SquareCap, Qt::BevelJoin));
-        plotCurve->setSamples(*(scatterplotData->getXData()), *(scatterplotData->getYData()));
-        plotCurve->attach(scopeGadgetWidget);
         scatterplotData->setCurve(plotCurve);
+        plotCurve->attach(scopeGadgetWidget);
 
         //Keep the curve details for later
         scopeGadgetWidget->insertDataSources(curveNameScaledMath, scatterplotData);
 
         // Connect the UAVO
-        scopeGadgetWidget->connectUAVO(obj);
+        scopeGadgetWidget->connectUAVO(obj, scatterplotData);
     }
     scopeGadgetWidget->replot();
 }
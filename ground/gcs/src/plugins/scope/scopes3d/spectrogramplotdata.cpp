@@ -35,13 +35,10 @@
 
 #include "qwt/src/qwt.h"
 #include "qwt/src/qwt_color_map.h"
-#include "qwt/src/qwt_matrix_raster_data.h"
 #include "qwt/src/qwt_plot_spectrogram.h"
 #include "qwt/src/qwt_scale_draw.h"
 #include "qwt/src/qwt_scale_widget.h"
 
-#define PI 3.1415926535897932384626433832795
-
 /**
  * @brief SpectrogramData
  * @param uavObject
@@ -54,23 +51,23 @@ SpectrogramData::SpectrogramData(QString uavObject, QString uavField, double sam
         : Plot3dData(uavObject, uavField),
           spectrogram(0),
           rasterData(0),
-          fft_object(0)
+          overlap(0)
 {
     this->samplingFrequency = samplingFrequency;
     this->timeHorizon = timeHorizon;
     autoscaleValueUpdated = 0;
 
     // Create raster data
-    rasterData = new QwtMatrixRasterData();
+    rasterData = new SpectrogramRasterData();
     
     if(mathFunction == "FFT") {
-        fft_object = new ffft::FFTReal<double>(windowWidth);
+        stft.configure(windowWidth, windowWidth);
         windowWidth /= 2;
     }
 
     this->windowWidth = windowWidth;
 
-    rasterData->setValueMatrix( *zDataHistory, windowWidth );
+    rasterData->reset(windowWidth);
 
     // Set the ranges for the plot
     resetAxisRanges();
@@ -117,11 +114,9 @@ void SpectrogramData::plotNewData(PlotData *plot3dData, ScopeConfig *scopeConfig
 
     removeStaleData();
 
-    // Check for new data
+    // Check for new data. The raster already holds it, rows are added as
+    // they are computed
     if (readAndResetUpdatedFlag() == true){
-        // Plot new data
-        rasterData->setValueMatrix(*zDataHistory, windowWidth);
-
         // Check autoscale. (For some reason, QwtSpectrogram doesn't support autoscale)
         if (zMaximum == 0){
             double newVal = readAndResetAutoscaleValue();
@@ -141,10 +136,8 @@ void SpectrogramData::plotNewData(PlotData *plot3dData, ScopeConfig *scopeConfig
  */
 bool SpectrogramData::append(UAVObject* multiObj)
 {
-    QDateTime NOW = QDateTime::currentDateTime(); //TODO: Upgrade this to show UAVO time and not system time
-
     // Check to make sure it's the correct UAVO
-    if (uavObjectName == multiObj->getName()) {
+    if (multiObj == boundObject) {
 
         // Only run on UAVOs that have multiple instances
         if (multiObj->isSingleInstance()) {
@@ -196,7 +189,6 @@ bool SpectrogramData::append(UAVObject* multiObj)
             clearPlots();
 
             plotData.clear();
-            rasterData->setValueMatrix(*zDataHistory, windowWidth);
 
             qDebug() << "Spectrogram width adjusted to " << windowWidth;
         }
@@ -234,7 +226,7 @@ bool SpectrogramData::append(UAVObject* multiObj)
                 }
 
                 for (int i = 0; i < numElements; i++) {
-                    double currentValue = field->getValue(i).toDouble() / scale;  // Get the value and scale it
+                    float currentValue = field->getDouble(i) / scale;  // Get the value and scale it
 
                     //Normally some math would go here, modifying currentValue before appending it to values
                     // .
@@ -257,62 +249,45 @@ bool SpectrogramData::append(UAVObject* multiObj)
                 return false;
             }
 
-            // Check if the FFT needs to be calculated
-            // Because this function is optional we will calculate the FFT and then
-            // update the original vector. This will allow using the same code
-            // to display the information.
+            // Check if the FFT needs to be calculated. The samples are a
+            // stream to the STFT, which gives a spectrum every hop samples.
+            // With no overlap that is one per window received.
+            int rows = 1;
+            unsigned int hop = qMax(1u, (unsigned int) (valuesToProcess * (100 - qMin(overlap, 99u)) / 100));
             if (mathFunction == "FFT") {
-
-                // Check if the fft_object was already created or needs to be updated
-                // May happen if settings change after the spectrogram was created
-                if (fft_object == NULL || fft_object->get_length() != valuesToProcess) {
-                    if (fft_object != NULL)
-                        delete fft_object;
-
-                    fft_object = new ffft::FFTReal<double>(valuesToProcess);
-                }
-
-                // Hanning Window
-                for (int i = 0; i < valuesToProcess; i++) {
-                    plotData[i] *= pow(sin(PI*i/(valuesToProcess - 1) ), 2);
-                }
-
-                QVector<double> fftout(valuesToProcess);
-
-                fft_object->do_fft(&fftout[0], plotData.data()); // Do FFT
-                plotData.clear();  // Clear vector
-
-                // Lets get the magnitude and scale it.
-                // mag = X * sqrt(re^2 + im^2)/n
-                // X (4.2) is chosen so that the magnitude presented is similar to the acceleration registered
-                // although this is not 100% correct, it helps users understanding the spectrogram.
-                for (unsigned int i = 0; i < valuesToProcess/2; i++) {
-                    plotData << 4.2*sqrt(pow(fftout[i], 2) + pow(fftout[valuesToProcess/2 + i], 2)) / valuesToProcess;
-                }
+                // The plan is only rebuilt if the settings changed after the
+                // spectrogram was created
+                stft.configure(valuesToProcess, hop);
+
+                columns.resize(0);
+                rows = stft.process(plotData.constData(), plotData.size(), columns);
+            } else {
+                columns = plotData;
             }
-            
-            // Apply autoscale if enabled
-            if (zMaximum == 0) {
-				for (unsigned int i = 0; i < windowWidth; i++) {
-	                 // See if autoscale is turned on and if the value exceeds the maximum for the scope.
-	                if (plotData[i] > rasterData->interval(Qt::ZAxis).maxValue()){
-	                    // Change scope maximum and color depth
-	                    rasterData->setInterval(Qt::ZAxis, QwtInterval(0, plotData[i]) );
-	                    autoscaleValueUpdated = plotData[i];
-                	}
-            	}
-
+            plotData.clear();
 
-            }
+            // The spectra of one window are spread over the time it took
+            double time = sampleTime(multiObj);
+            double rowInterval = hop / samplingFrequency;
+
+            for (int row = 0; row < rows; row++) {
+                const float *values = columns.constData() + row * windowWidth;
+
+                // Apply autoscale if enabled
+                if (zMaximum == 0) {
+                    for (unsigned int i = 0; i < windowWidth; i++) {
+                        // See if autoscale is turned on and if the value exceeds the maximum for the scope.
+                        if (values[i] > rasterData->interval(Qt::ZAxis).maxValue()){
+                            // Change scope maximum and color depth
+                            rasterData->setInterval(Qt::ZAxis, QwtInterval(0, values[i]) );
+                            autoscaleValueUpdated = values[i];
+                        }
+                    }
+                }
 
-            timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0);
-            while (timeDataHistory->back() - timeDataHistory->front() > timeHorizon) {
-                timeDataHistory->pop_front();
-                zDataHistory->remove(0, fminl(windowWidth, zDataHistory->size()));
+                rasterData->appendRow(values, time - (rows - 1 - row) * rowInterval);
             }
-            
-            *zDataHistory << plotData;
-            plotData.clear();
+            rasterData->dropRowsBefore(time - timeHorizon);
             lastInstanceIndex = -1; // Next index will be 0
 
             return true;
@@ -344,8 +319,21 @@ void SpectrogramData::deletePlots(PlotData *spectrogramData)
  */
 void SpectrogramData::clearPlots()
 {
-    timeDataHistory->clear();
-    zDataHistory->clear();
+    rasterData->reset(windowWidth);
+    stft.reset();
 
     resetAxisRanges();
 }
+
+
+/**
+ * @brief SpectrogramData::addEmptyRows Fill the raster with blank rows, one
+ * per second from a time on, so the first rows are not stretched over the
+ * whole time horizon
+ */
+void SpectrogramData::addEmptyRows(unsigned int rows, double startTime)
+{
+    QVector<float> empty(windowWidth, 0);
+    for (unsigned int i = 0; i < rows; i++)
+        rasterData->appendRow(empty.constData(), startTime + i);
+}
@@ -30,14 +30,13 @@
 #include "scopes3d/plotdata3d.h"
 #include "uavobject.h"
 #include "qwt/src/qwt_plot_spectrogram.h"
-#include "qwt/src/qwt_matrix_raster_data.h"
+#include "scopes3d/spectrogramrasterdata.h"
+#include "scopes3d/stftengine.h"
 
 #include <QTimer>
 #include <QTime>
 #include <QVector>
 
-#include "ffft/FFTReal.h"
-
 /**
  * @brief The SpectrogramData class The spectrogram plot has a fixed size
  * data buffer. All the curves in one plot have the same size buffer.
@@ -72,22 +71,27 @@ public:
     virtual void setZMaximum(double val);
     void clearPlots();
 
+    //! Percentage of each FFT window shared with the previous one
+    void setOverlap(unsigned int val){overlap = val;}
+    void addEmptyRows(unsigned int rows, double startTime);
 
-    QwtMatrixRasterData *getRasterData(){return rasterData;}
+    SpectrogramRasterData *getRasterData(){return rasterData;}
     void setSpectrogram(QwtPlotSpectrogram *val){spectrogram = val;}
 
 private:
     void resetAxisRanges();
 
     QwtPlotSpectrogram *spectrogram;
-    QwtMatrixRasterData *rasterData;
+    SpectrogramRasterData *rasterData;
 
     double samplingFrequency;
     double timeHorizon;
     unsigned int windowWidth;
     double autoscaleValueUpdated;
-    ffft::FFTReal <double> *fft_object;
-    QVector<double> plotData;
+    unsigned int overlap;
+    StftEngine stft;
+    QVector<float> plotData;    // Samples of the window being received
+    QVector<float> columns;     // Rows to add to the raster
     int lastInstanceIndex;
 };
 
@@ -0,0 +1,152 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrogramrasterdata.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Circular raster storage for the spectrogram
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <string.h>
+#include <qnumeric.h>
+
+#include "scopes3d/spectrogramrasterdata.h"
+
+#include "qwt/src/qwt_interval.h"
+
+SpectrogramRasterData::SpectrogramRasterData() :
+    width(0),
+    capacity(0),
+    head(0),
+    count(0)
+{
+}
+
+
+/**
+ * @brief SpectrogramRasterData::reset Drop all rows
+ * @param width Values per row from now on
+ */
+void SpectrogramRasterData::reset(unsigned int width)
+{
+    if (width != this->width) {
+        this->width = width;
+        capacity = 0;
+        values.clear();
+        times.clear();
+    }
+    head = 0;
+    count = 0;
+}
+
+
+/**
+ * @brief SpectrogramRasterData::appendRow Add the newest row
+ * @param row getWidth() values
+ * @param time Time of the row, in s
+ */
+void SpectrogramRasterData::appendRow(const float *row, double time)
+{
+    if (count == capacity)
+        grow();
+
+    int slot = (head + count) % capacity;
+    memcpy(values.data() + slot * width, row, width * sizeof(float));
+    times[slot] = time;
+    count++;
+}
+
+
+/**
+ * @brief SpectrogramRasterData::dropRowsBefore Drop the rows older than a
+ * time, always keeping the newest one
+ */
+void SpectrogramRasterData::dropRowsBefore(double time)
+{
+    while (count > 1 && times[head] < time) {
+        head = (head + 1) % capacity;
+        count--;
+    }
+}
+
+
+/**
+ * @brief SpectrogramRasterData::grow Double the storage, moving the rows
+ * back to the start of it
+ */
+void SpectrogramRasterData::grow()
+{
+    int grown = capacity ? capacity * 2 : 64;
+    QVector<float> newValues(grown * width);
+    QVector<double> newTimes(grown);
+
+    for (int i = 0; i < count; i++) {
+        int slot = (head + i) % capacity;
+        memcpy(newValues.data() + i * width, values.constData() + slot * width, width * sizeof(float));
+        newTimes[i] = times[slot];
+    }
+
+    values = newValues;
+    times = newTimes;
+    capacity = grown;
+    head = 0;
+}
+
+
+/**
+ * @brief SpectrogramRasterData::pixelHint One cell, so the spectrogram is
+ * rendered at the resolution of the data and scaled up
+ */
+QRectF SpectrogramRasterData::pixelHint(const QRectF &area) const
+{
+    Q_UNUSED(area);
+
+    const QwtInterval intervalX = interval(Qt::XAxis);
+    const QwtInterval intervalY = interval(Qt::YAxis);
+    if (width == 0 || count == 0 || !intervalX.isValid() || !intervalY.isValid())
+        return QRectF();
+
+    return QRectF(intervalX.minValue(), intervalY.minValue(),
+                  intervalX.width() / width, intervalY.width() / count);
+}
+
+
+/**
+ * @brief SpectrogramRasterData::value The value of the cell at a position
+ */
+double SpectrogramRasterData::value(double x, double y) const
+{
+    const QwtInterval intervalX = interval(Qt::XAxis);
+    const QwtInterval intervalY = interval(Qt::YAxis);
+    if (width == 0 || count == 0 || !(intervalX.contains(x) && intervalY.contains(y)))
+        return qQNaN();
+
+    int column = (int) ((x - intervalX.minValue()) / intervalX.width() * width);
+    int row = (int) ((y - intervalY.minValue()) / intervalY.width() * count);
+    column = qBound(0, column, (int) width - 1);
+    row = qBound(0, row, count - 1);
+
+    return values[((head + row) % capacity) * width + column];
+}
+
+/**
+ * @}
+ * @}
+ */
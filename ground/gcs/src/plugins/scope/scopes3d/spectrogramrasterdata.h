@@ -0,0 +1,72 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrogramrasterdata.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Circular raster storage for the spectrogram
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef SPECTROGRAMRASTERDATA_H
+#define SPECTROGRAMRASTERDATA_H
+
+#include "qwt/src/qwt_raster_data.h"
+
+#include <QVector>
+
+/**
+ * @brief The SpectrogramRasterData class Rows of the spectrogram, oldest
+ * first, in a circular buffer. Adding the newest row and dropping the
+ * oldest ones only touches those rows, the rest of the raster is never
+ * copied. The rows are spread evenly over the y interval, and looked up
+ * like a QwtMatrixRasterData in nearest neighbour mode.
+ */
+class SpectrogramRasterData : public QwtRasterData
+{
+public:
+    SpectrogramRasterData();
+
+    void reset(unsigned int width);
+    void appendRow(const float *row, double time);
+    void dropRowsBefore(double time);
+
+    unsigned int getWidth() const { return width; }
+    int getNumRows() const { return count; }
+
+    virtual QRectF pixelHint(const QRectF &area) const;
+    virtual double value(double x, double y) const;
+
+private:
+    void grow();
+
+    unsigned int width;
+    int capacity;               // Rows the storage holds
+    int head;                   // Storage row of the oldest row
+    int count;
+    QVector<float> values;
+    QVector<double> times;
+};
+
+#endif // SPECTROGRAMRASTERDATA_H
+
+/**
+ * @}
+ * @}
+ */
@@ -47,6 +47,7 @@ SpectrogramScopeConfig::SpectrogramScopeConfig()
     timeHorizon = 60;
     samplingFrequency = 100;
     windowWidth = 64;
+    overlap = 0;
     zMaximum = 120;
     colorMapType = ColorMap::STANDARD;
 }
@@ -61,6 +62,7 @@ SpectrogramScopeConfig::SpectrogramScopeConfig(QSettings *qSettings)
     timeHorizon = qSettings->value("timeHorizon").toDouble();
     samplingFrequency = qSettings->value("samplingFrequency").toDouble();
     windowWidth       = qSettings->value("windowWidth").toInt();
+    overlap           = qSettings->value("overlap", 0).toInt();
     zMaximum = qSettings->value("zMaximum").toDouble();
     colorMapType = (ColorMap::ColorMapType) qSettings->value("colorMap").toInt();
 
@@ -96,6 +98,7 @@ SpectrogramScopeConfig::SpectrogramScopeConfig(Ui::ScopeGadgetOptionsPage *optio
     bool parseOK = false;
 
     windowWidth = options_page->sbSpectrogramWidth->value();
+    overlap = options_page->sbSpectrogramOverlap->value();
     samplingFrequency = options_page->sbSpectrogramFrequency->value();
     timeHorizon = options_page->sbSpectrogramTimeHorizon->value();
     zMaximum = options_page->spnMaxSpectrogramZ->value();
@@ -136,6 +139,7 @@ ScopeConfig* SpectrogramScopeConfig::cloneScope(ScopeConfig *originalScope)
     SpectrogramScopeConfig *cloneObj = new SpectrogramScopeConfig();
 
     cloneObj->timeHorizon = originalSpectrogramScopeConfig->timeHorizon;
+    cloneObj->overlap = originalSpectrogramScopeConfig->overlap;
     cloneObj->colorMapType = originalSpectrogramScopeConfig->colorMapType;
 
     int plotCurveCount = originalSpectrogramScopeConfig->m_spectrogramSourceConfigs.size();
@@ -176,6 +180,7 @@ void SpectrogramScopeConfig::saveConfiguration(QSettings* qSettings)
     qSettings->setValue("samplingFrequency", samplingFrequency);
     qSettings->setValue("timeHorizon", timeHorizon);
     qSettings->setValue("windowWidth", windowWidth);
+    qSettings->setValue("overlap", overlap);
     qSettings->setValue("zMaximum",  zMaximum);
 
     for(int i = 0; i < plot3dCurveCount; i++){
@@ -238,6 +243,7 @@ void SpectrogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWid
     spectrogramData->setScalePower(spectrogramSourceConfigs->yScalePower);
     spectrogramData->setMeanSamples(spectrogramSourceConfigs->yMeanSamples);
     spectrogramData->setMathFunction(spectrogramSourceConfigs->mathFunction);
+    spectrogramData->setOverlap(overlap);
 
     //Generate the waterfall name
     QString waterfallName = (spectrogramData->getUavoName()) + "." + (spectrogramData->getUavoFieldName());
@@ -271,15 +277,8 @@ void SpectrogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWid
 
     // Initial raster data
 
-    QDateTime NOW = QDateTime::currentDateTime(); //TODO: Upgrade this to show UAVO time and not system time
-    for ( uint i = 0; i < timeHorizon; i++ ){
-        spectrogramData->timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0 + i);
-    }
-
-    if (((double) windowWidth) * timeHorizon < (double) 10000000.0 * sizeof(spectrogramData->zDataHistory->front())){ //Don't exceed 10MB for memory
-        for ( uint i = 0; i < windowWidth*timeHorizon; i++ ){
-            spectrogramData->zDataHistory->append(0);
-        }
+    if (((double) windowWidth) * timeHorizon < (double) 10000000.0 * sizeof(float)){ //Don't exceed 10MB for memory
+        spectrogramData->addEmptyRows(timeHorizon, UAVObject::currentTimestamp() / 1000.0);
     }
     else{
         qDebug() << "For some reason, we're trying to allocate a gigantic spectrogram. This probably represents a problem in the configuration file. TimeHorizion: "<< timeHorizon << ", windowWidth: "<< windowWidth;
@@ -304,7 +303,7 @@ void SpectrogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWid
     scopeGadgetWidget->insertDataSources(waterfallNameScaled, spectrogramData);
 
     // Connect the UAVO
-    scopeGadgetWidget->connectUAVO(obj);
+    scopeGadgetWidget->connectUAVO(obj, spectrogramData);
 
     scopeGadgetWidget->replot();
 }
@@ -326,6 +325,7 @@ void SpectrogramScopeConfig::setGuiConfiguration(Ui::ScopeGadgetOptionsPage *opt
     options_page->sbSpectrogramTimeHorizon->setValue(timeHorizon);
     options_page->sbSpectrogramFrequency->setValue(samplingFrequency);
     options_page->spnMaxSpectrogramZ->setValue(zMaximum);
+    options_page->sbSpectrogramOverlap->setValue(overlap);
     options_page->cmbColorMapSpectrogram->setCurrentIndex(options_page->cmbColorMapSpectrogram->findData(colorMapType));
 
     foreach (Plot3dCurveConfiguration* plot3dData,  m_spectrogramSourceConfigs) {
@@ -61,6 +61,7 @@ public:
     double getSamplingFrequency(){return samplingFrequency;}
     double getZMaximum(){return zMaximum;}
     unsigned int getWindowWidth(){return windowWidth;}
+    unsigned int getOverlap(){return overlap;}
     double getTimeHorizon(){return timeHorizon;}
     virtual QList<Plot3dCurveConfiguration*> getDataSourceConfigs(){return m_spectrogramSourceConfigs;}
     virtual int getScopeType(){return SPECTROGRAM;}
@@ -69,6 +70,7 @@ public:
     void setSamplingFrequency(double val){samplingFrequency = val;}
     void setZMaximum(double val){zMaximum = val;}
     void setWindowWidth(unsigned int val){windowWidth = val;}
+    void setOverlap(unsigned int val){overlap = val;}
     void setTimeHorizon(double val){timeHorizon = val;}
     virtual void setGuiConfiguration(Ui::ScopeGadgetOptionsPage *options_page);
     virtual ScopeConfig* cloneScope(ScopeConfig*);
@@ -91,6 +93,7 @@ private:
 
     double samplingFrequency;
     unsigned int windowWidth;
+    unsigned int overlap;       // Percent of each FFT window shared with the next
     QString yAxisUnits;
     double zMaximum;
 
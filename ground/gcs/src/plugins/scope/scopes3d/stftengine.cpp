@@ -0,0 +1,147 @@
+/**
+ ******************************************************************************
+ *
+ * @file       stftengine.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Streaming short time Fourier transform for the spectrogram
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "scopes3d/stftengine.h"
+
+#define PI 3.1415926535897932384626433832795
+
+const float StftEngine::MAGNITUDE_SCALE = 4.2f;
+
+StftEngine::StftEngine() :
+    plan(0),
+    length(0),
+    hop(0)
+{
+}
+
+StftEngine::~StftEngine()
+{
+    delete plan;
+}
+
+
+/**
+ * @brief StftEngine::configure Set the transform length and the samples
+ * between spectra. Pending samples are dropped if the length changes.
+ * @param length Samples per transform, a power of two
+ * @param hop Samples between transforms, at most length
+ */
+void StftEngine::configure(unsigned int length, unsigned int hop)
+{
+    if (hop == 0 || hop > length)
+        hop = length;
+    this->hop = hop;
+
+    if (length == this->length)
+        return;
+
+    this->length = length;
+    delete plan;
+    plan = new ffft::FFTReal<float>(length);
+
+    // Hann window
+    window.resize(length);
+    for (unsigned int i = 0; i < length; i++) {
+        double s = sin(PI * i / (length - 1));
+        window[i] = s * s;
+    }
+
+    frame.resize(length);
+    spectrum.resize(length);
+    reset();
+}
+
+
+/**
+ * @brief StftEngine::reset Forget the samples not transformed yet
+ */
+void StftEngine::reset()
+{
+    pending.resize(0);
+}
+
+
+/**
+ * @brief StftEngine::process Add samples to the stream and transform
+ * every full window reached
+ * @param samples New samples
+ * @param count Number of new samples
+ * @param columns Receives getBins() magnitudes per spectrum, appended
+ * @return Number of spectra appended
+ */
+int StftEngine::process(const float *samples, int count, QVector<float> &columns)
+{
+    if (plan == 0)
+        return 0;
+
+    int queued = pending.size();
+    pending.resize(queued + count);
+    memcpy(pending.data() + queued, samples, count * sizeof(float));
+
+    const unsigned int bins = getBins();
+    const float scale = MAGNITUDE_SCALE / length;
+    int start = 0;
+    int spectra = 0;
+
+    while ((unsigned int) (pending.size() - start) >= length) {
+        const float *in = pending.constData() + start;
+        for (unsigned int i = 0; i < length; i++)
+            frame[i] = in[i] * window[i];
+
+        plan->do_fft(spectrum.data(), frame.constData());
+
+        // Real parts come first, then the imaginary parts of bins 1 and up
+        int column = columns.size();
+        columns.resize(column + bins);
+        float *out = columns.data() + column;
+        out[0] = fabsf(spectrum[0]) * scale;
+        for (unsigned int i = 1; i < bins; i++) {
+            float re = spectrum[i];
+            float im = spectrum[bins + i];
+            out[i] = sqrtf(re * re + im * im) * scale;
+        }
+
+        start += hop;
+        spectra++;
+    }
+
+    // Keep what the next windows still need
+    if (start > 0) {
+        int left = pending.size() - start;
+        memmove(pending.data(), pending.constData() + start, left * sizeof(float));
+        pending.resize(left);
+    }
+
+    return spectra;
+}
+
+/**
+ * @}
+ * @}
+ */
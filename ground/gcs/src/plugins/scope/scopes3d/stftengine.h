@@ -0,0 +1,74 @@
+/**
+ ******************************************************************************
+ *
+ * @file       stftengine.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Streaming short time Fourier transform for the spectrogram
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef STFTENGINE_H
+#define STFTENGINE_H
+
+#include <QVector>
+
+#include "ffft/FFTReal.h"
+
+/**
+ * @brief The StftEngine class Turns a stream of samples into magnitude
+ * spectra, one every hop samples over the latest length samples. The FFT
+ * plan, the Hann window and all buffers are kept from one call to the
+ * next, and only rebuilt when the length changes.
+ */
+class StftEngine
+{
+public:
+    StftEngine();
+    ~StftEngine();
+
+    void configure(unsigned int length, unsigned int hop);
+    void reset();
+
+    unsigned int getLength() const { return length; }
+    unsigned int getBins() const { return length / 2; }
+
+    int process(const float *samples, int count, QVector<float> &columns);
+
+private:
+    // Scales the magnitudes so they read close to the acceleration
+    // registered, which helps users reading the spectrogram
+    static const float MAGNITUDE_SCALE;
+
+    ffft::FFTReal<float> *plan;
+    unsigned int length;
+    unsigned int hop;
+
+    QVector<float> window;
+    QVector<float> frame;
+    QVector<float> spectrum;
+    QVector<float> pending;     // Samples not consumed by a hop yet
+};
+
+#endif // STFTENGINE_H
+
+/**
+ * @}
+ * @}
+ */
@@ -29,6 +29,7 @@
 
 #include <extensionsystem/pluginmanager.h>
 #include <coreplugin/icore.h>
+#include <coreplugin/boardmanager.h>
 
 #include <QtCore/QtPlugin>
 #include <QMainWindow>
@@ -40,7 +41,6 @@ SerialConnection::SerialConnection()
     : enablePolling(true),
       m_deviceOpened(false)
 {
-    serialHandle = NULL;
     m_config = new SerialPluginConfiguration("Serial Telemetry", NULL, this);
     m_config->restoresettings();
 
@@ -79,6 +79,7 @@ QList <IDevice *> SerialConnection::availableDevices()
         bool changed = false;
 
         QList<QSerialPortInfo> ports = QSerialPortInfo::availablePorts();
+        QList<int> boardVIDs = Core::ICore::instance()->boardManager()->getKnownVendorIDs();
 
         //sort the list by port number (nice idea from PT_Dreamer :))
         qSort(ports.begin(), ports.end(),sortPorts);
@@ -101,6 +102,10 @@ QList <IDevice *> SerialConnection::availableDevices()
                 disp.append(port.portName());
                 d->setDisplayName(disp.join(" - "));
                 d->setName(port.portName());
+                // The USB VCP of a board beats its HID reports for telemetry
+                // throughput, if the board put the telemetry on it
+                d->setPreferred(port.hasVendorIdentifier() &&
+                                boardVIDs.contains(port.vendorIdentifier()));
                 m_available_device_list.append(d);
 
                 changed = true;
@@ -133,7 +138,7 @@ QList <IDevice *> SerialConnection::availableDevices()
 
 QIODevice *SerialConnection::openDevice(IDevice *deviceName)
 {
-    if (serialHandle){
+    if (serialHandles.contains(deviceName->getName())){
         closeDevice(deviceName->getName());
     }
     QList<QSerialPortInfo> ports = QSerialPortInfo::availablePorts();
@@ -141,7 +146,8 @@ QIODevice *SerialConnection::openDevice(IDevice *deviceName)
         if (port.portName() == deviceName->getName()) {
             //we need to handle port settings here...
 
-            serialHandle = new QSerialPort(port);
+            QSerialPort *serialHandle = new QSerialPort(port);
+            serialHandles.insert(port.portName(), serialHandle);
             if (serialHandle->open(QIODevice::ReadWrite)) {
                  if (serialHandle->setBaudRate(m_config->speed().toInt())
 	                    && serialHandle->setDataBits(QSerialPort::Data8)
@@ -159,12 +165,11 @@ QIODevice *SerialConnection::openDevice(IDevice *deviceName)
 
 void SerialConnection::closeDevice(const QString &deviceName)
 {
-    Q_UNUSED(deviceName);
     //we have to delete the serial connection we created
+    QSerialPort *serialHandle = serialHandles.take(deviceName);
     if (serialHandle){
         serialHandle->deleteLater();
-        serialHandle = NULL;
-        m_deviceOpened = false;
+        m_deviceOpened = !serialHandles.isEmpty();
     }
 }
 
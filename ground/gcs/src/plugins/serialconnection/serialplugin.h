@@ -34,6 +34,7 @@
 #include <extensionsystem/iplugin.h>
 #include "serialpluginconfiguration.h"
 #include "serialpluginoptionspage.h"
+#include <QMap>
 #include <QTimer>
 
 class IConnection;
@@ -62,12 +63,14 @@ public:
     virtual void suspendPolling();
     virtual void resumePolling();
     virtual bool reconnect() { return m_config->reconnect(); }
+    virtual bool supportsMultipleDevices() { return true; }
     bool deviceOpened() {return m_deviceOpened;}
     SerialPluginConfiguration * Config() const { return m_config; }
     SerialPluginOptionsPage * Optionspage() const { return m_optionspage; }
 
 private:
-    QSerialPort*  serialHandle;
+    // Open ports by name; several when more vehicles are watched
+    QMap<QString, QSerialPort *> serialHandles;
     bool enablePolling;
     SerialPluginConfiguration *m_config;
     SerialPluginOptionsPage *m_optionspage;
@@ -30,6 +30,7 @@
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjectmanager.h"
 #include "systemalarms.h"
+#include "looptiming.h"
 #include <coreplugin/icore.h>
 #include <QDebug>
 #include <QWhatsThis>
@@ -48,6 +49,16 @@ SystemHealthGadgetWidget::SystemHealthGadgetWidget(QWidget *parent) : QGraphicsV
     background = new QGraphicsSvgItem();
     foreground = new QGraphicsSvgItem();
     nolink = new QGraphicsSvgItem();
+    timing = new QGraphicsSimpleTextItem();
+    timing->setBrush(Qt::white);
+    timing->setZValue(98);
+    timing->setVisible(false);
+
+    // The layers only change with the gadget size, so they are drawn from
+    // pixmaps rendered for the current view transform
+    background->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+    foreground->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+    nolink->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
 
     paint();
 
@@ -58,6 +69,11 @@ SystemHealthGadgetWidget::SystemHealthGadgetWidget(QWidget *parent) : QGraphicsV
     SystemAlarms* obj = SystemAlarms::GetInstance(objManager);
     connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(updateAlarms(UAVObject*)));
 
+    // Boards built without the loop tracepoints never send this one
+    LoopTiming *loopTiming = LoopTiming::GetInstance(objManager);
+    if (loopTiming)
+        connect(loopTiming, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(updateLoopTiming(UAVObject*)));
+
     // Listen to autopilot connection events
     TelemetryManager* telMngr = pm->getObject<TelemetryManager>();
     connect(telMngr, SIGNAL(connected()), this, SLOT(onAutopilotConnect()));
@@ -80,21 +96,90 @@ void SystemHealthGadgetWidget::onAutopilotConnect()
 void SystemHealthGadgetWidget::onAutopilotDisconnect()
 {
     nolink->setVisible(true);
+    timing->setVisible(false);
 }
 
-void SystemHealthGadgetWidget::updateAlarms(UAVObject* systemAlarm)
+/**
+  * Summarise the control loop timing along the bottom of the gadget, and
+  * keep the histograms and stage times for when it is clicked
+  */
+void SystemHealthGadgetWidget::updateLoopTiming(UAVObject *loopTiming)
 {
-    static QList<QString> warningClean;
-    // This code does not know anything about alarms beforehand, and
-    // I found no efficient way to locate items inside the scene by
-    // name, so it's just as simple to reset the scene:
-    // And add the one with the right name.
-    QGraphicsScene *m_scene = scene();
-    foreach ( QGraphicsItem* item ,background->childItems()){
-        m_scene->removeItem(item);
-        delete item; // removeItem does _not_ delete the item.
+    LoopTiming *obj = dynamic_cast<LoopTiming *>(loopTiming);
+    if (!obj)
+        return;
+
+    LoopTiming::DataFields data = obj->getData();
+
+    if (!data.Samples) {
+        timing->setVisible(false);
+        return;
     }
 
+    timing->setText(tr("Loop %1 us (%2-%3), latency %4 us (%5-%6)")
+                    .arg(data.PeriodAvg).arg(data.PeriodMin).arg(data.PeriodMax)
+                    .arg(data.LatencyAvg).arg(data.LatencyMin).arg(data.LatencyMax));
+    timing->setVisible(true);
+    placeLoopTiming();
+
+    // The buckets double in width, see looptiming.xml
+    QString html = tr("<b>Control loop timing</b>, %1 samples in the last second").arg(data.Samples);
+
+    html += tr("<p>Period jitter</p><table>");
+    for (unsigned int i = 0; i < LoopTiming::JITTERHISTOGRAM_NUMELEM; i++) {
+        QString bucket = (i < LoopTiming::JITTERHISTOGRAM_NUMELEM - 1) ?
+                    tr("under %1 us").arg(2 << i) : tr("over %1 us").arg(1 << i);
+        html += QString("<tr><td>%1</td><td align=\"right\">%2</td></tr>")
+                .arg(bucket).arg(data.JitterHistogram[i]);
+    }
+    html += "</table>";
+
+    html += tr("<p>Sample to output latency</p><table>");
+    for (unsigned int i = 0; i < LoopTiming::LATENCYHISTOGRAM_NUMELEM; i++) {
+        QString bucket = (i < LoopTiming::LATENCYHISTOGRAM_NUMELEM - 1) ?
+                    tr("under %1 us").arg(64 << i) : tr("over %1 us").arg(32 << i);
+        html += QString("<tr><td>%1</td><td align=\"right\">%2</td></tr>")
+                .arg(bucket).arg(data.LatencyHistogram[i]);
+    }
+    html += "</table>";
+
+    html += tr("<p>Cycles per stage</p><table><tr><td></td><td>min</td><td>avg</td><td>max</td></tr>");
+    QStringList stages = obj->getField("StageCyclesAvg")->getElementNames();
+    for (unsigned int i = 0; i < (unsigned int)stages.size() && i < LoopTiming::STAGECYCLESAVG_NUMELEM; i++) {
+        html += QString("<tr><td>%1</td><td align=\"right\">%2</td><td align=\"right\">%3</td><td align=\"right\">%4</td></tr>")
+                .arg(stages[i]).arg(data.StageCyclesMin[i])
+                .arg(data.StageCyclesAvg[i]).arg(data.StageCyclesMax[i]);
+    }
+    html += "</table>";
+
+    timingDetails = html;
+}
+
+/**
+  * Fit the timing summary across the bottom of the background
+  */
+void SystemHealthGadgetWidget::placeLoopTiming()
+{
+    QRectF bounds = background->boundingRect();
+    if (bounds.isEmpty() || timing->text().isEmpty())
+        return;
+
+    QFont font = timing->font();
+    font.setPixelSize(qMax(1, (int)(bounds.height() / 24)));
+    timing->setFont(font);
+
+    QRectF text = timing->boundingRect();
+    qreal scale = qMin(1.0, bounds.width() / text.width());
+    timing->setTransform(QTransform::fromScale(scale, scale));
+    timing->setPos(bounds.left(), bounds.bottom() - text.height() * scale);
+}
+
+void SystemHealthGadgetWidget::updateAlarms(UAVObject* systemAlarm)
+{
+    static QList<QString> warningClean;
+    // Each alarm has a tile, found by the alarm name, which only changes
+    // its element when that alarm's value does.  The tiles that didn't
+    // change keep their cached pixmaps and are not repainted.
     UAVObjectField *field = systemAlarm->getField("Alarm");
     Q_ASSERT(field);
     if (field == NULL)
@@ -104,19 +189,30 @@ void SystemHealthGadgetWidget::updateAlarms(UAVObject* systemAlarm)
         QString element = field->getElementNames()[i];
         QString value = field->getValue(i).toString();
         if (m_renderer->elementExists(element)) {
-            QMatrix blockMatrix = m_renderer->matrixForElement(element);
-            qreal startX = blockMatrix.mapRect(m_renderer->boundsOnElement(element)).x();
-            qreal startY = blockMatrix.mapRect(m_renderer->boundsOnElement(element)).y();
             QString element2 = element + "-" + value;
+            QGraphicsSvgItem *ind = alarmTiles.value(element);
             if (m_renderer->elementExists(element2)) {
-                QGraphicsSvgItem *ind = new QGraphicsSvgItem();
-                ind->setSharedRenderer(m_renderer);
-                ind->setElementId(element2);
-                ind->setParentItem(background);
-                QTransform matrix;
-                matrix.translate(startX,startY);
-                ind->setTransform(matrix,false);
+                if (!ind) {
+                    QMatrix blockMatrix = m_renderer->matrixForElement(element);
+                    qreal startX = blockMatrix.mapRect(m_renderer->boundsOnElement(element)).x();
+                    qreal startY = blockMatrix.mapRect(m_renderer->boundsOnElement(element)).y();
+                    ind = new QGraphicsSvgItem();
+                    ind->setSharedRenderer(m_renderer);
+                    ind->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+                    ind->setParentItem(background);
+                    QTransform matrix;
+                    matrix.translate(startX,startY);
+                    ind->setTransform(matrix,false);
+                    alarmTiles.insert(element, ind);
+                }
+                if (ind->elementId() != element2)
+                    ind->setElementId(element2);
             } else {
+                if (ind) {
+                    alarmTiles.remove(element);
+                    delete ind; // Also takes it out of the scene
+                }
+
                 if ((value.compare("Uninitialised") != 0) && !warningClean.contains(element2))
                 {
                     qDebug() << "[SystemHealth] Warning: The SystemHealth SVG does not contain a graphical element for the " << element2 << " alarm.";
@@ -142,6 +238,10 @@ void SystemHealthGadgetWidget::setSystemFile(QString dfn)
    if (QFile::exists(dfn)) {
        m_renderer->load(dfn);
        if(m_renderer->isValid()) {
+           // The alarm tiles may be elsewhere in the new file
+           qDeleteAll(alarmTiles);
+           alarmTiles.clear();
+
            fgenabled = false;
            background->setSharedRenderer(m_renderer);
            background->setElementId("background");
@@ -161,6 +261,7 @@ void SystemHealthGadgetWidget::setSystemFile(QString dfn)
          QGraphicsScene *l_scene = scene();
          l_scene->setSceneRect(background->boundingRect());
          fitInView(background, Qt::KeepAspectRatio );
+         placeLoopTiming();
 
          // Check whether the autopilot is connected already, by the way:
          ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
@@ -180,10 +281,12 @@ void SystemHealthGadgetWidget::setSystemFile(QString dfn)
 void SystemHealthGadgetWidget::paint()
 {
     QGraphicsScene *l_scene = scene();
+    alarmTiles.clear(); // Deleted with the background
     l_scene->clear();
     l_scene->addItem(background);
     l_scene->addItem(foreground);
     l_scene->addItem(nolink);
+    l_scene->addItem(timing);
     update();
 }
 
@@ -212,6 +315,12 @@ void SystemHealthGadgetWidget::mousePressEvent ( QMouseEvent * event )
     if(graphicsScene){
         QPoint point = event->pos();
         bool haveAlarmItem = false;
+
+        if (timing->isVisible() && items(point).contains(timing)) {
+            QWhatsThis::showText(event->globalPos(), timingDetails);
+            return;
+        }
+
         foreach(QGraphicsItem* sceneItem, items(point)){
             QGraphicsSvgItem *clickedItem = dynamic_cast<QGraphicsSvgItem*>(sceneItem);
 
@@ -33,6 +33,7 @@
 #include <QGraphicsView>
 #include <QtSvg/QSvgRenderer>
 #include <QtSvg/QGraphicsSvgItem>
+#include <QGraphicsSimpleTextItem>
 #include <QMouseEvent>
 #include <QMap>
 #include <QFile>
@@ -56,6 +57,7 @@ protected:
 
 private slots:
    void updateAlarms(UAVObject *systemAlarm); // Called by the systemalarms UAVObject
+   void updateLoopTiming(UAVObject *loopTiming); // Called by the looptiming UAVObject
    void onAutopilotConnect();
    void onAutopilotDisconnect();
 
@@ -64,12 +66,16 @@ private:
    QGraphicsSvgItem *background;
    QGraphicsSvgItem *foreground;
    QGraphicsSvgItem *nolink;
+   QMap<QString, QGraphicsSvgItem *> alarmTiles; // By alarm name, children of background
+   QGraphicsSimpleTextItem *timing; // One line summary of LoopTiming
+   QString timingDetails; // Shown when the summary is clicked
 
                    // Simple flag to skip rendering if the
    bool fgenabled; // layer does not exist.
 
    void showAlarmDescriptionForItemId(const QString itemId, const QPoint& location);
    void showAllAlarmDescriptions(const QPoint &location);
+   void placeLoopTiming();
    QString getAlarmDescriptionFileName(const QString itemId);
 };
 #endif /* SYSTEMHEALTHGADGETWIDGET_H_ */
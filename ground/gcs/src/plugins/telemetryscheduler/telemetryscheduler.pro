@@ -8,6 +8,7 @@ include(../../gcsplugin.pri)
 include(../../plugins/coreplugin/coreplugin.pri) 
 include(../../plugins/uavobjects/uavobjects.pri)
 include(../../plugins/uavobjectutil/uavobjectutil.pri)
+include(../../plugins/uavtalk/uavtalk.pri)
 
 HEADERS += telemetryschedulergadget.h
 HEADERS += telemetryschedulergadgetwidget.h
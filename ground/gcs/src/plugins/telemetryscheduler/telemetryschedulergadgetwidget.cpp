@@ -44,6 +44,7 @@
 #include <QPushButton>
 #include <QFileInfo>
 #include <QInputDialog>
+#include <QSet>
 
 #include "extensionsystem/pluginmanager.h"
 #include "utils/xmlconfig.h"
@@ -51,11 +52,15 @@
 #include "uavdataobject.h"
 #include "uavmetaobject.h"
 #include "uavobjectutil/uavobjectutilmanager.h"
+#include "uavtalk/uavtalk.h"
 #include <coreplugin/coreconstants.h>
 #include <coreplugin/generalsettings.h>
 #include <QMenu>
+#include <QHeaderView>
+#include <algorithm>
 
-TelemetrySchedulerGadgetWidget::TelemetrySchedulerGadgetWidget(QWidget *parent) : QWidget(parent)
+TelemetrySchedulerGadgetWidget::TelemetrySchedulerGadgetWidget(QWidget *parent) : QWidget(parent),
+    fitPending(false)
 {
     m_telemetryeditor = new Ui_TelemetryScheduler();
     m_telemetryeditor->setupUi(this);
@@ -93,6 +98,7 @@ TelemetrySchedulerGadgetWidget::TelemetrySchedulerGadgetWidget(QWidget *parent)
     connect(m_telemetryeditor->bnLoadTelemetryFromFile, SIGNAL(clicked()), this, SLOT(loadTelemetryFromFile()));
     connect(m_telemetryeditor->bnApplySchedule, SIGNAL(clicked()), this, SLOT(applySchedule()));
     connect(m_telemetryeditor->bnSaveSchedule, SIGNAL(clicked()), this, SLOT(saveSchedule()));
+    connect(m_telemetryeditor->bnFitToLink, SIGNAL(clicked()), this, SLOT(fitToLink()));
     connect(m_telemetryeditor->bnAddTelemetryColumn, SIGNAL(clicked()), this, SLOT(addTelemetryColumn()));
     connect(m_telemetryeditor->bnRemoveTelemetryColumn, SIGNAL(clicked()), this, SLOT(removeTelemetryColumn()));
     connect(schedulerModel, SIGNAL(itemChanged(QStandardItem *)), this, SLOT(dataModel_itemChanged(QStandardItem *)));
@@ -173,6 +179,27 @@ TelemetrySchedulerGadgetWidget::TelemetrySchedulerGadgetWidget(QWidget *parent)
     m_telemetryeditor->cmbScheduleList->addItem("");
     m_telemetryeditor->cmbScheduleList->addItems(columnHeaders);
     onHideNotPresent(true);
+
+    // Table of the objects using the most of the link, so the schedule can
+    // be tuned against what is actually being sent
+    telMngr = pm->getObject<TelemetryManager>();
+    Q_ASSERT(telMngr != NULL);
+
+    QStringList linkHeaders;
+    linkHeaders << tr("Object") << tr("Rx B/s") << tr("Tx B/s") << tr("Rx pkt/s")
+                << tr("Retries/s") << tr("Latency (ms)") << tr("Interval min/avg/max (ms)");
+    linkUsageTable = new QTableWidget(0, linkHeaders.size(), this);
+    linkUsageTable->setObjectName(QString::fromUtf8("linkUsageTable"));
+    linkUsageTable->setHorizontalHeaderLabels(linkHeaders);
+    linkUsageTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    linkUsageTable->setAlternatingRowColors(true);
+    linkUsageTable->verticalHeader()->setVisible(false);
+    linkUsageTable->horizontalHeader()->setStretchLastSection(true);
+    m_telemetryeditor->gridLayout->addWidget(linkUsageTable, m_telemetryeditor->gridLayout->rowCount(), 0, 1, -1);
+
+    linkUsageTimer = new QTimer(this);
+    connect(linkUsageTimer, SIGNAL(timeout()), this, SLOT(updateLinkUsage()));
+    linkUsageTimer->start(LINK_USAGE_PERIOD_MS);
 }
 
 
@@ -182,6 +209,90 @@ TelemetrySchedulerGadgetWidget::~TelemetrySchedulerGadgetWidget()
 }
 
 
+/**
+ * @brief TelemetrySchedulerGadgetWidget::updateLinkUsage Refresh the table of
+ * the objects with the highest byte rate over the last period
+ */
+void TelemetrySchedulerGadgetWidget::updateLinkUsage()
+{
+    QVector<Telemetry::ObjectStats> stats = telMngr->getObjectStats();
+
+    struct LinkUsage {
+        int index;
+        double rxBps;
+        double txBps;
+        double rxPps;
+        double retriesPs;
+    };
+
+    // Rates come from the difference with the previous snapshot. Counters
+    // that went backwards were reset, so count them from zero.
+    const double period = LINK_USAGE_PERIOD_MS / 1000.0;
+    QVector<LinkUsage> usage;
+    QHash<quint32, Telemetry::ObjectStats> current;
+    for (int i = 0; i < stats.size(); i++) {
+        const Telemetry::ObjectStats &now = stats[i];
+        Telemetry::ObjectStats prev = lastLinkStats.value(now.com.objId);
+        if (now.com.rxBytes < prev.com.rxBytes || now.com.txBytes < prev.com.txBytes ||
+                now.retries < prev.retries)
+            prev = Telemetry::ObjectStats();
+
+        LinkUsage entry;
+        entry.index = i;
+        entry.rxBps = (now.com.rxBytes - prev.com.rxBytes) / period;
+        entry.txBps = (now.com.txBytes - prev.com.txBytes) / period;
+        entry.rxPps = (now.com.rxPackets - prev.com.rxPackets) / period;
+        entry.retriesPs = (now.retries - prev.retries) / period;
+        usage.append(entry);
+        current.insert(now.com.objId, now);
+    }
+    lastLinkStats = current;
+
+    if (!isVisible())
+        return;
+
+    std::sort(usage.begin(), usage.end(), [](const LinkUsage &a, const LinkUsage &b) {
+        return a.rxBps + a.txBps > b.rxBps + b.txBps;
+    });
+
+    int rows = usage.size();
+    if (rows > LINK_USAGE_ROWS)
+        rows = LINK_USAGE_ROWS;
+    linkUsageTable->setRowCount(rows);
+    for (int row = 0; row < rows; row++) {
+        const LinkUsage &entry = usage[row];
+        const Telemetry::ObjectStats &objStats = stats[entry.index];
+
+        UAVObject *obj = objManager->getObject(objStats.com.objId);
+        QString name = obj ? obj->getName() : QString("0x%1").arg(objStats.com.objId, 8, 16, QChar('0'));
+
+        QString latency = "-";
+        if (objStats.transactions > 0)
+            latency = QString::number(objStats.sumLatencyNs / objStats.transactions / 1e6, 'f', 1);
+
+        QString interval = "-";
+        if (objStats.com.rxIntervals > 0)
+            interval = QString("%1 / %2 / %3")
+                    .arg(objStats.com.minRxIntervalNs / 1e6, 0, 'f', 1)
+                    .arg(objStats.com.sumRxIntervalNs / objStats.com.rxIntervals / 1e6, 0, 'f', 1)
+                    .arg(objStats.com.maxRxIntervalNs / 1e6, 0, 'f', 1);
+
+        QStringList cells;
+        cells << name << QString::number(entry.rxBps, 'f', 0) << QString::number(entry.txBps, 'f', 0)
+              << QString::number(entry.rxPps, 'f', 1) << QString::number(entry.retriesPs, 'f', 1)
+              << latency << interval;
+        for (int col = 0; col < cells.size(); col++) {
+            QTableWidgetItem *item = linkUsageTable->item(row, col);
+            if (item == NULL) {
+                item = new QTableWidgetItem();
+                linkUsageTable->setItem(row, col, item);
+            }
+            item->setText(cells[col]);
+        }
+    }
+}
+
+
 /**
  * @brief TelemetrySchedulerGadgetWidget::updateCurrentColumn Updates the "Current" column
  * @param obj UAVObject being updated
@@ -462,6 +573,17 @@ void TelemetrySchedulerGadgetWidget::onSavedSchedule(bool value)
 
 void TelemetrySchedulerGadgetWidget::onCompletedMetadataWrite(bool value)
 {
+    if (fitPending) {
+        fitPending = false;
+        if (value) {
+            // Measure from here, the old rates are gone
+            fitStartStats.clear();
+            foreach (const Telemetry::ObjectStats &objStats, telMngr->getObjectStats())
+                fitStartStats.insert(objStats.com.objId, objStats);
+            QTimer::singleShot(FIT_VERIFY_PERIOD_MS, this, SLOT(verifyFit()));
+        }
+    }
+
     if(value)
         m_telemetryeditor->bnApplySchedule->setIcon(QIcon(":/uploader/images/dialog-apply.svg"));
     else
@@ -503,6 +625,169 @@ void TelemetrySchedulerGadgetWidget::onCompletedMetadataSave(int id, bool result
     }
 }
 
+/**
+ * @brief TelemetrySchedulerGadgetWidget::fitToLink Fill the selected column
+ * with the fastest periods that fit in the link rate. Objects are never made
+ * faster than the column asks; the ones with a selected cell in the column
+ * keep their period, the others are all slowed by the same factor (up to
+ * FIT_MAX_PERIOD_MS), so the column keeps its relative priorities. With the
+ * apply button available the result is sent right away and checked against
+ * the measured link usage.
+ */
+void TelemetrySchedulerGadgetWidget::fitToLink()
+{
+    int col = columnHeaders.indexOf(m_telemetryeditor->cmbScheduleList->currentText());
+    if (m_telemetryeditor->cmbScheduleList->currentText().isEmpty() || col < 2) {
+        QMessageBox::warning(this, tr("No Schedule selected"), tr("Please select an editable schedule on the dropbox and retry"), QMessageBox::Ok);
+        return;
+    }
+
+    bool ok;
+    int baud = QInputDialog::getInt(this, tr("Fit to link"), tr("Link rate [bits/s]:"), 57600, 1200, 10000000, 1, &ok);
+    if (!ok)
+        return;
+    // 8N1 framing, and some room for everything else going over the link
+    const double budget = baud / 10.0 * FIT_LINK_USE_PERCENT / 100.0;
+
+    struct FitEntry {
+        int row;
+        UAVObject *obj;
+        double packetBytes;
+        double wantedMs;
+        bool pinned;
+    };
+
+    QSet<int> pinnedRows;
+    foreach (QModelIndex index, telemetryScheduleView->selectionModel()->selectedIndexes()) {
+        if (index.column() == col)
+            pinnedRows.insert(index.row());
+    }
+
+    QVector<FitEntry> entries;
+    double pinnedBps = 0;
+    for (int i = 1; i < schedulerModel->rowCount(); i++) {
+        UAVObject *obj = objManager->getObject(schedulerModel->verticalHeaderItem(i)->text());
+        UAVDataObject *dobj = dynamic_cast<UAVDataObject*>(obj);
+        if (!dobj || !dobj->getIsPresentOnHardware())
+            continue;
+
+        FitEntry entry;
+        entry.row = i;
+        entry.obj = obj;
+        entry.packetBytes = obj->getNumBytes() + UAVTalk::CHECKSUM_LENGTH +
+                (obj->isSingleInstance() ? UAVTalk::MIN_HEADER_LENGTH : UAVTalk::MAX_HEADER_LENGTH);
+
+        QModelIndex index = schedulerModel->index(i, col, QModelIndex());
+        if (schedulerModel->data(index).isValid() && stripMs(schedulerModel->data(index)) >= 0)
+            entry.wantedMs = stripMs(schedulerModel->data(index));
+        else
+            entry.wantedMs = defaultMdata.value(obj->getName().append("Meta")).flightTelemetryUpdatePeriod;
+
+        // On change only, or not sent at all
+        if (entry.wantedMs <= 0)
+            continue;
+
+        entry.pinned = pinnedRows.contains(i);
+        if (entry.pinned)
+            pinnedBps += entry.packetBytes * 1000 / entry.wantedMs;
+        entries.append(entry);
+    }
+
+    // Bytes/s of the unpinned objects, slowed down by factor
+    auto scaledBps = [&entries](double factor) {
+        double bps = 0;
+        foreach (const FitEntry &entry, entries) {
+            if (!entry.pinned)
+                bps += entry.packetBytes * 1000 / qMax(entry.wantedMs, qMin(entry.wantedMs * factor, (double) FIT_MAX_PERIOD_MS));
+        }
+        return bps;
+    };
+
+    if (pinnedBps + scaledBps(FIT_MAX_PERIOD_MS) > budget) {
+        QMessageBox::warning(this, tr("Fit to link"),
+                             tr("The schedule can't fit in %1 B/s: the kept objects alone need %2 B/s, and %3 B/s with everything else at its slowest.")
+                             .arg(lround(budget)).arg(lround(pinnedBps)).arg(lround(pinnedBps + scaledBps(FIT_MAX_PERIOD_MS))),
+                             QMessageBox::Ok);
+        return;
+    }
+
+    double factor = 1;
+    if (pinnedBps + scaledBps(1) > budget) {
+        double low = 1, high = FIT_MAX_PERIOD_MS;
+        for (int i = 0; i < 50; i++) {
+            double mid = (low + high) / 2;
+            if (pinnedBps + scaledBps(mid) > budget)
+                low = mid;
+            else
+                high = mid;
+        }
+        factor = high;
+    }
+
+    fitPrediction.clear();
+    double predictedBps = 0;
+    foreach (const FitEntry &entry, entries) {
+        double periodMs = entry.wantedMs;
+        if (!entry.pinned && factor > 1) {
+            periodMs = qMax(entry.wantedMs, qMin(entry.wantedMs * factor, (double) FIT_MAX_PERIOD_MS));
+            // Only ever round towards slower
+            periodMs = ceil(periodMs / FIT_PERIOD_STEP_MS) * FIT_PERIOD_STEP_MS;
+        }
+
+        QModelIndex index = schedulerModel->index(entry.row, col, QModelIndex());
+        schedulerModel->setData(index, QString("%1ms").arg(lround(periodMs)));
+
+        double bps = entry.packetBytes * 1000 / periodMs;
+        fitPrediction.insert(entry.obj->getObjID(), bps);
+        predictedBps += bps;
+    }
+
+    qDebug() << "[scheduler] Fitted" << columnHeaders.at(col) << "to" << lround(budget) << "B/s, slowed by" << factor
+             << ", expecting" << lround(predictedBps) << "B/s";
+
+    if (m_telemetryeditor->bnApplySchedule->isVisible() && telMngr->isConnected()) {
+        fitPending = true;
+        m_telemetryeditor->bnApplySchedule->click();
+    }
+}
+
+/**
+ * @brief TelemetrySchedulerGadgetWidget::verifyFit Compare what the objects
+ * used over the verification period with what the fit predicted
+ */
+void TelemetrySchedulerGadgetWidget::verifyFit()
+{
+    const double period = FIT_VERIFY_PERIOD_MS / 1000.0;
+    double predictedBps = 0, measuredBps = 0;
+    QStringList over;
+
+    foreach (const Telemetry::ObjectStats &now, telMngr->getObjectStats()) {
+        if (!fitPrediction.contains(now.com.objId))
+            continue;
+
+        Telemetry::ObjectStats prev = fitStartStats.value(now.com.objId);
+        if (now.com.rxBytes < prev.com.rxBytes)
+            prev = Telemetry::ObjectStats();
+
+        double predicted = fitPrediction.value(now.com.objId);
+        double measured = (now.com.rxBytes - prev.com.rxBytes) / period;
+        predictedBps += predicted;
+        measuredBps += measured;
+
+        // Allow for the jitter of a few packets over the period
+        if (measured > predicted * 1.2 + 2 * UAVTalk::MAX_HEADER_LENGTH / period) {
+            UAVObject *obj = objManager->getObject(now.com.objId);
+            over << QString("%1: %2 B/s, expected %3 B/s").arg(obj ? obj->getName() : QString::number(now.com.objId, 16))
+                    .arg(lround(measured)).arg(lround(predicted));
+        }
+    }
+
+    QString text = tr("Measured %1 B/s of telemetry, %2 B/s were expected.").arg(lround(measuredBps)).arg(lround(predictedBps));
+    if (!over.isEmpty())
+        text += "\n\n" + tr("Objects above their expected rate:") + "\n" + over.join("\n");
+    QMessageBox::information(this, tr("Fit to link"), text, QMessageBox::Ok);
+}
+
 void TelemetrySchedulerGadgetWidget::loadTelemetryFromFile()
 {
     // ask for file name
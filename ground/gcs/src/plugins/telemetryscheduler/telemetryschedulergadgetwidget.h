@@ -32,8 +32,11 @@
 #include <QStandardItemModel>
 #include <QItemDelegate>
 #include <QLabel>
+#include <QTableWidget>
+#include <QTimer>
 
 #include "uavobjectutil/uavobjectutilmanager.h"
+#include "uavtalk/telemetrymanager.h"
 #include "extensionsystem/pluginmanager.h"
 #include "uavobject.h"
 
@@ -75,6 +78,9 @@ private slots:
     void customMenuRequested(QPoint pos);
     void uavoPresentOnHardwareChanged(UAVDataObject*);
     void onHideNotPresent(bool);
+    void updateLinkUsage();
+    void fitToLink();
+    void verifyFit();
 private:
     int stripMs(QVariant rate_ms);
     QList<UAVMetaObject *> metaObjectsToSave;
@@ -96,6 +102,23 @@ private:
     QFrozenTableViewWithCopyPaste *telemetryScheduleView;
     QStandardItemModel *frozenModel;
 
+    //! Link usage of the busiest objects on the live connection
+    static const int LINK_USAGE_PERIOD_MS = 1000;
+    static const int LINK_USAGE_ROWS = 10;
+    TelemetryManager *telMngr;
+    QTableWidget *linkUsageTable;
+    QTimer *linkUsageTimer;
+    QHash<quint32, Telemetry::ObjectStats> lastLinkStats;
+
+    //! Fitting a schedule to the link rate
+    static const int FIT_LINK_USE_PERCENT = 80;     // Left for acks, GCS traffic and framing
+    static const int FIT_MAX_PERIOD_MS = 10000;     // Slowest an object is pushed to
+    static const int FIT_PERIOD_STEP_MS = 10;
+    static const int FIT_VERIFY_PERIOD_MS = 10000;
+    bool fitPending;
+    QHash<quint32, double> fitPrediction;           // Bytes/s by object ID
+    QHash<quint32, Telemetry::ObjectStats> fitStartStats;
+
 };
 
 
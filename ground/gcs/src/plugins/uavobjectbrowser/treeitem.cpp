@@ -36,73 +36,86 @@
 #include "fieldtreeitem.h"
 #include <math.h>
 
-QTime* HighLightManager::m_currentTime = NULL;
-
 /* Constructor */
-HighLightManager::HighLightManager(long checkingInterval, QTime *currentTime)
+HighLightManager::HighLightManager(int tickMs) :
+    m_tickMs(tickMs),
+    m_cursor(0),
+    m_slots(WHEEL_SLOTS)
 {
-    // Start the timer and connect it to the callback
-    m_expirationTimer.start(checkingInterval);
-    connect(&m_expirationTimer, SIGNAL(timeout()), this, SLOT(checkItemsExpired()));
-
-    if (currentTime == NULL)
-        m_currentTime = new QTime;
-    m_currentTime = currentTime;
+    // The timer is started when the first item is added
+    connect(&m_wheelTimer, SIGNAL(timeout()), this, SLOT(advance()));
 }
 
 /*
- * Called to add item to list. Item is only added if absent.
+ * Called to add item to the wheel, or to move it to the
+ * slot of its new expiry if it is there already.
  * Returns true if item was added, otherwise false.
  */
-bool HighLightManager::add(TreeItem *itemToAdd)
+bool HighLightManager::add(TreeItem *itemToAdd, int highlightMs)
 {
-    // Check so that the item isn't already in the list
-    if(!m_itemsList.contains(itemToAdd))
-    {
-        m_itemsList.append(itemToAdd);
-        return true;
-    }
-    return false;
+    bool added = !m_expiries.contains(itemToAdd);
+    if (!added)
+        m_slots[m_expiries[itemToAdd].slot].remove(itemToAdd);
+
+    // Ticks until the expiry, at least one
+    int ticks = qMax(1, (highlightMs + m_tickMs - 1) / m_tickMs);
+
+    Expiry expiry;
+    expiry.slot = (m_cursor + ticks) % WHEEL_SLOTS;
+    expiry.turns = (ticks - 1) / WHEEL_SLOTS;
+    m_slots[expiry.slot].insert(itemToAdd);
+    m_expiries.insert(itemToAdd, expiry);
+
+    if (!m_wheelTimer.isActive())
+        m_wheelTimer.start(m_tickMs);
+
+    return added;
 }
 
 /*
- * Called to remove item from list.
+ * Called to remove item from the wheel.
  * Returns true if item was removed, otherwise false.
  */
 bool HighLightManager::remove(TreeItem *itemToRemove)
 {
-    // Remove item and return result
-    return m_itemsList.removeOne(itemToRemove);
+    if (!m_expiries.contains(itemToRemove))
+        return false;
+
+    m_slots[m_expiries.take(itemToRemove).slot].remove(itemToRemove);
+    return true;
 }
 
 /*
- * Callback called periodically by the timer.
- * This method checks for expired highlights and
- * removes them if they are expired.
- * Expired highlights are restored.
+ * Callback called on each tick of the timer.
+ * Turns the wheel one slot and restores the
+ * highlights of the items expiring there.
  */
-void HighLightManager::checkItemsExpired()
+void HighLightManager::advance()
 {
-    // Get a mutable iterator for the list
-    QMutableLinkedListIterator<TreeItem*> iter(m_itemsList);
-
-    // Loop over all items, check if they expired.
-    while(iter.hasNext())
-    {
-        TreeItem* item = iter.next();
-        if(item->getHiglightExpires() < *m_currentTime)
-        {
-            // If expired, call removeHighlight
-            item->removeHighlight();
-
-            // Remove from list since it is restored.
-            iter.remove();
+    m_cursor = (m_cursor + 1) % WHEEL_SLOTS;
+
+    // Take the slot out first, removeHighlight() may add items back
+    QSet<TreeItem*> due;
+    due.swap(m_slots[m_cursor]);
+
+    foreach (TreeItem *item, due) {
+        Expiry &expiry = m_expiries[item];
+        if (expiry.turns > 0) {
+            // Not this turn of the wheel
+            expiry.turns--;
+            m_slots[m_cursor].insert(item);
+            continue;
         }
+
+        m_expiries.remove(item);
+        item->removeHighlight();
     }
+
+    if (m_expiries.isEmpty())
+        m_wheelTimer.stop();
 }
 
 int TreeItem::m_highlightTimeMs = 500;
-QTime* TreeItem::m_currentTime = NULL;
 
 TreeItem::TreeItem(const QList<QVariant> &data, TreeItem *parent) :
         QObject(0),
@@ -112,7 +125,8 @@ TreeItem::TreeItem(const QList<QVariant> &data, TreeItem *parent) :
         m_highlight(false),
         m_changed(false),
         m_updated(false),
-        m_defaultValue(true)
+        m_defaultValue(true),
+        m_highlightManager(0)
 {
 }
 
@@ -123,13 +137,16 @@ TreeItem::TreeItem(const QVariant &data, TreeItem *parent) :
         m_highlight(false),
         m_changed(false),
         m_updated(false),
-        m_defaultValue(true)
+        m_defaultValue(true),
+        m_highlightManager(0)
 {
     m_data << data << "" << "";
 }
 
 TreeItem::~TreeItem()
 {
+    if (m_highlightManager)
+        m_highlightManager->remove(this);
     qDeleteAll(m_children);
 }
 
@@ -201,14 +218,8 @@ void TreeItem::setHighlight(bool highlight) {
     m_highlight = highlight;
     m_changed = false;
     if (highlight) {
-        // Update the expires timestamp
-        if (m_currentTime != NULL)
-            m_highlightExpires = m_currentTime->addMSecs(m_highlightTimeMs);
-        else
-            m_highlightExpires = QTime::currentTime().addMSecs(m_highlightTimeMs);
-
-        // Add to highlightmanager
-        if(m_highlightManager->add(this))
+        // Add to highlightmanager, or push its expiry back
+        if(m_highlightManager->add(this, m_highlightTimeMs))
         {
             // Only emit signal if it was added
             emit updateHighlight(this);
@@ -266,18 +277,6 @@ void TreeItem::setHighlightManager(HighLightManager *mgr)
     m_highlightManager = mgr;
 }
 
-QTime TreeItem::getHiglightExpires()
-{
-    return m_highlightExpires;
-}
-
-void TreeItem::setCurrentTime(QTime *currentTime)
-{
-    if (m_currentTime == NULL)
-        m_currentTime = new QTime;
-    m_currentTime = currentTime;
-}
-
 void TreeItem::setIsDefaultValue(bool isDefault)
 {
     m_defaultValue = isDefault;
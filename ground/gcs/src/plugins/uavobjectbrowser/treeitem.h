@@ -40,7 +40,9 @@
 #include "uavmetaobject.h"
 #include "uavobjectfield.h"
 #include <QtCore/QList>
-#include <QtCore/QLinkedList>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtCore/QVector>
 #include <QtCore/QMap>
 #include <QtCore/QVariant>
 #include <QtCore/QTime>
@@ -53,45 +55,49 @@ class TreeItem;
 /*
 * Small utility class that handles the higlighting of
 * tree grid items.
-* Basicly it maintains all items due to be restored to
-* non highlighted state in a linked list.
-* A timer traverses this list periodically to find out
-* if any of the items should be restored. All items are
-* updated withan expiration timestamp when they expires.
-* An item that is beeing restored is removed from the
-* list and its removeHighlight() method is called. Items
-* that are not expired are left in the list til next time.
-* Items that are updated during the expiration time are
-* left untouched in the list. This reduces unwanted emits
-* of signals to the repaint/update function.
+* Highlighted items are kept in a timer wheel: a ring of
+* slots, each holding the items expiring when the wheel
+* reaches it. A single timer turns the wheel one slot per
+* tick, and only the items of that slot are looked at.
+* Items expiring after more than a turn of the wheel
+* count down the turns left. An item highlighted again
+* is moved to its new slot, without emitting anything,
+* which reduces unwanted emits of signals to the
+* repaint/update function. The timer only runs while
+* items are highlighted.
 */
 class HighLightManager : public QObject
 {
 Q_OBJECT
 public:
-    // Constructor taking the checking interval in ms.
-    HighLightManager(long checkingInterval, QTime *currentTime);
+    // Constructor taking the wheel tick in ms.
+    HighLightManager(int tickMs);
 
     // This is called when an item has been set to
-    // highlighted = true.
-    bool add(TreeItem* itemToAdd);
+    // highlighted = true. Returns true if it was not
+    // highlighted yet.
+    bool add(TreeItem* itemToAdd, int highlightMs);
 
     //This is called when an item is set to highlighted = false;
     bool remove(TreeItem* itemToRemove);
 
 private slots:
     // Timer callback method.
-    void checkItemsExpired();
+    void advance();
 
 private:
-    // The timer checking highlight expiration.
-    QTimer m_expirationTimer;
-
-    // The list holding all items due to be updated.
-    QLinkedList<TreeItem*> m_itemsList;
-
-    // This is the timestamp to compare with
-    static QTime *m_currentTime;
+    struct Expiry {
+        int slot;
+        int turns;
+    };
+
+    static const int WHEEL_SLOTS = 32;
+
+    QTimer m_wheelTimer;
+    int m_tickMs;
+    int m_cursor;
+    QVector<QSet<TreeItem*> > m_slots;
+    QHash<TreeItem*, Expiry> m_expiries;
 };
 
 class TreeItem : public QObject
@@ -152,8 +158,6 @@ public:
     void setUpdatedOnlyParent();
     virtual void setHighlightManager(HighLightManager* mgr);
 
-    QTime getHiglightExpires();
-
     virtual void removeHighlight();
 
     int nameIndex(QString name) {
@@ -174,7 +178,6 @@ public:
         return 0;
     }
 
-    void setCurrentTime(QTime *currentTime);
     bool isDefaultValue();
     void setIsDefaultValue(bool isDefault);
 
@@ -193,11 +196,8 @@ private:
     bool m_changed;
     bool m_updated;
     bool m_defaultValue;
-    QTime m_highlightExpires;
     HighLightManager* m_highlightManager;
     static int m_highlightTimeMs;
-    // This is the timestamp to compare with
-    static QTime *m_currentTime;
 public:
     static const int dataColumn = 1;
 };
@@ -234,21 +234,53 @@ private:
     QMap<quint32, MetaObjectTreeItem*> m_metaObjectTreeItemsPerObjectIds;
 };
 
+/*
+* The field items of an object are only created when the
+* object is expanded (see UAVObjectTreeModel::fetchMore).
+* Until then, and while it is collapsed, the object keeps
+* its last packed data, to tell whether an update changed it.
+*/
 class ObjectTreeItem : public TreeItem
 {
 Q_OBJECT
 public:
     ObjectTreeItem(const QList<QVariant> &data, TreeItem *parent = 0) :
-            TreeItem(data, parent), m_obj(0) { }
+            TreeItem(data, parent), m_obj(0), m_fieldsPopulated(false), m_expanded(false) { }
     ObjectTreeItem(const QVariant &data, TreeItem *parent = 0) :
-            TreeItem(data, parent), m_obj(0) { }
+            TreeItem(data, parent), m_obj(0), m_fieldsPopulated(false), m_expanded(false) { }
     virtual void setObject(UAVObject *obj) {
         m_obj = obj; setDescription(obj->getDescription());
+        m_lastData = packedData();
     }
     inline UAVObject *object() { return m_obj; }
 
+    inline bool fieldsPopulated() const { return m_fieldsPopulated; }
+    inline void setFieldsPopulated(bool populated) { m_fieldsPopulated = populated; }
+    inline bool expanded() const { return m_expanded; }
+    inline void setExpanded(bool expanded) { m_expanded = expanded; }
+
+    // Returns true if the object data differs from the last call
+    bool packedDataChanged() {
+        QByteArray packed = packedData();
+        if (packed == m_lastData)
+            return false;
+        m_lastData = packed;
+        return true;
+    }
+
 private:
+    QByteArray packedData() {
+        if (!m_obj)
+            return QByteArray();
+        QByteArray packed(m_obj->getNumBytes(), 0);
+        m_obj->pack((quint8 *) packed.data());
+        return packed;
+    }
+
     UAVObject *m_obj;
+    bool m_fieldsPopulated;
+    bool m_expanded;
+    QByteArray m_lastData;
 };
 
 class MetaObjectTreeItem : public ObjectTreeItem
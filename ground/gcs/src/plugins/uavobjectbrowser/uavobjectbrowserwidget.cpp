@@ -88,6 +88,7 @@ UAVObjectBrowserWidget::UAVObjectBrowserWidget(QWidget *parent) : QWidget(parent
 void UAVObjectBrowserWidget::onTreeItemExpanded(QModelIndex currentProxyIndex)
 {
     QModelIndex currentIndex = proxyModel->mapToSource(currentProxyIndex);
+    m_model->setExpanded(currentIndex, true);
     TreeItem *item = static_cast<TreeItem*>(currentIndex.internalPointer());
     TopTreeItem *top = dynamic_cast<TopTreeItem*>(item->parent());
 
@@ -148,6 +149,7 @@ void UAVObjectBrowserWidget::onTreeItemExpanded(QModelIndex currentProxyIndex)
 void UAVObjectBrowserWidget::onTreeItemCollapsed(QModelIndex currentProxyIndex)
 {
     QModelIndex currentIndex = proxyModel->mapToSource(currentProxyIndex);
+    m_model->setExpanded(currentIndex, false);
     TreeItem *item = static_cast<TreeItem*>(currentIndex.internalPointer());
     TopTreeItem *top = dynamic_cast<TopTreeItem*>(item->parent());
 
@@ -781,6 +783,26 @@ bool TreeSortFilterProxyModel::filterAcceptsRowItself(int source_row, const QMod
     return QSortFilterProxyModel::filterAcceptsRow(source_row, source_parent);
 }
 
+/**
+ * @brief TreeSortFilterProxyModel::fieldsAccepted Matches the names the field
+ * items of an object get, as UAVObjectTreeModel creates them
+ */
+bool TreeSortFilterProxyModel::fieldsAccepted(UAVObject *obj) const
+{
+    const QRegExp regExp = filterRegExp();
+    foreach (UAVObjectField *field, obj->getFields()) {
+        if (regExp.indexIn(field->getName()) != -1)
+            return true;
+        if (field->getNumElements() > 1) {
+            foreach (QString element, field->getElementNames()) {
+                if (regExp.indexIn(QString("[%1]").arg(element)) != -1)
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
 bool TreeSortFilterProxyModel::hasAcceptedChildren(int source_row, const QModelIndex &source_parent) const
 {
     QModelIndex item = sourceModel()->index(source_row,0,source_parent);
@@ -789,6 +811,14 @@ bool TreeSortFilterProxyModel::hasAcceptedChildren(int source_row, const QModelI
         return false;
     }
 
+    // The fields of an object not expanded yet have no items, look at the
+    // names they will have
+    if (sourceModel()->canFetchMore(item)) {
+        ObjectTreeItem *objItem = dynamic_cast<ObjectTreeItem*>(static_cast<TreeItem*>(item.internalPointer()));
+        if (objItem && objItem->object() && fieldsAccepted(objItem->object()))
+            return true;
+    }
+
     //check if there are children
     int childCount = item.model()->rowCount(item);
     if (childCount == 0)
@@ -50,6 +50,7 @@ protected:
     bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const;
     bool filterAcceptsRowItself(int source_row, const QModelIndex &source_parent) const;
     bool hasAcceptedChildren(int source_row, const QModelIndex &source_parent) const;
+    bool fieldsAccepted(UAVObject *obj) const;
 };
 
 class UAVOBrowserTreeView : public QTreeView
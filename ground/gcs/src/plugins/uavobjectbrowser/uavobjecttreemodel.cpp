@@ -48,6 +48,11 @@
 
 #include <QApplication>
 
+// Highlight timer wheel tick, in ms
+#define HIGHLIGHT_TICK_PERIOD 50
+// Updated objects are refreshed at most once per frame
+#define REFRESH_PERIOD 16
+
 UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool useScientificNotation) :
     QAbstractItemModel(parent),
     m_rootItem(NULL),
@@ -66,11 +71,9 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool useScientificNotati
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     objManager = pm->getObject<UAVObjectManager>();
 
-    m_currentTime = QTime::currentTime();
-    // Create timer that sets the rhythm for all highlight events.
-    connect(&m_currentTimeTimer, SIGNAL(timeout()), this, SLOT(updateCurrentTime()));
-    m_currentTimeTimer.start(lrint(fmax(m_recentlyUpdatedTimeout / 10.0f, 10))); // Update the timer 10 times faster than the time
-                                                                                 // out. In any case, never go faster than 10ms.
+    m_refreshTimer.setSingleShot(true);
+    m_refreshTimer.setInterval(REFRESH_PERIOD);
+    connect(&m_refreshTimer, SIGNAL(timeout()), this, SLOT(refreshUpdatedObjects()));
     TreeItem::setHighlightTime(m_recentlyUpdatedTimeout);
 
     QFont font;
@@ -81,8 +84,8 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool useScientificNotati
 
 UAVObjectTreeModel::~UAVObjectTreeModel()
 {
-    delete m_highlightManager;
     delete m_rootItem;
+    delete m_highlightManager;
 }
 
 /**
@@ -101,18 +104,18 @@ void UAVObjectTreeModel::setupModelData(UAVObjectManager *objManager, bool categ
         disconnect(objManager, SIGNAL(newObject(UAVObject*)), this, SLOT(newObject(UAVObject*)));
         disconnect(objManager, SIGNAL(newInstance(UAVObject*)), this, SLOT(newObject(UAVObject*)));
         disconnect(objManager, SIGNAL(instanceRemoved(UAVObject*)), this, SLOT(instanceRemove(UAVObject*)));
-        delete m_highlightManager;
+        m_updatedItems.clear();
         int count = m_rootItem->childCount();
         beginRemoveRows(index(m_rootItem), 0, count);
         delete m_rootItem;
         endRemoveRows();
+        delete m_highlightManager;
     }
-    // Create highlight manager, let it run every 300 ms.
-    m_highlightManager = new HighLightManager(300, &m_currentTime);
+    // Create highlight manager, its wheel turns every 50 ms.
+    m_highlightManager = new HighLightManager(HIGHLIGHT_TICK_PERIOD);
     QList<QVariant> rootData;
     rootData << tr("Property") << tr("Value") << tr("Unit");
     m_rootItem = new TreeItem(rootData);
-    m_rootItem->setCurrentTime(&m_currentTime);
 
     m_settingsTree = new TopTreeItem(tr("Settings"), m_rootItem);
     m_settingsTree->setHighlightManager(m_highlightManager);
@@ -163,6 +166,7 @@ void UAVObjectTreeModel::instanceRemove(UAVObject *obj)
             InstanceTreeItem *inst = dynamic_cast<InstanceTreeItem*>(item);
             if(inst && inst->object() == obj)
             {
+                m_updatedItems.remove(inst);
                 inst->parent()->removeChild(inst);
                 inst->deleteLater();
             }
@@ -220,34 +224,26 @@ TreeItem* UAVObjectTreeModel::createCategoryItems(QStringList categoryPath, Tree
 
 MetaObjectTreeItem* UAVObjectTreeModel::addMetaObject(UAVMetaObject *obj, TreeItem *parent)
 {
-    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(highlightUpdatedObject(UAVObject*)));
+    connect(obj, SIGNAL(objectUpdatedCoalesced(UAVObject*, quint64)), this, SLOT(highlightUpdatedObject(UAVObject*)));
     MetaObjectTreeItem *meta = new MetaObjectTreeItem(obj, tr("Meta Data"));
 
     meta->setHighlightManager(m_highlightManager);
     connect(meta, SIGNAL(updateHighlight(TreeItem*)), this, SLOT(updateHighlight(TreeItem*)));
-    foreach (UAVObjectField *field, obj->getFields()) {
-        if (field->getNumElements() > 1) {
-            addArrayField(field, meta);
-        } else {
-            addSingleField(0, field, meta);
-        }
-    }
+    // The fields are added by fetchMore(), when the item is expanded
     parent->appendChild(meta);
     return meta;
 }
 
 void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
 {
-    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(highlightUpdatedObject(UAVObject*)));
-    TreeItem *item;
+    connect(obj, SIGNAL(objectUpdatedCoalesced(UAVObject*, quint64)), this, SLOT(highlightUpdatedObject(UAVObject*)));
     DataObjectTreeItem *p = static_cast<DataObjectTreeItem*>(parent);
     if (obj->isSingleInstance()) {
-        item = parent;
         p->setObject(obj);
     } else {
         p->setObject(NULL);
         QString name = tr("Instance") +  " " + QString::number(obj->getInstID());
-        item = new InstanceTreeItem(obj, name);
+        TreeItem *item = new InstanceTreeItem(obj, name);
         item->setHighlightManager(m_highlightManager);
         connect(item, SIGNAL(updateHighlight(TreeItem*)), this, SLOT(updateHighlight(TreeItem*)));
 
@@ -260,13 +256,7 @@ void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
         // Inform the model that the row addition is complete
         endInsertRows();
     }
-    foreach (UAVObjectField *field, obj->getFields()) {
-        if (field->getNumElements() > 1) {
-            addArrayField(field, item);
-        } else {
-            addSingleField(0, field, item);
-        }
-    }
+    // The fields are added by fetchMore(), when the item is expanded
     UAVDataObject * dobj = dynamic_cast<UAVDataObject *>(obj);
     if(dobj)
     {
@@ -274,6 +264,17 @@ void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
     }
 }
 
+void UAVObjectTreeModel::addFields(UAVObject *obj, TreeItem *parent)
+{
+    foreach (UAVObjectField *field, obj->getFields()) {
+        if (field->getNumElements() > 1) {
+            addArrayField(field, parent);
+        } else {
+            addSingleField(0, field, parent);
+        }
+    }
+}
+
 void UAVObjectTreeModel::addArrayField(UAVObjectField *field, TreeItem *parent)
 {
     TreeItem *item = new ArrayFieldTreeItem(field->getName());
@@ -402,6 +403,81 @@ int UAVObjectTreeModel::columnCount(const QModelIndex &parent) const
         return m_rootItem->columnCount();
 }
 
+/**
+ * @brief UAVObjectTreeModel::unpopulatedObjectItem Returns the object item at
+ * an index if its fields were not created yet, otherwise NULL
+ */
+ObjectTreeItem *UAVObjectTreeModel::unpopulatedObjectItem(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.column() > 0)
+        return NULL;
+
+    ObjectTreeItem *item = dynamic_cast<ObjectTreeItem*>(static_cast<TreeItem*>(index.internalPointer()));
+    if (!item || !item->object() || item->fieldsPopulated())
+        return NULL;
+
+    return item;
+}
+
+bool UAVObjectTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    if (unpopulatedObjectItem(parent))
+        return true;
+
+    return QAbstractItemModel::hasChildren(parent);
+}
+
+bool UAVObjectTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    return unpopulatedObjectItem(parent) != NULL;
+}
+
+/**
+ * @brief UAVObjectTreeModel::fetchMore Creates the field items of an object,
+ * which the view asks for when the object is first expanded
+ */
+void UAVObjectTreeModel::fetchMore(const QModelIndex &parent)
+{
+    ObjectTreeItem *item = unpopulatedObjectItem(parent);
+    if (!item)
+        return;
+
+    UAVObject *obj = item->object();
+    int first = item->childCount();
+    int count = obj->getFields().count();
+
+    item->setFieldsPopulated(true);
+    if (count == 0)
+        return;
+
+    beginInsertRows(parent, first, first + count - 1);
+    addFields(obj, item);
+    foreach (TreeItem *child, item->treeChildren().mid(first))
+        child->setIsPresentOnHardware(item->getIsPresentOnHardware());
+    endInsertRows();
+}
+
+/**
+ * @brief UAVObjectTreeModel::setExpanded Tells the model whether the fields
+ * of an object are on view. Only those are updated as the object changes
+ * @param index Index of the object
+ */
+void UAVObjectTreeModel::setExpanded(const QModelIndex &index, bool expanded)
+{
+    if (!index.isValid())
+        return;
+
+    ObjectTreeItem *item = dynamic_cast<ObjectTreeItem*>(static_cast<TreeItem*>(index.internalPointer()));
+    if (!item)
+        return;
+
+    item->setExpanded(expanded);
+
+    // Catch up with the updates missed while collapsed
+    if (expanded && item->fieldsPopulated())
+        item->update();
+}
+
 QList<QModelIndex> UAVObjectTreeModel::getMetaDataIndexes()
 {
     QList<QModelIndex> metaIndexes;
@@ -535,15 +611,57 @@ void UAVObjectTreeModel::highlightUpdatedObject(UAVObject *obj)
     Q_ASSERT(obj);
     ObjectTreeItem *item = findObjectTreeItem(obj);
     Q_ASSERT(item);
-    if(!m_onlyHighlightChangedValues){
-        item->setHighlight(true);
+
+    // Objects updated several times in a frame are only refreshed once
+    m_updatedItems.insert(item);
+    if (!m_refreshTimer.isActive())
+        m_refreshTimer.start();
+}
+
+/**
+ * @brief UAVObjectTreeModel::refreshUpdatedObjects Refreshes the objects
+ * updated since the last call
+ */
+void UAVObjectTreeModel::refreshUpdatedObjects()
+{
+    QSet<ObjectTreeItem*> updatedItems;
+    updatedItems.swap(m_updatedItems);
+
+    foreach (ObjectTreeItem *item, updatedItems) {
+        if(!m_onlyHighlightChangedValues){
+            item->setHighlight(true);
+        }
+        updateFields(item);
+        if(!m_onlyHighlightChangedValues){
+            QModelIndex itemIndex = index(item);
+            Q_ASSERT(itemIndex != QModelIndex());
+            emit dataChanged(itemIndex, itemIndex);
+        }
     }
-    item->update();
-    if(!m_onlyHighlightChangedValues){
-        QModelIndex itemIndex = index(item);
-        Q_ASSERT(itemIndex != QModelIndex());
-        emit dataChanged(itemIndex, itemIndex);
+}
+
+/**
+ * @brief UAVObjectTreeModel::updateFields Updates the fields of an object
+ * that are on view. For the others, only the object row shows the change.
+ * @param item The object, or the parent of its instances
+ */
+void UAVObjectTreeModel::updateFields(ObjectTreeItem *item)
+{
+    if (!item->object()) {
+        // Multiple instances, each holding its own fields
+        foreach (TreeItem *child, item->treeChildren()) {
+            InstanceTreeItem *instance = dynamic_cast<InstanceTreeItem*>(child);
+            if (instance)
+                updateFields(instance);
+        }
+        return;
     }
+
+    bool changed = item->packedDataChanged();
+    if (item->fieldsPopulated() && item->expanded())
+        item->update();
+    else if (changed && m_onlyHighlightChangedValues)
+        item->setHighlight(true);
 }
 
 ObjectTreeItem* UAVObjectTreeModel::findObjectTreeItem(UAVObject *object)
@@ -583,15 +701,6 @@ void UAVObjectTreeModel::updateHighlight(TreeItem *item)
     emit dataChanged(itemIndex, itemIndex.sibling(itemIndex.row(), TreeItem::dataColumn));
 }
 
-
-/**
- * @brief TreeItem::updateCurrentTime  This single timer sets the rhythm for all highlight events.
- */
-void UAVObjectTreeModel::updateCurrentTime()
-{
-    m_currentTime = QTime::currentTime();
-}
-
 void UAVObjectTreeModel::presentOnHardwareChangedCB(UAVDataObject * obj)
 {
     Q_UNUSED(obj);
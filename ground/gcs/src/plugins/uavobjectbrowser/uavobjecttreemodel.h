@@ -39,6 +39,8 @@
 #include <QAbstractItemModel>
 #include <QtCore/QMap>
 #include <QtCore/QList>
+#include <QtCore/QSet>
+#include <QtCore/QTimer>
 #include <QColor>
 #include <QFont>
 
@@ -70,6 +72,11 @@ public:
     QModelIndex parent(const QModelIndex &index) const;
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
     int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
+
+    void setExpanded(const QModelIndex &index, bool expanded);
 
     TopTreeItem* getSettingsTree(){return m_settingsTree;}
     TopTreeItem* getNonSettingsTree(){return m_nonSettingsTree;}
@@ -96,8 +103,8 @@ public slots:
     void instanceRemove(UAVObject*);
 private slots:
     void highlightUpdatedObject(UAVObject *obj);
+    void refreshUpdatedObjects();
     void updateHighlight(TreeItem*);
-    void updateCurrentTime();
     void presentOnHardwareChangedCB(UAVDataObject*);
 
 private:
@@ -107,7 +114,10 @@ private:
     MetaObjectTreeItem *addMetaObject(UAVMetaObject *obj, TreeItem *parent);
     void addArrayField(UAVObjectField *field, TreeItem *parent);
     void addSingleField(int index, UAVObjectField *field, TreeItem *parent);
+    void addFields(UAVObject *obj, TreeItem *parent);
     void addInstance(UAVObject *obj, TreeItem *parent);
+    ObjectTreeItem *unpopulatedObjectItem(const QModelIndex &index) const;
+    void updateFields(ObjectTreeItem *item);
 
     TreeItem *createCategoryItems(QStringList categoryPath, TreeItem *root);
 
@@ -131,8 +141,9 @@ private:
     bool m_useScientificFloatNotation;
     bool m_hideNotPresent;
     bool m_categorize;
-    QTimer m_currentTimeTimer;
-    QTime m_currentTime;
+    // Objects updated since the last refresh, refreshed at most once per frame
+    QSet<ObjectTreeItem*> m_updatedItems;
+    QTimer m_refreshTimer;
     UAVObjectManager *objManager;
     // Highlight manager to handle highlighting of tree items.
     HighLightManager *m_highlightManager;
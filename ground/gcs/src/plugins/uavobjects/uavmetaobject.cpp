@@ -101,6 +101,7 @@ void UAVMetaObject::setData(const Metadata& mdata)
     parentMetadata = mdata;
     emit objectUpdatedAuto(this); // trigger object updated event
     emit objectUpdated(this);
+    queueCoalescedUpdate(ALL_FIELDS_DIRTY);
 }
 
 /**
@@ -38,6 +38,12 @@
 #include <QDebug>
 #include <QJsonArray>
 #include <QJsonValue>
+#include <QCoreApplication>
+#include <QMetaMethod>
+#include <QTimer>
+#include <QVarLengthArray>
+#include <QDateTime>
+#include <QElapsedTimer>
 
 // Constants
 #define UAVOBJ_ACCESS_SHIFT 0
@@ -51,6 +57,10 @@
 // Macros
 #define SET_BITS(var, shift, value, mask) var = (var & ~(mask << shift)) |	(value << shift);
 
+QVector<QPointer<UAVObject> > UAVObject::coalescedPending;
+QTimer *UAVObject::coalescedTimer = NULL;
+int UAVObject::coalescedIntervalMs = 16;
+
 /**
  * Constructor
  * @param objID The object ID
@@ -63,6 +73,30 @@ UAVObject::UAVObject(quint32 objID, bool isSingleInst, const QString& name)
     this->instID = 0;
     this->isSingleInst = isSingleInst;
     this->name = name;
+    this->coalescedDirty = 0;
+    this->hostLayout = false;
+    this->timestamp = 0;
+}
+
+namespace {
+// Monotonic clock started at the wall clock time, so the time of day can
+// still be shown, without the cost of building a QDateTime per sample
+struct TimestampClock {
+    TimestampClock() : start(QDateTime::currentMSecsSinceEpoch()) { timer.start(); }
+    qint64 start;
+    QElapsedTimer timer;
+};
+}
+
+/**
+ * Get the time objects are stamped with when they are updated, in ms
+ * since the epoch as of when the GCS started. Links replaying recorded
+ * data stamp objects with the recorded time on this clock instead.
+ */
+qint64 UAVObject::currentTimestamp()
+{
+    static const TimestampClock clock;
+    return clock.start + clock.timer.elapsed();
 }
 
 /**
@@ -92,6 +126,10 @@ void UAVObject::initializeFields(QList<UAVObjectField*>& fields, quint8* data, q
         offset += fields[n]->getNumBytes();
         connect(fields[n], SIGNAL(fieldUpdated(UAVObjectField*)), this, SLOT(fieldUpdated(UAVObjectField*)));
     }
+    // Fields are laid out back to back in the data block, in the same
+    // little-endian encoding as on the wire, so on a little-endian host the
+    // whole block can be copied at once
+    hostLayout = (Q_BYTE_ORDER == Q_LITTLE_ENDIAN) && (offset == numBytes);
 }
 
 /**
@@ -198,8 +236,72 @@ void UAVObject::requestUpdateAllInstances()
  */
 void UAVObject::updated()
 {
+    timestamp = currentTimestamp();
     emit objectUpdatedManual(this);
     emit objectUpdated(this);
+    queueCoalescedUpdate(ALL_FIELDS_DIRTY);
+}
+
+/**
+ * Set how often objectUpdatedCoalesced may fire, for all objects
+ * @param intervalMs Minimum time between emissions
+ */
+void UAVObject::setCoalescedUpdateInterval(int intervalMs)
+{
+    coalescedIntervalMs = intervalMs;
+    if (coalescedTimer)
+        coalescedTimer->setInterval(intervalMs);
+}
+
+/**
+ * Returns true if anything is listening to objectUpdatedCoalesced
+ */
+bool UAVObject::hasCoalescedReceivers()
+{
+    static const QMetaMethod coalescedSignal = QMetaMethod::fromSignal(&UAVObject::objectUpdatedCoalesced);
+    return isSignalConnected(coalescedSignal);
+}
+
+/**
+ * Accumulate changed fields and schedule a coalesced notification
+ * @param dirty Mask of changed fields
+ */
+void UAVObject::queueCoalescedUpdate(quint64 dirty)
+{
+    if (dirty == 0 || !hasCoalescedReceivers())
+        return;
+
+    if (coalescedDirty == 0)
+        coalescedPending.append(this);
+    coalescedDirty |= dirty;
+
+    if (coalescedTimer == NULL)
+    {
+        coalescedTimer = new QTimer(QCoreApplication::instance());
+        coalescedTimer->setSingleShot(true);
+        coalescedTimer->setInterval(coalescedIntervalMs);
+        QObject::connect(coalescedTimer, &QTimer::timeout, &UAVObject::flushCoalescedUpdates);
+    }
+    if (!coalescedTimer->isActive())
+        coalescedTimer->start();
+}
+
+/**
+ * Emit one objectUpdatedCoalesced for each object updated since the last flush
+ */
+void UAVObject::flushCoalescedUpdates()
+{
+    QVector<QPointer<UAVObject> > pending;
+    pending.swap(coalescedPending);
+
+    foreach (const QPointer<UAVObject> &obj, pending)
+    {
+        if (obj.isNull())
+            continue;
+        quint64 dirty = obj->coalescedDirty;
+        obj->coalescedDirty = 0;
+        emit obj->objectUpdatedCoalesced(obj.data(), dirty);
+    }
 }
 
 /**
@@ -273,6 +375,12 @@ UAVObjectField* UAVObject::getField(const QString& name)
  */
 qint32 UAVObject::pack(quint8* dataOut)
 {
+    if (hostLayout)
+    {
+        memcpy(dataOut, data, numBytes);
+        return numBytes;
+    }
+
     qint32 offset = 0;
     for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
     {
@@ -289,16 +397,44 @@ qint32 UAVObject::pack(quint8* dataOut)
  */
 qint32 UAVObject::unpack(const quint8* dataIn)
 {
-    qint32 offset = 0;
-    for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
+    // Only pay for change detection when someone wants the dirty mask
+    bool trackDirty = hasCoalescedReceivers();
+    QVarLengthArray<quint8, 256> previous;
+    if (trackDirty)
     {
-        UAVObjectField *field = *iter;
-        field->unpack(&dataIn[offset]);
-        offset += field->getNumBytes();
+        previous.resize(numBytes);
+        memcpy(previous.data(), data, numBytes);
+    }
+
+    if (hostLayout)
+    {
+        memcpy(data, dataIn, numBytes);
+    }
+    else
+    {
+        qint32 offset = 0;
+        for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
+        {
+            UAVObjectField *field = *iter;
+            field->unpack(&dataIn[offset]);
+            offset += field->getNumBytes();
+        }
     }
     emit objectUnpacked(this); // trigger object updated event
     emit objectUpdated(this);
 
+    if (trackDirty)
+    {
+        quint64 dirty = 0;
+        for (int n = 0; n < fields.length(); ++n)
+        {
+            UAVObjectField *field = fields[n];
+            if (memcmp(&previous[field->getDataOffset()], &data[field->getDataOffset()], field->getNumBytes()))
+                dirty |= 1ULL << qMin(n, 63);
+        }
+        queueCoalescedUpdate(dirty);
+    }
+
     return numBytes;
 }
 
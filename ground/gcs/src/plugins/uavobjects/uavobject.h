@@ -43,6 +43,8 @@
 #include <QString>
 #include <QList>
 #include <QFile>
+#include <QPointer>
+#include <QVector>
 #include <qglobal.h>
 #include "uavobjectfield.h"
 
@@ -61,6 +63,7 @@
 #define UAVOBJ_UPDATE_MODE_MASK 0x3
 
 class UAVObjectField;
+class QTimer;
 
 class UAVOBJECTS_EXPORT UAVObject: public QObject
 {
@@ -150,6 +153,14 @@ public:
     static void SetFlightTelemetryUpdateMode(Metadata& meta, UpdateMode val);
     static UpdateMode GetGcsTelemetryUpdateMode(const Metadata& meta);
     static void SetGcsTelemetryUpdateMode(Metadata& meta, UpdateMode val);
+
+    static const quint64 ALL_FIELDS_DIRTY = ~0ULL;
+    static void setCoalescedUpdateInterval(int intervalMs);
+
+    // Time of the last update, in ms on the clock given by currentTimestamp()
+    qint64 getTimestamp() const { return timestamp; }
+    void setTimestamp(qint64 ms) { timestamp = ms; }
+    static qint64 currentTimestamp();
 		
 public slots:
     void requestUpdate();
@@ -169,6 +180,18 @@ signals:
      */
     void objectUpdated(UAVObject* obj);
 
+    /**
+     * @brief Rate-limited form of objectUpdated for display gadgets
+     * @param obj
+     * @param dirtyFields Bit n is set if field n changed since the previous
+     * emission (fields past 63 share bit 63)
+     *
+     * Emitted at most once per coalescing interval (one UI frame by
+     * default), no matter how many updates arrive in between.  Nothing is
+     * tracked for objects without a connection to this signal.
+     */
+    void objectUpdatedCoalesced(UAVObject* obj, quint64 dirtyFields);
+
     /**
      * @brief objectUpdatedAuto: triggered on "setData" only (Object data updated by changing the data structure)
      *
@@ -235,6 +258,8 @@ private slots:
     void fieldUpdated(UAVObjectField* field);
 
 protected:
+    void queueCoalescedUpdate(quint64 dirty);
+
     quint32 objID;
     quint32 instID;
     bool isSingleInst;
@@ -248,6 +273,16 @@ protected:
     void setDescription(const QString& description);
     void setCategory(const QString& category);
 
+private:
+    bool hasCoalescedReceivers();
+    static void flushCoalescedUpdates();
+
+    bool hostLayout;        /** Data block matches the wire format */
+    qint64 timestamp;       /** Set by the link before unpacking, or on local updates */
+    quint64 coalescedDirty;
+    static QVector<QPointer<UAVObject> > coalescedPending;
+    static QTimer *coalescedTimer;
+    static int coalescedIntervalMs;
 };
 
 #endif // UAVOBJECT_H
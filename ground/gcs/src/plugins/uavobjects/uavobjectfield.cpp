@@ -59,6 +59,30 @@ UAVObjectField::UAVObjectField(const QString& name, const QString& units, FieldT
     constructorInitialize(name, units, type, elementNames, options, indices, limits, description, defaultValues);
 }
 
+/**
+ * @brief UAVObjectField::UAVObjectField Copy a field already built, sharing
+ * its names, options, parsed limits and defaults rather than building them
+ * again. The copy is not bound to any data until initialize().
+ * @param prototype The field to copy
+ */
+UAVObjectField::UAVObjectField(const UAVObjectField *prototype) :
+    name(prototype->name),
+    units(prototype->units),
+    type(prototype->type),
+    elementNames(prototype->elementNames),
+    indices(prototype->indices),
+    options(prototype->options),
+    numElements(prototype->numElements),
+    numBytesPerElement(prototype->numBytesPerElement),
+    offset(0),
+    data(NULL),
+    obj(NULL),
+    elementLimits(prototype->elementLimits),
+    description(prototype->description),
+    defaultValues(prototype->defaultValues)
+{
+}
+
 void UAVObjectField::constructorInitialize(const QString& name, const QString& units, FieldType type, const QStringList& elementNames,
                                            const QStringList& options, const QList<int>& indices, const QString &limits,
                                            const QString &description, const QList<QVariant> defaultValues)
@@ -1039,6 +1063,15 @@ bool UAVObjectField::checkValue(const QVariant& value, quint32 index)
     return true;
 }
 
+/**
+ * Returns true if the GCS access mode permits writing the field
+ */
+bool UAVObjectField::isWritable()
+{
+    UAVObject::Metadata mdata = obj->getMetadata();
+    return UAVObject::GetGcsAccess(mdata) == UAVObject::ACCESS_READWRITE;
+}
+
 void UAVObjectField::setValue(const QVariant& value, quint32 index)
 {
     // Check that index is not out of bounds
@@ -1046,10 +1079,8 @@ void UAVObjectField::setValue(const QVariant& value, quint32 index)
     {
         return;
     }
-    // Get metadata
-    UAVObject::Metadata mdata = obj->getMetadata();
     // Update value if the access mode permits
-    if ( UAVObject::GetGcsAccess(mdata) == UAVObject::ACCESS_READWRITE )
+    if ( isWritable() )
     {
         switch (type)
         {
@@ -1148,7 +1179,26 @@ void UAVObjectField::setValue(const QVariant& value, quint32 index)
 
 double UAVObjectField::getDouble(quint32 index)
 {
-    return getValue(index).toDouble();
+    // Numeric types are read directly, the rest need the QVariant conversion
+    switch (type)
+    {
+    case INT8:
+        return get<qint8>(index);
+    case INT16:
+        return get<qint16>(index);
+    case INT32:
+        return get<qint32>(index);
+    case UINT8:
+        return get<quint8>(index);
+    case UINT16:
+        return get<quint16>(index);
+    case UINT32:
+        return get<quint32>(index);
+    case FLOAT32:
+        return get<float>(index);
+    default:
+        return getValue(index).toDouble();
+    }
 }
 
 void UAVObjectField::setDouble(double value, quint32 index)
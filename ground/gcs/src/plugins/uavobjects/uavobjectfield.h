@@ -34,8 +34,10 @@
 #include <QVariant>
 #include <QList>
 #include <QMap>
+#include <string.h>
 
 class UAVObject;
+template <typename T> struct UAVObjectFieldStorage;
 
 class UAVOBJECTS_EXPORT UAVObjectField: public QObject
 {
@@ -58,6 +60,7 @@ public:
                    const QStringList& elementNames, const QStringList& options, const QList<int>& indices,
                    const QString& limits=QString(), const QString& description=QString(),
                    const QList<QVariant> defaultValues = QList<QVariant>());
+    explicit UAVObjectField(const UAVObjectField *prototype);
     void initialize(quint8* data, quint32 dataOffset, UAVObject* obj);
     UAVObject* getObject();
     FieldType getType();
@@ -81,6 +84,25 @@ public:
     void setValue(const QVariant& data, quint32 index = 0);
     double getDouble(quint32 index = 0);
     void setDouble(double value, quint32 index = 0);
+
+    /**
+     * @brief Typed element accessors that read and write the object data
+     * directly, without going through QVariant. T must be the storage type
+     * of the field (float for FLOAT32, quint8 for the raw value of an ENUM,
+     * ...); a mismatch asserts, reads as zero and is not written. Hold on to
+     * the field pointer rather than looking it up by name on every access.
+     * @param index The element to access
+     */
+    template <typename T> T get(quint32 index = 0);
+    template <typename T> void set(T value, quint32 index = 0);
+    /**
+     * @brief Copy a whole numeric array in or out with one memcpy. The data
+     * block is packed, so elements may be unaligned and are not exposed by
+     * pointer.
+     * @return The number of elements copied
+     */
+    template <typename T> quint32 getArray(T *values, quint32 count);
+    template <typename T> quint32 setArray(const T *values, quint32 count);
     quint32 getDataOffset();
     quint32 getNumBytes();
     bool isNumeric();
@@ -126,10 +148,64 @@ protected:
                                const QStringList& options, const QList<int> &indices, const QString &limits,
                                const QString &description, const QList<QVariant> defaultValues);
     void limitsInitialize(const QString &limits);
+    bool isWritable();
+    template <typename T> bool isStorageType();
 
 
 };
 
+/**
+ * Maps a C++ element type to the field type it is stored as, for the typed
+ * accessors of UAVObjectField. Types without a mapping do not compile.
+ */
+template <> struct UAVObjectFieldStorage<qint8>   { static const UAVObjectField::FieldType type = UAVObjectField::INT8; };
+template <> struct UAVObjectFieldStorage<qint16>  { static const UAVObjectField::FieldType type = UAVObjectField::INT16; };
+template <> struct UAVObjectFieldStorage<qint32>  { static const UAVObjectField::FieldType type = UAVObjectField::INT32; };
+template <> struct UAVObjectFieldStorage<quint8>  { static const UAVObjectField::FieldType type = UAVObjectField::UINT8; };
+template <> struct UAVObjectFieldStorage<quint16> { static const UAVObjectField::FieldType type = UAVObjectField::UINT16; };
+template <> struct UAVObjectFieldStorage<quint32> { static const UAVObjectField::FieldType type = UAVObjectField::UINT32; };
+template <> struct UAVObjectFieldStorage<float>   { static const UAVObjectField::FieldType type = UAVObjectField::FLOAT32; };
+
+template <typename T> bool UAVObjectField::isStorageType()
+{
+    FieldType storage = UAVObjectFieldStorage<T>::type;
+    bool match = (storage == type) || (storage == UINT8 && type == ENUM);
+    Q_ASSERT(match);
+    return match;
+}
+
+template <typename T> T UAVObjectField::get(quint32 index)
+{
+    T value = 0;
+    if (index < numElements && isStorageType<T>())
+        memcpy(&value, &data[offset + sizeof(T)*index], sizeof(T));
+    return value;
+}
+
+template <typename T> void UAVObjectField::set(T value, quint32 index)
+{
+    if (index < numElements && isStorageType<T>() && isWritable())
+        memcpy(&data[offset + sizeof(T)*index], &value, sizeof(T));
+}
+
+template <typename T> quint32 UAVObjectField::getArray(T *values, quint32 count)
+{
+    if (!isStorageType<T>())
+        return 0;
+    count = qMin(count, numElements);
+    memcpy(values, &data[offset], sizeof(T)*count);
+    return count;
+}
+
+template <typename T> quint32 UAVObjectField::setArray(const T *values, quint32 count)
+{
+    if (!isStorageType<T>() || !isWritable())
+        return 0;
+    count = qMin(count, numElements);
+    memcpy(&data[offset], values, sizeof(T)*count);
+    return count;
+}
+
 #endif // UAVOBJECTFIELD_H
 
 /**
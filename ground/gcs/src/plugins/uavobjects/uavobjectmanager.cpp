@@ -37,7 +37,9 @@
 /**
  * Constructor
  */
-UAVObjectManager::UAVObjectManager()
+UAVObjectManager::UAVObjectManager() :
+    numPending(0),
+    objectsVectorValid(false)
 {
 }
 
@@ -55,6 +57,9 @@ bool UAVObjectManager::registerObject(UAVDataObject* obj)
 {
     // Check if this object type is already in the list
     quint32 objID = obj->getObjID();
+    // A type not created yet is created first, so obj is a further instance
+    if (indexById.contains(objID))
+        createPendingObject(indexById.value(objID));
     if (objects.contains(objID))//Known object ID
     {
         if (objects.value(objID).contains(obj->getInstID()))//Instance already present
@@ -75,21 +80,19 @@ bool UAVObjectManager::registerObject(UAVDataObject* obj)
             {
                 UAVDataObject* cobj = obj->clone(instidx);
                 cobj->initialize(instidx,mobj);
-                QMap<quint32,UAVObject*> ppp;
-                ppp.insert(instidx,cobj);
-                objects[objID].insert(instidx,cobj);
+                addInstance(cobj);
                 getObject(cobj->getObjID())->emitNewInstance(cobj);//TODO??
                 emit newInstance(cobj);
             }
         }
         else if (obj->getInstID() == 0)
-            obj->initialize(objects.value(objID).last()->getObjID() + 1, mobj);
+            obj->initialize(objects.value(objID).last()->getInstID() + 1, mobj);
         else
         {
             return false;
         }
         // Add the actual object instance in the list
-        objects[objID].insert(obj->getInstID(),obj);
+        addInstance(obj);
         getObject(objID)->emitNewInstance(obj);
         emit newInstance(obj);
         return true;
@@ -111,6 +114,62 @@ bool UAVObjectManager::registerObject(UAVDataObject* obj)
     }
  }
 
+/**
+ * Register an object type to be created when it is first needed, so that
+ * the types a session never touches cost no more than an index entry.
+ * Lookups by name, ID or index create it, as does listing the objects.
+ */
+bool UAVObjectManager::registerObjectType(quint32 objId, const QString& name, ObjectFactory create)
+{
+    if (create == NULL || indexById.contains(objId) || indexById.contains(objId + 1))
+        return false;
+
+    // Reserve the indexes addObject() would give the object and its
+    // metaobject, so they come out the same as if created right away
+    int index = objectsByIndex.size();
+    for (int i = 0; i < 2; ++i)
+    {
+        objectsByIndex.append(QVector<UAVObject*>());
+        dataByIndex.append(-1);
+        settingsByIndex.append(-1);
+        pendingByIndex.append(create);
+    }
+    indexById.insert(objId, index);
+    indexById.insert(objId + 1, index + 1);
+    indexByName.insert(name, index);
+    indexByName.insert(name + "Meta", index + 1);
+    numPending += 2;
+    return true;
+}
+
+/**
+ * Create a type registered with registerObjectType(), given the index of
+ * either the object or its metaobject
+ */
+void UAVObjectManager::createPendingObject(int index)
+{
+    ObjectFactory create = pendingByIndex.at(index);
+    if (create == NULL)
+        return;
+
+    // Both indexes were reserved together, the object's first
+    UAVDataObject* obj = create();
+    int objIndex = indexById.value(obj->getObjID());
+    pendingByIndex[objIndex] = NULL;
+    pendingByIndex[objIndex + 1] = NULL;
+    numPending -= 2;
+    registerObject(obj);
+}
+
+/**
+ * Create all the types not created yet, for callers that list them
+ */
+void UAVObjectManager::createPendingObjects()
+{
+    for (int index = 0; numPending > 0 && index < pendingByIndex.size(); ++index)
+        createPendingObject(index);
+}
+
 /**
  * @brief unregisters an object instance and all instances bigger than the one passed as argument from the manager
  * @param obj pointer to the object to unregister
@@ -127,11 +186,15 @@ bool UAVObjectManager::unRegisterObject(UAVDataObject* obj)
     {
         getObject(objects.value(objID).value(x)->getObjID())->emitInstanceRemoved(objects.value(objID).value(x));
         emit instanceRemoved(objects.value(objID).value(x));
-        objects[objID].remove(x);
+        removeInstance(objects.value(objID).value(x));
     }
     return true;
 }
 
+/**
+ * Add the first instance of a new object type, giving the type the next
+ * index of the dense table unless it has one reserved already
+ */
 void UAVObjectManager::addObject(UAVObject* obj)
 {
     // Add to list
@@ -139,77 +202,168 @@ void UAVObjectManager::addObject(UAVObject* obj)
     list.insert(obj->getInstID(),obj);
     objects.insert(obj->getObjID(),list);
 
-    objectsByName.insert(obj->getName(), list);
+    int index = indexById.value(obj->getObjID(), -1);
+    if (index < 0)
+    {
+        index = objectsByIndex.size();
+        objectsByIndex.append(QVector<UAVObject*>());
+        dataByIndex.append(-1);
+        settingsByIndex.append(-1);
+        pendingByIndex.append(NULL);
+        indexById.insert(obj->getObjID(), index);
+        indexByName.insert(obj->getName(), index);
+    }
+    objectsByIndex[index] = QVector<UAVObject*>() << obj;
+    objectsVectorValid = false;
+
+    // Sort the type into its kind once, rather than on every query
+    UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(obj);
+    UAVMetaObject* mobj = dynamic_cast<UAVMetaObject*>(obj);
+    int dataPos = -1;
+    int settingsPos = -1;
+    if (dobj != NULL)
+    {
+        dataPos = dataObjects.size();
+        dataObjects.append(QVector<UAVDataObject*>() << dobj);
+        if (dobj->isSettings())
+        {
+            settingsPos = settingsObjects.size();
+            settingsObjects.append(QVector<UAVDataObject*>() << dobj);
+        }
+    }
+    else if (mobj != NULL)
+    {
+        metaObjects.append(QVector<UAVMetaObject*>() << mobj);
+    }
+    dataByIndex[index] = dataPos;
+    settingsByIndex[index] = settingsPos;
 
     emit newObject(obj);
 }
 
+/**
+ * Add an instance of an already known object type
+ */
+void UAVObjectManager::addInstance(UAVObject* obj)
+{
+    objects[obj->getObjID()].insert(obj->getInstID(), obj);
+
+    QVector<UAVObject*> &instances = objectsByIndex[indexById.value(obj->getObjID())];
+    if ((quint32)instances.size() <= obj->getInstID())
+        instances.resize(obj->getInstID() + 1);
+    instances[obj->getInstID()] = obj;
+    objectsVectorValid = false;
+    updateDataGroups(indexById.value(obj->getObjID()));
+}
+
+/**
+ * Remove an instance from the lists, the object itself is not deleted
+ */
+void UAVObjectManager::removeInstance(UAVObject* obj)
+{
+    objects[obj->getObjID()].remove(obj->getInstID());
+
+    QVector<UAVObject*> &instances = objectsByIndex[indexById.value(obj->getObjID())];
+    if (obj->getInstID() < (quint32)instances.size())
+        instances[obj->getInstID()] = NULL;
+    while (!instances.isEmpty() && instances.last() == NULL)
+        instances.removeLast();
+    objectsVectorValid = false;
+    updateDataGroups(indexById.value(obj->getObjID()));
+}
+
+/**
+ * Refresh the data and settings lists of a type after its instances changed.
+ * Only data objects have more than one instance.
+ */
+void UAVObjectManager::updateDataGroups(int index)
+{
+    int dataPos = dataByIndex.at(index);
+    if (dataPos < 0)
+        return;
+
+    QVector<UAVDataObject*> instances;
+    foreach (UAVObject* obj, objectsByIndex.at(index))
+    {
+        if (obj != NULL)
+            instances.append(static_cast<UAVDataObject*>(obj));
+    }
+    dataObjects[dataPos] = instances;
+    if (settingsByIndex.at(index) >= 0)
+        settingsObjects[settingsByIndex.at(index)] = instances;
+}
+
 /**
  * Get all objects. A two dimentional QVector is returned. Objects are grouped by
  * instances of the same object type.
+ * The dense index can have holes, types without instances and removed
+ * instances, which are left out.
+ */
+const QVector< QVector<UAVObject*> > &UAVObjectManager::getObjectsVector()
+{
+    createPendingObjects();
+    if (!objectsVectorValid)
+    {
+        objectsVector.clear();
+        foreach (const QVector<UAVObject*> &instances, objectsByIndex)
+        {
+            QVector<UAVObject*> present = presentInstances(instances);
+            if (!present.isEmpty())
+                objectsVector.append(present);
+        }
+        objectsVectorValid = true;
+    }
+    return objectsVector;
+}
+
+/**
+ * The instances of a type from the dense index, without the holes
  */
-QVector< QVector<UAVObject*> > UAVObjectManager::getObjectsVector()
+QVector<UAVObject*> UAVObjectManager::presentInstances(const QVector<UAVObject*> &instances)
 {
-    QVector< QVector<UAVObject*> > vector;
-    foreach (const ObjectMap &map,objects.values())
+    if (!instances.contains(NULL))
+        return instances;
+
+    QVector<UAVObject*> present;
+    foreach (UAVObject* obj, instances)
     {
-        QVector<UAVObject*> vec = map.values().toVector();
-        vector.append(vec);
+        if (obj != NULL)
+            present.append(obj);
     }
-    return vector;
+    return present;
 }
 
 QHash<quint32, QMap<quint32, UAVObject *> > UAVObjectManager::getObjects()
 {
+    createPendingObjects();
     return objects;
 }
 
 /**
  * Same as getObjects() but will only return DataObjects.
  */
-QVector< QVector<UAVDataObject*> > UAVObjectManager::getDataObjectsVector()
+const QVector< QVector<UAVDataObject*> > &UAVObjectManager::getDataObjectsVector()
 {
-    QVector< QVector<UAVDataObject*> > vector;
-    foreach (const ObjectMap &map,objects.values())
-    {
-        UAVDataObject* obj = dynamic_cast<UAVDataObject*>(map.first());
-        if(obj!=NULL)
-        {
-            QVector<UAVDataObject*> vec;
-            foreach(UAVObject* o,map)
-            {
-                UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(o);
-                if(dobj)
-                    vec.append(dobj);
-            }
-            vector.append(vec);
-        }
-     }
-    return vector;
+    createPendingObjects();
+    return dataObjects;
 }
 
 /**
  * Same as getObjects() but will only return MetaObjects.
  */
-QVector <QVector<UAVMetaObject*> > UAVObjectManager::getMetaObjectsVector()
+const QVector< QVector<UAVMetaObject*> > &UAVObjectManager::getMetaObjectsVector()
 {
-    QVector< QVector<UAVMetaObject*> > vector;
-    foreach(const ObjectMap &map,objects.values())
-    {
-        UAVMetaObject* obj = dynamic_cast<UAVMetaObject*>(map.first());
-        if(obj!=NULL)
-        {
-            QVector<UAVMetaObject*> vec;
-            foreach(UAVObject* o,map)
-            {
-                UAVMetaObject* mobj = dynamic_cast<UAVMetaObject*>(o);
-                if(mobj)
-                    vec.append(mobj);
-            }
-            vector.append(vec);
-        }
-     }
-    return vector;
+    createPendingObjects();
+    return metaObjects;
+}
+
+/**
+ * Same as getDataObjectsVector() but will only return settings objects.
+ */
+const QVector< QVector<UAVDataObject*> > &UAVObjectManager::getSettingsObjectsVector()
+{
+    createPendingObjects();
+    return settingsObjects;
 }
 
 /**
@@ -218,7 +372,7 @@ QVector <QVector<UAVMetaObject*> > UAVObjectManager::getMetaObjectsVector()
  */
 UAVObject* UAVObjectManager::getObject(const QString& name, quint32 instId)
 {
-    return getObject(name, 0, instId);
+    return getObjectByIndex(indexByName.value(name, -1), instId);
 }
 
 /**
@@ -227,25 +381,23 @@ UAVObject* UAVObjectManager::getObject(const QString& name, quint32 instId)
  */
 UAVObject* UAVObjectManager::getObject(quint32 objId, quint32 instId)
 {
-    return getObject(NULL, objId, instId);
+    return getObjectByIndex(indexById.value(objId, -1), instId);
 }
 
 /**
- * Helper function for the public getObject() functions.
+ * Get the dense index of an object type given its name
  */
-UAVObject* UAVObjectManager::getObject(const QString& name, quint32 objId, quint32 instId)
+int UAVObjectManager::getObjectIndex(const QString& name)
 {
-    if(name != NULL)
-    {
-        if (objectsByName.contains(name)) {
-            return objectsByName.value(name).value(instId);
-        }
+    return indexByName.value(name, -1);
+}
 
-        return NULL;
-    }
-    else if(objects.contains(objId))
-        return objects.value(objId).value(instId);
-    return NULL;
+/**
+ * Get the dense index of an object type given its ID
+ */
+int UAVObjectManager::getObjectIndex(quint32 objId)
+{
+    return indexById.value(objId, -1);
 }
 
 /**
@@ -269,16 +421,12 @@ QVector<UAVObject*> UAVObjectManager::getObjectInstancesVector(quint32 objId)
  */
 QVector<UAVObject*> UAVObjectManager::getObjectInstancesVector(const QString* name, quint32 objId)
 {
-    if(name != NULL)
+    int index = (name != NULL) ? indexByName.value(*name, -1) : indexById.value(objId, -1);
+    if (index >= 0)
     {
-        foreach(const ObjectMap &map,objects)
-        {
-            if(map.first()->getName().compare(name) == 0)
-                return map.values().toVector();
-        }
+        createPendingObject(index);
+        return presentInstances(objectsByIndex.at(index));
     }
-    else if(objects.contains(objId))
-        return objects.value(objId).values().toVector();
     return  QVector<UAVObject*>();
 }
 
@@ -303,16 +451,12 @@ qint32 UAVObjectManager::getNumInstances(quint32 objId)
  */
 qint32 UAVObjectManager::getNumInstances(const QString* name, quint32 objId)
 {
-    if(name != NULL)
+    int index = (name != NULL) ? indexByName.value(*name, -1) : indexById.value(objId, -1);
+    if (index >= 0)
     {
-        foreach(const ObjectMap &map,objects)
-        {
-            if(map.first()->getName().compare(name) == 0)
-                return map.count();
-        }
+        createPendingObject(index);
+        return objectsByIndex.at(index).size();
     }
-    else if(objects.contains(objId))
-        return objects.value(objId).count();
     return -1;
 }
 
@@ -51,13 +51,46 @@ public:
     UAVObjectManager();
     ~UAVObjectManager();
     typedef QMap<quint32,UAVObject*> ObjectMap;
+    typedef UAVDataObject* (*ObjectFactory)();
     bool registerObject(UAVDataObject* obj);
-    QVector< QVector<UAVObject*> > getObjectsVector();
+    /**
+     * @brief registerObjectType Make an object type known without creating
+     * it. The type gets its dense index straight away, and the object and
+     * its metaobject are created on first lookup. Enumerating the objects
+     * creates all the types still pending.
+     * @param create makes the first instance, to be passed to registerObject()
+     * @return false if the type is already known
+     */
+    bool registerObjectType(quint32 objId, const QString& name, ObjectFactory create);
+    const QVector< QVector<UAVObject*> > &getObjectsVector();
     QHash<quint32, QMap<quint32,UAVObject*> > getObjects();
-    QVector< QVector<UAVDataObject*> > getDataObjectsVector();
-    QVector< QVector<UAVMetaObject*> > getMetaObjectsVector();
+    const QVector< QVector<UAVDataObject*> > &getDataObjectsVector();
+    const QVector< QVector<UAVMetaObject*> > &getMetaObjectsVector();
+    const QVector< QVector<UAVDataObject*> > &getSettingsObjectsVector();
     UAVObject* getObject(const QString& name, quint32 instId = 0);
     UAVObject* getObject(quint32 objId, quint32 instId = 0);
+    /**
+     * @brief getObjectIndex Resolve an object type to its dense index. The
+     * index is stable for the lifetime of the manager, so resolve it once
+     * and use getObjectByIndex() on hot paths.
+     * @return The index, or -1 if the object is unknown
+     */
+    int getObjectIndex(const QString& name);
+    int getObjectIndex(quint32 objId);
+    /**
+     * @brief getObjectByIndex Get an instance from the dense index, without
+     * any hashing
+     * @return The object if found, null pointer otherwise
+     */
+    UAVObject* getObjectByIndex(int index, quint32 instId = 0)
+    {
+        if (index < 0 || index >= objectsByIndex.size())
+            return NULL;
+        if (pendingByIndex.at(index) != NULL)
+            createPendingObject(index);
+        const QVector<UAVObject*> &instances = objectsByIndex.at(index);
+        return instId < (quint32)instances.size() ? instances.at(instId) : NULL;
+    }
     /**
      * @brief getField Get a UAV Object field
      * Success is asserted so there is no need to do this again in the caller
@@ -79,13 +112,59 @@ signals:
 private:
     static const quint32 MAX_INSTANCES = 1000;
     QHash<quint32, QMap<quint32,UAVObject*> > objects;
-    QHash<QString, QMap<quint32,UAVObject*> > objectsByName;
+    QVector<QVector<UAVObject*> > objectsByIndex;
+    QHash<quint32, int> indexById;
+    QHash<QString, int> indexByName;
+
+    // Object types partitioned by kind, kept up to date on registration
+    QVector< QVector<UAVDataObject*> > dataObjects;
+    QVector< QVector<UAVMetaObject*> > metaObjects;
+    QVector< QVector<UAVDataObject*> > settingsObjects;
+    QVector<int> dataByIndex;       // Position in dataObjects, or -1
+    QVector<int> settingsByIndex;   // Position in settingsObjects, or -1
+
+    // Types registered but not created yet, by index of the object and of
+    // its metaobject
+    QVector<ObjectFactory> pendingByIndex;
+    int numPending;
+
+    // objectsByIndex without its holes, rebuilt when instances change
+    QVector< QVector<UAVObject*> > objectsVector;
+    bool objectsVectorValid;
 
+    void createPendingObject(int index);
+    void createPendingObjects();
+    static QVector<UAVObject*> presentInstances(const QVector<UAVObject*> &instances);
     void addObject(UAVObject* obj);
-    UAVObject* getObject(const QString& name, quint32 objId, quint32 instId);
+    void addInstance(UAVObject* obj);
+    void removeInstance(UAVObject* obj);
+    void updateDataGroups(int index);
     QVector<UAVObject*> getObjectInstancesVector(const QString* name, quint32 objId);
     qint32 getNumInstances(const QString* name, quint32 objId);
 };
 
 
+/**
+ * @brief Typed handle to a generated object type, resolved once to its
+ * dense index so that later instance lookups are a vector access
+ */
+template <class T> class UAVObjectHandle
+{
+public:
+    UAVObjectHandle(UAVObjectManager* objMngr) :
+        objMngr(objMngr), index(objMngr->getObjectIndex(T::OBJID)) { }
+
+    T* get(quint32 instId = 0)
+    {
+        // Handles made before the type was registered resolve on first use
+        if (index < 0)
+            index = objMngr->getObjectIndex(T::OBJID);
+        return static_cast<T*>(objMngr->getObjectByIndex(index, instId));
+    }
+
+private:
+    UAVObjectManager* objMngr;
+    int index;
+};
+
 #endif // UAVOBJECTMANAGER_H
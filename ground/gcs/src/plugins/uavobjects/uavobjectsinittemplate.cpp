@@ -32,8 +32,14 @@
 #include "uavobjectsinit.h"
 $(OBJINC)
 
+template <class T> static UAVDataObject* createObject()
+{
+    return new T();
+}
+
 /**
- * Function used to initialize the first instance of each object.
+ * Function used to register each object type. The first instance of each
+ * object is created when the object is first looked up.
  * This file is automatically updated by the UAVObjectGenerator.
  */
 void UAVObjectsInitialize(UAVObjectManager* objMngr)
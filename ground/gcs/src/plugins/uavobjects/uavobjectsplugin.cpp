@@ -27,6 +27,8 @@
 #include "uavobjectsplugin.h"
 #include "uavobjectsinit.h"
 
+#include <extensionsystem/tracelog.h>
+
 UAVObjectsPlugin::UAVObjectsPlugin()
 {
 
@@ -48,7 +50,10 @@ bool UAVObjectsPlugin::initialize(const QStringList & arguments, QString * error
     UAVObjectManager* objMngr = new UAVObjectManager();
     addAutoReleasedObject(objMngr);
     // Initialize UAVObjects
-    UAVObjectsInitialize(objMngr);
+    {
+        ExtensionSystem::TraceScope trace("Register UAVObjects", "plugins");
+        UAVObjectsInitialize(objMngr);
+    }
     // Done
     Q_UNUSED(arguments);
     Q_UNUSED(errorString);
@@ -49,9 +49,13 @@ $(FIELDDESCRIPTIONS_STRINGS)};
  */
 $(NAME)::$(NAME)(): UAVDataObject(OBJID, ISSINGLEINST, ISSETTINGS, NAME)
 {
-    // Create fields
+    // The fields are only built and parsed for the first instance, the
+    // others share the names, options, limits and defaults of those
+    static const QList<UAVObjectField*> prototypes = createFields();
     QList<UAVObjectField*> fields;
-$(FIELDSINIT)
+    foreach (const UAVObjectField *prototype, prototypes)
+        fields.append(new UAVObjectField(prototype));
+
     // Initialize object
     initializeFields(fields, (quint8*)&data, NUMBYTES);
     // Set the default field values
@@ -66,6 +70,16 @@ $(FIELDSINIT)
             SLOT(emitNotifications()));
 }
 
+/**
+ * Create the fields from the object definition
+ */
+QList<UAVObjectField*> $(NAME)::createFields()
+{
+    QList<UAVObjectField*> fields;
+$(FIELDSINIT)
+    return fields;
+}
+
 /**
  * Get the default metadata for this object
  */
@@ -114,8 +128,10 @@ void $(NAME)::setData(const DataFields& data)
     if ( UAVObject::GetGcsAccess(mdata) == ACCESS_READWRITE )
     {
         this->data = data;
+        setTimestamp(currentTimestamp());
         emit objectUpdatedAuto(this); // trigger object updated event
         emit objectUpdated(this);
+        queueCoalescedUpdate(ALL_FIELDS_DIRTY);
     }
 }
 
@@ -150,6 +166,10 @@ UAVDataObject* $(NAME)::dirtyClone()
  */
 $(NAME)* $(NAME)::GetInstance(UAVObjectManager* objMngr, quint32 instID)
 {
+    // The generated index holds unless objects were registered out of order
+    UAVObject* obj = objMngr->getObjectByIndex(OBJINDEX, instID);
+    if (obj != NULL && obj->getObjID() == OBJID)
+        return static_cast<$(NAME)*>(obj);
     return dynamic_cast<$(NAME)*>(objMngr->getObject($(NAME)::OBJID, instID));
 }
 
@@ -64,6 +64,7 @@ $(DATAFIELDINFO)
   
     // Constants
     static const quint32 OBJID = $(OBJIDHEX);
+    static const int OBJINDEX = $(OBJINDEX);
     static const QString NAME;
     static const QString DESCRIPTION;
     static const QString CATEGORY;
@@ -98,6 +99,7 @@ private slots:
 private:
     DataFields data;
 
+    static QList<UAVObjectField*> createFields();
     void setDefaultFieldValues();
 
 };
@@ -37,6 +37,7 @@
 #include "uavsettingsimportexport/uavsettingsimportexportmanager.h"
 #include <coreplugin/connectionmanager.h>
 #include <coreplugin/icore.h>
+#include <extensionsystem/tracelog.h>
 
 /**
  * Constructor
@@ -349,6 +350,8 @@ void ConfigTaskWidget::forceConnectedState()//dynamic widgets don't recieve the
 
 void ConfigTaskWidget::onAutopilotConnect()
 {
+    ExtensionSystem::TraceScope trace(QString("Refresh ") + metaObject()->className(), "connect");
+
     if (utilMngr)
         currentBoard = utilMngr->getBoardModel();
 
@@ -31,6 +31,8 @@
 #include <QDebug>
 #include <QCheckBox>
 #include "importsummary.h"
+#include "uavsettingsprovisioner.h"
+#include <QCoreApplication>
 // for menu item
 #include <coreplugin/coreconstants.h>
 #include <coreplugin/actionmanager/actionmanager.h>
@@ -49,7 +51,8 @@
 #include <QFileDialog>
 #include <QMessageBox>
 
-UAVSettingsImportExportPlugin::UAVSettingsImportExportPlugin()
+UAVSettingsImportExportPlugin::UAVSettingsImportExportPlugin() :
+    provisioner(0)
 {
    // Do nothing
 }
@@ -61,10 +64,14 @@ UAVSettingsImportExportPlugin::~UAVSettingsImportExportPlugin()
 
 bool UAVSettingsImportExportPlugin::initialize(const QStringList& args, QString *errMsg)
 {
-    Q_UNUSED(args);
     Q_UNUSED(errMsg);
     mf = new UAVSettingsImportExportManager(this);
     addAutoReleasedObject(mf);
+
+    // -p provision=<file> pushes the file to the next board and quits
+    int index = args.indexOf("provision");
+    if (index >= 0 && index + 1 < args.length())
+        provisioner = new UAVSettingsProvisioner(args.at(index + 1), this);
     return true;
 }
 
@@ -74,4 +81,17 @@ void UAVSettingsImportExportPlugin::shutdown()
 }
 void UAVSettingsImportExportPlugin::extensionsInitialized()
 {
+    if (provisioner) {
+        connect(provisioner, SIGNAL(finished(bool)), this, SLOT(provisioningFinished(bool)));
+        provisioner->start();
+    }
+}
+
+/**
+ * @brief UAVSettingsImportExportPlugin::provisioningFinished Quit once the
+ * settings are pushed, with an exit code scripts can check
+ */
+void UAVSettingsImportExportPlugin::provisioningFinished(bool success)
+{
+    QCoreApplication::exit(success ? 0 : 1);
 }
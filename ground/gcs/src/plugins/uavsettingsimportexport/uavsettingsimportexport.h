@@ -35,6 +35,9 @@
 #include "uavobjectutil/uavobjectutilmanager.h"
 #include "uavsettingsimportexport_global.h"
 #include "uavsettingsimportexportmanager.h"
+
+class UAVSettingsProvisioner;
+
 class UAVSETTINGSIMPORTEXPORT_EXPORT UAVSettingsImportExportPlugin : public ExtensionSystem::IPlugin
 {
     Q_OBJECT
@@ -47,8 +50,11 @@ public:
    void extensionsInitialized();
    bool initialize(const QStringList & arguments, QString * errorString);
    void shutdown();
+private slots:
+   void provisioningFinished(bool success);
 private:
    UAVSettingsImportExportManager *mf;
+   UAVSettingsProvisioner *provisioner;
 
 
 
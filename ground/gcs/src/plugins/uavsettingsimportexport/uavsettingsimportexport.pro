@@ -10,10 +10,12 @@ include(uavsettingsimportexport_dependencies.pri)
 
 HEADERS += uavsettingsimportexport.h \
     importsummary.h \
-    uavsettingsimportexportmanager.h
+    uavsettingsimportexportmanager.h \
+    uavsettingsprovisioner.h
 SOURCES += uavsettingsimportexport.cpp \
     importsummary.cpp \
-    uavsettingsimportexportmanager.cpp
+    uavsettingsimportexportmanager.cpp \
+    uavsettingsprovisioner.cpp
 
 OTHER_FILES += uavsettingsimportexport.pluginspec \
     uavsettingsimportexport.json
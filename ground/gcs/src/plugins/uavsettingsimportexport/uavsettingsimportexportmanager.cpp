@@ -56,6 +56,16 @@
 #include <QFileDialog>
 #include <QMessageBox>
 
+// for binary snapshots
+#include <QDataStream>
+
+// Binary snapshots start with the magic, then the format version
+#define SNAPSHOT_MAGIC 0x55415642 // "UAVB"
+#define SNAPSHOT_VERSION 1
+// Entry flag: the object is at its default values and its data is left out
+#define SNAPSHOT_DEFAULTS 0x01
+#define SNAPSHOT_SUFFIX ".uavb"
+
 UAVSettingsImportExportManager::~UAVSettingsImportExportManager()
 {
     // Do nothing
@@ -96,12 +106,102 @@ UAVSettingsImportExportManager::UAVSettingsImportExportManager(QObject *parent):
 
 }
 
+/**
+ * @brief The object data as sent on the link, used to compare objects
+ */
+static QByteArray packedData(UAVObject *obj)
+{
+    QByteArray data(obj->getNumBytes(), 0);
+    obj->pack((quint8 *) data.data());
+    return data;
+}
+
+/**
+ * @brief FNV-1a hash of the object data stored in snapshots. Unlike qHash it
+ * is the same on every platform and Qt version.
+ */
+static quint32 contentHash(const QByteArray &data)
+{
+    quint32 hash = 2166136261u;
+    for (int i = 0; i < data.size(); i++) {
+        hash ^= (quint8) data.at(i);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool isSnapshot(const QByteArray &settings)
+{
+    QDataStream in(settings);
+    quint32 magic = 0;
+    in >> magic;
+    return in.status() == QDataStream::Ok && magic == SNAPSHOT_MAGIC;
+}
+
+/**
+ * @brief Set the fields of an object from an object element of a settings file
+ * @param[in] obj the object to update
+ * @param[in] node the object element
+ * @param[out] unknownField set when the element has a field the object lacks
+ * @param[out] invalidValue set when a value does not fit its field
+ */
+static void applyFields(UAVObject *obj, const QDomNode &node, bool *unknownField, bool *invalidValue)
+{
+    QString uavObjectName = obj->getName();
+    QDomNode field = node.firstChild();
+    while(!field.isNull()) {
+        QDomElement f = field.toElement();
+        if (f.tagName() == "field") {
+            UAVObjectField *uavfield = obj->getField(f.attribute("name"));
+            if (uavfield) {
+                QStringList list = f.attribute("values").split(",");
+                if (list.length() == 1) {
+                    if (false == uavfield->checkValue(f.attribute("values"))) {
+                        qDebug() << "checkValue returned false on: " << uavObjectName << f.attribute("values");
+                        *invalidValue = true;
+                    } else {
+                        uavfield->setValue(f.attribute("values"));
+                    }
+                } else {
+                    // This is an enum:
+                    int i = 0;
+                    foreach (QString element, list) {
+                        if (false == uavfield->checkValue(element, i)) {
+                            qDebug() << "checkValue(list) returned false on: " << uavObjectName << list;
+                            *invalidValue = true;
+                        } else {
+                            uavfield->setValue(element,i);
+                        }
+                        i++;
+                    }
+                }
+            } else {
+                *unknownField = true;
+            }
+        }
+        field = field.nextSibling();
+    }
+}
+
+/**
+ * @brief Set the fields of an object from an object element of a settings file
+ * @return true if every field of the element was known and its values valid
+ */
+bool UAVSettingsImportExportManager::updateObject(UAVObject *obj, QDomNode *node)
+{
+    bool unknownField = false;
+    bool invalidValue = false;
+    applyFields(obj, *node, &unknownField, &invalidValue);
+    return !unknownField && !invalidValue;
+}
+
 bool UAVSettingsImportExportManager::importUAVSettings(const QByteArray &settings,
         bool quiet)
 {
     QDomDocument doc("UAVObjects");
+    const bool snapshot = isSnapshot(settings);
 
-    if (!doc.setContent(settings)) {
+    if (!snapshot && !doc.setContent(settings)) {
         QMessageBox msgBox;
         msgBox.setText(tr("File Parsing Failed."));
         msgBox.setInformativeText(tr("This file is not a correct XML file"));
@@ -117,7 +217,7 @@ bool UAVSettingsImportExportManager::importUAVSettings(const QByteArray &setting
     if (root.tagName() == "uavobjects") {
         root = root.firstChildElement("settings");
     }
-    if (root.isNull() || (root.tagName() != "settings")) {
+    if (!snapshot && (root.isNull() || (root.tagName() != "settings"))) {
         QMessageBox msgBox;
         msgBox.setText(tr("Wrong file contents"));
         msgBox.setInformativeText(tr("This file does not contain correct UAVSettings"));
@@ -136,6 +236,16 @@ bool UAVSettingsImportExportManager::importUAVSettings(const QByteArray &setting
 
     swui.show();
 
+    if (snapshot && !readSnapshot(settings, swui, importedObjectManager)) {
+        QMessageBox msgBox;
+        msgBox.setText(tr("Wrong file contents"));
+        msgBox.setInformativeText(tr("This settings snapshot is from an unknown format version"));
+        msgBox.setStandardButtons(QMessageBox::Ok);
+        msgBox.exec();
+        return false;
+    }
+
+    // Without an XML document root is null and there is nothing to walk
     QDomNode node = root.firstChild();
     while (!node.isNull()) {
         QDomElement e = node.toElement();
@@ -161,43 +271,15 @@ bool UAVSettingsImportExportManager::importUAVSettings(const QByteArray &setting
 
                 bool error = false;
                 bool setError = false;
-                QDomNode field = node.firstChild();
-                while(!field.isNull()) {
-                    QDomElement f = field.toElement();
-                    if (f.tagName() == "field") {
-                        UAVObjectField *uavfield = newObj->getField(f.attribute("name"));
-                        if (uavfield) {
-                            QStringList list = f.attribute("values").split(",");
-                            if (list.length() == 1) {
-                                if (false == uavfield->checkValue(f.attribute("values"))) {
-                                    qDebug() << "checkValue returned false on: " << uavObjectName << f.attribute("values");
-                                    setError = true;
-                                } else {
-                                    uavfield->setValue(f.attribute("values"));
-                                }
-                            } else {
-                                // This is an enum:
-                                int i = 0;
-                                QStringList list = f.attribute("values").split(",");
-                                foreach (QString element, list) {
-                                    if (false == uavfield->checkValue(element, i)) {
-                                        qDebug() << "checkValue(list) returned false on: " << uavObjectName << list;
-                                        setError = true;
-                                    } else {
-                                        uavfield->setValue(element,i);
-                                    }
-                                    i++;
-                                }
-                            }
-                        } else {
-                            error = true;
-                        }
-                    }
-                    field = field.nextSibling();
-                }
+                applyFields(newObj, node, &error, &setError);
                 newObj->updated();
 
-                if (error) {
+                if (!setError && packedData(newObj) == packedData(dobj)) {
+                    // Nothing to send or save for it
+                    swui.addLine(uavObjectName, "Unchanged, skipped", false);
+                    delete newObj;
+                    newObj = NULL;
+                } else if (error) {
                     swui.addLine(uavObjectName, "Warning (Object field unknown)", true);
                 } else if (uavObjectID != newObj->getObjID()) {
                     qDebug() << "Mismatch for Object " << uavObjectName << uavObjectID << " - " << newObj->getObjID();
@@ -207,7 +289,8 @@ bool UAVSettingsImportExportManager::importUAVSettings(const QByteArray &setting
                 } else {
                     swui.addLine(uavObjectName, "OK", true);
                 }
-                importedObjectManager->registerObject(newObj);
+                if (newObj)
+                    importedObjectManager->registerObject(newObj);
             }
         }
         node = node.nextSibling();
@@ -228,12 +311,84 @@ bool UAVSettingsImportExportManager::importUAVSettings(const QByteArray &setting
     return swui.result() == QDialog::Accepted;
 }
 
+/**
+ * @brief Fill the import summary from a binary snapshot. Entries whose object
+ * already holds the same data on the board are listed but not imported.
+ * @return false if the snapshot format is not known
+ */
+bool UAVSettingsImportExportManager::readSnapshot(const QByteArray &snapshot, ImportSummaryDialog &swui,
+        UAVObjectManager *importedObjectManager)
+{
+    QDataStream in(snapshot);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic;
+    quint16 version;
+    in >> magic >> version;
+    if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION)
+        return false;
+
+    // Where the snapshot was taken, for reference only: the object IDs
+    // already change with the object definitions
+    quint8 boardType, boardRevision;
+    QByteArray fwHash, uavoHash;
+    quint32 count;
+    in >> boardType >> boardRevision >> fwHash >> uavoHash >> count;
+
+    UAVObjectManager *boardObjManager = ExtensionSystem::PluginManager::instance()->getObject<UAVObjectManager>();
+    for (quint32 i = 0; i < count; i++) {
+        quint32 objId, instId, hash;
+        quint8 flags;
+        QByteArray data;
+        in >> objId >> instId >> hash >> flags >> data;
+        if (in.status() != QDataStream::Ok) {
+            qDebug() << "Snapshot truncated after" << i << "objects";
+            break;
+        }
+
+        UAVDataObject *dobj = dynamic_cast<UAVDataObject*>(boardObjManager->getObject(objId, instId));
+        if (dobj == NULL) {
+            qDebug() << "Object unknown:" << objId;
+            swui.addLine("0x" + QString("%1").arg(objId, 8, 16, QChar('0')).toUpper(), "Error (Object unknown)", false);
+            continue;
+        }
+
+        QString uavObjectName = dobj->getName();
+        if (!dobj->getIsPresentOnHardware()) {
+            swui.addLine(uavObjectName, "Error (Object not present on hw)", false);
+            continue;
+        }
+
+        // A clone holds the default values, which is all defaults entries need
+        UAVDataObject *newObj = dobj->clone(instId);
+        if (!(flags & SNAPSHOT_DEFAULTS)) {
+            if (data.size() != (int) newObj->getNumBytes() || contentHash(data) != hash) {
+                swui.addLine(uavObjectName, "Error (Object data corrupted)", false);
+                delete newObj;
+                continue;
+            }
+            newObj->unpack((const quint8 *) data.constData());
+        }
+
+        if (packedData(newObj) == packedData(dobj)) {
+            swui.addLine(uavObjectName, "Unchanged, skipped", false);
+            delete newObj;
+            continue;
+        }
+
+        swui.addLine(uavObjectName, "OK", true);
+        importedObjectManager->registerObject(newObj);
+    }
+
+    return true;
+}
+
 // Slot called by the menu manager on user action
 void UAVSettingsImportExportManager::importUAVSettings()
 {
     // ask for file name
     QString fileName;
-    QString filters = tr("UAVObjects XML files (*.uav);; XML files (*.xml)");
+    QString filters = tr("UAVObjects XML files (*.uav);; UAVObjects binary snapshots (*" SNAPSHOT_SUFFIX ");; XML files (*.xml)");
     fileName = QFileDialog::getOpenFileName(0, tr("Import UAV Settings"), "", filters);
     if (fileName.isEmpty()) {
         return;
@@ -241,8 +396,10 @@ void UAVSettingsImportExportManager::importUAVSettings()
 
     // Now open the file
     QFile file(fileName);
-    QDomDocument doc("UAVObjects");
-    file.open(QFile::ReadOnly|QFile::Text);
+    if (fileName.endsWith(SNAPSHOT_SUFFIX))
+        file.open(QFile::ReadOnly);
+    else
+        file.open(QFile::ReadOnly|QFile::Text);
 
     importUAVSettings(file.readAll());
 
@@ -442,14 +599,58 @@ QString UAVSettingsImportExportManager::createXMLDocument(const enum storedData
     return alphabetizedXMLDoc;
 }
 
+/**
+ * @brief Binary snapshot of the settings on the board, keyed by object ID.
+ * Each object carries a hash of its data, and objects at their default
+ * values are stored without data.
+ */
+QByteArray UAVSettingsImportExportManager::createSnapshot()
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    UAVObjectUtilManager *utilMngr = pm->getObject<UAVObjectUtilManager>();
+    deviceDescriptorStruct board;
+    utilMngr->getBoardDescriptionStruct(board);
+
+    QList<UAVDataObject*> objects;
+    foreach (QVector<UAVDataObject*> list, objManager->getDataObjectsVector()) {
+        foreach (UAVDataObject *obj, list) {
+            if (obj->getIsPresentOnHardware() && obj->isSettings())
+                objects.append(obj);
+        }
+    }
+
+    QByteArray snapshot;
+    QDataStream out(&snapshot, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << (quint32) SNAPSHOT_MAGIC << (quint16) SNAPSHOT_VERSION;
+    out << board.boardType << board.boardRevision << board.fwHash << board.uavoHash;
+    out << (quint32) objects.count();
+
+    foreach (UAVDataObject *obj, objects) {
+        QByteArray data = packedData(obj);
+        UAVDataObject *defaults = obj->dirtyClone();
+        bool isDefault = (data == packedData(defaults));
+        delete defaults;
+
+        out << obj->getObjID() << obj->getInstID() << contentHash(data);
+        out << (quint8) (isDefault ? SNAPSHOT_DEFAULTS : 0);
+        out << (isDefault ? QByteArray() : data);
+    }
+
+    return snapshot;
+}
+
 // Slot called by the menu manager on user action
 void UAVSettingsImportExportManager::exportUAVSettings()
 {
     // ask for file name
     QString fileName;
-    QString filters = tr("UAVObjects XML files (*.uav)");
+    QString binaryFilter = tr("UAVObjects binary snapshots (*" SNAPSHOT_SUFFIX ")");
+    QString filters = binaryFilter + ";; " + tr("UAVObjects XML files (*.uav)");
+    QString selectedFilter;
 
-    fileName = QFileDialog::getSaveFileName(0, tr("Save UAVSettings File As"), "", filters);
+    fileName = QFileDialog::getSaveFileName(0, tr("Save UAVSettings File As"), "", filters, &selectedFilter);
     if (fileName.isEmpty()) {
         return;
     }
@@ -458,17 +659,18 @@ void UAVSettingsImportExportManager::exportUAVSettings()
     bool fullExport = false;
     if (fileName.endsWith(".xml")) {
         fullExport = true;
-    } else if (!fileName.endsWith(".uav")) {
-        fileName.append(".uav");
+    } else if (!fileName.endsWith(".uav") && !fileName.endsWith(SNAPSHOT_SUFFIX)) {
+        fileName.append(selectedFilter == binaryFilter ? SNAPSHOT_SUFFIX : ".uav");
     }
+    const bool binary = fileName.endsWith(SNAPSHOT_SUFFIX);
 
-    // generate an XML first (used for all export formats as a formatted data source)
-    QString xml = createXMLDocument(Settings, fullExport);
+    // the XML stays available as the readable format
+    QByteArray contents = binary ? createSnapshot() : createXMLDocument(Settings, fullExport).toLatin1();
 
     // save file
     QFile file(fileName);
     if (file.open(QIODevice::WriteOnly) &&
-            (file.write(xml.toLatin1()) != -1)) {
+            (file.write(contents) != -1)) {
         file.close();
     } else {
         QMessageBox::critical(0,
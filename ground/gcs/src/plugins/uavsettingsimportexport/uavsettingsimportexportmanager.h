@@ -35,6 +35,7 @@
 #include "../../../../../build/ground/gcs/gcsversioninfo.h"
 
 class QDomNode;
+class ImportSummaryDialog;
 
 class UAVSETTINGSIMPORTEXPORT_EXPORT UAVSettingsImportExportManager : public QObject
 {
@@ -55,6 +56,8 @@ public slots:
 private:
     enum storedData { Settings, Data, Both };
     QString createXMLDocument(const enum storedData, const bool fullExport);
+    QByteArray createSnapshot();
+    bool readSnapshot(const QByteArray &snapshot, ImportSummaryDialog &swui, UAVObjectManager *importedObjectManager);
 
 signals:
     void importAboutToBegin();
@@ -0,0 +1,227 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavsettingsprovisioner.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVSettingsImportExport UAVSettings Import/Export Plugin
+ * @{
+ * @brief Pushes a settings file to the board without user interaction
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+#include "uavsettingsprovisioner.h"
+#include "uavsettingsimportexportmanager.h"
+#include <QDebug>
+#include <QFile>
+#include <QDomDocument>
+
+#include "uavdataobject.h"
+#include "uavobjectmanager.h"
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjectutil/uavobjectutilmanager.h"
+#include "uavtalk/telemetrymanager.h"
+
+UAVSettingsProvisioner::UAVSettingsProvisioner(const QString &fileName, QObject *parent) :
+    QObject(parent),
+    fileName(fileName),
+    telMngr(0),
+    utilMngr(0),
+    failed(false)
+{
+}
+
+/**
+ * @brief UAVSettingsProvisioner::start Wait for the board, or push right
+ * away if it is already connected
+ */
+void UAVSettingsProvisioner::start()
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    telMngr = pm->getObject<TelemetryManager>();
+    utilMngr = pm->getObject<UAVObjectUtilManager>();
+    Q_ASSERT(telMngr && utilMngr);
+
+    qDebug() << "[provision] Waiting for a board to push" << fileName;
+    connect(telMngr, SIGNAL(connected()), this, SLOT(onAutopilotConnect()), Qt::UniqueConnection);
+    if (telMngr->isConnected())
+        onAutopilotConnect();
+}
+
+void UAVSettingsProvisioner::onAutopilotConnect()
+{
+    disconnect(telMngr, SIGNAL(connected()), this, SLOT(onAutopilotConnect()));
+
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        qDebug() << "[provision] Can't open" << fileName;
+        finish(false);
+        return;
+    }
+
+    if (!collectChanges(file.readAll())) {
+        finish(false);
+        return;
+    }
+
+    if (changed.isEmpty()) {
+        qDebug() << "[provision] The board already matches the file";
+        finish(true);
+        return;
+    }
+
+    // Send everything at once, the telemetry window keeps the link full
+    qDebug() << "[provision] Sending" << changed.count() << "changed objects";
+    foreach (UAVObject *obj, changed) {
+        unsent.insert(obj);
+        connect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(objectSent(UAVObject*,bool)), Qt::UniqueConnection);
+    }
+    foreach (UAVObject *obj, changed)
+        obj->updated();
+}
+
+/**
+ * @brief UAVSettingsProvisioner::collectChanges Read the file against the
+ * board and put the new values in the board objects that differ. Nothing
+ * is touched unless the whole file is valid.
+ * @return false if the file can't be applied as it is
+ */
+bool UAVSettingsProvisioner::collectChanges(const QByteArray &settings)
+{
+    QDomDocument doc("UAVObjects");
+    if (!doc.setContent(settings)) {
+        qDebug() << "[provision] Not an XML file:" << fileName;
+        return false;
+    }
+
+    QDomElement root = doc.documentElement();
+    if (root.tagName() == "uavobjects")
+        root = root.firstChildElement("settings");
+    if (root.isNull() || (root.tagName() != "settings")) {
+        qDebug() << "[provision] No settings in" << fileName;
+        return false;
+    }
+
+    UAVObjectManager *objMngr = ExtensionSystem::PluginManager::instance()->getObject<UAVObjectManager>();
+    QList<UAVObject *> objects;
+    QList<QByteArray> values;
+    bool valid = true;
+
+    for (QDomNode node = root.firstChild(); !node.isNull(); node = node.nextSibling()) {
+        QDomElement e = node.toElement();
+        if (e.tagName() != "object")
+            continue;
+
+        QString uavObjectName = e.attribute("name");
+        UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(objMngr->getObject(uavObjectName));
+        if (dobj == NULL) {
+            qDebug() << "[provision] Object unknown:" << uavObjectName;
+            valid = false;
+            continue;
+        }
+        if (!dobj->getIsPresentOnHardware()) {
+            qDebug() << "[provision] Object not present on hw, skipped:" << uavObjectName;
+            continue;
+        }
+
+        UAVDataObject *newObj = dobj->clone();
+        if (!UAVSettingsImportExportManager::updateObject(newObj, &node)) {
+            qDebug() << "[provision] Unknown field or invalid value in" << uavObjectName;
+            valid = false;
+        }
+
+        QByteArray current(dobj->getNumBytes(), 0);
+        QByteArray wanted(newObj->getNumBytes(), 0);
+        dobj->pack((quint8 *) current.data());
+        newObj->pack((quint8 *) wanted.data());
+        delete newObj;
+
+        if (wanted != current) {
+            objects.append(dobj);
+            values.append(wanted);
+        }
+    }
+
+    if (!valid)
+        return false;
+
+    for (int i = 0; i < objects.count(); i++) {
+        objects[i]->unpack((const quint8 *) values[i].constData());
+        changed.append(objects[i]);
+    }
+    return true;
+}
+
+void UAVSettingsProvisioner::objectSent(UAVObject *obj, bool success)
+{
+    if (!unsent.remove(obj))
+        return;
+    disconnect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(objectSent(UAVObject*,bool)));
+
+    if (!success) {
+        qDebug() << "[provision] The board did not acknowledge" << obj->getName();
+        failed = true;
+    }
+
+    if (unsent.isEmpty())
+        saveChanges();
+}
+
+/**
+ * @brief UAVSettingsProvisioner::saveChanges Persist the objects sent. Each
+ * save is its own ObjectPersistence round trip, so only the changed ones go.
+ */
+void UAVSettingsProvisioner::saveChanges()
+{
+    if (failed) {
+        finish(false);
+        return;
+    }
+
+    connect(utilMngr, SIGNAL(saveCompleted(int,bool)), this, SLOT(objectSaved(int,bool)), Qt::UniqueConnection);
+    foreach (UAVObject *obj, changed)
+        unsaved.insert(obj->getObjID());
+    foreach (UAVObject *obj, changed)
+        utilMngr->saveObjectToFlash(obj);
+}
+
+void UAVSettingsProvisioner::objectSaved(int objectID, bool success)
+{
+    if (!unsaved.remove(objectID))
+        return;
+
+    if (!success) {
+        qDebug() << "[provision] Saving failed for object" << QString::number(objectID, 16);
+        failed = true;
+    }
+
+    if (unsaved.isEmpty())
+        finish(!failed);
+}
+
+void UAVSettingsProvisioner::finish(bool success)
+{
+    if (utilMngr)
+        disconnect(utilMngr, SIGNAL(saveCompleted(int,bool)), this, SLOT(objectSaved(int,bool)));
+
+    qDebug() << "[provision]" << (success ? "Settings pushed" : "Settings push FAILED");
+    emit finished(success);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,80 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavsettingsprovisioner.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVSettingsImportExport UAVSettings Import/Export Plugin
+ * @{
+ * @brief Pushes a settings file to the board without user interaction
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef UAVSETTINGSPROVISIONER_H
+#define UAVSETTINGSPROVISIONER_H
+
+#include "uavsettingsimportexport_global.h"
+#include "uavobject.h"
+#include <QList>
+#include <QObject>
+#include <QSet>
+
+class TelemetryManager;
+class UAVObjectUtilManager;
+
+/**
+ * @brief The UAVSettingsProvisioner class Brings the board in line with a
+ * settings file once it connects. Only the objects whose packed data differ
+ * from the board are sent, all at once so the telemetry window pipelines
+ * them, and only those are then saved to flash.
+ */
+class UAVSETTINGSIMPORTEXPORT_EXPORT UAVSettingsProvisioner : public QObject
+{
+    Q_OBJECT
+
+public:
+    UAVSettingsProvisioner(const QString &fileName, QObject *parent = 0);
+
+    void start();
+
+signals:
+    void finished(bool success);
+
+private slots:
+    void onAutopilotConnect();
+    void objectSent(UAVObject *obj, bool success);
+    void objectSaved(int objectID, bool success);
+
+private:
+    bool collectChanges(const QByteArray &settings);
+    void saveChanges();
+    void finish(bool success);
+
+    QString fileName;
+    TelemetryManager *telMngr;
+    UAVObjectUtilManager *utilMngr;
+    QList<UAVObject *> changed;     // Board objects already holding the new values
+    QSet<UAVObject *> unsent;
+    QSet<quint32> unsaved;
+    bool failed;
+};
+
+#endif // UAVSETTINGSPROVISIONER_H
+
+/**
+ * @}
+ * @}
+ */
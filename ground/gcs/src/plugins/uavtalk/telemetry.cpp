@@ -26,7 +26,7 @@
  * for more details.
  * 
  * You should have received a copy of the GNU General Public License along 
- * with this program; if not, see <http://www.gnu.org/licenses/>
+ * with this program; if not, see <http://www.gnu.org/licenses/>
  *
  * Additional note on redistribution: The copyright and license notices above
  * must be maintained in each individual source file that is a derivative work
@@ -39,6 +39,7 @@
 #include <QTime>
 #include <QtGlobal>
 #include <stdlib.h>
+#include <algorithm>
 #include <QDebug>
 
 #ifdef TELEMETRY_DEBUG
@@ -71,7 +72,7 @@ public:
 
     bool operator<(const TransactionKey & rhs) const {
         return objId < rhs.objId || (objId == rhs.objId && instId < rhs.instId) ||
-                (objId == rhs.objId && instId == rhs.instId && req != rhs.req);
+                (objId == rhs.objId && instId == rhs.instId && req < rhs.req);
     }
 
     quint32 objId;
@@ -79,13 +80,31 @@ public:
     bool req;
 };
 
+/**
+ * Heap ordering for periodic updates, earliest deadline on top
+ */
+template <typename T>
+static bool dueLater(const T &a, const T &b)
+{
+    return a.dueNs > b.dueNs;
+}
+
 /**
  * Constructor
  */
-Telemetry::Telemetry(UAVTalk* utalk, UAVObjectManager* objMngr)
+Telemetry::Telemetry(UAVTalk* utalk, UAVObjectManager* objMngr) :
+    transactionWindow(0), transactionsInFlight(0), retransmitOnNack(false),
+    timeoutWheel(TIMEOUT_WHEEL_SLOTS), timeoutWheelTick(0)
 {
     this->utalk = utalk;
     this->objMngr = objMngr;
+    periodicClock.start();
+    // Setup the periodic timer, armed for the earliest queued update. It
+    // has to exist before the objects are registered, which schedules it.
+    updateTimer = new QTimer(this);
+    updateTimer->setSingleShot(true);
+    updateTimer->setTimerType(Qt::PreciseTimer);
+    connect(updateTimer, SIGNAL(timeout()), this, SLOT(processPeriodicUpdates()));
     // Process all objects in the list
     QVector< QVector<UAVObject*> > objs = objMngr->getObjectsVector();
     const int objSize = objs.size();
@@ -99,13 +118,15 @@ Telemetry::Telemetry(UAVTalk* utalk, UAVObjectManager* objMngr)
     // Listen to transaction completions
     connect(utalk, SIGNAL(ackReceived(UAVObject*)), this, SLOT(transactionSuccess(UAVObject*)));
     connect(utalk, SIGNAL(nackReceived(UAVObject*)), this, SLOT(transactionFailure(UAVObject*)));
+    connect(utalk, SIGNAL(dumpCompleted(bool)), this, SIGNAL(dumpCompleted(bool)));
     // Get GCS stats object
     gcsStatsObj = GCSTelemetryStats::GetInstance(objMngr);
-    // Setup and start the periodic timer
-    timeToNextUpdateMs = 0;
-    updateTimer = new QTimer(this);
-    connect(updateTimer, SIGNAL(timeout()), this, SLOT(processPeriodicUpdates()));
-    updateTimer->start(1000);
+    schedulePeriodicTimer();
+    // One timer serves the response timeouts of every transaction
+    timeoutClock.start();
+    timeoutWheelTimer = new QTimer(this);
+    timeoutWheelTimer->setInterval(TIMEOUT_WHEEL_TICK_MS);
+    connect(timeoutWheelTimer, SIGNAL(timeout()), this, SLOT(processTransactionTimeouts()));
     // Setup and start the stats timer
     txErrors = 0;
     txRetries = 0;
@@ -118,6 +139,48 @@ Telemetry::~Telemetry()
     }
 }
 
+/**
+ * @brief Limit the number of transactions awaiting a response
+ *
+ * With a window, acked sends and requests beyond the limit are held back
+ * and started as earlier ones complete, and the event queues may grow to
+ * hold a full settings upload instead of failing after MAX_QUEUE_SIZE.
+ * @param window Maximum transactions in flight, or 0 for no limit
+ */
+void Telemetry::setTransactionWindow(int window)
+{
+    transactionWindow = window;
+    startPendingTransactions();
+}
+
+/**
+ * @brief Retry a transaction when the remote end NACKs it
+ *
+ * The retry uses the same budget as timeouts, so an object missing on the
+ * remote end still fails after MAX_RETRIES.
+ */
+void Telemetry::setRetransmitOnNack(bool enable)
+{
+    retransmitOnNack = enable;
+}
+
+/**
+ * @brief Ask the autopilot for bundle frames, see UAVTalk::setBundleObjects
+ */
+void Telemetry::setBundleObjects(const QVector<quint32> &objIds)
+{
+    utalk->setBundleObjects(objIds);
+}
+
+/**
+ * @brief Ask the autopilot for all its metaobjects and settings at once,
+ * see UAVTalk::sendDumpRequest
+ */
+bool Telemetry::requestDump()
+{
+    return utalk->sendDumpRequest();
+}
+
 /**
  * Register a new object for periodic updates (if enabled)
  */
@@ -136,21 +199,18 @@ void Telemetry::registerObject(UAVObject* obj)
 void Telemetry::addObject(UAVObject* obj)
 {
     // Check if object type is already in the list
-    const QVector<ObjectTimeInfo>::iterator iterEnd = objList.end();
-    for (QVector<ObjectTimeInfo>::const_iterator iter = objList.constBegin(); iter != iterEnd; ++iter)
+    if (objListIndex.contains(obj->getObjID()))
     {
-        if (iter->obj->getObjID() == obj->getObjID())
-        {
-            // Object type (not instance!) is already in the list, do nothing
-            return;
-        }
+        // Object type (not instance!) is already in the list, do nothing
+        return;
     }
 
     // If this point is reached, then the object type is new, let's add it
     ObjectTimeInfo timeInfo;
     timeInfo.obj = obj;
-    timeInfo.timeToNextUpdateMs = 0;
     timeInfo.updatePeriodMs = 0;
+    timeInfo.generation = 0;
+    objListIndex.insert(obj->getObjID(), objList.size());
     objList.append(timeInfo);
 }
 
@@ -160,19 +220,62 @@ void Telemetry::addObject(UAVObject* obj)
 void Telemetry::setUpdatePeriod(UAVObject* obj, qint32 periodMs)
 {
     // Find object type (not instance!) and update its period
-    const quint32 objID = obj->getObjID();
+    QHash<quint32, int>::const_iterator idx = objListIndex.constFind(obj->getObjID());
+    if (idx == objListIndex.constEnd())
+        return;
+
+    ObjectTimeInfo &timeInfo = objList[idx.value()];
 
-    const QVector<ObjectTimeInfo>::iterator iterEnd = objList.end();
-    for (QVector<ObjectTimeInfo>::iterator iter = objList.begin(); iter != iterEnd; ++iter)
+    // Changing the period retires anything already queued for this object
+    if (timeInfo.updatePeriodMs == periodMs)
+        return;
+    timeInfo.updatePeriodMs = periodMs;
+    ++timeInfo.generation;
+
+    if (periodMs > 0)
     {
-        if (iter->obj->getObjID() == objID)
-        {
-            iter->updatePeriodMs = periodMs;
-            iter->timeToNextUpdateMs = quint32((float)periodMs * (float)qrand() / (float)RAND_MAX); // avoid bunching of updates
-        }
+        // avoid bunching of updates
+        qint64 phaseNs = qint64((double)periodMs * 1000000.0 * (double)qrand() / (double)RAND_MAX);
+        queuePeriodicUpdate(timeInfo, periodicClock.nsecsElapsed() + phaseNs);
+        schedulePeriodicTimer();
     }
 }
 
+/**
+ * Push the next periodic update of an object onto the deadline heap
+ */
+void Telemetry::queuePeriodicUpdate(const ObjectTimeInfo &timeInfo, qint64 dueNs)
+{
+    PeriodicUpdate update;
+    update.dueNs = dueNs;
+    update.objId = timeInfo.obj->getObjID();
+    update.generation = timeInfo.generation;
+    periodicHeap.append(update);
+    std::push_heap(periodicHeap.begin(), periodicHeap.end(), dueLater<PeriodicUpdate>);
+}
+
+/**
+ * Arm the periodic timer for the earliest pending update
+ */
+void Telemetry::schedulePeriodicTimer()
+{
+    if (periodicHeap.isEmpty())
+    {
+        updateTimer->stop();
+        return;
+    }
+
+    qint64 delayNs = periodicHeap.first().dueNs - periodicClock.nsecsElapsed();
+    // Round up to whole ms so we never wake before the deadline
+    qint64 delayMs = (delayNs + 999999) / 1000000;
+    if (delayMs < 0)
+        delayMs = 0;
+    if (delayMs > MAX_UPDATE_PERIOD_MS)
+        delayMs = MAX_UPDATE_PERIOD_MS;
+
+    updateTimer->start(delayMs);
+}
+
 /**
  * Connect to all instances of an object depending on the event mask specified
  */
@@ -281,6 +384,7 @@ void Telemetry::updateObject(UAVObject* obj, quint32 eventType)
  */
 void Telemetry::transactionSuccess(UAVObject* obj)
 {
+    recordTransactionLatency(obj, false);
     if (updateTransactionMap(obj,false)) {
         TELEMETRY_QXTLOG_DEBUG(QString("[telemetry.cpp] Transaction succeeded:%0 Instance:%1").arg(obj->getName() + QString(QString(" 0x") + QString::number(obj->getObjID(), 16).toUpper())).arg(obj->getInstID()));
         obj->emitTransactionCompleted(true);
@@ -305,6 +409,16 @@ void Telemetry::transactionFailure(UAVObject* obj)
     bool nacked = false;
     if(sender() == this->utalk)
         nacked = true;
+    if (nacked && retransmitOnNack) {
+        ObjectTransactionInfo *transInfo = findTransaction(obj);
+        if (transInfo && transInfo->inFlight && transInfo->retriesRemaining > 0) {
+            --transInfo->retriesRemaining;
+            ++txRetries;
+            ++objectStats(obj->getObjID()).retries;
+            processObjectTransaction(transInfo);
+            return;
+        }
+    }
     // Here we need to check for true or false as a NAK can occur for OBJ_REQ or an
     // object set
     if (updateTransactionMap(obj, true) || updateTransactionMap(obj, false)) {
@@ -325,6 +439,7 @@ void Telemetry::transactionFailure(UAVObject* obj)
  */
 void Telemetry::transactionRequestCompleted(UAVObject* obj)
 {
+    recordTransactionLatency(obj, true);
     if (updateTransactionMap(obj,true)) {
         TELEMETRY_QXTLOG_DEBUG(QString("[telemetry.cpp] Transaction succeeded:%0 Instance:%1").arg(obj->getName() + QString(QString(" 0x") + QString::number(obj->getObjID(), 16).toUpper())).arg(obj->getInstID()));
         obj->emitTransactionCompleted(true);
@@ -353,33 +468,83 @@ bool Telemetry::updateTransactionMap(UAVObject* obj, bool request)
     {
         ObjectTransactionInfo *transInfo = itr.value();
         // Remove this transaction as it is complete.
-        transInfo->timer->stop();
+        if (transInfo->inFlight)
+            --transactionsInFlight;
+        else
+            pendingTransactions.removeOne(transInfo);
         transMap.remove(key);
         delete transInfo;
+        startPendingTransactions();
         return true;
     }
     return false;
 }
 
+/**
+ * @brief Find or create the link usage entry of an object ID
+ */
+Telemetry::ObjectStats &Telemetry::objectStats(quint32 objId)
+{
+    QHash<quint32, ObjectStats>::iterator itr = objStats.find(objId);
+    if (itr == objStats.end())
+    {
+        ObjectStats entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.com.objId = objId;
+        entry.com.lastRxNs = -1;
+        itr = objStats.insert(objId, entry);
+    }
+    return itr.value();
+}
+
+/**
+ * @brief Account the round trip of a transaction that is about to complete
+ */
+void Telemetry::recordTransactionLatency(UAVObject* obj, bool request)
+{
+    ObjectTransactionInfo *transInfo = transMap.value(TransactionKey(obj, request), NULL);
+    if (transInfo == NULL || !transInfo->inFlight)
+        return;
+
+    qint64 latency = timeoutClock.nsecsElapsed() - transInfo->sentNs;
+    ObjectStats &entry = objectStats(obj->getObjID());
+    if (entry.transactions == 0 || latency < entry.minLatencyNs)
+        entry.minLatencyNs = latency;
+    if (latency > entry.maxLatencyNs)
+        entry.maxLatencyNs = latency;
+    entry.sumLatencyNs += latency;
+    entry.transactions++;
+}
+
+/**
+ * @brief Find the outstanding transaction for an object, request or send
+ */
+ObjectTransactionInfo *Telemetry::findTransaction(UAVObject* obj)
+{
+    ObjectTransactionInfo *transInfo = transMap.value(TransactionKey(obj, true), NULL);
+    if (transInfo == NULL)
+        transInfo = transMap.value(TransactionKey(obj, false), NULL);
+    return transInfo;
+}
+
 
 /**
  * Called when a transaction is not completed within the timeout period (timer event)
  */
 void Telemetry::transactionTimeout(ObjectTransactionInfo *transInfo)
 {
-    transInfo->timer->stop();
     // Check if more retries are pending
     if (transInfo->retriesRemaining > 0)
     {
         TELEMETRY_QXTLOG_DEBUG(QString("[telemetry.cpp] Transaction timeout:%0 Instance:%1 Retrying").arg(transInfo->obj->getName() + QString(QString(" 0x") + QString::number(transInfo->obj->getObjID(), 16).toUpper())).arg(transInfo->obj->getInstID()));
         --transInfo->retriesRemaining;
+        ++objectStats(transInfo->obj->getObjID()).retries;
         processObjectTransaction(transInfo);
         ++txRetries;
     }
     else
     {
         TELEMETRY_QXTLOG_DEBUG(QString("[telemetry.cpp] Transaction timeout:%0 Instance:%1 no more retries. FAILED TRANSACT").arg(transInfo->obj->getName() + QString(QString(" 0x") + QString::number(transInfo->obj->getObjID(), 16).toUpper())).arg(transInfo->obj->getInstID()));
-        transInfo->timer->stop();
         transactionFailure(transInfo->obj);
         ++txErrors;
     }
@@ -403,7 +568,13 @@ void Telemetry::processObjectTransaction(ObjectTransactionInfo *transInfo)
     // Start timer if a response is expected
     if ( transInfo->objRequest || transInfo->acked )
     {
-        transInfo->timer->start(REQ_TIMEOUT_MS);
+        if (!transInfo->inFlight)
+        {
+            transInfo->inFlight = true;
+            ++transactionsInFlight;
+        }
+        transInfo->sentNs = timeoutClock.nsecsElapsed();
+        armTransactionTimeout(transInfo);
     }
     else
     {
@@ -413,6 +584,93 @@ void Telemetry::processObjectTransaction(ObjectTransactionInfo *transInfo)
     }
 }
 
+/**
+ * Start a new transaction now, or hold it back until the window has room.
+ * Transactions that expect no response are never held back.
+ */
+void Telemetry::startTransaction(ObjectTransactionInfo *transInfo)
+{
+    bool needsResponse = transInfo->objRequest || transInfo->acked;
+
+    if (needsResponse && transactionWindow > 0 &&
+            (transactionsInFlight >= transactionWindow || !pendingTransactions.isEmpty()))
+    {
+        pendingTransactions.enqueue(transInfo);
+        return;
+    }
+
+    processObjectTransaction(transInfo);
+}
+
+/**
+ * Start held-back transactions while the window has room
+ */
+void Telemetry::startPendingTransactions()
+{
+    while (!pendingTransactions.isEmpty() &&
+           (transactionWindow <= 0 || transactionsInFlight < transactionWindow))
+    {
+        processObjectTransaction(pendingTransactions.dequeue());
+    }
+}
+
+/**
+ * Schedule the response timeout of a transaction that was just transmitted
+ */
+void Telemetry::armTransactionTimeout(ObjectTransactionInfo *transInfo)
+{
+    qint64 now = timeoutClock.elapsed();
+
+    if (!timeoutWheelTimer->isActive())
+    {
+        timeoutWheelTick = now / TIMEOUT_WHEEL_TICK_MS;
+        timeoutWheelTimer->start();
+    }
+
+    // Round up so a timeout never fires early
+    transInfo->deadlineTick = (now + REQ_TIMEOUT_MS + TIMEOUT_WHEEL_TICK_MS - 1) / TIMEOUT_WHEEL_TICK_MS;
+    timeoutWheel[transInfo->deadlineTick % TIMEOUT_WHEEL_SLOTS].append(TransactionKey(transInfo->obj, transInfo->objRequest));
+}
+
+/**
+ * Expire transactions whose response is overdue.  Entries are keys rather
+ * than pointers, so completed or re-armed transactions are simply skipped.
+ */
+void Telemetry::processTransactionTimeouts()
+{
+    qint64 nowTick = timeoutClock.elapsed() / TIMEOUT_WHEEL_TICK_MS;
+
+    // After a long stall every slot only needs visiting once
+    if (nowTick - timeoutWheelTick >= TIMEOUT_WHEEL_SLOTS)
+        timeoutWheelTick = nowTick - TIMEOUT_WHEEL_SLOTS + 1;
+
+    for (; timeoutWheelTick <= nowTick; ++timeoutWheelTick)
+    {
+        QList<TransactionKey> &slot = timeoutWheel[timeoutWheelTick % TIMEOUT_WHEEL_SLOTS];
+        QList<TransactionKey> expired;
+        expired.swap(slot);
+
+        foreach (const TransactionKey &key, expired)
+        {
+            ObjectTransactionInfo *transInfo = transMap.value(key, NULL);
+            if (transInfo == NULL || !transInfo->inFlight)
+                continue;
+            if (transInfo->deadlineTick > nowTick)
+            {
+                // Not due yet, keep it in the wheel
+                if (transInfo->deadlineTick % TIMEOUT_WHEEL_SLOTS == timeoutWheelTick % TIMEOUT_WHEEL_SLOTS)
+                    slot.append(key);
+                continue;
+            }
+            if (transInfo->deadlineTick <= timeoutWheelTick)
+                transactionTimeout(transInfo);
+        }
+    }
+
+    if (transactionsInFlight == 0)
+        timeoutWheelTimer->stop();
+}
+
 /**
  * Process the event received from an object we are following. This method
  * only enqueues objects for later processing
@@ -424,9 +682,10 @@ void Telemetry::processObjectUpdates(UAVObject* obj, EventMask event, bool allIn
     objInfo.obj = obj;
     objInfo.event = event;
     objInfo.allInstances = allInstances;
+    int maxQueueSize = (transactionWindow > 0) ? MAX_PIPELINED_QUEUE_SIZE : MAX_QUEUE_SIZE;
     if (priority)
     {
-        if ( objPriorityQueue.length() < MAX_QUEUE_SIZE )
+        if ( objPriorityQueue.length() < maxQueueSize )
         {
             objPriorityQueue.enqueue(objInfo);
         }
@@ -440,7 +699,7 @@ void Telemetry::processObjectUpdates(UAVObject* obj, EventMask event, bool allIn
     }
     else
     {
-        if ( objQueue.length() < MAX_QUEUE_SIZE )
+        if ( objQueue.length() < maxQueueSize )
         {
             objQueue.enqueue(objInfo);
         }
@@ -528,7 +787,7 @@ void Telemetry::processObjectQueue()
             // Insert the transaction into the transaction map.
             TransactionKey key(objInfo.obj, transInfo->objRequest);
             transMap.insert(key, transInfo);
-            processObjectTransaction(transInfo);
+            startTransaction(transInfo);
         }
     }
 
@@ -564,57 +823,40 @@ void Telemetry::processObjectQueue()
  */
 void Telemetry::processPeriodicUpdates()
 {
-    // Stop timer
-    updateTimer->stop();
+    qint64 now = periodicClock.nsecsElapsed();
 
-    // Iterate through each object and update its timer, if zero then transmit object.
-    // Also calculate smallest delay to next update (will be used for setting timeToNextUpdateMs)
-    qint32 minDelay = MAX_UPDATE_PERIOD_MS;
-    qint32 elapsedMs = 0;
-    QTime time;
-    qint32 offset;
-
-    const QVector<ObjectTimeInfo>::iterator objInfoEnd = objList.end();
-    for (QVector<ObjectTimeInfo>::iterator objinfo = objList.begin(); objinfo != objInfoEnd; ++objinfo)
+    // Pop every update that is due. Deadlines advance by whole periods
+    // from the previous deadline, so late wakeups do not accumulate drift.
+    while (!periodicHeap.isEmpty() && periodicHeap.first().dueNs <= now)
     {
-        // If object is configured for periodic updates
-        // FixMe: This is an inefficient process as it depends on polling. It would be better to have
-        // this functionality be driven through timers.
-        if (objinfo->updatePeriodMs > 0)
+        std::pop_heap(periodicHeap.begin(), periodicHeap.end(), dueLater<PeriodicUpdate>);
+        PeriodicUpdate update = periodicHeap.takeLast();
+
+        QHash<quint32, int>::const_iterator idx = objListIndex.constFind(update.objId);
+        if (idx == objListIndex.constEnd())
+            continue;
+        const ObjectTimeInfo &timeInfo = objList.at(idx.value());
+        if (timeInfo.generation != update.generation || timeInfo.updatePeriodMs <= 0)
         {
-            objinfo->timeToNextUpdateMs -= timeToNextUpdateMs;
-            // Check if time for the next update
-            if (objinfo->timeToNextUpdateMs <= 0)
-            {
-                // Reset timer
-                offset = (-objinfo->timeToNextUpdateMs) % objinfo->updatePeriodMs;
-                objinfo->timeToNextUpdateMs = objinfo->updatePeriodMs - offset;
-                // Send object
-                time.start();
-                processObjectUpdates(objinfo->obj, EV_UPDATED_PERIODIC, true, false);
-                elapsedMs = time.elapsed();
-                // Update timeToNextUpdateMs with the elapsed delay of sending the object;
-                timeToNextUpdateMs += elapsedMs;
-            }
-            // Update minimum delay
-            if (objinfo->timeToNextUpdateMs < minDelay)
-            {
-                minDelay = objinfo->timeToNextUpdateMs;
-            }
+            // Period changed since this was queued
+            continue;
         }
-    }
 
-    // Check if delay for the next update is too short
-    if (minDelay < MIN_UPDATE_PERIOD_MS)
-    {
-        minDelay = MIN_UPDATE_PERIOD_MS;
-    }
+        qint64 periodNs = qint64(timeInfo.updatePeriodMs) * 1000000;
+        qint64 due = update.dueNs + periodNs;
+        if (due <= now)
+        {
+            // Fell behind by more than a period, skip the missed updates
+            due += ((now - due) / periodNs + 1) * periodNs;
+        }
+        queuePeriodicUpdate(timeInfo, due);
 
-    // Done
-    timeToNextUpdateMs = minDelay;
+        // Send object (may register objects and so invalidate timeInfo)
+        UAVObject *obj = timeInfo.obj;
+        processObjectUpdates(obj, EV_UPDATED_PERIODIC, true, false);
+    }
 
-    // Restart timer
-    updateTimer->start(timeToNextUpdateMs);
+    schedulePeriodicTimer();
 }
 
 Telemetry::TelemetryStats Telemetry::getStats()
@@ -638,11 +880,30 @@ Telemetry::TelemetryStats Telemetry::getStats()
     return stats;
 }
 
+/**
+ * @brief Per-object link usage, merging the UAVTalk traffic counters with
+ * the transaction retries and round trip times tracked here
+ */
+QVector<Telemetry::ObjectStats> Telemetry::getObjectStats()
+{
+    QVector<ObjectStats> result;
+
+    foreach (const UAVTalk::ObjectComStats &com, utalk->getObjectStats())
+    {
+        ObjectStats entry = objectStats(com.objId);
+        entry.com = com;
+        result.append(entry);
+    }
+
+    return result;
+}
+
 void Telemetry::resetStats()
 {
     utalk->resetStats();
     txErrors = 0;
     txRetries = 0;
+    objStats.clear();
 }
 
 void Telemetry::objectUpdatedAuto(UAVObject* obj)
@@ -692,22 +953,13 @@ ObjectTransactionInfo::ObjectTransactionInfo(QObject* parent):QObject(parent)
     objRequest = false;
     retriesRemaining = 0;
     acked = false;
+    inFlight = false;
+    sentNs = 0;
+    deadlineTick = 0;
     telem = 0;
-    // Setup transaction timer
-    timer = new QTimer(this);
-    timer->stop();
-    connect(timer, SIGNAL(timeout()), this, SLOT(timeout()));
 }
 
 ObjectTransactionInfo::~ObjectTransactionInfo()
 {
     telem = 0;
-    timer->stop();
-    timer->deleteLater();
-}
-
-void ObjectTransactionInfo::timeout()
-{
-    if (!telem.isNull())
-        telem->transactionTimeout(this);
 }
@@ -26,7 +26,7 @@
  * for more details.
  * 
  * You should have received a copy of the GNU General Public License along 
- * with this program; if not, see <http://www.gnu.org/licenses/>
+ * with this program; if not, see <http://www.gnu.org/licenses/>
  *
  * Additional note on redistribution: The copyright and license notices above
  * must be maintained in each individual source file that is a derivative work
@@ -40,6 +40,7 @@
 #include "uavobjectmanager.h"
 #include "gcstelemetrystats.h"
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QQueue>
 #include <QMap>
 
@@ -56,10 +57,10 @@ public:
     bool objRequest;
     qint32 retriesRemaining;
     bool acked;
+    bool inFlight;          /** Sent and awaiting a response */
+    qint64 sentNs;          /** Time of the latest transmission */
+    qint64 deadlineTick;    /** Timeout wheel tick at which the response is late */
     QPointer<class Telemetry>telem;
-    QTimer* timer;
-private slots:
-    void timeout();
 };
 
 class Telemetry: public QObject
@@ -79,13 +80,31 @@ public:
         quint32 txRetries;
     } TelemetryStats;
 
+    /**
+     * Link usage of one object ID, for tuning update periods
+     */
+    typedef struct {
+        UAVTalk::ObjectComStats com;
+        quint32 retries;
+        quint32 transactions;       /** Completed acked sends and requests */
+        qint64 minLatencyNs;        /** Shortest round trip of a transaction */
+        qint64 maxLatencyNs;        /** Longest round trip of a transaction */
+        qint64 sumLatencyNs;        /** Of all round trips, for the mean */
+    } ObjectStats;
+
     Telemetry(UAVTalk* utalk, UAVObjectManager* objMngr);
     ~Telemetry();
     TelemetryStats getStats();
+    QVector<ObjectStats> getObjectStats();
     void resetStats();
     void transactionTimeout(ObjectTransactionInfo *info);
+    void setTransactionWindow(int window);
+    void setRetransmitOnNack(bool enable);
+    void setBundleObjects(const QVector<quint32> &objIds);
+    bool requestDump();
 
 signals:
+    void dumpCompleted(bool success);
 
 private:
     // Constants
@@ -94,6 +113,9 @@ private:
     static const int MAX_UPDATE_PERIOD_MS = 1000;
     static const int MIN_UPDATE_PERIOD_MS = 1;
     static const int MAX_QUEUE_SIZE = 20;
+    static const int MAX_PIPELINED_QUEUE_SIZE = 500;
+    static const int TIMEOUT_WHEEL_TICK_MS = 10;
+    static const int TIMEOUT_WHEEL_SLOTS = 32; // Must span REQ_TIMEOUT_MS
 
     // Types
     /**
@@ -111,9 +133,15 @@ private:
     typedef struct {
         UAVObject* obj;
         qint32 updatePeriodMs;      /** Update period in ms or 0 if no periodic updates are needed */
-        qint32 timeToNextUpdateMs;  /** Time delay to the next update */
+        quint32 generation;         /** Bumped on every period change to retire queued updates */
     } ObjectTimeInfo;
 
+    typedef struct {
+        qint64 dueNs;               /** Deadline on periodicClock */
+        quint32 objId;
+        quint32 generation;         /** ObjectTimeInfo::generation when queued */
+    } PeriodicUpdate;
+
     typedef struct {
         UAVObject* obj;
         EventMask event;
@@ -125,25 +153,44 @@ private:
     UAVTalk* utalk;
     GCSTelemetryStats* gcsStatsObj;
     QVector<ObjectTimeInfo> objList;
+    QHash<quint32, int> objListIndex;
+    QVector<PeriodicUpdate> periodicHeap;
+    QElapsedTimer periodicClock;
     QQueue<ObjectQueueInfo> objQueue;
     QQueue<ObjectQueueInfo> objPriorityQueue;
     QMap<TransactionKey, ObjectTransactionInfo*>transMap;
+    QQueue<ObjectTransactionInfo*> pendingTransactions;
+    int transactionWindow;
+    int transactionsInFlight;
+    bool retransmitOnNack;
+    QVector<QList<TransactionKey> > timeoutWheel;
+    QTimer* timeoutWheelTimer;
+    QElapsedTimer timeoutClock;
+    qint64 timeoutWheelTick;
     QTimer* updateTimer;
     QTimer* statsTimer;
-    qint32 timeToNextUpdateMs;
     quint32 txErrors;
     quint32 txRetries;
+    QHash<quint32, ObjectStats> objStats;
 
     // Methods
     void registerObject(UAVObject* obj);
     void addObject(UAVObject* obj);
     void setUpdatePeriod(UAVObject* obj, qint32 periodMs);
+    void queuePeriodicUpdate(const ObjectTimeInfo &timeInfo, qint64 dueNs);
+    void schedulePeriodicTimer();
     void connectToObjectInstances(UAVObject* obj, quint32 eventMask);
     void updateObject(UAVObject* obj, quint32 eventMask);
     void processObjectUpdates(UAVObject* obj, EventMask event, bool allInstances, bool priority);
     void processObjectTransaction(ObjectTransactionInfo *transInfo);
+    void startTransaction(ObjectTransactionInfo *transInfo);
+    void startPendingTransactions();
+    void armTransactionTimeout(ObjectTransactionInfo *transInfo);
     void processObjectQueue();
     bool updateTransactionMap(UAVObject* obj, bool request);
+    ObjectTransactionInfo *findTransaction(UAVObject* obj);
+    ObjectStats &objectStats(quint32 objId);
+    void recordTransactionLatency(UAVObject* obj, bool request);
 
 
 private slots:
@@ -156,6 +203,7 @@ private slots:
     void newObject(UAVObject* obj);
     void newInstance(UAVObject* obj);
     void processPeriodicUpdates();
+    void processTransactionTimeouts();
     void transactionSuccess(UAVObject* obj);
     void transactionFailure(UAVObject* obj);
     void transactionRequestCompleted(UAVObject* obj);
@@ -27,9 +27,13 @@
 
 #include "telemetrymanager.h"
 #include <extensionsystem/pluginmanager.h>
+#include <extensionsystem/tracelog.h>
 #include <coreplugin/icore.h>
 
 TelemetryManager::TelemetryManager() :
+    utalk(NULL),
+    telemetry(NULL),
+    telemetryMon(NULL),
     autopilotConnected(false)
 {
     // Get UAVObjectManager instance
@@ -50,10 +54,24 @@ bool TelemetryManager::isConnected()
     return autopilotConnected;
 }
 
+/**
+ * @brief Per-object link usage of the running telemetry session, empty
+ * when telemetry is stopped
+ */
+QVector<Telemetry::ObjectStats> TelemetryManager::getObjectStats()
+{
+    if (telemetryMon == NULL)
+        return QVector<Telemetry::ObjectStats>();
+    return telemetryMon->getObjectStats();
+}
+
 void TelemetryManager::start(QIODevice *dev)
 {
-    utalk = new UAVTalk(dev, objMngr);
+    ExtensionSystem::TraceScope trace("Start telemetry", "connect");
+
+    utalk = new UAVTalk(dev, objMngr, true);
     telemetry = new Telemetry(utalk, objMngr);
+    telemetry->setTransactionWindow(TRANSACTION_WINDOW);
     telemetryMon = new TelemetryMonitor(objMngr, telemetry, sessions);
     connect(telemetryMon, SIGNAL(connected()), this, SLOT(onConnect()));
     connect(telemetryMon, SIGNAL(disconnected()), this, SLOT(onDisconnect()));
@@ -72,14 +90,60 @@ void TelemetryManager::stop()
     onDisconnect();
 }
 
+/**
+ * @brief Starts telemetry with another vehicle, which has its own object
+ * manager and leaves the main connection alone
+ * @param name to show the vehicle by, such as its port
+ */
+VehicleSession *TelemetryManager::addVehicle(const QString &name, QIODevice *dev)
+{
+    ExtensionSystem::TraceScope trace("Start vehicle telemetry", "connect");
+
+    VehicleSession *vehicle = new VehicleSession(name, dev, this);
+    vehicles.append(vehicle);
+    emit vehicleAdded(vehicle);
+    return vehicle;
+}
+
+/**
+ * @brief Stops the telemetry that addVehicle() started on dev
+ */
+void TelemetryManager::removeVehicle(QIODevice *dev)
+{
+    foreach (VehicleSession *vehicle, vehicles) {
+        if (vehicle->device() != dev)
+            continue;
+
+        emit vehicleAboutToBeRemoved(vehicle);
+        vehicles.removeOne(vehicle);
+        // Like stop(), this can be called from the session's own signals
+        vehicle->deleteLater();
+    }
+}
+
+/**
+ * @brief What a map needs of each watched vehicle, in getVehicles() order
+ */
+QVector<VehicleSession::Snapshot> TelemetryManager::getVehicleSnapshots()
+{
+    QVector<VehicleSession::Snapshot> snapshots;
+    snapshots.reserve(vehicles.size());
+    foreach (VehicleSession *vehicle, vehicles)
+        snapshots.append(vehicle->snapshot());
+    return snapshots;
+}
+
 void TelemetryManager::onConnect()
 {
+    ExtensionSystem::TraceLog::asyncEnd("Board connect", "connect");
     autopilotConnected = true;
     emit connected();
 }
 
 void TelemetryManager::onDisconnect()
 {
+    if (!autopilotConnected)
+        ExtensionSystem::TraceLog::asyncEnd("Board connect", "connect", "disconnected first");
     autopilotConnected = false;
     emit disconnected();
 }
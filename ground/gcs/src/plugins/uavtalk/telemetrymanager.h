@@ -35,6 +35,7 @@
 #include "telemetry.h"
 #include "uavtalk.h"
 #include "uavobjectmanager.h"
+#include "vehiclesession.h"
 #include <QIODevice>
 #include <QObject>
 
@@ -49,10 +50,18 @@ public:
     void start(QIODevice *dev);
     void stop();
     bool isConnected();
+    QVector<Telemetry::ObjectStats> getObjectStats();
+
+    VehicleSession *addVehicle(const QString &name, QIODevice *dev);
+    void removeVehicle(QIODevice *dev);
+    QList<VehicleSession *> getVehicles() { return vehicles; }
+    QVector<VehicleSession::Snapshot> getVehicleSnapshots();
 
 signals:
     void connected();
     void disconnected();
+    void vehicleAdded(VehicleSession *vehicle);
+    void vehicleAboutToBeRemoved(VehicleSession *vehicle);
 
 private slots:
     void onConnect();
@@ -60,12 +69,15 @@ private slots:
     void onGeneralSettingsChanged();
 
 private:
+    static const int TRANSACTION_WINDOW = 8;
+
     UAVObjectManager* objMngr;
     UAVTalk* utalk;
     Telemetry* telemetry;
     TelemetryMonitor* telemetryMon;
 
     bool autopilotConnected;
+    QList<VehicleSession *> vehicles; // Watched besides the main connection
     QHash<quint16, QList<TelemetryMonitor::objStruc> > sessions;
     Core::Internal::GeneralSettings *settings;
 };
@@ -35,6 +35,8 @@
 #include "coreplugin/icore.h"
 #include "firmwareiapobj.h"
 
+#include <extensionsystem/tracelog.h>
+
 //Number of retries for initial session object fetching
 //This is needed because sometimes the object is lost when asked right uppon connection
 #define SESSION_INIT_RETRIES                3
@@ -48,6 +50,8 @@
 #define OBJECT_RETRIEVE_TIMEOUT             5000
 //IAP object is very important, retry if not able to get it the first time
 #define IAP_OBJECT_RETRIES                  3
+//Timeout for the dump of metaobjects and settings, they are fetched one by one after it
+#define DUMP_TIMEOUT                        8000
 
 #ifdef TELEMETRYMONITOR_DEBUG
   #define TELEMETRYMONITOR_QXTLOG_DEBUG(...) qDebug()<<__VA_ARGS__
@@ -62,6 +66,7 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager* objMngr, Telemetry* tel, QH
     connectionStatus(CON_DISCONNECTED),
     objMngr(objMngr),
     tel(tel),
+    dumping(false),
     numberOfObjects(0),
     retries(0),
     isManaged(true),
@@ -86,10 +91,14 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager* objMngr, Telemetry* tel, QH
     objectRetrieveTimeout->setSingleShot(true);
     sessionInitialRetrieveTimeout = new QTimer(this);
     sessionInitialRetrieveTimeout->setSingleShot(true);
+    dumpTimeout = new QTimer(this);
+    dumpTimeout->setSingleShot(true);
     connect(statsTimer, SIGNAL(timeout()), this, SLOT(processStatsUpdates()));
     connect(sessionRetrieveTimeout,SIGNAL(timeout()),this,SLOT(sessionRetrieveTimeoutCB()));
     connect(sessionInitialRetrieveTimeout,SIGNAL(timeout()),this,SLOT(sessionInitialRetrieveTimeoutCB()));
     connect(objectRetrieveTimeout,SIGNAL(timeout()),this,SLOT(objectRetrieveTimeoutCB()));
+    connect(dumpTimeout,SIGNAL(timeout()),this,SLOT(dumpTimeoutCB()));
+    connect(tel,SIGNAL(dumpCompleted(bool)),this,SLOT(dumpCompletedCB(bool)));
     statsTimer->start(STATS_CONNECT_PERIOD_MS);
 
     Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
@@ -101,6 +110,8 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager* objMngr, Telemetry* tel, QH
 
     ExtensionSystem::PluginManager* pm = ExtensionSystem::PluginManager::instance();
     settings=pm->getObject<Core::Internal::GeneralSettings>();
+
+    ExtensionSystem::TraceLog::asyncBegin("Handshake", "connect");
 }
 
 TelemetryMonitor::~TelemetryMonitor() {
@@ -129,11 +140,15 @@ TelemetryMonitor::~TelemetryMonitor() {
 void TelemetryMonitor::startRetrievingObjects()
 {
     TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 connectionStatus changed to CON_RETRIEVING_OBJECT").arg(Q_FUNC_INFO));
+    if (connectionStatus == CON_INITIALIZING || connectionStatus == CON_SESSION_INITIALIZING)
+        ExtensionSystem::TraceLog::asyncEnd("Session", "connect", isManaged ? "" : "fell back");
+    ExtensionSystem::TraceLog::asyncBegin("Object retrieval", "connect");
     connectionStatus = CON_RETRIEVING_OBJECTS;
-    // Get all objects, add metaobjects, settings and data objects with OnChange update mode to the queue
+    // Get all objects, add metaobjects, settings and data objects with OnChange update mode to the queues.
+    // The autopilot sends the metaobjects and settings in one dump, the rest is requested one by one.
     queue.clear();
+    dumpQueue.clear();
     retries = 0;
-    objectRetrieveTimeout->start(OBJECT_RETRIEVE_TIMEOUT);
     foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects().values())
     {
         UAVObject* obj = map.first();
@@ -150,11 +165,11 @@ void TelemetryMonitor::startRetrievingObjects()
                 TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 %1 not present on hardware, skipping").arg(Q_FUNC_INFO).arg(obj->getName()));
                 continue;
             }
-            queue.enqueue(dobj->getMetaObject());
+            dumpQueue.enqueue(dobj->getMetaObject());
             if ( dobj->isSettings() )
             {
                 TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 queing settings object %1").arg(Q_FUNC_INFO).arg(dobj->getName()));
-                queue.enqueue(obj);
+                dumpQueue.enqueue(obj);
             }
             else
             {
@@ -172,10 +187,59 @@ void TelemetryMonitor::startRetrievingObjects()
     }
     // Start retrieving
     TELEMETRYMONITOR_QXTLOG_DEBUG(QString(tr("Starting to retrieve meta and settings objects from the autopilot (%1 objects)"))
-                                  .arg( queue.length()));
+                                  .arg( dumpQueue.length() + queue.length()));
+    dumping = tel->requestDump();
+    if (dumping)
+    {
+        ExtensionSystem::TraceLog::asyncBegin("Dump", "connect");
+        dumpTimeout->start(DUMP_TIMEOUT);
+        return;
+    }
+    finishDump(false);
+}
+
+/**
+ * Go on with the objects requested one by one, after the dump or instead of it
+ */
+void TelemetryMonitor::finishDump(bool success)
+{
+    if (dumping)
+        ExtensionSystem::TraceLog::asyncEnd("Dump", "connect", success ? "" : "fell back");
+    dumping = false;
+    dumpTimeout->stop();
+
+    if (!success)
+    {
+        TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 no dump, requesting %1 objects one by one").arg(Q_FUNC_INFO).arg(dumpQueue.length()));
+        while (!queue.isEmpty())
+            dumpQueue.enqueue(queue.dequeue());
+        queue.swap(dumpQueue);
+    }
+    dumpQueue.clear();
+
+    objectRetrieveTimeout->start(OBJECT_RETRIEVE_TIMEOUT);
     retrieveNextObject();
 }
 
+/**
+ * Called when the autopilot sent the last object of the dump, or refused it
+ */
+void TelemetryMonitor::dumpCompletedCB(bool success)
+{
+    // Too late, or not asked for
+    if (!dumping || connectionStatus != CON_RETRIEVING_OBJECTS)
+        return;
+    finishDump(success);
+}
+
+void TelemetryMonitor::dumpTimeoutCB()
+{
+    if (!dumping || connectionStatus != CON_RETRIEVING_OBJECTS)
+        return;
+    TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 dump timed out").arg(Q_FUNC_INFO));
+    finishDump(false);
+}
+
 void TelemetryMonitor::changeObjectInstances(quint32 objID, quint32 instID, bool delayed)
 {
     TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 OBJID:%1 INSTID:%2").arg(Q_FUNC_INFO).arg(objID).arg(instID));
@@ -253,6 +317,21 @@ void TelemetryMonitor::retrieveNextObject()
             uavo->setIsPresentOnHardware(true);
         }
         delayedUpdate.clear();
+        if(isManaged)
+        {
+            // The autopilot indexes its objects by ID, and we know now
+            // which of them it has
+            QVector<quint32> bundleObjIds;
+            foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects())
+            {
+                UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(map.value(0));
+                if(dobj && dobj->getIsPresentOnHardware())
+                    bundleObjIds.append(dobj->getObjID());
+            }
+            qSort(bundleObjIds);
+            tel->setBundleObjects(bundleObjIds);
+        }
+        ExtensionSystem::TraceLog::asyncEnd("Object retrieval", "connect");
         emit connected();
         sessionRetrieveTimeout->stop();
         sessionInitialRetrieveTimeout->stop();
@@ -472,6 +551,7 @@ void TelemetryMonitor::startSessionRetrieving(UAVObject *session)
     static int sessionNegotiationRetries = 0;
     if(session == NULL)
     {
+        tel->setBundleObjects(QVector<quint32>());
         sessionRetrieveTimeout->start(SESSION_RETRIEVE_TIMEOUT);
         TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 NULL new session start").arg(Q_FUNC_INFO));
         foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects())
@@ -643,6 +723,7 @@ void TelemetryMonitor::processStatsUpdates()
     {
         statsTimer->setInterval(STATS_UPDATE_PERIOD_MS);
         qDebug() << "Connection with the autopilot established";
+        ExtensionSystem::TraceLog::asyncEnd("Handshake", "connect");
         ExtensionSystem::PluginManager* pm = ExtensionSystem::PluginManager::instance();
         Core::Internal::GeneralSettings * settings=pm->getObject<Core::Internal::GeneralSettings>();
         if (!settings->useSessionManaging())
@@ -652,6 +733,7 @@ void TelemetryMonitor::processStatsUpdates()
         else
         {
             connectionStatus = CON_INITIALIZING;
+            ExtensionSystem::TraceLog::asyncBegin("Session", "connect");
             sessionInitialRetrieveTimeout->start(SESSION_INITIAL_RETRIEVE_TIMEOUT);
             connect(sessionObj,SIGNAL(transactionCompleted(UAVObject*,bool,bool)),this, SLOT(checkSessionObjNacked(UAVObject*, bool, bool)),Qt::UniqueConnection);
             sessionObj->requestUpdate();
@@ -662,6 +744,10 @@ void TelemetryMonitor::processStatsUpdates()
     {
         statsTimer->setInterval(STATS_CONNECT_PERIOD_MS);
         connectionStatus = CON_DISCONNECTED;
+        dumping = false;
+        dumpTimeout->stop();
+        ExtensionSystem::TraceLog::asyncBegin("Handshake", "connect");
+        tel->setBundleObjects(QVector<quint32>());
         ExtensionSystem::PluginManager* pm = ExtensionSystem::PluginManager::instance();
         Core::Internal::GeneralSettings * settings=pm->getObject<Core::Internal::GeneralSettings>();
         if (settings->useSessionManaging())
@@ -62,6 +62,7 @@ public:
     TelemetryMonitor(UAVObjectManager* objMngr, Telemetry* tel, QHash<quint16, QList<objStruc> > sessions);
     ~TelemetryMonitor();
     QHash<quint16, QList<objStruc> > savedSessions() {return sessions;}
+    QVector<Telemetry::ObjectStats> getObjectStats() {return tel->getObjectStats();}
 signals:
     void connected();
     void disconnected();
@@ -77,6 +78,8 @@ private slots:
     void objectRetrieveTimeoutCB();
     void sessionRetrieveTimeoutCB();
     void sessionInitialRetrieveTimeoutCB();
+    void dumpCompletedCB(bool success);
+    void dumpTimeoutCB();
     void saveSession();
     void newInstanceSlot(UAVObject*);
 private:
@@ -89,6 +92,8 @@ private:
     UAVObjectManager* objMngr;
     Telemetry* tel;
     QQueue<UAVObject*> queue;
+    QQueue<UAVObject*> dumpQueue;   // What the dump brings, to fetch one by one without it
+    bool dumping;
     GCSTelemetryStats* gcsStatsObj;
     FlightTelemetryStats* flightStatsObj;
     QTimer* statsTimer;
@@ -96,11 +101,13 @@ private:
     SessionManaging* sessionObj;
     void startRetrievingObjects();
     void retrieveNextObject();
+    void finishDump(bool success);
     quint16 sessionID;
     quint8 numberOfObjects;
     QTimer* objectRetrieveTimeout;
     QTimer* sessionRetrieveTimeout;
     QTimer* sessionInitialRetrieveTimeout;
+    QTimer* dumpTimeout;
     int retries;
     void changeObjectInstances(quint32 objID, quint32 instID, bool delayed);
     void startSessionRetrieving(UAVObject *session);
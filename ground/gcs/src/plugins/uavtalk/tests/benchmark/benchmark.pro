@@ -0,0 +1,17 @@
+QT += testlib network widgets qml
+TEMPLATE = app
+TARGET = tst_uavtalkbenchmark
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../../../../../gcs.pri)
+include(../../uavtalk.pri)
+
+INCLUDEPATH *= $$GCS_SOURCE_TREE/src/plugins \
+    $$GCS_SOURCE_TREE/src/plugins/uavtalk
+
+# The plugins are ordinary libraries, only kept in the plugin directory
+LIBS += -L$$GCS_PLUGIN_PATH/dRonin
+unix:!macx:QMAKE_RPATHDIR += $$GCS_PLUGIN_PATH/dRonin $$GCS_LIBRARY_PATH
+
+SOURCES += tst_uavtalkbenchmark.cpp
@@ -0,0 +1,563 @@
+/**
+ ******************************************************************************
+ * @file       tst_uavtalkbenchmark.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Benchmarks of the telemetry receive path and of object access
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * The telemetry decoded is a capture named by DRONIN_BENCH_CAPTURE: a log
+ * recorded by the GCS in the readable format (not the compact one), or a
+ * raw UAVTalk stream.  Objects the capture has that this build does not
+ * know are skipped.  Without a capture a minute of the usual flight
+ * telemetry is made up from objects at their defaults, which is a fair
+ * mix of sizes but always the same values.
+ *
+ * Results are per iteration, and each row says what an iteration is.
+ * To keep a baseline and compare it with a later commit:
+ *
+ *   tst_uavtalkbenchmark -o before.csv,csv
+ *   tst_uavtalkbenchmark -o after.csv,csv
+ *
+ * Use the same capture for both, and -tickcounter or -callgrind for
+ * figures that depend less on the load of the machine.
+ */
+
+#include "uavtalk.h"
+#include "uavobjectmanager.h"
+#include "uavobjectsinit.h"
+
+#include <QtCore/QObject>
+#include <QtTest/QtTest>
+#include <QBuffer>
+#include <QFile>
+#include <QtEndian>
+
+namespace {
+
+// As in UAVTalk
+const quint8 SYNC_VAL = 0x3C;
+const quint8 TYPE_MASK = 0xF8;
+const quint8 TYPE_OBJ = 0x20;
+const quint8 TYPE_OBJ_ACK = 0x22;
+const int MIN_HEADER_LENGTH = 8;
+const int MAX_PACKET_LENGTH = 10 + 256;
+
+const char LOG_HEADER[] = "dRonin git hash:";
+const char LOG_FORMAT_V2_LINE[] = "format: 2";
+const int LOG_RECORD_HEADER_LENGTH = sizeof(quint32) + sizeof(qint64);
+
+const int SYNTHETIC_SECONDS = 60;
+
+//! Updates a second of the flight telemetry of a typical vehicle
+const struct {
+    const char *name;
+    int rate;
+} telemetryMix[] = {
+    { "Gyros", 20 },
+    { "Accels", 20 },
+    { "AttitudeActual", 20 },
+    { "Magnetometer", 10 },
+    { "BaroAltitude", 10 },
+    { "ManualControlCommand", 10 },
+    { "StabilizationDesired", 10 },
+    { "ActuatorDesired", 10 },
+    { "ActuatorCommand", 10 },
+    { "PositionActual", 5 },
+    { "VelocityActual", 5 },
+    { "GPSPosition", 5 },
+    { "FlightStatus", 1 },
+    { "SystemAlarms", 1 },
+    { "SystemStats", 1 },
+    { "FlightTelemetryStats", 1 },
+};
+
+//! A packet of the capture carrying an object
+struct Frame {
+    quint32 objId;
+    int offset;             // Of the sync byte in the stream
+    int length;             // Checksum included
+    int payload;            // Offset of the object data in the packet
+};
+
+}
+
+/**
+ * Counts the signals it gets, standing in for a gadget
+ */
+class Receiver : public QObject
+{
+    Q_OBJECT
+
+public:
+    Receiver() : count(0) {}
+    quint64 count;
+
+public slots:
+    void updated(UAVObject *) { count++; }
+};
+
+class tst_UAVTalkBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void decodeStream_data();
+    void decodeStream();
+    void decodePacket_data();
+    void decodePacket();
+    void unpack_data();
+    void unpack();
+    void getValue_data();
+    void getValue();
+    void setValue_data();
+    void setValue();
+    void getObject_data();
+    void getObject();
+    void fanOut_data();
+    void fanOut();
+
+private:
+    UAVObjectManager *objMngr;
+    QBuffer *rxDev;
+    UAVTalk *utalk;
+    QByteArray stream;
+    QVector<Frame> frames;
+    QVector<int> framesByObject;    // First frame of each object seen
+
+    bool loadCapture(const QString &path, QString &error);
+    void makeStream();
+    void findFrames();
+    void addObjectRows();
+    void addFieldRows();
+    UAVObjectField *fetchField();
+};
+
+/**
+ * Read a log or a raw UAVTalk stream into the stream to decode
+ */
+bool tst_UAVTalkBenchmark::loadCapture(const QString &path, QString &error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+
+    QByteArray contents = file.readAll();
+    if (!contents.startsWith(LOG_HEADER)) {
+        stream = contents;
+        return true;
+    }
+
+    int end = contents.indexOf("\n##\n");
+    if (end < 0) {
+        error = QLatin1String("log header has no end");
+        return false;
+    }
+    if (contents.left(end).contains(LOG_FORMAT_V2_LINE)) {
+        error = QLatin1String("compact logs are not read, record the capture in the readable format");
+        return false;
+    }
+
+    // Records are a timestamp, the packet size and the packet
+    qint64 pos = end + 4;
+    while (pos + LOG_RECORD_HEADER_LENGTH <= contents.size()) {
+        qint64 size;
+        memcpy(&size, contents.constData() + pos + sizeof(quint32), sizeof(size));
+        pos += LOG_RECORD_HEADER_LENGTH;
+        if (size < 1 || pos + size > contents.size())
+            break;
+
+        stream.append(contents.constData() + pos, size);
+        pos += size;
+    }
+
+    return true;
+}
+
+/**
+ * Make up telemetry in the proportions of telemetryMix, interleaved as a
+ * vehicle would send it
+ */
+void tst_UAVTalkBenchmark::makeStream()
+{
+    QBuffer txDev(&stream);
+    txDev.open(QIODevice::WriteOnly);
+    UAVTalk tx(&txDev, objMngr);
+
+    const int numMix = sizeof(telemetryMix) / sizeof(telemetryMix[0]);
+    QVector<UAVObject *> mixObjects(numMix);
+    for (int i = 0; i < numMix; i++)
+        mixObjects[i] = objMngr->getObject(QLatin1String(telemetryMix[i].name));
+
+    // Every 50 ms, each object due by its rate
+    for (int tick = 0; tick < SYNTHETIC_SECONDS * 20; tick++) {
+        for (int i = 0; i < numMix; i++) {
+            if (mixObjects[i] == NULL || (tick * telemetryMix[i].rate) % 20 >= telemetryMix[i].rate)
+                continue;
+            tx.sendObject(mixObjects[i], false, false);
+        }
+    }
+}
+
+/**
+ * Find the packets of the stream that carry objects this build knows
+ */
+void tst_UAVTalkBenchmark::findFrames()
+{
+    const quint8 *data = (const quint8 *)stream.constData();
+    QHash<quint32, int> seen;
+
+    int pos = 0;
+    while (pos + MIN_HEADER_LENGTH < stream.size()) {
+        const quint8 *p = data + pos;
+        int size = qFromLittleEndian<quint16>(p + 2);
+        quint8 type = p[1];
+
+        if (p[0] != SYNC_VAL || (type & TYPE_MASK) != TYPE_OBJ ||
+                size < MIN_HEADER_LENGTH || size >= MAX_PACKET_LENGTH ||
+                pos + size >= stream.size() ||
+                UAVTalk::updateCRC(0, p, size) != p[size]) {
+            pos++;
+            continue;
+        }
+
+        Frame frame;
+        frame.objId = qFromLittleEndian<quint32>(p + 4);
+        frame.offset = pos;
+        frame.length = size + 1;
+        pos += frame.length;
+
+        if (type != TYPE_OBJ && type != TYPE_OBJ_ACK)
+            continue;
+
+        UAVObject *obj = objMngr->getObject(frame.objId);
+        if (obj == NULL || (int)obj->getNumBytes() > size - MIN_HEADER_LENGTH)
+            continue;
+        frame.payload = size - obj->getNumBytes();
+
+        if (!seen.contains(frame.objId)) {
+            seen.insert(frame.objId, frames.size());
+            framesByObject.append(frames.size());
+        }
+        frames.append(frame);
+    }
+}
+
+void tst_UAVTalkBenchmark::initTestCase()
+{
+    objMngr = new UAVObjectManager();
+    UAVObjectsInitialize(objMngr);
+
+    // Never written to, the packets are handed over directly
+    rxDev = new QBuffer();
+    rxDev->open(QIODevice::ReadOnly);
+    utalk = new UAVTalk(rxDev, objMngr);
+
+    QString path = QString::fromLocal8Bit(qgetenv("DRONIN_BENCH_CAPTURE"));
+    if (path.isEmpty()) {
+        makeStream();
+        qDebug("No DRONIN_BENCH_CAPTURE given, decoding made up telemetry");
+    } else {
+        QString error;
+        if (!loadCapture(path, error))
+            QFAIL(qPrintable(QString(QLatin1String("Can't read %1: %2")).arg(path).arg(error)));
+    }
+
+    findFrames();
+    QVERIFY2(!frames.isEmpty(), "No packets of known objects in the capture");
+
+    qDebug("%d bytes, %d packets of %d objects", stream.size(), frames.size(),
+           framesByObject.size());
+}
+
+void tst_UAVTalkBenchmark::cleanupTestCase()
+{
+    delete utalk;
+    delete rxDev;
+    delete objMngr;
+}
+
+/**
+ * An iteration decodes the whole capture
+ */
+void tst_UAVTalkBenchmark::decodeStream_data()
+{
+    QTest::addColumn<bool>("byteWise");
+
+    QTest::newRow("processInputBuffer") << false;
+    QTest::newRow("processInputByte") << true;
+}
+
+void tst_UAVTalkBenchmark::decodeStream()
+{
+    QFETCH(bool, byteWise);
+
+    const quint8 *data = (const quint8 *)stream.constData();
+    const int length = stream.size();
+
+    if (byteWise) {
+        QBENCHMARK {
+            for (int i = 0; i < length; i++)
+                utalk->processInputByte(data[i]);
+        }
+    } else {
+        QBENCHMARK {
+            utalk->processInputBuffer(data, length);
+        }
+    }
+}
+
+/**
+ * Rows of the objects in the capture, with the first packet of each
+ */
+void tst_UAVTalkBenchmark::addObjectRows()
+{
+    QTest::addColumn<int>("frame");
+
+    foreach (int i, framesByObject) {
+        UAVObject *obj = objMngr->getObject(frames[i].objId);
+        QTest::newRow(qPrintable(obj->getName())) << i;
+    }
+}
+
+/**
+ * An iteration decodes one packet, from framing to the object's signals
+ */
+void tst_UAVTalkBenchmark::decodePacket_data()
+{
+    addObjectRows();
+}
+
+void tst_UAVTalkBenchmark::decodePacket()
+{
+    QFETCH(int, frame);
+
+    const quint8 *data = (const quint8 *)stream.constData() + frames[frame].offset;
+    const int length = frames[frame].length;
+
+    QBENCHMARK {
+        utalk->processInputBuffer(data, length);
+    }
+}
+
+/**
+ * An iteration unpacks one object, with nothing connected to it
+ */
+void tst_UAVTalkBenchmark::unpack_data()
+{
+    addObjectRows();
+}
+
+void tst_UAVTalkBenchmark::unpack()
+{
+    QFETCH(int, frame);
+
+    UAVObject *obj = objMngr->getObject(frames[frame].objId);
+    const quint8 *data = (const quint8 *)stream.constData() + frames[frame].offset +
+            frames[frame].payload;
+
+    QBENCHMARK {
+        obj->unpack(data);
+    }
+}
+
+/**
+ * Rows of a field of each type that telemetry is usually plotted from
+ */
+void tst_UAVTalkBenchmark::addFieldRows()
+{
+    QTest::addColumn<QString>("object");
+    QTest::addColumn<QString>("field");
+    QTest::addColumn<QVariant>("value");
+
+    QTest::newRow("float") << QString("AttitudeActual") << QString("Roll") << QVariant(12.5);
+    QTest::newRow("uint8") << QString("SystemStats") << QString("CPULoad") << QVariant(42);
+    QTest::newRow("uint16") << QString("ActuatorCommand") << QString("MaxUpdateTime") << QVariant(5);
+    QTest::newRow("int32") << QString("GPSPosition") << QString("Latitude") << QVariant(473977420);
+    QTest::newRow("enum") << QString("FlightStatus") << QString("Armed") << QVariant(QString("Armed"));
+}
+
+UAVObjectField *tst_UAVTalkBenchmark::fetchField()
+{
+    QFETCH(QString, object);
+    QFETCH(QString, field);
+
+    UAVObject *obj = objMngr->getObject(object);
+    return obj ? obj->getField(field) : NULL;
+}
+
+/**
+ * An iteration reads a field through a QVariant
+ */
+void tst_UAVTalkBenchmark::getValue_data()
+{
+    addFieldRows();
+}
+
+void tst_UAVTalkBenchmark::getValue()
+{
+    UAVObjectField *field = fetchField();
+    if (field == NULL)
+        QSKIP("No such field in this build");
+
+    QVariant value;
+    QBENCHMARK {
+        value = field->getValue();
+    }
+}
+
+/**
+ * An iteration writes a field through a QVariant, signals included
+ */
+void tst_UAVTalkBenchmark::setValue_data()
+{
+    addFieldRows();
+}
+
+void tst_UAVTalkBenchmark::setValue()
+{
+    QFETCH(QVariant, value);
+
+    UAVObjectField *field = fetchField();
+    if (field == NULL)
+        QSKIP("No such field in this build");
+
+    QBENCHMARK {
+        field->setValue(value);
+    }
+}
+
+/**
+ * An iteration looks up every object of the capture once
+ */
+void tst_UAVTalkBenchmark::getObject_data()
+{
+    QTest::addColumn<int>("by");
+
+    QTest::newRow("name") << 0;
+    QTest::newRow("id") << 1;
+    QTest::newRow("index") << 2;
+}
+
+void tst_UAVTalkBenchmark::getObject()
+{
+    QFETCH(int, by);
+
+    QVector<QString> names;
+    QVector<quint32> ids;
+    QVector<int> indices;
+    foreach (int i, framesByObject) {
+        UAVObject *obj = objMngr->getObject(frames[i].objId);
+        names.append(obj->getName());
+        ids.append(obj->getObjID());
+        indices.append(objMngr->getObjectIndex(obj->getObjID()));
+    }
+
+    UAVObject *obj = NULL;
+    switch (by) {
+    case 0:
+        QBENCHMARK {
+            foreach (const QString &name, names)
+                obj = objMngr->getObject(name);
+        }
+        break;
+    case 1:
+        QBENCHMARK {
+            foreach (quint32 id, ids)
+                obj = objMngr->getObject(id);
+        }
+        break;
+    default:
+        QBENCHMARK {
+            foreach (int index, indices)
+                obj = objMngr->getObjectByIndex(index);
+        }
+        break;
+    }
+
+    QVERIFY(obj != NULL);
+}
+
+/**
+ * An iteration decodes the whole capture, with receivers connected to
+ * every object in it
+ */
+void tst_UAVTalkBenchmark::fanOut_data()
+{
+    QTest::addColumn<int>("receivers");
+    QTest::addColumn<bool>("coalesced");
+
+    QTest::newRow("0") << 0 << false;
+    QTest::newRow("1") << 1 << false;
+    QTest::newRow("4") << 4 << false;
+    QTest::newRow("16") << 16 << false;
+    QTest::newRow("4 coalesced") << 4 << true;
+}
+
+void tst_UAVTalkBenchmark::fanOut()
+{
+    QFETCH(int, receivers);
+    QFETCH(bool, coalesced);
+
+    QVector<Receiver *> gadgets;
+    for (int r = 0; r < receivers; r++) {
+        Receiver *gadget = new Receiver();
+        foreach (int i, framesByObject) {
+            UAVObject *obj = objMngr->getObject(frames[i].objId);
+            if (coalesced)
+                connect(obj, SIGNAL(objectUpdatedCoalesced(UAVObject*,quint64)),
+                        gadget, SLOT(updated(UAVObject*)));
+            else
+                connect(obj, SIGNAL(objectUpdated(UAVObject*)),
+                        gadget, SLOT(updated(UAVObject*)));
+        }
+        gadgets.append(gadget);
+    }
+
+    const quint8 *data = (const quint8 *)stream.constData();
+    const int length = stream.size();
+
+    QBENCHMARK {
+        utalk->processInputBuffer(data, length);
+    }
+
+    // Coalesced signals come from a timer, which never runs here
+    if (!coalesced) {
+        foreach (Receiver *gadget, gadgets)
+            QVERIFY(gadget->count > 0);
+    }
+
+    qDeleteAll(gadgets);
+}
+
+QTEST_MAIN(tst_UAVTalkBenchmark)
+
+#include "tst_uavtalkbenchmark.moc"
+
+/**
+ * @}
+ * @}
+ */
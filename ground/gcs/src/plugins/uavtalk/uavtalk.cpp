@@ -33,6 +33,7 @@
  */
 
 #include "uavtalk.h"
+#include "uavtalkrxworker.h"
 #include <QtEndian>
 #include <QDebug>
 #include <extensionsystem/pluginmanager.h>
@@ -69,10 +70,17 @@ const quint8 UAVTalk::crc_table[256] = {
 
 /**
  * Constructor
+ * \param[in] iodev Link to send and receive on
+ * \param[in] objMngr Object manager to resolve received objects against
+ * \param[in] threadedRx Frame and CRC check the receive stream on a worker
+ *                       thread.  Unpacking and all object signals still
+ *                       happen on this object's thread.
  */
-UAVTalk::UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr)
+UAVTalk::UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr, bool threadedRx) :
+    rxThread(NULL), rxWorker(NULL), rxTimestamp(0)
 {
     io = iodev;
+    timeSource = dynamic_cast<UAVTalkTimeSource *>(iodev);
 
     this->objMngr = objMngr;
 
@@ -80,11 +88,27 @@ UAVTalk::UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr)
     rxPacketLength = 0;
 
     memset(&stats, 0, sizeof(ComStats));
+    objStatsClock.start();
+
+    if (threadedRx)
+    {
+        rxThread = new QThread(this);
+        rxWorker = new UAVTalkRxWorker();
+        rxWorker->moveToThread(rxThread);
+        connect(this, SIGNAL(rxData(QByteArray,qint64)), rxWorker, SLOT(processData(QByteArray,qint64)));
+        connect(rxWorker, SIGNAL(framesAvailable()), this, SLOT(processRxFrames()));
+        rxThread->start();
+
+        // Devices with their own read thread can feed the worker from it
+        if (io->metaObject()->indexOfSignal("dataReceived(QByteArray)") >= 0)
+            connect(io, SIGNAL(dataReceived(QByteArray)), rxWorker, SLOT(processRawData(QByteArray)), Qt::DirectConnection);
+    }
 
     connect(io, SIGNAL(readyRead()), this, SLOT(processInputStream()));
+    // Without a plugin manager (the benchmarks) there are no settings
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    Core::Internal::GeneralSettings * settings=pm->getObject<Core::Internal::GeneralSettings>();
-    useUDPMirror=settings->useUDPMirror();
+    Core::Internal::GeneralSettings * settings = pm ? pm->getObject<Core::Internal::GeneralSettings>() : NULL;
+    useUDPMirror = settings && settings->useUDPMirror();
     UAVTALK_QXTLOG_DEBUG(QString("[uavtalk.cpp  ] Use UDP:%0").arg(useUDPMirror));
     if(useUDPMirror)
     {
@@ -102,6 +126,16 @@ UAVTalk::~UAVTalk()
     // According to Qt, it is not necessary to disconnect upon
     // object deletion.
     //disconnect(io, SIGNAL(readyRead()), this, SLOT(processInputStream()));
+
+    if (rxThread)
+    {
+        // The device normally is closed by now, so its read thread is gone
+        if (io)
+            disconnect(io, 0, rxWorker, 0);
+        rxThread->quit();
+        rxThread->wait();
+        delete rxWorker;
+    }
 }
 
 
@@ -111,6 +145,8 @@ UAVTalk::~UAVTalk()
 void UAVTalk::resetStats()
 {
     memset(&stats, 0, sizeof(ComStats));
+    objStats.clear();
+    objStatsIndex.clear();
 }
 
 /**
@@ -121,22 +157,98 @@ UAVTalk::ComStats UAVTalk::getStats()
     return stats;
 }
 
+/**
+ * Get the per-object statistics counters, one entry for each object ID
+ * seen on the link since the last reset
+ */
+QVector<UAVTalk::ObjectComStats> UAVTalk::getObjectStats()
+{
+    return objStats;
+}
+
+/**
+ * Find or create the statistics entry of an object ID
+ */
+UAVTalk::ObjectComStats &UAVTalk::objectStats(quint32 objId)
+{
+    QHash<quint32, int>::const_iterator idx = objStatsIndex.constFind(objId);
+    if (idx != objStatsIndex.constEnd())
+        return objStats[idx.value()];
+
+    ObjectComStats entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.objId = objId;
+    entry.lastRxNs = -1;
+    objStatsIndex.insert(objId, objStats.size());
+    objStats.append(entry);
+    return objStats.last();
+}
+
+/**
+ * Account a received packet and its inter-arrival time
+ */
+void UAVTalk::recordObjectRx(quint32 objId, qint32 bytes)
+{
+    ObjectComStats &entry = objectStats(objId);
+    qint64 now = objStatsClock.nsecsElapsed();
+
+    entry.rxBytes += bytes;
+    entry.rxPackets++;
+
+    if (entry.lastRxNs >= 0)
+    {
+        qint64 interval = now - entry.lastRxNs;
+        if (entry.rxIntervals == 0 || interval < entry.minRxIntervalNs)
+            entry.minRxIntervalNs = interval;
+        if (interval > entry.maxRxIntervalNs)
+            entry.maxRxIntervalNs = interval;
+        entry.sumRxIntervalNs += interval;
+        entry.rxIntervals++;
+    }
+    entry.lastRxNs = now;
+}
+
 /**
  * Called each time there are data in the input buffer
  */
 void UAVTalk::processInputStream()
 {
-    quint8 tmp;
-
     if (io && io->isReadable()) {
-        while (io->bytesAvailable() > 0)
+        while (io && io->bytesAvailable() > 0)
         {
-            io->read((char*)&tmp, 1);
-            processInputByte(tmp);
+            QByteArray data = io->read(io->bytesAvailable());
+            qint64 timestamp = timeSource ? timeSource->readTimestamp() : UAVObject::currentTimestamp();
+            if (rxWorker)
+            {
+                stats.rxBytes += data.size();
+                emit rxData(data, timestamp);
+            }
+            else
+            {
+                rxTimestamp = timestamp;
+                processInputBuffer((const quint8 *)data.constData(), data.size());
+            }
         }
     }
 }
 
+/**
+ * Called when the framing thread has queued complete frames
+ */
+void UAVTalk::processRxFrames()
+{
+    UAVTalkRxWorker::Frame frame;
+
+    while (rxWorker->takeFrame(&frame))
+    {
+        rxTimestamp = frame.timestamp;
+        processPacket(frame.data, frame.length, true);
+    }
+
+    stats.rxErrors += rxWorker->takeErrors();
+    stats.rxBytes += rxWorker->takeRawBytes();
+}
+
 void UAVTalk::dummyUDPRead()
 {
     QUdpSocket *socket=qobject_cast<QUdpSocket*>(sender());
@@ -160,6 +272,74 @@ bool UAVTalk::sendObjectRequest(UAVObject* obj, bool allInstances)
     return objectTransaction(obj, TYPE_OBJ_REQ, allInstances);
 }
 
+/**
+ * Set the objects present on the autopilot, in its index order (by ID),
+ * and ask it to send its unacked updates in bundle frames that refer to
+ * them by index, as deltas where it can.  An empty list stops decoding
+ * bundles.
+ * \param[in] objIds IDs of the objects, at most 255
+ */
+void UAVTalk::setBundleObjects(const QVector<quint32> &objIds)
+{
+    bundleRefs.clear();
+
+    if (objIds.size() > BUNDLE_DELTA)
+    {
+        bundleObjIds.clear();
+        return;
+    }
+
+    bundleObjIds = objIds;
+
+    if (!bundleObjIds.isEmpty())
+        transmitBundleRequest((quint8)bundleObjIds.size(), BUNDLE_OPT_DELTAS);
+}
+
+/**
+ * Ask the autopilot for all its metaobjects and settings objects at once.
+ * They come in as unacked updates, and dumpCompleted() is emitted after
+ * the last one, or when the autopilot doesn't know the request.
+ * \return Success (true), Failure (false)
+ */
+bool UAVTalk::sendDumpRequest()
+{
+    int dataOffset = 8;
+
+    txBuffer[0] = SYNC_VAL;
+    txBuffer[1] = TYPE_OBJ_REQ;
+    qToLittleEndian<quint32>(DUMP_OBJID, &txBuffer[4]);
+
+    qToLittleEndian<quint16>(dataOffset, &txBuffer[2]);
+
+    // Calculate checksum
+    txBuffer[dataOffset] = updateCRC(0, txBuffer, dataOffset);
+
+    // Send buffer, check that the transmit backlog does not grow above limit
+    if (io && io->isWritable() && io->bytesToWrite() < TX_BUFFER_SIZE )
+    {
+        io->write((const char*)txBuffer, dataOffset + CHECKSUM_LENGTH);
+    }
+    else
+    {
+        ++stats.txErrors;
+        return false;
+    }
+
+    // Update stats
+    stats.txBytes += dataOffset + CHECKSUM_LENGTH;
+
+    // Done
+    return true;
+}
+
+/**
+ * The ACK ending a dump and the NACK refusing one carry no object of ours
+ */
+bool UAVTalk::isDumpReply(quint8 type, quint32 objId) const
+{
+    return objId == DUMP_OBJID && (type == TYPE_ACK || type == TYPE_NACK);
+}
+
 /**
  * Send the specified object through the telemetry link.
  * \param[in] obj Object to send
@@ -210,6 +390,187 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
     // Update stats
     stats.rxBytes++;
 
+    return processByte(rxbyte);
+}
+
+/**
+ * Process a block of bytes from the telemetry stream.
+ *
+ * Packets lying entirely within the block are located with a sync scan and
+ * validated in one pass by processPacket().  Whatever straddles the end of
+ * the block goes through the byte-wise state machine, so parsing picks up
+ * where it left off on the next read.  Statistics are identical to feeding
+ * every byte to processInputByte().
+ * \param[in] data Received bytes
+ * \param[in] length Number of bytes in \a data
+ */
+void UAVTalk::processInputBuffer(const quint8 *data, qint32 length)
+{
+    stats.rxBytes += length;
+
+    qint32 pos = 0;
+
+    while (pos < length) {
+        if (rxState != STATE_SYNC) {
+            // Finish a packet that began in a previous block
+            processByte(data[pos++]);
+            continue;
+        }
+
+        const quint8 *sync = (const quint8 *)memchr(&data[pos], SYNC_VAL, length - pos);
+        if (sync == NULL) {
+            break;
+        }
+
+        pos = sync - data;
+
+        qint32 consumed = processPacket(&data[pos], length - pos);
+        if (consumed == 0) {
+            // Packet is cut off by the end of the block
+            while (pos < length) {
+                processByte(data[pos++]);
+            }
+            break;
+        }
+
+        pos += consumed;
+    }
+}
+
+/**
+ * Validate and dispatch a packet that starts with a sync byte.
+ * Performs the same checks, in the same order, as the byte-wise state
+ * machine, and on failure consumes exactly the bytes the state machine
+ * would have consumed before returning to sync.
+ * \param[in] data Buffer starting at the sync byte
+ * \param[in] length Number of bytes available in \a data
+ * \param[in] crcChecked The checksum has already been verified
+ * \return Number of bytes consumed, or 0 if the packet is incomplete
+ */
+qint32 UAVTalk::processPacket(const quint8 *data, qint32 length, bool crcChecked)
+{
+    if (length < 4) {
+        return 0;
+    }
+
+    if ((data[1] & TYPE_MASK) != TYPE_VER) {
+        return 2;
+    }
+
+    rxType = data[1];
+
+    packetSize = qFromLittleEndian<quint16>(&data[2]);
+
+    if (packetSize < MIN_HEADER_LENGTH || packetSize > MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH) {
+        return 4;
+    }
+
+    if (length < MIN_HEADER_LENGTH) {
+        return 0;
+    }
+
+    rxObjId = qFromLittleEndian<quint32>(&data[4]);
+
+    UAVObject *rxObj = objMngr->getObject(rxObjId);
+    const quint8 *payload = rxBuffer;
+    qint32 csOffset;
+
+    if (rxObj == NULL && rxType == TYPE_BUNDLE && rxObjId == BUNDLE_OBJID && !bundleObjIds.isEmpty()) {
+        // Several objects, the payload is split by receiveBundle()
+        rxInstId = 0;
+        rxLength = packetSize - MIN_HEADER_LENGTH;
+
+        if (length < packetSize + CHECKSUM_LENGTH) {
+            return 0;
+        }
+
+        payload = &data[MIN_HEADER_LENGTH];
+        csOffset = packetSize;
+    } else if (rxObj == NULL) {
+        if (rxType != TYPE_OBJ_REQ && !isDumpReply(rxType, rxObjId)) {
+            stats.rxErrors++;
+            return MIN_HEADER_LENGTH;
+        }
+
+        // Request for a non-existing object, checksum follows directly
+        // and we'll send a NACK.  A dump reply has no payload either.
+        rxInstId = 0;
+        csOffset = MIN_HEADER_LENGTH;
+    } else {
+        if (rxType == TYPE_OBJ_REQ || rxType == TYPE_ACK || rxType == TYPE_NACK) {
+            rxLength = 0;
+        } else {
+            rxLength = rxObj->getNumBytes();
+        }
+
+        if (rxLength >= MAX_PAYLOAD_LENGTH) {
+            stats.rxErrors++;
+            return MIN_HEADER_LENGTH;
+        }
+
+        qint32 rxInstanceLength = (rxObj->isSingleInstance() ? 0 : 2);
+        if (MIN_HEADER_LENGTH + rxInstanceLength + rxLength != packetSize) {
+            stats.rxErrors++;
+            return MIN_HEADER_LENGTH;
+        }
+
+        if (length < packetSize + CHECKSUM_LENGTH) {
+            return 0;
+        }
+
+        if (rxInstanceLength) {
+            rxInstId = qFromLittleEndian<quint16>(&data[MIN_HEADER_LENGTH]);
+        } else {
+            rxInstId = 0;
+        }
+
+        // Objects unpack straight from the packet, it outlives the dispatch
+        payload = &data[MIN_HEADER_LENGTH + rxInstanceLength];
+        csOffset = packetSize;
+    }
+
+    if (length < csOffset + CHECKSUM_LENGTH) {
+        return 0;
+    }
+
+    rxCSPacket = data[csOffset];
+    rxCS = crcChecked ? rxCSPacket : updateCRC(0, data, csOffset);
+
+    if (rxCS != rxCSPacket) {
+        stats.rxErrors++;
+        return csOffset + CHECKSUM_LENGTH;
+    }
+
+    if (csOffset != packetSize) {
+        stats.rxErrors++;
+        return csOffset + CHECKSUM_LENGTH;
+    }
+
+    if (rxType == TYPE_BUNDLE) {
+        receiveBundle(payload, rxLength);
+    } else {
+        receiveObject(rxType, rxObjId, rxInstId, payload, rxLength);
+    }
+    if(useUDPMirror)
+    {
+        udpSocketTx->writeDatagram((const char *)data, csOffset + CHECKSUM_LENGTH, QHostAddress::LocalHost, udpSocketRx->localPort());
+    }
+    if (rxType != TYPE_BUNDLE) {
+        stats.rxObjectBytes += rxLength;
+        stats.rxObjects++;
+        recordObjectRx(rxObjId, csOffset + CHECKSUM_LENGTH);
+    }
+
+    return csOffset + CHECKSUM_LENGTH;
+}
+
+/**
+ * Run one byte through the receive state machine.
+ * \param[in] rxbyte Received byte
+ * \return Success (true), Failure (false)
+ */
+bool UAVTalk::processByte(quint8 rxbyte)
+{
     rxPacketLength++;   // update packet byte count
 
     if(useUDPMirror)
@@ -305,7 +666,24 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
             rxObjId = (qint32)qFromLittleEndian<quint32>(rxTmpBuffer);
             {
                 UAVObject *rxObj = objMngr->getObject(rxObjId);
-                if (rxObj == NULL && rxType != TYPE_OBJ_REQ)
+                if (rxObj == NULL && rxType == TYPE_BUNDLE && rxObjId == BUNDLE_OBJID && !bundleObjIds.isEmpty())
+                {
+                    // Several objects, the payload is split by receiveBundle()
+                    rxLength = packetSize - rxPacketLength;
+                    if (rxLength >= MAX_PAYLOAD_LENGTH)
+                    {
+                        stats.rxErrors++;
+                        rxState = STATE_SYNC;
+                        UAVTALK_QXTLOG_DEBUG("UAVTalk: ObjID->Sync (oversize bundle)");
+                        break;
+                    }
+                    rxState = (rxLength > 0) ? STATE_DATA : STATE_CS;
+                    UAVTALK_QXTLOG_DEBUG("UAVTalk: ObjID->Data (bundle)");
+                    rxInstId = 0;
+                    rxCount = 0;
+                    break;
+                }
+                else if (rxObj == NULL && rxType != TYPE_OBJ_REQ && !isDumpReply(rxType, rxObjId))
                 {
                     stats.rxErrors++;
                     rxState = STATE_SYNC;
@@ -315,7 +693,7 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
                 else if (rxObj == NULL)
                 {
                    // This is a non-existing object, just skip to checksum
-                   // and we'll send a NACK next.
+                   // and we'll send a NACK next, or a dump reply.
                    rxState   = STATE_CS;
                    UAVTALK_QXTLOG_DEBUG("UAVTalk: ObjID->CSum (no obj)");
                    rxInstId = 0;
@@ -444,13 +822,20 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
                 break;
             }
 
-                receiveObject(rxType, rxObjId, rxInstId, rxBuffer, rxLength);
+                if (rxType == TYPE_BUNDLE)
+                    receiveBundle(rxBuffer, rxLength);
+                else
+                    receiveObject(rxType, rxObjId, rxInstId, rxBuffer, rxLength);
                 if(useUDPMirror)
                 {
                     udpSocketTx->writeDatagram(rxDataArray,QHostAddress::LocalHost,udpSocketRx->localPort());
                 }
-                stats.rxObjectBytes += rxLength;
-                stats.rxObjects++;
+                if (rxType != TYPE_BUNDLE)
+                {
+                    stats.rxObjectBytes += rxLength;
+                    stats.rxObjects++;
+                    recordObjectRx(rxObjId, rxPacketLength);
+                }
 
             rxState = STATE_SYNC;
             UAVTALK_QXTLOG_DEBUG("UAVTalk: CSum->Sync (OK)");
@@ -475,7 +860,7 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
  * \param[in] length Buffer length
  * \return Success (true), Failure (false)
  */
-bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8* data, qint32 length)
+bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, const quint8* data, qint32 length)
 {
     Q_UNUSED(length);
     UAVObject* obj = NULL;
@@ -551,7 +936,12 @@ bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8*
     case TYPE_NACK: // We have received a NACK for an object that does not exist on the remote end.
                     // (but should exist on our end)
         // All instances, not allowed for NACK messages
-        if (!allInstances)
+        if (objId == DUMP_OBJID)
+        {
+            UAVTALK_QXTLOG_DEBUG("[uavtalk.cpp  ] The remote end doesn't do dumps");
+            emit dumpCompleted(false);
+        }
+        else if (!allInstances)
         {
             // Get object
             obj = objMngr->getObject(objId, instId);
@@ -570,7 +960,11 @@ bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8*
         break;
     case TYPE_ACK: // We have received a ACK, supposedly after sending an object with OBJ_ACK
         // All instances, not allowed for ACK messages
-        if (!allInstances)
+        if (objId == DUMP_OBJID)
+        {
+            emit dumpCompleted(true);
+        }
+        else if (!allInstances)
         {
             // Get object
             obj = objMngr->getObject(objId, instId);
@@ -595,20 +989,139 @@ bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8*
     return !error;
 }
 
+/**
+ * Split a bundle frame into the object updates it carries, each handled as
+ * an unacked object.  Delta entries are rebuilt from the last full entry of
+ * the object, and dropped when it isn't the one they were made against.
+ * Parsing stops at the first entry that doesn't match the index, as the
+ * lengths that follow are unknown then.
+ * \param[in] data Payload of the frame
+ * \param[in] length Payload length
+ */
+void UAVTalk::receiveBundle(const quint8 *data, qint32 length)
+{
+    qint32 pos = 0;
+
+    while (pos < length)
+    {
+        qint32 entryStart = pos;
+        bool delta = (data[pos] == BUNDLE_DELTA);
+        if (delta)
+        {
+            pos++;
+            if (pos >= length)
+            {
+                stats.rxErrors++;
+                return;
+            }
+        }
+
+        quint8 index = data[pos++];
+        UAVObject *obj = (index < bundleObjIds.size()) ? objMngr->getObject(bundleObjIds[index]) : NULL;
+        if (obj == NULL)
+        {
+            UAVTALK_QXTLOG_DEBUG(QString("[uavtalk.cpp  ] Bundle entry with unknown index:%0").arg(index));
+            stats.rxErrors++;
+            return;
+        }
+
+        quint16 instId = 0;
+        if (!obj->isSingleInstance())
+        {
+            if (pos >= length)
+            {
+                stats.rxErrors++;
+                return;
+            }
+            instId = data[pos++];
+        }
+
+        qint32 objLength = obj->getNumBytes();
+        quint64 refKey = ((quint64)obj->getObjID() << 16) | instId;
+        const quint8 *objData = &data[pos];
+        QByteArray rebuilt;
+
+        if (delta)
+        {
+            qint32 bitmapLength = (objLength + 7) / 8;
+            if (pos + 1 + bitmapLength > length)
+            {
+                stats.rxErrors++;
+                return;
+            }
+
+            quint8 refCrc = data[pos++];
+            const quint8 *bitmap = &data[pos];
+            pos += bitmapLength;
+
+            QHash<quint64, QByteArray>::const_iterator ref = bundleRefs.constFind(refKey);
+            bool haveRef = (ref != bundleRefs.constEnd() && ref->size() == objLength &&
+                    updateCRC(0, (const quint8 *)ref->constData(), objLength) == refCrc);
+            if (haveRef)
+                rebuilt = *ref;
+
+            for (qint32 i = 0; i < objLength; i++)
+            {
+                if (!(bitmap[i / 8] & (1 << (i % 8))))
+                    continue;
+                if (pos >= length)
+                {
+                    stats.rxErrors++;
+                    return;
+                }
+                if (haveRef)
+                    rebuilt[i] = data[pos];
+                pos++;
+            }
+
+            if (!haveRef)
+            {
+                // The full update it was made against got lost
+                UAVTALK_QXTLOG_DEBUG(QString("[uavtalk.cpp  ] Bundle delta without reference for:%0").arg(obj->getName()));
+                stats.rxErrors++;
+                continue;
+            }
+
+            objData = (const quint8 *)rebuilt.constData();
+        }
+        else
+        {
+            if (pos + objLength > length)
+            {
+                stats.rxErrors++;
+                return;
+            }
+            bundleRefs.insert(refKey, QByteArray((const char *)objData, objLength));
+            pos += objLength;
+        }
+
+        receiveObject(TYPE_OBJ, obj->getObjID(), instId, objData, objLength);
+
+        // The frame header is shared, only the entry counts for the object
+        stats.rxObjectBytes += objLength;
+        stats.rxObjects++;
+        recordObjectRx(obj->getObjID(), pos - entryStart);
+    }
+}
+
 /**
  * Update the data of an object from a byte array (unpack).
  * If the object instance could not be found in the list, then a
  * new one is created.
  */
-UAVObject* UAVTalk::updateObject(quint32 objId, quint16 instId, quint8* data)
+UAVObject* UAVTalk::updateObject(quint32 objId, quint16 instId, const quint8* data)
 {
-    // Get object
-    UAVObject* obj = objMngr->getObject(objId, instId);
+    // Buffers handed straight to processInputBuffer() carry no time
+    qint64 timestamp = rxTimestamp ? rxTimestamp : UAVObject::currentTimestamp();
+
+    // Get object, resolving the type once for both lookups
+    int index = objMngr->getObjectIndex(objId);
+    UAVObject* obj = objMngr->getObjectByIndex(index, instId);
     // If the instance does not exist create it
     if (obj == NULL)
     {
         // Get the object type
-        UAVObject* tobj = objMngr->getObject(objId);
+        UAVObject* tobj = objMngr->getObjectByIndex(index);
         if (tobj == NULL)
         {
             return NULL;
@@ -625,12 +1138,14 @@ UAVObject* UAVTalk::updateObject(quint32 objId, quint16 instId, quint8* data)
         {
             return NULL;
         }
+        instobj->setTimestamp(timestamp);
         instobj->unpack(data);
         return instobj;
     }
     else
     {
         // Unpack data into object instance
+        obj->setTimestamp(timestamp);
         obj->unpack(data);
         return obj;
     }
@@ -729,12 +1244,57 @@ bool UAVTalk::transmitNack(quint32 objId)
 
     // Update stats
     stats.txBytes += 8+CHECKSUM_LENGTH;
+    ObjectComStats &entry = objectStats(objId);
+    entry.txBytes += 8+CHECKSUM_LENGTH;
+    entry.txPackets++;
 
     // Done
     return true;
 
 }
 
+/**
+ * Ask the autopilot to bundle its unacked updates, with an empty bundle
+ * frame holding the number of objects our index covers and the entry
+ * options we decode.  Firmware that doesn't support bundles drops it as
+ * an unknown object.
+ * \param[in] numObjects Size of the object index
+ * \param[in] options BUNDLE_OPT_ flags
+ * \return Success (true), Failure (false)
+ */
+bool UAVTalk::transmitBundleRequest(quint8 numObjects, quint8 options)
+{
+    int dataOffset = 8;
+
+    txBuffer[0] = SYNC_VAL;
+    txBuffer[1] = TYPE_BUNDLE;
+    qToLittleEndian<quint32>(BUNDLE_OBJID, &txBuffer[4]);
+    txBuffer[dataOffset] = numObjects;
+    txBuffer[dataOffset + 1] = options;
+
+    qToLittleEndian<quint16>(dataOffset + 2, &txBuffer[2]);
+
+    // Calculate checksum
+    txBuffer[dataOffset + 2] = updateCRC(0, txBuffer, dataOffset + 2);
+
+    // Send buffer, check that the transmit backlog does not grow above limit
+    if (io && io->isWritable() && io->bytesToWrite() < TX_BUFFER_SIZE )
+    {
+        io->write((const char*)txBuffer, dataOffset + 2 + CHECKSUM_LENGTH);
+    }
+    else
+    {
+        ++stats.txErrors;
+        return false;
+    }
+
+    // Update stats
+    stats.txBytes += dataOffset + 2 + CHECKSUM_LENGTH;
+
+    // Done
+    return true;
+}
+
 
 /**
  * Send an object through the telemetry link.
@@ -825,11 +1385,38 @@ bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstance
     ++stats.txObjects;
     stats.txBytes += dataOffset+length+CHECKSUM_LENGTH;
     stats.txObjectBytes += length;
+    ObjectComStats &entry = objectStats(objId);
+    entry.txBytes += dataOffset+length+CHECKSUM_LENGTH;
+    entry.txPackets++;
 
     // Done
     return true;
 }
 
+/**
+ * Lookup tables for slicing-by-8 CRC computation.
+ * Table k holds the CRC of each byte value followed by k zero bytes, so
+ * table 0 is crc_table itself.
+ */
+const quint8 (*UAVTalk::crcSliceTables())[256]
+{
+    static struct SliceTables {
+        quint8 t[8][256];
+
+        SliceTables()
+        {
+            memcpy(t[0], crc_table, sizeof(t[0]));
+            for (int k = 1; k < 8; k++) {
+                for (int i = 0; i < 256; i++) {
+                    t[k][i] = crc_table[t[k - 1][i]];
+                }
+            }
+        }
+    } tables;
+
+    return tables.t;
+}
+
 /**
  * Update the crc value with new data.
  *
@@ -854,6 +1441,17 @@ quint8 UAVTalk::updateCRC(quint8 crc, const quint8 data)
 }
 quint8 UAVTalk::updateCRC(quint8 crc, const quint8* data, qint32 length)
 {
+    const quint8 (*t)[256] = crcSliceTables();
+
+    // Eight bytes per step; the CRC is linear so the contributions of each
+    // byte can be looked up independently and combined.
+    while (length >= 8) {
+        crc = t[7][crc ^ data[0]] ^ t[6][data[1]] ^ t[5][data[2]] ^ t[4][data[3]] ^
+              t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+        data += 8;
+        length -= 8;
+    }
+
     while (length--)
         crc = crc_table[crc ^ *data++];
     return crc;
@@ -43,10 +43,28 @@
 #include "uavtalk_global.h"
 #include <QtNetwork/QUdpSocket>
 
+class UAVTalkRxWorker;
+
+/**
+ * Implemented by devices replaying recorded data, so the objects read
+ * from them are stamped with the time they were recorded rather than
+ * the time they were read
+ */
+class UAVTALK_EXPORT UAVTalkTimeSource
+{
+public:
+    virtual ~UAVTalkTimeSource() {}
+
+    //! Recorded time of the last bytes read, on the UAVObject timestamp clock
+    virtual qint64 readTimestamp() const = 0;
+};
+
 class UAVTALK_EXPORT UAVTalk: public QObject
 {
     Q_OBJECT
 
+    friend class UAVTalkRxWorker;
+
 public:
     typedef struct {
         quint32 txBytes;
@@ -59,23 +77,52 @@ public:
         quint32 rxErrors;
     } ComStats;
 
-    UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr);
+    /**
+     * Traffic for a single object ID, including all its instances
+     */
+    typedef struct {
+        quint32 objId;
+        quint32 rxBytes;            /** Whole packets, header and checksum included */
+        quint32 txBytes;
+        quint32 rxPackets;
+        quint32 txPackets;
+        qint64 lastRxNs;            /** Arrival of the last packet, -1 if none yet */
+        qint64 minRxIntervalNs;
+        qint64 maxRxIntervalNs;
+        qint64 sumRxIntervalNs;
+        quint32 rxIntervals;        /** Number of intervals in sumRxIntervalNs */
+    } ObjectComStats;
+
+    UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr, bool threadedRx = false);
     ~UAVTalk();
     bool sendObject(UAVObject* obj, bool acked, bool allInstances);
     bool sendObjectRequest(UAVObject* obj, bool allInstances);
+    void setBundleObjects(const QVector<quint32> &objIds);
+    bool sendDumpRequest();
     ComStats getStats();
+    QVector<ObjectComStats> getObjectStats();
     void resetStats();
 
     bool processInputByte(quint8 rxbyte);
+    void processInputBuffer(const quint8 *data, qint32 length);
+
+    static quint8 updateCRC(quint8 crc, const quint8 data);
+    static quint8 updateCRC(quint8 crc, const quint8* data, qint32 length);
 
 signals:
     // The only signals we send to the upper level are when we
     // either receive an ACK or a NACK for a request.
     void ackReceived(UAVObject* obj);
     void nackReceived(UAVObject* obj);
+    // The end of a dump, or false if the remote end doesn't do dumps
+    void dumpCompleted(bool success);
+
+    // Internal: raw receive data for the framing thread
+    void rxData(const QByteArray &data, qint64 timestamp);
 
 private slots:
     void processInputStream(void);
+    void processRxFrames(void);
     void dummyUDPRead();
 
 protected:
@@ -88,6 +135,13 @@ protected:
     static const int TYPE_OBJ_ACK = (TYPE_VER | 0x02);
     static const int TYPE_ACK = (TYPE_VER | 0x03);
     static const int TYPE_NACK = (TYPE_VER | 0x04);
+    static const int TYPE_BUNDLE = (TYPE_VER | 0x05);
+
+    static const quint32 BUNDLE_OBJID = 0x00000000;
+    static const quint8 BUNDLE_DELTA = 0xFF;
+    static const quint8 BUNDLE_OPT_DELTAS = 0x01;
+
+    static const quint32 DUMP_OBJID = 0x00000000;
 
     static const int MIN_HEADER_LENGTH = 8; // sync(1), type (1), size(2), object ID(4)
     static const int MAX_HEADER_LENGTH = 10; // sync(1), type (1), size(2), object ID (4), instance ID(2, not used in single objects)
@@ -103,6 +157,7 @@ protected:
 
     static const int TX_BUFFER_SIZE = 2*1024;
     static const quint8 crc_table[256];
+    static const quint8 (*crcSliceTables())[256];
 
     // Types
     typedef enum {STATE_SYNC, STATE_TYPE, STATE_SIZE, STATE_OBJID, STATE_INSTID, STATE_DATA, STATE_CS} RxStateType;
@@ -125,21 +180,38 @@ protected:
     qint32 packetSize;
     RxStateType rxState;
     ComStats stats;
+    QVector<ObjectComStats> objStats;
+    QHash<quint32, int> objStatsIndex;
+    QElapsedTimer objStatsClock;
 
     bool useUDPMirror;
     QUdpSocket * udpSocketTx;
     QUdpSocket * udpSocketRx;
     QByteArray rxDataArray;
 
+    QThread *rxThread;
+    UAVTalkRxWorker *rxWorker;
+
+    UAVTalkTimeSource *timeSource;
+    qint64 rxTimestamp;         /** Time the packet being processed was received */
+
+    QVector<quint32> bundleObjIds; /** Object IDs by autopilot index, empty unless bundles were asked for */
+    QHash<quint64, QByteArray> bundleRefs; /** Last full bundle entry by object and instance, for the deltas */
+
     // Methods
+    ObjectComStats &objectStats(quint32 objId);
+    void recordObjectRx(quint32 objId, qint32 bytes);
+    bool processByte(quint8 rxbyte);
+    qint32 processPacket(const quint8 *data, qint32 length, bool crcChecked = false);
     bool objectTransaction(UAVObject* obj, quint8 type, bool allInstances);
-    virtual bool receiveObject(quint8 type, quint32 objId, quint16 instId, quint8* data, qint32 length);
-    UAVObject* updateObject(quint32 objId, quint16 instId, quint8* data);
+    virtual bool receiveObject(quint8 type, quint32 objId, quint16 instId, const quint8* data, qint32 length);
+    UAVObject* updateObject(quint32 objId, quint16 instId, const quint8* data);
     bool transmitNack(quint32 objId);
+    bool isDumpReply(quint8 type, quint32 objId) const;
+    bool transmitBundleRequest(quint8 numObjects, quint8 options);
+    void receiveBundle(const quint8 *data, qint32 length);
     bool transmitObject(UAVObject* obj, quint8 type, bool allInstances);
     bool transmitSingleObject(UAVObject* obj, quint8 type, bool allInstances);
-    quint8 updateCRC(quint8 crc, const quint8 data);
-    quint8 updateCRC(quint8 crc, const quint8* data, qint32 length);
 };
 
 #endif // UAVTALK_H
@@ -5,16 +5,20 @@ TARGET = UAVTalk
 include(../../gcsplugin.pri)
 include(uavtalk_dependencies.pri)
 HEADERS += uavtalk.h \
+    uavtalkrxworker.h \
     uavtalkplugin.h \
     telemetrymonitor.h \
     telemetrymanager.h \
     uavtalk_global.h \
-    telemetry.h
+    telemetry.h \
+    vehiclesession.h
 SOURCES += uavtalk.cpp \
+    uavtalkrxworker.cpp \
     uavtalkplugin.cpp \
     telemetrymonitor.cpp \
     telemetrymanager.cpp \
-    telemetry.cpp
+    telemetry.cpp \
+    vehiclesession.cpp
 DEFINES += UAVTALK_LIBRARY
 OTHER_FILES += UAVTalk.pluginspec \
     UAVTalk.json
\ No newline at end of file
@@ -66,6 +66,10 @@ bool UAVTalkPlugin::initialize(const QStringList & arguments, QString * errorStr
                      this, SLOT(onDeviceConnect(QIODevice *)));
     QObject::connect(cm, SIGNAL(deviceAboutToDisconnect()),
                      this, SLOT(onDeviceDisconnect()));
+    QObject::connect(cm, SIGNAL(additionalDeviceConnected(QIODevice *, QString)),
+                     this, SLOT(onAdditionalDeviceConnect(QIODevice *, QString)));
+    QObject::connect(cm, SIGNAL(additionalDeviceAboutToDisconnect(QIODevice *)),
+                     this, SLOT(onAdditionalDeviceDisconnect(QIODevice *)));
     return true;
 }
 
@@ -83,3 +87,13 @@ void UAVTalkPlugin::onDeviceDisconnect()
 {
     telMngr->stop();
 }
+
+void UAVTalkPlugin::onAdditionalDeviceConnect(QIODevice *dev, const QString &name)
+{
+    telMngr->addVehicle(name, dev);
+}
+
+void UAVTalkPlugin::onAdditionalDeviceDisconnect(QIODevice *dev)
+{
+    telMngr->removeVehicle(dev);
+}
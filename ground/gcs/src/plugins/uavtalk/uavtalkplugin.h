@@ -51,6 +51,8 @@ public:
 protected slots:
     void onDeviceConnect(QIODevice *dev);
     void onDeviceDisconnect();
+    void onAdditionalDeviceConnect(QIODevice *dev, const QString &name);
+    void onAdditionalDeviceDisconnect(QIODevice *dev);
 
 private:
     UAVObjectManager* objMngr;
@@ -0,0 +1,187 @@
+/**
+ ******************************************************************************
+ * @file       uavtalkrxworker.cpp
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Receive-side UAVTalk framing on a worker thread
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "uavtalkrxworker.h"
+#include "uavtalk.h"
+#include <QtEndian>
+#include <QMutexLocker>
+
+#define SYNC_VAL 0x3C
+
+UAVTalkRxWorker::UAVTalkRxWorker() :
+    head(0), tail(0), notifyPending(0), errors(0), rawBytes(0)
+{
+}
+
+/**
+ * Pull the next complete frame off the ring.  Called from the consumer
+ * thread only.
+ * \param[out] frame Destination for the frame
+ * \return true if a frame was returned, false if the ring is empty
+ */
+bool UAVTalkRxWorker::takeFrame(Frame *frame)
+{
+    int t = tail.loadAcquire();
+
+    if (t == head.loadAcquire()) {
+        // Empty; the next push must signal again
+        notifyPending.storeRelease(0);
+
+        // A frame may have landed between the check and the re-arm
+        if (t == head.loadAcquire()) {
+            return false;
+        }
+    }
+
+    frame->timestamp = ring[t].timestamp;
+    frame->length = ring[t].length;
+    memcpy(frame->data, ring[t].data, ring[t].length);
+
+    tail.storeRelease((t + 1) % RING_SIZE);
+
+    return true;
+}
+
+/**
+ * Return and clear the number of framing and CRC errors seen since the
+ * last call.
+ */
+quint32 UAVTalkRxWorker::takeErrors()
+{
+    return errors.fetchAndStoreOrdered(0);
+}
+
+/**
+ * Return and clear the number of bytes that reached processRawData() since
+ * the last call.  The consumer never sees these bytes, so it can't count them.
+ */
+quint32 UAVTalkRxWorker::takeRawBytes()
+{
+    return rawBytes.fetchAndStoreOrdered(0);
+}
+
+/**
+ * A raw block handed over directly by the thread reading the device.  It
+ * is framed right there, without a trip through any event loop.
+ */
+void UAVTalkRxWorker::processRawData(const QByteArray &data)
+{
+    rawBytes.fetchAndAddRelaxed(data.size());
+    processData(data, UAVObject::currentTimestamp());
+}
+
+/**
+ * Append a raw block from the link and extract every complete frame.
+ * Runs on the worker thread, or on the device read thread for direct input.
+ */
+void UAVTalkRxWorker::processData(const QByteArray &data, qint64 timestamp)
+{
+    QMutexLocker lock(&pendingMtx);
+
+    pending.append(data);
+
+    const quint8 *buf = (const quint8 *)pending.constData();
+    int length = pending.size();
+    int pos = 0;
+    bool pushed = false;
+
+    while (pos < length) {
+        const quint8 *sync = (const quint8 *)memchr(&buf[pos], SYNC_VAL, length - pos);
+        if (sync == NULL) {
+            pos = length;
+            break;
+        }
+
+        pos = sync - buf;
+
+        if (length - pos < 4) {
+            break;
+        }
+
+        if ((buf[pos + 1] & UAVTalk::TYPE_MASK) != UAVTalk::TYPE_VER) {
+            pos++;
+            continue;
+        }
+
+        int packetSize = qFromLittleEndian<quint16>(&buf[pos + 2]);
+        if (packetSize < UAVTalk::MIN_HEADER_LENGTH ||
+                packetSize > UAVTalk::MAX_HEADER_LENGTH + UAVTalk::MAX_PAYLOAD_LENGTH) {
+            pos++;
+            continue;
+        }
+
+        if (length - pos < packetSize + UAVTalk::CHECKSUM_LENGTH) {
+            break;
+        }
+
+        if (UAVTalk::updateCRC(0, &buf[pos], packetSize) != buf[pos + packetSize]) {
+            errors.fetchAndAddRelaxed(1);
+            pos++;
+            continue;
+        }
+
+        if (pushFrame(&buf[pos], packetSize + UAVTalk::CHECKSUM_LENGTH, timestamp)) {
+            pushed = true;
+        } else {
+            errors.fetchAndAddRelaxed(1);
+        }
+
+        pos += packetSize + UAVTalk::CHECKSUM_LENGTH;
+    }
+
+    pending.remove(0, pos);
+
+    if (pushed && notifyPending.testAndSetOrdered(0, 1)) {
+        emit framesAvailable();
+    }
+}
+
+/**
+ * Copy a frame into the ring.  Frames are dropped when the consumer has
+ * fallen a full ring behind.
+ */
+bool UAVTalkRxWorker::pushFrame(const quint8 *data, qint32 length, qint64 timestamp)
+{
+    int h = head.loadAcquire();
+    int next = (h + 1) % RING_SIZE;
+
+    if (next == tail.loadAcquire()) {
+        return false;
+    }
+
+    ring[h].timestamp = timestamp;
+    ring[h].length = length;
+    memcpy(ring[h].data, data, length);
+
+    head.storeRelease(next);
+
+    return true;
+}
@@ -0,0 +1,94 @@
+/**
+ ******************************************************************************
+ * @file       uavtalkrxworker.h
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Receive-side UAVTalk framing on a worker thread
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef UAVTALKRXWORKER_H
+#define UAVTALKRXWORKER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QAtomicInt>
+#include <QMutex>
+
+/**
+ * Splits the raw receive stream into CRC-checked UAVTalk frames.
+ *
+ * Lives on its own thread.  Raw blocks arrive through processData(), or
+ * through processRawData() called directly from a device's read thread, and
+ * complete frames are handed to the owning UAVTalk instance through a
+ * single-producer/single-consumer ring.  framesAvailable() is emitted once
+ * per batch rather than once per frame; the consumer re-arms it by calling
+ * takeFrame() until the ring is empty.
+ *
+ * Object lookup and unpacking stay with the consumer, since UAVObjects and
+ * the object manager are not thread safe.
+ */
+class UAVTalkRxWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int MAX_FRAME_LENGTH = 10 + 256 + 1; // UAVTalk::MAX_PACKET_LENGTH
+    static const int RING_SIZE = 256;
+
+    typedef struct {
+        qint64 timestamp;
+        quint16 length;
+        quint8 data[MAX_FRAME_LENGTH];
+    } Frame;
+
+    UAVTalkRxWorker();
+
+    bool takeFrame(Frame *frame);
+    quint32 takeErrors();
+    quint32 takeRawBytes();
+
+public slots:
+    void processData(const QByteArray &data, qint64 timestamp);
+    void processRawData(const QByteArray &data);
+
+signals:
+    void framesAvailable();
+
+private:
+    bool pushFrame(const quint8 *data, qint32 length, qint64 timestamp);
+
+    QMutex pendingMtx;          /** Serializes the queued and the direct input */
+    QByteArray pending;
+
+    Frame ring[RING_SIZE];
+    QAtomicInt head;            /** Next slot the worker fills */
+    QAtomicInt tail;            /** Next slot the consumer drains */
+    QAtomicInt notifyPending;   /** framesAvailable already signalled */
+    QAtomicInt errors;
+    QAtomicInt rawBytes;        /** Bytes taken in through processRawData() */
+};
+
+#endif // UAVTALKRXWORKER_H
@@ -0,0 +1,142 @@
+/**
+ ******************************************************************************
+ *
+ * @file       vehiclesession.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Telemetry with a vehicle watched next to the main connection
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "vehiclesession.h"
+#include "telemetrymonitor.h"
+#include "telemetry.h"
+#include "uavtalk.h"
+#include "uavobjects/uavobjectsinit.h"
+#include <coreplugin/icore.h>
+#include <coreplugin/connectionmanager.h>
+
+#include "attitudeactual.h"
+#include "flightstatus.h"
+#include "gpsposition.h"
+
+#include <QDateTime>
+
+VehicleSession::VehicleSession(const QString &name, QIODevice *dev, QObject *parent) :
+    QObject(parent),
+    m_name(name),
+    dev(dev)
+{
+    snap.connected = false;
+    snap.hasPosition = false;
+    snap.latitude = 0;
+    snap.longitude = 0;
+    snap.altitude = 0;
+    snap.yaw = 0;
+    snap.armed = false;
+    snap.updated = QDateTime::currentMSecsSinceEpoch();
+
+    // The objects are only created as they are looked up, so a store
+    // per vehicle costs little until the vehicle sends something
+    objMngr = new UAVObjectManager();
+    UAVObjectsInitialize(objMngr);
+
+    utalk = new UAVTalk(dev, objMngr, true);
+    telemetry = new Telemetry(utalk, objMngr);
+    telemetry->setTransactionWindow(TRANSACTION_WINDOW);
+
+    // The monitor reports to the connection manager, whose status is
+    // that of the main connection only
+    QHash<quint16, QList<TelemetryMonitor::objStruc> > sessions;
+    telemetryMon = new TelemetryMonitor(objMngr, telemetry, sessions);
+    telemetryMon->disconnect(Core::ICore::instance()->connectionManager());
+    connect(telemetryMon, SIGNAL(connected()), this, SLOT(onConnect()));
+    connect(telemetryMon, SIGNAL(disconnected()), this, SLOT(onDisconnect()));
+
+    connect(GPSPosition::GetInstance(objMngr), SIGNAL(objectUpdated(UAVObject*)),
+            this, SLOT(gpsPositionUpdated(UAVObject*)));
+    connect(AttitudeActual::GetInstance(objMngr), SIGNAL(objectUpdated(UAVObject*)),
+            this, SLOT(attitudeUpdated(UAVObject*)));
+    connect(FlightStatus::GetInstance(objMngr), SIGNAL(objectUpdated(UAVObject*)),
+            this, SLOT(flightStatusUpdated(UAVObject*)));
+}
+
+VehicleSession::~VehicleSession()
+{
+    // Everything else refers to the objects, so they go last
+    delete telemetryMon;
+    delete telemetry;
+    delete utalk;
+    delete objMngr;
+}
+
+void VehicleSession::onConnect()
+{
+    snap.connected = true;
+    snap.updated = QDateTime::currentMSecsSinceEpoch();
+    emit connected();
+}
+
+void VehicleSession::onDisconnect()
+{
+    snap.connected = false;
+    snap.updated = QDateTime::currentMSecsSinceEpoch();
+    emit disconnected();
+}
+
+void VehicleSession::gpsPositionUpdated(UAVObject *obj)
+{
+    GPSPosition *gpsPosition = qobject_cast<GPSPosition *>(obj);
+    if (!gpsPosition)
+        return;
+
+    GPSPosition::DataFields gpsData = gpsPosition->getData();
+    snap.hasPosition = gpsData.Status == GPSPosition::STATUS_FIX2D ||
+            gpsData.Status == GPSPosition::STATUS_FIX3D ||
+            gpsData.Status == GPSPosition::STATUS_DIFF3D;
+    snap.latitude = gpsData.Latitude * 1e-7;
+    snap.longitude = gpsData.Longitude * 1e-7;
+    snap.altitude = gpsData.Altitude;
+    snap.updated = QDateTime::currentMSecsSinceEpoch();
+}
+
+void VehicleSession::attitudeUpdated(UAVObject *obj)
+{
+    AttitudeActual *attitude = qobject_cast<AttitudeActual *>(obj);
+    if (!attitude)
+        return;
+
+    snap.yaw = attitude->getData().Yaw;
+    snap.updated = QDateTime::currentMSecsSinceEpoch();
+}
+
+void VehicleSession::flightStatusUpdated(UAVObject *obj)
+{
+    FlightStatus *flightStatus = qobject_cast<FlightStatus *>(obj);
+    if (!flightStatus)
+        return;
+
+    snap.armed = flightStatus->getData().Armed == FlightStatus::ARMED_ARMED;
+    snap.updated = QDateTime::currentMSecsSinceEpoch();
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,105 @@
+/**
+ ******************************************************************************
+ *
+ * @file       vehiclesession.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Telemetry with a vehicle watched next to the main connection
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef VEHICLESESSION_H
+#define VEHICLESESSION_H
+
+#include "uavtalk_global.h"
+#include "uavobjectmanager.h"
+#include <QIODevice>
+#include <QObject>
+#include <QPointer>
+
+class UAVTalk;
+class Telemetry;
+class TelemetryMonitor;
+
+/**
+ * @brief Telemetry with one more vehicle, next to the main connection.
+ *
+ * Each session has an object manager of its own, so the updates of one
+ * vehicle only reach what watches that vehicle, and the GCS does work in
+ * proportion to the number of vehicles.  As for the main connection,
+ * UAVTalk frames the session's stream on a thread of its own.
+ *
+ * The few values a map needs of every vehicle are kept up to date in a
+ * Snapshot, which can be read at any rate without touching the session's
+ * objects or subscribing to them.
+ */
+class UAVTALK_EXPORT VehicleSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Snapshot {
+        bool connected;
+        bool hasPosition;
+        double latitude;    // degrees
+        double longitude;   // degrees
+        float altitude;     // meters
+        float yaw;          // degrees
+        bool armed;
+        qint64 updated;     // ms since the epoch, of the last change
+    };
+
+    VehicleSession(const QString &name, QIODevice *dev, QObject *parent = 0);
+    ~VehicleSession();
+
+    QString name() const { return m_name; }
+    QIODevice *device() const { return dev; }
+    UAVObjectManager *objectManager() const { return objMngr; }
+    bool isConnected() const { return snap.connected; }
+    Snapshot snapshot() const { return snap; }
+
+signals:
+    void connected();
+    void disconnected();
+
+private slots:
+    void onConnect();
+    void onDisconnect();
+    void gpsPositionUpdated(UAVObject *obj);
+    void attitudeUpdated(UAVObject *obj);
+    void flightStatusUpdated(UAVObject *obj);
+
+private:
+    static const int TRANSACTION_WINDOW = 8;
+
+    QString m_name;
+    QPointer<QIODevice> dev;
+    UAVObjectManager *objMngr;
+    UAVTalk *utalk;
+    Telemetry *telemetry;
+    TelemetryMonitor *telemetryMon;
+    Snapshot snap;
+};
+
+#endif // VEHICLESESSION_H
+
+/**
+ * @}
+ * @}
+ */
@@ -62,6 +62,9 @@ enum bl_commands {
     BL_MSG_STATUS_REQ,
     BL_MSG_STATUS_REP,
     BL_MSG_WIPE_PARTITION,
+    BL_MSG_SECTOR_CRC_REQ,
+    BL_MSG_SECTOR_CRC_REP,
+    BL_MSG_WRITE_RANGE_START,
 
     BL_MSG_WRITE_START = 0x27, // f1 bl masks with 0b11111 so this looks like BL_MSG_WRITE_CONT there
                                // the 6th bit ends up being start flag
@@ -186,6 +189,27 @@ struct msg_wipe_partition {
 	uint8_t label;
 };
 
+PACK(struct msg_sector_crc_req {
+	uint8_t label;
+	uint32_t partition_offset;
+});
+
+PACK(struct msg_sector_crc_rep {
+	uint8_t label;
+	uint32_t sector_offset;
+	uint32_t sector_size; /* 0 past the end of the partition */
+	uint32_t crc;
+});
+
+/* Writes over only the sectors the range covers */
+PACK(struct msg_xfer_range_start {
+	uint32_t packets_in_transfer;
+	uint8_t label;
+	uint8_t words_in_last_packet;
+	uint32_t expected_crc; /* of the whole sectors written */
+	uint32_t partition_offset; /* must start a sector */
+});
+
 PACK(union msg_contents {
     struct msg_capabilities_req cap_req;
     struct msg_capabilities_rep_all cap_rep_all;
@@ -200,6 +224,9 @@ PACK(union msg_contents {
     struct msg_status_req status_req;
     struct msg_status_rep status_rep;
     struct msg_wipe_partition wipe_partition;
+    struct msg_sector_crc_req sector_crc_req;
+    struct msg_sector_crc_rep sector_crc_rep;
+    struct msg_xfer_range_start xfer_range_start;
     uint8_t pad[62];
 });
 
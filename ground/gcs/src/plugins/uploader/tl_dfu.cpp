@@ -34,8 +34,16 @@
 
 #include <QApplication>
 #include <QThread>
+#include <QVector>
 
 #define TL_DFU_DEBUG
+
+// Times a broken upload is picked up again where the board says it stopped
+#define UPLOAD_RESUME_ATTEMPTS 3
+// Time given to the link to recover before asking the board, in ms
+#define UPLOAD_RESUME_DELAY 100
+// Time to wait for a sector CRC, which older bootloaders never send, in ms
+#define SECTOR_CRC_TIMEOUT 500
 #ifdef TL_DFU_DEBUG
 #define TL_DFU_QXTLOG_DEBUG(...) qDebug()<<__VA_ARGS__
 #else  // TL_DFU_DEBUG
@@ -101,9 +109,40 @@ bool DFUObject::StartUpload(qint32 const & numberOfBytes, dfu_partition_label co
 }
 
 
+/**
+  Tells the board to get ready for an upload over part of a partition.
+  Only the sectors from offset up to the end of the data are erased, and
+  the crc covers those sectors whole as far as the partition goes.
+  @param numberOfByte number of bytes of the transfer
+  @param label partition where the data will be uploaded to
+  @param crc crc value of the sectors once written
+  @param offset start of the first sector to write
+  @returns result of the requested operation
+  */
+bool DFUObject::StartRangeUpload(qint32 const & numberOfBytes, dfu_partition_label const & label, quint32 crc, quint32 offset)
+{
+    messagePackets msg = CalculatePadding(numberOfBytes);
+    bl_messages message;
+    message.flags_command = BL_MSG_WRITE_RANGE_START;
+    message.v.xfer_range_start.expected_crc = ntohl(crc);
+    message.v.xfer_range_start.packets_in_transfer = ntohl(msg.numberOfPackets);
+    message.v.xfer_range_start.words_in_last_packet = msg.lastPacketCount;
+    message.v.xfer_range_start.label = label;
+    message.v.xfer_range_start.partition_offset = ntohl(offset);
+
+    TL_DFU_QXTLOG_DEBUG(QString("Range at:%0 Number of packets:%1 Size of last packet:%2").arg(offset).arg(msg.numberOfPackets).arg(msg.lastPacketCount));
+
+    int result = SendData(message);
+    return (result > 0);
+}
+
 /**
   Does the actual data upload to the board. Needs to be called once the
   board is ready to accept data following a StartUpload command, and it is erased.
+  If sending fails part way, the board is asked which packet it expects
+  next and the upload carries on from there, so a glitch on the link does
+  not cost the whole erase and upload. Bootloaders that do not report it
+  answer 0 and the upload fails as before.
   @param numberOfBytes number of bytes to transfer
   @param data data to transfer
   @returns result of the requested operation
@@ -117,23 +156,39 @@ bool DFUObject::UploadData(qint32 const & numberOfBytes, QByteArray  & data)
     int packetsize;
     float percentage;
     int laspercentage = 0;
+    int resumes = 0;
     for(quint32 packetcount = 0; packetcount < msg.numberOfPackets; ++packetcount)
     {
         percentage = (float)(packetcount + 1) / msg.numberOfPackets * 100;
         if(laspercentage != (int)percentage)
             emit operationProgress("", percentage);
         laspercentage=(int)percentage;
-        if(packetcount == msg.numberOfPackets)
+        if(packetcount == msg.numberOfPackets - 1)
             packetsize = msg.lastPacketCount;
         else
             packetsize = 14;
+        message.flags_command = BL_MSG_WRITE_CONT;
         message.v.xfer_cont.current_packet_number = ntohl(packetcount);
         char *pointer = data.data();
         pointer = pointer + 4 * 14 * packetcount;
         CopyWords(pointer, (char*)message.v.xfer_cont.data, packetsize *4);
         int result = SendData(message);
         if(result < 1)
-            return false;
+        {
+            if(resumes++ >= UPLOAD_RESUME_ATTEMPTS)
+                return false;
+
+            QThread::msleep(UPLOAD_RESUME_DELAY);
+            statusReport status = StatusRequest();
+            // Only trust a packet number the board can have reached
+            if(status.status != tl_dfu::uploading ||
+                    (status.additional == 0 && packetcount != 0) ||
+                    status.additional > packetcount)
+                return false;
+
+            TL_DFU_QXTLOG_DEBUG(QString("Resuming upload at packet %0").arg(status.additional));
+            packetcount = status.additional - 1;
+        }
     }
     return true;
 }
@@ -528,9 +583,11 @@ bool DFUObject::EndOperation()
   @param sourceArray array containing the data to upload
   @param partition destination partition
   @param size size of the data to upload
+  @param delta only write the sectors that differ from sourceArray, if the
+  bootloader can tell which those are
   @returns status of the board after upload
   */
-bool DFUObject::UploadPartitionThreaded(QByteArray &sourceArray,dfu_partition_label partition,int size)
+bool DFUObject::UploadPartitionThreaded(QByteArray &sourceArray,dfu_partition_label partition,int size,bool delta)
 {
     if (isRunning())
         return false;
@@ -538,6 +595,7 @@ bool DFUObject::UploadPartitionThreaded(QByteArray &sourceArray,dfu_partition_la
     threadJob.requestTransferType = partition;
     threadJob.requestStorage = &sourceArray;
     threadJob.partition_size = size;
+    threadJob.delta = delta;
     start();
     return true;
 }
@@ -573,6 +631,14 @@ tl_dfu::Status DFUObject::UploadPartition(QByteArray &sourceArray, dfu_partition
         return tl_dfu::abort;
     }
 
+    if (threadJob.delta) {
+        QList<QPair<quint32, quint32> > ranges;
+        if (FindChangedSectors(sourceArray, partition, ranges))
+            return UploadRanges(sourceArray, partition, ranges);
+
+        TL_DFU_QXTLOG_DEBUG("No sector CRCs from the bootloader, uploading the whole partition");
+    }
+
     quint32 crc = DFUObject::CRCFromQBArray(sourceArray, threadJob.partition_size);
     TL_DFU_QXTLOG_DEBUG( QString("NEW FIRMWARE CRC=%0").arg(crc));
 
@@ -632,6 +698,117 @@ tl_dfu::Status DFUObject::UploadPartition(QByteArray &sourceArray, dfu_partition
     return ret.status;
 }
 
+/**
+  Compares each sector of a partition with what an upload would leave in
+  it, by CRC, so only the sectors that differ need to be written
+  @param sourceArray padded data to upload
+  @param partition partition to compare
+  @param ranges the offset and length of each run of differing sectors
+  @returns false if the bootloader can't report sector CRCs
+  */
+bool DFUObject::FindChangedSectors(QByteArray const &sourceArray, dfu_partition_label partition, QList<QPair<quint32, quint32> > &ranges)
+{
+    emit operationProgress(QString(tr("Comparing %0 partition...")).arg(partitionStringFromLabel(partition)), -1);
+
+    quint32 offset = 0;
+    while (offset < threadJob.partition_size) {
+        bl_messages message;
+        message.flags_command = BL_MSG_SECTOR_CRC_REQ;
+        message.v.sector_crc_req.label = partition;
+        message.v.sector_crc_req.partition_offset = ntohl(offset);
+        if (SendData(message) < 1)
+            return false;
+
+        // Older bootloaders ignore the request
+        if (ReceiveData(message, SECTOR_CRC_TIMEOUT) < 1 ||
+                message.flags_command != BL_MSG_SECTOR_CRC_REP)
+            return false;
+
+        quint32 sectorOffset = ntohl(message.v.sector_crc_rep.sector_offset);
+        quint32 sectorSize = ntohl(message.v.sector_crc_rep.sector_size);
+        if (sectorSize == 0 || sectorOffset != offset)
+            return false;
+
+        // The firmware description is kept past the end of the last sector
+        // and can only be written once that sector is erased
+        bool changed = (partition == DFU_PARTITION_FW &&
+                        sectorOffset + sectorSize >= threadJob.partition_size) ||
+                CRCFromQBArray(sourceArray.mid(sectorOffset, sectorSize), sectorSize) !=
+                ntohl(message.v.sector_crc_rep.crc);
+
+        if (changed) {
+            if (!ranges.isEmpty() && ranges.last().first + ranges.last().second == sectorOffset)
+                ranges.last().second += sectorSize;
+            else
+                ranges.append(qMakePair(sectorOffset, sectorSize));
+        }
+
+        offset = sectorOffset + sectorSize;
+    }
+
+    TL_DFU_QXTLOG_DEBUG(QString("%0 runs of sectors changed").arg(ranges.size()));
+    return true;
+}
+
+/**
+  Writes each run of sectors FindChangedSectors found
+  @param sourceArray padded data to upload
+  @param partition destination partition
+  @param ranges the offset and length of each run of sectors
+  @returns status of the board after the last run
+  */
+tl_dfu::Status DFUObject::UploadRanges(QByteArray &sourceArray, dfu_partition_label partition, QList<QPair<quint32, quint32> > const &ranges)
+{
+    DFUObject::statusReport ret;
+    ret.status = tl_dfu::Last_operation_Success;
+
+    for (int i = 0; i < ranges.size(); i++) {
+        quint32 offset = ranges.at(i).first;
+        quint32 length = ranges.at(i).second;
+
+        // Past the end of the image the sectors are left erased, but a
+        // transfer has to carry at least a word
+        QByteArray data = sourceArray.mid(offset, length);
+        if (data.length() < 4)
+            data.append(QByteArray(4 - data.length(), (char) 0xFF));
+        quint32 crc = DFUObject::CRCFromQBArray(data, length);
+
+        emit operationProgress(QString(tr("Uploading changed sectors, %0 of %1...")).arg(i + 1).arg(ranges.size()), -1);
+
+        if (!StartRangeUpload(data.length(), partition, crc, offset)) {
+            ret = StatusRequest();
+            qDebug() << QString("[tl_dfu] StartRangeUpload failed, status: %1, additional: 0x%2")
+                        .arg(StatusToString(ret.status)).arg(ret.additional, 8, 16, QChar('0'));
+            return ret.status;
+        }
+
+        // Answered once the sectors are erased
+        ret = StatusRequest();
+        if (ret.status != tl_dfu::uploading) {
+            qDebug() << QString("[tl_dfu] Couldn't start range upload, status: %1, additional: 0x%2")
+                        .arg(StatusToString(ret.status)).arg(ret.additional, 8, 16, QChar('0'));
+            return ret.status;
+        }
+
+        if (!UploadData(data.length(), data) || !EndOperation()) {
+            ret = StatusRequest();
+            qDebug() << QString("[tl_dfu] Range upload failed, status: %1, additional: 0x%2")
+                        .arg(StatusToString(ret.status)).arg(ret.additional, 8, 16, QChar('0'));
+            return ret.status;
+        }
+
+        ret = StatusRequest();
+        if (ret.status != tl_dfu::Last_operation_Success) {
+            qDebug() << QString("[tl_dfu] Range upload failed, status: %1, additional: 0x%2")
+                        .arg(StatusToString(ret.status)).arg(ret.additional, 8, 16, QChar('0'));
+            return ret.status;
+        }
+    }
+
+    TL_DFU_QXTLOG_DEBUG("Changed sectors uploaded");
+    return ret.status;
+}
+
 /**
   Copies one array into another inverting endianess
   @param source source array
@@ -651,80 +828,69 @@ void DFUObject::CopyWords(char *source, char *destination, int count)
 
 /**
   Utility function
-  Calculates the CRC value of an array
+  Calculates the CRC value of one 32-bit word, the way the STM32 CRC unit does
   */
-quint32 DFUObject::CRC32WideFast(quint32 Crc, quint32 Size, quint32 *Buffer)
+static QVector<quint32> CRCByteTable()
 {
-    while(Size--)
+    QVector<quint32> table(256);
+    for(quint32 i = 0; i < 256; i++)
     {
-        static const quint32 CrcTable[16] = { // Nibble lookup table for 0x04C11DB7 polynomial
-                                              0x00000000,0x04C11DB7,0x09823B6E,0x0D4326D9,0x130476DC,0x17C56B6B,0x1A864DB2,0x1E475005,
-                                              0x2608EDB8,0x22C9F00F,0x2F8AD6D6,0x2B4BCB61,0x350C9B64,0x31CD86D3,0x3C8EA00A,0x384FBDBD };
-
-        Crc = Crc ^ *((quint32 *)Buffer); // Apply all 32-bits
+        quint32 entry = i << 24;
+        for(int bit = 0; bit < 8; bit++)
+            entry = (entry & 0x80000000) ? (entry << 1) ^ 0x04C11DB7 : entry << 1;
+        table[i] = entry;
+    }
+    return table;
+}
 
-        Buffer += 1;
+quint32 DFUObject::CRC32WideFast(quint32 Crc, quint32 Word)
+{
+    // Byte lookup table for 0x04C11DB7 polynomial, built once for all the uploaders
+    static const QVector<quint32> CrcTable = CRCByteTable();
 
-        // Process 32-bits, 4 at a time, or 8 rounds
+    Crc = Crc ^ Word; // Apply all 32-bits
 
-        Crc = (Crc << 4) ^ CrcTable[Crc >> 28]; // Assumes 32-bit reg, masking index to 4-bits
-        Crc = (Crc << 4) ^ CrcTable[Crc >> 28]; //  0x04C11DB7 Polynomial used in STM32
-        Crc = (Crc << 4) ^ CrcTable[Crc >> 28];
-        Crc = (Crc << 4) ^ CrcTable[Crc >> 28];
-        Crc = (Crc << 4) ^ CrcTable[Crc >> 28];
-        Crc = (Crc << 4) ^ CrcTable[Crc >> 28];
-        Crc = (Crc << 4) ^ CrcTable[Crc >> 28];
-        Crc = (Crc << 4) ^ CrcTable[Crc >> 28];
-    }
+    // Process 32-bits, 8 at a time, or 4 rounds
+    Crc = (Crc << 8) ^ CrcTable[Crc >> 24];
+    Crc = (Crc << 8) ^ CrcTable[Crc >> 24];
+    Crc = (Crc << 8) ^ CrcTable[Crc >> 24];
+    Crc = (Crc << 8) ^ CrcTable[Crc >> 24];
     return(Crc);
 }
 
 /**
   Utility function
-  Calculates the CRC value of an array after padding it to the format used with the bootloader
+  Calculates the CRC value of an array after padding it to the format used with the bootloader.
+  The array is read in place; the padding up to Size is 0xFF, so it is fed as such
+  instead of being appended to a copy of a firmware that can be several MB.
   */
-quint32 DFUObject::CRCFromQBArray(QByteArray array, quint32 Size)
+quint32 DFUObject::CRCFromQBArray(QByteArray const & array, quint32 Size)
 {
-    // If array is not an 32-bit word aligned file then
-    // pad out the end to make it so like the firmware
-    // expects
-    if(array.length() % 4 != 0)
+    const uchar *bytes = (const uchar *) array.constData();
+    const quint32 length = qMin((quint32) array.length(), Size);
+    quint32 crc = 0xFFFFFFFF;
+    quint32 x = 0;
+
+    // Whole little endian words of the array
+    for(; x + 4 <= length; x += 4)
+        crc = CRC32WideFast(crc, bytes[x] | (bytes[x + 1] << 8) | (bytes[x + 2] << 16) | ((quint32) bytes[x + 3] << 24));
+
+    // The last partial word, padded with 0xFF like the firmware expects
+    if(x < length && x + 4 <= Size)
     {
-        int pad = array.length() / 4;
-        ++pad;
-        pad = pad * 4;
-        pad = pad - array.length();
-        array.append(QByteArray(pad,255));
+        quint32 aux = 0xFFFFFFFF;
+        for(quint32 i = 0; x + i < length; i++)
+            aux = (aux & ~(0xFFu << (8 * i))) | ((quint32) bytes[x + i] << (8 * i));
+        crc = CRC32WideFast(crc, aux);
+        x += 4;
     }
 
-    // If the size is greater than the provided code then
-    // pad the end with 0xFF
-    if ((int) Size > array.length()) {
+    // The rest of the partition reads erased
+    if(x < Size)
         TL_DFU_QXTLOG_DEBUG("Padding");
-        quint32 pad = Size - array.length();
-        array.append( QByteArray(pad, 255) );
-    }
+    for(; x + 4 <= Size; x += 4)
+        crc = CRC32WideFast(crc, 0xFFFFFFFF);
 
-    int maxSize = ((quint32) array.length() > Size) ? Size : array.length();
-    // Large firmwares require defining super large arrays,
-    // so better to malloc them. I did run into stack overflows here
-    // with devices with large firmwares (1MB) (E. Lafargue), hence
-    // this approach.
-    quint32 *t = (quint32*) malloc(Size);
-    for(int x = 0; x < maxSize / 4;x++)
-    {
-        quint32 aux = 0;
-        aux = (char)array[x * 4 + 3] & 0xFF;
-        aux = aux << 8;
-        aux += (char)array[x * 4 + 2] & 0xFF;
-        aux = aux << 8;
-        aux += (char)array[x * 4 + 1] & 0xFF;
-        aux=aux << 8;
-        aux += (char)array[x * 4 + 0] & 0xFF;
-        t[x] = aux;
-    }
-    quint32 crc = DFUObject::CRC32WideFast(0xFFFFFFFF, Size / 4, (quint32*)t);
-    free(t);
     return crc;
 }
 
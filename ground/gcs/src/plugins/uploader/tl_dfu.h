@@ -31,6 +31,8 @@
 #include <rawhid/usbsignalfilter.h>
 #include <QDebug>
 #include <QFile>
+#include <QList>
+#include <QPair>
 #include <QThread>
 #include <QTimer>
 #include "bl_messages.h"
@@ -91,7 +93,7 @@ class DFUObject : public QThread
     } statusReport;
 
 public:
-    static quint32 CRCFromQBArray(QByteArray array, quint32 Size);
+    static quint32 CRCFromQBArray(QByteArray const & array, quint32 Size);
     DFUObject();
     ~DFUObject();
 
@@ -102,7 +104,7 @@ public:
     void CloseBootloaderComs();
 
     // Partition operations:
-    bool UploadPartitionThreaded(QByteArray &sourceArray, dfu_partition_label partition, int size);
+    bool UploadPartitionThreaded(QByteArray &sourceArray, dfu_partition_label partition, int size, bool delta = false);
     bool DownloadPartitionThreaded(QByteArray *firmwareArray, dfu_partition_label partition, int size);
     bool WipePartition(dfu_partition_label partition);
     QByteArray DownloadDescriptionAsByteArray(int const & numberOfChars);
@@ -119,10 +121,12 @@ signals:
 private:
     bool DownloadPartition(QByteArray *fw, qint32 const & numberOfBytes, const dfu_partition_label &partition);
     tl_dfu::Status UploadPartition(QByteArray &sfile, dfu_partition_label partition);
+    bool FindChangedSectors(QByteArray const &sfile, dfu_partition_label partition, QList<QPair<quint32, quint32> > &ranges);
+    tl_dfu::Status UploadRanges(QByteArray &sfile, dfu_partition_label partition, QList<QPair<quint32, quint32> > const &ranges);
 
     // Helper functions:
     QString StatusToString(tl_dfu::Status  const & status);
-    static quint32 CRC32WideFast(quint32 Crc, quint32 Size, quint32 *Buffer);
+    static quint32 CRC32WideFast(quint32 Crc, quint32 Word);
     void CopyWords(char *source, char *destination, int count);
     messagePackets CalculatePadding(quint32 numberOfBytes);
 
@@ -138,6 +142,7 @@ private:
     hid_device *m_hidHandle;
 
     bool StartUpload(qint32  const &numberOfBytes, const dfu_partition_label &label, quint32 crc);
+    bool StartRangeUpload(qint32 const &numberOfBytes, const dfu_partition_label &label, quint32 crc, quint32 offset);
     bool UploadData(qint32 const &numberOfPackets, QByteArray  &data);
 
     typedef struct ThreadJobStruc
@@ -151,6 +156,7 @@ private:
         dfu_partition_label requestTransferType;
         QByteArray *requestStorage;
         quint32 partition_size;
+        bool delta;
         Actions requestedOperation;
     } ThreadJobStruc;
     ThreadJobStruc threadJob;
@@ -441,7 +441,7 @@ bool UploaderGadgetWidget::flashFirmware(QByteArray &firmwareImage)
     setStatusInfo("",uploader::STATUSICON_RUNNING);
     setUploaderStatus(uploader::BL_BUSY);
     onStatusUpdate(QString("Starting upload..."), 0); // set progress bar to 0 while erasing
-    dfu.UploadPartitionThreaded(firmwareImage, DFU_PARTITION_FW, currentBoard.max_code_size.toInt());
+    dfu.UploadPartitionThreaded(firmwareImage, DFU_PARTITION_FW, currentBoard.max_code_size.toInt(), true);
 
     /* disconnects when loop comes out of scope */
     connect(&dfu, &DFUObject::uploadFinished, &loop, [&] (tl_dfu::Status status) {
@@ -79,6 +79,7 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser* parser,QString template
 
     // Write the flight object initialization header
     flightInitIncludeTemplate.replace( QString("$(SIZECALCULATION)"), QString().setNum(sizeCalc));
+    flightInitIncludeTemplate.replace( QString("$(OBJCOUNT)"), QString().setNum(parser->getNumObjects()));
     res = writeFileIfDiffrent( flightOutputPath.absolutePath() + "/uavobjectsinit.h",
                      flightInitIncludeTemplate );
     if (!res) {
@@ -351,10 +352,11 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo* info)
 							.arg( info->name )
 							.arg( info->fields[n]->name ) );
 				setgetfields.append( QString("{\r\n") );
-				setgetfields.append( QString("\tUAVObjSetDataField(%1Handle(), (void*)New%2, offsetof( %1Data, %2), sizeof(%3));\r\n")
+				setgetfields.append( QString("\tUAVObjSetDataFieldMasked(%1Handle(), (void*)New%2, offsetof( %1Data, %2), sizeof(%3), UAVOBJ_FIELD_DIRTY(%4));\r\n")
 							.arg( info->name )
 							.arg( info->fields[n]->name )
-							.arg( fieldTypeStrC[info->fields[n]->type] ) );
+							.arg( fieldTypeStrC[info->fields[n]->type] )
+							.arg( n ) );
 				setgetfields.append( QString("}\r\n") );
 
 				/* GET */
@@ -379,11 +381,12 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo* info)
 								.arg( info->name )
 								.arg( info->fields[n]->name ) );
 				setgetfields.append( QString("{\r\n") );
-				setgetfields.append( QString("\tUAVObjSetDataField(%1Handle(), (void*)New%2, offsetof( %1Data, %2), %3*sizeof(%4));\r\n")
+				setgetfields.append( QString("\tUAVObjSetDataFieldMasked(%1Handle(), (void*)New%2, offsetof( %1Data, %2), %3*sizeof(%4), UAVOBJ_FIELD_DIRTY(%5));\r\n")
 								.arg( info->name )
 								.arg( info->fields[n]->name )
 								.arg( info->fields[n]->numElements )
-								.arg( fieldTypeStrC[info->fields[n]->type] ) );
+								.arg( fieldTypeStrC[info->fields[n]->type] )
+								.arg( n ) );
 				setgetfields.append( QString("}\r\n") );
 
 				/* GET */
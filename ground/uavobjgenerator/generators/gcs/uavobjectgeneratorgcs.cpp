@@ -64,9 +64,11 @@ bool UAVObjectGeneratorGCS::generate(UAVObjectParser* parser,QString templatepat
 
     for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
         ObjectInfo* info=parser->getObjectByIndex(objidx);
-        process_object(info);
+        // Objects are registered in this order, each followed by its
+        // metaobject, which fixes their index in the object manager
+        process_object(info, 2 * objidx);
 
-        gcsObjInit.append("    objMngr->registerObject( new " + info->name + "() );\n");
+        gcsObjInit.append("    objMngr->registerObjectType(" + info->name + "::OBJID, " + info->name + "::NAME, &createObject<" + info->name + ">);\n");
         gcsObjInit.append("    qmlRegisterType<" + info->name + ">(\"com.dronin.uavo\", 1, 0, \"" + info->name + "Class\");\n");
         objInc.append("#include \"" + info->namelc + ".h\"\n");
     }
@@ -110,7 +112,7 @@ QString UAVObjectGeneratorGCS::form_enum_name(const QString& objectName,
 /**
  * Generate the GCS object files
  */
-bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
+bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info, int objIndex)
 {
     if (info == NULL)
         return false;
@@ -123,6 +125,9 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
     replaceCommonTags(outInclude, info);
     replaceCommonTags(outCode, info);
 
+    // Replace the $(OBJINDEX) tag
+    outInclude.replace(QString("$(OBJINDEX)"), QString::number(objIndex));
+
     // Replace the $(PARENT_INCLUDES) tag
     QString parentIncludes;
 
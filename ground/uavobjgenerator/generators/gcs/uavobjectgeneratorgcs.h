@@ -37,7 +37,7 @@ public:
     bool generate(UAVObjectParser* gen,QString templatepath,QString outputpath);
 
 private:
-    bool process_object(ObjectInfo* info);
+    bool process_object(ObjectInfo* info, int objIndex);
     QString form_enum_name(const QString& objectName,
             const QString& fieldName, const QString& option);
     QString escape_raw_string(QString raw);
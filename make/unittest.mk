@@ -38,8 +38,11 @@ GTEST_CXXFLAGS := -I$(GTEST_DIR)
 # gcov requires specific link options to enable the coverage hooks
 LDFLAGS += -fprofile-arcs
 
-# gcov requires specific compile options to enable the profiling hooks
+# gcov requires specific compile options to enable the profiling hooks.
+# Tests that time the code under test set UT_NO_COVERAGE so it runs as built.
+ifneq ($(UT_NO_COVERAGE),YES)
 GCOV_CFLAGS := -fprofile-arcs -ftest-coverage
+endif
 
 
 #################################
@@ -88,7 +91,9 @@ run: $(OUTDIR)/$(TARGET).elf
 	$(V0) @echo " TEST RUN  $(MSG_EXTRA)  $(call toprel, $<)"
 	$(V1) $<
 
+ifneq ($(UT_NO_COVERAGE),YES)
 GCOV_INPUT_FILES := $(notdir $(SRC))
+endif
 $(foreach src,$(GCOV_INPUT_FILES),$(eval $(call GCOV_TEMPLATE,$(src))))
 
 .PHONY: gcov
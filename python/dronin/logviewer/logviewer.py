@@ -120,37 +120,34 @@ def get_series(name):
     if name in series:
         return series[name]
 
-    typ = t.uavo_defs.find_by_name(name)
+    # Not in the log
+    return np.array([])
 
-    series[name] = t.as_numpy_array(typ)
-
-    return series[name]
-
-def scan_for_events(uv):
+def scan_for_events():
     flight_mode = -1
     armed = -1
 
     events = []
 
-    for u in uv:
-        if u._name == 'UAVO_FlightStatus':
-            ev = []
-            # u.Armed DISARMED/ARMING/ARMED
-            # u.FlightMode
+    typ = objtyps['FlightStatus']
+
+    for u in get_series('FlightStatus'):
+        ev = []
+        # Armed DISARMED/ARMING/ARMED
 
-            if u.Armed != armed:
-                armed = u.Armed
+        if u['Armed'] != armed:
+            armed = u['Armed']
 
-                ev.append(u.ENUMR_Armed[armed])
+            ev.append(typ.ENUMR_Armed[armed])
 
-            if u.FlightMode != flight_mode:
-                flight_mode = u.FlightMode
+        if u['FlightMode'] != flight_mode:
+            flight_mode = u['FlightMode']
 
-                ev.append('MODE:' + u.ENUMR_FlightMode[flight_mode])
+            ev.append('MODE:' + typ.ENUMR_FlightMode[flight_mode])
 
-            if len(ev):
-                tup = (u.time, '/'.join(ev))
-                events.append(tup)
+        if len(ev):
+            tup = (u['time'], '/'.join(ev))
+            events.append(tup)
 
     return events
 
@@ -190,7 +187,10 @@ def handle_open(ignored=False, fname=None):
             dlg.setLabelText("%d objects read..." % n_objs)
 
         t = telemetry.FileTelemetry(f, parse_header=True, service_in_iter=True,
-                    gcs_timestamps=None, name=fname, progress_callback=cb)
+                    gcs_timestamps=None, name=fname, progress_callback=cb,
+                    jobs=open_jobs)
+
+        arrays = t.read_numpy_arrays()
 
         global series, objtyps
         series = {}
@@ -200,7 +200,10 @@ def handle_open(ignored=False, fname=None):
             short_name = typ._name[5:]
             objtyps[short_name] = typ
 
-        event_series = scan_for_events(t)
+        for typ, arr in arrays.items():
+            series[typ._name[5:]] = arr
+
+        event_series = scan_for_events()
 
         global last_plot
         last_plot = None
@@ -219,7 +222,7 @@ def handle_open(ignored=False, fname=None):
         plot_vs_time('Gyros', ['x', 'y', 'z'])
         plot_vs_time('ActuatorCommand', ['Channel:0', 'Channel:1', 'Channel:2', 'Channel:3'])
 
-        objtyps = { k:v for k,v in objtyps.items() if v in t.last_values }
+        objtyps = { k:v for k,v in objtyps.items() if v in arrays }
 
         #add all non-settings objects, and autotune, to the keys.
         objSel.clear()
@@ -278,6 +281,9 @@ menubar = win.menuBar()
 win_num = 0
 menus_enabled = False
 
+# How many processes to read logs with
+open_jobs = 1
+
 openAction = QtGui.QAction("&Open", win)
 openAction.setShortcut(QtGui.QKeySequence.Open)
 openAction.triggered.connect(handle_open)
@@ -328,10 +334,21 @@ contextualCb.toggled.connect(enableContextuals)
 win.show()
 
 def main():
+    import argparse
     import sys
 
-    if len(sys.argv) == 2:
-        handle_open(fname=sys.argv[1])
+    parser = argparse.ArgumentParser(description="dRonin log viewer")
+    parser.add_argument("-j", "--jobs", type=int, default=1,
+            help="processes to read GCS format logs with")
+    parser.add_argument("log", nargs="?", help="log file to open")
+
+    args = parser.parse_args()
+
+    global open_jobs
+    open_jobs = args.jobs
+
+    if args.log is not None:
+        handle_open(fname=args.log)
 
     if (sys.flags.interactive != 1) or not hasattr(QtCore, 'PYQT_VERSION'):
         QtGui.QApplication.instance().exec_()
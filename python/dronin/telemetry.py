@@ -10,6 +10,7 @@ import socket
 import time
 import errno
 from threading import Condition
+from collections import deque
 
 from . import uavtalk, uavo_collection, uavo
 
@@ -19,6 +20,118 @@ from abc import ABCMeta, abstractmethod
 
 from six import with_metaclass
 
+# Default size of the pieces a log is split into to read it in parallel
+DEFAULT_CHUNK_SIZE = 32 << 20
+
+def _load_uavo_defs(githash):
+    """ Loads the UAVO definitions of githash, or of this source tree """
+    uavo_defs = uavo_collection.UAVOCollection()
+
+    if githash:
+        uavo_defs.from_git_hash(githash)
+    else:
+        xml_path = os.path.join(os.path.dirname(__file__), "..", "..",
+                                "shared", "uavobjectdefinition")
+        uavo_defs.from_uavo_xml_path(xml_path)
+
+    return uavo_defs
+
+def _add_to_columns(columns, packet):
+    """ Files a raw packet from uavtalk.process_stream under its class """
+    (cls, timestamp, instance_id, data, position) = packet
+
+    if cls not in columns:
+        columns[cls] = ([], [], [])
+
+    col = columns[cls]
+    col[0].append(data)
+    col[1].append(timestamp)
+    col[2].append(instance_id)
+
+def _columns_to_arrays(columns):
+    """ Decodes each class's packets into one numpy array """
+    return dict((cls, cls.array_from_bytes(b''.join(col[0]), col[1],
+                None if cls._single else col[2]))
+            for cls, col in columns.items())
+
+# The UAVO definitions in each worker of a parallel read
+_chunk_uavo_defs = None
+
+def _chunk_init(githash):
+    global _chunk_uavo_defs
+    _chunk_uavo_defs = _load_uavo_defs(githash)
+
+def _seek_log_record(f, pos, size):
+    """ Finds the first log record at or after pos in f, or size if none """
+    window = 65536
+
+    while pos < size:
+        f.seek(pos)
+
+        # With room for the two whole records find_log_record wants
+        buf = f.read(window + 600)
+        i = uavtalk.find_log_record(buf)
+
+        if i is not None:
+            return pos + i
+
+        pos += window
+
+    return size
+
+def _decode_log_chunk(file_name, start, end, as_text):
+    """ Decodes the log records starting from start up to end in a worker.
+
+    Both ends are moved on to the next record boundary, so that neighbouring
+    chunks meet.  Returns the number of objects, where the chunk really
+    ended, and either their text or a dict from class name to numpy array.
+    """
+
+    with open(file_name, 'rb') as f:
+        size = os.fstat(f.fileno()).st_size
+
+        start = _seek_log_record(f, start, size)
+        end = _seek_log_record(f, end, size)
+
+        gen = uavtalk.process_stream(_chunk_uavo_defs, gcs_timestamps=True,
+            raw=not as_text)
+        gen.send(None)
+
+        f.seek(start)
+        left = end - start
+        count = 0
+
+        if as_text:
+            lines = []
+        else:
+            columns = {}
+
+        while left > 0:
+            buf = f.read(min(left, 524288))
+
+            if buf == b'':
+                break
+
+            left -= len(buf)
+
+            obj = gen.send(buf)
+
+            while obj:
+                count += 1
+
+                if as_text:
+                    lines.append(str(obj))
+                else:
+                    _add_to_columns(columns, obj)
+
+                obj = gen.send(b'')
+
+    if as_text:
+        return (count, end, '\n'.join(lines))
+
+    return (count, end, dict((cls._name, arr)
+            for cls, arr in _columns_to_arrays(columns).items()))
+
 class TelemetryBase(with_metaclass(ABCMeta)):
     """
     Basic (abstract) implementation of telemetry used by all stream types.
@@ -48,18 +161,13 @@ class TelemetryBase(with_metaclass(ABCMeta)):
              information
         """
 
-        uavo_defs = uavo_collection.UAVOCollection()
-
-        if githash:
-            uavo_defs.from_git_hash(githash)
-        else:
-            xml_path = os.path.join(os.path.dirname(__file__), "..", "..",
-                                    "shared", "uavobjectdefinition")
-            uavo_defs.from_uavo_xml_path(xml_path)
+        uavo_defs = _load_uavo_defs(githash)
 
         self.githash = githash
 
         self.uavo_defs = uavo_defs
+        self.gcs_timestamps = gcs_timestamps
+        self.progress_callback = progress_callback
         self.uavtalk_generator = uavtalk.process_stream(uavo_defs,
             use_walltime=use_walltime, gcs_timestamps=gcs_timestamps,
             progress_callback=progress_callback,
@@ -85,9 +193,13 @@ class TelemetryBase(with_metaclass(ABCMeta)):
         self.do_handshaking = do_handshaking
         self.filename = name
 
-        self.acks = set()
+        # Object class -> when its ack came in
+        self.acks = {}
         self.nacks = set()
 
+        # Seconds from sending an object to its ack, most recent last
+        self.ack_latencies = deque(maxlen=1000)
+
         self.eof = False
 
         self.first_handshake_needed = self.do_handshaking
@@ -102,7 +214,7 @@ class TelemetryBase(with_metaclass(ABCMeta)):
 
     def gotack_callback(self, obj):
         with self.ack_cond:
-            self.acks.add(obj)
+            self.acks[obj] = time.time()
             self.ack_cond.notifyAll()
 
     def gotnack_callback(self, obj):
@@ -167,25 +279,78 @@ class TelemetryBase(with_metaclass(ABCMeta)):
 
     def __remove_from_ack_set(self, obj):
         with self.ack_cond:
-            self.acks.discard(obj)
+            self.acks.pop(obj, None)
 
     def send_object(self, send_obj, req_ack=False, *args, **kwargs):
+        return self.send_objects([send_obj], req_ack, *args, **kwargs)
+
+    def send_objects(self, send_objs, req_ack=False, *args, **kwargs):
+        """ Sends several objects in one write.
+
+        With req_ack, their acks are waited for together, and the ones not
+        acked are sent again; the return is whether all were acked.  An ack
+        only says which object it's for, so two instances of one object are
+        sent in turn rather than together.
+        """
         if not self.do_handshaking:
             raise ValueError("Can only send on handshaking/bidir sessions")
 
-        if req_ack:
-            self.__remove_from_ack_set(send_obj.__class__)
+        if not req_ack:
+            self._send(b''.join(uavtalk.send_object(obj, *args, **kwargs)
+                for obj in send_objs))
+            return True
 
-            for i in range(8):
-                self._send(uavtalk.send_object(send_obj, req_ack=req_ack, *args, **kwargs))
-                if self.__wait_ack(send_obj.__class__, 0.26):
-                    return True
+        all_acked = True
+        pending = list(send_objs)
 
-            return False
+        while pending:
+            this_round = {}
+            later = []
 
-        else:
-            self._send(uavtalk.send_object(send_obj, req_ack=req_ack, *args, **kwargs))
-            return True
+            for obj in pending:
+                if obj.__class__ in this_round:
+                    later.append(obj)
+                else:
+                    this_round[obj.__class__] = obj
+
+            if not self.__send_acked(this_round, *args, **kwargs):
+                all_acked = False
+
+            pending = later
+
+        return all_acked
+
+    def __send_acked(self, waiting, *args, **kwargs):
+        """ Sends objects, one per class, until they're all acked or it's
+        been tried 8 times. """
+        for cls in waiting:
+            self.__remove_from_ack_set(cls)
+
+        for i in range(8):
+            sent = time.time()
+
+            self._send(b''.join(uavtalk.send_object(obj, req_ack=True, *args, **kwargs)
+                for obj in waiting.values()))
+
+            for cls, ack_time in self.__wait_acks(waiting, 0.26).items():
+                self.ack_latencies.append(ack_time - sent)
+                del waiting[cls]
+
+            if not waiting:
+                return True
+
+        return False
+
+    def get_ack_latency_stats(self):
+        """ Returns (count, min, mean, max) in seconds of the time from
+        sending an object to its ack, over the last 1000 acks, or None if
+        nothing has been acked yet. """
+        lat = list(self.ack_latencies)
+
+        if not lat:
+            return None
+
+        return (len(lat), min(lat), sum(lat) / len(lat), max(lat))
 
     def __handle_handshake(self, obj):
         if obj.name == "UAVO_FlightTelemetryStats":
@@ -211,22 +376,24 @@ class TelemetryBase(with_metaclass(ABCMeta)):
 
         self._send(uavtalk.request_object(obj))
 
-    def __wait_ack(self, obj, timeout):
+    def __wait_acks(self, objs, timeout):
+        """ Waits until all of objs are acked, or the timeout, and returns a
+        dict of those that were to when their ack came in. """
         expiry = time.time() + timeout
 
         # properly sleep, etc.
         with self.ack_cond:
             while True:
-                if obj in self.acks:
-                    return True
+                acked = dict((obj, self.acks[obj]) for obj in objs
+                        if obj in self.acks)
 
-                if self.eof:
-                    return False
+                if len(acked) == len(objs) or self.eof:
+                    return acked
 
                 diff = expiry - time.time();
 
                 if (diff <= 0):
-                    return False
+                    return acked
 
                 self.ack_cond.wait(diff + 0.001)
 
@@ -392,6 +559,16 @@ class BidirTelemetry(TelemetryBase):
 
         if self.service_in_iter:
             self._do_io(0)
+        else:
+            self._wake()
+
+    def _wake(self):
+        """ Gets a _do_io waiting in another thread to look at send_buf.
+
+        Without this, what's queued waits for the next received data or
+        timeout.
+        """
+        return
 
     @abstractmethod
     def _do_io(self, finish_time):
@@ -420,16 +597,43 @@ class FDTelemetry(BidirTelemetry):
 
         self.fd = fd
 
+        # Written by _wake to break a select waiting on only the fd
+        self.wake_rd, self.wake_wr = os.pipe()
+
+        import fcntl
+
+        for wake_fd in (self.wake_rd, self.wake_wr):
+            fcntl.fcntl(wake_fd, fcntl.F_SETFL,
+                    fcntl.fcntl(wake_fd, fcntl.F_GETFL) | os.O_NONBLOCK)
+
+    def _wake(self):
+        if self.wake_wr is None:
+            return
+
+        try:
+            os.write(self.wake_wr, b'w')
+        except OSError as err:
+            # Full already means it'll wake
+            if err.errno != errno.EAGAIN:
+                raise
+
+    def _close(self):
+        # Can be called more than once at eof
+        if self.wake_wr is not None:
+            os.close(self.wake_rd)
+            os.close(self.wake_wr)
+            self.wake_rd = self.wake_wr = None
+
     # Call select and do one set of IO operations.
     def _do_io(self, finish_time):
         import select
 
-        rdSet = []
+        rdSet = [self.wake_rd]
         wrSet = []
 
         did_stuff = False
 
-        if len(self.recv_buf) < 1024:
+        if len(self.recv_buf) < 16384:
             rdSet.append(self.fd)
 
         if len(self.send_buf) > 0:
@@ -444,13 +648,26 @@ class FDTelemetry(BidirTelemetry):
 
             r,w,e = select.select(rdSet, wrSet, [], tm)
 
+        if self.wake_rd in r:
+            try:
+                while os.read(self.wake_rd, 64):
+                    pass
+            except OSError as err:
+                if err.errno != errno.EAGAIN:
+                    raise
+
+            r.remove(self.wake_rd)
+
+            # Might have something to send now
+            did_stuff = True
+
         if r:
             # Shouldn't throw an exception-- they just told us
             # it was ready for read.
             # TODO: Figure out why read sometimes fails when using sockets
             try:
-                chunk = os.read(self.fd, 1024)
-                if chunk == '':
+                chunk = os.read(self.fd, 16384)
+                if chunk == b'':
                     raise RuntimeError("stream closed")
 
                 self.recv_buf = self.recv_buf + chunk
@@ -496,6 +713,7 @@ class NetworkTelemetry(FDTelemetry):
 
     def _close(self):
         self.sock.close()
+        FDTelemetry._close(self)
 
 # TODO XXX : Plumb appropriate cleanup / file close for these classes
 
@@ -537,7 +755,7 @@ class SerialTelemetry(BidirTelemetry):
                 pass
 
             with self.send_lock:
-                if self.send_buf != '':
+                if self.send_buf != b'':
                     try:
                         written = self.ser.write(self.send_buf)
 
@@ -650,7 +868,7 @@ class HIDTelemetry(BidirTelemetry):
 
                     if length <= len(raw) - 2:
                         chunk = raw.tostring()[2:2+length]
-            except IOError, e:
+            except IOError as e:
                 if e.errno != errno.ETIMEDOUT:
                     raise
 
@@ -659,7 +877,7 @@ class HIDTelemetry(BidirTelemetry):
                 self.recv_buf = self.recv_buf + chunk
 
             with self.send_lock:
-                if self.send_buf != '':
+                if self.send_buf != b'':
                     to_write = len(self.send_buf)
 
                     if to_write > 60:
@@ -673,7 +891,7 @@ class HIDTelemetry(BidirTelemetry):
                         if written > 0:
                             self.send_buf = self.send_buf[written:]
                             did_stuff = True
-                    except IOError, e:
+                    except IOError as e:
                         if e.errno != errno.ETIMEDOUT:
                             raise
 
@@ -683,12 +901,12 @@ class HIDTelemetry(BidirTelemetry):
                     break
 
                 # if we have nothing left to send
-                if self.send_buf == '':
+                if self.send_buf == b'':
                     remaining = finish_time - now
 
                     to_block = int((remaining * 0.75) * 1000) + 25
             else:
-                if self.send_buf == '':
+                if self.send_buf == b'':
                     to_block = 2000
                 else:
                     to_block = 10
@@ -701,19 +919,25 @@ class HIDTelemetry(BidirTelemetry):
 class FileTelemetry(TelemetryBase):
     """ Telemetry interface to data in a file """
 
-    def __init__(self, file_obj, parse_header=False,
-             *args, **kwargs):
+    def __init__(self, file_obj, parse_header=False, jobs=1,
+             chunk_size=DEFAULT_CHUNK_SIZE, *args, **kwargs):
         """ Instantiates a telemetry instance reading from a file.
 
          - file_obj: the file object to read from
          - parse_header: whether to read a header like the GCS writes from the
            file.
+         - jobs: how many processes read_numpy_arrays and iter_text may split
+           GCS format logs over
+         - chunk_size: the size of the pieces they split it into; each job
+           holds a couple of pieces decoded at a time
 
         Meaningful parameters passed up to TelemetryBase include: githash,
         service_in_iter, iter_blocks, gcs_timestamps
         """
 
         self.f = file_obj
+        self.jobs = jobs
+        self.chunk_size = chunk_size
 
         if parse_header:
             # Check the header signature
@@ -761,6 +985,141 @@ class FileTelemetry(TelemetryBase):
 
         self.done=False
 
+    def _can_split(self):
+        """ Whether the rest of the file can be read in parallel pieces.
+
+        Only GCS format logs can be: each record's timestamp stands alone,
+        where others' depend on counting wraparounds from the start. """
+
+        if self.jobs <= 1 or self.gcs_timestamps == False:
+            return False
+
+        try:
+            pos = self.f.tell()
+            buf = self.f.read(4096)
+            self.f.seek(pos)
+
+            self.f.fileno()
+            self.f.name
+        except (AttributeError, IOError, ValueError):
+            return False
+
+        # Past the divider line the GCS writes after the header
+        return uavtalk.find_log_record(buf) is not None
+
+    def _read_chunks(self, as_text):
+        """ Yields what _decode_log_chunk gives for each piece of the rest of
+        the file, in order, from a pool of self.jobs processes. """
+
+        import multiprocessing
+
+        start = self.f.tell()
+        size = os.fstat(self.f.fileno()).st_size
+
+        bounds = list(range(start, size, self.chunk_size)) + [size]
+
+        pool = multiprocessing.Pool(self.jobs, _chunk_init, (self.githash,))
+
+        try:
+            pending = []
+
+            for i in range(len(bounds) - 1):
+                pending.append(pool.apply_async(_decode_log_chunk,
+                    (self.f.name, bounds[i], bounds[i + 1], as_text)))
+
+                # Don't let the decoded pieces pile up
+                if len(pending) >= 2 * self.jobs:
+                    yield pending.pop(0).get()
+
+            while pending:
+                yield pending.pop(0).get()
+        finally:
+            pool.terminate()
+            pool.join()
+
+        self.f.seek(size)
+        self.eof = True
+
+    def iter_text(self):
+        """ Yields the rest of the file as text, as printing each object would,
+        a piece at a time.  It is split over self.jobs processes when it can
+        be.  This is instead of iterating over this telemetry, not as well as.
+        """
+
+        if self._can_split():
+            for (count, end, text) in self._read_chunks(True):
+                if text:
+                    yield text
+        else:
+            for obj in self:
+                yield str(obj)
+
+    def read_numpy_arrays(self):
+        """ Reads the rest of the file into a numpy array per object class.
+
+        This decodes each class's packets in one go rather than making an
+        object of each, which is much faster and smaller for big logs.  It is
+        split over self.jobs processes when it can be.  This is instead of
+        iterating over this telemetry, not as well as.
+
+        Returns a dict from the UAVO_* classes seen to their arrays, in the
+        form TelemetryBase.as_numpy_array gives.
+        """
+
+        if self._can_split():
+            import numpy as np
+
+            pieces = {}
+            received = 0
+
+            for (count, end, arrays) in self._read_chunks(False):
+                received += count
+
+                for name, arr in arrays.items():
+                    pieces.setdefault(name, []).append(arr)
+
+                if self.progress_callback is not None:
+                    self.progress_callback(received, end)
+
+            return dict((self.uavo_defs.find_by_name(name), np.concatenate(arrs))
+                    for name, arrs in pieces.items())
+
+        gen = uavtalk.process_stream(self.uavo_defs,
+            gcs_timestamps=self.gcs_timestamps,
+            progress_callback=self.progress_callback, raw=True)
+
+        gen.send(None)
+
+        # class -> (packed data, timestamps, instance ids)
+        columns = {}
+
+        while True:
+            buf = self._receive(None)
+
+            if buf == b'':
+                break
+
+            packet = gen.send(buf)
+
+            while packet:
+                _add_to_columns(columns, packet)
+
+                packet = gen.send(b'')
+
+        self.eof = True
+        self._close()
+
+        return _columns_to_arrays(columns)
+
+    def index(self, index_name=None):
+        """ Gives lazy access to the rest of the file through a LogIndex.
+
+         - index_name: where to keep the index; by default next to the file.
+
+        This is instead of iterating over this telemetry, not as well as.
+        """
+        return LogIndex(self, index_name)
+
     def _receive(self, finish_time):
         """ Fetch available data from file """
 
@@ -768,6 +1127,201 @@ class FileTelemetry(TelemetryBase):
 
         return buf
 
+class LogIndex(object):
+    """ Random access to the objects in a log file, decoded only as asked.
+
+    The first time a log is opened, where each object's packets are and
+    their timestamps are found in one pass, and saved next to the log so
+    that later opens are immediate.  After that,
+
+        log[UAVO_Gyros]             or log['Gyros']
+        log['Gyros', 60.0:120.0]    the packets in that minute of the log
+
+    each give a numpy array like TelemetryBase.as_numpy_array does, decoded
+    straight from the memory mapped file.
+    """
+
+    # Bump when what's stored changes
+    INDEX_VERSION = 1
+
+    def __init__(self, telemetry, index_name=None):
+        import mmap
+        import numpy as np
+
+        f = telemetry.f
+
+        self.uavo_defs = telemetry.uavo_defs
+
+        data_start = f.tell()
+        st = os.fstat(f.fileno())
+
+        self._mm = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        self._bytes = np.frombuffer(self._mm, dtype=np.uint8)
+
+        # An index made from another version of the file is no good
+        stamp = np.array([self.INDEX_VERSION, st.st_size, int(st.st_mtime),
+            data_start], dtype='int64')
+
+        if index_name is None and hasattr(f, 'name'):
+            index_name = f.name + '.idx.npz'
+
+        self._entries = self._load(index_name, stamp)
+
+        if self._entries is None:
+            self._entries = self._build(telemetry, data_start)
+            self._save(index_name, stamp)
+
+    def _build(self, telemetry, data_start):
+        """ Finds every object's packets in the file """
+        import numpy as np
+
+        gen = uavtalk.process_stream(self.uavo_defs,
+            gcs_timestamps=telemetry.gcs_timestamps,
+            progress_callback=telemetry.progress_callback, raw=True)
+
+        gen.send(None)
+
+        # class -> (data offsets, timestamps, instance ids)
+        found = {}
+
+        pos = data_start
+
+        while pos < len(self._mm):
+            packet = gen.send(self._mm[pos:pos + 524288])
+            pos += 524288
+
+            while packet:
+                (cls, timestamp, instance_id, data, offset) = packet
+
+                if cls not in found:
+                    found[cls] = ([], [], [])
+
+                entry = found[cls]
+                entry[0].append(data_start + offset)
+                entry[1].append(timestamp)
+                entry[2].append(instance_id)
+
+                packet = gen.send(b'')
+
+        return dict((cls, (np.array(entry[0], dtype='int64'),
+                    np.array(entry[1], dtype='int64'),
+                    None if cls._single else np.array(entry[2], dtype='uint16')))
+                for cls, entry in found.items())
+
+    def _load(self, index_name, stamp):
+        """ Reads a saved index, if there's a current one """
+        import numpy as np
+
+        if index_name is None or not os.path.exists(index_name):
+            return None
+
+        try:
+            saved = np.load(index_name)
+
+            if not np.array_equal(saved['stamp'], stamp):
+                return None
+
+            entries = {}
+
+            for key in saved.files:
+                if not key.endswith('.pos'):
+                    continue
+
+                name = key[:-4]
+                cls = self.uavo_defs.find_by_name(name)
+
+                if cls is None:
+                    return None
+
+                entries[cls] = (saved[name + '.pos'], saved[name + '.time'],
+                        None if cls._single else saved[name + '.inst'])
+
+            return entries
+        except (IOError, OSError, KeyError, ValueError):
+            return None
+
+    def _save(self, index_name, stamp):
+        """ Keeps the index for next time, if there's somewhere to """
+        import numpy as np
+
+        if index_name is None:
+            return
+
+        arrays = { 'stamp' : stamp }
+
+        for cls, (pos, times, inst) in self._entries.items():
+            arrays[cls._name + '.pos'] = pos
+            arrays[cls._name + '.time'] = times
+
+            if inst is not None:
+                arrays[cls._name + '.inst'] = inst
+
+        try:
+            np.savez(index_name, **arrays)
+        except (IOError, OSError):
+            print("Couldn't save log index to %s" % index_name)
+
+    def _find_class(self, key):
+        if isinstance(key, str):
+            cls = self.uavo_defs.find_by_name(key)
+
+            if cls is None:
+                raise KeyError(key)
+
+            return cls
+
+        return key
+
+    def keys(self):
+        """ The UAVO_* classes that appear in the log """
+        return list(self._entries.keys())
+
+    def __contains__(self, key):
+        return self._find_class(key) in self._entries
+
+    def count(self, key):
+        """ How many times an object appears in the log """
+        entry = self._entries.get(self._find_class(key))
+
+        return 0 if entry is None else len(entry[0])
+
+    def __getitem__(self, key):
+        import numpy as np
+
+        span = None
+
+        if isinstance(key, tuple):
+            (key, span) = key
+
+        cls = self._find_class(key)
+
+        if cls not in self._entries:
+            return cls.array_from_bytes(b'', [], [])
+
+        (pos, times, inst) = self._entries[cls]
+
+        # The span is in seconds, like the time field
+        if span is not None:
+            keep = np.ones(len(times), dtype=bool)
+
+            if span.start is not None:
+                keep &= times >= span.start * 1000.0
+
+            if span.stop is not None:
+                keep &= times < span.stop * 1000.0
+
+            pos = pos[keep]
+            times = times[keep]
+
+            if inst is not None:
+                inst = inst[keep]
+
+        # Gather just these packets' data out of the file
+        size = cls.get_size_of_data()
+        data = self._bytes[pos[:, np.newaxis] + np.arange(size)]
+
+        return cls.array_from_bytes(data.tobytes(), times, inst)
+
 def get_telemetry_by_args(desc="Process telemetry", service_in_iter=True,
         iter_blocks=True):
     """ Parses command line to decide how to get a telemetry object. """
@@ -806,6 +1360,20 @@ def get_telemetry_by_args(desc="Process telemetry", service_in_iter=True,
                         dest    = "hid",
                         help    = "use usb hid to communicate with FC")
 
+    parser.add_argument("-j", "--jobs",
+                        action  = "store",
+                        dest    = "jobs",
+                        type    = int,
+                        default = 1,
+                        help    = "processes to read a GCS format log file with")
+
+    parser.add_argument("--chunk-size",
+                        action  = "store",
+                        dest    = "chunk_mb",
+                        type    = int,
+                        default = DEFAULT_CHUNK_SIZE >> 20,
+                        help    = "MB of log each job reads at a time; memory use grows with jobs times this")
+
     parser.add_argument("source",
             help  = "file, host:port, vid:pid, or serial port")
 
@@ -844,11 +1412,13 @@ def get_telemetry_by_args(desc="Process telemetry", service_in_iter=True,
 
         if parse_header:
             t = telemetry.FileTelemetry(file_obj, parse_header=True,
-                gcs_timestamps=args.timestamped, name=args.source)
+                gcs_timestamps=args.timestamped, name=args.source,
+                jobs=args.jobs, chunk_size=args.chunk_mb << 20)
         else:
             t = telemetry.FileTelemetry(file_obj, parse_header=False,
                 gcs_timestamps=args.timestamped, name=args.source,
-                githash=githash)
+                githash=githash, jobs=args.jobs,
+                chunk_size=args.chunk_mb << 20)
 
         return t
 
@@ -59,37 +59,47 @@ class UAVTupleClass():
          - timestamp: the timestamp to put on the object instance
          - offset: an optional index into data where to begin deserialization
         """
-        unpack_field_values = cls._packstruct.unpack_from(data, offset)
-
-        field_values = []
-        field_values.append(cls._name)
+        field_values = (cls._name,)
 
         if timestamp is not None:
-            field_values.append(timestamp / 1000.0)
+            field_values += (timestamp / 1000.0,)
 
-        field_values.append(cls._id)
+        field_values += (cls._id,)
 
         if instance_id is not None:
-            field_values.append(instance_id)
+            field_values += (instance_id,)
 
-        # add the remaining fields.  If the thing should be nested, construct
-        # an appropriate tuple.
-        if not cls._flat:
-            pos = 0
+        # add the remaining fields, nested as the class was built to
+        return cls._make(field_values +
+                cls._nest(cls._packstruct.unpack_from(data, offset)))
 
-            for n in cls._num_subelems:
-                if n == 1:
-                    field_values.append(unpack_field_values[pos])
-                else:
-                    field_values.append(tuple(unpack_field_values[pos:pos+n]))
-                pos += n
+    @classmethod
+    def array_from_bytes(cls, data, timestamps, instance_ids=None):
+        """ Deserializes many instances of this object into a numpy array.
 
-            field_values = tuple(field_values)
-        else:
-            # Short cut; nothing is nested
-            field_values = tuple(field_values) + tuple(unpack_field_values)
+         - data: the packed data of each instance, one after another
+         - timestamps: the timestamp of each instance, in milliseconds
+         - instance_ids: the instance id of each, for multi-instance objects
+
+        The array has the same dtype as TelemetryBase.as_numpy_array gives.
+        """
+        import numpy as np
+
+        packed = np.frombuffer(data, dtype=np.dtype(cls._wire_dtype))
+
+        arr = np.zeros(len(packed), dtype=cls._dtype)
+
+        arr['name'] = cls._name
+        arr['time'] = np.asarray(timestamps, dtype='double') / 1000.0
+        arr['uavo_id'] = cls._id
+
+        if not cls._single:
+            arr['inst_id'] = instance_ids
+
+        for field in packed.dtype.names:
+            arr[field] = packed[field]
 
-        return cls._make(field_values)
+        return arr
 
     def __repr__(self):
         """ String representation of the contents """
@@ -177,6 +187,18 @@ type_numpy_map = {
     'enum'    : 'uint8',
     }
 
+# Little-endian numpy types of the fields as packed on the wire
+type_wire_map = {
+    'int8'    : 'i1',
+    'int16'   : '<i2',
+    'int32'   : '<i4',
+    'uint8'   : 'u1',
+    'uint16'  : '<u2',
+    'uint32'  : '<u4',
+    'float'   : '<f4',
+    'enum'    : 'u1',
+    }
+
 struct_element_map = {
     'int8'    : 'b',
     'int16'   : 'h',
@@ -359,6 +381,23 @@ def make_class(collection, xml_file, update_globals=True):
 
     fmt = Struct('<' + ''.join(formats))
 
+    # Build the code that turns the flat unpacked values into the fields,
+    # with no loop: each array field is one slice of them.
+    if is_flat:
+        nest = tuple
+    else:
+        nested = []
+        pos = 0
+
+        for n in num_subelems:
+            if n == 1:
+                nested.append('v[%d],' % pos)
+            else:
+                nested.append('v[%d:%d],' % (pos, pos + n))
+            pos += n
+
+        nest = eval('lambda v: (' + ' '.join(nested) + ')')
+
     ##### CALCULATE THE NUMPY TYPE ASSOCIATED WITH THIS CLASS #####
     dtype  = [('name', 'S20'), ('time', 'double'), ('uavo_id', 'uint')]
 
@@ -371,6 +410,15 @@ def make_class(collection, xml_file, update_globals=True):
         else:
             dtype += [(f['name'], type_numpy_map[f['type']])]
 
+    # And of the packed data, for decoding many packets at once
+    wire_dtype = []
+
+    for f in fields:
+        if f['elements'] != 1:
+            wire_dtype += [(f['name'], type_wire_map[f['type']], (f['elements'],))]
+        else:
+            wire_dtype += [(f['name'], type_wire_map[f['type']])]
+
     ##### DYNAMICALLY CREATE A CLASS TO CONTAIN THIS OBJECT #####
     tuple_fields = ['name', 'time', 'uavo_id']
     if not is_single_inst:
@@ -387,7 +435,9 @@ def make_class(collection, xml_file, update_globals=True):
         _id = uavo_id
         _single = is_single_inst
         _num_subelems = num_subelems
+        _nest = staticmethod(nest)
         _dtype = dtype
+        _wire_dtype = wire_dtype
         _is_settings = is_settings
         _units = {f['name'] : f['units'] for f in fields}
 
@@ -21,6 +21,11 @@ __all__ = [ "send_object", "process_stream" ]
 
 from six import int2byte, indexbytes, byte2int, iterbytes
 
+try:
+    from . import _uavtalk
+except ImportError:
+    _uavtalk = None
+
 # Constants used for UAVTalk parsing
 (MIN_HEADER_LENGTH, MAX_HEADER_LENGTH, MAX_PAYLOAD_LENGTH) = (8, 12, (256-12))
 (SYNC_VAL) = (0x3C)
@@ -56,14 +61,27 @@ crc_table = [
     0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5, 0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3
 ]
 
+def _native_object_table(uavo_defs):
+    """Maps object ids to what the native scanner needs to frame them"""
+    return dict((obj._id, (obj.get_size_of_data(), obj._single, obj))
+        for obj in uavo_defs.values())
+
 def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
         progress_callback=None, ack_callback=None, reqack_callback=None,
-        nack_callback=None):
+        nack_callback=None, raw=False):
     """Generator function that parses uavotalk stream.
 
     You are expected to send more bytes, or '' to it, until EOF.  Then send
     None.  After that, you may continue to receive objects back because of
-    buffering."""
+    buffering.
+
+    If raw is true, (uavo class, timestamp, instance id, packed data, offset
+    of the data in the stream) tuples are generated in place of objects, for
+    decoding in bulk later.
+
+    When the _uavtalk extension is built, runs of whole, valid packets are
+    framed by it in bulk, and the Python parser below only has to deal with
+    resyncing, errors and waiting for data."""
 
     # These are used for accounting for timestamp wraparound
     timestamp_base = 0
@@ -78,179 +96,212 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
 
     pending_pieces = []
 
-    while True:
-        # If we don't have sufficient data buffered, join up any chunks we've
-        # been given to ensure pending_pieces is empty for the rest of this loop.
-        #
-        # in other words, don't mix the pending_pieces drain model and the
-        # buffer concatenation model within a loop iteration.
-        #
-        # 10k chosen here to be bigger than any plausible uavo; could calculate
-        # this instead from our known uav objects
-        if len(buf) - buf_offset < 10240:
-            past_bytes += buf_offset
-
-            #print "stitch pp=%d"%(len(pending_pieces))
-            pending_pieces.insert(0, buf[buf_offset:])
-            buf_offset = 0
-
-            buf = b''.join(pending_pieces)
-            pending_pieces = []
-
-        if gcs_timestamps is None or gcs_timestamps == True:
-            while len(buf) < (header_fmt.size + logheader_fmt.size + buf_offset):
-                rx = yield None
+    overrideTimestamp = None
 
-                if rx is None:
-                    return
-
-                buf = buf + rx
+    # Packets already framed by the extension, last one first
+    batch = []
+    native_objs = {}
 
-            overrideTimestamp, logHdrLen = logheader_fmt.unpack_from(buf,buf_offset)
-
-            if gcs_timestamps is None:
-                if ((logHdrLen > 1000) or ( overrideTimestamp > 100000000)):
-                    if indexbytes(buf, buf_offset) == SYNC_VAL:
-                        print("Autodetect: no gcs-type timestamps")
-                        gcs_timestamps = False
+    while True:
+        if batch:
+            packet = batch.pop()
+        else:
+            packet = None
+
+            # If we don't have sufficient data buffered, join up any chunks we've
+            # been given to ensure pending_pieces is empty for the rest of this loop.
+            #
+            # in other words, don't mix the pending_pieces drain model and the
+            # buffer concatenation model within a loop iteration.
+            #
+            # 10k chosen here to be bigger than any plausible uavo; could calculate
+            # this instead from our known uav objects
+            if len(buf) - buf_offset < 10240:
+                past_bytes += buf_offset
+
+                #print "stitch pp=%d"%(len(pending_pieces))
+                pending_pieces.insert(0, buf[buf_offset:])
+                buf_offset = 0
+
+                buf = b''.join(pending_pieces)
+                pending_pieces = []
+
+            # The log format has to be settled before the fast path can run
+            if _uavtalk is not None and gcs_timestamps is not None:
+                if len(native_objs) != len(uavo_defs):
+                    native_objs = _native_object_table(uavo_defs)
+
+                batch = _uavtalk.scan(buf, buf_offset, native_objs,
+                    bool(gcs_timestamps), 1024)
+                batch.reverse()
+
+                if batch:
+                    packet = batch.pop()
+
+        if packet is None:
+            if gcs_timestamps is None or gcs_timestamps == True:
+                while len(buf) < (header_fmt.size + logheader_fmt.size + buf_offset):
+                    rx = yield None
+
+                    if rx is None:
+                        return
+
+                    buf = buf + rx
+
+                overrideTimestamp, logHdrLen = logheader_fmt.unpack_from(buf,buf_offset)
+
+                if gcs_timestamps is None:
+                    if ((logHdrLen > 1000) or ( overrideTimestamp > 100000000)):
+                        if indexbytes(buf, buf_offset) == SYNC_VAL:
+                            print("Autodetect: no gcs-type timestamps")
+                            gcs_timestamps = False
+                        else:
+                            print("Autodetect: punting to next cycle")
+                            buf_offset += 1
+                            continue
                     else:
-                        print("Autodetect: punting to next cycle")
-                        buf_offset += 1
-                        continue
+                        if indexbytes(buf, buf_offset + logheader_fmt.size) == SYNC_VAL:
+                            print("Autodetect: GCS-type timestamps likely")
+                            gcs_timestamps = True
+                            buf_offset += logheader_fmt.size
+                        else:
+                            print("Autodetect: punting to next cycle")
                 else:
-                    if indexbytes(buf, buf_offset + logheader_fmt.size) == SYNC_VAL:
-                        print("Autodetect: GCS-type timestamps likely")
-                        gcs_timestamps = True
-                        buf_offset += logheader_fmt.size
-                    else:
-                        print("Autodetect: punting to next cycle")
-            else:
-                buf_offset += logheader_fmt.size
+                    buf_offset += logheader_fmt.size
 
-        # Ensure we have enough room for all the
-        # plain required fields to avoid duplicating
-        # this code lots.
-        # sync(1) + type(1) + len(2) + objid(4)
+            # Ensure we have enough room for all the
+            # plain required fields to avoid duplicating
+            # this code lots.
+            # sync(1) + type(1) + len(2) + objid(4)
 
-        while (len(buf) < header_fmt.size + buf_offset) or (indexbytes(buf, buf_offset) != SYNC_VAL):
-            #print "waitingsync len=%d, offset=%d"%(len(buf), buf_offset)
+            while (len(buf) < header_fmt.size + buf_offset) or (indexbytes(buf, buf_offset) != SYNC_VAL):
+                #print "waitingsync len=%d, offset=%d"%(len(buf), buf_offset)
 
-            if len(buf) < header_fmt.size + 1 + buf_offset:
-                rx = yield None
-
-                if rx is None:
-                    #end of stream, stopiteration
-                    return
+                if len(buf) < header_fmt.size + 1 + buf_offset:
+                    rx = yield None
 
-                buf = buf + rx
+                    if rx is None:
+                        #end of stream, stopiteration
+                        return
 
-            for i in range(buf_offset, len(buf)):
-                if indexbytes(buf, i) == SYNC_VAL:
-                    break
+                    buf = buf + rx
 
-            #print "skipping from %d to %d"%(buf_offset, i)
+                for i in range(buf_offset, len(buf)):
+                    if indexbytes(buf, i) == SYNC_VAL:
+                        break
 
-            # Trim off irrelevant stuff, loop and try again
-            buf_offset = i
+                #print "skipping from %d to %d"%(buf_offset, i)
 
-        (sync, pack_type, pack_len, objId) = header_fmt.unpack_from(buf, buf_offset)
+                # Trim off irrelevant stuff, loop and try again
+                buf_offset = i
 
-        if (pack_type & TYPE_MASK) != TYPE_VER:
-            print("badver %x"%(pack_type))
-            buf_offset += 1
-            continue    # go to top to look for sync
+            (sync, pack_type, pack_len, objId) = header_fmt.unpack_from(buf, buf_offset)
 
-        pack_type &= ~ TYPE_MASK
+            if (pack_type & TYPE_MASK) != TYPE_VER:
+                print("badver %x"%(pack_type))
+                buf_offset += 1
+                continue    # go to top to look for sync
 
-        if pack_len < MIN_HEADER_LENGTH or pack_len > MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH:
-            print("badlen %d"%(pack_len))
-            buf_offset += 1
-            continue
+            pack_type &= ~ TYPE_MASK
 
-        # Search for object.
-        uavo_key = '{0:08x}'.format(objId)
-        if not uavo_key in uavo_defs:
-            #print "Unknown object 0x" + uavo_key
-            obj = None
-        else:
-            obj = uavo_defs[uavo_key]
+            if pack_len < MIN_HEADER_LENGTH or pack_len > MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH:
+                print("badlen %d"%(pack_len))
+                buf_offset += 1
+                continue
 
-        # Determine data length
-        if (pack_type == TYPE_OBJ_REQ) or (pack_type == TYPE_ACK) or (pack_type == TYPE_NACK):
-            obj_len = 0
-            timestamp_len = 0
-        else:
-            if obj is not None:
-                timestamp_len = timestamp_fmt.size if pack_type == TYPE_OBJ_TS or pack_type == TYPE_OBJ_ACK_TS else 0
-                obj_len = obj.get_size_of_data()
+            # Search for object.
+            uavo_key = '{0:08x}'.format(objId)
+            if not uavo_key in uavo_defs:
+                #print "Unknown object 0x" + uavo_key
+                obj = None
             else:
-                # we don't know anything, so fudge to keep sync.
-                timestamp_len = 0
-                obj_len = pack_len - header_fmt.size
-
-        if obj is not None and not obj._single:
-            instance_len = 2
-        else:
-            instance_len = 0
+                obj = uavo_defs[uavo_key]
 
-        # Check length and determine next state
-        if obj_len >= MAX_PAYLOAD_LENGTH:
-            print("bad len-- bad xml?")
-            #should never happen; requires invalid uavo xml
-            buf_offset += 1
-            continue
-
-        # calc_size, AKA timestamp, and obj data
-        # as appropriate, plus our current header
-        # also equivalent to the offset of the CRC in the packet
-
-        calc_size = header_fmt.size + instance_len + timestamp_len + obj_len
+            # Determine data length
+            if (pack_type == TYPE_OBJ_REQ) or (pack_type == TYPE_ACK) or (pack_type == TYPE_NACK):
+                obj_len = 0
+                timestamp_len = 0
+            else:
+                if obj is not None:
+                    timestamp_len = timestamp_fmt.size if pack_type == TYPE_OBJ_TS or pack_type == TYPE_OBJ_ACK_TS else 0
+                    obj_len = obj.get_size_of_data()
+                else:
+                    # we don't know anything, so fudge to keep sync.
+                    timestamp_len = 0
+                    obj_len = pack_len - header_fmt.size
 
-        # Check the lengths match
-        if calc_size != pack_len:
-            print("mismatched size id=%s %d vs %d, type %d"%(uavo_key,
-                calc_size, pack_len, pack_type))
+            if obj is not None and not obj._single:
+                instance_len = 2
+            else:
+                instance_len = 0
+
+            # Check length and determine next state
+            if obj_len >= MAX_PAYLOAD_LENGTH:
+                print("bad len-- bad xml?")
+                #should never happen; requires invalid uavo xml
+                buf_offset += 1
+                continue
+
+            # calc_size, AKA timestamp, and obj data
+            # as appropriate, plus our current header
+            # also equivalent to the offset of the CRC in the packet
+
+            calc_size = header_fmt.size + instance_len + timestamp_len + obj_len
+
+            # Check the lengths match
+            if calc_size != pack_len:
+                print("mismatched size id=%s %d vs %d, type %d"%(uavo_key,
+                    calc_size, pack_len, pack_type))
+
+                # packet error - mismatched packet size
+                # Consume a byte to try syncing right after where we
+                # did...
+                buf_offset += 1
+                continue
+
+            # OK, at this point we are seriously hoping to receive
+            # a packet.  Time for another loop to make sure we have
+            # enough data.
+            # +1 here is for CRC-8
+            while len(buf) < calc_size + 1 + buf_offset:
+                rx = yield None
 
-            # packet error - mismatched packet size
-            # Consume a byte to try syncing right after where we
-            # did...
-            buf_offset += 1
-            continue
+                if rx is None:
+                    #end of stream, stopiteration
+                    return
 
-        # OK, at this point we are seriously hoping to receive
-        # a packet.  Time for another loop to make sure we have
-        # enough data.
-        # +1 here is for CRC-8
-        while len(buf) < calc_size + 1 + buf_offset:
-            rx = yield None
+                buf += rx
 
-            if rx is None:
-                #end of stream, stopiteration
-                return
+            # check the CRC byte
 
-            buf += rx
+            cs = calcCRC(buf[buf_offset:calc_size+buf_offset])
+            recv_cs = indexbytes(buf, buf_offset + calc_size)
 
-        # check the CRC byte
+            if recv_cs != cs:
+                print("Bad crc. Got %d but wanted %d"%(recv_cs, cs))
 
-        cs = calcCRC(buf[buf_offset:calc_size+buf_offset])
-        recv_cs = indexbytes(buf, buf_offset + calc_size)
+                buf_offset += 1
 
-        if recv_cs != cs:
-            print("Bad crc. Got %d but wanted %d"%(recv_cs, cs))
+                continue
 
-            buf_offset += 1
+            if instance_len:
+                instance_id = instance_fmt.unpack_from(buf, header_fmt.size + buf_offset)[0]
+            else:
+                instance_id = None
 
-            continue
+            if timestamp_len:
+                timestamp = timestamp_fmt.unpack_from(buf, header_fmt.size + instance_len + buf_offset)[0]
+            else:
+                timestamp = None
 
-        if instance_len:
-            instance_id = instance_fmt.unpack_from(buf, header_fmt.size + buf_offset)[0]
-        else:
-            instance_id = None
+            packet = (pack_type, obj, instance_id, timestamp,
+                header_fmt.size + instance_len + timestamp_len + buf_offset,
+                obj_len, buf_offset + calc_size + 1, overrideTimestamp)
 
-        if timestamp_len:
-            # pull the timestamp from the packet
-            timestamp = timestamp_fmt.unpack_from(buf, header_fmt.size + instance_len + buf_offset)[0]
+        (pack_type, obj, instance_id, timestamp, offset, obj_len,
+            packet_end, overrideTimestamp) = packet
 
+        if timestamp is not None:
             # handle wraparound
             if timestamp < last_timestamp:
                 timestamp_base = timestamp_base + 65536
@@ -266,12 +317,15 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
             timestamp = overrideTimestamp
 
         if (obj_len > 0) and (obj is not None):
-            offset = header_fmt.size + instance_len + timestamp_len + buf_offset
-            objInstance = obj.from_bytes(buf, timestamp, instance_id, offset=offset)
+            if raw:
+                objInstance = (obj, timestamp, instance_id,
+                    buf[offset:offset + obj_len], past_bytes + offset)
+            else:
+                objInstance = obj.from_bytes(buf, timestamp, instance_id, offset=offset)
             received += 1
             if not (received % 10000):
                 if progress_callback is not None:
-                    progress_callback(received, past_bytes + buf_offset + calc_size + 1)
+                    progress_callback(received, past_bytes + packet_end)
                 print("received %d objs"%(received))
 
             next_recv = yield objInstance
@@ -290,11 +344,54 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
             if nack_callback is not None:
                 nack_callback(obj)
 
-        buf_offset += calc_size + 1
+        buf_offset = packet_end
 
         if next_recv is not None and next_recv != '':
             pending_pieces.append(next_recv)
 
+def _log_record_length(buf, offset):
+    """Length of the GCS log record (header and packet) at offset, or 0 if
+    there isn't a whole, valid one there"""
+
+    pkt = offset + logheader_fmt.size
+
+    if len(buf) < pkt + header_fmt.size:
+        return 0
+
+    (sync, pack_type, pack_len, objId) = header_fmt.unpack_from(buf, pkt)
+
+    if sync != SYNC_VAL or (pack_type & TYPE_MASK) != TYPE_VER:
+        return 0
+
+    if pack_len < MIN_HEADER_LENGTH or pack_len > MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH:
+        return 0
+
+    if len(buf) < pkt + pack_len + 1:
+        return 0
+
+    if calcCRC(buf[pkt:pkt + pack_len]) != indexbytes(buf, pkt + pack_len):
+        return 0
+
+    return logheader_fmt.size + pack_len + 1
+
+def find_log_record(buf, start=0):
+    """Finds where the first GCS log record at or after start begins, so a
+    log can be split and parsed in pieces.  Two valid records in a row are
+    asked for, so payload that happens to look like one is passed over.
+
+    Returns None if there's none in buf."""
+
+    for i in range(start, len(buf) - logheader_fmt.size):
+        if indexbytes(buf, i + logheader_fmt.size) != SYNC_VAL:
+            continue
+
+        rec_len = _log_record_length(buf, i)
+
+        if rec_len and _log_record_length(buf, i + rec_len):
+            return i
+
+    return None
+
 def send_object(obj, req_ack=False):
     """Generates a string containing a UAVTalk packet describing this object"""
 
@@ -336,6 +433,9 @@ def calcCRC(s):
     Calculate a CRC consistently with how they are computed on the firmware side
     """
 
+    if _uavtalk is not None:
+        return _uavtalk.crc(s)
+
     cs = 0
 
     for c in iterbytes(s):
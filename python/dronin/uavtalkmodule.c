@@ -0,0 +1,283 @@
+/*
+ * Finds UAVTalk packets in a buffer for uavtalk.process_stream.
+ *
+ * Copyright (C) 2017 dRonin, http://dronin.org
+ *
+ * Licensed under the GNU LGPL version 2.1 or any later version (see COPYING.LESSER)
+ *
+ * This only frames packets: it applies the same checks as the pure Python
+ * parser and stops at the first thing that is not a whole, valid packet,
+ * leaving resync and error reporting to the Python side.  The payloads are
+ * decoded by the UAVO classes as before.
+ */
+
+#include <Python.h>
+#include <stdint.h>
+
+#define SYNC_VAL		0x3C
+#define TYPE_MASK		0x78
+#define TYPE_VER		0x20
+#define TYPE_OBJ_REQ		0x01
+#define TYPE_ACK		0x03
+#define TYPE_NACK		0x04
+#define TYPE_OBJ_TS		0x80
+#define TYPE_OBJ_ACK_TS		0x82
+
+#define HEADER_LENGTH		8
+#define LOGHEADER_LENGTH	12
+#define MIN_HEADER_LENGTH	8
+#define MAX_HEADER_LENGTH	12
+#define MAX_PAYLOAD_LENGTH	(256 - 12)
+
+static const uint8_t crc_table[256] = {
+	0x00, 0x07, 0x0e, 0x09, 0x1c, 0x1b, 0x12, 0x15, 0x38, 0x3f, 0x36, 0x31, 0x24, 0x23, 0x2a, 0x2d,
+	0x70, 0x77, 0x7e, 0x79, 0x6c, 0x6b, 0x62, 0x65, 0x48, 0x4f, 0x46, 0x41, 0x54, 0x53, 0x5a, 0x5d,
+	0xe0, 0xe7, 0xee, 0xe9, 0xfc, 0xfb, 0xf2, 0xf5, 0xd8, 0xdf, 0xd6, 0xd1, 0xc4, 0xc3, 0xca, 0xcd,
+	0x90, 0x97, 0x9e, 0x99, 0x8c, 0x8b, 0x82, 0x85, 0xa8, 0xaf, 0xa6, 0xa1, 0xb4, 0xb3, 0xba, 0xbd,
+	0xc7, 0xc0, 0xc9, 0xce, 0xdb, 0xdc, 0xd5, 0xd2, 0xff, 0xf8, 0xf1, 0xf6, 0xe3, 0xe4, 0xed, 0xea,
+	0xb7, 0xb0, 0xb9, 0xbe, 0xab, 0xac, 0xa5, 0xa2, 0x8f, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9d, 0x9a,
+	0x27, 0x20, 0x29, 0x2e, 0x3b, 0x3c, 0x35, 0x32, 0x1f, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0d, 0x0a,
+	0x57, 0x50, 0x59, 0x5e, 0x4b, 0x4c, 0x45, 0x42, 0x6f, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7d, 0x7a,
+	0x89, 0x8e, 0x87, 0x80, 0x95, 0x92, 0x9b, 0x9c, 0xb1, 0xb6, 0xbf, 0xb8, 0xad, 0xaa, 0xa3, 0xa4,
+	0xf9, 0xfe, 0xf7, 0xf0, 0xe5, 0xe2, 0xeb, 0xec, 0xc1, 0xc6, 0xcf, 0xc8, 0xdd, 0xda, 0xd3, 0xd4,
+	0x69, 0x6e, 0x67, 0x60, 0x75, 0x72, 0x7b, 0x7c, 0x51, 0x56, 0x5f, 0x58, 0x4d, 0x4a, 0x43, 0x44,
+	0x19, 0x1e, 0x17, 0x10, 0x05, 0x02, 0x0b, 0x0c, 0x21, 0x26, 0x2f, 0x28, 0x3d, 0x3a, 0x33, 0x34,
+	0x4e, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5c, 0x5b, 0x76, 0x71, 0x78, 0x7f, 0x6a, 0x6d, 0x64, 0x63,
+	0x3e, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2c, 0x2b, 0x06, 0x01, 0x08, 0x0f, 0x1a, 0x1d, 0x14, 0x13,
+	0xae, 0xa9, 0xa0, 0xa7, 0xb2, 0xb5, 0xbc, 0xbb, 0x96, 0x91, 0x98, 0x9f, 0x8a, 0x8d, 0x84, 0x83,
+	0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5, 0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3
+};
+
+static uint8_t calc_crc(const uint8_t *p, Py_ssize_t len)
+{
+	uint8_t cs = 0;
+
+	while (len--)
+		cs = crc_table[cs ^ *p++];
+
+	return cs;
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/* A field the packet may not have: its value, or None */
+static PyObject *opt_u32(int present, uint32_t val)
+{
+	if (!present)
+		Py_RETURN_NONE;
+
+	return PyLong_FromUnsignedLong(val);
+}
+
+/**
+ * scan(buf, offset, objects, logheader, max_packets)
+ *
+ * @param[in] buf the bytes received so far
+ * @param[in] offset where the next packet should start
+ * @param[in] objects dict from object id to (data size, single, uavo class)
+ * @param[in] logheader whether each packet follows a GCS log header
+ * @param[in] max_packets how many packets to frame at most
+ * @return a list of (type, uavo or None, instance or None, timestamp or None,
+ * data offset, data length, end offset, log timestamp or None), which stops
+ * at the first place that isn't a whole valid packet
+ */
+static PyObject *scan(PyObject *self, PyObject *args)
+{
+	Py_buffer view;
+	Py_ssize_t offset, max_packets;
+	PyObject *objects;
+	int logheader;
+
+	(void) self;
+
+	if (!PyArg_ParseTuple(args, "s*nO!in", &view, &offset,
+				&PyDict_Type, &objects, &logheader, &max_packets))
+		return NULL;
+
+	PyObject *packets = PyList_New(0);
+	if (!packets) {
+		PyBuffer_Release(&view);
+		return NULL;
+	}
+
+	const uint8_t *buf = view.buf;
+	Py_ssize_t len = view.len;
+
+	while (offset >= 0 && PyList_GET_SIZE(packets) < max_packets) {
+		Py_ssize_t p = offset;
+		uint32_t log_timestamp = 0;
+
+		if (logheader) {
+			if (p + LOGHEADER_LENGTH > len)
+				break;
+
+			log_timestamp = get_u32(buf + p);
+			p += LOGHEADER_LENGTH;
+		}
+
+		if (p + HEADER_LENGTH > len || buf[p] != SYNC_VAL)
+			break;
+
+		uint8_t pack_type = buf[p + 1];
+		uint16_t pack_len = get_u16(buf + p + 2);
+		uint32_t obj_id = get_u32(buf + p + 4);
+
+		if ((pack_type & TYPE_MASK) != TYPE_VER)
+			break;
+
+		pack_type &= ~TYPE_MASK;
+
+		if (pack_len < MIN_HEADER_LENGTH ||
+				pack_len > MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH)
+			break;
+
+		PyObject *key = PyLong_FromUnsignedLong(obj_id);
+		if (!key)
+			goto fail;
+
+		/* Borrowed */
+		PyObject *entry = PyDict_GetItem(objects, key);
+		Py_DECREF(key);
+
+		PyObject *obj = Py_None;
+		Py_ssize_t obj_len = 0, timestamp_len = 0, instance_len = 0;
+
+		if (entry) {
+			if (!PyTuple_Check(entry) || PyTuple_GET_SIZE(entry) < 3) {
+				PyErr_SetString(PyExc_ValueError,
+						"Object entries must be (size, single, uavo)");
+				goto fail;
+			}
+
+			obj = PyTuple_GET_ITEM(entry, 2);
+
+			if (!PyObject_IsTrue(PyTuple_GET_ITEM(entry, 1)))
+				instance_len = 2;
+		}
+
+		if (pack_type == TYPE_OBJ_REQ || pack_type == TYPE_ACK ||
+				pack_type == TYPE_NACK) {
+			obj_len = 0;
+		} else if (entry) {
+			if (pack_type == TYPE_OBJ_TS || pack_type == TYPE_OBJ_ACK_TS)
+				timestamp_len = 2;
+
+			obj_len = PyLong_AsSsize_t(PyTuple_GET_ITEM(entry, 0));
+			if (obj_len < 0) {
+				if (!PyErr_Occurred())
+					PyErr_SetString(PyExc_ValueError,
+							"Object size is negative");
+				goto fail;
+			}
+		} else {
+			/* Unknown object; skip it by its length */
+			obj_len = pack_len - HEADER_LENGTH;
+		}
+
+		if (obj_len >= MAX_PAYLOAD_LENGTH)
+			break;
+
+		Py_ssize_t calc_size = HEADER_LENGTH + instance_len +
+			timestamp_len + obj_len;
+
+		if (calc_size != pack_len || p + calc_size + 1 > len)
+			break;
+
+		if (calc_crc(buf + p, calc_size) != buf[p + calc_size])
+			break;
+
+		Py_ssize_t data_offset = p + HEADER_LENGTH + instance_len +
+			timestamp_len;
+
+		PyObject *instance = opt_u32(instance_len,
+				instance_len ? get_u16(buf + p + HEADER_LENGTH) : 0);
+		PyObject *timestamp = opt_u32(timestamp_len,
+				timestamp_len ? get_u16(buf + p + HEADER_LENGTH + instance_len) : 0);
+		PyObject *log_ts = opt_u32(logheader, log_timestamp);
+
+		PyObject *packet = NULL;
+
+		if (instance && timestamp && log_ts)
+			packet = Py_BuildValue("iOOOnnnO", pack_type, obj,
+					instance, timestamp, data_offset, obj_len,
+					p + calc_size + 1, log_ts);
+
+		Py_XDECREF(instance);
+		Py_XDECREF(timestamp);
+		Py_XDECREF(log_ts);
+
+		if (!packet)
+			goto fail;
+
+		int ret = PyList_Append(packets, packet);
+		Py_DECREF(packet);
+
+		if (ret)
+			goto fail;
+
+		offset = p + calc_size + 1;
+	}
+
+	PyBuffer_Release(&view);
+	return packets;
+
+fail:
+	Py_DECREF(packets);
+	PyBuffer_Release(&view);
+	return NULL;
+}
+
+/**
+ * crc(buf)
+ *
+ * @param[in] buf the bytes to checksum
+ * @return the UAVTalk CRC-8 of buf
+ */
+static PyObject *crc(PyObject *self, PyObject *args)
+{
+	Py_buffer view;
+
+	(void) self;
+
+	if (!PyArg_ParseTuple(args, "s*", &view))
+		return NULL;
+
+	uint8_t cs = calc_crc(view.buf, view.len);
+
+	PyBuffer_Release(&view);
+
+	return Py_BuildValue("i", cs);
+}
+
+static PyMethodDef UAVTalkMethods[] =
+{
+	{"scan", scan, METH_VARARGS, "Frame the whole, valid packets at the start of a buffer."},
+	{"crc", crc, METH_VARARGS, "Calculate the UAVTalk CRC-8 of some bytes."},
+	{NULL, NULL, 0, NULL}
+};
+
+#if PY_MAJOR_VERSION >= 3
+static struct PyModuleDef uavtalkmodule = {
+	PyModuleDef_HEAD_INIT, "_uavtalk", NULL, -1, UAVTalkMethods
+};
+
+PyMODINIT_FUNC
+PyInit__uavtalk(void)
+{
+	return PyModule_Create(&uavtalkmodule);
+}
+#else
+PyMODINIT_FUNC
+init_uavtalk(void)
+{
+	(void) Py_InitModule("_uavtalk", UAVTalkMethods);
+}
+#endif
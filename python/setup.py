@@ -5,7 +5,7 @@ https://github.com/pypa/sampleproject
 """
 
 # Always prefer setuptools over distutils
-from setuptools import setup, find_packages
+from setuptools import setup, find_packages, Extension
 # To use a consistent encoding
 from codecs import open
 from os import path
@@ -77,6 +77,13 @@ setup(
     # simple. Or you can use find_packages().
     packages = ['dronin', 'dronin.logviewer'],
 
+    # Speeds up log parsing.  uavtalk falls back to pure Python without it,
+    # so a failure to build it doesn't fail the install.
+    ext_modules = [Extension('dronin._uavtalk',
+        sources = ['dronin/uavtalkmodule.c'],
+        extra_compile_args = ['-std=gnu99'],
+        optional = True)],
+
     # Just requires the base python system to run
     install_requires=['six'],
 
@@ -88,7 +95,7 @@ setup(
 
     scripts = [ 'dronin-dumplog', 'dronin-halt',
         'dronin-getconfig', 'dronin-logfsimport',
-        'dronin-shell' ],
+        'dronin-shell', 'dronin-swarm' ],
 #    package_data={
 #        'sample': ['package_data.dat'],
 #    },